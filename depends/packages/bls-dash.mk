@@ -16,6 +16,11 @@ $(package)_relic_sha256_hash=ddad83b1406985a1e4703bd03bdbab89453aa700c0c99567cf8
 
 $(package)_extra_sources=$($(package)_relic_file_name)
 
+# The assembly backend produces different binaries, so it must not share the cached build of the portable one
+ifneq ($(BLS_ASM),)
+$(package)_build_id_deps=arith-x64-asm-6l
+endif
+
 define $(package)_fetch_cmds
 $(call fetch_file,$(package),$($(package)_download_path),$($(package)_download_file),$($(package)_file_name),$($(package)_sha256_hash)) && \
 $(call fetch_file,$(package),$($(package)_relic_download_path),$($(package)_relic_download_file),$($(package)_relic_file_name),$($(package)_relic_sha256_hash))
@@ -40,6 +45,10 @@ define $(package)_set_vars
   $(package)_config_opts_mingw32=-DOPSYS=WINDOWS -DCMAKE_SYSTEM_NAME=Windows -DCMAKE_SHARED_LIBRARY_LINK_C_FLAGS=""
   $(package)_config_opts_i686+= -DWSIZE=32
   $(package)_config_opts_x86_64+= -DWSIZE=64
+  ifneq ($(BLS_ASM),)
+    # relic's hand written x86_64 prime field arithmetic for 6 limb (381 bit) primes
+    $(package)_config_opts_x86_64+= -DARITH=x64-asm-6l
+  endif
   $(package)_config_opts_arm+= -DWSIZE=32
   $(package)_config_opts_armv7l+= -DWSIZE=32
   $(package)_config_opts_debug=-DDEBUG=ON -DCMAKE_BUILD_TYPE=Debug
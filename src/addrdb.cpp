@@ -130,6 +130,12 @@ bool CAddrDB::Write(const CAddrMan& addr)
     return SerializeFileDB("peers", pathAddr, addr);
 }
 
+bool CAddrDB::Write(const CDataStream& ssAddr)
+{
+    // a stream serializes as its raw content, so the file is the same as if the addrman was written directly
+    return SerializeFileDB("peers", pathAddr, ssAddr);
+}
+
 bool CAddrDB::Read(CAddrMan& addr)
 {
     return DeserializeFileDB(pathAddr, addr);
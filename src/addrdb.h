@@ -8,6 +8,7 @@
 
 #include <fs.h>
 #include <serialize.h>
+#include <streams.h>
 
 #include <string>
 #include <map>
@@ -84,6 +85,8 @@ private:
 public:
     CAddrDB();
     bool Write(const CAddrMan& addr);
+    /** Writes a snapshot of an addrman, serialized with SER_DISK and CLIENT_VERSION */
+    bool Write(const CDataStream& ssAddr);
     bool Read(CAddrMan& addr);
     static bool Read(CAddrMan& addr, CDataStream& ssPeers);
 };
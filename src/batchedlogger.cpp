@@ -6,7 +6,7 @@
 #include <util.h>
 
 CBatchedLogger::CBatchedLogger(uint64_t _category, const std::string& _header) :
-    accept(LogAcceptCategory(_category)), header(_header)
+    accept(LogAcceptCategory(_category) && LogRateLimitAccept(_category)), header(_header)
 {
 }
 
@@ -5,6 +5,7 @@
 #include <bench/bench.h>
 
 #include <crypto/sha256.h>
+#include <crypto/x11.h>
 #include <key.h>
 #include <stacktraces.h>
 #include <validation.h>
@@ -65,6 +66,7 @@ int main(int argc, char** argv)
     const fs::path bench_datadir{SetDataDir()};
 
     SHA256AutoDetect();
+    X11AutoDetect();
 
     RegisterPrettySignalHandlers();
     RegisterPrettyTerminateHander();
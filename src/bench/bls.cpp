@@ -3,7 +3,9 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <bench/bench.h>
+#include <chainparams.h>
 #include <random.h>
+#include <bls/bls_batchverifier.h>
 #include <bls/bls_worker.h>
 #include <utiltime.h>
 
@@ -129,6 +131,81 @@ static void BLS_Verify_Normal(benchmark::State& state)
 }
 
 
+static void BLS_Recover_Normal(benchmark::State& state)
+{
+    // threshold of the LLMQ_400_60 quorums
+    const size_t threshold = 240;
+    BLSSecretKeyVector msk(threshold);
+    for (auto& sk : msk) {
+        sk.MakeNewKey();
+    }
+    uint256 msgHash = GetRandHash();
+    BLSSignatureVector sigShares;
+    BLSIdVector ids;
+    for (size_t i = 0; i < threshold; i++) {
+        CBLSId id(GetRandHash());
+        CBLSSecretKey skShare;
+        skShare.SecretKeyShare(msk, id);
+        sigShares.emplace_back(skShare.Sign(msgHash));
+        ids.emplace_back(id);
+    }
+
+    // Benchmark.
+    while (state.KeepRunning()) {
+        CBLSSignature recoveredSig;
+        bool ok = recoveredSig.Recover(sigShares, ids);
+        assert(ok);
+    }
+}
+
+static void BLS_Recover_LLMQ(Consensus::LLMQType llmqType, benchmark::State& state)
+{
+    auto chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    const size_t threshold = (size_t)chainParams->GetConsensus().llmqs.at(llmqType).threshold;
+
+    BLSSecretKeyVector msk(threshold);
+    for (auto& sk : msk) {
+        sk.MakeNewKey();
+    }
+    uint256 msgHash = GetRandHash();
+    BLSSignatureVector sigShares;
+    BLSIdVector ids;
+    for (size_t i = 0; i < threshold; i++) {
+        CBLSId id(GetRandHash());
+        CBLSSecretKey skShare;
+        skShare.SecretKeyShare(msk, id);
+        sigShares.emplace_back(skShare.Sign(msgHash));
+        ids.emplace_back(id);
+    }
+
+    // Benchmark.
+    while (state.KeepRunning()) {
+        CBLSSignature recoveredSig;
+        bool ok = recoveredSig.Recover(sigShares, ids);
+        assert(ok);
+    }
+}
+
+static void BLS_Recover_LLMQ_50_60(benchmark::State& state)
+{
+    BLS_Recover_LLMQ(Consensus::LLMQ_50_60, state);
+}
+
+static void BLS_Recover_LLMQ_100_67(benchmark::State& state)
+{
+    BLS_Recover_LLMQ(Consensus::LLMQ_100_67, state);
+}
+
+static void BLS_Recover_LLMQ_400_60(benchmark::State& state)
+{
+    BLS_Recover_LLMQ(Consensus::LLMQ_400_60, state);
+}
+
+static void BLS_Recover_LLMQ_400_85(benchmark::State& state)
+{
+    BLS_Recover_LLMQ(Consensus::LLMQ_400_85, state);
+}
+
 static void BLS_Verify_LargeBlock(size_t txCount, benchmark::State& state)
 {
     BLSPublicKeyVector pubKeys;
@@ -358,11 +435,134 @@ static void BLS_Verify_BatchedParallel(benchmark::State& state)
     }
 }
 
+// Aggregates "count" signatures, split into "jobCount" independent AsyncAggregateSigs jobs whose results are then
+// aggregated on the calling thread. The worker aggregates in batches of 16, so the depth of its aggregation tree is
+// roughly log16(count / jobCount)
+static void BLS_AggregateSigs(size_t count, size_t jobCount, bool parallel, benchmark::State& state)
+{
+    BLSPublicKeyVector pubKeys;
+    BLSSecretKeyVector secKeys;
+    BLSSignatureVector sigs;
+    std::vector<uint256> msgHashes;
+    std::vector<bool> invalid;
+    BuildTestVectors(count, 0, pubKeys, secKeys, sigs, msgHashes, invalid);
+
+    const size_t jobSize = (count + jobCount - 1) / jobCount;
+
+    // Benchmark.
+    while (state.KeepRunning()) {
+        std::vector<std::future<CBLSSignature>> futures;
+        futures.reserve(jobCount);
+        for (size_t start = 0; start < count; start += jobSize) {
+            futures.emplace_back(blsWorker.AsyncAggregateSigs(sigs, start, std::min(jobSize, count - start), parallel));
+        }
+        BLSSignatureVector jobSigs;
+        jobSigs.reserve(futures.size());
+        for (auto& f : futures) {
+            jobSigs.emplace_back(f.get());
+        }
+        CBLSSignature aggSig = CBLSSignature::AggregateInsecure(jobSigs);
+        assert(aggSig.IsValid());
+    }
+}
+
+static void BLS_AggregateSigs_16_Jobs1(benchmark::State& state)
+{
+    BLS_AggregateSigs(16, 1, true, state);
+}
+
+static void BLS_AggregateSigs_256_Jobs1(benchmark::State& state)
+{
+    BLS_AggregateSigs(256, 1, true, state);
+}
+
+static void BLS_AggregateSigs_4096_Jobs1(benchmark::State& state)
+{
+    BLS_AggregateSigs(4096, 1, true, state);
+}
+
+static void BLS_AggregateSigs_4096_Jobs16(benchmark::State& state)
+{
+    BLS_AggregateSigs(4096, 16, true, state);
+}
+
+static void BLS_AggregateSigs_4096_Jobs256(benchmark::State& state)
+{
+    BLS_AggregateSigs(4096, 256, true, state);
+}
+
+static void BLS_AggregateSigs_4096_Sync(benchmark::State& state)
+{
+    BLS_AggregateSigs(4096, 1, false, state);
+}
+
+// Verifies "batchSize" signatures of distinct messages from distinct sources through CBLSBatchVerifier, which is how
+// sig shares are verified in CSigSharesManager
+static void BLS_BatchVerifier(size_t batchSize, benchmark::State& state)
+{
+    BLSPublicKeyVector pubKeys;
+    BLSSecretKeyVector secKeys;
+    BLSSignatureVector sigs;
+    std::vector<uint256> msgHashes;
+    std::vector<bool> invalid;
+    BuildTestVectors(batchSize, 0, pubKeys, secKeys, sigs, msgHashes, invalid);
+
+    // Benchmark.
+    while (state.KeepRunning()) {
+        CBLSBatchVerifier<size_t, size_t> batchVerifier(false, true);
+        for (size_t i = 0; i < batchSize; i++) {
+            batchVerifier.PushMessage(i, i, msgHashes[i], sigs[i], pubKeys[i]);
+        }
+        batchVerifier.Verify();
+        assert(batchVerifier.badSources.empty());
+    }
+}
+
+static void BLS_BatchVerifier_1(benchmark::State& state)
+{
+    BLS_BatchVerifier(1, state);
+}
+
+static void BLS_BatchVerifier_4(benchmark::State& state)
+{
+    BLS_BatchVerifier(4, state);
+}
+
+static void BLS_BatchVerifier_16(benchmark::State& state)
+{
+    BLS_BatchVerifier(16, state);
+}
+
+static void BLS_BatchVerifier_64(benchmark::State& state)
+{
+    BLS_BatchVerifier(64, state);
+}
+
+static void BLS_BatchVerifier_256(benchmark::State& state)
+{
+    BLS_BatchVerifier(256, state);
+}
+
+static void BLS_BatchVerifier_1024(benchmark::State& state)
+{
+    BLS_BatchVerifier(1024, state);
+}
+
+static void BLS_BatchVerifier_4096(benchmark::State& state)
+{
+    BLS_BatchVerifier(4096, state);
+}
+
 BENCHMARK(BLS_PubKeyAggregate_Normal, 700 * 1000)
 BENCHMARK(BLS_SecKeyAggregate_Normal, 1300 * 1000)
 BENCHMARK(BLS_SignatureAggregate_Normal, 300 * 1000)
 BENCHMARK(BLS_Sign_Normal, 600)
 BENCHMARK(BLS_Verify_Normal, 350)
+BENCHMARK(BLS_Recover_Normal, 1)
+BENCHMARK(BLS_Recover_LLMQ_50_60, 20)
+BENCHMARK(BLS_Recover_LLMQ_100_67, 10)
+BENCHMARK(BLS_Recover_LLMQ_400_60, 1)
+BENCHMARK(BLS_Recover_LLMQ_400_85, 1)
 BENCHMARK(BLS_Verify_LargeBlock100, 3)
 BENCHMARK(BLS_Verify_LargeBlock1000, 1)
 BENCHMARK(BLS_Verify_LargeBlockSelfAggregated100, 7)
@@ -372,3 +572,16 @@ BENCHMARK(BLS_Verify_LargeAggregatedBlock1000, 1)
 BENCHMARK(BLS_Verify_LargeAggregatedBlock1000PreVerified, 7)
 BENCHMARK(BLS_Verify_Batched, 500)
 BENCHMARK(BLS_Verify_BatchedParallel, 1000)
+BENCHMARK(BLS_AggregateSigs_16_Jobs1, 20 * 1000)
+BENCHMARK(BLS_AggregateSigs_256_Jobs1, 2000)
+BENCHMARK(BLS_AggregateSigs_4096_Jobs1, 150)
+BENCHMARK(BLS_AggregateSigs_4096_Jobs16, 150)
+BENCHMARK(BLS_AggregateSigs_4096_Jobs256, 100)
+BENCHMARK(BLS_AggregateSigs_4096_Sync, 70)
+BENCHMARK(BLS_BatchVerifier_1, 300)
+BENCHMARK(BLS_BatchVerifier_4, 80)
+BENCHMARK(BLS_BatchVerifier_16, 20)
+BENCHMARK(BLS_BatchVerifier_64, 5)
+BENCHMARK(BLS_BatchVerifier_256, 1)
+BENCHMARK(BLS_BatchVerifier_1024, 1)
+BENCHMARK(BLS_BatchVerifier_4096, 1)
@@ -2,11 +2,13 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <arith_uint256.h>
 #include <bench/bench.h>
 #include <coins.h>
 #include <policy/policy.h>
 #include <wallet/crypter.h>
 
+#include <unordered_map>
 #include <vector>
 
 // FIXME: Dedup with SetupDummyInputs in test/transaction_tests.cpp.
@@ -84,4 +86,40 @@ static void CCoinsCaching(benchmark::State& state)
     }
 }
 
+// Fills a coins map like a cache during IBD and frees it again like a flush does, once with the pool allocator of
+// CCoinsMap and once with one malloc'ed node per coin
+template <typename Map>
+static void CoinsMapFillAndFree(benchmark::State& state)
+{
+    std::vector<COutPoint> vOutPoints;
+    for (uint32_t i = 0; i < 10000; i++) {
+        vOutPoints.emplace_back(ArithToUint256(arith_uint256(i)), i % 4);
+    }
+
+    while (state.KeepRunning()) {
+        Map map;
+        for (const auto& outpoint : vOutPoints) {
+            CCoinsCacheEntry& entry = map[outpoint];
+            entry.coin.out.nValue = 1;
+            entry.flags = CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH;
+        }
+        // half of the coins are spent before the flush
+        for (size_t i = 0; i < vOutPoints.size(); i += 2) {
+            map.erase(vOutPoints[i]);
+        }
+    }
+}
+
+static void CCoinsMapPooled(benchmark::State& state)
+{
+    CoinsMapFillAndFree<CCoinsMap>(state);
+}
+
+static void CCoinsMapUnpooled(benchmark::State& state)
+{
+    CoinsMapFillAndFree<std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher>>(state);
+}
+
 BENCHMARK(CCoinsCaching, 170 * 1000);
+BENCHMARK(CCoinsMapPooled, 500);
+BENCHMARK(CCoinsMapUnpooled, 300);
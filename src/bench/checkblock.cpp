@@ -7,10 +7,13 @@
 #include <chainparams.h>
 #include <validation.h>
 #include <streams.h>
+#include <util.h>
 #include <consensus/validation.h>
 
 #include <bench/data/block813851.raw.h>
 
+#include <boost/thread/thread.hpp>
+
 // These are the two major time-sinks which happen after we have fully received
 // a block off the wire, but before we can relay the block on to peers using
 // compact block relay.
@@ -50,5 +53,39 @@ static void DeserializeAndCheckBlockTest(benchmark::State& state)
     }
 }
 
+// Same as above, but with the transactions checked on the transaction check threads
+static void DeserializeAndCheckBlockParallelTest(benchmark::State& state)
+{
+    CDataStream stream((const char*)raw_bench::block813851,
+            (const char*)&raw_bench::block813851[sizeof(raw_bench::block813851)],
+            SER_NETWORK, PROTOCOL_VERSION);
+    char a = '\0';
+    stream.write(&a, 1); // Prevent compaction
+
+    const auto chainParams = CreateChainParams(CBaseChainParams::MAIN);
+
+    const int nThreads = std::max(2, std::min(GetNumCores(), MAX_SCRIPTCHECK_THREADS));
+    boost::thread_group tg;
+    for (int i = 0; i < nThreads - 1; i++) {
+        tg.create_thread(&ThreadTransactionCheck);
+    }
+    const int nScriptCheckThreadsPrev = nScriptCheckThreads;
+    nScriptCheckThreads = nThreads;
+
+    while (state.KeepRunning()) {
+        CBlock block;
+        stream >> block;
+        assert(stream.Rewind(sizeof(raw_bench::block813851)));
+
+        CValidationState validationState;
+        assert(CheckBlock(block, validationState, chainParams->GetConsensus(), block.GetBlockTime()));
+    }
+
+    nScriptCheckThreads = nScriptCheckThreadsPrev;
+    tg.interrupt_all();
+    tg.join_all();
+}
+
 BENCHMARK(DeserializeBlockTest, 130);
 BENCHMARK(DeserializeAndCheckBlockTest, 160);
+BENCHMARK(DeserializeAndCheckBlockParallelTest, 160);
@@ -10,6 +10,7 @@
 #include <vector>
 #include <boost/thread/thread.hpp>
 #include <random.h>
+#include <crypto/sha256.h>
 
 
 static const int MIN_CORES = 2;
@@ -60,3 +61,51 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::State& state)
     tg.join_all();
 }
 BENCHMARK(CCheckQueueSpeedPrevectorJob, 1400);
+
+// This Benchmark shows how the CheckQueue scales with the number of worker
+// threads. Each check hashes a small buffer, which is closer to the cost of a
+// signature check relative to the queue overhead than the empty job above.
+template <int THREADS>
+static void CCheckQueueScaling(benchmark::State& state)
+{
+    struct HashJob {
+        unsigned char data[64] = {0};
+        HashJob() {}
+        bool operator()()
+        {
+            for (int i = 0; i < 16; ++i)
+                CSHA256().Write(data, sizeof(data)).Finalize(data);
+            return true;
+        }
+        void swap(HashJob& x) { std::swap(data, x.data); };
+    };
+    CCheckQueue<HashJob> queue {QUEUE_BATCH_SIZE};
+    boost::thread_group tg;
+    // The master joins in on Wait, so it counts as one of the threads.
+    for (auto x = 0; x < THREADS - 1; ++x) {
+       tg.create_thread([&]{queue.Thread();});
+    }
+    while (state.KeepRunning()) {
+        CCheckQueueControl<HashJob> control(&queue);
+        std::vector<std::vector<HashJob>> vBatches(BATCHES);
+        for (auto& vChecks : vBatches) {
+            vChecks.resize(BATCH_SIZE);
+            control.Add(vChecks);
+        }
+        control.Wait();
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+static void CCheckQueueScaling_1Thread(benchmark::State& state) { CCheckQueueScaling<1>(state); }
+static void CCheckQueueScaling_2Threads(benchmark::State& state) { CCheckQueueScaling<2>(state); }
+static void CCheckQueueScaling_4Threads(benchmark::State& state) { CCheckQueueScaling<4>(state); }
+static void CCheckQueueScaling_8Threads(benchmark::State& state) { CCheckQueueScaling<8>(state); }
+static void CCheckQueueScaling_16Threads(benchmark::State& state) { CCheckQueueScaling<16>(state); }
+
+BENCHMARK(CCheckQueueScaling_1Thread, 10);
+BENCHMARK(CCheckQueueScaling_2Threads, 20);
+BENCHMARK(CCheckQueueScaling_4Threads, 40);
+BENCHMARK(CCheckQueueScaling_8Threads, 80);
+BENCHMARK(CCheckQueueScaling_16Threads, 160);
@@ -3,6 +3,9 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <bench/bench.h>
+#include <coinjoin/coinjoin.h>
+#include <coinjoin/coinjoin-client-options.h>
+#include <coinjoin/coinjoin-util.h>
 #include <wallet/wallet.h>
 #include <wallet/coinselection.h>
 
@@ -62,6 +65,48 @@ static void CoinSelection(benchmark::State& state)
     }
 }
 
+// Fills a large wallet with a mix of denominated and non-denominated coins once and selects
+// from it repeatedly, the way a long-running CoinJoin wallet would
+static void CoinSelectionLargeWallet(benchmark::State& state, int nCoins, bool fUseBnB, CoinType nCoinType)
+{
+    const CWallet wallet(WalletLocation(), WalletDatabase::CreateDummy());
+    std::vector<COutput> vCoins;
+    LOCK(wallet.cs_wallet);
+
+    const std::vector<CAmount>& vecDenoms = CCoinJoin::GetStandardDenominations();
+    vCoins.reserve(nCoins);
+    for (int i = 0; i < nCoins; i++) {
+        if (nCoinType == CoinType::ONLY_FULLY_MIXED || i % 2 == 0) {
+            addCoin(vecDenoms[i % vecDenoms.size()], wallet, vCoins);
+        } else {
+            addCoin((i % 1000 + 1) * COIN / 10, wallet, vCoins);
+        }
+    }
+
+    CoinEligibilityFilter filter_standard(1, 6, 0);
+    CoinSelectionParams coin_selection_params(fUseBnB, 34, 148, CFeeRate(0), 0);
+    while (state.KeepRunning()) {
+        std::set<CInputCoin> setCoinsRet;
+        CAmount nValueRet;
+        bool bnb_used;
+        wallet.SelectCoinsMinConf(50 * COIN, filter_standard, vCoins, setCoinsRet, nValueRet, coin_selection_params, bnb_used, nCoinType);
+    }
+
+    for (COutput& output : vCoins) {
+        delete output.tx;
+    }
+}
+
+static void CoinSelectionKnapsack10k(benchmark::State& state) { CoinSelectionLargeWallet(state, 10000, false, CoinType::ALL_COINS); }
+static void CoinSelectionKnapsack50k(benchmark::State& state) { CoinSelectionLargeWallet(state, 50000, false, CoinType::ALL_COINS); }
+static void CoinSelectionKnapsack200k(benchmark::State& state) { CoinSelectionLargeWallet(state, 200000, false, CoinType::ALL_COINS); }
+static void CoinSelectionBnB10k(benchmark::State& state) { CoinSelectionLargeWallet(state, 10000, true, CoinType::ALL_COINS); }
+static void CoinSelectionBnB50k(benchmark::State& state) { CoinSelectionLargeWallet(state, 50000, true, CoinType::ALL_COINS); }
+static void CoinSelectionBnB200k(benchmark::State& state) { CoinSelectionLargeWallet(state, 200000, true, CoinType::ALL_COINS); }
+static void CoinSelectionFullyMixed10k(benchmark::State& state) { CoinSelectionLargeWallet(state, 10000, false, CoinType::ONLY_FULLY_MIXED); }
+static void CoinSelectionFullyMixed50k(benchmark::State& state) { CoinSelectionLargeWallet(state, 50000, false, CoinType::ONLY_FULLY_MIXED); }
+static void CoinSelectionFullyMixed200k(benchmark::State& state) { CoinSelectionLargeWallet(state, 200000, false, CoinType::ONLY_FULLY_MIXED); }
+
 typedef std::set<CInputCoin> CoinSet;
 
 // Copied from src/wallet/test/coinselector_tests.cpp
@@ -104,5 +149,52 @@ static void BnBExhaustion(benchmark::State& state)
     }
 }
 
+// Plans the denominations for a tally item of 100 inputs the way CCoinJoinClientSession::CreateDenominated
+// processes the remainder, from the largest denomination to the smallest one
+static void CoinJoinPlanDenominations(benchmark::State& state)
+{
+    auto wallet = std::make_shared<CWallet>(WalletLocation(), WalletDatabase::CreateDummy());
+    CompactTallyItem tallyItem;
+    {
+        LOCK(wallet->cs_wallet);
+        CKey key;
+        key.MakeNewKey(true);
+        wallet->AddKeyPubKey(key, key.GetPubKey());
+        tallyItem.txdest = key.GetPubKey().GetID();
+        CScript scriptPubKey = GetScriptForDestination(tallyItem.txdest);
+        for (int i = 0; i < 100; i++) {
+            CMutableTransaction tx;
+            tx.nLockTime = i; // so all transactions get different hashes
+            tx.vout.emplace_back(10 * COIN, scriptPubKey);
+            tallyItem.vecInputCoins.emplace_back(MakeTransactionRef(std::move(tx)), 0);
+            tallyItem.nAmount += 10 * COIN;
+        }
+    }
+
+    CTransactionBuilder txBuilder(wallet, tallyItem);
+
+    while (state.KeepRunning()) {
+        CTransactionBuilderPlan plan(txBuilder);
+        for (auto nDenomValue : CCoinJoin::GetStandardDenominations()) {
+            int nOutputs = plan.CountPossibleOutputs(nDenomValue, COINJOIN_DENOM_OUTPUTS_THRESHOLD - plan.CountOutputs());
+            for (int i = 0; i < nOutputs; i++) {
+                bool fAdded = plan.AddOutput(nDenomValue);
+                assert(fAdded);
+            }
+        }
+        assert(plan.CountOutputs() > 0);
+    }
+}
+
 BENCHMARK(CoinSelection, 650);
 BENCHMARK(BnBExhaustion, 650);
+BENCHMARK(CoinSelectionKnapsack10k, 10);
+BENCHMARK(CoinSelectionKnapsack50k, 3);
+BENCHMARK(CoinSelectionKnapsack200k, 1);
+BENCHMARK(CoinSelectionBnB10k, 10);
+BENCHMARK(CoinSelectionBnB50k, 3);
+BENCHMARK(CoinSelectionBnB200k, 1);
+BENCHMARK(CoinSelectionFullyMixed10k, 10);
+BENCHMARK(CoinSelectionFullyMixed50k, 3);
+BENCHMARK(CoinSelectionFullyMixed200k, 1);
+BENCHMARK(CoinJoinPlanDenominations, 100);
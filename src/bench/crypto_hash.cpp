@@ -8,6 +8,7 @@
 #include <bench/bench.h>
 #include <bloom.h>
 #include <hash.h>
+#include <primitives/block.h>
 #include <random.h>
 #include <uint256.h>
 #include <utiltime.h>
@@ -15,6 +16,16 @@
 #include <crypto/sha1.h>
 #include <crypto/sha256.h>
 #include <crypto/sha512.h>
+#include <crypto/x11.h>
+#include <crypto/sph_blake.h>
+#include <crypto/sph_bmw.h>
+#include <crypto/sph_cubehash.h>
+#include <crypto/sph_groestl.h>
+#include <crypto/sph_jh.h>
+#include <crypto/sph_keccak.h>
+#include <crypto/sph_luffa.h>
+#include <crypto/sph_simd.h>
+#include <crypto/sph_skein.h>
 
 /* Number of bytes to hash per iteration */
 static const uint64_t BUFFER_SIZE = 1000*1000;
@@ -210,6 +221,69 @@ static void HASH_X11_2048b_single(benchmark::State& state)
         hash = HashX11(in.begin(), in.end());
 }
 
+/* A single X11 step on a 64 byte input, as hashed by every step but the first */
+template <typename Context, void (*Init)(void*), void (*Update)(void*, const void*, size_t), void (*Close)(void*, void*)>
+static void X11Step(benchmark::State& state)
+{
+    Context ctx;
+    std::vector<uint8_t> in(64,0);
+    while (state.KeepRunning()) {
+        Init(&ctx);
+        Update(&ctx, in.data(), in.size());
+        Close(&ctx, in.data());
+    }
+}
+
+static void HASH_X11_BLAKE512_0064b(benchmark::State& state) { X11Step<sph_blake512_context, sph_blake512_init, sph_blake512, sph_blake512_close>(state); }
+static void HASH_X11_BMW512_0064b(benchmark::State& state) { X11Step<sph_bmw512_context, sph_bmw512_init, sph_bmw512, sph_bmw512_close>(state); }
+static void HASH_X11_GROESTL512_0064b(benchmark::State& state) { X11Step<sph_groestl512_context, sph_groestl512_init, sph_groestl512, sph_groestl512_close>(state); }
+static void HASH_X11_SKEIN512_0064b(benchmark::State& state) { X11Step<sph_skein512_context, sph_skein512_init, sph_skein512, sph_skein512_close>(state); }
+static void HASH_X11_JH512_0064b(benchmark::State& state) { X11Step<sph_jh512_context, sph_jh512_init, sph_jh512, sph_jh512_close>(state); }
+static void HASH_X11_KECCAK512_0064b(benchmark::State& state) { X11Step<sph_keccak512_context, sph_keccak512_init, sph_keccak512, sph_keccak512_close>(state); }
+static void HASH_X11_LUFFA512_0064b(benchmark::State& state) { X11Step<sph_luffa512_context, sph_luffa512_init, sph_luffa512, sph_luffa512_close>(state); }
+static void HASH_X11_CUBEHASH512_0064b(benchmark::State& state) { X11Step<sph_cubehash512_context, sph_cubehash512_init, sph_cubehash512, sph_cubehash512_close>(state); }
+static void HASH_X11_SIMD512_0064b(benchmark::State& state) { X11Step<sph_simd512_context, sph_simd512_init, sph_simd512, sph_simd512_close>(state); }
+
+static void HASH_X11_ECHO512_0064b(benchmark::State& state)
+{
+    std::vector<uint8_t> in(64,0);
+    while (state.KeepRunning())
+        X11Echo512_64(in.data(), in.data());
+}
+
+static void HASH_X11_SHAVITE512_0064b(benchmark::State& state)
+{
+    std::vector<uint8_t> in(64,0);
+    while (state.KeepRunning())
+        X11Shavite512_64(in.data(), in.data());
+}
+
+static void HASH_X11_SHAVITE512_0064b_multi(benchmark::State& state)
+{
+    std::vector<uint8_t> in(64 * X11_MULTI_LANES,0);
+    while (state.KeepRunning())
+        X11Shavite512_64Multi(in.data(), in.data(), X11_MULTI_LANES);
+}
+
+static void HASH_X11_HEADERS_2000(benchmark::State& state)
+{
+    std::vector<CBlockHeader> headers(2000);
+    std::vector<uint256> hashes(headers.size());
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < headers.size(); i++) {
+            hashes[i] = headers[i].GetHash();
+        }
+    }
+}
+
+static void HASH_X11_HEADERS_2000_multi(benchmark::State& state)
+{
+    std::vector<CBlockHeader> headers(2000);
+    std::vector<uint256> hashes(headers.size());
+    while (state.KeepRunning())
+        HashX11Multi(headers.data(), headers.size(), hashes.data());
+}
+
 BENCHMARK(HASH_RIPEMD160, 440);
 BENCHMARK(HASH_SHA1, 570);
 BENCHMARK(HASH_SHA256, 340);
@@ -234,5 +308,19 @@ BENCHMARK(HASH_X11_0128b_single, 60 * 1000);
 BENCHMARK(HASH_X11_0512b_single, 50 * 1000);
 BENCHMARK(HASH_X11_1024b_single, 50 * 1000);
 BENCHMARK(HASH_X11_2048b_single, 50 * 1000);
+BENCHMARK(HASH_X11_BLAKE512_0064b, 1000 * 1000);
+BENCHMARK(HASH_X11_BMW512_0064b, 1000 * 1000);
+BENCHMARK(HASH_X11_GROESTL512_0064b, 1000 * 1000);
+BENCHMARK(HASH_X11_SKEIN512_0064b, 1000 * 1000);
+BENCHMARK(HASH_X11_JH512_0064b, 1000 * 1000);
+BENCHMARK(HASH_X11_KECCAK512_0064b, 1000 * 1000);
+BENCHMARK(HASH_X11_LUFFA512_0064b, 1000 * 1000);
+BENCHMARK(HASH_X11_CUBEHASH512_0064b, 1000 * 1000);
+BENCHMARK(HASH_X11_SHAVITE512_0064b, 1000 * 1000);
+BENCHMARK(HASH_X11_SHAVITE512_0064b_multi, 200 * 1000);
+BENCHMARK(HASH_X11_SIMD512_0064b, 1000 * 1000);
+BENCHMARK(HASH_X11_ECHO512_0064b, 1000 * 1000);
+BENCHMARK(HASH_X11_HEADERS_2000, 20);
+BENCHMARK(HASH_X11_HEADERS_2000_multi, 20);
 BENCHMARK(FastRandom_32bit, 110 * 1000 * 1000);
 BENCHMARK(FastRandom_1bit, 440 * 1000 * 1000);
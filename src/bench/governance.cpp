@@ -0,0 +1,335 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bls/bls.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <evo/deterministicmns.h>
+#include <evo/evodb.h>
+#include <flat-database.h>
+#include <governance/governance.h>
+#include <governance/governance-classes.h>
+#include <governance/governance-object.h>
+#include <governance/governance-vote.h>
+#include <governance/governance-votedb.h>
+#include <key.h>
+#include <key_io.h>
+#include <masternode/masternode-meta.h>
+#include <masternode/masternode-sync.h>
+#include <net.h>
+#include <random.h>
+#include <scheduler.h>
+#include <utilstrencodings.h>
+#include <validationinterface.h>
+
+#include <univalue.h>
+
+#include <boost/thread.hpp>
+
+static const size_t BENCH_MASTERNODES = 100;
+
+// same key as DB_LIST_SNAPSHOT in evo/deterministicmns.cpp
+static const std::string DB_LIST_SNAPSHOT = "dmn_S";
+
+/**
+ * Sets up the global state the governance code depends on: regtest params, in-memory evoDb and governanceDB, a
+ * masternode list with nMasternodes entries at a synthetic chain tip and a blockchain-synced masternodeSync.
+ * Objects are written to governanceDB first and picked up by a single call to LoadObjects, the same way they are
+ * loaded on startup, which avoids the collateral checks of CGovernanceManager::AddGovernanceObject.
+ */
+class GovernanceBenchSetup
+{
+public:
+    struct Masternode {
+        COutPoint collateralOutpoint;
+        CKey votingKey;
+        CBLSSecretKey operatorKey;
+    };
+
+    std::vector<Masternode> masternodes;
+    std::unique_ptr<CConnman> connman;
+
+private:
+    uint256 tipHash;
+    CBlockIndex tipIndex;
+    CScheduler scheduler;
+    boost::thread schedulerThread;
+
+public:
+    explicit GovernanceBenchSetup(size_t nMasternodes)
+    {
+        SelectParams(CBaseChainParams::REGTEST);
+
+        schedulerThread = boost::thread(boost::bind(&CScheduler::serviceQueue, &scheduler));
+        GetMainSignals().RegisterBackgroundSignalScheduler(scheduler);
+        connman.reset(new CConnman(0x1337, 0x1337));
+
+        evoDb.reset(new CEvoDB(1 << 20, true, true));
+        deterministicMNManager.reset(new CDeterministicMNManager(*evoDb));
+        governanceDB = new CGovernanceDB(true, true);
+
+        tipHash = GetRandHash();
+        tipIndex.phashBlock = &tipHash;
+        tipIndex.nHeight = Params().GetConsensus().nSuperblockStartBlock - 10;
+
+        CDeterministicMNList mnList(tipHash, tipIndex.nHeight, 0);
+        for (size_t i = 0; i < nMasternodes; i++) {
+            Masternode mn;
+            CKey ownerKey;
+            ownerKey.MakeNewKey(true);
+            mn.collateralOutpoint = COutPoint(GetRandHash(), 0);
+            mn.votingKey.MakeNewKey(true);
+            mn.operatorKey.MakeNewKey();
+
+            auto dmnState = std::make_shared<CDeterministicMNState>();
+            dmnState->nRegisteredHeight = 1;
+            dmnState->keyIDOwner = ownerKey.GetPubKey().GetID();
+            dmnState->pubKeyOperator.Set(mn.operatorKey.GetPublicKey());
+            dmnState->keyIDVoting = mn.votingKey.GetPubKey().GetID();
+
+            auto dmn = std::make_shared<CDeterministicMN>(i);
+            dmn->proTxHash = GetRandHash();
+            dmn->collateralOutpoint = mn.collateralOutpoint;
+            dmn->nOperatorReward = 0;
+            dmn->pdmnState = dmnState;
+            mnList.AddMN(dmn);
+
+            masternodes.emplace_back(std::move(mn));
+        }
+        evoDb->Write(std::make_pair(DB_LIST_SNAPSHOT, tipHash), mnList);
+        deterministicMNManager->UpdatedBlockTip(&tipIndex);
+
+        // past MASTERNODE_SYNC_BLOCKCHAIN, but not fully synced so that nothing is relayed
+        masternodeSync.Reset(true, false);
+        masternodeSync.SwitchToNextAsset(*connman);
+    }
+
+    ~GovernanceBenchSetup()
+    {
+        governance.Clear();
+        // removes all triggers from triggerman as their objects are gone now
+        governance.UpdateCachesAndClean();
+        mmetaman.Clear();
+        masternodeSync.Reset(true, false);
+
+        schedulerThread.interrupt();
+        schedulerThread.join();
+        GetMainSignals().FlushBackgroundCallbacks();
+        GetMainSignals().UnregisterBackgroundSignalScheduler();
+        connman.reset();
+
+        delete governanceDB;
+        governanceDB = nullptr;
+        deterministicMNManager.reset();
+        evoDb.reset();
+    }
+
+    // Writes nCount valid proposals to governanceDB and returns their hashes
+    std::vector<uint256> AddProposals(size_t nCount)
+    {
+        int64_t nNow = GetAdjustedTime();
+        std::vector<uint256> vecHashes;
+        for (size_t i = 0; i < nCount; i++) {
+            CKey paymentKey;
+            paymentKey.MakeNewKey(true);
+
+            UniValue obj(UniValue::VOBJ);
+            obj.pushKV("type", GOVERNANCE_OBJECT_PROPOSAL);
+            obj.pushKV("name", strprintf("bench-proposal-%d", i));
+            obj.pushKV("start_epoch", nNow - 60 * 60);
+            obj.pushKV("end_epoch", nNow + 30 * 24 * 60 * 60);
+            obj.pushKV("payment_amount", 10);
+            obj.pushKV("payment_address", EncodeDestination(paymentKey.GetPubKey().GetID()));
+            obj.pushKV("url", "https://www.dash.org");
+
+            CGovernanceObject govobj(uint256(), 1, nNow, GetRandHash(), HexStr(obj.write()));
+            governanceDB->WriteObject(govobj);
+            vecHashes.emplace_back(govobj.GetHash());
+        }
+        return vecHashes;
+    }
+
+    // Writes a trigger with nPayments payments for the superblock at nBlockHeight to governanceDB
+    uint256 AddTrigger(int nBlockHeight, size_t nPayments)
+    {
+        std::string strAddresses, strAmounts;
+        for (size_t i = 0; i < nPayments; i++) {
+            CKey paymentKey;
+            paymentKey.MakeNewKey(true);
+            if (i != 0) {
+                strAddresses += "|";
+                strAmounts += "|";
+            }
+            strAddresses += EncodeDestination(paymentKey.GetPubKey().GetID());
+            strAmounts += "1.00000000";
+        }
+
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("type", GOVERNANCE_OBJECT_TRIGGER);
+        obj.pushKV("event_block_height", nBlockHeight);
+        obj.pushKV("payment_addresses", strAddresses);
+        obj.pushKV("payment_amounts", strAmounts);
+
+        const auto& mn = masternodes[GetRandInt(masternodes.size())];
+        CGovernanceObject govobj(uint256(), 1, GetAdjustedTime(), uint256(), HexStr(obj.write()));
+        govobj.SetMasternodeOutpoint(mn.collateralOutpoint);
+        govobj.Sign(mn.operatorKey);
+        governanceDB->WriteObject(govobj);
+        return govobj.GetHash();
+    }
+
+    void LoadObjects()
+    {
+        governance.InitOnLoad();
+    }
+
+    // Funding votes on proposals are signed with the voting key, all others with the operator key
+    CGovernanceVote CreateVote(const Masternode& mn, const uint256& nParentHash, bool fProposal) const
+    {
+        CGovernanceVote vote(mn.collateralOutpoint, nParentHash, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES);
+        bool fSigned = fProposal ? vote.Sign(mn.votingKey, mn.votingKey.GetPubKey().GetID()) : vote.Sign(mn.operatorKey);
+        assert(fSigned);
+        return vote;
+    }
+
+    // Creates nVotesPerObject votes from different masternodes for each object
+    std::vector<CGovernanceVote> CreateVotes(const std::vector<uint256>& vecHashes, size_t nVotesPerObject, bool fProposal) const
+    {
+        assert(nVotesPerObject <= masternodes.size());
+        std::vector<CGovernanceVote> vecVotes;
+        vecVotes.reserve(vecHashes.size() * nVotesPerObject);
+        for (const auto& nHash : vecHashes) {
+            for (size_t i = 0; i < nVotesPerObject; i++) {
+                vecVotes.emplace_back(CreateVote(masternodes[i], nHash, fProposal));
+            }
+        }
+        return vecVotes;
+    }
+
+    void ProcessVote(const CGovernanceVote& vote)
+    {
+        CGovernanceException exception;
+        bool fOk = governance.ProcessVoteAndRelay(vote, exception, *connman);
+        assert(fOk);
+    }
+};
+
+// Full processing of new proposal funding votes, including signature verification and storing the vote
+static void Governance_ProcessVote(benchmark::State& state)
+{
+    GovernanceBenchSetup setup(BENCH_MASTERNODES);
+    size_t nVotes = state.m_num_iters * state.m_num_evals;
+    auto vecHashes = setup.AddProposals((nVotes + BENCH_MASTERNODES - 1) / BENCH_MASTERNODES);
+    setup.LoadObjects();
+    auto vecVotes = setup.CreateVotes(vecHashes, BENCH_MASTERNODES, true);
+
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        setup.ProcessVote(vecVotes[i++]);
+    }
+}
+
+// Revalidation of 200 proposals with 20 votes each, e.g. after the masternodes list changed
+static void Governance_UpdateCachesAndClean(benchmark::State& state)
+{
+    GovernanceBenchSetup setup(BENCH_MASTERNODES);
+    auto vecHashes = setup.AddProposals(200);
+    setup.LoadObjects();
+    for (const auto& vote : setup.CreateVotes(vecHashes, 20, true)) {
+        setup.ProcessVote(vote);
+    }
+
+    while (state.KeepRunning()) {
+        for (const auto& nHash : vecHashes) {
+            mmetaman.AddDirtyGovernanceObjectHash(nHash);
+        }
+        governance.UpdateCachesAndClean();
+    }
+}
+
+// Serializing 200 proposals with 20 votes each to governanceDB
+static void Governance_WriteObjects(benchmark::State& state)
+{
+    GovernanceBenchSetup setup(BENCH_MASTERNODES);
+    auto vecHashes = setup.AddProposals(200);
+    setup.LoadObjects();
+    for (const auto& vote : setup.CreateVotes(vecHashes, 20, true)) {
+        setup.ProcessVote(vote);
+    }
+
+    LOCK(governance.cs);
+    while (state.KeepRunning()) {
+        for (const auto& nHash : vecHashes) {
+            governanceDB->WriteObject(*governance.FindGovernanceObject(nHash));
+        }
+    }
+}
+
+// Deserializing 200 proposals with 20 votes each from governanceDB, as done on startup
+static void Governance_LoadObjects(benchmark::State& state)
+{
+    GovernanceBenchSetup setup(BENCH_MASTERNODES);
+    auto vecHashes = setup.AddProposals(200);
+    setup.LoadObjects();
+    for (const auto& vote : setup.CreateVotes(vecHashes, 20, true)) {
+        setup.ProcessVote(vote);
+    }
+    governance.FlushObjects();
+
+    while (state.KeepRunning()) {
+        std::map<uint256, CGovernanceObject> mapObjects;
+        governanceDB->LoadObjects(mapObjects);
+        assert(mapObjects.size() == vecHashes.size());
+    }
+}
+
+// Writing and verifying governance.dat, which holds everything except for the objects and votes
+static void Governance_FlatDB(benchmark::State& state)
+{
+    GovernanceBenchSetup setup(BENCH_MASTERNODES);
+    auto vecHashes = setup.AddProposals(200);
+    setup.LoadObjects();
+    for (const auto& vote : setup.CreateVotes(vecHashes, 20, true)) {
+        setup.ProcessVote(vote);
+    }
+
+    CFlatDB<CGovernanceManager> flatdb("governance_bench.dat", "magicGovernanceCache");
+    while (state.KeepRunning()) {
+        bool fOk = flatdb.Dump(governance);
+        assert(fOk);
+    }
+}
+
+// Deciding on the superblock for a height with 5 competing triggers of 20 payments each, after votes changed
+static void Governance_SuperblockTrigger(benchmark::State& state)
+{
+    GovernanceBenchSetup setup(BENCH_MASTERNODES);
+    int nSuperblockHeight = Params().GetConsensus().nSuperblockStartBlock;
+    assert(CSuperblock::IsValidBlockHeight(nSuperblockHeight));
+
+    std::vector<uint256> vecHashes;
+    for (size_t i = 0; i < 5; i++) {
+        vecHashes.emplace_back(setup.AddTrigger(nSuperblockHeight, 20));
+    }
+    setup.LoadObjects();
+    for (const auto& vote : setup.CreateVotes(vecHashes, BENCH_MASTERNODES / 2, false)) {
+        setup.ProcessVote(vote);
+    }
+
+    while (state.KeepRunning()) {
+        triggerman.NotifyTriggerVotesChanged();
+        bool fTriggered = CSuperblockManager::IsSuperblockTriggered(nSuperblockHeight);
+        std::vector<CTxOut> voutSuperblock;
+        bool fPayments = CSuperblockManager::GetSuperblockPayments(nSuperblockHeight, voutSuperblock);
+        assert(fTriggered && fPayments && voutSuperblock.size() == 20);
+    }
+}
+
+BENCHMARK(Governance_ProcessVote, 1000);
+BENCHMARK(Governance_UpdateCachesAndClean, 20);
+BENCHMARK(Governance_WriteObjects, 20);
+BENCHMARK(Governance_LoadObjects, 20);
+BENCHMARK(Governance_FlatDB, 200);
+BENCHMARK(Governance_SuperblockTrigger, 10000);
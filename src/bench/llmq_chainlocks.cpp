@@ -0,0 +1,68 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <llmq/quorums_chainlocks.h>
+#include <llmq/quorums_utils.h>
+#include <random.h>
+#include <streams.h>
+
+// Message parsing and signature verification of CLSIGs, as done in CChainLocksHandler::ProcessNewChainLock when the
+// CLSIG is not cached yet
+static void CLSig_DeserializeAndVerify(benchmark::State& state)
+{
+    CBLSSecretKey quorumSecKey;
+    quorumSecKey.MakeNewKey();
+    CBLSPublicKey quorumPubKey = quorumSecKey.GetPublicKey();
+    uint256 quorumHash = GetRandHash();
+
+    llmq::CChainLockSig clsig;
+    clsig.nHeight = 1000;
+    clsig.blockHash = GetRandHash();
+    uint256 requestId = ::SerializeHash(std::make_pair(llmq::CLSIG_REQUESTID_PREFIX, clsig.nHeight));
+    clsig.sig = quorumSecKey.Sign(llmq::CLLMQUtils::BuildSignHash(Consensus::LLMQ_400_60, quorumHash, requestId, clsig.blockHash));
+
+    CDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
+    ds << clsig;
+    const std::vector<char> data(ds.begin(), ds.end());
+
+    while (state.KeepRunning()) {
+        CDataStream vRecv(data.data(), data.data() + data.size(), SER_NETWORK, PROTOCOL_VERSION);
+        llmq::CChainLockSig clsig2;
+        vRecv >> clsig2;
+        uint256 id = ::SerializeHash(std::make_pair(llmq::CLSIG_REQUESTID_PREFIX, clsig2.nHeight));
+        uint256 signHash = llmq::CLLMQUtils::BuildSignHash(Consensus::LLMQ_400_60, quorumHash, id, clsig2.blockHash);
+        assert(clsig2.sig.VerifyInsecure(quorumPubKey, signHash));
+    }
+}
+
+// Bookkeeping of first seen times for a block of 1000 TXs: adding them, looking them up when trying to sign the tip
+// and pruning them once the block is deep enough
+static void CLSig_TxFirstSeenTimesPerBlock(benchmark::State& state)
+{
+    llmq::CTxFirstSeenTimes times(0);
+    std::vector<std::vector<uint256>> blocks(7);
+    for (auto& txids : blocks) {
+        for (size_t i = 0; i < 1000; i++) {
+            txids.emplace_back(GetRandHash());
+        }
+    }
+
+    int nHeight = 0;
+    int64_t nTime;
+    while (state.KeepRunning()) {
+        auto& txids = blocks[nHeight % blocks.size()];
+        for (const auto& txid : txids) {
+            times.Add(txid, nHeight, nHeight);
+        }
+        for (const auto& txid : txids) {
+            times.Get(txid, nTime);
+        }
+        times.PruneMined(nHeight - 6);
+        nHeight++;
+    }
+}
+
+BENCHMARK(CLSig_DeserializeAndVerify, 350)
+BENCHMARK(CLSig_TxFirstSeenTimesPerBlock, 2 * 1000)
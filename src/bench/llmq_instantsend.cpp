@@ -0,0 +1,231 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bls/bls_batchverifier.h>
+#include <chainparams.h>
+#include <hash.h>
+#include <llmq/quorums_instantsend.h>
+#include <llmq/quorums_utils.h>
+#include <net.h>
+#include <netbase.h>
+#include <random.h>
+#include <streams.h>
+
+struct SyntheticISLocks {
+    CBLSSecretKey quorumSecKey;
+    CBLSPublicKey quorumPubKey;
+    uint256 quorumHash;
+    std::vector<llmq::CInstantSendLock> islocks;
+    std::vector<uint256> hashes;
+};
+
+// Builds count ISLOCKs with inputsPerLock inputs each, all signed by the same synthetic quorum
+static SyntheticISLocks BuildISLocks(size_t count, size_t inputsPerLock)
+{
+    SyntheticISLocks ret;
+    ret.quorumSecKey.MakeNewKey();
+    ret.quorumPubKey = ret.quorumSecKey.GetPublicKey();
+    ret.quorumHash = GetRandHash();
+
+    for (size_t i = 0; i < count; i++) {
+        llmq::CInstantSendLock islock;
+        islock.txid = GetRandHash();
+        for (size_t j = 0; j < inputsPerLock; j++) {
+            islock.inputs.emplace_back(GetRandHash(), (uint32_t)j);
+        }
+        uint256 signHash = llmq::CLLMQUtils::BuildSignHash(Consensus::LLMQ_50_60, ret.quorumHash, islock.GetRequestId(), islock.txid);
+        islock.sig.Set(ret.quorumSecKey.Sign(signHash));
+        ret.hashes.emplace_back(::SerializeHash(islock));
+        ret.islocks.emplace_back(std::move(islock));
+    }
+    return ret;
+}
+
+// Message parsing and the cheap checks done in ProcessMessageInstantSendLock, per ISLOCK
+static void ISLock_DeserializeAndPreVerify(benchmark::State& state)
+{
+    auto locks = BuildISLocks(1000, 2);
+    CDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
+    for (const auto& islock : locks.islocks) {
+        ds << islock;
+    }
+    const std::vector<char> data(ds.begin(), ds.end());
+
+    CDataStream vRecv(SER_NETWORK, PROTOCOL_VERSION);
+    while (state.KeepRunning()) {
+        if (vRecv.empty()) {
+            vRecv.write(data.data(), data.size());
+        }
+        auto islock = std::make_shared<llmq::CInstantSendLock>();
+        vRecv >> *islock;
+        auto hash = ::SerializeHash(*islock);
+        assert(!hash.IsNull() && llmq::CInstantSendManager::PreVerifyInstantSendLock(*islock));
+    }
+}
+
+// Same as the verification done per part in CInstantSendManager::ProcessPendingInstantSendLocks, 32 ISLOCKs from 4
+// sources per iteration
+static void ISLock_VerifyBatch32(benchmark::State& state)
+{
+    auto locks = BuildISLocks(32, 2);
+
+    while (state.KeepRunning()) {
+        CBLSBatchVerifier<NodeId, uint256> batchVerifier(false, true, 8);
+        for (size_t i = 0; i < locks.islocks.size(); i++) {
+            const auto& islock = locks.islocks[i];
+            uint256 signHash = llmq::CLLMQUtils::BuildSignHash(Consensus::LLMQ_50_60, locks.quorumHash, islock.GetRequestId(), islock.txid);
+            batchVerifier.PushMessage((NodeId)(i % 4), locks.hashes[i], signHash, islock.sig.Get(), locks.quorumPubKey);
+        }
+        batchVerifier.Verify();
+        assert(batchVerifier.badMessages.empty());
+    }
+}
+
+static void ISLock_OutpointIndexLookup(benchmark::State& state)
+{
+    auto locks = BuildISLocks(10000, 2);
+    llmq::CInstantSendOutpointIndex index;
+    index.Init(64 << 20);
+    for (size_t i = 0; i < locks.islocks.size(); i++) {
+        for (const auto& in : locks.islocks[i].inputs) {
+            index.Add(in, locks.hashes[i]);
+        }
+    }
+
+    size_t i = 0;
+    uint256 islockHash;
+    while (state.KeepRunning()) {
+        // alternate between locked and unlocked outpoints
+        const auto& islock = locks.islocks[i % locks.islocks.size()];
+        COutPoint outpoint = (i & 1) ? islock.inputs[0] : COutPoint(islock.txid, 0);
+        index.Lookup(outpoint, islockHash);
+        i++;
+    }
+}
+
+static void ISLock_KnownLocksIsLocked(benchmark::State& state)
+{
+    auto locks = BuildISLocks(1000, 1);
+    llmq::CInstantSendKnownLocks knownLocks;
+    for (size_t i = 0; i < locks.islocks.size(); i++) {
+        knownLocks.Add(locks.hashes[i], locks.islocks[i].txid);
+    }
+
+    size_t i = 0;
+    uint256 islockHash;
+    while (state.KeepRunning()) {
+        knownLocks.GetHashByTxid(locks.islocks[i % locks.islocks.size()].txid, islockHash);
+        i++;
+    }
+}
+
+#ifndef WIN32
+// Returns a connected pair of blocking loopback TCP sockets
+static bool CreateLoopbackSocketPair(SOCKET& hSocket1, SOCKET& hSocket2)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+
+    SOCKET hListenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    bool ret = hListenSocket != INVALID_SOCKET &&
+               bind(hListenSocket, (struct sockaddr*)&addr, len) != SOCKET_ERROR &&
+               listen(hListenSocket, 1) != SOCKET_ERROR &&
+               getsockname(hListenSocket, (struct sockaddr*)&addr, &len) != SOCKET_ERROR;
+    if (ret) {
+        hSocket1 = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        ret = hSocket1 != INVALID_SOCKET && connect(hSocket1, (struct sockaddr*)&addr, len) != SOCKET_ERROR;
+    }
+    if (ret) {
+        hSocket2 = accept(hListenSocket, nullptr, nullptr);
+        ret = hSocket2 != INVALID_SOCKET;
+    }
+    CloseSocket(hListenSocket);
+    return ret;
+}
+
+// An ISLOCK message travelling between two local nodes and back, including header parsing, checksum verification
+// and deserialization on each side. Compares the default socket setup to the one of -lowlatency.
+static void ISLock_LoopbackRelay(benchmark::State& state, bool fLowLatency)
+{
+    const auto chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    auto locks = BuildISLocks(1, 2);
+
+    CDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
+    ds << locks.islocks[0];
+    CMessageHeader hdr(chainParams->MessageStart(), NetMsgType::ISLOCK, ds.size());
+    uint256 hash = Hash(ds.begin(), ds.end());
+    memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
+    CDataStream dsMsg(SER_NETWORK, PROTOCOL_VERSION);
+    dsMsg << hdr;
+    dsMsg.write(ds.data(), ds.size());
+    const std::vector<char> data(dsMsg.begin(), dsMsg.end());
+
+    SOCKET hSocket1 = INVALID_SOCKET, hSocket2 = INVALID_SOCKET;
+    bool fSocketsCreated = CreateLoopbackSocketPair(hSocket1, hSocket2);
+    assert(fSocketsCreated);
+    for (const auto& hSocket : {hSocket1, hSocket2}) {
+        SetSocketNoDelay(hSocket);
+        if (fLowLatency) {
+            SetSocketLowLatency(hSocket);
+        }
+    }
+
+    std::vector<char> vBuf(data.size());
+    auto relay = [&](const SOCKET& hFrom, const SOCKET& hTo) {
+        for (size_t nSent = 0; nSent < data.size(); ) {
+            int nBytes = send(hFrom, data.data() + nSent, data.size() - nSent, MSG_NOSIGNAL);
+            assert(nBytes > 0);
+            nSent += nBytes;
+        }
+
+        CNetMessage msg(chainParams->MessageStart(), SER_NETWORK, PROTOCOL_VERSION);
+        while (!msg.complete()) {
+            int nBytes = recv(hTo, vBuf.data(), vBuf.size(), 0);
+            assert(nBytes > 0);
+            if (fLowLatency) {
+                SetSocketQuickAck(hTo);
+            }
+            for (int nPos = 0; nPos < nBytes; ) {
+                int nHandled = msg.in_data ? msg.readData(vBuf.data() + nPos, nBytes - nPos) : msg.readHeader(vBuf.data() + nPos, nBytes - nPos);
+                assert(nHandled >= 0);
+                nPos += nHandled;
+            }
+        }
+        assert(memcmp(msg.GetMessageHash().begin(), msg.hdr.pchChecksum, CMessageHeader::CHECKSUM_SIZE) == 0);
+        llmq::CInstantSendLock islock;
+        msg.vRecv >> islock;
+    };
+
+    while (state.KeepRunning()) {
+        relay(hSocket1, hSocket2);
+        relay(hSocket2, hSocket1);
+    }
+
+    CloseSocket(hSocket1);
+    CloseSocket(hSocket2);
+}
+
+static void ISLock_LoopbackRelayDefault(benchmark::State& state)
+{
+    ISLock_LoopbackRelay(state, false);
+}
+
+static void ISLock_LoopbackRelayLowLatency(benchmark::State& state)
+{
+    ISLock_LoopbackRelay(state, true);
+}
+#endif // WIN32
+
+BENCHMARK(ISLock_DeserializeAndPreVerify, 300 * 1000)
+BENCHMARK(ISLock_VerifyBatch32, 15)
+BENCHMARK(ISLock_OutpointIndexLookup, 5 * 1000 * 1000)
+BENCHMARK(ISLock_KnownLocksIsLocked, 5 * 1000 * 1000)
+#ifndef WIN32
+BENCHMARK(ISLock_LoopbackRelayDefault, 20 * 1000)
+BENCHMARK(ISLock_LoopbackRelayLowLatency, 20 * 1000)
+#endif
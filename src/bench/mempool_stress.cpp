@@ -0,0 +1,157 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <coins.h>
+#include <policy/policy.h>
+#include <random.h>
+#include <script/standard.h>
+#include <txmempool.h>
+#include <validation.h>
+
+#include <vector>
+
+//! Number of transactions in the benchmarked mempools
+static const size_t MEMPOOL_STRESS_TX_COUNT = 100000;
+//! Number of transactions per block in MempoolRemoveForBlock
+static const size_t MEMPOOL_STRESS_BLOCK_TX_COUNT = 2000;
+
+struct StressTx {
+    CTransactionRef tx;
+    CAmount nFee;
+};
+
+/**
+ * Creates MEMPOOL_STRESS_TX_COUNT transactions in chains of up to 12 transactions, where every transaction of a chain
+ * might have an additional leaf child. This keeps all packages within the default ancestor/descendant limits. The
+ * spent coins are added to view, so that the address and spent indexes find them.
+ */
+static std::vector<StressTx> CreateTxChains(CCoinsViewCache& view)
+{
+    FastRandomContext rand(true);
+    std::vector<StressTx> vtx;
+    vtx.reserve(MEMPOOL_STRESS_TX_COUNT);
+
+    auto createTx = [&](const COutPoint& prevout, CAmount nValueIn) {
+        CMutableTransaction tx;
+        tx.vin.emplace_back(prevout);
+        tx.vin[0].scriptSig = CScript() << OP_1;
+        CAmount nFee = 1000 + rand.randrange(100000);
+        for (int i = 0; i < 2; i++) {
+            CScript script = GetScriptForDestination(CKeyID(uint160(rand.randbytes(20))));
+            tx.vout.emplace_back((nValueIn - nFee) / 2, script);
+        }
+        vtx.push_back({MakeTransactionRef(std::move(tx)), nFee});
+        AddCoins(view, *vtx.back().tx, MEMPOOL_HEIGHT);
+        return vtx.back().tx;
+    };
+
+    while (vtx.size() < MEMPOOL_STRESS_TX_COUNT) {
+        COutPoint prevout(rand.rand256(), 0);
+        CAmount nValue = 100 * COIN;
+        view.AddCoin(prevout, Coin(CTxOut(nValue, GetScriptForDestination(CKeyID(uint160(rand.randbytes(20))))), 1, false), false);
+
+        size_t nChainLength = 1 + rand.randrange(12);
+        for (size_t i = 0; i < nChainLength && vtx.size() < MEMPOOL_STRESS_TX_COUNT; i++) {
+            CTransactionRef tx = createTx(prevout, nValue);
+            if (rand.randrange(3) == 0 && vtx.size() < MEMPOOL_STRESS_TX_COUNT) {
+                createTx(COutPoint(tx->GetHash(), 1), tx->vout[1].nValue);
+            }
+            prevout = COutPoint(tx->GetHash(), 0);
+            nValue = tx->vout[0].nValue;
+        }
+    }
+    return vtx;
+}
+
+/** Does what AcceptToMemoryPool does after the transaction passed its checks */
+static void PopulateMempool(CTxMemPool& pool, const std::vector<StressTx>& vtx, const CCoinsViewCache& view, bool fIndexes) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+{
+    std::string errString;
+    int64_t nTime = 0;
+    for (const auto& stx : vtx) {
+        CTxMemPoolEntry entry(stx.tx, stx.nFee, nTime++, 1, false, 1, LockPoints());
+        CTxMemPool::setEntries setAncestors;
+        bool fOk = pool.CalculateMemPoolAncestors(entry, setAncestors, DEFAULT_ANCESTOR_LIMIT, DEFAULT_ANCESTOR_SIZE_LIMIT * 1000,
+                                                  DEFAULT_DESCENDANT_LIMIT, DEFAULT_DESCENDANT_SIZE_LIMIT * 1000, errString);
+        assert(fOk);
+        pool.addUnchecked(stx.tx->GetHash(), entry, setAncestors, false);
+        if (fIndexes) {
+            pool.addAddressIndex(entry, view);
+            pool.addSpentIndex(entry, view);
+        }
+    }
+}
+
+static void RunMempoolPopulate(benchmark::State& state, bool fIndexes)
+{
+    CCoinsView viewDummy;
+    CCoinsViewCache view(&viewDummy);
+    const std::vector<StressTx> vtx = CreateTxChains(view);
+
+    while (state.KeepRunning()) {
+        CTxMemPool pool;
+        LOCK(pool.cs);
+        PopulateMempool(pool, vtx, view, fIndexes);
+    }
+}
+
+static void MempoolPopulate(benchmark::State& state)
+{
+    RunMempoolPopulate(state, false);
+}
+
+static void MempoolPopulateIndexed(benchmark::State& state)
+{
+    RunMempoolPopulate(state, true);
+}
+
+// Includes populating the mempool, compare with MempoolPopulate
+static void MempoolRemoveForBlock(benchmark::State& state)
+{
+    CCoinsView viewDummy;
+    CCoinsViewCache view(&viewDummy);
+    const std::vector<StressTx> vtx = CreateTxChains(view);
+
+    // the transactions are in topological order, so each block only confirms transactions whose parents are
+    // confirmed already
+    std::vector<std::vector<CTransactionRef>> vBlocks;
+    for (size_t i = 0; i < vtx.size(); i++) {
+        if (i % MEMPOOL_STRESS_BLOCK_TX_COUNT == 0) {
+            vBlocks.emplace_back();
+        }
+        vBlocks.back().emplace_back(vtx[i].tx);
+    }
+
+    while (state.KeepRunning()) {
+        CTxMemPool pool;
+        LOCK(pool.cs);
+        PopulateMempool(pool, vtx, view, false);
+        unsigned int nHeight = 2;
+        for (const auto& block : vBlocks) {
+            pool.removeForBlock(block, nHeight++);
+        }
+        assert(pool.size() == 0);
+    }
+}
+
+// Includes populating the mempool, compare with MempoolPopulate
+static void MempoolTrimToSize(benchmark::State& state)
+{
+    CCoinsView viewDummy;
+    CCoinsViewCache view(&viewDummy);
+    const std::vector<StressTx> vtx = CreateTxChains(view);
+
+    while (state.KeepRunning()) {
+        CTxMemPool pool;
+        LOCK(pool.cs);
+        PopulateMempool(pool, vtx, view, false);
+        pool.TrimToSize(pool.DynamicMemoryUsage() / 2);
+    }
+}
+
+BENCHMARK(MempoolPopulate, 1);
+BENCHMARK(MempoolPopulateIndexed, 1);
+BENCHMARK(MempoolRemoveForBlock, 1);
+BENCHMARK(MempoolTrimToSize, 1);
@@ -3,11 +3,21 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <blockfilter.h>
+#include <evo/providertx.h>
+#include <evo/specialtx.h>
 #include <hash.h>
 #include <primitives/transaction.h>
 #include <script/script.h>
 #include <streams.h>
 
+#include <map>
+#include <mutex>
+
+static const std::map<BlockFilterType, std::string> g_filter_types = {
+    {BlockFilterType::BASIC_FILTER, "basic"},
+    {BlockFilterType::SPECIAL_TX_FILTER, "specialtx"},
+};
+
 /// SerType used to serialize parameters in GCS filter encoding.
 static constexpr int GCS_SER_TYPE = SER_NETWORK;
 
@@ -224,6 +234,108 @@ static GCSFilter::ElementSet BasicFilterElements(const CBlock& block,
     return elements;
 }
 
+static GCSFilter::ElementSet SpecialTxFilterElements(const CBlock& block)
+{
+    GCSFilter::ElementSet elements;
+
+    for (const CTransactionRef& tx : block.vtx) {
+        if (tx->nType == TRANSACTION_PROVIDER_REGISTER) {
+            CProRegTx proTx;
+            if (!GetTxPayload(*tx, proTx)) continue;
+            elements.emplace(proTx.keyIDOwner.begin(), proTx.keyIDOwner.end());
+            elements.emplace(proTx.keyIDVoting.begin(), proTx.keyIDVoting.end());
+            if (!proTx.scriptPayout.empty()) {
+                elements.emplace(proTx.scriptPayout.begin(), proTx.scriptPayout.end());
+            }
+        } else if (tx->nType == TRANSACTION_PROVIDER_UPDATE_REGISTRAR) {
+            CProUpRegTx proTx;
+            if (!GetTxPayload(*tx, proTx)) continue;
+            // the owner key is not part of the payload, owners find their updates by the hash of the ProRegTx
+            elements.emplace(proTx.proTxHash.begin(), proTx.proTxHash.end());
+            elements.emplace(proTx.keyIDVoting.begin(), proTx.keyIDVoting.end());
+            if (!proTx.scriptPayout.empty()) {
+                elements.emplace(proTx.scriptPayout.begin(), proTx.scriptPayout.end());
+            }
+        }
+    }
+
+    return elements;
+}
+
+const std::string& BlockFilterTypeName(BlockFilterType filter_type)
+{
+    static std::string unknown_retval = "";
+    auto it = g_filter_types.find(filter_type);
+    return it != g_filter_types.end() ? it->second : unknown_retval;
+}
+
+bool BlockFilterTypeByName(const std::string& name, BlockFilterType& filter_type) {
+    for (const auto& entry : g_filter_types) {
+        if (entry.second == name) {
+            filter_type = entry.first;
+            return true;
+        }
+    }
+    return false;
+}
+
+const std::vector<BlockFilterType>& AllBlockFilterTypes()
+{
+    static std::vector<BlockFilterType> types;
+
+    static std::once_flag flag;
+    std::call_once(flag, []() {
+            types.reserve(g_filter_types.size());
+            for (auto entry : g_filter_types) {
+                types.push_back(entry.first);
+            }
+        });
+
+    return types;
+}
+
+const std::string& ListBlockFilterTypes()
+{
+    static std::string type_list;
+
+    static std::once_flag flag;
+    std::call_once(flag, []() {
+            bool first = true;
+            for (auto entry : g_filter_types) {
+                if (!first) type_list += ", ";
+                type_list += entry.second;
+                first = false;
+            }
+        });
+
+    return type_list;
+}
+
+BlockFilter::BlockFilter(BlockFilterType filter_type, const uint256& block_hash,
+                         std::vector<unsigned char> filter)
+    : m_filter_type(filter_type), m_block_hash(block_hash)
+{
+    SetEncodedFilter(std::move(filter));
+}
+
+void BlockFilter::SetEncodedFilter(std::vector<unsigned char> encoded_filter)
+{
+    switch (m_filter_type) {
+    case BlockFilterType::BASIC_FILTER:
+        m_filter = GCSFilter(m_block_hash.GetUint64(0), m_block_hash.GetUint64(1),
+                             BASIC_FILTER_P, BASIC_FILTER_M, std::move(encoded_filter));
+        break;
+
+    case BlockFilterType::SPECIAL_TX_FILTER:
+        m_filter = GCSFilter(m_block_hash.GetUint64(0), m_block_hash.GetUint64(1),
+                             BASIC_FILTER_P, BASIC_FILTER_M, std::move(encoded_filter));
+        break;
+
+    default:
+        throw std::ios_base::failure("unknown filter_type");
+    }
+}
+
 BlockFilter::BlockFilter(BlockFilterType filter_type, const CBlock& block, const CBlockUndo& block_undo)
     : m_filter_type(filter_type), m_block_hash(block.GetHash())
 {
@@ -234,6 +346,12 @@ BlockFilter::BlockFilter(BlockFilterType filter_type, const CBlock& block, const
                              BasicFilterElements(block, block_undo));
         break;
 
+    case BlockFilterType::SPECIAL_TX_FILTER:
+        m_filter = GCSFilter(m_block_hash.GetUint64(0), m_block_hash.GetUint64(1),
+                             BASIC_FILTER_P, BASIC_FILTER_M,
+                             SpecialTxFilterElements(block));
+        break;
+
     default:
         throw std::invalid_argument("unknown filter_type");
     }
@@ -105,6 +105,9 @@ public:
     //! Also adds any outputs which match the filter to the filter (to match their spending txes)
     bool IsRelevantAndUpdate(const CTransaction& tx);
 
+    //! Whether IsRelevantAndUpdate may add to the filter
+    bool IsUpdating() const { return (nFlags & BLOOM_UPDATE_MASK) != BLOOM_UPDATE_NONE; }
+
     //! Checks for empty and full filters to avoid wasting cpu
     void UpdateEmptyFull();
 };
@@ -11,7 +11,11 @@
 #include <support/allocators/mt_pooled_secure.h>
 #endif
 
+#include <saltedhasher.h>
+#include <unordered_lru_cache.h>
+
 #include <assert.h>
+#include <mutex>
 #include <string.h>
 
 static std::unique_ptr<bls::CoreMPL> pSchemeLegacy(new bls::LegacySchemeMPL);
@@ -259,17 +263,46 @@ void CBLSSignature::SubInsecure(const CBLSSignature& o)
     cachedHash.SetNull();
 }
 
+// Successful single signature verifications. The same signature is often verified more than once, e.g. recovered
+// sigs received from multiple peers or sig shares re-verified after a failed batch verification. Each verification
+// costs a hash-to-curve and two pairings, so remembering the result is much cheaper than repeating it
+static std::mutex verifiedSigsCacheMutex;
+static unordered_lru_cache<uint256, bool, StaticSaltedHasher, 20000> verifiedSigsCache;
+
+static uint256 MakeVerifiedSigKey(const CBLSSignature& sig, const CBLSPublicKey& pubKey, const uint256& hash, bool fLegacy)
+{
+    CHashWriter hw(SER_GETHASH, 0);
+    hw << sig.GetHash() << pubKey.GetHash() << hash << fLegacy;
+    return hw.GetHash();
+}
+
 bool CBLSSignature::VerifyInsecure(const CBLSPublicKey& pubKey, const uint256& hash) const
 {
     if (!IsValid() || !pubKey.IsValid()) {
         return false;
     }
 
+    uint256 cacheKey = MakeVerifiedSigKey(*this, pubKey, hash, fLegacy);
+    {
+        std::unique_lock<std::mutex> l(verifiedSigsCacheMutex);
+        bool fCached;
+        if (verifiedSigsCache.get(cacheKey, fCached)) {
+            return true;
+        }
+    }
+
+    bool fVerified;
     try {
-        return Scheme(fLegacy)->Verify(pubKey.impl, bls::Bytes(hash.begin(), hash.size()), impl);
+        fVerified = Scheme(fLegacy)->Verify(pubKey.impl, bls::Bytes(hash.begin(), hash.size()), impl);
     } catch (...) {
         return false;
     }
+    if (fVerified) {
+        // only valid results are cached, so that invalid signatures can't evict useful entries
+        std::unique_lock<std::mutex> l(verifiedSigsCacheMutex);
+        verifiedSigsCache.insert(cacheKey, true);
+    }
+    return fVerified;
 }
 
 bool CBLSSignature::VerifyInsecureAggregated(const std::vector<CBLSPublicKey>& pubKeys, const std::vector<uint256>& hashes) const
@@ -394,3 +427,47 @@ bool BLSInit()
 #endif
     return true;
 }
+
+bool BLSSanityCheck()
+{
+    // Exercises the field and curve arithmetic of the BLS backend, which might be built with platform specific
+    // assembly (see BLS_ASM in depends). Uses fixed keys so that the result doesn't depend on the RNG
+    CBLSSecretKey sk1, sk2;
+    if (!sk1.SetHexStr("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f") ||
+        !sk2.SetHexStr("1f1e1d1c1b1a191817161514131211100f0e0d0c0b0a09080706050403020100")) {
+        return false;
+    }
+    uint256 msgHash1 = uint256S("0000000000000000000000000000000000000000000000000000000000000001");
+    uint256 msgHash2 = uint256S("0000000000000000000000000000000000000000000000000000000000000002");
+
+    CBLSSignature sig1 = sk1.Sign(msgHash1);
+    CBLSSignature sig2 = sk2.Sign(msgHash2);
+    if (!sig1.VerifyInsecure(sk1.GetPublicKey(), msgHash1) || sig1.VerifyInsecure(sk1.GetPublicKey(), msgHash2)) {
+        return false;
+    }
+
+    CBLSSignature aggSig = sig1;
+    aggSig.AggregateInsecure(sig2);
+    if (!aggSig.VerifyInsecureAggregated({sk1.GetPublicKey(), sk2.GetPublicKey()}, {msgHash1, msgHash2})) {
+        return false;
+    }
+
+    // 2-of-3 threshold signature, recovering from any two shares must result in the signature of the master key
+    std::vector<CBLSSecretKey> msk = {sk1, sk2};
+    std::vector<CBLSPublicKey> mpk = {sk1.GetPublicKey(), sk2.GetPublicKey()};
+    std::vector<CBLSId> ids = {CBLSId(uint256S("01")), CBLSId(uint256S("02")), CBLSId(uint256S("03"))};
+    std::vector<CBLSSignature> sigShares;
+    for (const auto& id : ids) {
+        CBLSSecretKey skShare;
+        CBLSPublicKey pkShare;
+        if (!skShare.SecretKeyShare(msk, id) || !pkShare.PublicKeyShare(mpk, id) || skShare.GetPublicKey() != pkShare) {
+            return false;
+        }
+        sigShares.emplace_back(skShare.Sign(msgHash1));
+    }
+    CBLSSignature recoveredSig;
+    if (!recoveredSig.Recover({sigShares[0], sigShares[2]}, {ids[0], ids[2]})) {
+        return false;
+    }
+    return recoveredSig == sig1;
+}
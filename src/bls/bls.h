@@ -20,8 +20,11 @@
 #include <bls-dash/threshold.hpp>
 #undef DOUBLE
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <mutex>
+#include <thread>
 #include <unistd.h>
 
 static const bool fLegacyDefault{true};
@@ -297,9 +300,30 @@ template<typename BLSObject>
 class CBLSLazyWrapper
 {
 private:
-    mutable std::mutex mutex;
+    // Millions of these objects are alive at the same time (sig shares, recovered sigs, MN states, ISLOCKs), so the
+    // buffer is kept inline and access is guarded by a spinlock on a single atomic_flag instead of a std::mutex.
+    // The critical sections are tiny, except for the first Get() which has to deserialize the object
+    class ScopedSpinLock
+    {
+    private:
+        std::atomic_flag& flag;
+
+    public:
+        explicit ScopedSpinLock(std::atomic_flag& _flag) : flag(_flag)
+        {
+            while (flag.test_and_set(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }
+        ~ScopedSpinLock()
+        {
+            flag.clear(std::memory_order_release);
+        }
+    };
+
+    mutable std::atomic_flag lock = ATOMIC_FLAG_INIT;
 
-    mutable std::vector<uint8_t> vecBytes;
+    mutable std::array<uint8_t, BLSObject::SerSize> vecBytes;
     mutable bool bufValid{false};
 
     mutable BLSObject obj;
@@ -308,10 +332,10 @@ private:
     mutable uint256 hash;
 
 public:
-    CBLSLazyWrapper() :
-        vecBytes(BLSObject::SerSize, 0)
+    CBLSLazyWrapper()
     {
         // the all-zero buf is considered a valid buf, but the resulting object will return false for IsValid
+        vecBytes.fill(0);
         bufValid = true;
     }
 
@@ -322,12 +346,15 @@ public:
 
     CBLSLazyWrapper& operator=(const CBLSLazyWrapper& r)
     {
-        std::unique_lock<std::mutex> l(r.mutex);
+        if (this == &r) {
+            return *this;
+        }
+        ScopedSpinLock l(r.lock);
         bufValid = r.bufValid;
         if (r.bufValid) {
             vecBytes = r.vecBytes;
         } else {
-            std::fill(vecBytes.begin(), vecBytes.end(), 0);
+            vecBytes.fill(0);
         }
         objInitialized = r.objInitialized;
         if (r.objInitialized) {
@@ -347,14 +374,12 @@ public:
     template<typename Stream>
     inline void Serialize(Stream& s) const
     {
-        std::unique_lock<std::mutex> l(mutex);
+        ScopedSpinLock l(lock);
         if (!objInitialized && !bufValid) {
             throw std::ios_base::failure("obj and buf not initialized");
         }
         if (!bufValid) {
-            vecBytes = obj.ToByteVector();
-            bufValid = true;
-            hash.SetNull();
+            UpdateBuf();
         }
         s.write((const char*)vecBytes.data(), vecBytes.size());
     }
@@ -362,7 +387,7 @@ public:
     template<typename Stream>
     inline void Unserialize(Stream& s)
     {
-        std::unique_lock<std::mutex> l(mutex);
+        ScopedSpinLock l(lock);
         s.read((char*)vecBytes.data(), BLSObject::SerSize);
         bufValid = true;
         objInitialized = false;
@@ -371,7 +396,7 @@ public:
 
     void Set(const BLSObject& _obj)
     {
-        std::unique_lock<std::mutex> l(mutex);
+        ScopedSpinLock l(lock);
         bufValid = false;
         objInitialized = true;
         obj = _obj;
@@ -379,14 +404,15 @@ public:
     }
     const BLSObject& Get() const
     {
-        std::unique_lock<std::mutex> l(mutex);
+        ScopedSpinLock l(lock);
         static BLSObject invalidObj;
         if (!bufValid && !objInitialized) {
             return invalidObj;
         }
         if (!objInitialized) {
-            obj.SetByteVector(vecBytes);
-            if (!obj.CheckMalleable(vecBytes)) {
+            std::vector<uint8_t> vecTmp(vecBytes.begin(), vecBytes.end());
+            obj.SetByteVector(vecTmp);
+            if (!obj.CheckMalleable(vecTmp)) {
                 bufValid = false;
                 objInitialized = false;
                 obj = invalidObj;
@@ -397,6 +423,20 @@ public:
         return obj;
     }
 
+    // Returns true for the null object (unset or all-zero buffer) without deserializing the object. Objects which are
+    // not null might still turn out to be invalid on Get()
+    bool IsNull() const
+    {
+        ScopedSpinLock l(lock);
+        if (objInitialized) {
+            return !obj.IsValid();
+        }
+        if (!bufValid) {
+            return true;
+        }
+        return std::all_of(vecBytes.begin(), vecBytes.end(), [](uint8_t c) { return c == 0; });
+    }
+
     bool operator==(const CBLSLazyWrapper& r) const
     {
         if (bufValid && r.bufValid) {
@@ -415,11 +455,9 @@ public:
 
     uint256 GetHash() const
     {
-        std::unique_lock<std::mutex> l(mutex);
+        ScopedSpinLock l(lock);
         if (!bufValid) {
-            vecBytes = obj.ToByteVector();
-            bufValid = true;
-            hash.SetNull();
+            UpdateBuf();
         }
         if (hash.IsNull()) {
             CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
@@ -428,6 +466,16 @@ public:
         }
         return hash;
     }
+
+private:
+    // must be called with the lock held
+    void UpdateBuf() const
+    {
+        auto v = obj.ToByteVector();
+        std::copy(v.begin(), v.end(), vecBytes.begin());
+        bufValid = true;
+        hash.SetNull();
+    }
 };
 typedef CBLSLazyWrapper<CBLSSignature> CBLSLazySignature;
 typedef CBLSLazyWrapper<CBLSPublicKey> CBLSLazyPublicKey;
@@ -447,5 +495,7 @@ typedef std::shared_ptr<BLSSecretKeyVector> BLSSecretKeyVectorPtr;
 typedef std::shared_ptr<BLSSignatureVector> BLSSignatureVectorPtr;
 
 bool BLSInit();
+// Returns false if the BLS backend produces incorrect results on this platform
+bool BLSSanityCheck();
 
 #endif // DASH_CRYPTO_BLS_H
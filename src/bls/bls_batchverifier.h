@@ -6,8 +6,11 @@
 #define DASH_CRYPTO_BLS_BATCHVERIFIER_H
 
 #include <bls/bls.h>
+#include <bls/bls_worker.h>
 
+#include <future>
 #include <map>
+#include <memory>
 #include <vector>
 
 template<typename SourceId, typename MessageId>
@@ -24,10 +27,13 @@ private:
     typedef std::map<MessageId, Message> MessageMap;
     typedef typename MessageMap::iterator MessageMapIterator;
     typedef std::map<SourceId, std::vector<MessageMapIterator>> MessagesBySourceMap;
+    typedef typename MessagesBySourceMap::const_iterator MessagesBySourceMapIterator;
 
     bool secureVerification;
     bool perMessageFallback;
     size_t subBatchSize;
+    // if set, the halves of a failed batch are verified in parallel on it. Must not be used from worker threads
+    CBLSWorker* worker;
 
     MessageMap messages;
     MessagesBySourceMap messagesBySource;
@@ -37,10 +43,11 @@ public:
     std::set<MessageId> badMessages;
 
 public:
-    CBLSBatchVerifier(bool _secureVerification, bool _perMessageFallback, size_t _subBatchSize = 0) :
+    CBLSBatchVerifier(bool _secureVerification, bool _perMessageFallback, size_t _subBatchSize = 0, CBLSWorker* _worker = nullptr) :
             secureVerification(_secureVerification),
             perMessageFallback(_perMessageFallback),
-            subBatchSize(_subBatchSize)
+            subBatchSize(_subBatchSize),
+            worker(_worker)
     {
     }
 
@@ -81,47 +88,102 @@ public:
             return;
         }
 
-        // revert to per-source verification
-        for (const auto& p : messagesBySource) {
-            bool batchValid = false;
+        // Isolate the bad sources by recursively bisecting the set of sources. With k bad sources, this needs about
+        // O(k log n) batch verifications instead of one verification per source
+        std::vector<MessagesBySourceMapIterator> sources;
+        sources.reserve(messagesBySource.size());
+        for (auto it = messagesBySource.begin(); it != messagesBySource.end(); ++it) {
+            sources.emplace_back(it);
+        }
+        BisectSources(sources, 0, sources.size());
+    }
 
-            // no need to verify it again if there was just one source
-            if (messagesBySource.size() != 1) {
-                byMessageHash.clear();
-                for (auto it = p.second.begin(); it != p.second.end(); ++it) {
-                    byMessageHash[(*it)->second.msgHash].emplace_back(*it);
-                }
-                batchValid = VerifyBatch(byMessageHash);
+private:
+    // All Verify methods take ownership of the passed byMessageHash map and thus might modify the map. This is to avoid
+    // unnecessary copies
+
+    bool VerifySources(const std::vector<MessagesBySourceMapIterator>& sources, size_t start, size_t count)
+    {
+        std::map<uint256, std::vector<MessageMapIterator>> byMessageHash;
+        for (size_t i = start; i < start + count; i++) {
+            for (const auto& msgIt : sources[i]->second) {
+                byMessageHash[msgIt->second.msgHash].emplace_back(msgIt);
             }
-            if (!batchValid) {
-                badSources.emplace(p.first);
-
-                if (perMessageFallback) {
-                    // revert to per-message verification
-                    if (p.second.size() == 1) {
-                        // no need to re-verify a single message
-                        badMessages.emplace(p.second[0]->second.msgId);
-                    } else {
-                        for (const auto& msgIt : p.second) {
-                            if (badMessages.count(msgIt->first)) {
-                                // same message might be invalid from different source, so no need to re-verify it
-                                continue;
-                            }
-
-                            const auto& msg = msgIt->second;
-                            if (!msg.sig.VerifyInsecure(msg.pubKey, msg.msgHash)) {
-                                badMessages.emplace(msg.msgId);
-                            }
-                        }
-                    }
+        }
+        return VerifyBatch(byMessageHash);
+    }
+
+    // Must only be called for a range of sources which failed verification as a whole
+    void BisectSources(const std::vector<MessagesBySourceMapIterator>& sources, size_t start, size_t count)
+    {
+        if (count == 1) {
+            HandleBadSource(*sources[start]);
+            return;
+        }
+
+        size_t leftCount = count / 2;
+        size_t rightStart = start + leftCount;
+        size_t rightCount = count - leftCount;
+
+        bool leftValid;
+        bool rightValid;
+        if (worker != nullptr) {
+            auto leftPromise = std::make_shared<std::promise<bool>>();
+            auto leftFuture = leftPromise->get_future();
+            worker->AsyncRun([this, &sources, start, leftCount, leftPromise]() {
+                leftPromise->set_value(VerifySources(sources, start, leftCount));
+            });
+            rightValid = VerifySources(sources, rightStart, rightCount);
+            leftValid = leftFuture.get();
+        } else {
+            leftValid = VerifySources(sources, start, leftCount);
+            rightValid = VerifySources(sources, rightStart, rightCount);
+        }
+
+        if (leftValid && rightValid) {
+            // Both halves are valid while the whole range is not, which means that invalid signatures of different
+            // sources cancelled each other out in the aggregated halves. Don't trust aggregation for this range
+            for (size_t i = start; i < start + count; i++) {
+                if (!VerifySources(sources, i, 1)) {
+                    HandleBadSource(*sources[i]);
                 }
             }
+            return;
+        }
+        if (!leftValid) {
+            BisectSources(sources, start, leftCount);
+        }
+        if (!rightValid) {
+            BisectSources(sources, rightStart, rightCount);
         }
     }
 
-private:
-    // All Verify methods take ownership of the passed byMessageHash map and thus might modify the map. This is to avoid
-    // unnecessary copies
+    void HandleBadSource(const std::pair<const SourceId, std::vector<MessageMapIterator>>& p)
+    {
+        badSources.emplace(p.first);
+
+        if (!perMessageFallback) {
+            return;
+        }
+
+        // revert to per-message verification
+        if (p.second.size() == 1) {
+            // no need to re-verify a single message
+            badMessages.emplace(p.second[0]->second.msgId);
+            return;
+        }
+        for (const auto& msgIt : p.second) {
+            if (badMessages.count(msgIt->first)) {
+                // same message might be invalid from different source, so no need to re-verify it
+                continue;
+            }
+
+            const auto& msg = msgIt->second;
+            if (!msg.sig.VerifyInsecure(msg.pubKey, msg.msgHash)) {
+                badMessages.emplace(msg.msgId);
+            }
+        }
+    }
 
     bool VerifyBatch(std::map<uint256, std::vector<MessageMapIterator>>& byMessageHash)
     {
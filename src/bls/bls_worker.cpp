@@ -118,6 +118,73 @@ bool CBLSWorker::GenerateContributions(int quorumThreshold, const BLSIdVector& i
     return success;
 }
 
+bool CBLSWorker::EncryptContributions(const std::vector<CBLSPublicKey>& recipients, const BLSSecretKeyVector& skShares, int nVersion,
+                                      CBLSIESMultiRecipientObjects<CBLSSecretKey>& encryptedRet)
+{
+    if (recipients.size() != skShares.size()) {
+        return false;
+    }
+
+    // InitEncrypt resizes all blobs up front, so each batch only writes to its own entries
+    encryptedRet.InitEncrypt(recipients.size());
+
+    std::list<std::future<bool> > futures;
+    size_t batchSize = 8;
+
+    for (size_t i = 0; i < recipients.size(); i += batchSize) {
+        size_t start = i;
+        size_t count = std::min(batchSize, recipients.size() - start);
+        auto f = [&, start, count](int threadId) {
+            for (size_t j = start; j < start + count; j++) {
+                if (!encryptedRet.Encrypt(j, recipients[j], skShares[j], nVersion)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        futures.emplace_back(workerPool.push(f));
+    }
+    bool success = true;
+    for (auto& f : futures) {
+        if (!f.get()) {
+            success = false;
+        }
+    }
+    return success;
+}
+
+bool CBLSWorker::DecryptContributions(const std::vector<CBLSIESEncryptedObject<CBLSSecretKey>>& encrypted, size_t idx, const CBLSSecretKey& sk, int nVersion,
+                                      BLSSecretKeyVector& skSharesRet)
+{
+    // each batch only writes to its own entries
+    skSharesRet.clear();
+    skSharesRet.resize(encrypted.size());
+
+    std::list<std::future<bool> > futures;
+    size_t batchSize = 8;
+
+    for (size_t i = 0; i < encrypted.size(); i += batchSize) {
+        size_t start = i;
+        size_t count = std::min(batchSize, encrypted.size() - start);
+        auto f = [&, start, count](int threadId) {
+            for (size_t j = start; j < start + count; j++) {
+                if (!encrypted[j].Decrypt(idx, sk, skSharesRet[j], nVersion)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        futures.emplace_back(workerPool.push(f));
+    }
+    bool success = true;
+    for (auto& f : futures) {
+        if (!f.get()) {
+            success = false;
+        }
+    }
+    return success;
+}
+
 // aggregates a single vector of BLS objects in parallel
 // the input vector is split into batches and each batch is aggregated in parallel
 // when enough batches are finished to form a new batch, the new batch is queued for further parallel aggregation
@@ -751,6 +818,44 @@ std::vector<bool> CBLSWorker::VerifyContributionShares(const CBLSId& forId, cons
     return AsyncVerifyContributionShares(forId, vvecs, skShares, parallel, aggregated).get();
 }
 
+void CBLSWorker::ScheduleVerifyContributionShares(int64_t nDeadline, const CBLSId& forId, std::vector<BLSVerificationVectorPtr> vvecs, BLSSecretKeyVector skShares,
+                                                  ContributionVerifyDoneCallback doneCallback)
+{
+    auto job = std::make_shared<ContributionVerifyJob>();
+    job->nDeadline = nDeadline;
+    job->forId = forId;
+    job->vvecs = std::move(vvecs);
+    job->skShares = std::move(skShares);
+    job->doneCallback = std::move(doneCallback);
+
+    std::unique_lock<std::mutex> l(contributionVerifyMutex);
+    job->nSequence = contributionVerifySequence++;
+    contributionVerifyQueue.emplace(std::move(job));
+    PushContributionVerifyJobs();
+}
+
+// contributionVerifyMutex must be held while calling
+void CBLSWorker::PushContributionVerifyJobs()
+{
+    while (!contributionVerifyQueue.empty() && contributionVerifyJobsInProgress < workerPool.size()) {
+        auto job = contributionVerifyQueue.top();
+        contributionVerifyQueue.pop();
+        contributionVerifyJobsInProgress++;
+
+        // the job itself is not parallelized, but the verification of batches that failed aggregated verification still
+        // ends up on the pool. This is why we don't block the worker thread until the job is done
+        auto f = [this, job](int threadId) {
+            AsyncVerifyContributionShares(job->forId, job->vvecs, job->skShares, false, true, [this, job](const std::vector<bool>& result) {
+                job->doneCallback(result);
+                std::unique_lock<std::mutex> l(contributionVerifyMutex);
+                contributionVerifyJobsInProgress--;
+                PushContributionVerifyJobs();
+            });
+        };
+        workerPool.push(f);
+    }
+}
+
 std::future<bool> CBLSWorker::AsyncVerifyContributionShare(const CBLSId& forId,
                                                            const BLSVerificationVectorPtr& vvec,
                                                            const CBLSSecretKey& skContribution)
@@ -832,7 +937,7 @@ bool CBLSWorker::VerifySignatureVector(const BLSSignatureVector& sigs, size_t st
 
 void CBLSWorker::AsyncSign(const CBLSSecretKey& secKey, const uint256& msgHash, CBLSWorker::SignDoneCallback doneCallback)
 {
-    workerPool.push([secKey, msgHash, doneCallback](int threadId) {
+    workerPool.push_high([secKey, msgHash, doneCallback](int threadId) {
         doneCallback(secKey.Sign(msgHash));
     });
 }
@@ -844,6 +949,29 @@ std::future<CBLSSignature> CBLSWorker::AsyncSign(const CBLSSecretKey& secKey, co
     return std::move(p.second);
 }
 
+void CBLSWorker::AsyncRun(std::function<void()> func)
+{
+    workerPool.push([func](int threadId) {
+        func();
+    });
+}
+
+void CBLSWorker::AsyncRecoverSig(const BLSSignatureVector& sigShares, const BLSIdVector& ids, CBLSWorker::SignDoneCallback doneCallback)
+{
+    workerPool.push_high([sigShares, ids, doneCallback](int threadId) {
+        CBLSSignature recoveredSig;
+        recoveredSig.Recover(sigShares, ids);
+        doneCallback(recoveredSig);
+    });
+}
+
+std::future<CBLSSignature> CBLSWorker::AsyncRecoverSig(const BLSSignatureVector& sigShares, const BLSIdVector& ids)
+{
+    auto p = BuildFutureDoneCallback<CBLSSignature>();
+    AsyncRecoverSig(sigShares, ids, std::move(p.first));
+    return std::move(p.second);
+}
+
 void CBLSWorker::AsyncVerifySig(const CBLSSignature& sig, const CBLSPublicKey& pubKey, const uint256& msgHash,
                                 CBLSWorker::SigVerifyDoneCallback doneCallback, CancelCond cancelCond)
 {
@@ -956,5 +1084,6 @@ void CBLSWorker::PushSigVerifyBatch()
     sigVerifyQueue.reserve(SIG_VERIFY_BATCH_SIZE);
 
     sigVerifyBatchesInProgress++;
-    workerPool.push(f, batch);
+    // signing sessions, InstantSend and ChainLocks wait for these, so they must not queue up behind DKG work
+    workerPool.push_high(f, batch);
 }
@@ -6,11 +6,15 @@
 #define DASH_CRYPTO_BLS_WORKER_H
 
 #include <bls/bls.h>
+#include <bls/bls_ies.h>
 
 #include <ctpl.h>
+#include <memusage.h>
 
 #include <future>
+#include <limits>
 #include <mutex>
+#include <queue>
 
 #include <boost/lockfree/queue.hpp>
 
@@ -24,6 +28,7 @@ public:
     typedef std::function<void(const CBLSSignature&)> SignDoneCallback;
     typedef std::function<void(bool)> SigVerifyDoneCallback;
     typedef std::function<bool()> CancelCond;
+    typedef std::function<void(const std::vector<bool>&)> ContributionVerifyDoneCallback;
 
 private:
     ctpl::thread_pool workerPool;
@@ -49,6 +54,29 @@ private:
     int sigVerifyBatchesInProgress{0};
     std::vector<SigVerifyJob> sigVerifyQueue;
 
+    struct ContributionVerifyJob {
+        int64_t nDeadline;
+        uint64_t nSequence;
+        CBLSId forId;
+        std::vector<BLSVerificationVectorPtr> vvecs;
+        BLSSecretKeyVector skShares;
+        ContributionVerifyDoneCallback doneCallback;
+    };
+    typedef std::shared_ptr<ContributionVerifyJob> ContributionVerifyJobPtr;
+    struct ContributionVerifyJobCompare {
+        // std::priority_queue pops the largest element, so the earliest deadline must compare as the largest one
+        bool operator()(const ContributionVerifyJobPtr& a, const ContributionVerifyJobPtr& b) const
+        {
+            if (a->nDeadline != b->nDeadline) return a->nDeadline > b->nDeadline;
+            return a->nSequence > b->nSequence;
+        }
+    };
+
+    std::mutex contributionVerifyMutex;
+    int contributionVerifyJobsInProgress{0};
+    uint64_t contributionVerifySequence{0};
+    std::priority_queue<ContributionVerifyJobPtr, std::vector<ContributionVerifyJobPtr>, ContributionVerifyJobCompare> contributionVerifyQueue;
+
 public:
     CBLSWorker();
     ~CBLSWorker();
@@ -57,6 +85,13 @@ public:
     void Stop();
 
     bool GenerateContributions(int threshold, const BLSIdVector& ids, BLSVerificationVectorPtr& vvecRet, BLSSecretKeyVector& skSharesRet);
+    // Encrypts skShares[i] for recipients[i]. The per-recipient DH key exchanges and encryptions are done in parallel
+    bool EncryptContributions(const std::vector<CBLSPublicKey>& recipients, const BLSSecretKeyVector& skShares, int nVersion,
+                              CBLSIESMultiRecipientObjects<CBLSSecretKey>& encryptedRet);
+    // Decrypts all encrypted contributions (encrypted for recipient index idx) with sk in parallel. Fails if any of them
+    // fails to decrypt
+    bool DecryptContributions(const std::vector<CBLSIESEncryptedObject<CBLSSecretKey>>& encrypted, size_t idx, const CBLSSecretKey& sk, int nVersion,
+                              BLSSecretKeyVector& skSharesRet);
 
     // The following functions are all used to aggregate verification (public key) vectors
     // Inputs are in the following form:
@@ -121,6 +156,13 @@ public:
     std::vector<bool> VerifyContributionShares(const CBLSId& forId, const std::vector<BLSVerificationVectorPtr>& vvecs, const BLSSecretKeyVector& skShares,
                                                bool parallel = true, bool aggregated = true);
 
+    // Queues a contribution verification job. Jobs from all DKG sessions share the worker pool and are started as soon
+    // as a worker becomes free, with the job of the earliest deadline (e.g. the height at which the DKG phase ends) first.
+    // At most one job per worker thread is in progress, so that a session which is close to its deadline does not have
+    // to wait behind a large backlog of another session. doneCallback is called from one of the worker threads
+    void ScheduleVerifyContributionShares(int64_t nDeadline, const CBLSId& forId, std::vector<BLSVerificationVectorPtr> vvecs, BLSSecretKeyVector skShares,
+                                          ContributionVerifyDoneCallback doneCallback);
+
     std::future<bool> AsyncVerifyContributionShare(const CBLSId& forId, const BLSVerificationVectorPtr& vvec, const CBLSSecretKey& skContribution);
 
     // Non paralellized verification of a single contribution
@@ -132,15 +174,24 @@ public:
     bool VerifySecretKeyVector(const BLSSecretKeyVector& secKeys, size_t start = 0, size_t count = 0);
     bool VerifySignatureVector(const BLSSignatureVector& sigs, size_t start = 0, size_t count = 0);
 
-    // Internally batched signature signing and verification
+    // Internally batched signature signing and verification. These run ahead of all queued DKG related jobs
     void AsyncSign(const CBLSSecretKey& secKey, const uint256& msgHash, SignDoneCallback doneCallback);
     std::future<CBLSSignature> AsyncSign(const CBLSSecretKey& secKey, const uint256& msgHash);
     void AsyncVerifySig(const CBLSSignature& sig, const CBLSPublicKey& pubKey, const uint256& msgHash, SigVerifyDoneCallback doneCallback, CancelCond cancelCond = [] { return false; });
     std::future<bool> AsyncVerifySig(const CBLSSignature& sig, const CBLSPublicKey& pubKey, const uint256& msgHash, CancelCond cancelCond = [] { return false; });
     bool IsAsyncVerifyInProgress();
 
+    // Runs func on the worker pool. Meant for compute intensive work of callers which is not covered by the functions above
+    void AsyncRun(std::function<void()> func);
+
+    // Recovers the threshold signature from the given shares on the worker pool. The callback receives an invalid
+    // signature if recovery failed
+    void AsyncRecoverSig(const BLSSignatureVector& sigShares, const BLSIdVector& ids, SignDoneCallback doneCallback);
+    std::future<CBLSSignature> AsyncRecoverSig(const BLSSignatureVector& sigShares, const BLSIdVector& ids);
+
 private:
     void PushSigVerifyBatch();
+    void PushContributionVerifyJobs();
 };
 
 // Builds and caches different things from CBLSWorker
@@ -150,16 +201,30 @@ private:
 class CBLSWorkerCache
 {
 private:
+    template <typename T>
+    struct CacheEntry {
+        std::shared_future<T> f;
+        int64_t nLastAccess;
+        size_t nUsage;
+    };
+    template <typename T>
+    using CacheMap = std::map<uint256, CacheEntry<T> >;
+
     CBLSWorker& worker;
 
     std::mutex cacheCs;
-    std::map<uint256, std::shared_future<BLSVerificationVectorPtr> > vvecCache;
-    std::map<uint256, std::shared_future<CBLSSecretKey> > secretKeyShareCache;
-    std::map<uint256, std::shared_future<CBLSPublicKey> > publicKeyShareCache;
+    CacheMap<BLSVerificationVectorPtr> vvecCache;
+    CacheMap<CBLSSecretKey> secretKeyShareCache;
+    CacheMap<CBLSPublicKey> publicKeyShareCache;
+
+    // Estimated memory usage of all entries. When it exceeds nMaxUsage, the least recently used entries are evicted
+    size_t nMaxUsage;
+    size_t nUsage{0};
+    int64_t nAccessCounter{0};
 
 public:
-    explicit CBLSWorkerCache(CBLSWorker& _worker) :
-        worker(_worker) {}
+    explicit CBLSWorkerCache(CBLSWorker& _worker, size_t _nMaxUsage = std::numeric_limits<size_t>::max()) :
+        worker(_worker), nMaxUsage(_nMaxUsage) {}
 
     BLSVerificationVectorPtr BuildQuorumVerificationVector(const uint256& cacheKey, const std::vector<BLSVerificationVectorPtr>& vvecs)
     {
@@ -180,26 +245,105 @@ public:
         });
     }
 
+    size_t DynamicMemoryUsage()
+    {
+        std::unique_lock<std::mutex> l(cacheCs);
+        return nUsage;
+    }
+
 private:
+    template <typename T>
+    static size_t EntryUsage(const T& v)
+    {
+        return memusage::MallocUsage(sizeof(memusage::stl_tree_node<std::pair<const uint256, CacheEntry<T> > >));
+    }
+    static size_t EntryUsage(const BLSVerificationVectorPtr& v)
+    {
+        size_t nEntryUsage = memusage::MallocUsage(sizeof(memusage::stl_tree_node<std::pair<const uint256, CacheEntry<BLSVerificationVectorPtr> > >));
+        if (v != nullptr) {
+            nEntryUsage += memusage::DynamicUsage(v) + memusage::DynamicUsage(*v);
+        }
+        return nEntryUsage;
+    }
+
     template <typename T, typename Builder>
-    T GetOrBuild(const uint256& cacheKey, std::map<uint256, std::shared_future<T> >& cache, Builder&& builder)
+    T GetOrBuild(const uint256& cacheKey, CacheMap<T>& cache, Builder&& builder)
     {
         cacheCs.lock();
         auto it = cache.find(cacheKey);
         if (it != cache.end()) {
-            auto f = it->second;
+            it->second.nLastAccess = nAccessCounter++;
+            auto f = it->second.f;
             cacheCs.unlock();
             return f.get();
         }
 
         std::promise<T> p;
-        cache.emplace(cacheKey, p.get_future());
+        cache.emplace(cacheKey, CacheEntry<T>{p.get_future(), nAccessCounter++, 0});
         cacheCs.unlock();
 
         T v = builder();
         p.set_value(v);
+
+        std::unique_lock<std::mutex> l(cacheCs);
+        it = cache.find(cacheKey);
+        // the entry might have been evicted in the meantime
+        if (it != cache.end() && it->second.nUsage == 0) {
+            it->second.nUsage = EntryUsage(v);
+            nUsage += it->second.nUsage;
+            EvictIfNeeded();
+        }
         return v;
     }
+
+    // Entries which are still being built are accounted with 0 bytes and never evicted, as waiters need them
+    template <typename T>
+    static typename CacheMap<T>::iterator FindLeastRecentlyUsed(CacheMap<T>& cache)
+    {
+        auto oldest = cache.end();
+        for (auto it = cache.begin(); it != cache.end(); ++it) {
+            if (it->second.nUsage != 0 && (oldest == cache.end() || it->second.nLastAccess < oldest->second.nLastAccess)) {
+                oldest = it;
+            }
+        }
+        return oldest;
+    }
+
+    template <typename T>
+    static int64_t GetLastAccess(const CacheMap<T>& cache, const typename CacheMap<T>::iterator& it)
+    {
+        return it != cache.end() ? it->second.nLastAccess : std::numeric_limits<int64_t>::max();
+    }
+
+    template <typename T>
+    void Evict(CacheMap<T>& cache, const typename CacheMap<T>::iterator& it)
+    {
+        nUsage -= it->second.nUsage;
+        cache.erase(it);
+    }
+
+    // cacheCs must be held while calling
+    void EvictIfNeeded()
+    {
+        while (nUsage > nMaxUsage) {
+            auto it1 = FindLeastRecentlyUsed(vvecCache);
+            auto it2 = FindLeastRecentlyUsed(secretKeyShareCache);
+            auto it3 = FindLeastRecentlyUsed(publicKeyShareCache);
+            int64_t nAccess1 = GetLastAccess(vvecCache, it1);
+            int64_t nAccess2 = GetLastAccess(secretKeyShareCache, it2);
+            int64_t nAccess3 = GetLastAccess(publicKeyShareCache, it3);
+            if (it1 == vvecCache.end() && it2 == secretKeyShareCache.end() && it3 == publicKeyShareCache.end()) {
+                return;
+            }
+            if (nAccess1 <= nAccess2 && nAccess1 <= nAccess3) {
+                Evict(vvecCache, it1);
+            } else if (nAccess2 <= nAccess3) {
+                Evict(secretKeyShareCache, it2);
+            } else {
+                Evict(publicKeyShareCache, it3);
+            }
+        }
+    }
 };
 
 #endif //DASH_CRYPTO_BLS_WORKER_H
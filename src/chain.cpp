@@ -9,6 +9,7 @@
  * CChain implementation
  */
 void CChain::SetTip(CBlockIndex *pindex) {
+    tipNoLock = pindex;
     if (pindex == nullptr) {
         vChain.clear();
         return;
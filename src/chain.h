@@ -12,6 +12,7 @@
 #include <tinyformat.h>
 #include <uint256.h>
 
+#include <atomic>
 #include <vector>
 
 /**
@@ -442,6 +443,8 @@ public:
 class CChain {
 private:
     std::vector<CBlockIndex*> vChain;
+    //! Published copy of the tip for TipNoLock
+    std::atomic<const CBlockIndex*> tipNoLock{nullptr};
 
 public:
     /** Returns the index entry for the genesis block of this chain, or nullptr if none. */
@@ -454,6 +457,17 @@ public:
         return vChain.size() > 0 ? vChain[vChain.size() - 1] : nullptr;
     }
 
+    /**
+     * Returns the tip of this chain like Tip(), but it can be called without holding the lock which
+     * protects the chain, e.g. by RPCs which would otherwise contend with validation for cs_main.
+     * Without that lock only the fields of the block index which don't change once it's connected
+     * may be accessed: the block hash, the header fields, nHeight, nTx, nChainWork, pprev and pskip,
+     * which means GetAncestor() and GetMedianTimePast() can be used too.
+     */
+    const CBlockIndex *TipNoLock() const {
+        return tipNoLock.load();
+    }
+
     /** Returns the index entry at a particular height in this chain, or nullptr if no such height exists. */
     CBlockIndex *operator[](int nHeight) const {
         if (nHeight < 0 || nHeight >= (int)vChain.size())
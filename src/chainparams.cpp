@@ -149,6 +149,11 @@ void CChainParams::UpdateLLMQDevnetParams(int size, int threshold)
     params.dkgBadVotesThreshold = threshold;
 }
 
+void CChainParams::UpdateAssumeutxoData(int nHeight, const AssumeutxoData& data)
+{
+    mapAssumeutxo[nHeight] = data;
+}
+
 static CBlock FindDevNetGenesisBlock(const CBlock &prevBlock, const CAmount& reward)
 {
     std::string devNetName = gArgs.GetDevNetName();
@@ -1104,3 +1109,8 @@ void UpdateLLMQDevnetParams(int size, int threshold)
 {
     globalChainParams->UpdateLLMQDevnetParams(size, threshold);
 }
+
+void UpdateAssumeutxoData(int nHeight, const AssumeutxoData& data)
+{
+    globalChainParams->UpdateAssumeutxoData(nHeight, data);
+}
@@ -25,6 +25,18 @@ struct CCheckpointData {
     MapCheckpoints mapCheckpoints;
 };
 
+/**
+ * Hashes of the state as of a block, which UTXO set snapshots of that block are verified against (see
+ * loadtxoutset). hashSerialized is the hash_serialized_2 of gettxoutsetinfo, hashEvoState the hash of the
+ * deterministic masternode list and the active quorum commitments, both reported by dumptxoutset.
+ */
+struct AssumeutxoData {
+    uint256 hashSerialized;
+    uint256 hashEvoState;
+};
+
+typedef std::map<int, AssumeutxoData> MapAssumeutxo;
+
 /**
  * Holds various statistics on transactions within a chain. Used to estimate
  * verification progress during chain sync.
@@ -87,6 +99,8 @@ public:
     const std::vector<SeedSpec6>& FixedSeeds() const { return vFixedSeeds; }
     const CCheckpointData& Checkpoints() const { return checkpointData; }
     const ChainTxData& TxData() const { return chainTxData; }
+    /** Snapshot hashes by block height */
+    const MapAssumeutxo& Assumeutxo() const { return mapAssumeutxo; }
     void UpdateVersionBitsParameters(Consensus::DeploymentPos d, int64_t nStartTime, int64_t nTimeout, int64_t nWindowSize, int64_t nThresholdStart, int64_t nThresholdMin, int64_t nFalloffCoeff);
     void UpdateDIP3Parameters(int nActivationHeight, int nEnforcementHeight);
     void UpdateDIP8Parameters(int nActivationHeight);
@@ -96,6 +110,7 @@ public:
     void UpdateLLMQInstantSend(Consensus::LLMQType llmqType);
     void UpdateLLMQTestParams(int size, int threshold);
     void UpdateLLMQDevnetParams(int size, int threshold);
+    void UpdateAssumeutxoData(int nHeight, const AssumeutxoData& data);
     int PoolMinParticipants() const { return nPoolMinParticipants; }
     int PoolMaxParticipants() const { return nPoolMaxParticipants; }
     int FulfilledRequestExpireTime() const { return nFulfilledRequestExpireTime; }
@@ -125,6 +140,7 @@ protected:
     int nLLMQConnectionRetryTimeout;
     CCheckpointData checkpointData;
     ChainTxData chainTxData;
+    MapAssumeutxo mapAssumeutxo;
     int nPoolMinParticipants;
     int nPoolMaxParticipants;
     int nFulfilledRequestExpireTime;
@@ -197,4 +213,9 @@ void UpdateLLMQTestParams(int size, int threshold);
  */
 void UpdateLLMQDevnetParams(int size, int threshold);
 
+/**
+ * Allows adding snapshot hashes for testing UTXO set snapshots (regtest only)
+ */
+void UpdateAssumeutxoData(int nHeight, const AssumeutxoData& data);
+
 #endif // BITCOIN_CHAINPARAMS_H
@@ -8,6 +8,9 @@
 #include <sync.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
 #include <vector>
 
 #include <boost/thread/condition_variable.hpp>
@@ -25,12 +28,36 @@ class CCheckQueueControl;
   * onto the queue, where they are processed by N-1 worker threads. When
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
+  *
+  * Every worker owns a deque of pending checks, each with its own lock. Add
+  * spreads new checks over those deques, a worker pops batches from the back
+  * of its own deque and, once that runs dry, steals from the front of the
+  * others. The shared mutex is only taken to sleep and to wake up, so it is
+  * no longer contended by every batch on hosts with many script check threads.
   */
 template <typename T>
 class CCheckQueue
 {
 private:
-    //! Mutex to protect the inner state
+    //! Upper bound on the number of deques. Workers beyond it share one.
+    static const unsigned int MAX_WORKER_SLOTS = 64;
+
+    //! The pending checks of one worker, used as a LIFO by the owner and a FIFO by thieves
+    struct WorkerSlot {
+        boost::mutex mutex;
+        std::deque<T> queue;
+    };
+
+    //! Slot 0 belongs to the master, workers take the following ones in the order they start
+    std::array<WorkerSlot, MAX_WORKER_SLOTS> slots;
+
+    //! The number of worker threads (not including the master) that have started.
+    std::atomic<unsigned int> nWorkers;
+
+    //! Where Add starts spreading the next batch, so single checks don't all land in one deque
+    std::atomic<unsigned int> nNextSlot;
+
+    //! Mutex to protect sleeping and waking up
     boost::mutex mutex;
 
     //! Worker threads block on this when out of work
@@ -39,87 +66,132 @@ private:
     //! Master thread blocks on this when out of work
     boost::condition_variable condMaster;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue;
-
     //! The number of workers (including the master) that are idle.
-    int nIdle;
-
-    //! The total number of workers (including the master).
-    int nTotal;
+    std::atomic<int> nIdle;
 
     //! The temporary evaluation result.
-    bool fAllOk;
+    std::atomic<bool> fAllOk;
 
     /**
      * Number of verifications that haven't completed yet.
      * This includes elements that are no longer queued, but still in the
      * worker's own batches.
      */
-    unsigned int nTodo;
+    std::atomic<unsigned int> nTodo;
+
+    //! Number of verifications still sitting in one of the deques.
+    std::atomic<unsigned int> nQueued;
 
     //! The maximum number of elements to be processed in one batch
     unsigned int nBatchSize;
 
+    unsigned int SlotCount() const
+    {
+        return std::min(nWorkers.load() + 1, MAX_WORKER_SLOTS);
+    }
+
+    /**
+     * Move up to nMax checks out of a slot into vChecks, from the back (own
+     * slot) or the front (stealing). The caller holds the slot's lock.
+     */
+    void TakeLocked(WorkerSlot& slot, std::vector<T>& vChecks, unsigned int nMax, bool fSteal)
+    {
+        const unsigned int nNow = std::min(nMax, (unsigned int)slot.queue.size());
+        vChecks.resize(nNow);
+        for (unsigned int i = 0; i < nNow; i++) {
+            // Swap jobs out instead of copying to keep the slot locked as briefly as possible.
+            if (fSteal) {
+                vChecks[i].swap(slot.queue.front());
+                slot.queue.pop_front();
+            } else {
+                vChecks[i].swap(slot.queue.back());
+                slot.queue.pop_back();
+            }
+        }
+        nQueued -= nNow;
+    }
+
+    /**
+     * Fill vChecks with the next batch for the worker owning nSlot, stealing
+     * from the other slots when its own is empty. Returns false if no work
+     * was found anywhere.
+     *
+     * The batch size adapts: it doubles (up to nBatchSize) while a worker keeps
+     * finding work in its own deque, halves while other workers are idle so
+     * that work stays available for them to steal, and never takes more than
+     * half of a deque so that all workers finish approximately simultaneously.
+     */
+    bool Take(unsigned int nSlot, std::vector<T>& vChecks, unsigned int& nLimit)
+    {
+        if (nIdle.load(std::memory_order_relaxed) > 0) {
+            nLimit = std::max(1U, nLimit / 2);
+        }
+        {
+            WorkerSlot& own = slots[nSlot];
+            boost::unique_lock<boost::mutex> lock(own.mutex);
+            if (!own.queue.empty()) {
+                TakeLocked(own, vChecks, std::max(1U, std::min(nLimit, (unsigned int)own.queue.size() / 2)), false);
+                nLimit = std::min(nBatchSize, nLimit * 2);
+                return true;
+            }
+        }
+        const unsigned int nSlots = SlotCount();
+        for (unsigned int i = 1; i < nSlots && nQueued.load() > 0; i++) {
+            WorkerSlot& victim = slots[(nSlot + i) % nSlots];
+            boost::unique_lock<boost::mutex> lock(victim.mutex);
+            if (!victim.queue.empty()) {
+                TakeLocked(victim, vChecks, std::max(1U, std::min(nBatchSize, ((unsigned int)victim.queue.size() + 1) / 2)), true);
+                nLimit = 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
     /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster = false)
+    bool Loop(unsigned int nSlot, bool fMaster = false)
     {
-        boost::condition_variable& cond = fMaster ? condMaster : condWorker;
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
+        unsigned int nLimit = 1;
         do {
-            {
+            if (!Take(nSlot, vChecks, nLimit)) {
                 boost::unique_lock<boost::mutex> lock(mutex);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        // We processed the last element; inform the master it can exit and return the result
-                        condMaster.notify_one();
-                } else {
-                    // first iteration
-                    nTotal++;
+                if (nQueued.load() > 0) {
+                    // Work was added (or moved) while we were looking; look again.
+                    continue;
                 }
-                // logically, the do loop starts here
-                while (queue.empty()) {
-                    if (fMaster && nTodo == 0) {
-                        nTotal--;
-                        bool fRet = fAllOk;
-                        // reset the status for new work later
-                        if (fMaster)
-                            fAllOk = true;
-                        // return the current status
-                        return fRet;
+                if (fMaster) {
+                    if (nTodo.load() == 0) {
+                        // return the current status and reset it for new work later
+                        return fAllOk.exchange(true);
                     }
+                    // The remaining checks are in other workers' batches; wait for them.
                     nIdle++;
-                    cond.wait(lock); // wait
+                    condMaster.wait(lock);
+                    nIdle--;
+                } else {
+                    nIdle++;
+                    condWorker.wait(lock); // wait
                     nIdle--;
                 }
-                // Decide how many work units to process now.
-                // * Do not try to do everything at once, but aim for increasingly smaller batches so
-                //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
-                // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                vChecks.resize(nNow);
-                for (unsigned int i = 0; i < nNow; i++) {
-                    // We want the lock on the mutex to be as short as possible, so swap jobs from the global
-                    // queue to the local batch vector instead of copying.
-                    vChecks[i].swap(queue.back());
-                    queue.pop_back();
-                }
-                // Check whether we need to do work at all
-                fOk = fAllOk;
+                continue;
             }
+            // Check whether we need to do work at all
+            bool fOk = fAllOk.load();
             // execute work
             for (T& check : vChecks)
                 if (fOk)
                     fOk = check();
+            if (!fOk)
+                fAllOk.store(false);
+            const unsigned int nNow = vChecks.size();
             vChecks.clear();
+            if (nTodo.fetch_sub(nNow) == nNow && !fMaster) {
+                // We processed the last element; inform the master it can exit and return the result
+                boost::unique_lock<boost::mutex> lock(mutex);
+                condMaster.notify_one();
+            }
         } while (true);
     }
 
@@ -128,32 +200,45 @@ public:
     boost::mutex ControlMutex;
 
     //! Create a new check queue
-    explicit CCheckQueue(unsigned int nBatchSizeIn) : nIdle(0), nTotal(0), fAllOk(true), nTodo(0), nBatchSize(nBatchSizeIn) {}
+    explicit CCheckQueue(unsigned int nBatchSizeIn) : nWorkers(0), nNextSlot(0), nIdle(0), fAllOk(true), nTodo(0), nQueued(0), nBatchSize(std::max(1U, nBatchSizeIn)) {}
 
     //! Worker thread
     void Thread()
     {
-        Loop();
+        Loop(1 + nWorkers++ % (MAX_WORKER_SLOTS - 1));
     }
 
     //! Wait until execution finishes, and return whether all evaluations were successful.
     bool Wait()
     {
-        return Loop(true);
+        return Loop(0, true);
     }
 
     //! Add a batch of checks to the queue
     void Add(std::vector<T>& vChecks)
     {
-        boost::unique_lock<boost::mutex> lock(mutex);
-        for (T& check : vChecks) {
-            queue.push_back(T());
-            check.swap(queue.back());
-        }
+        if (vChecks.empty())
+            return;
+        // Spread the checks over the slots in contiguous chunks, starting at a
+        // rotating slot so that small batches are distributed as well.
+        const unsigned int nSlots = SlotCount();
+        const size_t nChunk = (vChecks.size() + nSlots - 1) / nSlots;
+        unsigned int nSlot = nNextSlot++ % nSlots;
         nTodo += vChecks.size();
+        for (size_t nPos = 0; nPos < vChecks.size(); nPos += nChunk, nSlot = (nSlot + 1) % nSlots) {
+            WorkerSlot& slot = slots[nSlot];
+            const size_t nEnd = std::min(vChecks.size(), nPos + nChunk);
+            boost::unique_lock<boost::mutex> lock(slot.mutex);
+            for (size_t i = nPos; i < nEnd; i++) {
+                slot.queue.push_back(T());
+                vChecks[i].swap(slot.queue.back());
+            }
+            nQueued += nEnd - nPos;
+        }
+        boost::unique_lock<boost::mutex> lock(mutex);
         if (vChecks.size() == 1)
             condWorker.notify_one();
-        else if (vChecks.size() > 1)
+        else
             condWorker.notify_all();
     }
 
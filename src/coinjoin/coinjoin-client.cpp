@@ -13,6 +13,7 @@
 #include <masternode/masternode-meta.h>
 #include <netmessagemaker.h>
 #include <script/sign.h>
+#include <statsd_client.h>
 #include <txmempool.h>
 #include <util.h>
 #include <utilmoneystr.h>
@@ -58,15 +59,13 @@ void CCoinJoinClientQueueManager::ProcessMessage(CNode* pfrom, const std::string
             if (!lockRecv) return;
 
             // process every dsq only once
-            for (const auto& q : vecCoinJoinQueue) {
-                if (q == dsq) {
-                    return;
-                }
-                if (q.fReady == dsq.fReady && q.masternodeOutpoint == dsq.masternodeOutpoint) {
+            const CCoinJoinQueue* q = GetQueue(dsq.masternodeOutpoint, dsq.nDenom, dsq.fReady);
+            if (q != nullptr) {
+                if (!(*q == dsq)) {
                     // no way the same mn can send another dsq with the same readiness this soon
                     LogPrint(BCLog::COINJOIN, "DSQUEUE -- Peer %s is sending WAY too many dsq messages for a masternode with collateral %s\n", pfrom->GetLogString(), dsq.masternodeOutpoint.ToStringShort());
-                    return;
                 }
+                return;
             }
         } // cs_vecqueue
 
@@ -87,7 +86,7 @@ void CCoinJoinClientQueueManager::ProcessMessage(CNode* pfrom, const std::string
         // if the queue is ready, submit if we can
         if (dsq.fReady) {
             for (auto& pair : coinJoinClientManagers) {
-                if (pair.second->TrySubmitDenominate(dmn->pdmnState->addr, connman)) {
+                if (pair.second->TrySubmitDenominate(dmn->pdmnState->addr, dsq.nDenom, connman)) {
                     LogPrint(BCLog::COINJOIN, "DSQUEUE -- CoinJoin queue (%s) is ready on masternode %s\n", dsq.ToString(), dmn->pdmnState->addr.ToString());
                     return;
                 }
@@ -114,8 +113,15 @@ void CCoinJoinClientQueueManager::ProcessMessage(CNode* pfrom, const std::string
 
             TRY_LOCK(cs_vecqueue, lockRecv);
             if (!lockRecv) return;
-            vecCoinJoinQueue.push_back(dsq);
+            // might have been added by another peer in the meantime
+            if (GetQueue(dsq.masternodeOutpoint, dsq.nDenom, dsq.fReady) != nullptr) return;
+            AddQueue(dsq);
             dsq.Relay(connman);
+
+            // a new queue might be one we can join
+            for (const auto& pair : coinJoinClientManagers) {
+                pair.second->WakeUp();
+            }
         }
 
     }
@@ -169,6 +175,11 @@ void CCoinJoinClientSession::ProcessMessage(CNode* pfrom, const std::string& str
         CCoinJoinStatusUpdate psssup;
         vRecv >> psssup;
 
+        // the masternode might run sessions for other denominations, ignore their updates
+        if (nSessionID != 0 && psssup.nSessionID != 0 && psssup.nSessionID != nSessionID) {
+            return;
+        }
+
         ProcessPoolStateUpdate(psssup);
 
     } else if (strCommand == NetMsgType::DSFINALTX) {
@@ -242,6 +253,7 @@ bool CCoinJoinClientManager::StartMixing() {
     if (IsMixing()) {
         return false;
     }
+    WakeUp();
     return fMixing = true;
 }
 
@@ -433,6 +445,8 @@ void CCoinJoinClientManager::CheckTimeout()
     for (auto& session : deqSessions) {
         if (session.CheckTimeout()) {
             strAutoDenomResult = _("Session timed out.");
+            // the session is idle again and can try another masternode
+            WakeUp();
         }
     }
 }
@@ -1208,12 +1222,13 @@ void CCoinJoinClientManager::ProcessPendingDsaRequest(CConnman& connman)
     }
 }
 
-bool CCoinJoinClientManager::TrySubmitDenominate(const CService& mnAddr, CConnman& connman)
+bool CCoinJoinClientManager::TrySubmitDenominate(const CService& mnAddr, int nDenom, CConnman& connman)
 {
     LOCK(cs_deqsessions);
     for (auto& session : deqSessions) {
         CDeterministicMNCPtr mnMixing;
-        if (session.GetMixingMasternodeInfo(mnMixing) && mnMixing->pdmnState->addr == mnAddr && session.GetState() == POOL_STATE_QUEUE) {
+        // masternodes run one session per denomination, only the matching one is ready
+        if (session.GetMixingMasternodeInfo(mnMixing) && mnMixing->pdmnState->addr == mnAddr && session.nSessionDenom == nDenom && session.GetState() == POOL_STATE_QUEUE) {
             session.SubmitDenominate(connman);
             return true;
         }
@@ -1226,7 +1241,7 @@ bool CCoinJoinClientManager::MarkAlreadyJoinedQueueAsTried(CCoinJoinQueue& dsq)
     LOCK(cs_deqsessions);
     for (const auto& session : deqSessions) {
         CDeterministicMNCPtr mnMixing;
-        if (session.GetMixingMasternodeInfo(mnMixing) && mnMixing->collateralOutpoint == dsq.masternodeOutpoint) {
+        if (session.GetMixingMasternodeInfo(mnMixing) && mnMixing->collateralOutpoint == dsq.masternodeOutpoint && session.nSessionDenom == dsq.nDenom) {
             dsq.fTried = true;
             return true;
         }
@@ -1450,6 +1465,9 @@ bool CCoinJoinClientSession::MakeCollateralAmounts(const CompactTallyItem& tally
         return false;
     }
 
+    // Plan both outputs first so that their amounts can be derived from the remainder after all fees
+    CTransactionBuilderPlan plan(txBuilder);
+
     int nCase{0}; // Just for debug logs
     if (txBuilder.CouldAddOutputs({CCoinJoin::GetMaxCollateralAmount(), CCoinJoin::GetCollateralAmount()})) {
         nCase = 1;
@@ -1457,12 +1475,12 @@ bool CCoinJoinClientSession::MakeCollateralAmounts(const CompactTallyItem& tally
         // Out1 == CCoinJoin::GetMaxCollateralAmount()
         // Out2 >= CCoinJoin::GetCollateralAmount()
 
-        txBuilder.AddOutput(CCoinJoin::GetMaxCollateralAmount());
+        plan.AddOutput(CCoinJoin::GetMaxCollateralAmount());
         // Note, here we first add a zero amount output to get the remainder after all fees and then assign it
-        CTransactionBuilderOutput* out = txBuilder.AddOutput();
-        CAmount nAmountLeft = txBuilder.GetAmountLeft();
+        plan.AddOutput();
+        CAmount nAmountLeft = plan.GetAmountLeft();
         // If remainder is denominated add one duff to the fee
-        out->UpdateAmount(CCoinJoin::IsDenominatedAmount(nAmountLeft) ? nAmountLeft - 1 : nAmountLeft);
+        plan.UpdateAmount(1, CCoinJoin::IsDenominatedAmount(nAmountLeft) ? nAmountLeft - 1 : nAmountLeft);
 
     } else if (txBuilder.CouldAddOutputs({CCoinJoin::GetCollateralAmount(), CCoinJoin::GetCollateralAmount()})) {
         nCase = 2;
@@ -1471,26 +1489,31 @@ bool CCoinJoinClientSession::MakeCollateralAmounts(const CompactTallyItem& tally
         // Out2 CCoinJoin::IsCollateralAmount()
 
         // First add two outputs to get the available value after all fees
-        CTransactionBuilderOutput* out1 = txBuilder.AddOutput();
-        CTransactionBuilderOutput* out2 = txBuilder.AddOutput();
+        plan.AddOutput();
+        plan.AddOutput();
 
-        // Create two equal outputs from the available value. This adds one duff to the fee if txBuilder.GetAmountLeft() is odd.
-        CAmount nAmountOutputs = txBuilder.GetAmountLeft() / 2;
+        // Create two equal outputs from the available value. This adds one duff to the fee if plan.GetAmountLeft() is odd.
+        CAmount nAmountOutputs = plan.GetAmountLeft() / 2;
 
         assert(CCoinJoin::IsCollateralAmount(nAmountOutputs));
 
-        out1->UpdateAmount(nAmountOutputs);
-        out2->UpdateAmount(nAmountOutputs);
+        plan.UpdateAmount(0, nAmountOutputs);
+        plan.UpdateAmount(1, nAmountOutputs);
 
     } else { // still at least possible to add one CCoinJoin::GetCollateralAmount() output
         nCase = 3;
         // <case3>, see TransactionRecord::decomposeTransaction
         // Out1 CCoinJoin::IsCollateralAmount()
         // Out2 Skipped
-        CTransactionBuilderOutput* out = txBuilder.AddOutput();
-        out->UpdateAmount(txBuilder.GetAmountLeft());
+        plan.AddOutput();
+        plan.UpdateAmount(0, plan.GetAmountLeft());
 
-        assert(CCoinJoin::IsCollateralAmount(out->GetAmount()));
+        assert(CCoinJoin::IsCollateralAmount(plan.GetAmounts()[0]));
+    }
+
+    if (!txBuilder.AddOutputs(plan.GetAmounts())) {
+        LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- Failed to add planned outputs, %s\n", __func__, plan.ToString());
+        return false;
     }
 
     LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- Done with case %d: %s\n", __func__, nCase, txBuilder.ToString());
@@ -1618,9 +1641,12 @@ bool CCoinJoinClientSession::CreateDenominated(CAmount nBalanceToDenominate, con
 
     LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- Start %s\n", __func__, txBuilder.ToString());
 
+    // Plan all outputs first, fee checks of planned outputs are cheap and no keys are reserved until we are done
+    CTransactionBuilderPlan plan(txBuilder);
+
     // ****** Add an output for mixing collaterals ************ /
 
-    if (fCreateMixingCollaterals && !txBuilder.AddOutput(CCoinJoin::GetMaxCollateralAmount())) {
+    if (fCreateMixingCollaterals && !plan.AddOutput(CCoinJoin::GetMaxCollateralAmount())) {
         LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- Failed to add collateral output\n", __func__);
         return false;
     }
@@ -1644,7 +1670,7 @@ bool CCoinJoinClientSession::CreateDenominated(CAmount nBalanceToDenominate, con
     // Now, in this system, so long as we don't reach COINJOIN_DENOM_OUTPUTS_THRESHOLD outputs the process repeats in
     // the same transaction, creating up to nCoinJoinDenomsHardCap per denomination in a single transaction.
 
-    while (txBuilder.CouldAddOutput(CCoinJoin::GetSmallestDenomination()) && txBuilder.CountOutputs() < COINJOIN_DENOM_OUTPUTS_THRESHOLD) {
+    while (plan.CouldAddOutput(CCoinJoin::GetSmallestDenomination()) && plan.CountOutputs() < COINJOIN_DENOM_OUTPUTS_THRESHOLD) {
         for (auto it = vecStandardDenoms.rbegin(); it != vecStandardDenoms.rend(); ++it) {
             CAmount nDenomValue = *it;
             auto currentDenomIt = mapDenomCount.find(nDenomValue);
@@ -1653,11 +1679,11 @@ bool CCoinJoinClientSession::CreateDenominated(CAmount nBalanceToDenominate, con
 
             const auto& strFunc = __func__;
             auto needMoreOutputs = [&]() {
-                if (txBuilder.CouldAddOutput(nDenomValue)) {
+                if (plan.CouldAddOutput(nDenomValue)) {
                     if (fAddFinal && nBalanceToDenominate > 0 && nBalanceToDenominate < nDenomValue) {
                         fAddFinal = false; // add final denom only once, only the smalest possible one
                         LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- 1 - FINAL - nDenomValue: %f, nBalanceToDenominate: %f, nOutputs: %d, %s\n",
-                                                     strFunc, (float) nDenomValue / COIN, (float) nBalanceToDenominate / COIN, nOutputs, txBuilder.ToString());
+                                                     strFunc, (float) nDenomValue / COIN, (float) nBalanceToDenominate / COIN, nOutputs, plan.ToString());
                         return true;
                     } else if (nBalanceToDenominate >= nDenomValue) {
                         return true;
@@ -1669,67 +1695,52 @@ bool CCoinJoinClientSession::CreateDenominated(CAmount nBalanceToDenominate, con
             // add each output up to 11 times or until it can't be added again or until we reach nCoinJoinDenomsGoal
             while (needMoreOutputs() && nOutputs <= 10 && currentDenomIt->second < CCoinJoinClientOptions::GetDenomsGoal()) {
                 // Add output and subtract denomination amount
-                if (txBuilder.AddOutput(nDenomValue)) {
+                if (plan.AddOutput(nDenomValue)) {
                     ++nOutputs;
                     ++currentDenomIt->second;
                     nBalanceToDenominate -= nDenomValue;
                     LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- 1 - nDenomValue: %f, nBalanceToDenominate: %f, nOutputs: %d, %s\n",
-                                                 __func__, (float) nDenomValue / COIN, (float) nBalanceToDenominate / COIN, nOutputs, txBuilder.ToString());
+                                                 __func__, (float) nDenomValue / COIN, (float) nBalanceToDenominate / COIN, nOutputs, plan.ToString());
                 } else {
                     LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- 1 - Error: AddOutput failed for nDenomValue: %f, nBalanceToDenominate: %f, nOutputs: %d, %s\n",
-                                                 __func__, (float) nDenomValue / COIN, (float) nBalanceToDenominate / COIN, nOutputs, txBuilder.ToString());
+                                                 __func__, (float) nDenomValue / COIN, (float) nBalanceToDenominate / COIN, nOutputs, plan.ToString());
                     return false;
                 }
 
             }
 
-            if (txBuilder.GetAmountLeft() == 0 || nBalanceToDenominate <= 0) break;
+            if (plan.GetAmountLeft() == 0 || nBalanceToDenominate <= 0) break;
         }
 
         bool finished = true;
         for (const auto it : mapDenomCount) {
             // Check if this specific denom could use another loop, check that there aren't nCoinJoinDenomsGoal of this
             // denom and that our nValueLeft/nBalanceToDenominate is enough to create one of these denoms, if so, loop again.
-            if (it.second < CCoinJoinClientOptions::GetDenomsGoal() && txBuilder.CouldAddOutput(it.first) && nBalanceToDenominate > 0) {
+            if (it.second < CCoinJoinClientOptions::GetDenomsGoal() && plan.CouldAddOutput(it.first) && nBalanceToDenominate > 0) {
                 finished = false;
                 LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- 1 - NOT finished - nDenomValue: %f, count: %d, nBalanceToDenominate: %f, %s\n",
-                                             __func__, (float) it.first / COIN, it.second, (float) nBalanceToDenominate / COIN, txBuilder.ToString());
+                                             __func__, (float) it.first / COIN, it.second, (float) nBalanceToDenominate / COIN, plan.ToString());
                 break;
             }
             LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- 1 - FINSHED - nDenomValue: %f, count: %d, nBalanceToDenominate: %f, %s\n",
-                                         __func__, (float) it.first / COIN, it.second, (float) nBalanceToDenominate / COIN, txBuilder.ToString());
+                                         __func__, (float) it.first / COIN, it.second, (float) nBalanceToDenominate / COIN, plan.ToString());
         }
 
         if (finished) break;
     }
 
     // Now that nCoinJoinDenomsGoal worth of each denom have been created or the max number of denoms given the value of the input, do something with the remainder.
-    if (txBuilder.CouldAddOutput(CCoinJoin::GetSmallestDenomination()) && nBalanceToDenominate >= CCoinJoin::GetSmallestDenomination() && txBuilder.CountOutputs() < COINJOIN_DENOM_OUTPUTS_THRESHOLD) {
+    if (plan.CouldAddOutput(CCoinJoin::GetSmallestDenomination()) && nBalanceToDenominate >= CCoinJoin::GetSmallestDenomination() && plan.CountOutputs() < COINJOIN_DENOM_OUTPUTS_THRESHOLD) {
         CAmount nLargestDenomValue = vecStandardDenoms.front();
 
-        LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- 2 - Process remainder: %s\n", __func__, txBuilder.ToString());
-
-        auto countPossibleOutputs = [&](CAmount nAmount) -> int {
-            std::vector<CAmount> vecOutputs;
-            while (true) {
-                // Create an potential output
-                vecOutputs.push_back(nAmount);
-                if (!txBuilder.CouldAddOutputs(vecOutputs) || txBuilder.CountOutputs() + vecOutputs.size() > COINJOIN_DENOM_OUTPUTS_THRESHOLD) {
-                    // If its not possible to add it due to insufficient amount left or total number of outputs exceeds
-                    // COINJOIN_DENOM_OUTPUTS_THRESHOLD drop the output again and stop trying.
-                    vecOutputs.pop_back();
-                    break;
-                }
-            }
-            return static_cast<int>(vecOutputs.size());
-        };
+        LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- 2 - Process remainder: %s\n", __func__, plan.ToString());
 
         // Go big to small
         for (auto nDenomValue : vecStandardDenoms) {
             int nOutputs = 0;
 
             // Number of denoms we can create given our denom and the amount of funds we have left
-            int denomsToCreateValue = countPossibleOutputs(nDenomValue);
+            int denomsToCreateValue = plan.CountPossibleOutputs(nDenomValue, COINJOIN_DENOM_OUTPUTS_THRESHOLD - plan.CountOutputs());
             // Prefer overshooting the targed balance by larger denoms (hence `+1`) instead of a more
             // accurate approximation by many smaller denoms. This is ok because when we get here we
             // should have nCoinJoinDenomsGoal of each smaller denom already. Also, without `+1`
@@ -1748,30 +1759,35 @@ bool CCoinJoinClientSession::CreateDenominated(CAmount nBalanceToDenominate, con
                 if (nDenomValue != nLargestDenomValue && it->second >= CCoinJoinClientOptions::GetDenomsHardCap()) break;
 
                 // Increment helpers, add output and subtract denomination amount
-                if (txBuilder.AddOutput(nDenomValue)) {
+                if (plan.AddOutput(nDenomValue)) {
                     nOutputs++;
                     it->second++;
                     nBalanceToDenominate -= nDenomValue;
                 } else {
-                    LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- 2 - Error: AddOutput failed at %d/%d, %s\n", __func__, i + 1, denomsToCreate, txBuilder.ToString());
+                    LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- 2 - Error: AddOutput failed at %d/%d, %s\n", __func__, i + 1, denomsToCreate, plan.ToString());
                     break;
                 }
                 LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- 2 - nDenomValue: %f, nBalanceToDenominate: %f, nOutputs: %d, %s\n",
-                                             __func__, (float) nDenomValue / COIN, (float) nBalanceToDenominate / COIN, nOutputs, txBuilder.ToString());
-                if (txBuilder.CountOutputs() >= COINJOIN_DENOM_OUTPUTS_THRESHOLD) break;
+                                             __func__, (float) nDenomValue / COIN, (float) nBalanceToDenominate / COIN, nOutputs, plan.ToString());
+                if (plan.CountOutputs() >= COINJOIN_DENOM_OUTPUTS_THRESHOLD) break;
             }
-            if (txBuilder.CountOutputs() >= COINJOIN_DENOM_OUTPUTS_THRESHOLD) break;
+            if (plan.CountOutputs() >= COINJOIN_DENOM_OUTPUTS_THRESHOLD) break;
         }
     }
 
-    LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- 3 - nBalanceToDenominate: %f, %s\n", __func__, (float) nBalanceToDenominate / COIN, txBuilder.ToString());
+    LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- 3 - nBalanceToDenominate: %f, %s\n", __func__, (float) nBalanceToDenominate / COIN, plan.ToString());
 
     for (const auto it : mapDenomCount) {
         LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- 3 - DONE - nDenomValue: %f, count: %d\n", __func__, (float) it.first / COIN, it.second);
     }
 
     // No reasons to create mixing collaterals if we can't create denoms to mix
-    if ((fCreateMixingCollaterals && txBuilder.CountOutputs() == 1) || txBuilder.CountOutputs() == 0) {
+    if ((fCreateMixingCollaterals && plan.CountOutputs() == 1) || plan.CountOutputs() == 0) {
+        return false;
+    }
+
+    if (!txBuilder.AddOutputs(plan.GetAmounts())) {
+        LogPrint(BCLog::COINJOIN, "CCoinJoinClientSession::%s -- Failed to add planned outputs, %s\n", __func__, plan.ToString());
         return false;
     }
 
@@ -1811,6 +1827,8 @@ void CCoinJoinClientManager::UpdatedBlockTip(const CBlockIndex* pindex)
 {
     nCachedBlockHeight = pindex->nHeight;
     LogPrint(BCLog::COINJOIN, "CCoinJoinClientManager::UpdatedBlockTip -- nCachedBlockHeight: %d\n", nCachedBlockHeight);
+    // new confirmations and WaitForAnotherBlock() might allow us to continue
+    WakeUp();
 }
 
 void CCoinJoinClientQueueManager::DoMaintenance()
@@ -1830,16 +1848,18 @@ void CCoinJoinClientManager::DoMaintenance(CConnman& connman)
 
     if (!masternodeSync.IsBlockchainSynced() || ShutdownRequested()) return;
 
-    static int nTick = 0;
-    static int nDoAutoNextRun = nTick + COINJOIN_AUTO_TIMEOUT_MIN;
-
-    nTick++;
     CheckTimeout();
     ProcessPendingDsaRequest(connman);
-    if (nDoAutoNextRun == nTick) {
-        DoAutomaticDenominating(connman);
-        nDoAutoNextRun = nTick + COINJOIN_AUTO_TIMEOUT_MIN + GetRandInt(COINJOIN_AUTO_TIMEOUT_MAX - COINJOIN_AUTO_TIMEOUT_MIN);
-    }
+
+    int64_t nNow = GetTime();
+    // keep the randomized delay between two runs
+    if (nNow < nTimeNextAutoDenominate) return;
+    // nothing happened since the last run which could change its result, only retry once in a while
+    if (!fWakeUp.exchange(false) && nNow < nTimeLastAutoDenominate + COINJOIN_AUTO_TIMEOUT_IDLE) return;
+
+    DoAutomaticDenominating(connman);
+    nTimeLastAutoDenominate = nNow;
+    nTimeNextAutoDenominate = nNow + COINJOIN_AUTO_TIMEOUT_MIN + GetRandInt(COINJOIN_AUTO_TIMEOUT_MAX - COINJOIN_AUTO_TIMEOUT_MIN);
 }
 
 void CCoinJoinClientSession::GetJsonInfo(UniValue& obj) const
@@ -1856,6 +1876,14 @@ void CCoinJoinClientSession::GetJsonInfo(UniValue& obj) const
     obj.pushKV("entries_count", GetEntriesCount());
 }
 
+size_t CCoinJoinClientManager::GetActiveSessionCount() const
+{
+    LOCK(cs_deqsessions);
+    return std::count_if(deqSessions.begin(), deqSessions.end(), [](const CCoinJoinClientSession& session) {
+        return session.GetState() != POOL_STATE_IDLE;
+    });
+}
+
 void CCoinJoinClientManager::GetJsonInfo(UniValue& obj) const
 {
     LOCK(cs_deqsessions);
@@ -1876,8 +1904,12 @@ void CCoinJoinClientManager::GetJsonInfo(UniValue& obj) const
 void DoCoinJoinMaintenance(CConnman& connman)
 {
     coinJoinClientQueueManager.DoMaintenance();
+    size_t nSessions{0};
     for (auto& pair : coinJoinClientManagers) {
         pair.second->DoMaintenance(connman);
+        nSessions += pair.second->GetActiveSessionCount();
     }
+    statsClient.gauge("coinjoin.client.sessions", nSessions, 1.0f);
+    statsClient.gauge("coinjoin.client.queue", coinJoinClientQueueManager.GetQueueSize(), 1.0f);
 }
 
@@ -189,6 +189,14 @@ private:
     // Keep track of current block height
     int nCachedBlockHeight;
 
+    // Set by events which might allow DoAutomaticDenominating to make progress (new blocks, queues, wallet transactions)
+    std::atomic<bool> fWakeUp{true};
+    // Wake timers of DoMaintenance, see COINJOIN_AUTO_TIMEOUT_MIN/MAX/IDLE
+    int64_t nTimeLastAutoDenominate{0};
+    int64_t nTimeNextAutoDenominate{0};
+    // Wakes us up on wallet transaction changes
+    boost::signals2::scoped_connection connNotifyTransactionChanged;
+
     bool WaitForAnotherBlock() const;
 
     // Make sure we have enough keys since last backup
@@ -209,6 +217,8 @@ public:
         fCreateAutoBackups(true),
         mixingWallet(wallet)
     {
+        connNotifyTransactionChanged = mixingWallet.NotifyTransactionChanged.connect(
+            [this](CWallet*, const uint256&, ChangeType) { WakeUp(); });
     }
 
     void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman, bool enable_bip61);
@@ -226,7 +236,7 @@ public:
     /// Passively run mixing in the background according to the configuration in settings
     bool DoAutomaticDenominating(CConnman& connman, bool fDryRun = false);
 
-    bool TrySubmitDenominate(const CService& mnAddr, CConnman& connman);
+    bool TrySubmitDenominate(const CService& mnAddr, int nDenom, CConnman& connman);
     bool MarkAlreadyJoinedQueueAsTried(CCoinJoinQueue& dsq) const;
 
     void CheckTimeout();
@@ -240,8 +250,14 @@ public:
 
     void UpdatedBlockTip(const CBlockIndex* pindex);
 
+    /// Make the next DoMaintenance run DoAutomaticDenominating as soon as the randomized delay allows it
+    void WakeUp() { fWakeUp = true; }
+
     void DoMaintenance(CConnman& connman);
 
+    /// Number of sessions which are not idle
+    size_t GetActiveSessionCount() const;
+
     void GetJsonInfo(UniValue& obj) const;
 };
 
@@ -42,18 +42,21 @@ void CCoinJoinServer::ProcessMessage(CNode* pfrom, const std::string& strCommand
             return;
         }
 
-        if (IsSessionReady()) {
-            // too many users in this session already, reject new ones
-            LogPrint(BCLog::COINJOIN, "DSACCEPT -- queue is already full!\n");
-            PushStatus(pfrom, STATUS_REJECTED, ERR_QUEUE_FULL, connman);
-            return;
-        }
-
         CCoinJoinAccept dsa;
         vRecv >> dsa;
 
         LogPrint(BCLog::COINJOIN, "DSACCEPT -- nDenom %d (%s)  txCollateral %s", dsa.nDenom, CCoinJoin::DenominationToString(dsa.nDenom), dsa.txCollateral.ToString()); /* Continued */
 
+        LOCK(cs_mapsessions);
+
+        auto itSession = mapSessions.find(dsa.nDenom);
+        if (itSession != mapSessions.end() && itSession->second.IsSessionReady()) {
+            // too many users in this session already, reject new ones
+            LogPrint(BCLog::COINJOIN, "DSACCEPT -- queue is already full!\n");
+            itSession->second.PushStatus(pfrom, STATUS_REJECTED, ERR_QUEUE_FULL, connman);
+            return;
+        }
+
         auto mnList = deterministicMNManager->GetListAtChainTip();
         auto dmn = mnList.GetValidMNByCollateral(activeMasternodeInfo.outpoint);
         if (!dmn) {
@@ -61,18 +64,16 @@ void CCoinJoinServer::ProcessMessage(CNode* pfrom, const std::string& strCommand
             return;
         }
 
-        if (vecSessionCollaterals.empty()) {
+        if (itSession == mapSessions.end()) {
             {
                 TRY_LOCK(cs_vecqueue, lockRecv);
                 if (!lockRecv) return;
 
-                for (const auto& q : vecCoinJoinQueue) {
-                    if (q.masternodeOutpoint == activeMasternodeInfo.outpoint) {
-                        // refuse to create another queue this often
-                        LogPrint(BCLog::COINJOIN, "DSACCEPT -- last dsq is still in queue, refuse to mix\n");
-                        PushStatus(pfrom, STATUS_REJECTED, ERR_RECENT, connman);
-                        return;
-                    }
+                if (GetQueue(activeMasternodeInfo.outpoint, dsa.nDenom, false) != nullptr) {
+                    // refuse to create another queue this often
+                    LogPrint(BCLog::COINJOIN, "DSACCEPT -- last dsq is still in queue, refuse to mix\n");
+                    PushStatus(pfrom, STATUS_REJECTED, ERR_RECENT, connman);
+                    return;
                 }
             }
 
@@ -91,15 +92,35 @@ void CCoinJoinServer::ProcessMessage(CNode* pfrom, const std::string& strCommand
 
         PoolMessage nMessageID = MSG_NOERR;
 
-        bool fResult = nSessionID == 0 ? CreateNewSession(dsa, nMessageID, connman)
-                                       : AddUserToExistingSession(dsa, nMessageID);
+        bool fNewSession = itSession == mapSessions.end();
+        if (fNewSession) {
+            itSession = mapSessions.emplace(std::piecewise_construct, std::forward_as_tuple(dsa.nDenom), std::forward_as_tuple()).first;
+        }
+        auto& session = itSession->second;
+
+        bool fResult = fNewSession ? session.CreateNewSession(dsa, nMessageID, connman)
+                                   : session.AddUserToExistingSession(dsa, nMessageID);
         if (fResult) {
+            if (fNewSession) {
+                //broadcast that I'm accepting entries, only if it's the first entry through
+                CCoinJoinQueue dsq(session.nSessionDenom, activeMasternodeInfo.outpoint, GetAdjustedTime(), false);
+                LogPrint(BCLog::COINJOIN, "DSACCEPT -- signing and relaying new queue: %s\n", dsq.ToString());
+                dsq.Sign();
+                dsq.Relay(connman);
+                LOCK(cs_vecqueue);
+                if (GetQueue(dsq.masternodeOutpoint, dsq.nDenom, dsq.fReady) == nullptr) {
+                    AddQueue(dsq);
+                }
+            }
             LogPrint(BCLog::COINJOIN, "DSACCEPT -- is compatible, please submit!\n");
-            PushStatus(pfrom, STATUS_ACCEPTED, nMessageID, connman);
+            session.PushStatus(pfrom, STATUS_ACCEPTED, nMessageID, connman);
             return;
         } else {
             LogPrint(BCLog::COINJOIN, "DSACCEPT -- not compatible with existing transactions!\n");
-            PushStatus(pfrom, STATUS_REJECTED, nMessageID, connman);
+            session.PushStatus(pfrom, STATUS_REJECTED, nMessageID, connman);
+            if (fNewSession) {
+                mapSessions.erase(itSession);
+            }
             return;
         }
 
@@ -122,15 +143,13 @@ void CCoinJoinServer::ProcessMessage(CNode* pfrom, const std::string& strCommand
             if (!lockRecv) return;
 
             // process every dsq only once
-            for (const auto& q : vecCoinJoinQueue) {
-                if (q == dsq) {
-                    return;
-                }
-                if (q.fReady == dsq.fReady && q.masternodeOutpoint == dsq.masternodeOutpoint) {
+            const CCoinJoinQueue* q = GetQueue(dsq.masternodeOutpoint, dsq.nDenom, dsq.fReady);
+            if (q != nullptr) {
+                if (!(*q == dsq)) {
                     // no way the same mn can send another dsq with the same readiness this soon
                     LogPrint(BCLog::COINJOIN, "DSQUEUE -- Peer %s is sending WAY too many dsq messages for a masternode with collateral %s\n", pfrom->GetLogString(), dsq.masternodeOutpoint.ToStringShort());
-                    return;
                 }
+                return;
             }
         } // cs_vecqueue
 
@@ -163,7 +182,9 @@ void CCoinJoinServer::ProcessMessage(CNode* pfrom, const std::string& strCommand
 
             TRY_LOCK(cs_vecqueue, lockRecv);
             if (!lockRecv) return;
-            vecCoinJoinQueue.push_back(dsq);
+            // might have been added by another peer in the meantime
+            if (GetQueue(dsq.masternodeOutpoint, dsq.nDenom, dsq.fReady) != nullptr) return;
+            AddQueue(dsq);
             dsq.Relay(connman);
         }
 
@@ -179,28 +200,36 @@ void CCoinJoinServer::ProcessMessage(CNode* pfrom, const std::string& strCommand
             return;
         }
 
-        //do we have enough users in the current session?
-        if (!IsSessionReady()) {
-            LogPrint(BCLog::COINJOIN, "DSVIN -- session not complete!\n");
-            PushStatus(pfrom, STATUS_REJECTED, ERR_SESSION, connman);
-            return;
-        }
-
         CCoinJoinEntry entry;
         vRecv >> entry;
 
         LogPrint(BCLog::COINJOIN, "DSVIN -- txCollateral %s", entry.txCollateral->ToString()); /* Continued */
 
+        LOCK(cs_mapsessions);
+
+        //do we have enough users in the session for this denomination?
+        CCoinJoinServerSession* session = GetSessionForOutputs(entry.vecTxOut);
+        if (session == nullptr || !session->IsSessionReady()) {
+            LogPrint(BCLog::COINJOIN, "DSVIN -- session not complete!\n");
+            if (session != nullptr) {
+                session->PushStatus(pfrom, STATUS_REJECTED, ERR_SESSION, connman);
+            } else {
+                PushStatus(pfrom, STATUS_REJECTED, ERR_SESSION, connman);
+            }
+            return;
+        }
+
         PoolMessage nMessageID = MSG_NOERR;
 
         entry.addr = pfrom->addr;
-        if (AddEntry(connman, entry, nMessageID)) {
-            PushStatus(pfrom, STATUS_ACCEPTED, nMessageID, connman);
-            CheckPool(connman);
-            RelayStatus(STATUS_ACCEPTED, connman);
+        if (session->AddEntry(connman, entry, nMessageID)) {
+            session->PushStatus(pfrom, STATUS_ACCEPTED, nMessageID, connman);
+            session->CheckPool(connman);
+            session->RelayStatus(STATUS_ACCEPTED, connman);
         } else {
-            PushStatus(pfrom, STATUS_REJECTED, nMessageID, connman);
+            session->PushStatus(pfrom, STATUS_REJECTED, nMessageID, connman);
         }
+        RemoveFinishedSessions();
 
     } else if (strCommand == NetMsgType::DSSIGNFINALTX) {
         if (pfrom->nVersion < MIN_COINJOIN_PEER_PROTO_VERSION) {
@@ -218,51 +247,103 @@ void CCoinJoinServer::ProcessMessage(CNode* pfrom, const std::string& strCommand
 
         LogPrint(BCLog::COINJOIN, "DSSIGNFINALTX -- vecTxIn.size() %s\n", vecTxIn.size());
 
-        int nTxInIndex = 0;
-        int nTxInsCount = (int)vecTxIn.size();
+        LOCK(cs_mapsessions);
 
-        for (const auto& txin : vecTxIn) {
-            nTxInIndex++;
-            if (!AddScriptSig(txin)) {
-                LogPrint(BCLog::COINJOIN, "DSSIGNFINALTX -- AddScriptSig() failed at %d/%d, session: %d\n", nTxInIndex, nTxInsCount, nSessionID);
-                RelayStatus(STATUS_REJECTED, connman);
-                return;
-            }
-            LogPrint(BCLog::COINJOIN, "DSSIGNFINALTX -- AddScriptSig() %d/%d success\n", nTxInIndex, nTxInsCount);
+        CCoinJoinServerSession* session = GetSessionForInputs(vecTxIn);
+        if (session == nullptr) {
+            LogPrint(BCLog::COINJOIN, "DSSIGNFINALTX -- no session for these inputs\n");
+            return;
+        }
+
+        if (!session->AddScriptSigs(vecTxIn)) {
+            LogPrint(BCLog::COINJOIN, "DSSIGNFINALTX -- AddScriptSigs() failed, session: %d\n", session->GetSessionID());
+            session->RelayStatus(STATUS_REJECTED, connman);
+            RemoveFinishedSessions();
+            return;
         }
+        LogPrint(BCLog::COINJOIN, "DSSIGNFINALTX -- AddScriptSigs() %d inputs success\n", vecTxIn.size());
         // all is good
-        CheckPool(connman);
+        session->CheckPool(connman);
+        RemoveFinishedSessions();
+    }
+}
+
+CCoinJoinServerSession* CCoinJoinServer::GetSessionForOutputs(const std::vector<CTxOut>& vecTxOut)
+{
+    AssertLockHeld(cs_mapsessions);
+
+    // all outputs of an entry have the session denomination, anything else is rejected by IsValidInOuts later
+    if (vecTxOut.empty()) return nullptr;
+    auto it = mapSessions.find(CCoinJoin::AmountToDenomination(vecTxOut[0].nValue));
+    return it == mapSessions.end() ? nullptr : &it->second;
+}
+
+CCoinJoinServerSession* CCoinJoinServer::GetSessionForInputs(const std::vector<CTxIn>& vecTxIn)
+{
+    AssertLockHeld(cs_mapsessions);
+
+    if (vecTxIn.empty()) return nullptr;
+    for (auto& pair : mapSessions) {
+        if (pair.second.HasInput(vecTxIn[0].prevout)) {
+            return &pair.second;
+        }
     }
+    return nullptr;
+}
+
+void CCoinJoinServer::RemoveFinishedSessions()
+{
+    AssertLockHeld(cs_mapsessions);
+
+    for (auto it = mapSessions.begin(); it != mapSessions.end(); ) {
+        if (!it->second.IsFinished()) {
+            ++it;
+            continue;
+        }
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::%s -- removing session for denom %d (%s)\n", __func__, it->first, CCoinJoin::DenominationToString(it->first));
+        {
+            // our queue for this denom is obsolete, a new session may be started right away
+            LOCK(cs_vecqueue);
+            RemoveQueues(activeMasternodeInfo.outpoint, it->first);
+        }
+        it = mapSessions.erase(it);
+    }
+}
+
+void CCoinJoinServer::PushStatus(CNode* pnode, PoolStatusUpdate nStatusUpdate, PoolMessage nMessageID, CConnman& connman)
+{
+    if (!pnode) return;
+    CCoinJoinStatusUpdate psssup(0, POOL_STATE_IDLE, 0, nStatusUpdate, nMessageID);
+    connman.PushMessage(pnode, CNetMsgMaker(pnode->GetSendVersion()).Make(NetMsgType::DSSTATUSUPDATE, psssup));
 }
 
-void CCoinJoinServer::SetNull()
+void CCoinJoinServerSession::SetNull()
 {
     // MN side
     vecSessionCollaterals.clear();
 
     CCoinJoinBaseSession::SetNull();
-    CCoinJoinBaseManager::SetNull();
 }
 
 //
 // Check the mixing progress and send client updates if a Masternode
 //
-void CCoinJoinServer::CheckPool(CConnman& connman)
+void CCoinJoinServerSession::CheckPool(CConnman& connman)
 {
     if (!fMasternodeMode) return;
 
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CheckPool -- entries count %lu\n", GetEntriesCount());
+    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::CheckPool -- entries count %lu\n", GetEntriesCount());
 
     // If we have an entry for each collateral, then create final tx
     if (nState == POOL_STATE_ACCEPTING_ENTRIES && GetEntriesCount() == vecSessionCollaterals.size()) {
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CheckPool -- FINALIZE TRANSACTIONS\n");
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::CheckPool -- FINALIZE TRANSACTIONS\n");
         CreateFinalTransaction(connman);
         return;
     }
 
     // Check for Time Out
     // If we timed out while accepting entries, then if we have more than minimum, create final tx
-    if (nState == POOL_STATE_ACCEPTING_ENTRIES && CCoinJoinServer::HasTimedOut()
+    if (nState == POOL_STATE_ACCEPTING_ENTRIES && CCoinJoinServerSession::HasTimedOut()
             && GetEntriesCount() >= CCoinJoin::GetMinPoolParticipants()) {
         // Punish misbehaving participants
         ChargeFees(connman);
@@ -273,15 +354,15 @@ void CCoinJoinServer::CheckPool(CConnman& connman)
 
     // If we have all of the signatures, try to compile the transaction
     if (nState == POOL_STATE_SIGNING && IsSignaturesComplete()) {
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CheckPool -- SIGNING\n");
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::CheckPool -- SIGNING\n");
         CommitFinalTransaction(connman);
         return;
     }
 }
 
-void CCoinJoinServer::CreateFinalTransaction(CConnman& connman)
+void CCoinJoinServerSession::CreateFinalTransaction(CConnman& connman)
 {
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CreateFinalTransaction -- FINALIZE TRANSACTIONS\n");
+    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::CreateFinalTransaction -- FINALIZE TRANSACTIONS\n");
 
     CMutableTransaction txNew;
 
@@ -299,21 +380,21 @@ void CCoinJoinServer::CreateFinalTransaction(CConnman& connman)
     sort(txNew.vout.begin(), txNew.vout.end(), CompareOutputBIP69());
 
     finalMutableTransaction = txNew;
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CreateFinalTransaction -- finalMutableTransaction=%s", txNew.ToString()); /* Continued */
+    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::CreateFinalTransaction -- finalMutableTransaction=%s", txNew.ToString()); /* Continued */
 
     // request signatures from clients
     SetState(POOL_STATE_SIGNING);
     RelayFinalTransaction(finalMutableTransaction, connman);
 }
 
-void CCoinJoinServer::CommitFinalTransaction(CConnman& connman)
+void CCoinJoinServerSession::CommitFinalTransaction(CConnman& connman)
 {
     if (!fMasternodeMode) return; // check and relay final tx only on masternode
 
     CTransactionRef finalTransaction = MakeTransactionRef(finalMutableTransaction);
     uint256 hashTx = finalTransaction->GetHash();
 
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CommitFinalTransaction -- finalTransaction=%s", finalTransaction->ToString()); /* Continued */
+    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::CommitFinalTransaction -- finalTransaction=%s", finalTransaction->ToString()); /* Continued */
 
     {
         // See if the transaction is valid
@@ -321,7 +402,7 @@ void CCoinJoinServer::CommitFinalTransaction(CConnman& connman)
         CValidationState validationState;
         mempool.PrioritiseTransaction(hashTx, 0.1 * COIN);
         if (!lockMain || !AcceptToMemoryPool(mempool, validationState, finalTransaction, nullptr /* pfMissingInputs */, false /* bypass_limits */, maxTxFee /* nAbsurdFee */)) {
-            LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CommitFinalTransaction -- AcceptToMemoryPool() error: Transaction not valid\n");
+            LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::CommitFinalTransaction -- AcceptToMemoryPool() error: Transaction not valid\n");
             SetNull();
             // not much we can do in this case, just notify clients
             RelayCompletedTransaction(ERR_INVALID_TX, connman);
@@ -329,7 +410,7 @@ void CCoinJoinServer::CommitFinalTransaction(CConnman& connman)
         }
     }
 
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CommitFinalTransaction -- CREATING DSTX\n");
+    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::CommitFinalTransaction -- CREATING DSTX\n");
 
     // create and sign masternode dstx transaction
     if (!CCoinJoin::GetDSTX(hashTx)) {
@@ -338,7 +419,7 @@ void CCoinJoinServer::CommitFinalTransaction(CConnman& connman)
         CCoinJoin::AddDSTX(dstxNew);
     }
 
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CommitFinalTransaction -- TRANSMITTING DSTX\n");
+    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::CommitFinalTransaction -- TRANSMITTING DSTX\n");
 
     CInv inv(MSG_DSTX, hashTx);
     connman.RelayInv(inv);
@@ -350,7 +431,7 @@ void CCoinJoinServer::CommitFinalTransaction(CConnman& connman)
     ChargeRandomFees(connman);
 
     // Reset
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CommitFinalTransaction -- COMPLETED -- RESETTING\n");
+    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::CommitFinalTransaction -- COMPLETED -- RESETTING\n");
     SetNull();
 }
 
@@ -366,7 +447,7 @@ void CCoinJoinServer::CommitFinalTransaction(CConnman& connman)
 // transaction for the client to be able to enter the pool. This transaction is kept by the Masternode
 // until the transaction is either complete or fails.
 //
-void CCoinJoinServer::ChargeFees(CConnman& connman)
+void CCoinJoinServerSession::ChargeFees(CConnman& connman)
 {
     if (!fMasternodeMode) return;
 
@@ -387,7 +468,7 @@ void CCoinJoinServer::ChargeFees(CConnman& connman)
 
             // This queue entry didn't send us the promised transaction
             if (!fFound) {
-                LogPrint(BCLog::COINJOIN, "CCoinJoinServer::ChargeFees -- found uncooperative node (didn't send transaction), found offence\n");
+                LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::ChargeFees -- found uncooperative node (didn't send transaction), found offence\n");
                 vecOffendersCollaterals.push_back(txCollateral);
             }
         }
@@ -398,7 +479,7 @@ void CCoinJoinServer::ChargeFees(CConnman& connman)
         for (const auto& entry : vecEntries) {
             for (const auto& txdsin : entry.vecTxDSIn) {
                 if (!txdsin.fHasSig) {
-                    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::ChargeFees -- found uncooperative node (didn't sign), found offence\n");
+                    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::ChargeFees -- found uncooperative node (didn't sign), found offence\n");
                     vecOffendersCollaterals.push_back(entry.txCollateral);
                 }
             }
@@ -418,7 +499,7 @@ void CCoinJoinServer::ChargeFees(CConnman& connman)
     Shuffle(vecOffendersCollaterals.begin(), vecOffendersCollaterals.end(), FastRandomContext());
 
     if (nState == POOL_STATE_ACCEPTING_ENTRIES || nState == POOL_STATE_SIGNING) {
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::ChargeFees -- found uncooperative node (didn't %s transaction), charging fees: %s", /* Continued */
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::ChargeFees -- found uncooperative node (didn't %s transaction), charging fees: %s", /* Continued */
             (nState == POOL_STATE_SIGNING) ? "sign" : "send", vecOffendersCollaterals[0]->ToString());
         ConsumeCollateral(connman, vecOffendersCollaterals[0]);
     }
@@ -436,18 +517,18 @@ void CCoinJoinServer::ChargeFees(CConnman& connman)
     stop these kinds of attacks 1 in 10 successful transactions are charged. This
     adds up to a cost of 0.001DRK per transaction on average.
 */
-void CCoinJoinServer::ChargeRandomFees(CConnman& connman)
+void CCoinJoinServerSession::ChargeRandomFees(CConnman& connman)
 {
     if (!fMasternodeMode) return;
 
     for (const auto& txCollateral : vecSessionCollaterals) {
         if (GetRandInt(100) > 10) return;
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::ChargeRandomFees -- charging random fees, txCollateral=%s", txCollateral->ToString()); /* Continued */
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::ChargeRandomFees -- charging random fees, txCollateral=%s", txCollateral->ToString()); /* Continued */
         ConsumeCollateral(connman, txCollateral);
     }
 }
 
-void CCoinJoinServer::ConsumeCollateral(CConnman& connman, const CTransactionRef& txref)
+void CCoinJoinServerSession::ConsumeCollateral(CConnman& connman, const CTransactionRef& txref)
 {
     LOCK(cs_main);
     CValidationState validationState;
@@ -459,7 +540,7 @@ void CCoinJoinServer::ConsumeCollateral(CConnman& connman, const CTransactionRef
     }
 }
 
-bool CCoinJoinServer::HasTimedOut()
+bool CCoinJoinServerSession::HasTimedOut()
 {
     if (!fMasternodeMode) return false;
 
@@ -473,16 +554,14 @@ bool CCoinJoinServer::HasTimedOut()
 //
 // Check for extraneous timeout
 //
-void CCoinJoinServer::CheckTimeout(CConnman& connman)
+void CCoinJoinServerSession::CheckTimeout(CConnman& connman)
 {
     if (!fMasternodeMode) return;
 
-    CheckQueue();
-
     // Too early to do anything
-    if (!CCoinJoinServer::HasTimedOut()) return;
+    if (!CCoinJoinServerSession::HasTimedOut()) return;
 
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CheckTimeout -- %s timed out -- resetting\n",
+    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::CheckTimeout -- %s timed out -- resetting\n",
         (nState == POOL_STATE_SIGNING) ? "Signing" : "Session");
     ChargeFees(connman);
     SetNull();
@@ -493,7 +572,7 @@ void CCoinJoinServer::CheckTimeout(CConnman& connman)
     After receiving multiple dsa messages, the queue will switch to "accepting entries"
     which is the active state right before merging the transaction
 */
-void CCoinJoinServer::CheckForCompleteQueue(CConnman& connman)
+void CCoinJoinServerSession::CheckForCompleteQueue(CConnman& connman)
 {
     if (!fMasternodeMode) return;
 
@@ -501,77 +580,81 @@ void CCoinJoinServer::CheckForCompleteQueue(CConnman& connman)
         SetState(POOL_STATE_ACCEPTING_ENTRIES);
 
         CCoinJoinQueue dsq(nSessionDenom, activeMasternodeInfo.outpoint, GetAdjustedTime(), true);
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CheckForCompleteQueue -- queue is ready, signing and relaying (%s) " /* Continued */
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::CheckForCompleteQueue -- queue is ready, signing and relaying (%s) " /* Continued */
                                      "with %d participants\n", dsq.ToString(), vecSessionCollaterals.size());
         dsq.Sign();
         dsq.Relay(connman);
     }
 }
 
-// Check to make sure a given input matches an input in the pool and its scriptSig is valid
-bool CCoinJoinServer::IsInputScriptSigValid(const CTxIn& txin)
+// Check to make sure the given inputs match inputs in the pool and their scriptSigs are valid
+bool CCoinJoinServerSession::IsInputScriptSigValid(const std::vector<CTxIn>& vecTxIn) const
 {
-    CMutableTransaction txNew;
-    txNew.vin.clear();
-    txNew.vout.clear();
-
-    int i = 0;
-    int nTxInIndex = -1;
-    CScript sigPubKey = CScript();
+    // clients sign the final transaction, so verify against it
+    CMutableTransaction txNew(finalMutableTransaction);
 
+    std::map<COutPoint, CScript> mapPrevPubKeys;
     for (const auto& entry : vecEntries) {
-        for (const auto& txout : entry.vecTxOut) {
-            txNew.vout.push_back(txout);
-        }
         for (const auto& txdsin : entry.vecTxDSIn) {
-            txNew.vin.push_back(txdsin);
-
-            if (txdsin.prevout == txin.prevout) {
-                nTxInIndex = i;
-                sigPubKey = txdsin.prevPubKey;
-            }
-            i++;
+            mapPrevPubKeys.emplace(txdsin.prevout, txdsin.prevPubKey);
         }
     }
 
-    if (nTxInIndex >= 0) { //might have to do this one input at a time?
-        txNew.vin[nTxInIndex].scriptSig = txin.scriptSig;
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::IsInputScriptSigValid -- verifying scriptSig %s\n", ScriptToAsmStr(txin.scriptSig).substr(0, 24));
-        // TODO we're using amount=0 here but we should use the correct amount. This works because Dash ignores the amount while signing/verifying (only used in Bitcoin/Segwit)
-        if (!VerifyScript(txNew.vin[nTxInIndex].scriptSig, sigPubKey, SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_STRICTENC, MutableTransactionSignatureChecker(&txNew, nTxInIndex, 0))) {
-            LogPrint(BCLog::COINJOIN, "CCoinJoinServer::IsInputScriptSigValid -- VerifyScript() failed on input %d\n", nTxInIndex);
+    std::vector<std::pair<unsigned int, CScript>> vecInputsToCheck;
+    for (const auto& txin : vecTxIn) {
+        auto itPrevPubKey = mapPrevPubKeys.find(txin.prevout);
+        auto itTxIn = std::find_if(txNew.vin.begin(), txNew.vin.end(), [&txin](const CTxIn& txinFinal) {
+            return txinFinal.prevout == txin.prevout;
+        });
+        if (itPrevPubKey == mapPrevPubKeys.end() || itTxIn == txNew.vin.end()) {
+            LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::IsInputScriptSigValid -- Failed to find matching input in pool, %s\n", txin.ToString());
             return false;
         }
-    } else {
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::IsInputScriptSigValid -- Failed to find matching input in pool, %s\n", txin.ToString());
+        itTxIn->scriptSig = txin.scriptSig;
+        vecInputsToCheck.emplace_back(itTxIn - txNew.vin.begin(), itPrevPubKey->second);
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::IsInputScriptSigValid -- verifying scriptSig %s\n", ScriptToAsmStr(txin.scriptSig).substr(0, 24));
+    }
+
+    // verify all inputs at once on the script check threads, scriptSigs of other inputs aren't covered by the
+    // SIGHASH_ANYONECANPAY signatures, so a single transaction can be used for all of them
+    const CTransaction txToCheck(txNew);
+    PrecomputedTransactionData txdata(txToCheck);
+    std::vector<CScriptCheck> vChecks;
+    vChecks.reserve(vecInputsToCheck.size());
+    for (const auto& input : vecInputsToCheck) {
+        // TODO we're using amount=0 here but we should use the correct amount. This works because Dash ignores the amount while signing/verifying (only used in Bitcoin/Segwit)
+        vChecks.emplace_back(CTxOut(0, input.second), txToCheck, input.first, SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_STRICTENC, false, &txdata);
+    }
+    if (!RunScriptChecks(vChecks)) {
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::IsInputScriptSigValid -- VerifyScript() failed\n");
         return false;
     }
 
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::IsInputScriptSigValid -- Successfully validated input and scriptSig\n");
+    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::IsInputScriptSigValid -- Successfully validated %d inputs and scriptSigs\n", vecTxIn.size());
     return true;
 }
 
 //
 // Add a client's transaction inputs/outputs to the pool
 //
-bool CCoinJoinServer::AddEntry(CConnman& connman, const CCoinJoinEntry& entry, PoolMessage& nMessageIDRet)
+bool CCoinJoinServerSession::AddEntry(CConnman& connman, const CCoinJoinEntry& entry, PoolMessage& nMessageIDRet)
 {
     if (!fMasternodeMode) return false;
 
     if (GetEntriesCount() >= vecSessionCollaterals.size()) {
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::%s -- ERROR: entries is full!\n", __func__);
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::%s -- ERROR: entries is full!\n", __func__);
         nMessageIDRet = ERR_ENTRIES_FULL;
         return false;
     }
 
     if (!CCoinJoin::IsCollateralValid(*entry.txCollateral)) {
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::%s -- ERROR: collateral not valid!\n", __func__);
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::%s -- ERROR: collateral not valid!\n", __func__);
         nMessageIDRet = ERR_INVALID_COLLATERAL;
         return false;
     }
 
     if (entry.vecTxDSIn.size() > COINJOIN_ENTRY_MAX_SIZE) {
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::%s -- ERROR: too many inputs! %d/%d\n", __func__, entry.vecTxDSIn.size(), COINJOIN_ENTRY_MAX_SIZE);
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::%s -- ERROR: too many inputs! %d/%d\n", __func__, entry.vecTxDSIn.size(), COINJOIN_ENTRY_MAX_SIZE);
         nMessageIDRet = ERR_MAXIMUM;
         ConsumeCollateral(connman, entry.txCollateral);
         return false;
@@ -579,12 +662,12 @@ bool CCoinJoinServer::AddEntry(CConnman& connman, const CCoinJoinEntry& entry, P
 
     std::vector<CTxIn> vin;
     for (const auto& txin : entry.vecTxDSIn) {
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::%s -- txin=%s\n", __func__, txin.ToString());
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::%s -- txin=%s\n", __func__, txin.ToString());
 
         for (const auto& entry : vecEntries) {
             for (const auto& txdsin : entry.vecTxDSIn) {
                 if (txdsin.prevout == txin.prevout) {
-                    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::%s -- ERROR: already have this txin in entries\n", __func__);
+                    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::%s -- ERROR: already have this txin in entries\n", __func__);
                     nMessageIDRet = ERR_ALREADY_HAVE;
                     // Two peers sent the same input? Can't really say who is the malicious one here,
                     // could be that someone is picking someone else's inputs randomly trying to force
@@ -598,7 +681,7 @@ bool CCoinJoinServer::AddEntry(CConnman& connman, const CCoinJoinEntry& entry, P
 
     bool fConsumeCollateral{false};
     if (!IsValidInOuts(vin, entry.vecTxOut, nMessageIDRet, &fConsumeCollateral)) {
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::%s -- ERROR! IsValidInOuts() failed: %s\n", __func__, CCoinJoin::GetMessageByID(nMessageIDRet));
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::%s -- ERROR! IsValidInOuts() failed: %s\n", __func__, CCoinJoin::GetMessageByID(nMessageIDRet));
         if (fConsumeCollateral) {
             ConsumeCollateral(connman, entry.txCollateral);
         }
@@ -607,51 +690,70 @@ bool CCoinJoinServer::AddEntry(CConnman& connman, const CCoinJoinEntry& entry, P
 
     vecEntries.push_back(entry);
 
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::%s -- adding entry %d of %d required\n", __func__, GetEntriesCount(), CCoinJoin::GetMaxPoolParticipants());
+    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::%s -- adding entry %d of %d required\n", __func__, GetEntriesCount(), CCoinJoin::GetMaxPoolParticipants());
     nMessageIDRet = MSG_ENTRIES_ADDED;
 
     return true;
 }
 
-bool CCoinJoinServer::AddScriptSig(const CTxIn& txinNew)
+bool CCoinJoinServerSession::AddScriptSigs(const std::vector<CTxIn>& vecTxIn)
 {
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::AddScriptSig -- scriptSig=%s\n", ScriptToAsmStr(txinNew.scriptSig).substr(0, 24));
+    for (auto it = vecTxIn.begin(); it != vecTxIn.end(); ++it) {
+        const auto& txinNew = *it;
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::AddScriptSigs -- scriptSig=%s\n", ScriptToAsmStr(txinNew.scriptSig).substr(0, 24));
 
-    for (const auto& entry : vecEntries) {
-        for (const auto& txdsin : entry.vecTxDSIn) {
-            if (txdsin.scriptSig == txinNew.scriptSig) {
-                LogPrint(BCLog::COINJOIN, "CCoinJoinServer::AddScriptSig -- already exists\n");
-                return false;
+        bool fExists = std::any_of(vecTxIn.begin(), it, [&txinNew](const CTxIn& txin) { return txin.scriptSig == txinNew.scriptSig; });
+        for (const auto& entry : vecEntries) {
+            for (const auto& txdsin : entry.vecTxDSIn) {
+                fExists |= txdsin.scriptSig == txinNew.scriptSig;
             }
         }
+        if (fExists) {
+            LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::AddScriptSigs -- already exists\n");
+            return false;
+        }
     }
 
-    if (!IsInputScriptSigValid(txinNew)) {
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::AddScriptSig -- Invalid scriptSig\n");
+    if (!IsInputScriptSigValid(vecTxIn)) {
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::AddScriptSigs -- Invalid scriptSig\n");
         return false;
     }
 
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::AddScriptSig -- scriptSig=%s new\n", ScriptToAsmStr(txinNew.scriptSig).substr(0, 24));
+    for (const auto& txinNew : vecTxIn) {
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::AddScriptSigs -- scriptSig=%s new\n", ScriptToAsmStr(txinNew.scriptSig).substr(0, 24));
 
-    for (auto& txin : finalMutableTransaction.vin) {
-        if (txin.prevout == txinNew.prevout && txin.nSequence == txinNew.nSequence) {
-            txin.scriptSig = txinNew.scriptSig;
-            LogPrint(BCLog::COINJOIN, "CCoinJoinServer::AddScriptSig -- adding to finalMutableTransaction, scriptSig=%s\n", ScriptToAsmStr(txinNew.scriptSig).substr(0, 24));
+        for (auto& txin : finalMutableTransaction.vin) {
+            if (txin.prevout == txinNew.prevout && txin.nSequence == txinNew.nSequence) {
+                txin.scriptSig = txinNew.scriptSig;
+                LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::AddScriptSigs -- adding to finalMutableTransaction, scriptSig=%s\n", ScriptToAsmStr(txinNew.scriptSig).substr(0, 24));
+            }
         }
-    }
-    for (int i = 0; i < GetEntriesCount(); i++) {
-        if (vecEntries[i].AddScriptSig(txinNew)) {
-            LogPrint(BCLog::COINJOIN, "CCoinJoinServer::AddScriptSig -- adding to entries, scriptSig=%s\n", ScriptToAsmStr(txinNew.scriptSig).substr(0, 24));
-            return true;
+        bool fAdded = false;
+        for (int i = 0; i < GetEntriesCount() && !fAdded; i++) {
+            fAdded = vecEntries[i].AddScriptSig(txinNew);
+        }
+        if (!fAdded) {
+            LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::AddScriptSigs -- Couldn't set sig!\n");
+            return false;
         }
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::AddScriptSigs -- adding to entries, scriptSig=%s\n", ScriptToAsmStr(txinNew.scriptSig).substr(0, 24));
     }
 
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::AddScriptSig -- Couldn't set sig!\n");
+    return true;
+}
+
+bool CCoinJoinServerSession::HasInput(const COutPoint& outpoint) const
+{
+    for (const auto& entry : vecEntries) {
+        for (const auto& txdsin : entry.vecTxDSIn) {
+            if (txdsin.prevout == outpoint) return true;
+        }
+    }
     return false;
 }
 
 // Check to make sure everything is signed
-bool CCoinJoinServer::IsSignaturesComplete()
+bool CCoinJoinServerSession::IsSignaturesComplete()
 {
     for (const auto& entry : vecEntries) {
         for (const auto& txdsin : entry.vecTxDSIn) {
@@ -662,20 +764,20 @@ bool CCoinJoinServer::IsSignaturesComplete()
     return true;
 }
 
-bool CCoinJoinServer::IsAcceptableDSA(const CCoinJoinAccept& dsa, PoolMessage& nMessageIDRet)
+bool CCoinJoinServerSession::IsAcceptableDSA(const CCoinJoinAccept& dsa, PoolMessage& nMessageIDRet)
 {
     if (!fMasternodeMode) return false;
 
     // is denom even something legit?
     if (!CCoinJoin::IsValidDenomination(dsa.nDenom)) {
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::%s -- denom not valid!\n", __func__);
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::%s -- denom not valid!\n", __func__);
         nMessageIDRet = ERR_DENOM;
         return false;
     }
 
     // check collateral
     if (!fUnitTest && !CCoinJoin::IsCollateralValid(dsa.txCollateral)) {
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::%s -- collateral not valid!\n", __func__);
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::%s -- collateral not valid!\n", __func__);
         nMessageIDRet = ERR_INVALID_COLLATERAL;
         return false;
     }
@@ -683,14 +785,14 @@ bool CCoinJoinServer::IsAcceptableDSA(const CCoinJoinAccept& dsa, PoolMessage& n
     return true;
 }
 
-bool CCoinJoinServer::CreateNewSession(const CCoinJoinAccept& dsa, PoolMessage& nMessageIDRet, CConnman& connman)
+bool CCoinJoinServerSession::CreateNewSession(const CCoinJoinAccept& dsa, PoolMessage& nMessageIDRet, CConnman& connman)
 {
     if (!fMasternodeMode || nSessionID != 0) return false;
 
     // new session can only be started in idle mode
     if (nState != POOL_STATE_IDLE) {
         nMessageIDRet = ERR_MODE;
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CreateNewSession -- incompatible mode: nState=%d\n", nState);
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::CreateNewSession -- incompatible mode: nState=%d\n", nState);
         return false;
     }
 
@@ -705,23 +807,14 @@ bool CCoinJoinServer::CreateNewSession(const CCoinJoinAccept& dsa, PoolMessage&
 
     SetState(POOL_STATE_QUEUE);
 
-    if (!fUnitTest) {
-        //broadcast that I'm accepting entries, only if it's the first entry through
-        CCoinJoinQueue dsq(nSessionDenom, activeMasternodeInfo.outpoint, GetAdjustedTime(), false);
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CreateNewSession -- signing and relaying new queue: %s\n", dsq.ToString());
-        dsq.Sign();
-        dsq.Relay(connman);
-        vecCoinJoinQueue.push_back(dsq);
-    }
-
     vecSessionCollaterals.push_back(MakeTransactionRef(dsa.txCollateral));
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CreateNewSession -- new session created, nSessionID: %d  nSessionDenom: %d (%s)  vecSessionCollaterals.size(): %d  CCoinJoin::GetMaxPoolParticipants(): %d\n",
+    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::CreateNewSession -- new session created, nSessionID: %d  nSessionDenom: %d (%s)  vecSessionCollaterals.size(): %d  CCoinJoin::GetMaxPoolParticipants(): %d\n",
         nSessionID, nSessionDenom, CCoinJoin::DenominationToString(nSessionDenom), vecSessionCollaterals.size(), CCoinJoin::GetMaxPoolParticipants());
 
     return true;
 }
 
-bool CCoinJoinServer::AddUserToExistingSession(const CCoinJoinAccept& dsa, PoolMessage& nMessageIDRet)
+bool CCoinJoinServerSession::AddUserToExistingSession(const CCoinJoinAccept& dsa, PoolMessage& nMessageIDRet)
 {
     if (!fMasternodeMode || nSessionID == 0 || IsSessionReady()) return false;
 
@@ -732,12 +825,12 @@ bool CCoinJoinServer::AddUserToExistingSession(const CCoinJoinAccept& dsa, PoolM
     // we only add new users to an existing session when we are in queue mode
     if (nState != POOL_STATE_QUEUE) {
         nMessageIDRet = ERR_MODE;
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::AddUserToExistingSession -- incompatible mode: nState=%d\n", nState);
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::AddUserToExistingSession -- incompatible mode: nState=%d\n", nState);
         return false;
     }
 
     if (dsa.nDenom != nSessionDenom) {
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::AddUserToExistingSession -- incompatible denom %d (%s) != nSessionDenom %d (%s)\n",
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::AddUserToExistingSession -- incompatible denom %d (%s) != nSessionDenom %d (%s)\n",
             dsa.nDenom, CCoinJoin::DenominationToString(dsa.nDenom), nSessionDenom, CCoinJoin::DenominationToString(nSessionDenom));
         nMessageIDRet = ERR_DENOM;
         return false;
@@ -748,20 +841,20 @@ bool CCoinJoinServer::AddUserToExistingSession(const CCoinJoinAccept& dsa, PoolM
     nMessageIDRet = MSG_NOERR;
     vecSessionCollaterals.push_back(MakeTransactionRef(dsa.txCollateral));
 
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::AddUserToExistingSession -- new user accepted, nSessionID: %d  nSessionDenom: %d (%s)  vecSessionCollaterals.size(): %d  CCoinJoin::GetMaxPoolParticipants(): %d\n",
+    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::AddUserToExistingSession -- new user accepted, nSessionID: %d  nSessionDenom: %d (%s)  vecSessionCollaterals.size(): %d  CCoinJoin::GetMaxPoolParticipants(): %d\n",
         nSessionID, nSessionDenom, CCoinJoin::DenominationToString(nSessionDenom), vecSessionCollaterals.size(), CCoinJoin::GetMaxPoolParticipants());
 
     return true;
 }
 
 // Returns true if either max size has been reached or if the mix timed out and min size was reached
-bool CCoinJoinServer::IsSessionReady()
+bool CCoinJoinServerSession::IsSessionReady()
 {
     if (nState == POOL_STATE_QUEUE) {
         if ((int)vecSessionCollaterals.size() >= CCoinJoin::GetMaxPoolParticipants()) {
             return true;
         }
-        if (CCoinJoinServer::HasTimedOut() && (int)vecSessionCollaterals.size() >= CCoinJoin::GetMinPoolParticipants()) {
+        if (CCoinJoinServerSession::HasTimedOut() && (int)vecSessionCollaterals.size() >= CCoinJoin::GetMinPoolParticipants()) {
             return true;
         }
     }
@@ -771,9 +864,9 @@ bool CCoinJoinServer::IsSessionReady()
     return false;
 }
 
-void CCoinJoinServer::RelayFinalTransaction(const CTransaction& txFinal, CConnman& connman)
+void CCoinJoinServerSession::RelayFinalTransaction(const CTransaction& txFinal, CConnman& connman)
 {
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::%s -- nSessionID: %d  nSessionDenom: %d (%s)\n",
+    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::%s -- nSessionID: %d  nSessionDenom: %d (%s)\n",
         __func__, nSessionID, nSessionDenom, CCoinJoin::DenominationToString(nSessionDenom));
 
     // final mixing tx with empty signatures should be relayed to mixing participants only
@@ -791,14 +884,14 @@ void CCoinJoinServer::RelayFinalTransaction(const CTransaction& txFinal, CConnma
     }
 }
 
-void CCoinJoinServer::PushStatus(CNode* pnode, PoolStatusUpdate nStatusUpdate, PoolMessage nMessageID, CConnman& connman)
+void CCoinJoinServerSession::PushStatus(CNode* pnode, PoolStatusUpdate nStatusUpdate, PoolMessage nMessageID, CConnman& connman)
 {
     if (!pnode) return;
     CCoinJoinStatusUpdate psssup(nSessionID, nState, 0, nStatusUpdate, nMessageID);
     connman.PushMessage(pnode, CNetMsgMaker(pnode->GetSendVersion()).Make(NetMsgType::DSSTATUSUPDATE, psssup));
 }
 
-void CCoinJoinServer::RelayStatus(PoolStatusUpdate nStatusUpdate, CConnman& connman, PoolMessage nMessageID)
+void CCoinJoinServerSession::RelayStatus(PoolStatusUpdate nStatusUpdate, CConnman& connman, PoolMessage nMessageID)
 {
     unsigned int nDisconnected{};
     // status updates should be relayed to mixing participants only
@@ -816,7 +909,7 @@ void CCoinJoinServer::RelayStatus(PoolStatusUpdate nStatusUpdate, CConnman& conn
     if (nDisconnected == 0) return; // all is clear
 
     // something went wrong
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::%s -- can't continue, %llu client(s) disconnected, nSessionID: %d  nSessionDenom: %d (%s)\n",
+    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::%s -- can't continue, %llu client(s) disconnected, nSessionID: %d  nSessionDenom: %d (%s)\n",
         __func__, nDisconnected, nSessionID, nSessionDenom, CCoinJoin::DenominationToString(nSessionDenom));
 
     // notify everyone else that this session should be terminated
@@ -834,9 +927,9 @@ void CCoinJoinServer::RelayStatus(PoolStatusUpdate nStatusUpdate, CConnman& conn
     }
 }
 
-void CCoinJoinServer::RelayCompletedTransaction(PoolMessage nMessageID, CConnman& connman)
+void CCoinJoinServerSession::RelayCompletedTransaction(PoolMessage nMessageID, CConnman& connman)
 {
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::%s -- nSessionID: %d  nSessionDenom: %d (%s)\n",
+    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::%s -- nSessionID: %d  nSessionDenom: %d (%s)\n",
         __func__, nSessionID, nSessionDenom, CCoinJoin::DenominationToString(nSessionDenom));
 
     // final mixing tx with empty signatures should be relayed to mixing participants only
@@ -854,16 +947,16 @@ void CCoinJoinServer::RelayCompletedTransaction(PoolMessage nMessageID, CConnman
     }
 }
 
-void CCoinJoinServer::SetState(PoolState nStateNew)
+void CCoinJoinServerSession::SetState(PoolState nStateNew)
 {
     if (!fMasternodeMode) return;
 
     if (nStateNew == POOL_STATE_ERROR) {
-        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::SetState -- Can't set state to ERROR as a Masternode. \n");
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::SetState -- Can't set state to ERROR as a Masternode. \n");
         return;
     }
 
-    LogPrint(BCLog::COINJOIN, "CCoinJoinServer::SetState -- nState: %d, nStateNew: %d\n", nState, nStateNew);
+    LogPrint(BCLog::COINJOIN, "CCoinJoinServerSession::SetState -- nState: %d, nStateNew: %d\n", nState, nStateNew);
     nTimeLastSuccessfulStep = GetTime();
     nState = nStateNew;
 }
@@ -874,17 +967,51 @@ void CCoinJoinServer::DoMaintenance(CConnman& connman)
 
     if (!masternodeSync.IsBlockchainSynced() || ShutdownRequested()) return;
 
-    coinJoinServer.CheckForCompleteQueue(connman);
-    coinJoinServer.CheckPool(connman);
-    coinJoinServer.CheckTimeout(connman);
+    CheckQueue();
+
+    LOCK(cs_mapsessions);
+    for (auto& pair : mapSessions) {
+        auto& session = pair.second;
+        session.CheckForCompleteQueue(connman);
+        session.CheckPool(connman);
+        session.CheckTimeout(connman);
+    }
+    RemoveFinishedSessions();
 }
 
-void CCoinJoinServer::GetJsonInfo(UniValue& obj) const
+void CCoinJoinServerSession::GetJsonInfo(UniValue& obj) const
 {
     obj.clear();
     obj.setObject();
-    obj.pushKV("queue_size",    GetQueueSize());
     obj.pushKV("denomination",  ValueFromAmount(CCoinJoin::DenominationToAmount(nSessionDenom)));
     obj.pushKV("state",         GetStateString());
     obj.pushKV("entries_count", GetEntriesCount());
 }
+
+void CCoinJoinServer::GetSessionCounts(size_t& nSessionsRet, size_t& nEntriesRet) const
+{
+    LOCK(cs_mapsessions);
+    nSessionsRet = mapSessions.size();
+    nEntriesRet = 0;
+    for (const auto& pair : mapSessions) {
+        nEntriesRet += pair.second.GetEntriesCount();
+    }
+}
+
+void CCoinJoinServer::GetJsonInfo(UniValue& obj) const
+{
+    obj.clear();
+    obj.setObject();
+    obj.pushKV("queue_size",    GetQueueSize());
+
+    UniValue arrSessions(UniValue::VARR);
+    {
+        LOCK(cs_mapsessions);
+        for (const auto& pair : mapSessions) {
+            UniValue objSession;
+            pair.second.GetJsonInfo(objSession);
+            arrSessions.push_back(objSession);
+        }
+    }
+    obj.pushKV("sessions",      arrSessions);
+}
@@ -14,9 +14,9 @@ class UniValue;
 // The main object for accessing mixing
 extern CCoinJoinServer coinJoinServer;
 
-/** Used to keep track of current status of mixing pool
+/** A single mixing session of the masternode, there is at most one session per denomination
  */
-class CCoinJoinServer : public CCoinJoinBaseSession, public CCoinJoinBaseManager
+class CCoinJoinServerSession : public CCoinJoinBaseSession
 {
 private:
     // Mixing uses collateral transactions to trust parties entering the pool
@@ -25,11 +25,6 @@ private:
 
     bool fUnitTest;
 
-    /// Add a clients entry to the pool
-    bool AddEntry(CConnman& connman, const CCoinJoinEntry& entry, PoolMessage& nMessageIDRet);
-    /// Add signature to a txin
-    bool AddScriptSig(const CTxIn& txin);
-
     /// Charge fees to bad actors (Charge clients a fee if they're abusive)
     void ChargeFees(CConnman& connman);
     /// Rarely charge fees to pay miners
@@ -37,48 +32,88 @@ private:
     /// Consume collateral in cases when peer misbehaved
     void ConsumeCollateral(CConnman& connman, const CTransactionRef& txref);
 
-    /// Check for process
-    void CheckPool(CConnman& connman);
-
     void CreateFinalTransaction(CConnman& connman);
     void CommitFinalTransaction(CConnman& connman);
 
     /// Is this nDenom and txCollateral acceptable?
     bool IsAcceptableDSA(const CCoinJoinAccept& dsa, PoolMessage& nMessageIDRet);
-    bool CreateNewSession(const CCoinJoinAccept& dsa, PoolMessage& nMessageIDRet, CConnman& connman);
-    bool AddUserToExistingSession(const CCoinJoinAccept& dsa, PoolMessage& nMessageIDRet);
-    /// Do we have enough users to take entries?
-    bool IsSessionReady();
 
     /// Check that all inputs are signed. (Are all inputs signed?)
     bool IsSignaturesComplete();
-    /// Check to make sure a given input matches an input in the pool and its scriptSig is valid
-    bool IsInputScriptSigValid(const CTxIn& txin);
+    /// Check to make sure the given inputs match inputs in the pool and their scriptSigs are valid
+    bool IsInputScriptSigValid(const std::vector<CTxIn>& vecTxIn) const;
 
     // Set the 'state' value, with some logging and capturing when the state changed
     void SetState(PoolState nStateNew);
 
     /// Relay mixing Messages
     void RelayFinalTransaction(const CTransaction& txFinal, CConnman& connman);
-    void PushStatus(CNode* pnode, PoolStatusUpdate nStatusUpdate, PoolMessage nMessageID, CConnman& connman);
-    void RelayStatus(PoolStatusUpdate nStatusUpdate, CConnman& connman, PoolMessage nMessageID = MSG_NOERR);
     void RelayCompletedTransaction(PoolMessage nMessageID, CConnman& connman);
 
     void SetNull();
 
 public:
-    CCoinJoinServer() :
+    CCoinJoinServerSession() :
         vecSessionCollaterals(),
         fUnitTest(false) {}
 
-    void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman, bool enable_bip61);
+    /// Add a clients entry to the pool
+    bool AddEntry(CConnman& connman, const CCoinJoinEntry& entry, PoolMessage& nMessageIDRet);
+    /// Add signatures of all txins a client sent, fails if any of them is invalid
+    bool AddScriptSigs(const std::vector<CTxIn>& vecTxIn);
+    /// Is this input part of the entries of this session?
+    bool HasInput(const COutPoint& outpoint) const;
+
+    bool CreateNewSession(const CCoinJoinAccept& dsa, PoolMessage& nMessageIDRet, CConnman& connman);
+    bool AddUserToExistingSession(const CCoinJoinAccept& dsa, PoolMessage& nMessageIDRet);
+    /// Do we have enough users to take entries?
+    bool IsSessionReady();
+    /// Has the session been reset (completed, failed or timed out) and can be removed?
+    bool IsFinished() const { return nState == POOL_STATE_IDLE && nSessionID == 0; }
+
+    /// Check for process
+    void CheckPool(CConnman& connman);
 
     bool HasTimedOut();
     void CheckTimeout(CConnman& connman);
     void CheckForCompleteQueue(CConnman& connman);
 
+    void PushStatus(CNode* pnode, PoolStatusUpdate nStatusUpdate, PoolMessage nMessageID, CConnman& connman);
+    void RelayStatus(PoolStatusUpdate nStatusUpdate, CConnman& connman, PoolMessage nMessageID = MSG_NOERR);
+
+    void GetJsonInfo(UniValue& obj) const;
+};
+
+/** Used to keep track of current status of mixing pool, runs one independent session per denomination
+ */
+class CCoinJoinServer : public CCoinJoinBaseManager
+{
+private:
+    mutable CCriticalSection cs_mapsessions;
+
+    // Mixing sessions in progress, by denomination
+    std::map<int, CCoinJoinServerSession> mapSessions GUARDED_BY(cs_mapsessions);
+
+    /// Session the entry with these outputs belongs to, nullptr if there is none
+    CCoinJoinServerSession* GetSessionForOutputs(const std::vector<CTxOut>& vecTxOut) EXCLUSIVE_LOCKS_REQUIRED(cs_mapsessions);
+    /// Session these signed inputs belong to, nullptr if there is none
+    CCoinJoinServerSession* GetSessionForInputs(const std::vector<CTxIn>& vecTxIn) EXCLUSIVE_LOCKS_REQUIRED(cs_mapsessions);
+    /// Remove sessions which were reset, together with our queue for their denomination
+    void RemoveFinishedSessions() EXCLUSIVE_LOCKS_REQUIRED(cs_mapsessions);
+
+    /// Status update for messages not belonging to any session
+    static void PushStatus(CNode* pnode, PoolStatusUpdate nStatusUpdate, PoolMessage nMessageID, CConnman& connman);
+
+public:
+    CCoinJoinServer() = default;
+
+    void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman, bool enable_bip61);
+
     void DoMaintenance(CConnman& connman);
 
+    /// Number of mixing sessions in progress and the entries submitted to them
+    void GetSessionCounts(size_t& nSessionsRet, size_t& nEntriesRet) const;
+
     void GetJsonInfo(UniValue& obj) const;
 };
 
@@ -101,6 +101,7 @@ bool CTransactionBuilderOutput::UpdateAmount(const CAmount nNewAmount)
     if (nNewAmount <= 0 || nNewAmount - nAmount > pTxBuilder->GetAmountLeft()) {
         return false;
     }
+    pTxBuilder->nAmountUsed += nNewAmount - nAmount;
     nAmount = nNewAmount;
     return true;
 }
@@ -166,6 +167,7 @@ void CTransactionBuilder::Clear()
         LOCK(cs_outputs);
         std::swap(vecOutputs, vecOutputsTmp);
         vecOutputs.clear();
+        nAmountUsed = 0;
     }
 
     for (auto& key : vecOutputsTmp) {
@@ -184,25 +186,32 @@ bool CTransactionBuilder::CouldAddOutput(CAmount nAmountOutput) const
     if (nAmountOutput < 0) {
         return false;
     }
-    // Adding another output can change the serialized size of the vout size hence + GetSizeOfCompactSizeDiff()
-    unsigned int nBytes = GetBytesTotal() + nBytesOutput + GetSizeOfCompactSizeDiff(1);
-    return GetAmountLeft(GetAmountInitial(), GetAmountUsed() + nAmountOutput, GetFee(nBytes)) >= 0;
+    return CouldAddOutputs(1, nAmountOutput);
 }
 
 bool CTransactionBuilder::CouldAddOutputs(const std::vector<CAmount>& vecOutputAmounts) const
 {
     CAmount nAmountAdditional{0};
-    assert(vecOutputAmounts.size() < INT_MAX);
-    int nBytesAdditional = nBytesOutput * (int)vecOutputAmounts.size();
     for (const auto nAmountOutput : vecOutputAmounts) {
         if (nAmountOutput < 0) {
             return false;
         }
         nAmountAdditional += nAmountOutput;
     }
+    return CouldAddOutputs(vecOutputAmounts.size(), nAmountAdditional);
+}
+
+bool CTransactionBuilder::CouldAddOutputs(size_t nOutputs, CAmount nAmountOutputs) const
+{
+    return GetAmountLeft(nOutputs, nAmountOutputs) >= 0;
+}
+
+CAmount CTransactionBuilder::GetAmountLeft(size_t nOutputs, CAmount nAmountOutputs) const
+{
+    assert(nOutputs < INT_MAX);
     // Adding other outputs can change the serialized size of the vout size hence + GetSizeOfCompactSizeDiff()
-    unsigned int nBytes = GetBytesTotal() + nBytesAdditional + GetSizeOfCompactSizeDiff(vecOutputAmounts.size());
-    return GetAmountLeft(GetAmountInitial(), GetAmountUsed() + nAmountAdditional, GetFee(nBytes)) >= 0;
+    unsigned int nBytes = GetBytesTotal() + nBytesOutput * (int)nOutputs + GetSizeOfCompactSizeDiff(nOutputs);
+    return GetAmountLeft(GetAmountInitial(), GetAmountUsed() + nAmountOutputs, GetFee(nBytes));
 }
 
 CTransactionBuilderOutput* CTransactionBuilder::AddOutput(CAmount nAmountOutput)
@@ -210,11 +219,26 @@ CTransactionBuilderOutput* CTransactionBuilder::AddOutput(CAmount nAmountOutput)
     LOCK(cs_outputs);
     if (CouldAddOutput(nAmountOutput)) {
         vecOutputs.push_back(std::make_unique<CTransactionBuilderOutput>(this, pwallet, nAmountOutput));
+        nAmountUsed += nAmountOutput;
         return vecOutputs.back().get();
     }
     return nullptr;
 }
 
+bool CTransactionBuilder::AddOutputs(const std::vector<CAmount>& vecOutputAmounts)
+{
+    LOCK(cs_outputs);
+    if (!CouldAddOutputs(vecOutputAmounts)) {
+        return false;
+    }
+    vecOutputs.reserve(vecOutputs.size() + vecOutputAmounts.size());
+    for (const auto nAmountOutput : vecOutputAmounts) {
+        vecOutputs.push_back(std::make_unique<CTransactionBuilderOutput>(this, pwallet, nAmountOutput));
+        nAmountUsed += nAmountOutput;
+    }
+    return true;
+}
+
 unsigned int CTransactionBuilder::GetBytesTotal() const
 {
     // Adding other outputs can change the serialized size of the vout size hence + GetSizeOfCompactSizeDiff()
@@ -226,15 +250,6 @@ CAmount CTransactionBuilder::GetAmountLeft(const CAmount nAmountInitial, const C
     return nAmountInitial - nAmountUsed - nFee;
 }
 
-CAmount CTransactionBuilder::GetAmountUsed() const
-{
-    CAmount nAmountUsed{0};
-    for (const auto& out : vecOutputs) {
-        nAmountUsed += out->GetAmount();
-    }
-    return nAmountUsed;
-}
-
 CAmount CTransactionBuilder::GetFee(unsigned int nBytes) const
 {
     CAmount nFeeCalc = coinControl.m_feerate->GetFee(nBytes);
@@ -339,3 +354,52 @@ std::string CTransactionBuilder::ToString() const
         coinControl.m_discard_feerate->GetFeePerK(),
         GetFee(GetBytesTotal()));
 }
+
+bool CTransactionBuilderPlan::CouldAddOutput(CAmount nAmountOutput) const
+{
+    if (nAmountOutput < 0) {
+        return false;
+    }
+    return txBuilder.CouldAddOutputs(vecAmounts.size() + 1, nAmountPlanned + nAmountOutput);
+}
+
+bool CTransactionBuilderPlan::AddOutput(CAmount nAmountOutput)
+{
+    if (!CouldAddOutput(nAmountOutput)) {
+        return false;
+    }
+    vecAmounts.push_back(nAmountOutput);
+    nAmountPlanned += nAmountOutput;
+    return true;
+}
+
+bool CTransactionBuilderPlan::UpdateAmount(size_t nIndex, CAmount nNewAmount)
+{
+    if (nIndex >= vecAmounts.size() || nNewAmount <= 0 || nNewAmount - vecAmounts[nIndex] > GetAmountLeft()) {
+        return false;
+    }
+    nAmountPlanned += nNewAmount - vecAmounts[nIndex];
+    vecAmounts[nIndex] = nNewAmount;
+    return true;
+}
+
+int CTransactionBuilderPlan::CountPossibleOutputs(CAmount nAmountOutput, int nMaxOutputs) const
+{
+    if (nAmountOutput < 0) {
+        return 0;
+    }
+    int nOutputs = 0;
+    while (nOutputs < nMaxOutputs && txBuilder.CouldAddOutputs(vecAmounts.size() + nOutputs + 1, nAmountPlanned + nAmountOutput * (nOutputs + 1))) {
+        ++nOutputs;
+    }
+    return nOutputs;
+}
+
+std::string CTransactionBuilderPlan::ToString() const
+{
+    return strprintf("CTransactionBuilderPlan(Amount planned: %d, Amount left: %d, Outputs planned: %d, Outputs total: %d)",
+        nAmountPlanned,
+        GetAmountLeft(),
+        vecAmounts.size(),
+        CountOutputs());
+}
@@ -95,6 +95,8 @@ class CTransactionBuilder
     mutable CCriticalSection cs_outputs;
     /// Contains all outputs already added to the transaction
     std::vector<std::unique_ptr<CTransactionBuilderOutput>> vecOutputs;
+    /// Sum of the amounts of vecOutputs, kept up to date to not iterate vecOutputs for every fee calculation
+    CAmount nAmountUsed{0};
     /// Needed by CTransactionBuilderOutput::UpdateAmount to lock cs_outputs
     friend class CTransactionBuilderOutput;
 
@@ -105,12 +107,18 @@ public:
     bool CouldAddOutput(CAmount nAmountOutput) const;
     /// Check if its possible to add multiple outputs as vector of amounts. Returns true if its possible to add all of them and false if not.
     bool CouldAddOutputs(const std::vector<CAmount>& vecOutputAmounts) const;
+    /// Check if its possible to add nOutputs more outputs with a total amount of nAmountOutputs. Returns true if its possible and false if not.
+    bool CouldAddOutputs(size_t nOutputs, CAmount nAmountOutputs) const;
     /// Add an output with the amount nAmount. Returns a pointer to the output if it could be added and nullptr if not due to insufficient amount left.
     CTransactionBuilderOutput* AddOutput(CAmount nAmountOutput = 0);
+    /// Add all outputs of vecOutputAmounts at once. Returns false and adds none of them if they don't fit all together.
+    bool AddOutputs(const std::vector<CAmount>& vecOutputAmounts);
     /// Get amount we had available when we started
     CAmount GetAmountInitial() const { return tallyItem.nAmount; }
     /// Get the amount currently left to add more outputs. Does respect fees.
     CAmount GetAmountLeft() const { return GetAmountInitial() - GetAmountUsed() - GetFee(GetBytesTotal()); }
+    /// Get the amount which would be left after adding nOutputs more outputs with a total amount of nAmountOutputs. Does respect fees.
+    CAmount GetAmountLeft(size_t nOutputs, CAmount nAmountOutputs) const;
     /// Check if an amounts should be considered as dust
     bool IsDust(CAmount nAmount) const;
     /// Get the total number of added outputs
@@ -128,7 +136,7 @@ private:
     /// Helper to calculate static amount left by simply subtracting an used amount and a fee from a provided initial amount.
     static CAmount GetAmountLeft(CAmount nAmountInitial, CAmount nAmountUsed, CAmount nFee);
     /// Get the amount currently used by added outputs. Does not include fees.
-    CAmount GetAmountUsed() const;
+    CAmount GetAmountUsed() const { return nAmountUsed; }
     /// Get fees based on the number of bytes and the feerate set in CoinControl.
     /// NOTE: To get the total transaction fee this should only be called once with the total number of bytes for the transaction to avoid
     /// calling CFeeRate::GetFee multiple times with subtotals as this may add rounding errors with each further call.
@@ -137,4 +145,39 @@ private:
     int GetSizeOfCompactSizeDiff(size_t nAdd) const;
 };
 
+/**
+ * @brief Plans the outputs of a CTransactionBuilder before any of them is added. Planned outputs are plain
+ * amounts, no keys are reserved for them and the fee checks only use the number of planned outputs and their
+ * total amount together with the sizes the CTransactionBuilder estimated once on construction. Once the plan is
+ * complete all outputs can be added in one go with CTransactionBuilder::AddOutputs(GetAmounts()).
+ */
+class CTransactionBuilderPlan
+{
+    /// Builder the outputs are planned for, its outputs are taken into account for all checks
+    const CTransactionBuilder& txBuilder;
+    /// Amounts of the planned outputs
+    std::vector<CAmount> vecAmounts;
+    /// Sum of vecAmounts
+    CAmount nAmountPlanned{0};
+
+public:
+    explicit CTransactionBuilderPlan(const CTransactionBuilder& txBuilderIn) : txBuilder(txBuilderIn) {}
+    /// Check it would be possible to plan another output with the amount nAmountOutput
+    bool CouldAddOutput(CAmount nAmountOutput) const;
+    /// Plan an output with the amount nAmountOutput. Returns false if there is not enough amount left for it.
+    bool AddOutput(CAmount nAmountOutput = 0);
+    /// Try update the amount of the planned output at nIndex. Returns false if nIndex is invalid or there is not enough amount left.
+    bool UpdateAmount(size_t nIndex, CAmount nNewAmount);
+    /// Count how many more outputs with the amount nAmountOutput could be planned, at most nMaxOutputs
+    int CountPossibleOutputs(CAmount nAmountOutput, int nMaxOutputs) const;
+    /// Get the amount left after all planned outputs. Does respect fees.
+    CAmount GetAmountLeft() const { return txBuilder.GetAmountLeft(vecAmounts.size(), nAmountPlanned); }
+    /// Get the total number of outputs, including the ones already added to the builder
+    int CountOutputs() const { return txBuilder.CountOutputs() + (int)vecAmounts.size(); }
+    /// Get the amounts of the planned outputs
+    const std::vector<CAmount>& GetAmounts() const { return vecAmounts; }
+    /// Convert to a string
+    std::string ToString() const;
+};
+
 #endif // BITCOIN_COINJOIN_COINJOIN_UTIL_H
@@ -70,10 +70,11 @@ bool CCoinJoinQueue::CheckSignature(const CBLSPublicKey& blsPubKey) const
 
 bool CCoinJoinQueue::Relay(CConnman& connman)
 {
-    connman.ForEachNode([&connman, this](CNode* pnode) {
-        CNetMsgMaker msgMaker(pnode->GetSendVersion());
+    // the serialization of a dsq does not depend on the peer version, serialize it only once
+    auto msg = CConnman::MakeSharedMessage(CNetMsgMaker(PROTOCOL_VERSION).Make(NetMsgType::DSQUEUE, (*this)));
+    connman.ForEachNode([&connman, &msg](CNode* pnode) {
         if (pnode->nVersion >= MIN_COINJOIN_PEER_PROTO_VERSION && pnode->fSendDSQueue) {
-            connman.PushMessage(pnode, msgMaker.Make(NetMsgType::DSQUEUE, (*this)));
+            connman.PushMessage(pnode, msg);
         }
     });
     return true;
@@ -162,6 +163,7 @@ void CCoinJoinBaseManager::SetNull()
 {
     LOCK(cs_vecqueue);
     vecCoinJoinQueue.clear();
+    mapCoinJoinQueueIndex.clear();
 }
 
 void CCoinJoinBaseManager::CheckQueue()
@@ -174,6 +176,7 @@ void CCoinJoinBaseManager::CheckQueue()
     while (it != vecCoinJoinQueue.end()) {
         if ((*it).IsTimeOutOfBounds()) {
             LogPrint(BCLog::COINJOIN, "CCoinJoinBaseManager::%s -- Removing a queue (%s)\n", __func__, (*it).ToString());
+            mapCoinJoinQueueIndex.erase(std::make_tuple(it->masternodeOutpoint, it->nDenom, it->fReady));
             it = vecCoinJoinQueue.erase(it);
         } else {
             ++it;
@@ -181,6 +184,35 @@ void CCoinJoinBaseManager::CheckQueue()
     }
 }
 
+void CCoinJoinBaseManager::AddQueue(const CCoinJoinQueue& dsq)
+{
+    AssertLockHeld(cs_vecqueue);
+
+    auto it = vecCoinJoinQueue.insert(vecCoinJoinQueue.end(), dsq);
+    mapCoinJoinQueueIndex.emplace(std::make_tuple(dsq.masternodeOutpoint, dsq.nDenom, dsq.fReady), it);
+}
+
+const CCoinJoinQueue* CCoinJoinBaseManager::GetQueue(const COutPoint& masternodeOutpoint, int nDenom, bool fReady) const
+{
+    AssertLockHeld(cs_vecqueue);
+
+    auto it = mapCoinJoinQueueIndex.find(std::make_tuple(masternodeOutpoint, nDenom, fReady));
+    return it == mapCoinJoinQueueIndex.end() ? nullptr : &*it->second;
+}
+
+void CCoinJoinBaseManager::RemoveQueues(const COutPoint& masternodeOutpoint, int nDenom)
+{
+    AssertLockHeld(cs_vecqueue);
+
+    for (bool fReady : {false, true}) {
+        auto it = mapCoinJoinQueueIndex.find(std::make_tuple(masternodeOutpoint, nDenom, fReady));
+        if (it != mapCoinJoinQueueIndex.end()) {
+            vecCoinJoinQueue.erase(it->second);
+            mapCoinJoinQueueIndex.erase(it);
+        }
+    }
+}
+
 bool CCoinJoinBaseManager::GetQueueItemAndTry(CCoinJoinQueue& dsqRet)
 {
     TRY_LOCK(cs_vecqueue, lockDS);
@@ -305,6 +337,9 @@ bool CCoinJoinBaseSession::IsValidInOuts(const std::vector<CTxIn>& vin, const st
 std::vector<CAmount> CCoinJoin::vecStandardDenominations;
 std::map<uint256, CCoinJoinBroadcastTx> CCoinJoin::mapDSTX;
 CCriticalSection CCoinJoin::cs_mapdstx;
+std::map<uint256, bool> CCoinJoin::mapCollateralValidity;
+std::map<COutPoint, uint256> CCoinJoin::mapCollateralInputs;
+CCriticalSection CCoinJoin::cs_mapcollateral;
 
 void CCoinJoin::InitStandardDenominations()
 {
@@ -330,6 +365,37 @@ void CCoinJoin::InitStandardDenominations()
 
 // check to make sure the collateral provided by the client is valid
 bool CCoinJoin::IsCollateralValid(const CTransaction& txCollateral)
+{
+    const uint256 hashTx = txCollateral.GetHash();
+    {
+        LOCK(cs_mapcollateral);
+        auto it = mapCollateralValidity.find(hashTx);
+        if (it != mapCollateralValidity.end()) {
+            LogPrint(BCLog::COINJOIN, "CCoinJoin::IsCollateralValid -- cached result %d for %s\n", it->second, hashTx.ToString());
+            return it->second;
+        }
+    }
+
+    bool fValid = CheckCollateral(txCollateral);
+
+    LOCK(cs_mapcollateral);
+    mapCollateralValidity.emplace(hashTx, fValid);
+    if (fValid) {
+        for (const auto& txin : txCollateral.vin) {
+            mapCollateralInputs.emplace(txin.prevout, hashTx);
+        }
+    }
+    return fValid;
+}
+
+void CCoinJoin::ClearCollateralValidity()
+{
+    LOCK(cs_mapcollateral);
+    mapCollateralValidity.clear();
+    mapCollateralInputs.clear();
+}
+
+bool CCoinJoin::CheckCollateral(const CTransaction& txCollateral)
 {
     if (txCollateral.vout.empty()) return false;
     if (txCollateral.nLockTime != 0) return false;
@@ -577,12 +643,26 @@ void CCoinJoin::UpdateDSTXConfirmedHeight(const CTransactionRef& tx, int nHeight
 
 void CCoinJoin::TransactionAddedToMempool(const CTransactionRef& tx)
 {
-    LOCK(cs_mapdstx);
-    UpdateDSTXConfirmedHeight(tx, -1);
+    {
+        LOCK(cs_mapdstx);
+        UpdateDSTXConfirmedHeight(tx, -1);
+    }
+
+    // a collateral (or a tx spending its inputs) made it into the mempool, it won't pass a test acceptance anymore
+    LOCK(cs_mapcollateral);
+    for (const auto& txin : tx->vin) {
+        auto it = mapCollateralInputs.find(txin.prevout);
+        if (it != mapCollateralInputs.end()) {
+            mapCollateralValidity.erase(it->second);
+            mapCollateralInputs.erase(it);
+        }
+    }
 }
 
 void CCoinJoin::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindex, const std::vector<CTransactionRef>& vtxConflicted)
 {
+    ClearCollateralValidity();
+
     LOCK(cs_mapdstx);
     for (const auto& tx : vtxConflicted) {
         UpdateDSTXConfirmedHeight(tx, -1);
@@ -595,6 +675,8 @@ void CCoinJoin::BlockConnected(const std::shared_ptr<const CBlock>& pblock, cons
 
 void CCoinJoin::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexDisconnected)
 {
+    ClearCollateralValidity();
+
     LOCK(cs_mapdstx);
     for (const auto& tx : pblock->vtx) {
         UpdateDSTXConfirmedHeight(tx, -1);
@@ -15,12 +15,18 @@
 #include <timedata.h>
 #include <tinyformat.h>
 
+#include <list>
+#include <map>
+#include <tuple>
+
 class CCoinJoin;
 class CConnman;
 
 // timeouts
 static const int COINJOIN_AUTO_TIMEOUT_MIN = 5;
 static const int COINJOIN_AUTO_TIMEOUT_MAX = 15;
+// clients run automatic denomination at least this often even if no event woke them up
+static const int COINJOIN_AUTO_TIMEOUT_IDLE = 60;
 static const int COINJOIN_QUEUE_TIMEOUT = 30;
 static const int COINJOIN_SIGNING_TIMEOUT = 15;
 
@@ -388,6 +394,7 @@ public:
     }
 
     int GetState() const { return nState; }
+    int GetSessionID() const { return nSessionID; }
     std::string GetStateString() const;
 
     int GetEntriesCount() const { return vecEntries.size(); }
@@ -399,12 +406,21 @@ class CCoinJoinBaseManager
 protected:
     mutable CCriticalSection cs_vecqueue;
 
-    // The current mixing sessions in progress on the network
-    std::vector<CCoinJoinQueue> vecCoinJoinQueue;
+    // The current mixing sessions in progress on the network, in the order they were received
+    std::list<CCoinJoinQueue> vecCoinJoinQueue;
+    // vecCoinJoinQueue indexed by masternode collateral, denomination and readiness, there is at most one queue for each of them
+    std::map<std::tuple<COutPoint, int, bool>, std::list<CCoinJoinQueue>::iterator> mapCoinJoinQueueIndex;
 
     void SetNull();
     void CheckQueue();
 
+    /// Add a queue, must not be called if a queue with the same masternode, denomination and readiness is known already
+    void AddQueue(const CCoinJoinQueue& dsq) EXCLUSIVE_LOCKS_REQUIRED(cs_vecqueue);
+    /// Get the queue of a masternode with the given denomination and readiness, nullptr if there is none
+    const CCoinJoinQueue* GetQueue(const COutPoint& masternodeOutpoint, int nDenom, bool fReady) const EXCLUSIVE_LOCKS_REQUIRED(cs_vecqueue);
+    /// Remove all queues of a masternode for the given denomination
+    void RemoveQueues(const COutPoint& masternodeOutpoint, int nDenom) EXCLUSIVE_LOCKS_REQUIRED(cs_vecqueue);
+
 public:
     CCoinJoinBaseManager() :
         vecCoinJoinQueue() {}
@@ -429,7 +445,15 @@ private:
 
     static CCriticalSection cs_mapdstx;
 
+    // Results of IsCollateralValid by txid, valid until the next block. mapCollateralInputs maps the inputs of
+    // valid collaterals to their txid, so that results can be dropped when a mempool tx spends one of them.
+    static std::map<uint256, bool> mapCollateralValidity;
+    static std::map<COutPoint, uint256> mapCollateralInputs;
+    static CCriticalSection cs_mapcollateral;
+
     static void CheckDSTXes(const CBlockIndex* pindex);
+    static bool CheckCollateral(const CTransaction& txCollateral);
+    static void ClearCollateralValidity();
 
 public:
     static void InitStandardDenominations();
@@ -7,6 +7,8 @@
 #include <consensus/consensus.h>
 #include <random.h>
 
+#include <map>
+
 bool CCoinsView::GetCoin(const COutPoint &outpoint, Coin &coin) const { return false; }
 uint256 CCoinsView::GetBestBlock() const { return uint256(); }
 std::vector<uint256> CCoinsView::GetHeadBlocks() const { return std::vector<uint256>(); }
@@ -39,12 +41,15 @@ size_t CCoinsViewCache::DynamicMemoryUsage() const {
 
 CCoinsMap::iterator CCoinsViewCache::FetchCoin(const COutPoint &outpoint) const {
     CCoinsMap::iterator it = cacheCoins.find(outpoint);
-    if (it != cacheCoins.end())
+    if (it != cacheCoins.end()) {
+        it->second.nLastAccess = nAccessEpoch;
         return it;
+    }
     Coin tmp;
     if (!base->GetCoin(outpoint, tmp))
         return cacheCoins.end();
     CCoinsMap::iterator ret = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::forward_as_tuple(std::move(tmp))).first;
+    ret->second.nLastAccess = nAccessEpoch;
     if (ret->second.coin.IsSpent()) {
         // The parent only has an empty entry for this outpoint; we can consider our
         // version as fresh.
@@ -81,6 +86,7 @@ void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin&& coin, bool possi
     }
     it->second.coin = std::move(coin);
     it->second.flags |= CCoinsCacheEntry::DIRTY | (fresh ? CCoinsCacheEntry::FRESH : 0);
+    it->second.nLastAccess = nAccessEpoch;
     cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
 }
 
@@ -127,6 +133,17 @@ bool CCoinsViewCache::HaveCoin(const COutPoint &outpoint) const {
     return (it != cacheCoins.end() && !it->second.coin.IsSpent());
 }
 
+void CCoinsViewCache::AddFetchedCoin(const COutPoint &outpoint, Coin&& coin) {
+    if (coin.IsSpent()) {
+        return;
+    }
+    auto ret = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::forward_as_tuple(std::move(coin)));
+    if (ret.second) {
+        ret.first->second.nLastAccess = nAccessEpoch;
+        cachedCoinsUsage += ret.first->second.coin.DynamicMemoryUsage();
+    }
+}
+
 bool CCoinsViewCache::HaveCoinInCache(const COutPoint &outpoint) const {
     CCoinsMap::const_iterator it = cacheCoins.find(outpoint);
     return (it != cacheCoins.end() && !it->second.coin.IsSpent());
@@ -143,6 +160,7 @@ void CCoinsViewCache::SetBestBlock(const uint256 &hashBlockIn) {
 }
 
 bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn) {
+    nAccessEpoch++;
     for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end(); it = mapCoins.erase(it)) {
         // Ignore non-dirty entries (optimization).
         if (!(it->second.flags & CCoinsCacheEntry::DIRTY)) {
@@ -159,6 +177,7 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn
                 entry.coin = std::move(it->second.coin);
                 cachedCoinsUsage += entry.coin.DynamicMemoryUsage();
                 entry.flags = CCoinsCacheEntry::DIRTY;
+                entry.nLastAccess = nAccessEpoch;
                 // We can mark it FRESH in the parent if it was FRESH in the child
                 // Otherwise it might have just been flushed from the parent's cache
                 // and already exist in the grandparent
@@ -188,6 +207,7 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn
                 itUs->second.coin = std::move(it->second.coin);
                 cachedCoinsUsage += itUs->second.coin.DynamicMemoryUsage();
                 itUs->second.flags |= CCoinsCacheEntry::DIRTY;
+                itUs->second.nLastAccess = nAccessEpoch;
                 // NOTE: It is possible the child has a FRESH flag here in
                 // the event the entry we found in the parent is pruned. But
                 // we must not copy that FRESH flag to the parent as that
@@ -202,11 +222,67 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn
 
 bool CCoinsViewCache::Flush() {
     bool fOk = base->BatchWrite(cacheCoins, hashBlock);
-    cacheCoins.clear();
+    // frees the pool of the flushed map at once, instead of keeping its chunks around
+    CCoinsMap().swap(cacheCoins);
     cachedCoinsUsage = 0;
     return fOk;
 }
 
+bool CCoinsViewCache::FlushAndTrim(size_t nMaxUsageAfter) {
+    // Find the oldest access epoch to keep, so that the entries of the newer epochs fit into nMaxUsageAfter. The
+    // bucket array of the current map is an upper bound for the one of the kept entries.
+    const size_t nNodeUsage = memusage::MallocUsage(sizeof(memusage::unordered_node<CCoinsMap::value_type>));
+    const size_t nBucketsUsage = memusage::MallocUsage(sizeof(void*) * cacheCoins.bucket_count());
+    // usage and count of the entries by access epoch
+    std::map<uint32_t, std::pair<size_t, size_t>> mapEpochUsage;
+    for (const auto& p : cacheCoins) {
+        if (!p.second.coin.IsSpent()) {
+            auto& usage = mapEpochUsage[p.second.nLastAccess];
+            usage.first += nNodeUsage + p.second.coin.DynamicMemoryUsage();
+            usage.second++;
+        }
+    }
+    size_t nKeptUsage = nBucketsUsage;
+    size_t nKeptCount = 0;
+    uint32_t nKeepEpoch = std::numeric_limits<uint32_t>::max();
+    for (auto it = mapEpochUsage.rbegin(); it != mapEpochUsage.rend() && nKeptUsage + it->second.first <= nMaxUsageAfter; ++it) {
+        nKeptUsage += it->second.first;
+        nKeptCount += it->second.second;
+        nKeepEpoch = it->first;
+    }
+
+    // The kept entries are moved to a new map, so that the pool of the old one, which still has the nodes of all
+    // entries, is freed at once. Dirty entries which are kept are copied for the base, all others are moved or dropped.
+    CCoinsMap mapKeep;
+    mapKeep.reserve(nKeptCount);
+    mapKeep.get_allocator().GetPool().Reserve(nKeptCount);
+    CCoinsMap mapWrite;
+    for (auto& p : cacheCoins) {
+        const bool fKeep = !p.second.coin.IsSpent() && p.second.nLastAccess >= nKeepEpoch;
+        if (!fKeep) {
+            cachedCoinsUsage -= p.second.coin.DynamicMemoryUsage();
+        }
+        if (p.second.flags & CCoinsCacheEntry::DIRTY) {
+            CCoinsCacheEntry& entry = mapWrite[p.first];
+            entry.flags = p.second.flags;
+            if (fKeep) {
+                entry.coin = p.second.coin;
+            } else {
+                entry.coin = std::move(p.second.coin);
+            }
+        }
+        if (fKeep) {
+            // the base has the same coin once it's written
+            CCoinsCacheEntry& entry = mapKeep.emplace(p.first, std::move(p.second)).first->second;
+            entry.flags = 0;
+        }
+    }
+    cacheCoins.swap(mapKeep);
+    // frees the old pool before the base allocates its copies
+    mapKeep = CCoinsMap();
+    return base->BatchWrite(mapWrite, hashBlock);
+}
+
 void CCoinsViewCache::Uncache(const COutPoint& hash)
 {
     CCoinsMap::iterator it = cacheCoins.find(hash);
@@ -12,6 +12,7 @@
 #include <hash.h>
 #include <memusage.h>
 #include <serialize.h>
+#include <support/allocators/pool.h>
 #include <uint256.h>
 
 #include <assert.h>
@@ -84,8 +85,8 @@ public:
 class SaltedOutpointHasher
 {
 private:
-    /** Salt */
-    const uint64_t k0, k1;
+    /** Salt, not const so that maps can be swapped */
+    uint64_t k0, k1;
 
 public:
     SaltedOutpointHasher();
@@ -104,6 +105,7 @@ struct CCoinsCacheEntry
 {
     Coin coin; // The actual cached data.
     unsigned char flags;
+    uint32_t nLastAccess{0}; // Access epoch of the owning cache when the entry was last used, see FlushAndTrim.
 
     enum Flags {
         DIRTY = (1 << 0), // This cache entry is potentially different from the version in the parent view.
@@ -119,7 +121,11 @@ struct CCoinsCacheEntry
     explicit CCoinsCacheEntry(Coin&& coin_) : coin(std::move(coin_)), flags(0) {}
 };
 
-typedef std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> CCoinsMap;
+/**
+ * The nodes of a map are taken from its own pool, which is freed when the map is destroyed. Maps are handed over to
+ * other threads or views with swap(), see node_pool_allocator.
+ */
+typedef std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher, std::equal_to<COutPoint>, node_pool_allocator<std::pair<const COutPoint, CCoinsCacheEntry>>> CCoinsMap;
 
 /** Cursor for iterating over CoinsView state */
 class CCoinsViewCursor
@@ -211,6 +217,9 @@ protected:
     /* Cached dynamic memory usage for the inner Coin objects. */
     mutable size_t cachedCoinsUsage;
 
+    /* Incremented with every BatchWrite into this cache, i.e. with every block when this is the tip cache. */
+    uint32_t nAccessEpoch{0};
+
 public:
     CCoinsViewCache(CCoinsView *baseIn);
 
@@ -236,6 +245,13 @@ public:
      */
     bool HaveCoinInCache(const COutPoint &outpoint) const;
 
+    /**
+     * Add a coin which someone else read from the backing view on our behalf, e.g. when prefetching coins in
+     * parallel. It must be what GetCoin() on the backing view returns for outpoint. Does nothing if the outpoint
+     * is cached already.
+     */
+    void AddFetchedCoin(const COutPoint &outpoint, Coin&& coin);
+
     /**
      * Return a reference to Coin in the cache, or a pruned one if not found. This is
      * more efficient than GetCoin.
@@ -268,6 +284,13 @@ public:
      */
     bool Flush();
 
+    /**
+     * Like Flush(), but keeps the most recently used unspent entries in the cache, as clean entries, so that the
+     * cache isn't cold after every flush. Entries are evicted by their access epoch until the memory usage
+     * is at most nMaxUsageAfter.
+     */
+    bool FlushAndTrim(size_t nMaxUsageAfter);
+
     /**
      * Removes the UTXO with the given outpoint from the cache, if it is
      * not modified.
@@ -0,0 +1,152 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <coinsprefetch.h>
+
+#include <memusage.h>
+#include <util.h>
+
+#include <set>
+
+CCoinsPrefetcher coinsPrefetcher;
+
+size_t CCoinsPrefetcher::DynamicMemoryUsage() const
+{
+    AssertLockHeld(cs);
+    return memusage::DynamicUsage(mapStaged) + nCoinsUsage;
+}
+
+void CCoinsPrefetcher::Start(CCoinsView* db, int nThreads)
+{
+    assert(!fRunning);
+    if (nThreads <= 0) {
+        return;
+    }
+    pdb = db;
+    pool.resize(nThreads);
+    RenameThreadPool(pool, "dash-prefetch");
+    fRunning = true;
+}
+
+void CCoinsPrefetcher::Stop()
+{
+    if (!fRunning) {
+        return;
+    }
+    fRunning = false;
+    // wait for the reads in progress, queued ones are dropped
+    pool.clear_queue();
+    pool.stop(true);
+    pdb = nullptr;
+    Invalidate();
+}
+
+void CCoinsPrefetcher::ReadCoins(const std::vector<COutPoint>& vOutPoints, uint64_t nGenerationStart)
+{
+    std::vector<std::pair<COutPoint, Coin>> vRead;
+    vRead.reserve(vOutPoints.size());
+    try {
+        for (const auto& outpoint : vOutPoints) {
+            if (!fRunning) {
+                return;
+            }
+            Coin coin;
+            if (pdb->GetCoin(outpoint, coin) && !coin.IsSpent()) {
+                vRead.emplace_back(outpoint, std::move(coin));
+            }
+        }
+    } catch (const std::runtime_error& e) {
+        // ConnectBlock will run into the same error and handle it
+        LogPrint(BCLog::BENCHMARK, "CCoinsPrefetcher::%s -- failed to read coins: %s\n", __func__, e.what());
+        return;
+    }
+
+    LOCK(cs);
+    if (nGeneration != nGenerationStart) {
+        // the database was written in the meantime, what we read might be outdated
+        nDropped += vRead.size();
+        return;
+    }
+    for (auto& p : vRead) {
+        if (DynamicMemoryUsage() >= MAX_COINS_PREFETCH_USAGE) {
+            nDropped++;
+            continue;
+        }
+        size_t nUsage = p.second.DynamicMemoryUsage();
+        if (mapStaged.emplace(p.first, std::move(p.second)).second) {
+            nCoinsUsage += nUsage;
+            nStaged++;
+        }
+    }
+}
+
+void CCoinsPrefetcher::PrefetchBlock(const CBlock& block, const CCoinsViewCache& tip)
+{
+    if (!fRunning) {
+        return;
+    }
+
+    std::set<uint256> setBlockTxids;
+    for (const auto& tx : block.vtx) {
+        setBlockTxids.emplace(tx->GetHash());
+    }
+    std::vector<COutPoint> vOutPoints;
+    uint64_t nGenerationStart;
+    {
+        LOCK(cs);
+        nGenerationStart = nGeneration;
+        if (DynamicMemoryUsage() >= MAX_COINS_PREFETCH_USAGE) {
+            return;
+        }
+        for (size_t i = 1; i < block.vtx.size(); i++) {
+            for (const auto& txin : block.vtx[i]->vin) {
+                if (!setBlockTxids.count(txin.prevout.hash) && !mapStaged.count(txin.prevout) && !tip.HaveCoinInCache(txin.prevout)) {
+                    vOutPoints.emplace_back(txin.prevout);
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < vOutPoints.size(); i += BATCH_SIZE) {
+        auto vBatch = std::make_shared<std::vector<COutPoint>>(vOutPoints.begin() + i, vOutPoints.begin() + std::min(i + BATCH_SIZE, vOutPoints.size()));
+        pool.push([this, vBatch, nGenerationStart](int threadId) {
+            ReadCoins(*vBatch, nGenerationStart);
+        });
+    }
+}
+
+bool CCoinsPrefetcher::TakeCoin(const COutPoint& outpoint, Coin& coinRet)
+{
+    LOCK(cs);
+    auto it = mapStaged.find(outpoint);
+    if (it == mapStaged.end()) {
+        return false;
+    }
+    nCoinsUsage -= it->second.DynamicMemoryUsage();
+    coinRet = std::move(it->second);
+    mapStaged.erase(it);
+    nUsed++;
+    return true;
+}
+
+void CCoinsPrefetcher::Invalidate()
+{
+    LOCK(cs);
+    nGeneration++;
+    nDropped += mapStaged.size();
+    mapStaged.clear();
+    nCoinsUsage = 0;
+}
+
+CCoinsPrefetcher::Stats CCoinsPrefetcher::GetStats() const
+{
+    LOCK(cs);
+    Stats stats;
+    stats.nCount = mapStaged.size();
+    stats.nUsage = DynamicMemoryUsage();
+    stats.nStaged = nStaged;
+    stats.nUsed = nUsed;
+    stats.nDropped = nDropped;
+    return stats;
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_COINSPREFETCH_H
+#define BITCOIN_COINSPREFETCH_H
+
+#include <coins.h>
+#include <primitives/block.h>
+#include <sync.h>
+
+#include <ctpl.h>
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/** Default for -coinsprefetchthreads, the number of threads reading inputs of blocks which are not connected yet */
+static const int DEFAULT_COINS_PREFETCH_THREADS = 4;
+/** Maximum number of coins prefetch threads */
+static const int MAX_COINS_PREFETCH_THREADS = 32;
+/** Maximum memory used by prefetched coins which are waiting for their block to be connected */
+static const size_t MAX_COINS_PREFETCH_USAGE = 64 * 1024 * 1024;
+
+/**
+ * Reads the inputs of blocks which were received but not connected yet from the coins database, on a few threads and
+ * without holding cs_main, so that ConnectBlock mostly finds them in memory. This is mostly useful during IBD with a
+ * cold cache, where ConnectBlock would otherwise read one coin after another.
+ *
+ * The coins are only staged here, ConnectBlock moves them into pcoinsTip, but only for outpoints pcoinsTip doesn't
+ * cache already. A staged coin is therefore only used if it's what pcoinsTip would read from the database itself.
+ * As that's no longer true once pcoinsTip writes to the database, Invalidate() must be called before and after that,
+ * which drops all staged coins and the results of reads which were in progress in the meantime.
+ */
+class CCoinsPrefetcher
+{
+public:
+    struct Stats {
+        size_t nCount{0};
+        size_t nUsage{0};
+        uint64_t nStaged{0};
+        uint64_t nUsed{0};
+        uint64_t nDropped{0};
+    };
+
+private:
+    //! outpoints read by one task
+    static const size_t BATCH_SIZE = 128;
+
+    mutable CCriticalSection cs;
+    std::unordered_map<COutPoint, Coin, SaltedOutpointHasher> mapStaged GUARDED_BY(cs);
+    size_t nCoinsUsage GUARDED_BY(cs){0};
+    //! incremented by Invalidate(), reads which started before are dropped
+    uint64_t nGeneration GUARDED_BY(cs){0};
+    uint64_t nStaged GUARDED_BY(cs){0};
+    uint64_t nUsed GUARDED_BY(cs){0};
+    uint64_t nDropped GUARDED_BY(cs){0};
+
+    ctpl::thread_pool pool;
+    CCoinsView* pdb{nullptr};
+    std::atomic<bool> fRunning{false};
+
+    size_t DynamicMemoryUsage() const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void ReadCoins(const std::vector<COutPoint>& vOutPoints, uint64_t nGenerationStart);
+
+public:
+    /** Starts nThreads threads reading from db, which must stay valid until Stop() returned */
+    void Start(CCoinsView* db, int nThreads);
+    void Stop();
+
+    /** Queues reads of the inputs of block which aren't created in the block and aren't cached in tip, the caller must hold the lock protecting tip */
+    void PrefetchBlock(const CBlock& block, const CCoinsViewCache& tip);
+    /** Moves a staged coin to coinRet, returns false if there's none for outpoint */
+    bool TakeCoin(const COutPoint& outpoint, Coin& coinRet);
+    /** Drops all staged coins and reads in progress, must be called before and after the database is written */
+    void Invalidate();
+
+    Stats GetStats() const;
+};
+
+extern CCoinsPrefetcher coinsPrefetcher;
+
+#endif // BITCOIN_COINSPREFETCH_H
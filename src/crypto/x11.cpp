@@ -0,0 +1,141 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/x11.h>
+
+#include <crypto/common.h>
+#include <crypto/sph_echo.h>
+#include <crypto/sph_shavite.h>
+
+#include <assert.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
+#if defined(USE_ASM)
+#include <cpuid.h>
+#endif
+#endif
+
+namespace x11_aesni
+{
+void Echo512_64(unsigned char* out, const unsigned char* in);
+void Shavite512_64(unsigned char* out, const unsigned char* in);
+void Shavite512_64_4way(unsigned char* out, const unsigned char* in);
+}
+
+namespace {
+
+void Echo512_64Generic(unsigned char* out, const unsigned char* in)
+{
+    sph_echo512_context ctx;
+    sph_echo512_init(&ctx);
+    sph_echo512(&ctx, in, 64);
+    sph_echo512_close(&ctx, out);
+}
+
+void Shavite512_64Generic(unsigned char* out, const unsigned char* in)
+{
+    sph_shavite512_context ctx;
+    sph_shavite512_init(&ctx);
+    sph_shavite512(&ctx, in, 64);
+    sph_shavite512_close(&ctx, out);
+}
+
+typedef void (*Hash64Fn)(unsigned char*, const unsigned char*);
+
+Hash64Fn Echo512_64 = Echo512_64Generic;
+Hash64Fn Shavite512_64 = Shavite512_64Generic;
+Hash64Fn Shavite512_64_4way = nullptr;
+
+/** Compare the selected implementations against the portable ones on a few inputs. */
+bool SelfTest()
+{
+    unsigned char in[64];
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 64; ++j) {
+            in[j] = (unsigned char)(i * 131 + j * 17 + (i == 7 ? 0xff : 0));
+        }
+        unsigned char out[64], expected[64];
+        Echo512_64Generic(expected, in);
+        Echo512_64(out, in);
+        if (memcmp(out, expected, 64) != 0) return false;
+        Shavite512_64Generic(expected, in);
+        Shavite512_64(out, in);
+        if (memcmp(out, expected, 64) != 0) return false;
+    }
+
+    if (Shavite512_64_4way) {
+        unsigned char in4[256], out4[256], expected4[256];
+        for (int i = 0; i < 256; ++i) {
+            in4[i] = (unsigned char)(i * 7 + 3);
+        }
+        for (int i = 0; i < 4; ++i) {
+            Shavite512_64Generic(expected4 + 64 * i, in4 + 64 * i);
+        }
+        Shavite512_64_4way(out4, in4);
+        if (memcmp(out4, expected4, 256) != 0) return false;
+    }
+    return true;
+}
+
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+void inline cpuid(uint32_t leaf, uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d)
+{
+    __cpuid(leaf, a, b, c, d);
+}
+#endif
+} // namespace
+
+void X11Echo512_64(unsigned char* out, const unsigned char* in)
+{
+    Echo512_64(out, in);
+}
+
+void X11Shavite512_64(unsigned char* out, const unsigned char* in)
+{
+    Shavite512_64(out, in);
+}
+
+void X11Shavite512_64Multi(unsigned char* out, const unsigned char* in, size_t blocks)
+{
+    if (Shavite512_64_4way) {
+        while (blocks >= 4) {
+            Shavite512_64_4way(out, in);
+            out += 256;
+            in += 256;
+            blocks -= 4;
+        }
+    }
+    while (blocks) {
+        Shavite512_64(out, in);
+        out += 64;
+        in += 64;
+        --blocks;
+    }
+}
+
+std::string X11AutoDetect()
+{
+    std::string ret = "standard";
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+    bool have_aesni = false;
+    (void)have_aesni;
+
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, eax, ebx, ecx, edx);
+    have_aesni = (ecx >> 25) & 1;
+
+#if defined(ENABLE_AESNI) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (have_aesni) {
+        Echo512_64 = x11_aesni::Echo512_64;
+        Shavite512_64 = x11_aesni::Shavite512_64;
+        Shavite512_64_4way = x11_aesni::Shavite512_64_4way;
+        ret = "aesni(echo,shavite,shavite-4way)";
+    }
+#endif
+#endif
+
+    assert(SelfTest());
+    return ret;
+}
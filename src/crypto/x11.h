@@ -0,0 +1,25 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_X11_H
+#define BITCOIN_CRYPTO_X11_H
+
+#include <stdlib.h>
+#include <string>
+
+/** Compute the 64 byte ECHO-512 hash of a 64 byte input, as done by the last X11 step. */
+void X11Echo512_64(unsigned char* out, const unsigned char* in);
+
+/** Compute the 64 byte SHAvite-3-512 hash of a 64 byte input, as done by the ninth X11 step. */
+void X11Shavite512_64(unsigned char* out, const unsigned char* in);
+
+/** Compute the SHAvite-3-512 hashes of blocks consecutive 64 byte inputs into blocks*64 bytes of output. */
+void X11Shavite512_64Multi(unsigned char* out, const unsigned char* in, size_t blocks);
+
+/** Autodetect the best available implementation of the X11 steps above.
+ *  Returns the name of the implementation.
+ */
+std::string X11AutoDetect();
+
+#endif // BITCOIN_CRYPTO_X11_H
@@ -0,0 +1,219 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// AES-NI implementations of the ECHO-512 and SHAvite-3-512 steps of X11.
+// Both are only ever fed the 64 byte output of the previous step, so the
+// padding is folded in and a single compression is performed. SHAvite's
+// message expansion is a serial chain of AES rounds, so a 4-way version
+// interleaves independent inputs for batches.
+
+#ifdef ENABLE_AESNI
+
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include <crypto/x11.h>
+
+namespace x11_aesni {
+namespace {
+
+/** ECHO-512 initial chaining value: the output length in bits, per 128 bit word. */
+const uint32_t ECHO512_SALT_LEN = 512;
+
+/** SHAvite-3-512 initial chaining value. */
+const uint32_t SHAVITE512_IV[16] = {
+    0x72FCCDD8, 0x79CA4727, 0x128A077B, 0x40D55AEC,
+    0xD1901A06, 0x430AE307, 0xB29F5CD1, 0xDF07FBFC,
+    0x8E45D73D, 0x681AB538, 0xBDE86578, 0xDD577E47,
+    0xE275EADE, 0x502D9FCD, 0xB9357178, 0x022A4B9A
+};
+
+__m128i inline Load(const unsigned char* p) { return _mm_loadu_si128((const __m128i*)p); }
+__m128i inline Load(const uint32_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+void inline Store(unsigned char* p, __m128i x) { _mm_storeu_si128((__m128i*)p, x); }
+void inline Store(uint32_t* p, __m128i x) { _mm_storeu_si128((__m128i*)p, x); }
+
+/** Multiply every byte by x in GF(2^8) with the AES polynomial. */
+__m128i inline Xtime(__m128i x)
+{
+    const __m128i high = _mm_cmplt_epi8(x, _mm_setzero_si128());
+    return _mm_xor_si128(_mm_add_epi8(x, x), _mm_and_si128(high, _mm_set1_epi8(0x1b)));
+}
+
+/** ECHO MixColumns on one column of four 128 bit words. */
+void inline __attribute__((always_inline)) MixColumn(__m128i& a, __m128i& b, __m128i& c, __m128i& d)
+{
+    const __m128i ab = _mm_xor_si128(a, b);
+    const __m128i bc = _mm_xor_si128(b, c);
+    const __m128i cd = _mm_xor_si128(c, d);
+    const __m128i abx = Xtime(ab);
+    const __m128i bcx = Xtime(bc);
+    const __m128i cdx = Xtime(cd);
+    const __m128i a0 = a;
+    const __m128i c0 = c;
+    a = _mm_xor_si128(abx, _mm_xor_si128(bc, d));
+    b = _mm_xor_si128(bcx, _mm_xor_si128(a0, cd));
+    c = _mm_xor_si128(cdx, _mm_xor_si128(ab, d));
+    d = _mm_xor_si128(_mm_xor_si128(abx, bcx), _mm_xor_si128(cdx, _mm_xor_si128(ab, c0)));
+}
+
+} // namespace
+
+void Echo512_64(unsigned char* out, const unsigned char* in)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i salt = _mm_set_epi32(0, 0, 0, ECHO512_SALT_LEN);
+
+    // The padded message block: the input, the 0x80 padding byte, the
+    // output length at byte 110 and the 512 bit message counter.
+    unsigned char block[128] = {0};
+    memcpy(block, in, 64);
+    block[64] = 0x80;
+    block[110] = 512 & 0xff;
+    block[111] = 512 >> 8;
+    block[112] = 512 & 0xff;
+    block[113] = 512 >> 8;
+
+    __m128i m[8];
+    __m128i w[16];
+    for (int i = 0; i < 8; ++i) {
+        m[i] = Load(block + 16 * i);
+        w[i] = salt;
+        w[i + 8] = m[i];
+    }
+
+    // The round counter starts at the message length and never carries
+    // out of the low word for a single 64 byte message.
+    uint32_t k = 512;
+    for (int r = 0; r < 10; ++r) {
+        for (int i = 0; i < 16; ++i) {
+            w[i] = _mm_aesenc_si128(w[i], _mm_cvtsi32_si128(k++));
+            w[i] = _mm_aesenc_si128(w[i], zero);
+        }
+
+        // ShiftRows on the 4x4 matrix of 128 bit words.
+        __m128i t = w[1];
+        w[1] = w[5]; w[5] = w[9]; w[9] = w[13]; w[13] = t;
+        t = w[2]; w[2] = w[10]; w[10] = t;
+        t = w[6]; w[6] = w[14]; w[14] = t;
+        t = w[15]; w[15] = w[11]; w[11] = w[7]; w[7] = w[3]; w[3] = t;
+
+        MixColumn(w[0], w[1], w[2], w[3]);
+        MixColumn(w[4], w[5], w[6], w[7]);
+        MixColumn(w[8], w[9], w[10], w[11]);
+        MixColumn(w[12], w[13], w[14], w[15]);
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        Store(out + 16 * i, _mm_xor_si128(_mm_xor_si128(salt, m[i]), _mm_xor_si128(w[i], w[i + 8])));
+    }
+}
+
+namespace {
+
+/** SHAvite-3-512 of N independent 64 byte inputs, interleaved to hide the AESENC latency. */
+template<int N>
+void inline __attribute__((always_inline)) Shavite512(unsigned char* out, const unsigned char* in)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    // The padded message block: the input, the 0x80 padding byte, the
+    // 128 bit message length at byte 110 and the output length.
+    unsigned char block[N][128] = {};
+    for (int l = 0; l < N; ++l) {
+        memcpy(block[l], in + 64 * l, 64);
+        block[l][64] = 0x80;
+        block[l][110] = 512 & 0xff;
+        block[l][111] = 512 >> 8;
+        block[l][127] = 512 >> 8;
+    }
+
+    // Message expansion, following the order of the portable implementation.
+    const uint32_t count0 = 512, count1 = 0, count2 = 0, count3 = 0;
+    uint32_t rk[N][448];
+    for (int l = 0; l < N; ++l) {
+        memcpy(rk[l], block[l], 128);
+    }
+    size_t u = 32;
+    while (true) {
+        for (int s = 0; s < 8; ++s) {
+            __m128i c = zero;
+            if (u == 32) {
+                c = _mm_set_epi32(~count3, count2, count1, count0);
+            } else if (u == 164) {
+                c = _mm_set_epi32(~count0, count1, count2, count3);
+            } else if (u == 316) {
+                c = _mm_set_epi32(~count1, count0, count3, count2);
+            } else if (u == 440) {
+                c = _mm_set_epi32(~count2, count3, count0, count1);
+            }
+            for (int l = 0; l < N; ++l) {
+                __m128i x = _mm_shuffle_epi32(Load(rk[l] + u - 32), _MM_SHUFFLE(0, 3, 2, 1));
+                x = _mm_xor_si128(_mm_aesenc_si128(x, zero), Load(rk[l] + u - 4));
+                Store(rk[l] + u, _mm_xor_si128(x, c));
+            }
+            u += 4;
+        }
+        if (u == 448) break;
+        for (int s = 0; s < 8; ++s) {
+            for (int l = 0; l < N; ++l) {
+                Store(rk[l] + u, _mm_xor_si128(Load(rk[l] + u - 32), Load(rk[l] + u - 7)));
+            }
+            u += 4;
+        }
+    }
+
+    const __m128i h0 = Load(SHAVITE512_IV + 0);
+    const __m128i h1 = Load(SHAVITE512_IV + 4);
+    const __m128i h2 = Load(SHAVITE512_IV + 8);
+    const __m128i h3 = Load(SHAVITE512_IV + 12);
+    __m128i p0[N], p1[N], p2[N], p3[N];
+    for (int l = 0; l < N; ++l) {
+        p0[l] = h0; p1[l] = h1; p2[l] = h2; p3[l] = h3;
+    }
+    for (int r = 0, k = 0; r < 14; ++r, k += 32) {
+        __m128i x[N], y[N];
+        for (int l = 0; l < N; ++l) {
+            x[l] = _mm_aesenc_si128(_mm_xor_si128(p1[l], Load(rk[l] + k)), zero);
+            y[l] = _mm_aesenc_si128(_mm_xor_si128(p3[l], Load(rk[l] + k + 16)), zero);
+        }
+        for (int i = 4; i < 16; i += 4) {
+            for (int l = 0; l < N; ++l) {
+                x[l] = _mm_aesenc_si128(_mm_xor_si128(x[l], Load(rk[l] + k + i)), zero);
+                y[l] = _mm_aesenc_si128(_mm_xor_si128(y[l], Load(rk[l] + k + 16 + i)), zero);
+            }
+        }
+        for (int l = 0; l < N; ++l) {
+            const __m128i t = p3[l];
+            p3[l] = _mm_xor_si128(p2[l], y[l]);
+            p2[l] = p1[l];
+            p1[l] = _mm_xor_si128(p0[l], x[l]);
+            p0[l] = t;
+        }
+    }
+
+    for (int l = 0; l < N; ++l) {
+        Store(out + 64 * l + 0, _mm_xor_si128(h0, p0[l]));
+        Store(out + 64 * l + 16, _mm_xor_si128(h1, p1[l]));
+        Store(out + 64 * l + 32, _mm_xor_si128(h2, p2[l]));
+        Store(out + 64 * l + 48, _mm_xor_si128(h3, p3[l]));
+    }
+}
+
+} // namespace
+
+void Shavite512_64(unsigned char* out, const unsigned char* in)
+{
+    Shavite512<1>(out, in);
+}
+
+void Shavite512_64_4way(unsigned char* out, const unsigned char* in)
+{
+    Shavite512<4>(out, in);
+}
+
+} // namespace x11_aesni
+
+#endif
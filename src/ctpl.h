@@ -41,6 +41,7 @@
 //      ret func(int id, other_params)
 // where id is the index of the thread that runs the functor
 // ret is some return type
+// functors pushed with push_high() are run before all functors pushed with push()
 
 
 namespace ctpl {
@@ -49,8 +50,8 @@ namespace ctpl {
 
     public:
 
-        thread_pool() : q(_ctplThreadPoolLength_) { this->init(); }
-        thread_pool(int nThreads, int queueSize = _ctplThreadPoolLength_) : q(queueSize) { this->init(); this->resize(nThreads); }
+        thread_pool() : q(_ctplThreadPoolLength_), qHigh(_ctplThreadPoolLength_) { this->init(); }
+        thread_pool(int nThreads, int queueSize = _ctplThreadPoolLength_) : q(queueSize), qHigh(queueSize) { this->init(); this->resize(nThreads); }
 
         // the destructor waits for all the functions in the queue to be finished
         ~thread_pool() {
@@ -98,14 +99,14 @@ namespace ctpl {
         // empty the queue
         void clear_queue() {
             std::function<void(int id)> * _f;
-            while (this->q.pop(_f))
+            while (this->pop_any(_f))
                 delete _f;  // empty the queue
         }
 
         // pops a functional wraper to the original function
         std::function<void(int)> pop() {
             std::function<void(int id)> * _f = nullptr;
-            this->q.pop(_f);
+            this->pop_any(_f);
             std::unique_ptr<std::function<void(int id)>> func(_f);  // at return, delete the function even if an exception occurred
 
             std::function<void(int)> f;
@@ -157,10 +158,7 @@ namespace ctpl {
             auto _f = new std::function<void(int id)>([pck](int id) {
                 (*pck)(id);
             });
-            this->q.push(_f);
-
-            std::unique_lock<std::mutex> lock(this->mutex);
-            this->cv.notify_one();
+            this->enqueue(this->q, _f);
 
             return pck->get_future();
         }
@@ -174,10 +172,34 @@ namespace ctpl {
             auto _f = new std::function<void(int id)>([pck](int id) {
                 (*pck)(id);
             });
-            this->q.push(_f);
+            this->enqueue(this->q, _f);
 
-            std::unique_lock<std::mutex> lock(this->mutex);
-            this->cv.notify_one();
+            return pck->get_future();
+        }
+
+        // same as push(), but the functor is run before all functors pushed with push() which are not running yet
+        template<typename F, typename... Rest>
+        auto push_high(F && f, Rest&&... rest) ->std::future<decltype(f(0, rest...))> {
+            auto pck = std::make_shared<std::packaged_task<decltype(f(0, rest...))(int)>>(
+                std::bind(std::forward<F>(f), std::placeholders::_1, std::forward<Rest>(rest)...)
+            );
+
+            auto _f = new std::function<void(int id)>([pck](int id) {
+                (*pck)(id);
+            });
+            this->enqueue(this->qHigh, _f);
+
+            return pck->get_future();
+        }
+
+        template<typename F>
+        auto push_high(F && f) ->std::future<decltype(f(0))> {
+            auto pck = std::make_shared<std::packaged_task<decltype(f(0))(int)>>(std::forward<F>(f));
+
+            auto _f = new std::function<void(int id)>([pck](int id) {
+                (*pck)(id);
+            });
+            this->enqueue(this->qHigh, _f);
 
             return pck->get_future();
         }
@@ -191,12 +213,29 @@ namespace ctpl {
         thread_pool & operator=(const thread_pool &);// = delete;
         thread_pool & operator=(thread_pool &&);// = delete;
 
+        bool pop_any(std::function<void(int id)> * & _f) {
+            return this->qHigh.pop(_f) || this->q.pop(_f);
+        }
+
+        void enqueue(boost::lockfree::queue<std::function<void(int id)> *> & queue, std::function<void(int id)> * _f) {
+            queue.push(_f);
+
+            // Only take the mutex if a thread might be waiting. Pushing many small jobs would otherwise contend on it.
+            // The fence pairs with the one in set_thread(), so either the waiting thread sees the new functor or we
+            // see the increased nWaiting
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (this->nWaiting == 0)
+                return;
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->cv.notify_one();
+        }
+
         void set_thread(int i) {
             std::shared_ptr<std::atomic<bool>> flag(this->flags[i]);  // a copy of the shared ptr to the flag
             auto f = [this, i, flag/* a copy of the shared ptr to the flag */]() {
                 std::atomic<bool> & _flag = *flag;
                 std::function<void(int id)> * _f;
-                bool isPop = this->q.pop(_f);
+                bool isPop = this->pop_any(_f);
                 while (true) {
                     while (isPop) {  // if there is anything in the queue
                         std::unique_ptr<std::function<void(int id)>> func(_f);  // at return, delete the function even if an exception occurred
@@ -205,13 +244,14 @@ namespace ctpl {
                         if (_flag)
                             return;  // the thread is wanted to stop, return even if the queue is not empty yet
                         else
-                            isPop = this->q.pop(_f);
+                            isPop = this->pop_any(_f);
                     }
 
                     // the queue is empty here, wait for the next command
                     std::unique_lock<std::mutex> lock(this->mutex);
                     ++this->nWaiting;
-                    this->cv.wait(lock, [this, &_f, &isPop, &_flag](){ isPop = this->q.pop(_f); return isPop || this->isDone || _flag; });
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    this->cv.wait(lock, [this, &_f, &isPop, &_flag](){ isPop = this->pop_any(_f); return isPop || this->isDone || _flag; });
                     --this->nWaiting;
 
                     if (!isPop)
@@ -226,6 +266,7 @@ namespace ctpl {
         std::vector<std::unique_ptr<std::thread>> threads;
         std::vector<std::shared_ptr<std::atomic<bool>>> flags;
         mutable boost::lockfree::queue<std::function<void(int id)> *> q;
+        mutable boost::lockfree::queue<std::function<void(int id)> *> qHigh;
         std::atomic<bool> isDone;
         std::atomic<bool> isStop;
         std::atomic<int> nWaiting;  // how many threads are waiting
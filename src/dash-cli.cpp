@@ -18,6 +18,7 @@
 #include <utilstrencodings.h>
 
 #include <memory>
+#include <sstream>
 #include <stdio.h>
 
 #include <event2/buffer.h>
@@ -37,6 +38,7 @@ static void SetupCliArgs()
     const auto testnetBaseParams = CreateBaseChainParams(CBaseChainParams::TESTNET);
 
     gArgs.AddArg("-?", "This help message", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-batch", "Read commands from standard input, one per line until EOF/Ctrl-D, each being a method followed by its whitespace separated arguments, and send them to the server as a single JSON-RPC batch request. The replies are printed as an array in the order of the commands, errors of individual commands are reported in their reply", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-conf=<file>", strprintf("Specify configuration file. Relative paths will be prefixed by datadir location. (default: %s)", BITCOIN_CONF_FILENAME), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-datadir=<dir>", "Specify data directory", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-getinfo", "Get general information from the remote server. Note that unlike server-side RPC calls, the results of -getinfo is the result of multiple non-atomic requests. Some entries in the result may represent results from different states (e.g. wallet balance may be as of a different block from the chain state reported)", false, OptionsCategory::OPTIONS);
@@ -279,6 +281,67 @@ public:
     }
 };
 
+/** Process -batch requests, sending all commands read from stdin in one round trip */
+class BatchRequestHandler: public BaseRequestHandler
+{
+private:
+    std::vector<std::vector<std::string>> vCommands;
+
+public:
+    explicit BatchRequestHandler(const std::vector<std::string>& vLines)
+    {
+        for (const std::string& line : vLines) {
+            std::istringstream ss(line);
+            std::vector<std::string> vWords;
+            std::string word;
+            while (ss >> word) {
+                vWords.push_back(word);
+            }
+            if (!vWords.empty()) {
+                vCommands.push_back(std::move(vWords));
+            }
+        }
+    }
+
+    /** Create one request per command, the id being the index of the command. */
+    UniValue PrepareRequest(const std::string& method, const std::vector<std::string>& args) override
+    {
+        if (!args.empty()) {
+            throw std::runtime_error("-batch takes no arguments, commands are read from standard input");
+        }
+        if (vCommands.empty()) {
+            throw std::runtime_error("-batch specified but no commands were read from standard input");
+        }
+        UniValue result(UniValue::VARR);
+        for (size_t i = 0; i < vCommands.size(); i++) {
+            const std::string& strMethod = vCommands[i][0];
+            const std::vector<std::string> vArgs(vCommands[i].begin() + 1, vCommands[i].end());
+            UniValue params;
+            if (gArgs.GetBoolArg("-named", DEFAULT_NAMED)) {
+                params = RPCConvertNamedValues(strMethod, vArgs);
+            } else {
+                params = RPCConvertValues(strMethod, vArgs);
+            }
+            result.push_back(JSONRPCRequestObj(strMethod, params, (int)i));
+        }
+        return result;
+    }
+
+    /** Put the replies back into command order and wrap them into a single reply. */
+    UniValue ProcessReply(const UniValue &batch_in) override
+    {
+        // The server answers a batch it can't process with a single error object
+        if (batch_in.isObject()) {
+            return batch_in.get_obj();
+        }
+        UniValue result(UniValue::VARR);
+        for (const UniValue& reply : JSONRPCProcessBatchReply(batch_in, vCommands.size())) {
+            result.push_back(reply);
+        }
+        return JSONRPCReplyObj(result, NullUniValue, 1);
+    }
+};
+
 /** Process default single requests */
 class DefaultRequestHandler: public BaseRequestHandler {
 public:
@@ -418,7 +481,17 @@ int CommandLineRPC(int argc, char *argv[])
             gArgs.ForceSetArg("-rpcpassword", rpcPass);
         }
         std::vector<std::string> args = std::vector<std::string>(&argv[1], &argv[argc]);
-        if (gArgs.GetBoolArg("-stdin", false)) {
+        std::vector<std::string> vBatchLines;
+        if (gArgs.GetBoolArg("-batch", false)) {
+            if (gArgs.GetBoolArg("-stdin", false) || gArgs.GetBoolArg("-getinfo", false)) {
+                throw std::runtime_error("-batch can't be combined with -stdin or -getinfo");
+            }
+            // Read one command per line from stdin
+            std::string line;
+            while (std::getline(std::cin, line)) {
+                vBatchLines.push_back(line);
+            }
+        } else if (gArgs.GetBoolArg("-stdin", false)) {
             // Read one arg per line from stdin and append
             std::string line;
             while (std::getline(std::cin, line)) {
@@ -430,6 +503,9 @@ int CommandLineRPC(int argc, char *argv[])
         if (gArgs.GetBoolArg("-getinfo", false)) {
             rh.reset(new GetinfoRequestHandler());
             method = "";
+        } else if (gArgs.GetBoolArg("-batch", false)) {
+            rh.reset(new BatchRequestHandler(vBatchLines));
+            method = "";
         } else {
             rh.reset(new DefaultRequestHandler());
             if (args.size() < 1) {
@@ -6,6 +6,7 @@
 
 #include <memory>
 #include <random.h>
+#include <sync.h>
 
 #include <leveldb/cache.h>
 #include <leveldb/env.h>
@@ -13,6 +14,10 @@
 #include <memenv.h>
 #include <stdint.h>
 #include <algorithm>
+#include <set>
+
+static CCriticalSection cs_open_dbs;
+static std::set<const CDBWrapper*> setOpenDBs GUARDED_BY(cs_open_dbs);
 
 class CBitcoinLevelDBLogger : public leveldb::Logger {
 public:
@@ -97,32 +102,113 @@ static void SetMaxOpenFiles(leveldb::Options *options) {
              options->max_open_files, default_open_files);
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+static leveldb::Options GetOptions(const CDBOptions& dbOptions)
 {
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
-    options.compression = leveldb::kNoCompression;
+    options.block_cache = leveldb::NewLRUCache(dbOptions.nBlockCacheSize);
+    options.write_buffer_size = dbOptions.nWriteBufferSize;
+    options.filter_policy = dbOptions.nBloomBits > 0 ? leveldb::NewBloomFilterPolicy(dbOptions.nBloomBits) : nullptr;
+    options.compression = dbOptions.fCompression ? leveldb::kSnappyCompression : leveldb::kNoCompression;
+    options.max_file_size = dbOptions.nMaxFileSize;
+    options.block_size = dbOptions.nBlockSize;
     options.info_log = new CBitcoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
         // LevelDB versions before 1.16 consider short writes to be corruption. Only trigger error
         // on corruption in later versions.
         options.paranoid_checks = true;
     }
-    SetMaxOpenFiles(&options);
+    if (dbOptions.nMaxOpenFiles > 0) {
+        options.max_open_files = dbOptions.nMaxOpenFiles;
+    } else {
+        SetMaxOpenFiles(&options);
+    }
     return options;
 }
 
+CDBOptions GetDefaultDBOptions(DBRole role, size_t nCacheSize)
+{
+    CDBOptions dbOptions;
+    dbOptions.nBlockCacheSize = nCacheSize / 2;
+    dbOptions.nWriteBufferSize = nCacheSize / 4;
+    switch (role) {
+    case DBRole::GENERIC:
+        break;
+    case DBRole::EVO:
+        // values are large, bigger blocks and files keep the table indexes and the number of files small
+        dbOptions.nBlockSize = 16 << 10;
+        dbOptions.nMaxFileSize = 8 << 20;
+        break;
+    case DBRole::LLMQ:
+        // mostly writes and lookups of entries which don't exist, which the bloom filter answers
+        dbOptions.nBlockCacheSize = nCacheSize / 4;
+        dbOptions.nWriteBufferSize = nCacheSize * 3 / 8;
+        dbOptions.nBloomBits = 16;
+        break;
+    case DBRole::INDEX:
+        // keys of the same address share most of their bytes, scans read whole blocks
+        dbOptions.fCompression = true;
+        dbOptions.nBlockSize = 16 << 10;
+        break;
+    }
+    return dbOptions;
+}
+
+bool ApplyDBTuneArg(const std::string& strArg, const std::string& strName, CDBOptions& dbOptions)
+{
+    size_t nColon = strArg.find(':');
+    size_t nEquals = strArg.find('=', nColon == std::string::npos ? 0 : nColon);
+    int64_t nValue;
+    if (nColon == std::string::npos || nEquals == std::string::npos || nColon == 0 ||
+            !ParseInt64(strArg.substr(nEquals + 1), &nValue) || nValue < 0) {
+        return false;
+    }
+    const std::string strDB = strArg.substr(0, nColon);
+    const std::string strOption = strArg.substr(nColon + 1, nEquals - nColon - 1);
+    const bool fApply = !strName.empty() && strDB == strName;
+
+    CDBOptions newOptions = dbOptions;
+    if (strOption == "blockcache") {
+        newOptions.nBlockCacheSize = nValue << 10;
+    } else if (strOption == "writebuffer") {
+        newOptions.nWriteBufferSize = nValue << 10;
+    } else if (strOption == "bloombits") {
+        newOptions.nBloomBits = nValue;
+    } else if (strOption == "compression") {
+        newOptions.fCompression = nValue != 0;
+    } else if (strOption == "maxopenfiles") {
+        newOptions.nMaxOpenFiles = nValue;
+    } else if (strOption == "maxfilesize") {
+        newOptions.nMaxFileSize = nValue << 10;
+    } else if (strOption == "blocksize") {
+        newOptions.nBlockSize = nValue << 10;
+    } else if (strOption == "compactonopen") {
+        newOptions.fCompactOnOpen = nValue != 0;
+    } else {
+        return false;
+    }
+    if (fApply) {
+        dbOptions = newOptions;
+    }
+    return true;
+}
+
 CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate)
-    : m_name(fs::basename(path))
+    : CDBWrapper(path, GetDefaultDBOptions(DBRole::GENERIC, nCacheSize), fMemory, fWipe, obfuscate)
+{
+}
+
+CDBWrapper::CDBWrapper(const fs::path& path, const CDBOptions& dbOptions, bool fMemory, bool fWipe, bool obfuscate)
+    : m_name(fs::basename(path)), m_db_options(dbOptions)
 {
     penv = nullptr;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    for (const std::string& strArg : gArgs.GetArgs("-dbtune")) {
+        ApplyDBTuneArg(strArg, m_name, m_db_options);
+    }
+    options = GetOptions(m_db_options);
     options.create_if_missing = true;
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -140,7 +226,11 @@ CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bo
     dbwrapper_private::HandleError(status);
     LogPrintf("Opened LevelDB successfully\n");
 
-    if (gArgs.GetBoolArg("-forcecompactdb", false)) {
+    LogPrint(BCLog::LEVELDB, "LevelDB options for %s: blockcache=%u writebuffer=%u bloombits=%d compression=%d maxfilesize=%u blocksize=%u\n",
+             m_name, m_db_options.nBlockCacheSize, m_db_options.nWriteBufferSize, m_db_options.nBloomBits,
+             m_db_options.fCompression, m_db_options.nMaxFileSize, m_db_options.nBlockSize);
+
+    if (m_db_options.fCompactOnOpen || gArgs.GetBoolArg("-forcecompactdb", false)) {
         LogPrintf("Starting database compaction of %s\n", path.string());
         pdb->CompactRange(nullptr, nullptr);
         LogPrintf("Finished database compaction of %s\n", path.string());
@@ -164,10 +254,17 @@ CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bo
     }
 
     LogPrintf("Using obfuscation key for %s: %s\n", path.string(), HexStr(obfuscate_key));
+
+    LOCK(cs_open_dbs);
+    setOpenDBs.emplace(this);
 }
 
 CDBWrapper::~CDBWrapper()
 {
+    {
+        LOCK(cs_open_dbs);
+        setOpenDBs.erase(this);
+    }
     delete pdb;
     pdb = nullptr;
     delete options.filter_policy;
@@ -206,6 +303,30 @@ size_t CDBWrapper::DynamicMemoryUsage() const {
     return stoul(memory);
 }
 
+bool CDBWrapper::GetProperty(const std::string& strProperty, std::string& valueRet) const
+{
+    return pdb->GetProperty(strProperty, &valueRet);
+}
+
+uint64_t CDBWrapper::GetApproximateSize() const
+{
+    // all keys are lower than this, keys are prefixed with a type byte which is never 0xff
+    const std::string strLimit(DBWRAPPER_PREALLOC_KEY_SIZE, '\xff');
+    leveldb::Slice slBegin, slLimit(strLimit);
+    leveldb::Range range(slBegin, slLimit);
+    uint64_t size = 0;
+    pdb->GetApproximateSizes(&range, 1, &size);
+    return size;
+}
+
+void CDBWrapper::ForEachDB(const std::function<void(const CDBWrapper&)>& f)
+{
+    LOCK(cs_open_dbs);
+    for (const CDBWrapper* pdbw : setOpenDBs) {
+        f(*pdbw);
+    }
+}
+
 // Prefixed with null character to avoid collisions with other keys
 //
 // We must use a string constructor which specifies length so that we copy
@@ -236,7 +357,9 @@ bool CDBWrapper::IsEmpty()
 CDBIterator::~CDBIterator() { delete piter; }
 bool CDBIterator::Valid() const { return piter->Valid(); }
 void CDBIterator::SeekToFirst() { piter->SeekToFirst(); }
+void CDBIterator::SeekToLast() { piter->SeekToLast(); }
 void CDBIterator::Next() { piter->Next(); }
+void CDBIterator::Prev() { piter->Prev(); }
 
 namespace dbwrapper_private {
 
@@ -13,6 +13,7 @@
 #include <utilstrencodings.h>
 #include <version.h>
 
+#include <functional>
 #include <typeindex>
 
 #include <leveldb/db.h>
@@ -45,6 +46,43 @@ const std::vector<unsigned char>& GetObfuscateKey(const CDBWrapper &w);
 
 };
 
+/** What a database is used for, which decides the defaults of its CDBOptions */
+enum class DBRole {
+    //! chainstate, block index and smaller databases, point lookups of small values
+    GENERIC,
+    //! evodb, large values (masternode lists and diffs) which are written once per block and read in bursts
+    EVO,
+    //! llmq, many small entries which are written and deleted all the time and often looked up without existing
+    LLMQ,
+    //! address, spent and timestamp indexes, mostly range scans over compressible keys
+    INDEX,
+};
+
+/** LevelDB tuning of a database, can be changed per database with -dbtune */
+struct CDBOptions {
+    size_t nBlockCacheSize{0};
+    //! up to two write buffers may be held in memory simultaneously
+    size_t nWriteBufferSize{0};
+    //! bits per key of the bloom filter, 0 for no filter
+    int nBloomBits{10};
+    bool fCompression{false};
+    //! 0 for the platform default, see SetMaxOpenFiles
+    int nMaxOpenFiles{0};
+    //! size of table files, larger files mean fewer but longer compactions
+    size_t nMaxFileSize{2 << 20};
+    size_t nBlockSize{4 << 10};
+    //! compact the whole database when it is opened
+    bool fCompactOnOpen{false};
+};
+
+/** Returns the default options for a database with the given role and nCacheSize bytes of cache */
+CDBOptions GetDefaultDBOptions(DBRole role, size_t nCacheSize);
+/**
+ * Applies a -dbtune argument of the form <db>:<option>=<value> to dbOptions if <db> is strName. Returns false if the
+ * argument is malformed, which is also checked when strName is empty.
+ */
+bool ApplyDBTuneArg(const std::string& strArg, const std::string& strName, CDBOptions& dbOptions);
+
 /** Batch of changes queued to be written to a CDBWrapper */
 class CDBBatch
 {
@@ -142,6 +180,7 @@ public:
     bool Valid() const;
 
     void SeekToFirst();
+    void SeekToLast();
 
     template<typename K> void Seek(const K& key) {
         CDataStream ssKey(SER_DISK, CLIENT_VERSION);
@@ -156,6 +195,7 @@ public:
     }
 
     void Next();
+    void Prev();
 
     template<typename K> bool GetKey(K& key) {
         try {
@@ -222,6 +262,9 @@ private:
     //! the name of this database
     std::string m_name;
 
+    //! the tuning this database was opened with
+    CDBOptions m_db_options;
+
     //! a key used for optional XOR-obfuscation of the database
     std::vector<unsigned char> obfuscate_key;
 
@@ -243,8 +286,20 @@ public:
      *                        with a zero'd byte array.
      */
     CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false);
+    /** Opens the database with the given tuning, -dbtune arguments for it are applied on top */
+    CDBWrapper(const fs::path& path, const CDBOptions& dbOptions, bool fMemory = false, bool fWipe = false, bool obfuscate = false);
     ~CDBWrapper();
 
+    const std::string& GetName() const { return m_name; }
+    const CDBOptions& GetDBOptions() const { return m_db_options; }
+    /** Returns a LevelDB property (e.g. leveldb.stats) in valueRet, false if the property is unknown */
+    bool GetProperty(const std::string& strProperty, std::string& valueRet) const;
+    /** Returns the approximate size of all the data of this database on disk */
+    uint64_t GetApproximateSize() const;
+
+    /** Calls f for every open database, the databases can't be closed in the meantime */
+    static void ForEachDB(const std::function<void(const CDBWrapper&)>& f);
+
     template <typename K>
     bool ReadDataStream(const K& key, CDataStream& ssValue) const
     {
@@ -557,6 +612,7 @@ private:
 template<typename Parent, typename CommitTarget>
 class CDBTransaction {
     friend class CDBTransactionIterator<CDBTransaction>;
+    template<typename, typename> friend class CDBTransaction;
 
 protected:
     Parent &parent;
@@ -585,15 +641,27 @@ protected:
     template <typename V>
     struct ValueHolderImpl : ValueHolder {
         ValueHolderImpl(const V &_value, size_t _memoryUsage) : ValueHolder(_memoryUsage), value(_value) {}
+        ValueHolderImpl(V &&_value, size_t _memoryUsage) : ValueHolder(_memoryUsage), value(std::move(_value)) {}
 
         virtual void Write(const CDataStream& ssKey, CommitTarget &commitTarget) {
             // we're moving the value instead of copying it. This means that Write() can only be called once per
             // ValueHolderImpl instance. Commit() clears the write maps, so this ok.
-            commitTarget.Write(ssKey, std::move(value));
+            CommitValue(commitTarget, ssKey, value, this->memoryUsage);
         }
         V value;
     };
 
+    // Committing into a batch serializes the value, which happens only once on the way to the database. Committing into
+    // another transaction moves the value into it, together with its already known size.
+    template <typename V>
+    static void CommitValue(CDBBatch& batch, const CDataStream& ssKey, V& value, size_t valueMemoryUsage) {
+        batch.Write(ssKey, value);
+    }
+    template <typename P, typename C, typename V>
+    static void CommitValue(CDBTransaction<P, C>& transaction, const CDataStream& ssKey, V& value, size_t valueMemoryUsage) {
+        transaction.WriteHolder(ssKey, std::make_unique<typename CDBTransaction<P, C>::template ValueHolderImpl<V>>(std::move(value), valueMemoryUsage));
+    }
+
     template<typename K>
     static CDataStream KeyToDataStream(const K& key) {
         CDataStream ssKey(SER_DISK, CLIENT_VERSION);
@@ -619,19 +687,27 @@ public:
     template <typename V>
     void Write(const CDataStream& ssKey, const V& v) {
         auto valueMemoryUsage = ::GetSerializeSize(v, SER_DISK, CLIENT_VERSION);
+        WriteHolder(ssKey, std::make_unique<ValueHolderImpl<V>>(v, valueMemoryUsage));
+    }
 
-        if (deletes.erase(ssKey)) {
+private:
+    void WriteHolder(const CDataStream& ssKey, ValueHolderPtr&& holder) {
+        if (!deletes.empty() && deletes.erase(ssKey)) {
             memoryUsage -= ssKey.size();
         }
-        auto it = writes.emplace(ssKey, nullptr).first;
-        if (it->second) {
+        // only copy the key if it's not written already
+        auto it = writes.lower_bound(ssKey);
+        if (it != writes.end() && !DataStreamCmp::less(ssKey, it->first)) {
             memoryUsage -= ssKey.size() + it->second->memoryUsage;
+        } else {
+            it = writes.emplace_hint(it, ssKey, nullptr);
         }
-        it->second = std::make_unique<ValueHolderImpl<V>>(v, valueMemoryUsage);
-
-        memoryUsage += ssKey.size() + valueMemoryUsage;
+        memoryUsage += ssKey.size() + holder->memoryUsage;
+        it->second = std::move(holder);
     }
 
+public:
+
     template <typename K, typename V>
     bool Read(const K& key, V& value) {
         return Read(KeyToDataStream(key), value);
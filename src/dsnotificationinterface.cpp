@@ -15,6 +15,7 @@
 
 #include <evo/deterministicmns.h>
 #include <evo/mnauth.h>
+#include <evo/simplifiedmns.h>
 
 #include <llmq/quorums.h>
 #include <llmq/quorums_chainlocks.h>
@@ -73,6 +74,8 @@ void CDSNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, con
     llmq::quorumManager->UpdatedBlockTip(pindexNew, fInitialDownload);
     llmq::quorumDKGSessionManager->UpdatedBlockTip(pindexNew, fInitialDownload);
 
+    mnListDiffCache.UpdatedBlockTip(pindexNew);
+
     if (!fDisableGovernance) governance.UpdatedBlockTip(pindexNew, connman);
 }
 
@@ -86,6 +89,7 @@ void CDSNotificationInterface::TransactionAddedToMempool(const CTransactionRef&
 void CDSNotificationInterface::TransactionRemovedFromMempool(const CTransactionRef& ptx, MemPoolRemovalReason reason)
 {
     llmq::quorumInstantSendManager->TransactionRemovedFromMempool(ptx);
+    llmq::chainLocksHandler->TransactionRemovedFromMempool(ptx);
 }
 
 void CDSNotificationInterface::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindex, const std::vector<CTransactionRef>& vtxConflicted)
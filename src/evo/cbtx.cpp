@@ -118,16 +118,30 @@ bool CalcCbTxMerkleRootMNList(const CBlock& block, const CBlockIndex* pindexPrev
         int64_t nTime2 = GetTimeMicros(); nTimeDMN += nTime2 - nTime1;
         LogPrint(BCLog::BENCHMARK, "            - BuildNewListFromBlock: %.2fms [%.2fs]\n", 0.001 * (nTime2 - nTime1), nTimeDMN * 0.000001);
 
-        CSimplifiedMNList sml(tmpMNList);
-
-        int64_t nTime3 = GetTimeMicros(); nTimeSMNL += nTime3 - nTime2;
-        LogPrint(BCLog::BENCHMARK, "            - CSimplifiedMNList: %.2fms [%.2fs]\n", 0.001 * (nTime3 - nTime2), nTimeSMNL * 0.000001);
-
-        static CSimplifiedMNList smlCached;
+        // Leaf hashes are cached per MN. MN states are immutable and shared between list versions, so MNs which were
+        // not touched by this block still have the same state object and don't need to be serialized and hashed again
+        static std::map<uint256, std::pair<CDeterministicMNStateCPtr, uint256>> leavesCached;
         static uint256 merkleRootCached;
         static bool mutatedCached{false};
 
-        if (sml.mnList == smlCached.mnList) {
+        std::map<uint256, std::pair<CDeterministicMNStateCPtr, uint256>> leaves;
+        bool fChanged = leavesCached.size() != tmpMNList.GetAllMNsCount();
+        size_t nRehashed = 0;
+        tmpMNList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
+            auto it = leavesCached.find(dmn->proTxHash);
+            if (it != leavesCached.end() && it->second.first == dmn->pdmnState) {
+                leaves.emplace(dmn->proTxHash, it->second);
+                return;
+            }
+            leaves.emplace(dmn->proTxHash, std::make_pair(dmn->pdmnState, CSimplifiedMNListEntry(*dmn).CalcHash()));
+            nRehashed++;
+            fChanged = true;
+        });
+
+        int64_t nTime3 = GetTimeMicros(); nTimeSMNL += nTime3 - nTime2;
+        LogPrint(BCLog::BENCHMARK, "            - SML leaves (%d rehashed): %.2fms [%.2fs]\n", nRehashed, 0.001 * (nTime3 - nTime2), nTimeSMNL * 0.000001);
+
+        if (!fChanged) {
             merkleRootRet = merkleRootCached;
             if (mutatedCached) {
                 return state.DoS(100, false, REJECT_INVALID, "mutated-cached-calc-cb-mnmerkleroot");
@@ -135,13 +149,20 @@ bool CalcCbTxMerkleRootMNList(const CBlock& block, const CBlockIndex* pindexPrev
             return true;
         }
 
+        // leaves are ordered by proRegTxHash, same as in CSimplifiedMNList
+        std::vector<uint256> hashes;
+        hashes.reserve(leaves.size());
+        for (const auto& p : leaves) {
+            hashes.emplace_back(p.second.second);
+        }
+
         bool mutated = false;
-        merkleRootRet = sml.CalcMerkleRoot(&mutated);
+        merkleRootRet = ComputeMerkleRoot(std::move(hashes), &mutated);
 
         int64_t nTime4 = GetTimeMicros(); nTimeMerkle += nTime4 - nTime3;
         LogPrint(BCLog::BENCHMARK, "            - CalcMerkleRoot: %.2fms [%.2fs]\n", 0.001 * (nTime4 - nTime3), nTimeMerkle * 0.000001);
 
-        smlCached = std::move(sml);
+        leavesCached = std::move(leaves);
         merkleRootCached = merkleRootRet;
         mutatedCached = mutated;
 
@@ -159,46 +180,29 @@ bool CalcCbTxMerkleRootMNList(const CBlock& block, const CBlockIndex* pindexPrev
 bool CalcCbTxMerkleRootQuorums(const CBlock& block, const CBlockIndex* pindexPrev, uint256& merkleRootRet, CValidationState& state)
 {
     static int64_t nTimeMinedAndActive = 0;
-    static int64_t nTimeMined = 0;
     static int64_t nTimeLoop = 0;
     static int64_t nTimeMerkle = 0;
 
     int64_t nTime1 = GetTimeMicros();
 
-    static std::map<Consensus::LLMQType, std::vector<const CBlockIndex*>> quorumsCached;
-    static std::map<Consensus::LLMQType, std::vector<uint256>> qcHashesCached;
+    static std::vector<uint256> qcHashesVecCached;
+    static uint256 merkleRootCached;
+    static bool mutatedCached{false};
 
-    // The returned quorums are in reversed order, so the most recent one is at index 0
-    auto quorums = llmq::quorumBlockProcessor->GetMinedAndActiveCommitmentsUntilBlock(pindexPrev);
+    // The returned hashes are in reversed order, so the most recent one is at index 0
     std::map<Consensus::LLMQType, std::vector<uint256>> qcHashes;
+    if (!llmq::quorumBlockProcessor->GetMinedAndActiveCommitmentHashesUntilBlock(pindexPrev, qcHashes)) {
+        return state.DoS(100, false, REJECT_INVALID, "commitment-not-found");
+    }
     size_t hashCount = 0;
-
-    int64_t nTime2 = GetTimeMicros(); nTimeMinedAndActive += nTime2 - nTime1;
-    LogPrint(BCLog::BENCHMARK, "            - GetMinedAndActiveCommitmentsUntilBlock: %.2fms [%.2fs]\n", 0.001 * (nTime2 - nTime1), nTimeMinedAndActive * 0.000001);
-
-    if (quorums == quorumsCached) {
-        qcHashes = qcHashesCached;
-    } else {
-        for (const auto& p : quorums) {
-            auto& v = qcHashes[p.first];
-            v.reserve(p.second.size());
-            for (const auto& p2 : p.second) {
-                llmq::CFinalCommitment qc;
-                uint256 minedBlockHash;
-                bool found = llmq::quorumBlockProcessor->GetMinedCommitment(p.first, p2->GetBlockHash(), qc, minedBlockHash);
-                if (!found) return state.DoS(100, false, REJECT_INVALID, "commitment-not-found");
-                v.emplace_back(::SerializeHash(qc));
-                hashCount++;
-            }
-        }
-        quorumsCached = quorums;
-        qcHashesCached = qcHashes;
+    for (const auto& p : qcHashes) {
+        hashCount += p.second.size();
     }
 
-    int64_t nTime3 = GetTimeMicros(); nTimeMined += nTime3 - nTime2;
-    LogPrint(BCLog::BENCHMARK, "            - GetMinedCommitment: %.2fms [%.2fs]\n", 0.001 * (nTime3 - nTime2), nTimeMined * 0.000001);
+    int64_t nTime2 = GetTimeMicros(); nTimeMinedAndActive += nTime2 - nTime1;
+    LogPrint(BCLog::BENCHMARK, "            - GetMinedAndActiveCommitmentHashesUntilBlock: %.2fms [%.2fs]\n", 0.001 * (nTime2 - nTime1), nTimeMinedAndActive * 0.000001);
 
-    // now add the commitments from the current block, which are not returned by GetMinedAndActiveCommitmentsUntilBlock
+    // now add the commitments from the current block, which are not returned by GetMinedAndActiveCommitmentHashesUntilBlock
     // due to the use of pindexPrev (we don't have the tip index here)
     for (size_t i = 1; i < block.vtx.size(); i++) {
         auto& tx = block.vtx[i];
@@ -215,7 +219,7 @@ bool CalcCbTxMerkleRootQuorums(const CBlock& block, const CBlockIndex* pindexPre
             const auto& params = Params().GetConsensus().llmqs.at((Consensus::LLMQType)qc.commitment.llmqType);
             auto& v = qcHashes[params.type];
             if (v.size() == params.signingActiveQuorumCount) {
-                // we pop the last entry, which is actually the oldest quorum as GetMinedAndActiveCommitmentsUntilBlock
+                // we pop the last entry, which is actually the oldest quorum as GetMinedAndActiveCommitmentHashesUntilBlock
                 // returned quorums in reversed order. This pop and later push can only work ONCE, but we rely on the
                 // fact that a block can only contain a single commitment for one LLMQ type
                 v.pop_back();
@@ -238,14 +242,24 @@ bool CalcCbTxMerkleRootQuorums(const CBlock& block, const CBlockIndex* pindexPre
     }
     std::sort(qcHashesVec.begin(), qcHashesVec.end());
 
-    int64_t nTime4 = GetTimeMicros(); nTimeLoop += nTime4 - nTime3;
-    LogPrint(BCLog::BENCHMARK, "            - Loop: %.2fms [%.2fs]\n", 0.001 * (nTime4 - nTime3), nTimeLoop * 0.000001);
+    int64_t nTime3 = GetTimeMicros(); nTimeLoop += nTime3 - nTime2;
+    LogPrint(BCLog::BENCHMARK, "            - Loop: %.2fms [%.2fs]\n", 0.001 * (nTime3 - nTime2), nTimeLoop * 0.000001);
 
+    // the set of active quorums only changes when a commitment is mined, so the root of the previous call can be reused
+    // most of the time
     bool mutated = false;
-    merkleRootRet = ComputeMerkleRoot(qcHashesVec, &mutated);
+    if (qcHashesVec == qcHashesVecCached) {
+        merkleRootRet = merkleRootCached;
+        mutated = mutatedCached;
+    } else {
+        merkleRootRet = ComputeMerkleRoot(qcHashesVec, &mutated);
+        qcHashesVecCached = std::move(qcHashesVec);
+        merkleRootCached = merkleRootRet;
+        mutatedCached = mutated;
+    }
 
-    int64_t nTime5 = GetTimeMicros(); nTimeMerkle += nTime5 - nTime4;
-    LogPrint(BCLog::BENCHMARK, "            - ComputeMerkleRoot: %.2fms [%.2fs]\n", 0.001 * (nTime5 - nTime4), nTimeMerkle * 0.000001);
+    int64_t nTime4 = GetTimeMicros(); nTimeMerkle += nTime4 - nTime3;
+    LogPrint(BCLog::BENCHMARK, "            - ComputeMerkleRoot: %.2fms [%.2fs]\n", 0.001 * (nTime4 - nTime3), nTimeMerkle * 0.000001);
 
     if (mutated) {
         return state.DoS(100, false, REJECT_INVALID, "mutated-calc-cbtx-quorummerkleroot");
@@ -8,7 +8,9 @@
 #include <base58.h>
 #include <chainparams.h>
 #include <core_io.h>
+#include <memusage.h>
 #include <script/standard.h>
+#include <statsd_client.h>
 #include <ui_interface.h>
 #include <validation.h>
 #include <validationinterface.h>
@@ -18,6 +20,8 @@
 
 #include <univalue.h>
 
+#include <thread>
+
 static const std::string DB_LIST_SNAPSHOT = "dmn_S";
 static const std::string DB_LIST_DIFF = "dmn_D";
 
@@ -212,20 +216,63 @@ static bool CompareByLastPaid(const CDeterministicMNCPtr& _a, const CDeterminist
     return CompareByLastPaid(*_a, *_b);
 }
 
-CDeterministicMNCPtr CDeterministicMNList::GetMNPayee() const
+void CDeterministicMNList::AddToPaymentQueue(const CDeterministicMNCPtr& dmn)
 {
-    if (mnMap.size() == 0) {
-        return nullptr;
+    if (!IsMNValid(dmn)) {
+        return;
     }
+    auto it = std::lower_bound(paymentQueue.begin(), paymentQueue.end(), dmn, [](const CDeterministicMNCPtr& a, const CDeterministicMNCPtr& b) {
+        return CompareByLastPaid(a, b);
+    });
+    paymentQueue = paymentQueue.insert(it - paymentQueue.begin(), dmn);
+}
 
-    CDeterministicMNCPtr best;
-    ForEachMN(true, [&](const CDeterministicMNCPtr& dmn) {
-        if (!best || CompareByLastPaid(dmn, best)) {
-            best = dmn;
+void CDeterministicMNList::RemoveFromPaymentQueue(const CDeterministicMNCPtr& dmn)
+{
+    if (!IsMNValid(dmn)) {
+        return;
+    }
+    auto it = std::lower_bound(paymentQueue.begin(), paymentQueue.end(), dmn, [](const CDeterministicMNCPtr& a, const CDeterministicMNCPtr& b) {
+        return CompareByLastPaid(a, b);
+    });
+    assert(it != paymentQueue.end() && (*it)->proTxHash == dmn->proTxHash);
+    paymentQueue = paymentQueue.erase(it - paymentQueue.begin());
+}
+
+void CDeterministicMNList::InvalidateHotFields()
+{
+    // Nobody else can reach the holder if we are its only owner, so it can be kept as long as it wasn't built yet
+    if (hotFields.use_count() > 1 || hotFields->fields) {
+        hotFields = std::make_shared<HotFieldsHolder>();
+    }
+}
+
+const CDeterministicMNListHotFields& CDeterministicMNList::GetHotFields() const
+{
+    std::call_once(hotFields->once, [&]() {
+        auto fields = std::make_unique<CDeterministicMNListHotFields>();
+        fields->dmns.reserve(mnMap.size());
+        fields->fValid.reserve(mnMap.size());
+        fields->nPoSePenalty.reserve(mnMap.size());
+        fields->confirmedHashWithProRegTxHash.reserve(mnMap.size());
+        for (const auto& p : mnMap) {
+            const auto& dmn = p.second;
+            fields->dmns.emplace_back(dmn);
+            fields->fValid.emplace_back(IsMNValid(dmn));
+            fields->nPoSePenalty.emplace_back(dmn->pdmnState->nPoSePenalty);
+            fields->confirmedHashWithProRegTxHash.emplace_back(dmn->pdmnState->confirmedHash.IsNull() ? uint256() : dmn->pdmnState->confirmedHashWithProRegTxHash);
         }
+        hotFields->fields = std::move(fields);
     });
+    return *hotFields->fields;
+}
 
-    return best;
+CDeterministicMNCPtr CDeterministicMNList::GetMNPayee() const
+{
+    if (paymentQueue.empty()) {
+        return nullptr;
+    }
+    return paymentQueue.front();
 }
 
 std::vector<CDeterministicMNCPtr> CDeterministicMNList::GetProjectedMNPayees(int nCount) const
@@ -234,65 +281,80 @@ std::vector<CDeterministicMNCPtr> CDeterministicMNList::GetProjectedMNPayees(int
         nCount = GetValidMNsCount();
     }
 
-    std::vector<CDeterministicMNCPtr> result;
-    result.reserve(nCount);
-
-    ForEachMN(true, [&](const CDeterministicMNCPtr& dmn) {
-        result.emplace_back(dmn);
-    });
-    std::sort(result.begin(), result.end(), [&](const CDeterministicMNCPtr& a, const CDeterministicMNCPtr& b) {
-        return CompareByLastPaid(a, b);
-    });
-
-    result.resize(nCount);
-
-    return result;
+    return std::vector<CDeterministicMNCPtr>(paymentQueue.begin(), paymentQueue.begin() + nCount);
 }
 
 std::vector<CDeterministicMNCPtr> CDeterministicMNList::CalculateQuorum(size_t maxSize, const uint256& modifier) const
 {
-    auto scores = CalculateScores(modifier);
+    return std::move(CalculateQuorums({std::make_pair(maxSize, modifier)})[0]);
+}
 
-    // sort is descending order
-    std::sort(scores.rbegin(), scores.rend(), [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
-        if (a.first == b.first) {
-            // this should actually never happen, but we should stay compatible with how the non deterministic MNs did the sorting
-            return a.second->collateralOutpoint < b.second->collateralOutpoint;
-        }
-        return a.first < b.first;
-    });
+std::vector<std::vector<CDeterministicMNCPtr>> CDeterministicMNList::CalculateQuorums(const std::vector<std::pair<size_t, uint256>>& quorums) const
+{
+    std::vector<uint256> modifiers;
+    modifiers.reserve(quorums.size());
+    for (const auto& p : quorums) {
+        modifiers.emplace_back(p.second);
+    }
+    auto allScores = CalculateScores(modifiers);
+
+    std::vector<std::vector<CDeterministicMNCPtr>> result(quorums.size());
+    for (size_t i = 0; i < quorums.size(); i++) {
+        auto& scores = allScores[i];
+
+        // sort is descending order
+        std::sort(scores.rbegin(), scores.rend(), [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
+            if (a.first == b.first) {
+                // this should actually never happen, but we should stay compatible with how the non deterministic MNs did the sorting
+                return a.second->collateralOutpoint < b.second->collateralOutpoint;
+            }
+            return a.first < b.first;
+        });
 
-    // take top maxSize entries and return it
-    std::vector<CDeterministicMNCPtr> result;
-    result.resize(std::min(maxSize, scores.size()));
-    for (size_t i = 0; i < result.size(); i++) {
-        result[i] = std::move(scores[i].second);
+        // take top maxSize entries and return it
+        result[i].resize(std::min(quorums[i].first, scores.size()));
+        for (size_t j = 0; j < result[i].size(); j++) {
+            result[i][j] = std::move(scores[j].second);
+        }
     }
     return result;
 }
 
 std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>> CDeterministicMNList::CalculateScores(const uint256& modifier) const
 {
-    std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>> scores;
-    scores.reserve(GetAllMNsCount());
-    ForEachMN(true, [&](const CDeterministicMNCPtr& dmn) {
-        if (dmn->pdmnState->confirmedHash.IsNull()) {
+    return std::move(CalculateScores(std::vector<uint256>{modifier})[0]);
+}
+
+std::vector<std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>>> CDeterministicMNList::CalculateScores(const std::vector<uint256>& modifiers) const
+{
+    std::vector<std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>>> scores(modifiers.size());
+    for (auto& v : scores) {
+        v.reserve(GetValidMNsCount());
+    }
+    // All modifiers are handled in the same pass so that every MN is only visited once
+    const auto& hot = GetHotFields();
+    for (size_t j = 0; j < hot.size(); j++) {
+        const uint256& confirmedHashWithProRegTxHash = hot.confirmedHashWithProRegTxHash[j];
+        if (!hot.fValid[j] || confirmedHashWithProRegTxHash.IsNull()) {
             // we only take confirmed MNs into account to avoid hash grinding on the ProRegTxHash to sneak MNs into a
             // future quorums
-            return;
+            continue;
         }
         // calculate sha256(sha256(proTxHash, confirmedHash), modifier) per MN
         // Please note that this is not a double-sha256 but a single-sha256
         // The first part is already precalculated (confirmedHashWithProRegTxHash)
         // TODO When https://github.com/bitcoin/bitcoin/pull/13191 gets backported, implement something that is similar but for single-sha256
-        uint256 h;
-        CSHA256 sha256;
-        sha256.Write(dmn->pdmnState->confirmedHashWithProRegTxHash.begin(), dmn->pdmnState->confirmedHashWithProRegTxHash.size());
-        sha256.Write(modifier.begin(), modifier.size());
-        sha256.Finalize(h.begin());
-
-        scores.emplace_back(UintToArith256(h), dmn);
-    });
+        CSHA256 sha256Base;
+        sha256Base.Write(confirmedHashWithProRegTxHash.begin(), confirmedHashWithProRegTxHash.size());
+        for (size_t i = 0; i < modifiers.size(); i++) {
+            uint256 h;
+            CSHA256 sha256(sha256Base);
+            sha256.Write(modifiers[i].begin(), modifiers[i].size());
+            sha256.Finalize(h.begin());
+
+            scores[i].emplace_back(UintToArith256(h), hot.dmns[j]);
+        }
+    }
 
     return scores;
 }
@@ -467,7 +529,8 @@ void CDeterministicMNList::AddMN(const CDeterministicMNCPtr& dmn, bool fBumpTota
         throw(std::runtime_error(strprintf("%s: Can't add a masternode %s with a duplicate keyIDOwner=%s", __func__,
                 dmn->proTxHash.ToString(), EncodeDestination(dmn->pdmnState->keyIDOwner))));
     }
-    if (dmn->pdmnState->pubKeyOperator.Get().IsValid() && !AddUniqueProperty(dmn, dmn->pdmnState->pubKeyOperator)) {
+    // IsNull() doesn't deserialize the key, which keeps loading lists from the DB cheap as AddMN is called for every MN
+    if (!dmn->pdmnState->pubKeyOperator.IsNull() && !AddUniqueProperty(dmn, dmn->pdmnState->pubKeyOperator)) {
         mnUniquePropertyMap = mnUniquePropertyMapSaved;
         throw(std::runtime_error(strprintf("%s: Can't add a masternode %s with a duplicate pubKeyOperator=%s", __func__,
                 dmn->proTxHash.ToString(), dmn->pdmnState->pubKeyOperator.Get().ToString())));
@@ -475,6 +538,8 @@ void CDeterministicMNList::AddMN(const CDeterministicMNCPtr& dmn, bool fBumpTota
 
     mnMap = mnMap.set(dmn->proTxHash, dmn);
     mnInternalIdMap = mnInternalIdMap.set(dmn->GetInternalId(), dmn->proTxHash);
+    AddToPaymentQueue(dmn);
+    InvalidateHotFields();
     if (fBumpTotalCount) {
         // nTotalRegisteredCount acts more like a checkpoint, not as a limit,
         nTotalRegisteredCount = std::max(dmn->GetInternalId() + 1, (uint64_t)nTotalRegisteredCount);
@@ -510,6 +575,9 @@ void CDeterministicMNList::UpdateMN(const CDeterministicMNCPtr& oldDmn, const CD
     }
 
     mnMap = mnMap.set(oldDmn->proTxHash, dmn);
+    RemoveFromPaymentQueue(oldDmn);
+    AddToPaymentQueue(dmn);
+    InvalidateHotFields();
 }
 
 void CDeterministicMNList::UpdateMN(const uint256& proTxHash, const CDeterministicMNStateCPtr& pdmnState)
@@ -556,7 +624,7 @@ void CDeterministicMNList::RemoveMN(const uint256& proTxHash)
         throw(std::runtime_error(strprintf("%s: Can't delete a masternode %s with a keyIDOwner=%s", __func__,
                 proTxHash.ToString(), EncodeDestination(dmn->pdmnState->keyIDOwner))));
     }
-    if (dmn->pdmnState->pubKeyOperator.Get().IsValid() && !DeleteUniqueProperty(dmn, dmn->pdmnState->pubKeyOperator)) {
+    if (!dmn->pdmnState->pubKeyOperator.IsNull() && !DeleteUniqueProperty(dmn, dmn->pdmnState->pubKeyOperator)) {
         mnUniquePropertyMap = mnUniquePropertyMapSaved;
         throw(std::runtime_error(strprintf("%s: Can't delete a masternode %s with a pubKeyOperator=%s", __func__,
                 proTxHash.ToString(), dmn->pdmnState->pubKeyOperator.Get().ToString())));
@@ -564,10 +632,14 @@ void CDeterministicMNList::RemoveMN(const uint256& proTxHash)
 
     mnMap = mnMap.erase(proTxHash);
     mnInternalIdMap = mnInternalIdMap.erase(dmn->GetInternalId());
+    RemoveFromPaymentQueue(dmn);
+    InvalidateHotFields();
 }
 
 CDeterministicMNManager::CDeterministicMNManager(CEvoDB& _evoDb) :
-    evoDb(_evoDb)
+    evoDb(_evoDb),
+    nMaxCacheUsage(std::max<int64_t>(1, gArgs.GetArg("-mnlistcachemb", DEFAULT_MNLIST_CACHE_MB)) << 20),
+    nSnapshotPeriod(std::max(1, (int)gArgs.GetArg("-mnlistsnapshotperiod", DEFAULT_MNLIST_SNAPSHOT_PERIOD)))
 {
 }
 
@@ -589,15 +661,20 @@ bool CDeterministicMNManager::ProcessBlock(const CBlock& block, const CBlockInde
     try {
         LOCK(cs);
 
+        int64_t nTimeBuild = GetTimeMicros();
         if (!BuildNewListFromBlock(block, pindex->pprev, _state, view, newList, true)) {
             // pass the state returned by the function above
             return false;
         }
+        statsClient.timing("masternodes.listBuild_ms", (GetTimeMicros() - nTimeBuild) / 1000, 1.0f);
 
         if (fJustCheck) {
             return true;
         }
 
+        statsClient.gauge("masternodes.total", newList.GetAllMNsCount(), 1.0f);
+        statsClient.gauge("masternodes.valid", newList.GetValidMNsCount(), 1.0f);
+
         if (newList.GetHeight() == -1) {
             newList.SetHeight(nHeight);
         }
@@ -608,15 +685,17 @@ bool CDeterministicMNManager::ProcessBlock(const CBlock& block, const CBlockInde
         diff = oldList.BuildDiff(newList);
 
         evoDb.Write(std::make_pair(DB_LIST_DIFF, newList.GetBlockHash()), diff);
-        if ((nHeight % DISK_SNAPSHOT_PERIOD) == 0 || oldList.GetHeight() == -1) {
+        if ((nHeight % nSnapshotPeriod) == 0 || oldList.GetHeight() == -1) {
             evoDb.Write(std::make_pair(DB_LIST_SNAPSHOT, newList.GetBlockHash()), newList);
-            mnListsCache.emplace(newList.GetBlockHash(), newList);
+            LOCK(cacheCs);
+            AddListToCache(newList);
             LogPrintf("CDeterministicMNManager::%s -- Wrote snapshot. nHeight=%d, mapCurMNs.allMNsCount=%d\n",
                 __func__, nHeight, newList.GetAllMNsCount());
         }
 
         diff.nHeight = pindex->nHeight;
-        mnListDiffsCache.emplace(pindex->GetBlockHash(), diff);
+        LOCK(cacheCs);
+        AddDiffToCache(pindex->GetBlockHash(), diff);
     } catch (const std::exception& e) {
         LogPrintf("CDeterministicMNManager::%s -- internal error: %s\n", __func__, e.what());
         return _state.DoS(100, false, REJECT_INVALID, "failed-dmn-block");
@@ -661,8 +740,9 @@ bool CDeterministicMNManager::UndoBlock(const CBlock& block, const CBlockIndex*
             prevList = GetListForBlock(pindex->pprev);
         }
 
-        mnListsCache.erase(blockHash);
-        mnListDiffsCache.erase(blockHash);
+        LOCK(cacheCs);
+        EraseListFromCache(blockHash);
+        EraseDiffFromCache(blockHash);
     }
 
     if (diff.HasChanges()) {
@@ -686,6 +766,96 @@ void CDeterministicMNManager::UpdatedBlockTip(const CBlockIndex* pindex)
     tipIndex = pindex;
 }
 
+// Returns true if the list at nListHeight is the base of a quorum that is still alive at nTipHeight
+static bool IsListUsedByAliveQuorum(int nListHeight, int nTipHeight)
+{
+    for (const auto& p_llmq : Params().GetConsensus().llmqs) {
+        if ((nListHeight % p_llmq.second.dkgInterval == 0) && (nListHeight + p_llmq.second.dkgInterval * (p_llmq.second.keepOldConnections + 1) >= nTipHeight)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace {
+// Decoded payload of a special TX. Only the member matching tx->nType is used
+struct CDecodedSpecialTx
+{
+    const CTransaction* tx;
+    bool fDecoded{false};
+    CProRegTx proRegTx;
+    CProUpServTx proUpServTx;
+    CProUpRegTx proUpRegTx;
+    CProUpRevTx proUpRevTx;
+    llmq::CFinalCommitmentTxPayload qc;
+
+    explicit CDecodedSpecialTx(const CTransaction* _tx) : tx(_tx) {}
+
+    void Decode()
+    {
+        switch (tx->nType) {
+        case TRANSACTION_PROVIDER_REGISTER:
+            fDecoded = GetTxPayload(*tx, proRegTx);
+            break;
+        case TRANSACTION_PROVIDER_UPDATE_SERVICE:
+            fDecoded = GetTxPayload(*tx, proUpServTx);
+            break;
+        case TRANSACTION_PROVIDER_UPDATE_REGISTRAR:
+            fDecoded = GetTxPayload(*tx, proUpRegTx);
+            break;
+        case TRANSACTION_PROVIDER_UPDATE_REVOKE:
+            fDecoded = GetTxPayload(*tx, proUpRevTx);
+            break;
+        case TRANSACTION_QUORUM_COMMITMENT:
+            fDecoded = GetTxPayload(*tx, qc);
+            break;
+        default:
+            fDecoded = true;
+            break;
+        }
+    }
+};
+} // namespace
+
+// Decodes the payloads of all special TXs in the block (skipping the coinbase). Payloads include BLS public keys,
+// which are expensive to decode, so blocks with many special TXs (e.g. during registration waves) are decoded on
+// multiple threads
+static std::vector<CDecodedSpecialTx> DecodeSpecialTxs(const CBlock& block)
+{
+    static const size_t MIN_TXS_PER_THREAD = 16;
+
+    std::vector<CDecodedSpecialTx> decoded;
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        if (block.vtx[i]->nVersion == 3) {
+            decoded.emplace_back(block.vtx[i].get());
+        }
+    }
+
+    size_t nThreads = std::min((size_t)std::max(GetNumCores(), 1), decoded.size() / MIN_TXS_PER_THREAD);
+    if (nThreads <= 1) {
+        for (auto& d : decoded) {
+            d.Decode();
+        }
+        return decoded;
+    }
+
+    auto decodeRange = [&decoded, nThreads](size_t start) {
+        for (size_t i = start; i < decoded.size(); i += nThreads) {
+            decoded[i].Decode();
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(nThreads - 1);
+    for (size_t i = 1; i < nThreads; i++) {
+        threads.emplace_back(decodeRange, i);
+    }
+    decodeRange(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+    return decoded;
+}
+
 bool CDeterministicMNManager::BuildNewListFromBlock(const CBlock& block, const CBlockIndex* pindexPrev, CValidationState& _state, const CCoinsViewCache& view, CDeterministicMNList& mnListRet, bool debugLogs)
 {
     AssertLockHeld(cs);
@@ -719,20 +889,17 @@ bool CDeterministicMNManager::BuildNewListFromBlock(const CBlock& block, const C
 
     DecreasePoSePenalties(newList);
 
-    // we skip the coinbase
-    for (int i = 1; i < (int)block.vtx.size(); i++) {
-        const CTransaction& tx = *block.vtx[i];
+    // Decode all payloads first (possibly in parallel), the list is then updated in a cheap serial pass
+    auto decodedTxs = DecodeSpecialTxs(block);
 
-        if (tx.nVersion != 3) {
-            // only interested in special TXs
-            continue;
-        }
+    for (const auto& decodedTx : decodedTxs) {
+        const CTransaction& tx = *decodedTx.tx;
 
         if (tx.nType == TRANSACTION_PROVIDER_REGISTER) {
-            CProRegTx proTx;
-            if (!GetTxPayload(tx, proTx)) {
+            if (!decodedTx.fDecoded) {
                 return _state.DoS(100, false, REJECT_INVALID, "bad-protx-payload");
             }
+            const CProRegTx& proTx = decodedTx.proRegTx;
 
             auto dmn = std::make_shared<CDeterministicMN>(newList.GetTotalRegisteredCount());
             dmn->proTxHash = tx.GetHash();
@@ -787,10 +954,10 @@ bool CDeterministicMNManager::BuildNewListFromBlock(const CBlock& block, const C
                     __func__, tx.GetHash().ToString(), nHeight, proTx.ToString());
             }
         } else if (tx.nType == TRANSACTION_PROVIDER_UPDATE_SERVICE) {
-            CProUpServTx proTx;
-            if (!GetTxPayload(tx, proTx)) {
+            if (!decodedTx.fDecoded) {
                 return _state.DoS(100, false, REJECT_INVALID, "bad-protx-payload");
             }
+            const CProUpServTx& proTx = decodedTx.proUpServTx;
 
             if (newList.HasUniqueProperty(proTx.addr) && newList.GetUniquePropertyMN(proTx.addr)->proTxHash != proTx.proTxHash) {
                 return _state.DoS(100, false, REJECT_DUPLICATE, "bad-protx-dup-addr");
@@ -821,10 +988,10 @@ bool CDeterministicMNManager::BuildNewListFromBlock(const CBlock& block, const C
                     __func__, proTx.proTxHash.ToString(), nHeight, proTx.ToString());
             }
         } else if (tx.nType == TRANSACTION_PROVIDER_UPDATE_REGISTRAR) {
-            CProUpRegTx proTx;
-            if (!GetTxPayload(tx, proTx)) {
+            if (!decodedTx.fDecoded) {
                 return _state.DoS(100, false, REJECT_INVALID, "bad-protx-payload");
             }
+            const CProUpRegTx& proTx = decodedTx.proUpRegTx;
 
             CDeterministicMNCPtr dmn = newList.GetMN(proTx.proTxHash);
             if (!dmn) {
@@ -847,10 +1014,10 @@ bool CDeterministicMNManager::BuildNewListFromBlock(const CBlock& block, const C
                     __func__, proTx.proTxHash.ToString(), nHeight, proTx.ToString());
             }
         } else if (tx.nType == TRANSACTION_PROVIDER_UPDATE_REVOKE) {
-            CProUpRevTx proTx;
-            if (!GetTxPayload(tx, proTx)) {
+            if (!decodedTx.fDecoded) {
                 return _state.DoS(100, false, REJECT_INVALID, "bad-protx-payload");
             }
+            const CProUpRevTx& proTx = decodedTx.proUpRevTx;
 
             CDeterministicMNCPtr dmn = newList.GetMN(proTx.proTxHash);
             if (!dmn) {
@@ -868,10 +1035,10 @@ bool CDeterministicMNManager::BuildNewListFromBlock(const CBlock& block, const C
                     __func__, proTx.proTxHash.ToString(), nHeight, proTx.ToString());
             }
         } else if (tx.nType == TRANSACTION_QUORUM_COMMITMENT) {
-            llmq::CFinalCommitmentTxPayload qc;
-            if (!GetTxPayload(tx, qc)) {
+            if (!decodedTx.fDecoded) {
                 return _state.DoS(100, false, REJECT_INVALID, "bad-qc-payload");
             }
+            llmq::CFinalCommitmentTxPayload qc = decodedTx.qc;
             if (!qc.commitment.IsNull()) {
                 const auto& params = Params().GetConsensus().llmqs.at(qc.commitment.llmqType);
                 uint32_t quorumHeight = qc.nHeight - (qc.nHeight % params.dkgInterval);
@@ -943,11 +1110,13 @@ void CDeterministicMNManager::DecreasePoSePenalties(CDeterministicMNList& mnList
     toDecrease.reserve(mnList.GetValidMNsCount() / 10);
     // only iterate and decrease for valid ones (not PoSe banned yet)
     // if a MN ever reaches the maximum, it stays in PoSe banned state until revived
-    mnList.ForEachMN(true, [&](const CDeterministicMNCPtr& dmn) {
-        if (dmn->pdmnState->nPoSePenalty > 0 && !dmn->pdmnState->IsBanned()) {
-            toDecrease.emplace_back(dmn->proTxHash);
+    // mnList is usually still unmodified at this point, so its hot fields are shared with the (cached) previous list
+    const auto& hot = mnList.GetHotFields();
+    for (size_t i = 0; i < hot.size(); i++) {
+        if (hot.fValid[i] && hot.nPoSePenalty[i] > 0) {
+            toDecrease.emplace_back(hot.dmns[i]->proTxHash);
         }
-    });
+    }
 
     for (const auto& proTxHash : toDecrease) {
         mnList.PoSeDecrease(proTxHash);
@@ -956,48 +1125,99 @@ void CDeterministicMNManager::DecreasePoSePenalties(CDeterministicMNList& mnList
 
 CDeterministicMNList CDeterministicMNManager::GetListForBlock(const CBlockIndex* pindex)
 {
-    LOCK(cs);
+    const uint256& blockHash = pindex->GetBlockHash();
+
+    std::promise<CDeterministicMNList> buildPromise;
+    std::shared_future<CDeterministicMNList> buildFuture;
+    {
+        LOCK(cacheCs);
+        auto itLists = mnListsCache.find(blockHash);
+        if (itLists != mnListsCache.end()) {
+            nCacheHits++;
+            return itLists->second;
+        }
+        nCacheMisses++;
+        auto itBuilds = mnListBuildsInFlight.find(blockHash);
+        if (itBuilds != mnListBuildsInFlight.end()) {
+            buildFuture = itBuilds->second;
+        } else {
+            mnListBuildsInFlight.emplace(blockHash, buildPromise.get_future().share());
+        }
+    }
+
+    if (buildFuture.valid()) {
+        // some other thread is already building this list
+        return buildFuture.get();
+    }
+
+    try {
+        CDeterministicMNList snapshot = BuildListForBlock(pindex);
+        buildPromise.set_value(snapshot);
+        LOCK(cacheCs);
+        mnListBuildsInFlight.erase(blockHash);
+        return snapshot;
+    } catch (...) {
+        buildPromise.set_exception(std::current_exception());
+        LOCK(cacheCs);
+        mnListBuildsInFlight.erase(blockHash);
+        throw;
+    }
+}
+
+CDeterministicMNList CDeterministicMNManager::BuildListForBlock(const CBlockIndex* pindex)
+{
+    int64_t nTimeStart = GetTimeMicros();
+    const CBlockIndex* pindexRequested = pindex;
 
     CDeterministicMNList snapshot;
-    std::list<const CBlockIndex*> listDiffIndexes;
+    std::list<std::pair<const CBlockIndex*, CDeterministicMNListDiff>> listDiffs;
 
     while (true) {
-        // try using cache before reading from disk
-        auto itLists = mnListsCache.find(pindex->GetBlockHash());
-        if (itLists != mnListsCache.end()) {
-            snapshot = itLists->second;
-            break;
+        {
+            // try using cache before reading from disk
+            LOCK(cacheCs);
+            auto itLists = mnListsCache.find(pindex->GetBlockHash());
+            if (itLists != mnListsCache.end()) {
+                snapshot = itLists->second;
+                break;
+            }
+
+            auto itDiffs = mnListDiffsCache.find(pindex->GetBlockHash());
+            if (itDiffs != mnListDiffsCache.end()) {
+                listDiffs.emplace_front(pindex, itDiffs->second);
+                pindex = pindex->pprev;
+                continue;
+            }
         }
 
         if (evoDb.Read(std::make_pair(DB_LIST_SNAPSHOT, pindex->GetBlockHash()), snapshot)) {
-            mnListsCache.emplace(pindex->GetBlockHash(), snapshot);
+            LOCK(cacheCs);
+            AddListToCache(snapshot);
             break;
         }
 
         // no snapshot found yet, check diffs
-        auto itDiffs = mnListDiffsCache.find(pindex->GetBlockHash());
-        if (itDiffs != mnListDiffsCache.end()) {
-            listDiffIndexes.emplace_front(pindex);
-            pindex = pindex->pprev;
-            continue;
-        }
-
         CDeterministicMNListDiff diff;
         if (!evoDb.Read(std::make_pair(DB_LIST_DIFF, pindex->GetBlockHash()), diff)) {
             // no snapshot and no diff on disk means that it's the initial snapshot
             snapshot = CDeterministicMNList(pindex->GetBlockHash(), -1, 0);
-            mnListsCache.emplace(pindex->GetBlockHash(), snapshot);
+            LOCK(cacheCs);
+            AddListToCache(snapshot);
             break;
         }
 
         diff.nHeight = pindex->nHeight;
-        mnListDiffsCache.emplace(pindex->GetBlockHash(), std::move(diff));
-        listDiffIndexes.emplace_front(pindex);
+        {
+            LOCK(cacheCs);
+            AddDiffToCache(pindex->GetBlockHash(), diff);
+        }
+        listDiffs.emplace_front(pindex, std::move(diff));
         pindex = pindex->pprev;
     }
 
-    for (const auto& diffIndex : listDiffIndexes) {
-        const auto& diff = mnListDiffsCache.at(diffIndex->GetBlockHash());
+    for (const auto& p : listDiffs) {
+        const CBlockIndex* diffIndex = p.first;
+        const auto& diff = p.second;
         if (diff.HasChanges()) {
             snapshot = snapshot.ApplyDiff(diffIndex, diff);
         } else {
@@ -1006,18 +1226,27 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlock(const CBlockIndex*
         }
     }
 
-    if (tipIndex) {
-        // always keep a snapshot for the tip
-        if (snapshot.GetBlockHash() == tipIndex->GetBlockHash()) {
-            mnListsCache.emplace(snapshot.GetBlockHash(), snapshot);
-        } else {
-            // keep snapshots for yet alive quorums
-            for (auto& p_llmq : Params().GetConsensus().llmqs) {
-                if ((snapshot.GetHeight() % p_llmq.second.dkgInterval == 0) && (snapshot.GetHeight() + p_llmq.second.dkgInterval * (p_llmq.second.keepOldConnections + 1) >= tipIndex->nHeight)) {
-                    mnListsCache.emplace(snapshot.GetBlockHash(), snapshot);
-                    break;
-                }
-            }
+    int64_t nTimeReplay = GetTimeMicros() - nTimeStart;
+    statsClient.gauge("masternodes.listReplay.diffs", listDiffs.size(), 1.0f);
+    statsClient.timing("masternodes.listReplay_ms", nTimeReplay / 1000, 1.0f);
+
+    if (listDiffs.size() > CHECKPOINT_PERIOD) {
+        LogPrint(BCLog::BENCHMARK, "CDeterministicMNManager::%s -- replayed %d diffs for block %s at height %d: %.2fms\n", __func__,
+                 listDiffs.size(), pindexRequested->GetBlockHash().ToString(), pindexRequested->nHeight, nTimeReplay * 0.001);
+
+        const CBlockIndex* pindexCheckpoint = pindexRequested->GetAncestor(pindexRequested->nHeight - pindexRequested->nHeight % CHECKPOINT_PERIOD);
+        LOCK(cacheCs);
+        if (checkpointCandidates.size() < MAX_CHECKPOINT_CANDIDATES || checkpointCandidates.count(pindexCheckpoint)) {
+            checkpointCandidates[pindexCheckpoint]++;
+        }
+    }
+
+    const CBlockIndex* pindexTip = tipIndex;
+    if (pindexTip) {
+        if (snapshot.GetBlockHash() == pindexTip->GetBlockHash() || IsListUsedByAliveQuorum(snapshot.GetHeight(), pindexTip->nHeight)) {
+            // always keep a snapshot for the tip and for yet alive quorums
+            LOCK(cacheCs);
+            AddListToCache(snapshot);
         }
     }
 
@@ -1026,11 +1255,11 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlock(const CBlockIndex*
 
 CDeterministicMNList CDeterministicMNManager::GetListAtChainTip()
 {
-    LOCK(cs);
-    if (!tipIndex) {
+    const CBlockIndex* pindexTip = tipIndex;
+    if (!pindexTip) {
         return {};
     }
-    return GetListForBlock(tipIndex);
+    return GetListForBlock(pindexTip);
 }
 
 bool CDeterministicMNManager::IsProTxWithCollateral(const CTransactionRef& tx, uint32_t n)
@@ -1060,15 +1289,48 @@ bool CDeterministicMNManager::IsDIP3Enforced(int nHeight)
     LOCK(cs);
 
     if (nHeight == -1) {
-        nHeight = tipIndex->nHeight;
+        nHeight = tipIndex.load()->nHeight;
     }
 
     return nHeight >= Params().GetConsensus().DIP0003EnforcementHeight;
 }
 
+void CDeterministicMNManager::DoMaintenance()
+{
+    std::vector<const CBlockIndex*> toWrite;
+    {
+        LOCK(cacheCs);
+        for (auto it = checkpointCandidates.begin(); it != checkpointCandidates.end(); ) {
+            if (it->second >= CHECKPOINT_MIN_REQUESTS) {
+                toWrite.emplace_back(it->first);
+                it = checkpointCandidates.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (checkpointCandidates.size() >= MAX_CHECKPOINT_CANDIDATES) {
+            // only rarely requested blocks are left, start over
+            checkpointCandidates.clear();
+        }
+    }
+
+    for (const auto pindex : toWrite) {
+        // Lists are immutable per block hash, so it's fine to write this outside of block processing (and even if
+        // the block gets disconnected later). The snapshot is written directly as it has nothing to do with the
+        // current evodb transaction
+        CDeterministicMNList snapshot = GetListForBlock(pindex);
+        evoDb.GetRawDB().Write(std::make_pair(DB_LIST_SNAPSHOT, pindex->GetBlockHash()), snapshot);
+        LogPrintf("CDeterministicMNManager::%s -- Wrote checkpoint snapshot. nHeight=%d, blockHash=%s\n", __func__,
+                  pindex->nHeight, pindex->GetBlockHash().ToString());
+    }
+}
+
 void CDeterministicMNManager::CleanupCache(int nHeight)
 {
     AssertLockHeld(cs);
+    LOCK(cacheCs);
+
+    const CBlockIndex* pindexTip = tipIndex;
 
     std::vector<uint256> toDeleteLists;
     std::vector<uint256> toDeleteDiffs;
@@ -1077,19 +1339,12 @@ void CDeterministicMNManager::CleanupCache(int nHeight)
             toDeleteLists.emplace_back(p.first);
             continue;
         }
-        bool fQuorumCache{false};
-        for (auto& p_llmq : Params().GetConsensus().llmqs) {
-            if ((p.second.GetHeight() % p_llmq.second.dkgInterval == 0) && (p.second.GetHeight() + p_llmq.second.dkgInterval * (p_llmq.second.keepOldConnections + 1) >= nHeight)) {
-                fQuorumCache = true;
-                break;
-            }
-        }
-        if (fQuorumCache) {
+        if (IsListUsedByAliveQuorum(p.second.GetHeight(), nHeight)) {
             // at least one quorum could be using it, keep it
             continue;
         }
         // no alive quorums using it, see if it was a cache for the tip or for a now outdated quorum
-        if (tipIndex && tipIndex->pprev && (p.first == tipIndex->pprev->GetBlockHash())) {
+        if (pindexTip && pindexTip->pprev && (p.first == pindexTip->pprev->GetBlockHash())) {
             toDeleteLists.emplace_back(p.first);
         } else {
             for (auto& p_llmq : Params().GetConsensus().llmqs) {
@@ -1101,7 +1356,7 @@ void CDeterministicMNManager::CleanupCache(int nHeight)
         }
     }
     for (const auto& h : toDeleteLists) {
-        mnListsCache.erase(h);
+        EraseListFromCache(h);
     }
     for (const auto& p : mnListDiffsCache) {
         if (p.second.nHeight + LIST_DIFFS_CACHE_SIZE < nHeight) {
@@ -1109,10 +1364,120 @@ void CDeterministicMNManager::CleanupCache(int nHeight)
         }
     }
     for (const auto& h : toDeleteDiffs) {
-        mnListDiffsCache.erase(h);
+        EraseDiffFromCache(h);
     }
 }
 
+// Lists share most of their immer nodes with the lists of neighbouring blocks, so this is only a rough upper bound
+static size_t EstimateListUsage(const CDeterministicMNList& mnList)
+{
+    // per MN: one entry in mnMap and mnInternalIdMap, ~4 unique properties and one payment queue entry
+    static const size_t MN_ENTRY_USAGE = 400;
+    return sizeof(CDeterministicMNList) + mnList.GetAllMNsCount() * MN_ENTRY_USAGE;
+}
+
+static size_t EstimateDiffUsage(const CDeterministicMNListDiff& diff)
+{
+    return sizeof(CDeterministicMNListDiff) +
+           memusage::DynamicUsage(diff.addedMNs) +
+           diff.addedMNs.size() * (memusage::MallocUsage(sizeof(CDeterministicMN)) + memusage::MallocUsage(sizeof(CDeterministicMNState))) +
+           memusage::DynamicUsage(diff.updatedMNs) +
+           memusage::DynamicUsage(diff.removedMns);
+}
+
+void CDeterministicMNManager::AddListToCache(const CDeterministicMNList& mnList)
+{
+    AssertLockHeld(cacheCs);
+    if (mnListsCache.emplace(mnList.GetBlockHash(), mnList).second) {
+        nListsCacheUsage += EstimateListUsage(mnList);
+        EnforceCacheLimit();
+    }
+}
+
+void CDeterministicMNManager::AddDiffToCache(const uint256& blockHash, const CDeterministicMNListDiff& diff)
+{
+    AssertLockHeld(cacheCs);
+    if (mnListDiffsCache.emplace(blockHash, diff).second) {
+        nDiffsCacheUsage += EstimateDiffUsage(diff);
+        EnforceCacheLimit();
+    }
+}
+
+void CDeterministicMNManager::EraseListFromCache(const uint256& blockHash)
+{
+    AssertLockHeld(cacheCs);
+    auto it = mnListsCache.find(blockHash);
+    if (it != mnListsCache.end()) {
+        nListsCacheUsage -= EstimateListUsage(it->second);
+        mnListsCache.erase(it);
+    }
+}
+
+void CDeterministicMNManager::EraseDiffFromCache(const uint256& blockHash)
+{
+    AssertLockHeld(cacheCs);
+    auto it = mnListDiffsCache.find(blockHash);
+    if (it != mnListDiffsCache.end()) {
+        nDiffsCacheUsage -= EstimateDiffUsage(it->second);
+        mnListDiffsCache.erase(it);
+    }
+}
+
+void CDeterministicMNManager::EnforceCacheLimit()
+{
+    AssertLockHeld(cacheCs);
+
+    if (nListsCacheUsage + nDiffsCacheUsage <= nMaxCacheUsage) {
+        return;
+    }
+
+    const CBlockIndex* pindexTip = tipIndex;
+    int nTipHeight = pindexTip ? pindexTip->nHeight : 0;
+
+    // Evict the oldest entries first. Lists for the tip and for alive quorums are never evicted, all other lists and
+    // all diffs can be re-read from disk when needed again. Evict a bit more than needed so that this doesn't run
+    // again for every single new entry
+    std::vector<std::tuple<int, bool, uint256>> candidates;
+    for (const auto& p : mnListsCache) {
+        if ((pindexTip && p.first == pindexTip->GetBlockHash()) || IsListUsedByAliveQuorum(p.second.GetHeight(), nTipHeight)) {
+            continue;
+        }
+        candidates.emplace_back(p.second.GetHeight(), true, p.first);
+    }
+    for (const auto& p : mnListDiffsCache) {
+        candidates.emplace_back(p.second.nHeight, false, p.first);
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    size_t nTargetUsage = nMaxCacheUsage / 10 * 9;
+    for (const auto& c : candidates) {
+        if (nListsCacheUsage + nDiffsCacheUsage <= nTargetUsage) {
+            break;
+        }
+        if (std::get<1>(c)) {
+            EraseListFromCache(std::get<2>(c));
+        } else {
+            EraseDiffFromCache(std::get<2>(c));
+        }
+        nCacheEvictions++;
+    }
+}
+
+CDeterministicMNManager::CacheStats CDeterministicMNManager::GetCacheStats()
+{
+    LOCK(cacheCs);
+    CacheStats stats;
+    stats.nLists = mnListsCache.size();
+    stats.nDiffs = mnListDiffsCache.size();
+    stats.nListsUsage = nListsCacheUsage;
+    stats.nDiffsUsage = nDiffsCacheUsage;
+    stats.nMaxUsage = nMaxCacheUsage;
+    stats.nHits = nCacheHits;
+    stats.nMisses = nCacheMisses;
+    stats.nEvictions = nCacheEvictions;
+    return stats;
+}
+
 void CDeterministicMNManager::UpgradeDiff(CDBBatch& batch, const CBlockIndex* pindexNext, const CDeterministicMNList& curMNList, CDeterministicMNList& newMNList)
 {
     CDataStream oldDiffData(SER_DISK, CLIENT_VERSION);
@@ -14,9 +14,13 @@
 #include <saltedhasher.h>
 #include <sync.h>
 
+#include <immer/flex_vector.hpp>
 #include <immer/map.hpp>
 #include <immer/map_transient.hpp>
 
+#include <atomic>
+#include <future>
+#include <mutex>
 #include <unordered_map>
 
 class CBlock;
@@ -268,6 +272,20 @@ typedef std::shared_ptr<const CDeterministicMN> CDeterministicMNCPtr;
 
 class CDeterministicMNListDiff;
 
+// Flat copy of the MN fields that hot loops need, one entry per MN (in no particular order). This avoids chasing
+// the CDeterministicMN and CDeterministicMNState pointers for every MN. The immer maps of the list stay the source of
+// truth, see CDeterministicMNList::GetHotFields
+struct CDeterministicMNListHotFields
+{
+    std::vector<CDeterministicMNCPtr> dmns;
+    std::vector<uint8_t> fValid;
+    std::vector<int> nPoSePenalty;
+    // null if not confirmed yet
+    std::vector<uint256> confirmedHashWithProRegTxHash;
+
+    size_t size() const { return dmns.size(); }
+};
+
 template <typename Stream, typename K, typename T, typename Hash, typename Equal>
 void SerializeImmerMap(Stream& os, const immer::map<K, T, Hash, Equal>& m)
 {
@@ -309,6 +327,7 @@ public:
     typedef immer::map<uint256, CDeterministicMNCPtr> MnMap;
     typedef immer::map<uint64_t, uint256> MnInternalIdMap;
     typedef immer::map<uint256, std::pair<uint256, uint32_t> > MnUniquePropertyMap;
+    typedef immer::flex_vector<CDeterministicMNCPtr> MnPaymentQueue;
 
 private:
     uint256 blockHash;
@@ -321,6 +340,18 @@ private:
     // we keep track of this as checking for duplicates would otherwise be painfully slow
     MnUniquePropertyMap mnUniquePropertyMap;
 
+    // all valid MNs, ordered by payment order (see CompareByLastPaid). Kept up-to-date by AddMN/UpdateMN/RemoveMN so
+    // that payee selection doesn't need to iterate and sort all MNs. Not serialized, it's rebuilt while AddMN is called
+    // for every MN in Unserialize
+    MnPaymentQueue paymentQueue;
+
+    struct HotFieldsHolder {
+        std::once_flag once;
+        std::unique_ptr<const CDeterministicMNListHotFields> fields;
+    };
+    // built on first use and shared by all copies of the same list version
+    std::shared_ptr<HotFieldsHolder> hotFields{std::make_shared<HotFieldsHolder>()};
+
 public:
     CDeterministicMNList() = default;
     explicit CDeterministicMNList(const uint256& _blockHash, int _height, uint32_t _totalRegisteredCount) :
@@ -354,6 +385,8 @@ public:
         mnMap = MnMap();
         mnUniquePropertyMap = MnUniquePropertyMap();
         mnInternalIdMap = MnInternalIdMap();
+        paymentQueue = MnPaymentQueue();
+        InvalidateHotFields();
 
         SerializationOpBase(s, CSerActionUnserialize());
 
@@ -371,15 +404,12 @@ public:
 
     size_t GetValidMNsCount() const
     {
-        size_t count = 0;
-        for (const auto& p : mnMap) {
-            if (IsMNValid(p.second)) {
-                count++;
-            }
-        }
-        return count;
+        return paymentQueue.size();
     }
 
+    // Returns the flat copy of hot MN fields of this list version. The reference is valid until the list is modified
+    const CDeterministicMNListHotFields& GetHotFields() const;
+
     template <typename Callback>
     void ForEachMN(bool onlyValid, Callback&& cb) const
     {
@@ -453,7 +483,13 @@ public:
      * @return
      */
     std::vector<CDeterministicMNCPtr> CalculateQuorum(size_t maxSize, const uint256& modifier) const;
+    /**
+     * Same as CalculateQuorum, but for multiple (maxSize, modifier) pairs at once. The scores for all modifiers are
+     * calculated in a single pass over the list
+     */
+    std::vector<std::vector<CDeterministicMNCPtr>> CalculateQuorums(const std::vector<std::pair<size_t, uint256>>& quorums) const;
     std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>> CalculateScores(const uint256& modifier) const;
+    std::vector<std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>>> CalculateScores(const std::vector<uint256>& modifiers) const;
 
     /**
      * Calculates the maximum penalty which is allowed at the height of this MN list. It is dynamic and might change
@@ -514,6 +550,10 @@ public:
     }
 
 private:
+    void AddToPaymentQueue(const CDeterministicMNCPtr& dmn);
+    void RemoveFromPaymentQueue(const CDeterministicMNCPtr& dmn);
+    void InvalidateHotFields();
+
     template <typename T>
     NODISCARD bool AddUniqueProperty(const CDeterministicMNCPtr& dmn, const T& v)
     {
@@ -663,21 +703,59 @@ public:
     }
 };
 
+static const int DEFAULT_MNLIST_SNAPSHOT_PERIOD = 576; // once per day
+static const int64_t DEFAULT_MNLIST_CACHE_MB = 128;
+
 class CDeterministicMNManager
 {
-    static const int DISK_SNAPSHOT_PERIOD = 576; // once per day
+    static const int DISK_SNAPSHOT_PERIOD = DEFAULT_MNLIST_SNAPSHOT_PERIOD;
     static const int DISK_SNAPSHOTS = 3; // keep cache for 3 disk snapshots to have 2 full days covered
     static const int LIST_DIFFS_CACHE_SIZE = DISK_SNAPSHOT_PERIOD * DISK_SNAPSHOTS;
+    // lookups that replay more diffs than this make the block at the last multiple of it a checkpoint candidate
+    static const int CHECKPOINT_PERIOD = 64;
+    // a candidate gets an in-between snapshot (checkpoint) written once it was hit this often
+    static const int CHECKPOINT_MIN_REQUESTS = 2;
+    static const size_t MAX_CHECKPOINT_CANDIDATES = 10000;
 
 public:
     CCriticalSection cs;
 
+    struct CacheStats {
+        size_t nLists{0};
+        size_t nDiffs{0};
+        size_t nListsUsage{0};
+        size_t nDiffsUsage{0};
+        size_t nMaxUsage{0};
+        uint64_t nHits{0};
+        uint64_t nMisses{0};
+        uint64_t nEvictions{0};
+    };
+
 private:
     CEvoDB& evoDb;
 
+    // Protects the caches below. GetListForBlock only takes this (and never cs), so that lookups for old blocks from
+    // other threads don't stall block processing. Lists and diffs are immutable per block hash, so any thread
+    // may fill the caches
+    CCriticalSection cacheCs;
     std::unordered_map<uint256, CDeterministicMNList, StaticSaltedHasher> mnListsCache;
     std::unordered_map<uint256, CDeterministicMNListDiff, StaticSaltedHasher> mnListDiffsCache;
-    const CBlockIndex* tipIndex{nullptr};
+    // lists that are currently being built by some thread. Other callers for the same block wait for that result
+    // instead of building it again
+    std::unordered_map<uint256, std::shared_future<CDeterministicMNList>, StaticSaltedHasher> mnListBuildsInFlight;
+    // estimated memory usage of both caches, limited by -mnlistcachemb
+    const size_t nMaxCacheUsage;
+    size_t nListsCacheUsage{0};
+    size_t nDiffsCacheUsage{0};
+    uint64_t nCacheHits{0};
+    uint64_t nCacheMisses{0};
+    uint64_t nCacheEvictions{0};
+    std::atomic<const CBlockIndex*> tipIndex{nullptr};
+
+    // see -mnlistsnapshotperiod
+    const int nSnapshotPeriod;
+    // checkpoint candidates and how often they were hit, protected by cacheCs
+    std::map<const CBlockIndex*, int> checkpointCandidates;
 
 public:
     explicit CDeterministicMNManager(CEvoDB& _evoDb);
@@ -700,13 +778,26 @@ public:
 
     bool IsDIP3Enforced(int nHeight = -1);
 
+    // Writes in-between snapshots for blocks whose lists were repeatedly expensive to build
+    void DoMaintenance();
+
+    CacheStats GetCacheStats();
+
 public:
     // TODO these can all be removed in a future version
     void UpgradeDiff(CDBBatch& batch, const CBlockIndex* pindexNext, const CDeterministicMNList& curMNList, CDeterministicMNList& newMNList);
     bool UpgradeDBIfNeeded();
 
 private:
+    CDeterministicMNList BuildListForBlock(const CBlockIndex* pindex);
     void CleanupCache(int nHeight);
+
+    // all of these require cacheCs
+    void AddListToCache(const CDeterministicMNList& mnList);
+    void AddDiffToCache(const uint256& blockHash, const CDeterministicMNListDiff& diff);
+    void EraseListFromCache(const uint256& blockHash);
+    void EraseDiffFromCache(const uint256& blockHash);
+    void EnforceCacheLimit();
 };
 
 extern std::unique_ptr<CDeterministicMNManager> deterministicMNManager;
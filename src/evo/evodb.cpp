@@ -4,6 +4,9 @@
 
 #include <evo/evodb.h>
 
+#include <hash.h>
+#include <random.h>
+
 std::unique_ptr<CEvoDB> evoDb;
 
 CEvoDBScopedCommitter::CEvoDBScopedCommitter(CEvoDB &_evoDB) :
@@ -32,11 +35,33 @@ void CEvoDBScopedCommitter::Rollback()
 }
 
 CEvoDB::CEvoDB(size_t nCacheSize, bool fMemory, bool fWipe) :
-    db(fMemory ? "" : (GetDataDir() / "evodb"), nCacheSize, fMemory, fWipe),
+    db(fMemory ? "" : (GetDataDir() / "evodb"), GetDefaultDBOptions(DBRole::EVO, nCacheSize), fMemory, fWipe),
     rootBatch(db),
     rootDBTransaction(db, rootBatch),
-    curDBTransaction(rootDBTransaction, rootDBTransaction)
+    curDBTransaction(rootDBTransaction, rootDBTransaction),
+    nDirtyKeySalt0(GetRand(std::numeric_limits<uint64_t>::max())),
+    nDirtyKeySalt1(GetRand(std::numeric_limits<uint64_t>::max()))
+{
+}
+
+uint64_t CEvoDB::GetDirtyKeyHash(const CDataStream& ssKey) const
 {
+    return CSipHasher(nDirtyKeySalt0, nDirtyKeySalt1).Write((const unsigned char*)ssKey.data(), ssKey.size()).Finalize();
+}
+
+bool CEvoDB::IsDirtyKey(const CDataStream& ssKey)
+{
+    const uint64_t nHash = GetDirtyKeyHash(ssKey);
+    LOCK(cs_dirty);
+    return setDirtyKeys.count(nHash) != 0;
+}
+
+void CEvoDB::MarkDirtyKey(const CDataStream& ssKey)
+{
+    AssertLockHeld(cs);
+    const uint64_t nHash = GetDirtyKeyHash(ssKey);
+    LOCK(cs_dirty);
+    setDirtyKeys.emplace(nHash);
 }
 
 void CEvoDB::CommitCurTransaction()
@@ -58,6 +83,11 @@ bool CEvoDB::CommitRootTransaction()
     rootDBTransaction.Commit();
     bool ret = db.WriteBatch(rootBatch);
     rootBatch.Clear();
+    if (ret) {
+        // only now the database has the values which were read from the transactions before
+        LOCK(cs_dirty);
+        setDirtyKeys.clear();
+    }
     return ret;
 }
 
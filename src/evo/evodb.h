@@ -9,6 +9,8 @@
 #include <sync.h>
 #include <uint256.h>
 
+#include <unordered_set>
+
 // "b_b" was used in the initial version of deterministic MN storage
 // "b_b2" was used after compact diffs were introduced
 static const std::string EVODB_BEST_BLOCK = "b_b2";
@@ -43,6 +45,27 @@ private:
     RootTransaction rootDBTransaction;
     CurTransaction curDBTransaction;
 
+    // Salted hashes of the keys which were written or erased since the last CommitRootTransaction (including ones of
+    // rolled back transactions). All other keys are the same in the transactions and in the database, so reads of them
+    // go straight to the database without taking cs, which is held for long while blocks are connected.
+    CCriticalSection cs_dirty;
+    std::unordered_set<uint64_t> setDirtyKeys GUARDED_BY(cs_dirty);
+    const uint64_t nDirtyKeySalt0;
+    const uint64_t nDirtyKeySalt1;
+
+    uint64_t GetDirtyKeyHash(const CDataStream& ssKey) const;
+    bool IsDirtyKey(const CDataStream& ssKey);
+    void MarkDirtyKey(const CDataStream& ssKey);
+
+    template <typename K>
+    static CDataStream KeyToDataStream(const K& key)
+    {
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
+        ssKey << key;
+        return ssKey;
+    }
+
 public:
     explicit CEvoDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
 
@@ -52,6 +75,7 @@ public:
         return std::make_unique<CEvoDBScopedCommitter>(*this);
     }
 
+    // Only for iterating, writes must go through Write() and Erase() so that the written keys are known
     CurTransaction& GetCurTransaction()
     {
         AssertLockHeld(cs); // lock must be held from outside as long as the DB transaction is used
@@ -61,29 +85,41 @@ public:
     template <typename K, typename V>
     bool Read(const K& key, V& value)
     {
+        const CDataStream ssKey = KeyToDataStream(key);
+        if (!IsDirtyKey(ssKey)) {
+            return db.Read(ssKey, value);
+        }
         LOCK(cs);
-        return curDBTransaction.Read(key, value);
+        return curDBTransaction.Read(ssKey, value);
     }
 
     template <typename K, typename V>
     void Write(const K& key, const V& value)
     {
+        const CDataStream ssKey = KeyToDataStream(key);
         LOCK(cs);
-        curDBTransaction.Write(key, value);
+        MarkDirtyKey(ssKey);
+        curDBTransaction.Write(ssKey, value);
     }
 
     template <typename K>
     bool Exists(const K& key)
     {
+        const CDataStream ssKey = KeyToDataStream(key);
+        if (!IsDirtyKey(ssKey)) {
+            return db.Exists(ssKey);
+        }
         LOCK(cs);
-        return curDBTransaction.Exists(key);
+        return curDBTransaction.Exists(ssKey);
     }
 
     template <typename K>
     void Erase(const K& key)
     {
+        const CDataStream ssKey = KeyToDataStream(key);
         LOCK(cs);
-        curDBTransaction.Erase(key);
+        MarkDirtyKey(ssKey);
+        curDBTransaction.Erase(ssKey);
     }
 
     CDBWrapper& GetRawDB()
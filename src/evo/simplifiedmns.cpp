@@ -13,6 +13,7 @@
 #include <base58.h>
 #include <chainparams.h>
 #include <consensus/merkle.h>
+#include <streams.h>
 #include <univalue.h>
 #include <validation.h>
 
@@ -180,35 +181,48 @@ void CSimplifiedMNListDiff::ToJson(UniValue& obj) const
     }
 }
 
-bool BuildSimplifiedMNListDiff(const uint256& baseBlockHash, const uint256& blockHash, CSimplifiedMNListDiff& mnListDiffRet, std::string& errorRet)
+static bool LookupDiffBlocks(const uint256& baseBlockHash, const uint256& blockHash, const CBlockIndex*& baseBlockIndexRet, const CBlockIndex*& blockIndexRet, std::string& errorRet)
 {
     AssertLockHeld(cs_main);
-    mnListDiffRet = CSimplifiedMNListDiff();
 
-    const CBlockIndex* baseBlockIndex = chainActive.Genesis();
+    baseBlockIndexRet = chainActive.Genesis();
     if (!baseBlockHash.IsNull()) {
-        baseBlockIndex = LookupBlockIndex(baseBlockHash);
-        if (!baseBlockIndex) {
+        baseBlockIndexRet = LookupBlockIndex(baseBlockHash);
+        if (!baseBlockIndexRet) {
             errorRet = strprintf("block %s not found", baseBlockHash.ToString());
             return false;
         }
     }
 
-    const CBlockIndex* blockIndex = LookupBlockIndex(blockHash);
-    if (!blockIndex) {
+    blockIndexRet = LookupBlockIndex(blockHash);
+    if (!blockIndexRet) {
         errorRet = strprintf("block %s not found", blockHash.ToString());
         return false;
     }
 
-    if (!chainActive.Contains(baseBlockIndex) || !chainActive.Contains(blockIndex)) {
+    if (!chainActive.Contains(baseBlockIndexRet) || !chainActive.Contains(blockIndexRet)) {
         errorRet = strprintf("block %s and %s are not in the same chain", baseBlockHash.ToString(), blockHash.ToString());
         return false;
     }
-    if (baseBlockIndex->nHeight > blockIndex->nHeight) {
+    if (baseBlockIndexRet->nHeight > blockIndexRet->nHeight) {
         errorRet = strprintf("base block %s is higher then block %s", baseBlockHash.ToString(), blockHash.ToString());
         return false;
     }
 
+    return true;
+}
+
+bool BuildSimplifiedMNListDiff(const uint256& baseBlockHash, const uint256& blockHash, CSimplifiedMNListDiff& mnListDiffRet, std::string& errorRet)
+{
+    AssertLockHeld(cs_main);
+    mnListDiffRet = CSimplifiedMNListDiff();
+
+    const CBlockIndex* baseBlockIndex;
+    const CBlockIndex* blockIndex;
+    if (!LookupDiffBlocks(baseBlockHash, blockHash, baseBlockIndex, blockIndex, errorRet)) {
+        return false;
+    }
+
     LOCK(deterministicMNManager->cs);
 
     auto baseDmnList = deterministicMNManager->GetListForBlock(baseBlockIndex);
@@ -244,3 +258,107 @@ bool BuildSimplifiedMNListDiff(const uint256& baseBlockHash, const uint256& bloc
 
     return true;
 }
+
+CSimplifiedMNListDiffCache mnListDiffCache;
+
+uint256 CSimplifiedMNListDiffCache::BuildCacheKey(const uint256& baseBlockHash, const uint256& blockHash, int nVersion)
+{
+    // the serialized diff only depends on the version through the quorums part
+    CHashWriter hw(SER_GETHASH, 0);
+    hw << baseBlockHash;
+    hw << blockHash;
+    hw << (nVersion >= LLMQS_PROTO_VERSION);
+    return hw.GetHash();
+}
+
+bool CSimplifiedMNListDiffCache::BuildSerializedDiff(const uint256& baseBlockHash, const uint256& blockHash, int nVersion, std::shared_ptr<const std::vector<unsigned char>>& dataRet, std::string& errorRet)
+{
+    AssertLockHeld(cs_main);
+
+    CSimplifiedMNListDiff mnListDiff;
+    if (!BuildSimplifiedMNListDiff(baseBlockHash, blockHash, mnListDiff, errorRet)) {
+        return false;
+    }
+
+    auto data = std::make_shared<std::vector<unsigned char>>();
+    CVectorWriter{SER_NETWORK, nVersion, *data, 0, mnListDiff};
+    dataRet = std::move(data);
+    return true;
+}
+
+bool CSimplifiedMNListDiffCache::GetSerializedDiff(const uint256& baseBlockHash, const uint256& blockHash, int nVersion, std::vector<unsigned char>& dataRet, std::string& errorRet)
+{
+    AssertLockHeld(cs_main);
+
+    // cached diffs are only valid while both blocks are part of the active chain
+    const CBlockIndex* baseBlockIndex;
+    const CBlockIndex* blockIndex;
+    if (!LookupDiffBlocks(baseBlockHash, blockHash, baseBlockIndex, blockIndex, errorRet)) {
+        return false;
+    }
+
+    uint256 cacheKey = BuildCacheKey(baseBlockHash, blockHash, nVersion);
+    std::shared_ptr<const std::vector<unsigned char>> data;
+    {
+        LOCK(cs);
+        if (blockHash == tipBlockHash) {
+            auto it = baseRequestCounts.find(baseBlockHash);
+            if (it != baseRequestCounts.end()) {
+                it->second++;
+            } else if (baseRequestCounts.size() < MAX_TRACKED_BASES) {
+                baseRequestCounts.emplace(baseBlockHash, 1);
+            }
+        }
+        serializedDiffs.get(cacheKey, data);
+    }
+
+    if (!data) {
+        if (!BuildSerializedDiff(baseBlockHash, blockHash, nVersion, data, errorRet)) {
+            return false;
+        }
+        LOCK(cs);
+        serializedDiffs.insert(cacheKey, data);
+    }
+
+    dataRet = *data;
+    return true;
+}
+
+void CSimplifiedMNListDiffCache::UpdatedBlockTip(const CBlockIndex* pindexNew)
+{
+    uint256 blockHash = pindexNew->GetBlockHash();
+
+    std::vector<std::pair<uint64_t, uint256>> bases;
+    {
+        LOCK(cs);
+        if (blockHash == tipBlockHash) {
+            return;
+        }
+        for (const auto& p : baseRequestCounts) {
+            if (p.second >= MIN_PREWARM_REQUESTS) {
+                bases.emplace_back(p.second, p.first);
+            }
+        }
+        baseRequestCounts.clear();
+        tipBlockHash = blockHash;
+    }
+
+    std::sort(bases.begin(), bases.end(), std::greater<std::pair<uint64_t, uint256>>());
+    if (bases.size() > MAX_PREWARM_BASES) {
+        bases.resize(MAX_PREWARM_BASES);
+    }
+
+    LOCK(cs_main);
+    for (const auto& p : bases) {
+        std::shared_ptr<const std::vector<unsigned char>> data;
+        std::string strError;
+        if (!BuildSerializedDiff(p.second, blockHash, PROTOCOL_VERSION, data, strError)) {
+            // the new tip might already be reorged away
+            LogPrint(BCLog::NET, "CSimplifiedMNListDiffCache::%s -- failed to build diff for baseBlockHash=%s, blockHash=%s. error=%s\n", __func__,
+                     p.second.ToString(), blockHash.ToString(), strError);
+            continue;
+        }
+        LOCK(cs);
+        serializedDiffs.insert(BuildCacheKey(p.second, blockHash, PROTOCOL_VERSION), data);
+    }
+}
@@ -9,10 +9,17 @@
 #include <merkleblock.h>
 #include <netaddress.h>
 #include <pubkey.h>
+#include <saltedhasher.h>
 #include <serialize.h>
+#include <sync.h>
+#include <unordered_lru_cache.h>
 #include <version.h>
 
+#include <map>
+#include <memory>
+
 class UniValue;
+class CBlockIndex;
 class CDeterministicMNList;
 class CDeterministicMN;
 
@@ -147,4 +154,38 @@ public:
 
 bool BuildSimplifiedMNListDiff(const uint256& baseBlockHash, const uint256& blockHash, CSimplifiedMNListDiff& mnListDiffRet, std::string& errorRet);
 
+/**
+ * Cache of serialized MNLISTDIFF responses, keyed by the requested (baseBlockHash, blockHash) pair and the
+ * serialization variant. Most SPV clients ask for diffs from the same few bases (usually the null/genesis base or a
+ * recent checkpoint) to the tip, so the bases requested towards the tip are counted and the diffs from the most popular
+ * ones are built in advance whenever a new tip arrives.
+ */
+class CSimplifiedMNListDiffCache
+{
+public:
+    static const size_t MAX_CACHED_DIFFS = 32;
+    static const size_t MAX_PREWARM_BASES = 4;
+    static const uint64_t MIN_PREWARM_REQUESTS = 2;
+    static const size_t MAX_TRACKED_BASES = 1024;
+
+private:
+    CCriticalSection cs;
+    unordered_lru_cache<uint256, std::shared_ptr<const std::vector<unsigned char>>, StaticSaltedHasher, MAX_CACHED_DIFFS> serializedDiffs;
+    // number of requests towards the current tip, per (requested) base block hash
+    std::map<uint256, uint64_t> baseRequestCounts;
+    uint256 tipBlockHash;
+
+public:
+    // Returns the serialized diff as it is sent in MNLISTDIFF to a peer with the given send version
+    bool GetSerializedDiff(const uint256& baseBlockHash, const uint256& blockHash, int nVersion, std::vector<unsigned char>& dataRet, std::string& errorRet);
+
+    void UpdatedBlockTip(const CBlockIndex* pindexNew);
+
+private:
+    static uint256 BuildCacheKey(const uint256& baseBlockHash, const uint256& blockHash, int nVersion);
+    bool BuildSerializedDiff(const uint256& baseBlockHash, const uint256& blockHash, int nVersion, std::shared_ptr<const std::vector<unsigned char>>& dataRet, std::string& errorRet);
+};
+
+extern CSimplifiedMNListDiffCache mnListDiffCache;
+
 #endif // BITCOIN_EVO_SIMPLIFIEDMNS_H
@@ -14,8 +14,14 @@ class CBlockIndex;
 class CCoinsViewCache;
 class CValidationState;
 
-bool CheckSpecialTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CValidationState& state, const CCoinsViewCache& view);
-bool ProcessSpecialTxsInBlock(const CBlock& block, const CBlockIndex* pindex, CValidationState& state, const CCoinsViewCache& view, bool fJustCheck, bool fCheckCbTxMerleRoots);
+/** fCheckSigs=false skips the payload signatures of ProTxes, everything else is still checked */
+bool CheckSpecialTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CValidationState& state, const CCoinsViewCache& view, bool fCheckSigs = true);
+/**
+ * fScriptChecks is false for blocks below -assumevalid and when replaying blocks. In that case the CbTx merkle roots,
+ * the ProTx payload signatures and the BLS signatures of final commitments are not verified, the masternode list and
+ * the quorum state are still built from the block.
+ */
+bool ProcessSpecialTxsInBlock(const CBlock& block, const CBlockIndex* pindex, CValidationState& state, const CCoinsViewCache& view, bool fJustCheck, bool fScriptChecks);
 bool UndoSpecialTxsInBlock(const CBlock& block, const CBlockIndex* pindex);
 
 template <typename T>
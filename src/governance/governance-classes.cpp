@@ -120,6 +120,7 @@ bool CGovernanceTriggerManager::AddNewTrigger(uint256 nHash)
     pSuperblock->SetStatus(SEEN_OBJECT_IS_VALID);
 
     mapTrigger.insert(std::make_pair(nHash, pSuperblock));
+    nTriggersVersion++;
 
     return true;
 }
@@ -185,6 +186,7 @@ void CGovernanceTriggerManager::CleanAndRemove()
             LogPrint(BCLog::GOBJECT, "CGovernanceTriggerManager::CleanAndRemove -- Removing trigger object %s\n", strDataAsPlainString);
             // delete the trigger
             mapTrigger.erase(it++);
+            nTriggersVersion++;
         } else {
             ++it;
         }
@@ -280,8 +282,30 @@ bool CSuperblockManager::GetBestSuperblock(CSuperblock_sptr& pSuperblockRet, int
     }
 
     AssertLockHeld(governance.cs);
+
+    // This is called multiple times for every block and block template, so the decision is cached until triggers
+    // or their funding votes change
+    uint64_t nVersion = triggerman.nTriggersVersion;
+    if (triggerman.nBestSuperblocksVersion != nVersion) {
+        triggerman.mapBestSuperblocks.clear();
+        triggerman.nBestSuperblocksVersion = nVersion;
+    }
+    auto itCached = triggerman.mapBestSuperblocks.find(nBlockHeight);
+    if (itCached != triggerman.mapBestSuperblocks.end()) {
+        // the object of the trigger might have been erased in the meantime
+        if (itCached->second && itCached->second->GetGovernanceObject()) {
+            pSuperblockRet = itCached->second;
+            return true;
+        }
+        if (!itCached->second) {
+            return false;
+        }
+        triggerman.mapBestSuperblocks.erase(itCached);
+    }
+
     std::vector<CSuperblock_sptr> vecTriggers = triggerman.GetActiveTriggers();
     int nYesCount = 0;
+    CSuperblock_sptr pBestSuperblock;
 
     for (const auto& pSuperblock : vecTriggers) {
         if (!pSuperblock || nBlockHeight != pSuperblock->GetBlockHeight()) {
@@ -299,11 +323,17 @@ bool CSuperblockManager::GetBestSuperblock(CSuperblock_sptr& pSuperblockRet, int
         int nTempYesCount = pObj->GetAbsoluteYesCount(VOTE_SIGNAL_FUNDING);
         if (nTempYesCount > nYesCount) {
             nYesCount = nTempYesCount;
-            pSuperblockRet = pSuperblock;
+            pBestSuperblock = pSuperblock;
         }
     }
 
-    return nYesCount > 0;
+    triggerman.mapBestSuperblocks.emplace(nBlockHeight, pBestSuperblock);
+
+    if (nYesCount > 0) {
+        pSuperblockRet = pBestSuperblock;
+        return true;
+    }
+    return false;
 }
 
 /**
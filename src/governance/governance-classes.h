@@ -10,6 +10,8 @@
 #include <script/standard.h>
 #include <util.h>
 
+#include <atomic>
+
 class CSuperblock;
 class CGovernanceTriggerManager;
 class CSuperblockManager;
@@ -34,13 +36,26 @@ class CGovernanceTriggerManager
 private:
     std::map<uint256, CSuperblock_sptr> mapTrigger;
 
+    // Bumped whenever triggers are added or removed or the funding votes of a trigger change
+    std::atomic<uint64_t> nTriggersVersion;
+
+    // Best trigger per superblock height (nullptr if there is none) as determined by
+    // CSuperblockManager::GetBestSuperblock. Only valid while nBestSuperblocksVersion matches nTriggersVersion
+    std::map<int, CSuperblock_sptr> mapBestSuperblocks;
+    uint64_t nBestSuperblocksVersion;
+
     std::vector<CSuperblock_sptr> GetActiveTriggers();
     bool AddNewTrigger(uint256 nHash);
     void CleanAndRemove();
 
 public:
     CGovernanceTriggerManager() :
-        mapTrigger() {}
+        mapTrigger(),
+        nTriggersVersion(0),
+        mapBestSuperblocks(),
+        nBestSuperblocksVersion(0) {}
+
+    void NotifyTriggerVotesChanged() { nTriggersVersion++; }
 };
 
 /**
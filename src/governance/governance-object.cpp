@@ -4,6 +4,7 @@
 
 #include <governance/governance-object.h>
 #include <core_io.h>
+#include <governance/governance-classes.h>
 #include <governance/governance-validators.h>
 #include <governance/governance.h>
 #include <masternode/masternode-meta.h>
@@ -34,8 +35,10 @@ CGovernanceObject::CGovernanceObject() :
     fCachedEndorsed(false),
     fDirtyCache(true),
     fExpired(false),
+    fDirtyDB(true),
     fUnparsable(false),
     mapCurrentMNVotes(),
+    voteTallies(),
     fileVotes()
 {
     // PARSE JSON DATA STORAGE (VCHDATA)
@@ -61,8 +64,10 @@ CGovernanceObject::CGovernanceObject(const uint256& nHashParentIn, int nRevision
     fCachedEndorsed(false),
     fDirtyCache(true),
     fExpired(false),
+    fDirtyDB(true),
     fUnparsable(false),
     mapCurrentMNVotes(),
+    voteTallies(),
     fileVotes()
 {
     // PARSE JSON DATA STORAGE (VCHDATA)
@@ -88,8 +93,11 @@ CGovernanceObject::CGovernanceObject(const CGovernanceObject& other) :
     fCachedEndorsed(other.fCachedEndorsed),
     fDirtyCache(other.fDirtyCache),
     fExpired(other.fExpired),
+    fDirtyDB(other.fDirtyDB),
     fUnparsable(other.fUnparsable),
+    parsedData(other.parsedData),
     mapCurrentMNVotes(other.mapCurrentMNVotes),
+    voteTallies(other.voteTallies),
     fileVotes(other.fileVotes)
 {
 }
@@ -207,9 +215,12 @@ bool CGovernanceObject::ProcessVote(CNode* pfrom,
         return false;
     }
 
+    UpdateVoteTally(eSignal, voteInstanceRef.eOutcome, -1);
     voteInstanceRef = vote_instance_t(vote.GetOutcome(), nVoteTimeUpdate, vote.GetTimestamp());
+    UpdateVoteTally(eSignal, voteInstanceRef.eOutcome, 1);
     fileVotes.AddVote(vote);
     fDirtyCache = true;
+    fDirtyDB = true;
     // SEND NOTIFICATION TO SCRIPT/ZMQ
     GetMainSignals().NotifyGovernanceVote(std::make_shared<const CGovernanceVote>(vote));
     return true;
@@ -224,9 +235,13 @@ void CGovernanceObject::ClearMasternodeVotes()
     auto it = mapCurrentMNVotes.begin();
     while (it != mapCurrentMNVotes.end()) {
         if (!mnList.HasMNByCollateral(it->first)) {
+            for (const auto& p : it->second.mapInstances) {
+                UpdateVoteTally(p.first, p.second.eOutcome, -1);
+            }
             fileVotes.RemoveVotesFromMasternode(it->first);
             mapCurrentMNVotes.erase(it++);
             fDirtyCache = true;
+            fDirtyDB = true;
         } else {
             ++it;
         }
@@ -253,6 +268,7 @@ std::set<uint256> CGovernanceObject::RemoveInvalidVotes(const COutPoint& mnOutpo
         CGovernanceVote tmpVote(mnOutpoint, nParentHash, (vote_signal_enum_t)jt->first, jt->second.eOutcome);
         tmpVote.SetTime(jt->second.nCreationTime);
         if (removedVotes.count(tmpVote.GetHash())) {
+            UpdateVoteTally(jt->first, jt->second.eOutcome, -1);
             jt = it->second.mapInstances.erase(jt);
         } else {
             ++jt;
@@ -269,11 +285,46 @@ std::set<uint256> CGovernanceObject::RemoveInvalidVotes(const COutPoint& mnOutpo
         }
         LogPrintf("CGovernanceObject::%s -- Removed %d invalid votes for %s from MN %s:\n%s", __func__, removedVotes.size(), nParentHash.ToString(), mnOutpoint.ToString(), removedStr); /* Continued */
         fDirtyCache = true;
+        fDirtyDB = true;
     }
 
     return removedVotes;
 }
 
+void CGovernanceObject::SyncVoteRecords()
+{
+    LOCK(cs);
+
+    size_t nRecordedVotes = 0;
+    for (const auto& p : mapCurrentMNVotes) {
+        for (const auto& p2 : p.second.mapInstances) {
+            // instances of rejected votes stay at nCreationTime 0
+            if (p2.second.nCreationTime != 0) {
+                nRecordedVotes++;
+            }
+        }
+    }
+
+    // only the vote hashes are read here, the votes themselves are only needed when the records are outdated
+    size_t nStoredVotes = (size_t)fileVotes.SyncVoteCount(GetHash());
+    if (nStoredVotes == nRecordedVotes) {
+        return;
+    }
+
+    LogPrintf("CGovernanceObject::%s -- rebuilding vote records for %s, votes=%d, records=%d\n", __func__, GetHash().ToString(), nStoredVotes, nRecordedVotes);
+
+    mapCurrentMNVotes.clear();
+    for (const auto& vote : fileVotes.GetVotes()) {
+        auto& voteInstanceRef = mapCurrentMNVotes[vote.GetMasternodeOutpoint()].mapInstances[int(vote.GetSignal())];
+        if (vote.GetTimestamp() >= voteInstanceRef.nCreationTime) {
+            voteInstanceRef = vote_instance_t(vote.GetOutcome(), vote.GetTimestamp(), vote.GetTimestamp());
+        }
+    }
+    RebuildVoteTallies();
+    fDirtyCache = true;
+    fDirtyDB = true;
+}
+
 uint256 CGovernanceObject::GetHash() const
 {
     // Note: doesn't match serialization
@@ -326,25 +377,48 @@ bool CGovernanceObject::CheckSignature(const CBLSPublicKey& pubKey) const
 
    Returns an empty object on error.
  */
-UniValue CGovernanceObject::GetJSONObject()
+UniValue CGovernanceObject::GetJSONObject() const
 {
-    UniValue obj(UniValue::VOBJ);
-    if (vchData.empty()) {
-        return obj;
-    }
-
-    UniValue objResult(UniValue::VOBJ);
-    GetData(objResult);
+    return GetParsedData()->objJSON;
+}
 
-    if (objResult.isObject()) {
-        obj = objResult;
-    } else {
-        std::vector<UniValue> arr1 = objResult.getValues();
-        std::vector<UniValue> arr2 = arr1.at(0).getValues();
-        obj = arr2.at(1);
+std::shared_ptr<const CGovernanceObjectParsedData> CGovernanceObject::GetParsedData() const
+{
+    LOCK(cs);
+    if (parsedData) {
+        return parsedData;
+    }
+
+    auto data = std::make_shared<CGovernanceObjectParsedData>();
+    if (!vchData.empty()) {
+        try {
+            UniValue objResult(UniValue::VOBJ);
+            GetData(objResult);
+
+            if (objResult.isObject()) {
+                data->objJSON = objResult;
+            } else {
+                std::vector<UniValue> arr1 = objResult.getValues();
+                std::vector<UniValue> arr2 = arr1.at(0).getValues();
+                data->objJSON = arr2.at(1);
+            }
+            data->fParsed = true;
+        } catch (std::exception& e) {
+            data->objJSON = UniValue(UniValue::VOBJ);
+            data->strParseError = e.what();
+        } catch (...) {
+            data->objJSON = UniValue(UniValue::VOBJ);
+            data->strParseError = "Unknown Error";
+        }
     }
 
-    return obj;
+    // the validator checks the type itself, other objects simply end up with fValidProposal == false
+    CProposalValidator validator(data->fParsed ? data->objJSON : NullUniValue, vchData.size());
+    data->fValidProposal = validator.Validate(false) && validator.GetProposalData(data->proposal);
+    data->strProposalErrors = validator.GetErrorMessages();
+
+    parsedData = std::move(data);
+    return parsedData;
 }
 
 /**
@@ -363,11 +437,12 @@ void CGovernanceObject::LoadData()
 
     try {
         // ATTEMPT TO LOAD JSON STRING FROM VCHDATA
-        UniValue objResult(UniValue::VOBJ);
-        GetData(objResult);
         LogPrint(BCLog::GOBJECT, "CGovernanceObject::LoadData -- GetDataAsPlainString = %s\n", GetDataAsPlainString());
-        UniValue obj = GetJSONObject();
-        nObjectType = obj["type"].get_int();
+        auto data = GetParsedData();
+        if (!data->fParsed) {
+            throw std::runtime_error(data->strParseError);
+        }
+        nObjectType = data->objJSON["type"].get_int();
     } catch (std::exception& e) {
         fUnparsable = true;
         std::ostringstream ostr;
@@ -392,7 +467,7 @@ void CGovernanceObject::LoadData()
 *
 */
 
-void CGovernanceObject::GetData(UniValue& objResult)
+void CGovernanceObject::GetData(UniValue& objResult) const
 {
     UniValue o(UniValue::VOBJ);
     std::string s = GetDataAsPlainString();
@@ -463,12 +538,12 @@ bool CGovernanceObject::IsValidLocally(std::string& strError, bool& fMissingConf
 
     switch (nObjectType) {
     case GOVERNANCE_OBJECT_PROPOSAL: {
-        CProposalValidator validator(GetDataAsHexString(), true);
         // Note: It's ok to have expired proposals
         // they are going to be cleared by CGovernanceManager::UpdateCachesAndClean()
         // TODO: should they be tagged as "expired" to skip vote downloading?
-        if (!validator.Validate(false)) {
-            strError = strprintf("Invalid proposal data, error messages: %s", validator.GetErrorMessages());
+        auto data = GetParsedData();
+        if (!data->fValidProposal) {
+            strError = strprintf("Invalid proposal data, error messages: %s", data->strProposalErrors);
             return false;
         }
         if (fCheckCollateral && !IsCollateralValid(strError, fMissingConfirmations)) {
@@ -610,6 +685,10 @@ int CGovernanceObject::CountMatchingVotes(vote_signal_enum_t eVoteSignalIn, vote
 {
     LOCK(cs);
 
+    if (eVoteSignalIn >= 0 && eVoteSignalIn <= MAX_SUPPORTED_VOTE_SIGNAL && eVoteOutcomeIn > VOTE_OUTCOME_NONE && eVoteOutcomeIn <= VOTE_OUTCOME_ABSTAIN) {
+        return voteTallies[eVoteSignalIn][eVoteOutcomeIn];
+    }
+
     int nCount = 0;
     for (const auto& votepair : mapCurrentMNVotes) {
         const vote_rec_t& recVote = votepair.second;
@@ -621,9 +700,34 @@ int CGovernanceObject::CountMatchingVotes(vote_signal_enum_t eVoteSignalIn, vote
     return nCount;
 }
 
-/**
-*   Get specific vote counts for each outcome (funding, validity, etc)
-*/
+void CGovernanceObject::UpdateVoteTally(int nSignal, vote_outcome_enum_t eOutcome, int nDelta)
+{
+    AssertLockHeld(cs);
+
+    if (nSignal < 0 || nSignal > MAX_SUPPORTED_VOTE_SIGNAL || eOutcome <= VOTE_OUTCOME_NONE || eOutcome > VOTE_OUTCOME_ABSTAIN) {
+        return;
+    }
+    voteTallies[nSignal][eOutcome] += nDelta;
+
+    if (nObjectType == GOVERNANCE_OBJECT_TRIGGER && nSignal == VOTE_SIGNAL_FUNDING) {
+        triggerman.NotifyTriggerVotesChanged();
+    }
+}
+
+void CGovernanceObject::RebuildVoteTallies()
+{
+    LOCK(cs);
+
+    voteTallies = {};
+    if (nObjectType == GOVERNANCE_OBJECT_TRIGGER) {
+        triggerman.NotifyTriggerVotesChanged();
+    }
+    for (const auto& votepair : mapCurrentMNVotes) {
+        for (const auto& p : votepair.second.mapInstances) {
+            UpdateVoteTally(p.first, p.second.eOutcome, 1);
+        }
+    }
+}
 
 int CGovernanceObject::GetAbsoluteYesCount(vote_signal_enum_t eVoteSignalIn) const
 {
@@ -662,6 +766,23 @@ bool CGovernanceObject::GetCurrentMNVotes(const COutPoint& mnCollateralOutpoint,
     return true;
 }
 
+void CGovernanceObject::ForEachCurrentMNVotes(const COutPoint* pMnCollateralOutpointFilter, const std::function<void(const COutPoint&, const vote_rec_t&)>& func) const
+{
+    LOCK(cs);
+
+    if (pMnCollateralOutpointFilter) {
+        auto it = mapCurrentMNVotes.find(*pMnCollateralOutpointFilter);
+        if (it != mapCurrentMNVotes.end()) {
+            func(it->first, it->second);
+        }
+        return;
+    }
+
+    for (const auto& p : mapCurrentMNVotes) {
+        func(p.first, p.second);
+    }
+}
+
 void CGovernanceObject::Relay(CConnman& connman)
 {
     // Do not relay until fully synced
@@ -7,6 +7,7 @@
 
 #include <cachemultimap.h>
 #include <governance/governance-exceptions.h>
+#include <governance/governance-validators.h>
 #include <governance/governance-vote.h>
 #include <governance/governance-votedb.h>
 #include <key.h>
@@ -18,6 +19,10 @@
 
 #include <univalue.h>
 
+#include <array>
+#include <functional>
+#include <memory>
+
 class CGovernanceManager;
 class CGovernanceTriggerManager;
 class CGovernanceObject;
@@ -91,6 +96,23 @@ struct vote_rec_t {
     }
 };
 
+/**
+ * vchData of a governance object, parsed once and shared (immutable) between all copies of the object
+ */
+struct CGovernanceObjectParsedData {
+    /// false if vchData is not valid JSON
+    bool fParsed{false};
+    std::string strParseError;
+
+    /// the JSON object, with the legacy [["type", {...}]] wrapping removed
+    UniValue objJSON{UniValue::VOBJ};
+
+    /// result of CProposalValidator::Validate(false) and the typed fields of a valid proposal
+    bool fValidProposal{false};
+    std::string strProposalErrors;
+    CProposalData proposal;
+};
+
 /**
 * Governance Object
 *
@@ -156,11 +178,20 @@ private:
     /// Object is no longer of interest
     bool fExpired;
 
+    /// object was changed since it was last written to governanceDB
+    bool fDirtyDB;
+
     /// Failed to parse object data
     bool fUnparsable;
 
+    /// vchData parsed on first use, reset when vchData is deserialized
+    mutable std::shared_ptr<const CGovernanceObjectParsedData> parsedData;
+
     vote_m_t mapCurrentMNVotes;
 
+    /// number of current votes per signal and outcome, kept in sync with mapCurrentMNVotes. VOTE_OUTCOME_NONE is not counted
+    std::array<std::array<int, VOTE_OUTCOME_ABSTAIN + 1>, MAX_SUPPORTED_VOTE_SIGNAL + 1> voteTallies;
+
     CGovernanceObjectVoteFile fileVotes;
 
 public:
@@ -230,6 +261,17 @@ public:
     void SetExpired()
     {
         fExpired = true;
+        fDirtyDB = true;
+    }
+
+    bool IsSetDirtyDB() const
+    {
+        return fDirtyDB;
+    }
+
+    void ClearDirtyDB()
+    {
+        fDirtyDB = false;
     }
 
     const CGovernanceObjectVoteFile& GetVoteFile() const
@@ -263,12 +305,16 @@ public:
         fCachedDelete = true;
         if (nDeletionTime == 0) {
             nDeletionTime = nDeletionTime_;
+            fDirtyDB = true;
         }
     }
 
     CAmount GetMinCollateralFee() const;
 
-    UniValue GetJSONObject();
+    UniValue GetJSONObject() const;
+
+    // Returns vchData parsed as JSON and, for proposals, validated. Parses only on the first call
+    std::shared_ptr<const CGovernanceObjectParsedData> GetParsedData() const;
 
     void Relay(CConnman& connman);
 
@@ -286,6 +332,10 @@ public:
 
     bool GetCurrentMNVotes(const COutPoint& mnCollateralOutpoint, vote_rec_t& voteRecord) const;
 
+    // Calls func for the current votes of every masternode (or only of pMnCollateralOutpointFilter, when set)
+    // without copying the vote records
+    void ForEachCurrentMNVotes(const COutPoint* pMnCollateralOutpointFilter, const std::function<void(const COutPoint&, const vote_rec_t&)>& func) const;
+
     // FUNCTIONS FOR DEALING WITH DATA STRING
 
     std::string GetDataAsHexString() const;
@@ -304,6 +354,9 @@ public:
         READWRITE(nTime);
         READWRITE(nCollateralHash);
         READWRITE(vchData);
+        if (ser_action.ForRead()) {
+            parsedData.reset();
+        }
         READWRITE(nObjectType);
         READWRITE(masternodeOutpoint);
         if (!(s.GetType() & SER_GETHASH)) {
@@ -315,6 +368,9 @@ public:
             READWRITE(nDeletionTime);
             READWRITE(fExpired);
             READWRITE(mapCurrentMNVotes);
+            if (ser_action.ForRead()) {
+                RebuildVoteTallies();
+            }
             READWRITE(fileVotes);
             LogPrint(BCLog::GOBJECT, "CGovernanceObject::SerializationOp hash = %s, vote count = %d\n", GetHash().ToString(), fileVotes.GetVoteCount());
         }
@@ -326,7 +382,7 @@ public:
 
     // FUNCTIONS FOR DEALING WITH DATA STRING
     void LoadData();
-    void GetData(UniValue& objResult);
+    void GetData(UniValue& objResult) const;
 
     bool ProcessVote(CNode* pfrom,
         const CGovernanceVote& vote,
@@ -341,6 +397,14 @@ public:
     // also for MNs that were removed from the list completely.
     // Returns deleted vote hashes.
     std::set<uint256> RemoveInvalidVotes(const COutPoint& mnOutpoint);
+
+    // Rebuilds mapCurrentMNVotes from the votes in governanceDB if they don't match, e.g. because the object was last
+    // written before an unclean shutdown
+    void SyncVoteRecords();
+
+private:
+    void UpdateVoteTally(int nSignal, vote_outcome_enum_t eOutcome, int nDelta);
+    void RebuildVoteTallies();
 };
 
 
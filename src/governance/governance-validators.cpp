@@ -26,6 +26,20 @@ CProposalValidator::CProposalValidator(const std::string& strHexData, bool fAllo
     }
 }
 
+CProposalValidator::CProposalValidator(const UniValue& objJSONIn, size_t nDataSize) :
+    objJSON(UniValue::VOBJ),
+    fJSONValid(false),
+    fAllowLegacyFormat(true),
+    strErrorMessages()
+{
+    if (nDataSize > MAX_DATA_SIZE) {
+        strErrorMessages = strprintf("data exceeds %lu characters;", MAX_DATA_SIZE);
+    } else if (nDataSize != 0 && objJSONIn.isObject()) {
+        objJSON = objJSONIn;
+        fJSONValid = true;
+    }
+}
+
 void CProposalValidator::ParseStrHexData(const std::string& strHexData)
 {
     std::vector<unsigned char> v = ParseHex(strHexData);
@@ -110,6 +124,16 @@ bool CProposalValidator::ValidateName()
     return true;
 }
 
+bool CProposalValidator::GetProposalData(CProposalData& dataRet)
+{
+    return GetDataValue("name", dataRet.strName) &&
+           GetDataValue("start_epoch", dataRet.nStartEpoch) &&
+           GetDataValue("end_epoch", dataRet.nEndEpoch) &&
+           GetDataValue("payment_amount", dataRet.dPaymentAmount) &&
+           GetDataValue("payment_address", dataRet.strPaymentAddress) &&
+           GetDataValue("url", dataRet.strURL);
+}
+
 bool CProposalValidator::ValidateStartEndEpoch(bool fCheckExpiration)
 {
     int64_t nStartEpoch = 0;
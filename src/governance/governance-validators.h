@@ -9,6 +9,17 @@
 
 #include <univalue.h>
 
+/** Typed fields of a proposal, see CProposalValidator::GetProposalData */
+struct CProposalData
+{
+    std::string strName;
+    int64_t nStartEpoch{0};
+    int64_t nEndEpoch{0};
+    double dPaymentAmount{0};
+    std::string strPaymentAddress;
+    std::string strURL;
+};
+
 class CProposalValidator
 {
 private:
@@ -19,9 +30,14 @@ private:
 
 public:
     explicit CProposalValidator(const std::string& strDataHexIn = std::string(), bool fAllowLegacyFormat = true);
+    // For data which was already parsed (and unwrapped from the legacy format) by the caller
+    CProposalValidator(const UniValue& objJSONIn, size_t nDataSize);
 
     bool Validate(bool fCheckExpiration = true);
 
+    // Fills the fields of a proposal which was validated successfully before
+    bool GetProposalData(CProposalData& dataRet);
+
     const std::string& GetErrorMessages()
     {
         return strErrorMessages;
@@ -6,10 +6,42 @@
 #include <governance/governance-object.h>
 #include <masternode/masternode-sync.h>
 #include <messagesigner.h>
+#include <saltedhasher.h>
+#include <unordered_lru_cache.h>
 #include <util.h>
 
 #include <evo/deterministicmns.h>
 
+// Signatures which were already verified successfully. Keys commit to the vote, the signature bytes and the key used
+// for verification, so that a vote with a mutated signature or a changed voting/operator key is verified again.
+// This allows to verify signatures outside of CGovernanceManager::cs (see CGovernanceManager::PreVerifyVotes) and to
+// skip the expensive verification when the vote is processed afterwards.
+static CCriticalSection cs_verifiedSigs;
+static unordered_lru_cache<uint256, bool, StaticSaltedHasher, 50000> verifiedSigsCache;
+
+template <typename Key>
+static uint256 BuildVerifiedSigKey(const CGovernanceVote& vote, const std::vector<unsigned char>& vchSig, const Key& key)
+{
+    CHashWriter hw(SER_GETHASH, 0);
+    hw << vote.GetSignatureHash();
+    hw << vchSig;
+    hw << key;
+    return hw.GetHash();
+}
+
+static bool IsSigVerified(const uint256& nKey)
+{
+    LOCK(cs_verifiedSigs);
+    bool f;
+    return verifiedSigsCache.get(nKey, f);
+}
+
+static void SetSigVerified(const uint256& nKey)
+{
+    LOCK(cs_verifiedSigs);
+    verifiedSigsCache.insert(nKey, true);
+}
+
 std::string CGovernanceVoting::ConvertOutcomeToString(vote_outcome_enum_t nOutcome)
 {
     static const std::map<vote_outcome_enum_t, std::string> mapOutcomeString = {
@@ -196,6 +228,11 @@ bool CGovernanceVote::Sign(const CKey& key, const CKeyID& keyID)
 
 bool CGovernanceVote::CheckSignature(const CKeyID& keyID) const
 {
+    uint256 nVerifiedKey = BuildVerifiedSigKey(*this, vchSig, keyID);
+    if (IsSigVerified(nVerifiedKey)) {
+        return true;
+    }
+
     std::string strError;
 
     // Harden Spork6 so that it is active on testnet and no other networks
@@ -218,6 +255,7 @@ bool CGovernanceVote::CheckSignature(const CKeyID& keyID) const
         }
     }
 
+    SetSigVerified(nVerifiedKey);
     return true;
 }
 
@@ -234,10 +272,16 @@ bool CGovernanceVote::Sign(const CBLSSecretKey& key)
 
 bool CGovernanceVote::CheckSignature(const CBLSPublicKey& pubKey) const
 {
+    uint256 nVerifiedKey = BuildVerifiedSigKey(*this, vchSig, pubKey);
+    if (IsSigVerified(nVerifiedKey)) {
+        return true;
+    }
+
     if (!CBLSSignature(vchSig).VerifyInsecure(pubKey, GetSignatureHash())) {
         LogPrintf("CGovernanceVote::CheckSignature -- VerifyInsecure() failed\n");
         return false;
     }
+    SetSigVerified(nVerifiedKey);
     return true;
 }
 
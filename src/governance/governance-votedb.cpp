@@ -4,19 +4,220 @@
 
 #include <governance/governance-votedb.h>
 
-CGovernanceObjectVoteFile::CGovernanceObjectVoteFile() :
-    nMemoryVotes(0),
-    listVotes(),
-    mapVoteIndex()
+#include <governance/governance-object.h>
+#include <util.h>
+
+CGovernanceDB* governanceDB;
+
+static const std::string DB_OBJECT = "go_o";
+static const std::string DB_VOTE = "gv_v";
+static const std::string DB_VOTE_BY_OBJECT = "gv_m";
+
+static std::tuple<std::string, uint256, COutPoint, uint256> BuildVoteByObjectKey(const CGovernanceVote& vote, const uint256& nHash)
+{
+    return std::make_tuple(DB_VOTE_BY_OBJECT, vote.GetParentHash(), vote.GetMasternodeOutpoint(), nHash);
+}
+
+CGovernanceDB::CGovernanceDB(bool fMemory, bool fWipe) :
+    db(fMemory ? "" : (GetDataDir() / "governance"), 8 << 20, fMemory, fWipe)
+{
+}
+
+void CGovernanceDB::WriteObject(const CGovernanceObject& govobj)
+{
+    db.Write(std::make_pair(DB_OBJECT, govobj.GetHash()), govobj);
+}
+
+void CGovernanceDB::EraseObject(const uint256& nHash)
+{
+    EraseVotesForObject(nHash);
+    db.Erase(std::make_pair(DB_OBJECT, nHash));
+}
+
+void CGovernanceDB::LoadObjects(std::map<uint256, CGovernanceObject>& mapObjectsRet)
+{
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+
+    auto start = std::make_pair(DB_OBJECT, uint256());
+    pcursor->Seek(start);
+
+    while (pcursor->Valid()) {
+        decltype(start) k;
+
+        if (!pcursor->GetKey(k) || k.first != DB_OBJECT) {
+            break;
+        }
+
+        CGovernanceObject govobj;
+        if (!pcursor->GetValue(govobj)) {
+            LogPrintf("CGovernanceDB::%s -- failed to read object %s\n", __func__, k.second.ToString());
+        } else {
+            govobj.ClearDirtyDB();
+            mapObjectsRet.emplace(k.second, govobj);
+        }
+
+        pcursor->Next();
+    }
+
+    LogPrint(BCLog::GOBJECT, "CGovernanceDB::%s -- loaded %d objects\n", __func__, mapObjectsRet.size());
+}
+
+void CGovernanceDB::WriteVote(const CGovernanceVote& vote)
+{
+    uint256 nHash = vote.GetHash();
+
+    CDBBatch batch(db);
+    batch.Write(std::make_pair(DB_VOTE, nHash), vote);
+    batch.Write(BuildVoteByObjectKey(vote, nHash), (uint8_t)1);
+    db.WriteBatch(batch);
+
+    LOCK(cs);
+    votesCache.insert(nHash, std::make_shared<const CGovernanceVote>(vote));
+}
+
+void CGovernanceDB::EraseVote(const CGovernanceVote& vote)
 {
+    uint256 nHash = vote.GetHash();
+
+    CDBBatch batch(db);
+    batch.Erase(std::make_pair(DB_VOTE, nHash));
+    batch.Erase(BuildVoteByObjectKey(vote, nHash));
+    db.WriteBatch(batch);
+
+    LOCK(cs);
+    votesCache.erase(nHash);
+}
+
+bool CGovernanceDB::HasVote(const uint256& nHash) const
+{
+    {
+        LOCK(cs);
+        std::shared_ptr<const CGovernanceVote> vote;
+        if (votesCache.get(nHash, vote)) {
+            return true;
+        }
+    }
+    return db.Exists(std::make_pair(DB_VOTE, nHash));
 }
 
-CGovernanceObjectVoteFile::CGovernanceObjectVoteFile(const CGovernanceObjectVoteFile& other) :
-    nMemoryVotes(other.nMemoryVotes),
-    listVotes(other.listVotes),
-    mapVoteIndex()
+std::shared_ptr<const CGovernanceVote> CGovernanceDB::GetVote(const uint256& nHash) const
+{
+    std::shared_ptr<const CGovernanceVote> ret;
+    {
+        LOCK(cs);
+        if (votesCache.get(nHash, ret)) {
+            return ret;
+        }
+    }
+
+    auto vote = std::make_shared<CGovernanceVote>();
+    if (!db.Read(std::make_pair(DB_VOTE, nHash), *vote)) {
+        return nullptr;
+    }
+    ret = std::move(vote);
+
+    LOCK(cs);
+    votesCache.insert(nHash, ret);
+    return ret;
+}
+
+std::vector<uint256> CGovernanceDB::GetVoteHashes(const uint256& nParentHash, const COutPoint* pOutpointMasternode)
+{
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+
+    auto start = std::make_tuple(DB_VOTE_BY_OBJECT, nParentHash, pOutpointMasternode ? *pOutpointMasternode : COutPoint(uint256(), 0), uint256());
+    pcursor->Seek(start);
+
+    std::vector<uint256> ret;
+    while (pcursor->Valid()) {
+        decltype(start) k;
+
+        if (!pcursor->GetKey(k) || std::get<0>(k) != DB_VOTE_BY_OBJECT || std::get<1>(k) != nParentHash) {
+            break;
+        }
+        if (pOutpointMasternode && std::get<2>(k) != *pOutpointMasternode) {
+            break;
+        }
+
+        ret.emplace_back(std::get<3>(k));
+
+        pcursor->Next();
+    }
+
+    return ret;
+}
+
+std::vector<CGovernanceVote> CGovernanceDB::ReadVotes(const std::vector<uint256>& vecHashes)
+{
+    std::vector<CGovernanceVote> ret;
+    ret.reserve(vecHashes.size());
+    for (const auto& nHash : vecHashes) {
+        CGovernanceVote vote;
+        if (!db.Read(std::make_pair(DB_VOTE, nHash), vote)) {
+            LogPrintf("CGovernanceDB::%s -- vote %s not found\n", __func__, nHash.ToString());
+            continue;
+        }
+        ret.emplace_back(std::move(vote));
+    }
+    return ret;
+}
+
+std::vector<CGovernanceVote> CGovernanceDB::GetVotes(const uint256& nParentHash)
+{
+    return ReadVotes(GetVoteHashes(nParentHash, nullptr));
+}
+
+std::vector<CGovernanceVote> CGovernanceDB::GetVotesFromMasternode(const uint256& nParentHash, const COutPoint& outpointMasternode)
+{
+    return ReadVotes(GetVoteHashes(nParentHash, &outpointMasternode));
+}
+
+void CGovernanceDB::EraseVotesForObject(const uint256& nParentHash)
+{
+    for (const auto& vote : GetVotes(nParentHash)) {
+        EraseVote(vote);
+    }
+}
+
+void CGovernanceDB::EraseVotesExceptForObjects(const std::set<uint256>& setParentHashes)
+{
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+
+    auto start = std::make_tuple(DB_VOTE_BY_OBJECT, uint256(), COutPoint(uint256(), 0), uint256());
+    pcursor->Seek(start);
+
+    CDBBatch batch(db);
+    size_t cnt = 0;
+    while (pcursor->Valid()) {
+        decltype(start) k;
+
+        if (!pcursor->GetKey(k) || std::get<0>(k) != DB_VOTE_BY_OBJECT) {
+            break;
+        }
+
+        if (!setParentHashes.count(std::get<1>(k))) {
+            batch.Erase(k);
+            batch.Erase(std::make_pair(DB_VOTE, std::get<3>(k)));
+            cnt++;
+        }
+
+        pcursor->Next();
+    }
+    pcursor.reset();
+
+    if (cnt != 0) {
+        db.WriteBatch(batch);
+        LOCK(cs);
+        votesCache.clear();
+    }
+
+    LogPrint(BCLog::GOBJECT, "CGovernanceDB::%s -- removed %d orphaned votes\n", __func__, cnt);
+}
+
+CGovernanceObjectVoteFile::CGovernanceObjectVoteFile() :
+    nVoteCount(0),
+    nParentHash()
 {
-    RebuildIndex();
 }
 
 void CGovernanceObjectVoteFile::AddVote(const CGovernanceVote& vote)
@@ -25,47 +226,54 @@ void CGovernanceObjectVoteFile::AddVote(const CGovernanceVote& vote)
     // make sure to never add/update already known votes
     if (HasVote(nHash))
         return;
-    listVotes.push_front(vote);
-    mapVoteIndex.emplace(nHash, listVotes.begin());
-    ++nMemoryVotes;
+    nParentHash = vote.GetParentHash();
     RemoveOldVotes(vote);
+    governanceDB->WriteVote(vote);
+    ++nVoteCount;
 }
 
 bool CGovernanceObjectVoteFile::HasVote(const uint256& nHash) const
 {
-    return mapVoteIndex.find(nHash) != mapVoteIndex.end();
+    // vote hashes include the hash of the object, so votes for other objects can't match here
+    return nVoteCount != 0 && governanceDB->HasVote(nHash);
 }
 
 bool CGovernanceObjectVoteFile::SerializeVoteToStream(const uint256& nHash, CDataStream& ss) const
 {
-    auto it = mapVoteIndex.find(nHash);
-    if (it == mapVoteIndex.end()) {
+    if (nVoteCount == 0) {
+        return false;
+    }
+    auto vote = governanceDB->GetVote(nHash);
+    if (!vote) {
         return false;
     }
-    ss << *(it->second);
+    ss << *vote;
     return true;
 }
 
 std::vector<CGovernanceVote> CGovernanceObjectVoteFile::GetVotes() const
 {
-    std::vector<CGovernanceVote> vecResult;
-    for (auto it = listVotes.begin(); it != listVotes.end(); ++it) {
-        vecResult.push_back(*it);
+    if (nVoteCount == 0) {
+        return {};
     }
-    return vecResult;
+    return governanceDB->GetVotes(nParentHash);
+}
+
+int CGovernanceObjectVoteFile::SyncVoteCount(const uint256& nObjectHash)
+{
+    nParentHash = nObjectHash;
+    nVoteCount = (int)governanceDB->GetVoteHashes(nParentHash).size();
+    return nVoteCount;
 }
 
 void CGovernanceObjectVoteFile::RemoveVotesFromMasternode(const COutPoint& outpointMasternode)
 {
-    auto it = listVotes.begin();
-    while (it != listVotes.end()) {
-        if (it->GetMasternodeOutpoint() == outpointMasternode) {
-            --nMemoryVotes;
-            mapVoteIndex.erase(it->GetHash());
-            listVotes.erase(it++);
-        } else {
-            ++it;
-        }
+    if (nVoteCount == 0) {
+        return;
+    }
+    for (const auto& vote : governanceDB->GetVotesFromMasternode(nParentHash, outpointMasternode)) {
+        governanceDB->EraseVote(vote);
+        --nVoteCount;
     }
 }
 
@@ -73,19 +281,17 @@ std::set<uint256> CGovernanceObjectVoteFile::RemoveInvalidVotes(const COutPoint&
 {
     std::set<uint256> removedVotes;
 
-    auto it = listVotes.begin();
-    while (it != listVotes.end()) {
-        if (it->GetMasternodeOutpoint() == outpointMasternode) {
-            bool useVotingKey = fProposal && (it->GetSignal() == VOTE_SIGNAL_FUNDING);
-            if (!it->IsValid(useVotingKey)) {
-                removedVotes.emplace(it->GetHash());
-                --nMemoryVotes;
-                mapVoteIndex.erase(it->GetHash());
-                listVotes.erase(it++);
-                continue;
-            }
+    if (nVoteCount == 0) {
+        return removedVotes;
+    }
+
+    for (const auto& vote : governanceDB->GetVotesFromMasternode(nParentHash, outpointMasternode)) {
+        bool useVotingKey = fProposal && (vote.GetSignal() == VOTE_SIGNAL_FUNDING);
+        if (!vote.IsValid(useVotingKey)) {
+            removedVotes.emplace(vote.GetHash());
+            governanceDB->EraseVote(vote);
+            --nVoteCount;
         }
-        ++it;
     }
 
     return removedVotes;
@@ -93,36 +299,12 @@ std::set<uint256> CGovernanceObjectVoteFile::RemoveInvalidVotes(const COutPoint&
 
 void CGovernanceObjectVoteFile::RemoveOldVotes(const CGovernanceVote& vote)
 {
-    auto it = listVotes.begin();
-    while (it != listVotes.end()) {
-        if (it->GetMasternodeOutpoint() == vote.GetMasternodeOutpoint() // same masternode
-            && it->GetParentHash() == vote.GetParentHash() // same governance object (e.g. same proposal)
-            && it->GetSignal() == vote.GetSignal() // same signal (e.g. "funding", "delete", etc.)
-            && it->GetTimestamp() < vote.GetTimestamp()) // older than new vote
+    for (const auto& oldVote : governanceDB->GetVotesFromMasternode(vote.GetParentHash(), vote.GetMasternodeOutpoint())) {
+        if (oldVote.GetSignal() == vote.GetSignal() // same signal (e.g. "funding", "delete", etc.)
+            && oldVote.GetTimestamp() < vote.GetTimestamp()) // older than new vote
         {
-            --nMemoryVotes;
-            mapVoteIndex.erase(it->GetHash());
-            listVotes.erase(it++);
-        } else {
-            ++it;
-        }
-    }
-}
-
-void CGovernanceObjectVoteFile::RebuildIndex()
-{
-    mapVoteIndex.clear();
-    nMemoryVotes = 0;
-    auto it = listVotes.begin();
-    while (it != listVotes.end()) {
-        CGovernanceVote& vote = *it;
-        uint256 nHash = vote.GetHash();
-        if (mapVoteIndex.find(nHash) == mapVoteIndex.end()) {
-            mapVoteIndex[nHash] = it;
-            ++nMemoryVotes;
-            ++it;
-        } else {
-            listVotes.erase(it++);
+            governanceDB->EraseVote(oldVote);
+            --nVoteCount;
         }
     }
 }
@@ -5,63 +5,116 @@
 #ifndef BITCOIN_GOVERNANCE_GOVERNANCE_VOTEDB_H
 #define BITCOIN_GOVERNANCE_GOVERNANCE_VOTEDB_H
 
-#include <list>
-#include <map>
-
+#include <dbwrapper.h>
 #include <governance/governance-vote.h>
+#include <saltedhasher.h>
 #include <serialize.h>
 #include <streams.h>
+#include <sync.h>
 #include <uint256.h>
+#include <unordered_lru_cache.h>
+
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+class CGovernanceObject;
 
 /**
- * Represents the collection of votes associated with a given CGovernanceObject
- * Recently received votes are held in memory until a maximum size is reached after
- * which older votes a flushed to a disk file.
+ * LevelDB backed storage for governance objects and their votes
  *
- * Note: This is a stub implementation that doesn't limit the number of votes held
- * in memory and doesn't flush to disk.
+ * Objects are stored under "go_o" + objectHash. They are written when they are accepted and afterwards whenever
+ * CGovernanceManager flushes changed objects, so that startup only has to read the objects and not their votes.
+ *
+ * Votes are stored under "gv_v" + voteHash as soon as they are accepted. For every vote, an additional "gv_m" +
+ * parentHash + masternodeOutpoint + voteHash key is written, which allows to find all votes of an object or all votes
+ * of a single masternode for an object by iterating a key prefix. Recently written or read votes are kept in a small
+ * in-memory cache, as these are the ones requested by peers while votes are relayed.
  */
-class CGovernanceObjectVoteFile
+class CGovernanceDB
 {
-public: // Types
-    typedef std::list<CGovernanceVote> vote_l_t;
+private:
+    static const size_t MAX_CACHED_VOTES = 10000;
+
+    CDBWrapper db;
+
+    mutable CCriticalSection cs;
+    mutable unordered_lru_cache<uint256, std::shared_ptr<const CGovernanceVote>, StaticSaltedHasher, MAX_CACHED_VOTES> votesCache;
+
+public:
+    CGovernanceDB(bool fMemory, bool fWipe);
+
+    void WriteObject(const CGovernanceObject& govobj);
+    // Erases the object and all of its votes
+    void EraseObject(const uint256& nHash);
+    void LoadObjects(std::map<uint256, CGovernanceObject>& mapObjectsRet);
+
+    void WriteVote(const CGovernanceVote& vote);
+    void EraseVote(const CGovernanceVote& vote);
+
+    bool HasVote(const uint256& nHash) const;
+    // returns nullptr if the vote is not known
+    std::shared_ptr<const CGovernanceVote> GetVote(const uint256& nHash) const;
+
+    // Only reads the keys, so this is much cheaper than GetVotes
+    std::vector<uint256> GetVoteHashes(const uint256& nParentHash, const COutPoint* pOutpointMasternode = nullptr);
+    std::vector<CGovernanceVote> GetVotes(const uint256& nParentHash);
+    std::vector<CGovernanceVote> GetVotesFromMasternode(const uint256& nParentHash, const COutPoint& outpointMasternode);
 
-    typedef std::map<uint256, vote_l_t::iterator> vote_m_t;
+    void EraseVotesForObject(const uint256& nParentHash);
+    // Removes the votes of all objects not in setParentHashes, e.g. the ones left behind by an unclean shutdown
+    void EraseVotesExceptForObjects(const std::set<uint256>& setParentHashes);
 
 private:
-    int nMemoryVotes;
+    std::vector<CGovernanceVote> ReadVotes(const std::vector<uint256>& vecHashes);
+};
+
+extern CGovernanceDB* governanceDB;
 
-    vote_l_t listVotes;
+/**
+ * Represents the collection of votes associated with a given CGovernanceObject
+ *
+ * The votes themselves are stored in governanceDB, only the hash of the object and the number of votes are held
+ * (and serialized) here.
+ */
+class CGovernanceObjectVoteFile
+{
+private:
+    int nVoteCount;
 
-    vote_m_t mapVoteIndex;
+    uint256 nParentHash;
 
 public:
     CGovernanceObjectVoteFile();
 
-    CGovernanceObjectVoteFile(const CGovernanceObjectVoteFile& other);
-
     /**
      * Add a vote to the file
      */
     void AddVote(const CGovernanceVote& vote);
 
     /**
-     * Return true if the vote with this hash is currently cached in memory
+     * Return true if the vote with this hash is known
      */
     bool HasVote(const uint256& nHash) const;
 
     /**
-     * Retrieve a vote cached in memory
+     * Retrieve a known vote
      */
     bool SerializeVoteToStream(const uint256& nHash, CDataStream& ss) const;
 
     int GetVoteCount() const
     {
-        return nMemoryVotes;
+        return nVoteCount;
     }
 
     std::vector<CGovernanceVote> GetVotes() const;
 
+    /**
+     * Recount the votes of the object with hash nObjectHash in governanceDB, returns the new count
+     */
+    int SyncVoteCount(const uint256& nObjectHash);
+
     void RemoveVotesFromMasternode(const COutPoint& outpointMasternode);
     std::set<uint256> RemoveInvalidVotes(const COutPoint& outpointMasternode, bool fProposal);
 
@@ -70,18 +123,13 @@ public:
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action)
     {
-        READWRITE(nMemoryVotes);
-        READWRITE(listVotes);
-        if (ser_action.ForRead()) {
-            RebuildIndex();
-        }
+        READWRITE(nVoteCount);
+        READWRITE(nParentHash);
     }
 
 private:
     // Drop older votes for the same gobject from the same masternode
     void RemoveOldVotes(const CGovernanceVote& vote);
-
-    void RebuildIndex();
 };
 
 #endif // BITCOIN_GOVERNANCE_GOVERNANCE_VOTEDB_H
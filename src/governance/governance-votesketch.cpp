@@ -0,0 +1,118 @@
+// Copyright (c) 2014-2021 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <governance/governance-votesketch.h>
+
+#include <hash.h>
+
+#include <algorithm>
+
+// used to derive differently keyed hash functions from the sketch salt
+static const uint64_t CHECKSUM_SALT_MASK = 0x9e3779b97f4a7c15ULL;
+static const uint64_t INDEX_SALT_MASK = 0xc2b2ae3d27d4eb4fULL;
+
+CGovernanceVoteSketch::CGovernanceVoteSketch(const uint256& nParentHashIn, uint64_t nSaltIn, size_t nCells) :
+    nParentHash(nParentHashIn),
+    nSalt(nSaltIn),
+    vecCells(nCells)
+{
+}
+
+size_t CGovernanceVoteSketch::GetCellCountForVotes(size_t nVoteCount)
+{
+    size_t nCellsPerHash = std::min(std::max(nVoteCount / 32 + MIN_CELLS / NUM_HASHES, MIN_CELLS / NUM_HASHES), MAX_CELLS / NUM_HASHES);
+    return nCellsPerHash * NUM_HASHES;
+}
+
+bool CGovernanceVoteSketch::IsValid() const
+{
+    return vecCells.size() >= MIN_CELLS && vecCells.size() <= MAX_CELLS && (vecCells.size() % NUM_HASHES) == 0;
+}
+
+uint64_t CGovernanceVoteSketch::GetShortId(const uint256& nVoteHash) const
+{
+    return SipHashUint256(nSalt, nParentHash.GetCheapHash(), nVoteHash);
+}
+
+uint64_t CGovernanceVoteSketch::GetCheckSum(uint64_t nShortId) const
+{
+    return CSipHasher(nSalt ^ CHECKSUM_SALT_MASK, nParentHash.GetCheapHash()).Write(nShortId).Finalize();
+}
+
+size_t CGovernanceVoteSketch::GetCellIndex(uint64_t nShortId, size_t nHashNum) const
+{
+    // every hash function maps into its own partition, so that a short id never hits the same cell twice
+    size_t nCellsPerHash = vecCells.size() / NUM_HASHES;
+    uint64_t h = CSipHasher(nSalt ^ INDEX_SALT_MASK, nParentHash.GetCheapHash()).Write(nShortId).Write(nHashNum).Finalize();
+    return nHashNum * nCellsPerHash + (size_t)(h % nCellsPerHash);
+}
+
+void CGovernanceVoteSketch::Toggle(uint64_t nShortId, int32_t nDirection, std::vector<Cell>& cells) const
+{
+    uint64_t nCheckSum = GetCheckSum(nShortId);
+    for (size_t i = 0; i < NUM_HASHES; i++) {
+        auto& cell = cells[GetCellIndex(nShortId, i)];
+        cell.nCount += nDirection;
+        cell.nKeySum ^= nShortId;
+        cell.nCheckSum ^= nCheckSum;
+    }
+}
+
+void CGovernanceVoteSketch::Add(const uint256& nVoteHash)
+{
+    AddShortId(GetShortId(nVoteHash));
+}
+
+void CGovernanceVoteSketch::AddShortId(uint64_t nShortId)
+{
+    if (vecCells.empty()) {
+        return;
+    }
+    Toggle(nShortId, 1, vecCells);
+}
+
+bool CGovernanceVoteSketch::Subtract(const CGovernanceVoteSketch& other)
+{
+    if (other.nParentHash != nParentHash || other.nSalt != nSalt || other.vecCells.size() != vecCells.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < vecCells.size(); i++) {
+        vecCells[i].nCount -= other.vecCells[i].nCount;
+        vecCells[i].nKeySum ^= other.vecCells[i].nKeySum;
+        vecCells[i].nCheckSum ^= other.vecCells[i].nCheckSum;
+    }
+    return true;
+}
+
+bool CGovernanceVoteSketch::Decode(std::set<uint64_t>& setPositiveRet, std::set<uint64_t>& setNegativeRet) const
+{
+    if (vecCells.empty() || (vecCells.size() % NUM_HASHES) != 0) {
+        return false;
+    }
+
+    std::vector<Cell> cells = vecCells;
+
+    bool fProgress = true;
+    while (fProgress) {
+        fProgress = false;
+        for (size_t i = 0; i < cells.size(); i++) {
+            const auto& cell = cells[i];
+            if ((cell.nCount != 1 && cell.nCount != -1) || cell.nCheckSum != GetCheckSum(cell.nKeySum)) {
+                continue;
+            }
+            uint64_t nShortId = cell.nKeySum;
+            int32_t nCount = cell.nCount;
+            // a short id can't be decoded twice and there can't be more differences than cells unless the sketch
+            // was crafted, bail out instead of looping forever
+            if (!(nCount > 0 ? setPositiveRet : setNegativeRet).emplace(nShortId).second ||
+                setPositiveRet.size() + setNegativeRet.size() > cells.size()) {
+                return false;
+            }
+            Toggle(nShortId, -nCount, cells);
+            fProgress = true;
+        }
+    }
+
+    return std::all_of(cells.begin(), cells.end(), [](const Cell& cell) { return cell.IsEmpty(); });
+}
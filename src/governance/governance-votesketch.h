@@ -0,0 +1,101 @@
+// Copyright (c) 2014-2021 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_GOVERNANCE_GOVERNANCE_VOTESKETCH_H
+#define BITCOIN_GOVERNANCE_GOVERNANCE_VOTESKETCH_H
+
+#include <serialize.h>
+#include <uint256.h>
+
+#include <set>
+#include <vector>
+
+/**
+ * Invertible bloom lookup table over the vote hashes of a single governance object
+ *
+ * Used for vote set reconciliation (MNGOVERNANCERECON). The requesting node sends a sketch of the votes it knows
+ * for an object, the other node subtracts it from a sketch of its own votes built with the same parameters and
+ * decodes the difference. If both nodes are nearly in sync, the sketch is much smaller than a bloom filter over all
+ * votes and only the missing votes are announced afterwards.
+ *
+ * Votes are mapped to salted 64 bit short ids. Each short id is added to one cell in each of the NUM_HASHES
+ * partitions of the table. Decoding repeatedly removes "pure" cells (cells which contain only a single short id),
+ * which succeeds with high probability as long as the number of differences is below ~2/3 of the number of cells.
+ */
+class CGovernanceVoteSketch
+{
+public:
+    static const size_t NUM_HASHES = 3;
+    static const size_t MIN_CELLS = 16 * NUM_HASHES;
+    static const size_t MAX_CELLS = 1024 * NUM_HASHES;
+
+    struct Cell {
+        int32_t nCount{0};
+        uint64_t nKeySum{0};
+        uint64_t nCheckSum{0};
+
+        ADD_SERIALIZE_METHODS;
+
+        template <typename Stream, typename Operation>
+        inline void SerializationOp(Stream& s, Operation ser_action)
+        {
+            READWRITE(nCount);
+            READWRITE(nKeySum);
+            READWRITE(nCheckSum);
+        }
+
+        bool IsEmpty() const { return nCount == 0 && nKeySum == 0 && nCheckSum == 0; }
+    };
+
+private:
+    uint256 nParentHash;
+    uint64_t nSalt{0};
+    std::vector<Cell> vecCells;
+
+public:
+    CGovernanceVoteSketch() = default;
+    CGovernanceVoteSketch(const uint256& nParentHashIn, uint64_t nSaltIn, size_t nCells);
+
+    // Returns a cell count suitable for an object of which nVoteCount votes are known locally
+    static size_t GetCellCountForVotes(size_t nVoteCount);
+
+    const uint256& GetParentHash() const { return nParentHash; }
+    uint64_t GetSalt() const { return nSalt; }
+    size_t GetCellCount() const { return vecCells.size(); }
+
+    // Checks if the sketch was received with parameters we are willing to process
+    bool IsValid() const;
+
+    uint64_t GetShortId(const uint256& nVoteHash) const;
+
+    void Add(const uint256& nVoteHash);
+    void AddShortId(uint64_t nShortId);
+
+    // Subtracts a sketch with identical parameters, returns false if the parameters don't match
+    bool Subtract(const CGovernanceVoteSketch& other);
+
+    /**
+     * Decodes a sketch which was previously subtracted from another sketch. Short ids which were only present in
+     * this sketch are returned in setPositiveRet, the ones only present in the other sketch in setNegativeRet.
+     * Returns false if the difference is too large to be decoded.
+     */
+    bool Decode(std::set<uint64_t>& setPositiveRet, std::set<uint64_t>& setNegativeRet) const;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(nParentHash);
+        READWRITE(nSalt);
+        READWRITE(vecCells);
+    }
+
+private:
+    uint64_t GetCheckSum(uint64_t nShortId) const;
+    size_t GetCellIndex(uint64_t nShortId, size_t nHashNum) const;
+    void Toggle(uint64_t nShortId, int32_t nDirection, std::vector<Cell>& cells) const;
+};
+
+#endif // BITCOIN_GOVERNANCE_GOVERNANCE_VOTESKETCH_H
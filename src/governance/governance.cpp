@@ -16,11 +16,13 @@
 #include <spork.h>
 #include <validation.h>
 
+#include <cxxtimer.hpp>
+
 CGovernanceManager governance;
 
 int nSubmittedFinalBudget;
 
-const std::string CGovernanceManager::SERIALIZATION_VERSION_STRING = "CGovernanceManager-Version-15";
+const std::string CGovernanceManager::SERIALIZATION_VERSION_STRING = "CGovernanceManager-Version-17";
 const int CGovernanceManager::MAX_TIME_FUTURE_DEVIATION = 60 * 60;
 const int CGovernanceManager::RELIABLE_PROPAGATION_TIME = 60;
 
@@ -63,8 +65,12 @@ bool CGovernanceManager::HaveVoteForHash(const uint256& nHash) const
 {
     LOCK(cs);
 
-    CGovernanceObject* pGovobj = nullptr;
-    return cmapVoteToObject.Get(nHash, pGovobj) && pGovobj->GetVoteFile().HasVote(nHash);
+    uint256 nParentHash;
+    if (!cmapVoteToObject.Get(nHash, nParentHash)) {
+        return false;
+    }
+    auto it = mapObjects.find(nParentHash);
+    return it != mapObjects.end() && it->second.GetVoteFile().HasVote(nHash);
 }
 
 int CGovernanceManager::GetVoteCount() const
@@ -73,12 +79,22 @@ int CGovernanceManager::GetVoteCount() const
     return (int)cmapVoteToObject.GetSize();
 }
 
+int CGovernanceManager::GetObjectCount() const
+{
+    LOCK(cs);
+    return (int)mapObjects.size();
+}
+
 bool CGovernanceManager::SerializeVoteForHash(const uint256& nHash, CDataStream& ss) const
 {
     LOCK(cs);
 
-    CGovernanceObject* pGovobj = nullptr;
-    return cmapVoteToObject.Get(nHash, pGovobj) && pGovobj->GetVoteFile().SerializeVoteToStream(nHash, ss);
+    uint256 nParentHash;
+    if (!cmapVoteToObject.Get(nHash, nParentHash)) {
+        return false;
+    }
+    auto it = mapObjects.find(nParentHash);
+    return it != mapObjects.end() && it->second.GetVoteFile().SerializeVoteToStream(nHash, ss);
 }
 
 void CGovernanceManager::ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman, bool enable_bip61)
@@ -119,6 +135,42 @@ void CGovernanceManager::ProcessMessage(CNode* pfrom, const std::string& strComm
         LogPrint(BCLog::GOBJECT, "MNGOVERNANCESYNC -- syncing governance objects to our peer %s\n", pfrom->GetLogString());
     }
 
+    // A PEER WANTS TO RECONCILE THE VOTES OF A SINGLE OBJECT
+    else if (strCommand == NetMsgType::MNGOVERNANCERECON) {
+        if (pfrom->nVersion < GOVERNANCE_VOTE_RECON_VERSION) {
+            LogPrint(BCLog::GOBJECT, "MNGOVERNANCERECON -- peer=%d using obsolete version %i\n", pfrom->GetId(), pfrom->nVersion);
+            return;
+        }
+
+        // Ignore such requests until we are fully synced, same as for MNGOVERNANCESYNC
+        if (!masternodeSync.IsSynced()) return;
+
+        CGovernanceVoteSketch sketch;
+        vRecv >> sketch;
+
+        if (!sketch.IsValid()) {
+            LogPrint(BCLog::GOBJECT, "MNGOVERNANCERECON -- invalid sketch with %d cells, peer=%d\n", sketch.GetCellCount(), pfrom->GetId());
+            LOCK(cs_main);
+            Misbehaving(pfrom->GetId(), 20);
+            return;
+        }
+
+        SyncSingleObjVotes(pfrom, sketch, connman);
+    }
+
+    // OUR VOTE SKETCH COULD NOT BE DECODED, FALL BACK TO A BLOOM FILTER
+    else if (strCommand == NetMsgType::MNGOVERNANCERECONFAIL) {
+        if (pfrom->nVersion < GOVERNANCE_VOTE_RECON_VERSION) {
+            return;
+        }
+
+        uint256 nProp;
+        vRecv >> nProp;
+
+        LogPrint(BCLog::GOBJECT, "MNGOVERNANCERECONFAIL -- reconciliation failed for %s, peer=%d\n", nProp.ToString(), pfrom->GetId());
+        RequestGovernanceObject(pfrom, nProp, connman, true, false);
+    }
+
     // A NEW GOVERNANCE OBJECT HAS ARRIVED
     else if (strCommand == NetMsgType::MNGOVERNANCEOBJECT) {
         // MAKE SURE WE HAVE A VALID REFERENCE TO THE TIP BEFORE CONTINUING
@@ -237,20 +289,135 @@ void CGovernanceManager::ProcessMessage(CNode* pfrom, const std::string& strComm
             return;
         }
 
+        // signature verification is expensive, so votes are queued and verified in batches by ProcessPendingVotes
+        bool fProcessNow;
+        {
+            LOCK(cs_pendingVotes);
+            vecPendingVotes.emplace_back(pfrom->GetId(), vote);
+            fProcessNow = vecPendingVotes.size() >= PENDING_VOTES_BATCH_SIZE;
+        }
+        if (fProcessNow) {
+            ProcessPendingVotes(connman);
+        }
+    }
+}
+
+void CGovernanceManager::ProcessPendingVotes(CConnman& connman)
+{
+    std::vector<std::pair<NodeId, CGovernanceVote>> vecVotes;
+    {
+        LOCK(cs_pendingVotes);
+        vecVotes.swap(vecPendingVotes);
+    }
+
+    if (vecVotes.empty()) {
+        return;
+    }
+
+    cxxtimer::Timer verifyTimer(true);
+    PreVerifyVotes(vecVotes);
+    verifyTimer.stop();
+
+    std::map<NodeId, CNode*> mapNodes;
+    connman.ForEachNode([&](CNode* pnode) {
+        pnode->AddRef();
+        mapNodes.emplace(pnode->GetId(), pnode);
+    });
+
+    for (const auto& p : vecVotes) {
+        NodeId nodeId = p.first;
+        const CGovernanceVote& vote = p.second;
+
+        auto itNode = mapNodes.find(nodeId);
+        CNode* pfrom = itNode != mapNodes.end() ? itNode->second : nullptr;
+
         CGovernanceException exception;
         if (ProcessVote(pfrom, vote, exception, connman)) {
-            LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECTVOTE -- %s new\n", strHash);
+            LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECTVOTE -- %s new\n", vote.GetHash().ToString());
             masternodeSync.BumpAssetLastTime("MNGOVERNANCEOBJECTVOTE");
             vote.Relay(connman);
         } else {
             LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECTVOTE -- Rejected vote, error = %s\n", exception.what());
             if ((exception.GetNodePenalty() != 0) && masternodeSync.IsSynced()) {
                 LOCK(cs_main);
-                Misbehaving(pfrom->GetId(), exception.GetNodePenalty());
+                Misbehaving(nodeId, exception.GetNodePenalty());
             }
-            return;
         }
     }
+
+    for (const auto& p : mapNodes) {
+        p.second->Release();
+    }
+
+    LogPrint(BCLog::GOBJECT, "CGovernanceManager::%s -- processed %d votes, vt=%d\n", __func__, vecVotes.size(), verifyTimer.count());
+}
+
+void CGovernanceManager::PreVerifyVotes(const std::vector<std::pair<NodeId, CGovernanceVote>>& vecVotes) const
+{
+    static const size_t MIN_VOTES_PER_THREAD = 8;
+
+    struct PendingVerification {
+        const CGovernanceVote* vote;
+        bool fUseVotingKey;
+        CDeterministicMNCPtr dmn;
+    };
+
+    auto mnList = deterministicMNManager->GetListAtChainTip();
+
+    std::vector<PendingVerification> vecPending;
+    vecPending.reserve(vecVotes.size());
+    {
+        LOCK(cs);
+        for (const auto& p : vecVotes) {
+            const CGovernanceVote& vote = p.second;
+            uint256 nHashVote = vote.GetHash();
+            if (cmapVoteToObject.HasKey(nHashVote) || cmapInvalidVotes.HasKey(nHashVote)) {
+                continue;
+            }
+            // votes for unknown objects end up as orphans and are verified when the object arrives
+            auto it = mapObjects.find(vote.GetParentHash());
+            if (it == mapObjects.end()) {
+                continue;
+            }
+            auto dmn = mnList.GetMNByCollateral(vote.GetMasternodeOutpoint());
+            if (!dmn) {
+                continue;
+            }
+            bool fUseVotingKey = it->second.GetObjectType() == GOVERNANCE_OBJECT_PROPOSAL && vote.GetSignal() == VOTE_SIGNAL_FUNDING;
+            vecPending.emplace_back(PendingVerification{&vote, fUseVotingKey, dmn});
+        }
+    }
+
+    // Successfully verified signatures are remembered by CGovernanceVote, so the verification done by ProcessVote
+    // under cs is cheap afterwards. Votes are verified one by one instead of aggregating them through
+    // CBLSBatchVerifier, as the vote hash does not cover the signature. An aggregated verification would accept
+    // two votes with signatures that were mutated in a way which cancels out in the aggregate.
+    auto verifyRange = [&vecPending](size_t start, size_t step) {
+        for (size_t i = start; i < vecPending.size(); i += step) {
+            const auto& v = vecPending[i];
+            if (v.fUseVotingKey) {
+                v.vote->CheckSignature(v.dmn->pdmnState->keyIDVoting);
+            } else {
+                v.vote->CheckSignature(v.dmn->pdmnState->pubKeyOperator.Get());
+            }
+        }
+    };
+
+    size_t nThreads = std::min((size_t)std::max(GetNumCores(), 1), vecPending.size() / MIN_VOTES_PER_THREAD);
+    if (nThreads <= 1) {
+        verifyRange(0, 1);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(nThreads - 1);
+    for (size_t i = 1; i < nThreads; i++) {
+        threads.emplace_back(verifyRange, i, nThreads);
+    }
+    verifyRange(0, nThreads);
+    for (auto& t : threads) {
+        t.join();
+    }
 }
 
 void CGovernanceManager::CheckOrphanVotes(CGovernanceObject& govobj, CGovernanceException& exception, CConnman& connman)
@@ -270,6 +437,7 @@ void CGovernanceManager::CheckOrphanVotes(CGovernanceObject& govobj, CGovernance
             fRemove = true;
         } else if (govobj.ProcessVote(nullptr, vote, exception, connman)) {
             vote.Relay(connman);
+            setDirtyObjects.emplace(nHash);
             fRemove = true;
         }
         if (fRemove) {
@@ -308,6 +476,10 @@ void CGovernanceManager::AddGovernanceObject(CGovernanceObject& govobj, CConnman
         return;
     }
 
+    governanceDB->WriteObject(objpair.first->second);
+    objpair.first->second.ClearDirtyDB();
+    setDirtyObjects.emplace(nHash);
+
     // SHOULD WE ADD THIS OBJECT TO ANY OTHER MANAGERS?
 
     LogPrint(BCLog::GOBJECT, "CGovernanceManager::AddGovernanceObject -- Before trigger block, GetDataAsPlainString = %s, nObjectType = %d\n",
@@ -349,105 +521,151 @@ void CGovernanceManager::UpdateCachesAndClean()
 
     std::vector<uint256> vecDirtyHashes = mmetaman.GetAndClearDirtyGovernanceObjectHashes();
 
-    LOCK2(cs_main, cs);
+    int64_t nNow = GetAdjustedTime();
+    hash_s_t setHashesToCheck;
 
-    for (const uint256& nHash : vecDirtyHashes) {
-        auto it = mapObjects.find(nHash);
-        if (it == mapObjects.end()) {
-            continue;
-        }
-        it->second.ClearMasternodeVotes();
-    }
+    {
+        LOCK2(cs_main, cs);
 
-    ScopedLockBool guard(cs, fRateChecksEnabled, false);
+        for (const uint256& nHash : vecDirtyHashes) {
+            auto it = mapObjects.find(nHash);
+            if (it == mapObjects.end()) {
+                continue;
+            }
+            it->second.ClearMasternodeVotes();
+            setDirtyObjects.emplace(nHash);
+        }
 
-    // Clean up any expired or invalid triggers
-    triggerman.CleanAndRemove();
+        // Triggers can be expired or marked for deletion by triggerman, so these are always checked. There are only
+        // a few of them
+        for (const auto& pSuperblock : triggerman.GetActiveTriggers()) {
+            setDirtyObjects.emplace(pSuperblock->GetGovernanceObject()->GetHash());
+        }
 
-    auto it = mapObjects.begin();
-    int64_t nNow = GetAdjustedTime();
+        ScopedLockBool guard(cs, fRateChecksEnabled, false);
 
-    while (it != mapObjects.end()) {
-        CGovernanceObject* pObj = &((*it).second);
+        // Clean up any expired or invalid triggers
+        triggerman.CleanAndRemove();
 
-        if (!pObj) {
-            ++it;
-            continue;
+        // Only objects which were touched since the last run or which have a due time based check are visited.
+        // Objects touched while we are working on these are left for the next run
+        while (!setTimedObjectChecks.empty() && setTimedObjectChecks.begin()->first <= nNow) {
+            setDirtyObjects.emplace(setTimedObjectChecks.begin()->second);
+            setTimedObjectChecks.erase(setTimedObjectChecks.begin());
         }
+        setHashesToCheck.swap(setDirtyObjects);
+    }
 
-        uint256 nHash = it->first;
-        std::string strHash = nHash.ToString();
+    size_t nChecked = 0;
+    auto itHash = setHashesToCheck.begin();
+    while (itHash != setHashesToCheck.end()) {
+        // Work in chunks and give message processing a chance to grab the locks in between
+        LOCK2(cs_main, cs);
+        ScopedLockBool guard(cs, fRateChecksEnabled, false);
+
+        int64_t nChunkEnd = GetTimeMillis() + CLEAN_CHUNK_TIME_MILLIS;
+        for (; itHash != setHashesToCheck.end() && GetTimeMillis() < nChunkEnd; ++itHash) {
+            auto it = mapObjects.find(*itHash);
+            if (it == mapObjects.end()) {
+                continue;
+            }
+            UpdateCachesAndCleanObject(it, nNow);
+            nChecked++;
+        }
+    }
 
-        // IF CACHE IS NOT DIRTY, WHY DO THIS?
-        if (pObj->IsSetDirtyCache()) {
-            // UPDATE LOCAL VALIDITY AGAINST CRYPTO DATA
-            pObj->UpdateLocalValidity();
+    LOCK(cs);
 
-            // UPDATE SENTINEL SIGNALING VARIABLES
-            pObj->UpdateSentinelVariables();
+    // forget about expired deleted objects
+    auto s_it = mapErasedGovernanceObjects.begin();
+    while (s_it != mapErasedGovernanceObjects.end()) {
+        if (s_it->second < nNow) {
+            mapErasedGovernanceObjects.erase(s_it++);
+        } else {
+            ++s_it;
         }
+    }
+
+    LogPrintf("CGovernanceManager::UpdateCachesAndClean -- checked %d objects, %s\n", nChecked, ToString());
+}
 
-        // IF DELETE=TRUE, THEN CLEAN THE MESS UP!
+bool CGovernanceManager::UpdateCachesAndCleanObject(std::map<uint256, CGovernanceObject>::iterator it, int64_t nNow)
+{
+    AssertLockHeld(cs);
 
-        int64_t nTimeSinceDeletion = nNow - pObj->GetDeletionTime();
+    CGovernanceObject* pObj = &it->second;
 
-        LogPrint(BCLog::GOBJECT, "CGovernanceManager::UpdateCachesAndClean -- Checking object for deletion: %s, deletion time = %d, time since deletion = %d, delete flag = %d, expired flag = %d\n",
-            strHash, pObj->GetDeletionTime(), nTimeSinceDeletion, pObj->IsSetCachedDelete(), pObj->IsSetExpired());
+    uint256 nHash = it->first;
+    std::string strHash = nHash.ToString();
 
-        if ((pObj->IsSetCachedDelete() || pObj->IsSetExpired()) &&
-            (nTimeSinceDeletion >= GOVERNANCE_DELETION_DELAY)) {
-            LogPrintf("CGovernanceManager::UpdateCachesAndClean -- erase obj %s\n", (*it).first.ToString());
-            mmetaman.RemoveGovernanceObject(pObj->GetHash());
+    // IF CACHE IS NOT DIRTY, WHY DO THIS?
+    if (pObj->IsSetDirtyCache()) {
+        // UPDATE LOCAL VALIDITY AGAINST CRYPTO DATA
+        pObj->UpdateLocalValidity();
 
-            // Remove vote references
-            const object_ref_cm_t::list_t& listItems = cmapVoteToObject.GetItemList();
-            object_ref_cm_t::list_cit lit = listItems.begin();
-            while (lit != listItems.end()) {
-                if (lit->value == pObj) {
-                    uint256 nKey = lit->key;
-                    ++lit;
-                    cmapVoteToObject.Erase(nKey);
-                } else {
-                    ++lit;
-                }
-            }
+        // UPDATE SENTINEL SIGNALING VARIABLES
+        pObj->UpdateSentinelVariables();
+    }
 
-            int64_t nTimeExpired{0};
+    // IF DELETE=TRUE, THEN CLEAN THE MESS UP!
 
-            if (pObj->GetObjectType() == GOVERNANCE_OBJECT_PROPOSAL) {
-                // keep hashes of deleted proposals forever
-                nTimeExpired = std::numeric_limits<int64_t>::max();
-            } else {
-                int64_t nSuperblockCycleSeconds = Params().GetConsensus().nSuperblockCycle * Params().GetConsensus().nPowTargetSpacing;
-                nTimeExpired = pObj->GetCreationTime() + 2 * nSuperblockCycleSeconds + GOVERNANCE_DELETION_DELAY;
-            }
+    int64_t nTimeSinceDeletion = nNow - pObj->GetDeletionTime();
+
+    LogPrint(BCLog::GOBJECT, "CGovernanceManager::UpdateCachesAndClean -- Checking object for deletion: %s, deletion time = %d, time since deletion = %d, delete flag = %d, expired flag = %d\n",
+        strHash, pObj->GetDeletionTime(), nTimeSinceDeletion, pObj->IsSetCachedDelete(), pObj->IsSetExpired());
+
+    if (pObj->IsSetCachedDelete() || pObj->IsSetExpired()) {
+        if (nTimeSinceDeletion < GOVERNANCE_DELETION_DELAY) {
+            setTimedObjectChecks.emplace(pObj->GetDeletionTime() + GOVERNANCE_DELETION_DELAY, nHash);
+            return true;
+        }
+
+        LogPrintf("CGovernanceManager::UpdateCachesAndClean -- erase obj %s\n", strHash);
+        mmetaman.RemoveGovernanceObject(nHash);
+
+        // Remove vote references. Votes which were replaced by newer votes are not in governanceDB anymore, their
+        // references are left to the cache limit of cmapVoteToObject and don't resolve to an object anymore
+        for (const auto& nVoteHash : governanceDB->GetVoteHashes(nHash)) {
+            cmapVoteToObject.Erase(nVoteHash);
+        }
+
+        int64_t nTimeExpired{0};
 
-            mapErasedGovernanceObjects.insert(std::make_pair(nHash, nTimeExpired));
-            mapObjects.erase(it++);
+        if (pObj->GetObjectType() == GOVERNANCE_OBJECT_PROPOSAL) {
+            // keep hashes of deleted proposals forever
+            nTimeExpired = std::numeric_limits<int64_t>::max();
         } else {
-            // NOTE: triggers are handled via triggerman
-            if (pObj->GetObjectType() == GOVERNANCE_OBJECT_PROPOSAL) {
-                CProposalValidator validator(pObj->GetDataAsHexString(), true);
-                if (!validator.Validate()) {
-                    LogPrintf("CGovernanceManager::UpdateCachesAndClean -- set for deletion expired obj %s\n", strHash);
-                    pObj->PrepareDeletion(nNow);
-                }
-            }
-            ++it;
+            int64_t nSuperblockCycleSeconds = Params().GetConsensus().nSuperblockCycle * Params().GetConsensus().nPowTargetSpacing;
+            nTimeExpired = pObj->GetCreationTime() + 2 * nSuperblockCycleSeconds + GOVERNANCE_DELETION_DELAY;
         }
+
+        mapErasedGovernanceObjects.insert(std::make_pair(nHash, nTimeExpired));
+        governanceDB->EraseObject(nHash);
+        mapObjects.erase(it);
+        return false;
     }
 
-    // forget about expired deleted objects
-    auto s_it = mapErasedGovernanceObjects.begin();
-    while (s_it != mapErasedGovernanceObjects.end()) {
-        if (s_it->second < nNow) {
-            mapErasedGovernanceObjects.erase(s_it++);
+    // NOTE: triggers are handled via triggerman
+    if (pObj->GetObjectType() == GOVERNANCE_OBJECT_PROPOSAL) {
+        // Everything but the expiration of a proposal never changes, so the proposal is only validated once and
+        // checked again when it expires
+        auto data = pObj->GetParsedData();
+        if (!data->fValidProposal) {
+            LogPrintf("CGovernanceManager::UpdateCachesAndClean -- set for deletion invalid obj %s\n", strHash);
+            pObj->PrepareDeletion(nNow);
+            setTimedObjectChecks.emplace(pObj->GetDeletionTime() + GOVERNANCE_DELETION_DELAY, nHash);
+            return true;
+        }
+        if (data->proposal.nEndEpoch <= nNow) {
+            LogPrintf("CGovernanceManager::UpdateCachesAndClean -- set for deletion expired obj %s\n", strHash);
+            pObj->PrepareDeletion(nNow);
+            setTimedObjectChecks.emplace(pObj->GetDeletionTime() + GOVERNANCE_DELETION_DELAY, nHash);
         } else {
-            ++s_it;
+            setTimedObjectChecks.emplace(data->proposal.nEndEpoch, nHash);
         }
     }
 
-    LogPrintf("CGovernanceManager::UpdateCachesAndClean -- %s\n", ToString());
+    return true;
 }
 
 CGovernanceObject* CGovernanceManager::FindGovernanceObject(const uint256& nHash)
@@ -459,47 +677,43 @@ CGovernanceObject* CGovernanceManager::FindGovernanceObject(const uint256& nHash
     return nullptr;
 }
 
-std::vector<CGovernanceVote> CGovernanceManager::GetCurrentVotes(const uint256& nParentHash, const COutPoint& mnCollateralOutpointFilter) const
+void CGovernanceManager::ForEachCurrentVote(const uint256& nParentHash, const COutPoint& mnCollateralOutpointFilter, const std::function<void(const CGovernanceVote&)>& func) const
 {
     LOCK(cs);
-    std::vector<CGovernanceVote> vecResult;
 
     // Find the governance object or short-circuit.
     auto it = mapObjects.find(nParentHash);
-    if (it == mapObjects.end()) return vecResult;
+    if (it == mapObjects.end()) return;
     const CGovernanceObject& govobj = it->second;
 
+    // Walk the votes of the object (which are indexed by collateral outpoint) instead of the whole masternode list,
+    // only votes of masternodes which are still registered are reported
     auto mnList = deterministicMNManager->GetListAtChainTip();
-    std::map<COutPoint, CDeterministicMNCPtr> mapMasternodes;
-    if (mnCollateralOutpointFilter.IsNull()) {
-        mnList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
-            mapMasternodes.emplace(dmn->collateralOutpoint, dmn);
-        });
-    } else {
-        auto dmn = mnList.GetMNByCollateral(mnCollateralOutpointFilter);
-        if (dmn) {
-            mapMasternodes.emplace(dmn->collateralOutpoint, dmn);
+    const COutPoint* pFilter = mnCollateralOutpointFilter.IsNull() ? nullptr : &mnCollateralOutpointFilter;
+    govobj.ForEachCurrentMNVotes(pFilter, [&](const COutPoint& outpoint, const vote_rec_t& voteRecord) {
+        if (!mnList.HasMNByCollateral(outpoint)) {
+            return;
         }
-    }
-
-    // Loop through each MN collateral outpoint and get the votes for the `nParentHash` governance object
-    for (const auto& mnpair : mapMasternodes) {
-        // get a vote_rec_t from the govobj
-        vote_rec_t voteRecord;
-        if (!govobj.GetCurrentMNVotes(mnpair.first, voteRecord)) continue;
 
         for (const auto& voteInstancePair : voteRecord.mapInstances) {
             int signal = voteInstancePair.first;
             int outcome = voteInstancePair.second.eOutcome;
             int64_t nCreationTime = voteInstancePair.second.nCreationTime;
 
-            CGovernanceVote vote = CGovernanceVote(mnpair.first, nParentHash, (vote_signal_enum_t)signal, (vote_outcome_enum_t)outcome);
+            CGovernanceVote vote = CGovernanceVote(outpoint, nParentHash, (vote_signal_enum_t)signal, (vote_outcome_enum_t)outcome);
             vote.SetTime(nCreationTime);
 
-            vecResult.push_back(vote);
+            func(vote);
         }
-    }
+    });
+}
 
+std::vector<CGovernanceVote> CGovernanceManager::GetCurrentVotes(const uint256& nParentHash, const COutPoint& mnCollateralOutpointFilter) const
+{
+    std::vector<CGovernanceVote> vecResult;
+    ForEachCurrentVote(nParentHash, mnCollateralOutpointFilter, [&](const CGovernanceVote& vote) {
+        vecResult.push_back(vote);
+    });
     return vecResult;
 }
 
@@ -536,7 +750,12 @@ struct sortProposalsByVotes {
 
 void CGovernanceManager::DoMaintenance(CConnman& connman)
 {
-    if (fDisableGovernance || !masternodeSync.IsSynced() || ShutdownRequested()) return;
+    if (fDisableGovernance) return;
+
+    // objects are received during sync too, so flush them before waiting for it to finish
+    FlushObjects();
+
+    if (!masternodeSync.IsSynced() || ShutdownRequested()) return;
 
     // CHECK OBJECTS WE'VE ASKED FOR, REMOVE OLD ENTRIES
 
@@ -602,15 +821,8 @@ bool CGovernanceManager::ConfirmInventoryRequest(const CInv& inv)
     return true;
 }
 
-void CGovernanceManager::SyncSingleObjVotes(CNode* pnode, const uint256& nProp, const CBloomFilter& filter, CConnman& connman)
+bool CGovernanceManager::GetSyncableVoteHashes(CNode* pnode, const uint256& nProp, std::vector<uint256>& vecVoteHashesRet)
 {
-    // do not provide any data until our node is synced
-    if (!masternodeSync.IsSynced()) return;
-
-    int nVoteCount = 0;
-
-    // SYNC GOVERNANCE OBJECTS WITH OTHER CLIENT
-
     LogPrint(BCLog::GOBJECT, "CGovernanceManager::%s -- syncing single object to peer=%d, nProp = %s\n", __func__, pnode->GetId(), nProp.ToString());
 
     LOCK2(cs_main, cs);
@@ -619,7 +831,7 @@ void CGovernanceManager::SyncSingleObjVotes(CNode* pnode, const uint256& nProp,
     auto it = mapObjects.find(nProp);
     if (it == mapObjects.end()) {
         LogPrint(BCLog::GOBJECT, "CGovernanceManager::%s -- no matching object for hash %s, peer=%d\n", __func__, nProp.ToString(), pnode->GetId());
-        return;
+        return false;
     }
     CGovernanceObject& govobj = it->second;
     std::string strHash = it->first.ToString();
@@ -629,26 +841,97 @@ void CGovernanceManager::SyncSingleObjVotes(CNode* pnode, const uint256& nProp,
     if (govobj.IsSetCachedDelete() || govobj.IsSetExpired()) {
         LogPrintf("CGovernanceManager::%s -- not syncing deleted/expired govobj: %s, peer=%d\n", __func__,
             strHash, pnode->GetId());
-        return;
+        return false;
     }
 
     auto fileVotes = govobj.GetVoteFile();
 
     for (const auto& vote : fileVotes.GetVotes()) {
-        uint256 nVoteHash = vote.GetHash();
-
         bool onlyVotingKeyAllowed = govobj.GetObjectType() == GOVERNANCE_OBJECT_PROPOSAL && vote.GetSignal() == VOTE_SIGNAL_FUNDING;
 
-        if (filter.contains(nVoteHash) || !vote.IsValid(onlyVotingKeyAllowed)) {
+        if (!vote.IsValid(onlyVotingKeyAllowed)) {
             continue;
         }
+        vecVoteHashesRet.emplace_back(vote.GetHash());
+    }
+
+    return true;
+}
+
+void CGovernanceManager::PushVoteInventory(CNode* pnode, const std::vector<uint256>& vecVoteHashes, CConnman& connman)
+{
+    for (const auto& nVoteHash : vecVoteHashes) {
         pnode->PushInventory(CInv(MSG_GOVERNANCE_OBJECT_VOTE, nVoteHash));
-        ++nVoteCount;
     }
 
     CNetMsgMaker msgMaker(pnode->GetSendVersion());
-    connman.PushMessage(pnode, msgMaker.Make(NetMsgType::SYNCSTATUSCOUNT, MASTERNODE_SYNC_GOVOBJ_VOTE, nVoteCount));
-    LogPrintf("CGovernanceManager::%s -- sent %d votes to peer=%d\n", __func__, nVoteCount, pnode->GetId());
+    connman.PushMessage(pnode, msgMaker.Make(NetMsgType::SYNCSTATUSCOUNT, MASTERNODE_SYNC_GOVOBJ_VOTE, (int)vecVoteHashes.size()));
+    LogPrintf("CGovernanceManager::%s -- sent %d votes to peer=%d\n", __func__, vecVoteHashes.size(), pnode->GetId());
+}
+
+void CGovernanceManager::SyncSingleObjVotes(CNode* pnode, const uint256& nProp, const CBloomFilter& filter, CConnman& connman)
+{
+    // do not provide any data until our node is synced
+    if (!masternodeSync.IsSynced()) return;
+
+    // SYNC GOVERNANCE OBJECTS WITH OTHER CLIENT
+
+    std::vector<uint256> vecVoteHashes;
+    if (!GetSyncableVoteHashes(pnode, nProp, vecVoteHashes)) {
+        return;
+    }
+
+    vecVoteHashes.erase(std::remove_if(vecVoteHashes.begin(), vecVoteHashes.end(), [&](const uint256& nVoteHash) {
+        return filter.contains(nVoteHash);
+    }), vecVoteHashes.end());
+
+    PushVoteInventory(pnode, vecVoteHashes, connman);
+}
+
+void CGovernanceManager::SyncSingleObjVotes(CNode* pnode, const CGovernanceVoteSketch& sketch, CConnman& connman)
+{
+    // do not provide any data until our node is synced
+    if (!masternodeSync.IsSynced()) return;
+
+    const uint256& nProp = sketch.GetParentHash();
+
+    std::vector<uint256> vecVoteHashes;
+    if (!GetSyncableVoteHashes(pnode, nProp, vecVoteHashes)) {
+        return;
+    }
+
+    CGovernanceVoteSketch ourSketch(nProp, sketch.GetSalt(), sketch.GetCellCount());
+    std::map<uint64_t, uint256> mapShortIds;
+    for (const auto& nVoteHash : vecVoteHashes) {
+        uint64_t nShortId = ourSketch.GetShortId(nVoteHash);
+        mapShortIds.emplace(nShortId, nVoteHash);
+        ourSketch.AddShortId(nShortId);
+    }
+    ourSketch.Subtract(sketch);
+
+    // votes we know about but the peer doesn't are "positive", the ones only the peer knows are "negative"
+    std::set<uint64_t> setPeerMissing;
+    std::set<uint64_t> setWeMissing;
+    if (!ourSketch.Decode(setPeerMissing, setWeMissing)) {
+        LogPrint(BCLog::GOBJECT, "CGovernanceManager::%s -- failed to decode sketch for %s, peer=%d\n", __func__, nProp.ToString(), pnode->GetId());
+        CNetMsgMaker msgMaker(pnode->GetSendVersion());
+        connman.PushMessage(pnode, msgMaker.Make(NetMsgType::MNGOVERNANCERECONFAIL, nProp));
+        return;
+    }
+
+    LogPrint(BCLog::GOBJECT, "CGovernanceManager::%s -- reconciled votes for %s, peer is missing %d, we are missing %d, peer=%d\n", __func__,
+        nProp.ToString(), setPeerMissing.size(), setWeMissing.size(), pnode->GetId());
+
+    std::vector<uint256> vecToSend;
+    vecToSend.reserve(setPeerMissing.size());
+    for (const auto& nShortId : setPeerMissing) {
+        auto it = mapShortIds.find(nShortId);
+        if (it != mapShortIds.end()) {
+            vecToSend.emplace_back(it->second);
+        }
+    }
+
+    PushVoteInventory(pnode, vecToSend, connman);
 }
 
 void CGovernanceManager::SyncObjects(CNode* pnode, CConnman& connman) const
@@ -839,7 +1122,10 @@ bool CGovernanceManager::ProcessVote(CNode* pfrom, const CGovernanceVote& vote,
         return false;
     }
 
-    bool fOk = govobj.ProcessVote(pfrom, vote, exception, connman) && cmapVoteToObject.Insert(nHashVote, &govobj);
+    bool fOk = govobj.ProcessVote(pfrom, vote, exception, connman) && cmapVoteToObject.Insert(nHashVote, nHashGovobj);
+    if (fOk) {
+        setDirtyObjects.emplace(nHashGovobj);
+    }
     LEAVE_CRITICAL_SECTION(cs);
     return fOk;
 }
@@ -909,7 +1195,7 @@ void CGovernanceManager::CheckPostponedObjects(CConnman& connman)
     }
 }
 
-void CGovernanceManager::RequestGovernanceObject(CNode* pfrom, const uint256& nHash, CConnman& connman, bool fUseFilter)
+void CGovernanceManager::RequestGovernanceObject(CNode* pfrom, const uint256& nHash, CConnman& connman, bool fUseFilter, bool fAllowRecon)
 {
     if (!pfrom) {
         return;
@@ -928,9 +1214,22 @@ void CGovernanceManager::RequestGovernanceObject(CNode* pfrom, const uint256& nH
         CGovernanceObject* pObj = FindGovernanceObject(nHash);
 
         if (pObj) {
-            filter = CBloomFilter(Params().GetConsensus().nGovernanceFilterElements, GOVERNANCE_FILTER_FP_RATE, GetRandInt(999999), BLOOM_UPDATE_ALL);
             std::vector<CGovernanceVote> vecVotes = pObj->GetVoteFile().GetVotes();
             nVoteCount = vecVotes.size();
+
+            // Peers which support reconciliation get a sketch of our votes instead of a bloom filter, so that only
+            // the differences are announced to us. If we don't have votes yet, there is nothing to reconcile.
+            if (fAllowRecon && nVoteCount != 0 && pfrom->nVersion >= GOVERNANCE_VOTE_RECON_VERSION) {
+                CGovernanceVoteSketch sketch(nHash, GetRand(std::numeric_limits<uint64_t>::max()), CGovernanceVoteSketch::GetCellCountForVotes(nVoteCount));
+                for (const auto& vote : vecVotes) {
+                    sketch.Add(vote.GetHash());
+                }
+                LogPrint(BCLog::GOBJECT, "CGovernanceManager::RequestGovernanceObject -- nHash %s nVoteCount %d nCells %d peer=%d\n", nHash.ToString(), nVoteCount, sketch.GetCellCount(), pfrom->GetId());
+                connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::MNGOVERNANCERECON, sketch));
+                return;
+            }
+
+            filter = CBloomFilter(Params().GetConsensus().nGovernanceFilterElements, GOVERNANCE_FILTER_FP_RATE, GetRandInt(999999), BLOOM_UPDATE_ALL);
             for (const auto& vote : vecVotes) {
                 filter.insert(vote.GetHash());
             }
@@ -1084,11 +1383,31 @@ void CGovernanceManager::RebuildIndexes()
     cmapVoteToObject.Clear();
     for (auto& objPair : mapObjects) {
         CGovernanceObject& govobj = objPair.second;
-        std::vector<CGovernanceVote> vecVotes = govobj.GetVoteFile().GetVotes();
-        for (size_t i = 0; i < vecVotes.size(); ++i) {
-            cmapVoteToObject.Insert(vecVotes[i].GetHash(), &govobj);
+        if (govobj.GetVoteFile().GetVoteCount() == 0) {
+            continue;
+        }
+        for (const auto& nVoteHash : governanceDB->GetVoteHashes(objPair.first)) {
+            cmapVoteToObject.Insert(nVoteHash, objPair.first);
+        }
+    }
+}
+
+void CGovernanceManager::FlushObjects()
+{
+    LOCK(cs);
+
+    int nCount = 0;
+    for (auto& objPair : mapObjects) {
+        CGovernanceObject& govobj = objPair.second;
+        if (!govobj.IsSetDirtyDB()) {
+            continue;
         }
+        governanceDB->WriteObject(govobj);
+        govobj.ClearDirtyDB();
+        nCount++;
     }
+
+    LogPrint(BCLog::GOBJECT, "CGovernanceManager::%s -- wrote %d changed objects\n", __func__, nCount);
 }
 
 void CGovernanceManager::AddCachedTriggers()
@@ -1112,7 +1431,16 @@ void CGovernanceManager::InitOnLoad()
 {
     LOCK(cs);
     int64_t nStart = GetTimeMillis();
-    LogPrintf("Preparing masternode indexes and governance triggers...\n");
+    LogPrintf("Loading governance objects and preparing masternode indexes and governance triggers...\n");
+    governanceDB->LoadObjects(mapObjects);
+    // after an unclean shutdown, votes might have been written after their objects were last written (or erased)
+    std::set<uint256> setObjectHashes;
+    for (auto& objPair : mapObjects) {
+        setObjectHashes.emplace(objPair.first);
+        setDirtyObjects.emplace(objPair.first);
+        objPair.second.SyncVoteRecords();
+    }
+    governanceDB->EraseVotesExceptForObjects(setObjectHashes);
     RebuildIndexes();
     AddCachedTriggers();
     LogPrintf("Masternode indexes and governance triggers prepared  %dms\n", GetTimeMillis() - nStart);
@@ -1280,6 +1608,7 @@ void CGovernanceManager::RemoveInvalidVotes()
             if (removed.empty()) {
                 continue;
             }
+            setDirtyObjects.emplace(p.first);
             for (auto& voteHash : removed) {
                 cmapVoteToObject.Erase(voteHash);
                 cmapInvalidVotes.Erase(voteHash);
@@ -12,6 +12,7 @@
 #include <governance/governance-exceptions.h>
 #include <governance/governance-object.h>
 #include <governance/governance-vote.h>
+#include <governance/governance-votesketch.h>
 #include <net.h>
 #include <sync.h>
 #include <timedata.h>
@@ -160,7 +161,8 @@ public: // Types
     };
 
 
-    typedef CacheMap<uint256, CGovernanceObject*> object_ref_cm_t;
+    // vote hash -> hash of the voted object
+    typedef CacheMap<uint256, uint256> object_ref_cm_t;
 
     typedef CacheMultiMap<uint256, vote_time_pair_t> vote_cmm_t;
 
@@ -176,6 +178,12 @@ private:
     static const int MAX_TIME_FUTURE_DEVIATION;
     static const int RELIABLE_PROPAGATION_TIME;
 
+    // UpdateCachesAndClean releases cs_main and cs after working on objects for this long
+    static const int64_t CLEAN_CHUNK_TIME_MILLIS = 50;
+
+    // pending votes are processed immediately when this many are queued, otherwise once per second
+    static const size_t PENDING_VOTES_BATCH_SIZE = 64;
+
     int64_t nTimeLastDiff;
 
     // keep track of current block height
@@ -209,6 +217,17 @@ private:
     // used to check for changed voting keys
     CDeterministicMNList lastMNListForVotingKeys;
 
+    // objects which were touched since the last run of UpdateCachesAndClean and need to be checked again
+    hash_s_t setDirtyObjects;
+
+    // (time, object hash) of objects which must be checked again at that time even if they weren't touched,
+    // e.g. because their deletion delay is over or a proposal expires
+    std::set<std::pair<int64_t, uint256>> setTimedObjectChecks;
+
+    // votes received from the network which still need to be processed, see ProcessPendingVotes
+    CCriticalSection cs_pendingVotes;
+    std::vector<std::pair<NodeId, CGovernanceVote>> vecPendingVotes;
+
     class ScopedLockBool
     {
         bool& ref;
@@ -245,16 +264,21 @@ public:
     bool ConfirmInventoryRequest(const CInv& inv);
 
     void SyncSingleObjVotes(CNode* pnode, const uint256& nProp, const CBloomFilter& filter, CConnman& connman);
+    void SyncSingleObjVotes(CNode* pnode, const CGovernanceVoteSketch& sketch, CConnman& connman);
     void SyncObjects(CNode* pnode, CConnman& connman) const;
 
     void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman, bool enable_bip61);
 
     void DoMaintenance(CConnman& connman);
 
+    // Verifies the signatures of all pending votes in parallel (outside of cs) and processes them afterwards
+    void ProcessPendingVotes(CConnman& connman);
+
     CGovernanceObject* FindGovernanceObject(const uint256& nHash);
 
     // These commands are only used in RPC
     std::vector<CGovernanceVote> GetCurrentVotes(const uint256& nParentHash, const COutPoint& mnCollateralOutpointFilter) const;
+    void ForEachCurrentVote(const uint256& nParentHash, const COutPoint& mnCollateralOutpointFilter, const std::function<void(const CGovernanceVote&)>& func) const;
     std::vector<const CGovernanceObject*> GetAllNewerThan(int64_t nMoreThanTime) const;
 
     void AddGovernanceObject(CGovernanceObject& govobj, CConnman& connman, CNode* pfrom = nullptr);
@@ -263,6 +287,9 @@ public:
 
     void CheckAndRemove() { UpdateCachesAndClean(); }
 
+    // Writes all objects which changed since they were last written to governanceDB
+    void FlushObjects();
+
     void Clear()
     {
         LOCK(cs);
@@ -270,6 +297,8 @@ public:
         LogPrint(BCLog::GOBJECT, "Governance object manager was cleared\n");
         mapObjects.clear();
         mapErasedGovernanceObjects.clear();
+        setDirtyObjects.clear();
+        setTimedObjectChecks.clear();
         cmapVoteToObject.Clear();
         cmapInvalidVotes.Clear();
         cmmapOrphanVotes.Clear();
@@ -297,10 +326,10 @@ public:
             READWRITE(strVersion);
         }
 
+        // objects and votes are stored in governanceDB
         READWRITE(mapErasedGovernanceObjects);
         READWRITE(cmapInvalidVotes);
         READWRITE(cmmapOrphanVotes);
-        READWRITE(mapObjects);
         READWRITE(mapLastMasternodeObject);
         READWRITE(lastMNListForVotingKeys);
     }
@@ -317,6 +346,7 @@ public:
     bool HaveVoteForHash(const uint256& nHash) const;
 
     int GetVoteCount() const;
+    int GetObjectCount() const;
 
     bool SerializeObjectForHash(const uint256& nHash, CDataStream& ss) const;
 
@@ -357,7 +387,7 @@ public:
     int RequestGovernanceObjectVotes(const std::vector<CNode*>& vNodesCopy, CConnman& connman);
 
 private:
-    void RequestGovernanceObject(CNode* pfrom, const uint256& nHash, CConnman& connman, bool fUseFilter = false);
+    void RequestGovernanceObject(CNode* pfrom, const uint256& nHash, CConnman& connman, bool fUseFilter = false, bool fAllowRecon = true);
 
     void AddInvalidVote(const CGovernanceVote& vote)
     {
@@ -366,6 +396,16 @@ private:
 
     bool ProcessVote(CNode* pfrom, const CGovernanceVote& vote, CGovernanceException& exception, CConnman& connman);
 
+    // Collects the hashes of all valid votes of an object which can be announced to peers
+    bool GetSyncableVoteHashes(CNode* pnode, const uint256& nProp, std::vector<uint256>& vecVoteHashesRet);
+    void PushVoteInventory(CNode* pnode, const std::vector<uint256>& vecVoteHashes, CConnman& connman);
+
+    // Updates the cached state of a single object and erases it if its deletion delay is over.
+    // Returns false if the object was erased
+    bool UpdateCachesAndCleanObject(std::map<uint256, CGovernanceObject>::iterator it, int64_t nNow);
+
+    void PreVerifyVotes(const std::vector<std::pair<NodeId, CGovernanceVote>>& vecVotes) const;
+
     /// Called to indicate a requested object has been received
     bool AcceptObjectMessage(const uint256& nHash);
 
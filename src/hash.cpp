@@ -6,6 +6,8 @@
 #include <crypto/common.h>
 #include <crypto/hmac_sha512.h>
 
+#include <algorithm>
+
 
 inline uint32_t ROTL32(uint32_t x, int8_t r)
 {
@@ -245,3 +247,46 @@ uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint3
     SIPROUND;
     return v0 ^ v1 ^ v2 ^ v3;
 }
+
+#define X11_MULTI_STEP(name, in, out) do { \
+        for (size_t j = 0; j < lanes; j++) { \
+            sph_##name##512_context ctx; \
+            sph_##name##512_init(&ctx); \
+            sph_##name##512(&ctx, in[j].begin(), 64); \
+            sph_##name##512_close(&ctx, out[j].begin()); \
+        } \
+    } while (0)
+
+void HashX11Multi(const unsigned char* data, size_t len, size_t n, uint256* out)
+{
+    static unsigned char pblank[1];
+    uint512 a[X11_MULTI_LANES], b[X11_MULTI_LANES];
+    // the lanes are passed as contiguous 64 byte blocks to the multi-lane steps
+    static_assert(sizeof(uint512) == 64, "uint512 must not be padded");
+
+    for (size_t i = 0; i < n; i += X11_MULTI_LANES) {
+        const size_t lanes = std::min(X11_MULTI_LANES, n - i);
+
+        for (size_t j = 0; j < lanes; j++) {
+            sph_blake512_context ctx;
+            sph_blake512_init(&ctx);
+            sph_blake512(&ctx, len == 0 ? pblank : data + (i + j) * len, len);
+            sph_blake512_close(&ctx, a[j].begin());
+        }
+        X11_MULTI_STEP(bmw, a, b);
+        X11_MULTI_STEP(groestl, b, a);
+        X11_MULTI_STEP(skein, a, b);
+        X11_MULTI_STEP(jh, b, a);
+        X11_MULTI_STEP(keccak, a, b);
+        X11_MULTI_STEP(luffa, b, a);
+        X11_MULTI_STEP(cubehash, a, b);
+        X11Shavite512_64Multi(a[0].begin(), b[0].begin(), lanes);
+        X11_MULTI_STEP(simd, a, b);
+        for (size_t j = 0; j < lanes; j++) {
+            X11Echo512_64(a[j].begin(), b[j].begin());
+            out[i + j] = a[j].trim256();
+        }
+    }
+}
+
+#undef X11_MULTI_STEP
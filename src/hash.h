@@ -9,6 +9,7 @@
 
 #include <crypto/ripemd160.h>
 #include <crypto/sha256.h>
+#include <crypto/x11.h>
 #include <prevector.h>
 #include <serialize.h>
 #include <uint256.h>
@@ -298,6 +299,16 @@ uint64_t SipHashUint256(uint64_t k0, uint64_t k1, const uint256& val);
 uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint32_t extra);
 
 /* ----------- Dash Hash ------------------------------------------------ */
+/** Number of inputs HashX11Multi runs through each X11 step before moving on to the next one */
+static const size_t X11_MULTI_LANES = 8;
+
+/**
+ * Compute the X11 hashes of n inputs of len bytes each, stored back to back at
+ * data. The inputs are processed in groups of X11_MULTI_LANES, one algorithm at
+ * a time, so steps with a multi-lane implementation can hash a group at once.
+ */
+void HashX11Multi(const unsigned char* data, size_t len, size_t n, uint256* out);
+
 template<typename T1>
 inline uint256 HashX11(const T1 pbegin, const T1 pend)
 
@@ -310,9 +321,7 @@ inline uint256 HashX11(const T1 pbegin, const T1 pend)
     sph_skein512_context     ctx_skein;
     sph_luffa512_context     ctx_luffa;
     sph_cubehash512_context  ctx_cubehash;
-    sph_shavite512_context   ctx_shavite;
     sph_simd512_context      ctx_simd;
-    sph_echo512_context      ctx_echo;
     static unsigned char pblank[1];
 
     uint512 hash[11];
@@ -349,17 +358,13 @@ inline uint256 HashX11(const T1 pbegin, const T1 pend)
     sph_cubehash512 (&ctx_cubehash, static_cast<const void*>(&hash[6]), 64);
     sph_cubehash512_close(&ctx_cubehash, static_cast<void*>(&hash[7]));
 
-    sph_shavite512_init(&ctx_shavite);
-    sph_shavite512(&ctx_shavite, static_cast<const void*>(&hash[7]), 64);
-    sph_shavite512_close(&ctx_shavite, static_cast<void*>(&hash[8]));
+    X11Shavite512_64(hash[8].begin(), hash[7].begin());
 
     sph_simd512_init(&ctx_simd);
     sph_simd512 (&ctx_simd, static_cast<const void*>(&hash[8]), 64);
     sph_simd512_close(&ctx_simd, static_cast<void*>(&hash[9]));
 
-    sph_echo512_init(&ctx_echo);
-    sph_echo512 (&ctx_echo, static_cast<const void*>(&hash[9]), 64);
-    sph_echo512_close(&ctx_echo, static_cast<void*>(&hash[10]));
+    X11Echo512_64(hash[10].begin(), hash[9].begin());
 
     return hash[10].trim256();
 }
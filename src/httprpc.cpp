@@ -18,12 +18,29 @@
 #include <stdio.h>
 
 #include <memory>
+#include <set>
 
 #include <boost/algorithm/string.hpp> // boost::trim
 
 /** WWW-Authenticate to present with 401 Unauthorized response */
 static const char* WWW_AUTH_HEADER_DATA = "Basic realm=\"jsonrpc\"";
 
+/** Maximum size of a request body which is parsed on the event loop thread to classify the request */
+static const size_t MAX_CLASSIFY_BODY_SIZE = 4096;
+
+/** Cheap RPC methods which are handled by the fast work queue, e.g. for load balancer health checks */
+static const std::set<std::string> setFastRPCMethods = {
+    "echo", "getbestblockhash", "getbestchainlock", "getblockcount", "getblockhash", "getconnectioncount",
+    "getdifficulty", "getmempoolinfo", "getrpcinfo", "mnsync", "ping", "uptime",
+};
+
+/** RPC methods which can take long and are handled by the heavy work queue */
+static const std::set<std::string> setHeavyRPCMethods = {
+    "dumptxoutset", "getaddressbalance", "getaddressdeltas", "getaddressmempool", "getaddresstxids",
+    "getaddressutxos", "getblockstats", "getchaintxstats", "gettxoutsetinfo", "gobject", "masternodelist",
+    "protx", "verifychain",
+};
+
 /** Simple one-shot callback timer to be used by the RPC mechanism to e.g.
  * re-lock the wallet.
  */
@@ -193,8 +210,12 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
 
             UniValue result = tableRPC.execute(jreq);
 
-            // Send reply
-            strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            // Send reply, large replies are streamed in chunks while they are serialized
+            req->WriteHeader("Content-Type", "application/json");
+            JSONStreamWriter writer([req](const std::string& strChunk) { req->WriteReplyChunk(HTTP_OK, strChunk); });
+            JSONRPCWriteReply(writer, result, NullUniValue, jreq.id);
+            req->WriteReply(HTTP_OK, writer.Finish());
+            return true;
 
         // array of requests
         } else if (valRequest.isArray())
@@ -236,16 +257,46 @@ static bool InitRPCAuthentication()
     return true;
 }
 
+/** Select the work queue of a JSON-RPC request by its endpoint and method. Batches are handled
+ * by the default work queue as they can mix methods of all classes.
+ */
+static HTTPRequestClass ClassifyJSONRPCRequest(HTTPRequest* req, const std::string&)
+{
+    if (req->GetURI().compare(0, 8, "/wallet/") == 0) {
+        return HTTPRequestClass::WALLET;
+    }
+    UniValue valRequest;
+    if (!valRequest.read(req->PeekBody(MAX_CLASSIFY_BODY_SIZE)) || !valRequest.isObject()) {
+        return HTTPRequestClass::DEFAULT;
+    }
+    const UniValue& method = find_value(valRequest, "method");
+    if (!method.isStr()) {
+        return HTTPRequestClass::DEFAULT;
+    }
+    const std::string& strMethod = method.get_str();
+    if (setFastRPCMethods.count(strMethod)) {
+        return HTTPRequestClass::FAST;
+    }
+    if (setHeavyRPCMethods.count(strMethod)) {
+        return HTTPRequestClass::HEAVY;
+    }
+    const CRPCCommand* pcmd = tableRPC[strMethod];
+    if (pcmd && pcmd->category == "wallet") {
+        return HTTPRequestClass::WALLET;
+    }
+    return HTTPRequestClass::DEFAULT;
+}
+
 bool StartHTTPRPC()
 {
     LogPrint(BCLog::RPC, "Starting HTTP RPC server\n");
     if (!InitRPCAuthentication())
         return false;
 
-    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC);
+    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC, ClassifyJSONRPCRequest);
 #ifdef ENABLE_WALLET
     // ifdef can be removed once we switch to better endpoint support and API versioning
-    RegisterHTTPHandler("/wallet/", false, HTTPReq_JSONRPC);
+    RegisterHTTPHandler("/wallet/", false, HTTPReq_JSONRPC, ClassifyJSONRPCRequest);
 #endif
     assert(EventBase());
     httpRPCTimerInterface = MakeUnique<HTTPRPCTimerInterface>(EventBase());
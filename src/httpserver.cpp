@@ -76,9 +76,14 @@ private:
     /** Mutex protects entire object */
     std::mutex cs;
     std::condition_variable cond;
-    std::deque<std::unique_ptr<WorkItem>> queue;
+    /** Work items with the time they were enqueued at */
+    std::deque<std::pair<std::unique_ptr<WorkItem>, int64_t>> queue;
     bool running;
     size_t maxDepth;
+    uint64_t nProcessed{0};
+    uint64_t nRejected{0};
+    int64_t nTotalWaitMicros{0};
+    int64_t nMaxWaitMicros{0};
 
 public:
     explicit WorkQueue(size_t _maxDepth) : running(true),
@@ -95,9 +100,10 @@ public:
     {
         std::unique_lock<std::mutex> lock(cs);
         if (queue.size() >= maxDepth) {
+            nRejected++;
             return false;
         }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
+        queue.emplace_back(std::unique_ptr<WorkItem>(item), GetTimeMicros());
         cond.notify_one();
         return true;
     }
@@ -112,8 +118,12 @@ public:
                     cond.wait(lock);
                 if (!running)
                     break;
-                i = std::move(queue.front());
+                i = std::move(queue.front().first);
+                int64_t nWaitMicros = GetTimeMicros() - queue.front().second;
                 queue.pop_front();
+                nProcessed++;
+                nTotalWaitMicros += nWaitMicros;
+                nMaxWaitMicros = std::max(nMaxWaitMicros, nWaitMicros);
             }
             (*i)();
         }
@@ -125,18 +135,42 @@ public:
         running = false;
         cond.notify_all();
     }
+    /** Fill the queue part of stats */
+    void GetStats(HTTPWorkQueueStats& stats)
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        stats.nMaxDepth = maxDepth;
+        stats.nDepth = queue.size();
+        stats.nProcessed = nProcessed;
+        stats.nRejected = nRejected;
+        stats.nTotalWaitMicros = nTotalWaitMicros;
+        stats.nMaxWaitMicros = nMaxWaitMicros;
+    }
 };
 
 struct HTTPPathHandler
 {
     HTTPPathHandler() {}
-    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler):
-        prefix(_prefix), exactMatch(_exactMatch), handler(_handler)
+    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler, HTTPRequestClassifier _classifier):
+        prefix(_prefix), exactMatch(_exactMatch), handler(_handler), classifier(_classifier)
     {
     }
     std::string prefix;
     bool exactMatch;
     HTTPRequestHandler handler;
+    HTTPRequestClassifier classifier;
+};
+
+/** Work queue properties of every HTTPRequestClass, in the order of the enum */
+static const struct {
+    const char* name;
+    const char* threadsArg;
+    int defaultThreads;
+} httpRequestClasses[] = {
+    {"default", "-rpcthreads", DEFAULT_HTTP_THREADS},
+    {"fast", "-rpcfastthreads", DEFAULT_HTTP_FAST_THREADS},
+    {"heavy", "-rpcheavythreads", DEFAULT_HTTP_HEAVY_THREADS},
+    {"wallet", "-rpcwalletthreads", DEFAULT_HTTP_WALLET_THREADS},
 };
 
 /** HTTP module state */
@@ -147,8 +181,10 @@ static struct event_base* eventBase = nullptr;
 struct evhttp* eventHTTP = nullptr;
 //! List of subnets to allow RPC connections from
 static std::vector<CSubNet> rpc_allow_subnets;
-//! Work queue for handling longer requests off the event loop thread
-static WorkQueue<HTTPClosure>* workQueue = nullptr;
+//! Work queues for handling longer requests off the event loop thread, one per HTTPRequestClass
+static std::vector<std::unique_ptr<WorkQueue<HTTPClosure>>> workQueues;
+//! Number of worker threads of each work queue
+static std::vector<int> workQueueThreads;
 //! Handlers for (sub)paths
 std::vector<HTTPPathHandler> pathHandlers;
 //! Bound listening sockets
@@ -263,12 +299,14 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
 
     // Dispatch to worker thread
     if (i != iend) {
+        const HTTPRequestClass reqClass = i->classifier ? i->classifier(hreq.get(), path) : HTTPRequestClass::DEFAULT;
         std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler));
-        assert(workQueue);
-        if (workQueue->Enqueue(item.get()))
+        assert(!workQueues.empty());
+        if (workQueues[static_cast<size_t>(reqClass)]->Enqueue(item.get()))
             item.release(); /* if true, queue took ownership */
         else {
-            LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
+            LogPrintf("WARNING: request rejected because the %s http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n",
+                      httpRequestClasses[static_cast<size_t>(reqClass)].name);
             item->req->WriteReply(HTTP_INTERNAL, "Work queue depth exceeded");
         }
     } else {
@@ -406,9 +444,12 @@ bool InitHTTPServer()
 
     LogPrint(BCLog::HTTP, "Initialized HTTP server\n");
     int workQueueDepth = std::max((long)gArgs.GetArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
-    LogPrintf("HTTP: creating work queue of depth %d\n", workQueueDepth);
+    LogPrintf("HTTP: creating work queues of depth %d\n", workQueueDepth);
 
-    workQueue = new WorkQueue<HTTPClosure>(workQueueDepth);
+    for (const auto& reqClass : httpRequestClasses) {
+        workQueues.emplace_back(new WorkQueue<HTTPClosure>(workQueueDepth));
+        workQueueThreads.push_back(std::max((long)gArgs.GetArg(reqClass.threadsArg, reqClass.defaultThreads), 1L));
+    }
     // transfer ownership to eventBase/HTTP via .release()
     eventBase = base_ctr.release();
     eventHTTP = http_ctr.release();
@@ -435,12 +476,13 @@ static std::vector<std::thread> g_thread_http_workers;
 bool StartHTTPServer()
 {
     LogPrint(BCLog::HTTP, "Starting HTTP server\n");
-    int rpcThreads = std::max((long)gArgs.GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
-    LogPrintf("HTTP: starting %d worker threads\n", rpcThreads);
     threadHTTP = std::thread(ThreadHTTP, eventBase, eventHTTP);
 
-    for (int i = 0; i < rpcThreads; i++) {
-        g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueue);
+    for (size_t nClass = 0; nClass < workQueues.size(); nClass++) {
+        LogPrintf("HTTP: starting %d %s worker threads\n", workQueueThreads[nClass], httpRequestClasses[nClass].name);
+        for (int i = 0; i < workQueueThreads[nClass]; i++) {
+            g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueues[nClass].get());
+        }
     }
     return true;
 }
@@ -452,21 +494,22 @@ void InterruptHTTPServer()
         // Reject requests on current connections
         evhttp_set_gencb(eventHTTP, http_reject_request_cb, nullptr);
     }
-    if (workQueue)
-        workQueue->Interrupt();
+    for (auto& queue : workQueues) {
+        queue->Interrupt();
+    }
 }
 
 void StopHTTPServer()
 {
     LogPrint(BCLog::HTTP, "Stopping HTTP server\n");
-    if (workQueue) {
+    if (!workQueues.empty()) {
         LogPrint(BCLog::HTTP, "Waiting for HTTP worker threads to exit\n");
         for (auto& thread: g_thread_http_workers) {
             thread.join();
         }
         g_thread_http_workers.clear();
-        delete workQueue;
-        workQueue = nullptr;
+        workQueues.clear();
+        workQueueThreads.clear();
     }
     // Unlisten sockets, these are what make the event loop running, which means
     // that after this and all connections are closed the event loop will quit.
@@ -521,7 +564,8 @@ void HTTPEvent::trigger(struct timeval* tv)
         evtimer_add(ev, tv); // trigger after timeval passed
 }
 HTTPRequest::HTTPRequest(struct evhttp_request* _req) : req(_req),
-                                                       replySent(false)
+                                                       replySent(false),
+                                                       replyStarted(false)
 {
 }
 HTTPRequest::~HTTPRequest()
@@ -565,6 +609,20 @@ std::string HTTPRequest::ReadBody()
     return rv;
 }
 
+std::string HTTPRequest::PeekBody(size_t nMaxSize) const
+{
+    struct evbuffer* buf = evhttp_request_get_input_buffer(req);
+    if (!buf)
+        return "";
+    size_t size = evbuffer_get_length(buf);
+    if (size > nMaxSize)
+        return "";
+    std::string rv(size, '\0');
+    if (evbuffer_copyout(buf, &rv[0], size) != (ev_ssize_t)size)
+        return "";
+    return rv;
+}
+
 void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
 {
     struct evkeyvalq* headers = evhttp_request_get_output_headers(req);
@@ -577,21 +635,58 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
  * Replies must be sent in the main loop in the main http thread,
  * this cannot be done from worker threads.
  */
+void HTTPRequest::WriteReplyChunk(int nStatus, const std::string& strChunk)
+{
+    assert(!replySent && req);
+    auto req_copy = req;
+    if (!replyStarted) {
+        if (ShutdownRequested()) {
+            WriteHeader("Connection", "close");
+        }
+        HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
+            evhttp_send_reply_start(req_copy, nStatus, nullptr);
+        });
+        ev->trigger(nullptr);
+        replyStarted = true;
+    }
+    if (strChunk.empty()) {
+        return;
+    }
+    // Events are handled in the order they were triggered, so chunks are sent in order.
+    // libevent keeps the request alive until the reply is ended, even if the client went away.
+    struct evbuffer* evb = evbuffer_new();
+    assert(evb);
+    evbuffer_add(evb, strChunk.data(), strChunk.size());
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, evb]{
+        evhttp_send_reply_chunk(req_copy, evb);
+        evbuffer_free(evb);
+    });
+    ev->trigger(nullptr);
+}
+
 void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
 {
     assert(!replySent && req);
-    if (ShutdownRequested()) {
-        WriteHeader("Connection", "close");
+    if (replyStarted) {
+        WriteReplyChunk(nStatus, strReply);
+    } else {
+        if (ShutdownRequested()) {
+            WriteHeader("Connection", "close");
+        }
+        struct evbuffer* evb = evhttp_request_get_output_buffer(req);
+        assert(evb);
+        evbuffer_add(evb, strReply.data(), strReply.size());
     }
     // Send event to main http thread to send reply message
-    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
-    assert(evb);
-    evbuffer_add(evb, strReply.data(), strReply.size());
     auto req_copy = req;
-    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
-        evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
+    bool fChunked = replyStarted;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus, fChunked]{
+        if (!fChunked) {
+            evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
+        }
         // Re-enable reading from the socket. This is the second part of the libevent
-        // workaround above.
+        // workaround above. A chunked reply is ended afterwards as this can free the
+        // request right away.
         if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
             evhttp_connection* conn = evhttp_request_get_connection(req_copy);
             if (conn) {
@@ -601,6 +696,9 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
                 }
             }
         }
+        if (fChunked) {
+            evhttp_send_reply_end(req_copy);
+        }
     });
     ev->trigger(nullptr);
     replySent = true;
@@ -647,10 +745,23 @@ HTTPRequest::RequestMethod HTTPRequest::GetRequestMethod()
     }
 }
 
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPRequestClassifier &classifier)
 {
     LogPrint(BCLog::HTTP, "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
-    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler));
+    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler, classifier));
+}
+
+std::vector<HTTPWorkQueueStats> GetHTTPWorkQueueStats()
+{
+    std::vector<HTTPWorkQueueStats> vStats;
+    for (size_t nClass = 0; nClass < workQueues.size(); nClass++) {
+        HTTPWorkQueueStats stats;
+        stats.name = httpRequestClasses[nClass].name;
+        stats.nThreads = workQueueThreads[nClass];
+        workQueues[nClass]->GetStats(stats);
+        vStats.push_back(stats);
+    }
+    return vStats;
 }
 
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
@@ -8,8 +8,12 @@
 #include <string>
 #include <stdint.h>
 #include <functional>
+#include <vector>
 
 static const int DEFAULT_HTTP_THREADS=4;
+static const int DEFAULT_HTTP_FAST_THREADS=2;
+static const int DEFAULT_HTTP_HEAVY_THREADS=2;
+static const int DEFAULT_HTTP_WALLET_THREADS=2;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT=30;
 
@@ -36,13 +40,45 @@ void StopHTTPServer();
  * libevent doesn't support debug logging.*/
 bool UpdateHTTPServerLogging(bool enable);
 
+/** Classes of HTTP requests, every class has its own work queue and worker threads
+ * so that requests of one class can't starve the others.
+ */
+enum class HTTPRequestClass {
+    DEFAULT,    //!< Everything which isn't classified otherwise (-rpcthreads)
+    FAST,       //!< Cheap requests which must not wait behind slow ones (-rpcfastthreads)
+    HEAVY,      //!< Slow requests which must not take up the default workers (-rpcheavythreads)
+    WALLET,     //!< Wallet requests (-rpcwalletthreads)
+};
+
+/** Statistics of the work queue of a HTTPRequestClass */
+struct HTTPWorkQueueStats
+{
+    std::string name;
+    int nThreads{0};
+    size_t nMaxDepth{0};
+    size_t nDepth{0};
+    uint64_t nProcessed{0};
+    uint64_t nRejected{0};
+    //! Time the processed requests waited in the queue
+    int64_t nTotalWaitMicros{0};
+    int64_t nMaxWaitMicros{0};
+};
+
+/** Return the statistics of all work queues */
+std::vector<HTTPWorkQueueStats> GetHTTPWorkQueueStats();
+
 /** Handler for requests to a certain HTTP path */
 typedef std::function<bool(HTTPRequest* req, const std::string &)> HTTPRequestHandler;
+/** Selects the work queue a request to a certain HTTP path is handled by.
+ * It runs on the event loop thread, so it must be cheap.
+ */
+typedef std::function<HTTPRequestClass(HTTPRequest* req, const std::string &)> HTTPRequestClassifier;
 /** Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
- * be invoked.
+ * be invoked. Requests are handled by the default work queue unless a
+ * classifier is given.
  */
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler);
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPRequestClassifier &classifier = nullptr);
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
@@ -59,6 +95,8 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    //! Whether a chunked reply was started by WriteReplyChunk
+    bool replyStarted;
 
 public:
     explicit HTTPRequest(struct evhttp_request* req);
@@ -98,6 +136,12 @@ public:
      */
     std::string ReadBody();
 
+    /**
+     * Get the request body without consuming it.
+     * Returns an empty string if the body is larger than nMaxSize.
+     */
+    std::string PeekBody(size_t nMaxSize) const;
+
     /**
      * Write output header.
      *
@@ -112,8 +156,18 @@ public:
      *
      * @note Can be called only once. As this will give the request back to the
      * main thread, do not call any other HTTPRequest methods after calling this.
+     * If a chunked reply was started by WriteReplyChunk, strReply is sent as its last
+     * chunk and nStatus is ignored.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Write a chunk of a HTTP reply, starting a chunked reply with status code
+     * nStatus on the first call. Finish the reply by calling WriteReply.
+     *
+     * @note Call WriteHeader before the first chunk, headers can't be added later.
+     */
+    void WriteReplyChunk(int nStatus, const std::string& strChunk);
 };
 
 /** Event handler closure.
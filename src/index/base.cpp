@@ -0,0 +1,250 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/base.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <init.h>
+#include <tinyformat.h>
+#include <ui_interface.h>
+#include <undo.h>
+#include <util.h>
+#include <validation.h>
+#include <warnings.h>
+
+#include <functional>
+
+static const char DB_BEST_BLOCK = 'B';
+
+//! How often the progress of the sync thread is logged, in seconds
+static const int64_t SYNC_LOG_INTERVAL = 30;
+
+template<typename... Args>
+static void FatalError(const char* fmt, const Args&... args)
+{
+    std::string strMessage = tfm::format(fmt, args...);
+    SetMiscWarning(strMessage);
+    LogPrintf("*** %s\n", strMessage);
+    uiInterface.ThreadSafeMessageBox(
+        "Error: A fatal internal error occurred, see debug.log for details",
+        "", CClientUIInterface::MSG_ERROR);
+    StartShutdown();
+}
+
+BaseIndex::DB::DB(const fs::path& path, size_t n_cache_size, bool f_memory, bool f_wipe) :
+    CDBWrapper(path, GetDefaultDBOptions(DBRole::INDEX, n_cache_size), f_memory, f_wipe)
+{
+}
+
+bool BaseIndex::DB::ReadBestBlock(uint256& hashRet) const
+{
+    return Read(DB_BEST_BLOCK, hashRet);
+}
+
+void BaseIndex::DB::WriteBestBlock(CDBBatch& batch, const uint256& hash)
+{
+    batch.Write(DB_BEST_BLOCK, hash);
+}
+
+bool BaseIndex::Connect(const CBlockIndex* pindex, std::shared_ptr<const CBlock> pblock)
+{
+    if (!pblock) {
+        auto pblockRead = std::make_shared<CBlock>();
+        if (!ReadBlockFromDisk(*pblockRead, pindex, Params().GetConsensus())) {
+            return error("%s: %s failed to read block %s from disk", __func__, GetName(), pindex->GetBlockHash().ToString());
+        }
+        pblock = std::move(pblockRead);
+    }
+
+    CDBBatch batch(GetDB());
+    // like ConnectBlock, the transactions of the genesis block are skipped, unless the index handles them itself
+    if (pindex->pprev) {
+        CBlockUndo blockundo;
+        if (!UndoReadFromDisk(blockundo, pindex)) {
+            return error("%s: %s failed to read undo data of block %s", __func__, GetName(), pindex->GetBlockHash().ToString());
+        }
+        if (!WriteBlock(batch, *pblock, blockundo, pindex)) {
+            return error("%s: %s failed to index block %s", __func__, GetName(), pindex->GetBlockHash().ToString());
+        }
+    } else if (!WriteGenesisBlock(batch, *pblock, pindex)) {
+        return error("%s: %s failed to index the genesis block", __func__, GetName());
+    }
+    GetDB().WriteBestBlock(batch, pindex->GetBlockHash());
+    if (!GetDB().WriteBatch(batch)) {
+        return error("%s: %s failed to write block %s", __func__, GetName(), pindex->GetBlockHash().ToString());
+    }
+    m_best_block_index = pindex;
+    return true;
+}
+
+bool BaseIndex::Disconnect(std::shared_ptr<const CBlock> pblock)
+{
+    const CBlockIndex* pindex = m_best_block_index;
+    assert(pindex && pindex->pprev);
+
+    if (!pblock) {
+        auto pblockRead = std::make_shared<CBlock>();
+        if (!ReadBlockFromDisk(*pblockRead, pindex, Params().GetConsensus())) {
+            return error("%s: %s failed to read block %s from disk", __func__, GetName(), pindex->GetBlockHash().ToString());
+        }
+        pblock = std::move(pblockRead);
+    }
+    CBlockUndo blockundo;
+    if (!UndoReadFromDisk(blockundo, pindex)) {
+        return error("%s: %s failed to read undo data of block %s", __func__, GetName(), pindex->GetBlockHash().ToString());
+    }
+
+    CDBBatch batch(GetDB());
+    if (!RewindBlock(batch, *pblock, blockundo, pindex)) {
+        return error("%s: %s failed to rewind block %s", __func__, GetName(), pindex->GetBlockHash().ToString());
+    }
+    GetDB().WriteBestBlock(batch, pindex->pprev->GetBlockHash());
+    if (!GetDB().WriteBatch(batch)) {
+        return error("%s: %s failed to rewind block %s", __func__, GetName(), pindex->GetBlockHash().ToString());
+    }
+    m_best_block_index = pindex->pprev;
+    return true;
+}
+
+void BaseIndex::ThreadSync()
+{
+    int64_t nLastLogTime = 0;
+    while (!m_interrupt) {
+        const CBlockIndex* pindex = m_best_block_index;
+        const CBlockIndex* pindexNext{nullptr};
+        {
+            LOCK(cs_main);
+            if (!pindex || chainActive.Contains(pindex)) {
+                pindexNext = pindex ? chainActive.Next(pindex) : chainActive.Genesis();
+                if (!pindexNext) {
+                    // all blocks which are connected from now on are announced through BlockConnected
+                    m_synced = true;
+                    break;
+                }
+            }
+        }
+
+        if (!pindexNext) {
+            // the best block was disconnected while the index wasn't running or wasn't synced yet
+            if (!Disconnect()) {
+                FatalError("%s: %s failed to rewind block %s", __func__, GetName(), pindex->GetBlockHash().ToString());
+                return;
+            }
+        } else if (!Connect(pindexNext)) {
+            FatalError("%s: %s failed to connect block %s", __func__, GetName(), pindexNext->GetBlockHash().ToString());
+            return;
+        }
+
+        int64_t nNow = GetTime();
+        if (nNow - nLastLogTime >= SYNC_LOG_INTERVAL) {
+            LogPrintf("Syncing %s with block chain from height %d\n", GetName(), m_best_block_index.load()->nHeight);
+            nLastLogTime = nNow;
+        }
+    }
+
+    if (m_synced) {
+        const CBlockIndex* pindex = m_best_block_index;
+        LogPrintf("%s is enabled at height %d\n", GetName(), pindex ? pindex->nHeight : -1);
+    }
+}
+
+void BaseIndex::BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex, const std::vector<CTransactionRef>& txnConflicted)
+{
+    if (!m_synced) {
+        return;
+    }
+
+    const CBlockIndex* pindexBest = m_best_block_index;
+    if (pindexBest && pindexBest->GetAncestor(pindex->nHeight) == pindex) {
+        // connected by the sync thread already
+        return;
+    }
+
+    // Normally pindex is a child of the best block. If it isn't, rewind to the fork point and connect the blocks
+    // in between from disk.
+    while (pindexBest && pindex->GetAncestor(pindexBest->nHeight) != pindexBest) {
+        LogPrintf("%s: %s rewinds block %s, which isn't an ancestor of %s\n", __func__, GetName(), pindexBest->GetBlockHash().ToString(), pindex->GetBlockHash().ToString());
+        if (!Disconnect()) {
+            FatalError("%s: %s failed to rewind block %s", __func__, GetName(), pindexBest->GetBlockHash().ToString());
+            return;
+        }
+        pindexBest = m_best_block_index;
+    }
+    std::vector<const CBlockIndex*> vConnect;
+    for (const CBlockIndex* p = pindex->pprev; p != pindexBest; p = p->pprev) {
+        vConnect.emplace_back(p);
+    }
+    for (auto it = vConnect.rbegin(); it != vConnect.rend(); ++it) {
+        if (!Connect(*it)) {
+            FatalError("%s: %s failed to connect block %s", __func__, GetName(), (*it)->GetBlockHash().ToString());
+            return;
+        }
+    }
+
+    if (!Connect(pindex, block)) {
+        FatalError("%s: %s failed to connect block %s", __func__, GetName(), pindex->GetBlockHash().ToString());
+    }
+}
+
+void BaseIndex::BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    if (!m_synced || pindex != m_best_block_index) {
+        // not in the index, e.g. because it was connected and disconnected again before the sync thread finished
+        return;
+    }
+
+    if (!Disconnect(block)) {
+        FatalError("%s: %s failed to rewind block %s", __func__, GetName(), pindex->GetBlockHash().ToString());
+    }
+}
+
+bool BaseIndex::BlockUntilSyncedToCurrentChain()
+{
+    AssertLockNotHeld(cs_main);
+
+    if (!m_synced) {
+        return false;
+    }
+
+    {
+        LOCK(cs_main);
+        if (chainActive.Tip() == m_best_block_index) {
+            return true;
+        }
+    }
+
+    LogPrint(BCLog::BENCHMARK, "%s: %s is catching up on block notifications\n", __func__, GetName());
+    SyncWithValidationInterfaceQueue();
+    return true;
+}
+
+bool BaseIndex::Start()
+{
+    uint256 hashBest;
+    if (GetDB().ReadBestBlock(hashBest)) {
+        LOCK(cs_main);
+        const CBlockIndex* pindex = LookupBlockIndex(hashBest);
+        if (!pindex) {
+            return error("%s: best block %s of %s is unknown", __func__, hashBest.ToString(), GetName());
+        }
+        m_best_block_index = pindex;
+    }
+
+    // registered before the sync thread starts, so that no block is missed once it's synced
+    RegisterValidationInterface(this);
+
+    m_thread_sync = std::thread(&TraceThread<std::function<void()>>, GetName(), std::bind(&BaseIndex::ThreadSync, this));
+    return true;
+}
+
+void BaseIndex::Stop()
+{
+    UnregisterValidationInterface(this);
+
+    m_interrupt();
+    if (m_thread_sync.joinable()) {
+        m_thread_sync.join();
+    }
+}
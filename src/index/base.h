@@ -0,0 +1,103 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_BASE_H
+#define BITCOIN_INDEX_BASE_H
+
+#include <dbwrapper.h>
+#include <primitives/block.h>
+#include <threadinterrupt.h>
+#include <uint256.h>
+#include <validationinterface.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+class CBlockIndex;
+class CBlockUndo;
+
+/**
+ * Base class for indexes which are built from the blocks and undo data on disk instead of inline in ConnectBlock, so
+ * that connecting blocks doesn't wait for them. Each index has its own database, which also stores the block the index
+ * is in sync with. A sync thread catches up with the active chain from there, which makes it possible to enable an
+ * index at any time without a -reindex. Once it reached the tip, the index follows the chain through the
+ * BlockConnected and BlockDisconnected notifications.
+ */
+class BaseIndex : public CValidationInterface
+{
+protected:
+    class DB : public CDBWrapper
+    {
+    public:
+        DB(const fs::path& path, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+        /** Reads the hash of the block the index is in sync with */
+        bool ReadBestBlock(uint256& hashRet) const;
+        /** Writes the hash of the block the index is in sync with to batch */
+        void WriteBestBlock(CDBBatch& batch, const uint256& hash);
+    };
+
+private:
+    /// Whether the index caught up with the active chain, only then notifications are processed
+    std::atomic<bool> m_synced{false};
+
+    /// The last block the index is in sync with, only changed by the sync thread or the notification callbacks
+    std::atomic<const CBlockIndex*> m_best_block_index{nullptr};
+
+    std::thread m_thread_sync;
+    CThreadInterrupt m_interrupt;
+
+    /// Catches up with the active chain, rewinding blocks which were disconnected while the index wasn't synced
+    void ThreadSync();
+
+    /// Adds pindex, which must be a child of m_best_block_index, to the index. pblock is read from disk if not given.
+    bool Connect(const CBlockIndex* pindex, std::shared_ptr<const CBlock> pblock = nullptr);
+
+    /// Removes m_best_block_index from the index. pblock is read from disk if not given.
+    bool Disconnect(std::shared_ptr<const CBlock> pblock = nullptr);
+
+protected:
+    void BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex, const std::vector<CTransactionRef>& txnConflicted) override;
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override;
+
+    /// Writes the index entries of a block which is connected, blockundo holds the coins spent by it
+    virtual bool WriteBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex) = 0;
+
+    /// Like WriteBlock for the genesis block, whose transactions are not part of the UTXO set. Skipped by default.
+    virtual bool WriteGenesisBlock(CDBBatch& batch, const CBlock& block, const CBlockIndex* pindex) { return true; }
+
+    /// Writes the changes to undo WriteBlock for a block which is disconnected
+    virtual bool RewindBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex) = 0;
+
+    virtual DB& GetDB() const = 0;
+
+    /// Name of the index, used in log messages and as name of the sync thread
+    virtual const char* GetName() const = 0;
+
+public:
+    BaseIndex() = default;
+    BaseIndex(const BaseIndex&) = delete;
+    BaseIndex& operator=(const BaseIndex&) = delete;
+    /// Derived classes must call Stop() in their destructor, as the sync thread uses their database
+    virtual ~BaseIndex() = default;
+
+    /// Whether the index caught up with the active chain
+    bool IsSynced() const { return m_synced; }
+
+    /**
+     * Waits until the index processed the notifications for the current tip. Returns false without waiting if the
+     * index is still catching up with the chain. Must not be called with cs_main held.
+     */
+    bool BlockUntilSyncedToCurrentChain();
+
+    /// Registers for notifications and starts the sync thread. Returns false if the index database is unusable.
+    bool Start();
+
+    /// Stops the sync thread and unregisters from notifications
+    void Stop();
+};
+
+#endif // BITCOIN_INDEX_BASE_H
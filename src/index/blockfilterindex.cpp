@@ -0,0 +1,409 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/blockfilterindex.h>
+
+#include <clientversion.h>
+#include <streams.h>
+#include <undo.h>
+#include <util.h>
+
+#include <map>
+
+/* The index database stores three items for each block: the disk location of the encoded filter,
+ * its dSHA256 hash, and the header. Those belonging to blocks on the active chain are indexed by
+ * height, and those belonging to blocks that have been reorganized out of the active chain are
+ * indexed by block hash. This ensures that filter data for any block that becomes part of the
+ * active chain can always be retrieved, alleviating timing concerns.
+ *
+ * The filters themselves are stored in flat files and referenced by the LevelDB entries. This
+ * minimizes the amount of data written to LevelDB and keeps the database values constant size.
+ */
+static const char DB_BLOCK_HASH = 's';
+static const char DB_BLOCK_HEIGHT = 't';
+static const char DB_FILTER_POS = 'P';
+
+//! Maximum size of a filter file, filters which don't fit are written to the next one
+static const unsigned int MAX_FLTR_FILE_SIZE = 0x1000000; // 16 MiB
+
+namespace {
+
+struct DBVal {
+    uint256 hash;
+    uint256 header;
+    CDiskBlockPos pos;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(hash);
+        READWRITE(header);
+        READWRITE(pos);
+    }
+};
+
+struct DBHeightKey {
+    int height;
+
+    DBHeightKey() : height(0) {}
+    explicit DBHeightKey(int height_in) : height(height_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_BLOCK_HEIGHT);
+        ser_writedata32be(s, height);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        char prefix = ser_readdata8(s);
+        if (prefix != DB_BLOCK_HEIGHT) {
+            throw std::ios_base::failure("Invalid format for block filter index DB height key");
+        }
+        height = ser_readdata32be(s);
+    }
+};
+
+struct DBHashKey {
+    uint256 hash;
+
+    explicit DBHashKey(const uint256& hash_in) : hash(hash_in) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        char prefix = DB_BLOCK_HASH;
+        READWRITE(prefix);
+        if (prefix != DB_BLOCK_HASH) {
+            throw std::ios_base::failure("Invalid format for block filter index DB hash key");
+        }
+
+        READWRITE(hash);
+    }
+};
+
+}; // namespace
+
+class BlockFilterIndex::DB : public BaseIndex::DB
+{
+public:
+    DB(const fs::path& path, size_t n_cache_size, bool f_memory, bool f_wipe) :
+        BaseIndex::DB(path, n_cache_size, f_memory, f_wipe)
+    {
+    }
+
+    bool LookupOne(const CBlockIndex* block_index, DBVal& result) const
+    {
+        // First check if the result is stored under the height index and the value there matches the
+        // block hash. This should be the case if the block is on the active chain.
+        std::pair<uint256, DBVal> read_out;
+        if (!Read(DBHeightKey(block_index->nHeight), read_out)) {
+            return false;
+        }
+        if (read_out.first == block_index->GetBlockHash()) {
+            result = std::move(read_out.second);
+            return true;
+        }
+
+        // If value at the height index corresponds to an different block, the result will be stored in
+        // the hash index.
+        return Read(DBHashKey(block_index->GetBlockHash()), result);
+    }
+
+    bool LookupRange(int start_height, const CBlockIndex* stop_index, std::vector<DBVal>& results) const
+    {
+        if (start_height < 0) {
+            return error("%s: start height (%d) is negative", __func__, start_height);
+        }
+        if (start_height > stop_index->nHeight) {
+            return error("%s: start height (%d) is greater than stop height (%d)",
+                         __func__, start_height, stop_index->nHeight);
+        }
+
+        size_t results_size = static_cast<size_t>(stop_index->nHeight - start_height + 1);
+        std::vector<std::pair<uint256, DBVal>> values(results_size);
+
+        DBHeightKey key(start_height);
+        std::unique_ptr<CDBIterator> db_it(const_cast<DB*>(this)->NewIterator());
+        db_it->Seek(DBHeightKey(start_height));
+        for (int height = start_height; height <= stop_index->nHeight; ++height) {
+            if (!db_it->Valid() || !db_it->GetKey(key) || key.height != height) {
+                return false;
+            }
+
+            size_t i = static_cast<size_t>(height - start_height);
+            if (!db_it->GetValue(values[i])) {
+                return error("%s: unable to read value in block filter index at height %d", __func__, height);
+            }
+
+            db_it->Next();
+        }
+
+        results.resize(results_size);
+
+        // Iterate backwards through block indexes collecting results in order to access the block hash
+        // of each entry in case we need to look it up in the hash index.
+        for (const CBlockIndex* block_index = stop_index;
+             block_index && block_index->nHeight >= start_height;
+             block_index = block_index->pprev) {
+            uint256 block_hash = block_index->GetBlockHash();
+
+            size_t i = static_cast<size_t>(block_index->nHeight - start_height);
+            if (block_hash == values[i].first) {
+                results[i] = std::move(values[i].second);
+                continue;
+            }
+
+            if (!Read(DBHashKey(block_hash), results[i])) {
+                return error("%s: unable to read filter of block %s from the block filter index", __func__, block_hash.ToString());
+            }
+        }
+
+        return true;
+    }
+};
+
+static std::map<BlockFilterType, BlockFilterIndex> g_filter_indexes;
+
+BlockFilterIndex::BlockFilterIndex(BlockFilterType filter_type, size_t n_cache_size, bool f_memory, bool f_wipe) :
+    m_filter_type(filter_type),
+    m_name(BlockFilterTypeName(filter_type) + " block filter index"),
+    m_dir(GetDataDir() / "indexes" / "blockfilter" / BlockFilterTypeName(filter_type)),
+    m_db(MakeUnique<DB>(m_dir / "db", n_cache_size, f_memory, f_wipe))
+{
+    if (BlockFilterTypeName(filter_type).empty()) {
+        throw std::invalid_argument("unknown filter_type");
+    }
+    if (!m_db->Read(DB_FILTER_POS, m_next_filter_pos)) {
+        m_next_filter_pos = CDiskBlockPos(0, 0);
+    }
+}
+
+BlockFilterIndex::~BlockFilterIndex()
+{
+    Stop();
+}
+
+BaseIndex::DB& BlockFilterIndex::GetDB() const
+{
+    return *m_db;
+}
+
+FILE* BlockFilterIndex::OpenFilterFile(const CDiskBlockPos& pos, bool fReadOnly) const
+{
+    if (pos.IsNull()) {
+        return nullptr;
+    }
+    fs::path path = m_dir / strprintf("fltr%05u.dat", pos.nFile);
+    fs::create_directories(path.parent_path());
+    FILE* file = fsbridge::fopen(path, fReadOnly ? "rb" : "rb+");
+    if (!file && !fReadOnly) {
+        file = fsbridge::fopen(path, "wb+");
+    }
+    if (!file) {
+        LogPrintf("Unable to open file %s\n", path.string());
+        return nullptr;
+    }
+    if (pos.nPos && fseek(file, pos.nPos, SEEK_SET)) {
+        LogPrintf("Unable to seek to position %u of %s\n", pos.nPos, path.string());
+        fclose(file);
+        return nullptr;
+    }
+    return file;
+}
+
+bool BlockFilterIndex::ReadFilterFromDisk(const CDiskBlockPos& pos, BlockFilter& filter) const
+{
+    CAutoFile filein(OpenFilterFile(pos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull()) {
+        return false;
+    }
+
+    uint256 block_hash;
+    std::vector<unsigned char> encoded_filter;
+    try {
+        filein >> block_hash >> encoded_filter;
+        filter = BlockFilter(GetFilterType(), block_hash, std::move(encoded_filter));
+    } catch (const std::exception& e) {
+        return error("%s: Failed to deserialize block filter from disk: %s", __func__, e.what());
+    }
+
+    return true;
+}
+
+size_t BlockFilterIndex::WriteFilterToDisk(CDiskBlockPos& pos, const BlockFilter& filter)
+{
+    assert(filter.GetFilterType() == GetFilterType());
+
+    size_t data_size =
+        GetSerializeSize(filter.GetBlockHash(), SER_DISK, CLIENT_VERSION) +
+        GetSerializeSize(filter.GetEncodedFilter(), SER_DISK, CLIENT_VERSION);
+
+    // If writing the filter would overflow the file, flush and move to the next one.
+    if (pos.nPos + data_size > MAX_FLTR_FILE_SIZE) {
+        FILE* last_file = OpenFilterFile(pos, false);
+        if (!last_file) {
+            LogPrintf("%s: Failed to open filter file %d\n", __func__, pos.nFile);
+            return 0;
+        }
+        if (!FileCommit(last_file)) {
+            fclose(last_file);
+            LogPrintf("%s: Failed to commit filter file %d\n", __func__, pos.nFile);
+            return 0;
+        }
+        fclose(last_file);
+
+        pos.nFile++;
+        pos.nPos = 0;
+    }
+
+    CAutoFile fileout(OpenFilterFile(pos, false), SER_DISK, CLIENT_VERSION);
+    if (fileout.IsNull()) {
+        LogPrintf("%s: Failed to open filter file %d\n", __func__, pos.nFile);
+        return 0;
+    }
+
+    fileout << filter.GetBlockHash() << filter.GetEncodedFilter();
+    return data_size;
+}
+
+bool BlockFilterIndex::WriteFilter(CDBBatch& batch, const BlockFilter& filter, const CBlockIndex* pindex, const uint256& prev_header)
+{
+    size_t bytes_written;
+    try {
+        bytes_written = WriteFilterToDisk(m_next_filter_pos, filter);
+    } catch (const std::exception& e) {
+        return error("%s: Failed to write block filter to disk: %s", __func__, e.what());
+    }
+    if (bytes_written == 0) {
+        return false;
+    }
+
+    DBVal value;
+    value.hash = filter.GetHash();
+    value.header = filter.ComputeHeader(prev_header);
+    value.pos = m_next_filter_pos;
+    batch.Write(DBHeightKey(pindex->nHeight), std::make_pair(pindex->GetBlockHash(), value));
+
+    // Written before the entries refer to the filter, a crash in between only leaves unused bytes
+    m_next_filter_pos.nPos += bytes_written;
+    batch.Write(DB_FILTER_POS, m_next_filter_pos);
+    return true;
+}
+
+bool BlockFilterIndex::WriteGenesisBlock(CDBBatch& batch, const CBlock& block, const CBlockIndex* pindex)
+{
+    return WriteFilter(batch, BlockFilter(GetFilterType(), block, CBlockUndo()), pindex, uint256());
+}
+
+bool BlockFilterIndex::WriteBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex)
+{
+    DBVal prev;
+    if (!m_db->LookupOne(pindex->pprev, prev)) {
+        return error("%s: unable to read filter header of block %s", __func__, pindex->pprev->GetBlockHash().ToString());
+    }
+    return WriteFilter(batch, BlockFilter(GetFilterType(), block, blockundo), pindex, prev.header);
+}
+
+bool BlockFilterIndex::RewindBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex)
+{
+    // The height entry is overwritten by the block which is connected at this height next, so the entry is kept
+    // by block hash, in case the block is connected again or requested by a peer on the fork.
+    std::pair<uint256, DBVal> value;
+    if (!m_db->Read(DBHeightKey(pindex->nHeight), value) || value.first != pindex->GetBlockHash()) {
+        return error("%s: unable to read filter of block %s", __func__, pindex->GetBlockHash().ToString());
+    }
+    batch.Write(DBHashKey(value.first), value.second);
+    return true;
+}
+
+bool BlockFilterIndex::LookupFilter(const CBlockIndex* block_index, BlockFilter& filter_out) const
+{
+    DBVal entry;
+    if (!m_db->LookupOne(block_index, entry)) {
+        return false;
+    }
+
+    return ReadFilterFromDisk(entry.pos, filter_out) && filter_out.GetBlockHash() == block_index->GetBlockHash();
+}
+
+bool BlockFilterIndex::LookupFilterHeader(const CBlockIndex* block_index, uint256& header_out) const
+{
+    DBVal entry;
+    if (!m_db->LookupOne(block_index, entry)) {
+        return false;
+    }
+
+    header_out = entry.header;
+    return true;
+}
+
+bool BlockFilterIndex::LookupFilterRange(int start_height, const CBlockIndex* stop_index,
+                                         std::vector<BlockFilter>& filters_out) const
+{
+    std::vector<DBVal> entries;
+    if (!m_db->LookupRange(start_height, stop_index, entries)) {
+        return false;
+    }
+
+    filters_out.resize(entries.size());
+    auto filter_pos_it = filters_out.begin();
+    for (const auto& entry : entries) {
+        if (!ReadFilterFromDisk(entry.pos, *filter_pos_it)) {
+            return false;
+        }
+        ++filter_pos_it;
+    }
+
+    return true;
+}
+
+bool BlockFilterIndex::LookupFilterHashRange(int start_height, const CBlockIndex* stop_index,
+                                             std::vector<uint256>& hashes_out) const
+{
+    std::vector<DBVal> entries;
+    if (!m_db->LookupRange(start_height, stop_index, entries)) {
+        return false;
+    }
+
+    hashes_out.clear();
+    hashes_out.reserve(entries.size());
+    for (const auto& entry : entries) {
+        hashes_out.push_back(entry.hash);
+    }
+    return true;
+}
+
+BlockFilterIndex* GetBlockFilterIndex(BlockFilterType filter_type)
+{
+    auto it = g_filter_indexes.find(filter_type);
+    return it != g_filter_indexes.end() ? &it->second : nullptr;
+}
+
+void ForEachBlockFilterIndex(std::function<void (BlockFilterIndex&)> fn)
+{
+    for (auto& entry : g_filter_indexes) fn(entry.second);
+}
+
+bool InitBlockFilterIndex(BlockFilterType filter_type,
+                          size_t n_cache_size, bool f_memory, bool f_wipe)
+{
+    auto result = g_filter_indexes.emplace(std::piecewise_construct,
+                                           std::forward_as_tuple(filter_type),
+                                           std::forward_as_tuple(filter_type,
+                                                                 n_cache_size, f_memory, f_wipe));
+    return result.second;
+}
+
+void DestroyAllBlockFilterIndexes()
+{
+    g_filter_indexes.clear();
+}
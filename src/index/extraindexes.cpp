@@ -0,0 +1,440 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/extraindexes.h>
+
+#include <chain.h>
+#include <hash.h>
+#include <undo.h>
+#include <util.h>
+
+#include <boost/thread.hpp>
+
+static const char DB_ADDRESSINDEX = 'a';
+static const char DB_ADDRESSUNSPENTINDEX = 'u';
+static const char DB_ADDRESSSUMMARY = 'b';
+static const char DB_TIMESTAMPINDEX = 's';
+static const char DB_SPENTINDEX = 'p';
+
+std::unique_ptr<AddressIndex> g_addressindex;
+std::unique_ptr<SpentIndex> g_spentindex;
+std::unique_ptr<TimestampIndex> g_timestampindex;
+
+/** Extracts the address type and hash of P2SH, P2PKH and P2PK scripts, returns false for all other scripts */
+static bool GetAddressKey(const CScript& script, int& typeRet, uint160& hashRet)
+{
+    if (script.IsPayToScriptHash()) {
+        hashRet = uint160(std::vector<unsigned char>(script.begin() + 2, script.begin() + 22));
+        typeRet = 2;
+    } else if (script.IsPayToPublicKeyHash()) {
+        hashRet = uint160(std::vector<unsigned char>(script.begin() + 3, script.begin() + 23));
+        typeRet = 1;
+    } else if (script.IsPayToPublicKey()) {
+        hashRet = Hash160(script.begin() + 1, script.end() - 1);
+        typeRet = 1;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/** Changes of the CAddressSummary of an address by one block */
+struct AddressSummaryDelta {
+    CAmount balance{0};
+    CAmount received{0};
+    uint32_t txCount{0};
+    //! position in the block of the last tx which touched the address
+    int64_t lastTx{-1};
+
+    void Add(size_t txIndex, CAmount nValue)
+    {
+        balance += nValue;
+        if (nValue > 0) {
+            received += nValue;
+        }
+        if (lastTx != (int64_t)txIndex) {
+            txCount++;
+            lastTx = txIndex;
+        }
+    }
+};
+
+typedef std::map<std::pair<int, uint160>, AddressSummaryDelta> AddressSummaryDeltaMap;
+
+class AddressIndex::DB : public BaseIndex::DB
+{
+public:
+    DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+        BaseIndex::DB(GetDataDir() / "indexes" / "address", n_cache_size, f_memory, f_wipe)
+    {
+    }
+
+    /** Returns the height of the last entry of the address below nHeight, or -1 if there is none */
+    int ReadLastHeightBefore(int type, const uint160& addressHash, int nHeight)
+    {
+        std::unique_ptr<CDBIterator> pcursor(NewIterator());
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, nHeight)));
+        if (pcursor->Valid()) {
+            pcursor->Prev();
+        } else {
+            pcursor->SeekToLast();
+        }
+        std::pair<char, CAddressIndexKey> key;
+        if (pcursor->Valid() && pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX &&
+                (int)key.second.type == type && key.second.hashBytes == addressHash) {
+            return key.second.blockHeight;
+        }
+        return -1;
+    }
+};
+
+AddressIndex::AddressIndex(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    m_db(MakeUnique<AddressIndex::DB>(n_cache_size, f_memory, f_wipe))
+{
+}
+
+AddressIndex::~AddressIndex()
+{
+    Stop();
+}
+
+BaseIndex::DB& AddressIndex::GetDB() const
+{
+    return *m_db;
+}
+
+bool AddressIndex::WriteBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex)
+{
+    int addressType;
+    uint160 hashBytes;
+    AddressSummaryDeltaMap mapDeltas;
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        const CTransaction& tx = *block.vtx[i];
+        const uint256 txhash = tx.GetHash();
+
+        if (!tx.IsCoinBase()) {
+            const CTxUndo& txundo = blockundo.vtxundo[i - 1];
+            for (size_t j = 0; j < tx.vin.size(); j++) {
+                const COutPoint& prevout = tx.vin[j].prevout;
+                const CTxOut& out = txundo.vprevout[j].out;
+                if (!GetAddressKey(out.scriptPubKey, addressType, hashBytes)) {
+                    continue;
+                }
+                // record spending activity
+                batch.Write(std::make_pair(DB_ADDRESSINDEX, CAddressIndexKey(addressType, hashBytes, pindex->nHeight, i, txhash, j, true)), out.nValue * -1);
+                mapDeltas[std::make_pair(addressType, hashBytes)].Add(i, out.nValue * -1);
+                // remove address from unspent index
+                batch.Erase(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressUnspentKey(addressType, hashBytes, prevout.hash, prevout.n)));
+            }
+        }
+
+        for (size_t k = 0; k < tx.vout.size(); k++) {
+            const CTxOut& out = tx.vout[k];
+            if (!GetAddressKey(out.scriptPubKey, addressType, hashBytes)) {
+                continue;
+            }
+            // record receiving activity
+            batch.Write(std::make_pair(DB_ADDRESSINDEX, CAddressIndexKey(addressType, hashBytes, pindex->nHeight, i, txhash, k, false)), out.nValue);
+            mapDeltas[std::make_pair(addressType, hashBytes)].Add(i, out.nValue);
+            // record unspent output
+            batch.Write(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressUnspentKey(addressType, hashBytes, txhash, k)), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight));
+        }
+    }
+
+    for (const auto& p : mapDeltas) {
+        const auto key = std::make_pair(DB_ADDRESSSUMMARY, CAddressIndexIteratorKey(p.first.first, p.first.second));
+        CAddressSummary summary;
+        m_db->Read(key, summary);
+        if (summary.txCount == 0) {
+            summary.firstHeight = pindex->nHeight;
+        }
+        summary.balance += p.second.balance;
+        summary.received += p.second.received;
+        summary.txCount += p.second.txCount;
+        summary.lastHeight = pindex->nHeight;
+        batch.Write(key, summary);
+    }
+    return true;
+}
+
+bool AddressIndex::RewindBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex)
+{
+    int addressType;
+    uint160 hashBytes;
+    AddressSummaryDeltaMap mapDeltas;
+    // in reverse order, so that outputs which are created and spent in this block end up removed from the unspent index
+    for (size_t i = block.vtx.size(); i-- > 0;) {
+        const CTransaction& tx = *block.vtx[i];
+        const uint256 txhash = tx.GetHash();
+
+        for (size_t k = 0; k < tx.vout.size(); k++) {
+            const CTxOut& out = tx.vout[k];
+            if (!GetAddressKey(out.scriptPubKey, addressType, hashBytes)) {
+                continue;
+            }
+            // undo receiving activity
+            batch.Erase(std::make_pair(DB_ADDRESSINDEX, CAddressIndexKey(addressType, hashBytes, pindex->nHeight, i, txhash, k, false)));
+            mapDeltas[std::make_pair(addressType, hashBytes)].Add(i, out.nValue);
+            // undo unspent index
+            batch.Erase(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressUnspentKey(addressType, hashBytes, txhash, k)));
+        }
+
+        if (!tx.IsCoinBase()) {
+            const CTxUndo& txundo = blockundo.vtxundo[i - 1];
+            for (size_t j = 0; j < tx.vin.size(); j++) {
+                const COutPoint& prevout = tx.vin[j].prevout;
+                const Coin& coin = txundo.vprevout[j];
+                if (!GetAddressKey(coin.out.scriptPubKey, addressType, hashBytes)) {
+                    continue;
+                }
+                // undo spending activity
+                batch.Erase(std::make_pair(DB_ADDRESSINDEX, CAddressIndexKey(addressType, hashBytes, pindex->nHeight, i, txhash, j, true)));
+                mapDeltas[std::make_pair(addressType, hashBytes)].Add(i, coin.out.nValue * -1);
+                // restore unspent index
+                batch.Write(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressUnspentKey(addressType, hashBytes, prevout.hash, prevout.n)), CAddressUnspentValue(coin.out.nValue, coin.out.scriptPubKey, coin.nHeight));
+            }
+        }
+    }
+
+    for (const auto& p : mapDeltas) {
+        const auto key = std::make_pair(DB_ADDRESSSUMMARY, CAddressIndexIteratorKey(p.first.first, p.first.second));
+        CAddressSummary summary;
+        if (!m_db->Read(key, summary)) {
+            continue;
+        }
+        summary.balance -= p.second.balance;
+        summary.received -= p.second.received;
+        summary.txCount -= std::min(summary.txCount, p.second.txCount);
+        if (summary.txCount == 0) {
+            batch.Erase(key);
+            continue;
+        }
+        // the entries of this block are still in the database, as batch isn't written yet, but they are skipped
+        summary.lastHeight = m_db->ReadLastHeightBefore(p.first.first, p.first.second, pindex->nHeight);
+        batch.Write(key, summary);
+    }
+    return true;
+}
+
+bool AddressIndex::ReadAddressIndex(const uint160& addressHash, int type,
+                                    std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex,
+                                    int start, int end)
+{
+    CAddressIndexKey next;
+    bool fMore;
+    const CAddressIndexKey startKey(type, addressHash, (start > 0 && end > 0) ? start : 0, 0, uint256(), 0, false);
+    return ReadAddressIndexPage(startKey, end, 0, addressIndex, next, fMore);
+}
+
+bool AddressIndex::ReadAddressIndexPage(const CAddressIndexKey& start, int end, size_t limit,
+                                        std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex,
+                                        CAddressIndexKey& nextRet, bool& fMoreRet)
+{
+    std::unique_ptr<CDBIterator> pcursor(m_db->NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, start));
+
+    fMoreRet = false;
+    size_t nCount = 0;
+    std::pair<int, unsigned int> lastTx(-1, 0);
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, CAddressIndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.type == start.type && key.second.hashBytes == start.hashBytes) {
+            if (end > 0 && key.second.blockHeight > end) {
+                break;
+            }
+            const std::pair<int, unsigned int> curTx(key.second.blockHeight, key.second.txindex);
+            if (limit != 0 && nCount >= limit && curTx != lastTx) {
+                nextRet = key.second;
+                fMoreRet = true;
+                break;
+            }
+            CAmount nValue;
+            if (pcursor->GetValue(nValue)) {
+                addressIndex.push_back(std::make_pair(key.second, nValue));
+                nCount++;
+                lastTx = curTx;
+                pcursor->Next();
+            } else {
+                return error("failed to get address index value");
+            }
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool AddressIndex::ReadAddressUnspentIndex(const uint160& addressHash, int type,
+                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& unspentOutputs)
+{
+    CAddressUnspentKey next;
+    bool fMore;
+    return ReadAddressUnspentPage(CAddressUnspentKey(type, addressHash, uint256(), 0), 0, unspentOutputs, next, fMore);
+}
+
+bool AddressIndex::ReadAddressUnspentPage(const CAddressUnspentKey& start, size_t limit,
+                                          std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& unspentOutputs,
+                                          CAddressUnspentKey& nextRet, bool& fMoreRet)
+{
+    std::unique_ptr<CDBIterator> pcursor(m_db->NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, start));
+
+    fMoreRet = false;
+    size_t nCount = 0;
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, CAddressUnspentKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.type == start.type && key.second.hashBytes == start.hashBytes) {
+            if (limit != 0 && nCount >= limit) {
+                nextRet = key.second;
+                fMoreRet = true;
+                break;
+            }
+            CAddressUnspentValue nValue;
+            if (pcursor->GetValue(nValue)) {
+                unspentOutputs.push_back(std::make_pair(key.second, nValue));
+                nCount++;
+                pcursor->Next();
+            } else {
+                return error("failed to get address unspent value");
+            }
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool AddressIndex::ReadAddressSummary(const uint160& addressHash, int type, CAddressSummary& summary)
+{
+    summary.SetNull();
+    try {
+        m_db->Read(std::make_pair(DB_ADDRESSSUMMARY, CAddressIndexIteratorKey(type, addressHash)), summary);
+    } catch (const dbwrapper_error& e) {
+        return error("failed to read address summary: %s", e.what());
+    }
+    return true;
+}
+
+class SpentIndex::DB : public BaseIndex::DB
+{
+public:
+    DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+        BaseIndex::DB(GetDataDir() / "indexes" / "spent", n_cache_size, f_memory, f_wipe)
+    {
+    }
+};
+
+SpentIndex::SpentIndex(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    m_db(MakeUnique<SpentIndex::DB>(n_cache_size, f_memory, f_wipe))
+{
+}
+
+SpentIndex::~SpentIndex()
+{
+    Stop();
+}
+
+BaseIndex::DB& SpentIndex::GetDB() const
+{
+    return *m_db;
+}
+
+bool SpentIndex::WriteBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex)
+{
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        const CTransaction& tx = *block.vtx[i];
+        const uint256 txhash = tx.GetHash();
+        const CTxUndo& txundo = blockundo.vtxundo[i - 1];
+        for (size_t j = 0; j < tx.vin.size(); j++) {
+            const COutPoint& prevout = tx.vin[j].prevout;
+            const CTxOut& out = txundo.vprevout[j].out;
+            int addressType;
+            uint160 hashBytes;
+            if (!GetAddressKey(out.scriptPubKey, addressType, hashBytes)) {
+                addressType = 0;
+                hashBytes.SetNull();
+            }
+            // the txid and input that spent an output, and the amount and address of the input
+            batch.Write(std::make_pair(DB_SPENTINDEX, CSpentIndexKey(prevout.hash, prevout.n)), CSpentIndexValue(txhash, j, pindex->nHeight, out.nValue, addressType, hashBytes));
+        }
+    }
+    return true;
+}
+
+bool SpentIndex::RewindBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex)
+{
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        for (const auto& txin : block.vtx[i]->vin) {
+            batch.Erase(std::make_pair(DB_SPENTINDEX, CSpentIndexKey(txin.prevout.hash, txin.prevout.n)));
+        }
+    }
+    return true;
+}
+
+bool SpentIndex::ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value)
+{
+    return m_db->Read(std::make_pair(DB_SPENTINDEX, key), value);
+}
+
+class TimestampIndex::DB : public BaseIndex::DB
+{
+public:
+    DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+        BaseIndex::DB(GetDataDir() / "indexes" / "timestamp", n_cache_size, f_memory, f_wipe)
+    {
+    }
+};
+
+TimestampIndex::TimestampIndex(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    m_db(MakeUnique<TimestampIndex::DB>(n_cache_size, f_memory, f_wipe))
+{
+}
+
+TimestampIndex::~TimestampIndex()
+{
+    Stop();
+}
+
+BaseIndex::DB& TimestampIndex::GetDB() const
+{
+    return *m_db;
+}
+
+bool TimestampIndex::WriteBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex)
+{
+    batch.Write(std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())), 0);
+    return true;
+}
+
+bool TimestampIndex::RewindBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex)
+{
+    batch.Erase(std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())));
+    return true;
+}
+
+bool TimestampIndex::ReadTimestampIndex(unsigned int high, unsigned int low, std::vector<uint256>& hashes)
+{
+    std::unique_ptr<CDBIterator> pcursor(m_db->NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexIteratorKey(low)));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, CTimestampIndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_TIMESTAMPINDEX && key.second.timestamp <= high) {
+            hashes.push_back(key.second.blockHash);
+            pcursor->Next();
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_EXTRAINDEXES_H
+#define BITCOIN_INDEX_EXTRAINDEXES_H
+
+#include <amount.h>
+#include <index/base.h>
+#include <spentindex.h>
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * Address index (-addressindex). Maps addresses to all their receiving and spending activity and to their unspent
+ * outputs, stored in indexes/address. A CAddressSummary per address is updated with every block, so that balances
+ * don't need to be summed up from the whole history.
+ */
+class AddressIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex) override;
+    bool RewindBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex) override;
+    BaseIndex::DB& GetDB() const override;
+    const char* GetName() const override { return "addressindex"; }
+
+public:
+    explicit AddressIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+    ~AddressIndex() override;
+
+    bool ReadAddressIndex(const uint160& addressHash, int type,
+                          std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex,
+                          int start = 0, int end = 0);
+    bool ReadAddressUnspentIndex(const uint160& addressHash, int type,
+                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& unspentOutputs);
+    /**
+     * Reads the entries of the address of start, beginning at start and up to height end (0 for no end). Reading stops
+     * after limit entries (0 for no limit), but never within a transaction. If there are more entries, fMoreRet is set
+     * and nextRet is the key to read the next page from.
+     */
+    bool ReadAddressIndexPage(const CAddressIndexKey& start, int end, size_t limit,
+                              std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex,
+                              CAddressIndexKey& nextRet, bool& fMoreRet);
+    /** Like ReadAddressIndexPage, for the unspent outputs of the address of start, which are ordered by txid */
+    bool ReadAddressUnspentPage(const CAddressUnspentKey& start, size_t limit,
+                                std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& unspentOutputs,
+                                CAddressUnspentKey& nextRet, bool& fMoreRet);
+    /** Reads the summary of an address, which is null if the address has no entries */
+    bool ReadAddressSummary(const uint160& addressHash, int type, CAddressSummary& summary);
+};
+
+/**
+ * Spent index (-spentindex). Maps spent outputs to the input spending them, stored in indexes/spent.
+ */
+class SpentIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex) override;
+    bool RewindBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex) override;
+    BaseIndex::DB& GetDB() const override;
+    const char* GetName() const override { return "spentindex"; }
+
+public:
+    explicit SpentIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+    ~SpentIndex() override;
+
+    bool ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value);
+};
+
+/**
+ * Timestamp index (-timestampindex). Maps block timestamps to block hashes, stored in indexes/timestamp.
+ */
+class TimestampIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex) override;
+    bool RewindBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex) override;
+    BaseIndex::DB& GetDB() const override;
+    const char* GetName() const override { return "timestampindex"; }
+
+public:
+    explicit TimestampIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+    ~TimestampIndex() override;
+
+    bool ReadTimestampIndex(unsigned int high, unsigned int low, std::vector<uint256>& hashes);
+};
+
+/// The global indexes, null if not enabled
+extern std::unique_ptr<AddressIndex> g_addressindex;
+extern std::unique_ptr<SpentIndex> g_spentindex;
+extern std::unique_ptr<TimestampIndex> g_timestampindex;
+
+#endif // BITCOIN_INDEX_EXTRAINDEXES_H
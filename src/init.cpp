@@ -16,12 +16,16 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <checkpoints.h>
+#include <coinsprefetch.h>
 #include <node/coinstats.h>
 #include <compat/sanity.h>
 #include <consensus/validation.h>
+#include <dbwrapper.h>
 #include <fs.h>
 #include <httpserver.h>
 #include <httprpc.h>
+#include <index/blockfilterindex.h>
+#include <index/extraindexes.h>
 #include <key.h>
 #include <validation.h>
 #include <miner.h>
@@ -33,6 +37,7 @@
 #include <policy/policy.h>
 #include <rpc/server.h>
 #include <rpc/register.h>
+#include <rpc/resultcache.h>
 #include <rpc/blockchain.h>
 #include <script/standard.h>
 #include <script/sigcache.h>
@@ -40,6 +45,7 @@
 #include <timedata.h>
 #include <txdb.h>
 #include <txmempool.h>
+#include <txrelaycache.h>
 #include <torcontrol.h>
 #include <ui_interface.h>
 #include <util.h>
@@ -51,6 +57,7 @@
 #include <dsnotificationinterface.h>
 #include <flat-database.h>
 #include <governance/governance.h>
+#include <governance/governance-votedb.h>
 #include <masternode/masternode-meta.h>
 #include <masternode/masternode-payments.h>
 #include <masternode/masternode-sync.h>
@@ -62,13 +69,17 @@
 #include <walletinitinterface.h>
 
 #include <evo/deterministicmns.h>
+#include <llmq/quorums.h>
 #include <llmq/quorums_init.h>
 #include <llmq/quorums_blockprocessor.h>
 #include <llmq/quorums_signing.h>
+#include <llmq/quorums_instantsend.h>
+#include <llmq/quorums_signing_shares.h>
 #include <llmq/quorums_utils.h>
 
 #include <statsd_client.h>
 
+#include <cctype>
 #include <stdint.h>
 #include <stdio.h>
 
@@ -100,6 +111,8 @@ static const bool DEFAULT_STOPAFTERBLOCKIMPORT = false;
 std::unique_ptr<CConnman> g_connman;
 std::unique_ptr<PeerLogicValidation> peerLogic;
 
+static std::set<BlockFilterType> g_enabled_filter_types;
+
 #if !(ENABLE_WALLET)
 class DummyWalletInit : public WalletInitInterface {
 public:
@@ -136,6 +149,30 @@ static CDSNotificationInterface* pdsNotificationInterface = nullptr;
 #endif
 
 static const char* FEE_ESTIMATES_FILENAME="fee_estimates.dat";
+/** How often the fee estimates are written to disk while running, so that an unclean shutdown doesn't lose them */
+static const int64_t FEE_ESTIMATES_WRITE_INTERVAL = 60 * 60;
+
+/** Writes the fee estimates to a temporary file first, so that a crash while writing doesn't corrupt them */
+static void WriteFeeEstimates()
+{
+    static CCriticalSection cs_writeFeeEstimates;
+    LOCK(cs_writeFeeEstimates);
+    fs::path est_path = GetDataDir() / FEE_ESTIMATES_FILENAME;
+    fs::path est_path_new = GetDataDir() / (std::string(FEE_ESTIMATES_FILENAME) + ".new");
+    CAutoFile est_fileout(fsbridge::fopen(est_path_new, "wb"), SER_DISK, CLIENT_VERSION);
+    if (est_fileout.IsNull()) {
+        LogPrintf("%s: Failed to write fee estimates to %s\n", __func__, est_path_new.string());
+        return;
+    }
+    if (!::feeEstimator.Write(est_fileout)) {
+        return;
+    }
+    FileCommit(est_fileout.Get());
+    est_fileout.fclose();
+    if (!RenameOver(est_path_new, est_path)) {
+        LogPrintf("%s: Failed to rename fee estimates to %s\n", __func__, est_path.string());
+    }
+}
 
 //////////////////////////////////////////////////////////////////////////////
 //
@@ -207,7 +244,13 @@ static std::unique_ptr<CCoinsViewErrorCatcher> pcoinscatcher;
 static std::unique_ptr<ECCVerifyHandle> globalVerifyHandle;
 
 static boost::thread_group threadGroup;
-static CScheduler scheduler;
+static CScheduler scheduler("scheduler");
+//! Runs the callbacks of high priority validation interface listeners
+static CScheduler schedulerHighPriority("signals");
+//! Runs periodic Dash maintenance tasks, so they don't delay validation callbacks and networking
+static CScheduler schedulerMaintenance("maintenance");
+//! Runs tasks that write to disk
+static CScheduler schedulerIO("io");
 
 void Interrupt()
 {
@@ -255,6 +298,10 @@ void PrepareShutdown()
     // using the other before destroying them.
     if (peerLogic) UnregisterValidationInterface(peerLogic.get());
     if (g_connman) g_connman->Stop();
+    if (g_addressindex) g_addressindex->Stop();
+    if (g_spentindex) g_spentindex->Stop();
+    if (g_timestampindex) g_timestampindex->Stop();
+    ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Stop(); });
     // if (g_txindex) g_txindex->Stop(); //TODO watch out when backporting bitcoin#13033 (don't accidently put the reset here, as we've already backported bitcoin#13894)
 
     StopTorControl();
@@ -271,12 +318,14 @@ void PrepareShutdown()
     if (!fRPCInWarmup) {
         // STORE DATA CACHES INTO SERIALIZED DAT FILES
         CFlatDB<CMasternodeMetaMan> flatdb1("mncache.dat", "magicMasternodeCache");
+        mmetaman.CheckAndRemove();
         flatdb1.Dump(mmetaman);
         CFlatDB<CNetFulfilledRequestManager> flatdb4("netfulfilled.dat", "magicFulfilledCache");
         flatdb4.Dump(netfulfilledman);
         CFlatDB<CSporkManager> flatdb6("sporks.dat", "magicSporkCache");
         flatdb6.Dump(sporkManager);
         if (!fDisableGovernance) {
+            governance.FlushObjects();
             CFlatDB<CGovernanceManager> flatdb3("governance.dat", "magicGovernanceCache");
             flatdb3.Dump(governance);
         }
@@ -286,6 +335,10 @@ void PrepareShutdown()
     // destruct and reset all to nullptr.
     peerLogic.reset();
     g_connman.reset();
+    g_addressindex.reset();
+    g_spentindex.reset();
+    g_timestampindex.reset();
+    DestroyAllBlockFilterIndexes();
     //g_txindex.reset(); //TODO watch out when backporting bitcoin#13033 (re-enable this, was backported via bitcoin#13894)
 
     if (g_is_mempool_loaded && gArgs.GetArg("-persistmempool", DEFAULT_PERSIST_MEMPOOL)) {
@@ -295,12 +348,7 @@ void PrepareShutdown()
     if (fFeeEstimatesInitialized)
     {
         ::feeEstimator.FlushUnconfirmed();
-        fs::path est_path = GetDataDir() / FEE_ESTIMATES_FILENAME;
-        CAutoFile est_fileout(fsbridge::fopen(est_path, "wb"), SER_DISK, CLIENT_VERSION);
-        if (!est_fileout.IsNull())
-            ::feeEstimator.Write(est_fileout);
-        else
-            LogPrintf("%s: Failed to write fee estimates to %s\n", __func__, est_path.string());
+        WriteFeeEstimates();
         fFeeEstimatesInitialized = false;
     }
 
@@ -319,19 +367,26 @@ void PrepareShutdown()
     // up with our current chain to avoid any strange pruning edge cases and make
     // next startup faster by avoiding rescan.
 
+    // Reads from pcoinsdbview must be finished before it's destroyed
+    coinsPrefetcher.Stop();
+
     {
         LOCK(cs_main);
         if (pcoinsTip != nullptr) {
             FlushStateToDisk();
+            DumpBlockIndexCache();
         }
         pcoinsTip.reset();
         pcoinscatcher.reset();
         pcoinsdbview.reset();
+        g_coins_commitment.reset();
         pblocktree.reset();
         llmq::DestroyLLMQSystem();
         deterministicMNManager.reset();
         evoDb.reset();
     }
+    delete governanceDB;
+    governanceDB = nullptr;
     g_wallet_init_interface.Stop();
 
 #if ENABLE_ZMQ
@@ -387,6 +442,7 @@ void Shutdown()
     globalVerifyHandle.reset();
     ECC_Stop();
     LogPrintf("%s: done\n", __func__);
+    StopAsyncLogging();
 }
 
 /**
@@ -474,13 +530,24 @@ void SetupServerArgs()
     gArgs.AddArg("-blocknotify=<cmd>", "Execute command when the best block changes (%s in cmd is replaced by block hash)", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-blockreconstructionextratxn=<n>", strprintf("Extra transactions to keep in memory for compact block reconstructions (default: %u)", DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-blocksonly", strprintf("Whether to operate in a blocks only mode (default: %u)", DEFAULT_BLOCKSONLY), true, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-coinsprefetchthreads=<n>", strprintf("Number of threads reading the inputs of received blocks from the coins database before the blocks are connected during initial block download, 0 to disable (0-%d, default: %d)", MAX_COINS_PREFETCH_THREADS, DEFAULT_COINS_PREFETCH_THREADS), true, OptionsCategory::OPTIONS);
     gArgs.AddArg("-conf=<file>", strprintf("Specify configuration file. Relative paths will be prefixed by datadir location. (default: %s)", BITCOIN_CONF_FILENAME), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-datadir=<dir>", "Specify data directory", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-dbbackgroundwrite", strprintf("Write the coins database on a background thread when flushing the coins cache (default: %u)", DEFAULT_DB_BACKGROUND_WRITE), true, OptionsCategory::OPTIONS);
     gArgs.AddArg("-dbbatchsize", strprintf("Maximum database write batch size in bytes (default: %u)", nDefaultDbBatchSize), true, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-dbtune=<db>:<option>=<n>", "Change the LevelDB tuning of a database (chainstate, index, evodb, llmq, governance, address, spent, timestamp). Options are blockcache, writebuffer, maxfilesize and blocksize in KiB, bloombits, maxopenfiles, compression (0 or 1) and compactonopen (0 or 1). Can be specified multiple times", true, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-mnlistcachemb=<n>", strprintf("Limit the estimated memory usage of cached masternode lists and list diffs to <n> megabytes. Lists of the chain tip and of active quorums are always kept (default: %u)", DEFAULT_MNLIST_CACHE_MB), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-mnlistsnapshotperiod=<n>", strprintf("Write a full masternode list snapshot to disk every <n> blocks. Smaller values speed up masternode list lookups for old blocks at the cost of disk space (default: %u)", DEFAULT_MNLIST_SNAPSHOT_PERIOD), true, OptionsCategory::OPTIONS);
     gArgs.AddArg("-dbcache=<n>", strprintf("Set database cache size in megabytes (%d to %d, default: %d)", nMinDbCache, nMaxDbCache, nDefaultDbCache), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-dbcachekeep=<n>", strprintf("Percentage of the in-memory UTXO set which stays filled with recently used coins when it is written to disk, 0 to clear it completely (0 to %d, default: %d)", MAX_COINS_CACHE_KEEP_PERCENT, DEFAULT_COINS_CACHE_KEEP_PERCENT), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-debuglogfile=<file>", strprintf("Specify location of debug log file. Relative paths will be prefixed by a net-specific datadir location. (0 to disable; default: %s)", DEFAULT_DEBUGLOGFILE), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-islockarchivechunk=<n>", strprintf("Maximum number of InstantSend locks archived at once when blocks get fully confirmed (default: %d)", llmq::DEFAULT_ISLOCK_ARCHIVE_CHUNK), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-islockarchivetime=<n>", strprintf("Time budget in milliseconds for the archival of InstantSend locks per iteration of the InstantSend thread (default: %d)", llmq::DEFAULT_ISLOCK_ARCHIVE_TIME), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-islockindexmemory=<n>", strprintf("Maximum memory in megabytes used to index the inputs of InstantSend locks in memory (0 = disable, default: %d)", llmq::DEFAULT_ISLOCK_INDEX_MEMORY), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-islockverifythreads=<n>", strprintf("Set the number of threads used to verify incoming InstantSend locks (0 = auto, up to %d, default: %d)", llmq::MAX_ISLOCK_VERIFY_THREADS, llmq::DEFAULT_ISLOCK_VERIFY_THREADS), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-loadblock=<file>", "Imports blocks from external blk000??.dat file on startup", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-maxmempool=<n>", strprintf("Keep the transaction memory pool below <n> megabytes (default: %u)", DEFAULT_MAX_MEMPOOL_SIZE), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-maxrelaycache=<n>", strprintf("Keep recently relayed transactions, which are used to answer getdata requests, below <n> megabytes (default: %u)", DEFAULT_MAX_RELAY_CACHE_SIZE), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-maxorphantxsize=<n>", strprintf("Maximum total size of all orphan transactions in megabytes (default: %u)", DEFAULT_MAX_ORPHAN_TRANSACTIONS_SIZE), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-maxrecsigsage=<n>", strprintf("Number of seconds to keep LLMQ recovery sigs (default: %u)", llmq::DEFAULT_MAX_RECOVERED_SIGS_AGE), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-mempoolexpiry=<n>", strprintf("Do not keep transactions in the mempool longer than <n> hours (default: %u)", DEFAULT_MEMPOOL_EXPIRY), false, OptionsCategory::OPTIONS);
@@ -501,10 +568,13 @@ void SetupServerArgs()
     gArgs.AddArg("-version", "Print version and exit", false, OptionsCategory::OPTIONS);
 
     gArgs.AddArg("-addressindex", strprintf("Maintain a full address index, used to query for the balance, txids and unspent outputs for addresses (default: %u)", DEFAULT_ADDRESSINDEX), false, OptionsCategory::INDEXING);
+    gArgs.AddArg("-blockfilterindex=<type>", strprintf("Maintain an index of compact filters by block (default: %s, values: %s).", DEFAULT_BLOCKFILTERINDEX, ListBlockFilterTypes()) +
+                 " If <type> is not supplied or if <type> = 1, indexes for all known types are enabled.", false, OptionsCategory::INDEXING);
     gArgs.AddArg("-reindex", "Rebuild chain state and block index from the blk*.dat files on disk", false, OptionsCategory::INDEXING);
     gArgs.AddArg("-reindex-chainstate", "Rebuild chain state from the currently indexed blocks", false, OptionsCategory::INDEXING);
     gArgs.AddArg("-spentindex", strprintf("Maintain a full spent index, used to query the spending txid and input index for an outpoint (default: %u)", DEFAULT_SPENTINDEX), false, OptionsCategory::INDEXING);
     gArgs.AddArg("-timestampindex", strprintf("Maintain a timestamp index for block hashes, used to query blocks hashes by a range of timestamps (default: %u)", DEFAULT_TIMESTAMPINDEX), false, OptionsCategory::INDEXING);
+    gArgs.AddArg("-utxocommitment", strprintf("Maintain a MuHash of the UTXO set while blocks are connected, so that gettxoutsetinfo \"muhash\" returns immediately (default: %u)", DEFAULT_UTXO_COMMITMENT), false, OptionsCategory::INDEXING);
     gArgs.AddArg("-txindex", strprintf("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)", DEFAULT_TXINDEX), false, OptionsCategory::INDEXING);
 
     gArgs.AddArg("-addnode=<ip>", "Add a node to connect to and attempt to keep the connection open (see the `addnode` RPC command help for more info). This option can be specified multiple times to add multiple nodes.", false, OptionsCategory::CONNECTION);
@@ -512,6 +582,7 @@ void SetupServerArgs()
     gArgs.AddArg("-banscore=<n>", strprintf("Threshold for disconnecting misbehaving peers (default: %u)", DEFAULT_BANSCORE_THRESHOLD), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-bantime=<n>", strprintf("Number of seconds to keep misbehaving peers from reconnecting (default: %u)", DEFAULT_MISBEHAVING_BANTIME), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-bind=<addr>", "Bind to given address and always listen on it. Use [host]:port notation for IPv6", false, OptionsCategory::CONNECTION);
+    gArgs.AddArg("-blockreadthreads=<n>", strprintf("Number of threads to read blocks requested by peers from disk, 0 to read them on the message handler thread (0-%d, default: %d)", MAX_BLOCK_READ_THREADS, DEFAULT_BLOCK_READ_THREADS), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-connect=<ip>", "Connect only to the specified node; -connect=0 disables automatic connections (the rules for this peer are the same as for -addnode). This option can be specified multiple times to connect to multiple nodes.", false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-discover", "Discover own IP addresses (default: 1 when listening and no -externalip or -proxy)", false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-dns", strprintf("Allow DNS lookups for -addnode, -seednode and -connect (default: %u)", DEFAULT_NAME_LOOKUP), false, OptionsCategory::CONNECTION);
@@ -521,6 +592,7 @@ void SetupServerArgs()
     gArgs.AddArg("-forcednsseed", strprintf("Always query for peer addresses via DNS lookup (default: %u)", DEFAULT_FORCEDNSSEED), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-listen", "Accept connections from outside (default: 1 if no -proxy or -connect)", false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-listenonion", strprintf("Automatically create Tor hidden service (default: %d)", DEFAULT_LISTEN_ONION), false, OptionsCategory::CONNECTION);
+    gArgs.AddArg("-lowlatency", strprintf("Lower network latency at the cost of CPU time by busy polling sockets, recommended for masternodes on dedicated hosts only (default: %u)", DEFAULT_LOW_LATENCY), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-maxconnections=<n>", strprintf("Maintain at most <n> connections to peers (temporary service connections excluded) (default: %u)", DEFAULT_MAX_PEER_CONNECTIONS), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-maxreceivebuffer=<n>", strprintf("Maximum per-connection receive buffer, <n>*1000 bytes (default: %u)", DEFAULT_MAXRECEIVEBUFFER), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-maxsendbuffer=<n>", strprintf("Maximum per-connection send buffer, <n>*1000 bytes (default: %u)", DEFAULT_MAXSENDBUFFER), false, OptionsCategory::CONNECTION);
@@ -529,6 +601,7 @@ void SetupServerArgs()
     gArgs.AddArg("-onion=<ip:port>", "Use separate SOCKS5 proxy to reach peers via Tor hidden services (default: -proxy)", false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-onlynet=<net>", "Make outgoing connections only through network <net> (ipv4, ipv6 or onion). Incoming connections are not affected by this option. This option can be specified multiple times to allow multiple networks.", false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-peerbloomfilters", strprintf("Support filtering of blocks and transaction with bloom filters (default: %u)", DEFAULT_PEERBLOOMFILTERS), false, OptionsCategory::CONNECTION);
+    gArgs.AddArg("-peerblockfilters", strprintf("Serve compact block filters to peers per BIP 157 (default: %u)", DEFAULT_PEERBLOCKFILTERS), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-peertimeout=<n>", strprintf("Specify p2p connection timeout in seconds. This option determines the amount of time a peer may be inactive before the connection to it is dropped. (minimum: 1, default: %d)", DEFAULT_PEER_CONNECT_TIMEOUT), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-permitbaremultisig", strprintf("Relay non-P2SH multisig (default: %u)", DEFAULT_PERMIT_BAREMULTISIG), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-port=<port>", strprintf("Listen for connections on <port> (default: %u or testnet: %u)", defaultChainParams->GetDefaultPort(), testnetChainParams->GetDefaultPort()), false, OptionsCategory::CONNECTION);
@@ -536,6 +609,8 @@ void SetupServerArgs()
     gArgs.AddArg("-proxyrandomize", strprintf("Randomize credentials for every proxy connection. This enables Tor stream isolation (default: %u)", DEFAULT_PROXYRANDOMIZE), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-seednode=<ip>", "Connect to a node to retrieve peer addresses, and disconnect. This option can be specified multiple times to connect to multiple nodes.", false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-socketevents=<mode>", "Socket events mode, which must be one of 'select', 'poll', 'epoll' or 'kqueue', depending on your system (default: Linux - 'epoll', FreeBSD/Apple - 'kqueue', Windows - 'select')", false, OptionsCategory::CONNECTION);
+    gArgs.AddArg("-msgworkerthreads=<n>", strprintf("Number of threads to process LLMQ signing, DKG and governance vote messages, 0 to process them on the message handler thread (0-%d, default: %d)", MAX_MESSAGE_WORKER_THREADS, DEFAULT_MESSAGE_WORKER_THREADS), false, OptionsCategory::CONNECTION);
+    gArgs.AddArg("-socketthreads=<n>", strprintf("Number of threads to receive and send socket data, 0 to do it on the socket handler thread (0-%d, default: %d)", MAX_SOCKET_THREADS, DEFAULT_SOCKET_THREADS), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-timeout=<n>", strprintf("Specify connection timeout in milliseconds (minimum: 1, default: %d)", DEFAULT_CONNECT_TIMEOUT), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-torcontrol=<ip>:<port>", strprintf("Tor control port to use if onion listening enabled (default: %s)", DEFAULT_TOR_CONTROL), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-torpassword=<pass>", "Tor control port password (default: empty)", false, OptionsCategory::CONNECTION);
@@ -553,6 +628,7 @@ void SetupServerArgs()
     g_wallet_init_interface.AddWalletOptions();
 
 #if ENABLE_ZMQ
+    gArgs.AddArg("-zmqblockonfull=<type>", "Wait for room in the notification queue instead of dropping the notification when it's full, for notifications of this type (e.g. pubhashblock). Can be specified multiple times", false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubhashblock=<address>", "Enable publish hash block in <address>", false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubhashgovernanceobject=<address>", "Enable publish hash of governance objects (like proposals) in <address>", false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubhashgovernancevote=<address>", "Enable publish hash of governance votes in <address>", false, OptionsCategory::ZMQ);
@@ -565,10 +641,18 @@ void SetupServerArgs()
     gArgs.AddArg("-zmqpubrawrecoveredsig=<address>", "Enable publish raw recovered signatures (recovered by LLMQs) in <address>", false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubrawtx=<address>", "Enable publish raw transaction in <address>", false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubrawtxlock=<address>", "Enable publish raw transaction (locked via InstantSend) in <address>", false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubrawtxwatch=<address>", "Enable publish raw transaction paying to or spending from a script in -zmqwatch in <address>", false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqqueuesize=<n>", strprintf("Maximum number of notifications waiting to be published, further ones are dropped unless their type is in -zmqblockonfull (default: %u)", DEFAULT_ZMQ_QUEUE_SIZE), false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqsndhwm=<n>", strprintf("Set the outbound message high water mark of the publish sockets, 0 for no limit (default: %d)", DEFAULT_ZMQ_SNDHWM), false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqwatch=<address|script>", "Watch this address or hex encoded script for -zmqpubrawtxwatch, more can be added with the setzmqwatch RPC. Can be specified multiple times", false, OptionsCategory::ZMQ);
 #endif
 
+    gArgs.AddArg("-assumeutxo=<height:utxohash:evohash>", "Accept UTXO set snapshots of the block at this height with these hashes, as reported by dumptxoutset (regtest-only)", true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-checkblockindex", strprintf("Do a full consistency check for mapBlockIndex, setBlockIndexCandidates, chainActive and mapBlocksUnlinked occasionally. (default: %u)", defaultChainParams->DefaultConsistencyChecks()), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-checkblocks=<n>", strprintf("How many blocks to check at startup (default: %u, 0 = all)", DEFAULT_CHECKBLOCKS), true, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-checkblocksbackground=<n>", strprintf("How many blocks to check in the background after startup, without delaying it (default: %u, -1 = all)", DEFAULT_CHECKBLOCKS_BACKGROUND), true, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-checkblocksbackgroundfatal", "Shut down instead of only warning when the background block check finds corrupted data (default: 0)", true, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-checkblocksbackgroundlevel=<n>", strprintf("How thorough the block verification of -checkblocksbackground is (0-2, default: %u)", DEFAULT_CHECKLEVEL_BACKGROUND), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-checklevel=<n>", strprintf("How thorough the block verification of -checkblocks is (0-4, default: %u)", DEFAULT_CHECKLEVEL), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-checkmempool=<n>", strprintf("Run checks every <n> transactions (default: %u)", defaultChainParams->DefaultConsistencyChecks()), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-checkpoints", strprintf("Disable expensive verification for known chain history (default: %u)", DEFAULT_CHECKPOINTS_ENABLED), true, OptionsCategory::DEBUG_TEST);
@@ -595,7 +679,10 @@ void SetupServerArgs()
     gArgs.AddArg("-llmqdevnetparams=<size:threshold>", strprintf("Override the default LLMQ size for the LLMQ_DEVNET quorum (default: %u:%u)", devnetLLMQ.size, devnetLLMQ.threshold), false, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-llmqinstantsend=<quorum name>", strprintf("Override the default LLMQ type used for InstantSend on a devnet. Allows using InstantSend with smaller LLMQs. (default: %s)", devnetConsensus.llmqs.at(devnetConsensus.llmqTypeInstantSend).name), false, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-llmqtestparams=<size:threshold>", strprintf("Override the default LLMQ size for the LLMQ_TEST quorum (default: %u:%u)", regtestLLMQ.size, regtestLLMQ.threshold), false, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-lockstats", strprintf("Record how long each LOCK site waits for and holds its mutex, see getlockstats (default: %u)", DEFAULT_LOCKSTATS), true, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-logasync", strprintf("Write the debug log from a background thread, so logging doesn't slow down the threads that log. Messages are dropped if the writer can't keep up (default: %u)", DEFAULT_LOGASYNC), false, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-logips", strprintf("Include IP addresses in debug output (default: %u)", DEFAULT_LOGIPS), false, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-lograte=<n>", strprintf("Log at most <n> messages per second of each debug category, 0 for no limit (default: %u)", DEFAULT_LOGRATELIMIT), false, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-logthreadnames", strprintf("Add thread names to debug messages (default: %u)", DEFAULT_LOGTHREADNAMES), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-logtimemicros", strprintf("Add microsecond precision to debug timestamps (default: %u)", DEFAULT_LOGTIMEMICROS), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-maxsigcachesize=<n>", strprintf("Limit sum of signature cache and script execution cache sizes to <n> MiB (default: %u)", DEFAULT_MAX_SIG_CACHE_SIZE), true, OptionsCategory::DEBUG_TEST);
@@ -617,7 +704,10 @@ void SetupServerArgs()
     SetupChainParamsBaseOptions();
 
     gArgs.AddArg("-llmq-data-recovery=<n>", strprintf("Enable automated quorum data recovery (default: %u)", llmq::DEFAULT_ENABLE_QUORUM_DATA_RECOVERY), false, OptionsCategory::MASTERNODE);
+    gArgs.AddArg("-llmq-dkg-bls-cache=<n>", strprintf("Limit the memory used by the BLS cache of each DKG session to <n> MiB (default: %d)", llmq::DEFAULT_DKG_BLS_CACHE_SIZE), false, OptionsCategory::MASTERNODE);
+    gArgs.AddArg("-llmq-lazy-pubkeyshares=<n>", "Compute the public key shares of quorum members on first use instead of precomputing them for all members of new quorums (default: 0 for masternodes, 1 otherwise)", false, OptionsCategory::MASTERNODE);
     gArgs.AddArg("-llmq-qvvec-sync=<quorum_name>:<mode>", strprintf("Defines from which LLMQ type the masternode should sync quorum verification vectors. Can be used multiple times with different LLMQ types. <mode>: %d (sync always from all quorums of the type defined by <quorum_name>), %d (sync from all quorums of the type defined by <quorum_name> if a member of any of the quorums)", (int32_t)llmq::QvvecSyncMode::Always, (int32_t)llmq::QvvecSyncMode::OnlyIfTypeMember), false, OptionsCategory::MASTERNODE);
+    gArgs.AddArg("-llmq-sigshare-threads=<n>", strprintf("Set the number of threads used to verify incoming LLMQ signature shares (0 = auto, up to %d, default: %d)", llmq::MAX_SIGSHARES_VERIFY_THREADS, llmq::DEFAULT_SIGSHARES_VERIFY_THREADS), false, OptionsCategory::MASTERNODE);
     gArgs.AddArg("-masternodeblsprivkey=<hex>", "Set the masternode BLS private key and enable the client to act as a masternode", false, OptionsCategory::MASTERNODE);
     gArgs.AddArg("-platform-user=<user>", "Set the username for the \"platform user\", a restricted user intended to be used by Dash Platform, to the specified username.", false, OptionsCategory::MASTERNODE);
 
@@ -633,20 +723,26 @@ void SetupServerArgs()
     gArgs.AddArg("-whitelistrelay", strprintf("Accept relayed transactions received from whitelisted peers even when not relaying transactions (default: %d)", DEFAULT_WHITELISTRELAY), false, OptionsCategory::NODE_RELAY);
 
     gArgs.AddArg("-blockmaxsize=<n>", strprintf("Set maximum block size in bytes (default: %d)", DEFAULT_BLOCK_MAX_SIZE), false, OptionsCategory::BLOCK_CREATION);
+    gArgs.AddArg("-blocktemplateasynccheck", strprintf("Return getblocktemplate results before they passed TestBlockValidity, which then runs in the background and discards templates failing it (default: %u)", DEFAULT_BLOCK_TEMPLATE_ASYNC_CHECK), false, OptionsCategory::BLOCK_CREATION);
     gArgs.AddArg("-blockmintxfee=<amt>", strprintf("Set lowest fee rate (in %s/kB) for transactions to be included in block creation. (default: %s)", CURRENCY_UNIT, FormatMoney(DEFAULT_BLOCK_MIN_TX_FEE)), false, OptionsCategory::BLOCK_CREATION);
     gArgs.AddArg("-blockversion=<n>", "Override block version to test forking scenarios", true, OptionsCategory::BLOCK_CREATION);
 
     gArgs.AddArg("-rest", strprintf("Accept public REST requests (default: %u)", DEFAULT_REST_ENABLE), false, OptionsCategory::RPC);
     gArgs.AddArg("-rpcallowip=<ip>", "Allow JSON-RPC connections from specified source. Valid for <ip> are a single IP (e.g. 1.2.3.4), a network/netmask (e.g. 1.2.3.4/255.255.255.0) or a network/CIDR (e.g. 1.2.3.4/24). This option can be specified multiple times", false, OptionsCategory::RPC);
     gArgs.AddArg("-rpcauth=<userpw>", "Username and hashed password for JSON-RPC connections. The field <userpw> comes in the format: <USERNAME>:<SALT>$<HASH>. A canonical python script is included in share/rpcuser. The client then connects normally using the rpcuser=<USERNAME>/rpcpassword=<PASSWORD> pair of arguments. This option can be specified multiple times", false, OptionsCategory::RPC);
+    gArgs.AddArg("-rpcbatchthreads=<n>", strprintf("Execute the elements of a JSON-RPC batch request on up to <n> threads. Elements may then run in any order, so only use this if clients don't rely on earlier elements of a batch having completed (default: %d)", DEFAULT_RPC_BATCH_THREADS), true, OptionsCategory::RPC);
     gArgs.AddArg("-rpcbind=<addr>[:port]", "Bind to given address to listen for JSON-RPC connections. Do not expose the RPC server to untrusted networks such as the public internet! This option is ignored unless -rpcallowip is also passed. Port is optional and overrides -rpcport. Use [host]:port notation for IPv6. This option can be specified multiple times (default: 127.0.0.1 and ::1 i.e., localhost, or if -rpcallowip has been specified, 0.0.0.0 and :: i.e., all addresses)", false, OptionsCategory::RPC);
+    gArgs.AddArg("-rpccachesize=<n>", strprintf("Cache the results of RPC calls which only depend on the chain (getblock, getblockheader(s), getmerkleblocks, getspecialtxes, protx list and quorum list) until the tip changes, using up to <n> MiB (default: %d, 0 = disabled)", DEFAULT_RPC_CACHE_SIZE), false, OptionsCategory::RPC);
     gArgs.AddArg("-rpccookiefile=<loc>", "Location of the auth cookie. Relative paths will be prefixed by a net-specific datadir location. (default: data dir)", false, OptionsCategory::RPC);
+    gArgs.AddArg("-rpcfastthreads=<n>", strprintf("Set the number of threads to service cheap RPC calls like getblockcount, which never wait behind other calls (default: %d)", DEFAULT_HTTP_FAST_THREADS), true, OptionsCategory::RPC);
+    gArgs.AddArg("-rpcheavythreads=<n>", strprintf("Set the number of threads to service slow RPC calls like gettxoutsetinfo, getaddressdeltas or protx (default: %d)", DEFAULT_HTTP_HEAVY_THREADS), true, OptionsCategory::RPC);
     gArgs.AddArg("-rpcpassword=<pw>", "Password for JSON-RPC connections", false, OptionsCategory::RPC);
     gArgs.AddArg("-rpcport=<port>", strprintf("Listen for JSON-RPC connections on <port> (default: %u or testnet: %u)", defaultBaseParams->RPCPort(), testnetBaseParams->RPCPort()), false, OptionsCategory::RPC);
     gArgs.AddArg("-rpcservertimeout=<n>", strprintf("Timeout during HTTP requests (default: %d)", DEFAULT_HTTP_SERVER_TIMEOUT), true, OptionsCategory::RPC);
     gArgs.AddArg("-rpcthreads=<n>", strprintf("Set the number of threads to service RPC calls (default: %d)", DEFAULT_HTTP_THREADS), false, OptionsCategory::RPC);
     gArgs.AddArg("-rpcuser=<user>", "Username for JSON-RPC connections", false, OptionsCategory::RPC);
-    gArgs.AddArg("-rpcworkqueue=<n>", strprintf("Set the depth of the work queue to service RPC calls (default: %d)", DEFAULT_HTTP_WORKQUEUE), true, OptionsCategory::RPC);
+    gArgs.AddArg("-rpcwalletthreads=<n>", strprintf("Set the number of threads to service wallet RPC calls (default: %d)", DEFAULT_HTTP_WALLET_THREADS), true, OptionsCategory::RPC);
+    gArgs.AddArg("-rpcworkqueue=<n>", strprintf("Set the depth of each of the work queues to service RPC calls (default: %d)", DEFAULT_HTTP_WORKQUEUE), true, OptionsCategory::RPC);
     gArgs.AddArg("-server", "Accept command line and JSON-RPC commands", false, OptionsCategory::RPC);
 
     gArgs.AddArg("-statsenabled", strprintf("Publish internal stats to statsd (default: %u)", DEFAULT_STATSD_ENABLE), false, OptionsCategory::STATSD);
@@ -919,6 +1015,59 @@ void PeriodicStats()
     statsClient.gauge("transactions.mempool.totalTxBytes", (int64_t) mempool.GetTotalTxSize(), 1.0f);
     statsClient.gauge("transactions.mempool.memoryUsageBytes", (int64_t) mempool.DynamicMemoryUsage(), 1.0f);
     statsClient.gauge("transactions.mempool.minFeePerKb", mempool.GetMinFee(gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000).GetFeePerK(), 1.0f);
+
+    CCuckooCacheStats sigCacheStats = GetSignatureCacheStats();
+    statsClient.gauge("validation.sigCache.hits", sigCacheStats.nHits, 1.0f);
+    statsClient.gauge("validation.sigCache.misses", sigCacheStats.nMisses, 1.0f);
+    CCuckooCacheStats scriptCacheStats = GetScriptExecutionCacheStats();
+    statsClient.gauge("validation.scriptCache.hits", scriptCacheStats.nHits, 1.0f);
+    statsClient.gauge("validation.scriptCache.misses", scriptCacheStats.nMisses, 1.0f);
+
+    if (g_lock_profiling) {
+        // Sum up the sites of each mutex and report the most contended ones
+        static const size_t LOCKSTATS_STATSD_LOCKS = 10;
+        std::map<std::string, LockSiteStats> mapLocks;
+        for (const LockSiteStats& site : GetLockSiteStats()) {
+            std::string strName = site.pszName;
+            std::replace_if(strName.begin(), strName.end(), [](char c) { return !std::isalnum((unsigned char)c) && c != '_'; }, '_');
+            LockSiteStats& lock = mapLocks.emplace(strName, LockSiteStats{site.pszName, nullptr, 0, 0, 0, 0, 0, 0}).first->second;
+            lock.nLocks += site.nLocks;
+            lock.nContended += site.nContended;
+            lock.nWaitMicros += site.nWaitMicros;
+            lock.nMaxWaitMicros = std::max(lock.nMaxWaitMicros, site.nMaxWaitMicros);
+            lock.nHoldMicros += site.nHoldMicros;
+        }
+        std::vector<std::pair<std::string, LockSiteStats>> vLocks(mapLocks.begin(), mapLocks.end());
+        std::sort(vLocks.begin(), vLocks.end(), [](const std::pair<std::string, LockSiteStats>& a, const std::pair<std::string, LockSiteStats>& b) {
+            return a.second.nWaitMicros > b.second.nWaitMicros;
+        });
+        if (vLocks.size() > LOCKSTATS_STATSD_LOCKS) vLocks.resize(LOCKSTATS_STATSD_LOCKS);
+        for (const auto& p : vLocks) {
+            statsClient.gauge("locks." + p.first + ".locks", p.second.nLocks, 1.0f);
+            statsClient.gauge("locks." + p.first + ".contended", p.second.nContended, 1.0f);
+            statsClient.gauge("locks." + p.first + ".waitMicros", p.second.nWaitMicros, 1.0f);
+            statsClient.gauge("locks." + p.first + ".maxWaitMicros", p.second.nMaxWaitMicros, 1.0f);
+            statsClient.gauge("locks." + p.first + ".holdMicros", p.second.nHoldMicros, 1.0f);
+        }
+    }
+
+    if (llmq::quorumManager) {
+        for (const auto& p : Params().GetConsensus().llmqs) {
+            const auto& params = p.second;
+            statsClient.gauge(strprintf("llmq.%s.activeQuorums", params.name), llmq::quorumManager->ScanQuorums(params.type, params.signingActiveQuorumCount).size(), 1.0f);
+        }
+    }
+
+    statsClient.gauge("governance.objects", governance.GetObjectCount(), 1.0f);
+    statsClient.gauge("governance.votes", governance.GetVoteCount(), 1.0f);
+
+    if (fMasternodeMode) {
+        size_t nSessions, nEntries;
+        coinJoinServer.GetSessionCounts(nSessions, nEntries);
+        statsClient.gauge("coinjoin.server.queue", coinJoinServer.GetQueueSize(), 1.0f);
+        statsClient.gauge("coinjoin.server.sessions", nSessions, 1.0f);
+        statsClient.gauge("coinjoin.server.entries", nEntries, 1.0f);
+    }
 }
 
 /** Sanity checks
@@ -939,6 +1088,11 @@ bool InitSanityCheck(void)
         return false;
     }
 
+    if (!BLSSanityCheck()) {
+        InitError("BLS cryptography sanity check failure. Aborting.");
+        return false;
+    }
+
     if (!Random_SanityCheck()) {
         InitError("OS cryptographic RNG sanity check failure. Aborting.");
         return false;
@@ -1043,18 +1197,6 @@ void InitParameterInteraction()
         }
     }
 
-    // Make sure additional indexes are recalculated correctly in VerifyDB
-    // (we must reconnect blocks whenever we disconnect them for these indexes to work)
-    bool fAdditionalIndexes =
-        gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) ||
-        gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) ||
-        gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
-
-    if (fAdditionalIndexes && gArgs.GetArg("-checklevel", DEFAULT_CHECKLEVEL) < 4) {
-        gArgs.ForceSetArg("-checklevel", "4");
-        LogPrintf("%s: parameter interaction: additional indexes -> setting -checklevel=4\n", __func__);
-    }
-
     if (gArgs.IsArgSet("-masternodeblsprivkey") && gArgs.SoftSetBoolArg("-disablewallet", true)) {
         LogPrintf("%s: parameter interaction: -masternodeblsprivkey set -> setting -disablewallet=1\n", __func__);
     }
@@ -1078,6 +1220,8 @@ void InitLogging()
     fLogTimeMicros = gArgs.GetBoolArg("-logtimemicros", DEFAULT_LOGTIMEMICROS);
     fLogThreadNames = gArgs.GetBoolArg("-logthreadnames", DEFAULT_LOGTHREADNAMES);
     fLogIPs = gArgs.GetBoolArg("-logips", DEFAULT_LOGIPS);
+    EnableLockProfiling(gArgs.GetBoolArg("-lockstats", DEFAULT_LOCKSTATS));
+    nLogRateLimit = (unsigned int)std::max<int64_t>(0, gArgs.GetArg("-lograte", DEFAULT_LOGRATELIMIT));
 
     LogPrintf("\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n");
     std::string version_string = FormatFullVersion();
@@ -1173,10 +1317,40 @@ bool AppInitParameterInteraction()
         return InitError(strprintf(_("Specified blocks directory \"%s\" does not exist."), gArgs.GetArg("-blocksdir", "").c_str()));
     }
 
+    // parse and validate enabled filter types
+    std::string blockfilterindex_value = gArgs.GetArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX);
+    if (blockfilterindex_value == "" || blockfilterindex_value == "1") {
+        g_enabled_filter_types.insert(AllBlockFilterTypes().begin(), AllBlockFilterTypes().end());
+    } else if (blockfilterindex_value != "0") {
+        for (const auto& name : gArgs.GetArgs("-blockfilterindex")) {
+            BlockFilterType filter_type;
+            if (!BlockFilterTypeByName(name, filter_type)) {
+                return InitError(strprintf(_("Unknown -blockfilterindex value %s."), name));
+            }
+            g_enabled_filter_types.insert(filter_type);
+        }
+    }
+
+    // Signal NODE_COMPACT_FILTERS if peerblockfilters and basic filters index are both enabled.
+    if (gArgs.GetBoolArg("-peerblockfilters", DEFAULT_PEERBLOCKFILTERS)) {
+        if (g_enabled_filter_types.count(BlockFilterType::BASIC_FILTER) != 1) {
+            return InitError(_("Cannot set -peerblockfilters without -blockfilterindex."));
+        }
+
+        nLocalServices = ServiceFlags(nLocalServices | NODE_COMPACT_FILTERS);
+    }
+
     // if using block pruning, then disallow txindex and require disabling governance validation
     if (gArgs.GetArg("-prune", 0)) {
         if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX))
             return InitError(_("Prune mode is incompatible with -txindex."));
+        if (!g_enabled_filter_types.empty()) {
+            return InitError(_("Prune mode is incompatible with -blockfilterindex."));
+        }
+        // the blocks must stay on disk until the indexes processed them
+        if (gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) || gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) ||
+                gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX))
+            return InitError(_("Prune mode is incompatible with -addressindex, -spentindex and -timestampindex."));
         if (!gArgs.GetBoolArg("-disablegovernance", false)) {
             return InitError(_("Prune mode is incompatible with -disablegovernance=false."));
         }
@@ -1276,6 +1450,9 @@ bool AppInitParameterInteraction()
     }
     fCheckBlockIndex = gArgs.GetBoolArg("-checkblockindex", chainparams.DefaultConsistencyChecks());
     fCheckpointsEnabled = gArgs.GetBoolArg("-checkpoints", DEFAULT_CHECKPOINTS_ENABLED);
+    fAddressIndex = gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
+    fSpentIndex = gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX);
+    fTimestampIndex = gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
 
     hashAssumeValid = uint256S(gArgs.GetArg("-assumevalid", chainparams.GetConsensus().defaultAssumeValid.GetHex()));
     if (!hashAssumeValid.IsNull())
@@ -1302,6 +1479,10 @@ bool AppInitParameterInteraction()
     int64_t nMempoolSizeMin = gArgs.GetArg("-limitdescendantsize", DEFAULT_DESCENDANT_SIZE_LIMIT) * 1000 * 40;
     if (nMempoolSizeMax < 0 || nMempoolSizeMax < nMempoolSizeMin)
         return InitError(strprintf(_("-maxmempool must be at least %d MB"), std::ceil(nMempoolSizeMin / 1000000.0)));
+    int64_t nRelayCacheSizeMax = gArgs.GetArg("-maxrelaycache", DEFAULT_MAX_RELAY_CACHE_SIZE) * 1000000;
+    if (nRelayCacheSizeMax < 0)
+        return InitError(_("-maxrelaycache must not be negative"));
+    txRelayCache.SetMaxBytes(nRelayCacheSizeMax);
     // incremental relay fee sets the minimum feerate increase necessary for BIP 125 replacement in the mempool
     // and the amount the mempool min fee increases above the feerate of txs evicted due to mempool limiting.
     if (gArgs.IsArgSet("-incrementalrelayfee"))
@@ -1321,6 +1502,18 @@ bool AppInitParameterInteraction()
     else if (nScriptCheckThreads > MAX_SCRIPTCHECK_THREADS)
         nScriptCheckThreads = MAX_SCRIPTCHECK_THREADS;
 
+    int nCoinsPrefetchThreads = gArgs.GetArg("-coinsprefetchthreads", DEFAULT_COINS_PREFETCH_THREADS);
+    if (nCoinsPrefetchThreads < 0 || nCoinsPrefetchThreads > MAX_COINS_PREFETCH_THREADS) {
+        return InitError(strprintf(_("Invalid -coinsprefetchthreads (%d) specified. Must be between 0 and %d"), nCoinsPrefetchThreads, MAX_COINS_PREFETCH_THREADS));
+    }
+
+    for (const std::string& strArg : gArgs.GetArgs("-dbtune")) {
+        CDBOptions dbOptions;
+        if (!ApplyDBTuneArg(strArg, "", dbOptions)) {
+            return InitError(strprintf(_("Invalid -dbtune ('%s') specified. Must be <db>:<option>=<n>"), strArg));
+        }
+    }
+
     // block pruning; get the amount of disk space (in MiB) to allot for block & undo files
     int64_t nPruneArg = gArgs.GetArg("-prune", 0);
     if (nPruneArg < 0) {
@@ -1578,6 +1771,21 @@ bool AppInitParameterInteraction()
         return InitError("LLMQ test params can only be overridden on regtest.");
     }
 
+    if (gArgs.IsArgSet("-assumeutxo")) {
+        if (chainparams.NetworkIDString() != CBaseChainParams::REGTEST) {
+            return InitError("Snapshot hashes can only be added on regtest.");
+        }
+        for (const std::string& s : gArgs.GetArgs("-assumeutxo")) {
+            std::vector<std::string> v;
+            boost::split(v, s, boost::is_any_of(":"));
+            int nHeight;
+            if (v.size() != 3 || !ParseInt32(v[0], &nHeight) || nHeight < 0 || !IsHex(v[1]) || v[1].size() != 64 || !IsHex(v[2]) || v[2].size() != 64) {
+                return InitError(strprintf("Invalid -assumeutxo specified (%s)", s));
+            }
+            UpdateAssumeutxoData(nHeight, AssumeutxoData{uint256S(v[1]), uint256S(v[2])});
+        }
+    }
+
     try {
         const bool fRecoveryEnabled{llmq::CLLMQUtils::QuorumDataRecoveryEnabled()};
         const bool fQuorumVvecRequestsEnabled{llmq::CLLMQUtils::GetEnabledQuorumVvecSyncEntries().size() > 0};
@@ -1652,6 +1860,8 @@ bool AppInitSanityChecks()
     // Initialize elliptic curve code
     std::string sha256_algo = SHA256AutoDetect();
     LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    std::string x11_algo = X11AutoDetect();
+    LogPrintf("Using the '%s' X11 implementation\n", x11_algo);
     RandomInit();
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -1695,6 +1905,9 @@ bool AppInitMain()
         if (!OpenDebugLog()) {
             return InitError(strprintf("Could not open debug log file %s", GetDebugLogPath().string()));
         }
+        if (gArgs.GetBoolArg("-logasync", DEFAULT_LOGASYNC)) {
+            StartAsyncLogging();
+        }
     }
 
     if (!fLogTimestamps)
@@ -1720,6 +1933,18 @@ bool AppInitMain()
     if (nScriptCheckThreads) {
         for (int i=0; i<nScriptCheckThreads-1; i++)
             threadGroup.create_thread(&ThreadScriptCheck);
+        // also used to hash headers in parallel during headers sync
+        for (int i=0; i<nScriptCheckThreads-1; i++)
+            threadGroup.create_thread(&ThreadHeaderHashCheck);
+        // and to read the inputs of a block from the coins database in parallel before connecting it
+        for (int i=0; i<nScriptCheckThreads-1; i++)
+            threadGroup.create_thread(&ThreadCoinPrefetch);
+        // and to check the transactions of large blocks in CheckBlock
+        for (int i=0; i<nScriptCheckThreads-1; i++)
+            threadGroup.create_thread(&ThreadTransactionCheck);
+        // and to verify the signatures of the quorum commitments of a block
+        for (int i=0; i<nScriptCheckThreads-1; i++)
+            threadGroup.create_thread(&llmq::ThreadCommitmentSigCheck);
     }
 
     std::vector<std::string> vSporkAddresses;
@@ -1749,8 +1974,14 @@ bool AppInitMain()
     // Start the lightweight task scheduler thread
     CScheduler::Function serviceLoop = boost::bind(&CScheduler::serviceQueue, &scheduler);
     threadGroup.create_thread(boost::bind(&TraceThread<CScheduler::Function>, "scheduler", serviceLoop));
-
-    GetMainSignals().RegisterBackgroundSignalScheduler(scheduler);
+    CScheduler::Function serviceLoopHighPriority = boost::bind(&CScheduler::serviceQueue, &schedulerHighPriority);
+    threadGroup.create_thread(boost::bind(&TraceThread<CScheduler::Function>, "signals", serviceLoopHighPriority));
+    CScheduler::Function serviceLoopMaintenance = boost::bind(&CScheduler::serviceQueue, &schedulerMaintenance);
+    threadGroup.create_thread(boost::bind(&TraceThread<CScheduler::Function>, "maint", serviceLoopMaintenance));
+    CScheduler::Function serviceLoopIO = boost::bind(&CScheduler::serviceQueue, &schedulerIO);
+    threadGroup.create_thread(boost::bind(&TraceThread<CScheduler::Function>, "io", serviceLoopIO));
+
+    GetMainSignals().RegisterBackgroundSignalScheduler(scheduler, &schedulerHighPriority);
     GetMainSignals().RegisterWithMempoolSignals(mempool);
 
     tableRPC.InitPlatformRestrictions();
@@ -1794,7 +2025,7 @@ bool AppInitMain()
     CConnman& connman = *g_connman;
 
     peerLogic.reset(new PeerLogicValidation(&connman, scheduler, gArgs.GetBoolArg("-enablebip61", DEFAULT_ENABLE_BIP61)));
-    RegisterValidationInterface(peerLogic.get());
+    RegisterValidationInterface(peerLogic.get(), ValidationInterfacePriority::HIGH);
 
     // sanitize comments per BIP-0014, format user agent and check total size
     std::vector<std::string> uacomments;
@@ -1897,7 +2128,7 @@ bool AppInitMain()
 #endif
 
     pdsNotificationInterface = new CDSNotificationInterface(connman);
-    RegisterValidationInterface(pdsNotificationInterface);
+    RegisterValidationInterface(pdsNotificationInterface, ValidationInterfacePriority::HIGH);
 
     uint64_t nMaxOutboundLimit = 0; //unlimited unless -maxuploadtarget is set
     uint64_t nMaxOutboundTimeframe = MAX_UPLOAD_TIMEFRAME;
@@ -1926,14 +2157,36 @@ bool AppInitMain()
     int64_t nBlockTreeDBCache = nTotalCache / 8;
     nBlockTreeDBCache = std::min(nBlockTreeDBCache, (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxBlockDBAndTxIndexCache : nMaxBlockDBCache) << 20);
     nTotalCache -= nBlockTreeDBCache;
+    int nExtraIndexes = (int)fAddressIndex + (int)fSpentIndex + (int)fTimestampIndex;
+    int64_t nExtraIndexCache = nExtraIndexes > 0 ? std::min(nTotalCache / 8, nMaxExtraIndexCache << 20) : 0;
+    nTotalCache -= nExtraIndexCache;
+    int64_t filter_index_cache = 0;
+    if (!g_enabled_filter_types.empty()) {
+        size_t n_indexes = g_enabled_filter_types.size();
+        int64_t max_cache = std::min(nTotalCache / 8, nMaxFilterIndexCache << 20);
+        filter_index_cache = max_cache / n_indexes;
+        nTotalCache -= filter_index_cache * n_indexes;
+    }
     int64_t nCoinDBCache = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
     nCoinDBCache = std::min(nCoinDBCache, nMaxCoinsDBCache << 20); // cap total coins db cache
     nTotalCache -= nCoinDBCache;
     nCoinCacheUsage = nTotalCache; // the rest goes to in-memory cache
+    int64_t nCoinCacheKeepPercent = gArgs.GetArg("-dbcachekeep", DEFAULT_COINS_CACHE_KEEP_PERCENT);
+    if (nCoinCacheKeepPercent < 0 || nCoinCacheKeepPercent > MAX_COINS_CACHE_KEEP_PERCENT) {
+        return InitError(strprintf(_("Invalid -dbcachekeep (%d) specified. Must be between 0 and %d"), nCoinCacheKeepPercent, MAX_COINS_CACHE_KEEP_PERCENT));
+    }
+    nCoinCacheKeepUsage = nCoinCacheUsage * nCoinCacheKeepPercent / 100;
     int64_t nMempoolSizeMax = gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
     int64_t nEvoDbCache = 1024 * 1024 * 16; // TODO
     LogPrintf("Cache configuration:\n");
     LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
+    if (nExtraIndexes > 0) {
+        LogPrintf("* Using %.1fMiB for address, spent and timestamp index databases\n", nExtraIndexCache * (1.0 / 1024 / 1024));
+    }
+    for (BlockFilterType filter_type : g_enabled_filter_types) {
+        LogPrintf("* Using %.1f MiB for %s block filter index database\n",
+                  filter_index_cache * (1.0 / 1024 / 1024), BlockFilterTypeName(filter_type));
+    }
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set (plus up to %.1fMiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
 
@@ -2007,24 +2260,6 @@ bool AppInitMain()
                     break;
                 }
 
-                // Check for changed -addressindex state
-                if (fAddressIndex != gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
-                    strLoadError = _("You need to rebuild the database using -reindex to change -addressindex");
-                    break;
-                }
-
-                // Check for changed -timestampindex state
-                if (fTimestampIndex != gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX)) {
-                    strLoadError = _("You need to rebuild the database using -reindex to change -timestampindex");
-                    break;
-                }
-
-                // Check for changed -spentindex state
-                if (fSpentIndex != gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX)) {
-                    strLoadError = _("You need to rebuild the database using -reindex to change -spentindex");
-                    break;
-                }
-
                 // Check for changed -prune state.  What we are concerned about is a user who has pruned blocks
                 // in the past, but is now trying to run unpruned.
                 if (fHavePruned && !fPruneMode) {
@@ -2153,12 +2388,53 @@ bool AppInitMain()
         return false;
     }
 
+    if (gArgs.GetBoolArg("-utxocommitment", DEFAULT_UTXO_COMMITMENT)) {
+        uiInterface.InitMessage(_("Loading UTXO set commitment..."));
+        if (!LoadCoinsCommitment()) {
+            return InitError(_("Error loading the UTXO set commitment"));
+        }
+    }
+
+    if (gArgs.GetBoolArg("-dbbackgroundwrite", DEFAULT_DB_BACKGROUND_WRITE)) {
+        pcoinsdbview->StartBackgroundWrites();
+    }
+    coinsPrefetcher.Start(pcoinsdbview.get(), gArgs.GetArg("-coinsprefetchthreads", DEFAULT_COINS_PREFETCH_THREADS));
+
+    // The additional indexes are built in the background and catch up with the chain on their own, so they can be
+    // enabled at any time. -reindex rebuilds them.
+    if (fAddressIndex) {
+        g_addressindex = MakeUnique<AddressIndex>(nExtraIndexCache / nExtraIndexes, false, fReindex);
+        if (!g_addressindex->Start()) {
+            return InitError(strprintf(_("Error loading the address index, delete %s to rebuild it"), (GetDataDir() / "indexes" / "address").string()));
+        }
+    }
+    if (fSpentIndex) {
+        g_spentindex = MakeUnique<SpentIndex>(nExtraIndexCache / nExtraIndexes, false, fReindex);
+        if (!g_spentindex->Start()) {
+            return InitError(strprintf(_("Error loading the spent index, delete %s to rebuild it"), (GetDataDir() / "indexes" / "spent").string()));
+        }
+    }
+    if (fTimestampIndex) {
+        g_timestampindex = MakeUnique<TimestampIndex>(nExtraIndexCache / nExtraIndexes, false, fReindex);
+        if (!g_timestampindex->Start()) {
+            return InitError(strprintf(_("Error loading the timestamp index, delete %s to rebuild it"), (GetDataDir() / "indexes" / "timestamp").string()));
+        }
+    }
+    for (const auto& filter_type : g_enabled_filter_types) {
+        InitBlockFilterIndex(filter_type, filter_index_cache, false, fReindex);
+        if (!GetBlockFilterIndex(filter_type)->Start()) {
+            return InitError(strprintf(_("Error loading the %s block filter index, delete %s to rebuild it"), BlockFilterTypeName(filter_type),
+                                       (GetDataDir() / "indexes" / "blockfilter" / BlockFilterTypeName(filter_type)).string()));
+        }
+    }
+
     fs::path est_path = GetDataDir() / FEE_ESTIMATES_FILENAME;
     CAutoFile est_filein(fsbridge::fopen(est_path, "rb"), SER_DISK, CLIENT_VERSION);
     // Allowed to fail as this file IS missing on first startup.
     if (!est_filein.IsNull())
         ::feeEstimator.Read(est_filein);
     fFeeEstimatesInitialized = true;
+    schedulerIO.scheduleEvery(WriteFeeEstimates, FEE_ESTIMATES_WRITE_INTERVAL * 1000, "feeestimates");
 
     // ********************************************************* Step 8: load wallet
     if (!g_wallet_init_interface.Open()) return false;
@@ -2211,7 +2487,7 @@ bool AppInitMain()
     if(fMasternodeMode) {
         // Create and register activeMasternodeManager, will init later in ThreadImport
         activeMasternodeManager = new CActiveMasternodeManager();
-        RegisterValidationInterface(activeMasternodeManager);
+        RegisterValidationInterface(activeMasternodeManager, ValidationInterfacePriority::HIGH);
     }
 
     if (activeMasternodeInfo.blsKeyOperator == nullptr) {
@@ -2257,6 +2533,8 @@ bool AppInitMain()
 
     strDBName = "governance.dat";
     uiInterface.InitMessage(_("Loading governance cache..."));
+    // votes are stored separately and are only valid together with the objects from governance.dat
+    governanceDB = new CGovernanceDB(false, !fLoadCacheFiles || fDisableGovernance);
     CFlatDB<CGovernanceManager> flatdb3(strDBName, "magicGovernanceCache");
     if (fLoadCacheFiles && !fDisableGovernance) {
         if(!flatdb3.Load(governance)) {
@@ -2286,21 +2564,25 @@ bool AppInitMain()
 
     // ********************************************************* Step 10c: schedule Dash-specific tasks
 
-    scheduler.scheduleEvery(std::bind(&CNetFulfilledRequestManager::DoMaintenance, std::ref(netfulfilledman)), 60 * 1000);
-    scheduler.scheduleEvery(std::bind(&CMasternodeSync::DoMaintenance, std::ref(masternodeSync), std::ref(*g_connman)), 1 * 1000);
-    scheduler.scheduleEvery(std::bind(&CMasternodeUtils::DoMaintenance, std::ref(*g_connman)), 1 * 1000);
+    // Sync ticks and masternode connections stay on the main scheduler, the
+    // slower cleanup tasks get their own thread.
+    scheduler.scheduleEvery(std::bind(&CMasternodeSync::DoMaintenance, std::ref(masternodeSync), std::ref(*g_connman)), 1 * 1000, "mnsync");
+    scheduler.scheduleEvery(std::bind(&CMasternodeUtils::DoMaintenance, std::ref(*g_connman)), 1 * 1000, "mnutils");
+    schedulerMaintenance.scheduleEvery(std::bind(&CNetFulfilledRequestManager::DoMaintenance, std::ref(netfulfilledman)), 60 * 1000, "netfulfilled");
+    schedulerMaintenance.scheduleEvery(std::bind(&CDeterministicMNManager::DoMaintenance, std::ref(*deterministicMNManager)), 60 * 1000, "dmnman");
 
     if (!fDisableGovernance) {
-        scheduler.scheduleEvery(std::bind(&CGovernanceManager::DoMaintenance, std::ref(governance), std::ref(*g_connman)), 60 * 5 * 1000);
+        schedulerMaintenance.scheduleEvery(std::bind(&CGovernanceManager::DoMaintenance, std::ref(governance), std::ref(*g_connman)), 60 * 5 * 1000, "governance");
+        schedulerMaintenance.scheduleEvery(std::bind(&CGovernanceManager::ProcessPendingVotes, std::ref(governance), std::ref(*g_connman)), 1 * 1000, "governancevotes");
     }
 
     if (fMasternodeMode) {
-        scheduler.scheduleEvery(std::bind(&CCoinJoinServer::DoMaintenance, std::ref(coinJoinServer), std::ref(*g_connman)), 1 * 1000);
+        schedulerMaintenance.scheduleEvery(std::bind(&CCoinJoinServer::DoMaintenance, std::ref(coinJoinServer), std::ref(*g_connman)), 1 * 1000, "coinjoinserver");
     }
 
     if (gArgs.GetBoolArg("-statsenabled", DEFAULT_STATSD_ENABLE)) {
         int nStatsPeriod = std::min(std::max((int)gArgs.GetArg("-statsperiod", DEFAULT_STATSD_PERIOD), MIN_STATSD_PERIOD), MAX_STATSD_PERIOD);
-        scheduler.scheduleEvery(PeriodicStats, nStatsPeriod * 1000);
+        schedulerMaintenance.scheduleEvery(PeriodicStats, nStatsPeriod * 1000, "stats");
     }
 
     llmq::StartLLMQSystem();
@@ -2441,16 +2723,43 @@ bool AppInitMain()
         return InitError(strprintf(_("Invalid -socketevents ('%s') specified. Only these modes are supported: %s"), strSocketEventsMode, GetSupportedSocketEventsStr()));
     }
 
-    if (!connman.Start(scheduler, connOptions)) {
+    connOptions.nSocketThreads = gArgs.GetArg("-socketthreads", DEFAULT_SOCKET_THREADS);
+    if (connOptions.nSocketThreads < 0 || connOptions.nSocketThreads > MAX_SOCKET_THREADS) {
+        return InitError(strprintf(_("Invalid -socketthreads (%d) specified. Must be between 0 and %d"), connOptions.nSocketThreads, MAX_SOCKET_THREADS));
+    }
+
+    connOptions.nMessageWorkerThreads = gArgs.GetArg("-msgworkerthreads", DEFAULT_MESSAGE_WORKER_THREADS);
+    if (connOptions.nMessageWorkerThreads < 0 || connOptions.nMessageWorkerThreads > MAX_MESSAGE_WORKER_THREADS) {
+        return InitError(strprintf(_("Invalid -msgworkerthreads (%d) specified. Must be between 0 and %d"), connOptions.nMessageWorkerThreads, MAX_MESSAGE_WORKER_THREADS));
+    }
+
+    connOptions.fLowLatency = gArgs.GetBoolArg("-lowlatency", DEFAULT_LOW_LATENCY);
+
+    connOptions.nBlockReadThreads = gArgs.GetArg("-blockreadthreads", DEFAULT_BLOCK_READ_THREADS);
+    if (connOptions.nBlockReadThreads < 0 || connOptions.nBlockReadThreads > MAX_BLOCK_READ_THREADS) {
+        return InitError(strprintf(_("Invalid -blockreadthreads (%d) specified. Must be between 0 and %d"), connOptions.nBlockReadThreads, MAX_BLOCK_READ_THREADS));
+    }
+
+    if (!connman.Start(schedulerIO, connOptions)) {
         return false;
     }
 
+    int nCheckBlocksBackground = gArgs.GetArg("-checkblocksbackground", DEFAULT_CHECKBLOCKS_BACKGROUND);
+    if (nCheckBlocksBackground != 0 && !fReindex) {
+        int nCheckLevelBackground = gArgs.GetArg("-checkblocksbackgroundlevel", DEFAULT_CHECKLEVEL_BACKGROUND);
+        if (nCheckLevelBackground < 0 || nCheckLevelBackground > 2) {
+            return InitError(strprintf(_("Invalid -checkblocksbackgroundlevel (%d) specified. Must be between 0 and %d"), nCheckLevelBackground, 2));
+        }
+        std::function<void()> verifyDB = std::bind(&ThreadVerifyDB, nCheckLevelBackground, std::max(0, nCheckBlocksBackground), gArgs.GetBoolArg("-checkblocksbackgroundfatal", false));
+        threadGroup.create_thread(boost::bind(&TraceThread<std::function<void()>>, "verifydb", verifyDB));
+    }
+
     // ********************************************************* Step 13: finished
 
     SetRPCWarmupFinished();
     uiInterface.InitMessage(_("Done loading"));
 
-    g_wallet_init_interface.Start(scheduler);
+    g_wallet_init_interface.Start(schedulerMaintenance);
 
     return true;
 }
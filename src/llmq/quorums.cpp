@@ -26,6 +26,7 @@ namespace llmq
 
 static const std::string DB_QUORUM_SK_SHARE = "q_Qsk";
 static const std::string DB_QUORUM_QUORUM_VVEC = "q_Qqvvec";
+static const std::string DB_QUORUM_PUBKEY_SHARES = "q_Qpks";
 
 CQuorumManager* quorumManager;
 
@@ -43,11 +44,18 @@ static uint256 MakeQuorumKey(const CQuorum& q)
     return hw.GetHash();
 }
 
-CQuorum::CQuorum(const Consensus::LLMQParams& _params, CBLSWorker& _blsWorker) : params(_params), blsCache(_blsWorker)
+CQuorum::CQuorum(const Consensus::LLMQParams& _params, CBLSWorker& _blsWorker) : params(_params), blsWorker(_blsWorker)
 {
 }
 
-CQuorum::~CQuorum() = default;
+CQuorum::~CQuorum()
+{
+    if (pubKeyShares) {
+        for (size_t i = 0; i < members.size(); i++) {
+            delete pubKeyShares[i].load();
+        }
+    }
+}
 
 void CQuorum::Init(const CFinalCommitment& _qc, const CBlockIndex* _pindexQuorum, const uint256& _minedBlockHash, const std::vector<CDeterministicMNCPtr>& _members)
 {
@@ -55,6 +63,18 @@ void CQuorum::Init(const CFinalCommitment& _qc, const CBlockIndex* _pindexQuorum
     pindexQuorum = _pindexQuorum;
     members = _members;
     minedBlockHash = _minedBlockHash;
+
+    memberIds.clear();
+    memberIds.reserve(members.size());
+    for (const auto& dmn : members) {
+        memberIds.emplace_back(dmn->proTxHash);
+    }
+
+    assert(pubKeyShares == nullptr);
+    pubKeyShares.reset(new std::atomic<const CBLSPublicKey*>[members.size()]);
+    for (size_t i = 0; i < members.size(); i++) {
+        pubKeyShares[i] = nullptr;
+    }
 }
 
 bool CQuorum::SetVerificationVector(const BLSVerificationVector& quorumVecIn)
@@ -95,13 +115,38 @@ bool CQuorum::IsValidMember(const uint256& proTxHash) const
     return false;
 }
 
+const CBLSId& CQuorum::GetMemberId(size_t memberIdx) const
+{
+    assert(memberIdx < memberIds.size());
+    return memberIds[memberIdx];
+}
+
 CBLSPublicKey CQuorum::GetPubKeyShare(size_t memberIdx) const
 {
     if (quorumVvec == nullptr || memberIdx >= members.size() || !qc.validMembers[memberIdx]) {
         return CBLSPublicKey();
     }
-    auto& m = members[memberIdx];
-    return blsCache.BuildPubKeyShare(m->proTxHash, quorumVvec, CBLSId(m->proTxHash));
+    const CBLSPublicKey* pubKeyShare = pubKeyShares[memberIdx].load(std::memory_order_acquire);
+    if (pubKeyShare != nullptr) {
+        return *pubKeyShare;
+    }
+    // concurrent callers might compute the same share, but only one of the results is kept
+    CBLSPublicKey built = blsWorker.BuildPubKeyShare(quorumVvec, memberIds[memberIdx]);
+    if (!built.IsValid()) {
+        return built;
+    }
+    return SetPubKeyShare(memberIdx, built);
+}
+
+const CBLSPublicKey& CQuorum::SetPubKeyShare(size_t memberIdx, const CBLSPublicKey& pubKeyShare) const
+{
+    auto* newShare = new CBLSPublicKey(pubKeyShare);
+    const CBLSPublicKey* expected = nullptr;
+    if (!pubKeyShares[memberIdx].compare_exchange_strong(expected, newShare, std::memory_order_acq_rel)) {
+        delete newShare;
+        return *expected;
+    }
+    return *newShare;
 }
 
 const CBLSSecretKey& CQuorum::GetSkShare() const
@@ -149,13 +194,46 @@ bool CQuorum::ReadContributions(CEvoDB& evoDb)
     return true;
 }
 
+void CQuorum::WritePubKeyShares(CEvoDB& evoDb) const
+{
+    if (quorumVvec == nullptr) {
+        return;
+    }
+
+    // invalid members get an invalid public key so that the indexes match the member indexes
+    std::vector<CBLSPublicKey> pubKeyShares(members.size());
+    for (size_t i = 0; i < members.size(); i++) {
+        if (qc.validMembers[i]) {
+            pubKeyShares[i] = GetPubKeyShare(i);
+        }
+    }
+    evoDb.GetRawDB().Write(std::make_pair(DB_QUORUM_PUBKEY_SHARES, MakeQuorumKey(*this)), pubKeyShares);
+}
+
+bool CQuorum::ReadPubKeyShares(CEvoDB& evoDb)
+{
+    if (quorumVvec == nullptr) {
+        return false;
+    }
+
+    std::vector<CBLSPublicKey> pubKeyShares;
+    if (!evoDb.Read(std::make_pair(DB_QUORUM_PUBKEY_SHARES, MakeQuorumKey(*this)), pubKeyShares) || pubKeyShares.size() != members.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < members.size(); i++) {
+        if (qc.validMembers[i] && pubKeyShares[i].IsValid()) {
+            SetPubKeyShare(i, pubKeyShares[i]);
+        }
+    }
+    return true;
+}
+
 CQuorumManager::CQuorumManager(CEvoDB& _evoDb, CBLSWorker& _blsWorker, CDKGSessionManager& _dkgManager) :
     evoDb(_evoDb),
     blsWorker(_blsWorker),
     dkgManager(_dkgManager)
 {
     CLLMQUtils::InitQuorumsCache(mapQuorumsCache);
-    CLLMQUtils::InitQuorumsCache(scanQuorumsCache);
     quorumThreadInterrupt.reset();
 }
 
@@ -170,16 +248,23 @@ void CQuorumManager::Start()
     workerCount = std::max(std::min(1, workerCount), 4);
     workerPool.resize(workerCount);
     RenameThreadPool(workerPool, "dash-q-mngr");
+
+    if (!recoveryThread.joinable()) {
+        recoveryThread = std::thread(&TraceThread<std::function<void()> >, "q-recovery", std::function<void()>(std::bind(&CQuorumManager::QuorumDataRecoveryThread, this)));
+    }
 }
 
 void CQuorumManager::Stop()
 {
     quorumThreadInterrupt();
+    if (recoveryThread.joinable()) {
+        recoveryThread.join();
+    }
     workerPool.clear_queue();
     workerPool.stop(true);
 }
 
-void CQuorumManager::TriggerQuorumDataRecoveryThreads(const CBlockIndex* pIndex) const
+void CQuorumManager::TriggerQuorumDataRecoveries(const CBlockIndex* pIndex) const
 {
     if (!fMasternodeMode || !CLLMQUtils::QuorumDataRecoveryEnabled() || pIndex == nullptr) {
         return;
@@ -203,8 +288,8 @@ void CQuorumManager::TriggerQuorumDataRecoveryThreads(const CBlockIndex* pIndex)
         }
 
         for (const auto& pQuorum : vecQuorums) {
-            // If there is already a thread running for this specific quorum skip it
-            if (pQuorum->fQuorumDataRecoveryThreadRunning) {
+            // If there is already a recovery scheduled for this specific quorum skip it
+            if (pQuorum->fQuorumDataRecoveryScheduled) {
                 continue;
             }
 
@@ -228,8 +313,8 @@ void CQuorumManager::TriggerQuorumDataRecoveryThreads(const CBlockIndex* pIndex)
                 continue;
             }
 
-            // Finally start the thread which triggers the requests for this quorum
-            StartQuorumDataRecoveryThread(pQuorum, pIndex, nDataMask);
+            // Finally queue the recovery which triggers the requests for this quorum
+            ScheduleQuorumDataRecovery(pQuorum, pIndex, nDataMask);
         }
     }
 }
@@ -257,7 +342,7 @@ void CQuorumManager::UpdatedBlockTip(const CBlockIndex* pindexNew, bool fInitial
         }
     }
 
-    TriggerQuorumDataRecoveryThreads(pindexNew);
+    TriggerQuorumDataRecoveries(pindexNew);
 }
 
 void CQuorumManager::EnsureQuorumConnections(Consensus::LLMQType llmqType, const CBlockIndex* pindexNew) const
@@ -315,7 +400,7 @@ CQuorumPtr CQuorumManager::BuildQuorumFromCommitment(const Consensus::LLMQType l
         }
     }
 
-    if (hasValidVvec) {
+    if (hasValidVvec && !quorum->ReadPubKeyShares(evoDb)) {
         // pre-populate caches in the background
         // recovering public key shares is quite expensive and would result in serious lags for the first few signing
         // sessions if the shares would be calculated on-demand
@@ -416,38 +501,11 @@ std::vector<CQuorumCPtr> CQuorumManager::ScanQuorums(Consensus::LLMQType llmqTyp
         return {};
     }
 
-    bool fCacheExists{false};
-    void* pIndexScanCommitments{(void*)pindexStart};
-    size_t nScanCommitments{nCountRequested};
-    std::vector<CQuorumCPtr> vecResultQuorums;
+    // The block processor keeps an index of mined commitments by height, so this doesn't need to hit the DB
+    auto quorumIndexes = quorumBlockProcessor->GetMinedCommitmentsUntilBlock(llmqType, pindexStart, nCountRequested);
 
-    {
-        LOCK(quorumsCacheCs);
-        auto& cache = scanQuorumsCache[llmqType];
-        fCacheExists = cache.get(pindexStart->GetBlockHash(), vecResultQuorums);
-        if (fCacheExists) {
-            // We have exactly what requested so just return it
-            if (vecResultQuorums.size() == nCountRequested) {
-                return vecResultQuorums;
-            }
-            // If we have more cached than requested return only a subvector
-            if (vecResultQuorums.size() > nCountRequested) {
-                return {vecResultQuorums.begin(), vecResultQuorums.begin() + nCountRequested};
-            }
-            // If we have cached quorums but not enough, subtract what we have from the count and the set correct index where to start
-            // scanning for the rests
-            if(vecResultQuorums.size() > 0) {
-                nScanCommitments -= vecResultQuorums.size();
-                pIndexScanCommitments = (void*)vecResultQuorums.back()->pindexQuorum->pprev;
-            }
-        } else {
-            // If there is nothing in cache request at least cache.max_size() because this gets cached then later
-            nScanCommitments = std::max(nCountRequested, cache.max_size());
-        }
-    }
-    // Get the block indexes of the mined commitments to build the required quorums from
-    auto quorumIndexes = quorumBlockProcessor->GetMinedCommitmentsUntilBlock(llmqType, (const CBlockIndex*)pIndexScanCommitments, nScanCommitments);
-    vecResultQuorums.reserve(vecResultQuorums.size() + quorumIndexes.size());
+    std::vector<CQuorumCPtr> vecResultQuorums;
+    vecResultQuorums.reserve(quorumIndexes.size());
 
     for (auto& quorumIndex : quorumIndexes) {
         assert(quorumIndex);
@@ -455,18 +513,7 @@ std::vector<CQuorumCPtr> CQuorumManager::ScanQuorums(Consensus::LLMQType llmqTyp
         assert(quorum != nullptr);
         vecResultQuorums.emplace_back(quorum);
     }
-
-    size_t nCountResult{vecResultQuorums.size()};
-    if (nCountResult > 0 && !fCacheExists) {
-        LOCK(quorumsCacheCs);
-        // Don't cache more than cache.max_size() elements
-        auto& cache = scanQuorumsCache[llmqType];
-        size_t nCacheEndIndex = std::min(nCountResult, cache.max_size());
-        cache.emplace(pindexStart->GetBlockHash(), {vecResultQuorums.begin(), vecResultQuorums.begin() + nCacheEndIndex});
-    }
-    // Don't return more than nCountRequested elements
-    size_t nResultEndIndex = std::min(nCountResult, nCountRequested);
-    return {vecResultQuorums.begin(), vecResultQuorums.begin() + nResultEndIndex};
+    return vecResultQuorums;
 }
 
 CQuorumCPtr CQuorumManager::GetQuorum(Consensus::LLMQType llmqType, const uint256& quorumHash) const
@@ -669,7 +716,10 @@ void CQuorumManager::ProcessMessage(CNode* pFrom, const std::string& strCommand,
             BLSVerificationVector verficationVector;
             vRecv >> verficationVector;
 
-            if (pQuorum->SetVerificationVector(verficationVector)) {
+            if (pQuorum->quorumVvec != nullptr) {
+                // we ask multiple members at once, so the data might already be there
+                LogPrint(BCLog::LLMQ, "CQuorumManager::%s -- quorumVvec already known, peer=%d\n", __func__, pFrom->GetId());
+            } else if (pQuorum->SetVerificationVector(verficationVector)) {
                 StartCachePopulatorThread(pQuorum);
             } else {
                 errorHandler("Invalid quorum verification vector");
@@ -694,13 +744,15 @@ void CQuorumManager::ProcessMessage(CNode* pFrom, const std::string& strCommand,
             std::vector<CBLSIESEncryptedObject<CBLSSecretKey>> vecEncrypted;
             vRecv >> vecEncrypted;
 
+            if (pQuorum->skShare.IsValid()) {
+                LogPrint(BCLog::LLMQ, "CQuorumManager::%s -- skShare already known, peer=%d\n", __func__, pFrom->GetId());
+                return;
+            }
+
             BLSSecretKeyVector vecSecretKeys;
-            vecSecretKeys.resize(vecEncrypted.size());
-            for (size_t i = 0; i < vecEncrypted.size(); ++i) {
-                if (!vecEncrypted[i].Decrypt(memberIdx, *activeMasternodeInfo.blsKeyOperator, vecSecretKeys[i], PROTOCOL_VERSION)) {
-                    errorHandler("Failed to decrypt");
-                    return;
-                }
+            if (!blsWorker.DecryptContributions(vecEncrypted, memberIdx, *activeMasternodeInfo.blsKeyOperator, PROTOCOL_VERSION, vecSecretKeys)) {
+                errorHandler("Failed to decrypt");
+                return;
             }
 
             CBLSSecretKey secretKeyShare = blsWorker.AggregateSecretKeys(vecSecretKeys);
@@ -716,7 +768,7 @@ void CQuorumManager::ProcessMessage(CNode* pFrom, const std::string& strCommand,
 
 void CQuorumManager::StartCachePopulatorThread(const CQuorumCPtr pQuorum) const
 {
-    if (pQuorum->quorumVvec == nullptr) {
+    if (pQuorum->quorumVvec == nullptr || CLLMQUtils::IsLazyPubKeySharesEnabled()) {
         return;
     }
 
@@ -730,125 +782,168 @@ void CQuorumManager::StartCachePopulatorThread(const CQuorumCPtr pQuorum) const
                 pQuorum->GetPubKeyShare(i);
             }
         }
+        if (!quorumThreadInterrupt) {
+            // all shares are cached now, so this only serializes them
+            pQuorum->WritePubKeyShares(evoDb);
+        }
         LogPrint(BCLog::LLMQ, "CQuorumManager::StartCachePopulatorThread -- done. time=%d\n", t.count());
     });
 }
 
-void CQuorumManager::StartQuorumDataRecoveryThread(const CQuorumCPtr pQuorum, const CBlockIndex* pIndex, uint16_t nDataMaskIn) const
+void CQuorumManager::ScheduleQuorumDataRecovery(const CQuorumCPtr pQuorum, const CBlockIndex* pIndex, uint16_t nDataMask) const
 {
-    if (pQuorum->fQuorumDataRecoveryThreadRunning) {
-        LogPrint(BCLog::LLMQ, "CQuorumManager::%s -- Already running\n", __func__);
+    if (pQuorum->fQuorumDataRecoveryScheduled.exchange(true)) {
+        LogPrint(BCLog::LLMQ, "CQuorumManager::%s -- Already scheduled\n", __func__);
         return;
     }
-    pQuorum->fQuorumDataRecoveryThreadRunning = true;
-
-    workerPool.push([pQuorum, pIndex, nDataMaskIn, this](int threadId) {
-        size_t nTries{0};
-        uint16_t nDataMask{nDataMaskIn};
-        int64_t nTimeLastSuccess{0};
-        uint256* pCurrentMemberHash{nullptr};
-        std::vector<uint256> vecMemberHashes;
-        const size_t nMyStartOffset{GetQuorumRecoveryStartOffset(pQuorum, pIndex)};
-        const int64_t nRequestTimeout{10};
-
-        auto printLog = [&](const std::string& strMessage) {
-            const std::string strMember{pCurrentMemberHash == nullptr ? "nullptr" : pCurrentMemberHash->ToString()};
-            LogPrint(BCLog::LLMQ, "CQuorumManager::StartQuorumDataRecoveryThread -- %s - for llmqType %d, quorumHash %s, nDataMask (%d/%d), pCurrentMemberHash %s, nTries %d\n",
-                strMessage, pQuorum->qc.llmqType, pQuorum->qc.quorumHash.ToString(), nDataMask, nDataMaskIn, strMember, nTries);
-        };
-        printLog("Start");
 
-        while (!masternodeSync.IsBlockchainSynced() && !quorumThreadInterrupt) {
-            quorumThreadInterrupt.sleep_for(std::chrono::seconds(nRequestTimeout));
-        }
+    QuorumDataRecovery recovery;
+    recovery.pQuorum = pQuorum;
+    recovery.pIndex = pIndex;
+    recovery.nDataMask = nDataMask;
+    recovery.nDataMaskIn = nDataMask;
 
-        if (quorumThreadInterrupt) {
-            printLog("Aborted");
-            return;
-        }
+    LOCK(cs_queuedRecoveries);
+    queuedRecoveries.emplace_back(std::move(recovery));
+}
+
+void CQuorumManager::QuorumDataRecoveryThread()
+{
+    while (!quorumThreadInterrupt) {
+        if (masternodeSync.IsBlockchainSynced()) {
+            {
+                LOCK(cs_queuedRecoveries);
+                while (activeRecoveries.size() < MAX_CONCURRENT_QUORUM_RECOVERIES && !queuedRecoveries.empty()) {
+                    activeRecoveries.splice(activeRecoveries.end(), queuedRecoveries, queuedRecoveries.begin());
+                    auto& recovery = activeRecoveries.back();
 
-        vecMemberHashes.reserve(pQuorum->qc.validMembers.size());
-        for (auto& member : pQuorum->members) {
-            if (pQuorum->IsValidMember(member->proTxHash) && member->proTxHash != activeMasternodeInfo.proTxHash) {
-                vecMemberHashes.push_back(member->proTxHash);
+                    for (auto& member : recovery.pQuorum->members) {
+                        if (recovery.pQuorum->IsValidMember(member->proTxHash) && member->proTxHash != activeMasternodeInfo.proTxHash) {
+                            recovery.vecMemberHashes.emplace_back(member->proTxHash);
+                        }
+                    }
+                    std::sort(recovery.vecMemberHashes.begin(), recovery.vecMemberHashes.end());
+                    recovery.nMyStartOffset = GetQuorumRecoveryStartOffset(recovery.pQuorum, recovery.pIndex);
+                    // Wait a bit depending on the start offset to balance out multiple requests to same masternode
+                    recovery.nStartTime = GetTimeMillis() + (int64_t)recovery.nMyStartOffset * 100;
+                }
+            }
+
+            for (auto it = activeRecoveries.begin(); it != activeRecoveries.end() && !quorumThreadInterrupt; ) {
+                if (ProcessQuorumDataRecovery(*it)) {
+                    ++it;
+                } else {
+                    it->pQuorum->fQuorumDataRecoveryScheduled = false;
+                    it = activeRecoveries.erase(it);
+                }
             }
         }
-        std::sort(vecMemberHashes.begin(), vecMemberHashes.end());
 
-        printLog("Try to request");
+        if (!quorumThreadInterrupt.sleep_for(std::chrono::seconds(1))) {
+            break;
+        }
+    }
+}
 
-        while (nDataMask > 0 && !quorumThreadInterrupt) {
+bool CQuorumManager::ProcessQuorumDataRecovery(QuorumDataRecovery& recovery)
+{
+    const auto& pQuorum = recovery.pQuorum;
+    auto& nDataMask = recovery.nDataMask;
 
-            if (nDataMask & llmq::CQuorumDataRequest::QUORUM_VERIFICATION_VECTOR && pQuorum->quorumVvec != nullptr) {
-                nDataMask &= ~llmq::CQuorumDataRequest::QUORUM_VERIFICATION_VECTOR;
-                printLog("Received quorumVvec");
-            }
+    auto printLog = [&](const std::string& strMessage, const uint256& memberHash = uint256()) {
+        LogPrint(BCLog::LLMQ, "CQuorumManager::ProcessQuorumDataRecovery -- %s - for llmqType %d, quorumHash %s, nDataMask (%d/%d), member %s, nTries %d, pending %d\n",
+            strMessage, pQuorum->qc.llmqType, pQuorum->qc.quorumHash.ToString(), nDataMask, recovery.nDataMaskIn, memberHash.ToString(), recovery.nTries, recovery.mapPendingMembers.size());
+    };
 
-            if (nDataMask & llmq::CQuorumDataRequest::ENCRYPTED_CONTRIBUTIONS && pQuorum->skShare.IsValid()) {
-                nDataMask &= ~llmq::CQuorumDataRequest::ENCRYPTED_CONTRIBUTIONS;
-                printLog("Received skShare");
-            }
+    if (GetTimeMillis() < recovery.nStartTime) {
+        return true;
+    }
 
-            if (nDataMask == 0) {
-                printLog("Success");
-                break;
+    if (nDataMask & llmq::CQuorumDataRequest::QUORUM_VERIFICATION_VECTOR && pQuorum->quorumVvec != nullptr) {
+        nDataMask &= ~llmq::CQuorumDataRequest::QUORUM_VERIFICATION_VECTOR;
+        printLog("Received quorumVvec");
+    }
+
+    if (nDataMask & llmq::CQuorumDataRequest::ENCRYPTED_CONTRIBUTIONS && pQuorum->skShare.IsValid()) {
+        nDataMask &= ~llmq::CQuorumDataRequest::ENCRYPTED_CONTRIBUTIONS;
+        printLog("Received skShare");
+    }
+
+    if (nDataMask == 0) {
+        // Stop waiting for the other members. Their responses are ignored if they still arrive
+        g_connman->ForEachNode([&](CNode* pNode) {
+            if (recovery.mapPendingMembers.count(pNode->verifiedProRegTxHash)) {
+                pNode->fDisconnect = true;
             }
+        });
+        recovery.mapPendingMembers.clear();
+        printLog("Success");
+        return false;
+    }
 
-            if ((GetAdjustedTime() - nTimeLastSuccess) > nRequestTimeout) {
-                if (nTries >= vecMemberHashes.size()) {
-                    printLog("All tried but failed");
-                    break;
-                }
-                // Access the member list of the quorum with the calculated offset applied to balance the load equally
-                pCurrentMemberHash = &vecMemberHashes[(nMyStartOffset + nTries++) % vecMemberHashes.size()];
-                {
-                    LOCK(cs_data_requests);
-                    auto it = mapQuorumDataRequests.find(std::make_pair(*pCurrentMemberHash, true));
-                    if (it != mapQuorumDataRequests.end() && !it->second.IsExpired()) {
-                        printLog("Already asked");
-                        continue;
-                    }
-                }
-                // Sleep a bit depending on the start offset to balance out multiple requests to same masternode
-                quorumThreadInterrupt.sleep_for(std::chrono::milliseconds(nMyStartOffset * 100));
-                nTimeLastSuccess = GetAdjustedTime();
-                g_connman->AddPendingMasternode(*pCurrentMemberHash);
-                printLog("Connect");
+    const int64_t nNow = GetAdjustedTime();
+
+    // give up on members which didn't connect or answer in time
+    for (auto it = recovery.mapPendingMembers.begin(); it != recovery.mapPendingMembers.end(); ) {
+        if (nNow - it->second > QUORUM_RECOVERY_REQUEST_TIMEOUT) {
+            printLog("Timeout", it->first);
+            it = recovery.mapPendingMembers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Access the member list of the quorum with the calculated offset applied to balance the load equally
+    while (recovery.mapPendingMembers.size() < QUORUM_RECOVERY_PARALLEL_REQUESTS && recovery.nTries < recovery.vecMemberHashes.size()) {
+        const uint256& memberHash = recovery.vecMemberHashes[(recovery.nMyStartOffset + recovery.nTries++) % recovery.vecMemberHashes.size()];
+        {
+            LOCK(cs_data_requests);
+            auto it = mapQuorumDataRequests.find(std::make_pair(memberHash, true));
+            if (it != mapQuorumDataRequests.end() && !it->second.IsExpired()) {
+                printLog("Already asked", memberHash);
+                continue;
             }
+        }
+        recovery.mapPendingMembers.emplace(memberHash, nNow);
+        g_connman->AddPendingMasternode(memberHash);
+        printLog("Connect", memberHash);
+    }
 
-            g_connman->ForEachNode([&](CNode* pNode) {
+    if (recovery.mapPendingMembers.empty()) {
+        printLog("All tried but failed");
+        return false;
+    }
 
-                if (pCurrentMemberHash == nullptr || pNode->verifiedProRegTxHash != *pCurrentMemberHash) {
-                    return;
-                }
+    std::vector<uint256> vecFailed;
+    g_connman->ForEachNode([&](CNode* pNode) {
+        auto itPending = recovery.mapPendingMembers.find(pNode->verifiedProRegTxHash);
+        if (pNode->verifiedProRegTxHash.IsNull() || itPending == recovery.mapPendingMembers.end()) {
+            return;
+        }
 
-                if (quorumManager->RequestQuorumData(pNode, pQuorum->qc.llmqType, pQuorum->pindexQuorum, nDataMask, activeMasternodeInfo.proTxHash)) {
-                    nTimeLastSuccess = GetAdjustedTime();
-                    printLog("Requested");
-                } else {
-                    LOCK(cs_data_requests);
-                    auto it = mapQuorumDataRequests.find(std::make_pair(pNode->verifiedProRegTxHash, true));
-                    if (it == mapQuorumDataRequests.end()) {
-                        printLog("Failed");
-                        pNode->fDisconnect = true;
-                        pCurrentMemberHash = nullptr;
-                        return;
-                    } else if (it->second.IsProcessed()) {
-                        printLog("Processed");
-                        pNode->fDisconnect = true;
-                        pCurrentMemberHash = nullptr;
-                        return;
-                    } else {
-                        printLog("Waiting");
-                        return;
-                    }
-                }
-            });
-            quorumThreadInterrupt.sleep_for(std::chrono::seconds(1));
+        if (RequestQuorumData(pNode, pQuorum->qc.llmqType, pQuorum->pindexQuorum, nDataMask, activeMasternodeInfo.proTxHash)) {
+            itPending->second = nNow;
+            printLog("Requested", itPending->first);
+        } else {
+            LOCK(cs_data_requests);
+            auto it = mapQuorumDataRequests.find(std::make_pair(pNode->verifiedProRegTxHash, true));
+            if (it == mapQuorumDataRequests.end()) {
+                printLog("Failed", itPending->first);
+                pNode->fDisconnect = true;
+                vecFailed.emplace_back(itPending->first);
+            } else if (it->second.IsProcessed()) {
+                // answered, but we still miss data (e.g. the member responded with an error)
+                printLog("Processed", itPending->first);
+                pNode->fDisconnect = true;
+                vecFailed.emplace_back(itPending->first);
+            }
         }
-        pQuorum->fQuorumDataRecoveryThreadRunning = false;
-        printLog("Done");
     });
+    for (const auto& memberHash : vecFailed) {
+        recovery.mapPendingMembers.erase(memberHash);
+    }
+
+    return true;
 }
 
 } // namespace llmq
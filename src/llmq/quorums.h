@@ -20,6 +20,11 @@
 
 #include <ctpl.h>
 
+#include <atomic>
+#include <list>
+#include <memory>
+#include <thread>
+
 class CNode;
 
 namespace llmq
@@ -153,16 +158,21 @@ public:
     const CBlockIndex* pindexQuorum;
     uint256 minedBlockHash;
     std::vector<CDeterministicMNCPtr> members;
+    // BLS ids of the members, built once so that recovery and pubkey share lookups don't recreate them
+    BLSIdVector memberIds;
 
     // These are only valid when we either participated in the DKG or fully watched it
     BLSVerificationVectorPtr quorumVvec;
     CBLSSecretKey skShare;
 
 private:
-    // Recovery of public key shares is very slow, so we start a background thread that pre-populates a cache so that
-    // the public key shares are ready when needed later
-    mutable CBLSWorkerCache blsCache;
-    mutable std::atomic<bool> fQuorumDataRecoveryThreadRunning{false};
+    CBLSWorker& blsWorker;
+    // Memoized public key shares, indexed by member index. Recovery of public key shares is very slow, so they are
+    // computed only once, either on first use or by the cache populator (see -llmq-lazy-pubkeyshares). Entries are
+    // published with a CAS and never change afterwards, so lookups don't need a lock
+    mutable std::unique_ptr<std::atomic<const CBLSPublicKey*>[]> pubKeyShares;
+    // set while a data recovery for this quorum is queued or in progress
+    mutable std::atomic<bool> fQuorumDataRecoveryScheduled{false};
 
 public:
     CQuorum(const Consensus::LLMQParams& _params, CBLSWorker& _blsWorker);
@@ -176,12 +186,19 @@ public:
     bool IsValidMember(const uint256& proTxHash) const;
     int GetMemberIndex(const uint256& proTxHash) const;
 
+    const CBLSId& GetMemberId(size_t memberIdx) const;
     CBLSPublicKey GetPubKeyShare(size_t memberIdx) const;
     const CBLSSecretKey& GetSkShare() const;
 
 private:
+    // returns the memoized share, which might be the one of a concurrent caller
+    const CBLSPublicKey& SetPubKeyShare(size_t memberIdx, const CBLSPublicKey& pubKeyShare) const;
+
     void WriteContributions(CEvoDB& evoDb);
     bool ReadContributions(CEvoDB& evoDb);
+    // The public key shares of all valid members, so that warm restarts don't have to recompute them
+    void WritePubKeyShares(CEvoDB& evoDb) const;
+    bool ReadPubKeyShares(CEvoDB& evoDb);
 };
 
 /**
@@ -199,11 +216,36 @@ private:
 
     mutable CCriticalSection quorumsCacheCs;
     mutable std::map<Consensus::LLMQType, unordered_lru_cache<uint256, CQuorumPtr, StaticSaltedHasher>> mapQuorumsCache;
-    mutable std::map<Consensus::LLMQType, unordered_lru_cache<uint256, std::vector<CQuorumCPtr>, StaticSaltedHasher>> scanQuorumsCache;
 
     mutable ctpl::thread_pool workerPool;
     mutable CThreadInterrupt quorumThreadInterrupt;
 
+    // Quorum data recovery. Recoveries are queued by TriggerQuorumDataRecoveries and driven by a single thread, which
+    // requests the missing data from multiple members at once and limits the number of concurrent recoveries
+    static const size_t MAX_CONCURRENT_QUORUM_RECOVERIES = 4;
+    static const size_t QUORUM_RECOVERY_PARALLEL_REQUESTS = 3;
+    static const int64_t QUORUM_RECOVERY_REQUEST_TIMEOUT = 10;
+
+    struct QuorumDataRecovery {
+        CQuorumCPtr pQuorum;
+        const CBlockIndex* pIndex;
+        uint16_t nDataMask;
+        uint16_t nDataMaskIn;
+        // the valid members of the quorum minus ourself, sorted. Filled when the recovery starts
+        std::vector<uint256> vecMemberHashes;
+        size_t nMyStartOffset{0};
+        size_t nTries{0};
+        // don't start before this time (GetTimeMillis()), spreads the load of multiple nodes over the members
+        int64_t nStartTime{0};
+        // members which we currently connect to or wait for, mapped to the time (GetAdjustedTime()) of the last action
+        std::map<uint256, int64_t> mapPendingMembers;
+    };
+    mutable CCriticalSection cs_queuedRecoveries;
+    mutable std::list<QuorumDataRecovery> queuedRecoveries;
+    // only accessed by the recovery thread
+    std::list<QuorumDataRecovery> activeRecoveries;
+    std::thread recoveryThread;
+
 public:
     CQuorumManager(CEvoDB& _evoDb, CBLSWorker& _blsWorker, CDKGSessionManager& _dkgManager);
     ~CQuorumManager();
@@ -211,7 +253,7 @@ public:
     void Start();
     void Stop();
 
-    void TriggerQuorumDataRecoveryThreads(const CBlockIndex* pIndex) const;
+    void TriggerQuorumDataRecoveries(const CBlockIndex* pIndex) const;
 
     void UpdatedBlockTip(const CBlockIndex *pindexNew, bool fInitialDownload) const;
 
@@ -242,7 +284,10 @@ private:
     size_t GetQuorumRecoveryStartOffset(const CQuorumCPtr pQuorum, const CBlockIndex* pIndex) const;
 
     void StartCachePopulatorThread(const CQuorumCPtr pQuorum) const;
-    void StartQuorumDataRecoveryThread(const CQuorumCPtr pQuorum, const CBlockIndex* pIndex, uint16_t nDataMask) const;
+    void ScheduleQuorumDataRecovery(const CQuorumCPtr pQuorum, const CBlockIndex* pIndex, uint16_t nDataMask) const;
+    void QuorumDataRecoveryThread();
+    // returns false when the recovery is finished, either successful or because all members were tried
+    bool ProcessQuorumDataRecovery(QuorumDataRecovery& recovery);
 };
 
 extern CQuorumManager* quorumManager;
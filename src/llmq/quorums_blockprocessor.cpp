@@ -9,6 +9,7 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <checkqueue.h>
 #include <consensus/validation.h>
 #include <net.h>
 #include <net_processing.h>
@@ -25,6 +26,42 @@ static const std::string DB_MINED_COMMITMENT_BY_INVERSED_HEIGHT = "q_mcih";
 
 static const std::string DB_BEST_BLOCK_UPGRADE = "q_bbu2";
 
+/** Verifies the BLS signatures of a final commitment, the result is written to the location passed on construction */
+class CCommitmentSigCheck
+{
+private:
+    const CFinalCommitment* pqc{nullptr};
+    std::vector<CDeterministicMNCPtr> members;
+    bool* pfValidRet{nullptr};
+
+public:
+    CCommitmentSigCheck() = default;
+    CCommitmentSigCheck(const CFinalCommitment& qc, std::vector<CDeterministicMNCPtr>&& _members, bool& fValidRet) :
+        pqc(&qc), members(std::move(_members)), pfValidRet(&fValidRet) {}
+
+    bool operator()()
+    {
+        *pfValidRet = pqc->VerifySigs(members);
+        return true;
+    }
+
+    void swap(CCommitmentSigCheck& check)
+    {
+        std::swap(pqc, check.pqc);
+        members.swap(check.members);
+        std::swap(pfValidRet, check.pfValidRet);
+    }
+};
+
+// each check is a few pairings, no need to batch them
+static CCheckQueue<CCommitmentSigCheck> commitmentsigcheckqueue(1);
+
+void ThreadCommitmentSigCheck()
+{
+    RenameThread("dash-qcsigs");
+    commitmentsigcheckqueue.Thread();
+}
+
 CQuorumBlockProcessor::CQuorumBlockProcessor(CEvoDB &_evoDb) :
     evoDb(_evoDb)
 {
@@ -118,7 +155,7 @@ void CQuorumBlockProcessor::ProcessMessage(CNode* pfrom, const std::string& strC
     }
 }
 
-bool CQuorumBlockProcessor::ProcessBlock(const CBlock& block, const CBlockIndex* pindex, CValidationState& state, bool fJustCheck)
+bool CQuorumBlockProcessor::ProcessBlock(const CBlock& block, const CBlockIndex* pindex, CValidationState& state, bool fJustCheck, bool fCheckSigs)
 {
     AssertLockHeld(cs_main);
 
@@ -161,9 +198,34 @@ bool CQuorumBlockProcessor::ProcessBlock(const CBlock& block, const CBlockIndex*
 
     auto blockHash = block.GetHash();
 
+    // Verify the signatures of all commitments in parallel first. Commitments which fail here (or are skipped) are
+    // verified again by ProcessCommitment, so that the result and its reject reason don't change.
+    std::map<Consensus::LLMQType, bool> mapSigsValid;
+    if (fCheckSigs && qcs.size() > 1) {
+        std::vector<CCommitmentSigCheck> vChecks;
+        for (const auto& p : qcs) {
+            const auto& qc = p.second;
+            if (qc.IsNull() || !Params().GetConsensus().llmqs.count(qc.llmqType)) {
+                continue;
+            }
+            auto quorumIndex = LookupBlockIndex(qc.quorumHash);
+            if (!quorumIndex || !qc.Verify(quorumIndex, false)) {
+                continue;
+            }
+            vChecks.emplace_back(qc, CLLMQUtils::GetAllQuorumMembers(qc.llmqType, quorumIndex), mapSigsValid[p.first]);
+        }
+        if (vChecks.size() > 1) {
+            CCheckQueueControl<CCommitmentSigCheck> control(&commitmentsigcheckqueue);
+            control.Add(vChecks);
+            control.Wait();
+        }
+    }
+
     for (auto& p : qcs) {
         auto& qc = p.second;
-        if (!ProcessCommitment(pindex->nHeight, blockHash, qc, state, fJustCheck)) {
+        auto it = mapSigsValid.find(p.first);
+        bool fSigsVerified = it != mapSigsValid.end() && it->second;
+        if (!ProcessCommitment(pindex, blockHash, qc, state, fJustCheck, fCheckSigs && !fSigsVerified)) {
             return false;
         }
     }
@@ -181,8 +243,9 @@ static std::tuple<std::string, Consensus::LLMQType, uint32_t> BuildInversedHeigh
     return std::make_tuple(DB_MINED_COMMITMENT_BY_INVERSED_HEIGHT, llmqType, htobe32(std::numeric_limits<uint32_t>::max() - nMinedHeight));
 }
 
-bool CQuorumBlockProcessor::ProcessCommitment(int nHeight, const uint256& blockHash, const CFinalCommitment& qc, CValidationState& state, bool fJustCheck)
+bool CQuorumBlockProcessor::ProcessCommitment(const CBlockIndex* pindex, const uint256& blockHash, const CFinalCommitment& qc, CValidationState& state, bool fJustCheck, bool fCheckSigs)
 {
+    int nHeight = pindex->nHeight;
     auto& params = Params().GetConsensus().llmqs.at((Consensus::LLMQType)qc.llmqType);
 
     uint256 quorumHash = GetQuorumBlockHash((Consensus::LLMQType)qc.llmqType, nHeight);
@@ -206,7 +269,7 @@ bool CQuorumBlockProcessor::ProcessCommitment(int nHeight, const uint256& blockH
         return true;
     }
 
-    if (HasMinedCommitment(params.type, quorumHash)) {
+    if (HasMinedCommitmentInChain(params.type, quorumHash, nHeight - (nHeight % params.dkgInterval), pindex->pprev)) {
         // should not happen as it's already handled in ProcessBlock
         return state.DoS(100, false, REJECT_INVALID, "bad-qc-dup");
     }
@@ -218,7 +281,8 @@ bool CQuorumBlockProcessor::ProcessCommitment(int nHeight, const uint256& blockH
 
     auto quorumIndex = LookupBlockIndex(qc.quorumHash);
 
-    if (!qc.Verify(quorumIndex, true)) {
+    // the member list is still checked without the signatures, it determines which members are valid
+    if (!qc.Verify(quorumIndex, fCheckSigs)) {
         return state.DoS(100, false, REJECT_INVALID, "bad-qc-invalid");
     }
 
@@ -237,6 +301,11 @@ bool CQuorumBlockProcessor::ProcessCommitment(int nHeight, const uint256& blockH
         minableCommitmentsByQuorum.erase(cacheKey);
         minableCommitments.erase(::SerializeHash(qc));
     }
+    {
+        LOCK(minedCommitmentsIndexCs);
+        minedCommitmentsIndex[params.type][nHeight] = std::make_pair(pindex, quorumIndex);
+        minedCommitmentHashes[std::make_pair(params.type, pindex)] = ::SerializeHash(qc);
+    }
 
     LogPrint(BCLog::LLMQ, "CQuorumBlockProcessor::%s -- processed commitment from block. type=%d, quorumHash=%s, signers=%s, validMembers=%d, quorumPublicKey=%s\n", __func__,
               qc.llmqType, quorumHash.ToString(), qc.CountSigners(), qc.CountValidMembers(), qc.quorumPublicKey.ToString());
@@ -266,6 +335,10 @@ bool CQuorumBlockProcessor::UndoBlock(const CBlock& block, const CBlockIndex* pi
             LOCK(minableCommitmentsCs);
             mapHasMinedCommitmentCache[qc.llmqType].erase(qc.quorumHash);
         }
+        {
+            LOCK(minedCommitmentsIndexCs);
+            minedCommitmentHashes.erase(std::make_pair((Consensus::LLMQType)qc.llmqType, pindex));
+        }
 
         // if a reorg happened, we should allow to mine this commitment later
         AddMinableCommitment(qc);
@@ -283,11 +356,16 @@ bool CQuorumBlockProcessor::UpgradeDB()
 
     if (chainActive.Tip() == nullptr) {
         // should have no records
-        return evoDb.IsEmpty();
+        if (!evoDb.IsEmpty()) {
+            return false;
+        }
+        BuildMinedCommitmentsIndex();
+        return true;
     }
 
     uint256 bestBlock;
     if (evoDb.GetRawDB().Read(DB_BEST_BLOCK_UPGRADE, bestBlock) && bestBlock == chainActive.Tip()->GetBlockHash()) {
+        BuildMinedCommitmentsIndex();
         return true;
     }
 
@@ -325,9 +403,30 @@ bool CQuorumBlockProcessor::UpgradeDB()
     }
 
     LogPrintf("CQuorumBlockProcessor::%s -- Upgrade done...\n", __func__);
+    BuildMinedCommitmentsIndex();
     return true;
 }
 
+void CQuorumBlockProcessor::BuildMinedCommitmentsIndex()
+{
+    AssertLockHeld(cs_main);
+
+    size_t nCount{0};
+    LOCK(minedCommitmentsIndexCs);
+    if (chainActive.Tip() != nullptr) {
+        for (const auto& p : Params().GetConsensus().llmqs) {
+            auto& index = minedCommitmentsIndex[p.first];
+            for (const auto& e : GetMinedCommitmentsUntilBlockFromDB(p.first, chainActive.Tip(), std::numeric_limits<size_t>::max())) {
+                index[e.first->nHeight] = e;
+                nCount++;
+            }
+        }
+    }
+    fMinedCommitmentsIndexReady = true;
+
+    LogPrint(BCLog::LLMQ, "CQuorumBlockProcessor::%s -- indexed %d mined commitments\n", __func__, nCount);
+}
+
 bool CQuorumBlockProcessor::GetCommitmentsFromBlock(const CBlock& block, const CBlockIndex* pindex, std::map<Consensus::LLMQType, CFinalCommitment>& ret, CValidationState& state)
 {
     AssertLockHeld(cs_main);
@@ -380,7 +479,8 @@ bool CQuorumBlockProcessor::IsCommitmentRequired(Consensus::LLMQType llmqType, i
     bool isMiningPhase = !quorumHash.IsNull() && IsMiningPhase(llmqType, nHeight);
 
     // did we already mine a non-null commitment for this session?
-    bool hasMinedCommitment = !quorumHash.IsNull() && HasMinedCommitment(llmqType, quorumHash);
+    const auto& params = Params().GetConsensus().llmqs.at(llmqType);
+    bool hasMinedCommitment = !quorumHash.IsNull() && HasMinedCommitmentInChain(llmqType, quorumHash, nHeight - (nHeight % params.dkgInterval), chainActive[nHeight - 1]);
 
     return isMiningPhase && !hasMinedCommitment;
 }
@@ -418,6 +518,27 @@ bool CQuorumBlockProcessor::HasMinedCommitment(Consensus::LLMQType llmqType, con
     return fExists;
 }
 
+// Same as HasMinedCommitment, but only considers the chain ending at pindexPrev. Answered from the in-memory index if
+// possible, so that validation and mining of new blocks doesn't need to hit the DB
+bool CQuorumBlockProcessor::HasMinedCommitmentInChain(Consensus::LLMQType llmqType, const uint256& quorumHash, int nQuorumHeight, const CBlockIndex* pindexPrev)
+{
+    if (pindexPrev != nullptr) {
+        LOCK(minedCommitmentsIndexCs);
+        if (fMinedCommitmentsIndexReady) {
+            const auto& params = Params().GetConsensus().llmqs.at(llmqType);
+            const auto& index = minedCommitmentsIndex[llmqType];
+            // commitments can only be mined in the DKG interval of the quorum
+            for (auto it = index.lower_bound(nQuorumHeight); it != index.end() && it->first <= pindexPrev->nHeight && it->first < nQuorumHeight + params.dkgInterval; ++it) {
+                if (it->second.second->nHeight == nQuorumHeight && pindexPrev->GetAncestor(it->first) == it->second.first) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+    return HasMinedCommitment(llmqType, quorumHash);
+}
+
 bool CQuorumBlockProcessor::GetMinedCommitment(Consensus::LLMQType llmqType, const uint256& quorumHash, CFinalCommitment& retQc, uint256& retMinedBlockHash)
 {
     auto key = std::make_pair(DB_MINED_COMMITMENT, std::make_pair(llmqType, quorumHash));
@@ -432,6 +553,43 @@ bool CQuorumBlockProcessor::GetMinedCommitment(Consensus::LLMQType llmqType, con
 
 // The returned quorums are in reversed order, so the most recent one is at index 0
 std::vector<const CBlockIndex*> CQuorumBlockProcessor::GetMinedCommitmentsUntilBlock(Consensus::LLMQType llmqType, const CBlockIndex* pindex, size_t maxCount)
+{
+    auto commitments = GetMinedCommitmentPairsUntilBlock(llmqType, pindex, maxCount);
+    std::vector<const CBlockIndex*> ret;
+    ret.reserve(commitments.size());
+    for (const auto& p : commitments) {
+        ret.emplace_back(p.second);
+    }
+    return ret;
+}
+
+// Returns pairs of mined block and quorum block, the most recent commitment is at index 0
+std::vector<std::pair<const CBlockIndex*, const CBlockIndex*>> CQuorumBlockProcessor::GetMinedCommitmentPairsUntilBlock(Consensus::LLMQType llmqType, const CBlockIndex* pindex, size_t maxCount)
+{
+    {
+        LOCK(minedCommitmentsIndexCs);
+        if (fMinedCommitmentsIndexReady) {
+            std::vector<std::pair<const CBlockIndex*, const CBlockIndex*>> ret;
+            const auto& index = minedCommitmentsIndex[llmqType];
+            ret.reserve(std::min(maxCount, index.size()));
+            auto it = index.upper_bound(pindex->nHeight);
+            while (it != index.begin() && ret.size() < maxCount) {
+                --it;
+                // skip entries of blocks which are not (or no longer) part of the chain
+                if (pindex->GetAncestor(it->first) != it->second.first) {
+                    continue;
+                }
+                ret.emplace_back(it->second);
+            }
+            return ret;
+        }
+    }
+
+    return GetMinedCommitmentsUntilBlockFromDB(llmqType, pindex, maxCount);
+}
+
+// Returns pairs of mined block and quorum block, the most recent commitment is at index 0
+std::vector<std::pair<const CBlockIndex*, const CBlockIndex*>> CQuorumBlockProcessor::GetMinedCommitmentsUntilBlockFromDB(Consensus::LLMQType llmqType, const CBlockIndex* pindex, size_t maxCount)
 {
     LOCK(evoDb.cs);
 
@@ -442,8 +600,7 @@ std::vector<const CBlockIndex*> CQuorumBlockProcessor::GetMinedCommitmentsUntilB
 
     dbIt->Seek(firstKey);
 
-    std::vector<const CBlockIndex*> ret;
-    ret.reserve(maxCount);
+    std::vector<std::pair<const CBlockIndex*, const CBlockIndex*>> ret;
 
     while (dbIt->Valid() && ret.size() < maxCount) {
         decltype(firstKey) curKey;
@@ -464,9 +621,10 @@ std::vector<const CBlockIndex*> CQuorumBlockProcessor::GetMinedCommitmentsUntilB
             break;
         }
 
+        auto minedIndex = pindex->GetAncestor(nMinedHeight);
         auto quorumIndex = pindex->GetAncestor(quorumHeight);
-        assert(quorumIndex);
-        ret.emplace_back(quorumIndex);
+        assert(minedIndex && quorumIndex);
+        ret.emplace_back(minedIndex, quorumIndex);
 
         dbIt->Next();
     }
@@ -491,6 +649,43 @@ std::map<Consensus::LLMQType, std::vector<const CBlockIndex*>> CQuorumBlockProce
     return ret;
 }
 
+// Same as GetMinedAndActiveCommitmentsUntilBlock, but returns the commitment hashes instead of the quorum blocks. Hashes
+// are served from minedCommitmentHashes and only read from the DB when a commitment was not seen being connected
+bool CQuorumBlockProcessor::GetMinedAndActiveCommitmentHashesUntilBlock(const CBlockIndex* pindex, std::map<Consensus::LLMQType, std::vector<uint256>>& ret)
+{
+    ret.clear();
+
+    for (const auto& p : Params().GetConsensus().llmqs) {
+        auto& v = ret[p.second.type];
+        v.reserve(p.second.signingActiveQuorumCount);
+        for (const auto& c : GetMinedCommitmentPairsUntilBlock(p.second.type, pindex, p.second.signingActiveQuorumCount)) {
+            auto cacheKey = std::make_pair(p.second.type, c.first);
+            {
+                LOCK(minedCommitmentsIndexCs);
+                auto it = minedCommitmentHashes.find(cacheKey);
+                if (it != minedCommitmentHashes.end()) {
+                    v.emplace_back(it->second);
+                    continue;
+                }
+            }
+
+            CFinalCommitment qc;
+            uint256 minedBlockHash;
+            if (!GetMinedCommitment(p.second.type, c.second->GetBlockHash(), qc, minedBlockHash) || minedBlockHash != c.first->GetBlockHash()) {
+                return false;
+            }
+            uint256 qcHash = ::SerializeHash(qc);
+            {
+                LOCK(minedCommitmentsIndexCs);
+                minedCommitmentHashes.emplace(cacheKey, qcHash);
+            }
+            v.emplace_back(qcHash);
+        }
+    }
+
+    return true;
+}
+
 bool CQuorumBlockProcessor::HasMinableCommitment(const uint256& hash)
 {
     LOCK(minableCommitmentsCs);
@@ -23,6 +23,9 @@ class CConnman;
 namespace llmq
 {
 
+/** Run an instance of the thread which verifies the signatures of the commitments of a block in parallel */
+void ThreadCommitmentSigCheck();
+
 class CQuorumBlockProcessor
 {
 private:
@@ -35,6 +38,19 @@ private:
 
     std::map<Consensus::LLMQType, unordered_lru_cache<uint256, bool, StaticSaltedHasher>> mapHasMinedCommitmentCache;
 
+    // In-memory index of mined commitments, per LLMQ type and keyed by mined height. Each entry holds the block the
+    // commitment was mined in and the quorum block. Entries are added when blocks are connected and overwritten when
+    // a different block is connected at the same height. Entries of disconnected blocks are kept, lookups filter them
+    // by checking that the mined block is an ancestor of the block they start from. This keeps the index correct even
+    // when the evoDb transaction of a connected/disconnected block is not committed (e.g. on failure or in VerifyDB)
+    CCriticalSection minedCommitmentsIndexCs;
+    std::map<Consensus::LLMQType, std::map<int, std::pair<const CBlockIndex*, const CBlockIndex*>>> minedCommitmentsIndex;
+    // set after the index was populated from the DB, until then lookups are served from the DB
+    bool fMinedCommitmentsIndexReady{false};
+    // Hashes of mined commitments, keyed by LLMQ type and the block they were mined in. A block can only contain a single
+    // commitment per LLMQ type, so entries never become stale. Protected by minedCommitmentsIndexCs
+    std::map<std::pair<Consensus::LLMQType, const CBlockIndex*>, uint256> minedCommitmentHashes;
+
 public:
     explicit CQuorumBlockProcessor(CEvoDB& _evoDb);
 
@@ -42,7 +58,7 @@ public:
 
     void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv);
 
-    bool ProcessBlock(const CBlock& block, const CBlockIndex* pindex, CValidationState& state, bool fJustCheck);
+    bool ProcessBlock(const CBlock& block, const CBlockIndex* pindex, CValidationState& state, bool fJustCheck, bool fCheckSigs = true);
     bool UndoBlock(const CBlock& block, const CBlockIndex* pindex);
 
     void AddMinableCommitment(const CFinalCommitment& fqc);
@@ -56,10 +72,15 @@ public:
 
     std::vector<const CBlockIndex*> GetMinedCommitmentsUntilBlock(Consensus::LLMQType llmqType, const CBlockIndex* pindex, size_t maxCount);
     std::map<Consensus::LLMQType, std::vector<const CBlockIndex*>> GetMinedAndActiveCommitmentsUntilBlock(const CBlockIndex* pindex);
+    bool GetMinedAndActiveCommitmentHashesUntilBlock(const CBlockIndex* pindex, std::map<Consensus::LLMQType, std::vector<uint256>>& ret);
 
 private:
     static bool GetCommitmentsFromBlock(const CBlock& block, const CBlockIndex* pindex, std::map<Consensus::LLMQType, CFinalCommitment>& ret, CValidationState& state);
-    bool ProcessCommitment(int nHeight, const uint256& blockHash, const CFinalCommitment& qc, CValidationState& state, bool fJustCheck);
+    bool ProcessCommitment(const CBlockIndex* pindex, const uint256& blockHash, const CFinalCommitment& qc, CValidationState& state, bool fJustCheck, bool fCheckSigs);
+    std::vector<std::pair<const CBlockIndex*, const CBlockIndex*>> GetMinedCommitmentPairsUntilBlock(Consensus::LLMQType llmqType, const CBlockIndex* pindex, size_t maxCount);
+    std::vector<std::pair<const CBlockIndex*, const CBlockIndex*>> GetMinedCommitmentsUntilBlockFromDB(Consensus::LLMQType llmqType, const CBlockIndex* pindex, size_t maxCount);
+    void BuildMinedCommitmentsIndex();
+    bool HasMinedCommitmentInChain(Consensus::LLMQType llmqType, const uint256& quorumHash, int nQuorumHeight, const CBlockIndex* pindexPrev);
     static bool IsMiningPhase(Consensus::LLMQType llmqType, int nHeight);
     bool IsCommitmentRequired(Consensus::LLMQType llmqType, int nHeight);
     static uint256 GetQuorumBlockHash(Consensus::LLMQType llmqType, int nHeight);
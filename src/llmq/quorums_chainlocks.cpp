@@ -7,10 +7,13 @@
 #include <llmq/quorums_utils.h>
 
 #include <chain.h>
+#include <hash.h>
 #include <masternode/masternode-sync.h>
 #include <net_processing.h>
+#include <random.h>
 #include <scheduler.h>
 #include <spork.h>
+#include <statsd_client.h>
 #include <txmempool.h>
 #include <validation.h>
 
@@ -31,9 +34,140 @@ std::string CChainLockSig::ToString() const
     return strprintf("CChainLockSig(nHeight=%d, blockHash=%s)", nHeight, blockHash.ToString());
 }
 
-CChainLocksHandler::CChainLocksHandler()
+////////////////
+
+CTxFirstSeenTimes::CTxFirstSeenTimes(int64_t _nTimeBase) :
+    nTimeBase(_nTimeBase),
+    k0(GetRand(std::numeric_limits<uint64_t>::max())),
+    k1(GetRand(std::numeric_limits<uint64_t>::max()))
+{
+    table.resize(MIN_CAPACITY);
+}
+
+uint64_t CTxFirstSeenTimes::GetFingerprint(const uint256& txid) const
+{
+    uint64_t fingerprint = SipHashUint256(k0, k1, txid);
+    // 0 marks empty slots
+    return fingerprint != 0 ? fingerprint : 1;
+}
+
+size_t CTxFirstSeenTimes::FindSlot(uint64_t fingerprint) const
+{
+    const size_t mask = table.size() - 1;
+    size_t i = (size_t)fingerprint & mask;
+    while (table[i].fingerprint != 0 && table[i].fingerprint != fingerprint) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+void CTxFirstSeenTimes::Rehash(size_t newCapacity)
+{
+    std::vector<Entry> oldTable;
+    oldTable.swap(table);
+    table.resize(newCapacity);
+    for (const auto& e : oldTable) {
+        if (e.fingerprint != 0) {
+            table[FindSlot(e.fingerprint)] = e;
+        }
+    }
+}
+
+void CTxFirstSeenTimes::Add(const uint256& txid, int64_t nTime, int nHeight)
 {
-    scheduler = new CScheduler();
+    // keep the load factor below 3/4
+    if ((count + 1) * 4 > table.size() * 3) {
+        Rehash(table.size() * 2);
+    }
+
+    uint64_t fingerprint = GetFingerprint(txid);
+    auto& e = table[FindSlot(fingerprint)];
+    if (e.fingerprint == 0) {
+        e.fingerprint = fingerprint;
+        e.nTime = (uint32_t)std::min<int64_t>(std::max<int64_t>(nTime - nTimeBase, 0), std::numeric_limits<uint32_t>::max());
+        count++;
+    }
+    if (nHeight != -1) {
+        e.nHeight = nHeight;
+    }
+}
+
+bool CTxFirstSeenTimes::Get(const uint256& txid, int64_t& nTimeRet) const
+{
+    const auto& e = table[FindSlot(GetFingerprint(txid))];
+    if (e.fingerprint == 0) {
+        return false;
+    }
+    nTimeRet = nTimeBase + e.nTime;
+    return true;
+}
+
+void CTxFirstSeenTimes::SetMinedHeight(const uint256& txid, int nHeight)
+{
+    auto& e = table[FindSlot(GetFingerprint(txid))];
+    if (e.fingerprint != 0) {
+        e.nHeight = nHeight;
+    }
+}
+
+void CTxFirstSeenTimes::Remove(const uint256& txid)
+{
+    const size_t mask = table.size() - 1;
+    size_t i = FindSlot(GetFingerprint(txid));
+    if (table[i].fingerprint == 0) {
+        return;
+    }
+
+    // backward shift deletion, so that we don't need tombstones
+    size_t j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        if (table[j].fingerprint == 0) {
+            break;
+        }
+        size_t home = (size_t)table[j].fingerprint & mask;
+        // move entry j into the hole at i if its home slot is not in the (cyclic) range (i, j]
+        if ((j > i && (home <= i || home > j)) || (j < i && (home <= i && home > j))) {
+            table[i] = table[j];
+            i = j;
+        }
+    }
+    table[i] = Entry();
+    count--;
+}
+
+size_t CTxFirstSeenTimes::PruneMined(int nHeight)
+{
+    size_t removed = 0;
+    for (auto& e : table) {
+        if (e.fingerprint != 0 && e.nHeight != -1 && e.nHeight <= nHeight) {
+            e = Entry();
+            removed++;
+        }
+    }
+    if (removed == 0) {
+        return 0;
+    }
+    count -= removed;
+
+    // clearing slots breaks probe sequences, so the table must be rebuilt. Also shrink it while we're at it
+    size_t newCapacity = MIN_CAPACITY;
+    while (count * 4 > newCapacity * 3) {
+        newCapacity *= 2;
+    }
+    Rehash(newCapacity);
+    return removed;
+}
+
+////////////////
+
+CChainLocksHandler::CChainLocksHandler() :
+    txFirstSeenTime(GetAdjustedTime() - WAIT_FOR_ISLOCK_TIMEOUT)
+{
+    GetRandBytes(verifiedChainLocksNonce.begin(), 32);
+    verifiedChainLocks.setup_bytes(VERIFIED_CHAINLOCKS_CACHE_BYTES);
+
+    scheduler = new CScheduler("chainlocks");
     CScheduler::Function serviceLoop = boost::bind(&CScheduler::serviceQueue, scheduler);
     scheduler_thread = new boost::thread(boost::bind(&TraceThread<CScheduler::Function>, "cl-schdlr", serviceLoop));
 }
@@ -54,7 +188,7 @@ void CChainLocksHandler::Start()
         EnforceBestChainLock();
         // regularly retry signing the current chaintip as it might have failed before due to missing islocks
         TrySignChainTip();
-    }, 5000);
+    }, 5000, "periodic");
 }
 
 void CChainLocksHandler::Stop()
@@ -127,8 +261,7 @@ void CChainLocksHandler::ProcessNewChainLock(const NodeId from, const llmq::CCha
         }
     }
 
-    const uint256 requestId = ::SerializeHash(std::make_pair(CLSIG_REQUESTID_PREFIX, clsig.nHeight));
-    if (!quorumSigningManager->VerifyRecoveredSig(Params().GetConsensus().llmqTypeChainLocks, clsig.nHeight, requestId, clsig.blockHash, clsig.sig)) {
+    if (!VerifyChainLock(clsig)) {
         LogPrint(BCLog::CHAINLOCKS, "CChainLocksHandler::%s -- invalid CLSIG (%s), peer=%d\n", __func__, clsig.ToString(), from);
         if (from != -1) {
             LOCK(cs_main);
@@ -148,6 +281,11 @@ void CChainLocksHandler::ProcessNewChainLock(const NodeId from, const llmq::CCha
         bestChainLockHash = hash;
         bestChainLock = clsig;
 
+        if (clsig.blockHash == lastTipHash) {
+            statsClient.timing("chainlocks.latency_ms", std::max<int64_t>(GetTimeMillis() - lastTipTimeMs, 0), 1.0f);
+        }
+        statsClient.inc("chainlocks.clsigs", 1.0f);
+
         if (pindex != nullptr) {
 
             if (pindex->nHeight != clsig.nHeight) {
@@ -178,7 +316,7 @@ void CChainLocksHandler::ProcessNewChainLock(const NodeId from, const llmq::CCha
     scheduler->scheduleFromNow([&]() {
         CheckActiveState();
         EnforceBestChainLock();
-    }, 0);
+    }, 0, "enforce");
 
     LogPrint(BCLog::CHAINLOCKS, "CChainLocksHandler::%s -- processed new CLSIG (%s), peer=%d\n",
               __func__, clsig.ToString(), from);
@@ -207,6 +345,16 @@ void CChainLocksHandler::AcceptedBlockHeader(const CBlockIndex* pindexNew)
 }
 
 void CChainLocksHandler::UpdatedBlockTip(const CBlockIndex* pindexNew)
+{
+    {
+        LOCK(cs);
+        lastTipHash = pindexNew->GetBlockHash();
+        lastTipTimeMs = GetTimeMillis();
+    }
+    ScheduleTrySignChainTip();
+}
+
+void CChainLocksHandler::ScheduleTrySignChainTip()
 {
     // don't call TrySignChainTip directly but instead let the scheduler call it. This way we ensure that cs_main is
     // never locked and TrySignChainTip is not called twice in parallel. Also avoids recursive calls due to
@@ -222,7 +370,7 @@ void CChainLocksHandler::UpdatedBlockTip(const CBlockIndex* pindexNew)
         TrySignChainTip();
         LOCK(cs);
         tryLockChainTipScheduled = false;
-    }, 0);
+    }, 0, "signtip");
 }
 
 void CChainLocksHandler::CheckActiveState()
@@ -320,28 +468,51 @@ void CChainLocksHandler::TrySignChainTip()
                 break;
             }
 
-            auto txids = GetBlockTxs(pindexWalk->GetBlockHash());
-            if (!txids) {
+            std::vector<uint256> txids;
+            if (!GetBlockTxs(pindexWalk->GetBlockHash(), txids)) {
                 pindexWalk = pindexWalk->pprev;
                 continue;
             }
 
-            for (auto& txid : *txids) {
-                int64_t txAge = 0;
-                {
-                    LOCK(cs);
-                    auto it = txFirstSeenTime.find(txid);
-                    if (it != txFirstSeenTime.end()) {
-                        txAge = GetAdjustedTime() - it->second;
+            // blockTxs only contains the TXs which were not safe yet the last time we checked, so usually there is
+            // nothing or very little left to check here
+            std::vector<std::pair<uint256, int64_t>> unsafeTxs;
+            {
+                LOCK(cs);
+                unsafeTxs.reserve(txids.size());
+                int64_t curTime = GetAdjustedTime();
+                for (auto& txid : txids) {
+                    int64_t txAge = 0;
+                    int64_t nFirstSeenTime;
+                    if (txFirstSeenTime.Get(txid, nFirstSeenTime)) {
+                        txAge = curTime - nFirstSeenTime;
                     }
+                    unsafeTxs.emplace_back(txid, txAge);
                 }
+            }
 
-                if (txAge < WAIT_FOR_ISLOCK_TIMEOUT && !quorumInstantSendManager->IsLocked(txid)) {
+            std::unordered_set<uint256, StaticSaltedHasher> safeTxs;
+            for (auto& p : unsafeTxs) {
+                if (p.second < WAIT_FOR_ISLOCK_TIMEOUT && !quorumInstantSendManager->IsLocked(p.first)) {
                     LogPrint(BCLog::CHAINLOCKS, "CChainLocksHandler::%s -- not signing block %s due to TX %s not being islocked and not old enough. age=%d\n", __func__,
-                              pindexWalk->GetBlockHash().ToString(), txid.ToString(), txAge);
-                    return;
+                              pindexWalk->GetBlockHash().ToString(), p.first.ToString(), p.second);
+                    break;
+                }
+                safeTxs.emplace(p.first);
+            }
+            if (!safeTxs.empty()) {
+                LOCK(cs);
+                auto it = blockTxs.find(pindexWalk->GetBlockHash());
+                if (it != blockTxs.end()) {
+                    auto& unsafeTxids = it->second.unsafeTxids;
+                    unsafeTxids.erase(std::remove_if(unsafeTxids.begin(), unsafeTxids.end(), [&](const uint256& txid) {
+                        return safeTxs.count(txid) != 0;
+                    }), unsafeTxids.end());
                 }
             }
+            if (safeTxs.size() != unsafeTxs.size()) {
+                return;
+            }
 
             pindexWalk = pindexWalk->pprev;
         }
@@ -371,7 +542,19 @@ void CChainLocksHandler::TransactionAddedToMempool(const CTransactionRef& tx, in
     }
 
     LOCK(cs);
-    txFirstSeenTime.emplace(tx->GetHash(), nAcceptTime);
+    txFirstSeenTime.Add(tx->GetHash(), nAcceptTime);
+}
+
+void CChainLocksHandler::TransactionRemovedFromMempool(const CTransactionRef& tx)
+{
+    if (tx->IsCoinBase() || tx->vin.empty()) {
+        return;
+    }
+
+    // TXs removed due to being included in a block are not reported here, so this TX has vanished (e.g. due to
+    // conflicts or expiry). Mined TXs are pruned by height instead
+    LOCK(cs);
+    txFirstSeenTime.Remove(tx->GetHash());
 }
 
 void CChainLocksHandler::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindex, const std::vector<CTransactionRef>& vtxConflicted)
@@ -382,84 +565,125 @@ void CChainLocksHandler::BlockConnected(const std::shared_ptr<const CBlock>& pbl
 
     // We listen for BlockConnected so that we can collect all TX ids of all included TXs of newly received blocks
     // We need this information later when we try to sign a new tip, so that we can determine if all included TXs are
-    // safe.
+    // safe. TXs which are already safe at this point (islocked or known for long enough) are not added at all, so that
+    // TrySignChainTip can sign right away when the new tip arrives.
+
+    bool fCheckLocks = IsInstantSendEnabled() && quorumInstantSendManager != nullptr;
+    std::vector<std::pair<uint256, bool>> blockTxids;
+    blockTxids.reserve(pblock->vtx.size());
+    for (const auto& tx : pblock->vtx) {
+        if (tx->IsCoinBase() || tx->vin.empty()) {
+            continue;
+        }
+        // don't hold cs while asking the isman, it might call into us while holding its own lock
+        blockTxids.emplace_back(tx->GetHash(), fCheckLocks && quorumInstantSendManager->IsLocked(tx->GetHash()));
+    }
 
     LOCK(cs);
 
-    auto it = blockTxs.find(pindex->GetBlockHash());
-    if (it == blockTxs.end()) {
-        // we must create this entry even if there are no lockable transactions in the block, so that TrySignChainTip
-        // later knows about this block
-        it = blockTxs.emplace(pindex->GetBlockHash(), std::make_shared<std::unordered_set<uint256, StaticSaltedHasher>>()).first;
-    }
-    auto& txids = *it->second;
+    // we must create this entry even if there are no lockable transactions in the block, so that TrySignChainTip
+    // later knows about this block
+    auto& info = blockTxs[pindex->GetBlockHash()];
+    info.nHeight = pindex->nHeight;
+    info.unsafeTxids.clear();
 
     int64_t curTime = GetAdjustedTime();
 
-    for (const auto& tx : pblock->vtx) {
-        if (tx->IsCoinBase() || tx->vin.empty()) {
+    for (const auto& p : blockTxids) {
+        txFirstSeenTime.Add(p.first, curTime, pindex->nHeight);
+        int64_t nFirstSeenTime = curTime;
+        txFirstSeenTime.Get(p.first, nFirstSeenTime);
+        if (p.second || curTime - nFirstSeenTime >= WAIT_FOR_ISLOCK_TIMEOUT) {
             continue;
         }
-
-        txids.emplace(tx->GetHash());
-        txFirstSeenTime.emplace(tx->GetHash(), curTime);
+        info.unsafeTxids.emplace_back(p.first);
     }
+    info.unsafeTxids.shrink_to_fit();
 
+    // TrySignChainTip never looks further down than 5 blocks below the tip, so everything below that is not needed
+    // anymore, even if ChainLocks are not active
+    PruneBlockTxs(pindex->nHeight - 6);
 }
 
 void CChainLocksHandler::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexDisconnected)
 {
     LOCK(cs);
     blockTxs.erase(pindexDisconnected->GetBlockHash());
+    // the TXs are back in the mempool (or vanished, in which case we'll get notified about this)
+    for (const auto& tx : pblock->vtx) {
+        txFirstSeenTime.SetMinedHeight(tx->GetHash(), -1);
+    }
 }
 
-CChainLocksHandler::BlockTxs::mapped_type CChainLocksHandler::GetBlockTxs(const uint256& blockHash)
+void CChainLocksHandler::PruneBlockTxs(int nHeight)
+{
+    AssertLockHeld(cs);
+
+    if (nHeight <= prunedHeight) {
+        return;
+    }
+    prunedHeight = nHeight;
+
+    for (auto it = blockTxs.begin(); it != blockTxs.end(); ) {
+        if (it->second.nHeight <= nHeight) {
+            it = blockTxs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    size_t pruned = txFirstSeenTime.PruneMined(nHeight);
+
+    LogPrint(BCLog::CHAINLOCKS, "CChainLocksHandler::%s -- pruned %d TXs up to height %d. txFirstSeenTime.size=%d (%d bytes), blockTxs.size=%d\n", __func__,
+             pruned, nHeight, txFirstSeenTime.size(), txFirstSeenTime.GetMemoryUsage(), blockTxs.size());
+}
+
+bool CChainLocksHandler::GetBlockTxs(const uint256& blockHash, std::vector<uint256>& txidsRet)
 {
     AssertLockNotHeld(cs);
     AssertLockNotHeld(cs_main);
 
-    CChainLocksHandler::BlockTxs::mapped_type ret;
-
     {
         LOCK(cs);
         auto it = blockTxs.find(blockHash);
         if (it != blockTxs.end()) {
-            ret = it->second;
+            txidsRet = it->second.unsafeTxids;
+            return true;
         }
     }
-    if (!ret) {
-        // This should only happen when freshly started.
-        // If running for some time, SyncTransaction should have been called before which fills blockTxs.
-        LogPrint(BCLog::CHAINLOCKS, "CChainLocksHandler::%s -- blockTxs for %s not found. Trying ReadBlockFromDisk\n", __func__,
-                 blockHash.ToString());
 
-        uint32_t blockTime;
-        {
-            LOCK(cs_main);
-            auto pindex = LookupBlockIndex(blockHash);
-            CBlock block;
-            if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
-                return nullptr;
-            }
+    // This should only happen when freshly started.
+    // If running for some time, SyncTransaction should have been called before which fills blockTxs.
+    LogPrint(BCLog::CHAINLOCKS, "CChainLocksHandler::%s -- blockTxs for %s not found. Trying ReadBlockFromDisk\n", __func__,
+             blockHash.ToString());
 
-            ret = std::make_shared<std::unordered_set<uint256, StaticSaltedHasher>>();
-            for (auto& tx : block.vtx) {
-                if (tx->IsCoinBase() || tx->vin.empty()) {
-                    continue;
-                }
-                ret->emplace(tx->GetHash());
-            }
-
-            blockTime = block.nTime;
+    BlockTxsInfo info;
+    uint32_t blockTime;
+    {
+        LOCK(cs_main);
+        auto pindex = LookupBlockIndex(blockHash);
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
+            return false;
         }
 
-        LOCK(cs);
-        blockTxs.emplace(blockHash, ret);
-        for (auto& txid : *ret) {
-            txFirstSeenTime.emplace(txid, blockTime);
+        info.nHeight = pindex->nHeight;
+        for (auto& tx : block.vtx) {
+            if (tx->IsCoinBase() || tx->vin.empty()) {
+                continue;
+            }
+            info.unsafeTxids.emplace_back(tx->GetHash());
         }
+
+        blockTime = block.nTime;
     }
-    return ret;
+
+    LOCK(cs);
+    for (auto& txid : info.unsafeTxids) {
+        txFirstSeenTime.Add(txid, blockTime, info.nHeight);
+    }
+    auto it = blockTxs.emplace(blockHash, std::move(info)).first;
+    txidsRet = it->second.unsafeTxids;
+    return true;
 }
 
 bool CChainLocksHandler::IsTxSafeForMining(const uint256& txid)
@@ -477,9 +701,9 @@ bool CChainLocksHandler::IsTxSafeForMining(const uint256& txid)
         if (!isEnabled || !isEnforced) {
             return true;
         }
-        auto it = txFirstSeenTime.find(txid);
-        if (it != txFirstSeenTime.end()) {
-            txAge = GetAdjustedTime() - it->second;
+        int64_t nFirstSeenTime;
+        if (txFirstSeenTime.Get(txid, nFirstSeenTime)) {
+            txAge = GetAdjustedTime() - nFirstSeenTime;
         }
     }
 
@@ -568,6 +792,10 @@ void CChainLocksHandler::EnforceBestChainLock()
     }
 
     if (pindexNotify) {
+        {
+            LOCK(cs);
+            PruneBlockTxs(pindexNotify->nHeight);
+        }
         GetMainSignals().NotifyChainLock(pindexNotify, clsig);
     }
 }
@@ -598,6 +826,41 @@ void CChainLocksHandler::HandleNewRecoveredSig(const llmq::CRecoveredSig& recove
     ProcessNewChainLock(-1, clsig, ::SerializeHash(clsig));
 }
 
+bool CChainLocksHandler::VerifyChainLock(const CChainLockSig& clsig)
+{
+    const auto llmqType = Params().GetConsensus().llmqTypeChainLocks;
+    const uint256 requestId = ::SerializeHash(std::make_pair(CLSIG_REQUESTID_PREFIX, clsig.nHeight));
+
+    // same as CSigningManager::VerifyRecoveredSig, but we need the quorum for the cache entry. Including the quorum
+    // hash makes sure that we don't accept cached results if a reorg changed the responsible quorum
+    auto quorum = CSigningManager::SelectQuorumForSigning(llmqType, requestId, clsig.nHeight);
+    if (!quorum) {
+        return false;
+    }
+
+    CHashWriter hw(SER_GETHASH, 0);
+    hw << verifiedChainLocksNonce;
+    hw << quorum->qc.quorumHash;
+    hw << clsig;
+    uint256 entry = hw.GetHash();
+
+    {
+        LOCK(cs_verifiedChainLocks);
+        if (verifiedChainLocks.contains(entry, false)) {
+            return true;
+        }
+    }
+
+    uint256 signHash = CLLMQUtils::BuildSignHash(llmqType, quorum->qc.quorumHash, requestId, clsig.blockHash);
+    if (!clsig.sig.VerifyInsecure(quorum->qc.quorumPublicKey, signHash)) {
+        return false;
+    }
+
+    LOCK(cs_verifiedChainLocks);
+    verifiedChainLocks.insert(entry);
+    return true;
+}
+
 bool CChainLocksHandler::HasChainLock(int nHeight, const uint256& blockHash)
 {
     LOCK(cs);
@@ -672,8 +935,7 @@ void CChainLocksHandler::Cleanup()
         }
     }
 
-    // need mempool.cs due to GetTransaction calls
-    LOCK2(cs_main, mempool.cs);
+    // blockTxs and txFirstSeenTime are pruned by height when blocks get connected or ChainLocked
     LOCK(cs);
 
     for (auto it = seenChainLocks.begin(); it != seenChainLocks.end(); ) {
@@ -684,38 +946,6 @@ void CChainLocksHandler::Cleanup()
         }
     }
 
-    for (auto it = blockTxs.begin(); it != blockTxs.end(); ) {
-        auto pindex = LookupBlockIndex(it->first);
-        if (InternalHasChainLock(pindex->nHeight, pindex->GetBlockHash())) {
-            for (auto& txid : *it->second) {
-                txFirstSeenTime.erase(txid);
-            }
-            it = blockTxs.erase(it);
-        } else if (InternalHasConflictingChainLock(pindex->nHeight, pindex->GetBlockHash())) {
-            it = blockTxs.erase(it);
-        } else {
-            ++it;
-        }
-    }
-    for (auto it = txFirstSeenTime.begin(); it != txFirstSeenTime.end(); ) {
-        CTransactionRef tx;
-        uint256 hashBlock;
-        if (!GetTransaction(it->first, tx, Params().GetConsensus(), hashBlock)) {
-            // tx has vanished, probably due to conflicts
-            it = txFirstSeenTime.erase(it);
-        } else if (!hashBlock.IsNull()) {
-            auto pindex = LookupBlockIndex(hashBlock);
-            if (chainActive.Tip()->GetAncestor(pindex->nHeight) == pindex && chainActive.Height() - pindex->nHeight >= 6) {
-                // tx got confirmed >= 6 times, so we can stop keeping track of it
-                it = txFirstSeenTime.erase(it);
-            } else {
-                ++it;
-            }
-        } else {
-            ++it;
-        }
-    }
-
     lastCleanupTime = GetTimeMillis();
 }
 
@@ -10,8 +10,11 @@
 
 #include <net.h>
 #include <chainparams.h>
+#include <cuckoocache.h>
+#include <script/sigcache.h>
 
 #include <atomic>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <boost/thread.hpp>
@@ -46,10 +49,58 @@ public:
     std::string ToString() const;
 };
 
+/**
+ * Compact map of the times at which TXs were first seen (in the mempool or in a block). It's a flat open addressing
+ * table with linear probing which only stores a salted 64 bit fingerprint of the txid, the time relative to a base
+ * time and the height of the block the TX was mined in (or -1 if not mined). Mined entries are pruned by height, so
+ * that no periodic scan over the mempool and txindex is needed.
+ *
+ * Times before the base time are clamped to it. The base time is chosen far enough in the past so that this doesn't
+ * change whether a TX is considered old enough.
+ */
+class CTxFirstSeenTimes
+{
+private:
+    struct Entry {
+        uint64_t fingerprint{0}; // 0 means the slot is empty
+        uint32_t nTime{0};
+        int32_t nHeight{-1};
+    };
+
+    static const size_t MIN_CAPACITY = 1024;
+
+    std::vector<Entry> table;
+    size_t count{0};
+
+    const int64_t nTimeBase;
+    const uint64_t k0;
+    const uint64_t k1;
+
+public:
+    explicit CTxFirstSeenTimes(int64_t _nTimeBase);
+
+    // Does not overwrite the time of an existing entry. If nHeight is not -1, the entry is marked as mined at nHeight
+    void Add(const uint256& txid, int64_t nTime, int nHeight = -1);
+    bool Get(const uint256& txid, int64_t& nTimeRet) const;
+    void SetMinedHeight(const uint256& txid, int nHeight);
+    void Remove(const uint256& txid);
+    // Removes all entries of TXs mined at or below nHeight and returns how many were removed
+    size_t PruneMined(int nHeight);
+
+    size_t size() const { return count; }
+    size_t GetMemoryUsage() const { return table.capacity() * sizeof(Entry); }
+
+private:
+    uint64_t GetFingerprint(const uint256& txid) const;
+    size_t FindSlot(uint64_t fingerprint) const;
+    void Rehash(size_t newCapacity);
+};
+
 class CChainLocksHandler : public CRecoveredSigsListener
 {
     static const int64_t CLEANUP_INTERVAL = 1000 * 30;
     static const int64_t CLEANUP_SEEN_TIMEOUT = 24 * 60 * 60 * 1000;
+    static const size_t VERIFIED_CHAINLOCKS_CACHE_BYTES = 64 * 1024;
 
     // how long to wait for islocks until we consider a block with non-islocked TXs to be safe to sign
     static const int64_t WAIT_FOR_ISLOCK_TIMEOUT = 10 * 60;
@@ -69,17 +120,34 @@ private:
     const CBlockIndex* bestChainLockBlockIndex{nullptr};
     const CBlockIndex* lastNotifyChainLockBlockIndex{nullptr};
 
+    // the last tip we were notified about and when, to report how long it took to get the CLSIG for it
+    uint256 lastTipHash;
+    int64_t lastTipTimeMs{0};
+
     int32_t lastSignedHeight{-1};
     uint256 lastSignedRequestId;
     uint256 lastSignedMsgHash;
 
-    // We keep track of txids from recently received blocks so that we can check if all TXs got islocked
-    typedef std::unordered_map<uint256, std::shared_ptr<std::unordered_set<uint256, StaticSaltedHasher>>> BlockTxs;
-    BlockTxs blockTxs;
-    std::unordered_map<uint256, int64_t> txFirstSeenTime;
+    // We keep track of txids from recently received blocks so that we can check if all TXs got islocked. TXs are removed
+    // from the per block lists as soon as they are known to be safe, so an empty list means that the block is safe to
+    // sign. Entries are pruned once their height is ChainLocked or deep enough
+    struct BlockTxsInfo {
+        int nHeight{-1};
+        std::vector<uint256> unsafeTxids;
+    };
+    std::unordered_map<uint256, BlockTxsInfo, StaticSaltedHasher> blockTxs;
+    CTxFirstSeenTimes txFirstSeenTime;
+    int prunedHeight{-1};
 
     std::map<uint256, int64_t> seenChainLocks;
 
+    // CLSIGs which were verified successfully, so that we don't have to verify them again when they are seen again
+    // (e.g. after seenChainLocks timed out or through the verifychainlock RPC). Entries are
+    // SHA256(nonce || quorum hash || CLSIG) and only valid CLSIGs are stored
+    CCriticalSection cs_verifiedChainLocks;
+    uint256 verifiedChainLocksNonce;
+    CuckooCache::cache<uint256, SignatureCacheHasher> verifiedChainLocks;
+
     int64_t lastCleanupTime{0};
 
 public:
@@ -98,13 +166,19 @@ public:
     void AcceptedBlockHeader(const CBlockIndex* pindexNew);
     void UpdatedBlockTip(const CBlockIndex* pindexNew);
     void TransactionAddedToMempool(const CTransactionRef& tx, int64_t nAcceptTime);
+    void TransactionRemovedFromMempool(const CTransactionRef& tx);
     void BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindex, const std::vector<CTransactionRef>& vtxConflicted);
     void BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexDisconnected);
     void CheckActiveState();
+    // Called when the tip changed or when a TX of a recent block got islocked
+    void ScheduleTrySignChainTip();
     void TrySignChainTip();
     void EnforceBestChainLock();
     virtual void HandleNewRecoveredSig(const CRecoveredSig& recoveredSig);
 
+    // Verifies the CLSIG against the quorum responsible for its height, using the cache of already verified CLSIGs
+    bool VerifyChainLock(const CChainLockSig& clsig);
+
     bool HasChainLock(int nHeight, const uint256& blockHash);
     bool HasConflictingChainLock(int nHeight, const uint256& blockHash);
 
@@ -115,7 +189,8 @@ private:
     bool InternalHasChainLock(int nHeight, const uint256& blockHash);
     bool InternalHasConflictingChainLock(int nHeight, const uint256& blockHash);
 
-    BlockTxs::mapped_type GetBlockTxs(const uint256& blockHash);
+    bool GetBlockTxs(const uint256& blockHash, std::vector<uint256>& txidsRet);
+    void PruneBlockTxs(int nHeight);
 
     void Cleanup();
 };
@@ -78,26 +78,33 @@ bool CFinalCommitment::Verify(const CBlockIndex* pQuorumIndex, bool checkSigs) c
     }
 
     // sigs are only checked when the block is processed
-    if (checkSigs) {
-        uint256 commitmentHash = CLLMQUtils::BuildCommitmentHash(params.type, quorumHash, validMembers, quorumPublicKey, quorumVvecHash);
-
-        std::vector<CBLSPublicKey> memberPubKeys;
-        for (size_t i = 0; i < members.size(); i++) {
-            if (!signers[i]) {
-                continue;
-            }
-            memberPubKeys.emplace_back(members[i]->pdmnState->pubKeyOperator.Get());
-        }
+    if (checkSigs && !VerifySigs(members)) {
+        return false;
+    }
 
-        if (!membersSig.VerifySecureAggregated(memberPubKeys, commitmentHash)) {
-            LogPrintfFinalCommitment("invalid aggregated members signature\n");
-            return false;
-        }
+    return true;
+}
 
-        if (!quorumSig.VerifyInsecure(quorumPublicKey, commitmentHash)) {
-            LogPrintfFinalCommitment("invalid quorum signature\n");
-            return false;
+bool CFinalCommitment::VerifySigs(const std::vector<CDeterministicMNCPtr>& members) const
+{
+    uint256 commitmentHash = CLLMQUtils::BuildCommitmentHash(llmqType, quorumHash, validMembers, quorumPublicKey, quorumVvecHash);
+
+    std::vector<CBLSPublicKey> memberPubKeys;
+    for (size_t i = 0; i < members.size(); i++) {
+        if (!signers[i]) {
+            continue;
         }
+        memberPubKeys.emplace_back(members[i]->pdmnState->pubKeyOperator.Get());
+    }
+
+    if (!membersSig.VerifySecureAggregated(memberPubKeys, commitmentHash)) {
+        LogPrintfFinalCommitment("invalid aggregated members signature\n");
+        return false;
+    }
+
+    if (!quorumSig.VerifyInsecure(quorumPublicKey, commitmentHash)) {
+        LogPrintfFinalCommitment("invalid quorum signature\n");
+        return false;
     }
 
     return true;
@@ -53,6 +53,8 @@ public:
     }
 
     bool Verify(const CBlockIndex* pQuorumIndex, bool checkSigs) const;
+    /** Verifies membersSig and quorumSig only, members must be the quorum members and the rest already verified */
+    bool VerifySigs(const std::vector<CDeterministicMNCPtr>& members) const;
     bool VerifyNull() const;
     bool VerifySizes(const Consensus::LLMQParams& params) const;
 
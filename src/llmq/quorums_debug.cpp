@@ -6,15 +6,53 @@
 
 #include <chainparams.h>
 #include <timedata.h>
+#include <utiltime.h>
 #include <validation.h>
 
 #include <evo/deterministicmns.h>
+#include <llmq/quorums_dkgsessionhandler.h>
 #include <llmq/quorums_utils.h>
 
+#include <statsd_client.h>
+
 namespace llmq
 {
 CDKGDebugManager* quorumDKGDebugManager;
 
+static const char* DKGPhaseToString(uint8_t phase)
+{
+    switch (phase) {
+    case QuorumPhase_Contribute:
+        return "contribute";
+    case QuorumPhase_Complain:
+        return "complain";
+    case QuorumPhase_Justify:
+        return "justify";
+    case QuorumPhase_Commit:
+        return "commit";
+    case QuorumPhase_Finalize:
+        return "finalize";
+    default:
+        return "unknown";
+    }
+}
+
+// phaseTimings and receivedTimes both start at QuorumPhase_Contribute
+static size_t DKGPhaseToIndex(uint8_t phase)
+{
+    return (size_t)phase - QuorumPhase_Contribute;
+}
+
+UniValue CDKGDebugPhaseTiming::ToJson() const
+{
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("startTime", nStartTime);
+    ret.pushKV("endTime", nEndTime);
+    ret.pushKV("duration", nEndTime != 0 ? nEndTime - nStartTime : 0);
+    ret.pushKV("waitTime", nWaitTime);
+    return ret;
+}
+
 UniValue CDKGDebugSessionStatus::ToJson(int detailLevel) const
 {
     UniValue ret(UniValue::VOBJ);
@@ -24,7 +62,7 @@ UniValue CDKGDebugSessionStatus::ToJson(int detailLevel) const
     }
 
     std::vector<CDeterministicMNCPtr> dmnMembers;
-    if (detailLevel == 2) {
+    if (detailLevel >= 2) {
         const CBlockIndex* pindex = nullptr;
         {
             LOCK(cs_main);
@@ -65,7 +103,7 @@ UniValue CDKGDebugSessionStatus::ToJson(int detailLevel) const
                 v.count++;
             } else if (detailLevel == 1) {
                 v.arr.push_back((int)idx);
-            } else if (detailLevel == 2) {
+            } else {
                 UniValue a(UniValue::VOBJ);
                 a.pushKV("memberIndex", (int)idx);
                 if (idx < dmnMembers.size()) {
@@ -99,7 +137,16 @@ UniValue CDKGDebugSessionStatus::ToJson(int detailLevel) const
     push(receivedJustifications, "receivedJustifications");
     push(receivedPrematureCommitments, "receivedPrematureCommitments");
 
-    if (detailLevel == 2) {
+    UniValue phaseTimingsJson(UniValue::VOBJ);
+    for (uint8_t p = QuorumPhase_Contribute; p <= QuorumPhase_Finalize; p++) {
+        const auto& t = phaseTimings[DKGPhaseToIndex(p)];
+        if (t.nStartTime != 0) {
+            phaseTimingsJson.pushKV(DKGPhaseToString(p), t.ToJson());
+        }
+    }
+    ret.pushKV("phaseTimings", phaseTimingsJson);
+
+    if (detailLevel >= 2) {
         UniValue arr(UniValue::VARR);
         for (const auto& dmn : dmnMembers) {
             arr.push_back(dmn->proTxHash.ToString());
@@ -107,6 +154,34 @@ UniValue CDKGDebugSessionStatus::ToJson(int detailLevel) const
         ret.pushKV("allMembers", arr);
     }
 
+    if (detailLevel == 3) {
+        // time between the start of the local phase and the arrival of each member's message for this phase
+        UniValue latenciesJson(UniValue::VOBJ);
+        for (uint8_t p = QuorumPhase_Contribute; p <= QuorumPhase_Commit; p++) {
+            size_t phaseIdx = DKGPhaseToIndex(p);
+            int64_t nPhaseStartTime = phaseTimings[phaseIdx].nStartTime;
+            if (nPhaseStartTime == 0) {
+                continue;
+            }
+            UniValue arr(UniValue::VARR);
+            for (size_t i = 0; i < members.size(); i++) {
+                int64_t nReceivedTime = members[i].receivedTimes[phaseIdx];
+                if (nReceivedTime == 0) {
+                    continue;
+                }
+                UniValue a(UniValue::VOBJ);
+                a.pushKV("memberIndex", (int)i);
+                if (i < dmnMembers.size()) {
+                    a.pushKV("proTxHash", dmnMembers[i]->proTxHash.ToString());
+                }
+                a.pushKV("latency", nReceivedTime - nPhaseStartTime);
+                arr.push_back(a);
+            }
+            latenciesJson.pushKV(DKGPhaseToString(p), arr);
+        }
+        ret.pushKV("memberLatencies", latenciesJson);
+    }
+
     return ret;
 }
 
@@ -170,6 +245,7 @@ void CDKGDebugManager::InitLocalSessionStatus(Consensus::LLMQType llmqType, cons
     session.statusBitset = 0;
     session.members.clear();
     session.members.resize((size_t)params.size);
+    session.phaseTimings = {};
 }
 
 void CDKGDebugManager::UpdateLocalSessionStatus(Consensus::LLMQType llmqType, std::function<bool(CDKGDebugSessionStatus& status)>&& func)
@@ -200,4 +276,88 @@ void CDKGDebugManager::UpdateLocalMemberStatus(Consensus::LLMQType llmqType, siz
     }
 }
 
+void CDKGDebugManager::StartLocalPhase(Consensus::LLMQType llmqType, uint8_t phase)
+{
+    if (phase < QuorumPhase_Contribute || phase > QuorumPhase_Finalize) {
+        return;
+    }
+
+    LOCK(cs);
+
+    auto it = localStatus.sessions.find(llmqType);
+    if (it == localStatus.sessions.end()) {
+        return;
+    }
+
+    auto& t = it->second.phaseTimings[DKGPhaseToIndex(phase)];
+    t.nStartTime = GetTimeMillis();
+    t.nEndTime = 0;
+    t.nWaitTime = 0;
+    localStatus.nTime = GetAdjustedTime();
+}
+
+void CDKGDebugManager::FinishLocalPhase(Consensus::LLMQType llmqType, uint8_t phase, int64_t nWaitTime)
+{
+    if (phase < QuorumPhase_Contribute || phase > QuorumPhase_Finalize) {
+        return;
+    }
+
+    int64_t nDuration;
+    {
+        LOCK(cs);
+
+        auto it = localStatus.sessions.find(llmqType);
+        if (it == localStatus.sessions.end()) {
+            return;
+        }
+
+        auto& t = it->second.phaseTimings[DKGPhaseToIndex(phase)];
+        if (t.nStartTime == 0) {
+            return;
+        }
+        t.nEndTime = GetTimeMillis();
+        t.nWaitTime = nWaitTime;
+        nDuration = t.nEndTime - t.nStartTime;
+        localStatus.nTime = GetAdjustedTime();
+    }
+
+    const auto& params = GetLLMQParams(llmqType);
+    statsClient.timing(strprintf("llmq.%s.dkg.%s.duration_ms", params.name, DKGPhaseToString(phase)), std::max<int64_t>(nDuration, 0), 1.0f);
+    statsClient.timing(strprintf("llmq.%s.dkg.%s.wait_ms", params.name, DKGPhaseToString(phase)), std::max<int64_t>(nWaitTime, 0), 1.0f);
+}
+
+void CDKGDebugManager::UpdateLocalMemberReceivedTime(Consensus::LLMQType llmqType, size_t memberIdx, uint8_t phase)
+{
+    if (phase < QuorumPhase_Contribute || phase > QuorumPhase_Commit) {
+        return;
+    }
+    size_t phaseIdx = DKGPhaseToIndex(phase);
+
+    int64_t nLatency;
+    {
+        LOCK(cs);
+
+        auto it = localStatus.sessions.find(llmqType);
+        if (it == localStatus.sessions.end()) {
+            return;
+        }
+
+        auto& nReceivedTime = it->second.members.at(memberIdx).receivedTimes[phaseIdx];
+        if (nReceivedTime != 0) {
+            // only the first message of a member counts
+            return;
+        }
+        nReceivedTime = GetTimeMillis();
+        localStatus.nTime = GetAdjustedTime();
+
+        int64_t nPhaseStartTime = it->second.phaseTimings[phaseIdx].nStartTime;
+        if (nPhaseStartTime == 0) {
+            return;
+        }
+        nLatency = nReceivedTime - nPhaseStartTime;
+    }
+
+    statsClient.timing(strprintf("llmq.%s.dkg.%s.member_latency_ms", GetLLMQParams(llmqType).name, DKGPhaseToString(phase)), std::max<int64_t>(nLatency, 0), 1.0f);
+}
+
 } // namespace llmq
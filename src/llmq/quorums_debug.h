@@ -9,6 +9,7 @@
 #include <sync.h>
 #include <univalue.h>
 
+#include <array>
 #include <functional>
 #include <set>
 
@@ -41,10 +42,26 @@ public:
 
     std::set<uint16_t> complaintsFromMembers;
 
+    // GetTimeMillis() when the message of the contribute, complain, justify and commit phase was received. 0 if not received
+    std::array<int64_t, 4> receivedTimes{};
+
 public:
     CDKGDebugMemberStatus() : statusBitset(0) {}
 };
 
+class CDKGDebugPhaseTiming
+{
+public:
+    // GetTimeMillis() when the phase was entered and left. 0 if not entered/left yet
+    int64_t nStartTime{0};
+    int64_t nEndTime{0};
+    // time spent idle while waiting for peers and the next phase, i.e. without any messages to process
+    int64_t nWaitTime{0};
+
+public:
+    UniValue ToJson() const;
+};
+
 class CDKGDebugSessionStatus
 {
 public:
@@ -69,6 +86,9 @@ public:
 
     std::vector<CDKGDebugMemberStatus> members;
 
+    // indexed by QuorumPhase, from QuorumPhase_Contribute to QuorumPhase_Finalize
+    std::array<CDKGDebugPhaseTiming, 5> phaseTimings;
+
 public:
     CDKGDebugSessionStatus() : statusBitset(0) {}
 
@@ -102,6 +122,11 @@ public:
 
     void UpdateLocalSessionStatus(Consensus::LLMQType llmqType, std::function<bool(CDKGDebugSessionStatus& status)>&& func);
     void UpdateLocalMemberStatus(Consensus::LLMQType llmqType, size_t memberIdx, std::function<bool(CDKGDebugMemberStatus& status)>&& func);
+
+    // Phase timings and per member message arrival times. These are also pushed to statsd
+    void StartLocalPhase(Consensus::LLMQType llmqType, uint8_t phase);
+    void FinishLocalPhase(Consensus::LLMQType llmqType, uint8_t phase, int64_t nWaitTime);
+    void UpdateLocalMemberReceivedTime(Consensus::LLMQType llmqType, size_t memberIdx, uint8_t phase);
 };
 
 extern CDKGDebugManager* quorumDKGDebugManager;
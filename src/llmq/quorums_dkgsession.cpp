@@ -178,8 +178,10 @@ void CDKGSession::SendContributions(CDKGPendingMessages& pendingMessages)
     qc.vvec = vvecContribution;
 
     cxxtimer::Timer t1(true);
-    qc.contributions = std::make_shared<CBLSIESMultiRecipientObjects<CBLSSecretKey>>();
-    qc.contributions->InitEncrypt(members.size());
+    std::vector<CBLSPublicKey> recipients;
+    BLSSecretKeyVector skContribs;
+    recipients.reserve(members.size());
+    skContribs.reserve(members.size());
 
     for (size_t i = 0; i < members.size(); i++) {
         auto& m = members[i];
@@ -190,10 +192,14 @@ void CDKGSession::SendContributions(CDKGPendingMessages& pendingMessages)
             skContrib.MakeNewKey();
         }
 
-        if (!qc.contributions->Encrypt(i, m->dmn->pdmnState->pubKeyOperator.Get(), skContrib, PROTOCOL_VERSION)) {
-            logger.Batch("failed to encrypt contribution for %s", m->dmn->proTxHash.ToString());
-            return;
-        }
+        recipients.emplace_back(m->dmn->pdmnState->pubKeyOperator.Get());
+        skContribs.emplace_back(skContrib);
+    }
+
+    qc.contributions = std::make_shared<CBLSIESMultiRecipientObjects<CBLSSecretKey>>();
+    if (!blsWorker.EncryptContributions(recipients, skContribs, PROTOCOL_VERSION, *qc.contributions)) {
+        logger.Batch("failed to encrypt contributions");
+        return;
     }
 
     logger.Batch("encrypted contributions. time=%d", t1.count());
@@ -291,6 +297,7 @@ void CDKGSession::ReceiveMessage(const CDKGContribution& qc, bool& retBan)
             status.receivedContribution = true;
             return true;
         });
+        quorumDKGDebugManager->UpdateLocalMemberReceivedTime(params.type, member->idx, QuorumPhase_Contribute);
 
         if (member->contributions.size() > 1) {
             // don't do any further processing if we got more than 1 contribution. we already relayed it,
@@ -355,27 +362,51 @@ void CDKGSession::ReceiveMessage(const CDKGContribution& qc, bool& retBan)
     }
 }
 
-// Verifies all pending secret key contributions in one batch
+// Verifies all pending secret key contributions in batches
 // This is done by aggregating the verification vectors belonging to the secret key contributions
 // The resulting aggregated vvec is then used to recover a public key share
 // The public key share must match the public key belonging to the aggregated secret key contributions
 // See CBLSWorker::VerifyContributionShares for more details.
+// The batches are scheduled on the CBLSWorker queue which is shared with the sessions of all other LLMQ types. Jobs
+// are ordered by the height at which our contribution phase ends, so overlapping DKGs keep all workers busy while the
+// session which is closest to its deadline is served first. Results are handled in HandleVerifiedContributions
 void CDKGSession::VerifyPendingContributions()
 {
     AssertLockHeld(cs_pending);
 
     CDKGLogger logger(*this, __func__);
 
-    cxxtimer::Timer t1(true);
-
     std::vector<size_t> pend = std::move(pendingContributionVerifications);
     if (pend.empty()) {
         return;
     }
 
+    // contributions must be verified before the complain phase starts
+    const int64_t nDeadline = pindexQuorum->nHeight + params.dkgPhaseBlocks * 2;
+    std::weak_ptr<CDKGSession> weakThis = shared_from_this();
+
     std::vector<size_t> memberIndexes;
     std::vector<BLSVerificationVectorPtr> vvecs;
     BLSSecretKeyVector skContributions;
+    size_t jobCount = 0;
+
+    auto scheduleJob = [&]() {
+        {
+            std::unique_lock<std::mutex> l(verifyJobsMutex);
+            verifyJobsInProgress++;
+        }
+        blsWorker.ScheduleVerifyContributionShares(nDeadline, myId, std::move(vvecs), skContributions,
+            [weakThis, memberIndexes, skContributions](const std::vector<bool>& result) {
+                auto session = weakThis.lock();
+                if (session) {
+                    session->HandleVerifiedContributions(memberIndexes, skContributions, result);
+                }
+            });
+        memberIndexes.clear();
+        vvecs.clear();
+        skContributions.clear();
+        jobCount++;
+    };
 
     for (const auto& idx : pend) {
         auto& m = members[idx];
@@ -388,30 +419,60 @@ void CDKGSession::VerifyPendingContributions()
         // Write here to definitely store one contribution for each member no matter if
         // our share is valid or not, could be that others are still correct
         dkgManager.WriteEncryptedContributions(params.type, pindexQuorum, m->dmn->proTxHash, *vecEncryptedContributions[idx]);
-    }
 
-    auto result = blsWorker.VerifyContributionShares(myId, vvecs, skContributions);
-    if (result.size() != memberIndexes.size()) {
-        logger.Batch("VerifyContributionShares returned result of size %d but size %d was expected, something is wrong", result.size(), memberIndexes.size());
-        return;
+        if (memberIndexes.size() >= CONTRIBUTION_VERIFY_JOB_SIZE) {
+            scheduleJob();
+        }
+    }
+    if (!memberIndexes.empty()) {
+        scheduleJob();
     }
 
-    for (size_t i = 0; i < memberIndexes.size(); i++) {
-        if (!result[i]) {
-            auto& m = members[memberIndexes[i]];
-            logger.Batch("invalid contribution from %s. will complain later", m->dmn->proTxHash.ToString());
-            m->weComplain = true;
-            quorumDKGDebugManager->UpdateLocalMemberStatus(params.type, m->idx, [&](CDKGDebugMemberStatus& status) {
-                status.weComplain = true;
-                return true;
-            });
+    logger.Batch("scheduled verification of %d pending contributions in %d jobs", pend.size(), jobCount);
+}
+
+void CDKGSession::HandleVerifiedContributions(const std::vector<size_t>& memberIndexes, const BLSSecretKeyVector& skContributions, const std::vector<bool>& result)
+{
+    {
+        LOCK(cs_pending);
+
+        CDKGLogger logger(*this, __func__);
+
+        if (result.size() != memberIndexes.size()) {
+            logger.Batch("VerifyContributionShares returned result of size %d but size %d was expected, something is wrong", result.size(), memberIndexes.size());
         } else {
-            size_t memberIdx = memberIndexes[i];
-            dkgManager.WriteVerifiedSkContribution(params.type, pindexQuorum, members[memberIdx]->dmn->proTxHash, skContributions[i]);
+            for (size_t i = 0; i < memberIndexes.size(); i++) {
+                if (!result[i]) {
+                    auto& m = members[memberIndexes[i]];
+                    logger.Batch("invalid contribution from %s. will complain later", m->dmn->proTxHash.ToString());
+                    m->weComplain = true;
+                    quorumDKGDebugManager->UpdateLocalMemberStatus(params.type, m->idx, [&](CDKGDebugMemberStatus& status) {
+                        status.weComplain = true;
+                        return true;
+                    });
+                } else {
+                    size_t memberIdx = memberIndexes[i];
+                    dkgManager.WriteVerifiedSkContribution(params.type, pindexQuorum, members[memberIdx]->dmn->proTxHash, skContributions[i]);
+                }
+            }
+            logger.Batch("verified %d contributions", memberIndexes.size());
         }
     }
 
-    logger.Batch("verified %d pending contributions. time=%d", pend.size(), t1.count());
+    std::unique_lock<std::mutex> l(verifyJobsMutex);
+    verifyJobsInProgress--;
+    verifyJobsCv.notify_all();
+}
+
+// Must be called without cs_pending being held, as HandleVerifiedContributions needs it
+void CDKGSession::WaitForContributionVerifications()
+{
+    CDKGLogger logger(*this, __func__);
+
+    cxxtimer::Timer t1(true);
+    std::unique_lock<std::mutex> l(verifyJobsMutex);
+    verifyJobsCv.wait(l, [this] { return verifyJobsInProgress == 0; });
+    logger.Batch("all contributions verified. waited %d ms", t1.count());
 }
 
 void CDKGSession::VerifyAndComplain(CDKGPendingMessages& pendingMessages)
@@ -424,6 +485,7 @@ void CDKGSession::VerifyAndComplain(CDKGPendingMessages& pendingMessages)
         LOCK(cs_pending);
         VerifyPendingContributions();
     }
+    WaitForContributionVerifications();
 
     CDKGLogger logger(*this, __func__);
 
@@ -608,6 +670,7 @@ void CDKGSession::ReceiveMessage(const CDKGComplaint& qc, bool& retBan)
             status.receivedComplaint = true;
             return true;
         });
+        quorumDKGDebugManager->UpdateLocalMemberReceivedTime(params.type, member->idx, QuorumPhase_Complain);
 
         if (member->complaints.size() > 1) {
             // don't do any further processing if we got more than 1 complaint. we already relayed it,
@@ -823,6 +886,7 @@ void CDKGSession::ReceiveMessage(const CDKGJustification& qj, bool& retBan)
             status.receivedJustification = true;
             return true;
         });
+        quorumDKGDebugManager->UpdateLocalMemberReceivedTime(params.type, member->idx, QuorumPhase_Justify);
 
         if (member->justifications.size() > 1) {
             // don't do any further processing if we got more than 1 justification. we already relayed it,
@@ -1177,8 +1241,13 @@ void CDKGSession::ReceiveMessage(const CDKGPrematureCommitment& qc, bool& retBan
         }
     }
 
+    {
+        LOCK(invCs);
+        validCommitments.emplace(hash);
+    }
+    ScheduleSpeculativeFinalCommitment(qc.validMembers);
+
     LOCK(invCs);
-    validCommitments.emplace(hash);
 
     CInv inv(MSG_QUORUM_PREMATURE_COMMITMENT, hash);
     RelayInvToParticipants(inv);
@@ -1187,6 +1256,7 @@ void CDKGSession::ReceiveMessage(const CDKGPrematureCommitment& qc, bool& retBan
         status.receivedPrematureCommitment = true;
         return true;
     });
+    quorumDKGDebugManager->UpdateLocalMemberReceivedTime(params.type, member->idx, QuorumPhase_Commit);
 
     int receivedCount = 0;
     for (const auto& m : members) {
@@ -1229,6 +1299,7 @@ std::vector<CFinalCommitment> CDKGSession::FinalizeCommitments()
     }
 
     std::vector<CFinalCommitment> finalCommitments;
+    size_t speculativeCount = 0;
     for (const auto& p : commitmentsMap) {
         auto& cvec = p.second;
         if (cvec.size() < params.minSize) {
@@ -1236,68 +1307,157 @@ std::vector<CFinalCommitment> CDKGSession::FinalizeCommitments()
             continue;
         }
 
-        std::vector<CBLSId> signerIds;
-        std::vector<CBLSSignature> thresholdSigs;
+        {
+            // validCommitments only grows, so a finished build from the same number of commitments used the same set
+            LOCK(cs_speculative);
+            auto it = speculativeFinalCommitments.find(p.first);
+            if (it != speculativeFinalCommitments.end() && !it->second.fInProgress && it->second.nCommitments == cvec.size()) {
+                if (it->second.fValid) {
+                    finalCommitments.emplace_back(it->second.fqc);
+                }
+                speculativeCount++;
+                continue;
+            }
+        }
 
-        auto& first = cvec[0];
+        CFinalCommitment fqc;
+        if (BuildFinalCommitment(cvec, fqc)) {
+            finalCommitments.emplace_back(fqc);
+        }
+    }
 
-        CFinalCommitment fqc(params, first.quorumHash);
-        fqc.validMembers = first.validMembers;
-        fqc.quorumPublicKey = first.quorumPublicKey;
-        fqc.quorumVvecHash = first.quorumVvecHash;
+    logger.Batch("finalized %d commitments, %d of them built ahead of time, blsCacheUsage=%d", finalCommitments.size(), speculativeCount, cache.DynamicMemoryUsage());
+    logger.Flush();
 
-        uint256 commitmentHash = CLLMQUtils::BuildCommitmentHash(fqc.llmqType, fqc.quorumHash, fqc.validMembers, fqc.quorumPublicKey, fqc.quorumVvecHash);
+    return finalCommitments;
+}
 
-        std::vector<CBLSSignature> aggSigs;
-        std::vector<CBLSPublicKey> aggPks;
-        aggSigs.reserve(cvec.size());
-        aggPks.reserve(cvec.size());
+std::vector<CDKGPrematureCommitment> CDKGSession::GetValidPrematureCommitments(const std::vector<bool>& validMembers) const
+{
+    LOCK(invCs);
 
-        for (const auto& qc : cvec) {
-            if (qc.quorumPublicKey != first.quorumPublicKey || qc.quorumVvecHash != first.quorumVvecHash) {
-                logger.Batch("quorumPublicKey or quorumVvecHash does not match, skipping");
-                continue;
-            }
+    std::vector<CDKGPrematureCommitment> ret;
+    for (const auto& p : prematureCommitments) {
+        if (p.second.validMembers == validMembers && validCommitments.count(p.first)) {
+            ret.emplace_back(p.second);
+        }
+    }
+    return ret;
+}
+
+// Aggregates the member sigs and recovers the quorum sig of a group of premature commitments with the same validMembers
+// This is also called from the CBLSWorker threads, so it must only touch state which is immutable after Init
+bool CDKGSession::BuildFinalCommitment(const std::vector<CDKGPrematureCommitment>& cvec, CFinalCommitment& fqcRet) const
+{
+    CDKGLogger logger(*this, __func__);
 
-            size_t signerIndex = membersMap[qc.proTxHash];
-            const auto& m = members[signerIndex];
+    std::vector<CBLSId> signerIds;
+    std::vector<CBLSSignature> thresholdSigs;
 
-            fqc.signers[signerIndex] = true;
-            aggSigs.emplace_back(qc.sig);
-            aggPks.emplace_back(m->dmn->pdmnState->pubKeyOperator.Get());
+    auto& first = cvec[0];
 
-            signerIds.emplace_back(m->id);
-            thresholdSigs.emplace_back(qc.quorumSig);
-        }
+    CFinalCommitment fqc(params, first.quorumHash);
+    fqc.validMembers = first.validMembers;
+    fqc.quorumPublicKey = first.quorumPublicKey;
+    fqc.quorumVvecHash = first.quorumVvecHash;
 
-        cxxtimer::Timer t1(true);
-        fqc.membersSig = CBLSSignature::AggregateSecure(aggSigs, aggPks, commitmentHash);
-        t1.stop();
+    uint256 commitmentHash = CLLMQUtils::BuildCommitmentHash(fqc.llmqType, fqc.quorumHash, fqc.validMembers, fqc.quorumPublicKey, fqc.quorumVvecHash);
 
-        cxxtimer::Timer t2(true);
-        if (!fqc.quorumSig.Recover(thresholdSigs, signerIds)) {
-            logger.Batch("failed to recover quorum sig");
-            continue;
-        }
-        t2.stop();
+    std::vector<CBLSSignature> aggSigs;
+    std::vector<CBLSPublicKey> aggPks;
+    aggSigs.reserve(cvec.size());
+    aggPks.reserve(cvec.size());
 
-        cxxtimer::Timer t3(true);
-        if (!fqc.Verify(pindexQuorum, true)) {
-            logger.Batch("failed to verify final commitment");
+    for (const auto& qc : cvec) {
+        if (qc.quorumPublicKey != first.quorumPublicKey || qc.quorumVvecHash != first.quorumVvecHash) {
+            logger.Batch("quorumPublicKey or quorumVvecHash does not match, skipping");
             continue;
         }
-        t3.stop();
 
-        finalCommitments.emplace_back(fqc);
+        size_t signerIndex = membersMap.at(qc.proTxHash);
+        const auto& m = members[signerIndex];
+
+        fqc.signers[signerIndex] = true;
+        aggSigs.emplace_back(qc.sig);
+        aggPks.emplace_back(m->dmn->pdmnState->pubKeyOperator.Get());
 
-        logger.Batch("final commitment: validMembers=%d, signers=%d, quorumPublicKey=%s, time1=%d, time2=%d, time3=%d",
-                        fqc.CountValidMembers(), fqc.CountSigners(), fqc.quorumPublicKey.ToString(),
-                        t1.count(), t2.count(), t3.count());
+        signerIds.emplace_back(m->id);
+        thresholdSigs.emplace_back(qc.quorumSig);
     }
 
-    logger.Flush();
+    cxxtimer::Timer t1(true);
+    fqc.membersSig = CBLSSignature::AggregateSecure(aggSigs, aggPks, commitmentHash);
+    t1.stop();
 
-    return finalCommitments;
+    cxxtimer::Timer t2(true);
+    if (!fqc.quorumSig.Recover(thresholdSigs, signerIds)) {
+        logger.Batch("failed to recover quorum sig");
+        return false;
+    }
+    t2.stop();
+
+    cxxtimer::Timer t3(true);
+    if (!fqc.Verify(pindexQuorum, true)) {
+        logger.Batch("failed to verify final commitment");
+        return false;
+    }
+    t3.stop();
+
+    logger.Batch("final commitment: validMembers=%d, signers=%d, quorumPublicKey=%s, time1=%d, time2=%d, time3=%d",
+                    fqc.CountValidMembers(), fqc.CountSigners(), fqc.quorumPublicKey.ToString(),
+                    t1.count(), t2.count(), t3.count());
+
+    fqcRet = std::move(fqc);
+    return true;
+}
+
+void CDKGSession::ScheduleSpeculativeFinalCommitment(const std::vector<bool>& validMembers)
+{
+    if (!AreWeMember()) {
+        // FinalizeCommitments won't use it
+        return;
+    }
+
+    {
+        LOCK(cs_speculative);
+        auto& spec = speculativeFinalCommitments[validMembers];
+        if (spec.fInProgress) {
+            // the running build will start over when it's done
+            spec.fDirty = true;
+            return;
+        }
+        spec.fInProgress = true;
+        spec.fDirty = false;
+    }
+
+    std::weak_ptr<CDKGSession> weakThis = shared_from_this();
+    blsWorker.AsyncRun([weakThis, validMembers]() {
+        auto session = weakThis.lock();
+        if (session) {
+            session->BuildSpeculativeFinalCommitment(validMembers);
+        }
+    });
+}
+
+void CDKGSession::BuildSpeculativeFinalCommitment(const std::vector<bool>& validMembers)
+{
+    while (true) {
+        auto cvec = GetValidPrematureCommitments(validMembers);
+
+        CFinalCommitment fqc;
+        bool fValid = cvec.size() >= params.minSize && BuildFinalCommitment(cvec, fqc);
+
+        LOCK(cs_speculative);
+        auto& spec = speculativeFinalCommitments[validMembers];
+        spec.nCommitments = cvec.size();
+        spec.fValid = fValid;
+        spec.fqc = std::move(fqc);
+        if (!spec.fDirty) {
+            spec.fInProgress = false;
+            return;
+        }
+        spec.fDirty = false;
+    }
 }
 
 CDKGMember* CDKGSession::GetMember(const uint256& proTxHash) const
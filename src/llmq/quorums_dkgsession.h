@@ -14,14 +14,17 @@
 
 #include <evo/deterministicmns.h>
 
+#include <llmq/quorums_commitment.h>
 #include <llmq/quorums_utils.h>
 
+#include <condition_variable>
+#include <memory>
+
 class UniValue;
 
 namespace llmq
 {
 
-class CFinalCommitment;
 class CDKGSession;
 class CDKGSessionManager;
 class CDKGPendingMessages;
@@ -236,13 +239,17 @@ public:
  * The contributions stored by CDKGSessionManager are then later loaded by the quorum instances and used for signing
  * sessions, but only if the local node is a member of the quorum.
  */
-class CDKGSession
+class CDKGSession : public std::enable_shared_from_this<CDKGSession>
 {
     friend class CDKGSessionHandler;
     friend class CDKGSessionManager;
     friend class CDKGLogger;
 
 private:
+    // number of contributions verified by a single job on the CBLSWorker. Matches the aggregation batch size used by
+    // CBLSWorker::AsyncVerifyContributionShares, so a job of valid contributions needs a single verification
+    static const size_t CONTRIBUTION_VERIFY_JOB_SIZE = 8;
+
     const Consensus::LLMQParams& params;
 
     CBLSWorker& blsWorker;
@@ -282,12 +289,31 @@ private:
     mutable CCriticalSection cs_pending;
     std::vector<size_t> pendingContributionVerifications;
 
+    // number of contribution verification jobs scheduled on the shared CBLSWorker queue which did not finish yet
+    std::mutex verifyJobsMutex;
+    std::condition_variable verifyJobsCv;
+    int verifyJobsInProgress{0};
+
     // filled by ReceivePrematureCommitment and used by FinalizeCommitments
     std::set<uint256> validCommitments;
 
+    // Final commitments are built speculatively on the CBLSWorker while premature commitments arrive, so that
+    // FinalizeCommitments only has to pick up the results at the end of the commit phase. Keyed by validMembers
+    struct SpeculativeFinalCommitment {
+        bool fInProgress{false};
+        // more premature commitments arrived while the build was in progress
+        bool fDirty{false};
+        // number of premature commitments the result was built from
+        size_t nCommitments{0};
+        bool fValid{false};
+        CFinalCommitment fqc;
+    };
+    CCriticalSection cs_speculative;
+    std::map<std::vector<bool>, SpeculativeFinalCommitment> speculativeFinalCommitments;
+
 public:
     CDKGSession(const Consensus::LLMQParams& _params, CBLSWorker& _blsWorker, CDKGSessionManager& _dkgManager) :
-        params(_params), blsWorker(_blsWorker), cache(_blsWorker), dkgManager(_dkgManager) {}
+        params(_params), blsWorker(_blsWorker), cache(_blsWorker, CLLMQUtils::GetDKGBLSCacheSize()), dkgManager(_dkgManager) {}
 
     bool Init(const CBlockIndex* pindexQuorum, const std::vector<CDeterministicMNCPtr>& mns, const uint256& _myProTxHash);
 
@@ -312,6 +338,8 @@ public:
     bool PreVerifyMessage(const CDKGContribution& qc, bool& retBan) const;
     void ReceiveMessage(const CDKGContribution& qc, bool& retBan);
     void VerifyPendingContributions();
+    void HandleVerifiedContributions(const std::vector<size_t>& memberIndexes, const BLSSecretKeyVector& skContributions, const std::vector<bool>& result);
+    void WaitForContributionVerifications();
 
     // Phase 2: complaint
     void VerifyAndComplain(CDKGPendingMessages& pendingMessages);
@@ -334,6 +362,10 @@ public:
 
     // Phase 5: aggregate/finalize
     std::vector<CFinalCommitment> FinalizeCommitments();
+    std::vector<CDKGPrematureCommitment> GetValidPrematureCommitments(const std::vector<bool>& validMembers) const;
+    bool BuildFinalCommitment(const std::vector<CDKGPrematureCommitment>& cvec, CFinalCommitment& fqcRet) const;
+    void ScheduleSpeculativeFinalCommitment(const std::vector<bool>& validMembers);
+    void BuildSpeculativeFinalCommitment(const std::vector<bool>& validMembers);
 
     bool AreWeMember() const { return !myProTxHash.IsNull(); }
     void MarkBadMember(size_t idx);
@@ -16,9 +16,10 @@
 namespace llmq
 {
 
-CDKGPendingMessages::CDKGPendingMessages(size_t _maxMessagesPerNode, int _invType) :
+CDKGPendingMessages::CDKGPendingMessages(size_t _maxMessagesPerNode, size_t _maxPendingBytes, int _invType) :
+    invType(_invType),
     maxMessagesPerNode(_maxMessagesPerNode),
-    invType(_invType)
+    maxPendingBytes(_maxPendingBytes)
 {
 }
 
@@ -38,19 +39,77 @@ void CDKGPendingMessages::PushPendingMessage(NodeId from, CDataStream& vRecv)
 
     LOCK(cs);
 
+    if (fPhasePassed) {
+        LogPrint(BCLog::LLMQ_DKG, "CDKGPendingMessages::%s -- phase already passed, dropping %s, peer=%d\n", __func__, hash.ToString(), from);
+        return;
+    }
+
+    // check for duplicates first, so that they don't count against the limits of the node
+    if (seenMessages.count(hash)) {
+        LogPrint(BCLog::LLMQ_DKG, "CDKGPendingMessages::%s -- already seen %s, peer=%d\n", __func__, hash.ToString(), from);
+        return;
+    }
+
     if (messagesPerNode[from] >= maxMessagesPerNode) {
         // TODO ban?
         LogPrint(BCLog::LLMQ_DKG, "CDKGPendingMessages::%s -- too many messages, peer=%d\n", __func__, from);
         return;
     }
-    messagesPerNode[from]++;
 
-    if (!seenMessages.emplace(hash).second) {
-        LogPrint(BCLog::LLMQ_DKG, "CDKGPendingMessages::%s -- already seen %s, peer=%d\n", __func__, hash.ToString(), from);
+    const size_t size = pm->size();
+    if (!MakeRoom(from, size)) {
+        LogPrint(BCLog::LLMQ_DKG, "CDKGPendingMessages::%s -- pending messages limit reached, dropping %s, peer=%d\n", __func__, hash.ToString(), from);
         return;
     }
 
-    pendingMessages.emplace_back(std::make_pair(from, std::move(pm)));
+    messagesPerNode[from]++;
+    seenMessages.emplace(hash);
+
+    auto& q = pendingMessages[from];
+    q.messages.emplace_back(PendingMessage{hash, std::move(pm)});
+    q.bytes += size;
+    pendingBytes += size;
+}
+
+// Evicts the newest messages of the node with the most queued bytes until a message of the given size fits into the
+// budget. Returns false if the sending node is itself the largest one, in which case the new message must be dropped
+// cs must be held while calling
+bool CDKGPendingMessages::MakeRoom(NodeId from, size_t size)
+{
+    AssertLockHeld(cs);
+
+    if (size > maxPendingBytes) {
+        return false;
+    }
+
+    while (pendingBytes + size > maxPendingBytes) {
+        auto itFrom = pendingMessages.find(from);
+        size_t fromBytes = (itFrom != pendingMessages.end() ? itFrom->second.bytes : 0) + size;
+
+        auto itLargest = pendingMessages.end();
+        for (auto it = pendingMessages.begin(); it != pendingMessages.end(); ++it) {
+            if (it->first != from && (itLargest == pendingMessages.end() || it->second.bytes > itLargest->second.bytes)) {
+                itLargest = it;
+            }
+        }
+        if (itLargest == pendingMessages.end() || itLargest->second.bytes <= fromBytes) {
+            return false;
+        }
+
+        auto& q = itLargest->second;
+        auto& evicted = q.messages.back();
+        LogPrint(BCLog::LLMQ_DKG, "CDKGPendingMessages::%s -- pending messages limit reached, evicting %s, peer=%d\n", __func__, evicted.hash.ToString(), itLargest->first);
+        // allow the message to be received again later
+        seenMessages.erase(evicted.hash);
+        messagesPerNode[itLargest->first]--;
+        q.bytes -= evicted.data->size();
+        pendingBytes -= evicted.data->size();
+        q.messages.pop_back();
+        if (q.messages.empty()) {
+            pendingMessages.erase(itLargest);
+        }
+    }
+    return true;
 }
 
 std::list<CDKGPendingMessages::BinaryMessage> CDKGPendingMessages::PopPendingMessages(size_t maxCount)
@@ -59,8 +118,23 @@ std::list<CDKGPendingMessages::BinaryMessage> CDKGPendingMessages::PopPendingMes
 
     std::list<BinaryMessage> ret;
     while (!pendingMessages.empty() && ret.size() < maxCount) {
-        ret.emplace_back(std::move(pendingMessages.front()));
-        pendingMessages.pop_front();
+        // round-robin over all nodes with pending messages, starting with the one after the last served node
+        auto it = pendingMessages.upper_bound(lastPoppedNode);
+        if (it == pendingMessages.end()) {
+            it = pendingMessages.begin();
+        }
+
+        auto& q = it->second;
+        auto& pm = q.messages.front();
+        q.bytes -= pm.data->size();
+        pendingBytes -= pm.data->size();
+        ret.emplace_back(std::make_pair(it->first, std::move(pm.data)));
+        q.messages.pop_front();
+
+        lastPoppedNode = it->first;
+        if (q.messages.empty()) {
+            pendingMessages.erase(it);
+        }
     }
 
     return std::move(ret);
@@ -76,8 +150,54 @@ void CDKGPendingMessages::Clear()
 {
     LOCK(cs);
     pendingMessages.clear();
+    pendingBytes = 0;
+    lastPoppedNode = -1;
     messagesPerNode.clear();
     seenMessages.clear();
+    fPhasePassed = false;
+}
+
+void CDKGPendingMessages::DropPendingForPassedPhase()
+{
+    LOCK(cs);
+    if (!pendingMessages.empty()) {
+        LogPrint(BCLog::LLMQ_DKG, "CDKGPendingMessages::%s -- dropping %d bytes of pending messages\n", __func__, pendingBytes);
+    }
+    pendingMessages.clear();
+    pendingBytes = 0;
+    fPhasePassed = true;
+}
+
+// Upper bounds for the serialized size of a single DKG message, based on the quorum parameters. Used to limit the
+// memory used by each CDKGPendingMessages instance to what a full quorum, including double messages, could send
+static size_t GetMaxPendingBytes(const Consensus::LLMQParams& params, int invType)
+{
+    const size_t size = (size_t)params.size;
+    // type, quorumHash, proTxHash and sig
+    const size_t baseSize = 1 + 32 + 32 + 96;
+    size_t msgSize;
+    switch (invType) {
+    case MSG_QUORUM_CONTRIB:
+        // vvec + encrypted secret key share for each member (IV and padding included)
+        msgSize = baseSize + (size_t)params.threshold * 48 + 48 + 32 + size * 64;
+        break;
+    case MSG_QUORUM_COMPLAINT:
+        // two bitsets
+        msgSize = baseSize + size / 4 + 16;
+        break;
+    case MSG_QUORUM_JUSTIFICATION:
+        // member index and secret key share for each member
+        msgSize = baseSize + size * (4 + 32) + 8;
+        break;
+    case MSG_QUORUM_PREMATURE_COMMITMENT:
+        // bitset, quorum public key, vvec hash and quorumSig
+        msgSize = baseSize + size / 8 + 48 + 32 + 96 + 8;
+        break;
+    default:
+        assert(false);
+    }
+    // leave some room for larger than expected encodings
+    return size * 2 * msgSize * 5 / 4;
 }
 
 //////
@@ -87,10 +207,11 @@ CDKGSessionHandler::CDKGSessionHandler(const Consensus::LLMQParams& _params, CBL
     blsWorker(_blsWorker),
     dkgManager(_dkgManager),
     curSession(std::make_shared<CDKGSession>(_params, _blsWorker, _dkgManager)),
-    pendingContributions((size_t)_params.size * 2, MSG_QUORUM_CONTRIB), // we allow size*2 messages as we need to make sure we see bad behavior (double messages)
-    pendingComplaints((size_t)_params.size * 2, MSG_QUORUM_COMPLAINT),
-    pendingJustifications((size_t)_params.size * 2, MSG_QUORUM_JUSTIFICATION),
-    pendingPrematureCommitments((size_t)_params.size * 2, MSG_QUORUM_PREMATURE_COMMITMENT)
+    // we allow size*2 messages as we need to make sure we see bad behavior (double messages)
+    pendingContributions((size_t)_params.size * 2, GetMaxPendingBytes(_params, MSG_QUORUM_CONTRIB), MSG_QUORUM_CONTRIB),
+    pendingComplaints((size_t)_params.size * 2, GetMaxPendingBytes(_params, MSG_QUORUM_COMPLAINT), MSG_QUORUM_COMPLAINT),
+    pendingJustifications((size_t)_params.size * 2, GetMaxPendingBytes(_params, MSG_QUORUM_JUSTIFICATION), MSG_QUORUM_JUSTIFICATION),
+    pendingPrematureCommitments((size_t)_params.size * 2, GetMaxPendingBytes(_params, MSG_QUORUM_PREMATURE_COMMITMENT), MSG_QUORUM_PREMATURE_COMMITMENT)
 {
     if (params.type == Consensus::LLMQ_NONE) {
         throw std::runtime_error("Can't initialize CDKGSessionHandler with LLMQ_NONE type.");
@@ -318,9 +439,25 @@ void CDKGSessionHandler::HandlePhase(QuorumPhase curPhase,
 {
     LogPrint(BCLog::LLMQ_DKG, "CDKGSessionManager::%s -- %s - starting, curPhase=%d, nextPhase=%d\n", __func__, params.name, curPhase, nextPhase);
 
-    SleepBeforePhase(curPhase, expectedQuorumHash, randomSleepFactor, runWhileWaiting);
+    quorumDKGDebugManager->StartLocalPhase(params.type, curPhase);
+    int64_t nPhaseStartTime = GetTimeMillis();
+
+    // everything which is not spent in our own processing is spent waiting for peers and the next phase
+    int64_t nWorkTime = 0;
+    auto runWhileWaitingTimed = [&]() {
+        int64_t nStart = GetTimeMillis();
+        bool ret = runWhileWaiting();
+        nWorkTime += GetTimeMillis() - nStart;
+        return ret;
+    };
+
+    SleepBeforePhase(curPhase, expectedQuorumHash, randomSleepFactor, runWhileWaitingTimed);
+    int64_t nStart = GetTimeMillis();
     startPhaseFunc();
-    WaitForNextPhase(curPhase, nextPhase, expectedQuorumHash, runWhileWaiting);
+    nWorkTime += GetTimeMillis() - nStart;
+    WaitForNextPhase(curPhase, nextPhase, expectedQuorumHash, runWhileWaitingTimed);
+
+    quorumDKGDebugManager->FinishLocalPhase(params.type, curPhase, GetTimeMillis() - nPhaseStartTime - nWorkTime);
 
     LogPrint(BCLog::LLMQ_DKG, "CDKGSessionManager::%s -- %s - done, curPhase=%d, nextPhase=%d\n", __func__, params.name, curPhase, nextPhase);
 }
@@ -536,6 +673,7 @@ void CDKGSessionHandler::HandleDKGRound()
         return ProcessPendingMessageBatch<CDKGContribution, MSG_QUORUM_CONTRIB>(*curSession, pendingContributions, 8);
     };
     HandlePhase(QuorumPhase_Contribute, QuorumPhase_Complain, curQuorumHash, 0.05, fContributeStart, fContributeWait);
+    pendingContributions.DropPendingForPassedPhase();
 
     // Complain
     auto fComplainStart = [this]() {
@@ -545,6 +683,7 @@ void CDKGSessionHandler::HandleDKGRound()
         return ProcessPendingMessageBatch<CDKGComplaint, MSG_QUORUM_COMPLAINT>(*curSession, pendingComplaints, 8);
     };
     HandlePhase(QuorumPhase_Complain, QuorumPhase_Justify, curQuorumHash, 0.05, fComplainStart, fComplainWait);
+    pendingComplaints.DropPendingForPassedPhase();
 
     // Justify
     auto fJustifyStart = [this]() {
@@ -554,6 +693,7 @@ void CDKGSessionHandler::HandleDKGRound()
         return ProcessPendingMessageBatch<CDKGJustification, MSG_QUORUM_JUSTIFICATION>(*curSession, pendingJustifications, 8);
     };
     HandlePhase(QuorumPhase_Justify, QuorumPhase_Commit, curQuorumHash, 0.05, fJustifyStart, fJustifyWait);
+    pendingJustifications.DropPendingForPassedPhase();
 
     // Commit
     auto fCommitStart = [this]() {
@@ -563,11 +703,14 @@ void CDKGSessionHandler::HandleDKGRound()
         return ProcessPendingMessageBatch<CDKGPrematureCommitment, MSG_QUORUM_PREMATURE_COMMITMENT>(*curSession, pendingPrematureCommitments, 8);
     };
     HandlePhase(QuorumPhase_Commit, QuorumPhase_Finalize, curQuorumHash, 0.1, fCommitStart, fCommitWait);
+    pendingPrematureCommitments.DropPendingForPassedPhase();
 
+    quorumDKGDebugManager->StartLocalPhase(params.type, QuorumPhase_Finalize);
     auto finalCommitments = curSession->FinalizeCommitments();
     for (const auto& fqc : finalCommitments) {
         quorumBlockProcessor->AddMinableCommitment(fqc);
     }
+    quorumDKGDebugManager->FinishLocalPhase(params.type, QuorumPhase_Finalize, 0);
 }
 
 void CDKGSessionHandler::PhaseHandlerThread()
@@ -11,6 +11,8 @@
 
 #include <ctpl.h>
 
+#include <deque>
+
 namespace llmq
 {
 
@@ -26,11 +28,16 @@ enum QuorumPhase {
 };
 
 /**
- * Acts as a FIFO queue for incoming DKG messages. The reason we need this is that deserialization of these messages
+ * Acts as a queue for incoming DKG messages. The reason we need this is that deserialization of these messages
  * is too slow to be processed in the main message handler thread. So, instead of processing them directly from the
  * main handler thread, we push them into a CDKGPendingMessages object and later pop+deserialize them in the DKG phase
  * handler thread.
  *
+ * Messages are queued per node and popped round-robin, so that a single (spamming) node can't delay the messages of
+ * all other nodes. Duplicates are dropped on arrival and the total size of all queued messages is limited. When the
+ * limit is reached, messages of the node which currently occupies most of the queue are dropped first. Once the phase
+ * which handles the message type has passed, queued messages are dropped and no new messages are accepted.
+ *
  * Each message type has it's own instance of this class.
  */
 class CDKGPendingMessages
@@ -39,25 +46,48 @@ public:
     typedef std::pair<NodeId, std::shared_ptr<CDataStream>> BinaryMessage;
 
 private:
+    struct PendingMessage {
+        uint256 hash;
+        std::shared_ptr<CDataStream> data;
+    };
+    struct NodeQueue {
+        std::deque<PendingMessage> messages;
+        size_t bytes{0};
+    };
+
     mutable CCriticalSection cs;
     int invType;
     size_t maxMessagesPerNode;
-    std::list<BinaryMessage> pendingMessages;
+    size_t maxPendingBytes;
+    std::map<NodeId, NodeQueue> pendingMessages;
+    size_t pendingBytes{0};
+    // the node which was served last by PopPendingMessages
+    NodeId lastPoppedNode{-1};
     std::map<NodeId, size_t> messagesPerNode;
     std::set<uint256> seenMessages;
+    bool fPhasePassed{false};
 
 public:
-    explicit CDKGPendingMessages(size_t _maxMessagesPerNode, int _invType);
+    CDKGPendingMessages(size_t _maxMessagesPerNode, size_t _maxPendingBytes, int _invType);
 
     void PushPendingMessage(NodeId from, CDataStream& vRecv);
     std::list<BinaryMessage> PopPendingMessages(size_t maxCount);
     bool HasSeen(const uint256& hash) const;
     void Clear();
+    // Drops all queued messages and rejects new ones until the next Clear(). Seen messages are still remembered
+    void DropPendingForPassedPhase();
 
+private:
+    bool MakeRoom(NodeId from, size_t size);
+
+public:
     template<typename Message>
     void PushPendingMessage(NodeId from, Message& msg)
     {
+        // Reserve the exact size up front. Contributions of large quorums are big and letting the stream grow while
+        // serializing would briefly hold multiple copies of the message
         CDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
+        ds.reserve(::GetSerializeSize(msg, SER_NETWORK, PROTOCOL_VERSION));
         ds << msg;
         PushPendingMessage(from, ds);
     }
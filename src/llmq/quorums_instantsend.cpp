@@ -12,6 +12,7 @@
 #include <masternode/masternode-sync.h>
 #include <net_processing.h>
 #include <spork.h>
+#include <statsd_client.h>
 #include <validation.h>
 
 #include <cxxtimer.hpp>
@@ -47,8 +48,232 @@ uint256 CInstantSendLock::GetRequestId() const
 
 ////////////////
 
+CInstantSendOutpointIndex::CInstantSendOutpointIndex() :
+    k0(GetRand(std::numeric_limits<uint64_t>::max())),
+    k1(GetRand(std::numeric_limits<uint64_t>::max()))
+{
+}
+
+void CInstantSendOutpointIndex::Init(size_t nMemoryBudget)
+{
+    table.clear();
+    table.shrink_to_fit();
+    count = 0;
+
+    // capacities are powers of 2
+    maxCapacity = 0;
+    for (size_t c = MIN_CAPACITY; c * sizeof(Entry) <= nMemoryBudget; c *= 2) {
+        maxCapacity = c;
+    }
+    fComplete = maxCapacity != 0 && Resize(MIN_CAPACITY);
+}
+
+void CInstantSendOutpointIndex::MarkIncomplete()
+{
+    if (fComplete) {
+        LogPrintf("CInstantSendOutpointIndex::%s -- index exceeds its memory budget with %d entries, falling back to database lookups\n", __func__, count);
+    }
+    table.clear();
+    table.shrink_to_fit();
+    count = 0;
+    fComplete = false;
+}
+
+uint64_t CInstantSendOutpointIndex::GetFingerprint(const COutPoint& outpoint) const
+{
+    uint64_t fingerprint = SipHashUint256Extra(k0, k1, outpoint.hash, outpoint.n);
+    // 0 marks empty slots
+    return fingerprint != 0 ? fingerprint : 1;
+}
+
+size_t CInstantSendOutpointIndex::FindSlot(uint64_t fingerprint) const
+{
+    const size_t mask = table.size() - 1;
+    size_t i = (size_t)fingerprint & mask;
+    while (table[i].fingerprint != 0 && table[i].fingerprint != fingerprint) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+bool CInstantSendOutpointIndex::Resize(size_t newCapacity)
+{
+    if (newCapacity > maxCapacity) {
+        return false;
+    }
+
+    std::vector<Entry> oldTable;
+    oldTable.swap(table);
+    table.resize(newCapacity);
+    for (const auto& e : oldTable) {
+        if (e.fingerprint != 0) {
+            table[FindSlot(e.fingerprint)] = e;
+        }
+    }
+    return true;
+}
+
+void CInstantSendOutpointIndex::Add(const COutPoint& outpoint, const uint256& islockHash)
+{
+    if (!fComplete) {
+        return;
+    }
+
+    // keep the load factor below 3/4
+    if ((count + 1) * 4 > table.size() * 3 && !Resize(table.size() * 2)) {
+        MarkIncomplete();
+        return;
+    }
+
+    uint64_t fingerprint = GetFingerprint(outpoint);
+    auto& e = table[FindSlot(fingerprint)];
+    if (e.fingerprint == 0) {
+        e.fingerprint = fingerprint;
+        count++;
+    }
+    // same as the database, a newer islock for the same outpoint overwrites the older one
+    e.islockHash = islockHash;
+}
+
+void CInstantSendOutpointIndex::Remove(const COutPoint& outpoint)
+{
+    if (!fComplete) {
+        return;
+    }
+
+    const size_t mask = table.size() - 1;
+    size_t i = FindSlot(GetFingerprint(outpoint));
+    if (table[i].fingerprint == 0) {
+        return;
+    }
+
+    // backward shift deletion, so that we don't need tombstones
+    size_t j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        if (table[j].fingerprint == 0) {
+            break;
+        }
+        size_t home = (size_t)table[j].fingerprint & mask;
+        // move entry j into the hole at i if its home slot is not in the (cyclic) range (i, j]
+        if ((j > i && (home <= i || home > j)) || (j < i && (home <= i && home > j))) {
+            table[i] = table[j];
+            i = j;
+        }
+    }
+    table[i] = Entry();
+    count--;
+}
+
+bool CInstantSendOutpointIndex::Lookup(const COutPoint& outpoint, uint256& islockHashRet) const
+{
+    if (!fComplete) {
+        return false;
+    }
+
+    const auto& e = table[FindSlot(GetFingerprint(outpoint))];
+    if (e.fingerprint == 0) {
+        islockHashRet.SetNull();
+    } else {
+        islockHashRet = e.islockHash;
+    }
+    return true;
+}
+
+////////////////
+
+void CInstantSendKnownLocks::Add(const uint256& islockHash, const uint256& txid)
+{
+    AddKnownHash(islockHash);
+
+    auto& shard = GetShard(txid);
+    LOCK(shard.cs);
+    shard.txids.insert(txid, islockHash);
+}
+
+void CInstantSendKnownLocks::AddKnownHash(const uint256& islockHash)
+{
+    auto& shard = GetShard(islockHash);
+    LOCK(shard.cs);
+    shard.islockHashes.insert(islockHash, true);
+}
+
+void CInstantSendKnownLocks::RemoveTxid(const uint256& txid)
+{
+    auto& shard = GetShard(txid);
+    LOCK(shard.cs);
+    shard.txids.erase(txid);
+}
+
+void CInstantSendKnownLocks::RemoveKnownHash(const uint256& islockHash)
+{
+    auto& shard = GetShard(islockHash);
+    LOCK(shard.cs);
+    shard.islockHashes.erase(islockHash);
+}
+
+void CInstantSendKnownLocks::Clear()
+{
+    for (auto& shard : shards) {
+        LOCK(shard.cs);
+        shard.txids.clear();
+        shard.islockHashes.clear();
+    }
+}
+
+bool CInstantSendKnownLocks::GetHashByTxid(const uint256& txid, uint256& islockHashRet) const
+{
+    auto& shard = GetShard(txid);
+    LOCK(shard.cs);
+    return shard.txids.get(txid, islockHashRet);
+}
+
+bool CInstantSendKnownLocks::IsKnownHash(const uint256& islockHash) const
+{
+    auto& shard = GetShard(islockHash);
+    LOCK(shard.cs);
+    return shard.islockHashes.exists(islockHash);
+}
+
+////////////////
+
 CInstantSendDb::CInstantSendDb(CDBWrapper& _db) : db(_db)
 {
+    BuildOutpointIndex();
+}
+
+void CInstantSendDb::BuildOutpointIndex()
+{
+    int64_t nBudget = gArgs.GetArg("-islockindexmemory", DEFAULT_ISLOCK_INDEX_MEMORY);
+    outpointIndex.Init(nBudget > 0 ? (size_t)nBudget << 20 : 0);
+    if (!outpointIndex.IsComplete()) {
+        return;
+    }
+
+    int64_t nStart = GetTimeMillis();
+
+    auto it = std::unique_ptr<CDBIterator>(db.NewIterator());
+    auto firstKey = std::make_tuple(std::string(DB_HASH_BY_OUTPOINT), COutPoint());
+    it->Seek(firstKey);
+
+    while (it->Valid() && outpointIndex.IsComplete()) {
+        decltype(firstKey) curKey;
+        if (!it->GetKey(curKey) || std::get<0>(curKey) != DB_HASH_BY_OUTPOINT) {
+            break;
+        }
+        uint256 islockHash;
+        if (!it->GetValue(islockHash)) {
+            outpointIndex.MarkIncomplete();
+            break;
+        }
+        outpointIndex.Add(std::get<1>(curKey), islockHash);
+        it->Next();
+    }
+
+    if (outpointIndex.IsComplete()) {
+        LogPrintf("CInstantSendDb::%s -- indexed %d islock inputs using %d bytes in %dms\n", __func__,
+                  outpointIndex.size(), outpointIndex.GetMemoryUsage(), GetTimeMillis() - nStart);
+    }
 }
 
 void CInstantSendDb::Upgrade()
@@ -83,6 +308,10 @@ void CInstantSendDb::Upgrade()
         }
         batch.Write(DB_VERSION, CInstantSendDb::CURRENT_VERSION);
         db.WriteBatch(batch);
+
+        // the upgrade dropped entries behind the back of the index
+        BuildOutpointIndex();
+        knownLocks.Clear();
     }
 }
 
@@ -101,7 +330,9 @@ void CInstantSendDb::WriteNewInstantSendLock(const uint256& hash, const CInstant
     txidCache.insert(islock.txid, hash);
     for (auto& in : islock.inputs) {
         outpointCache.insert(in, hash);
+        outpointIndex.Add(in, hash);
     }
+    knownLocks.Add(hash, islock.txid);
 }
 
 void CInstantSendDb::RemoveInstantSendLock(CDBBatch& batch, const uint256& hash, CInstantSendLockPtr islock, bool keep_cache)
@@ -117,7 +348,10 @@ void CInstantSendDb::RemoveInstantSendLock(CDBBatch& batch, const uint256& hash,
     batch.Erase(std::make_tuple(std::string(DB_HASH_BY_TXID), islock->txid));
     for (auto& in : islock->inputs) {
         batch.Erase(std::make_tuple(std::string(DB_HASH_BY_OUTPOINT), in));
+        outpointIndex.Remove(in);
     }
+    // the hash itself stays known as the callers archive it
+    knownLocks.RemoveTxid(islock->txid);
 
     if (!keep_cache) {
         islockCache.erase(hash);
@@ -156,8 +390,9 @@ void CInstantSendDb::WriteInstantSendLockArchived(CDBBatch& batch, const uint256
     batch.Write(std::make_tuple(std::string(DB_ARCHIVED_BY_HASH), hash), true);
 }
 
-std::unordered_map<uint256, CInstantSendLockPtr> CInstantSendDb::RemoveConfirmedInstantSendLocks(int nUntilHeight)
+std::unordered_map<uint256, CInstantSendLockPtr> CInstantSendDb::RemoveConfirmedInstantSendLocks(int nUntilHeight, size_t nMaxCount, bool& fMoreRet)
 {
+    fMoreRet = false;
     if (nUntilHeight <= 0) {
         return {};
     }
@@ -179,13 +414,18 @@ std::unordered_map<uint256, CInstantSendLockPtr> CInstantSendDb::RemoveConfirmed
         if (nHeight > nUntilHeight) {
             break;
         }
+        if (ret.size() >= nMaxCount) {
+            fMoreRet = true;
+            break;
+        }
 
         auto& islockHash = std::get<2>(curKey);
         auto islock = GetInstantSendLockByHash(islockHash, false);
         if (islock) {
             RemoveInstantSendLock(batch, islockHash, islock);
-            ret.emplace(islockHash, islock);
         }
+        // also count entries without an islock, so that a chunk is always bounded
+        ret.emplace(islockHash, islock);
 
         // archive the islock hash, so that we're still able to check if we've seen the islock in the past
         WriteInstantSendLockArchived(batch, islockHash, nHeight);
@@ -200,10 +440,11 @@ std::unordered_map<uint256, CInstantSendLockPtr> CInstantSendDb::RemoveConfirmed
     return ret;
 }
 
-void CInstantSendDb::RemoveArchivedInstantSendLocks(int nUntilHeight)
+size_t CInstantSendDb::RemoveArchivedInstantSendLocks(int nUntilHeight, size_t nMaxCount, bool& fMoreRet)
 {
+    fMoreRet = false;
     if (nUntilHeight <= 0) {
-        return;
+        return 0;
     }
 
     auto it = std::unique_ptr<CDBIterator>(db.NewIterator());
@@ -213,6 +454,7 @@ void CInstantSendDb::RemoveArchivedInstantSendLocks(int nUntilHeight)
     it->Seek(firstKey);
 
     CDBBatch batch(db);
+    size_t cnt = 0;
     while (it->Valid()) {
         decltype(firstKey) curKey;
         if (!it->GetKey(curKey) || std::get<0>(curKey) != DB_ARCHIVED_BY_HEIGHT_AND_HASH) {
@@ -222,15 +464,23 @@ void CInstantSendDb::RemoveArchivedInstantSendLocks(int nUntilHeight)
         if (nHeight > nUntilHeight) {
             break;
         }
+        if (cnt >= nMaxCount) {
+            fMoreRet = true;
+            break;
+        }
 
         auto& islockHash = std::get<2>(curKey);
         batch.Erase(std::make_tuple(std::string(DB_ARCHIVED_BY_HASH), islockHash));
         batch.Erase(curKey);
+        knownLocks.RemoveKnownHash(islockHash);
+        cnt++;
 
         it->Next();
     }
 
     db.WriteBatch(batch);
+
+    return cnt;
 }
 
 void CInstantSendDb::WriteBlockInstantSendLocks(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexConnected)
@@ -331,6 +581,21 @@ CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByTxid(const uint256& txid
 CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByInput(const COutPoint& outpoint) const
 {
     uint256 islockHash;
+    if (outpointIndex.Lookup(outpoint, islockHash)) {
+        if (islockHash.IsNull()) {
+            // not locked according to the db, but removed islocks might still be kept in the caches (see keep_cache)
+            if (!outpointCache.get(outpoint, islockHash)) {
+                return nullptr;
+            }
+            return GetInstantSendLockByHash(islockHash);
+        }
+        auto islock = GetInstantSendLockByHash(islockHash);
+        if (islock && std::find(islock->inputs.begin(), islock->inputs.end(), outpoint) != islock->inputs.end()) {
+            return islock;
+        }
+        // fingerprint collision, do the full lookup
+    }
+
     if (!outpointCache.get(outpoint, islockHash)) {
         db.Read(std::make_tuple(std::string(DB_HASH_BY_OUTPOINT), outpoint), islockHash);
         outpointCache.insert(outpoint, islockHash);
@@ -422,6 +687,20 @@ void CInstantSendManager::Start()
         assert(false);
     }
 
+    archiveChunkSize = (size_t)std::max<int64_t>(1, gArgs.GetArg("-islockarchivechunk", DEFAULT_ISLOCK_ARCHIVE_CHUNK));
+    archiveTimeBudget = std::max<int64_t>(1, gArgs.GetArg("-islockarchivetime", DEFAULT_ISLOCK_ARCHIVE_TIME));
+
+    // -islockverifythreads=0 means autodetect, a single worker means we verify on the isman thread itself
+    verifyWorkerCount = (int)gArgs.GetArg("-islockverifythreads", DEFAULT_ISLOCK_VERIFY_THREADS);
+    if (verifyWorkerCount <= 0) {
+        verifyWorkerCount = GetNumCores() / 2;
+    }
+    verifyWorkerCount = std::max(1, std::min(verifyWorkerCount, MAX_ISLOCK_VERIFY_THREADS));
+    if (verifyWorkerCount > 1) {
+        verifyWorkerPool.resize(verifyWorkerCount);
+        RenameThreadPool(verifyWorkerPool, "dash-is-vrfy");
+    }
+
     workThread = std::thread(&TraceThread<std::function<void()> >, "isman", std::function<void()>(std::bind(&CInstantSendManager::WorkThreadMain, this)));
 
     quorumSigningManager->RegisterRecoveredSigsListener(this);
@@ -439,14 +718,25 @@ void CInstantSendManager::Stop()
     if (workThread.joinable()) {
         workThread.join();
     }
+
+    verifyWorkerPool.clear_queue();
+    verifyWorkerPool.stop(true);
 }
 
 void CInstantSendManager::InterruptWorkerThread()
 {
     workInterrupt();
+    SignalWork();
+}
+
+void CInstantSendManager::SignalWork()
+{
+    std::lock_guard<std::mutex> l(workMutex);
+    fWorkSignaled = true;
+    workCv.notify_one();
 }
 
-void CInstantSendManager::ProcessTx(const CTransaction& tx, bool fRetroactive, const Consensus::Params& params)
+void CInstantSendManager::ProcessTx(const CTransaction& tx, bool fRetroactive, const Consensus::Params& params, CanLockParentCache* parentCache)
 {
     if (!fMasternodeMode || !IsInstantSendEnabled() || !masternodeSync.IsBlockchainSynced()) {
         return;
@@ -469,7 +759,7 @@ void CInstantSendManager::ProcessTx(const CTransaction& tx, bool fRetroactive, c
         g_connman->RelayInvFiltered(inv, tx, LLMQS_PROTO_VERSION);
     }
 
-    if (!CheckCanLock(tx, true, params)) {
+    if (!CheckCanLock(tx, true, params, parentCache)) {
         LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txid=%s: CheckCanLock returned false\n", __func__,
                   tx.GetHash().ToString());
         return;
@@ -550,7 +840,7 @@ bool CInstantSendManager::TrySignInputLocks(const CTransaction& tx, bool fRetroa
     return true;
 }
 
-bool CInstantSendManager::CheckCanLock(const CTransaction& tx, bool printDebug, const Consensus::Params& params) const
+bool CInstantSendManager::CheckCanLock(const CTransaction& tx, bool printDebug, const Consensus::Params& params, CanLockParentCache* parentCache) const
 {
     if (tx.vin.empty()) {
         // can't lock TXs without inputs (e.g. quorum commitments)
@@ -558,8 +848,21 @@ bool CInstantSendManager::CheckCanLock(const CTransaction& tx, bool printDebug,
     }
 
     for (const auto& in : tx.vin) {
-        CAmount v = 0;
-        if (!CheckCanLock(in.prevout, printDebug, tx.GetHash(), &v, params)) {
+        // the result only depends on the parent TX as long as we're not interested in the value of the output
+        if (parentCache) {
+            auto it = parentCache->find(in.prevout.hash);
+            if (it != parentCache->end()) {
+                if (!it->second) {
+                    return false;
+                }
+                continue;
+            }
+        }
+        bool fCanLock = CheckCanLock(in.prevout, printDebug, tx.GetHash(), nullptr, params);
+        if (parentCache) {
+            parentCache->emplace(in.prevout.hash, fCanLock);
+        }
+        if (!fCanLock) {
             return false;
         }
     }
@@ -774,6 +1077,7 @@ void CInstantSendManager::ProcessMessageInstantSendLock(CNode* pfrom, const llmq
             islock->txid.ToString(), hash.ToString(), pfrom->GetId());
 
     pendingInstantSendLocks.emplace(hash, std::make_pair(pfrom->GetId(), islock));
+    SignalWork();
 }
 
 /**
@@ -805,9 +1109,9 @@ bool CInstantSendManager::ProcessPendingInstantSendLocks()
 
     {
         LOCK(cs);
-        // only process a max 32 locks at a time to avoid duplicate verification of recovered signatures which have been
-        // verified by CSigningManager in parallel
-        const size_t maxCount = 32;
+        // only process a max 32 locks per verification worker at a time to avoid duplicate verification of recovered
+        // signatures which have been verified by CSigningManager in parallel
+        const size_t maxCount = 32 * (size_t)verifyWorkerCount;
         if (pendingInstantSendLocks.size() <= maxCount) {
             pend = std::move(pendingInstantSendLocks);
         } else {
@@ -855,7 +1159,20 @@ std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(
 {
     auto llmqType = Params().GetConsensus().llmqTypeInstantSend;
 
-    CBLSBatchVerifier<NodeId, uint256> batchVerifier(false, true, 8);
+    struct PendingVerification {
+        NodeId nodeId;
+        uint256 hash;
+        uint256 signHash;
+        CBLSSignature sig;
+        CBLSPublicKey pubKey;
+    };
+
+    // Quorum selection and the reconstruction of recovered sigs happen here, while the actual signature verification
+    // is split by source node over the verification workers. Keeping all locks of a node in the same batch retains
+    // the per source fallback of the batch verifier
+    std::vector<std::vector<PendingVerification>> parts((size_t)verifyWorkerCount);
+    std::unordered_map<NodeId, size_t> partByNode;
+    std::set<NodeId> badSources;
     std::unordered_map<uint256, CRecoveredSig> recSigs;
 
     size_t verifyCount = 0;
@@ -865,12 +1182,12 @@ std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(
         auto nodeId = p.second.first;
         auto& islock = p.second.second;
 
-        if (batchVerifier.badSources.count(nodeId)) {
+        if (badSources.count(nodeId)) {
             continue;
         }
 
         if (!islock->sig.Get().IsValid()) {
-            batchVerifier.badSources.emplace(nodeId);
+            badSources.emplace(nodeId);
             continue;
         }
 
@@ -888,7 +1205,8 @@ std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(
             return {};
         }
         uint256 signHash = CLLMQUtils::BuildSignHash(llmqType, quorum->qc.quorumHash, id, islock->txid);
-        batchVerifier.PushMessage(nodeId, hash, signHash, islock->sig.Get(), quorum->qc.quorumPublicKey);
+        auto partIt = partByNode.emplace(nodeId, partByNode.size() % parts.size()).first;
+        parts[partIt->second].emplace_back(PendingVerification{nodeId, hash, signHash, islock->sig.Get(), quorum->qc.quorumPublicKey});
         verifyCount++;
 
         // We can reconstruct the CRecoveredSig objects from the islock and pass it to the signing manager, which
@@ -905,18 +1223,49 @@ std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(
         }
     }
 
+    parts.erase(std::remove_if(parts.begin(), parts.end(), [](const std::vector<PendingVerification>& v) {
+        return v.empty();
+    }), parts.end());
+
+    auto verifyPart = [](const std::vector<PendingVerification>& part) {
+        CBLSBatchVerifier<NodeId, uint256> batchVerifier(false, true, 8);
+        for (const auto& v : part) {
+            batchVerifier.PushMessage(v.nodeId, v.hash, v.signHash, v.sig, v.pubKey);
+        }
+        batchVerifier.Verify();
+        return std::make_pair(std::move(batchVerifier.badSources), std::move(batchVerifier.badMessages));
+    };
+
     cxxtimer::Timer verifyTimer(true);
-    batchVerifier.Verify();
+    std::set<uint256> badMessages;
+    if (parts.size() == 1) {
+        auto r = verifyPart(parts[0]);
+        badSources.insert(r.first.begin(), r.first.end());
+        badMessages = std::move(r.second);
+    } else if (!parts.empty()) {
+        std::vector<std::future<std::pair<std::set<NodeId>, std::set<uint256>>>> futures;
+        futures.reserve(parts.size());
+        for (const auto& part : parts) {
+            futures.emplace_back(verifyWorkerPool.push([&verifyPart, &part](int threadId) {
+                return verifyPart(part);
+            }));
+        }
+        for (auto& f : futures) {
+            auto r = f.get();
+            badSources.insert(r.first.begin(), r.first.end());
+            badMessages.insert(r.second.begin(), r.second.end());
+        }
+    }
     verifyTimer.stop();
 
-    LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- verified locks. count=%d, alreadyVerified=%d, vt=%d, nodes=%d\n", __func__,
-            verifyCount, alreadyVerified, verifyTimer.count(), batchVerifier.GetUniqueSourceCount());
+    LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- verified locks. count=%d, alreadyVerified=%d, vt=%d, nodes=%d, workers=%d\n", __func__,
+            verifyCount, alreadyVerified, verifyTimer.count(), partByNode.size(), parts.size());
 
     std::unordered_set<uint256> badISLocks;
 
-    if (ban && !batchVerifier.badSources.empty()) {
+    if (ban && !badSources.empty()) {
         LOCK(cs_main);
-        for (auto& nodeId : batchVerifier.badSources) {
+        for (auto& nodeId : badSources) {
             // Let's not be too harsh, as the peer might simply be unlucky and might have sent us an old lock which
             // does not validate anymore due to changed quorums
             Misbehaving(nodeId, 20);
@@ -927,7 +1276,7 @@ std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(
         auto nodeId = p.second.first;
         auto& islock = p.second.second;
 
-        if (batchVerifier.badMessages.count(hash)) {
+        if (badMessages.count(hash)) {
             LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txid=%s, islock=%s: invalid sig in islock, peer=%d\n", __func__,
                      islock->txid.ToString(), hash.ToString(), nodeId);
             badISLocks.emplace(hash);
@@ -1008,6 +1357,12 @@ void CInstantSendManager::ProcessInstantSendLock(NodeId from, const uint256& has
             db.WriteInstantSendLockMined(hash, pindexMined->nHeight);
         }
 
+        auto it = nonLockedTxs.find(islock->txid);
+        if (it != nonLockedTxs.end() && it->second.nTimeAdded != 0 && it->second.pindexMined == nullptr) {
+            statsClient.timing("instantsend.lockLatency_ms", std::max<int64_t>(GetTimeMillis() - it->second.nTimeAdded, 0), 1.0f);
+        }
+        statsClient.inc("instantsend.islocks", 1.0f);
+
         // This will also add children TXs to pendingRetryTxs
         RemoveNonLockedTx(islock->txid, true);
 
@@ -1028,7 +1383,17 @@ void CInstantSendManager::ProcessInstantSendLock(NodeId from, const uint256& has
     ResolveBlockConflicts(hash, *islock);
     RemoveMempoolConflictsForLock(hash, *islock);
 
+    if (pindexMined) {
+        // the TX is part of a recent block which we might have refrained from signing so far, no need to wait for the
+        // next regular retry
+        chainLocksHandler->ScheduleTrySignChainTip();
+    }
+
     if (tx != nullptr) {
+        if (hashBlock.IsNull()) {
+            // The TX will be mined soon, make sure connecting that block does not have to execute its scripts again
+            WarmScriptExecutionCache(*tx);
+        }
         LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- notify about an in-time lock for tx %s\n", __func__, tx->GetHash().ToString());
         GetMainSignals().NotifyTransactionLock(tx, islock);
         // bump mempool counter to make sure newly locked txes are picked up by getblocktemplate
@@ -1135,6 +1500,7 @@ void CInstantSendManager::AddNonLockedTx(const CTransactionRef& tx, const CBlock
 
     if (res.second) {
         info.tx = tx;
+        info.nTimeAdded = GetTimeMillis();
         for (const auto& in : tx->vin) {
             nonLockedTxs[in.prevout.hash].children.emplace(tx->GetHash());
             nonLockedTxsByOutpoints.emplace(in.prevout, tx->GetHash());
@@ -1162,6 +1528,9 @@ void CInstantSendManager::RemoveNonLockedTx(const uint256& txid, bool retryChild
             pendingRetryTxs.emplace(childTxid);
             retryChildrenCount++;
         }
+        if (retryChildrenCount != 0) {
+            SignalWork();
+        }
     }
 
     if (info.tx) {
@@ -1244,26 +1613,12 @@ void CInstantSendManager::HandleFullyConfirmedBlock(const CBlockIndex* pindex)
 
     LOCK(cs);
 
-    auto& consensusParams = Params().GetConsensus();
-    auto removeISLocks = db.RemoveConfirmedInstantSendLocks(pindex->nHeight);
-
-    for (auto& p : removeISLocks) {
-        auto& islockHash = p.first;
-        auto& islock = p.second;
-        LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txid=%s, islock=%s: removed islock as it got fully confirmed\n", __func__,
-                 islock->txid.ToString(), islockHash.ToString());
-
-        // No need to keep recovered sigs for fully confirmed IS locks, as there is no chance for conflicts
-        // from now on. All inputs are spent now and can't be spend in any other TX.
-        TruncateRecoveredSigsForInputs(*islock);
-
-        // And we don't need the recovered sig for the ISLOCK anymore, as the block in which it got mined is considered
-        // fully confirmed now
-        quorumSigningManager->TruncateRecoveredSig(consensusParams.llmqTypeInstantSend, islock->GetRequestId());
+    // the actual archival is done incrementally by the isman thread, see ProcessPendingArchival
+    if (pindex->nHeight > archivalStats.nTargetHeight) {
+        archivalStats.nTargetHeight = pindex->nHeight;
+        SignalWork();
     }
 
-    db.RemoveArchivedInstantSendLocks(pindex->nHeight - 100);
-
     // Find all previously unlocked TXs that got locked by this fully confirmed (ChainLock) block and remove them
     // from the nonLockedTxs map. Also collect all children of these TXs and mark them for retrying of IS locking.
     std::vector<uint256> toRemove;
@@ -1280,6 +1635,60 @@ void CInstantSendManager::HandleFullyConfirmedBlock(const CBlockIndex* pindex)
     }
 }
 
+bool CInstantSendManager::ProcessPendingArchival()
+{
+    auto& consensusParams = Params().GetConsensus();
+    int64_t nStartTime = GetTimeMillis();
+
+    while (!workInterrupt) {
+        bool fMore = false;
+        {
+            LOCK(cs);
+
+            int nTargetHeight = archivalStats.nTargetHeight;
+            if (archivalStats.nDoneHeight >= nTargetHeight) {
+                return false;
+            }
+
+            auto removeISLocks = db.RemoveConfirmedInstantSendLocks(nTargetHeight, archiveChunkSize, fMore);
+            for (auto& p : removeISLocks) {
+                auto& islockHash = p.first;
+                auto& islock = p.second;
+                if (!islock) {
+                    continue;
+                }
+                LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txid=%s, islock=%s: removed islock as it got fully confirmed\n", __func__,
+                         islock->txid.ToString(), islockHash.ToString());
+
+                // No need to keep recovered sigs for fully confirmed IS locks, as there is no chance for conflicts
+                // from now on. All inputs are spent now and can't be spend in any other TX.
+                TruncateRecoveredSigsForInputs(*islock);
+
+                // And we don't need the recovered sig for the ISLOCK anymore, as the block in which it got mined is considered
+                // fully confirmed now
+                quorumSigningManager->TruncateRecoveredSig(consensusParams.llmqTypeInstantSend, islock->GetRequestId());
+            }
+            archivalStats.nArchivedLocks += removeISLocks.size();
+
+            if (!fMore) {
+                archivalStats.nRemovedArchivedLocks += db.RemoveArchivedInstantSendLocks(nTargetHeight - 100, archiveChunkSize, fMore);
+            }
+
+            archivalStats.nChunks++;
+            archivalStats.nLastRunTime = GetTime();
+            if (!fMore) {
+                archivalStats.nDoneHeight = nTargetHeight;
+            }
+        }
+
+        if (GetTimeMillis() - nStartTime >= archiveTimeBudget) {
+            // continue in the next iteration, so that we don't block processing of new islocks for too long
+            return true;
+        }
+    }
+    return false;
+}
+
 void CInstantSendManager::RemoveMempoolConflictsForLock(const uint256& hash, const CInstantSendLock& islock)
 {
     std::unordered_map<uint256, CTransactionRef> toDelete;
@@ -1459,26 +1868,88 @@ void CInstantSendManager::ProcessPendingRetryLockTxs()
         return;
     }
 
-    int retryCount = 0;
-    for (const auto& txid : retryTxs) {
-        CTransactionRef tx;
-        {
-            LOCK(cs);
+    // Long chains of TXs (e.g. CoinJoin or exchange chains) end up here all at once. We handle them in topological
+    // order so that parents are retried before their children, and we don't even try children of unmined parents which
+    // could not be locked (yet), as these would fail CheckCanLock anyway. They are retried again once the parent gets
+    // locked.
+    std::unordered_map<uint256, CTransactionRef, StaticSaltedHasher> candidates;
+    std::unordered_set<uint256, StaticSaltedHasher> unmined;
+    {
+        LOCK(cs);
+        for (const auto& txid : retryTxs) {
             auto it = nonLockedTxs.find(txid);
-            if (it == nonLockedTxs.end()) {
+            if (it == nonLockedTxs.end() || !it->second.tx) {
                 continue;
             }
-            tx = it->second.tx;
+            candidates.emplace(txid, it->second.tx);
+            if (!it->second.pindexMined) {
+                unmined.emplace(txid);
+            }
+        }
+    }
 
-            if (!tx) {
+    std::vector<CTransactionRef> sorted;
+    sorted.reserve(candidates.size());
+    {
+        std::unordered_set<uint256, StaticSaltedHasher> visited;
+        std::vector<std::pair<CTransactionRef, size_t>> stack;
+        for (const auto& p : candidates) {
+            if (!visited.emplace(p.first).second) {
                 continue;
             }
+            stack.emplace_back(p.second, 0);
+            while (!stack.empty()) {
+                auto& top = stack.back();
+                const auto& vin = top.first->vin;
+                if (top.second < vin.size()) {
+                    const auto& parentTxid = vin[top.second++].prevout.hash;
+                    auto it = candidates.find(parentTxid);
+                    if (it != candidates.end() && visited.emplace(parentTxid).second) {
+                        stack.emplace_back(it->second, 0);
+                    }
+                    continue;
+                }
+                sorted.emplace_back(top.first);
+                stack.pop_back();
+            }
+        }
+    }
+
+    int retryCount = 0;
+    int skippedCount = 0;
+    CanLockParentCache parentCache;
+    // unmined TXs of this batch which are not locked after we're done with them. Their children are not tried
+    std::unordered_set<uint256, StaticSaltedHasher> notLocked;
+    for (const auto& tx : sorted) {
+        const auto& txid = tx->GetHash();
+
+        bool fParentNotLocked = false;
+        for (const auto& in : tx->vin) {
+            if (notLocked.count(in.prevout.hash)) {
+                fParentNotLocked = true;
+                break;
+            }
+        }
+        if (fParentNotLocked) {
+            notLocked.emplace(txid);
+            skippedCount++;
+            continue;
+        }
 
-            if (txToCreatingInstantSendLocks.count(tx->GetHash())) {
-                // we're already in the middle of locking this one
+        if (IsLocked(txid)) {
+            continue;
+        }
+        if (unmined.count(txid)) {
+            notLocked.emplace(txid);
+        }
+
+        {
+            LOCK(cs);
+            if (!nonLockedTxs.count(txid)) {
                 continue;
             }
-            if (IsLocked(tx->GetHash())) {
+            if (txToCreatingInstantSendLocks.count(txid)) {
+                // we're already in the middle of locking this one
                 continue;
             }
             if (IsConflicted(*tx)) {
@@ -1490,21 +1961,21 @@ void CInstantSendManager::ProcessPendingRetryLockTxs()
         // CheckCanLock is already called by ProcessTx, so we should avoid calling it twice. But we also shouldn't spam
         // the logs when retrying TXs that are not ready yet.
         if (LogAcceptCategory(BCLog::INSTANTSEND)) {
-            if (!CheckCanLock(*tx, false, Params().GetConsensus())) {
+            if (!CheckCanLock(*tx, false, Params().GetConsensus(), &parentCache)) {
                 continue;
             }
             LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txid=%s: retrying to lock\n", __func__,
-                     tx->GetHash().ToString());
+                     txid.ToString());
         }
 
-        ProcessTx(*tx, false, Params().GetConsensus());
+        ProcessTx(*tx, false, Params().GetConsensus(), &parentCache);
         retryCount++;
     }
 
-    if (retryCount != 0) {
+    if (retryCount != 0 || skippedCount != 0) {
         LOCK(cs);
-        LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- retried %d TXs. nonLockedTxs.size=%d\n", __func__,
-                 retryCount, nonLockedTxs.size());
+        LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- retried %d TXs, skipped %d children of unlocked TXs. nonLockedTxs.size=%d\n", __func__,
+                 retryCount, skippedCount, nonLockedTxs.size());
     }
 }
 
@@ -1514,8 +1985,19 @@ bool CInstantSendManager::AlreadyHave(const CInv& inv) const
         return true;
     }
 
+    if (db.GetKnownLocks().IsKnownHash(inv.hash)) {
+        return true;
+    }
+
     LOCK(cs);
-    return pendingInstantSendLocks.count(inv.hash) != 0 || db.KnownInstantSendLock(inv.hash);
+    if (pendingInstantSendLocks.count(inv.hash) != 0) {
+        return true;
+    }
+    if (db.KnownInstantSendLock(inv.hash)) {
+        db.GetKnownLocks().AddKnownHash(inv.hash);
+        return true;
+    }
+    return false;
 }
 
 bool CInstantSendManager::GetInstantSendLockByHash(const uint256& hash, llmq::CInstantSendLock& ret) const
@@ -1549,6 +2031,10 @@ bool CInstantSendManager::GetInstantSendLockHashByTxid(const uint256& txid, uint
         return false;
     }
 
+    if (db.GetKnownLocks().GetHashByTxid(txid, ret)) {
+        return true;
+    }
+
     LOCK(cs);
     ret = db.GetInstantSendLockHashByTxid(txid);
     return !ret.IsNull();
@@ -1560,8 +2046,18 @@ bool CInstantSendManager::IsLocked(const uint256& txHash) const
         return false;
     }
 
+    uint256 islockHash;
+    if (db.GetKnownLocks().GetHashByTxid(txHash, islockHash)) {
+        return true;
+    }
+
     LOCK(cs);
-    return db.KnownInstantSendLock(db.GetInstantSendLockHashByTxid(txHash));
+    islockHash = db.GetInstantSendLockHashByTxid(txHash);
+    if (!db.KnownInstantSendLock(islockHash)) {
+        return false;
+    }
+    db.GetKnownLocks().Add(islockHash, txHash);
+    return true;
 }
 
 bool CInstantSendManager::IsConflicted(const CTransaction& tx) const
@@ -1594,15 +2090,39 @@ size_t CInstantSendManager::GetInstantSendLockCount() const
     return db.GetInstantSendLockCount();
 }
 
+CInstantSendManager::ArchivalStats CInstantSendManager::GetArchivalStats() const
+{
+    LOCK(cs);
+    ArchivalStats ret = archivalStats;
+    ret.nChunkSize = archiveChunkSize;
+    ret.nTimeBudget = archiveTimeBudget;
+    return ret;
+}
+
 void CInstantSendManager::WorkThreadMain()
 {
+    // retrying TXs and archival are deferred for at most this many rounds while there are more islocks pending
+    const int MAX_DEFERRED_ROUNDS = 10;
+    int deferredRounds = 0;
+
     while (!workInterrupt) {
+        // islocks received from other nodes are always handled first, as the rest of the network (and our own
+        // mempool) waits for them
         bool fMoreWork = ProcessPendingInstantSendLocks();
-        ProcessPendingRetryLockTxs();
+        if (!fMoreWork || ++deferredRounds >= MAX_DEFERRED_ROUNDS) {
+            deferredRounds = 0;
+            ProcessPendingRetryLockTxs();
+            fMoreWork |= ProcessPendingArchival();
+        }
 
-        if (!fMoreWork && !workInterrupt.sleep_for(std::chrono::milliseconds(100))) {
-            return;
+        if (fMoreWork) {
+            continue;
         }
+
+        std::unique_lock<std::mutex> l(workMutex);
+        // the timeout only covers work which is not signaled, e.g. when the IS sporks change
+        workCv.wait_for(l, std::chrono::seconds(1), [this] { return fWorkSignaled || (bool)workInterrupt; });
+        fWorkSignaled = false;
     }
 }
 
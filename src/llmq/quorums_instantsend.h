@@ -8,15 +8,31 @@
 #include <llmq/quorums_signing.h>
 
 #include <coins.h>
+#include <sync.h>
 #include <unordered_lru_cache.h>
 #include <primitives/transaction.h>
 
+#include <ctpl.h>
+
+#include <array>
+#include <condition_variable>
+#include <mutex>
 #include <unordered_map>
 #include <unordered_set>
 
 namespace llmq
 {
 
+// 0 = auto, derived from the number of cores
+static const int DEFAULT_ISLOCK_VERIFY_THREADS = 0;
+static const int MAX_ISLOCK_VERIFY_THREADS = 8;
+// memory budget of the in-memory outpoint index, in megabytes. 0 disables the index
+static const int64_t DEFAULT_ISLOCK_INDEX_MEMORY = 64;
+// archival of islocks of fully confirmed blocks is done in chunks of this many entries, until the time budget (in
+// milliseconds) per iteration of the isman thread is used up
+static const int DEFAULT_ISLOCK_ARCHIVE_CHUNK = 1000;
+static const int DEFAULT_ISLOCK_ARCHIVE_TIME = 50;
+
 class CInstantSendLock
 {
 public:
@@ -40,6 +56,101 @@ public:
 
 typedef std::shared_ptr<CInstantSendLock> CInstantSendLockPtr;
 
+/**
+ * Compact in-memory index of the inputs of all non-archived islocks. It's an open addressing table with linear probing
+ * which only stores a salted 64 bit fingerprint of the outpoint together with the islock hash. This allows answering
+ * "is this outpoint locked?" without touching the database, which is the common case during mempool acceptance.
+ *
+ * The table is not allowed to grow beyond the configured memory budget. If it would, it is dropped and marked as
+ * incomplete, in which case all lookups fall back to the database again.
+ */
+class CInstantSendOutpointIndex
+{
+private:
+    struct Entry {
+        uint64_t fingerprint{0}; // 0 means the slot is empty
+        uint256 islockHash;
+    };
+
+    static const size_t MIN_CAPACITY = 1024;
+
+    std::vector<Entry> table;
+    size_t count{0};
+    size_t maxCapacity{0};
+    bool fComplete{false};
+
+    const uint64_t k0;
+    const uint64_t k1;
+
+public:
+    CInstantSendOutpointIndex();
+
+    // Resets the index and allows it to use up to nMemoryBudget bytes. Must be followed by Add() calls for all
+    // existing entries
+    void Init(size_t nMemoryBudget);
+    void MarkIncomplete();
+    bool IsComplete() const { return fComplete; }
+
+    void Add(const COutPoint& outpoint, const uint256& islockHash);
+    void Remove(const COutPoint& outpoint);
+
+    /**
+     * Returns false if the index can't give an authoritative answer. Otherwise islockHashRet is set to the hash of the
+     * islock which locks the outpoint or to null if it's not locked. In the very unlikely case of a fingerprint
+     * collision the returned hash might belong to an islock which does not contain the outpoint, so callers need to
+     * check the inputs of the returned islock.
+     */
+    bool Lookup(const COutPoint& outpoint, uint256& islockHashRet) const;
+
+    size_t size() const { return count; }
+    size_t GetMemoryUsage() const { return table.capacity() * sizeof(Entry); }
+
+private:
+    uint64_t GetFingerprint(const COutPoint& outpoint) const;
+    size_t FindSlot(uint64_t fingerprint) const;
+    bool Resize(size_t newCapacity);
+};
+
+/**
+ * Sharded set of known islocks which can be queried without holding the lock of CInstantSendManager. It only ever
+ * gives positive answers, i.e. a txid which is not found here might still be locked and an islock hash which is not
+ * found here might still be known from the database, so callers must fall back to the slow path in that case.
+ *
+ * Each shard has its own lock and is bounded in size, so concurrent readers (net_processing, mempool) only contend
+ * with each other when they hit the same shard and never with the isman thread while it holds cs.
+ */
+class CInstantSendKnownLocks
+{
+private:
+    static const size_t SHARD_COUNT = 16;
+    static const size_t MAX_ENTRIES_PER_SHARD = 2048;
+
+    struct Shard {
+        mutable CCriticalSection cs;
+        mutable unordered_lru_cache<uint256, uint256, StaticSaltedHasher, MAX_ENTRIES_PER_SHARD> txids;
+        mutable unordered_lru_cache<uint256, bool, StaticSaltedHasher, MAX_ENTRIES_PER_SHARD> islockHashes;
+    };
+    std::array<Shard, SHARD_COUNT> shards;
+
+public:
+    // islockHash is known and locks txid
+    void Add(const uint256& islockHash, const uint256& txid);
+    // islockHash is known (possibly archived), but we don't know or don't care which txid it locks
+    void AddKnownHash(const uint256& islockHash);
+    // the islock for txid was removed. The islock hash itself stays known as it's archived in that case
+    void RemoveTxid(const uint256& txid);
+    // the archived islock hash was removed, so it's not known anymore
+    void RemoveKnownHash(const uint256& islockHash);
+    void Clear();
+
+    bool GetHashByTxid(const uint256& txid, uint256& islockHashRet) const;
+    bool IsKnownHash(const uint256& islockHash) const;
+
+private:
+    Shard& GetShard(const uint256& hash) { return shards[StaticSaltedHasher()(hash) % SHARD_COUNT]; }
+    const Shard& GetShard(const uint256& hash) const { return shards[StaticSaltedHasher()(hash) % SHARD_COUNT]; }
+};
+
 class CInstantSendDb
 {
 private:
@@ -51,6 +162,11 @@ private:
     mutable unordered_lru_cache<uint256, uint256, StaticSaltedHasher, 10000> txidCache;
     mutable unordered_lru_cache<COutPoint, uint256, SaltedOutpointHasher, 10000> outpointCache;
 
+    CInstantSendOutpointIndex outpointIndex;
+    mutable CInstantSendKnownLocks knownLocks;
+
+    void BuildOutpointIndex();
+
     void WriteInstantSendLockMined(CDBBatch& batch, const uint256& hash, int nHeight);
     void RemoveInstantSendLockMined(CDBBatch& batch, const uint256& hash, int nHeight);
 
@@ -64,8 +180,8 @@ public:
 
     void WriteInstantSendLockMined(const uint256& hash, int nHeight);
     static void WriteInstantSendLockArchived(CDBBatch& batch, const uint256& hash, int nHeight);
-    std::unordered_map<uint256, CInstantSendLockPtr> RemoveConfirmedInstantSendLocks(int nUntilHeight);
-    void RemoveArchivedInstantSendLocks(int nUntilHeight);
+    std::unordered_map<uint256, CInstantSendLockPtr> RemoveConfirmedInstantSendLocks(int nUntilHeight, size_t nMaxCount, bool& fMoreRet);
+    size_t RemoveArchivedInstantSendLocks(int nUntilHeight, size_t nMaxCount, bool& fMoreRet);
     void WriteBlockInstantSendLocks(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexConnected);
     void RemoveBlockInstantSendLocks(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexDisconnected);
     bool KnownInstantSendLock(const uint256& islockHash) const;
@@ -78,6 +194,9 @@ public:
 
     std::vector<uint256> GetInstantSendLocksByParent(const uint256& parent) const;
     std::vector<uint256> RemoveChainedInstantSendLocks(const uint256& islockHash, const uint256& txid, int nHeight);
+
+    // internally synchronized, so it can be accessed without holding the lock that protects the rest of the db
+    CInstantSendKnownLocks& GetKnownLocks() const { return knownLocks; }
 };
 
 class CInstantSendManager : public CRecoveredSigsListener
@@ -91,6 +210,15 @@ private:
     std::thread workThread;
     CThreadInterrupt workInterrupt;
 
+    // wakes up the isman thread when new work got queued, so that it doesn't have to poll
+    std::mutex workMutex;
+    std::condition_variable workCv;
+    bool fWorkSignaled{false};
+
+    // verification of pending islocks is split by source node and spread over these workers
+    ctpl::thread_pool verifyWorkerPool;
+    int verifyWorkerCount{1};
+
     /**
      * Request ids of inputs that we signed. Used to determine if a recovered signature belongs to an
      * in-progress input lock.
@@ -115,12 +243,34 @@ private:
         const CBlockIndex* pindexMined{nullptr};
         CTransactionRef tx;
         std::unordered_set<uint256, StaticSaltedHasher> children;
+        // when the TX was first seen, to report the ISLOCK latency
+        int64_t nTimeAdded{0};
     };
     std::unordered_map<uint256, NonLockedTxInfo, StaticSaltedHasher> nonLockedTxs;
     std::unordered_map<COutPoint, uint256, SaltedOutpointHasher> nonLockedTxsByOutpoints;
 
     std::unordered_set<uint256, StaticSaltedHasher> pendingRetryTxs;
 
+public:
+    struct ArchivalStats {
+        // height of the last fully confirmed block and the height up to which archival is done
+        int nTargetHeight{0};
+        int nDoneHeight{0};
+        uint64_t nArchivedLocks{0};
+        uint64_t nRemovedArchivedLocks{0};
+        uint64_t nChunks{0};
+        int64_t nLastRunTime{0};
+        size_t nChunkSize{0};
+        int64_t nTimeBudget{0};
+    };
+
+private:
+    // Fully confirmed blocks only move the target height, the archival itself is done in bounded chunks by the
+    // isman thread. Protected by cs
+    ArchivalStats archivalStats;
+    size_t archiveChunkSize{DEFAULT_ISLOCK_ARCHIVE_CHUNK};
+    int64_t archiveTimeBudget{DEFAULT_ISLOCK_ARCHIVE_TIME};
+
 public:
     explicit CInstantSendManager(CDBWrapper& _llmqDb);
     ~CInstantSendManager();
@@ -128,10 +278,15 @@ public:
     void Start();
     void Stop();
     void InterruptWorkerThread();
+    void SignalWork();
 
 public:
-    void ProcessTx(const CTransaction& tx, bool fRetroactive, const Consensus::Params& params);
-    bool CheckCanLock(const CTransaction& tx, bool printDebug, const Consensus::Params& params) const;
+    // Results of the per parent TX part of CheckCanLock. Shared between all TXs of a retry batch, so that the mempool
+    // and txindex lookups are only done once per parent
+    typedef std::unordered_map<uint256, bool, StaticSaltedHasher> CanLockParentCache;
+
+    void ProcessTx(const CTransaction& tx, bool fRetroactive, const Consensus::Params& params, CanLockParentCache* parentCache = nullptr);
+    bool CheckCanLock(const CTransaction& tx, bool printDebug, const Consensus::Params& params, CanLockParentCache* parentCache = nullptr) const;
     bool CheckCanLock(const COutPoint& outpoint, bool printDebug, const uint256& txHash, CAmount* retValue, const Consensus::Params& params) const;
     bool IsLocked(const uint256& txHash) const;
     bool IsConflicted(const CTransaction& tx) const;
@@ -165,6 +320,7 @@ public:
     void UpdatedBlockTip(const CBlockIndex* pindexNew);
 
     void HandleFullyConfirmedBlock(const CBlockIndex* pindex);
+    bool ProcessPendingArchival();
 
     void RemoveMempoolConflictsForLock(const uint256& hash, const CInstantSendLock& islock);
     void ResolveBlockConflicts(const uint256& islockHash, const CInstantSendLock& islock);
@@ -178,6 +334,7 @@ public:
     bool GetInstantSendLockHashByTxid(const uint256& txid, uint256& ret) const;
 
     size_t GetInstantSendLockCount() const;
+    ArchivalStats GetArchivalStats() const;
 
     void WorkThreadMain();
 };
@@ -5,6 +5,7 @@
 #include <llmq/quorums_signing.h>
 #include <llmq/quorums_utils.h>
 #include <llmq/quorums_signing_shares.h>
+#include <llmq/quorums_signing_stats.h>
 
 #include <masternode/activemasternode.h>
 #include <bls/bls_batchverifier.h>
@@ -12,6 +13,7 @@
 #include <net_processing.h>
 #include <netmessagemaker.h>
 #include <scheduler.h>
+#include <statsd_client.h>
 #include <validation.h>
 
 #include <algorithm>
@@ -35,7 +37,8 @@ UniValue CRecoveredSig::ToJson() const
 }
 
 CRecoveredSigsDb::CRecoveredSigsDb(CDBWrapper& _db) :
-    db(_db)
+    db(_db),
+    pendingBatch(_db)
 {
     if (Params().NetworkIDString() == CBaseChainParams::TESTNET) {
         // TODO this can be completely removed after some time (when we're pretty sure the conversion has been run on most testnet MNs)
@@ -50,6 +53,23 @@ CRecoveredSigsDb::CRecoveredSigsDb(CDBWrapper& _db) :
     }
 }
 
+CRecoveredSigsDb::~CRecoveredSigsDb()
+{
+    FlushPendingWrites();
+}
+
+void CRecoveredSigsDb::FlushPendingWrites()
+{
+    LOCK(cs);
+    if (nPendingWrites == 0) {
+        return;
+    }
+    db.WriteBatch(pendingBatch);
+    pendingBatch.Clear();
+    pendingVotes.clear();
+    nPendingWrites = 0;
+}
+
 // This converts time values in "rs_t" from host endiannes to big endiannes, which is required to have proper ordering of the keys
 void CRecoveredSigsDb::ConvertInvalidTimeKeys()
 {
@@ -125,6 +145,8 @@ void CRecoveredSigsDb::AddVoteTimeKeys()
 
 bool CRecoveredSigsDb::HasRecoveredSig(Consensus::LLMQType llmqType, const uint256& id, const uint256& msgHash)
 {
+    FlushPendingWrites();
+
     auto k = std::make_tuple(std::string("rs_r"), llmqType, id, msgHash);
     return db.Exists(k);
 }
@@ -187,6 +209,8 @@ bool CRecoveredSigsDb::HasRecoveredSigForHash(const uint256& hash)
 
 bool CRecoveredSigsDb::ReadRecoveredSig(Consensus::LLMQType llmqType, const uint256& id, CRecoveredSig& ret)
 {
+    FlushPendingWrites();
+
     auto k = std::make_tuple(std::string("rs_r"), llmqType, id);
 
     CDataStream ds(SER_DISK, CLIENT_VERSION);
@@ -204,6 +228,8 @@ bool CRecoveredSigsDb::ReadRecoveredSig(Consensus::LLMQType llmqType, const uint
 
 bool CRecoveredSigsDb::GetRecoveredSigByHash(const uint256& hash, CRecoveredSig& ret)
 {
+    FlushPendingWrites();
+
     auto k1 = std::make_tuple(std::string("rs_h"), hash);
     std::pair<Consensus::LLMQType, uint256> k2;
     if (!db.Read(k1, k2)) {
@@ -220,7 +246,8 @@ bool CRecoveredSigsDb::GetRecoveredSigById(Consensus::LLMQType llmqType, const u
 
 void CRecoveredSigsDb::WriteRecoveredSig(const llmq::CRecoveredSig& recSig)
 {
-    CDBBatch batch(db);
+    LOCK(cs);
+    auto& batch = pendingBatch;
 
     uint32_t curTime = GetAdjustedTime();
 
@@ -244,15 +271,14 @@ void CRecoveredSigsDb::WriteRecoveredSig(const llmq::CRecoveredSig& recSig)
     // store by current time. Allows fast cleanup of old recSigs
     auto k5 = std::make_tuple(std::string("rs_t"), (uint32_t)htobe32(curTime), recSig.llmqType, recSig.id);
     batch.Write(k5, (uint8_t)1);
-
-    db.WriteBatch(batch);
-
-    {
-        LOCK(cs);
-        hasSigForIdCache.insert(std::make_pair((Consensus::LLMQType)recSig.llmqType, recSig.id), true);
-        hasSigForSessionCache.insert(signHash, true);
-        hasSigForHashCache.insert(recSig.GetHash(), true);
+    nPendingWrites++;
+    if (nPendingWrites >= MAX_PENDING_WRITES) {
+        FlushPendingWrites();
     }
+
+    hasSigForIdCache.insert(std::make_pair((Consensus::LLMQType)recSig.llmqType, recSig.id), true);
+    hasSigForSessionCache.insert(signHash, true);
+    hasSigForHashCache.insert(recSig.GetHash(), true);
 }
 
 void CRecoveredSigsDb::RemoveRecoveredSig(CDBBatch& batch, Consensus::LLMQType llmqType, const uint256& id, bool deleteHashKey, bool deleteTimeKey)
@@ -314,17 +340,44 @@ void CRecoveredSigsDb::TruncateRecoveredSig(Consensus::LLMQType llmqType, const
     db.WriteBatch(batch);
 }
 
+uint32_t CRecoveredSigsDb::GetCleanupBucketEnd(int64_t maxAge)
+{
+    // Use buckets of at most CLEANUP_BUCKET_SIZE, but keep them small compared to maxAge so that small values given
+    // via -maxrecsigsage still get cleaned up in time
+    int64_t bucketSize = maxAge / 16;
+    if (bucketSize > CLEANUP_BUCKET_SIZE) {
+        bucketSize = CLEANUP_BUCKET_SIZE;
+    }
+    if (bucketSize < 1) {
+        bucketSize = 1;
+    }
+    int64_t endTime = GetAdjustedTime() - maxAge;
+    if (endTime <= 0) {
+        return 0;
+    }
+    return (uint32_t)(endTime - (endTime % bucketSize));
+}
+
 void CRecoveredSigsDb::CleanupOldRecoveredSigs(int64_t maxAge)
 {
+    // Entries are expired in whole time buckets. As long as the current bucket has been fully removed, there is no
+    // need to touch the db at all
+    uint32_t endTime = GetCleanupBucketEnd(maxAge);
+    if (endTime <= recSigsCleanupEnd) {
+        return;
+    }
+
+    FlushPendingWrites();
+
     std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
 
     auto start = std::make_tuple(std::string("rs_t"), (uint32_t)0, (Consensus::LLMQType)0, uint256());
-    uint32_t endTime = (uint32_t)(GetAdjustedTime() - maxAge);
     pcursor->Seek(start);
 
     std::vector<std::pair<Consensus::LLMQType, uint256>> toDelete;
     std::vector<decltype(start)> toDelete2;
 
+    bool fBucketDone = true;
     while (pcursor->Valid()) {
         decltype(start) k;
 
@@ -334,6 +387,11 @@ void CRecoveredSigsDb::CleanupOldRecoveredSigs(int64_t maxAge)
         if (be32toh(std::get<1>(k)) >= endTime) {
             break;
         }
+        if (toDelete.size() >= MAX_CLEANUP_ENTRIES) {
+            // continue in the next cleanup cycle
+            fBucketDone = false;
+            break;
+        }
 
         toDelete.emplace_back(std::get<2>(k), std::get<3>(k));
         toDelete2.emplace_back(k);
@@ -342,40 +400,62 @@ void CRecoveredSigsDb::CleanupOldRecoveredSigs(int64_t maxAge)
     }
     pcursor.reset();
 
-    if (toDelete.empty()) {
-        return;
-    }
-
-    CDBBatch batch(db);
-    {
-        LOCK(cs);
-        for (auto& e : toDelete) {
-            RemoveRecoveredSig(batch, e.first, e.second, true, false);
+    if (!toDelete.empty()) {
+        CDBBatch batch(db);
+        {
+            LOCK(cs);
+            for (auto& e : toDelete) {
+                RemoveRecoveredSig(batch, e.first, e.second, true, false);
 
-            if (batch.SizeEstimate() >= (1 << 24)) {
-                db.WriteBatch(batch);
-                batch.Clear();
+                if (batch.SizeEstimate() >= (1 << 24)) {
+                    db.WriteBatch(batch);
+                    batch.Clear();
+                }
             }
         }
-    }
 
-    for (auto& e : toDelete2) {
-        batch.Erase(e);
-    }
+        for (auto& e : toDelete2) {
+            batch.Erase(e);
+        }
 
-    db.WriteBatch(batch);
+        db.WriteBatch(batch);
+
+        LogPrint(BCLog::LLMQ, "CRecoveredSigsDb::%d -- deleted %d entries\n", __func__, toDelete.size());
+    }
 
-    LogPrint(BCLog::LLMQ, "CRecoveredSigsDb::%d -- deleted %d entries\n", __func__, toDelete.size());
+    if (fBucketDone) {
+        if (!toDelete.empty()) {
+            // get rid of the tombstones of the whole expired time range at once
+            db.CompactRange(start, std::make_tuple(std::string("rs_t"), (uint32_t)htobe32(endTime), (Consensus::LLMQType)0, uint256()));
+        }
+        recSigsCleanupEnd = endTime;
+    }
 }
 
 bool CRecoveredSigsDb::HasVotedOnId(Consensus::LLMQType llmqType, const uint256& id)
 {
+    {
+        LOCK(cs);
+        if (pendingVotes.count(std::make_pair(llmqType, id))) {
+            return true;
+        }
+    }
+
     auto k = std::make_tuple(std::string("rs_v"), llmqType, id);
     return db.Exists(k);
 }
 
 bool CRecoveredSigsDb::GetVoteForId(Consensus::LLMQType llmqType, const uint256& id, uint256& msgHashRet)
 {
+    {
+        LOCK(cs);
+        auto it = pendingVotes.find(std::make_pair(llmqType, id));
+        if (it != pendingVotes.end()) {
+            msgHashRet = it->second;
+            return true;
+        }
+    }
+
     auto k = std::make_tuple(std::string("rs_v"), llmqType, id);
     return db.Read(k, msgHashRet);
 }
@@ -385,23 +465,33 @@ void CRecoveredSigsDb::WriteVoteForId(Consensus::LLMQType llmqType, const uint25
     auto k1 = std::make_tuple(std::string("rs_v"), llmqType, id);
     auto k2 = std::make_tuple(std::string("rs_vt"), (uint32_t)htobe32(GetAdjustedTime()), llmqType, id);
 
-    CDBBatch batch(db);
-    batch.Write(k1, msgHash);
-    batch.Write(k2, (uint8_t)1);
-
-    db.WriteBatch(batch);
+    LOCK(cs);
+    pendingBatch.Write(k1, msgHash);
+    pendingBatch.Write(k2, (uint8_t)1);
+    pendingVotes[std::make_pair(llmqType, id)] = msgHash;
+    nPendingWrites++;
+    if (nPendingWrites >= MAX_PENDING_WRITES) {
+        FlushPendingWrites();
+    }
 }
 
 void CRecoveredSigsDb::CleanupOldVotes(int64_t maxAge)
 {
+    uint32_t endTime = GetCleanupBucketEnd(maxAge);
+    if (endTime <= votesCleanupEnd) {
+        return;
+    }
+
+    FlushPendingWrites();
+
     std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
 
     auto start = std::make_tuple(std::string("rs_vt"), (uint32_t)0, (Consensus::LLMQType)0, uint256());
-    uint32_t endTime = (uint32_t)(GetAdjustedTime() - maxAge);
     pcursor->Seek(start);
 
     CDBBatch batch(db);
     size_t cnt = 0;
+    bool fBucketDone = true;
     while (pcursor->Valid()) {
         decltype(start) k;
 
@@ -411,6 +501,11 @@ void CRecoveredSigsDb::CleanupOldVotes(int64_t maxAge)
         if (be32toh(std::get<1>(k)) >= endTime) {
             break;
         }
+        if (cnt >= MAX_CLEANUP_ENTRIES) {
+            // continue in the next cleanup cycle
+            fBucketDone = false;
+            break;
+        }
 
         Consensus::LLMQType llmqType = std::get<2>(k);
         const uint256& id = std::get<3>(k);
@@ -424,13 +519,18 @@ void CRecoveredSigsDb::CleanupOldVotes(int64_t maxAge)
     }
     pcursor.reset();
 
-    if (cnt == 0) {
-        return;
-    }
+    if (cnt != 0) {
+        db.WriteBatch(batch);
 
-    db.WriteBatch(batch);
+        LogPrint(BCLog::LLMQ, "CRecoveredSigsDb::%d -- deleted %d entries\n", __func__, cnt);
+    }
 
-    LogPrint(BCLog::LLMQ, "CRecoveredSigsDb::%d -- deleted %d entries\n", __func__, cnt);
+    if (fBucketDone) {
+        if (cnt != 0) {
+            db.CompactRange(start, std::make_tuple(std::string("rs_vt"), (uint32_t)htobe32(endTime), (Consensus::LLMQType)0, uint256()));
+        }
+        votesCleanupEnd = endTime;
+    }
 }
 
 //////////////////
@@ -724,6 +824,9 @@ void CSigningManager::ProcessRecoveredSig(const std::shared_ptr<const CRecovered
         pendingReconstructedRecoveredSigs.erase(recoveredSig->GetHash());
     }
 
+    // a counter, so the rate of recovered sigs per second can be derived on the statsd side
+    statsClient.inc(strprintf("llmq.%s.recoveredSigs", GetLLMQParams(llmqType).name), 1.0f);
+
     if (fMasternodeMode) {
         CInv inv(MSG_QUORUM_RECOVERED_SIG, recoveredSig->GetHash());
         g_connman->ForEachNode([&](CNode* pnode) {
@@ -733,9 +836,12 @@ void CSigningManager::ProcessRecoveredSig(const std::shared_ptr<const CRecovered
         });
     }
 
+    cxxtimer::Timer dispatchTimer(true);
     for (auto& l : listeners) {
         l->HandleNewRecoveredSig(*recoveredSig);
     }
+    dispatchTimer.stop();
+    signingStats.Add(llmqType, SigningStage::ListenerDispatch, dispatchTimer.count());
 
     GetMainSignals().NotifyRecoveredSig(recoveredSig);
 }
@@ -751,6 +857,11 @@ void CSigningManager::TruncateRecoveredSig(Consensus::LLMQType llmqType, const u
     db.TruncateRecoveredSig(llmqType, id);
 }
 
+void CSigningManager::FlushPendingWrites()
+{
+    db.FlushPendingWrites();
+}
+
 void CSigningManager::Cleanup()
 {
     int64_t now = GetTimeMillis();
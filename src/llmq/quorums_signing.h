@@ -75,8 +75,28 @@ private:
     unordered_lru_cache<uint256, bool, StaticSaltedHasher, 30000> hasSigForSessionCache;
     unordered_lru_cache<uint256, bool, StaticSaltedHasher, 30000> hasSigForHashCache;
 
+    // Recovered sigs and votes are accumulated here and written in one go by FlushPendingWrites, which is called once
+    // per iteration of the signing worker. The hasSigFor* caches are updated immediately and, as the batch is capped
+    // far below their size, always contain the pending recovered sigs. Pending votes are looked up in pendingVotes.
+    // All other reads flush the batch first
+    static const size_t MAX_PENDING_WRITES = 1000;
+    CDBBatch pendingBatch;
+    size_t nPendingWrites{0};
+    std::unordered_map<std::pair<Consensus::LLMQType, uint256>, uint256, StaticSaltedHasher> pendingVotes;
+
+    // Old recovered sigs and votes are removed in whole time buckets of this size (in seconds). The "rs_t" and "rs_vt"
+    // keys are prefixed with the big endian write time, so each bucket is a contiguous key range which gets compacted
+    // after it was deleted
+    static const int64_t CLEANUP_BUCKET_SIZE = 60 * 60;
+    // limits the work (and memory) of a single cleanup cycle. Larger buckets are removed over multiple cycles
+    static const size_t MAX_CLEANUP_ENTRIES = 100000;
+    // end of the last completely removed bucket
+    uint32_t recSigsCleanupEnd{0};
+    uint32_t votesCleanupEnd{0};
+
 public:
     explicit CRecoveredSigsDb(CDBWrapper& _db);
+    ~CRecoveredSigsDb();
 
     void ConvertInvalidTimeKeys();
     void AddVoteTimeKeys();
@@ -100,9 +120,12 @@ public:
 
     void CleanupOldVotes(int64_t maxAge);
 
+    void FlushPendingWrites();
+
 private:
     bool ReadRecoveredSig(Consensus::LLMQType llmqType, const uint256& id, CRecoveredSig& ret);
     void RemoveRecoveredSig(CDBBatch& batch, Consensus::LLMQType llmqType, const uint256& id, bool deleteHashKey, bool deleteTimeKey);
+    static uint32_t GetCleanupBucketEnd(int64_t maxAge);
 };
 
 class CRecoveredSigsListener
@@ -167,6 +190,7 @@ private:
     bool ProcessPendingRecoveredSigs(); // called from the worker thread of CSigSharesManager
     void ProcessRecoveredSig(const std::shared_ptr<const CRecoveredSig>& recoveredSig);
     void Cleanup(); // called from the worker thread of CSigSharesManager
+    void FlushPendingWrites(); // called from the worker thread of CSigSharesManager
 
 public:
     // public interface
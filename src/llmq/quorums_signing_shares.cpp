@@ -4,6 +4,7 @@
 
 #include <llmq/quorums_signing.h>
 #include <llmq/quorums_signing_shares.h>
+#include <llmq/quorums_signing_stats.h>
 #include <llmq/quorums_utils.h>
 
 #include <masternode/activemasternode.h>
@@ -101,6 +102,27 @@ std::string CBatchedSigShares::ToInvString() const
     return inv.ToString();
 }
 
+CBLSLazySignature CBatchedSigSharesView::GetSigShare(size_t idx) const
+{
+    assert(idx < sigShares.size());
+    CBLSLazySignature sig;
+    SpanReader(SER_NETWORK, PROTOCOL_VERSION, sigShares[idx].second) >> sig;
+    return sig;
+}
+
+std::string CBatchedSigSharesView::ToInvString() const
+{
+    CSigSharesInv inv;
+    // we use 400 here no matter what the real size is. We don't really care about that size as we just want to call ToString()
+    inv.Init(400);
+    for (size_t i = 0; i < sigShares.size(); i++) {
+        if (sigShares[i].first < inv.inv.size()) {
+            inv.inv[sigShares[i].first] = true;
+        }
+    }
+    return inv.ToString();
+}
+
 template<typename T>
 static void InitSession(CSigSharesNodeState::Session& s, const uint256& signHash, T& from)
 {
@@ -169,6 +191,16 @@ bool CSigSharesNodeState::GetSessionInfoByRecvId(uint32_t sessionId, SessionInfo
     return true;
 }
 
+size_t CSigSharesNodeState::CountPendingSends() const
+{
+    // shares the node requested from us plus shares it announced and which we might request
+    size_t count = 0;
+    for (const auto& p : sessions) {
+        count += p.second.requested.CountSet() + p.second.announced.CountSet();
+    }
+    return count;
+}
+
 void CSigSharesNodeState::RemoveSession(const uint256& signHash)
 {
     auto it = sessions.find(signHash);
@@ -182,7 +214,8 @@ void CSigSharesNodeState::RemoveSession(const uint256& signHash)
 
 //////////////////////
 
-CSigSharesManager::CSigSharesManager()
+CSigSharesManager::CSigSharesManager(CBLSWorker& _blsWorker) :
+    blsWorker(_blsWorker)
 {
     workInterrupt.reset();
 }
@@ -196,6 +229,17 @@ void CSigSharesManager::StartWorkerThread()
         assert(false);
     }
 
+    // -llmq-sigshare-threads=0 means autodetect, a single worker means we verify on the sigshares thread itself
+    verifyWorkerCount = (int)gArgs.GetArg("-llmq-sigshare-threads", DEFAULT_SIGSHARES_VERIFY_THREADS);
+    if (verifyWorkerCount <= 0) {
+        verifyWorkerCount = GetNumCores() / 2;
+    }
+    verifyWorkerCount = std::max(1, std::min(verifyWorkerCount, MAX_SIGSHARES_VERIFY_THREADS));
+    if (verifyWorkerCount > 1) {
+        verifyWorkerPool.resize(verifyWorkerCount);
+        RenameThreadPool(verifyWorkerPool, "dash-sigs-vrfy");
+    }
+
     workThread = std::thread(&TraceThread<std::function<void()> >,
         "sigshares",
         std::function<void()>(std::bind(&CSigSharesManager::WorkThreadMain, this)));
@@ -211,6 +255,9 @@ void CSigSharesManager::StopWorkerThread()
     if (workThread.joinable()) {
         workThread.join();
     }
+
+    verifyWorkerPool.clear_queue();
+    verifyWorkerPool.stop(true);
 }
 
 void CSigSharesManager::RegisterAsRecoveredSigsListener()
@@ -295,8 +342,9 @@ void CSigSharesManager::ProcessMessage(CNode* pfrom, const std::string& strComma
             }
         }
     } else if (strCommand == NetMsgType::QBSIGSHARES) {
-        std::vector<CBatchedSigShares> msgs;
-        vRecv >> msgs;
+        // parse the batches in place, the views only stay valid as long as vRecv is not touched
+        std::vector<CBatchedSigSharesView> msgs;
+        SpanReader(vRecv.GetType(), vRecv.GetVersion(), Span<const unsigned char>((const unsigned char*)vRecv.data(), vRecv.size())) >> msgs;
         size_t totalSigsCount = 0;
         for (auto& bs : msgs) {
             totalSigsCount += bs.sigShares.size();
@@ -424,7 +472,7 @@ bool CSigSharesManager::ProcessMessageGetSigShares(CNode* pfrom, const CSigShare
     return true;
 }
 
-bool CSigSharesManager::ProcessMessageBatchedSigShares(CNode* pfrom, const CBatchedSigShares& batchedSigShares)
+bool CSigSharesManager::ProcessMessageBatchedSigShares(CNode* pfrom, const CBatchedSigSharesView& batchedSigShares)
 {
     CSigSharesNodeState::SessionInfo sessionInfo;
     if (!GetSessionInfoByRecvId(pfrom->GetId(), batchedSigShares.sessionId, sessionInfo)) {
@@ -443,24 +491,27 @@ bool CSigSharesManager::ProcessMessageBatchedSigShares(CNode* pfrom, const CBatc
         LOCK(cs);
         auto& nodeState = nodeStates[pfrom->GetId()];
 
+        // TODO for PoSe, we should consider propagating shares even if we already have a recovered sig
+        bool hasRecoveredSig = quorumSigningManager->HasRecoveredSigForId(sessionInfo.llmqType, sessionInfo.id);
+
         for (size_t i = 0; i < batchedSigShares.sigShares.size(); i++) {
-            CSigShare sigShare = RebuildSigShare(sessionInfo, batchedSigShares, i);
-            nodeState.requestedSigShares.Erase(sigShare.GetKey());
+            // the key is known without touching the signature, so only copy it out of the message when needed
+            SigShareKey k(sessionInfo.signHash, batchedSigShares.sigShares[i].first);
+            nodeState.requestedSigShares.Erase(k);
 
             // TODO track invalid sig shares received for PoSe?
             // It's important to only skip seen *valid* sig shares here. If a node sends us a
             // batch of mostly valid sig shares with a single invalid one and thus batched
             // verification fails, we'd skip the valid ones in the future if received from other nodes
-            if (this->sigShares.Has(sigShare.GetKey())) {
+            if (this->sigShares.Has(k)) {
                 continue;
             }
 
-            // TODO for PoSe, we should consider propagating shares even if we already have a recovered sig
-            if (quorumSigningManager->HasRecoveredSigForId((Consensus::LLMQType)sigShare.llmqType, sigShare.id)) {
+            if (hasRecoveredSig) {
                 continue;
             }
 
-            sigShares.emplace_back(sigShare);
+            sigShares.emplace_back(RebuildSigShare(sessionInfo, batchedSigShares, i));
         }
     }
 
@@ -530,7 +581,7 @@ void CSigSharesManager::ProcessMessageSigShare(NodeId fromId, const CSigShare& s
              sigShare.GetSignHash().ToString(), sigShare.id.ToString(), sigShare.msgHash.ToString(), sigShare.quorumMember, fromId);
 }
 
-bool CSigSharesManager::PreVerifyBatchedSigShares(const CSigSharesNodeState::SessionInfo& session, const CBatchedSigShares& batchedSigShares, bool& retBan)
+bool CSigSharesManager::PreVerifyBatchedSigShares(const CSigSharesNodeState::SessionInfo& session, const CBatchedSigSharesView& batchedSigShares, bool& retBan)
 {
     retBan = false;
 
@@ -549,20 +600,20 @@ bool CSigSharesManager::PreVerifyBatchedSigShares(const CSigSharesNodeState::Ses
         return false;
     }
 
-    std::unordered_set<uint16_t> dupMembers;
+    std::vector<bool> dupMembers(session.quorum->members.size(), false);
 
     for (const auto& sigShare : batchedSigShares.sigShares) {
         auto quorumMember = sigShare.first;
-        if (!dupMembers.emplace(quorumMember).second) {
+        if (quorumMember >= session.quorum->members.size()) {
+            LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- quorumMember out of bounds\n", __func__);
             retBan = true;
             return false;
         }
-
-        if (quorumMember >= session.quorum->members.size()) {
-            LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- quorumMember out of bounds\n", __func__);
+        if (dupMembers[quorumMember]) {
             retBan = true;
             return false;
         }
+        dupMembers[quorumMember] = true;
         if (!session.quorum->qc.validMembers[quorumMember]) {
             LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- quorumMember not valid\n", __func__);
             retBan = true;
@@ -639,62 +690,56 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
     std::unordered_map<NodeId, std::vector<CSigShare>> sigSharesByNodes;
     std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher> quorums;
 
-    const size_t nMaxBatchSize{32};
+    // every verification worker gets its own batch of sessions
+    const size_t nMaxBatchSize{32 * (size_t)verifyWorkerCount};
     CollectPendingSigSharesToVerify(nMaxBatchSize, sigSharesByNodes, quorums);
     if (sigSharesByNodes.empty()) {
         return false;
     }
 
-    // It's ok to perform insecure batched verification here as we verify against the quorum public key shares,
-    // which are not craftable by individual entities, making the rogue public key attack impossible
-    CBLSBatchVerifier<NodeId, SigShareKey> batchVerifier(false, true);
-
-    cxxtimer::Timer prepareTimer(true);
-    size_t verifyCount = 0;
-    for (auto& p : sigSharesByNodes) {
-        auto nodeId = p.first;
-        auto& v = p.second;
-
-        for (auto& sigShare : v) {
-            if (quorumSigningManager->HasRecoveredSigForId((Consensus::LLMQType)sigShare.llmqType, sigShare.id)) {
-                continue;
-            }
-
-            // we didn't check this earlier because we use a lazy BLS signature and tried to avoid doing the expensive
-            // deserialization in the message thread
-            if (!sigShare.sigShare.Get().IsValid()) {
-                BanNode(nodeId);
-                // don't process any additional shares from this node
-                break;
-            }
-
-            auto quorum = quorums.at(std::make_pair((Consensus::LLMQType)sigShare.llmqType, sigShare.quorumHash));
-            auto pubKeyShare = quorum->GetPubKeyShare(sigShare.quorumMember);
-
-            if (!pubKeyShare.IsValid()) {
-                // this should really not happen (we already ensured we have the quorum vvec,
-                // so we should also be able to create all pubkey shares)
-                LogPrintf("CSigSharesManager::%s -- pubKeyShare is invalid, which should not be possible here\n", __func__);
-                assert(false);
-            }
-
-            batchVerifier.PushMessage(nodeId, sigShare.GetKey(), sigShare.GetSignHash(), sigShare.sigShare.Get(), pubKeyShare);
-            verifyCount++;
+    // Split the sig shares into disjoint sets of sessions so that each worker can run its own batch verification.
+    // Sessions are assigned round-robin in the order they first appear
+    std::vector<std::vector<std::pair<NodeId, const CSigShare*>>> parts((size_t)verifyWorkerCount);
+    std::unordered_map<uint256, size_t, StaticSaltedHasher> partBySignHash;
+    for (const auto& p : sigSharesByNodes) {
+        for (const auto& sigShare : p.second) {
+            auto it = partBySignHash.emplace(sigShare.GetSignHash(), partBySignHash.size() % parts.size()).first;
+            parts[it->second].emplace_back(p.first, &sigShare);
         }
     }
-    prepareTimer.stop();
+    parts.erase(std::remove_if(parts.begin(), parts.end(), [](const std::vector<std::pair<NodeId, const CSigShare*>>& v) {
+        return v.empty();
+    }), parts.end());
 
     cxxtimer::Timer verifyTimer(true);
-    batchVerifier.Verify();
+    std::set<NodeId> badNodes;
+    size_t verifyCount = 0;
+    if (parts.size() == 1) {
+        badNodes = VerifyPendingSigShares(parts[0], quorums, verifyCount);
+    } else {
+        std::vector<size_t> verifyCounts(parts.size(), 0);
+        std::vector<std::future<std::set<NodeId>>> futures;
+        futures.reserve(parts.size());
+        for (size_t i = 0; i < parts.size(); i++) {
+            futures.emplace_back(verifyWorkerPool.push([this, &parts, &quorums, &verifyCounts, i](int threadId) {
+                return VerifyPendingSigShares(parts[i], quorums, verifyCounts[i]);
+            }));
+        }
+        for (size_t i = 0; i < futures.size(); i++) {
+            auto v = futures[i].get();
+            badNodes.insert(v.begin(), v.end());
+            verifyCount += verifyCounts[i];
+        }
+    }
     verifyTimer.stop();
 
-    LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- verified sig shares. count=%d, pt=%d, vt=%d, nodes=%d\n", __func__, verifyCount, prepareTimer.count(), verifyTimer.count(), sigSharesByNodes.size());
+    LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- verified sig shares. count=%d, vt=%d, nodes=%d, workers=%d\n", __func__, verifyCount, verifyTimer.count(), sigSharesByNodes.size(), parts.size());
 
     for (auto& p : sigSharesByNodes) {
         auto nodeId = p.first;
         auto& v = p.second;
 
-        if (batchVerifier.badSources.count(nodeId)) {
+        if (badNodes.count(nodeId)) {
             LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- invalid sig shares from other node, banning peer=%d\n",
                      __func__, nodeId);
             // this will also cause re-requesting of the shares that were sent by this node
@@ -708,6 +753,77 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
     return sigSharesByNodes.size() >= nMaxBatchSize;
 }
 
+// Might be called from multiple verification workers at once, each with a disjoint set of sessions
+std::set<NodeId> CSigSharesManager::VerifyPendingSigShares(const std::vector<std::pair<NodeId, const CSigShare*>>& sigShares,
+        const std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher>& quorums,
+        size_t& retVerifyCount)
+{
+    std::set<NodeId> badNodes;
+    retVerifyCount = 0;
+
+    // It's ok to perform insecure batched verification here as we verify against the quorum public key shares,
+    // which are not craftable by individual entities, making the rogue public key attack impossible
+    // A bad share is isolated by bisecting the batch, with both halves being verified in parallel on the BLS worker
+    CBLSBatchVerifier<NodeId, SigShareKey> batchVerifier(false, true, 0, &blsWorker);
+    std::set<Consensus::LLMQType> llmqTypes;
+
+    // Sessions of the same quorum share the public key shares of its members, so only look each of them up once per
+    // batch. Shares for the same session (same sign hash) get their public keys aggregated by the batch verifier, so
+    // the number of pairings only grows with the number of sessions and not with the number of shares
+    std::map<std::pair<const CQuorum*, uint16_t>, CBLSPublicKey> pubKeyShares;
+
+    for (const auto& p : sigShares) {
+        auto nodeId = p.first;
+        const auto& sigShare = *p.second;
+
+        if (badNodes.count(nodeId)) {
+            // don't process any additional shares from this node
+            continue;
+        }
+
+        if (quorumSigningManager->HasRecoveredSigForId((Consensus::LLMQType)sigShare.llmqType, sigShare.id)) {
+            continue;
+        }
+
+        // we didn't check this earlier because we use a lazy BLS signature and tried to avoid doing the expensive
+        // deserialization in the message thread
+        if (!sigShare.sigShare.Get().IsValid()) {
+            badNodes.emplace(nodeId);
+            continue;
+        }
+
+        const auto& quorum = quorums.at(std::make_pair((Consensus::LLMQType)sigShare.llmqType, sigShare.quorumHash));
+        auto it = pubKeyShares.find(std::make_pair(quorum.get(), sigShare.quorumMember));
+        if (it == pubKeyShares.end()) {
+            it = pubKeyShares.emplace(std::make_pair(quorum.get(), sigShare.quorumMember), quorum->GetPubKeyShare(sigShare.quorumMember)).first;
+        }
+        const auto& pubKeyShare = it->second;
+
+        if (!pubKeyShare.IsValid()) {
+            // this should really not happen (we already ensured we have the quorum vvec,
+            // so we should also be able to create all pubkey shares)
+            LogPrintf("CSigSharesManager::%s -- pubKeyShare is invalid, which should not be possible here\n", __func__);
+            assert(false);
+        }
+
+        batchVerifier.PushMessage(nodeId, sigShare.GetKey(), sigShare.GetSignHash(), sigShare.sigShare.Get(), pubKeyShare);
+        llmqTypes.emplace((Consensus::LLMQType)sigShare.llmqType);
+        retVerifyCount++;
+    }
+
+    cxxtimer::Timer verifyTimer(true);
+    batchVerifier.Verify();
+    verifyTimer.stop();
+    badNodes.insert(batchVerifier.badSources.begin(), batchVerifier.badSources.end());
+
+    // all shares of the batch waited for the whole batch, so account the time to each LLMQ type in it
+    for (auto llmqType : llmqTypes) {
+        signingStats.Add(llmqType, SigningStage::VerifyBatch, verifyTimer.count());
+    }
+
+    return badNodes;
+}
+
 // It's ensured that no duplicates are passed to this method
 void CSigSharesManager::ProcessPendingSigShares(const std::vector<CSigShare>& sigShares,
         const std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher>& quorums,
@@ -755,6 +871,7 @@ void CSigSharesManager::ProcessSigShare(const CSigShare& sigShare, CConnman& con
 
         // Update the time we've seen the last sigShare
         timeSeenForSessions[sigShare.GetSignHash()] = GetAdjustedTime();
+        timeFirstSeenForSessions.emplace(sigShare.GetSignHash(), GetTimeMillis());
 
         if (!quorumNodes.empty()) {
             // don't announce and wait for other nodes to request this share and directly send it to them
@@ -785,43 +902,72 @@ void CSigSharesManager::TryRecoverSig(const CQuorumCPtr& quorum, const uint256&
         return;
     }
 
+    auto signHash = CLLMQUtils::BuildSignHash(quorum->params.type, quorum->qc.quorumHash, id, msgHash);
+    if (quorumSigningManager->HasRecoveredSigForSession(signHash)) {
+        return;
+    }
+
     std::vector<CBLSSignature> sigSharesForRecovery;
     std::vector<CBLSId> idsForRecovery;
     {
         LOCK(cs);
 
-        auto signHash = CLLMQUtils::BuildSignHash(quorum->params.type, quorum->qc.quorumHash, id, msgHash);
-        auto sigShares = this->sigShares.GetAllForSignHash(signHash);
-        if (!sigShares) {
+        if (pendingRecoveries.count(signHash)) {
+            // recovery for this session is already running
+            return;
+        }
+        if (this->sigShares.CountForSignHash(signHash) == 0) {
             return;
         }
 
         sigSharesForRecovery.reserve((size_t) quorum->params.threshold);
         idsForRecovery.reserve((size_t) quorum->params.threshold);
-        for (auto it = sigShares->begin(); it != sigShares->end() && sigSharesForRecovery.size() < quorum->params.threshold; ++it) {
-            auto& sigShare = it->second;
+        this->sigShares.ForEachForSignHash(signHash, [&](const SigShareKey& k, const CSigShare& sigShare) {
+            if (sigSharesForRecovery.size() >= quorum->params.threshold) {
+                return;
+            }
             sigSharesForRecovery.emplace_back(sigShare.sigShare.Get());
-            idsForRecovery.emplace_back(quorum->members[sigShare.quorumMember]->proTxHash);
-        }
+            idsForRecovery.emplace_back(quorum->GetMemberId(sigShare.quorumMember));
+        });
 
         // check if we can recover the final signature
         if (sigSharesForRecovery.size() < quorum->params.threshold) {
             return;
         }
-    }
 
-    // now recover it
-    cxxtimer::Timer t(true);
-    CBLSSignature recoveredSig;
-    if (!recoveredSig.Recover(sigSharesForRecovery, idsForRecovery)) {
-        LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- failed to recover signature. id=%s, msgHash=%s, time=%d\n", __func__,
-                  id.ToString(), msgHash.ToString(), t.count());
-        return;
+        pendingRecoveries.emplace(signHash);
+
+        auto it = timeFirstSeenForSessions.find(signHash);
+        if (it != timeFirstSeenForSessions.end()) {
+            signingStats.Add(quorum->params.type, SigningStage::TimeToThreshold, GetTimeMillis() - it->second);
+        }
     }
 
-    LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- recovered signature. id=%s, msgHash=%s, time=%d\n", __func__,
-              id.ToString(), msgHash.ToString(), t.count());
+    // now recover it. This happens on the BLS worker so that the Lagrange interpolation does not block processing of
+    // the next batch of sig shares
+    auto t = std::make_shared<cxxtimer::Timer>(true);
+    blsWorker.AsyncRecoverSig(sigSharesForRecovery, idsForRecovery, [this, quorum, id, msgHash, signHash, t](const CBLSSignature& recoveredSig) {
+        {
+            LOCK(cs);
+            pendingRecoveries.erase(signHash);
+        }
+
+        if (!recoveredSig.IsValid()) {
+            LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- failed to recover signature. id=%s, msgHash=%s, time=%d\n", __func__,
+                      id.ToString(), msgHash.ToString(), t->count());
+            return;
+        }
+
+        LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- recovered signature. id=%s, msgHash=%s, time=%d\n", __func__,
+                  id.ToString(), msgHash.ToString(), t->count());
+        signingStats.Add(quorum->params.type, SigningStage::Recovery, t->count());
+
+        FinishRecoverSig(quorum, id, msgHash, recoveredSig);
+    });
+}
 
+void CSigSharesManager::FinishRecoverSig(const CQuorumCPtr& quorum, const uint256& id, const uint256& msgHash, const CBLSSignature& recoveredSig)
+{
     std::shared_ptr<CRecoveredSig> rs = std::make_shared<CRecoveredSig>();
     rs->llmqType = quorum->params.type;
     rs->quorumHash = quorum->qc.quorumHash;
@@ -862,7 +1008,7 @@ CDeterministicMNCPtr CSigSharesManager::SelectMemberForRecovery(const CQuorumCPt
     return v[attempt].second;
 }
 
-void CSigSharesManager::CollectSigSharesToRequest(std::unordered_map<NodeId, std::unordered_map<uint256, CSigSharesInv, StaticSaltedHasher>>& sigSharesToRequest)
+void CSigSharesManager::CollectSigSharesToRequest(std::unordered_map<NodeId, std::unordered_map<uint256, CSigSharesInv, StaticSaltedHasher>>& sigSharesToRequest, const std::unordered_set<NodeId>& dueNodes)
 {
     AssertLockHeld(cs);
 
@@ -897,6 +1043,11 @@ void CSigSharesManager::CollectSigSharesToRequest(std::unordered_map<NodeId, std
             return false;
         });
 
+        if (!dueNodes.count(nodeId)) {
+            // we'll batch up more requests for this node
+            continue;
+        }
+
         decltype(sigSharesToRequest.begin()->second)* invMap = nullptr;
 
         for (auto& p2 : nodeState.sessions) {
@@ -962,7 +1113,7 @@ void CSigSharesManager::CollectSigSharesToRequest(std::unordered_map<NodeId, std
     }
 }
 
-void CSigSharesManager::CollectSigSharesToSend(std::unordered_map<NodeId, std::unordered_map<uint256, CBatchedSigShares, StaticSaltedHasher>>& sigSharesToSend)
+void CSigSharesManager::CollectSigSharesToSend(std::unordered_map<NodeId, std::unordered_map<uint256, CBatchedSigShares, StaticSaltedHasher>>& sigSharesToSend, const std::unordered_set<NodeId>& dueNodes)
 {
     AssertLockHeld(cs);
 
@@ -970,7 +1121,7 @@ void CSigSharesManager::CollectSigSharesToSend(std::unordered_map<NodeId, std::u
         auto nodeId = p.first;
         auto& nodeState = p.second;
 
-        if (nodeState.banned) {
+        if (nodeState.banned || !dueNodes.count(nodeId)) {
             continue;
         }
 
@@ -1062,12 +1213,15 @@ void CSigSharesManager::CollectSigSharesToSendConcentrated(std::unordered_map<No
     }
 }
 
-void CSigSharesManager::CollectSigSharesToAnnounce(std::unordered_map<NodeId, std::unordered_map<uint256, CSigSharesInv, StaticSaltedHasher>>& sigSharesToAnnounce)
+void CSigSharesManager::CollectSigSharesToAnnounce(std::unordered_map<NodeId, std::unordered_map<uint256, CSigSharesInv, StaticSaltedHasher>>& sigSharesToAnnounce, const std::unordered_set<NodeId>& dueNodes)
 {
     AssertLockHeld(cs);
 
     std::unordered_map<std::pair<Consensus::LLMQType, uint256>, std::unordered_set<NodeId>, StaticSaltedHasher> quorumNodesMap;
 
+    // sig shares which still need to be announced to nodes which are not due yet
+    std::vector<SigShareKey> keepQueued;
+
     sigSharesQueuedToAnnounce.ForEach([&](const SigShareKey& sigShareKey, bool) {
         auto& signHash = sigShareKey.first;
         auto quorumMember = sigShareKey.second;
@@ -1100,6 +1254,13 @@ void CSigSharesManager::CollectSigSharesToAnnounce(std::unordered_map<NodeId, st
                 continue;
             }
 
+            if (!dueNodes.count(nodeId)) {
+                if (keepQueued.empty() || keepQueued.back() != sigShareKey) {
+                    keepQueued.emplace_back(sigShareKey);
+                }
+                continue;
+            }
+
             auto& inv = sigSharesToAnnounce[nodeId][signHash];
             if (inv.inv.empty()) {
                 const auto& params = Params().GetConsensus().llmqs.at((Consensus::LLMQType)sigShare->llmqType);
@@ -1110,11 +1271,56 @@ void CSigSharesManager::CollectSigSharesToAnnounce(std::unordered_map<NodeId, st
         }
     });
 
-    // don't announce these anymore
+    // don't announce these anymore, except to the nodes we deferred
     sigSharesQueuedToAnnounce.Clear();
+    for (const auto& k : keepQueued) {
+        sigSharesQueuedToAnnounce.Add(k, true);
+    }
 }
 
-bool CSigSharesManager::SendMessages()
+int64_t CSigSharesManager::CalcSendInterval(int64_t pingUsec)
+{
+    if (pingUsec <= 0) {
+        // no ping measured yet, stick to the slowest cadence
+        return SEND_INTERVAL_MAX;
+    }
+    // Waiting for a quarter of the round trip time adds little to the time until a recovered sig is available, while
+    // allowing more shares/invs to be combined into the same messages
+    int64_t interval = pingUsec / 1000 / 4;
+    if (interval < SEND_INTERVAL_MIN) {
+        return SEND_INTERVAL_MIN;
+    }
+    if (interval > SEND_INTERVAL_MAX) {
+        return SEND_INTERVAL_MAX;
+    }
+    return interval;
+}
+
+bool CSigSharesManager::IsSendDue(CSigSharesNodeState& nodeState, int64_t pingUsec, int64_t nowMs)
+{
+    AssertLockHeld(cs);
+
+    auto& stats = nodeState.sendStats;
+    stats.pingUsec = pingUsec;
+    stats.sendInterval = CalcSendInterval(pingUsec);
+    stats.queueDepth = nodeState.CountPendingSends() + sigSharesQueuedToAnnounce.Size();
+
+    // At low load, the first share after an idle period is sent out immediately as the last send is long ago. At high
+    // load, shares are collected for up to one send interval unless enough of them are queued to fill a batch
+    return nowMs - stats.lastSendTime >= stats.sendInterval || stats.queueDepth >= SEND_BATCH_TARGET;
+}
+
+void CSigSharesManager::GetNodeSendStats(std::map<NodeId, CSigSharesNodeState::SendStats>& retStats)
+{
+    LOCK(cs);
+    for (const auto& p : nodeStates) {
+        if (p.second.sendStats.flushes != 0) {
+            retStats.emplace(p.first, p.second.sendStats);
+        }
+    }
+}
+
+bool CSigSharesManager::SendMessages(bool& retDeferred)
 {
     std::unordered_map<NodeId, std::unordered_map<uint256, CSigSharesInv, StaticSaltedHasher>> sigSharesToRequest;
     std::unordered_map<NodeId, std::unordered_map<uint256, CBatchedSigShares, StaticSaltedHasher>> sigShareBatchesToSend;
@@ -1144,11 +1350,25 @@ bool CSigSharesManager::SendMessages()
 
     std::vector<CNode*> vNodesCopy = g_connman->CopyNodeVector(CConnman::FullyConnectedOnly);
 
+    int64_t nowMs = GetTimeMillis();
+    std::unordered_set<NodeId> dueNodes;
+    retDeferred = false;
+
     {
         LOCK(cs);
-        CollectSigSharesToRequest(sigSharesToRequest);
-        CollectSigSharesToSend(sigShareBatchesToSend);
-        CollectSigSharesToAnnounce(sigSharesToAnnounce);
+
+        for (auto& pnode : vNodesCopy) {
+            auto it = nodeStates.find(pnode->GetId());
+            if (it == nodeStates.end() || IsSendDue(it->second, pnode->nPingUsecTime, nowMs)) {
+                dueNodes.emplace(pnode->GetId());
+            } else if (it->second.sendStats.queueDepth != 0) {
+                retDeferred = true;
+            }
+        }
+
+        CollectSigSharesToRequest(sigSharesToRequest, dueNodes);
+        CollectSigSharesToSend(sigShareBatchesToSend, dueNodes);
+        CollectSigSharesToAnnounce(sigSharesToAnnounce, dueNodes);
         CollectSigSharesToSendConcentrated(sigSharesToSend, vNodesCopy);
 
         for (auto& p : sigSharesToRequest) {
@@ -1169,9 +1389,18 @@ bool CSigSharesManager::SendMessages()
     }
 
     bool didSend = false;
+    // <msgs, items> sent per node
+    std::unordered_map<NodeId, std::pair<uint64_t, uint64_t>> sentCounts;
 
     for (auto& pnode : vNodesCopy) {
         CNetMsgMaker msgMaker(pnode->GetSendVersion());
+        uint64_t sentMsgs = 0;
+        uint64_t sentItems = 0;
+        auto pushMessage = [&](CSerializedNetMsg&& msg, size_t items) {
+            g_connman->PushMessage(pnode, std::move(msg));
+            sentMsgs++;
+            sentItems += items;
+        };
 
         auto it1 = sigSessionAnnouncements.find(pnode->GetId());
         if (it1 != sigSessionAnnouncements.end()) {
@@ -1182,13 +1411,13 @@ bool CSigSharesManager::SendMessages()
                          CLLMQUtils::BuildSignHash(sigSesAnn).ToString(), sigSesAnn.sessionId, pnode->GetId());
                 msgs.emplace_back(sigSesAnn);
                 if (msgs.size() == MAX_MSGS_CNT_QSIGSESANN) {
-                    g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::QSIGSESANN, msgs));
+                    pushMessage(msgMaker.Make(NetMsgType::QSIGSESANN, msgs), msgs.size());
                     msgs.clear();
                     didSend = true;
                 }
             }
             if (!msgs.empty()) {
-                g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::QSIGSESANN, msgs));
+                pushMessage(msgMaker.Make(NetMsgType::QSIGSESANN, msgs), msgs.size());
                 didSend = true;
             }
         }
@@ -1202,13 +1431,13 @@ bool CSigSharesManager::SendMessages()
                          p.first.ToString(), p.second.ToString(), pnode->GetId());
                 msgs.emplace_back(std::move(p.second));
                 if (msgs.size() == MAX_MSGS_CNT_QGETSIGSHARES) {
-                    g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::QGETSIGSHARES, msgs));
+                    pushMessage(msgMaker.Make(NetMsgType::QGETSIGSHARES, msgs), msgs.size());
                     msgs.clear();
                     didSend = true;
                 }
             }
             if (!msgs.empty()) {
-                g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::QGETSIGSHARES, msgs));
+                pushMessage(msgMaker.Make(NetMsgType::QGETSIGSHARES, msgs), msgs.size());
                 didSend = true;
             }
         }
@@ -1222,7 +1451,7 @@ bool CSigSharesManager::SendMessages()
                 LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::SendMessages -- QBSIGSHARES signHash=%s, inv={%s}, node=%d\n",
                          p.first.ToString(), p.second.ToInvString(), pnode->GetId());
                 if (totalSigsCount + p.second.sigShares.size() > MAX_MSGS_TOTAL_BATCHED_SIGS) {
-                    g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::QBSIGSHARES, msgs));
+                    pushMessage(msgMaker.Make(NetMsgType::QBSIGSHARES, msgs), totalSigsCount);
                     msgs.clear();
                     totalSigsCount = 0;
                     didSend = true;
@@ -1232,7 +1461,7 @@ bool CSigSharesManager::SendMessages()
 
             }
             if (!msgs.empty()) {
-                g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::QBSIGSHARES, std::move(msgs)));
+                pushMessage(msgMaker.Make(NetMsgType::QBSIGSHARES, std::move(msgs)), totalSigsCount);
                 didSend = true;
             }
         }
@@ -1246,13 +1475,13 @@ bool CSigSharesManager::SendMessages()
                          p.first.ToString(), p.second.ToString(), pnode->GetId());
                 msgs.emplace_back(std::move(p.second));
                 if (msgs.size() == MAX_MSGS_CNT_QSIGSHARESINV) {
-                    g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::QSIGSHARESINV, msgs));
+                    pushMessage(msgMaker.Make(NetMsgType::QSIGSHARESINV, msgs), msgs.size());
                     msgs.clear();
                     didSend = true;
                 }
             }
             if (!msgs.empty()) {
-                g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::QSIGSHARESINV, msgs));
+                pushMessage(msgMaker.Make(NetMsgType::QSIGSHARESINV, msgs), msgs.size());
                 didSend = true;
             }
         }
@@ -1265,21 +1494,40 @@ bool CSigSharesManager::SendMessages()
                          sigShare.GetSignHash().ToString(), pnode->GetId());
                 msgs.emplace_back(std::move(sigShare));
                 if (msgs.size() == MAX_MSGS_SIG_SHARES) {
-                    g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::QSIGSHARE, msgs));
+                    pushMessage(msgMaker.Make(NetMsgType::QSIGSHARE, msgs), msgs.size());
                     msgs.clear();
                     didSend = true;
                 }
             }
             if (!msgs.empty()) {
-                g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::QSIGSHARE, msgs));
+                pushMessage(msgMaker.Make(NetMsgType::QSIGSHARE, msgs), msgs.size());
                 didSend = true;
             }
         }
+
+        if (sentMsgs != 0) {
+            sentCounts.emplace(pnode->GetId(), std::make_pair(sentMsgs, sentItems));
+        }
     }
 
     // looped through all nodes, release them
     g_connman->ReleaseNodeVector(vNodesCopy);
 
+    {
+        LOCK(cs);
+        for (const auto& p : sentCounts) {
+            auto it = nodeStates.find(p.first);
+            if (it == nodeStates.end()) {
+                continue;
+            }
+            auto& stats = it->second.sendStats;
+            stats.lastSendTime = nowMs;
+            stats.flushes++;
+            stats.msgs += p.second.first;
+            stats.items += p.second.second;
+        }
+    }
+
     return didSend;
 }
 
@@ -1289,7 +1537,7 @@ bool CSigSharesManager::GetSessionInfoByRecvId(NodeId nodeId, uint32_t sessionId
     return nodeStates[nodeId].GetSessionInfoByRecvId(sessionId, retInfo);
 }
 
-CSigShare CSigSharesManager::RebuildSigShare(const CSigSharesNodeState::SessionInfo& session, const CBatchedSigShares& batchedSigShares, size_t idx)
+CSigShare CSigSharesManager::RebuildSigShare(const CSigSharesNodeState::SessionInfo& session, const CBatchedSigSharesView& batchedSigShares, size_t idx)
 {
     assert(idx < batchedSigShares.sigShares.size());
     auto& s = batchedSigShares.sigShares[idx];
@@ -1299,7 +1547,7 @@ CSigShare CSigSharesManager::RebuildSigShare(const CSigSharesNodeState::SessionI
     sigShare.quorumMember = s.first;
     sigShare.id = session.id;
     sigShare.msgHash = session.msgHash;
-    sigShare.sigShare = s.second;
+    sigShare.sigShare = batchedSigShares.GetSigShare(idx);
     sigShare.UpdateKey();
     return sigShare;
 }
@@ -1379,10 +1627,15 @@ void CSigSharesManager::Cleanup()
             size_t count = sigShares.CountForSignHash(signHash);
 
             if (count > 0) {
-                auto m = sigShares.GetAllForSignHash(signHash);
-                assert(m);
+                const CSigShare* pOneSigShare{nullptr};
+                sigShares.ForEachForSignHash(signHash, [&](const SigShareKey& k, const CSigShare& sigShare) {
+                    if (!pOneSigShare) {
+                        pOneSigShare = &sigShare;
+                    }
+                });
+                assert(pOneSigShare);
 
-                auto& oneSigShare = m->begin()->second;
+                auto& oneSigShare = *pOneSigShare;
 
                 std::string strMissingMembers;
                 if (LogAcceptCategory(BCLog::LLMQ_SIGS)) {
@@ -1390,7 +1643,7 @@ void CSigSharesManager::Cleanup()
                     if (quorumIt != quorums.end()) {
                         auto& quorum = quorumIt->second;
                         for (size_t i = 0; i < quorum->members.size(); i++) {
-                            if (!m->count((uint16_t)i)) {
+                            if (!sigShares.Has(std::make_pair(signHash, (uint16_t)i))) {
                                 auto& dmn = quorum->members[i];
                                 strMissingMembers += strprintf("\n  %s", dmn->proTxHash.ToString());
                             }
@@ -1451,6 +1704,7 @@ void CSigSharesManager::RemoveSigSharesForSession(const uint256& signHash)
     sigShares.EraseAllForSignHash(signHash);
     signedSessions.erase(signHash);
     timeSeenForSessions.erase(signHash);
+    timeFirstSeenForSessions.erase(signHash);
 }
 
 void CSigSharesManager::RemoveBannedNodeStates()
@@ -1502,6 +1756,7 @@ void CSigSharesManager::BanNode(NodeId nodeId)
 void CSigSharesManager::WorkThreadMain()
 {
     int64_t lastSendTime = 0;
+    bool fDeferredSends = false;
 
     while (!workInterrupt) {
         if (!quorumSigningManager || !g_connman) {
@@ -1518,16 +1773,18 @@ void CSigSharesManager::WorkThreadMain()
         fMoreWork |= ProcessPendingSigShares(*g_connman);
         SignPendingSigShares();
 
-        if (GetTimeMillis() - lastSendTime > 100) {
-            SendMessages();
+        if (GetTimeMillis() - lastSendTime >= SEND_INTERVAL_MIN) {
+            SendMessages(fDeferredSends);
             lastSendTime = GetTimeMillis();
         }
 
         Cleanup();
         quorumSigningManager->Cleanup();
+        quorumSigningManager->FlushPendingWrites();
 
         // TODO Wakeup when pending signing is needed?
-        if (!fMoreWork && !workInterrupt.sleep_for(std::chrono::milliseconds(100))) {
+        // When sends were deferred to batch them up, wake up again as soon as the next node might become due
+        if (!fMoreWork && !workInterrupt.sleep_for(std::chrono::milliseconds(fDeferredSends ? SEND_INTERVAL_MIN : 100))) {
             return;
         }
     }
@@ -1536,77 +1793,126 @@ void CSigSharesManager::WorkThreadMain()
 void CSigSharesManager::AsyncSign(const CQuorumCPtr& quorum, const uint256& id, const uint256& msgHash)
 {
     LOCK(cs);
-    pendingSigns.emplace_back(quorum, id, msgHash);
+    pendingSigns.emplace_back(quorum, id, msgHash, GetTimeMillis());
 }
 
 void CSigSharesManager::SignPendingSigShares()
 {
-    std::vector<std::tuple<const CQuorumCPtr, uint256, uint256>> v;
+    std::vector<std::tuple<const CQuorumCPtr, uint256, uint256, int64_t>> v;
     {
         LOCK(cs);
         v = std::move(pendingSigns);
     }
 
-    for (auto& t : v) {
-        const CQuorumCPtr pQuorum = std::get<0>(t);
-        CSigShare sigShare = CreateSigShare(pQuorum, std::get<1>(t), std::get<2>(t));
+    if (v.empty()) {
+        return;
+    }
 
-        if (sigShare.sigShare.Get().IsValid()) {
+    cxxtimer::Timer t(true);
 
-            ProcessSigShare(sigShare, *g_connman, pQuorum);
+    // Prepare all shares first and sign them on the BLS worker. When we are a member of many quorums, a lot of shares
+    // become pending at once (e.g. for all the inputs of an IS lock) and signing them one by one would make our own
+    // signing latency grow with the number of quorums we're in
+    std::vector<std::pair<CSigShare, const CQuorumCPtr>> preparedShares;
+    std::vector<std::future<CBLSSignature>> futures;
+    preparedShares.reserve(v.size());
+    futures.reserve(v.size());
+    for (auto& p : v) {
+        const CQuorumCPtr pQuorum = std::get<0>(p);
+        signingStats.Add(pQuorum->params.type, SigningStage::SignQueueWait, GetTimeMillis() - std::get<3>(p));
+
+        CSigShare sigShare;
+        if (!PrepareSigShare(pQuorum, std::get<1>(p), std::get<2>(p), sigShare)) {
+            continue;
+        }
+        futures.emplace_back(blsWorker.AsyncSign(pQuorum->GetSkShare(), CLLMQUtils::BuildSignHash(sigShare)));
+        preparedShares.emplace_back(std::move(sigShare), pQuorum);
+    }
 
-            if (CLLMQUtils::IsAllMembersConnectedEnabled(pQuorum->params.type)) {
-                LOCK(cs);
-                auto& session = signedSessions[sigShare.GetSignHash()];
-                session.sigShare = sigShare;
-                session.quorum = pQuorum;
-                session.nextAttemptTime = 0;
-                session.attempt = 0;
-            }
+    // All shares are finished before the first one is processed, so that they end up in the same announcement batch
+    std::vector<std::pair<CSigShare, const CQuorumCPtr>> signedShares;
+    signedShares.reserve(preparedShares.size());
+    for (size_t i = 0; i < preparedShares.size(); i++) {
+        auto& sigShare = preparedShares[i].first;
+        if (FinishSigShare(sigShare, futures[i].get())) {
+            signedShares.emplace_back(std::move(preparedShares[i]));
+        }
+    }
+
+    LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- signed %d of %d pending sigShares, time=%d\n", __func__,
+             signedShares.size(), v.size(), t.count());
+
+    for (auto& p : signedShares) {
+        const CSigShare& sigShare = p.first;
+        const CQuorumCPtr& pQuorum = p.second;
+
+        ProcessSigShare(sigShare, *g_connman, pQuorum);
+
+        if (CLLMQUtils::IsAllMembersConnectedEnabled(pQuorum->params.type)) {
+            LOCK(cs);
+            auto& session = signedSessions[sigShare.GetSignHash()];
+            session.sigShare = sigShare;
+            session.quorum = pQuorum;
+            session.nextAttemptTime = 0;
+            session.attempt = 0;
         }
     }
 }
 
-CSigShare CSigSharesManager::CreateSigShare(const CQuorumCPtr& quorum, const uint256& id, const uint256& msgHash)
+bool CSigSharesManager::PrepareSigShare(const CQuorumCPtr& quorum, const uint256& id, const uint256& msgHash, CSigShare& sigShareRet) const
 {
-    cxxtimer::Timer t(true);
-
     if (!quorum->IsValidMember(activeMasternodeInfo.proTxHash)) {
-        return {};
+        return false;
     }
 
     const CBLSSecretKey& skShare = quorum->GetSkShare();
     if (!skShare.IsValid()) {
         LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- we don't have our skShare for quorum %s\n", __func__, quorum->qc.quorumHash.ToString());
-        return {};
+        return false;
     }
 
     int memberIdx = quorum->GetMemberIndex(activeMasternodeInfo.proTxHash);
     if (memberIdx == -1) {
         // this should really not happen (IsValidMember gave true)
-        return {};
+        return false;
     }
 
-    CSigShare sigShare;
-    sigShare.llmqType = quorum->params.type;
-    sigShare.quorumHash = quorum->qc.quorumHash;
-    sigShare.id = id;
-    sigShare.msgHash = msgHash;
-    sigShare.quorumMember = (uint16_t)memberIdx;
+    sigShareRet.llmqType = quorum->params.type;
+    sigShareRet.quorumHash = quorum->qc.quorumHash;
+    sigShareRet.id = id;
+    sigShareRet.msgHash = msgHash;
+    sigShareRet.quorumMember = (uint16_t)memberIdx;
+    return true;
+}
+
+bool CSigSharesManager::FinishSigShare(CSigShare& sigShare, const CBLSSignature& sig) const
+{
     uint256 signHash = CLLMQUtils::BuildSignHash(sigShare);
 
-    sigShare.sigShare.Set(skShare.Sign(signHash));
-    if (!sigShare.sigShare.Get().IsValid()) {
-        LogPrintf("CSigSharesManager::%s -- failed to sign sigShare. signHash=%s, id=%s, msgHash=%s, time=%s\n", __func__,
-                  signHash.ToString(), sigShare.id.ToString(), sigShare.msgHash.ToString(), t.count());
-        return {};
+    sigShare.sigShare.Set(sig);
+    if (!sig.IsValid()) {
+        LogPrintf("CSigSharesManager::%s -- failed to sign sigShare. signHash=%s, id=%s, msgHash=%s\n", __func__,
+                  signHash.ToString(), sigShare.id.ToString(), sigShare.msgHash.ToString());
+        return false;
     }
 
     sigShare.UpdateKey();
 
-    LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- created sigShare. signHash=%s, id=%s, msgHash=%s, llmqType=%d, quorum=%s, time=%s\n", __func__,
-              signHash.ToString(), sigShare.id.ToString(), sigShare.msgHash.ToString(), quorum->params.type, quorum->qc.quorumHash.ToString(), t.count());
+    LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- created sigShare. signHash=%s, id=%s, msgHash=%s, llmqType=%d, quorum=%s\n", __func__,
+              signHash.ToString(), sigShare.id.ToString(), sigShare.msgHash.ToString(), sigShare.llmqType, sigShare.quorumHash.ToString());
 
+    return true;
+}
+
+CSigShare CSigSharesManager::CreateSigShare(const CQuorumCPtr& quorum, const uint256& id, const uint256& msgHash)
+{
+    CSigShare sigShare;
+    if (!PrepareSigShare(quorum, id, msgHash, sigShare)) {
+        return {};
+    }
+    if (!FinishSigShare(sigShare, quorum->GetSkShare().Sign(CLLMQUtils::BuildSignHash(sigShare)))) {
+        return {};
+    }
     return sigShare;
 }
 
@@ -1619,13 +1925,10 @@ void CSigSharesManager::ForceReAnnouncement(const CQuorumCPtr& quorum, Consensus
 
     LOCK(cs);
     auto signHash = CLLMQUtils::BuildSignHash(llmqType, quorum->qc.quorumHash, id, msgHash);
-    auto sigs = sigShares.GetAllForSignHash(signHash);
-    if (sigs) {
-        for (auto& p : *sigs) {
-            // re-announce every sigshare to every node
-            sigSharesQueuedToAnnounce.Add(std::make_pair(signHash, p.first), true);
-        }
-    }
+    sigShares.ForEachForSignHash(signHash, [&](const SigShareKey& k, const CSigShare& sigShare) {
+        // re-announce every sigshare to every node
+        sigSharesQueuedToAnnounce.Add(k, true);
+    });
     for (auto& p : nodeStates) {
         CSigSharesNodeState& nodeState = p.second;
         auto session = nodeState.GetSessionBySignHash(signHash);
@@ -6,17 +6,22 @@
 #define BITCOIN_LLMQ_QUORUMS_SIGNING_SHARES_H
 
 #include <bls/bls.h>
+#include <bls/bls_worker.h>
 #include <chainparams.h>
 #include <net.h>
 #include <random.h>
 #include <saltedhasher.h>
 #include <serialize.h>
+#include <streams.h>
 #include <sync.h>
 #include <tinyformat.h>
 #include <uint256.h>
 
 #include <llmq/quorums.h>
 
+#include <ctpl.h>
+
+#include <algorithm>
 #include <thread>
 #include <mutex>
 #include <unordered_map>
@@ -27,6 +32,10 @@ class CScheduler;
 
 namespace llmq
 {
+// 0 = auto, derived from the number of cores
+static const int DEFAULT_SIGSHARES_VERIFY_THREADS = 0;
+static const int MAX_SIGSHARES_VERIFY_THREADS = 8;
+
 // <signHash, quorumMember>
 typedef std::pair<uint256, uint16_t> SigShareKey;
 
@@ -146,58 +155,206 @@ public:
     std::string ToInvString() const;
 };
 
+// Receive-side counterpart of CBatchedSigShares. It is parsed in place from the buffer of the received QBSIGSHARES
+// message and only references the serialized sig shares. Signatures are copied out of the buffer when a share passed
+// pre-verification and turned out to be new. The buffer must outlive the view
+class CBatchedSigSharesView
+{
+public:
+    uint32_t sessionId{(uint32_t)-1};
+    std::vector<std::pair<uint16_t, Span<const unsigned char>>> sigShares;
+
+public:
+    void Unserialize(SpanReader& s)
+    {
+        sessionId = ReadVarInt<SpanReader, VarIntMode::DEFAULT, uint32_t>(s);
+        uint64_t count = ReadCompactSize(s);
+        // don't trust the announced count for the allocation, each entry needs at least one member index and a sig
+        sigShares.clear();
+        sigShares.reserve(std::min<uint64_t>(count, s.size() / (sizeof(uint16_t) + CBLSSignature::SerSize)));
+        for (uint64_t i = 0; i < count; i++) {
+            uint16_t quorumMember;
+            s >> quorumMember;
+            sigShares.emplace_back(quorumMember, s.Peek(CBLSSignature::SerSize));
+            s.ignore(CBLSSignature::SerSize);
+        }
+    }
+
+    CBLSLazySignature GetSigShare(size_t idx) const;
+    std::string ToInvString() const;
+};
+
+// Maps sig share keys to values. Sessions (sign hashes) are assigned compact slot indexes and each slot holds a flat,
+// bitmap-backed slab of per-member values. Slots of removed sessions are recycled, so that adding a share to an
+// already known session never allocates and iterating all entries only walks contiguous memory
 template<typename T>
 class SigShareMap
 {
 private:
-    std::unordered_map<uint256, std::unordered_map<uint16_t, T>, StaticSaltedHasher> internalMap;
+    struct Entry {
+        T v;
+    };
+    struct Slot {
+        uint256 signHash;
+        size_t count{0};
+        std::vector<uint64_t> bitmap;
+        std::vector<Entry> entries;
+
+        bool Has(uint16_t quorumMember) const
+        {
+            size_t w = quorumMember / 64;
+            return w < bitmap.size() && ((bitmap[w] >> (quorumMember % 64)) & 1);
+        }
+        void Set(uint16_t quorumMember)
+        {
+            size_t w = quorumMember / 64;
+            if (w >= bitmap.size()) {
+                bitmap.resize(w + 1, 0);
+            }
+            if (quorumMember >= entries.size()) {
+                entries.resize((size_t)quorumMember + 1);
+            }
+            bitmap[w] |= (uint64_t)1 << (quorumMember % 64);
+            count++;
+        }
+        void Unset(uint16_t quorumMember)
+        {
+            bitmap[quorumMember / 64] &= ~((uint64_t)1 << (quorumMember % 64));
+            count--;
+        }
+        void Release()
+        {
+            signHash.SetNull();
+            count = 0;
+            std::fill(bitmap.begin(), bitmap.end(), 0);
+            // drop the values so that they don't hold on to memory while the slot is unused
+            std::vector<Entry>().swap(entries);
+        }
+
+        template<typename F>
+        void ForEachSet(F&& f) const
+        {
+            for (size_t w = 0; w < bitmap.size(); w++) {
+                uint64_t bits = bitmap[w];
+                for (size_t i = 0; bits != 0; i++, bits >>= 1) {
+                    if (bits & 1) {
+                        f((uint16_t)(w * 64 + i));
+                    }
+                }
+            }
+        }
+    };
+
+    std::unordered_map<uint256, uint32_t, StaticSaltedHasher> slotBySignHash;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    size_t totalCount{0};
+
+    Slot* GetSlot(const uint256& signHash)
+    {
+        auto it = slotBySignHash.find(signHash);
+        if (it == slotBySignHash.end()) {
+            return nullptr;
+        }
+        return &slots[it->second];
+    }
+    const Slot* GetSlot(const uint256& signHash) const
+    {
+        auto it = slotBySignHash.find(signHash);
+        if (it == slotBySignHash.end()) {
+            return nullptr;
+        }
+        return &slots[it->second];
+    }
+    Slot& GetOrAddSlot(const uint256& signHash)
+    {
+        auto it = slotBySignHash.find(signHash);
+        if (it != slotBySignHash.end()) {
+            return slots[it->second];
+        }
+        uint32_t idx;
+        if (!freeSlots.empty()) {
+            idx = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            idx = (uint32_t)slots.size();
+            slots.emplace_back();
+        }
+        slots[idx].signHash = signHash;
+        slotBySignHash.emplace(signHash, idx);
+        return slots[idx];
+    }
+    void ReleaseSlot(const uint256& signHash)
+    {
+        auto it = slotBySignHash.find(signHash);
+        if (it == slotBySignHash.end()) {
+            return;
+        }
+        uint32_t idx = it->second;
+        totalCount -= slots[idx].count;
+        slots[idx].Release();
+        slotBySignHash.erase(it);
+        if (idx + 1 == slots.size()) {
+            slots.pop_back();
+            // also drop all trailing free slots
+            while (!slots.empty() && slots.back().signHash.IsNull()) {
+                slots.pop_back();
+            }
+            freeSlots.erase(std::remove_if(freeSlots.begin(), freeSlots.end(), [&](uint32_t i) {
+                return i >= slots.size();
+            }), freeSlots.end());
+        } else {
+            freeSlots.emplace_back(idx);
+        }
+    }
 
 public:
     bool Add(const SigShareKey& k, const T& v)
     {
-        auto& m = internalMap[k.first];
-        return m.emplace(k.second, v).second;
+        auto& slot = GetOrAddSlot(k.first);
+        if (slot.Has(k.second)) {
+            return false;
+        }
+        slot.Set(k.second);
+        slot.entries[k.second].v = v;
+        totalCount++;
+        return true;
     }
 
     void Erase(const SigShareKey& k)
     {
-        auto it = internalMap.find(k.first);
-        if (it == internalMap.end()) {
+        auto slot = GetSlot(k.first);
+        if (!slot || !slot->Has(k.second)) {
             return;
         }
-        it->second.erase(k.second);
-        if (it->second.empty()) {
-            internalMap.erase(it);
+        slot->Unset(k.second);
+        totalCount--;
+        if (slot->count == 0) {
+            ReleaseSlot(k.first);
         }
     }
 
     void Clear()
     {
-        internalMap.clear();
+        slotBySignHash.clear();
+        slots.clear();
+        freeSlots.clear();
+        totalCount = 0;
     }
 
     bool Has(const SigShareKey& k) const
     {
-        auto it = internalMap.find(k.first);
-        if (it == internalMap.end()) {
-            return false;
-        }
-        return it->second.count(k.second) != 0;
+        auto slot = GetSlot(k.first);
+        return slot && slot->Has(k.second);
     }
 
     T* Get(const SigShareKey& k)
     {
-        auto it = internalMap.find(k.first);
-        if (it == internalMap.end()) {
-            return nullptr;
-        }
-
-        auto jt = it->second.find(k.second);
-        if (jt == it->second.end()) {
+        auto slot = GetSlot(k.first);
+        if (!slot || !slot->Has(k.second)) {
             return nullptr;
         }
-
-        return &jt->second;
+        return &slot->entries[k.second].v;
     }
 
     T& GetOrAdd(const SigShareKey& k)
@@ -212,83 +369,103 @@ public:
 
     const T* GetFirst() const
     {
-        if (internalMap.empty()) {
-            return nullptr;
+        for (const auto& slot : slots) {
+            if (slot.count == 0) {
+                continue;
+            }
+            for (size_t w = 0; w < slot.bitmap.size(); w++) {
+                if (slot.bitmap[w] != 0) {
+                    size_t i = 0;
+                    while (!((slot.bitmap[w] >> i) & 1)) {
+                        i++;
+                    }
+                    return &slot.entries[w * 64 + i].v;
+                }
+            }
         }
-        return &internalMap.begin()->second.begin()->second;
+        return nullptr;
     }
 
     size_t Size() const
     {
-        size_t s = 0;
-        for (auto& p : internalMap) {
-            s += p.second.size();
-        }
-        return s;
+        return totalCount;
     }
 
     size_t CountForSignHash(const uint256& signHash) const
     {
-        auto it = internalMap.find(signHash);
-        if (it == internalMap.end()) {
+        auto slot = GetSlot(signHash);
+        if (!slot) {
             return 0;
         }
-        return it->second.size();
+        return slot->count;
     }
 
     bool Empty() const
     {
-        return internalMap.empty();
-    }
-
-    const std::unordered_map<uint16_t, T>* GetAllForSignHash(const uint256& signHash)
-    {
-        auto it = internalMap.find(signHash);
-        if (it == internalMap.end()) {
-            return nullptr;
-        }
-        return &it->second;
+        return totalCount == 0;
     }
 
     void EraseAllForSignHash(const uint256& signHash)
     {
-        internalMap.erase(signHash);
+        ReleaseSlot(signHash);
     }
 
     template<typename F>
     void EraseIf(F&& f)
     {
-        for (auto it = internalMap.begin(); it != internalMap.end(); ) {
+        std::vector<uint256> emptySessions;
+        for (auto& slot : slots) {
+            if (slot.count == 0) {
+                continue;
+            }
             SigShareKey k;
-            k.first = it->first;
-            for (auto jt = it->second.begin(); jt != it->second.end(); ) {
-                k.second = jt->first;
-                if (f(k, jt->second)) {
-                    jt = it->second.erase(jt);
-                } else {
-                    ++jt;
+            k.first = slot.signHash;
+            slot.ForEachSet([&](uint16_t quorumMember) {
+                k.second = quorumMember;
+                if (f(k, slot.entries[quorumMember].v)) {
+                    slot.Unset(quorumMember);
+                    totalCount--;
                 }
-            }
-            if (it->second.empty()) {
-                it = internalMap.erase(it);
-            } else {
-                ++it;
+            });
+            if (slot.count == 0) {
+                emptySessions.emplace_back(slot.signHash);
             }
         }
+        for (const auto& signHash : emptySessions) {
+            ReleaseSlot(signHash);
+        }
     }
 
     template<typename F>
     void ForEach(F&& f)
     {
-        for (auto& p : internalMap) {
-            SigShareKey k;
-            k.first = p.first;
-            for (auto& p2 : p.second) {
-                k.second = p2.first;
-                f(k, p2.second);
+        for (auto& slot : slots) {
+            if (slot.count == 0) {
+                continue;
             }
+            SigShareKey k;
+            k.first = slot.signHash;
+            slot.ForEachSet([&](uint16_t quorumMember) {
+                k.second = quorumMember;
+                f(k, slot.entries[quorumMember].v);
+            });
         }
     }
+
+    template<typename F>
+    void ForEachForSignHash(const uint256& signHash, F&& f)
+    {
+        auto slot = GetSlot(signHash);
+        if (!slot) {
+            return;
+        }
+        SigShareKey k;
+        k.first = signHash;
+        slot->ForEachSet([&](uint16_t quorumMember) {
+            k.second = quorumMember;
+            f(k, slot->entries[quorumMember].v);
+        });
+    }
 };
 
 class CSigSharesNodeState
@@ -331,6 +508,18 @@ public:
     SigShareMap<CSigShare> pendingIncomingSigShares;
     SigShareMap<int64_t> requestedSigShares;
 
+    // Outgoing messages to this node are batched adaptively, see CSigSharesManager::IsSendDue
+    struct SendStats {
+        int64_t lastSendTime{0};
+        int64_t sendInterval{0};
+        int64_t pingUsec{0};
+        size_t queueDepth{0};
+        uint64_t flushes{0};
+        uint64_t msgs{0};
+        uint64_t items{0};
+    };
+    SendStats sendStats;
+
     bool banned{false};
 
     Session& GetOrCreateSessionFromShare(const CSigShare& sigShare);
@@ -338,6 +527,7 @@ public:
     Session* GetSessionBySignHash(const uint256& signHash);
     Session* GetSessionByRecvId(uint32_t sessionId);
     bool GetSessionInfoByRecvId(uint32_t sessionId, SessionInfo& retInfo);
+    size_t CountPendingSends() const;
 
     void RemoveSession(const uint256& signHash);
 };
@@ -364,6 +554,12 @@ class CSigSharesManager : public CRecoveredSigsListener
     // 400 is the maximum quorum size, so this is also the maximum number of sigs we need to support
     const size_t MAX_MSGS_TOTAL_BATCHED_SIGS = 400;
 
+    // bounds for the per-node send interval in milliseconds. Nodes with unknown ping time use the maximum
+    static const int64_t SEND_INTERVAL_MIN = 10;
+    static const int64_t SEND_INTERVAL_MAX = 100;
+    // a node with at least this many pending shares/invs is served without waiting for its send interval
+    const size_t SEND_BATCH_TARGET = 100;
+
     const int64_t EXP_SEND_FOR_RECOVERY_TIMEOUT = 2000;
     const int64_t MAX_SEND_FOR_RECOVERY_TIMEOUT = 10000;
     const size_t MAX_MSGS_SIG_SHARES = 32;
@@ -371,20 +567,32 @@ class CSigSharesManager : public CRecoveredSigsListener
 private:
     CCriticalSection cs;
 
+    CBLSWorker& blsWorker;
+
     std::thread workThread;
     CThreadInterrupt workInterrupt;
 
+    // verification of pending sig shares is split by session and spread over these workers
+    ctpl::thread_pool verifyWorkerPool;
+    int verifyWorkerCount{1};
+
     SigShareMap<CSigShare> sigShares;
     std::unordered_map<uint256, CSignedSession, StaticSaltedHasher> signedSessions;
 
     // stores time of last receivedSigShare. Used to detect timeouts
     std::unordered_map<uint256, int64_t, StaticSaltedHasher> timeSeenForSessions;
+    // time in ms we've seen the first sigShare of a session. Used for latency stats
+    std::unordered_map<uint256, int64_t, StaticSaltedHasher> timeFirstSeenForSessions;
 
     std::unordered_map<NodeId, CSigSharesNodeState> nodeStates;
     SigShareMap<std::pair<NodeId, int64_t>> sigSharesRequested;
     SigShareMap<bool> sigSharesQueuedToAnnounce;
 
-    std::vector<std::tuple<const CQuorumCPtr, uint256, uint256>> pendingSigns;
+    // quorum, id, msgHash and the time (in ms) the sign request was queued
+    std::vector<std::tuple<const CQuorumCPtr, uint256, uint256, int64_t>> pendingSigns;
+
+    // sessions for which a recovery is currently running on the BLS worker
+    std::unordered_set<uint256, StaticSaltedHasher> pendingRecoveries;
 
     // must be protected by cs
     FastRandomContext rnd;
@@ -393,7 +601,7 @@ private:
     std::atomic<uint32_t> recoveredSigsCounter{0};
 
 public:
-    CSigSharesManager();
+    explicit CSigSharesManager(CBLSWorker& _blsWorker);
     ~CSigSharesManager();
 
     void StartWorkerThread();
@@ -413,32 +621,39 @@ public:
 
     static CDeterministicMNCPtr SelectMemberForRecovery(const CQuorumCPtr& quorum, const uint256& id, int attempt);
 
+    void GetNodeSendStats(std::map<NodeId, CSigSharesNodeState::SendStats>& retStats);
+
 private:
     // all of these return false when the currently processed message should be aborted (as each message actually contains multiple messages)
     bool ProcessMessageSigSesAnn(CNode* pfrom, const CSigSesAnn& ann);
     bool ProcessMessageSigSharesInv(CNode* pfrom, const CSigSharesInv& inv);
     bool ProcessMessageGetSigShares(CNode* pfrom, const CSigSharesInv& inv);
-    bool ProcessMessageBatchedSigShares(CNode* pfrom, const CBatchedSigShares& batchedSigShares);
+    bool ProcessMessageBatchedSigShares(CNode* pfrom, const CBatchedSigSharesView& batchedSigShares);
     void ProcessMessageSigShare(NodeId fromId, const CSigShare& sigShare);
 
     static bool VerifySigSharesInv(Consensus::LLMQType llmqType, const CSigSharesInv& inv);
-    static bool PreVerifyBatchedSigShares(const CSigSharesNodeState::SessionInfo& session, const CBatchedSigShares& batchedSigShares, bool& retBan);
+    static bool PreVerifyBatchedSigShares(const CSigSharesNodeState::SessionInfo& session, const CBatchedSigSharesView& batchedSigShares, bool& retBan);
 
     void CollectPendingSigSharesToVerify(size_t maxUniqueSessions,
             std::unordered_map<NodeId, std::vector<CSigShare>>& retSigShares,
             std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher>& retQuorums);
     bool ProcessPendingSigShares(CConnman& connman);
 
+    std::set<NodeId> VerifyPendingSigShares(const std::vector<std::pair<NodeId, const CSigShare*>>& sigShares,
+            const std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher>& quorums,
+            size_t& retVerifyCount);
+
     void ProcessPendingSigShares(const std::vector<CSigShare>& sigShares,
             const std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher>& quorums,
             CConnman& connman);
 
     void ProcessSigShare(const CSigShare& sigShare, CConnman& connman, const CQuorumCPtr& quorum);
     void TryRecoverSig(const CQuorumCPtr& quorum, const uint256& id, const uint256& msgHash);
+    void FinishRecoverSig(const CQuorumCPtr& quorum, const uint256& id, const uint256& msgHash, const CBLSSignature& recoveredSig);
 
 private:
     bool GetSessionInfoByRecvId(NodeId nodeId, uint32_t sessionId, CSigSharesNodeState::SessionInfo& retInfo);
-    static CSigShare RebuildSigShare(const CSigSharesNodeState::SessionInfo& session, const CBatchedSigShares& batchedSigShares, size_t idx);
+    static CSigShare RebuildSigShare(const CSigSharesNodeState::SessionInfo& session, const CBatchedSigSharesView& batchedSigShares, size_t idx);
 
     void Cleanup();
     void RemoveSigSharesForSession(const uint256& signHash);
@@ -446,12 +661,16 @@ private:
 
     void BanNode(NodeId nodeId);
 
-    bool SendMessages();
-    void CollectSigSharesToRequest(std::unordered_map<NodeId, std::unordered_map<uint256, CSigSharesInv, StaticSaltedHasher>>& sigSharesToRequest);
-    void CollectSigSharesToSend(std::unordered_map<NodeId, std::unordered_map<uint256, CBatchedSigShares, StaticSaltedHasher>>& sigSharesToSend);
+    static int64_t CalcSendInterval(int64_t pingUsec);
+    bool IsSendDue(CSigSharesNodeState& nodeState, int64_t pingUsec, int64_t nowMs);
+    bool SendMessages(bool& retDeferred);
+    void CollectSigSharesToRequest(std::unordered_map<NodeId, std::unordered_map<uint256, CSigSharesInv, StaticSaltedHasher>>& sigSharesToRequest, const std::unordered_set<NodeId>& dueNodes);
+    void CollectSigSharesToSend(std::unordered_map<NodeId, std::unordered_map<uint256, CBatchedSigShares, StaticSaltedHasher>>& sigSharesToSend, const std::unordered_set<NodeId>& dueNodes);
     void CollectSigSharesToSendConcentrated(std::unordered_map<NodeId, std::vector<CSigShare>>& sigSharesToSend, const std::vector<CNode*>& vNodes);
-    void CollectSigSharesToAnnounce(std::unordered_map<NodeId, std::unordered_map<uint256, CSigSharesInv, StaticSaltedHasher>>& sigSharesToAnnounce);
+    void CollectSigSharesToAnnounce(std::unordered_map<NodeId, std::unordered_map<uint256, CSigSharesInv, StaticSaltedHasher>>& sigSharesToAnnounce, const std::unordered_set<NodeId>& dueNodes);
     void SignPendingSigShares();
+    bool PrepareSigShare(const CQuorumCPtr& quorum, const uint256& id, const uint256& msgHash, CSigShare& sigShareRet) const;
+    bool FinishSigShare(CSigShare& sigShare, const CBLSSignature& sig) const;
     void WorkThreadMain();
 };
 
@@ -0,0 +1,103 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <llmq/quorums_signing_stats.h>
+#include <llmq/quorums_utils.h>
+
+#include <statsd_client.h>
+#include <tinyformat.h>
+
+namespace llmq
+{
+
+CSigningStats signingStats;
+
+const std::array<int64_t, CLatencyHistogram::BUCKET_COUNT - 1> CLatencyHistogram::BUCKET_BOUNDS = {
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000
+};
+
+const char* SigningStageToString(SigningStage stage)
+{
+    switch (stage) {
+    case SigningStage::SignQueueWait:
+        return "signQueueWait";
+    case SigningStage::TimeToThreshold:
+        return "timeToThreshold";
+    case SigningStage::VerifyBatch:
+        return "verifyBatch";
+    case SigningStage::Recovery:
+        return "recovery";
+    case SigningStage::ListenerDispatch:
+        return "listenerDispatch";
+    default:
+        return "unknown";
+    }
+}
+
+void CLatencyHistogram::Add(int64_t ms)
+{
+    if (ms < 0) {
+        ms = 0;
+    }
+
+    size_t i = 0;
+    while (i < BUCKET_BOUNDS.size() && ms > BUCKET_BOUNDS[i]) {
+        i++;
+    }
+    buckets[i]++;
+    count++;
+    sumMs += ms;
+    if (ms > maxMs) {
+        maxMs = ms;
+    }
+}
+
+UniValue CLatencyHistogram::ToJson() const
+{
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("count", count);
+    ret.pushKV("avg", count != 0 ? (double)sumMs / count : 0.0);
+    ret.pushKV("max", maxMs);
+
+    UniValue bucketsArr(UniValue::VOBJ);
+    for (size_t i = 0; i < buckets.size(); i++) {
+        std::string name = i < BUCKET_BOUNDS.size() ? strprintf("<=%d", BUCKET_BOUNDS[i]) : strprintf(">%d", BUCKET_BOUNDS.back());
+        bucketsArr.pushKV(name, buckets[i]);
+    }
+    ret.pushKV("buckets", bucketsArr);
+    return ret;
+}
+
+void CSigningStats::Add(Consensus::LLMQType llmqType, SigningStage stage, int64_t ms)
+{
+    {
+        LOCK(cs);
+        histograms[std::make_pair(llmqType, stage)].Add(ms);
+    }
+    statsClient.timing(strprintf("llmq.%s.signing.%s_ms", GetLLMQParams(llmqType).name, SigningStageToString(stage)), ms < 0 ? 0 : ms, 1.0f);
+}
+
+UniValue CSigningStats::ToJson() const
+{
+    LOCK(cs);
+
+    UniValue ret(UniValue::VOBJ);
+    std::map<Consensus::LLMQType, UniValue> byType;
+    for (const auto& p : histograms) {
+        auto it = byType.emplace(p.first.first, UniValue(UniValue::VOBJ)).first;
+        it->second.pushKV(SigningStageToString(p.first.second), p.second.ToJson());
+    }
+    for (const auto& p : byType) {
+        ret.pushKV(GetLLMQParams(p.first).name, p.second);
+    }
+    return ret;
+}
+
+void CSigningStats::Reset()
+{
+    LOCK(cs);
+    histograms.clear();
+}
+
+} // namespace llmq
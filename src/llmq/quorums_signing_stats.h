@@ -0,0 +1,69 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_LLMQ_QUORUMS_SIGNING_STATS_H
+#define BITCOIN_LLMQ_QUORUMS_SIGNING_STATS_H
+
+#include <consensus/params.h>
+#include <sync.h>
+#include <univalue.h>
+
+#include <array>
+#include <map>
+
+namespace llmq
+{
+
+// The individual stages a signing request passes through until the recovered signature is handed to the listeners
+enum class SigningStage {
+    SignQueueWait,    // time between CSigSharesManager::AsyncSign and the creation of our own sig share
+    TimeToThreshold,  // time between the first sig share of a session and the start of recovery
+    VerifyBatch,      // time spent in a single batch verification of incoming sig shares
+    Recovery,         // time spent recovering the threshold signature from the sig shares
+    ListenerDispatch, // time spent in the recovered sig listeners
+    COUNT,
+};
+
+const char* SigningStageToString(SigningStage stage);
+
+/**
+ * Simple latency histogram with fixed bucket bounds in milliseconds. The last bucket catches everything above the
+ * largest bound.
+ */
+class CLatencyHistogram
+{
+public:
+    static const size_t BUCKET_COUNT = 14;
+    static const std::array<int64_t, BUCKET_COUNT - 1> BUCKET_BOUNDS;
+
+    std::array<uint64_t, BUCKET_COUNT> buckets{};
+    uint64_t count{0};
+    int64_t sumMs{0};
+    int64_t maxMs{0};
+
+public:
+    void Add(int64_t ms);
+    UniValue ToJson() const;
+};
+
+/**
+ * Collects per LLMQType latency histograms of the signing pipeline and forwards every sample to statsd
+ */
+class CSigningStats
+{
+private:
+    mutable CCriticalSection cs;
+    std::map<std::pair<Consensus::LLMQType, SigningStage>, CLatencyHistogram> histograms;
+
+public:
+    void Add(Consensus::LLMQType llmqType, SigningStage stage, int64_t ms);
+    UniValue ToJson() const;
+    void Reset();
+};
+
+extern CSigningStats signingStats;
+
+} // namespace llmq
+
+#endif // BITCOIN_LLMQ_QUORUMS_SIGNING_STATS_H
@@ -37,13 +37,36 @@ std::vector<CDeterministicMNCPtr> CLLMQUtils::GetAllQuorumMembers(Consensus::LLM
         }
     }
 
-    auto& params = Params().GetConsensus().llmqs.at(llmqType);
+    // At DKG interval boundaries, the members of all LLMQ types which start a DKG at this block are usually needed at
+    // about the same time. Calculate the missing ones together so that the list is only scored once
+    std::vector<Consensus::LLMQType> llmqTypes{llmqType};
+    for (const auto& p : Params().GetConsensus().llmqs) {
+        if (p.first == llmqType || pindexQuorum->nHeight % p.second.dkgInterval != 0) {
+            continue;
+        }
+        if (!IsQuorumTypeEnabled(p.first, pindexQuorum->pprev)) {
+            continue;
+        }
+        LOCK(cs_members);
+        if (!mapQuorumMembers[p.first].exists(pindexQuorum->GetBlockHash())) {
+            llmqTypes.emplace_back(p.first);
+        }
+    }
+
+    std::vector<std::pair<size_t, uint256>> quorums;
+    quorums.reserve(llmqTypes.size());
+    for (const auto type : llmqTypes) {
+        auto modifier = ::SerializeHash(std::make_pair(type, pindexQuorum->GetBlockHash()));
+        quorums.emplace_back(Params().GetConsensus().llmqs.at(type).size, modifier);
+    }
+
     auto allMns = deterministicMNManager->GetListForBlock(pindexQuorum);
-    auto modifier = ::SerializeHash(std::make_pair(llmqType, pindexQuorum->GetBlockHash()));
-    quorumMembers = allMns.CalculateQuorum(params.size, modifier);
+    auto allQuorumMembers = allMns.CalculateQuorums(quorums);
     LOCK(cs_members);
-    mapQuorumMembers[llmqType].insert(pindexQuorum->GetBlockHash(), quorumMembers);
-    return quorumMembers;
+    for (size_t i = 0; i < llmqTypes.size(); i++) {
+        mapQuorumMembers[llmqTypes[i]].insert(pindexQuorum->GetBlockHash(), allQuorumMembers[i]);
+    }
+    return allQuorumMembers[0];
 }
 
 uint256 CLLMQUtils::BuildCommitmentHash(Consensus::LLMQType llmqType, const uint256& blockHash, const std::vector<bool>& validMembers, const CBLSPublicKey& pubKey, const uint256& vvecHash)
@@ -342,6 +365,17 @@ bool CLLMQUtils::QuorumDataRecoveryEnabled()
     return gArgs.GetBoolArg("-llmq-data-recovery", DEFAULT_ENABLE_QUORUM_DATA_RECOVERY);
 }
 
+size_t CLLMQUtils::GetDKGBLSCacheSize()
+{
+    int64_t nSize = std::max<int64_t>(1, gArgs.GetArg("-llmq-dkg-bls-cache", DEFAULT_DKG_BLS_CACHE_SIZE));
+    return (size_t)nSize << 20;
+}
+
+bool CLLMQUtils::IsLazyPubKeySharesEnabled()
+{
+    return gArgs.GetBoolArg("-llmq-lazy-pubkeyshares", !fMasternodeMode);
+}
+
 bool CLLMQUtils::IsWatchQuorumsEnabled()
 {
     static bool fIsWatchQuroumsEnabled = gArgs.GetBoolArg("-watchquorums", DEFAULT_WATCH_QUORUMS);
@@ -23,6 +23,8 @@ extern CCriticalSection cs_llmq_vbc;
 extern VersionBitsCache llmq_versionbitscache;
 
 static const bool DEFAULT_ENABLE_QUORUM_DATA_RECOVERY = true;
+// Maximum memory used by the BLS cache of each DKG session, in MiB
+static const int DEFAULT_DKG_BLS_CACHE_SIZE = 32;
 
 enum class QvvecSyncMode {
     Invalid = -1,
@@ -63,6 +65,12 @@ public:
     /// Returns the state of `-llmq-data-recovery`
     static bool QuorumDataRecoveryEnabled();
 
+    /// Returns `-llmq-dkg-bls-cache` in bytes
+    static size_t GetDKGBLSCacheSize();
+
+    /// Returns the state of `-llmq-lazy-pubkeyshares`, which defaults to lazy mode for non-masternodes
+    static bool IsLazyPubKeySharesEnabled();
+
     /// Returns the state of `-watchquorums`
     static bool IsWatchQuorumsEnabled();
 
@@ -7,8 +7,10 @@
 #include <util.h>
 #include <utilstrencodings.h>
 
+#include <condition_variable>
 #include <list>
 #include <mutex>
+#include <thread>
 
 const char * const DEFAULT_DEBUGLOGFILE = "debug.log";
 
@@ -23,6 +25,8 @@ std::atomic<bool> fReopenDebugLog(false);
 
 /** Log categories bitfield. */
 std::atomic<uint64_t> logCategories(0);
+
+std::atomic<unsigned int> nLogRateLimit(DEFAULT_LOGRATELIMIT);
 /**
  * LogPrintf() has been broken a couple of times now
  * by well-meaning people adding mutexes in the most straightforward way.
@@ -229,7 +233,7 @@ std::string ListActiveLogCategoriesString()
  * suppress printing of the timestamp when multiple calls are made that don't
  * end in a newline. Initialize it to true, and hold it, in the calling context.
  */
-static std::string LogTimestampStr(const std::string &str, std::atomic_bool *fStartedNewLine)
+static std::string LogTimestampStr(const std::string &str, std::atomic_bool *fStartedNewLine, int64_t nTimeMicros)
 {
     std::string strStamped;
 
@@ -237,7 +241,6 @@ static std::string LogTimestampStr(const std::string &str, std::atomic_bool *fSt
         return str;
 
     if (*fStartedNewLine) {
-        int64_t nTimeMicros = GetTimeMicros();
         strStamped = FormatISO8601DateTime(nTimeMicros/1000000);
         if (fLogTimeMicros) {
             strStamped.pop_back();
@@ -259,15 +262,13 @@ static std::string LogTimestampStr(const std::string &str, std::atomic_bool *fSt
  * suppress printing of the thread name when multiple calls are made that don't
  * end in a newline. Initialize it to true, and hold/manage it, in the calling context.
  */
-static std::string LogThreadNameStr(const std::string &str, std::atomic_bool *fStartedNewLine)
+static std::string LogThreadNameStr(const std::string &str, std::atomic_bool *fStartedNewLine, const std::string& strThreadName)
 {
     std::string strThreadLogged;
 
     if (!fLogThreadNames)
         return str;
 
-    std::string strThreadName = GetThreadName();
-
     if (*fStartedNewLine)
         strThreadLogged = strprintf("%16s | %s", strThreadName.c_str(), str.c_str());
     else
@@ -276,19 +277,236 @@ static std::string LogThreadNameStr(const std::string &str, std::atomic_bool *fS
     return strThreadLogged;
 }
 
-int LogPrintStr(const std::string &str)
-{
-    int ret = 0; // Returns total number of characters written
-    static std::atomic_bool fStartedNewLine(true);
+/** Shared by the calling threads, or owned by the writer thread while logging asynchronously */
+static std::atomic_bool fStartedNewLine(true);
 
-    std::string strThreadLogged = LogThreadNameStr(str, &fStartedNewLine);
-    std::string strTimestamped = LogTimestampStr(strThreadLogged, &fStartedNewLine);
+/** Add the timestamp and thread name to str as configured */
+static std::string LogPrefixStr(const std::string &str, int64_t nTimeMicros, const std::string& strThreadName)
+{
+    std::string strThreadLogged = LogThreadNameStr(str, &fStartedNewLine, strThreadName);
+    std::string strTimestamped = LogTimestampStr(strThreadLogged, &fStartedNewLine, nTimeMicros);
 
     if (!str.empty() && str[str.size()-1] == '\n')
         fStartedNewLine = true;
     else
         fStartedNewLine = false;
 
+    return strTimestamped;
+}
+
+/** Reopen the log file if requested. Must hold mutexDebugLog. */
+static void MaybeReopenDebugLog(bool fBuffered)
+{
+    if (fReopenDebugLog) {
+        fReopenDebugLog = false;
+        fs::path pathDebug = GetDebugLogPath();
+        if (fsbridge::freopen(pathDebug,"a",fileout) != nullptr) {
+            if (fBuffered)
+                setvbuf(fileout, nullptr, _IOFBF, 1 << 16);
+            else
+                setbuf(fileout, nullptr); // unbuffered
+        }
+    }
+}
+
+//
+// Asynchronous logging.
+// A bounded multi-producer ring buffer: producers claim a slot by advancing
+// nEnqueuePos with a CAS and publish it through the slot's sequence number,
+// the single writer thread consumes slots in order. Neither side takes a lock;
+// the writer only sleeps on a condition variable while the ring is empty.
+//
+
+static const size_t LOG_RING_SIZE = 8192;
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE must be a power of two");
+
+struct LogRingEntry
+{
+    std::atomic<uint64_t> nSeq;
+    std::string str;
+    int64_t nTimeMicros;
+    std::string strThreadName;
+};
+
+struct LogRing
+{
+    LogRingEntry entries[LOG_RING_SIZE];
+    std::atomic<uint64_t> nEnqueuePos{0};
+    uint64_t nDequeuePos{0};
+    std::atomic<uint64_t> nDropped{0};
+
+    std::atomic<bool> fStop{false};
+    std::atomic<bool> fWriterSleeping{false};
+    std::mutex mutexWriter;
+    std::condition_variable condWriter;
+    std::thread writer;
+
+    LogRing()
+    {
+        for (size_t i = 0; i < LOG_RING_SIZE; i++) entries[i].nSeq = i;
+    }
+
+    bool Push(const std::string& str, int64_t nTimeMicros, std::string&& strThreadName)
+    {
+        uint64_t nPos = nEnqueuePos.load(std::memory_order_relaxed);
+        LogRingEntry* entry;
+        while (true) {
+            entry = &entries[nPos & (LOG_RING_SIZE - 1)];
+            const int64_t nDiff = (int64_t)entry->nSeq.load(std::memory_order_acquire) - (int64_t)nPos;
+            if (nDiff == 0) {
+                if (nEnqueuePos.compare_exchange_weak(nPos, nPos + 1, std::memory_order_relaxed)) break;
+            } else if (nDiff < 0) {
+                // The writer hasn't caught up, drop the message rather than block the caller
+                nDropped++;
+                return false;
+            } else {
+                nPos = nEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        entry->str = str;
+        entry->nTimeMicros = nTimeMicros;
+        entry->strThreadName = std::move(strThreadName);
+        entry->nSeq.store(nPos + 1, std::memory_order_release);
+        if (fWriterSleeping.load()) condWriter.notify_one();
+        return true;
+    }
+
+    /** Only called by the writer */
+    bool Pop(std::string& strOut)
+    {
+        LogRingEntry& entry = entries[nDequeuePos & (LOG_RING_SIZE - 1)];
+        if (entry.nSeq.load(std::memory_order_acquire) != nDequeuePos + 1) return false;
+        strOut = LogPrefixStr(entry.str, entry.nTimeMicros, entry.strThreadName);
+        entry.str.clear();
+        entry.strThreadName.clear();
+        entry.nSeq.store(nDequeuePos + LOG_RING_SIZE, std::memory_order_release);
+        nDequeuePos++;
+        return true;
+    }
+
+    /** Write out everything that is queued, returns false if there was nothing */
+    bool Drain()
+    {
+        std::string str;
+        if (!Pop(str)) return false;
+        std::lock_guard<std::mutex> scoped_lock(*mutexDebugLog);
+        MaybeReopenDebugLog(true);
+        do {
+            FileWriteStr(str, fileout);
+        } while (Pop(str));
+        const uint64_t nDroppedNow = nDropped.exchange(0);
+        if (nDroppedNow) {
+            FileWriteStr(LogPrefixStr(strprintf("%d log messages dropped, the log writer could not keep up\n", nDroppedNow), GetTimeMicros(), "logger"), fileout);
+        }
+        fflush(fileout);
+        return true;
+    }
+
+    void Thread()
+    {
+        RenameThread("dash-logger");
+        while (!fStop) {
+            if (Drain()) continue;
+            std::unique_lock<std::mutex> lock(mutexWriter);
+            fWriterSleeping = true;
+            // A producer's notify can slip in between Drain and the wait, so don't sleep for too long
+            condWriter.wait_for(lock, std::chrono::milliseconds(100));
+            fWriterSleeping = false;
+        }
+        while (Drain()) {}
+    }
+};
+
+/** Set while messages go through the ring. Never freed, see the note about fileout. */
+static std::atomic<LogRing*> logRing{nullptr};
+static LogRing* logRingStopped = nullptr;
+
+void StartAsyncLogging()
+{
+    std::call_once(debugPrintInitFlag, &DebugPrintInit);
+    if (!fPrintToDebugLog || fPrintToConsole || logRing) return;
+    {
+        std::lock_guard<std::mutex> scoped_lock(*mutexDebugLog);
+        if (fileout == nullptr) return;
+        setvbuf(fileout, nullptr, _IOFBF, 1 << 16);
+    }
+    LogRing* ring = logRingStopped ? logRingStopped : new LogRing();
+    logRingStopped = nullptr;
+    ring->fStop = false;
+    ring->writer = std::thread(&LogRing::Thread, ring);
+    logRing = ring;
+}
+
+void StopAsyncLogging()
+{
+    LogRing* ring = logRing.exchange(nullptr);
+    if (!ring) return;
+    {
+        std::lock_guard<std::mutex> lock(ring->mutexWriter);
+        ring->fStop = true;
+    }
+    ring->condWriter.notify_one();
+    ring->writer.join();
+    // Callers that picked up the ring just before it was cleared may still have pushed
+    while (ring->Drain()) {}
+    std::lock_guard<std::mutex> scoped_lock(*mutexDebugLog);
+    fflush(fileout);
+    setbuf(fileout, nullptr); // unbuffered
+    logRingStopped = ring;
+}
+
+static std::string LogCategoryToStr(uint64_t category)
+{
+    for (unsigned int i = 0; i < ARRAYLEN(LogCategories); i++) {
+        if (LogCategories[i].flag == category) return LogCategories[i].category;
+    }
+    return strprintf("%#x", category);
+}
+
+/** Fixed one second windows per category bit */
+struct LogRateBucket
+{
+    std::atomic<int64_t> nWindow{0};
+    std::atomic<unsigned int> nCount{0};
+    std::atomic<uint64_t> nSuppressed{0};
+};
+
+static LogRateBucket logRateBuckets[64];
+
+bool LogRateLimitAcceptInternal(uint64_t category)
+{
+    // Messages logged in several categories count against the lowest one
+    int nBit = 0;
+    while (nBit < 63 && !(category & ((uint64_t)1 << nBit))) nBit++;
+    LogRateBucket& bucket = logRateBuckets[nBit];
+
+    const int64_t nNow = GetTimeMicros() / 1000000;
+    if (bucket.nWindow.load(std::memory_order_relaxed) != nNow && bucket.nWindow.exchange(nNow) != nNow) {
+        bucket.nCount = 0;
+        const uint64_t nSuppressed = bucket.nSuppressed.exchange(0);
+        if (nSuppressed) {
+            LogPrintf("%s: suppressed %d messages of category %s (-lograte=%u)\n", __func__, nSuppressed, LogCategoryToStr((uint64_t)1 << nBit), nLogRateLimit);
+        }
+    }
+    if (++bucket.nCount <= nLogRateLimit.load(std::memory_order_relaxed)) return true;
+    bucket.nSuppressed++;
+    return false;
+}
+
+int LogPrintStr(const std::string &str)
+{
+    int ret = 0; // Returns total number of characters written
+
+    if (!fPrintToConsole && fPrintToDebugLog) {
+        LogRing* ring = logRing.load();
+        if (ring) {
+            ring->Push(str, GetTimeMicros(), fLogThreadNames ? GetThreadName() : std::string());
+            return str.size();
+        }
+    }
+
+    std::string strTimestamped = LogPrefixStr(str, GetTimeMicros(), fLogThreadNames ? GetThreadName() : std::string());
+
     if (fPrintToConsole)
     {
         // print to console
@@ -309,12 +527,7 @@ int LogPrintStr(const std::string &str)
         else
         {
             // reopen the log file, if requested
-            if (fReopenDebugLog) {
-                fReopenDebugLog = false;
-                fs::path pathDebug = GetDebugLogPath();
-                if (fsbridge::freopen(pathDebug,"a",fileout) != nullptr)
-                    setbuf(fileout, nullptr); // unbuffered
-            }
+            MaybeReopenDebugLog(false);
 
             ret = FileWriteStr(strTimestamped, fileout);
         }
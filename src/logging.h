@@ -18,6 +18,8 @@ static const bool DEFAULT_LOGTIMEMICROS  = false;
 static const bool DEFAULT_LOGIPS         = false;
 static const bool DEFAULT_LOGTIMESTAMPS  = true;
 static const bool DEFAULT_LOGTHREADNAMES = false;
+static const bool DEFAULT_LOGASYNC       = false;
+static const unsigned int DEFAULT_LOGRATELIMIT = 0;
 extern const char * const DEFAULT_DEBUGLOGFILE;
 
 extern bool fPrintToConsole;
@@ -31,6 +33,9 @@ extern std::atomic<bool> fReopenDebugLog;
 
 extern std::atomic<uint64_t> logCategories;
 
+/** Messages per second and category that LogPrint lets through (-lograte), 0 for no limit */
+extern std::atomic<unsigned int> nLogRateLimit;
+
 struct CLogCategoryActive
 {
     std::string category;
@@ -88,6 +93,14 @@ static inline bool LogAcceptCategory(uint64_t category)
     return (logCategories.load(std::memory_order_relaxed) & category) != 0;
 }
 
+bool LogRateLimitAcceptInternal(uint64_t category);
+
+/** Return true if the rate limit of the category (see -lograte) lets another message through */
+static inline bool LogRateLimitAccept(uint64_t category)
+{
+    return nLogRateLimit.load(std::memory_order_relaxed) == 0 || LogRateLimitAcceptInternal(category);
+}
+
 /** Returns a string with the log categories. */
 std::string ListLogCategories();
 
@@ -148,7 +161,7 @@ template<typename T, typename... Args> static inline void MarkUsed(const T& t, c
 } while(0)
 
 #define LogPrint(category, ...) do { \
-    if (LogAcceptCategory((category))) { \
+    if (LogAcceptCategory((category)) && LogRateLimitAccept((category))) { \
         LogPrintf(__VA_ARGS__); \
     } \
 } while(0)
@@ -158,4 +171,14 @@ fs::path GetDebugLogPath();
 bool OpenDebugLog();
 void ShrinkDebugFile();
 
+/**
+ * Hand debug.log writes to a background thread (-logasync). LogPrintStr then
+ * only pushes the message into a lock-free ring buffer; the timestamp and
+ * thread name prefix are formatted and the file is written and flushed by the
+ * writer thread. Messages are dropped (and counted) when the ring is full.
+ */
+void StartAsyncLogging();
+/** Write out all queued messages and go back to writing on the calling thread */
+void StopAsyncLogging();
+
 #endif // BITCOIN_LOGGING_H
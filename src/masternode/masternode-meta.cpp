@@ -6,9 +6,11 @@
 
 #include <timedata.h>
 
+#include <algorithm>
+
 CMasternodeMetaMan mmetaman;
 
-const std::string CMasternodeMetaMan::SERIALIZATION_VERSION_STRING = "CMasternodeMetaMan-Version-2";
+const std::string CMasternodeMetaMan::SERIALIZATION_VERSION_STRING = "CMasternodeMetaMan-Version-3";
 
 UniValue CMasternodeMetaInfo::ToJson() const
 {
@@ -22,6 +24,7 @@ UniValue CMasternodeMetaInfo::ToJson() const
     ret.pushKV("lastOutboundAttemptElapsed", now - lastOutboundAttempt);
     ret.pushKV("lastOutboundSuccess", lastOutboundSuccess);
     ret.pushKV("lastOutboundSuccessElapsed", now - lastOutboundSuccess);
+    ret.pushKV("outboundFailures", nOutboundFailures);
 
     return ret;
 }
@@ -29,17 +32,20 @@ UniValue CMasternodeMetaInfo::ToJson() const
 void CMasternodeMetaInfo::AddGovernanceVote(const uint256& nGovernanceObjectHash)
 {
     LOCK(cs);
-    // Insert a zero value, or not. Then increment the value regardless. This
-    // ensures the value is in the map.
-    const auto& pair = mapGovernanceObjectsVotedOn.emplace(nGovernanceObjectHash, 0);
-    pair.first->second++;
+    auto it = std::lower_bound(vecGovernanceObjectsVotedOn.begin(), vecGovernanceObjectsVotedOn.end(), nGovernanceObjectHash);
+    if (it == vecGovernanceObjectsVotedOn.end() || *it != nGovernanceObjectHash) {
+        vecGovernanceObjectsVotedOn.insert(it, nGovernanceObjectHash);
+    }
 }
 
 void CMasternodeMetaInfo::RemoveGovernanceObject(const uint256& nGovernanceObjectHash)
 {
     LOCK(cs);
-    // Whether or not the govobj hash exists in the map first is irrelevant.
-    mapGovernanceObjectsVotedOn.erase(nGovernanceObjectHash);
+    // Whether or not the govobj hash exists in the vector first is irrelevant.
+    auto it = std::lower_bound(vecGovernanceObjectsVotedOn.begin(), vecGovernanceObjectsVotedOn.end(), nGovernanceObjectHash);
+    if (it != vecGovernanceObjectsVotedOn.end() && *it == nGovernanceObjectHash) {
+        vecGovernanceObjectsVotedOn.erase(it);
+    }
 }
 
 CMasternodeMetaInfoPtr CMasternodeMetaMan::GetMetaInfo(const uint256& proTxHash, bool fCreate)
@@ -106,6 +112,12 @@ void CMasternodeMetaMan::RemoveGovernanceObject(const uint256& nGovernanceObject
     }
 }
 
+void CMasternodeMetaMan::AddDirtyGovernanceObjectHash(const uint256& nHash)
+{
+    LOCK(cs);
+    vecDirtyGovernanceObjectHashes.push_back(nHash);
+}
+
 std::vector<uint256> CMasternodeMetaMan::GetAndClearDirtyGovernanceObjectHashes()
 {
     LOCK(cs);
@@ -123,7 +135,23 @@ void CMasternodeMetaMan::Clear()
 
 void CMasternodeMetaMan::CheckAndRemove()
 {
+    if (!deterministicMNManager) return;
+
+    auto mnList = deterministicMNManager->GetListAtChainTip();
 
+    LOCK(cs);
+    // Meta infos of masternodes which are not registered anymore are of no use, don't keep them in memory and in
+    // mncache.dat forever
+    size_t nRemoved = 0;
+    for (auto it = metaInfos.begin(); it != metaInfos.end(); ) {
+        if (mnList.GetMN(it->first) == nullptr) {
+            it = metaInfos.erase(it);
+            nRemoved++;
+        } else {
+            ++it;
+        }
+    }
+    LogPrintf("CMasternodeMetaMan::%s -- removed %d meta infos, %s\n", __func__, nRemoved, ToString());
 }
 
 std::string CMasternodeMetaMan::ToString() const
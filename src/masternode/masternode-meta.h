@@ -33,10 +33,13 @@ private:
     int nMixingTxCount = 0;
 
     // KEEP TRACK OF GOVERNANCE ITEMS EACH MASTERNODE HAS VOTE UPON FOR RECALCULATION
-    std::map<uint256, int> mapGovernanceObjectsVotedOn;
+    // Sorted, a masternode only votes on a handful of objects so this is much smaller than a map
+    std::vector<uint256> vecGovernanceObjectsVotedOn;
 
     int64_t lastOutboundAttempt = 0;
     int64_t lastOutboundSuccess = 0;
+    // failed outbound connection attempts since the last success, not persisted
+    int nOutboundFailures = 0;
 
 public:
     CMasternodeMetaInfo() = default;
@@ -45,9 +48,10 @@ public:
         proTxHash(ref.proTxHash),
         nLastDsq(ref.nLastDsq),
         nMixingTxCount(ref.nMixingTxCount),
-        mapGovernanceObjectsVotedOn(ref.mapGovernanceObjectsVotedOn),
+        vecGovernanceObjectsVotedOn(ref.vecGovernanceObjectsVotedOn),
         lastOutboundAttempt(ref.lastOutboundAttempt),
-        lastOutboundSuccess(ref.lastOutboundSuccess)
+        lastOutboundSuccess(ref.lastOutboundSuccess),
+        nOutboundFailures(ref.nOutboundFailures)
     {
     }
 
@@ -59,7 +63,7 @@ public:
         READWRITE(proTxHash);
         READWRITE(nLastDsq);
         READWRITE(nMixingTxCount);
-        READWRITE(mapGovernanceObjectsVotedOn);
+        READWRITE(vecGovernanceObjectsVotedOn);
         READWRITE(lastOutboundAttempt);
         READWRITE(lastOutboundSuccess);
     }
@@ -80,8 +84,10 @@ public:
 
     void SetLastOutboundAttempt(int64_t t) { LOCK(cs); lastOutboundAttempt = t; }
     int64_t GetLastOutboundAttempt() const { LOCK(cs); return lastOutboundAttempt; }
-    void SetLastOutboundSuccess(int64_t t) { LOCK(cs); lastOutboundSuccess = t; }
+    void SetLastOutboundSuccess(int64_t t) { LOCK(cs); lastOutboundSuccess = t; nOutboundFailures = 0; }
     int64_t GetLastOutboundSuccess() const { LOCK(cs); return lastOutboundSuccess; }
+    void SetOutboundFailed() { LOCK(cs); lastOutboundSuccess = 0; nOutboundFailures++; }
+    int GetOutboundFailures() const { LOCK(cs); return nOutboundFailures; }
 };
 typedef std::shared_ptr<CMasternodeMetaInfo> CMasternodeMetaInfoPtr;
 
@@ -148,6 +154,8 @@ public:
     bool AddGovernanceVote(const uint256& proTxHash, const uint256& nGovernanceObjectHash);
     void RemoveGovernanceObject(const uint256& nGovernanceObjectHash);
 
+    // Marks an object for CGovernanceManager::UpdateCachesAndClean to revalidate the votes of all masternodes
+    void AddDirtyGovernanceObjectHash(const uint256& nHash);
     std::vector<uint256> GetAndClearDirtyGovernanceObjectHashes();
 
     void Clear();
@@ -8,12 +8,29 @@
 #include <masternode/masternode-sync.h>
 #include <netfulfilledman.h>
 #include <netmessagemaker.h>
+#include <saltedhasher.h>
+#include <unordered_lru_cache.h>
 #include <validation.h>
 
 #include <string>
 
 CMasternodePayments mnpayments;
 
+namespace {
+/**
+ * Everything GetBlockTxOuts needs to know about the block before the one paying the masternode. It only depends on
+ * that block, so it's the same for ConnectBlock, TestBlockValidity and getblocktemplate of the next block.
+ */
+struct CBlockPayeeInfo {
+    int nReallocActivationHeight{std::numeric_limits<int>::max()};
+    CDeterministicMNCPtr dmnPayee;
+};
+
+CCriticalSection cs_blockPayeeCache;
+// prev block hash -> CBlockPayeeInfo
+unordered_lru_cache<uint256, CBlockPayeeInfo, StaticSaltedHasher, 64> blockPayeeCache GUARDED_BY(cs_blockPayeeCache);
+} // namespace
+
 bool IsOldBudgetBlockValueValid(const CBlock& block, int nBlockHeight, CAmount blockReward, std::string& strErrorRet) {
     const Consensus::Params& consensusParams = Params().GetConsensus();
     bool isBlockRewardValueMet = (block.vtx[0]->GetValueOut() <= blockReward);
@@ -263,22 +280,26 @@ bool CMasternodePayments::GetBlockTxOuts(int nBlockHeight, CAmount blockReward,
 {
     voutMasternodePaymentsRet.clear();
 
-    const CBlockIndex* pindex;
-    int nReallocActivationHeight{std::numeric_limits<int>::max()};
+    CBlockPayeeInfo payeeInfo;
 
     {
         LOCK(cs_main);
-        pindex = chainActive[nBlockHeight - 1];
+        const CBlockIndex* pindex = chainActive[nBlockHeight - 1];
 
-        const Consensus::Params& consensusParams = Params().GetConsensus();
-        if (VersionBitsState(pindex, consensusParams, Consensus::DEPLOYMENT_REALLOC, versionbitscache) == ThresholdState::ACTIVE) {
-            nReallocActivationHeight = VersionBitsStateSinceHeight(pindex, consensusParams, Consensus::DEPLOYMENT_REALLOC, versionbitscache);
+        LOCK(cs_blockPayeeCache);
+        if (!blockPayeeCache.get(pindex->GetBlockHash(), payeeInfo)) {
+            const Consensus::Params& consensusParams = Params().GetConsensus();
+            if (VersionBitsState(pindex, consensusParams, Consensus::DEPLOYMENT_REALLOC, versionbitscache) == ThresholdState::ACTIVE) {
+                payeeInfo.nReallocActivationHeight = VersionBitsStateSinceHeight(pindex, consensusParams, Consensus::DEPLOYMENT_REALLOC, versionbitscache);
+            }
+            payeeInfo.dmnPayee = deterministicMNManager->GetListForBlock(pindex).GetMNPayee();
+            blockPayeeCache.insert(pindex->GetBlockHash(), payeeInfo);
         }
     }
 
-    CAmount masternodeReward = GetMasternodePayment(nBlockHeight, blockReward, nReallocActivationHeight);
+    CAmount masternodeReward = GetMasternodePayment(nBlockHeight, blockReward, payeeInfo.nReallocActivationHeight);
 
-    auto dmnPayee = deterministicMNManager->GetListForBlock(pindex).GetMNPayee();
+    const auto& dmnPayee = payeeInfo.dmnPayee;
     if (!dmnPayee) {
         return false;
     }
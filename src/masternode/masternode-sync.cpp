@@ -11,6 +11,10 @@
 #include <ui_interface.h>
 #include <evo/deterministicmns.h>
 
+#include <univalue.h>
+
+#include <algorithm>
+
 class CMasternodeSync;
 CMasternodeSync masternodeSync;
 
@@ -24,6 +28,12 @@ void CMasternodeSync::Reset(bool fForce, bool fNotifyReset)
         nTimeLastBumped = GetTime();
         nTimeLastUpdateBlockTip = 0;
         fReachedBestHeader = false;
+        {
+            // the current asset is started again by the next ProcessTick, we might be called before anything
+            // GetAssetItemCount relies on is initialized
+            LOCK(cs_mapAssetInfo);
+            mapAssetInfo.clear();
+        }
         if (fNotifyReset) {
             uiInterface.NotifyAdditionalDataSyncProgressChanged(-1);
         }
@@ -37,9 +47,9 @@ void CMasternodeSync::BumpAssetLastTime(const std::string& strFuncName)
     LogPrint(BCLog::MNSYNC, "CMasternodeSync::BumpAssetLastTime -- %s\n", strFuncName);
 }
 
-std::string CMasternodeSync::GetAssetName() const
+std::string CMasternodeSync::GetAssetName(int nAsset)
 {
-    switch(nCurrentAsset)
+    switch(nAsset)
     {
         case(MASTERNODE_SYNC_BLOCKCHAIN):   return "MASTERNODE_SYNC_BLOCKCHAIN";
         case(MASTERNODE_SYNC_GOVERNANCE):   return "MASTERNODE_SYNC_GOVERNANCE";
@@ -48,8 +58,74 @@ std::string CMasternodeSync::GetAssetName() const
     }
 }
 
+int CMasternodeSync::GetAssetItemCount(int nAsset)
+{
+    switch (nAsset) {
+        case MASTERNODE_SYNC_BLOCKCHAIN: {
+            LOCK(cs_main);
+            return chainActive.Height();
+        }
+        case MASTERNODE_SYNC_GOVERNANCE:
+            return governance.GetObjectCount() + governance.GetVoteCount();
+        default:
+            return 0;
+    }
+}
+
+void CMasternodeSync::StartAsset(int nAsset)
+{
+    if (nAsset == MASTERNODE_SYNC_FINISHED) return;
+
+    CMasternodeSyncAssetInfo info;
+    info.nTimeStarted = GetTime();
+    info.nItemsAtStart = GetAssetItemCount(nAsset);
+
+    LOCK(cs_mapAssetInfo);
+    mapAssetInfo[nAsset] = info;
+}
+
+void CMasternodeSync::FinishAsset(int nAsset)
+{
+    int nItems = GetAssetItemCount(nAsset);
+
+    LOCK(cs_mapAssetInfo);
+    auto it = mapAssetInfo.find(nAsset);
+    if (it == mapAssetInfo.end()) return;
+    it->second.nTimeFinished = GetTime();
+    it->second.nTriedPeerCount = nTriedPeerCount;
+    it->second.nItemsAtFinish = nItems;
+}
+
+UniValue CMasternodeSync::GetAssetsJson() const
+{
+    UniValue arr(UniValue::VARR);
+
+    int64_t nNow = GetTime();
+
+    LOCK(cs_mapAssetInfo);
+    for (const auto& p : mapAssetInfo) {
+        const auto& info = p.second;
+        bool fFinished = info.nTimeFinished != 0;
+        int64_t nDuration = (fFinished ? info.nTimeFinished : nNow) - info.nTimeStarted;
+        int nItems = (fFinished ? info.nItemsAtFinish : GetAssetItemCount(p.first)) - info.nItemsAtStart;
+
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("AssetID", p.first);
+        obj.pushKV("AssetName", GetAssetName(p.first));
+        obj.pushKV("StartTime", info.nTimeStarted);
+        obj.pushKV("FinishTime", info.nTimeFinished);
+        obj.pushKV("Duration", nDuration);
+        obj.pushKV("Attempt", fFinished ? info.nTriedPeerCount : nTriedPeerCount);
+        obj.pushKV("Items", nItems);
+        obj.pushKV("ItemsPerSecond", nDuration > 0 ? double(nItems) / nDuration : 0.0);
+        arr.push_back(obj);
+    }
+    return arr;
+}
+
 void CMasternodeSync::SwitchToNextAsset(CConnman& connman)
 {
+    FinishAsset(nCurrentAsset);
     switch(nCurrentAsset)
     {
         case(MASTERNODE_SYNC_BLOCKCHAIN):
@@ -71,6 +147,7 @@ void CMasternodeSync::SwitchToNextAsset(CConnman& connman)
     }
     nTriedPeerCount = 0;
     nTimeAssetSyncStarted = GetTime();
+    StartAsset(nCurrentAsset);
     BumpAssetLastTime("CMasternodeSync::SwitchToNextAsset");
 }
 
@@ -123,6 +200,15 @@ void CMasternodeSync::ProcessTick(CConnman& connman)
 
     nTimeLastProcess = GetTime();
 
+    bool fAssetStarted;
+    {
+        LOCK(cs_mapAssetInfo);
+        fAssetStarted = mapAssetInfo.count(nCurrentAsset) != 0;
+    }
+    if (!fAssetStarted) {
+        StartAsset(nCurrentAsset);
+    }
+
     // gradually request the rest of the votes after sync finished
     if(IsSynced()) {
         std::vector<CNode*> vNodesCopy = connman.CopyNodeVector(CConnman::FullyConnectedOnly);
@@ -137,6 +223,11 @@ void CMasternodeSync::ProcessTick(CConnman& connman)
     uiInterface.NotifyAdditionalDataSyncProgressChanged(nSyncProgress);
 
     std::vector<CNode*> vNodesCopy = connman.CopyNodeVector(CConnman::FullyConnectedOnly);
+    // Ask outbound peers first, they are the ones we picked and usually the better connected ones
+    std::stable_partition(vNodesCopy.begin(), vNodesCopy.end(), [](const CNode* pnode) { return !pnode->fInbound; });
+
+    // Number of peers we sent a governance sync request to during this tick
+    int nGovernanceRequestsThisTick = 0;
 
     for (auto& pnode : vNodesCopy)
     {
@@ -271,15 +362,16 @@ void CMasternodeSync::ProcessTick(CConnman& connman)
                     }
                     continue;
                 }
+                // request objects from a few peers in parallel, the rest is asked on the next ticks
+                if (nGovernanceRequestsThisTick >= MASTERNODE_SYNC_GOVERNANCE_PEERS_PER_TICK) continue;
+
                 netfulfilledman.AddFulfilledRequest(pnode->addr, "governance-sync");
 
                 if (pnode->nVersion < MIN_GOVERNANCE_PEER_PROTO_VERSION) continue;
                 nTriedPeerCount++;
+                nGovernanceRequestsThisTick++;
 
                 SendGovernanceSyncRequest(pnode, connman);
-
-                connman.ReleaseNodeVector(vNodesCopy);
-                return; //this will cause each peer to get one request each six seconds for the various assets we need
             }
         }
     }
@@ -8,6 +8,7 @@
 #include <net.h>
 
 class CMasternodeSync;
+class UniValue;
 
 static const int MASTERNODE_SYNC_BLOCKCHAIN      = 1;
 static const int MASTERNODE_SYNC_GOVERNANCE      = 4;
@@ -18,9 +19,20 @@ static const int MASTERNODE_SYNC_FINISHED        = 999;
 static const int MASTERNODE_SYNC_TICK_SECONDS    = 6;
 static const int MASTERNODE_SYNC_TIMEOUT_SECONDS = 30; // our blocks are 2.5 minutes so 30 seconds should be fine
 static const int MASTERNODE_SYNC_RESET_SECONDS = 600; // Reset fReachedBestHeader in CMasternodeSync::Reset if UpdateBlockTip hasn't been called for this seconds
+static const int MASTERNODE_SYNC_GOVERNANCE_PEERS_PER_TICK = 3; // How many new peers we ask for governance objects per tick
 
 extern CMasternodeSync masternodeSync;
 
+// Progress of a single asset, for "mnsync status"
+struct CMasternodeSyncAssetInfo
+{
+    int64_t nTimeStarted{0};
+    int64_t nTimeFinished{0}; // 0 while the asset is still syncing
+    int nTriedPeerCount{0};
+    int nItemsAtStart{0};     // blocks or governance objects + votes we had when the asset started
+    int nItemsAtFinish{0};
+};
+
 //
 // CMasternodeSync : Sync masternode assets in stages
 //
@@ -43,6 +55,16 @@ private:
     /// Last time UpdateBlockTip has been called
     int64_t nTimeLastUpdateBlockTip{0};
 
+    mutable CCriticalSection cs_mapAssetInfo;
+    /// Progress of all assets since the last reset, by asset id
+    std::map<int, CMasternodeSyncAssetInfo> mapAssetInfo GUARDED_BY(cs_mapAssetInfo);
+
+    /// Number of items of this asset we have, used to calculate the sync rate
+    static int GetAssetItemCount(int nAsset);
+    static std::string GetAssetName(int nAsset);
+    void StartAsset(int nAsset);
+    void FinishAsset(int nAsset);
+
 public:
     CMasternodeSync() { Reset(true, false); }
 
@@ -55,8 +77,10 @@ public:
     int GetAttempt() const { return nTriedPeerCount; }
     void BumpAssetLastTime(const std::string& strFuncName);
     int64_t GetAssetStartTime() const { return nTimeAssetSyncStarted; }
-    std::string GetAssetName() const;
+    std::string GetAssetName() const { return GetAssetName(nCurrentAsset); }
     std::string GetSyncStatus() const;
+    /// Progress and item rates of all assets since the last reset
+    UniValue GetAssetsJson() const;
 
     void Reset(bool fForce = false, bool fNotifyReset = true);
     void SwitchToNextAsset(CConnman& connman);
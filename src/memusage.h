@@ -6,6 +6,7 @@
 #define BITCOIN_MEMUSAGE_H
 
 #include <indirectmap.h>
+#include <support/allocators/pool.h>
 
 #include <stdlib.h>
 
@@ -165,6 +166,14 @@ static inline size_t DynamicUsage(const std::unordered_map<X, Y, Z>& m)
     return MallocUsage(sizeof(unordered_node<std::pair<const X, Y> >)) * m.size() + MallocUsage(sizeof(void*) * m.bucket_count());
 }
 
+template<typename X, typename Y, typename Z, typename E>
+static inline size_t DynamicUsage(const std::unordered_map<X, Y, Z, E, node_pool_allocator<std::pair<const X, Y> > >& m)
+{
+    // The chunks of the pool are only freed with the pool, so free nodes in them are counted as well. Chunks are
+    // large, the malloc overhead of all but one is ignored.
+    return MallocUsage(m.get_allocator().GetPool().ChunksBytes()) + MallocUsage(sizeof(void*) * m.bucket_count());
+}
+
 }
 
 #endif // BITCOIN_MEMUSAGE_H
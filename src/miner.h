@@ -23,6 +23,8 @@ class CScript;
 namespace Consensus { struct Params; };
 
 static const bool DEFAULT_PRINTPRIORITY = false;
+/** Default for -blocktemplateasynccheck */
+static const bool DEFAULT_BLOCK_TEMPLATE_ASYNC_CHECK = false;
 
 struct CBlockTemplate
 {
@@ -158,8 +160,8 @@ public:
     explicit BlockAssembler(const CChainParams& params);
     BlockAssembler(const CChainParams& params, const Options& options);
 
-    /** Construct a new block template with coinbase to scriptPubKeyIn */
-    std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn);
+    /** Construct a new block template with coinbase to scriptPubKeyIn, fTestBlockValidity=false leaves TestBlockValidity to the caller */
+    std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn, bool fTestBlockValidity = true);
 
 private:
     // utility functions
@@ -75,6 +75,11 @@
 #define MSG_DONTWAIT 0
 #endif
 
+/** Messages are appended to the last send buffer as long as it stays below this size */
+static const size_t SEND_BUFFER_COALESCE_SIZE = 16 * 1024;
+/** Maximum number of send buffers handed to a single sendmsg() call */
+static const size_t SEND_MAX_IOV = 64;
+
 // Fix for ancient MinGW versions, that don't have defined these in ws2tcpip.h.
 // Todo: Can be removed when our pull-tester is upgraded to a modern MinGW version.
 #ifdef WIN32
@@ -105,8 +110,33 @@ static const uint64_t SELECT_TIMEOUT_MILLISECONDS = 50;
 static const uint64_t SELECT_TIMEOUT_MILLISECONDS = 500;
 #endif
 
+// How long the socket handler keeps polling without timeout after the last socket event in low latency mode
+static const int64_t LOW_LATENCY_SPIN_MICROSECONDS = 1000;
+
 const static std::string NET_MESSAGE_COMMAND_OTHER = "*other*";
 
+// to prevent a memory DOS, only keep per command stats of valid commands
+static const std::string& GetMsgCmdStatsKey(const std::string& strCommand)
+{
+    static const std::set<std::string> setKnownCommands(getAllNetMessageTypes().begin(), getAllNetMessageTypes().end());
+    auto it = setKnownCommands.find(strCommand);
+    return it != setKnownCommands.end() ? *it : NET_MESSAGE_COMMAND_OTHER;
+}
+
+static void MergeMsgCmdTimes(mapMsgCmdTime& mapTo, const mapMsgCmdTime& mapFrom)
+{
+    for (const auto& p : mapFrom) {
+        mapTo[p.first].Merge(p.second);
+    }
+}
+
+void CNetMsgTimeStats::Merge(const CNetMsgTimeStats& other)
+{
+    MergeMsgCmdTimes(mapProcessTime, other.mapProcessTime);
+    MergeMsgCmdTimes(mapRecvQueueTime, other.mapRecvQueueTime);
+    MergeMsgCmdTimes(mapSendQueueTime, other.mapSendQueueTime);
+}
+
 constexpr const CConnman::CFullyConnectedOnly CConnman::FullyConnectedOnly;
 constexpr const CConnman::CAllNodes CConnman::AllNodes;
 
@@ -507,6 +537,7 @@ CNode* CConnman::ConnectNode(CAddress addrConnect, const char *pszDest, bool fCo
         CloseSocket(hSocket);
         return nullptr;
     }
+    SetConnectedSocketOptions(hSocket);
 
     // Add node
     NodeId id = GetNewNodeId();
@@ -526,17 +557,24 @@ void CConnman::DumpBanlist()
     if (!BannedSetIsDirty())
         return;
 
-    int64_t nStart = GetTimeMillis();
+    auto banmap = std::make_shared<banmap_t>();
+    GetBanned(*banmap);
+    // changes made while the copy is written mark the set dirty again
+    SetBannedSetDirty(false);
 
-    CBanDB bandb;
-    banmap_t banmap;
-    GetBanned(banmap);
-    if (bandb.Write(banmap)) {
-        SetBannedSetDirty(false);
-    }
+    RunOnDumpWorker([this, banmap]() {
+        int64_t nStart = GetTimeMillis();
 
-    LogPrint(BCLog::NET, "Flushed %d banned node ips/subnets to banlist.dat  %dms\n",
-        banmap.size(), GetTimeMillis() - nStart);
+        CBanDB bandb;
+        if (!bandb.Write(*banmap)) {
+            SetBannedSetDirty(true);
+        }
+
+        int64_t nTime = GetTimeMillis() - nStart;
+        LogPrint(BCLog::NET, "Flushed %d banned node ips/subnets to banlist.dat  %dms\n",
+            banmap->size(), nTime);
+        statsClient.timing("banlist.dump_ms", nTime, 1.0f);
+    });
 }
 
 void CNode::CloseSocketDisconnect(CConnman* connman)
@@ -795,6 +833,10 @@ void CNode::copyStats(CNodeStats &stats)
         X(mapRecvBytesPerMsgCmd);
         X(nRecvBytes);
     }
+    {
+        LOCK(cs_msgTimeStats);
+        X(msgTimeStats);
+    }
     X(fWhitelisted);
 
     // It is common for nodes with good ping times to suddenly become lagged,
@@ -845,7 +887,7 @@ bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& complete
         // absorb network data
         int handled;
         if (!msg.in_data) {
-            handled = msg.readHeader(pch, nBytes);
+            handled = msg.readHeader(pch, nBytes, fRecvCompactHeaders);
         } else {
             handled = msg.readData(pch, nBytes);
         }
@@ -862,17 +904,7 @@ bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& complete
         nBytes -= handled;
 
         if (msg.complete()) {
-
-            //store received bytes per message command
-            //to prevent a memory DOS, only allow valid commands
-            mapMsgCmdSize::iterator i = mapRecvBytesPerMsgCmd.find(msg.hdr.pchCommand);
-            if (i == mapRecvBytesPerMsgCmd.end())
-                i = mapRecvBytesPerMsgCmd.find(NET_MESSAGE_COMMAND_OTHER);
-            assert(i != mapRecvBytesPerMsgCmd.end());
-            i->second += msg.hdr.nMessageSize + CMessageHeader::HEADER_SIZE;
-            statsClient.count("bandwidth.message." + std::string(msg.hdr.pchCommand) + ".bytesReceived", msg.hdr.nMessageSize + CMessageHeader::HEADER_SIZE, 1.0f);
-
-            msg.nTime = nTimeMicros;
+            MessageReceived(msg, nTimeMicros);
             complete = true;
         }
     }
@@ -880,6 +912,58 @@ bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& complete
     return true;
 }
 
+void CNode::AddMsgProcessTime(const std::string& strCommand, int64_t nRecvQueueTime, int64_t nProcessTime)
+{
+    const std::string& strKey = GetMsgCmdStatsKey(strCommand);
+    LOCK(cs_msgTimeStats);
+    msgTimeStats.mapRecvQueueTime[strKey].Add(nRecvQueueTime);
+    msgTimeStats.mapProcessTime[strKey].Add(nProcessTime);
+}
+
+void CNode::MessageReceived(CNetMessage& msg, int64_t nTimeMicros)
+{
+    //store received bytes per message command
+    //to prevent a memory DOS, only allow valid commands
+    mapMsgCmdSize::iterator i = mapRecvBytesPerMsgCmd.find(msg.hdr.pchCommand);
+    if (i == mapRecvBytesPerMsgCmd.end())
+        i = mapRecvBytesPerMsgCmd.find(NET_MESSAGE_COMMAND_OTHER);
+    assert(i != mapRecvBytesPerMsgCmd.end());
+    i->second += msg.hdr.nMessageSize + msg.GetHeaderSize();
+    statsClient.count("bandwidth.message." + std::string(msg.hdr.pchCommand) + ".bytesReceived", msg.hdr.nMessageSize + msg.GetHeaderSize(), 1.0f);
+
+    msg.nTime = nTimeMicros;
+}
+
+char* CNode::GetDirectRecvBuffer(unsigned int nMinSize, unsigned int& nSizeRet)
+{
+    AssertLockHeld(cs_vRecv);
+    if (vRecvMsg.empty() || !vRecvMsg.back().in_data || vRecvMsg.back().complete()) {
+        return nullptr;
+    }
+    CNetMessage& msg = vRecvMsg.back();
+    nSizeRet = msg.hdr.nMessageSize - msg.nDataPos;
+    if (nSizeRet < nMinSize) {
+        return nullptr;
+    }
+    return msg.getDataBuffer(nSizeRet);
+}
+
+void CNode::DirectRecvBufferWritten(unsigned int nBytes, bool& complete)
+{
+    AssertLockHeld(cs_vRecv);
+    complete = false;
+    int64_t nTimeMicros = GetTimeMicros();
+    nLastRecv = nTimeMicros / 1000000;
+    nRecvBytes += nBytes;
+
+    CNetMessage& msg = vRecvMsg.back();
+    msg.dataWritten(nBytes);
+    if (msg.complete()) {
+        MessageReceived(msg, nTimeMicros);
+        complete = true;
+    }
+}
+
 void CNode::SetSendVersion(int nVersionIn)
 {
     // Send version may only be changed in the version message, and
@@ -907,22 +991,38 @@ int CNode::GetSendVersion() const
 }
 
 
-int CNetMessage::readHeader(const char *pch, unsigned int nBytes)
+int CNetMessage::readHeader(const char *pch, unsigned int nBytes, bool fAllowCompact)
 {
+    // A compact header starts with a known short message type id, a regular one with the message start. Both can't
+    // be confused as short ids are never larger than MAX_SHORT_NET_MSG_TYPE_ID and the first byte of the message
+    // start is larger on all networks. Anything else is treated as a regular header and rejected later.
+    if (nHdrPos == 0 && nBytes > 0 && fAllowCompact) {
+        fCompactHeader = GetNetMsgTypeFromShortId((uint8_t)pch[0]) != nullptr;
+    }
+    unsigned int nHeaderSize = GetHeaderSize();
+
     // copy data to temporary parsing buffer
-    unsigned int nRemaining = 24 - nHdrPos;
+    unsigned int nRemaining = nHeaderSize - nHdrPos;
     unsigned int nCopy = std::min(nRemaining, nBytes);
 
     memcpy(&hdrbuf[nHdrPos], pch, nCopy);
     nHdrPos += nCopy;
 
     // if header incomplete, exit
-    if (nHdrPos < 24)
+    if (nHdrPos < nHeaderSize)
         return nCopy;
 
     // deserialize to CMessageHeader
     try {
-        hdrbuf >> hdr;
+        if (fCompactHeader) {
+            uint8_t nShortId;
+            hdrbuf >> nShortId;
+            hdrbuf >> hdr.nMessageSize;
+            // hdr already carries our message start
+            strncpy(hdr.pchCommand, GetNetMsgTypeFromShortId(nShortId), CMessageHeader::COMMAND_SIZE);
+        } else {
+            hdrbuf >> hdr;
+        }
     }
     catch (const std::exception&) {
         return -1;
@@ -939,20 +1039,37 @@ int CNetMessage::readHeader(const char *pch, unsigned int nBytes)
 }
 
 int CNetMessage::readData(const char *pch, unsigned int nBytes)
+{
+    unsigned int nCopy = nBytes;
+    memcpy(getDataBuffer(nCopy), pch, nCopy);
+    dataWritten(nCopy);
+
+    return nCopy;
+}
+
+char* CNetMessage::getDataBuffer(unsigned int& nBytes)
 {
     unsigned int nRemaining = hdr.nMessageSize - nDataPos;
-    unsigned int nCopy = std::min(nRemaining, nBytes);
+    nBytes = std::min(nRemaining, nBytes);
 
-    if (vRecv.size() < nDataPos + nCopy) {
-        // Allocate up to 256 KiB ahead, but never more than the total message size.
-        vRecv.resize(std::min(hdr.nMessageSize, nDataPos + nCopy + 256 * 1024));
+    if (vRecv.size() < nDataPos + nBytes) {
+        // Grow geometrically so that large messages are not copied over and over again while they are received, but
+        // never allocate more than 256 KiB or what was already received ahead and never more than the total message
+        // size. A peer announcing a large message without sending it can't make us allocate much memory this way.
+        size_t nNewSize = std::max<size_t>(vRecv.size() * 2, nDataPos + 256 * 1024);
+        vRecv.resize(std::min<size_t>(hdr.nMessageSize, nNewSize));
     }
+    nBytes = std::min<size_t>(nBytes, vRecv.size() - nDataPos);
 
-    hasher.Write((const unsigned char*)pch, nCopy);
-    memcpy(&vRecv[nDataPos], pch, nCopy);
-    nDataPos += nCopy;
+    return &vRecv[nDataPos];
+}
 
-    return nCopy;
+void CNetMessage::dataWritten(unsigned int nBytes)
+{
+    // compact headers carry no checksum
+    if (!fCompactHeader)
+        hasher.Write((const unsigned char*)&vRecv[nDataPos], nBytes);
+    nDataPos += nBytes;
 }
 
 const uint256& CNetMessage::GetMessageHash() const
@@ -969,27 +1086,53 @@ size_t CConnman::SocketSendData(CNode *pnode) EXCLUSIVE_LOCKS_REQUIRED(pnode->cs
     size_t nSentSize = 0;
 
     while (it != pnode->vSendMsg.end()) {
-        const auto &data = *it;
-        assert(data.size() > pnode->nSendOffset);
+        assert(it->size() > pnode->nSendOffset);
+        size_t nToSend = 0;
         int nBytes = 0;
         {
             LOCK(pnode->cs_hSocket);
             if (pnode->hSocket == INVALID_SOCKET)
                 break;
-            nBytes = send(pnode->hSocket, reinterpret_cast<const char*>(data.data()) + pnode->nSendOffset, data.size() - pnode->nSendOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
+#ifndef WIN32
+            // hand as many buffers as possible to the kernel with a single syscall
+            struct iovec iov[SEND_MAX_IOV];
+            size_t nIov = 0;
+            size_t nOffset = pnode->nSendOffset;
+            for (auto jt = it; jt != pnode->vSendMsg.end() && nIov < SEND_MAX_IOV; ++jt, ++nIov) {
+                iov[nIov].iov_base = jt->data() + nOffset;
+                iov[nIov].iov_len = jt->size() - nOffset;
+                nToSend += iov[nIov].iov_len;
+                nOffset = 0;
+            }
+            struct msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = nIov;
+            nBytes = sendmsg(pnode->hSocket, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+#else
+            nToSend = it->size() - pnode->nSendOffset;
+            nBytes = send(pnode->hSocket, reinterpret_cast<const char*>(it->data()) + pnode->nSendOffset, nToSend, MSG_NOSIGNAL | MSG_DONTWAIT);
+#endif
         }
         if (nBytes > 0) {
             pnode->nLastSend = GetSystemTimeInSeconds();
             pnode->nSendBytes += nBytes;
-            pnode->nSendOffset += nBytes;
             nSentSize += nBytes;
-            if (pnode->nSendOffset == data.size()) {
+            // consume all buffers which were sent completely, the last one might only be sent partially
+            size_t nRemaining = (size_t)nBytes;
+            while (nRemaining > 0) {
+                size_t nLeft = it->size() - pnode->nSendOffset;
+                if (nRemaining < nLeft) {
+                    pnode->nSendOffset += nRemaining;
+                    break;
+                }
+                nRemaining -= nLeft;
                 pnode->nSendOffset = 0;
-                pnode->nSendSize -= data.size();
-                pnode->fPauseSend = pnode->nSendSize > nSendBufferMaxSize;
+                pnode->nSendSize -= it->size();
                 it++;
-            } else {
-                // could not send full message; stop sending more
+            }
+            pnode->fPauseSend = pnode->nSendSize > nSendBufferMaxSize;
+            if ((size_t)nBytes < nToSend) {
+                // could not send everything; stop sending more
                 pnode->fCanSendData = false;
                 break;
             }
@@ -1009,6 +1152,16 @@ size_t CConnman::SocketSendData(CNode *pnode) EXCLUSIVE_LOCKS_REQUIRED(pnode->cs
         }
     }
 
+    if (nSentSize > 0) {
+        int64_t nTimeMicros = GetTimeMicros();
+        LOCK(pnode->cs_msgTimeStats);
+        while (!pnode->vSendMsgTimes.empty() && pnode->vSendMsgTimes.front().nEndOffset <= pnode->nSendBytes) {
+            const auto& queued = pnode->vSendMsgTimes.front();
+            pnode->msgTimeStats.mapSendQueueTime[queued.strCommand].Add(nTimeMicros - queued.nTimeQueued);
+            pnode->vSendMsgTimes.pop_front();
+        }
+    }
+
     if (it == pnode->vSendMsg.end()) {
         assert(pnode->nSendOffset == 0);
         assert(pnode->nSendSize == 0);
@@ -1234,6 +1387,7 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
     // According to the internet TCP_NODELAY is not carried into accepted sockets
     // on all platforms.  Set it again here just to be sure.
     SetSocketNoDelay(hSocket);
+    SetConnectedSocketOptions(hSocket);
 
     if (IsBanned(addr) && !whitelisted)
     {
@@ -1283,6 +1437,7 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
+        UpdateNodesSnapshot();
         mapSocketToNode.emplace(pnode->hSocket, pnode);
         RegisterEvents(pnode);
         WakeSelect();
@@ -1350,6 +1505,7 @@ void CConnman::DisconnectNodes()
 
                 // remove from vNodes
                 it = vNodes.erase(it);
+                UpdateNodesSnapshot();
 
                 // release outbound grant (if any)
                 pnode->grantOutbound.Release();
@@ -1467,6 +1623,18 @@ void CConnman::CalculateNumConnectionsChangedStats()
         statsClient.gauge("bandwidth.message." + msg + ".totalBytesReceived", mapRecvBytesMsgStats[msg], 1.0f);
         statsClient.gauge("bandwidth.message." + msg + ".totalBytesSent", mapSentBytesMsgStats[msg], 1.0f);
     }
+    const CNetMsgTimeStats msgTimeStats = GetMsgTimeStats();
+    for (const auto& p : msgTimeStats.mapProcessTime) {
+        statsClient.gauge("message.process." + p.first + ".count", p.second.nCount, 1.0f);
+        statsClient.gauge("message.process." + p.first + ".totalTime_us", p.second.nTotal, 1.0f);
+    }
+    for (const auto& p : msgTimeStats.mapRecvQueueTime) {
+        statsClient.gauge("message.recvQueue." + p.first + ".totalTime_us", p.second.nTotal, 1.0f);
+    }
+    for (const auto& p : msgTimeStats.mapSendQueueTime) {
+        statsClient.gauge("message.sendQueue." + p.first + ".count", p.second.nCount, 1.0f);
+        statsClient.gauge("message.sendQueue." + p.first + ".totalTime_us", p.second.nTotal, 1.0f);
+    }
     statsClient.gauge("peers.totalConnections", nPrevNodeCount, 1.0f);
     statsClient.gauge("peers.spvNodeConnections", spvNodes, 1.0f);
     statsClient.gauge("peers.fullNodeConnections", fullNodes, 1.0f);
@@ -1781,8 +1949,17 @@ void CConnman::SocketHandler()
         }
     }
 
+    // In low latency mode, keep polling for a short while after the last events instead of sleeping in the kernel.
+    // Messages often come in bursts (e.g. sig shares and the resulting ISLOCK) and waking up from the wait costs time.
+    if (fLowLatency && GetTimeMicros() - nLastSocketEventsTime < LOW_LATENCY_SPIN_MICROSECONDS) {
+        fOnlyPoll = true;
+    }
+
     std::set<SOCKET> recv_set, send_set, error_set;
     SocketEvents(recv_set, send_set, error_set, fOnlyPoll);
+    if (fLowLatency && (!recv_set.empty() || !send_set.empty() || !error_set.empty())) {
+        nLastSocketEventsTime = GetTimeMicros();
+    }
 
 #ifdef USE_WAKEUP_PIPE
     // drain the wakeup pipe
@@ -1892,6 +2069,65 @@ void CConnman::SocketHandler()
         }
     }
 
+    if (nSocketThreads == 0) {
+        SocketHandleNodes(vErrorNodes, vReceivableNodes, vSendableNodes);
+    } else {
+        // Spread the work over the socket worker threads. A node is always handled by the same worker, so its
+        // receives and sends are never processed concurrently and keep their order
+        std::vector<std::vector<CNode*>> vWorkerErrorNodes(nSocketThreads);
+        std::vector<std::vector<CNode*>> vWorkerReceivableNodes(nSocketThreads);
+        std::vector<std::vector<CNode*>> vWorkerSendableNodes(nSocketThreads);
+        for (CNode* pnode : vErrorNodes) {
+            vWorkerErrorNodes[pnode->GetId() % nSocketThreads].emplace_back(pnode);
+        }
+        for (CNode* pnode : vReceivableNodes) {
+            vWorkerReceivableNodes[pnode->GetId() % nSocketThreads].emplace_back(pnode);
+        }
+        for (CNode* pnode : vSendableNodes) {
+            vWorkerSendableNodes[pnode->GetId() % nSocketThreads].emplace_back(pnode);
+        }
+
+        std::vector<std::future<void>> vFutures;
+        vFutures.reserve(nSocketThreads);
+        for (int i = 0; i < nSocketThreads; i++) {
+            if (vWorkerErrorNodes[i].empty() && vWorkerReceivableNodes[i].empty() && vWorkerSendableNodes[i].empty()) {
+                continue;
+            }
+            vFutures.emplace_back(socketWorkerPool.push([&, i](int threadId) {
+                SocketHandleNodes(vWorkerErrorNodes[i], vWorkerReceivableNodes[i], vWorkerSendableNodes[i]);
+            }));
+        }
+        // all workers must be done before the nodes are released and the receivable/sendable maps are cleaned up
+        for (auto& f : vFutures) {
+            f.get();
+        }
+    }
+
+    ReleaseNodeVector(vErrorNodes);
+    ReleaseNodeVector(vReceivableNodes);
+    ReleaseNodeVector(vSendableNodes);
+
+    if (interruptNet) {
+        return;
+    }
+
+    {
+        LOCK(cs_vNodes);
+        // remove nodes from mapSendableNodes, so that the next iteration knows that there is no work to do
+        // (even if there are pending messages to be sent)
+        for (auto it = mapSendableNodes.begin(); it != mapSendableNodes.end(); ) {
+            if (!it->second->fCanSendData) {
+                LogPrint(BCLog::NET, "%s -- remove mapSendableNodes, peer=%d\n", __func__, it->second->GetId());
+                it = mapSendableNodes.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+void CConnman::SocketHandleNodes(const std::vector<CNode*>& vErrorNodes, const std::vector<CNode*>& vReceivableNodes, const std::vector<CNode*>& vSendableNodes)
+{
     for (CNode* pnode : vErrorNodes)
     {
         if (interruptNet) {
@@ -1924,27 +2160,12 @@ void CConnman::SocketHandler()
             RecordBytesSent(nBytes);
         }
     }
+}
 
-    ReleaseNodeVector(vErrorNodes);
-    ReleaseNodeVector(vReceivableNodes);
-    ReleaseNodeVector(vSendableNodes);
-
-    if (interruptNet) {
-        return;
-    }
-
-    {
-        LOCK(cs_vNodes);
-        // remove nodes from mapSendableNodes, so that the next iteration knows that there is no work to do
-        // (even if there are pending messages to be sent)
-        for (auto it = mapSendableNodes.begin(); it != mapSendableNodes.end(); ) {
-            if (!it->second->fCanSendData) {
-                LogPrint(BCLog::NET, "%s -- remove mapSendableNodes, peer=%d\n", __func__, it->second->GetId());
-                it = mapSendableNodes.erase(it);
-            } else {
-                ++it;
-            }
-        }
+void CConnman::SetConnectedSocketOptions(const SOCKET& hSocket) const
+{
+    if (fLowLatency && !SetSocketLowLatency(hSocket)) {
+        LogPrint(BCLog::NET, "CConnman::%s -- setting low latency socket options failed, error %s\n", __func__, NetworkErrorString(WSAGetLastError()));
     }
 }
 
@@ -1953,19 +2174,43 @@ size_t CConnman::SocketRecvData(CNode *pnode)
     // typical socket buffer is 8K-64K
     char pchBuf[0x10000];
     int nBytes = 0;
+    bool fDirect = false;
+    bool notify = false;
     {
         LOCK(pnode->cs_hSocket);
         if (pnode->hSocket == INVALID_SOCKET)
             return 0;
-        nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
-        if (nBytes < (int)sizeof(pchBuf)) {
-            pnode->fHasRecvData = false;
+        {
+            // the remaining payload of large messages (blocks, DKG contributions, ...) is received directly into
+            // the message instead of being copied from pchBuf
+            LOCK(pnode->cs_vRecv);
+            unsigned int nBufSize = 0;
+            char* pBuf = pnode->GetDirectRecvBuffer(sizeof(pchBuf), nBufSize);
+            if (pBuf != nullptr) {
+                fDirect = true;
+                nBytes = recv(pnode->hSocket, pBuf, nBufSize, MSG_DONTWAIT);
+                if (nBytes > 0) {
+                    pnode->DirectRecvBufferWritten(nBytes, notify);
+                }
+                if (nBytes < (int)nBufSize) {
+                    pnode->fHasRecvData = false;
+                }
+            }
+        }
+        if (!fDirect) {
+            nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+            if (nBytes < (int)sizeof(pchBuf)) {
+                pnode->fHasRecvData = false;
+            }
+        }
+        if (fLowLatency && nBytes > 0) {
+            // the kernel might have switched to delayed acks in the meantime
+            SetSocketQuickAck(pnode->hSocket);
         }
     }
     if (nBytes > 0)
     {
-        bool notify = false;
-        if (!pnode->ReceiveMsgBytes(pchBuf, nBytes, notify)) {
+        if (!fDirect && !pnode->ReceiveMsgBytes(pchBuf, nBytes, notify)) {
             LOCK(cs_vNodes);
             pnode->CloseSocketDisconnect(this);
         }
@@ -2272,11 +2517,34 @@ void CConnman::DumpAddresses()
 {
     int64_t nStart = GetTimeMillis();
 
-    CAddrDB adb;
-    adb.Write(addrman);
+    // Serializing into memory only holds the addrman lock briefly, writing and syncing the file is done without it
+    auto ssPeers = std::make_shared<CDataStream>(SER_DISK, CLIENT_VERSION);
+    *ssPeers << addrman;
+    size_t nAddresses = addrman.size();
+    int64_t nSnapshotTime = GetTimeMillis() - nStart;
+
+    RunOnDumpWorker([ssPeers, nAddresses, nSnapshotTime]() {
+        int64_t nStart = GetTimeMillis();
 
-    LogPrint(BCLog::NET, "Flushed %d addresses to peers.dat  %dms\n",
-           addrman.size(), GetTimeMillis() - nStart);
+        CAddrDB adb;
+        adb.Write(*ssPeers);
+
+        int64_t nTime = nSnapshotTime + GetTimeMillis() - nStart;
+        LogPrint(BCLog::NET, "Flushed %d addresses to peers.dat  %dms (snapshot %dms)\n",
+               nAddresses, nTime, nSnapshotTime);
+        statsClient.timing("addrman.dump_ms", nTime, 1.0f);
+    });
+}
+
+void CConnman::RunOnDumpWorker(std::function<void()>&& func)
+{
+    if (!fDumpWorkerRunning) {
+        func();
+        return;
+    }
+    dumpPool.push([func](int threadId) {
+        func();
+    });
 }
 
 void CConnman::DumpData()
@@ -2608,14 +2876,19 @@ void CConnman::ThreadOpenAddedConnections()
     }
 }
 
+// Back off exponentially from masternodes we repeatedly failed to connect to
+static int64_t GetMasternodeConnectionRetryTimeout(const uint256& proTxHash)
+{
+    int nFailures = std::min(mmetaman.GetMetaInfo(proTxHash)->GetOutboundFailures(), MAX_MASTERNODE_CONNECTION_BACKOFF);
+    return (int64_t)Params().LLMQConnectionRetryTimeout() << nFailures;
+}
+
 void CConnman::ThreadOpenMasternodeConnections()
 {
     // Connecting to specific addresses, no masternode connections available
     if (gArgs.IsArgSet("-connect") && gArgs.GetArgs("-connect").size() > 0)
         return;
 
-    auto& chainParams = Params();
-
     bool didConnect = false;
     while (!interruptNet)
     {
@@ -2647,49 +2920,74 @@ void CConnman::ThreadOpenMasternodeConnections()
 
         int64_t nANow = GetAdjustedTime();
 
-        // NOTE: Process only one pending masternode at a time
+        // Pick up to MAX_PARALLEL_MASTERNODE_CONNECTIONS masternodes (minus the attempts still running), explicitly
+        // requested ones first, then quorum members of the most recent quorums, then probes
 
-        CDeterministicMNCPtr connectToDmn;
-        bool isProbe = false;
+        std::vector<std::pair<CDeterministicMNCPtr, bool>> vecToConnect; // masternode, isProbe
         { // don't hold lock while calling OpenMasternodeConnection as cs_main is locked deep inside
             LOCK2(cs_vNodes, cs_vPendingMasternodes);
 
-            if (!vPendingMasternodes.empty()) {
+            size_t nMaxConnect = MAX_PARALLEL_MASTERNODE_CONNECTIONS - std::min<size_t>(masternodeConnectionsInProgress.size(), MAX_PARALLEL_MASTERNODE_CONNECTIONS);
+            std::set<uint256> setSelected;
+            auto canConnect = [&](const CDeterministicMNCPtr& dmn) {
+                return !setSelected.count(dmn->proTxHash) && !masternodeConnectionsInProgress.count(dmn->proTxHash) &&
+                       !connectedNodes.count(dmn->pdmnState->addr) && !IsMasternodeOrDisconnectRequested(dmn->pdmnState->addr);
+            };
+            auto select = [&](const CDeterministicMNCPtr& dmn, bool isProbe) {
+                setSelected.emplace(dmn->proTxHash);
+                vecToConnect.emplace_back(dmn, isProbe);
+            };
+
+            while (!vPendingMasternodes.empty() && vecToConnect.size() < nMaxConnect) {
                 auto dmn = mnList.GetValidMN(vPendingMasternodes.front());
                 vPendingMasternodes.erase(vPendingMasternodes.begin());
-                if (dmn && !connectedNodes.count(dmn->pdmnState->addr) && !IsMasternodeOrDisconnectRequested(dmn->pdmnState->addr)) {
-                    connectToDmn = dmn;
+                if (dmn && canConnect(dmn)) {
+                    select(dmn, false);
                     LogPrint(BCLog::NET_NETCONN, "CConnman::%s -- opening pending masternode connection to %s, service=%s\n", __func__, dmn->proTxHash.ToString(), dmn->pdmnState->addr.ToString(false));
                 }
             }
 
-            if (!connectToDmn) {
-                std::vector<CDeterministicMNCPtr> pending;
+            if (vecToConnect.size() < nMaxConnect) {
+                // quorum members, by the time their quorum connections were requested (newest first)
+                std::vector<std::pair<int64_t, CDeterministicMNCPtr>> pending;
                 for (const auto& group : masternodeQuorumNodes) {
+                    auto itTime = masternodeQuorumNodesTime.find(group.first);
+                    int64_t nGroupTime = itTime != masternodeQuorumNodesTime.end() ? itTime->second : 0;
                     for (const auto& proRegTxHash : group.second) {
                         auto dmn = mnList.GetMN(proRegTxHash);
                         if (!dmn) {
                             continue;
                         }
-                        const auto& addr2 = dmn->pdmnState->addr;
-                        if (!connectedNodes.count(addr2) && !IsMasternodeOrDisconnectRequested(addr2) && !connectedProRegTxHashes.count(proRegTxHash)) {
+                        if (canConnect(dmn) && !connectedProRegTxHashes.count(proRegTxHash)) {
                             int64_t lastAttempt = mmetaman.GetMetaInfo(dmn->proTxHash)->GetLastOutboundAttempt();
                             // back off trying connecting to an address if we already tried recently
-                            if (nANow - lastAttempt < chainParams.LLMQConnectionRetryTimeout()) {
+                            if (nANow - lastAttempt < GetMasternodeConnectionRetryTimeout(dmn->proTxHash)) {
                                 continue;
                             }
-                            pending.emplace_back(dmn);
+                            pending.emplace_back(nGroupTime, dmn);
                         }
                     }
                 }
 
-                if (!pending.empty()) {
-                    connectToDmn = pending[GetRandInt(pending.size())];
-                    LogPrint(BCLog::NET_NETCONN, "CConnman::%s -- opening quorum connection to %s, service=%s\n", __func__, connectToDmn->proTxHash.ToString(), connectToDmn->pdmnState->addr.ToString(false));
+                // random order inside of a group, so that not all members of a quorum try the same masternodes first
+                Shuffle(pending.begin(), pending.end(), FastRandomContext());
+                std::stable_sort(pending.begin(), pending.end(), [](const std::pair<int64_t, CDeterministicMNCPtr>& a, const std::pair<int64_t, CDeterministicMNCPtr>& b) {
+                    return a.first > b.first;
+                });
+                for (const auto& p : pending) {
+                    if (vecToConnect.size() >= nMaxConnect) {
+                        break;
+                    }
+                    // a masternode might be a member of multiple quorums
+                    if (!canConnect(p.second)) {
+                        continue;
+                    }
+                    select(p.second, false);
+                    LogPrint(BCLog::NET_NETCONN, "CConnman::%s -- opening quorum connection to %s, service=%s\n", __func__, p.second->proTxHash.ToString(), p.second->pdmnState->addr.ToString(false));
                 }
             }
 
-            if (!connectToDmn) {
+            if (vecToConnect.size() < nMaxConnect) {
                 std::vector<CDeterministicMNCPtr> pending;
                 for (auto it = masternodePendingProbes.begin(); it != masternodePendingProbes.end(); ) {
                     auto dmn = mnList.GetMN(*it);
@@ -2709,42 +3007,55 @@ void CConnman::ThreadOpenMasternodeConnections()
 
                     int64_t lastAttempt = mmetaman.GetMetaInfo(dmn->proTxHash)->GetLastOutboundAttempt();
                     // back off trying connecting to an address if we already tried recently
-                    if (nANow - lastAttempt < chainParams.LLMQConnectionRetryTimeout()) {
+                    if (nANow - lastAttempt < GetMasternodeConnectionRetryTimeout(dmn->proTxHash)) {
                         continue;
                     }
-                    pending.emplace_back(dmn);
+                    if (canConnect(dmn)) {
+                        pending.emplace_back(dmn);
+                    }
                 }
 
-                if (!pending.empty()) {
-                    connectToDmn = pending[GetRandInt(pending.size())];
-                    masternodePendingProbes.erase(connectToDmn->proTxHash);
-                    isProbe = true;
+                Shuffle(pending.begin(), pending.end(), FastRandomContext());
+                for (const auto& dmn : pending) {
+                    if (vecToConnect.size() >= nMaxConnect) {
+                        break;
+                    }
+                    masternodePendingProbes.erase(dmn->proTxHash);
+                    select(dmn, true);
 
-                    LogPrint(BCLog::NET_NETCONN, "CConnman::%s -- probing masternode %s, service=%s\n", __func__, connectToDmn->proTxHash.ToString(), connectToDmn->pdmnState->addr.ToString(false));
+                    LogPrint(BCLog::NET_NETCONN, "CConnman::%s -- probing masternode %s, service=%s\n", __func__, dmn->proTxHash.ToString(), dmn->pdmnState->addr.ToString(false));
                 }
             }
-        }
 
-        if (!connectToDmn) {
-            continue;
+            for (const auto& p : vecToConnect) {
+                masternodeConnectionsInProgress.emplace(p.first->proTxHash);
+            }
         }
 
-        didConnect = true;
+        for (const auto& p : vecToConnect) {
+            didConnect = true;
 
-        mmetaman.GetMetaInfo(connectToDmn->proTxHash)->SetLastOutboundAttempt(nANow);
+            const auto connectToDmn = p.first;
+            bool isProbe = p.second;
+            mmetaman.GetMetaInfo(connectToDmn->proTxHash)->SetLastOutboundAttempt(nANow);
 
-        OpenMasternodeConnection(CAddress(connectToDmn->pdmnState->addr, NODE_NETWORK), isProbe);
-        // should be in the list now if connection was opened
-        bool connected = ForNode(connectToDmn->pdmnState->addr, CConnman::AllNodes, [&](CNode* pnode) {
-            if (pnode->fDisconnect) {
-                return false;
-            }
-            return true;
-        });
-        if (!connected) {
-            LogPrint(BCLog::NET_NETCONN, "CConnman::%s -- connection failed for masternode  %s, service=%s\n", __func__, connectToDmn->proTxHash.ToString(), connectToDmn->pdmnState->addr.ToString(false));
-            // reset last outbound success
-            mmetaman.GetMetaInfo(connectToDmn->proTxHash)->SetLastOutboundSuccess(0);
+            masternodeConnectionPool.push([this, connectToDmn, isProbe](int threadId) {
+                OpenMasternodeConnection(CAddress(connectToDmn->pdmnState->addr, NODE_NETWORK), isProbe);
+                // should be in the list now if connection was opened
+                bool connected = ForNode(connectToDmn->pdmnState->addr, CConnman::AllNodes, [&](CNode* pnode) {
+                    if (pnode->fDisconnect) {
+                        return false;
+                    }
+                    return true;
+                });
+                if (!connected) {
+                    LogPrint(BCLog::NET_NETCONN, "CConnman::%s -- connection failed for masternode  %s, service=%s\n", __func__, connectToDmn->proTxHash.ToString(), connectToDmn->pdmnState->addr.ToString(false));
+                    // reset last outbound success and back off from this masternode
+                    mmetaman.GetMetaInfo(connectToDmn->proTxHash)->SetOutboundFailed();
+                }
+                LOCK(cs_vPendingMasternodes);
+                masternodeConnectionsInProgress.erase(connectToDmn->proTxHash);
+            });
         }
     }
 }
@@ -2814,6 +3125,7 @@ void CConnman::OpenNetworkConnection(const CAddress& addrConnect, bool fCountFai
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
+        UpdateNodesSnapshot();
         RegisterEvents(pnode);
         WakeSelect();
     }
@@ -3050,6 +3362,7 @@ CConnman::CConnman(uint64_t nSeed0In, uint64_t nSeed1In) :
     nSendBufferMaxSize = 0;
     nReceiveFloodSize = 0;
     flagInterruptMsgProc = false;
+    nodesSnapshot = std::make_shared<const CNodesSnapshot>(std::vector<CNode*>());
     SetTryNewOutboundPeer(false);
 
     Options connOptions;
@@ -3243,6 +3556,23 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
 #endif
 
     // Send and receive from sockets, accept connections
+    if (nSocketThreads > 0) {
+        socketWorkerPool.resize(nSocketThreads);
+        RenameThreadPool(socketWorkerPool, "dash-net-io");
+    }
+    for (int i = 0; i < nMessageWorkerThreads; i++) {
+        vecMessageWorkers.emplace_back(MakeUnique<ctpl::thread_pool>(1));
+        RenameThreadPool(*vecMessageWorkers.back(), strprintf("dash-msg-%d", i).c_str());
+    }
+    fMessageWorkersRunning = !vecMessageWorkers.empty();
+    if (nBlockReadThreads > 0) {
+        blockReadPool.resize(nBlockReadThreads);
+        RenameThreadPool(blockReadPool, "dash-blkread");
+        fBlockReadWorkersRunning = true;
+    }
+    dumpPool.resize(1);
+    RenameThreadPool(dumpPool, "dash-dump");
+    fDumpWorkerRunning = true;
     threadSocketHandler = std::thread(&TraceThread<std::function<void()> >, "net", std::function<void()>(std::bind(&CConnman::ThreadSocketHandler, this)));
 
     if (!gArgs.GetBoolArg("-dnsseed", true))
@@ -3265,13 +3595,15 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
         threadOpenConnections = std::thread(&TraceThread<std::function<void()> >, "opencon", std::function<void()>(std::bind(&CConnman::ThreadOpenConnections, this, connOptions.m_specified_outgoing)));
 
     // Initiate masternode connections
+    masternodeConnectionPool.resize(MAX_PARALLEL_MASTERNODE_CONNECTIONS);
+    RenameThreadPool(masternodeConnectionPool, "dash-mncon");
     threadOpenMasternodeConnections = std::thread(&TraceThread<std::function<void()> >, "mncon", std::function<void()>(std::bind(&CConnman::ThreadOpenMasternodeConnections, this)));
 
     // Process messages
     threadMessageHandler = std::thread(&TraceThread<std::function<void()> >, "msghand", std::function<void()>(std::bind(&CConnman::ThreadMessageHandler, this)));
 
     // Dump network addresses
-    scheduler.scheduleEvery(std::bind(&CConnman::DumpData, this), DUMP_ADDRESSES_INTERVAL * 1000);
+    scheduler.scheduleEvery(std::bind(&CConnman::DumpData, this), DUMP_ADDRESSES_INTERVAL * 1000, "dumpdata");
 
     return true;
 }
@@ -3327,8 +3659,17 @@ void CConnman::Stop()
 {
     if (threadMessageHandler.joinable())
         threadMessageHandler.join();
+    // no more work can be queued now, finish what is queued before the nodes are deleted
+    fMessageWorkersRunning = false;
+    for (auto& worker : vecMessageWorkers) {
+        worker->stop(true);
+    }
+    vecMessageWorkers.clear();
+    fBlockReadWorkersRunning = false;
+    blockReadPool.stop(true);
     if (threadOpenMasternodeConnections.joinable())
         threadOpenMasternodeConnections.join();
+    masternodeConnectionPool.stop(true);
     if (threadOpenConnections.joinable())
         threadOpenConnections.join();
     if (threadOpenAddedConnections.joinable())
@@ -3337,6 +3678,11 @@ void CConnman::Stop()
         threadDNSAddressSeed.join();
     if (threadSocketHandler.joinable())
         threadSocketHandler.join();
+    socketWorkerPool.stop(true);
+
+    // finish the pending background writes, the final dump is written right away
+    fDumpWorkerRunning = false;
+    dumpPool.stop(true);
 
     if (fAddressesInitialized)
     {
@@ -3370,6 +3716,11 @@ void CConnman::Stop()
         }
 
     // clean up some globals (to help leak detection)
+    {
+        // the snapshot must not outlive the nodes it references
+        LOCK(cs_nodesSnapshot);
+        nodesSnapshot = std::make_shared<const CNodesSnapshot>(std::vector<CNode*>());
+    }
     for (CNode *pnode : vNodes) {
         DeleteNode(pnode);
     }
@@ -3424,6 +3775,10 @@ void CConnman::DeleteNode(CNode* pnode)
     if(fUpdateConnectionTime) {
         addrman.Connected(pnode->addr);
     }
+    {
+        LOCK2(cs_msgTimeStatsDisconnected, pnode->cs_msgTimeStats);
+        msgTimeStatsDisconnected.Merge(pnode->msgTimeStats);
+    }
     delete pnode;
 }
 
@@ -3499,6 +3854,7 @@ void CConnman::SetMasternodeQuorumNodes(Consensus::LLMQType llmqType, const uint
     if (!it.second) {
         it.first->second = proTxHashes;
     }
+    masternodeQuorumNodesTime.emplace(std::make_pair(llmqType, quorumHash), GetTimeMicros());
 }
 
 void CConnman::SetMasternodeQuorumRelayMembers(Consensus::LLMQType llmqType, const uint256& quorumHash, const std::set<uint256>& proTxHashes)
@@ -3570,6 +3926,7 @@ void CConnman::RemoveMasternodeQuorumNodes(Consensus::LLMQType llmqType, const u
 {
     LOCK(cs_vPendingMasternodes);
     masternodeQuorumNodes.erase(std::make_pair(llmqType, quorumHash));
+    masternodeQuorumNodesTime.erase(std::make_pair(llmqType, quorumHash));
     masternodeQuorumRelayMembers.erase(std::make_pair(llmqType, quorumHash));
 }
 
@@ -3945,21 +4302,80 @@ bool CConnman::NodeFullyConnected(const CNode* pnode)
     return pnode && pnode->fSuccessfullyConnected && !pnode->fDisconnect;
 }
 
+std::vector<unsigned char> CConnman::SerializeMessageHeader(const CSerializedNetMsg& msg, size_t nReserve)
+{
+    std::vector<unsigned char> serializedHeader;
+    serializedHeader.reserve(nReserve);
+    uint256 hash = Hash(msg.data.data(), msg.data.data() + msg.data.size());
+    CMessageHeader hdr(Params().MessageStart(), msg.command.c_str(), msg.data.size());
+    memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
+
+    CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, serializedHeader, 0, hdr};
+    return serializedHeader;
+}
+
+bool CConnman::SerializeCompactMessageHeader(const CNode* pnode, const std::string& strCommand, size_t nMessageSize, size_t nReserve, std::vector<unsigned char>& vHeaderRet)
+{
+    uint8_t nShortId = GetShortNetMsgTypeId(strCommand);
+    if (nShortId == 0 || nShortId > pnode->nSendCompactHeaderIds) {
+        return false;
+    }
+    vHeaderRet.clear();
+    vHeaderRet.reserve(CMessageHeader::COMPACT_HEADER_SIZE + nReserve);
+    CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, vHeaderRet, 0, nShortId, (uint32_t)nMessageSize};
+    return true;
+}
+
+CSharedSerializedNetMsgRef CConnman::MakeSharedMessage(CSerializedNetMsg&& msg)
+{
+    auto sharedMsg = std::make_shared<CSharedSerializedNetMsg>();
+    sharedMsg->header = SerializeMessageHeader(msg, CMessageHeader::HEADER_SIZE);
+    sharedMsg->command = std::move(msg.command);
+    sharedMsg->data = std::move(msg.data);
+    return sharedMsg;
+}
+
 void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
 {
+    // small payloads are sent from the same buffer as their header
+    bool fCopyPayload = msg.data.size() <= SEND_BUFFER_COALESCE_SIZE;
     size_t nMessageSize = msg.data.size();
-    size_t nTotalSize = nMessageSize + CMessageHeader::HEADER_SIZE;
-    LogPrint(BCLog::NET, "sending %s (%d bytes) peer=%d\n",  SanitizeString(msg.command.c_str()), nMessageSize, pnode->GetId());
-    statsClient.count("bandwidth.message." + SanitizeString(msg.command.c_str()) + ".bytesSent", nTotalSize, 1.0f);
-    statsClient.inc("message.sent." + SanitizeString(msg.command.c_str()), 1.0f);
+    std::vector<unsigned char> serializedHeader;
+    // compact headers don't need the payload to be hashed
+    if (!SerializeCompactMessageHeader(pnode, msg.command, nMessageSize, fCopyPayload ? nMessageSize : 0, serializedHeader)) {
+        serializedHeader = SerializeMessageHeader(msg, CMessageHeader::HEADER_SIZE + (fCopyPayload ? nMessageSize : 0));
+    }
+    if (fCopyPayload) {
+        serializedHeader.insert(serializedHeader.end(), msg.data.begin(), msg.data.end());
+        msg.data.clear();
+    }
+    EnqueueMessage(pnode, msg.command, nMessageSize, std::move(serializedHeader), std::move(msg.data));
+}
 
+void CConnman::PushMessage(CNode* pnode, const CSharedSerializedNetMsgRef& msg)
+{
+    // Copying the bytes is cheap compared to serializing and hashing the message again for every node
+    bool fCopyPayload = msg->data.size() <= SEND_BUFFER_COALESCE_SIZE;
     std::vector<unsigned char> serializedHeader;
-    serializedHeader.reserve(CMessageHeader::HEADER_SIZE);
-    uint256 hash = Hash(msg.data.data(), msg.data.data() + nMessageSize);
-    CMessageHeader hdr(Params().MessageStart(), msg.command.c_str(), nMessageSize);
-    memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
+    if (!SerializeCompactMessageHeader(pnode, msg->command, msg->data.size(), fCopyPayload ? msg->data.size() : 0, serializedHeader)) {
+        serializedHeader.reserve(msg->header.size() + (fCopyPayload ? msg->data.size() : 0));
+        serializedHeader.insert(serializedHeader.end(), msg->header.begin(), msg->header.end());
+    }
+    std::vector<unsigned char> payload;
+    if (fCopyPayload) {
+        serializedHeader.insert(serializedHeader.end(), msg->data.begin(), msg->data.end());
+    } else {
+        payload = msg->data;
+    }
+    EnqueueMessage(pnode, msg->command, msg->data.size(), std::move(serializedHeader), std::move(payload));
+}
 
-    CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, serializedHeader, 0, hdr};
+void CConnman::EnqueueMessage(CNode* pnode, const std::string& strCommand, size_t nMessageSize, std::vector<unsigned char>&& vHeader, std::vector<unsigned char>&& vPayload)
+{
+    size_t nTotalSize = vHeader.size() + vPayload.size();
+    LogPrint(BCLog::NET, "sending %s (%d bytes) peer=%d\n",  SanitizeString(strCommand.c_str()), nMessageSize, pnode->GetId());
+    statsClient.count("bandwidth.message." + SanitizeString(strCommand.c_str()) + ".bytesSent", nTotalSize, 1.0f);
+    statsClient.inc("message.sent." + SanitizeString(strCommand.c_str()), 1.0f);
 
     size_t nBytesSent = 0;
     {
@@ -3967,14 +4383,23 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
         bool hasPendingData = !pnode->vSendMsg.empty();
 
         //log total amount of bytes per command
-        pnode->mapSendBytesPerMsgCmd[msg.command] += nTotalSize;
+        pnode->mapSendBytesPerMsgCmd[strCommand] += nTotalSize;
         pnode->nSendSize += nTotalSize;
+        pnode->vSendMsgTimes.push_back({pnode->nSendBytes + pnode->nSendSize, GetTimeMicros(), strCommand});
 
         if (pnode->nSendSize > nSendBufferMaxSize)
             pnode->fPauseSend = true;
-        pnode->vSendMsg.push_back(std::move(serializedHeader));
-        if (nMessageSize)
-            pnode->vSendMsg.push_back(std::move(msg.data));
+        // Coalesce small messages into the last pending buffer, so that bursts of small messages (e.g. INVs or
+        // signature shares) don't need an allocation and an iovec entry per message. This is safe even if the last
+        // buffer was already partially sent, as nSendOffset only refers to data which is not touched here
+        if (!pnode->vSendMsg.empty() && pnode->vSendMsg.back().size() + vHeader.size() <= SEND_BUFFER_COALESCE_SIZE) {
+            auto& lastBuffer = pnode->vSendMsg.back();
+            lastBuffer.insert(lastBuffer.end(), vHeader.begin(), vHeader.end());
+        } else {
+            pnode->vSendMsg.push_back(std::move(vHeader));
+        }
+        if (!vPayload.empty())
+            pnode->vSendMsg.push_back(std::move(vPayload));
         pnode->nSendMsgSize = pnode->vSendMsg.size();
 
         {
@@ -4044,13 +4469,82 @@ int64_t PoissonNextSend(int64_t now, int average_interval_seconds)
     return now + (int64_t)(log1p(GetRand(1ULL << 48) * -0.0000000000000035527136788 /* -1/2^48 */) * average_interval_seconds * -1000000.0 + 0.5);
 }
 
+CNodesSnapshot::CNodesSnapshot(const std::vector<CNode*>& vNodesIn) :
+    vNodes(vNodesIn)
+{
+    for (CNode* pnode : vNodes) {
+        pnode->AddRef();
+    }
+}
+
+CNodesSnapshot::~CNodesSnapshot()
+{
+    for (CNode* pnode : vNodes) {
+        pnode->Release();
+    }
+}
+
+void CConnman::UpdateNodesSnapshot()
+{
+    AssertLockHeld(cs_vNodes);
+    auto newSnapshot = std::make_shared<const CNodesSnapshot>(vNodes);
+    LOCK(cs_nodesSnapshot);
+    nodesSnapshot = std::move(newSnapshot);
+}
+
+bool CConnman::RunOnMessageWorker(CNode* pnode, std::function<void()>&& func)
+{
+    if (!fMessageWorkersRunning || flagInterruptMsgProc) {
+        return false;
+    }
+    auto& worker = vecMessageWorkers[pnode->GetId() % vecMessageWorkers.size()];
+    pnode->AddRef();
+    worker->push([pnode, func](int threadId) {
+        func();
+        pnode->Release();
+    });
+    return true;
+}
+
+bool CConnman::RunOnBlockReadWorker(CNode* pnode, std::function<void()>&& func)
+{
+    if (!fBlockReadWorkersRunning || flagInterruptMsgProc) {
+        return false;
+    }
+    pnode->AddRef();
+    blockReadPool.push([pnode, func](int threadId) {
+        func();
+        pnode->Release();
+    });
+    return true;
+}
+
+CNetMsgTimeStats CConnman::GetMsgTimeStats() const
+{
+    CNetMsgTimeStats stats;
+    {
+        LOCK(cs_msgTimeStatsDisconnected);
+        stats = msgTimeStatsDisconnected;
+    }
+    ForEachNode(AllNodes, [&](const CNode* pnode) {
+        LOCK(pnode->cs_msgTimeStats);
+        stats.Merge(pnode->msgTimeStats);
+    });
+    return stats;
+}
+
+std::shared_ptr<const CNodesSnapshot> CConnman::GetNodesSnapshot() const
+{
+    LOCK(cs_nodesSnapshot);
+    return nodesSnapshot;
+}
+
 std::vector<CNode*> CConnman::CopyNodeVector(std::function<bool(const CNode* pnode)> cond)
 {
     std::vector<CNode*> vecNodesCopy;
-    LOCK(cs_vNodes);
-    vecNodesCopy.reserve(vNodes.size());
-    for(size_t i = 0; i < vNodes.size(); ++i) {
-        CNode* pnode = vNodes[i];
+    auto snapshot = GetNodesSnapshot();
+    vecNodesCopy.reserve(snapshot->vNodes.size());
+    for (CNode* pnode : snapshot->vNodes) {
         if (!cond(pnode))
             continue;
         pnode->AddRef();
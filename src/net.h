@@ -25,6 +25,8 @@
 #include <threadinterrupt.h>
 #include <consensus/params.h>
 
+#include <ctpl.h>
+
 #include <atomic>
 #include <deque>
 #include <stdint.h>
@@ -90,6 +92,24 @@ static const uint64_t MAX_UPLOAD_TIMEFRAME = 60 * 60 * 24;
 static const bool DEFAULT_BLOCKSONLY = false;
 /** -peertimeout default */
 static const int64_t DEFAULT_PEER_CONNECT_TIMEOUT = 60;
+/** Number of threads which receive and send socket data, 0 to do it on the socket handler thread */
+static const int DEFAULT_SOCKET_THREADS = 0;
+/** Maximum number of socket worker threads */
+static const int MAX_SOCKET_THREADS = 16;
+/** Maximum number of masternode/quorum connections which are established in parallel */
+static const int MAX_PARALLEL_MASTERNODE_CONNECTIONS = 8;
+/** Retrying a masternode connection backs off up to 2^MAX_MASTERNODE_CONNECTION_BACKOFF times the LLMQ retry timeout */
+static const int MAX_MASTERNODE_CONNECTION_BACKOFF = 4;
+/** Number of threads which process messages that don't affect validation, 0 to process all messages on the message handler thread */
+static const int DEFAULT_MESSAGE_WORKER_THREADS = 0;
+/** Maximum number of message worker threads */
+static const int MAX_MESSAGE_WORKER_THREADS = 16;
+/** Number of threads which read blocks requested through GETDATA from disk, 0 to read them on the message handler thread */
+static const int DEFAULT_BLOCK_READ_THREADS = 2;
+/** Maximum number of block read threads */
+static const int MAX_BLOCK_READ_THREADS = 16;
+/** Default for -lowlatency, trading CPU time for lower network latency */
+static const bool DEFAULT_LOW_LATENCY = false;
 
 static const bool DEFAULT_FORCEDNSSEED = false;
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
@@ -134,6 +154,69 @@ struct CSerializedNetMsg
     std::string command;
 };
 
+/**
+ * A message which is serialized and checksummed only once and then pushed to many peers, e.g. when announcing
+ * something to all connections. Create it with CConnman::MakeSharedMessage and keep it alive by reference.
+ */
+struct CSharedSerializedNetMsg
+{
+    std::string command;
+    std::vector<unsigned char> header;
+    std::vector<unsigned char> data;
+};
+typedef std::shared_ptr<const CSharedSerializedNetMsg> CSharedSerializedNetMsgRef;
+
+/** Number, total and maximum of measured message times, in microseconds */
+struct CNetMsgTime
+{
+    uint64_t nCount{0};
+    int64_t nTotal{0};
+    int64_t nMax{0};
+
+    void Add(int64_t nTime)
+    {
+        nCount++;
+        nTotal += nTime;
+        nMax = std::max(nMax, nTime);
+    }
+    void Merge(const CNetMsgTime& other)
+    {
+        nCount += other.nCount;
+        nTotal += other.nTotal;
+        nMax = std::max(nMax, other.nMax);
+    }
+};
+typedef std::map<std::string, CNetMsgTime> mapMsgCmdTime; //command, times
+
+/** Where messages spend their time, by command */
+struct CNetMsgTimeStats
+{
+    // time spent in ProcessMessage
+    mapMsgCmdTime mapProcessTime;
+    // time between the message being received completely and being processed (waiting in vProcessMsg)
+    mapMsgCmdTime mapRecvQueueTime;
+    // time between PushMessage and the last byte of the message being handed to the kernel
+    mapMsgCmdTime mapSendQueueTime;
+
+    void Merge(const CNetMsgTimeStats& other);
+};
+
+/**
+ * Immutable copy of CConnman::vNodes which holds a reference on each of its nodes. It is replaced whenever nodes are
+ * added or removed, so that ForEachNode and friends can iterate over the nodes without holding cs_vNodes while the
+ * callbacks run. Nodes are kept alive until the last snapshot containing them is gone.
+ */
+class CNodesSnapshot
+{
+public:
+    explicit CNodesSnapshot(const std::vector<CNode*>& vNodesIn);
+    ~CNodesSnapshot();
+    CNodesSnapshot(const CNodesSnapshot&) = delete;
+    CNodesSnapshot& operator=(const CNodesSnapshot&) = delete;
+
+    const std::vector<CNode*> vNodes;
+};
+
 class NetEventsInterface;
 class CConnman
 {
@@ -176,6 +259,10 @@ public:
         std::vector<std::string> m_specified_outgoing;
         std::vector<std::string> m_added_nodes;
         SocketEventsMode socketEventsMode = SOCKETEVENTS_SELECT;
+        int nSocketThreads = DEFAULT_SOCKET_THREADS;
+        int nMessageWorkerThreads = DEFAULT_MESSAGE_WORKER_THREADS;
+        bool fLowLatency = DEFAULT_LOW_LATENCY;
+        int nBlockReadThreads = DEFAULT_BLOCK_READ_THREADS;
     };
 
     void Init(const Options& connOptions) {
@@ -202,6 +289,10 @@ public:
             vAddedNodes = connOptions.m_added_nodes;
         }
         socketEventsMode = connOptions.socketEventsMode;
+        nSocketThreads = std::max(0, std::min(connOptions.nSocketThreads, MAX_SOCKET_THREADS));
+        nMessageWorkerThreads = std::max(0, std::min(connOptions.nMessageWorkerThreads, MAX_MESSAGE_WORKER_THREADS));
+        fLowLatency = connOptions.fLowLatency;
+        nBlockReadThreads = std::max(0, std::min(connOptions.nBlockReadThreads, MAX_BLOCK_READ_THREADS));
     }
 
     CConnman(uint64_t seed0, uint64_t seed1);
@@ -256,12 +347,16 @@ public:
     bool IsMasternodeOrDisconnectRequested(const CService& addr);
 
     void PushMessage(CNode* pnode, CSerializedNetMsg&& msg);
+    void PushMessage(CNode* pnode, const CSharedSerializedNetMsgRef& msg);
+
+    /** Serializes the header (including the checksum) of msg once, so that it can be pushed to many nodes */
+    static CSharedSerializedNetMsgRef MakeSharedMessage(CSerializedNetMsg&& msg);
 
     template<typename Condition, typename Callable>
     bool ForEachNodeContinueIf(const Condition& cond, Callable&& func)
     {
-        LOCK(cs_vNodes);
-        for (auto&& node : vNodes)
+        auto snapshot = GetNodesSnapshot();
+        for (auto&& node : snapshot->vNodes)
             if (cond(node))
                 if(!func(node))
                     return false;
@@ -277,8 +372,8 @@ public:
     template<typename Condition, typename Callable>
     bool ForEachNodeContinueIf(const Condition& cond, Callable&& func) const
     {
-        LOCK(cs_vNodes);
-        for (const auto& node : vNodes)
+        auto snapshot = GetNodesSnapshot();
+        for (const auto& node : snapshot->vNodes)
             if (cond(node))
                 if(!func(node))
                     return false;
@@ -294,8 +389,8 @@ public:
     template<typename Condition, typename Callable>
     void ForEachNode(const Condition& cond, Callable&& func)
     {
-        LOCK(cs_vNodes);
-        for (auto&& node : vNodes) {
+        auto snapshot = GetNodesSnapshot();
+        for (auto&& node : snapshot->vNodes) {
             if (cond(node))
                 func(node);
         }
@@ -310,8 +405,8 @@ public:
     template<typename Condition, typename Callable>
     void ForEachNode(const Condition& cond, Callable&& func) const
     {
-        LOCK(cs_vNodes);
-        for (auto&& node : vNodes) {
+        auto snapshot = GetNodesSnapshot();
+        for (auto&& node : snapshot->vNodes) {
             if (cond(node))
                 func(node);
         }
@@ -326,8 +421,8 @@ public:
     template<typename Condition, typename Callable, typename CallableAfter>
     void ForEachNodeThen(const Condition& cond, Callable&& pre, CallableAfter&& post)
     {
-        LOCK(cs_vNodes);
-        for (auto&& node : vNodes) {
+        auto snapshot = GetNodesSnapshot();
+        for (auto&& node : snapshot->vNodes) {
             if (cond(node))
                 pre(node);
         }
@@ -343,8 +438,8 @@ public:
     template<typename Condition, typename Callable, typename CallableAfter>
     void ForEachNodeThen(const Condition& cond, Callable&& pre, CallableAfter&& post) const
     {
-        LOCK(cs_vNodes);
-        for (auto&& node : vNodes) {
+        auto snapshot = GetNodesSnapshot();
+        for (auto&& node : snapshot->vNodes) {
             if (cond(node))
                 pre(node);
         }
@@ -357,6 +452,24 @@ public:
         ForEachNodeThen(FullyConnectedOnly, pre, post);
     }
 
+    /**
+     * Runs func on the message worker thread of pnode, so that it doesn't delay the message handler thread. All work
+     * of the same node ends up on the same worker and is executed in order. pnode is kept alive until func returns.
+     * Returns false if message workers are disabled or shutting down, in which case the caller has to do the work.
+     */
+    bool RunOnMessageWorker(CNode* pnode, std::function<void()>&& func);
+    /**
+     * Runs func on one of the block read threads, used to read blocks requested by peers from disk. pnode is kept alive
+     * until func returns. Returns false if block read threads are disabled or shutting down.
+     */
+    bool RunOnBlockReadWorker(CNode* pnode, std::function<void()>&& func);
+
+    /** Message times of all current peers and of all peers which were disconnected since startup */
+    CNetMsgTimeStats GetMsgTimeStats() const;
+
+    /** Current nodes, can be iterated without holding cs_vNodes */
+    std::shared_ptr<const CNodesSnapshot> GetNodesSnapshot() const;
+
     std::vector<CNode*> CopyNodeVector(std::function<bool(const CNode* pnode)> cond);
     std::vector<CNode*> CopyNodeVector();
     void ReleaseNodeVector(const std::vector<CNode*>& vecNodes);
@@ -510,6 +623,8 @@ private:
     void SocketEventsSelect(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll);
     void SocketEvents(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll);
     void SocketHandler();
+    /// Receives from and sends to the given nodes, called either by the socket handler or by a socket worker
+    void SocketHandleNodes(const std::vector<CNode*>& vErrorNodes, const std::vector<CNode*>& vReceivableNodes, const std::vector<CNode*>& vSendableNodes);
     void ThreadSocketHandler();
     void ThreadDNSAddressSeed();
     void ThreadOpenMasternodeConnections();
@@ -526,10 +641,19 @@ private:
     bool IsWhitelistedRange(const CNetAddr &addr);
 
     void DeleteNode(CNode* pnode);
+    /** Must be called whenever vNodes changes */
+    void UpdateNodesSnapshot() EXCLUSIVE_LOCKS_REQUIRED(cs_vNodes);
 
     NodeId GetNewNodeId();
 
     size_t SocketSendData(CNode *pnode);
+    /** Applies socket options which depend on our configuration to a newly connected socket */
+    void SetConnectedSocketOptions(const SOCKET& hSocket) const;
+    static std::vector<unsigned char> SerializeMessageHeader(const CSerializedNetMsg& msg, size_t nReserve);
+    /** Serializes a compact header into vHeaderRet if pnode accepts one for strCommand, returns false otherwise */
+    static bool SerializeCompactMessageHeader(const CNode* pnode, const std::string& strCommand, size_t nMessageSize, size_t nReserve, std::vector<unsigned char>& vHeaderRet);
+    /** Appends an already serialized message to the send queue of pnode, vHeader may already contain the payload */
+    void EnqueueMessage(CNode* pnode, const std::string& strCommand, size_t nMessageSize, std::vector<unsigned char>&& vHeader, std::vector<unsigned char>&& vPayload);
     size_t SocketRecvData(CNode* pnode);
     //!check is the banlist has unwritten changes
     bool BannedSetIsDirty();
@@ -540,6 +664,8 @@ private:
     void DumpAddresses();
     void DumpData();
     void DumpBanlist();
+    /** Runs func on the dump thread, which writes peers.dat and banlist.dat, or right away if it isn't running */
+    void RunOnDumpWorker(std::function<void()>&& func);
 
     // Network stats
     void RecordBytesRecv(uint64_t bytes);
@@ -588,11 +714,23 @@ private:
     std::map<std::pair<Consensus::LLMQType, uint256>, std::set<uint256>> masternodeQuorumNodes; // protected by cs_vPendingMasternodes
     std::map<std::pair<Consensus::LLMQType, uint256>, std::set<uint256>> masternodeQuorumRelayMembers; // protected by cs_vPendingMasternodes
     std::set<uint256> masternodePendingProbes;
+    // when each of the groups in masternodeQuorumNodes was added, newer groups (ongoing DKGs) are connected first
+    std::map<std::pair<Consensus::LLMQType, uint256>, int64_t> masternodeQuorumNodesTime; // protected by cs_vPendingMasternodes
+    // masternodes a connection attempt is currently running for
+    std::set<uint256> masternodeConnectionsInProgress; // protected by cs_vPendingMasternodes
+    // establishes masternode connections in parallel, see ThreadOpenMasternodeConnections
+    ctpl::thread_pool masternodeConnectionPool;
     mutable CCriticalSection cs_vPendingMasternodes;
     std::vector<CNode*> vNodes;
     std::list<CNode*> vNodesDisconnected;
     std::unordered_map<SOCKET, CNode*> mapSocketToNode;
     mutable CCriticalSection cs_vNodes;
+    /** Message times of peers which are gone */
+    mutable CCriticalSection cs_msgTimeStatsDisconnected;
+    CNetMsgTimeStats msgTimeStatsDisconnected GUARDED_BY(cs_msgTimeStatsDisconnected);
+    /** Only held while the snapshot pointer is read or replaced */
+    mutable CCriticalSection cs_nodesSnapshot;
+    std::shared_ptr<const CNodesSnapshot> nodesSnapshot GUARDED_BY(cs_nodesSnapshot);
     std::atomic<NodeId> nLastNodeId;
     unsigned int nPrevNodeCount;
 
@@ -629,6 +767,23 @@ private:
     std::atomic<bool> wakeupSelectNeeded{false};
 
     SocketEventsMode socketEventsMode;
+    int nSocketThreads{DEFAULT_SOCKET_THREADS};
+    /** Workers which do the actual socket IO for the nodes the socket handler found to be ready */
+    ctpl::thread_pool socketWorkerPool;
+    int nMessageWorkerThreads{DEFAULT_MESSAGE_WORKER_THREADS};
+    /** Single threaded pools, one per message worker, so that work is never reordered for a node */
+    std::vector<std::unique_ptr<ctpl::thread_pool>> vecMessageWorkers;
+    std::atomic<bool> fMessageWorkersRunning{false};
+    int nBlockReadThreads{DEFAULT_BLOCK_READ_THREADS};
+    ctpl::thread_pool blockReadPool;
+    std::atomic<bool> fBlockReadWorkersRunning{false};
+    /** Single threaded, so that a newer snapshot is never overwritten by an older one */
+    ctpl::thread_pool dumpPool;
+    std::atomic<bool> fDumpWorkerRunning{false};
+    /** Low latency mode: low latency socket options and polling without timeout for a while after socket events */
+    bool fLowLatency{DEFAULT_LOW_LATENCY};
+    /** Last time SocketEvents returned any events, only used by the socket handler thread */
+    int64_t nLastSocketEventsTime{0};
 #ifdef USE_KQUEUE
     int kqueuefd{-1};
 #endif
@@ -764,6 +919,7 @@ public:
     mapMsgCmdSize mapSendBytesPerMsgCmd;
     uint64_t nRecvBytes;
     mapMsgCmdSize mapRecvBytesPerMsgCmd;
+    CNetMsgTimeStats msgTimeStats;
     bool fWhitelisted;
     double dPingTime;
     double dPingWait;
@@ -794,6 +950,7 @@ public:
     CDataStream hdrbuf;             // partially received header
     CMessageHeader hdr;             // complete header
     unsigned int nHdrPos;
+    bool fCompactHeader;            // received with a compact header, hdr has no checksum
 
     CDataStream vRecv;              // received message data
     unsigned int nDataPos;
@@ -804,6 +961,7 @@ public:
         hdrbuf.resize(24);
         in_data = false;
         nHdrPos = 0;
+        fCompactHeader = false;
         nDataPos = 0;
         nTime = 0;
     }
@@ -817,14 +975,25 @@ public:
 
     const uint256& GetMessageHash() const;
 
+    unsigned int GetHeaderSize() const
+    {
+        return fCompactHeader ? CMessageHeader::COMPACT_HEADER_SIZE : CMessageHeader::HEADER_SIZE;
+    }
+
     void SetVersion(int nVersionIn)
     {
         hdrbuf.SetVersion(nVersionIn);
         vRecv.SetVersion(nVersionIn);
     }
 
-    int readHeader(const char *pch, unsigned int nBytes);
+    // fAllowCompact: accept compact headers (see SENDCMPCTHDR) in addition to regular ones
+    int readHeader(const char *pch, unsigned int nBytes, bool fAllowCompact = false);
     int readData(const char *pch, unsigned int nBytes);
+
+    // Returns where the next payload bytes must be written to and limits nBytes to what fits into the buffer
+    char* getDataBuffer(unsigned int& nBytes);
+    // Accounts for nBytes of payload which were written into the buffer returned by getDataBuffer
+    void dataWritten(unsigned int nBytes);
 };
 
 
@@ -849,9 +1018,23 @@ public:
     std::list<CNetMessage> vProcessMsg GUARDED_BY(cs_vProcessMsg);
     size_t nProcessQueueSize;
 
+    struct CQueuedMsgTime {
+        // value of nSendBytes once the message is sent completely
+        uint64_t nEndOffset;
+        int64_t nTimeQueued;
+        std::string strCommand;
+    };
+    // Messages in vSendMsg, used to measure how long they are queued
+    std::deque<CQueuedMsgTime> vSendMsgTimes GUARDED_BY(cs_vSend);
+    mutable CCriticalSection cs_msgTimeStats;
+    CNetMsgTimeStats msgTimeStats GUARDED_BY(cs_msgTimeStats);
+
     CCriticalSection cs_sendProcessing;
 
     std::deque<CInv> vRecvGetData;
+    // A block for the first entries of vRecvGetData is read from disk asynchronously, vRecvGetData must not be
+    // processed any further until it's done
+    std::atomic<bool> fGetDataBlockReadPending{false};
     uint64_t nRecvBytes GUARDED_BY(cs_vRecv);
     std::atomic<int> nRecvVersion;
 
@@ -967,6 +1150,10 @@ public:
 
     // If true, we will send him CoinJoin queue messages
     std::atomic<bool> fSendDSQueue{false};
+    // We announced SENDCMPCTHDR, the peer may send us compact message headers
+    std::atomic<bool> fRecvCompactHeaders{false};
+    // Number of short message type ids the peer accepts in compact headers, 0 if it didn't send SENDCMPCTHDR
+    std::atomic<uint8_t> nSendCompactHeaderIds{0};
 
     // Challenge sent in VERSION to be answered with MNAUTH (only happens between MNs)
     mutable CCriticalSection cs_mnauth;
@@ -1002,6 +1189,9 @@ private:
     // Our address, as reported by the peer
     CService addrLocal GUARDED_BY(cs_addrLocal);
     mutable CCriticalSection cs_addrLocal;
+
+    // Accounts for a completely received message
+    void MessageReceived(CNetMessage& msg, int64_t nTimeMicros) EXCLUSIVE_LOCKS_REQUIRED(cs_vRecv);
 public:
 
     NodeId GetId() const {
@@ -1024,6 +1214,18 @@ public:
 
     bool ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& complete);
 
+    /** Accounts for a processed message, times are in microseconds */
+    void AddMsgProcessTime(const std::string& strCommand, int64_t nRecvQueueTime, int64_t nProcessTime);
+
+    /**
+     * Returns the payload buffer of the message which is currently being received, so that the socket can be read
+     * directly into it. Only done if at least nMinSize bytes of the payload are still missing, nullptr otherwise.
+     * nSizeRet might be less than the missing payload, as the buffer only grows while data arrives.
+     */
+    char* GetDirectRecvBuffer(unsigned int nMinSize, unsigned int& nSizeRet) EXCLUSIVE_LOCKS_REQUIRED(cs_vRecv);
+    /** Accounts for nBytes which were received into the buffer returned by GetDirectRecvBuffer */
+    void DirectRecvBufferWritten(unsigned int nBytes, bool& complete) EXCLUSIVE_LOCKS_REQUIRED(cs_vRecv);
+
     void SetRecvVersion(int nVersionIn)
     {
         nRecvVersion = nVersionIn;
@@ -11,10 +11,12 @@
 #include <chainparams.h>
 #include <consensus/validation.h>
 #include <hash.h>
+#include <index/blockfilterindex.h>
 #include <init.h>
 #include <merkleblock.h>
 #include <netmessagemaker.h>
 #include <netbase.h>
+#include <objectrequest.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
 #include <primitives/block.h>
@@ -25,6 +27,7 @@
 #include <tinyformat.h>
 #include <txdb.h>
 #include <txmempool.h>
+#include <txrelaycache.h>
 #include <ui_interface.h>
 #include <util.h>
 #include <utilmoneystr.h>
@@ -59,27 +62,18 @@
 # error "Dash Core cannot be compiled without assertions."
 #endif
 
-/** Maximum number of in-flight objects from a peer */
-static constexpr int32_t MAX_PEER_OBJECT_IN_FLIGHT = 100;
-/** Maximum number of announced objects from a peer */
-static constexpr int32_t MAX_PEER_OBJECT_ANNOUNCEMENTS = 2 * MAX_INV_SZ;
-/** How many microseconds to delay requesting transactions from inbound peers */
-static constexpr std::chrono::microseconds INBOUND_PEER_TX_DELAY{std::chrono::seconds{2}};
-/** How long to wait (in microseconds) before downloading a transaction from an additional peer */
-static constexpr std::chrono::microseconds GETDATA_TX_INTERVAL{std::chrono::seconds{60}};
-/** Maximum delay (in microseconds) for transaction requests to avoid biasing some peers over others. */
-static constexpr std::chrono::microseconds MAX_GETDATA_RANDOM_DELAY{std::chrono::seconds{2}};
-/** How long to wait (expiry * factor microseconds) before expiring an in-flight getdata request to a peer */
-static constexpr int64_t TX_EXPIRY_INTERVAL_FACTOR = 10;
-static_assert(INBOUND_PEER_TX_DELAY >= MAX_GETDATA_RANDOM_DELAY,
-"To preserve security, MAX_GETDATA_RANDOM_DELAY should not exceed INBOUND_PEER_DELAY");
 /** Limit to avoid sending big packets. Not used in processing incoming GETDATA for compatibility */
 static const unsigned int MAX_GETDATA_SZ = 1000;
+/** Maximum number of further blocks requested in the same GETDATA which are read from disk together with the current one */
+static const unsigned int MAX_GETDATA_BLOCK_READ_AHEAD = 4;
 
 /** Expiration time for orphan transactions in seconds */
 static constexpr int64_t ORPHAN_TX_EXPIRE_TIME = 20 * 60;
 /** Minimum time between orphan transactions expire time checks in seconds */
 static constexpr int64_t ORPHAN_TX_EXPIRE_INTERVAL = 5 * 60;
+/** Maximum number of orphans passed to AcceptToMemoryPool in one ProcessOrphanTx call, the rest of the work set
+ *  is processed in later calls. Orphans which still miss inputs are skipped without counting against this. */
+static constexpr unsigned int MAX_ORPHAN_TX_BATCH_SIZE = 25;
 /** Headers download timeout expressed in microseconds
  *  Timeout = base + per_header * (expected number of headers) */
 static constexpr int64_t HEADERS_DOWNLOAD_TIMEOUT_BASE = 15 * 60 * 1000000; // 15 minutes
@@ -185,18 +179,15 @@ namespace {
     /** Number of peers from which we're downloading blocks. */
     int nPeersWithValidatedDownloads GUARDED_BY(cs_main) = 0;
 
+    /** Sum of the in-flight block limits of all peers, used to size the block download window. */
+    int nTotalMaxBlocksInFlight GUARDED_BY(cs_main) = 0;
+
     /** Number of outbound peers with m_chain_sync.m_protect. */
     int g_outbound_peers_with_protect_from_disconnect GUARDED_BY(cs_main) = 0;
 
     /** When our tip was last updated. */
     std::atomic<int64_t> g_last_tip_update(0);
 
-    /** Relay map */
-    typedef std::map<uint256, CTransactionRef> MapRelay;
-    MapRelay mapRelay GUARDED_BY(cs_main);
-    /** Expiration-time ordered list of (expire time, relay map entry) pairs. */
-    std::deque<std::pair<int64_t, MapRelay::iterator>> vRelayExpiration GUARDED_BY(cs_main);
-
     std::atomic<int64_t> nTimeBestReceived(0); // Used only to inform the wallet of when we last received a block
 
     struct IteratorComparator
@@ -260,6 +251,10 @@ struct CNodeState {
     int64_t nDownloadingSince;
     int nBlocksInFlight;
     int nBlocksInFlightValidHeaders;
+    //! Moving average of the time (in microseconds) the first entry of vBlocksInFlight took to arrive, or 0 if unknown.
+    int64_t nAvgBlockDeliveryTime;
+    //! How many blocks may be in flight from this peer at once, adapted to its delivery rate.
+    int nMaxBlocksInFlight;
     //! Whether we consider this a preferred download peer.
     bool fPreferredDownload;
     //! Whether this peer wants invs or headers (when possible) for block announcements.
@@ -304,68 +299,9 @@ struct CNodeState {
     //! Time of last new block announcement
     int64_t m_last_block_announcement;
 
-    /*
-     * State associated with objects download.
-     *
-     * Tx download algorithm:
-     *
-     *   When inv comes in, queue up (process_time, inv) inside the peer's
-     *   CNodeState (m_object_process_time) as long as m_object_announced for the peer
-     *   isn't too big (MAX_PEER_OBJECT_ANNOUNCEMENTS).
-     *
-     *   The process_time for a objects is set to nNow for outbound peers,
-     *   nNow + 2 seconds for inbound peers. This is the time at which we'll
-     *   consider trying to request the objects from the peer in
-     *   SendMessages(). The delay for inbound peers is to allow outbound peers
-     *   a chance to announce before we request from inbound peers, to prevent
-     *   an adversary from using inbound connections to blind us to a
-     *   objects (InvBlock).
-     *
-     *   When we call SendMessages() for a given peer,
-     *   we will loop over the objects in m_object_process_time, looking
-     *   at the objects whose process_time <= nNow. We'll request each
-     *   such objects that we don't have already and that hasn't been
-     *   requested from another peer recently, up until we hit the
-     *   MAX_PEER_OBJECT_IN_FLIGHT limit for the peer. Then we'll update
-     *   g_already_asked_for for each requested inv, storing the time of the
-     *   GETDATA request. We use g_already_asked_for to coordinate objects
-     *   requests amongst our peers.
-     *
-     *   For objects that we still need but we have already recently
-     *   requested from some other peer, we'll reinsert (process_time, inv)
-     *   back into the peer's m_object_process_time at the point in the future at
-     *   which the most recent GETDATA request would time out (ie
-     *   GetObjectInterval + the request time stored in g_already_asked_for).
-     *   We add an additional delay for inbound peers, again to prefer
-     *   attempting download from outbound peers first.
-     *   We also add an extra small random delay up to 2 seconds
-     *   to avoid biasing some peers over others. (e.g., due to fixed ordering
-     *   of peer processing in ThreadMessageHandler).
-     *
-     *   When we receive a objects from a peer, we remove the inv from the
-     *   peer's m_object_in_flight set and from their recently announced set
-     *   (m_object_announced).  We also clear g_already_asked_for for that entry, so
-     *   that if somehow the objects is not accepted but also not added to
-     *   the reject filter, then we will eventually redownload from other
-     *   peers.
-     */
-    struct ObjectDownloadState {
-        /* Track when to attempt download of announced objects (process
-         * time in micros -> inv)
-         */
-        std::multimap<std::chrono::microseconds, CInv> m_object_process_time;
-
-        //! Store all the objects a peer has recently announced
-        std::set<CInv> m_object_announced;
-
-        //! Store objects which were requested by us, with timestamp
-        std::map<CInv, std::chrono::microseconds> m_object_in_flight;
-
-        //! Periodically check for stuck getdata requests
-        std::chrono::microseconds m_check_expiry_timer{0};
-    };
-
-    ObjectDownloadState m_object_download;
+    //! Serialized blocks read from disk by a block read thread, waiting to be sent in the order they were requested.
+    //! An empty entry means reading the block failed.
+    std::map<uint256, std::vector<uint8_t>> mapReadBlocks;
 
     CNodeState(CAddress addrIn, std::string addrNameIn) : address(addrIn), name(addrNameIn) {
         fCurrentlyConnected = false;
@@ -382,6 +318,8 @@ struct CNodeState {
         nDownloadingSince = 0;
         nBlocksInFlight = 0;
         nBlocksInFlightValidHeaders = 0;
+        nAvgBlockDeliveryTime = 0;
+        nMaxBlocksInFlight = MAX_BLOCKS_IN_TRANSIT_PER_PEER;
         fPreferredDownload = false;
         fPreferHeaders = false;
         fPreferHeaderAndIDs = false;
@@ -392,9 +330,8 @@ struct CNodeState {
     }
 };
 
-// Keeps track of the time (in microseconds) when transactions were requested last time
-unordered_limitedmap<uint256, std::chrono::microseconds, StaticSaltedHasher> g_already_asked_for(MAX_INV_SZ, MAX_INV_SZ * 2);
-unordered_limitedmap<uint256, std::chrono::microseconds, StaticSaltedHasher> g_erased_object_requests(MAX_INV_SZ, MAX_INV_SZ * 2);
+/** Schedules GETDATA requests for announced transactions and Dash specific objects */
+static CObjectRequestScheduler objectRequestScheduler;
 
 /** Map maintaining per-node state. */
 static std::map<NodeId, CNodeState> mapNodeState GUARDED_BY(cs_main);
@@ -412,6 +349,7 @@ void UpdatePreferredDownload(CNode* node, CNodeState* state) EXCLUSIVE_LOCKS_REQ
 
     // Whether this node should be marked as a preferred download node.
     state->fPreferredDownload = (!node->fInbound || node->fWhitelisted) && !node->fOneShot && !node->fClient;
+    objectRequestScheduler.SetPreferred(node->GetId(), state->fPreferredDownload);
 
     nPreferredDownload += state->fPreferredDownload;
 }
@@ -451,9 +389,26 @@ void PushNodeVersion(CNode *pnode, CConnman* connman, int64_t nTime)
     }
 }
 
+// Update the measured delivery rate of a peer and derive its in-flight block limit from it, so that
+// peers on fast links are kept busy for BLOCK_DOWNLOAD_PIPELINE_TIME instead of a fixed number of blocks.
+static void UpdateBlockDeliveryTime(CNodeState* state, int64_t nDeliveryTime) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+    nDeliveryTime = std::max<int64_t>(nDeliveryTime, 1);
+    if (state->nAvgBlockDeliveryTime == 0) {
+        state->nAvgBlockDeliveryTime = nDeliveryTime;
+    } else {
+        state->nAvgBlockDeliveryTime = (state->nAvgBlockDeliveryTime * 7 + nDeliveryTime) / 8;
+    }
+    int64_t nLimit = BLOCK_DOWNLOAD_PIPELINE_TIME / state->nAvgBlockDeliveryTime;
+    nLimit = std::max<int64_t>(MAX_BLOCKS_IN_TRANSIT_PER_PEER, std::min<int64_t>(MAX_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER, nLimit));
+    nTotalMaxBlocksInFlight += nLimit - state->nMaxBlocksInFlight;
+    state->nMaxBlocksInFlight = nLimit;
+}
+
 // Returns a bool indicating whether we requested this block.
 // Also used if a block was /not/ received and timed out or started with another peer
-bool MarkBlockAsReceived(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+// nodeidFrom is the peer which delivered the block, if any. Only blocks delivered by the peer they
+// were requested from are used to measure its delivery rate.
+bool MarkBlockAsReceived(const uint256& hash, NodeId nodeidFrom = -1) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
     std::map<uint256, std::pair<NodeId, std::list<QueuedBlock>::iterator> >::iterator itInFlight = mapBlocksInFlight.find(hash);
     if (itInFlight != mapBlocksInFlight.end()) {
         CNodeState *state = State(itInFlight->second.first);
@@ -465,7 +420,11 @@ bool MarkBlockAsReceived(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
         }
         if (state->vBlocksInFlight.begin() == itInFlight->second.second) {
             // First block on the queue was received, update the start download time for the next one
-            state->nDownloadingSince = std::max(state->nDownloadingSince, GetTimeMicros());
+            int64_t nNow = GetTimeMicros();
+            if (itInFlight->second.first == nodeidFrom) {
+                UpdateBlockDeliveryTime(state, nNow - state->nDownloadingSince);
+            }
+            state->nDownloadingSince = std::max(state->nDownloadingSince, nNow);
         }
         state->vBlocksInFlight.erase(itInFlight->second.second);
         state->nBlocksInFlight--;
@@ -611,9 +570,18 @@ bool PeerHasHeader(CNodeState *state, const CBlockIndex *pindex) EXCLUSIVE_LOCKS
     return false;
 }
 
+/** Size of the block download window, which grows with the number of blocks our peers may have in flight,
+ *  so that faster peers aren't held back by the window before they're held back by their bandwidth. */
+unsigned int GetBlockDownloadWindow() EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    unsigned int nWindow = (unsigned int)nTotalMaxBlocksInFlight * BLOCK_DOWNLOAD_WINDOW_PER_IN_FLIGHT;
+    return std::max(BLOCK_DOWNLOAD_WINDOW, std::min(MAX_BLOCK_DOWNLOAD_WINDOW, nWindow));
+}
+
 /** Update pindexLastCommonBlock and add not-in-flight missing successors to vBlocks, until it has
- *  at most count entries. */
-void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, NodeId& nodeStaller, const Consensus::Params& consensusParams) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+ *  at most count entries. If nothing can be fetched because the download window is blocked by a block
+ *  in flight from another peer, that peer and block are returned in nodeStaller and pindexStalling. */
+void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, NodeId& nodeStaller, const CBlockIndex*& pindexStalling, const Consensus::Params& consensusParams) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
 {
     if (count == 0)
         return;
@@ -644,12 +612,13 @@ void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<con
 
     std::vector<const CBlockIndex*> vToFetch;
     const CBlockIndex *pindexWalk = state->pindexLastCommonBlock;
-    // Never fetch further than the best block we know the peer has, or more than BLOCK_DOWNLOAD_WINDOW + 1 beyond the last
+    // Never fetch further than the best block we know the peer has, or more than the download window + 1 beyond the last
     // linked block we have in common with this peer. The +1 is so we can detect stalling, namely if we would be able to
     // download that next block if the window were 1 larger.
-    int nWindowEnd = state->pindexLastCommonBlock->nHeight + BLOCK_DOWNLOAD_WINDOW;
+    int nWindowEnd = state->pindexLastCommonBlock->nHeight + GetBlockDownloadWindow();
     int nMaxHeight = std::min<int>(state->pindexBestKnownBlock->nHeight, nWindowEnd + 1);
     NodeId waitingfor = -1;
+    const CBlockIndex* pindexWaitingFor = nullptr;
     while (pindexWalk->nHeight < nMaxHeight) {
         // Read up to 128 (or more, if more blocks than that are needed) successors of pindexWalk (towards
         // pindexBestKnownBlock) into vToFetch. We fetch 128, because CBlockIndex::GetAncestor may be as expensive
@@ -681,6 +650,7 @@ void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<con
                     if (vBlocks.size() == 0 && waitingfor != nodeid) {
                         // We aren't able to fetch anything, but we would be if the download window was one larger.
                         nodeStaller = waitingfor;
+                        pindexStalling = pindexWaitingFor;
                     }
                     return;
                 }
@@ -691,151 +661,31 @@ void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<con
             } else if (waitingfor == -1) {
                 // This is the first already-in-flight block.
                 waitingfor = mapBlocksInFlight[pindex->GetBlockHash()].first;
+                pindexWaitingFor = pindex;
             }
         }
     }
 }
 } // namespace
 
-void EraseObjectRequest(CNodeState* nodestate, const CInv& inv) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
-{
-    AssertLockHeld(cs_main);
-    LogPrint(BCLog::NET, "%s -- inv=(%s)\n", __func__, inv.ToString());
-    g_already_asked_for.erase(inv.hash);
-    g_erased_object_requests.insert(std::make_pair(inv.hash, GetTime<std::chrono::microseconds>()));
-
-    if (nodestate) {
-        nodestate->m_object_download.m_object_announced.erase(inv);
-        nodestate->m_object_download.m_object_in_flight.erase(inv);
-    }
-}
-
-void EraseObjectRequest(NodeId nodeId, const CInv& inv) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+void EraseObjectRequest(NodeId nodeId, const CInv& inv)
 {
-    AssertLockHeld(cs_main);
-    auto* state = State(nodeId);
-    if (!state) {
-        return;
-    }
-    EraseObjectRequest(state, inv);
+    objectRequestScheduler.EraseObjectRequest(nodeId, inv);
 }
 
-std::chrono::microseconds GetObjectRequestTime(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+void RequestObject(NodeId nodeId, const CInv& inv, std::chrono::microseconds current_time, bool fForce)
 {
-    AssertLockHeld(cs_main);
-    auto it = g_already_asked_for.find(hash);
-    if (it != g_already_asked_for.end()) {
-        return it->second;
-    }
-    return {};
+    objectRequestScheduler.RequestObject(nodeId, inv, current_time, fForce);
 }
 
-void UpdateObjectRequestTime(const uint256& hash, std::chrono::microseconds request_time) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
-{
-    AssertLockHeld(cs_main);
-    auto it = g_already_asked_for.find(hash);
-    if (it == g_already_asked_for.end()) {
-        g_already_asked_for.insert(std::make_pair(hash, request_time));
-    } else {
-        g_already_asked_for.update(it, request_time);
-    }
-}
-
-std::chrono::microseconds GetObjectInterval(int invType)
-{
-    // some messages need to be re-requested faster when the first announcing peer did not answer to GETDATA
-    switch(invType)
-    {
-        case MSG_QUORUM_RECOVERED_SIG:
-            return std::chrono::seconds{15};
-        case MSG_CLSIG:
-            return std::chrono::seconds{5};
-        case MSG_ISLOCK:
-            return std::chrono::seconds{10};
-        default:
-            return GETDATA_TX_INTERVAL;
-    }
-}
-
-std::chrono::microseconds GetObjectExpiryInterval(int invType)
-{
-    return GetObjectInterval(invType) * TX_EXPIRY_INTERVAL_FACTOR;
-}
-
-std::chrono::microseconds GetObjectRandomDelay(int invType)
-{
-    if (invType == MSG_TX) {
-        return GetRandMicros(MAX_GETDATA_RANDOM_DELAY);
-    }
-    return {};
-}
-
-std::chrono::microseconds CalculateObjectGetDataTime(const CInv& inv, std::chrono::microseconds current_time, bool use_inbound_delay) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
-{
-    AssertLockHeld(cs_main);
-    std::chrono::microseconds process_time;
-    const auto last_request_time = GetObjectRequestTime(inv.hash);
-    // First time requesting this tx
-    if (last_request_time.count() == 0) {
-        process_time = current_time;
-    } else {
-        // Randomize the delay to avoid biasing some peers over others (such as due to
-        // fixed ordering of peer processing in ThreadMessageHandler)
-        process_time = last_request_time + GetObjectInterval(inv.type) + GetObjectRandomDelay(inv.type);
-    }
-
-    // We delay processing announcements from inbound peers
-    if (inv.type == MSG_TX && !fMasternodeMode && use_inbound_delay) process_time += INBOUND_PEER_TX_DELAY;
-
-    return process_time;
-}
-
-void RequestObject(CNodeState* state, const CInv& inv, std::chrono::microseconds current_time, bool fForce = false) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+size_t GetRequestedObjectCount(NodeId nodeId)
 {
-    AssertLockHeld(cs_main);
-    CNodeState::ObjectDownloadState& peer_download_state = state->m_object_download;
-    if (peer_download_state.m_object_announced.size() >= MAX_PEER_OBJECT_ANNOUNCEMENTS ||
-            peer_download_state.m_object_process_time.size() >= MAX_PEER_OBJECT_ANNOUNCEMENTS ||
-            peer_download_state.m_object_announced.count(inv)) {
-        // Too many queued announcements from this peer, or we already have
-        // this announcement
-        return;
-    }
-    peer_download_state.m_object_announced.insert(inv);
-
-    // Calculate the time to try requesting this transaction. Use
-    // fPreferredDownload as a proxy for outbound peers.
-    std::chrono::microseconds process_time = CalculateObjectGetDataTime(inv, current_time, !state->fPreferredDownload);
-
-    peer_download_state.m_object_process_time.emplace(process_time, inv);
-
-    if (fForce) {
-        // make sure this object is actually requested ASAP
-        g_erased_object_requests.erase(inv.hash);
-        g_already_asked_for.erase(inv.hash);
-    }
-
-    LogPrint(BCLog::NET, "%s -- inv=(%s), current_time=%d, process_time=%d, delta=%d\n", __func__, inv.ToString(), current_time.count(), process_time.count(), (process_time - current_time).count());
+    return objectRequestScheduler.GetScheduledCount(nodeId);
 }
 
-void RequestObject(NodeId nodeId, const CInv& inv, std::chrono::microseconds current_time, bool fForce) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+CObjectRequestScheduler::Stats GetObjectRequestStats()
 {
-    AssertLockHeld(cs_main);
-    auto* state = State(nodeId);
-    if (!state) {
-        return;
-    }
-    RequestObject(state, inv, current_time, fForce);
-}
-
-size_t GetRequestedObjectCount(NodeId nodeId)
-{
-    AssertLockHeld(cs_main);
-    auto* state = State(nodeId);
-    if (!state) {
-        return 0;
-    }
-    return state->m_object_download.m_object_process_time.size();
+    return objectRequestScheduler.GetStats();
 }
 
 // This function is used for testing the stale tip eviction logic, see
@@ -861,7 +711,9 @@ void PeerLogicValidation::InitializeNode(CNode *pnode) {
     {
         LOCK(cs_main);
         mapNodeState.emplace_hint(mapNodeState.end(), std::piecewise_construct, std::forward_as_tuple(nodeid), std::forward_as_tuple(addr, std::move(addrName)));
+        nTotalMaxBlocksInFlight += MAX_BLOCKS_IN_TRANSIT_PER_PEER;
     }
+    objectRequestScheduler.AddPeer(nodeid);
     if(!pnode->fInbound)
         PushNodeVersion(pnode, connman, GetTime());
 }
@@ -886,16 +738,20 @@ void PeerLogicValidation::FinalizeNode(NodeId nodeid, bool& fUpdateConnectionTim
     nPreferredDownload -= state->fPreferredDownload;
     nPeersWithValidatedDownloads -= (state->nBlocksInFlightValidHeaders != 0);
     assert(nPeersWithValidatedDownloads >= 0);
+    nTotalMaxBlocksInFlight -= state->nMaxBlocksInFlight;
+    assert(nTotalMaxBlocksInFlight >= 0);
     g_outbound_peers_with_protect_from_disconnect -= state->m_chain_sync.m_protect;
     assert(g_outbound_peers_with_protect_from_disconnect >= 0);
 
     mapNodeState.erase(nodeid);
+    objectRequestScheduler.RemovePeer(nodeid);
 
     if (mapNodeState.empty()) {
         // Do a consistency check after the last peer is removed.
         assert(mapBlocksInFlight.empty());
         assert(nPreferredDownload == 0);
         assert(nPeersWithValidatedDownloads == 0);
+        assert(nTotalMaxBlocksInFlight == 0);
         assert(g_outbound_peers_with_protect_from_disconnect == 0);
     }
     LogPrint(BCLog::NET, "Cleared nodestate for peer=%d\n", nodeid);
@@ -909,6 +765,7 @@ bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats) {
     stats.nMisbehavior = state->nMisbehavior;
     stats.nSyncHeight = state->pindexBestKnownBlock ? state->pindexBestKnownBlock->nHeight : -1;
     stats.nCommonHeight = state->pindexLastCommonBlock ? state->pindexLastCommonBlock->nHeight : -1;
+    stats.nMaxBlocksInFlight = state->nMaxBlocksInFlight;
     for (const QueuedBlock& queue : state->vBlocksInFlight) {
         if (queue.pindex)
             stats.vHeightInFlight.push_back(queue.pindex->nHeight);
@@ -1121,7 +978,7 @@ PeerLogicValidation::PeerLogicValidation(CConnman* connmanIn, CScheduler &schedu
     // combine them in one function and schedule at the quicker (peer-eviction)
     // timer.
     static_assert(EXTRA_PEER_CHECK_INTERVAL < STALE_CHECK_INTERVAL, "peer eviction timer should be less than stale tip check timer");
-    scheduler.scheduleEvery(std::bind(&PeerLogicValidation::CheckForStaleTipAndEvictPeers, this, consensusParams), EXTRA_PEER_CHECK_INTERVAL * 1000);
+    scheduler.scheduleEvery(std::bind(&PeerLogicValidation::CheckForStaleTipAndEvictPeers, this, consensusParams), EXTRA_PEER_CHECK_INTERVAL * 1000, "staletip");
 }
 
 /**
@@ -1179,7 +1036,43 @@ void PeerLogicValidation::BlockConnected(const std::shared_ptr<const CBlock>& pb
 static CCriticalSection cs_most_recent_block;
 static std::shared_ptr<const CBlock> most_recent_block GUARDED_BY(cs_most_recent_block);
 static std::shared_ptr<const CBlockHeaderAndShortTxIDs> most_recent_compact_block GUARDED_BY(cs_most_recent_block);
-static uint256 most_recent_block_hash GUARDED_BY(cs_most_recent_block);
+
+/** A recently connected block together with its encodings, which are built once and then served to all peers */
+struct CRecentBlock {
+    uint256 hash;
+    std::shared_ptr<const CBlock> block;
+    std::shared_ptr<const CBlockHeaderAndShortTxIDs> cmpctblock;
+    //! The block as sent in a BLOCK message
+    std::shared_ptr<const std::vector<uint8_t>> serialized;
+};
+/** Number of recent tips which are kept in recent_blocks */
+static const size_t MAX_RECENT_BLOCKS = 4;
+//! Most recently used first
+static std::list<CRecentBlock> recent_blocks GUARDED_BY(cs_most_recent_block);
+
+static void AddRecentBlock(const std::shared_ptr<const CBlock>& pblock, const std::shared_ptr<const CBlockHeaderAndShortTxIDs>& pcmpctblock) EXCLUSIVE_LOCKS_REQUIRED(cs_most_recent_block)
+{
+    auto serialized = std::make_shared<std::vector<uint8_t>>();
+    CVectorWriter(SER_NETWORK, PROTOCOL_VERSION, *serialized, 0) << *pblock;
+
+    recent_blocks.push_front(CRecentBlock{pblock->GetHash(), pblock, pcmpctblock, std::move(serialized)});
+    while (recent_blocks.size() > MAX_RECENT_BLOCKS) {
+        recent_blocks.pop_back();
+    }
+}
+
+static bool GetRecentBlock(const uint256& hash, CRecentBlock& ret)
+{
+    LOCK(cs_most_recent_block);
+    for (auto it = recent_blocks.begin(); it != recent_blocks.end(); ++it) {
+        if (it->hash == hash) {
+            recent_blocks.splice(recent_blocks.begin(), recent_blocks, it);
+            ret = recent_blocks.front();
+            return true;
+        }
+    }
+    return false;
+}
 
 /**
  * Maintain state about the best-seen block and fast-announce a compact block
@@ -1200,14 +1093,15 @@ void PeerLogicValidation::NewPoWValidBlock(const CBlockIndex *pindex, const std:
 
     {
         LOCK(cs_most_recent_block);
-        most_recent_block_hash = hashBlock;
         most_recent_block = pblock;
         most_recent_compact_block = pcmpctblock;
+        AddRecentBlock(pblock, pcmpctblock);
     }
 
-    connman->ForEachNode([this, &pcmpctblock, pindex, &msgMaker, &hashBlock](CNode* pnode) {
+    // serialized lazily, only if at least one peer gets the announcement
+    CSharedSerializedNetMsgRef cmpctBlockMsg;
+    connman->ForEachNode([this, &pcmpctblock, pindex, &msgMaker, &hashBlock, &cmpctBlockMsg](CNode* pnode) {
         AssertLockHeld(cs_main);
-        // TODO: Avoid the repeated-serialization here
         if (pnode->fDisconnect)
             return;
         ProcessBlockAvailability(pnode->GetId());
@@ -1219,7 +1113,10 @@ void PeerLogicValidation::NewPoWValidBlock(const CBlockIndex *pindex, const std:
 
             LogPrint(BCLog::NET, "%s sending header-and-ids %s to peer=%d\n", "PeerLogicValidation::NewPoWValidBlock",
                     hashBlock.ToString(), pnode->GetId());
-            connman->PushMessage(pnode, msgMaker.Make(NetMsgType::CMPCTBLOCK, *pcmpctblock));
+            if (!cmpctBlockMsg) {
+                cmpctBlockMsg = CConnman::MakeSharedMessage(msgMaker.Make(NetMsgType::CMPCTBLOCK, *pcmpctblock));
+            }
+            connman->PushMessage(pnode, cmpctBlockMsg);
             state.pindexBestHeaderSent = pindex;
         }
     });
@@ -1307,6 +1204,62 @@ void PeerLogicValidation::BlockChecked(const CBlock& block, const CValidationSta
 //
 
 
+/** Inventory types AlreadyHave answers from chain state, the mempool or recent rejects, which requires cs_main */
+static bool IsChainStateInvType(int type)
+{
+    return type == MSG_TX || type == MSG_DSTX || type == MSG_LEGACY_TXLOCK_REQUEST || type == MSG_BLOCK;
+}
+
+/**
+ * AlreadyHave for all other (Dash specific) inventory types. These are answered by the responsible managers under their
+ * own locks, so cs_main is not needed. Note that this is not free of side effects for governance objects and votes,
+ * which are marked as requested if we don't have them yet.
+ */
+static bool AlreadyHaveObject(const CInv& inv)
+{
+    assert(!IsChainStateInvType(inv.type));
+
+    switch (inv.type)
+    {
+    /*
+        Dash Related Inventory Messages
+
+        --
+
+        We shouldn't update the sync times for each of the messages when we already have it.
+        We're going to be asking many nodes upfront for the full inventory list, so we'll get duplicates of these.
+        We want to only update the time on new hits, so that we can time out appropriately if needed.
+    */
+
+    case MSG_SPORK:
+        {
+            CSporkMessage spork;
+            return sporkManager.GetSporkByHash(inv.hash, spork);
+        }
+
+    case MSG_GOVERNANCE_OBJECT:
+    case MSG_GOVERNANCE_OBJECT_VOTE:
+        return ! governance.ConfirmInventoryRequest(inv);
+
+    case MSG_QUORUM_FINAL_COMMITMENT:
+        return llmq::quorumBlockProcessor->HasMinableCommitment(inv.hash);
+    case MSG_QUORUM_CONTRIB:
+    case MSG_QUORUM_COMPLAINT:
+    case MSG_QUORUM_JUSTIFICATION:
+    case MSG_QUORUM_PREMATURE_COMMITMENT:
+        return llmq::quorumDKGSessionManager->AlreadyHave(inv);
+    case MSG_QUORUM_RECOVERED_SIG:
+        return llmq::quorumSigningManager->AlreadyHave(inv);
+    case MSG_CLSIG:
+        return llmq::chainLocksHandler->AlreadyHave(inv);
+    case MSG_ISLOCK:
+        return llmq::quorumInstantSendManager->AlreadyHave(inv);
+    }
+
+    // Don't know what it is, just say we already got one
+    return true;
+}
+
 bool static AlreadyHave(const CInv& inv) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
 {
     switch (inv.type)
@@ -1355,44 +1308,9 @@ bool static AlreadyHave(const CInv& inv) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
 
     case MSG_BLOCK:
         return LookupBlockIndex(inv.hash) != nullptr;
-
-    /*
-        Dash Related Inventory Messages
-
-        --
-
-        We shouldn't update the sync times for each of the messages when we already have it.
-        We're going to be asking many nodes upfront for the full inventory list, so we'll get duplicates of these.
-        We want to only update the time on new hits, so that we can time out appropriately if needed.
-    */
-
-    case MSG_SPORK:
-        {
-            CSporkMessage spork;
-            return sporkManager.GetSporkByHash(inv.hash, spork);
-        }
-
-    case MSG_GOVERNANCE_OBJECT:
-    case MSG_GOVERNANCE_OBJECT_VOTE:
-        return ! governance.ConfirmInventoryRequest(inv);
-
-    case MSG_QUORUM_FINAL_COMMITMENT:
-        return llmq::quorumBlockProcessor->HasMinableCommitment(inv.hash);
-    case MSG_QUORUM_CONTRIB:
-    case MSG_QUORUM_COMPLAINT:
-    case MSG_QUORUM_JUSTIFICATION:
-    case MSG_QUORUM_PREMATURE_COMMITMENT:
-        return llmq::quorumDKGSessionManager->AlreadyHave(inv);
-    case MSG_QUORUM_RECOVERED_SIG:
-        return llmq::quorumSigningManager->AlreadyHave(inv);
-    case MSG_CLSIG:
-        return llmq::chainLocksHandler->AlreadyHave(inv);
-    case MSG_ISLOCK:
-        return llmq::quorumInstantSendManager->AlreadyHave(inv);
     }
 
-    // Don't know what it is, just say we already got one
-    return true;
+    return AlreadyHaveObject(inv);
 }
 
 static void RelayAddress(const CAddress& addr, bool fReachable, CConnman* connman)
@@ -1431,13 +1349,82 @@ static void RelayAddress(const CAddress& addr, bool fReachable, CConnman* connma
     connman->ForEachNodeThen(std::move(sortfunc), std::move(pushfunc));
 }
 
-void static ProcessGetBlockData(CNode* pfrom, const CChainParams& chainparams, const CInv& inv, CConnman* connman)
+/**
+ * Sends a block from disk without deserializing it first. If the block wasn't read yet, it's read on a block read
+ * thread together with the blocks in vReadAhead and false is returned, ProcessGetData must then be retried once
+ * pfrom->fGetDataBlockReadPending was cleared.
+ */
+static bool PushRawBlockFromDisk(CNode* pfrom, const CChainParams& chainparams, const CBlockIndex* pindex, const std::vector<uint256>& vReadAhead, CConnman* connman) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    CNodeState* nodestate = State(pfrom->GetId());
+    std::vector<uint8_t> vData;
+    auto it = nodestate->mapReadBlocks.find(pindex->GetBlockHash());
+    if (it != nodestate->mapReadBlocks.end()) {
+        vData = std::move(it->second);
+        nodestate->mapReadBlocks.erase(it);
+    } else {
+        std::vector<std::pair<uint256, CDiskBlockPos>> vToRead;
+        vToRead.emplace_back(pindex->GetBlockHash(), pindex->GetBlockPos());
+        for (const auto& hash : vReadAhead) {
+            const CBlockIndex* pindexReadAhead = LookupBlockIndex(hash);
+            if (pindexReadAhead && (pindexReadAhead->nStatus & BLOCK_HAVE_DATA) && !nodestate->mapReadBlocks.count(hash)) {
+                vToRead.emplace_back(hash, pindexReadAhead->GetBlockPos());
+            }
+        }
+
+        pfrom->fGetDataBlockReadPending = true;
+        bool fDispatched = connman->RunOnBlockReadWorker(pfrom, [pfrom, vToRead, &chainparams, connman]() {
+            std::vector<std::pair<uint256, std::vector<uint8_t>>> vRead;
+            for (const auto& p : vToRead) {
+                std::vector<uint8_t> vBlock;
+                if (!ReadRawBlockFromDisk(vBlock, p.second, chainparams.MessageStart())) {
+                    vBlock.clear();
+                }
+                vRead.emplace_back(p.first, std::move(vBlock));
+            }
+            {
+                LOCK(cs_main);
+                CNodeState* state = State(pfrom->GetId());
+                if (state) {
+                    for (auto& p : vRead) {
+                        state->mapReadBlocks[p.first] = std::move(p.second);
+                    }
+                }
+            }
+            pfrom->fGetDataBlockReadPending = false;
+            connman->WakeMessageHandler();
+        });
+        if (fDispatched) {
+            return false;
+        }
+        pfrom->fGetDataBlockReadPending = false;
+    }
+
+    // Block read threads are disabled or the asynchronous read failed, read it here
+    if (vData.empty() && !ReadRawBlockFromDisk(vData, pindex->GetBlockPos(), chainparams.MessageStart())) {
+        assert(!"cannot load block from disk");
+    }
+    CSerializedNetMsg msg;
+    msg.command = NetMsgType::BLOCK;
+    msg.data = std::move(vData);
+    connman->PushMessage(pfrom, std::move(msg));
+    return true;
+}
+
+/** Returns false if the block is read from disk asynchronously and the request must be processed again later */
+bool static ProcessGetBlockData(CNode* pfrom, const CChainParams& chainparams, const CInv& inv, const std::vector<uint256>& vReadAhead, CConnman* connman)
 {
     bool send = false;
     std::shared_ptr<const CBlock> a_recent_block;
     std::shared_ptr<const CBlockHeaderAndShortTxIDs> a_recent_compact_block;
+    std::shared_ptr<const std::vector<uint8_t>> a_recent_serialized_block;
     const Consensus::Params& consensusParams = chainparams.GetConsensus();
-    {
+    CRecentBlock recentBlock;
+    if (GetRecentBlock(inv.hash, recentBlock)) {
+        a_recent_block = recentBlock.block;
+        a_recent_compact_block = recentBlock.cmpctblock;
+        a_recent_serialized_block = recentBlock.serialized;
+    } else {
         LOCK(cs_most_recent_block);
         a_recent_block = most_recent_block;
         a_recent_compact_block = most_recent_compact_block;
@@ -1500,8 +1487,19 @@ void static ProcessGetBlockData(CNode* pfrom, const CChainParams& chainparams, c
     if (send && (pindex->nStatus & BLOCK_HAVE_DATA))
     {
         std::shared_ptr<const CBlock> pblock;
-        if (a_recent_block && a_recent_block->GetHash() == pindex->GetBlockHash()) {
+        if (a_recent_serialized_block && inv.type == MSG_BLOCK) {
+            // Serialized once when the block was connected, only needs to be copied into the send buffer
+            CSerializedNetMsg msg;
+            msg.command = NetMsgType::BLOCK;
+            msg.data = *a_recent_serialized_block;
+            connman->PushMessage(pfrom, std::move(msg));
+        } else if (a_recent_block && a_recent_block->GetHash() == pindex->GetBlockHash()) {
             pblock = a_recent_block;
+        } else if (inv.type == MSG_BLOCK) {
+            // Plain blocks are sent as stored on disk, no need to deserialize them
+            if (!PushRawBlockFromDisk(pfrom, chainparams, pindex, vReadAhead, connman)) {
+                return false;
+            }
         } else {
             // Send block from disk
             std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
@@ -1574,12 +1572,17 @@ void static ProcessGetBlockData(CNode* pfrom, const CChainParams& chainparams, c
             pfrom->hashContinue.SetNull();
         }
     }
+    return true;
 }
 
 void static ProcessGetData(CNode* pfrom, const CChainParams& chainparams, CConnman* connman, const std::atomic<bool>& interruptMsgProc)
 {
     AssertLockNotHeld(cs_main);
 
+    // Keep the order of responses while a requested block is read from disk
+    if (pfrom->fGetDataBlockReadPending)
+        return;
+
     std::deque<CInv>::iterator it = pfrom->vRecvGetData.begin();
     std::vector<CInv> vNotFound;
     const CNetMsgMaker msgMaker(pfrom->GetSendVersion());
@@ -1606,12 +1609,12 @@ void static ProcessGetData(CNode* pfrom, const CChainParams& chainparams, CConnm
                 if (inv.type == MSG_DSTX) {
                     dstx = CCoinJoin::GetDSTX(inv.hash);
                 }
-                auto mi = mapRelay.find(inv.hash);
-                if (mi != mapRelay.end()) {
+                CTransactionRef txRelayed = txRelayCache.Get(inv.hash);
+                if (txRelayed) {
                     if (dstx) {
                         connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::DSTX, dstx));
                     } else {
-                        connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::TX, *mi->second));
+                        connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::TX, *txRelayed));
                     }
                     push = true;
                 } else if (pfrom->timeLastMempoolReq) {
@@ -1742,13 +1745,26 @@ void static ProcessGetData(CNode* pfrom, const CChainParams& chainparams, CConnm
     if (it != pfrom->vRecvGetData.end() && !pfrom->fPauseSend) {
         const CInv &inv = *it;
         if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK || inv.type == MSG_CMPCT_BLOCK) {
-            it++;
-            ProcessGetBlockData(pfrom, chainparams, inv, connman);
+            std::vector<uint256> vReadAhead;
+            for (auto itNext = std::next(it); itNext != pfrom->vRecvGetData.end() && vReadAhead.size() < MAX_GETDATA_BLOCK_READ_AHEAD; ++itNext) {
+                if (itNext->type == MSG_BLOCK) {
+                    vReadAhead.emplace_back(itNext->hash);
+                }
+            }
+            if (ProcessGetBlockData(pfrom, chainparams, inv, vReadAhead, connman)) {
+                it++;
+            }
         }
     }
 
     pfrom->vRecvGetData.erase(pfrom->vRecvGetData.begin(), it);
 
+    if (pfrom->vRecvGetData.empty()) {
+        // Drop blocks which were read ahead but not sent, e.g. because the peer wasn't allowed to request them
+        LOCK(cs_main);
+        State(pfrom->GetId())->mapReadBlocks.clear();
+    }
+
     if (!vNotFound.empty()) {
         // Let the peer know that we didn't find what it asked for, so it doesn't
         // have to wait around forever.
@@ -1793,6 +1809,10 @@ bool static ProcessHeadersMessage(CNode *pfrom, CConnman *connman, const std::ve
         return true;
     }
 
+    // Calculated without holding cs_main and (for large batches) in parallel, as X11 is expensive
+    std::vector<uint256> vHashes;
+    CalculateBlockHeaderHashes(headers, vHashes);
+
     bool received_new_header = false;
     const CBlockIndex *pindexLast = nullptr;
     {
@@ -1811,14 +1831,14 @@ bool static ProcessHeadersMessage(CNode *pfrom, CConnman *connman, const std::ve
             nodestate->nUnconnectingHeaders++;
             connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::GETHEADERS, chainActive.GetLocator(pindexBestHeader), uint256()));
             LogPrint(BCLog::NET, "received header %s: missing prev block %s, sending getheaders (%d) to end (peer=%d, nUnconnectingHeaders=%d)\n",
-                    headers[0].GetHash().ToString(),
+                    vHashes[0].ToString(),
                     headers[0].hashPrevBlock.ToString(),
                     pindexBestHeader->nHeight,
                     pfrom->GetId(), nodestate->nUnconnectingHeaders);
             // Set hashLastUnknownBlock for this peer, so that if we
             // eventually get the headers - even from a different peer -
             // we can use this peer to download.
-            UpdateBlockAvailability(pfrom->GetId(), headers.back().GetHash());
+            UpdateBlockAvailability(pfrom->GetId(), vHashes.back());
 
             if (nodestate->nUnconnectingHeaders % MAX_UNCONNECTING_HEADERS == 0) {
                 Misbehaving(pfrom->GetId(), 20);
@@ -1827,12 +1847,12 @@ bool static ProcessHeadersMessage(CNode *pfrom, CConnman *connman, const std::ve
         }
 
         uint256 hashLastBlock;
-        for (const CBlockHeader& header : headers) {
-            if (!hashLastBlock.IsNull() && header.hashPrevBlock != hashLastBlock) {
+        for (size_t i = 0; i < nCount; i++) {
+            if (!hashLastBlock.IsNull() && headers[i].hashPrevBlock != hashLastBlock) {
                 Misbehaving(pfrom->GetId(), 20, "non-continuous headers sequence");
                 return false;
             }
-            hashLastBlock = header.GetHash();
+            hashLastBlock = vHashes[i];
         }
 
         // If we don't have the last header, then they'll have given us
@@ -1844,7 +1864,7 @@ bool static ProcessHeadersMessage(CNode *pfrom, CConnman *connman, const std::ve
 
     CValidationState state;
     CBlockHeader first_invalid_header;
-    if (!ProcessNewBlockHeaders(headers, state, chainparams, &pindexLast, &first_invalid_header)) {
+    if (!ProcessNewBlockHeaders(headers, state, chainparams, &pindexLast, &first_invalid_header, &vHashes)) {
         int nDoS;
         if (state.IsInvalid(nDoS)) {
             LOCK(cs_main);
@@ -1925,7 +1945,7 @@ bool static ProcessHeadersMessage(CNode *pfrom, CConnman *connman, const std::ve
             std::vector<const CBlockIndex*> vToFetch;
             const CBlockIndex *pindexWalk = pindexLast;
             // Calculate all the blocks we'd need to switch to pindexLast, up to a limit.
-            while (pindexWalk && !chainActive.Contains(pindexWalk) && vToFetch.size() <= MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+            while (pindexWalk && !chainActive.Contains(pindexWalk) && vToFetch.size() <= (size_t)nodestate->nMaxBlocksInFlight) {
                 if (!(pindexWalk->nStatus & BLOCK_HAVE_DATA) &&
                         !mapBlocksInFlight.count(pindexWalk->GetBlockHash())) {
                     // We don't have this block, and it's not yet in flight.
@@ -1945,7 +1965,7 @@ bool static ProcessHeadersMessage(CNode *pfrom, CConnman *connman, const std::ve
                 std::vector<CInv> vGetData;
                 // Download as much as possible, from earliest to latest.
                 for (const CBlockIndex *pindex : reverse_iterate(vToFetch)) {
-                    if (nodestate->nBlocksInFlight >= MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+                    if (nodestate->nBlocksInFlight >= nodestate->nMaxBlocksInFlight) {
                         // Can't download any more from this peer
                         break;
                     }
@@ -2007,8 +2027,13 @@ void static ProcessOrphanTx(CConnman* connman, std::set<uint256>& orphan_work_se
     AssertLockHeld(cs_main);
     AssertLockHeld(g_cs_orphans);
     std::set<NodeId> setMisbehaving;
-    bool done = false;
-    while (!done && !orphan_work_set.empty()) {
+    // One coins view for the whole batch, used to skip orphans which still miss a parent without running them
+    // through AcceptToMemoryPool. Coins which aren't found are not cached, so outputs of orphans accepted earlier
+    // in the batch are visible to their children.
+    CCoinsViewMemPool viewMemPool(pcoinsTip.get(), mempool);
+    CCoinsViewCache view(&viewMemPool);
+    unsigned int nAttempted = 0;
+    while (nAttempted < MAX_ORPHAN_TX_BATCH_SIZE && !orphan_work_set.empty()) {
         const uint256 orphanHash = *orphan_work_set.begin();
         orphan_work_set.erase(orphan_work_set.begin());
 
@@ -2025,6 +2050,14 @@ void static ProcessOrphanTx(CConnman* connman, std::set<uint256>& orphan_work_se
         CValidationState stateDummy;
 
         if (setMisbehaving.count(fromPeer)) continue;
+        bool fHaveInputs = std::all_of(orphanTx.vin.begin(), orphanTx.vin.end(), [&](const CTxIn& txin) {
+            return view.HaveCoin(txin.prevout);
+        });
+        if (!fHaveInputs) {
+            // Still an orphan, it's retried when one of its other parents arrives
+            continue;
+        }
+        nAttempted++;
         if (AcceptToMemoryPool(mempool, stateDummy, porphanTx, &fMissingInputs2 /* pfMissingInputs */,
                 false /* bypass_limits */, 0 /* nAbsurdFee */)) {
             LogPrint(BCLog::MEMPOOL, "   accepted orphan tx %s\n", orphanHash.ToString());
@@ -2038,7 +2071,6 @@ void static ProcessOrphanTx(CConnman* connman, std::set<uint256>& orphan_work_se
                 }
             }
             EraseOrphanTx(orphanHash);
-            done = true;
         } else if (!fMissingInputs2) {
             int nDos = 0;
             if (stateDummy.IsInvalid(nDos) && nDos > 0) {
@@ -2055,8 +2087,10 @@ void static ProcessOrphanTx(CConnman* connman, std::set<uint256>& orphan_work_se
                 recentRejects->insert(orphanHash);
             }
             EraseOrphanTx(orphanHash);
-            done = true;
         }
+    }
+    if (nAttempted > 0) {
+        LogPrint(BCLog::MEMPOOL, "Processed %u orphans, %u left in work set\n", nAttempted, orphan_work_set.size());
         mempool.check(pcoinsTip.get());
     }
 }
@@ -2080,6 +2114,206 @@ std::string RejectCodeToString(const unsigned char code)
     return "";
 }
 
+/** Maximum number of compact filters that may be requested with one getcfilters. See BIP 157. */
+static constexpr uint32_t MAX_GETCFILTERS_SIZE = 1000;
+/** Maximum number of cf hashes that may be requested with one getcfheaders. See BIP 157. */
+static constexpr uint32_t MAX_GETCFHEADERS_SIZE = 2000;
+/** Interval between compact filter checkpoints. See BIP 157. */
+static constexpr int CFCHECKPT_INTERVAL = 1000;
+
+/**
+ * Validates a request for compact filters (getcfilters, getcfheaders or getcfcheckpt) and looks
+ * up the index and the stop block. Disconnects the peer if the request is not one we would serve.
+ *
+ * @param[in]   pfrom           The peer that we received the request from
+ * @param[in]   chainparams     Chain parameters
+ * @param[in]   filter_type     The filter type the request is for. Must have a running index.
+ * @param[in]   start_height    The start height for the request
+ * @param[in]   stop_hash       The stop_hash for the request
+ * @param[in]   max_height_diff The maximum number of items permitted to request, as specified in BIP 157
+ * @param[out]  stop_index      The CBlockIndex for the stop_hash block, if the request can be serviced.
+ * @param[out]  filter_index    The filter index, if the request can be serviced.
+ * @return                      True if the request can be serviced.
+ */
+static bool PrepareBlockFilterRequest(CNode* pfrom, const CChainParams& chainparams,
+                                      BlockFilterType filter_type, uint32_t start_height,
+                                      const uint256& stop_hash, uint32_t max_height_diff,
+                                      const CBlockIndex*& stop_index,
+                                      BlockFilterIndex*& filter_index)
+{
+    // Besides the basic filters, which NODE_COMPACT_FILTERS guarantees, serve every other type with an enabled index
+    filter_index = GetBlockFilterIndex(filter_type);
+    const bool supported_filter_type =
+        (filter_index != nullptr &&
+         (pfrom->GetLocalServices() & NODE_COMPACT_FILTERS));
+    if (!supported_filter_type) {
+        LogPrint(BCLog::NET, "peer %d requested unsupported block filter type: %d\n",
+                 pfrom->GetId(), static_cast<uint8_t>(filter_type));
+        pfrom->fDisconnect = true;
+        return false;
+    }
+
+    {
+        LOCK(cs_main);
+        stop_index = LookupBlockIndex(stop_hash);
+
+        // Check that the stop block exists and the peer would be allowed to fetch it.
+        if (!stop_index || !BlockRequestAllowed(stop_index, chainparams.GetConsensus())) {
+            LogPrint(BCLog::NET, "peer %d requested invalid block hash: %s\n",
+                     pfrom->GetId(), stop_hash.ToString());
+            pfrom->fDisconnect = true;
+            return false;
+        }
+    }
+
+    uint32_t stop_height = stop_index->nHeight;
+    if (start_height > stop_height) {
+        LogPrint(BCLog::NET, "peer %d sent invalid getcfilters/getcfheaders with "
+                 "start height %d and stop height %d\n",
+                 pfrom->GetId(), start_height, stop_height);
+        pfrom->fDisconnect = true;
+        return false;
+    }
+    if (stop_height - start_height >= max_height_diff) {
+        LogPrint(BCLog::NET, "peer %d requested too many cfilters/cfheaders: %d / %d\n",
+                 pfrom->GetId(), stop_height - start_height + 1, max_height_diff);
+        pfrom->fDisconnect = true;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Handle a cfilters request.
+ *
+ * May disconnect from the peer in the case of a bad request.
+ */
+static void ProcessGetCFilters(CNode* pfrom, CDataStream& vRecv, const CChainParams& chainparams,
+                               CConnman* connman)
+{
+    uint8_t filter_type_ser;
+    uint32_t start_height;
+    uint256 stop_hash;
+
+    vRecv >> filter_type_ser >> start_height >> stop_hash;
+
+    const BlockFilterType filter_type = static_cast<BlockFilterType>(filter_type_ser);
+
+    const CBlockIndex* stop_index;
+    BlockFilterIndex* filter_index;
+    if (!PrepareBlockFilterRequest(pfrom, chainparams, filter_type, start_height, stop_hash,
+                                   MAX_GETCFILTERS_SIZE, stop_index, filter_index)) {
+        return;
+    }
+
+    std::vector<BlockFilter> filters;
+    if (!filter_index->LookupFilterRange(start_height, stop_index, filters)) {
+        LogPrint(BCLog::NET, "Failed to find block filter in index: filter_type=%s, start_height=%d, stop_hash=%s\n",
+                 BlockFilterTypeName(filter_type), start_height, stop_hash.ToString());
+        return;
+    }
+
+    const CNetMsgMaker msgMaker(pfrom->GetSendVersion());
+    for (const auto& filter : filters) {
+        connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::CFILTER, filter));
+    }
+}
+
+/**
+ * Handle a cfheaders request.
+ *
+ * May disconnect from the peer in the case of a bad request.
+ */
+static void ProcessGetCFHeaders(CNode* pfrom, CDataStream& vRecv, const CChainParams& chainparams,
+                                CConnman* connman)
+{
+    uint8_t filter_type_ser;
+    uint32_t start_height;
+    uint256 stop_hash;
+
+    vRecv >> filter_type_ser >> start_height >> stop_hash;
+
+    const BlockFilterType filter_type = static_cast<BlockFilterType>(filter_type_ser);
+
+    const CBlockIndex* stop_index;
+    BlockFilterIndex* filter_index;
+    if (!PrepareBlockFilterRequest(pfrom, chainparams, filter_type, start_height, stop_hash,
+                                   MAX_GETCFHEADERS_SIZE, stop_index, filter_index)) {
+        return;
+    }
+
+    uint256 prev_header;
+    if (start_height > 0) {
+        const CBlockIndex* const prev_block =
+            stop_index->GetAncestor(static_cast<int>(start_height - 1));
+        if (!filter_index->LookupFilterHeader(prev_block, prev_header)) {
+            LogPrint(BCLog::NET, "Failed to find block filter header in index: filter_type=%s, block_hash=%s\n",
+                     BlockFilterTypeName(filter_type), prev_block->GetBlockHash().ToString());
+            return;
+        }
+    }
+
+    std::vector<uint256> filter_hashes;
+    if (!filter_index->LookupFilterHashRange(start_height, stop_index, filter_hashes)) {
+        LogPrint(BCLog::NET, "Failed to find block filter hashes in index: filter_type=%s, start_height=%d, stop_hash=%s\n",
+                 BlockFilterTypeName(filter_type), start_height, stop_hash.ToString());
+        return;
+    }
+
+    const CNetMsgMaker msgMaker(pfrom->GetSendVersion());
+    connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::CFHEADERS,
+                                              filter_type_ser,
+                                              stop_index->GetBlockHash(),
+                                              prev_header,
+                                              filter_hashes));
+}
+
+/**
+ * Handle a getcfcheckpt request.
+ *
+ * May disconnect from the peer in the case of a bad request.
+ */
+static void ProcessGetCFCheckPt(CNode* pfrom, CDataStream& vRecv, const CChainParams& chainparams,
+                                CConnman* connman)
+{
+    uint8_t filter_type_ser;
+    uint256 stop_hash;
+
+    vRecv >> filter_type_ser >> stop_hash;
+
+    const BlockFilterType filter_type = static_cast<BlockFilterType>(filter_type_ser);
+
+    const CBlockIndex* stop_index;
+    BlockFilterIndex* filter_index;
+    if (!PrepareBlockFilterRequest(pfrom, chainparams, filter_type, /*start_height=*/0, stop_hash,
+                                   /*max_height_diff=*/std::numeric_limits<uint32_t>::max(),
+                                   stop_index, filter_index)) {
+        return;
+    }
+
+    std::vector<uint256> headers(stop_index->nHeight / CFCHECKPT_INTERVAL);
+
+    // Populate headers.
+    const CBlockIndex* block_index = stop_index;
+    for (int i = headers.size() - 1; i >= 0; i--) {
+        int height = (i + 1) * CFCHECKPT_INTERVAL;
+        block_index = block_index->GetAncestor(height);
+
+        if (!filter_index->LookupFilterHeader(block_index, headers[i])) {
+            LogPrint(BCLog::NET, "Failed to find block filter header in index: filter_type=%s, block_hash=%s\n",
+                     BlockFilterTypeName(filter_type), block_index->GetBlockHash().ToString());
+            return;
+        }
+    }
+
+    const CNetMsgMaker msgMaker(pfrom->GetSendVersion());
+    connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::CFCHECKPT,
+                                              filter_type_ser,
+                                              stop_index->GetBlockHash(),
+                                              headers));
+}
+
 bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, int64_t nTimeReceived, const CChainParams& chainparams, CConnman* connman, const std::atomic<bool>& interruptMsgProc, bool enable_bip61)
 {
     LogPrint(BCLog::NET, "received: %s (%u bytes) peer=%d\n", SanitizeString(strCommand), vRecv.size(), pfrom->GetId());
@@ -2386,6 +2620,13 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::QWATCH));
         }
 
+        if (pfrom->nVersion >= COMPACT_HEADER_PROTO_VERSION) {
+            // Tell our peer that it can send us compact message headers. The peer can only start doing so after it
+            // received this message, so it's safe to accept them right away
+            pfrom->fRecvCompactHeaders = true;
+            connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::SENDCMPCTHDR, GetShortNetMsgTypeCount()));
+        }
+
         pfrom->fSuccessfullyConnected = true;
         return true;
     }
@@ -2489,6 +2730,15 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
     }
 
 
+    if (strCommand == NetMsgType::SENDCMPCTHDR) {
+        uint8_t nShortIds;
+        vRecv >> nShortIds;
+        // ids we don't know are never used, see CConnman::SerializeCompactMessageHeader
+        pfrom->nSendCompactHeaderIds = nShortIds;
+        return true;
+    }
+
+
     if (strCommand == NetMsgType::QSENDRECSIGS) {
         bool b;
         vRecv >> b;
@@ -2512,10 +2762,10 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         if (pfrom->fWhitelisted && gArgs.GetBoolArg("-whitelistrelay", DEFAULT_WHITELISTRELAY))
             fBlocksOnly = false;
 
-        LOCK(cs_main);
-
-        const auto current_time = GetTime<std::chrono::microseconds>();
-
+        // Dash objects are looked up without cs_main first. During INV floods most of them are already known and
+        // handled right here, cs_main is then only needed for blocks, transactions and objects we want to request
+        std::vector<std::pair<CInv, bool>> vInvToProcess; // inv, fAlreadyHave (unknown yet for chain state invs)
+        vInvToProcess.reserve(vInv.size());
         for (CInv &inv : vInv)
         {
             if(!inv.IsKnownType()) {
@@ -2526,7 +2776,40 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             if (interruptMsgProc)
                 return true;
 
-            bool fAlreadyHave = AlreadyHave(inv);
+            if (IsChainStateInvType(inv.type)) {
+                vInvToProcess.emplace_back(inv, false);
+                continue;
+            }
+            // must only be called once per inv, see AlreadyHaveObject
+            bool fAlreadyHave = AlreadyHaveObject(inv);
+            if (!fAlreadyHave) {
+                vInvToProcess.emplace_back(inv, false);
+                continue;
+            }
+            LogPrint(BCLog::NET, "got inv: %s  have peer=%d\n", inv.ToString(), pfrom->GetId());
+            statsClient.inc(strprintf("message.received.inv_%s", inv.GetCommand()), 1.0f);
+            pfrom->AddInventoryKnown(inv);
+            if (fBlocksOnly) {
+                LogPrint(BCLog::NET, "transaction (%s) inv sent in violation of protocol peer=%d\n", inv.hash.ToString(),
+                         pfrom->GetId());
+            }
+        }
+        if (vInvToProcess.empty()) {
+            return true;
+        }
+
+        LOCK(cs_main);
+
+        const auto current_time = GetTime<std::chrono::microseconds>();
+
+        for (auto& p : vInvToProcess)
+        {
+            CInv& inv = p.first;
+
+            if (interruptMsgProc)
+                return true;
+
+            bool fAlreadyHave = IsChainStateInvType(inv.type) ? AlreadyHave(inv) : p.second;
             LogPrint(BCLog::NET, "got inv: %s  %s peer=%d\n", inv.ToString(), fAlreadyHave ? "have" : "new", pfrom->GetId());
             statsClient.inc(strprintf("message.received.inv_%s", inv.GetCommand()), 1.0f);
 
@@ -2572,7 +2855,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                 } else if (!fAlreadyHave) {
                     bool allowWhileInIBD = allowWhileInIBDObjs.count(inv.type);
                     if (allowWhileInIBD || (!fImporting && !fReindex && !IsInitialBlockDownload())) {
-                        RequestObject(State(pfrom->GetId()), inv, current_time);
+                        RequestObject(pfrom->GetId(), inv, current_time);
                     }
                 }
             }
@@ -2675,15 +2958,10 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         BlockTransactionsRequest req;
         vRecv >> req;
 
-        std::shared_ptr<const CBlock> recent_block;
-        {
-            LOCK(cs_most_recent_block);
-            if (most_recent_block_hash == req.blockhash)
-                recent_block = most_recent_block;
-            // Unlock cs_most_recent_block to avoid cs_main lock inversion
-        }
-        if (recent_block) {
-            SendBlockTransactions(*recent_block, req, pfrom, connman);
+        // GetRecentBlock releases cs_most_recent_block before returning, avoiding cs_main lock inversion
+        CRecentBlock recentBlock;
+        if (GetRecentBlock(req.blockhash, recentBlock)) {
+            SendBlockTransactions(*recentBlock.block, req, pfrom, connman);
             return true;
         }
 
@@ -2919,11 +3197,11 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                 for (const CTxIn& txin : tx.vin) {
                     CInv _inv(MSG_TX, txin.prevout.hash);
                     pfrom->AddInventoryKnown(_inv);
-                    if (!AlreadyHave(_inv)) RequestObject(State(pfrom->GetId()), _inv, current_time);
+                    if (!AlreadyHave(_inv)) RequestObject(pfrom->GetId(), _inv, current_time);
                     // We don't know if the previous tx was a regular or a mixing one, try both
                     CInv _inv2(MSG_DSTX, txin.prevout.hash);
                     pfrom->AddInventoryKnown(_inv2);
-                    if (!AlreadyHave(_inv2)) RequestObject(State(pfrom->GetId()), _inv2, current_time);
+                    if (!AlreadyHave(_inv2)) RequestObject(pfrom->GetId(), _inv2, current_time);
                 }
                 AddOrphanTx(ptx, pfrom->GetId());
 
@@ -3078,7 +3356,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         // We want to be a bit conservative just to be extra careful about DoS
         // possibilities in compact block processing...
         if (pindex->nHeight <= chainActive.Height() + 2) {
-            if ((!fAlreadyInFlight && nodestate->nBlocksInFlight < MAX_BLOCKS_IN_TRANSIT_PER_PEER) ||
+            if ((!fAlreadyInFlight && nodestate->nBlocksInFlight < nodestate->nMaxBlocksInFlight) ||
                  (fAlreadyInFlight && blockInFlightIt->second.first == pfrom->GetId())) {
                 std::list<QueuedBlock>::iterator *queuedBlockIt = nullptr;
                 if (!MarkBlockAsInFlight(pfrom->GetId(), pindex->GetBlockHash(), pindex, &queuedBlockIt)) {
@@ -3247,7 +3525,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                 // though the block was successfully read, and rely on the
                 // handling in ProcessNewBlock to ensure the block index is
                 // updated, reject messages go out, etc.
-                MarkBlockAsReceived(resp.blockhash); // it is now an empty pointer
+                MarkBlockAsReceived(resp.blockhash, pfrom->GetId()); // it is now an empty pointer
                 fBlockRead = true;
                 // mapBlockSource is only used for sending reject messages and DoS scores,
                 // so the race between here and cs_main in ProcessNewBlock is fine.
@@ -3314,7 +3592,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             LOCK(cs_main);
             // Also always process if we requested the block explicitly, as we may
             // need it even though it is not a candidate for a new best tip.
-            forceProcessing |= MarkBlockAsReceived(hash);
+            forceProcessing |= MarkBlockAsReceived(hash, pfrom->GetId());
             // mapBlockSource is only used for sending reject messages and DoS scores,
             // so the race between here and cs_main in ProcessNewBlock is fine.
             mapBlockSource.emplace(hash, std::make_pair(pfrom->GetId(), true));
@@ -3504,6 +3782,21 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
+    if (strCommand == NetMsgType::GETCFILTERS) {
+        ProcessGetCFilters(pfrom, vRecv, chainparams, connman);
+        return true;
+    }
+
+    if (strCommand == NetMsgType::GETCFHEADERS) {
+        ProcessGetCFHeaders(pfrom, vRecv, chainparams, connman);
+        return true;
+    }
+
+    if (strCommand == NetMsgType::GETCFCHECKPT) {
+        ProcessGetCFCheckPt(pfrom, vRecv, chainparams, connman);
+        return true;
+    }
+
 
     if (strCommand == NetMsgType::GETMNLISTDIFF) {
         CGetSimplifiedMNListDiff cmd;
@@ -3511,10 +3804,11 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
 
         LOCK(cs_main);
 
-        CSimplifiedMNListDiff mnListDiff;
+        CSerializedNetMsg msg;
+        msg.command = NetMsgType::MNLISTDIFF;
         std::string strError;
-        if (BuildSimplifiedMNListDiff(cmd.baseBlockHash, cmd.blockHash, mnListDiff, strError)) {
-            connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::MNLISTDIFF, mnListDiff));
+        if (mnListDiffCache.GetSerializedDiff(cmd.baseBlockHash, cmd.blockHash, pfrom->GetSendVersion(), msg.data, strError)) {
+            connman->PushMessage(pfrom, std::move(msg));
         } else {
             strError = strprintf("getmnlistdiff failed for baseBlockHash=%s, blockHash=%s. error=%s", cmd.baseBlockHash.ToString(), cmd.blockHash.ToString(), strError);
             Misbehaving(pfrom->GetId(), 1, strError);
@@ -3533,23 +3827,15 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
 
     if (strCommand == NetMsgType::NOTFOUND) {
         // Remove the NOTFOUND transactions from the peer
-        LOCK(cs_main);
-        CNodeState *state = State(pfrom->GetId());
         std::vector<CInv> vInv;
         vRecv >> vInv;
-        if (vInv.size() <= MAX_PEER_OBJECT_IN_FLIGHT + MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+        if (vInv.size() <= MAX_PEER_OBJECT_IN_FLIGHT + MAX_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER) {
             for (CInv &inv : vInv) {
                 if (inv.IsKnownType()) {
                     // If we receive a NOTFOUND message for a txid we requested, erase
-                    // it from our data structures for this peer.
-                    auto in_flight_it = state->m_object_download.m_object_in_flight.find(inv);
-                    if (in_flight_it == state->m_object_download.m_object_in_flight.end()) {
-                        // Skip any further work if this is a spurious NOTFOUND
-                        // message.
-                        continue;
-                    }
-                    state->m_object_download.m_object_in_flight.erase(in_flight_it);
-                    state->m_object_download.m_object_announced.erase(inv);
+                    // it from our data structures for this peer. Spurious NOTFOUND
+                    // messages are ignored.
+                    objectRequestScheduler.ReceivedNotFound(pfrom->GetId(), inv);
                 }
             }
         }
@@ -3627,6 +3913,75 @@ static bool SendRejectsAndCheckIfBanned(CNode* pnode, CConnman* connman, bool en
     return false;
 }
 
+// Messages which don't affect validation and are handled by thread safe managers, these can be processed on message
+// worker threads (see -msgworkerthreads)
+static bool IsMessageWorkerCommand(const std::string& strCommand)
+{
+    static const std::set<std::string> setCommands{
+        NetMsgType::QSIGSESANN,
+        NetMsgType::QSIGSHARESINV,
+        NetMsgType::QGETSIGSHARES,
+        NetMsgType::QBSIGSHARES,
+        NetMsgType::QSIGSHARE,
+        NetMsgType::QCONTRIB,
+        NetMsgType::QCOMPLAINT,
+        NetMsgType::QJUSTIFICATION,
+        NetMsgType::QPCOMMITMENT,
+        NetMsgType::MNGOVERNANCEOBJECTVOTE,
+    };
+    return setCommands.count(strCommand) != 0;
+}
+
+bool PeerLogicValidation::ProcessValidatedMessage(CNode* pfrom, const std::string& strCommand, CNetMessage& msg, std::atomic<bool>& interruptMsgProc)
+{
+    unsigned int nMessageSize = msg.hdr.nMessageSize;
+    bool fRet = false;
+    int64_t nProcessStartTime = GetTimeMicros();
+    try
+    {
+        fRet = ProcessMessage(pfrom, strCommand, msg.vRecv, msg.nTime, Params(), connman, interruptMsgProc, m_enable_bip61);
+        if (interruptMsgProc)
+            return false;
+    }
+    catch (const std::ios_base::failure& e)
+    {
+        if (m_enable_bip61) {
+            connman->PushMessage(pfrom, CNetMsgMaker(INIT_PROTO_VERSION).Make(NetMsgType::REJECT, strCommand, REJECT_MALFORMED, std::string("error parsing message")));
+        }
+        if (strstr(e.what(), "end of data"))
+        {
+            // Allow exceptions from under-length message on vRecv
+            LogPrint(BCLog::NET, "%s(%s, %u bytes): Exception '%s' caught, normally caused by a message being shorter than its stated length\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
+        }
+        else if (strstr(e.what(), "size too large"))
+        {
+            // Allow exceptions from over-long size
+            LogPrint(BCLog::NET, "%s(%s, %u bytes): Exception '%s' caught\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
+        }
+        else if (strstr(e.what(), "non-canonical ReadCompactSize()"))
+        {
+            // Allow exceptions from non-canonical encoding
+            LogPrint(BCLog::NET, "%s(%s, %u bytes): Exception '%s' caught\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
+        }
+        else
+        {
+            PrintExceptionContinue(std::current_exception(), "ProcessMessages()");
+        }
+    } catch (...) {
+        PrintExceptionContinue(std::current_exception(), "ProcessMessages()");
+    }
+    pfrom->AddMsgProcessTime(strCommand, nProcessStartTime - msg.nTime, GetTimeMicros() - nProcessStartTime);
+
+    if (!fRet) {
+        LogPrint(BCLog::NET, "%s(%s, %u bytes) FAILED peer=%d\n", __func__, SanitizeString(strCommand), nMessageSize, pfrom->GetId());
+    }
+
+    LOCK(cs_main);
+    SendRejectsAndCheckIfBanned(pfrom, connman, m_enable_bip61);
+
+    return true;
+}
+
 bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& interruptMsgProc)
 {
     const CChainParams& chainparams = Params();
@@ -3651,8 +4006,8 @@ bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& inter
     if (pfrom->fDisconnect)
         return false;
 
-    // this maintains the order of responses
-    if (!pfrom->vRecvGetData.empty()) return true;
+    // this maintains the order of responses, the block read thread wakes us up when a pending block read finished
+    if (!pfrom->vRecvGetData.empty()) return !pfrom->fGetDataBlockReadPending;
     if (!pfrom->orphan_work_set.empty()) return true;
 
     // Don't bother if send buffer is too full to respond anyway
@@ -3692,62 +4047,50 @@ bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& inter
     // Message size
     unsigned int nMessageSize = hdr.nMessageSize;
 
-    // Checksum
-    CDataStream& vRecv = msg.vRecv;
-    const uint256& hash = msg.GetMessageHash();
-    if (memcmp(hash.begin(), hdr.pchChecksum, CMessageHeader::CHECKSUM_SIZE) != 0)
-    {
-        LogPrint(BCLog::NET, "%s(%s, %u bytes): CHECKSUM ERROR expected %s was %s\n", __func__,
-           SanitizeString(strCommand), nMessageSize,
-           HexStr(hash.begin(), hash.begin()+CMessageHeader::CHECKSUM_SIZE),
-           HexStr(hdr.pchChecksum, hdr.pchChecksum+CMessageHeader::CHECKSUM_SIZE));
-        return fMoreWork;
+    // Checksum, compact headers don't have one
+    if (!msg.fCompactHeader) {
+        const uint256& hash = msg.GetMessageHash();
+        if (memcmp(hash.begin(), hdr.pchChecksum, CMessageHeader::CHECKSUM_SIZE) != 0)
+        {
+            LogPrint(BCLog::NET, "%s(%s, %u bytes): CHECKSUM ERROR expected %s was %s\n", __func__,
+               SanitizeString(strCommand), nMessageSize,
+               HexStr(hash.begin(), hash.begin()+CMessageHeader::CHECKSUM_SIZE),
+               HexStr(hdr.pchChecksum, hdr.pchChecksum+CMessageHeader::CHECKSUM_SIZE));
+            return fMoreWork;
+        }
     }
 
     // Process message
-    bool fRet = false;
-    try
-    {
-        fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams, connman, interruptMsgProc, m_enable_bip61);
-        if (interruptMsgProc)
-            return false;
-        if (!pfrom->vRecvGetData.empty())
-            fMoreWork = true;
-    }
-    catch (const std::ios_base::failure& e)
-    {
-        if (m_enable_bip61) {
-            connman->PushMessage(pfrom, CNetMsgMaker(INIT_PROTO_VERSION).Make(NetMsgType::REJECT, strCommand, REJECT_MALFORMED, std::string("error parsing message")));
-        }
-        if (strstr(e.what(), "end of data"))
+    if (IsMessageWorkerCommand(strCommand) && pfrom->fSuccessfullyConnected) {
+        // the message stays accounted in nProcessQueueSize until the worker is done with it, so that a peer can't
+        // flood the worker queue
+        size_t nSize = msg.vRecv.size() + CMessageHeader::HEADER_SIZE;
         {
-            // Allow exceptions from under-length message on vRecv
-            LogPrint(BCLog::NET, "%s(%s, %u bytes): Exception '%s' caught, normally caused by a message being shorter than its stated length\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
-        }
-        else if (strstr(e.what(), "size too large"))
-        {
-            // Allow exceptions from over-long size
-            LogPrint(BCLog::NET, "%s(%s, %u bytes): Exception '%s' caught\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
-        }
-        else if (strstr(e.what(), "non-canonical ReadCompactSize()"))
-        {
-            // Allow exceptions from non-canonical encoding
-            LogPrint(BCLog::NET, "%s(%s, %u bytes): Exception '%s' caught\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
+            LOCK(pfrom->cs_vProcessMsg);
+            pfrom->nProcessQueueSize += nSize;
+        }
+        auto pmsg = std::make_shared<CNetMessage>(std::move(msg));
+        bool fQueued = connman->RunOnMessageWorker(pfrom, [this, pfrom, pmsg, strCommand, nSize, &interruptMsgProc]() {
+            ProcessValidatedMessage(pfrom, strCommand, *pmsg, interruptMsgProc);
+            LOCK(pfrom->cs_vProcessMsg);
+            pfrom->nProcessQueueSize -= nSize;
+            pfrom->fPauseRecv = pfrom->nProcessQueueSize > connman->GetReceiveFloodSize();
+        });
+        if (fQueued) {
+            return fMoreWork;
         }
-        else
         {
-            PrintExceptionContinue(std::current_exception(), "ProcessMessages()");
+            LOCK(pfrom->cs_vProcessMsg);
+            pfrom->nProcessQueueSize -= nSize;
         }
-    } catch (...) {
-        PrintExceptionContinue(std::current_exception(), "ProcessMessages()");
-    }
-
-    if (!fRet) {
-        LogPrint(BCLog::NET, "%s(%s, %u bytes) FAILED peer=%d\n", __func__, SanitizeString(strCommand), nMessageSize, pfrom->GetId());
+        if (!ProcessValidatedMessage(pfrom, strCommand, *pmsg, interruptMsgProc))
+            return false;
+    } else {
+        if (!ProcessValidatedMessage(pfrom, strCommand, msg, interruptMsgProc))
+            return false;
     }
-
-    LOCK(cs_main);
-    SendRejectsAndCheckIfBanned(pfrom, connman, m_enable_bip61);
+    if (!pfrom->vRecvGetData.empty() && !pfrom->fGetDataBlockReadPending)
+        fMoreWork = true;
 
     return fMoreWork;
 }
@@ -4108,15 +4451,10 @@ bool PeerLogicValidation::SendMessages(CNode* pto)
                     LogPrint(BCLog::NET, "%s sending header-and-ids %s to peer=%d\n", __func__,
                             vHeaders.front().GetHash().ToString(), pto->GetId());
 
-                    bool fGotBlockFromCache = false;
-                    {
-                        LOCK(cs_most_recent_block);
-                        if (most_recent_block_hash == pBestIndex->GetBlockHash()) {
-                            connman->PushMessage(pto, msgMaker.Make(NetMsgType::CMPCTBLOCK, *most_recent_compact_block));
-                            fGotBlockFromCache = true;
-                        }
-                    }
-                    if (!fGotBlockFromCache) {
+                    CRecentBlock recentBlock;
+                    if (GetRecentBlock(pBestIndex->GetBlockHash(), recentBlock)) {
+                        connman->PushMessage(pto, msgMaker.Make(NetMsgType::CMPCTBLOCK, *recentBlock.cmpctblock));
+                    } else {
                         CBlock block;
                         bool ret = ReadBlockFromDisk(block, pBestIndex, consensusParams);
                         assert(ret);
@@ -4289,19 +4627,7 @@ bool PeerLogicValidation::SendMessages(CNode* pto)
                     if (pto->pfilter && !pto->pfilter->IsRelevantAndUpdate(*txinfo.tx)) continue;
                     // Send
                     nRelayedTransactions++;
-                    {
-                        // Expire old relay messages
-                        while (!vRelayExpiration.empty() && vRelayExpiration.front().first < nNow)
-                        {
-                            mapRelay.erase(vRelayExpiration.front().second);
-                            vRelayExpiration.pop_front();
-                        }
-
-                        auto ret = mapRelay.insert(std::make_pair(hash, std::move(txinfo.tx)));
-                        if (ret.second) {
-                            vRelayExpiration.push_back(std::make_pair(nNow + 15 * 60 * 1000000, ret.first));
-                        }
-                    }
+                    txRelayCache.Add(txinfo.tx, nNow / 1000000);
                     int nInvType = CCoinJoin::GetDSTX(hash) ? MSG_DSTX : MSG_TX;
                     queueAndMaybePushInv(CInv(nInvType, hash));
                 }
@@ -4387,10 +4713,26 @@ bool PeerLogicValidation::SendMessages(CNode* pto)
         // Message: getdata (blocks)
         //
         std::vector<CInv> vGetData;
-        if (!pto->fClient && pto->CanRelay() && ((fFetch && !pto->m_limited_node) || !IsInitialBlockDownload()) && state.nBlocksInFlight < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+        if (!pto->fClient && pto->CanRelay() && ((fFetch && !pto->m_limited_node) || !IsInitialBlockDownload()) && state.nBlocksInFlight < state.nMaxBlocksInFlight) {
             std::vector<const CBlockIndex*> vToDownload;
             NodeId staller = -1;
-            FindNextBlocksToDownload(pto->GetId(), MAX_BLOCKS_IN_TRANSIT_PER_PEER - state.nBlocksInFlight, vToDownload, staller, consensusParams);
+            const CBlockIndex* pindexStalling = nullptr;
+            FindNextBlocksToDownload(pto->GetId(), state.nMaxBlocksInFlight - state.nBlocksInFlight, vToDownload, staller, pindexStalling, consensusParams);
+            if (vToDownload.empty() && staller != -1 && pindexStalling != nullptr && state.nAvgBlockDeliveryTime != 0) {
+                // The window is blocked by a block in flight from another peer. If it takes that peer much longer than
+                // this one usually needs for a block, take the block over instead of waiting for the staller to time out.
+                CNodeState* stallerState = State(staller);
+                int64_t nReassignTime = std::max(BLOCK_STALLING_REASSIGN_TIME, 4 * state.nAvgBlockDeliveryTime);
+                if (stallerState->nStallingSince != 0 && nNow > stallerState->nDownloadingSince + nReassignTime &&
+                        (stallerState->nAvgBlockDeliveryTime == 0 || stallerState->nAvgBlockDeliveryTime > 2 * state.nAvgBlockDeliveryTime)) {
+                    LogPrint(BCLog::NET, "Reassigning block %s (%d) from stalling peer=%d to peer=%d\n", pindexStalling->GetBlockHash().ToString(),
+                        pindexStalling->nHeight, staller, pto->GetId());
+                    // Account for the time the staller already spent on the block, to lower its in-flight limit
+                    UpdateBlockDeliveryTime(stallerState, nNow - stallerState->nDownloadingSince);
+                    vToDownload.push_back(pindexStalling);
+                    staller = -1;
+                }
+            }
             for (const CBlockIndex *pindex : vToDownload) {
                 vGetData.push_back(CInv(MSG_BLOCK, pindex->GetBlockHash()));
                 MarkBlockAsInFlight(pto->GetId(), pindex->GetBlockHash(), pindex);
@@ -4409,70 +4751,20 @@ bool PeerLogicValidation::SendMessages(CNode* pto)
         // Message: getdata (non-blocks)
         //
 
-        // For robustness, expire old requests after a long timeout, so that
-        // we can resume downloading objects from a peer even if they
-        // were unresponsive in the past.
-        // Eventually we should consider disconnecting peers, but this is
-        // conservative.
-        if (state.m_object_download.m_check_expiry_timer <= current_time) {
-            for (auto it=state.m_object_download.m_object_in_flight.begin(); it != state.m_object_download.m_object_in_flight.end();) {
-                if (it->second <= current_time - GetObjectExpiryInterval(it->first.type)) {
-                    LogPrint(BCLog::NET, "timeout of inflight object %s from peer=%d\n", it->first.ToString(), pto->GetId());
-                    state.m_object_download.m_object_announced.erase(it->first);
-                    state.m_object_download.m_object_in_flight.erase(it++);
-                } else {
-                    ++it;
-                }
-            }
-            // On average, we do this check every GetObjectExpiryInterval. Randomize
-            // so that we're not doing this for all peers at the same time.
-            state.m_object_download.m_check_expiry_timer = current_time + GetObjectExpiryInterval(MSG_TX)/2 + GetRandMicros(GetObjectExpiryInterval(MSG_TX));
-        }
-
         // DASH this code also handles non-TXs (Dash specific messages)
-        auto& object_process_time = state.m_object_download.m_object_process_time;
-        while (!object_process_time.empty() && object_process_time.begin()->first <= current_time && state.m_object_download.m_object_in_flight.size() < MAX_PEER_OBJECT_IN_FLIGHT) {
-            const CInv inv = object_process_time.begin()->second;
-            // Erase this entry from object_process_time (it may be added back for
-            // processing at a later time, see below)
-            object_process_time.erase(object_process_time.begin());
-            if (g_erased_object_requests.count(inv.hash)) {
-                LogPrint(BCLog::NET, "%s -- GETDATA skipping inv=(%s), peer=%d\n", __func__, inv.ToString(), pto->GetId());
-                state.m_object_download.m_object_announced.erase(inv);
-                state.m_object_download.m_object_in_flight.erase(inv);
-                continue;
-            }
-            if (!AlreadyHave(inv)) {
-                // If this object was last requested more than GetObjectInterval ago,
-                // then request.
-                const auto last_request_time = GetObjectRequestTime(inv.hash);
-                if (last_request_time <= current_time - GetObjectInterval(inv.type)) {
-                    LogPrint(BCLog::NET, "Requesting %s peer=%d\n", inv.ToString(), pto->GetId());
-                    vGetData.push_back(inv);
-                    if (vGetData.size() >= MAX_GETDATA_SZ) {
-                        connman->PushMessage(pto, msgMaker.Make(NetMsgType::GETDATA, vGetData));
-                        vGetData.clear();
-                    }
-                    UpdateObjectRequestTime(inv.hash, current_time);
-                    state.m_object_download.m_object_in_flight.emplace(inv, current_time);
-                } else {
-                    // This object is in flight from someone else; queue
-                    // up processing to happen after the download times out
-                    // (with a slight delay for inbound peers, to prefer
-                    // requests to outbound peers).
-                    const auto next_process_time = CalculateObjectGetDataTime(inv, current_time, !state.fPreferredDownload);
-                    object_process_time.emplace(next_process_time, inv);
-                    LogPrint(BCLog::NET, "%s -- GETDATA re-queue inv=(%s), next_process_time=%d, delta=%d, peer=%d\n", __func__, inv.ToString(), next_process_time.count(), (next_process_time - current_time).count(), pto->GetId());
-                }
-            } else {
-                // We have already seen this object, no need to download.
-                state.m_object_download.m_object_announced.erase(inv);
-                state.m_object_download.m_object_in_flight.erase(inv);
-                LogPrint(BCLog::NET, "%s -- GETDATA already seen inv=(%s), peer=%d\n", __func__, inv.ToString(), pto->GetId());
+        std::vector<CInv> vObjectGetData;
+        objectRequestScheduler.GetRequests(pto->GetId(), current_time, [](const CInv& inv) {
+            AssertLockHeld(cs_main);
+            return AlreadyHave(inv);
+        }, vObjectGetData);
+        for (const auto& inv : vObjectGetData) {
+            vGetData.push_back(inv);
+            if (vGetData.size() >= MAX_GETDATA_SZ) {
+                connman->PushMessage(pto, msgMaker.Make(NetMsgType::GETDATA, vGetData));
+                vGetData.clear();
             }
         }
 
-
         if (!vGetData.empty()) {
             connman->PushMessage(pto, msgMaker.Make(NetMsgType::GETDATA, vGetData));
             LogPrint(BCLog::NET, "SendMessages -- GETDATA -- pushed size = %lu peer=%d\n", vGetData.size(), pto->GetId());
@@ -7,6 +7,7 @@
 #define BITCOIN_NET_PROCESSING_H
 
 #include <net.h>
+#include <objectrequest.h>
 #include <validation.h>
 #include <validationinterface.h>
 #include <consensus/params.h>
@@ -25,6 +26,9 @@ class PeerLogicValidation final : public CValidationInterface, public NetEventsI
 private:
     CConnman* const connman;
 
+    /** Processes a message of which header and checksum were already checked, returns false if interrupted */
+    bool ProcessValidatedMessage(CNode* pfrom, const std::string& strCommand, CNetMessage& msg, std::atomic<bool>& interruptMsgProc);
+
 public:
     explicit PeerLogicValidation(CConnman* connmanIn, CScheduler &scheduler, bool enable_bip61);
 
@@ -82,6 +86,7 @@ struct CNodeStateStats {
     int nMisbehavior = 0;
     int nSyncHeight = -1;
     int nCommonHeight = -1;
+    int nMaxBlocksInFlight = 0;
     std::vector<int> vHeightInFlight;
 };
 
@@ -97,5 +102,6 @@ void Misbehaving(NodeId nodeid, int howmuch, const std::string& message="") EXCL
 void EraseObjectRequest(NodeId nodeId, const CInv& inv);
 void RequestObject(NodeId nodeId, const CInv& inv, std::chrono::microseconds current_time, bool fForce=false);
 size_t GetRequestedObjectCount(NodeId nodeId);
+CObjectRequestScheduler::Stats GetObjectRequestStats();
 
 #endif // BITCOIN_NET_PROCESSING_H
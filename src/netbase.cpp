@@ -751,6 +751,31 @@ bool SetSocketNoDelay(const SOCKET& hSocket)
     return rc == 0;
 }
 
+bool SetSocketLowLatency(const SOCKET& hSocket)
+{
+#if defined(SO_BUSY_POLL) && defined(TCP_QUICKACK)
+    // time in microseconds to busy poll for new packets
+    int busyPoll = 50;
+    if (setsockopt(hSocket, SOL_SOCKET, SO_BUSY_POLL, (const char*)&busyPoll, sizeof(int)) != 0) {
+        return false;
+    }
+    return SetSocketQuickAck(hSocket);
+#else
+    return false;
+#endif
+}
+
+bool SetSocketQuickAck(const SOCKET& hSocket)
+{
+#ifdef TCP_QUICKACK
+    int set = 1;
+    int rc = setsockopt(hSocket, IPPROTO_TCP, TCP_QUICKACK, (const char*)&set, sizeof(int));
+    return rc == 0;
+#else
+    return false;
+#endif
+}
+
 void InterruptSocks5(bool interrupt)
 {
     interruptSocks5Recv = interrupt;
@@ -63,6 +63,13 @@ bool CloseSocket(SOCKET& hSocket);
 bool SetSocketNonBlocking(const SOCKET& hSocket, bool fNonBlocking);
 /** Set the TCP_NODELAY flag on a socket */
 bool SetSocketNoDelay(const SOCKET& hSocket);
+/**
+ * Trade CPU time for latency: busy poll the device queue on blocking reads/polls (SO_BUSY_POLL) and acknowledge
+ * immediately (TCP_QUICKACK). Only supported on Linux, returns false if any of the options couldn't be set.
+ */
+bool SetSocketLowLatency(const SOCKET& hSocket);
+/** Re-arm TCP_QUICKACK, the kernel may leave quick ack mode on its own after receiving data */
+bool SetSocketQuickAck(const SOCKET& hSocket);
 /**
  * Convert milliseconds to a struct timeval for e.g. select.
  */
@@ -9,16 +9,26 @@
 #include <coins.h>
 #include <chain.h>
 #include <hash.h>
+#include <init.h>
 #include <serialize.h>
+#include <streams.h>
+#include <txdb.h>
+#include <undo.h>
 #include <validation.h>
 #include <uint256.h>
 // #include <util/system.h>
 #include <util.h>
 
 #include <map>
+#include <thread>
 
 #include <boost/thread.hpp>
 
+static uint64_t GetBogoSize(const CScript& scriptPubKey)
+{
+    return 32 /* txid */ + 4 /* vout index */ + 4 /* height + coinbase */ + 8 /* amount */ +
+           2 /* scriptPubKey len */ + scriptPubKey.size() /* scriptPubKey */;
+}
 
 static void ApplyStats(CCoinsStats &stats, CHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
 {
@@ -32,47 +42,212 @@ static void ApplyStats(CCoinsStats &stats, CHashWriter& ss, const uint256& hash,
         ss << VARINT(output.second.out.nValue, VarIntMode::NONNEGATIVE_SIGNED);
         stats.nTransactionOutputs++;
         stats.nTotalAmount += output.second.out.nValue;
-        stats.nBogoSize += 32 /* txid */ + 4 /* vout index */ + 4 /* height + coinbase */ + 8 /* amount */ +
-                           2 /* scriptPubKey len */ + output.second.out.scriptPubKey.size() /* scriptPubKey */;
+        stats.nBogoSize += GetBogoSize(output.second.out.scriptPubKey);
     }
     ss << VARINT(0u);
 }
 
+CCoinsStatsBuilder::CCoinsStatsBuilder(CCoinsStats& statsIn, const uint256& hashBlock) :
+    stats(statsIn),
+    ss(SER_GETHASH, PROTOCOL_VERSION)
+{
+    stats.hashBlock = hashBlock;
+    ss << stats.hashBlock;
+}
+
+void CCoinsStatsBuilder::Add(const COutPoint& outpoint, Coin coin)
+{
+    if (!outputs.empty() && outpoint.hash != prevkey) {
+        ApplyStats(stats, ss, prevkey, outputs);
+        outputs.clear();
+    }
+    prevkey = outpoint.hash;
+    outputs[outpoint.n] = std::move(coin);
+}
+
+void CCoinsStatsBuilder::Finish()
+{
+    if (!outputs.empty()) {
+        ApplyStats(stats, ss, prevkey, outputs);
+        outputs.clear();
+    }
+    stats.hashSerialized = ss.GetHash();
+}
+
 //! Calculate statistics about the unspent transaction output set
 bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
 {
     std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
     assert(pcursor);
 
-    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
-    stats.hashBlock = pcursor->GetBestBlock();
+    CCoinsStatsBuilder builder(stats, pcursor->GetBestBlock());
     {
         LOCK(cs_main);
         stats.nHeight = LookupBlockIndex(stats.hashBlock)->nHeight;
     }
-    ss << stats.hashBlock;
-    uint256 prevkey;
-    std::map<uint32_t, Coin> outputs;
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         COutPoint key;
         Coin coin;
         if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
-            if (!outputs.empty() && key.hash != prevkey) {
-                ApplyStats(stats, ss, prevkey, outputs);
-                outputs.clear();
-            }
-            prevkey = key.hash;
-            outputs[key.n] = std::move(coin);
+            builder.Add(key, std::move(coin));
         } else {
             return error("%s: unable to read value", __func__);
         }
         pcursor->Next();
     }
-    if (!outputs.empty()) {
-        ApplyStats(stats, ss, prevkey, outputs);
+    builder.Finish();
+    stats.nDiskSize = view->EstimateSize();
+    return true;
+}
+
+static std::vector<unsigned char> GetMuHashElement(const COutPoint& outpoint, const Coin& coin)
+{
+    std::vector<unsigned char> vch;
+    CVectorWriter ss(SER_DISK, PROTOCOL_VERSION, vch, 0);
+    ss << outpoint;
+    ss << (uint32_t)(coin.nHeight * 2 + (coin.fCoinBase ? 1u : 0u));
+    ss << coin.out;
+    return vch;
+}
+
+void CCoinsCommitment::AddCoin(const COutPoint& outpoint, const Coin& coin)
+{
+    muhash.Insert(GetMuHashElement(outpoint, coin));
+    nTransactionOutputs++;
+    nBogoSize += GetBogoSize(coin.out.scriptPubKey);
+    nTotalAmount += coin.out.nValue;
+}
+
+void CCoinsCommitment::RemoveCoin(const COutPoint& outpoint, const Coin& coin)
+{
+    muhash.Remove(GetMuHashElement(outpoint, coin));
+    nTransactionOutputs--;
+    nBogoSize -= GetBogoSize(coin.out.scriptPubKey);
+    nTotalAmount -= coin.out.nValue;
+}
+
+void CCoinsCommitment::ConnectBlock(const CBlock& block, const CBlockUndo& blockundo, int nHeight)
+{
+    assert(blockundo.vtxundo.size() + 1 == block.vtx.size());
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        const CTransaction& tx = *block.vtx[i];
+        if (i > 0) {
+            const CTxUndo& txundo = blockundo.vtxundo[i - 1];
+            assert(txundo.vprevout.size() == tx.vin.size());
+            for (size_t j = 0; j < tx.vin.size(); j++) {
+                RemoveCoin(tx.vin[j].prevout, txundo.vprevout[j]);
+            }
+        }
+        // same as AddCoins(), unspendable outputs never enter the UTXO set
+        const uint256& txid = tx.GetHash();
+        for (size_t o = 0; o < tx.vout.size(); o++) {
+            if (!tx.vout[o].scriptPubKey.IsUnspendable()) {
+                AddCoin(COutPoint(txid, o), Coin(tx.vout[o], nHeight, tx.IsCoinBase()));
+            }
+        }
     }
-    stats.hashSerialized = ss.GetHash();
+}
+
+void CCoinsCommitment::Combine(const CCoinsCommitment& other)
+{
+    muhash *= other.muhash;
+    nTransactionOutputs += other.nTransactionOutputs;
+    nBogoSize += other.nBogoSize;
+    nTotalAmount += other.nTotalAmount;
+}
+
+uint256 CCoinsCommitment::GetHash() const
+{
+    uint256 hash;
+    muhash.Finalize(hash);
+    return hash;
+}
+
+bool GetUTXOStatsParallel(CCoinsViewDB* view, CCoinsStats& stats, CCoinsCommitment* pcommitmentRet, int nThreads)
+{
+    nThreads = std::max(1, std::min(nThreads, MAX_UTXO_STATS_THREADS));
+
+    // Thread i scans the txids whose first byte (in the order of the database) is in [i * 256 / nThreads, (i + 1) * 256 / nThreads).
+    // As all outputs of a transaction are in the same range, the number of transactions of the ranges add up.
+    std::vector<std::unique_ptr<CCoinsViewCursor>> vCursors;
+    {
+        // Nothing writes to the database while we hold cs_main, so all cursors see the same coins
+        LOCK(cs_main);
+        for (int i = 0; i < nThreads; i++) {
+            uint256 hashStart;
+            *hashStart.begin() = (unsigned char)(i * 256 / nThreads);
+            vCursors.emplace_back(view->Cursor(hashStart));
+        }
+        stats.hashBlock = vCursors[0]->GetBestBlock();
+        const CBlockIndex* pindex = LookupBlockIndex(stats.hashBlock);
+        stats.nHeight = pindex ? pindex->nHeight : 0;
+    }
+
+    struct RangeStats {
+        uint64_t nTransactions{0};
+        CCoinsCommitment commitment;
+        bool fOk{true};
+    };
+    std::vector<RangeStats> vRanges(nThreads);
+    const bool fMuHash = pcommitmentRet != nullptr;
+
+    std::vector<std::thread> vThreads;
+    for (int i = 0; i < nThreads; i++) {
+        vThreads.emplace_back([&, i] {
+            RenameThread(strprintf("dash-utxostats-%d", i).c_str());
+            const int nEnd = (i + 1) * 256 / nThreads;
+            CCoinsViewCursor& cursor = *vCursors[i];
+            RangeStats& range = vRanges[i];
+            bool fFirst = true;
+            uint256 prevkey;
+            for (; cursor.Valid() && !ShutdownRequested(); cursor.Next()) {
+                COutPoint key;
+                Coin coin;
+                if (!cursor.GetKey(key) || !cursor.GetValue(coin)) {
+                    range.fOk = false;
+                    return;
+                }
+                if (*key.hash.begin() >= nEnd) {
+                    break;
+                }
+                if (fFirst || key.hash != prevkey) {
+                    range.nTransactions++;
+                    prevkey = key.hash;
+                    fFirst = false;
+                }
+                if (fMuHash) {
+                    range.commitment.AddCoin(key, coin);
+                } else {
+                    range.commitment.nTransactionOutputs++;
+                    range.commitment.nBogoSize += GetBogoSize(coin.out.scriptPubKey);
+                    range.commitment.nTotalAmount += coin.out.nValue;
+                }
+            }
+        });
+    }
+    for (auto& thread : vThreads) {
+        thread.join();
+    }
+    if (ShutdownRequested()) {
+        return error("%s: interrupted", __func__);
+    }
+
+    CCoinsCommitment commitment;
+    commitment.hashBlock = stats.hashBlock;
+    for (const auto& range : vRanges) {
+        if (!range.fOk) {
+            return error("%s: unable to read value", __func__);
+        }
+        stats.nTransactions += range.nTransactions;
+        commitment.Combine(range.commitment);
+    }
+    stats.nTransactionOutputs = commitment.nTransactionOutputs;
+    stats.nBogoSize = commitment.nBogoSize;
+    stats.nTotalAmount = commitment.nTotalAmount;
     stats.nDiskSize = view->EstimateSize();
+    if (pcommitmentRet) {
+        *pcommitmentRet = std::move(commitment);
+    }
     return true;
 }
@@ -7,11 +7,21 @@
 #define BITCOIN_NODE_COINSTATS_H
 
 #include <amount.h>
+#include <coins.h>
+#include <crypto/muhash.h>
+#include <hash.h>
+#include <serialize.h>
 #include <uint256.h>
 
 #include <cstdint>
+#include <map>
 
-class CCoinsView;
+class CBlock;
+class CBlockUndo;
+class CCoinsViewDB;
+
+//! Maximum number of threads scanning the coins database in GetUTXOStatsParallel()
+static const int MAX_UTXO_STATS_THREADS = 16;
 
 struct CCoinsStats
 {
@@ -27,7 +37,72 @@ struct CCoinsStats
     CCoinsStats() : nHeight(0), nTransactions(0), nTransactionOutputs(0), nBogoSize(0), nDiskSize(0), nTotalAmount(0) {}
 };
 
+/**
+ * Calculates the statistics and the serialized hash of a UTXO set from its coins, which must be added in the order
+ * of the coins database (all outputs of a transaction one after another). Used for UTXO set snapshots, which are
+ * streamed in that order.
+ */
+class CCoinsStatsBuilder
+{
+private:
+    CCoinsStats& stats;
+    CHashWriter ss;
+    uint256 prevkey;
+    std::map<uint32_t, Coin> outputs;
+
+public:
+    CCoinsStatsBuilder(CCoinsStats& statsIn, const uint256& hashBlock);
+
+    void Add(const COutPoint& outpoint, Coin coin);
+    /** Sets hashSerialized, no more coins can be added afterwards */
+    void Finish();
+};
+
+/**
+ * The MuHash of a UTXO set together with its totals. As elements can be added and removed in any order, it's updated
+ * while blocks are (dis)connected when -utxocommitment is set, so that gettxoutsetinfo doesn't need to scan the coins
+ * database. The numbers of transactions and the disk size can't be maintained like this.
+ */
+class CCoinsCommitment
+{
+public:
+    //! the block the commitment is for, checked against the coins database when it's loaded
+    uint256 hashBlock;
+    MuHash3072 muhash;
+    uint64_t nTransactionOutputs{0};
+    uint64_t nBogoSize{0};
+    CAmount nTotalAmount{0};
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(hashBlock);
+        READWRITE(muhash);
+        READWRITE(nTransactionOutputs);
+        READWRITE(nBogoSize);
+        READWRITE(nTotalAmount);
+    }
+
+    void AddCoin(const COutPoint& outpoint, const Coin& coin);
+    void RemoveCoin(const COutPoint& outpoint, const Coin& coin);
+    /** Adds the outputs of block and removes the coins it spent, in the order of ConnectBlock() */
+    void ConnectBlock(const CBlock& block, const CBlockUndo& blockundo, int nHeight);
+    /** Adds the coins of other, which must not overlap with ours */
+    void Combine(const CCoinsCommitment& other);
+
+    uint256 GetHash() const;
+};
+
 //! Calculate statistics about the unspent transaction output set
 bool GetUTXOStats(CCoinsView* view, CCoinsStats& stats);
 
+/**
+ * Calculates the statistics of the coins database with nThreads threads, each scanning a range of txids. Much faster
+ * than GetUTXOStats() on large UTXO sets, but it can't calculate hashSerialized, which is the hash of all coins in
+ * order. Calculates the MuHash of the coins instead if pcommitmentRet is not null.
+ */
+bool GetUTXOStatsParallel(CCoinsViewDB* view, CCoinsStats& stats, CCoinsCommitment* pcommitmentRet, int nThreads);
+
 #endif // BITCOIN_NODE_COINSTATS_H
@@ -0,0 +1,127 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/utxo_snapshot.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <coins.h>
+#include <llmq/quorums_blockprocessor.h>
+#include <util.h>
+#include <validation.h>
+
+#include <boost/thread.hpp>
+
+bool GetSnapshotEvoState(const CBlockIndex* pindex, SnapshotEvoState& evoStateRet)
+{
+    AssertLockHeld(cs_main);
+
+    evoStateRet.mnList = deterministicMNManager->GetListForBlock(pindex);
+    // the initial list before DIP3 has no height
+    evoStateRet.mnList.SetBlockHash(pindex->GetBlockHash());
+    evoStateRet.mnList.SetHeight(pindex->nHeight);
+
+    evoStateRet.vQuorumCommitments.clear();
+    for (const auto& p : llmq::quorumBlockProcessor->GetMinedAndActiveCommitmentsUntilBlock(pindex)) {
+        for (const auto& pindexQuorum : p.second) {
+            llmq::CFinalCommitment qc;
+            uint256 hashMinedBlock;
+            if (!llmq::quorumBlockProcessor->GetMinedCommitment(p.first, pindexQuorum->GetBlockHash(), qc, hashMinedBlock)) {
+                return error("%s: commitment for quorum %s not found", __func__, pindexQuorum->GetBlockHash().ToString());
+            }
+            evoStateRet.vQuorumCommitments.emplace_back(std::move(qc));
+        }
+    }
+    return true;
+}
+
+bool WriteUTXOSnapshot(CAutoFile& file, CCoinsViewCursor& cursor, const CBlockIndex* pindex, const SnapshotEvoState& evoState, SnapshotMetadata& metadataRet, CCoinsStats& statsRet)
+{
+    assert(cursor.GetBestBlock() == pindex->GetBlockHash());
+
+    metadataRet = SnapshotMetadata();
+    memcpy(metadataRet.pchMessageStart, Params().MessageStart(), sizeof(metadataRet.pchMessageStart));
+    metadataRet.hashBaseBlock = pindex->GetBlockHash();
+    metadataRet.nBaseHeight = pindex->nHeight;
+    // rewritten with the number of coins at the end
+    file << metadataRet;
+
+    statsRet = CCoinsStats();
+    statsRet.nHeight = pindex->nHeight;
+    CCoinsStatsBuilder builder(statsRet, pindex->GetBlockHash());
+    while (cursor.Valid()) {
+        boost::this_thread::interruption_point();
+        COutPoint key;
+        Coin coin;
+        if (!cursor.GetKey(key) || !cursor.GetValue(coin)) {
+            return error("%s: unable to read value", __func__);
+        }
+        file << key << coin;
+        builder.Add(key, std::move(coin));
+        metadataRet.nCoinsCount++;
+        cursor.Next();
+    }
+    builder.Finish();
+    file << evoState;
+
+    if (fseek(file.Get(), 0, SEEK_SET) != 0) {
+        return error("%s: unable to seek to the snapshot header", __func__);
+    }
+    file << metadataRet;
+    return true;
+}
+
+bool VerifyUTXOSnapshot(CAutoFile& file, const CChainParams& chainparams, SnapshotMetadata& metadataRet, CCoinsStats& statsRet, SnapshotEvoState& evoStateRet, std::string& strErrorRet)
+{
+    file >> metadataRet;
+    if (metadataRet.nVersion != SnapshotMetadata::CURRENT_VERSION) {
+        strErrorRet = strprintf("unsupported snapshot version %d", metadataRet.nVersion);
+        return false;
+    }
+    if (memcmp(metadataRet.pchMessageStart, chainparams.MessageStart(), sizeof(metadataRet.pchMessageStart)) != 0) {
+        strErrorRet = "snapshot is for another network";
+        return false;
+    }
+    auto it = chainparams.Assumeutxo().find(metadataRet.nBaseHeight);
+    if (it == chainparams.Assumeutxo().end()) {
+        strErrorRet = strprintf("no snapshot hashes known for height %d", metadataRet.nBaseHeight);
+        return false;
+    }
+    {
+        LOCK(cs_main);
+        const CBlockIndex* pindex = LookupBlockIndex(metadataRet.hashBaseBlock);
+        if (pindex && pindex->nHeight != metadataRet.nBaseHeight) {
+            strErrorRet = strprintf("snapshot block %s is not at height %d", metadataRet.hashBaseBlock.ToString(), metadataRet.nBaseHeight);
+            return false;
+        }
+    }
+
+    statsRet = CCoinsStats();
+    statsRet.nHeight = metadataRet.nBaseHeight;
+    CCoinsStatsBuilder builder(statsRet, metadataRet.hashBaseBlock);
+    for (uint64_t i = 0; i < metadataRet.nCoinsCount; i++) {
+        boost::this_thread::interruption_point();
+        COutPoint key;
+        Coin coin;
+        file >> key >> coin;
+        builder.Add(key, std::move(coin));
+    }
+    builder.Finish();
+    if (statsRet.hashSerialized != it->second.hashSerialized) {
+        strErrorRet = strprintf("UTXO set hash %s does not match the expected %s", statsRet.hashSerialized.ToString(), it->second.hashSerialized.ToString());
+        return false;
+    }
+
+    file >> evoStateRet;
+    if (evoStateRet.mnList.GetBlockHash() != metadataRet.hashBaseBlock || evoStateRet.mnList.GetHeight() != metadataRet.nBaseHeight) {
+        strErrorRet = "masternode list is not the one of the snapshot block";
+        return false;
+    }
+    const uint256 hashEvoState = evoStateRet.GetHash();
+    if (hashEvoState != it->second.hashEvoState) {
+        strErrorRet = strprintf("evo state hash %s does not match the expected %s", hashEvoState.ToString(), it->second.hashEvoState.ToString());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_UTXO_SNAPSHOT_H
+#define BITCOIN_NODE_UTXO_SNAPSHOT_H
+
+#include <evo/deterministicmns.h>
+#include <llmq/quorums_commitment.h>
+#include <node/coinstats.h>
+#include <protocol.h>
+#include <serialize.h>
+#include <streams.h>
+#include <uint256.h>
+
+#include <string>
+#include <vector>
+
+class CBlockIndex;
+class CChainParams;
+class CCoinsViewCursor;
+
+/**
+ * Header of a UTXO set snapshot file. The format is
+ *
+ *   SnapshotMetadata, nCoinsCount times (COutPoint, Coin) in the order of the coins database, SnapshotEvoState
+ *
+ * so that snapshots can be written and verified while streaming, without holding the UTXO set in memory.
+ */
+class SnapshotMetadata
+{
+public:
+    static const uint32_t CURRENT_VERSION = 1;
+
+    uint32_t nVersion{CURRENT_VERSION};
+    CMessageHeader::MessageStartChars pchMessageStart{};
+    uint256 hashBaseBlock;
+    int32_t nBaseHeight{0};
+    uint64_t nCoinsCount{0};
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(nVersion);
+        READWRITE(pchMessageStart);
+        READWRITE(hashBaseBlock);
+        READWRITE(nBaseHeight);
+        READWRITE(nCoinsCount);
+    }
+};
+
+/** The Dash specific state as of the snapshot block: the deterministic MN list and the active quorums */
+class SnapshotEvoState
+{
+public:
+    CDeterministicMNList mnList;
+    //! commitments of the active quorums of all LLMQ types, most recent first per type
+    std::vector<llmq::CFinalCommitment> vQuorumCommitments;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(mnList);
+        READWRITE(vQuorumCommitments);
+    }
+
+    uint256 GetHash() const { return SerializeHash(*this); }
+};
+
+/** Collects the evo state as of pindex, the caller must hold cs_main */
+bool GetSnapshotEvoState(const CBlockIndex* pindex, SnapshotEvoState& evoStateRet);
+
+/**
+ * Writes the coins of cursor and evoState to file, which must be at its beginning. The cursor must be at the first
+ * coin of a database whose best block is pindex.
+ */
+bool WriteUTXOSnapshot(CAutoFile& file, CCoinsViewCursor& cursor, const CBlockIndex* pindex, const SnapshotEvoState& evoState, SnapshotMetadata& metadataRet, CCoinsStats& statsRet);
+
+/**
+ * Reads a snapshot and verifies it against the hashes in chainparams for its height. Throws std::ios_base::failure
+ * for truncated files, returns false with strErrorRet if the snapshot is for another chain or doesn't match.
+ */
+bool VerifyUTXOSnapshot(CAutoFile& file, const CChainParams& chainparams, SnapshotMetadata& metadataRet, CCoinsStats& statsRet, SnapshotEvoState& evoStateRet, std::string& strErrorRet);
+
+#endif // BITCOIN_NODE_UTXO_SNAPSHOT_H
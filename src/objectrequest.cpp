@@ -0,0 +1,314 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <objectrequest.h>
+
+#include <random.h>
+#include <util.h>
+#include <utiltime.h>
+
+std::chrono::microseconds GetObjectInterval(int invType)
+{
+    // some messages need to be re-requested faster when the first announcing peer did not answer to GETDATA
+    switch(invType)
+    {
+        case MSG_QUORUM_RECOVERED_SIG:
+            return std::chrono::seconds{15};
+        case MSG_CLSIG:
+            return std::chrono::seconds{5};
+        case MSG_ISLOCK:
+            return std::chrono::seconds{10};
+        default:
+            return GETDATA_TX_INTERVAL;
+    }
+}
+
+std::chrono::microseconds GetObjectExpiryInterval(int invType)
+{
+    return GetObjectInterval(invType) * TX_EXPIRY_INTERVAL_FACTOR;
+}
+
+static std::chrono::microseconds GetObjectRandomDelay(int invType)
+{
+    if (invType == MSG_TX) {
+        return GetRandMicros(MAX_GETDATA_RANDOM_DELAY);
+    }
+    return {};
+}
+
+CObjectRequestScheduler::CObjectRequestScheduler() :
+    mapRequestTimes(MAX_INV_SZ, MAX_INV_SZ * 2),
+    mapErasedRequests(MAX_INV_SZ, MAX_INV_SZ * 2)
+{
+}
+
+size_t CObjectRequestScheduler::GetObjectPriority(int invType)
+{
+    switch (invType) {
+        case MSG_CLSIG:
+        case MSG_ISLOCK:
+            return 0;
+        case MSG_QUORUM_FINAL_COMMITMENT:
+        case MSG_QUORUM_CONTRIB:
+        case MSG_QUORUM_COMPLAINT:
+        case MSG_QUORUM_JUSTIFICATION:
+        case MSG_QUORUM_PREMATURE_COMMITMENT:
+        case MSG_QUORUM_RECOVERED_SIG:
+            return 1;
+        case MSG_GOVERNANCE_OBJECT:
+        case MSG_GOVERNANCE_OBJECT_VOTE:
+            return 3;
+        default:
+            return 2;
+    }
+}
+
+void CObjectRequestScheduler::AddPeer(NodeId nodeId)
+{
+    LOCK(cs);
+    mapPeers.emplace(nodeId, PeerState());
+}
+
+void CObjectRequestScheduler::RemovePeer(NodeId nodeId)
+{
+    LOCK(cs);
+    mapPeers.erase(nodeId);
+}
+
+void CObjectRequestScheduler::SetPreferred(NodeId nodeId, bool fPreferred)
+{
+    LOCK(cs);
+    auto it = mapPeers.find(nodeId);
+    if (it != mapPeers.end()) {
+        it->second.fPreferred = fPreferred;
+    }
+}
+
+std::chrono::microseconds CObjectRequestScheduler::GetRequestTime(const uint256& hash) const
+{
+    AssertLockHeld(cs);
+    auto it = mapRequestTimes.find(hash);
+    if (it != mapRequestTimes.end()) {
+        return it->second;
+    }
+    return {};
+}
+
+std::chrono::microseconds CObjectRequestScheduler::CalculateGetDataTime(const PeerState& peer, const CInv& inv, std::chrono::microseconds current_time) const
+{
+    AssertLockHeld(cs);
+    std::chrono::microseconds process_time;
+    const auto last_request_time = GetRequestTime(inv.hash);
+    // First time requesting this object
+    if (last_request_time.count() == 0) {
+        process_time = current_time;
+    } else {
+        // Randomize the delay to avoid biasing some peers over others (such as due to
+        // fixed ordering of peer processing in ThreadMessageHandler)
+        process_time = last_request_time + GetObjectInterval(inv.type) + GetObjectRandomDelay(inv.type);
+    }
+
+    // We delay processing announcements from inbound peers
+    if (inv.type == MSG_TX && !fMasternodeMode && !peer.fPreferred) process_time += INBOUND_PEER_TX_DELAY;
+
+    return process_time;
+}
+
+void CObjectRequestScheduler::Schedule(PeerState& peer, const CInv& inv, std::chrono::microseconds process_time)
+{
+    AssertLockHeld(cs);
+    peer.vecScheduled[GetObjectPriority(inv.type)].emplace(process_time, inv);
+    peer.nScheduled++;
+}
+
+void CObjectRequestScheduler::EraseInFlight(PeerState& peer, const CInv& inv)
+{
+    auto it = peer.mapInFlight.find(inv);
+    if (it != peer.mapInFlight.end()) {
+        peer.mapInFlightExpiry.erase(it->second);
+        peer.mapInFlight.erase(it);
+    }
+}
+
+void CObjectRequestScheduler::ExpireInFlight(NodeId nodeId, PeerState& peer, std::chrono::microseconds current_time)
+{
+    AssertLockHeld(cs);
+    // For robustness, expire old requests after a long timeout, so that
+    // we can resume downloading objects from a peer even if they
+    // were unresponsive in the past.
+    // Eventually we should consider disconnecting peers, but this is
+    // conservative.
+    while (!peer.mapInFlightExpiry.empty() && peer.mapInFlightExpiry.begin()->first <= current_time) {
+        const CInv inv = peer.mapInFlightExpiry.begin()->second;
+        LogPrint(BCLog::NET, "timeout of inflight object %s from peer=%d\n", inv.ToString(), nodeId);
+        peer.setAnnounced.erase(inv);
+        peer.mapInFlight.erase(inv);
+        peer.mapInFlightExpiry.erase(peer.mapInFlightExpiry.begin());
+        nTimedOut++;
+    }
+}
+
+void CObjectRequestScheduler::RequestObject(NodeId nodeId, const CInv& inv, std::chrono::microseconds current_time, bool fForce)
+{
+    LOCK(cs);
+    auto it = mapPeers.find(nodeId);
+    if (it == mapPeers.end()) {
+        return;
+    }
+    PeerState& peer = it->second;
+    if (peer.setAnnounced.size() >= MAX_PEER_OBJECT_ANNOUNCEMENTS ||
+            peer.nScheduled >= MAX_PEER_OBJECT_ANNOUNCEMENTS ||
+            peer.setAnnounced.count(inv)) {
+        // Too many queued announcements from this peer, or we already have
+        // this announcement
+        return;
+    }
+    peer.setAnnounced.insert(inv);
+
+    std::chrono::microseconds process_time = CalculateGetDataTime(peer, inv, current_time);
+    Schedule(peer, inv, process_time);
+
+    if (fForce) {
+        // make sure this object is actually requested ASAP
+        mapErasedRequests.erase(inv.hash);
+        mapRequestTimes.erase(inv.hash);
+    }
+
+    LogPrint(BCLog::NET, "%s -- inv=(%s), current_time=%d, process_time=%d, delta=%d\n", __func__, inv.ToString(), current_time.count(), process_time.count(), (process_time - current_time).count());
+}
+
+void CObjectRequestScheduler::EraseObjectRequest(NodeId nodeId, const CInv& inv)
+{
+    LOCK(cs);
+    LogPrint(BCLog::NET, "%s -- inv=(%s)\n", __func__, inv.ToString());
+    mapRequestTimes.erase(inv.hash);
+    mapErasedRequests.insert_or_update(std::make_pair(inv.hash, GetTime<std::chrono::microseconds>()));
+
+    auto it = mapPeers.find(nodeId);
+    if (it != mapPeers.end()) {
+        it->second.setAnnounced.erase(inv);
+        EraseInFlight(it->second, inv);
+    }
+}
+
+bool CObjectRequestScheduler::ReceivedNotFound(NodeId nodeId, const CInv& inv)
+{
+    LOCK(cs);
+    auto it = mapPeers.find(nodeId);
+    if (it == mapPeers.end() || !it->second.mapInFlight.count(inv)) {
+        return false;
+    }
+    EraseInFlight(it->second, inv);
+    it->second.setAnnounced.erase(inv);
+    nNotFound++;
+    return true;
+}
+
+void CObjectRequestScheduler::GetRequests(NodeId nodeId, std::chrono::microseconds current_time, const std::function<bool(const CInv&)>& fAlreadyHave, std::vector<CInv>& vRet)
+{
+    while (true) {
+        // Take the due announcements, highest priority first, but only as many as there are free in-flight slots
+        std::vector<CInv> vCandidates;
+        {
+            LOCK(cs);
+            auto it = mapPeers.find(nodeId);
+            if (it == mapPeers.end()) {
+                return;
+            }
+            PeerState& peer = it->second;
+            ExpireInFlight(nodeId, peer, current_time);
+
+            size_t nFree = peer.mapInFlight.size() < (size_t)MAX_PEER_OBJECT_IN_FLIGHT ? MAX_PEER_OBJECT_IN_FLIGHT - peer.mapInFlight.size() : 0;
+            for (auto& scheduled : peer.vecScheduled) {
+                while (vCandidates.size() < nFree && !scheduled.empty() && scheduled.begin()->first <= current_time) {
+                    const CInv inv = scheduled.begin()->second;
+                    // Erase this entry (it may be added back for processing at a later time, see below)
+                    scheduled.erase(scheduled.begin());
+                    peer.nScheduled--;
+                    if (mapErasedRequests.count(inv.hash)) {
+                        LogPrint(BCLog::NET, "%s -- GETDATA skipping inv=(%s), peer=%d\n", __func__, inv.ToString(), nodeId);
+                        peer.setAnnounced.erase(inv);
+                        EraseInFlight(peer, inv);
+                        continue;
+                    }
+                    vCandidates.emplace_back(inv);
+                }
+            }
+        }
+        if (vCandidates.empty()) {
+            return;
+        }
+
+        // Checked without holding cs, as fAlreadyHave might need locks which are held while calling into us
+        std::vector<bool> vAlreadyHave;
+        vAlreadyHave.reserve(vCandidates.size());
+        for (const auto& inv : vCandidates) {
+            vAlreadyHave.emplace_back(fAlreadyHave(inv));
+        }
+
+        LOCK(cs);
+        auto it = mapPeers.find(nodeId);
+        if (it == mapPeers.end()) {
+            return;
+        }
+        PeerState& peer = it->second;
+        for (size_t i = 0; i < vCandidates.size(); i++) {
+            const CInv& inv = vCandidates[i];
+            if (vAlreadyHave[i]) {
+                // We have already seen this object, no need to download.
+                peer.setAnnounced.erase(inv);
+                EraseInFlight(peer, inv);
+                LogPrint(BCLog::NET, "%s -- GETDATA already seen inv=(%s), peer=%d\n", __func__, inv.ToString(), nodeId);
+                continue;
+            }
+            // If this object was last requested more than GetObjectInterval ago,
+            // then request.
+            const auto last_request_time = GetRequestTime(inv.hash);
+            if (last_request_time <= current_time - GetObjectInterval(inv.type)) {
+                LogPrint(BCLog::NET, "Requesting %s peer=%d\n", inv.ToString(), nodeId);
+                vRet.emplace_back(inv);
+                mapRequestTimes.insert_or_update(std::make_pair(inv.hash, current_time));
+                EraseInFlight(peer, inv);
+                auto itExpiry = peer.mapInFlightExpiry.emplace(current_time + GetObjectExpiryInterval(inv.type), inv);
+                peer.mapInFlight.emplace(inv, itExpiry);
+                nRequested++;
+            } else {
+                // This object is in flight from someone else; queue
+                // up processing to happen after the download times out
+                // (with a slight delay for inbound peers, to prefer
+                // requests to outbound peers).
+                const auto next_process_time = CalculateGetDataTime(peer, inv, current_time);
+                Schedule(peer, inv, next_process_time);
+                LogPrint(BCLog::NET, "%s -- GETDATA re-queue inv=(%s), next_process_time=%d, delta=%d, peer=%d\n", __func__, inv.ToString(), next_process_time.count(), (next_process_time - current_time).count(), nodeId);
+            }
+        }
+    }
+}
+
+size_t CObjectRequestScheduler::GetScheduledCount(NodeId nodeId) const
+{
+    LOCK(cs);
+    auto it = mapPeers.find(nodeId);
+    if (it == mapPeers.end()) {
+        return 0;
+    }
+    return it->second.nScheduled;
+}
+
+CObjectRequestScheduler::Stats CObjectRequestScheduler::GetStats() const
+{
+    LOCK(cs);
+    Stats stats;
+    stats.nPeers = mapPeers.size();
+    for (const auto& p : mapPeers) {
+        stats.nAnnounced += p.second.setAnnounced.size();
+        stats.nScheduled += p.second.nScheduled;
+        stats.nInFlight += p.second.mapInFlight.size();
+    }
+    stats.nRequestTimes = mapRequestTimes.size();
+    stats.nRequested = nRequested;
+    stats.nTimedOut = nTimedOut;
+    stats.nNotFound = nNotFound;
+    return stats;
+}
@@ -0,0 +1,149 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_OBJECTREQUEST_H
+#define BITCOIN_OBJECTREQUEST_H
+
+#include <limitedmap.h>
+#include <net.h>
+#include <protocol.h>
+#include <saltedhasher.h>
+#include <sync.h>
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+/** Maximum number of in-flight objects from a peer */
+static constexpr int32_t MAX_PEER_OBJECT_IN_FLIGHT = 100;
+/** Maximum number of announced objects from a peer */
+static constexpr int32_t MAX_PEER_OBJECT_ANNOUNCEMENTS = 2 * MAX_INV_SZ;
+/** How many microseconds to delay requesting transactions from inbound peers */
+static constexpr std::chrono::microseconds INBOUND_PEER_TX_DELAY{std::chrono::seconds{2}};
+/** How long to wait (in microseconds) before downloading a transaction from an additional peer */
+static constexpr std::chrono::microseconds GETDATA_TX_INTERVAL{std::chrono::seconds{60}};
+/** Maximum delay (in microseconds) for transaction requests to avoid biasing some peers over others. */
+static constexpr std::chrono::microseconds MAX_GETDATA_RANDOM_DELAY{std::chrono::seconds{2}};
+/** How long to wait (expiry * factor microseconds) before expiring an in-flight getdata request to a peer */
+static constexpr int64_t TX_EXPIRY_INTERVAL_FACTOR = 10;
+static_assert(INBOUND_PEER_TX_DELAY >= MAX_GETDATA_RANDOM_DELAY,
+"To preserve security, MAX_GETDATA_RANDOM_DELAY should not exceed INBOUND_PEER_DELAY");
+
+std::chrono::microseconds GetObjectInterval(int invType);
+std::chrono::microseconds GetObjectExpiryInterval(int invType);
+
+/**
+ * Schedules GETDATA requests for announced objects (transactions and Dash specific messages).
+ *
+ * Download algorithm:
+ *
+ *   When an inv comes in, queue up (process_time, inv) for the peer as long as the peer didn't announce too many
+ *   objects already (MAX_PEER_OBJECT_ANNOUNCEMENTS). Each peer has one queue per priority class (see
+ *   GetObjectPriority), so that time critical messages like ISLOCKs and CLSIGs are requested before e.g. governance
+ *   votes when a peer has more due announcements than free in-flight slots.
+ *
+ *   The process_time for an object is set to nNow for outbound peers, nNow + 2 seconds for inbound peers (only for
+ *   transactions and not in masternode mode). This is the time at which we'll consider trying to request the object
+ *   from the peer. The delay for inbound peers is to allow outbound peers a chance to announce before we request from
+ *   inbound peers, to prevent an adversary from using inbound connections to blind us to an object (InvBlock).
+ *
+ *   GetRequests() looks at the objects whose process_time <= nNow. It requests each such object that we don't have
+ *   already and that hasn't been requested from another peer recently, up until the peer hits the
+ *   MAX_PEER_OBJECT_IN_FLIGHT limit. The time of the request is stored in a global map, which is used to coordinate
+ *   requests amongst our peers.
+ *
+ *   For objects that we still need but we have already recently requested from some other peer, (process_time, inv)
+ *   is reinserted at the point in the future at which the most recent GETDATA request would time out (ie
+ *   GetObjectInterval + the last request time), again with the additional delay for inbound peers. Transactions get an
+ *   extra small random delay up to 2 seconds to avoid biasing some peers over others.
+ *
+ *   In-flight requests are indexed by their expiry time, so that timed out requests can be expired in O(log n) without
+ *   scanning all of them. When we receive an object, EraseObjectRequest() removes it from the peer's in-flight and
+ *   announced sets and clears its request time, so that if somehow the object is not accepted but also not added to
+ *   the reject filter, we will eventually redownload it from other peers.
+ *
+ * The scheduler has its own lock, so none of its methods need cs_main. fAlreadyHave callbacks are called without
+ * holding it.
+ */
+class CObjectRequestScheduler
+{
+public:
+    static const size_t NUM_PRIORITIES = 4;
+
+    struct Stats {
+        size_t nPeers{0};
+        size_t nAnnounced{0};
+        size_t nScheduled{0};
+        size_t nInFlight{0};
+        size_t nRequestTimes{0};
+        uint64_t nRequested{0};
+        uint64_t nTimedOut{0};
+        uint64_t nNotFound{0};
+    };
+
+private:
+    typedef std::multimap<std::chrono::microseconds, CInv> TimeInvMap;
+
+    struct PeerState {
+        //! Whether this peer doesn't get INBOUND_PEER_TX_DELAY, see UpdatePreferredDownload
+        bool fPreferred{false};
+        //! All the objects the peer has recently announced
+        std::set<CInv> setAnnounced;
+        //! When to attempt downloading announced objects, by priority class
+        std::array<TimeInvMap, NUM_PRIORITIES> vecScheduled;
+        size_t nScheduled{0};
+        //! Objects which were requested from this peer, by expiry time of the request
+        TimeInvMap mapInFlightExpiry;
+        std::map<CInv, TimeInvMap::iterator> mapInFlight;
+    };
+
+    mutable CCriticalSection cs;
+    std::map<NodeId, PeerState> mapPeers GUARDED_BY(cs);
+    //! The time when objects were requested last time
+    unordered_limitedmap<uint256, std::chrono::microseconds, StaticSaltedHasher> mapRequestTimes GUARDED_BY(cs);
+    //! Objects which were received recently, announcements for them are dropped
+    unordered_limitedmap<uint256, std::chrono::microseconds, StaticSaltedHasher> mapErasedRequests GUARDED_BY(cs);
+    uint64_t nRequested GUARDED_BY(cs){0};
+    uint64_t nTimedOut GUARDED_BY(cs){0};
+    uint64_t nNotFound GUARDED_BY(cs){0};
+
+public:
+    CObjectRequestScheduler();
+
+    void AddPeer(NodeId nodeId);
+    void RemovePeer(NodeId nodeId);
+    void SetPreferred(NodeId nodeId, bool fPreferred);
+
+    /** Schedules a request for an object announced by nodeId. fForce ignores earlier requests from other peers. */
+    void RequestObject(NodeId nodeId, const CInv& inv, std::chrono::microseconds current_time, bool fForce = false);
+    /** Called when the object was received, from nodeId or from an unknown source if nodeId is -1 */
+    void EraseObjectRequest(NodeId nodeId, const CInv& inv);
+    /** Called when nodeId sent NOTFOUND for inv, returns false if we didn't request it from this peer */
+    bool ReceivedNotFound(NodeId nodeId, const CInv& inv);
+
+    /**
+     * Expires timed out requests of nodeId and appends the objects which should be requested from it now to vRet.
+     * fAlreadyHave is used to drop announcements of objects we have already.
+     */
+    void GetRequests(NodeId nodeId, std::chrono::microseconds current_time, const std::function<bool(const CInv&)>& fAlreadyHave, std::vector<CInv>& vRet);
+
+    /** Number of announcements of nodeId which are waiting to be requested */
+    size_t GetScheduledCount(NodeId nodeId) const;
+    Stats GetStats() const;
+
+    static size_t GetObjectPriority(int invType);
+
+private:
+    std::chrono::microseconds GetRequestTime(const uint256& hash) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    std::chrono::microseconds CalculateGetDataTime(const PeerState& peer, const CInv& inv, std::chrono::microseconds current_time) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void Schedule(PeerState& peer, const CInv& inv, std::chrono::microseconds process_time) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    static void EraseInFlight(PeerState& peer, const CInv& inv);
+    void ExpireInFlight(NodeId nodeId, PeerState& peer, std::chrono::microseconds current_time) EXCLUSIVE_LOCKS_REQUIRED(cs);
+};
+
+#endif // BITCOIN_OBJECTREQUEST_H
@@ -9,11 +9,13 @@
 #include <policy/feerate.h>
 #include <uint256.h>
 #include <random.h>
+#include <saltedhasher.h>
 #include <sync.h>
 
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class CAutoFile;
@@ -243,7 +245,7 @@ private:
     };
 
     // map of txids to information about that transaction
-    std::map<uint256, TxStatsInfo> mapMemPoolTxs;
+    std::unordered_map<uint256, TxStatsInfo, StaticSaltedHasher> mapMemPoolTxs;
 
     /** Classes to track historical data on transaction confirmations */
     std::unique_ptr<TxConfirmStats> feeStats;
@@ -11,6 +11,8 @@
 #include <utilstrencodings.h>
 #include <crypto/common.h>
 
+#include <algorithm>
+
 uint256 CBlockHeader::GetHash() const
 {
     std::vector<unsigned char> vch(80);
@@ -19,6 +21,19 @@ uint256 CBlockHeader::GetHash() const
     return HashX11((const char *)vch.data(), (const char *)vch.data() + vch.size());
 }
 
+void HashX11Multi(const CBlockHeader* headers, size_t n, uint256* out)
+{
+    for (size_t i = 0; i < n; i += X11_MULTI_LANES) {
+        const size_t lanes = std::min(X11_MULTI_LANES, n - i);
+        std::vector<unsigned char> vch(80 * lanes);
+        CVectorWriter ss(SER_GETHASH, PROTOCOL_VERSION, vch, 0);
+        for (size_t j = 0; j < lanes; j++) {
+            ss << headers[i + j];
+        }
+        HashX11Multi(vch.data(), 80, lanes, out + i);
+    }
+}
+
 std::string CBlock::ToString() const
 {
     std::stringstream s;
@@ -153,4 +153,7 @@ struct CBlockLocator
     }
 };
 
+/** Compute the hashes of n block headers at once, see HashX11Multi in hash.h. */
+void HashX11Multi(const CBlockHeader* headers, size_t n, uint256* out);
+
 #endif // BITCOIN_PRIMITIVES_BLOCK_H
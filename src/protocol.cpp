@@ -40,6 +40,12 @@ const char *SENDCMPCT="sendcmpct";
 const char *CMPCTBLOCK="cmpctblock";
 const char *GETBLOCKTXN="getblocktxn";
 const char *BLOCKTXN="blocktxn";
+const char *GETCFILTERS="getcfilters";
+const char *CFILTER="cfilter";
+const char *GETCFHEADERS="getcfheaders";
+const char *CFHEADERS="cfheaders";
+const char *GETCFCHECKPT="getcfcheckpt";
+const char *CFCHECKPT="cfcheckpt";
 // Dash message types
 const char *LEGACYTXLOCKREQUEST="ix";
 const char *SPORK="spork";
@@ -53,10 +59,13 @@ const char *DSSTATUSUPDATE="dssu";
 const char *DSTX="dstx";
 const char *DSQUEUE="dsq";
 const char *SENDDSQUEUE="senddsq";
+const char *SENDCMPCTHDR="sendcmpcthdr";
 const char *SYNCSTATUSCOUNT="ssc";
 const char *MNGOVERNANCESYNC="govsync";
 const char *MNGOVERNANCEOBJECT="govobj";
 const char *MNGOVERNANCEOBJECTVOTE="govobjvote";
+const char *MNGOVERNANCERECON="govrecon";
+const char *MNGOVERNANCERECONFAIL="govreconfail";
 const char *GETMNLISTDIFF="getmnlistd";
 const char *MNLISTDIFF="mnlistdiff";
 const char *QSENDRECSIGS="qsendrecsigs";
@@ -108,12 +117,19 @@ const static std::string allNetMessageTypes[] = {
     NetMsgType::CMPCTBLOCK,
     NetMsgType::GETBLOCKTXN,
     NetMsgType::BLOCKTXN,
+    NetMsgType::GETCFILTERS,
+    NetMsgType::CFILTER,
+    NetMsgType::GETCFHEADERS,
+    NetMsgType::CFHEADERS,
+    NetMsgType::GETCFCHECKPT,
+    NetMsgType::CFCHECKPT,
     // Dash message types
     // NOTE: do NOT include non-implmented here, we want them to be "Unknown command" in ProcessMessage()
     NetMsgType::LEGACYTXLOCKREQUEST,
     NetMsgType::SPORK,
     NetMsgType::GETSPORKS,
     NetMsgType::SENDDSQUEUE,
+    NetMsgType::SENDCMPCTHDR,
     NetMsgType::DSACCEPT,
     NetMsgType::DSVIN,
     NetMsgType::DSFINALTX,
@@ -126,6 +142,8 @@ const static std::string allNetMessageTypes[] = {
     NetMsgType::MNGOVERNANCESYNC,
     NetMsgType::MNGOVERNANCEOBJECT,
     NetMsgType::MNGOVERNANCEOBJECTVOTE,
+    NetMsgType::MNGOVERNANCERECON,
+    NetMsgType::MNGOVERNANCERECONFAIL,
     NetMsgType::GETMNLISTDIFF,
     NetMsgType::MNLISTDIFF,
     NetMsgType::QSENDRECSIGS,
@@ -149,6 +167,34 @@ const static std::string allNetMessageTypes[] = {
 };
 const static std::vector<std::string> allNetMessageTypesVec(allNetMessageTypes, allNetMessageTypes+ARRAYLEN(allNetMessageTypes));
 
+/** Message types with a short id for compact message headers, the id is the position in this list plus one.
+ * This is part of the protocol, only ever append to it. Peers announce how many of them they know in SENDCMPCTHDR.
+ */
+const static char* shortNetMessageTypes[] = {
+    NetMsgType::INV,
+    NetMsgType::GETDATA,
+    NetMsgType::NOTFOUND,
+    NetMsgType::PING,
+    NetMsgType::PONG,
+    NetMsgType::TX,
+    NetMsgType::HEADERS,
+    NetMsgType::CMPCTBLOCK,
+    NetMsgType::GETBLOCKTXN,
+    NetMsgType::BLOCKTXN,
+    NetMsgType::DSQUEUE,
+    NetMsgType::DSTX,
+    NetMsgType::MNGOVERNANCEOBJECTVOTE,
+    NetMsgType::QSIGSESANN,
+    NetMsgType::QSIGSHARESINV,
+    NetMsgType::QGETSIGSHARES,
+    NetMsgType::QBSIGSHARES,
+    NetMsgType::QSIGREC,
+    NetMsgType::QSIGSHARE,
+    NetMsgType::CLSIG,
+    NetMsgType::ISLOCK,
+};
+static_assert(ARRAYLEN(shortNetMessageTypes) <= MAX_SHORT_NET_MSG_TYPE_ID, "too many short message type ids");
+
 CMessageHeader::CMessageHeader(const MessageStartChars& pchMessageStartIn)
 {
     memcpy(pchMessageStart, pchMessageStartIn, MESSAGE_START_SIZE);
@@ -202,6 +248,29 @@ bool CMessageHeader::IsValid(const MessageStartChars& pchMessageStartIn) const
 }
 
 
+uint8_t GetShortNetMsgTypeCount()
+{
+    return ARRAYLEN(shortNetMessageTypes);
+}
+
+uint8_t GetShortNetMsgTypeId(const std::string& strCommand)
+{
+    for (size_t i = 0; i < ARRAYLEN(shortNetMessageTypes); i++) {
+        if (strCommand == shortNetMessageTypes[i]) {
+            return (uint8_t)(i + 1);
+        }
+    }
+    return 0;
+}
+
+const char* GetNetMsgTypeFromShortId(uint8_t nShortId)
+{
+    if (nShortId == 0 || nShortId > ARRAYLEN(shortNetMessageTypes)) {
+        return nullptr;
+    }
+    return shortNetMessageTypes[nShortId - 1];
+}
+
 ServiceFlags GetDesirableServiceFlags(ServiceFlags services) {
     if ((services & NODE_NETWORK_LIMITED) && g_initial_block_download_completed) {
         return ServiceFlags(NODE_NETWORK_LIMITED);
@@ -7,7 +7,11 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <core_io.h>
+#include <evo/simplifiedmns.h>
+#include <hash.h>
 #include <httpserver.h>
+#include <llmq/quorums_chainlocks.h>
+#include <llmq/quorums_instantsend.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <rpc/blockchain.h>
@@ -68,6 +72,16 @@ static bool RESTERR(HTTPRequest* req, enum HTTPStatusCode status, std::string me
     return false;
 }
 
+/** Writes a JSON reply, large ones are streamed in chunks while they are serialized */
+static bool RESTJSONReply(HTTPRequest* req, const UniValue& value)
+{
+    req->WriteHeader("Content-Type", "application/json");
+    JSONStreamWriter writer([req](const std::string& strChunk) { req->WriteReplyChunk(HTTP_OK, strChunk); });
+    writer.Write(value).WriteRaw("\n");
+    req->WriteReply(HTTP_OK, writer.Finish());
+    return true;
+}
+
 static RetFormat ParseDataFormat(std::string& param, const std::string& strReq)
 {
     const std::string::size_type pos = strReq.rfind('.');
@@ -122,6 +136,28 @@ static bool CheckWarmup(HTTPRequest* req)
     return true;
 }
 
+/**
+ * Set the ETag and caching headers of a response, the ETag is made of strKey and the format. Responses
+ * for explicitly requested blocks can be cached, all others have to be revalidated with the ETag.
+ * Returns true if the client already has the response, 304 Not Modified was sent then.
+ */
+static bool RESTNotModified(HTTPRequest* req, const std::string& strKey, RetFormat rf, bool fCacheable)
+{
+    std::string strETag;
+    for (unsigned int i = 0; i < ARRAYLEN(rf_names); i++)
+        if (rf_names[i].rf == rf)
+            strETag = strprintf("\"%s.%s\"", strKey, rf_names[i].name);
+
+    req->WriteHeader("ETag", strETag);
+    req->WriteHeader("Cache-Control", fCacheable ? "public, max-age=3600" : "no-cache");
+    std::pair<bool, std::string> ifNoneMatch = req->GetHeader("If-None-Match");
+    if (ifNoneMatch.first && ifNoneMatch.second == strETag) {
+        req->WriteReply(HTTP_NOT_MODIFIED);
+        return true;
+    }
+    return false;
+}
+
 static bool rest_headers(HTTPRequest* req,
                          const std::string& strURIPart)
 {
@@ -248,10 +284,7 @@ static bool rest_block(HTTPRequest* req,
             LOCK(cs_main);
             objBlock = blockToJSON(block, pblockindex, showTxDetails);
         }
-        std::string strJSON = objBlock.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
-        return true;
+        return RESTJSONReply(req, objBlock);
     }
 
     default: {
@@ -328,11 +361,7 @@ static bool rest_mempool_contents(HTTPRequest* req, const std::string& strURIPar
     switch (rf) {
     case RetFormat::JSON: {
         UniValue mempoolObject = mempoolToJSON(true);
-
-        std::string strJSON = mempoolObject.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
-        return true;
+        return RESTJSONReply(req, mempoolObject);
     }
     default: {
         return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
@@ -573,6 +602,180 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
     }
 }
 
+static bool rest_mnlistdiff(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    if (path.size() != 2)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Use /rest/mnlistdiff/<basehash>/<blockhash|tip>.<ext>.");
+    if (rf == RetFormat::UNDEF)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+
+    uint256 baseBlockHash;
+    if (!ParseHashStr(path[0], baseBlockHash))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + path[0]);
+    const bool fTip = path[1] == "tip";
+    uint256 blockHash;
+    if (!fTip && !ParseHashStr(path[1], blockHash))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + path[1]);
+    if (fTip) {
+        blockHash = chainActive.TipNoLock()->GetBlockHash();
+    }
+
+    if (RESTNotModified(req, baseBlockHash.ToString() + "." + blockHash.ToString(), rf, !fTip))
+        return true;
+
+    // the same serialization and cache as for MNLISTDIFF messages
+    std::vector<unsigned char> data;
+    std::string strError;
+    {
+        LOCK(cs_main);
+        if (!mnListDiffCache.GetSerializedDiff(baseBlockHash, blockHash, PROTOCOL_VERSION, data, strError))
+            return RESTERR(req, HTTP_NOT_FOUND, strError);
+    }
+
+    switch (rf) {
+    case RetFormat::BINARY: {
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, std::string(data.begin(), data.end()));
+        return true;
+    }
+    case RetFormat::HEX: {
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, HexStr(data) + "\n");
+        return true;
+    }
+    case RetFormat::JSON: {
+        CSimplifiedMNListDiff mnListDiff;
+        CDataStream(data, SER_NETWORK, PROTOCOL_VERSION) >> mnListDiff;
+        UniValue objDiff;
+        mnListDiff.ToJson(objDiff);
+        return RESTJSONReply(req, objDiff);
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
+static bool rest_chainlock(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (rf == RetFormat::UNDEF)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+
+    const llmq::CChainLockSig clsig = llmq::chainLocksHandler->GetBestChainLock();
+    if (clsig.IsNull())
+        return RESTERR(req, HTTP_NOT_FOUND, "no chainlock known yet");
+
+    if (RESTNotModified(req, clsig.blockHash.ToString(), rf, false))
+        return true;
+
+    // the same serialization as CLSIG messages
+    CDataStream ssCLSig(SER_NETWORK, PROTOCOL_VERSION);
+    ssCLSig << clsig;
+
+    switch (rf) {
+    case RetFormat::BINARY: {
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, ssCLSig.str());
+        return true;
+    }
+    case RetFormat::HEX: {
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, HexStr(ssCLSig.begin(), ssCLSig.end()) + "\n");
+        return true;
+    }
+    case RetFormat::JSON: {
+        UniValue objCLSig(UniValue::VOBJ);
+        objCLSig.pushKV("blockhash", clsig.blockHash.GetHex());
+        objCLSig.pushKV("height", clsig.nHeight);
+        objCLSig.pushKV("signature", clsig.sig.ToString());
+        return RESTJSONReply(req, objCLSig);
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
+static bool rest_txlock(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string hashStr;
+    const RetFormat rf = ParseDataFormat(hashStr, strURIPart);
+
+    uint256 txid;
+    if (!ParseHashStr(hashStr, txid))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
+
+    llmq::CInstantSendLockPtr islock = llmq::quorumInstantSendManager->GetInstantSendLockByTxid(txid);
+
+    switch (rf) {
+    case RetFormat::BINARY:
+    case RetFormat::HEX: {
+        // the same serialization as ISLOCK messages, a lock never changes once it exists
+        if (!islock)
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " is not locked");
+        if (RESTNotModified(req, ::SerializeHash(*islock).ToString(), rf, true))
+            return true;
+        CDataStream ssISLock(SER_NETWORK, PROTOCOL_VERSION);
+        ssISLock << *islock;
+        if (rf == RetFormat::BINARY) {
+            req->WriteHeader("Content-Type", "application/octet-stream");
+            req->WriteReply(HTTP_OK, ssISLock.str());
+        } else {
+            req->WriteHeader("Content-Type", "text/plain");
+            req->WriteReply(HTTP_OK, HexStr(ssISLock.begin(), ssISLock.end()) + "\n");
+        }
+        return true;
+    }
+    case RetFormat::JSON: {
+        CTransactionRef tx;
+        uint256 hashBlock;
+        if (!GetTransaction(txid, tx, Params().GetConsensus(), hashBlock, true))
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+
+        // the chainlock status can change with every block
+        if (RESTNotModified(req, txid.ToString() + "." + chainActive.TipNoLock()->GetBlockHash().ToString() + "." + (islock ? "1" : "0"), rf, false))
+            return true;
+
+        bool fChainLock = false;
+        int nHeight = -1;
+        if (!hashBlock.IsNull()) {
+            LOCK(cs_main);
+            const CBlockIndex* pindex = LookupBlockIndex(hashBlock);
+            if (pindex && chainActive.Contains(pindex)) {
+                nHeight = pindex->nHeight;
+            }
+        }
+        if (nHeight != -1) {
+            fChainLock = llmq::chainLocksHandler->HasChainLock(nHeight, hashBlock);
+        }
+
+        UniValue objLock(UniValue::VOBJ);
+        objLock.pushKV("txid", txid.GetHex());
+        objLock.pushKV("height", nHeight);
+        objLock.pushKV("instantlock", islock != nullptr || fChainLock);
+        objLock.pushKV("instantlock_internal", islock != nullptr);
+        objLock.pushKV("chainlock", fChainLock);
+        return RESTJSONReply(req, objLock);
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(HTTPRequest* req, const std::string& strReq);
@@ -585,6 +788,9 @@ static const struct {
       {"/rest/mempool/contents", rest_mempool_contents},
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
+      {"/rest/mnlistdiff/", rest_mnlistdiff},
+      {"/rest/chainlock", rest_chainlock},
+      {"/rest/txlock/", rest_txlock},
 };
 
 bool StartREST()
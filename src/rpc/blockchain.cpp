@@ -5,27 +5,35 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <rpc/blockchain.h>
+#include <rpc/blockreader.h>
 
 #include <amount.h>
+#include <blockfilter.h>
 #include <chainparams.h>
 #include <checkpoints.h>
 #include <coins.h>
 #include <node/coinstats.h>
+#include <node/utxo_snapshot.h>
 #include <core_io.h>
 #include <consensus/validation.h>
+#include <fs.h>
 #include <validation.h>
 // #include <rpc/index/txindex.h>
 #include <policy/feerate.h>
 #include <policy/policy.h>
 #include <primitives/transaction.h>
 #include <rpc/server.h>
+#include <script/sigcache.h>
 #include <streams.h>
 #include <sync.h>
 #include <txdb.h>
 #include <txmempool.h>
+#include <txrelaycache.h>
 #include <util.h>
 #include <utilstrencodings.h>
 #include <hash.h>
+#include <index/blockfilterindex.h>
+#include <index/extraindexes.h>
 #include <validationinterface.h>
 #include <warnings.h>
 
@@ -190,8 +198,9 @@ UniValue getblockcount(const JSONRPCRequest& request)
             + HelpExampleRpc("getblockcount", "")
         );
 
-    LOCK(cs_main);
-    return chainActive.Height();
+    // doesn't need cs_main, so it's not held up by validation
+    const CBlockIndex* pindexTip = chainActive.TipNoLock();
+    return pindexTip ? pindexTip->nHeight : -1;
 }
 
 UniValue getbestblockhash(const JSONRPCRequest& request)
@@ -207,8 +216,7 @@ UniValue getbestblockhash(const JSONRPCRequest& request)
             + HelpExampleRpc("getbestblockhash", "")
         );
 
-    LOCK(cs_main);
-    return chainActive.Tip()->GetBlockHash().GetHex();
+    return chainActive.TipNoLock()->GetBlockHash().GetHex();
 }
 
 UniValue getbestchainlock(const JSONRPCRequest& request)
@@ -238,8 +246,15 @@ UniValue getbestchainlock(const JSONRPCRequest& request)
     result.pushKV("height", clsig.nHeight);
     result.pushKV("signature", clsig.sig.ToString());
 
-    LOCK(cs_main);
-    result.pushKV("known_block", mapBlockIndex.count(clsig.blockHash) > 0);
+    // the chainlocked block is usually in the active chain, which can be checked without cs_main
+    const CBlockIndex* pindexTip = chainActive.TipNoLock();
+    const CBlockIndex* pindexAncestor = pindexTip ? pindexTip->GetAncestor(clsig.nHeight) : nullptr;
+    if (pindexAncestor && pindexAncestor->GetBlockHash() == clsig.blockHash) {
+        result.pushKV("known_block", true);
+    } else {
+        LOCK(cs_main);
+        result.pushKV("known_block", mapBlockIndex.count(clsig.blockHash) > 0);
+    }
     return result;
 }
 
@@ -403,8 +418,7 @@ UniValue getdifficulty(const JSONRPCRequest& request)
             + HelpExampleRpc("getdifficulty", "")
         );
 
-    LOCK(cs_main);
-    return GetDifficulty(chainActive.Tip());
+    return GetDifficulty(chainActive.TipNoLock());
 }
 
 std::string EntryDescriptionString()
@@ -475,7 +489,7 @@ void entryToJSON(UniValue &info, const CTxMemPoolEntry &e) EXCLUSIVE_LOCKS_REQUI
 
     UniValue spent(UniValue::VARR);
     const CTxMemPool::txiter &it = mempool.mapTx.find(tx.GetHash());
-    const CTxMemPool::setEntries &setChildren = mempool.GetMemPoolChildren(it);
+    const CTxMemPool::vecEntries &setChildren = mempool.GetMemPoolChildren(it);
     for (const CTxMemPool::txiter &childiter : setChildren) {
         spent.push_back(childiter->GetTx().GetHash().ToString());
     }
@@ -727,6 +741,10 @@ UniValue getblockhashes(const JSONRPCRequest& request)
     unsigned int low = request.params[1].get_int();
     std::vector<uint256> blockHashes;
 
+    if (g_timestampindex) {
+        g_timestampindex->BlockUntilSyncedToCurrentChain();
+    }
+
     if (!GetTimestampIndex(high, low, blockHashes)) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for block hashes");
     }
@@ -953,8 +971,6 @@ UniValue getmerkleblocks(const JSONRPCRequest& request)
             + HelpExampleRpc("getmerkleblocks", "\"2303028005802040100040000008008400048141010000f8400420800080025004000004130000000000000001\" \"00000000007e1432d2af52e8463278bf556b55cf5049262f25634557e2e91202\" 2000")
         );
 
-    LOCK(cs_main);
-
     CBloomFilter filter;
     std::string strFilter = request.params[0].get_str();
     CDataStream ssBloomFilter(ParseHex(strFilter), SER_NETWORK, PROTOCOL_VERSION);
@@ -967,10 +983,6 @@ UniValue getmerkleblocks(const JSONRPCRequest& request)
     std::string strHash = request.params[1].get_str();
     uint256 hash(uint256S(strHash));
 
-    if (mapBlockIndex.count(hash) == 0) {
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
-    }
-
     int nCount = MAX_HEADERS_RESULTS;
     if (!request.params[2].isNull())
         nCount = request.params[2].get_int();
@@ -979,32 +991,38 @@ UniValue getmerkleblocks(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Count is out of range");
     }
 
-    CBlockIndex* pblockindex = mapBlockIndex[hash];
-    CBlock block = GetBlockChecked(pblockindex);
-
-    UniValue arrMerkleBlocks(UniValue::VARR);
-
-    for (; pblockindex; pblockindex = chainActive.Next(pblockindex))
+    std::vector<const CBlockIndex*> vIndexes;
     {
-        if (--nCount < 0) {
-            break;
+        LOCK(cs_main);
+        if (mapBlockIndex.count(hash) == 0) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
         }
-
-        if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus())) {
-            // this shouldn't happen, we already checked pruning case earlier
-            throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+        for (const CBlockIndex* pblockindex = mapBlockIndex[hash]; pblockindex && (int)vIndexes.size() < nCount; pblockindex = chainActive.Next(pblockindex)) {
+            vIndexes.emplace_back(pblockindex);
         }
+    }
 
+    // Filters which add matched outputs to themselves depend on all earlier
+    // blocks, the others aren't changed by matching and can be shared by the readers
+    const bool fUpdating = filter.IsUpdating();
+    std::vector<std::string> vMerkleBlocks(vIndexes.size());
+    ReadBlocksParallel(vIndexes, [&](size_t i, const CBlock& block) {
         CMerkleBlock merkleblock(block, filter);
         if (merkleblock.vMatchedTxn.empty()) {
             // ignore blocks that do not match the filter
-            continue;
+            return;
         }
 
         CDataStream ssMerkleBlock(SER_NETWORK, PROTOCOL_VERSION);
         ssMerkleBlock << merkleblock;
-        std::string strHex = HexStr(ssMerkleBlock);
-        arrMerkleBlocks.push_back(strHex);
+        vMerkleBlocks[i] = HexStr(ssMerkleBlock);
+    }, fUpdating ? 1 : MAX_RPC_BLOCK_READER_THREADS);
+
+    UniValue arrMerkleBlocks(UniValue::VARR);
+    for (const std::string& strHex : vMerkleBlocks) {
+        if (!strHex.empty()) {
+            arrMerkleBlocks.push_back(strHex);
+        }
     }
     return arrMerkleBlocks;
 }
@@ -1144,48 +1162,265 @@ UniValue pruneblockchain(const JSONRPCRequest& request)
     return uint64_t(height);
 }
 
-UniValue gettxoutsetinfo(const JSONRPCRequest& request)
+UniValue getdbstats(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 0)
         throw std::runtime_error(
-            "gettxoutsetinfo\n"
+            "getdbstats\n"
+            "\nReturns the LevelDB tuning and internal statistics of all open databases.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"name\": {                 (object) The database, e.g. chainstate or evodb\n"
+            "    \"options\": {             (object) The tuning the database was opened with, see -dbtune\n"
+            "      \"blockcache\": n,        (numeric) Size of the block cache in bytes\n"
+            "      \"writebuffer\": n,       (numeric) Size of the write buffer in bytes\n"
+            "      \"bloombits\": n,         (numeric) Bits per key of the bloom filter, 0 for none\n"
+            "      \"compression\": true|false, (boolean) Whether tables are compressed\n"
+            "      \"maxopenfiles\": n,      (numeric) Maximum number of open files, 0 for the default\n"
+            "      \"maxfilesize\": n,       (numeric) Size of table files in bytes\n"
+            "      \"blocksize\": n          (numeric) Size of table blocks in bytes\n"
+            "    },\n"
+            "    \"approximate_size\": n,   (numeric) The approximate size of the data on disk in bytes\n"
+            "    \"memory_usage\": n,       (numeric) The approximate memory used by LevelDB in bytes\n"
+            "    \"stats\": \"...\",          (string) The leveldb.stats property (compactions per level)\n"
+            "  }, ...\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getdbstats", "")
+            + HelpExampleRpc("getdbstats", "")
+        );
+
+    UniValue result(UniValue::VOBJ);
+    int nUnnamed = 0;
+    CDBWrapper::ForEachDB([&](const CDBWrapper& db) {
+        const CDBOptions& dbOptions = db.GetDBOptions();
+        UniValue options(UniValue::VOBJ);
+        options.pushKV("blockcache", (uint64_t)dbOptions.nBlockCacheSize);
+        options.pushKV("writebuffer", (uint64_t)dbOptions.nWriteBufferSize);
+        options.pushKV("bloombits", dbOptions.nBloomBits);
+        options.pushKV("compression", dbOptions.fCompression);
+        options.pushKV("maxopenfiles", dbOptions.nMaxOpenFiles);
+        options.pushKV("maxfilesize", (uint64_t)dbOptions.nMaxFileSize);
+        options.pushKV("blocksize", (uint64_t)dbOptions.nBlockSize);
+
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("options", options);
+        obj.pushKV("approximate_size", db.GetApproximateSize());
+        obj.pushKV("memory_usage", (uint64_t)db.DynamicMemoryUsage());
+        std::string strStats;
+        if (db.GetProperty("leveldb.stats", strStats)) {
+            obj.pushKV("stats", strStats);
+        }
+        // in-memory databases have no name
+        result.pushKV(db.GetName().empty() ? strprintf("memory%d", nUnnamed++) : db.GetName(), obj);
+    });
+    return result;
+}
+
+UniValue gettxoutsetinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 1)
+        throw std::runtime_error(
+            "gettxoutsetinfo ( \"hash_type\" )\n"
             "\nReturns statistics about the unspent transaction output set.\n"
-            "Note this call may take some time.\n"
+            "Note this call may take some time, unless hash_type is \"muhash\" and the node runs with -utxocommitment.\n"
+            "\nArguments:\n"
+            "1. \"hash_type\"    (string, optional, default=\"hash_serialized_2\") Which UTXO set hash should be calculated:\n"
+            "                    \"hash_serialized_2\" scans the coins on one thread, \"muhash\" and \"none\" on several threads.\n"
             "\nResult:\n"
             "{\n"
             "  \"height\":n,     (numeric) The current block height (index)\n"
             "  \"bestblock\": \"hex\",   (string) The hash of the block at the tip of the chain\n"
-            "  \"transactions\": n,      (numeric) The number of transactions with unspent outputs\n"
+            "  \"transactions\": n,      (numeric) The number of transactions with unspent outputs (not available for \"muhash\" with -utxocommitment)\n"
             "  \"txouts\": n,            (numeric) The number of unspent transaction outputs\n"
             "  \"bogosize\": n,          (numeric) A meaningless metric for UTXO set size\n"
-            "  \"hash_serialized_2\": \"hash\", (string) The serialized hash\n"
+            "  \"hash_serialized_2\": \"hash\", (string) The serialized hash (only present if 'hash_serialized_2' hash_type is chosen)\n"
+            "  \"muhash\": \"hash\",       (string) The MuHash of the UTXO set (only present if 'muhash' hash_type is chosen)\n"
             "  \"disk_size\": n,         (numeric) The estimated size of the chainstate on disk\n"
             "  \"total_amount\": x.xxx          (numeric) The total amount\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("gettxoutsetinfo", "")
+            + HelpExampleCli("gettxoutsetinfo", "\"muhash\"")
             + HelpExampleRpc("gettxoutsetinfo", "")
         );
 
+    const std::string strHashType = request.params[0].isNull() ? "hash_serialized_2" : request.params[0].get_str();
+    if (strHashType != "hash_serialized_2" && strHashType != "muhash" && strHashType != "none") {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("%s is not a valid hash_type", strHashType));
+    }
+
     UniValue ret(UniValue::VOBJ);
 
+    if (strHashType == "muhash") {
+        LOCK(cs_main);
+        if (g_coins_commitment) {
+            const CBlockIndex* pindex = LookupBlockIndex(g_coins_commitment->hashBlock);
+            ret.pushKV("height", pindex ? (int64_t)pindex->nHeight : 0);
+            ret.pushKV("bestblock", g_coins_commitment->hashBlock.GetHex());
+            ret.pushKV("txouts", (int64_t)g_coins_commitment->nTransactionOutputs);
+            ret.pushKV("bogosize", (int64_t)g_coins_commitment->nBogoSize);
+            ret.pushKV("muhash", g_coins_commitment->GetHash().GetHex());
+            ret.pushKV("disk_size", pcoinsdbview->EstimateSize());
+            ret.pushKV("total_amount", ValueFromAmount(g_coins_commitment->nTotalAmount));
+            return ret;
+        }
+    }
+
     CCoinsStats stats;
     FlushStateToDisk();
-    if (GetUTXOStats(pcoinsdbview.get(), stats)) {
-        ret.pushKV("height", (int64_t)stats.nHeight);
-        ret.pushKV("bestblock", stats.hashBlock.GetHex());
-        ret.pushKV("transactions", (int64_t)stats.nTransactions);
-        ret.pushKV("txouts", (int64_t)stats.nTransactionOutputs);
-        ret.pushKV("bogosize", (int64_t)stats.nBogoSize);
-        ret.pushKV("hash_serialized_2", stats.hashSerialized.GetHex());
-        ret.pushKV("disk_size", stats.nDiskSize);
-        ret.pushKV("total_amount", ValueFromAmount(stats.nTotalAmount));
+    if (strHashType == "hash_serialized_2") {
+        if (!GetUTXOStats(pcoinsdbview.get(), stats)) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
+        }
     } else {
-        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
+        CCoinsCommitment commitment;
+        if (!GetUTXOStatsParallel(pcoinsdbview.get(), stats, strHashType == "muhash" ? &commitment : nullptr, GetNumCores())) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
+        }
+        if (strHashType == "muhash") {
+            stats.hashSerialized = commitment.GetHash();
+        }
+    }
+    ret.pushKV("height", (int64_t)stats.nHeight);
+    ret.pushKV("bestblock", stats.hashBlock.GetHex());
+    ret.pushKV("transactions", (int64_t)stats.nTransactions);
+    ret.pushKV("txouts", (int64_t)stats.nTransactionOutputs);
+    ret.pushKV("bogosize", (int64_t)stats.nBogoSize);
+    if (strHashType != "none") {
+        ret.pushKV(strHashType, stats.hashSerialized.GetHex());
     }
+    ret.pushKV("disk_size", stats.nDiskSize);
+    ret.pushKV("total_amount", ValueFromAmount(stats.nTotalAmount));
     return ret;
 }
 
+UniValue dumptxoutset(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "dumptxoutset \"path\"\n"
+            "\nWrites a snapshot of the UTXO set, the deterministic masternode list and the active quorums as of the\n"
+            "chain tip to a file. Note this call may take some time.\n"
+            "\nArguments:\n"
+            "1. \"path\"    (string, required) Path of the snapshot file, relative paths are relative to the data directory\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"coins_written\": n,        (numeric) The number of coins in the snapshot\n"
+            "  \"base_hash\": \"hash\",      (string) The hash of the block of the snapshot\n"
+            "  \"base_height\": n,          (numeric) The height of the block of the snapshot\n"
+            "  \"path\": \"path\",           (string) The absolute path of the snapshot file\n"
+            "  \"txoutset_hash\": \"hash\",  (string) The hash_serialized_2 of the UTXO set, see gettxoutsetinfo\n"
+            "  \"evo_state_hash\": \"hash\", (string) The hash of the masternode list and quorum commitments\n"
+            "  \"masternodes\": n,          (numeric) The number of masternodes in the list\n"
+            "  \"quorums\": n               (numeric) The number of active quorum commitments\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("dumptxoutset", "\"utxo.dat\"")
+            + HelpExampleRpc("dumptxoutset", "\"utxo.dat\"")
+        );
+
+    const fs::path path = fs::absolute(request.params[0].get_str(), GetDataDir());
+    // Write to a temporary path and then move into `path` on completion to avoid confusion due to an interruption
+    const fs::path temppath = fs::absolute(request.params[0].get_str() + ".incomplete", GetDataDir());
+    if (fs::exists(path)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, path.string() + " already exists. If you are sure this is what you want, move it out of the way first");
+    }
+
+    std::unique_ptr<CCoinsViewCursor> pcursor;
+    const CBlockIndex* pindex;
+    SnapshotEvoState evoState;
+    {
+        // the cursor and the evo state must be of the same block
+        LOCK(cs_main);
+        FlushStateToDisk();
+        pcursor.reset(pcoinsdbview->Cursor());
+        pindex = LookupBlockIndex(pcursor->GetBestBlock());
+        if (!pindex || !GetSnapshotEvoState(pindex, evoState)) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read the evo state of the chain tip");
+        }
+    }
+
+    CAutoFile afile(fsbridge::fopen(temppath, "wb"), SER_DISK, CLIENT_VERSION);
+    if (afile.IsNull()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Couldn't open file " + temppath.string() + " for writing.");
+    }
+    SnapshotMetadata metadata;
+    CCoinsStats stats;
+    if (!WriteUTXOSnapshot(afile, *pcursor, pindex, evoState, metadata, stats)) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to write UTXO set snapshot");
+    }
+    afile.fclose();
+    fs::rename(temppath, path);
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("coins_written", (int64_t)metadata.nCoinsCount);
+    result.pushKV("base_hash", pindex->GetBlockHash().GetHex());
+    result.pushKV("base_height", pindex->nHeight);
+    result.pushKV("path", path.string());
+    result.pushKV("txoutset_hash", stats.hashSerialized.GetHex());
+    result.pushKV("evo_state_hash", evoState.GetHash().GetHex());
+    result.pushKV("masternodes", (int64_t)evoState.mnList.GetAllMNsCount());
+    result.pushKV("quorums", (int64_t)evoState.vQuorumCommitments.size());
+    return result;
+}
+
+UniValue loadtxoutset(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "loadtxoutset \"path\"\n"
+            "\nReads a snapshot written by dumptxoutset and verifies it against the snapshot hashes of this network.\n"
+            "The snapshot is not activated, the node keeps validating the chain from its own tip.\n"
+            "Note this call may take some time.\n"
+            "\nArguments:\n"
+            "1. \"path\"    (string, required) Path of the snapshot file, relative paths are relative to the data directory\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"coins_read\": n,           (numeric) The number of coins in the snapshot\n"
+            "  \"base_hash\": \"hash\",      (string) The hash of the block of the snapshot\n"
+            "  \"base_height\": n,          (numeric) The height of the block of the snapshot\n"
+            "  \"txoutset_hash\": \"hash\",  (string) The hash_serialized_2 of the UTXO set\n"
+            "  \"evo_state_hash\": \"hash\", (string) The hash of the masternode list and quorum commitments\n"
+            "  \"total_amount\": x.xxx,     (numeric) The total amount of the coins\n"
+            "  \"masternodes\": n,          (numeric) The number of masternodes in the list\n"
+            "  \"quorums\": n               (numeric) The number of active quorum commitments\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("loadtxoutset", "\"utxo.dat\"")
+            + HelpExampleRpc("loadtxoutset", "\"utxo.dat\"")
+        );
+
+    const fs::path path = fs::absolute(request.params[0].get_str(), GetDataDir());
+    CAutoFile afile(fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION);
+    if (afile.IsNull()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Couldn't open file " + path.string() + " for reading.");
+    }
+
+    SnapshotMetadata metadata;
+    CCoinsStats stats;
+    SnapshotEvoState evoState;
+    std::string strError;
+    try {
+        if (!VerifyUTXOSnapshot(afile, Params(), metadata, stats, evoState, strError)) {
+            throw JSONRPCError(RPC_VERIFY_ERROR, "Invalid snapshot: " + strError);
+        }
+    } catch (const std::ios_base::failure& e) {
+        throw JSONRPCError(RPC_VERIFY_ERROR, strprintf("Invalid snapshot: %s", e.what()));
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("coins_read", (int64_t)metadata.nCoinsCount);
+    result.pushKV("base_hash", metadata.hashBaseBlock.GetHex());
+    result.pushKV("base_height", metadata.nBaseHeight);
+    result.pushKV("txoutset_hash", stats.hashSerialized.GetHex());
+    result.pushKV("evo_state_hash", evoState.GetHash().GetHex());
+    result.pushKV("total_amount", ValueFromAmount(stats.nTotalAmount));
+    result.pushKV("masternodes", (int64_t)evoState.mnList.GetAllMNsCount());
+    result.pushKV("quorums", (int64_t)evoState.vQuorumCommitments.size());
+    return result;
+}
+
 UniValue gettxout(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 2 || request.params.size() > 3)
@@ -1293,6 +1528,41 @@ UniValue verifychain(const JSONRPCRequest& request)
     return CVerifyDB().VerifyDB(Params(), pcoinsTip.get(), nCheckLevel, nCheckDepth);
 }
 
+UniValue getverifychaininfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getverifychaininfo\n"
+            "\nReturns the progress of the block verification started with -checkblocksbackground.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"running\": true|false,      (boolean) Whether the verification is in progress\n"
+            "  \"done\": true|false,         (boolean) Whether the verification finished\n"
+            "  \"checklevel\": n,            (numeric) How thorough the verification is\n"
+            "  \"blocks\": n,                (numeric) The number of blocks to check\n"
+            "  \"checked\": n,               (numeric) The number of blocks checked so far\n"
+            "  \"failed_height\": n,         (numeric, optional) The height of the first bad block\n"
+            "  \"error\": \"xxxx\"            (string, optional) What was wrong with it\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getverifychaininfo", "")
+            + HelpExampleRpc("getverifychaininfo", "")
+        );
+
+    CVerifyDBStatus status = GetBackgroundVerifyDBStatus();
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("running", status.fRunning);
+    ret.pushKV("done", status.fDone);
+    ret.pushKV("checklevel", status.nCheckLevel);
+    ret.pushKV("blocks", status.nBlocksTotal);
+    ret.pushKV("checked", status.nBlocksChecked);
+    if (status.nFailedHeight != -1) {
+        ret.pushKV("failed_height", status.nFailedHeight);
+        ret.pushKV("error", status.strError);
+    }
+    return ret;
+}
+
 /** Implementation of IsSuperMajority with better feedback */
 static UniValue SoftForkMajorityDesc(int version, CBlockIndex* pindex, const Consensus::Params& consensusParams)
 {
@@ -1621,13 +1891,41 @@ UniValue mempoolInfoToJSON()
     UniValue ret(UniValue::VOBJ);
     ret.pushKV("size", (int64_t) mempool.size());
     ret.pushKV("bytes", (int64_t) mempool.GetTotalTxSize());
-    ret.pushKV("usage", (int64_t) mempool.DynamicMemoryUsage());
+    CTxMemPool::MemoryUsage usage = mempool.GetMemoryUsage();
+    ret.pushKV("usage", (int64_t) usage.Total());
+    UniValue usageDetails(UniValue::VOBJ);
+    usageDetails.pushKV("entries", (int64_t) (usage.nEntries + usage.nEntriesInner));
+    usageDetails.pushKV("links", (int64_t) usage.nLinks);
+    usageDetails.pushKV("spends", (int64_t) usage.nNextTx);
+    usageDetails.pushKV("deltas", (int64_t) usage.nDeltas);
+    usageDetails.pushKV("txhashes", (int64_t) usage.nTxHashes);
+    usageDetails.pushKV("addressindex", (int64_t) usage.nAddressIndex);
+    usageDetails.pushKV("spentindex", (int64_t) usage.nSpentIndex);
+    ret.pushKV("usagedetails", usageDetails);
     size_t maxmempool = gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
     ret.pushKV("maxmempool", (int64_t) maxmempool);
     ret.pushKV("mempoolminfee", ValueFromAmount(std::max(mempool.GetMinFee(maxmempool), ::minRelayTxFee).GetFeePerK()));
     ret.pushKV("minrelaytxfee", ValueFromAmount(::minRelayTxFee.GetFeePerK()));
     ret.pushKV("instantsendlocks", (int64_t)llmq::quorumInstantSendManager->GetInstantSendLockCount());
 
+    CTxRelayCache::Stats relayStats = txRelayCache.GetStats();
+    UniValue relayCache(UniValue::VOBJ);
+    relayCache.pushKV("size", (int64_t)relayStats.nCount);
+    relayCache.pushKV("usage", (int64_t)relayStats.nBytes);
+    relayCache.pushKV("maxusage", (int64_t)relayStats.nMaxBytes);
+    relayCache.pushKV("evicted", (int64_t)relayStats.nEvicted);
+    ret.pushKV("relaycache", relayCache);
+
+    auto cacheStatsToJSON = [](const CCuckooCacheStats& stats) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("hits", (int64_t)stats.nHits);
+        obj.pushKV("misses", (int64_t)stats.nMisses);
+        obj.pushKV("maxelements", (int64_t)stats.nMaxElements);
+        return obj;
+    };
+    ret.pushKV("sigcache", cacheStatsToJSON(GetSignatureCacheStats()));
+    ret.pushKV("scriptcache", cacheStatsToJSON(GetScriptExecutionCacheStats()));
+
     return ret;
 }
 
@@ -1642,10 +1940,33 @@ UniValue getmempoolinfo(const JSONRPCRequest& request)
             "  \"size\": xxxxx,               (numeric) Current tx count\n"
             "  \"bytes\": xxxxx,              (numeric) Sum of all tx sizes\n"
             "  \"usage\": xxxxx,              (numeric) Total memory usage for the mempool\n"
+            "  \"usagedetails\": {            (json object) Memory usage by structure\n"
+            "    \"entries\": xxxxx,          (numeric) Transactions and their entries in the mempool indexes\n"
+            "    \"links\": xxxxx,            (numeric) Links between in-mempool parents and children\n"
+            "    \"spends\": xxxxx,           (numeric) Outpoints spent by mempool transactions\n"
+            "    \"deltas\": xxxxx,           (numeric) Fee deltas set by prioritisetransaction\n"
+            "    \"txhashes\": xxxxx,         (numeric) Transaction hashes used for compact blocks\n"
+            "    \"addressindex\": xxxxx,     (numeric) Address index, only used with -addressindex\n"
+            "    \"spentindex\": xxxxx        (numeric) Spent index, only used with -spentindex\n"
+            "  },\n"
             "  \"maxmempool\": xxxxx,         (numeric) Maximum memory usage for the mempool\n"
             "  \"mempoolminfee\": xxxxx       (numeric) Minimum fee rate in " + CURRENCY_UNIT + "/kB for tx to be accepted. Is the maximum of minrelaytxfee and minimum mempool fee\n"
             "  \"minrelaytxfee\": xxxxx       (numeric) Current minimum relay fee for transactions\n"
             "  \"instantsendlocks\": xxxxx,   (numeric) Number of unconfirmed instant send locks\n"
+            "  \"relaycache\": {              (json object) Recently relayed transactions kept to answer getdata requests\n"
+            "    \"size\": xxxxx,             (numeric) Number of transactions\n"
+            "    \"usage\": xxxxx,            (numeric) Memory usage of the transactions\n"
+            "    \"maxusage\": xxxxx,         (numeric) Memory budget, see -maxrelaycache\n"
+            "    \"evicted\": xxxxx           (numeric) Number of transactions evicted before they expired to stay in the budget\n"
+            "  },\n"
+            "  \"sigcache\": {                (json object) Cache of verified signatures, see -maxsigcachesize\n"
+            "    \"hits\": xxxxx,             (numeric) Signature checks answered by the cache\n"
+            "    \"misses\": xxxxx,           (numeric) Signature checks which had to be verified\n"
+            "    \"maxelements\": xxxxx       (numeric) Number of entries the cache can hold\n"
+            "  },\n"
+            "  \"scriptcache\": {             (json object) Cache of transactions whose scripts were all verified, same fields as sigcache\n"
+            "    ...\n"
+            "  }\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getmempoolinfo", "")
@@ -2129,8 +2450,6 @@ UniValue getspecialtxes(const JSONRPCRequest& request)
             + HelpExampleRpc("getspecialtxes", "\"00000000000fd08c2fb661d2fcb0d49abb3a91e5f27082ce64feed3b4dede2e2\"")
         );
 
-    LOCK(cs_main);
-
     std::string strHash = request.params[0].get_str();
     uint256 hash(uint256S(strHash));
 
@@ -2161,11 +2480,17 @@ UniValue getspecialtxes(const JSONRPCRequest& request)
         }
     }
 
-    if (mapBlockIndex.count(hash) == 0)
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+    const CBlockIndex* pblockindex;
+    {
+        LOCK(cs_main);
+        if (mapBlockIndex.count(hash) == 0)
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
 
-    CBlockIndex* pblockindex = mapBlockIndex[hash];
-    const CBlock block = GetBlockChecked(pblockindex);
+        pblockindex = mapBlockIndex[hash];
+    }
+    // neither reading the block nor converting its transactions (without a block hash) needs cs_main
+    CBlock block;
+    ReadBlocksParallel({pblockindex}, [&](size_t, const CBlock& blockIn) { block = blockIn; });
 
     int nTxNum = 0;
     UniValue result(UniValue::VARR);
@@ -2221,6 +2546,82 @@ UniValue savemempool(const JSONRPCRequest& request)
     return NullUniValue;
 }
 
+UniValue getblockfilter(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2) {
+        throw std::runtime_error(
+            "getblockfilter \"blockhash\" ( \"filtertype\" )\n"
+            "\nRetrieve a BIP 157 content filter for a particular block.\n"
+            "\nArguments:\n"
+            "1. \"blockhash\"       (string, required) The hash of the block\n"
+            "2. \"filtertype\"      (string, optional, default=" + BlockFilterTypeName(BlockFilterType::BASIC_FILTER) + ") The type name of the filter\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"filter\" : \"hex\",    (string) the hex-encoded filter data\n"
+            "  \"header\" : \"hex\"     (string) the hex-encoded filter header\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getblockfilter", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\" \"basic\"")
+            + HelpExampleRpc("getblockfilter", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\", \"basic\"")
+        );
+    }
+
+    uint256 block_hash = ParseHashV(request.params[0], "blockhash");
+    std::string filtertype_name = BlockFilterTypeName(BlockFilterType::BASIC_FILTER);
+    if (!request.params[1].isNull()) {
+        filtertype_name = request.params[1].get_str();
+    }
+
+    BlockFilterType filtertype;
+    if (!BlockFilterTypeByName(filtertype_name, filtertype)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown filtertype");
+    }
+
+    BlockFilterIndex* index = GetBlockFilterIndex(filtertype);
+    if (!index) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Index is not enabled for filtertype " + filtertype_name);
+    }
+
+    const CBlockIndex* block_index;
+    bool block_was_connected;
+    {
+        LOCK(cs_main);
+        block_index = LookupBlockIndex(block_hash);
+        if (!block_index) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+        }
+        block_was_connected = block_index->IsValid(BLOCK_VALID_SCRIPTS);
+    }
+
+    bool index_ready = index->BlockUntilSyncedToCurrentChain();
+
+    BlockFilter filter;
+    uint256 filter_header;
+    if (!index->LookupFilter(block_index, filter) ||
+        !index->LookupFilterHeader(block_index, filter_header)) {
+        int err_code;
+        std::string errmsg = "Filter not found.";
+
+        if (!block_was_connected) {
+            err_code = RPC_INVALID_ADDRESS_OR_KEY;
+            errmsg += " Block was not connected to active chain.";
+        } else if (!index_ready) {
+            err_code = RPC_MISC_ERROR;
+            errmsg += " Block filters are still in the process of being indexed.";
+        } else {
+            err_code = RPC_INTERNAL_ERROR;
+            errmsg += " This error is unexpected and indicates index corruption.";
+        }
+
+        throw JSONRPCError(err_code, errmsg);
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("filter", HexStr(filter.GetEncodedFilter()));
+    ret.pushKV("header", filter_header.GetHex());
+    return ret;
+}
+
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         argNames
   //  --------------------- ------------------------  -----------------------  ----------
@@ -2235,6 +2636,7 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getblockhash",           &getblockhash,           {"height"} },
     { "blockchain",         "getblockheader",         &getblockheader,         {"blockhash","verbose"} },
     { "blockchain",         "getblockheaders",        &getblockheaders,        {"blockhash","count","verbose"} },
+    { "blockchain",         "getblockfilter",         &getblockfilter,         {"blockhash","filtertype"} },
     { "blockchain",         "getmerkleblocks",        &getmerkleblocks,        {"filter","blockhash","count"} },
     { "blockchain",         "getchaintips",           &getchaintips,           {"count","branchlen"} },
     { "blockchain",         "getdifficulty",          &getdifficulty,          {} },
@@ -2245,10 +2647,14 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getrawmempool",          &getrawmempool,          {"verbose"} },
     { "blockchain",         "getspecialtxes",         &getspecialtxes,         {"blockhash", "type", "count", "skip", "verbosity"} },
     { "blockchain",         "gettxout",               &gettxout,               {"txid","n","include_mempool"} },
-    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {} },
+    { "blockchain",         "getdbstats",             &getdbstats,             {} },
+    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {"hash_type"} },
+    { "blockchain",         "dumptxoutset",           &dumptxoutset,           {"path"} },
+    { "blockchain",         "loadtxoutset",           &loadtxoutset,           {"path"} },
     { "blockchain",         "pruneblockchain",        &pruneblockchain,        {"height"} },
     { "blockchain",         "savemempool",            &savemempool,            {} },
     { "blockchain",         "verifychain",            &verifychain,            {"checklevel","nblocks"} },
+    { "blockchain",         "getverifychaininfo",     &getverifychaininfo,     {} },
 
     { "blockchain",         "preciousblock",          &preciousblock,          {"blockhash"} },
 
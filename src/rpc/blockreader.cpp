@@ -0,0 +1,75 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/blockreader.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <primitives/block.h>
+#include <rpc/protocol.h>
+#include <util.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+void ReadBlocksParallel(const std::vector<const CBlockIndex*>& vIndexes, const std::function<void(size_t, const CBlock&)>& fn, int nMaxThreads)
+{
+    std::vector<CDiskBlockPos> vPos;
+    vPos.reserve(vIndexes.size());
+    {
+        LOCK(cs_main);
+        for (const CBlockIndex* pindex : vIndexes) {
+            if (IsBlockPruned(pindex)) {
+                throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
+            }
+            vPos.emplace_back(pindex->GetBlockPos());
+        }
+    }
+
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+    std::atomic<size_t> nNext{0};
+    std::atomic<bool> fFailed{false};
+    std::mutex cs_error;
+    std::exception_ptr error;
+
+    auto read = [&]() {
+        CBlock block;
+        for (size_t i = nNext++; i < vIndexes.size() && !fFailed; i = nNext++) {
+            try {
+                if (!ReadBlockFromDisk(block, vPos[i], consensusParams) || block.GetHash() != vIndexes[i]->GetBlockHash()) {
+                    // the block may have been pruned since its position was looked up
+                    throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+                }
+                fn(i, block);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(cs_error);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                fFailed = true;
+            }
+        }
+    };
+
+    const size_t nThreads = vIndexes.size() < MIN_RPC_BLOCK_READER_PARALLEL_BLOCKS ? 1 : std::min<size_t>({(size_t)std::max(nMaxThreads, 1), (size_t)std::max(GetNumCores(), 1), vIndexes.size()});
+    std::vector<std::thread> vThreads;
+    for (size_t i = 1; i < nThreads; i++) {
+        vThreads.emplace_back([&]() {
+            RenameThread("dash-rpcblocks");
+            read();
+        });
+    }
+    read();
+    for (auto& t : vThreads) {
+        t.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
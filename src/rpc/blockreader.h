@@ -0,0 +1,33 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_BLOCKREADER_H
+#define BITCOIN_RPC_BLOCKREADER_H
+
+#include <stddef.h>
+
+#include <functional>
+#include <vector>
+
+class CBlock;
+class CBlockIndex;
+
+//! Maximum number of threads reading blocks for a single RPC call
+static const int MAX_RPC_BLOCK_READER_THREADS = 4;
+//! Ranges of fewer blocks are read on the calling thread
+static const size_t MIN_RPC_BLOCK_READER_PARALLEL_BLOCKS = 8;
+
+/**
+ * Reads the blocks of vIndexes from disk and calls fn(i, block) for each of
+ * them, on up to nMaxThreads threads, for RPCs which scan a range of blocks.
+ * fn is called concurrently and in no particular order, it should store its
+ * result at index i so that callers can emit the results in order. With
+ * nMaxThreads = 1 it's called in order on the calling thread. The positions of the blocks are looked up with cs_main held, which
+ * must not be held by the caller, reading and fn run without it.
+ * Throws a JSONRPCError if a block is pruned or can't be read, and rethrows
+ * the first exception thrown by fn.
+ */
+void ReadBlocksParallel(const std::vector<const CBlockIndex*>& vIndexes, const std::function<void(size_t, const CBlock&)>& fn, int nMaxThreads = MAX_RPC_BLOCK_READER_THREADS);
+
+#endif // BITCOIN_RPC_BLOCKREADER_H
@@ -922,10 +922,10 @@ UniValue gobject_getcurrentvotes(const JSONRPCRequest& request)
 
     // GET MATCHING VOTES BY HASH, THEN SHOW USERS VOTE INFORMATION
 
-    std::vector<CGovernanceVote> vecVotes = governance.GetCurrentVotes(hash, mnCollateralOutpoint);
-    for (const auto& vote : vecVotes) {
-        bResult.pushKV(vote.GetHash().ToString(),  vote.ToString());
-    }
+    // vote hashes are unique, so skip the duplicate key check of pushKV which is quadratic in the number of votes
+    governance.ForEachCurrentVote(hash, mnCollateralOutpoint, [&](const CGovernanceVote& vote) {
+        bResult.__pushKV(vote.GetHash().ToString(), vote.ToString());
+    });
 
     return bResult;
 }
@@ -35,7 +35,9 @@
 #include <evo/specialtx.h>
 #include <evo/cbtx.h>
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <stdint.h>
 
 unsigned int ParseConfirmTarget(const UniValue& value)
@@ -297,6 +299,107 @@ std::string gbt_vb_name(const Consensus::DeploymentPos pos) {
     return s;
 }
 
+/**
+ * Creates the getblocktemplate template for a new tip right after the tip changed, on the validation interface
+ * thread. Miners usually ask for the new template immediately, often by long polling, and then don't have to wait for
+ * CreateNewBlock and TestBlockValidity. Only active once getblocktemplate was used.
+ */
+class CBlockTemplatePrebuilder : public CValidationInterface
+{
+private:
+    CCriticalSection cs;
+    std::unique_ptr<CBlockTemplate> pblocktemplate GUARDED_BY(cs);
+    const CBlockIndex* pindexPrev GUARDED_BY(cs){nullptr};
+    unsigned int nTransactionsUpdated GUARDED_BY(cs){0};
+
+    std::once_flag registerFlag;
+
+public:
+    void Enable()
+    {
+        std::call_once(registerFlag, [this]() { RegisterValidationInterface(this); });
+    }
+
+    /** Returns the prebuilt template if it was built on pindexTip, nTransactionsUpdatedRet is set to the mempool state it was built from */
+    std::unique_ptr<CBlockTemplate> Take(const CBlockIndex* pindexTip, unsigned int& nTransactionsUpdatedRet)
+    {
+        LOCK(cs);
+        if (pindexPrev != pindexTip) {
+            return nullptr;
+        }
+        pindexPrev = nullptr;
+        nTransactionsUpdatedRet = nTransactionsUpdated;
+        return std::move(pblocktemplate);
+    }
+
+protected:
+    void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override
+    {
+        if (fInitialDownload) {
+            return;
+        }
+        // a superblock needs governance info, see getblocktemplate
+        if (AreSuperblocksEnabled() && !masternodeSync.IsSynced() && CSuperblock::IsValidBlockHeight(pindexNew->nHeight + 1)) {
+            return;
+        }
+
+        std::unique_ptr<CBlockTemplate> pblocktemplateNew;
+        const CBlockIndex* pindexPrevNew;
+        unsigned int nTransactionsUpdatedNew;
+        try {
+            LOCK(cs_main);
+            pindexPrevNew = chainActive.Tip();
+            if (pindexPrevNew != pindexNew) {
+                // there is another tip already, we'll be called for it as well
+                return;
+            }
+            nTransactionsUpdatedNew = mempool.GetTransactionsUpdated();
+            CScript scriptDummy = CScript() << OP_TRUE;
+            pblocktemplateNew = BlockAssembler(Params()).CreateNewBlock(scriptDummy);
+        } catch (const std::exception& e) {
+            LogPrint(BCLog::RPC, "CBlockTemplatePrebuilder::%s -- failed to create block template: %s\n", __func__, e.what());
+            return;
+        }
+        if (!pblocktemplateNew) {
+            return;
+        }
+
+        LOCK(cs);
+        pblocktemplate = std::move(pblocktemplateNew);
+        pindexPrev = pindexPrevNew;
+        nTransactionsUpdated = nTransactionsUpdatedNew;
+    }
+};
+
+static CBlockTemplatePrebuilder blockTemplatePrebuilder;
+
+//! Incremented for every template getblocktemplate creates itself
+static std::atomic<uint64_t> nTemplateGeneration{0};
+//! Set when the current template failed the background TestBlockValidity, see -blocktemplateasynccheck
+static std::atomic<bool> fTemplateInvalid{false};
+
+/** Runs TestBlockValidity for a template on the validation interface thread and discards the template if it fails */
+static void CheckBlockTemplateAsync(const CBlock& block)
+{
+    uint64_t nGeneration = nTemplateGeneration;
+    auto pblock = std::make_shared<const CBlock>(block);
+    CallFunctionInValidationInterfaceQueue([pblock, nGeneration]() {
+        LOCK(cs_main);
+        CBlockIndex* pindexPrev = chainActive.Tip();
+        if (pblock->hashPrevBlock != pindexPrev->GetBlockHash()) {
+            // outdated already, it's replaced on the next call
+            return;
+        }
+        CValidationState state;
+        if (!TestBlockValidity(state, Params(), *pblock, pindexPrev, false, false)) {
+            LogPrintf("getblocktemplate: block template failed TestBlockValidity, discarding it: %s\n", FormatStateMessage(state));
+            if (nTemplateGeneration == nGeneration) {
+                fTemplateInvalid = true;
+            }
+        }
+    });
+}
+
 UniValue getblocktemplate(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() > 1)
@@ -527,9 +630,12 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
     static CBlockIndex* pindexPrev;
     static int64_t nStart;
     static std::unique_ptr<CBlockTemplate> pblocktemplate;
-    if (pindexPrev != chainActive.Tip() ||
+    if (pindexPrev != chainActive.Tip() || fTemplateInvalid ||
         (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > 5))
     {
+        // the previous template failed the background check, make sure the next one is checked before it's returned
+        bool fTestBlockValidity = fTemplateInvalid.exchange(false) || !gArgs.GetBoolArg("-blocktemplateasynccheck", DEFAULT_BLOCK_TEMPLATE_ASYNC_CHECK);
+
         // Clear pindexPrev so future calls make a new block, despite any failures from here on
         pindexPrev = nullptr;
 
@@ -538,9 +644,19 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
         CBlockIndex* pindexPrevNew = chainActive.Tip();
         nStart = GetTime();
 
-        // Create new block
-        CScript scriptDummy = CScript() << OP_TRUE;
-        pblocktemplate = BlockAssembler(Params()).CreateNewBlock(scriptDummy);
+        // Create new block, unless it was already done in the background for this tip
+        blockTemplatePrebuilder.Enable();
+        pblocktemplate = blockTemplatePrebuilder.Take(pindexPrevNew, nTransactionsUpdatedLast);
+        if (!pblocktemplate) {
+            CScript scriptDummy = CScript() << OP_TRUE;
+            pblocktemplate = BlockAssembler(Params()).CreateNewBlock(scriptDummy, fTestBlockValidity);
+            if (pblocktemplate) {
+                nTemplateGeneration++;
+                if (!fTestBlockValidity) {
+                    CheckBlockTemplateAsync(pblocktemplate->block);
+                }
+            }
+        }
         if (!pblocktemplate)
             throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
 
@@ -8,15 +8,18 @@
 #include <clientversion.h>
 #include <consensus/consensus.h>
 #include <core_io.h>
+#include <evo/deterministicmns.h>
 #include <evo/mnauth.h>
 #include <init.h>
 #include <httpserver.h>
+#include <index/extraindexes.h>
 #include <key_io.h>
 #include <net.h>
 #include <netbase.h>
 #include <rpc/blockchain.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
+#include <scheduler.h>
 #include <timedata.h>
 #include <txmempool.h>
 #include <util.h>
@@ -31,6 +34,7 @@
 
 #include <masternode/masternode-sync.h>
 #include <spork.h>
+#include <streams.h>
 
 #include <stdint.h>
 #ifdef HAVE_MALLOC_INFO
@@ -99,6 +103,7 @@ UniValue mnsync(const JSONRPCRequest& request)
         objStatus.pushKV("Attempt", masternodeSync.GetAttempt());
         objStatus.pushKV("IsBlockchainSynced", masternodeSync.IsBlockchainSynced());
         objStatus.pushKV("IsSynced", masternodeSync.IsSynced());
+        objStatus.pushKV("Assets", masternodeSync.GetAssetsJson());
         return objStatus;
     }
 
@@ -519,6 +524,53 @@ bool getAddressesFromParams(const UniValue& params, std::vector<std::pair<uint16
     return true;
 }
 
+/** Returns the "limit" of a paginated address index query, or 0 if the whole result is requested */
+static size_t getPageLimitFromParams(const UniValue& params, const std::vector<std::pair<uint160, int> >& addresses)
+{
+    if (!params[0].isObject()) {
+        return 0;
+    }
+    const UniValue& limitValue = find_value(params[0].get_obj(), "limit");
+    if (limitValue.isNull()) {
+        return 0;
+    }
+    int limit = limitValue.get_int();
+    if (limit <= 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "limit must be positive");
+    }
+    if (addresses.size() != 1) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "limit is only supported for a single address");
+    }
+    return limit;
+}
+
+/** Decodes the "cursor" of a paginated address index query into keyRet, if there is one */
+template<typename Key>
+static void getPageCursorFromParams(const UniValue& params, const std::pair<uint160, int>& address, Key& keyRet)
+{
+    const UniValue& cursorValue = find_value(params[0].get_obj(), "cursor");
+    if (cursorValue.isNull()) {
+        return;
+    }
+    CDataStream ss(ParseHexV(cursorValue, "cursor"), SER_DISK, CLIENT_VERSION);
+    try {
+        ss >> keyRet;
+    } catch (const std::exception&) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+    if (!ss.empty() || (int)keyRet.type != address.second || keyRet.hashBytes != address.first) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+}
+
+template<typename Key>
+static std::string encodePageCursor(const Key& key)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << key;
+    return HexStr(ss.begin(), ss.end());
+}
+
 bool heightSort(std::pair<CAddressUnspentKey, CAddressUnspentValue> a,
                 std::pair<CAddressUnspentKey, CAddressUnspentValue> b) {
     return a.second.blockHeight < b.second.blockHeight;
@@ -613,8 +665,10 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
             "      \"address\"  (string) The base58check encoded address\n"
             "      ,...\n"
             "    ]\n"
+            "  \"limit\" (number, optional) Return at most this many outputs and a cursor for the next page, only for a single address\n"
+            "  \"cursor\" (string, optional) The cursor returned with the previous page\n"
             "}\n"
-            "\nResult:\n"
+            "\nResult (with limit, an object with the outputs in \"utxos\", ordered by txid, and the \"cursor\" of the next page if there is one):\n"
             "[\n"
             "  {\n"
             "    \"address\"  (string) The address base58check encoded\n"
@@ -636,15 +690,31 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    if (g_addressindex) {
+        g_addressindex->BlockUntilSyncedToCurrentChain();
+    }
+
+    const size_t limit = getPageLimitFromParams(request.params, addresses);
+
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
+    CAddressUnspentKey next;
+    bool fMore = false;
 
-    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressUnspent((*it).first, (*it).second, unspentOutputs)) {
+    if (limit > 0) {
+        CAddressUnspentKey startKey(addresses[0].second, addresses[0].first, uint256(), 0);
+        getPageCursorFromParams(request.params, addresses[0], startKey);
+        if (!GetAddressUnspentPage(startKey, limit, unspentOutputs, next, fMore)) {
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
-    }
+    } else {
+        for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+            if (!GetAddressUnspent((*it).first, (*it).second, unspentOutputs)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+        }
 
-    std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
+        std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
+    }
 
     UniValue result(UniValue::VARR);
 
@@ -664,6 +734,15 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
         result.push_back(output);
     }
 
+    if (limit > 0) {
+        UniValue page(UniValue::VOBJ);
+        page.pushKV("utxos", result);
+        if (fMore) {
+            page.pushKV("cursor", encodePageCursor(next));
+        }
+        return page;
+    }
+
     return result;
 }
 
@@ -682,8 +761,10 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
             "    ]\n"
             "  \"start\" (number) The start block height\n"
             "  \"end\" (number) The end block height\n"
+            "  \"limit\" (number, optional) Return at most this many entries (more to complete the last transaction) and a cursor for the next page, only for a single address\n"
+            "  \"cursor\" (string, optional) The cursor returned with the previous page\n"
             "}\n"
-            "\nResult:\n"
+            "\nResult (with limit, an object with the changes in \"deltas\" and the \"cursor\" of the next page if there is one):\n"
             "[\n"
             "  {\n"
             "    \"satoshis\"  (number) The difference of duffs\n"
@@ -720,16 +801,33 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    if (g_addressindex) {
+        g_addressindex->BlockUntilSyncedToCurrentChain();
+    }
 
-    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (start > 0 && end > 0) {
-            if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
-        } else {
-            if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+    const size_t limit = getPageLimitFromParams(request.params, addresses);
+
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    CAddressIndexKey next;
+    bool fMore = false;
+
+    if (limit > 0) {
+        const bool fRange = start > 0 && end > 0;
+        CAddressIndexKey startKey(addresses[0].second, addresses[0].first, fRange ? start : 0, 0, uint256(), 0, false);
+        getPageCursorFromParams(request.params, addresses[0], startKey);
+        if (!GetAddressIndexPage(startKey, fRange ? end : 0, limit, addressIndex, next, fMore)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+    } else {
+        for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+            if (start > 0 && end > 0) {
+                if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
+                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+                }
+            } else {
+                if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
+                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+                }
             }
         }
     }
@@ -752,6 +850,15 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         result.push_back(delta);
     }
 
+    if (limit > 0) {
+        UniValue page(UniValue::VOBJ);
+        page.pushKV("deltas", result);
+        if (fMore) {
+            page.pushKV("cursor", encodePageCursor(next));
+        }
+        return page;
+    }
+
     return result;
 }
 
@@ -787,12 +894,8 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-
-    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-        }
+    if (g_addressindex) {
+        g_addressindex->BlockUntilSyncedToCurrentChain();
     }
 
     int nHeight;
@@ -802,21 +905,34 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
     }
 
     CAmount balance = 0;
-    CAmount balance_spendable = 0;
     CAmount balance_immature = 0;
     CAmount received = 0;
 
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        if (it->second > 0) {
-            received += it->second;
+    // the totals come from the per address summaries, only coinbase outputs which might still be immature are
+    // looked up in the index itself
+    const int nImmatureStart = std::max(1, nHeight - COINBASE_MATURITY + 1);
+    for (const auto& address : addresses) {
+        CAddressSummary summary;
+        if (!GetAddressSummary(address.first, address.second, summary)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
-        if (it->first.txindex == 0 && nHeight - it->first.blockHeight < COINBASE_MATURITY) {
-            balance_immature += it->second;
-        } else {
-            balance_spendable += it->second;
+        balance += summary.balance;
+        received += summary.received;
+
+        if (summary.lastHeight < nImmatureStart) {
+            continue;
+        }
+        std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+        if (!GetAddressIndex(address.first, address.second, addressIndex, nImmatureStart, nHeight)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+        for (const auto& p : addressIndex) {
+            if (p.first.txindex == 0) {
+                balance_immature += p.second;
+            }
         }
-        balance += it->second;
     }
+    CAmount balance_spendable = balance - balance_immature;
 
     UniValue result(UniValue::VOBJ);
     result.pushKV("balance", balance);
@@ -843,8 +959,10 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
             "    ]\n"
             "  \"start\" (number) The start block height\n"
             "  \"end\" (number) The end block height\n"
+            "  \"limit\" (number, optional) Return at most this many entries (more to complete the last transaction) and a cursor for the next page, only for a single address\n"
+            "  \"cursor\" (string, optional) The cursor returned with the previous page\n"
             "}\n"
-            "\nResult:\n"
+            "\nResult (with limit, an object with the txids in \"txids\" and the \"cursor\" of the next page if there is one):\n"
             "[\n"
             "  \"transactionid\"  (string) The transaction id\n"
             "  ,...\n"
@@ -871,16 +989,33 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
         }
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    if (g_addressindex) {
+        g_addressindex->BlockUntilSyncedToCurrentChain();
+    }
 
-    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (start > 0 && end > 0) {
-            if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
-        } else {
-            if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+    const size_t limit = getPageLimitFromParams(request.params, addresses);
+
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    CAddressIndexKey next;
+    bool fMore = false;
+
+    if (limit > 0) {
+        const bool fRange = start > 0 && end > 0;
+        CAddressIndexKey startKey(addresses[0].second, addresses[0].first, fRange ? start : 0, 0, uint256(), 0, false);
+        getPageCursorFromParams(request.params, addresses[0], startKey);
+        if (!GetAddressIndexPage(startKey, fRange ? end : 0, limit, addressIndex, next, fMore)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+    } else {
+        for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+            if (start > 0 && end > 0) {
+                if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
+                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+                }
+            } else {
+                if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
+                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+                }
             }
         }
     }
@@ -907,6 +1042,15 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
         }
     }
 
+    if (limit > 0) {
+        UniValue page(UniValue::VOBJ);
+        page.pushKV("txids", result);
+        if (fMore) {
+            page.pushKV("cursor", encodePageCursor(next));
+        }
+        return page;
+    }
+
     return result;
 
 }
@@ -943,6 +1087,10 @@ UniValue getspentinfo(const JSONRPCRequest& request)
     uint256 txid = ParseHashV(txidValue, "txid");
     int outputIndex = indexValue.get_int();
 
+    if (g_spentindex) {
+        g_spentindex->BlockUntilSyncedToCurrentChain();
+    }
+
     CSpentIndexKey key(txid, outputIndex);
     CSpentIndexValue value;
 
@@ -971,6 +1119,24 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCMNListCacheInfo()
+{
+    UniValue obj(UniValue::VOBJ);
+    if (!deterministicMNManager) {
+        return obj;
+    }
+    auto stats = deterministicMNManager->GetCacheStats();
+    obj.pushKV("lists", uint64_t(stats.nLists));
+    obj.pushKV("diffs", uint64_t(stats.nDiffs));
+    obj.pushKV("lists_usage", uint64_t(stats.nListsUsage));
+    obj.pushKV("diffs_usage", uint64_t(stats.nDiffsUsage));
+    obj.pushKV("max_usage", uint64_t(stats.nMaxUsage));
+    obj.pushKV("hits", stats.nHits);
+    obj.pushKV("misses", stats.nMisses);
+    obj.pushKV("evictions", stats.nEvictions);
+    return obj;
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -990,6 +1156,131 @@ static std::string RPCMallocInfo()
 }
 #endif
 
+UniValue getlockstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 2)
+        throw std::runtime_error(
+            "getlockstats ( count reset )\n"
+            "Returns the lock sites that waited longest for their mutex since profiling was enabled (see -lockstats and setlockstats).\n"
+            "\nArguments:\n"
+            "1. count     (numeric, optional, default=20) The maximum number of lock sites to return\n"
+            "2. reset     (boolean, optional, default=false) Reset the statistics after returning them\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"enabled\": true|false,      (boolean) Whether lock profiling is currently enabled\n"
+            "  \"sites\": [                  (json array) Lock sites, sorted by total wait time\n"
+            "    {\n"
+            "      \"lock\": \"name\",          (string) The locked mutex\n"
+            "      \"site\": \"file:line\",     (string) Where it was locked\n"
+            "      \"locks\": xxxxx,          (numeric) Number of times the site took the lock\n"
+            "      \"contended\": xxxxx,      (numeric) Number of times the mutex was held by another thread\n"
+            "      \"wait_us\": xxxxx,        (numeric) Total time in microseconds spent waiting for the mutex\n"
+            "      \"max_wait_us\": xxxxx,    (numeric) Longest wait in microseconds\n"
+            "      \"hold_us\": xxxxx,        (numeric) Total time in microseconds the mutex was held\n"
+            "    }, ...\n"
+            "  ]\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getlockstats", "")
+            + HelpExampleCli("getlockstats", "10 true")
+            + HelpExampleRpc("getlockstats", "10, true")
+        );
+
+    const int nCount = request.params[0].isNull() ? 20 : request.params[0].get_int();
+    if (nCount < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "count must be non-negative");
+    }
+    const bool fReset = !request.params[1].isNull() && request.params[1].get_bool();
+
+    std::vector<LockSiteStats> vSites = GetLockSiteStats();
+    if (fReset) {
+        ResetLockSiteStats();
+    }
+    if (vSites.size() > (size_t)nCount) {
+        vSites.resize(nCount);
+    }
+
+    UniValue sites(UniValue::VARR);
+    for (const LockSiteStats& site : vSites) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("lock", site.pszName);
+        obj.pushKV("site", strprintf("%s:%d", site.pszFile, site.nLine));
+        obj.pushKV("locks", site.nLocks);
+        obj.pushKV("contended", site.nContended);
+        obj.pushKV("wait_us", site.nWaitMicros);
+        obj.pushKV("max_wait_us", site.nMaxWaitMicros);
+        obj.pushKV("hold_us", site.nHoldMicros);
+        sites.push_back(obj);
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("enabled", g_lock_profiling.load());
+    ret.pushKV("sites", sites);
+    return ret;
+}
+
+UniValue setlockstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "setlockstats enable\n"
+            "Enable or disable lock contention profiling at runtime. Statistics are kept when it is disabled.\n"
+            "\nArguments:\n"
+            "1. enable    (boolean, required) Whether to profile locks\n"
+            "\nExamples:\n"
+            + HelpExampleCli("setlockstats", "true")
+            + HelpExampleRpc("setlockstats", "true")
+        );
+
+    EnableLockProfiling(request.params[0].get_bool());
+    return NullUniValue;
+}
+
+UniValue getschedulerinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getschedulerinfo\n"
+            "Returns an object containing the queue and per-task runtime statistics of each scheduler thread.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"name\": {                    (json object) The scheduler, e.g. \"scheduler\", \"maintenance\" or \"io\"\n"
+            "    \"queued\": xxxxx,           (numeric) Number of tasks waiting to run\n"
+            "    \"tasks\": {                 (json object) Statistics of the named tasks that ran so far\n"
+            "      \"task\": {\n"
+            "        \"runs\": xxxxx,         (numeric) Number of times the task ran\n"
+            "        \"total_us\": xxxxx,     (numeric) Total runtime in microseconds\n"
+            "        \"max_us\": xxxxx,       (numeric) Longest runtime in microseconds\n"
+            "        \"max_delay_us\": xxxxx, (numeric) Longest time in microseconds the task started late, waiting for other tasks\n"
+            "      }, ...\n"
+            "    }\n"
+            "  }, ...\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getschedulerinfo", "")
+            + HelpExampleRpc("getschedulerinfo", "")
+        );
+
+    UniValue ret(UniValue::VOBJ);
+    ForEachScheduler([&ret](const CScheduler& scheduler) {
+        boost::chrono::system_clock::time_point first, last;
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("queued", (uint64_t)scheduler.getQueueInfo(first, last));
+        UniValue tasks(UniValue::VOBJ);
+        for (const auto& p : scheduler.GetTaskStats()) {
+            UniValue task(UniValue::VOBJ);
+            task.pushKV("runs", p.second.nRuns);
+            task.pushKV("total_us", p.second.nTotalMicros);
+            task.pushKV("max_us", p.second.nMaxMicros);
+            task.pushKV("max_delay_us", p.second.nMaxDelayMicros);
+            tasks.pushKV(p.first, task);
+        }
+        obj.pushKV("tasks", tasks);
+        ret.pushKV(scheduler.GetName(), obj);
+    });
+    return ret;
+}
+
 UniValue getmemoryinfo(const JSONRPCRequest& request)
 {
     /* Please, avoid using the word "pool" here in the RPC interface or help,
@@ -1012,6 +1303,16 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
             "    \"locked\": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.\n"
             "    \"chunks_used\": xxxxx,   (numeric) Number allocated chunks\n"
             "    \"chunks_free\": xxxxx,   (numeric) Number unused chunks\n"
+            "  },\n"
+            "  \"mnlistcache\": {          (json object) Information about the masternode list caches\n"
+            "    \"lists\": xxxxx,         (numeric) Number of cached lists\n"
+            "    \"diffs\": xxxxx,         (numeric) Number of cached list diffs\n"
+            "    \"lists_usage\": xxxxx,   (numeric) Estimated memory usage of cached lists in bytes. Lists share most of their memory, so this is an upper bound\n"
+            "    \"diffs_usage\": xxxxx,   (numeric) Estimated memory usage of cached list diffs in bytes\n"
+            "    \"max_usage\": xxxxx,     (numeric) Memory limit for both caches in bytes (see -mnlistcachemb)\n"
+            "    \"hits\": xxxxx,          (numeric) Number of list lookups served from the cache\n"
+            "    \"misses\": xxxxx,        (numeric) Number of list lookups that had to build the list\n"
+            "    \"evictions\": xxxxx,     (numeric) Number of entries evicted because of the memory limit\n"
             "  }\n"
             "}\n"
             "\nResult (mode \"mallocinfo\"):\n"
@@ -1025,6 +1326,7 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("locked", RPCLockedMemoryInfo());
+        obj.pushKV("mnlistcache", RPCMNListCacheInfo());
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -1155,6 +1457,9 @@ static const CRPCCommand commands[] =
   //  --------------------- ------------------------  -----------------------  ----------
     { "control",            "debug",                  &debug,                  {} },
     { "control",            "getmemoryinfo",          &getmemoryinfo,          {"mode"} },
+    { "control",            "getschedulerinfo",       &getschedulerinfo,       {} },
+    { "control",            "getlockstats",           &getlockstats,           {"count", "reset"} },
+    { "control",            "setlockstats",           &setlockstats,           {"enable"} },
     { "control",            "logging",                &logging,                {"include", "exclude"}},
     { "util",               "validateaddress",        &validateaddress,        {"address"} }, /* uses wallet if enabled */
     { "util",               "createmultisig",         &createmultisig,         {"nrequired","keys"} },
@@ -66,6 +66,32 @@ UniValue ping(const JSONRPCRequest& request)
     return NullUniValue;
 }
 
+static UniValue MsgCmdTimesToJson(const mapMsgCmdTime& mapTimes)
+{
+    UniValue obj(UniValue::VOBJ);
+    for (const auto& p : mapTimes) {
+        if (p.second.nCount == 0) {
+            continue;
+        }
+        UniValue times(UniValue::VOBJ);
+        times.pushKV("count", p.second.nCount);
+        times.pushKV("total_us", p.second.nTotal);
+        times.pushKV("avg_us", p.second.nTotal / (int64_t)p.second.nCount);
+        times.pushKV("max_us", p.second.nMax);
+        obj.pushKV(p.first, times);
+    }
+    return obj;
+}
+
+static UniValue MsgTimeStatsToJson(const CNetMsgTimeStats& stats)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("process", MsgCmdTimesToJson(stats.mapProcessTime));
+    obj.pushKV("recvqueue", MsgCmdTimesToJson(stats.mapRecvQueueTime));
+    obj.pushKV("sendqueue", MsgCmdTimesToJson(stats.mapSendQueueTime));
+    return obj;
+}
+
 UniValue getpeerinfo(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 0)
@@ -109,6 +135,7 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
             "       n,                        (numeric) The heights of blocks we're currently asking from this peer\n"
             "       ...\n"
             "    ],\n"
+            "    \"inflight_limit\": n,       (numeric) How many blocks may be in flight from this peer, adapted to its delivery rate\n"
             "    \"whitelisted\": true|false, (boolean) Whether the peer is whitelisted\n"
             "    \"bytessent_per_msg\": {\n"
             "       \"addr\": n,              (numeric) The total bytes sent aggregated by message type\n"
@@ -117,7 +144,8 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
             "    \"bytesrecv_per_msg\": {\n"
             "       \"addr\": n,              (numeric) The total bytes received aggregated by message type\n"
             "       ...\n"
-            "    }\n"
+            "    },\n"
+            "    \"msgtimes\": {...}           (json object) Message times of this peer, same format as in getnetmsgstats\n"
             "  }\n"
             "  ,...\n"
             "]\n"
@@ -182,6 +210,7 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
                 heights.push_back(height);
             }
             obj.pushKV("inflight", heights);
+            obj.pushKV("inflight_limit", statestats.nMaxBlocksInFlight);
         }
         obj.pushKV("whitelisted", stats.fWhitelisted);
 
@@ -198,6 +227,7 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
                 recvPerMsgCmd.pushKV(i.first, i.second);
         }
         obj.pushKV("bytesrecv_per_msg", recvPerMsgCmd);
+        obj.pushKV("msgtimes", MsgTimeStatsToJson(stats.msgTimeStats));
 
         ret.push_back(obj);
     }
@@ -363,6 +393,37 @@ UniValue getaddednodeinfo(const JSONRPCRequest& request)
     return ret;
 }
 
+UniValue getnetmsgstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 0)
+        throw std::runtime_error(
+            "getnetmsgstats\n"
+            "\nReturns where time is spent on network messages, aggregated by message type over all current peers\n"
+            "and all peers which were disconnected since startup. All times are in microseconds.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"process\": {                (json object) Time spent processing messages in the message handler thread\n"
+            "    \"inv\": {\n"
+            "      \"count\": n,              (numeric) Number of messages\n"
+            "      \"total_us\": n,           (numeric) Total time\n"
+            "      \"avg_us\": n,             (numeric) Average time\n"
+            "      \"max_us\": n              (numeric) Maximum time\n"
+            "    },\n"
+            "    ...\n"
+            "  },\n"
+            "  \"recvqueue\": {...},         (json object) Time received messages waited to be processed, same format as \"process\"\n"
+            "  \"sendqueue\": {...}          (json object) Time messages waited until they were completely sent, same format as \"process\"\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getnetmsgstats", "")
+            + HelpExampleRpc("getnetmsgstats", "")
+       );
+    if(!g_connman)
+        throw JSONRPCError(RPC_CLIENT_P2P_DISABLED, "Error: Peer-to-peer functionality missing or disabled");
+
+    return MsgTimeStatsToJson(g_connman->GetMsgTimeStats());
+}
+
 UniValue getnettotals(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() > 0)
@@ -459,6 +520,16 @@ UniValue getnetworkinfo(const JSONRPCRequest& request)
             "  ],\n"
             "  \"relayfee\": x.xxxxxxxx,                (numeric) minimum relay fee for transactions in " + CURRENCY_UNIT + "/kB\n"
             "  \"incrementalfee\": x.xxxxxxxx,          (numeric) minimum fee increment for mempool limiting in " + CURRENCY_UNIT + "/kB\n"
+            "  \"objectrequests\": {                    (json object) state of the scheduler for GETDATA requests of announced objects\n"
+            "    \"peers\": xxx,                        (numeric) number of peers known to the scheduler\n"
+            "    \"announced\": xxx,                    (numeric) number of announcements which weren't received or dropped yet\n"
+            "    \"scheduled\": xxx,                    (numeric) number of announcements waiting to be requested\n"
+            "    \"inflight\": xxx,                     (numeric) number of requests waiting for an answer\n"
+            "    \"requesttimes\": xxx,                 (numeric) number of objects for which the last request time is kept\n"
+            "    \"requested\": xxx,                    (numeric) total number of requested objects\n"
+            "    \"timedout\": xxx,                     (numeric) total number of requests which timed out\n"
+            "    \"notfound\": xxx                      (numeric) total number of requests answered with notfound\n"
+            "  },\n"
             "  \"localaddresses\": [                    (array) list of local addresses\n"
             "  {\n"
             "    \"address\": \"xxxx\",                 (string) network address\n"
@@ -509,6 +580,17 @@ UniValue getnetworkinfo(const JSONRPCRequest& request)
     obj.pushKV("networks",      GetNetworksInfo());
     obj.pushKV("relayfee",      ValueFromAmount(::minRelayTxFee.GetFeePerK()));
     obj.pushKV("incrementalfee", ValueFromAmount(::incrementalRelayFee.GetFeePerK()));
+    CObjectRequestScheduler::Stats requestStats = GetObjectRequestStats();
+    UniValue objectRequests(UniValue::VOBJ);
+    objectRequests.pushKV("peers", (int64_t)requestStats.nPeers);
+    objectRequests.pushKV("announced", (int64_t)requestStats.nAnnounced);
+    objectRequests.pushKV("scheduled", (int64_t)requestStats.nScheduled);
+    objectRequests.pushKV("inflight", (int64_t)requestStats.nInFlight);
+    objectRequests.pushKV("requesttimes", (int64_t)requestStats.nRequestTimes);
+    objectRequests.pushKV("requested", (int64_t)requestStats.nRequested);
+    objectRequests.pushKV("timedout", (int64_t)requestStats.nTimedOut);
+    objectRequests.pushKV("notfound", (int64_t)requestStats.nNotFound);
+    obj.pushKV("objectrequests", objectRequests);
     UniValue localAddresses(UniValue::VARR);
     {
         LOCK(cs_mapLocalHost);
@@ -671,6 +753,7 @@ static const CRPCCommand commands[] =
     { "network",            "disconnectnode",         &disconnectnode,         {"address", "nodeid"} },
     { "network",            "getaddednodeinfo",       &getaddednodeinfo,       {"node"} },
     { "network",            "getnettotals",           &getnettotals,           {} },
+    { "network",            "getnetmsgstats",         &getnetmsgstats,         {} },
     { "network",            "getnetworkinfo",         &getnetworkinfo,         {} },
     { "network",            "setban",                 &setban,                 {"subnet", "command", "bantime", "absolute"} },
     { "network",            "listbanned",             &listbanned,             {} },
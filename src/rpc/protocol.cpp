@@ -13,6 +13,7 @@
 #include <utiltime.h>
 #include <version.h>
 
+#include <assert.h>
 #include <fstream>
 
 /**
@@ -51,6 +52,129 @@ std::string JSONRPCReply(const UniValue& result, const UniValue& error, const Un
     return reply.write() + "\n";
 }
 
+void JSONRPCWriteReply(JSONStreamWriter& writer, const UniValue& result, const UniValue& error, const UniValue& id)
+{
+    writer.BeginObject();
+    writer.Key("result").Write(error.isNull() ? result : NullUniValue);
+    writer.Key("error").Write(error);
+    writer.Key("id").Write(id);
+    writer.EndObject();
+    writer.WriteRaw("\n");
+}
+
+void JSONStreamWriter::BeginValue()
+{
+    if (fAfterKey) {
+        fAfterKey = false;
+        return;
+    }
+    if (!vHasElements.empty()) {
+        if (vHasElements.back()) {
+            strBuffer += ',';
+        }
+        vHasElements.back() = true;
+    }
+}
+
+void JSONStreamWriter::MaybeFlush()
+{
+    if (strBuffer.size() >= nChunkSize) {
+        sink(strBuffer);
+        strBuffer.clear();
+        fFlushed = true;
+    }
+}
+
+JSONStreamWriter& JSONStreamWriter::BeginObject()
+{
+    BeginValue();
+    strBuffer += '{';
+    vHasElements.push_back(false);
+    return *this;
+}
+
+JSONStreamWriter& JSONStreamWriter::EndObject()
+{
+    assert(!vHasElements.empty() && !fAfterKey);
+    vHasElements.pop_back();
+    strBuffer += '}';
+    MaybeFlush();
+    return *this;
+}
+
+JSONStreamWriter& JSONStreamWriter::BeginArray()
+{
+    BeginValue();
+    strBuffer += '[';
+    vHasElements.push_back(false);
+    return *this;
+}
+
+JSONStreamWriter& JSONStreamWriter::EndArray()
+{
+    assert(!vHasElements.empty() && !fAfterKey);
+    vHasElements.pop_back();
+    strBuffer += ']';
+    MaybeFlush();
+    return *this;
+}
+
+JSONStreamWriter& JSONStreamWriter::Key(const std::string& key)
+{
+    assert(!vHasElements.empty() && !fAfterKey);
+    BeginValue();
+    strBuffer += UniValue(key).write();
+    strBuffer += ':';
+    fAfterKey = true;
+    return *this;
+}
+
+void JSONStreamWriter::WriteValue(const UniValue& value)
+{
+    if (value.isObject()) {
+        BeginObject();
+        const std::vector<std::string>& keys = value.getKeys();
+        const std::vector<UniValue>& values = value.getValues();
+        for (size_t i = 0; i < keys.size(); i++) {
+            Key(keys[i]);
+            WriteValue(values[i]);
+        }
+        EndObject();
+    } else if (value.isArray()) {
+        BeginArray();
+        for (const UniValue& element : value.getValues()) {
+            WriteValue(element);
+        }
+        EndArray();
+    } else {
+        BeginValue();
+        strBuffer += value.write();
+        MaybeFlush();
+    }
+}
+
+JSONStreamWriter& JSONStreamWriter::Write(const UniValue& value)
+{
+    WriteValue(value);
+    return *this;
+}
+
+JSONStreamWriter& JSONStreamWriter::WriteRaw(const std::string& str)
+{
+    assert(vHasElements.empty() && !fAfterKey);
+    strBuffer += str;
+    MaybeFlush();
+    return *this;
+}
+
+std::string JSONStreamWriter::Finish()
+{
+    assert(vHasElements.empty() && !fAfterKey);
+    std::string strRet;
+    strRet.swap(strBuffer);
+    return strRet;
+}
+
 UniValue JSONRPCError(int code, const std::string& message)
 {
     UniValue error(UniValue::VOBJ);
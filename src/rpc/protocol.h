@@ -8,10 +8,12 @@
 
 #include <fs.h>
 
+#include <functional>
 #include <list>
 #include <map>
 #include <stdint.h>
 #include <string>
+#include <vector>
 
 #include <univalue.h>
 
@@ -19,6 +21,7 @@
 enum HTTPStatusCode
 {
     HTTP_OK                    = 200,
+    HTTP_NOT_MODIFIED          = 304,
     HTTP_BAD_REQUEST           = 400,
     HTTP_UNAUTHORIZED          = 401,
     HTTP_FORBIDDEN             = 403,
@@ -98,6 +101,54 @@ UniValue JSONRPCReplyObj(const UniValue& result, const UniValue& error, const Un
 std::string JSONRPCReply(const UniValue& result, const UniValue& error, const UniValue& id);
 UniValue JSONRPCError(int code, const std::string& message);
 
+//! Size of the chunks a JSONStreamWriter hands to its sink
+static const size_t JSON_STREAM_CHUNK_SIZE = 1024 * 1024;
+
+/**
+ * Writes compact JSON, the same as UniValue::write() without indentation, and hands it to a sink
+ * in chunks of about JSON_STREAM_CHUNK_SIZE bytes. Values can be written as a whole or built up
+ * incrementally with BeginObject/Key/EndObject and BeginArray/EndArray, so that large replies
+ * never have to exist as a single string or be copied into an enclosing UniValue.
+ */
+class JSONStreamWriter
+{
+public:
+    typedef std::function<void(const std::string&)> Sink;
+
+    explicit JSONStreamWriter(Sink sinkIn, size_t nChunkSizeIn = JSON_STREAM_CHUNK_SIZE) : sink(std::move(sinkIn)), nChunkSize(nChunkSizeIn) {}
+
+    JSONStreamWriter& BeginObject();
+    JSONStreamWriter& EndObject();
+    JSONStreamWriter& BeginArray();
+    JSONStreamWriter& EndArray();
+    /** Write the key of the next value of the current object */
+    JSONStreamWriter& Key(const std::string& key);
+    JSONStreamWriter& Write(const UniValue& value);
+    /** Append raw text which must not be inside an unfinished object or array, e.g. a trailing newline */
+    JSONStreamWriter& WriteRaw(const std::string& str);
+
+    /** Returns false as long as nothing was handed to the sink */
+    bool HasFlushed() const { return fFlushed; }
+    /** Returns the output which was not handed to the sink yet, it's the whole output if HasFlushed() is false */
+    std::string Finish();
+
+private:
+    const Sink sink;
+    const size_t nChunkSize;
+    std::string strBuffer;
+    //! One entry per unfinished object or array, true if it already has an element
+    std::vector<bool> vHasElements;
+    bool fAfterKey{false};
+    bool fFlushed{false};
+
+    void BeginValue();
+    void WriteValue(const UniValue& value);
+    void MaybeFlush();
+};
+
+/** Writes the same reply JSONRPCReply returns, without copying the result into a reply object */
+void JSONRPCWriteReply(JSONStreamWriter& writer, const UniValue& result, const UniValue& error, const UniValue& id);
+
 /** Generate a new RPC authentication cookie and write it to disk */
 bool GenerateAuthCookie(std::string *cookie_out);
 /** Read the RPC authentication cookie from disk */
@@ -0,0 +1,130 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/resultcache.h>
+
+#include <chain.h>
+#include <rpc/server.h>
+#include <validation.h>
+
+#include <set>
+
+CRPCResultCache g_rpc_result_cache;
+
+//! Rough per entry overhead of the list, the map and the UniValue tree besides the JSON size
+static const size_t RPC_CACHE_ENTRY_OVERHEAD = 256;
+
+void CRPCResultCache::SetTip(const uint256& hash)
+{
+    AssertLockHeld(cs);
+    if (hash == hashTip) {
+        return;
+    }
+    entries.clear();
+    mapEntries.clear();
+    nUsage = 0;
+    hashTip = hash;
+}
+
+void CRPCResultCache::SetMaxUsage(size_t nMaxUsageIn)
+{
+    LOCK(cs);
+    nMaxUsage = nMaxUsageIn;
+    while (nUsage > nMaxUsage) {
+        nUsage -= entries.back().nUsage;
+        mapEntries.erase(entries.back().strKey);
+        entries.pop_back();
+    }
+}
+
+bool CRPCResultCache::IsEnabled() const
+{
+    LOCK(cs);
+    return nMaxUsage != 0;
+}
+
+bool CRPCResultCache::IsCacheable(const JSONRPCRequest& request)
+{
+    // results which only depend on the block(s) asked for and the active chain
+    static const std::set<std::string> setChainMethods = {
+        "getblock",
+        "getblockheader",
+        "getblockheaders",
+        "getmerkleblocks",
+        "getspecialtxes",
+    };
+    if (setChainMethods.count(request.strMethod)) {
+        return true;
+    }
+
+    if (!request.params.isArray() || request.params.empty() || !request.params[0].isStr()) {
+        return false;
+    }
+    const std::string& strCommand = request.params[0].get_str();
+    if (request.strMethod == "quorum") {
+        return strCommand == "list";
+    }
+    if (request.strMethod == "protx" && strCommand == "list") {
+        // the wallet's masternodes change without a new block
+        return request.params.size() < 2 || !request.params[1].isStr() || request.params[1].get_str() != "wallet";
+    }
+    return false;
+}
+
+std::string CRPCResultCache::GetKey(const JSONRPCRequest& request)
+{
+    return request.strMethod + '\0' + request.params.write();
+}
+
+uint256 CRPCResultCache::GetTipHash()
+{
+    const CBlockIndex* pindex = chainActive.TipNoLock();
+    return pindex ? pindex->GetBlockHash() : uint256();
+}
+
+bool CRPCResultCache::Get(const std::string& strKey, const uint256& hashTipIn, UniValue& resultRet)
+{
+    LOCK(cs);
+    SetTip(hashTipIn);
+    auto it = mapEntries.find(strKey);
+    if (it == mapEntries.end()) {
+        nMisses++;
+        return false;
+    }
+    nHits++;
+    entries.splice(entries.begin(), entries, it->second);
+    resultRet = it->second->result;
+    return true;
+}
+
+void CRPCResultCache::Put(const std::string& strKey, const uint256& hashTipIn, const UniValue& result)
+{
+    const size_t nEntryUsage = strKey.size() + result.write().size() + RPC_CACHE_ENTRY_OVERHEAD;
+
+    LOCK(cs);
+    // the tip moved while the result was computed, it may be from either tip
+    if (hashTipIn != hashTip || nEntryUsage > nMaxUsage || mapEntries.count(strKey)) {
+        return;
+    }
+    while (nUsage + nEntryUsage > nMaxUsage) {
+        nUsage -= entries.back().nUsage;
+        mapEntries.erase(entries.back().strKey);
+        entries.pop_back();
+    }
+    entries.push_front(Entry{strKey, result, nEntryUsage});
+    mapEntries.emplace(strKey, entries.begin());
+    nUsage += nEntryUsage;
+}
+
+UniValue CRPCResultCache::GetStats() const
+{
+    LOCK(cs);
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("max_usage", (uint64_t)nMaxUsage);
+    obj.pushKV("usage", (uint64_t)nUsage);
+    obj.pushKV("entries", (uint64_t)entries.size());
+    obj.pushKV("hits", nHits);
+    obj.pushKV("misses", nMisses);
+    return obj;
+}
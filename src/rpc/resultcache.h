@@ -0,0 +1,70 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_RESULTCACHE_H
+#define BITCOIN_RPC_RESULTCACHE_H
+
+#include <sync.h>
+#include <uint256.h>
+
+#include <univalue.h>
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+class JSONRPCRequest;
+
+//! Default for -rpccachesize, in MiB, 0 disables the cache
+static const int64_t DEFAULT_RPC_CACHE_SIZE = 0;
+
+/**
+ * Cache for the results of expensive RPC calls which only depend on the chain,
+ * like getblock or quorum list. Entries are keyed by the method, its params and
+ * the chain tip they were computed at. All of them are dropped once the tip
+ * changes, which also covers reorgs. The least recently used ones are evicted
+ * when the cache grows beyond its budget.
+ */
+class CRPCResultCache
+{
+private:
+    struct Entry
+    {
+        std::string strKey;
+        UniValue result;
+        size_t nUsage;
+    };
+
+    mutable CCriticalSection cs;
+    size_t nMaxUsage GUARDED_BY(cs){0};
+    size_t nUsage GUARDED_BY(cs){0};
+    uint256 hashTip GUARDED_BY(cs);
+    //! most recently used first
+    std::list<Entry> entries GUARDED_BY(cs);
+    std::unordered_map<std::string, std::list<Entry>::iterator> mapEntries GUARDED_BY(cs);
+    uint64_t nHits GUARDED_BY(cs){0};
+    uint64_t nMisses GUARDED_BY(cs){0};
+
+    void SetTip(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+public:
+    void SetMaxUsage(size_t nMaxUsageIn);
+    bool IsEnabled() const;
+
+    /** Whether the result of request only depends on the chain and may be cached */
+    static bool IsCacheable(const JSONRPCRequest& request);
+    static std::string GetKey(const JSONRPCRequest& request);
+    static uint256 GetTipHash();
+
+    /** Returns false if there's no result for strKey computed at hashTipIn */
+    bool Get(const std::string& strKey, const uint256& hashTipIn, UniValue& resultRet);
+    /** Store result computed at hashTipIn, which must have been read before computing it */
+    void Put(const std::string& strKey, const uint256& hashTipIn, const UniValue& result);
+
+    UniValue GetStats() const;
+};
+
+extern CRPCResultCache g_rpc_result_cache;
+
+#endif // BITCOIN_RPC_RESULTCACHE_H
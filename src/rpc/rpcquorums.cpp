@@ -10,10 +10,13 @@
 
 #include <llmq/quorums.h>
 #include <llmq/quorums_blockprocessor.h>
+#include <llmq/quorums_chainlocks.h>
 #include <llmq/quorums_debug.h>
 #include <llmq/quorums_dkgsession.h>
+#include <llmq/quorums_instantsend.h>
 #include <llmq/quorums_signing.h>
 #include <llmq/quorums_signing_shares.h>
+#include <llmq/quorums_signing_stats.h>
 
 namespace llmq {
 extern const std::string CLSIG_REQUESTID_PREFIX;
@@ -157,6 +160,7 @@ void quorum_dkgstatus_help()
             "\nArguments:\n"
             "1. detail_level         (number, optional, default=0) Detail level of output.\n"
             "                        0=Only show counts. 1=Show member indexes. 2=Show member's ProTxHashes.\n"
+            "                        3=Additionally show per member message latencies relative to the start of each phase.\n"
     );
 }
 
@@ -169,7 +173,7 @@ UniValue quorum_dkgstatus(const JSONRPCRequest& request)
     int detailLevel = 0;
     if (!request.params[1].isNull()) {
         detailLevel = ParseInt32V(request.params[1], "detail_level");
-        if (detailLevel < 0 || detailLevel > 2) {
+        if (detailLevel < 0 || detailLevel > 3) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid detail_level");
         }
     }
@@ -227,6 +231,91 @@ UniValue quorum_dkgstatus(const JSONRPCRequest& request)
     return ret;
 }
 
+void quorum_sigsharestats_help()
+{
+    throw std::runtime_error(
+            "quorum sigsharestats\n"
+            "Return per-peer statistics about the batching of outgoing signature share messages.\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"nodeId\": n,          (numeric) The internal id of the peer\n"
+            "    \"pingTime\": n,        (numeric) Last measured ping time in milliseconds\n"
+            "    \"sendInterval\": n,    (numeric) Current send interval in milliseconds, derived from pingTime\n"
+            "    \"queueDepth\": n,      (numeric) Number of pending shares and invs when the peer was last checked\n"
+            "    \"flushes\": n,         (numeric) Number of times messages were sent to the peer\n"
+            "    \"msgs\": n,            (numeric) Total number of sent messages\n"
+            "    \"items\": n,           (numeric) Total number of sent shares, invs and session announcements\n"
+            "    \"avgItemsPerMsg\": x.x (numeric) Average number of items per message\n"
+            "  }, ...\n"
+            "]\n"
+    );
+}
+
+UniValue quorum_sigsharestats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1) {
+        quorum_sigsharestats_help();
+    }
+
+    std::map<NodeId, llmq::CSigSharesNodeState::SendStats> stats;
+    llmq::quorumSigSharesManager->GetNodeSendStats(stats);
+
+    UniValue ret(UniValue::VARR);
+    for (const auto& p : stats) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("nodeId", p.first);
+        obj.pushKV("pingTime", p.second.pingUsec / 1000);
+        obj.pushKV("sendInterval", p.second.sendInterval);
+        obj.pushKV("queueDepth", (int64_t)p.second.queueDepth);
+        obj.pushKV("flushes", p.second.flushes);
+        obj.pushKV("msgs", p.second.msgs);
+        obj.pushKV("items", p.second.items);
+        obj.pushKV("avgItemsPerMsg", p.second.msgs != 0 ? (double)p.second.items / p.second.msgs : 0.0);
+        ret.push_back(obj);
+    }
+    return ret;
+}
+
+void quorum_sigstats_help()
+{
+    throw std::runtime_error(
+            "quorum sigstats ( reset )\n"
+            "Return latency histograms of the individual signing stages, broken out per LLMQ type.\n"
+            "\nArguments:\n"
+            "1. reset              (boolean, optional, default=false) Clear the collected stats after returning them.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"llmqTypeName\": {\n"
+            "    \"stage\": {          (json object) One of signQueueWait, timeToThreshold, verifyBatch, recovery, listenerDispatch\n"
+            "      \"count\": n,       (numeric) Number of samples\n"
+            "      \"avg\": x.x,       (numeric) Average latency in milliseconds\n"
+            "      \"max\": n,         (numeric) Maximum latency in milliseconds\n"
+            "      \"buckets\": {...}  (json object) Number of samples per latency bucket\n"
+            "    }, ...\n"
+            "  }, ...\n"
+            "}\n"
+    );
+}
+
+UniValue quorum_sigstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 2) {
+        quorum_sigstats_help();
+    }
+
+    bool fReset = false;
+    if (!request.params[1].isNull()) {
+        fReset = ParseBoolV(request.params[1], "reset");
+    }
+
+    UniValue ret = llmq::signingStats.ToJson();
+    if (fReset) {
+        llmq::signingStats.Reset();
+    }
+    return ret;
+}
+
 void quorum_memberof_help()
 {
     throw std::runtime_error(
@@ -621,6 +710,8 @@ UniValue quorum_getdata(const JSONRPCRequest& request)
             "  isconflicting     - Test if a conflict exists\n"
             "  selectquorum      - Return the quorum that would/should sign a request\n"
             "  getdata           - Request quorum data from other masternodes in the quorum\n"
+            "  sigsharestats     - Return per-peer statistics about batching of signature share messages\n"
+            "  sigstats          - Return latency histograms of the signing stages\n"
     );
 }
 
@@ -651,6 +742,10 @@ UniValue quorum(const JSONRPCRequest& request)
         return quorum_dkgsimerror(request);
     } else if (command == "getdata") {
         return quorum_getdata(request);
+    } else if (command == "sigsharestats") {
+        return quorum_sigsharestats(request);
+    } else if (command == "sigstats") {
+        return quorum_sigstats(request);
     } else {
         quorum_help();
     }
@@ -693,9 +788,11 @@ UniValue verifychainlock(const JSONRPCRequest& request)
         nBlockHeight = ParseInt32V(request.params[2], "blockHeight");
     }
 
-    const auto llmqType = Params().GetConsensus().llmqTypeChainLocks;
-    const uint256 nRequestId = ::SerializeHash(std::make_pair(llmq::CLSIG_REQUESTID_PREFIX, nBlockHeight));
-    return llmq::CSigningManager::VerifyRecoveredSig(llmqType, nBlockHeight, nRequestId, nBlockHash, chainLockSig);
+    llmq::CChainLockSig clsig;
+    clsig.nHeight = nBlockHeight;
+    clsig.blockHash = nBlockHash;
+    clsig.sig = chainLockSig;
+    return llmq::chainLocksHandler->VerifyChainLock(clsig);
 }
 
 void verifyislock_help()
@@ -755,9 +852,59 @@ UniValue verifyislock(const JSONRPCRequest& request)
            llmq::quorumSigningManager->VerifyRecoveredSig(llmqType, signHeight, id, txid, sig, signOffset);
 }
 
+void getinstantsendinfo_help()
+{
+    throw std::runtime_error(
+            "getinstantsendinfo\n"
+            "Returns the progress of the incremental archival of InstantSend locks from fully confirmed blocks.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"archival\": {\n"
+            "    \"targetHeight\": n,          (numeric) Height of the last fully confirmed block\n"
+            "    \"doneHeight\": n,            (numeric) Height up to which all islocks have been archived\n"
+            "    \"pending\": true|false,      (boolean) Whether archival is still in progress\n"
+            "    \"archivedLocks\": n,         (numeric) Number of islocks moved to the archive since startup\n"
+            "    \"removedArchivedLocks\": n,  (numeric) Number of archived islocks removed since startup\n"
+            "    \"chunks\": n,                (numeric) Number of processed chunks since startup\n"
+            "    \"lastRunTime\": n,           (numeric) Time of the last processed chunk\n"
+            "    \"chunkSize\": n,             (numeric) Maximum number of entries per chunk\n"
+            "    \"timeBudget\": n             (numeric) Time budget in milliseconds per iteration\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getinstantsendinfo", "")
+            + HelpExampleRpc("getinstantsendinfo", "")
+    );
+}
+
+UniValue getinstantsendinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0) {
+        getinstantsendinfo_help();
+    }
+
+    auto stats = llmq::quorumInstantSendManager->GetArchivalStats();
+
+    UniValue archival(UniValue::VOBJ);
+    archival.pushKV("targetHeight", stats.nTargetHeight);
+    archival.pushKV("doneHeight", stats.nDoneHeight);
+    archival.pushKV("pending", stats.nDoneHeight < stats.nTargetHeight);
+    archival.pushKV("archivedLocks", stats.nArchivedLocks);
+    archival.pushKV("removedArchivedLocks", stats.nRemovedArchivedLocks);
+    archival.pushKV("chunks", stats.nChunks);
+    archival.pushKV("lastRunTime", stats.nLastRunTime);
+    archival.pushKV("chunkSize", (int64_t)stats.nChunkSize);
+    archival.pushKV("timeBudget", stats.nTimeBudget);
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("archival", archival);
+    return ret;
+}
+
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)
   //  --------------------- ------------------------  -----------------------
+    { "evo",                "getinstantsendinfo",     &getinstantsendinfo,     {}  },
     { "evo",                "quorum",                 &quorum,                 {}  },
     { "evo",                "verifychainlock",        &verifychainlock,        {"blockHash", "signature", "blockHeight"} },
     { "evo",                "verifyislock",           &verifyislock,           {"id", "txid", "signature", "maxHeight"}  },
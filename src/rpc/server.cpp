@@ -7,9 +7,11 @@
 #include <rpc/server.h>
 
 #include <fs.h>
+#include <httpserver.h>
 #include <init.h>
 #include <key_io.h>
 #include <random.h>
+#include <rpc/resultcache.h>
 #include <sync.h>
 #include <ui_interface.h>
 #include <util.h>
@@ -22,13 +24,45 @@
 #include <boost/algorithm/string/split.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <memory> // for unique_ptr
+#include <thread>
 #include <unordered_map>
 
 static CCriticalSection cs_rpcWarmup;
 static bool fRPCRunning = false;
 static bool fRPCInWarmup GUARDED_BY(cs_rpcWarmup) = true;
 static std::string rpcWarmupStatus GUARDED_BY(cs_rpcWarmup) = "RPC server started";
+
+/** Call statistics of a RPC method for getrpcinfo */
+struct RPCMethodStats
+{
+    uint64_t nCalls{0};
+    int64_t nTotalMicros{0};
+    int64_t nMaxMicros{0};
+};
+static CCriticalSection cs_rpcMethodStats;
+static std::map<std::string, RPCMethodStats> mapRPCMethodStats GUARDED_BY(cs_rpcMethodStats);
+
+/** Adds the time from its construction to its destruction to the statistics of a method */
+class RPCMethodTimer
+{
+private:
+    const std::string& strMethod;
+    const int64_t nTimeStart;
+
+public:
+    explicit RPCMethodTimer(const std::string& strMethodIn) : strMethod(strMethodIn), nTimeStart(GetTimeMicros()) {}
+    ~RPCMethodTimer()
+    {
+        const int64_t nMicros = GetTimeMicros() - nTimeStart;
+        LOCK(cs_rpcMethodStats);
+        RPCMethodStats& stats = mapRPCMethodStats[strMethod];
+        stats.nCalls++;
+        stats.nTotalMicros += nMicros;
+        stats.nMaxMicros = std::max(stats.nMaxMicros, nMicros);
+    }
+};
 /* Timer-creating functions */
 static RPCTimerInterface* timerInterface = nullptr;
 /* Map of name to timer. */
@@ -333,6 +367,81 @@ UniValue uptime(const JSONRPCRequest& jsonRequest)
     return GetTime() - GetStartupTime();
 }
 
+UniValue getrpcinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 0)
+        throw std::runtime_error(
+                "getrpcinfo\n"
+                        "\nReturns statistics about the RPC server.\n"
+                        "\nResult:\n"
+                        "{\n"
+                        "  \"work_queues\": [            (array) The work queues requests are dispatched to by method\n"
+                        "    {\n"
+                        "      \"name\": \"xxxx\",          (string) The queue, one of \"default\", \"fast\", \"heavy\" and \"wallet\"\n"
+                        "      \"threads\": n,            (numeric) The number of worker threads\n"
+                        "      \"depth\": n,              (numeric) The number of requests waiting\n"
+                        "      \"max_depth\": n,          (numeric) The number of requests which can wait (see -rpcworkqueue)\n"
+                        "      \"processed\": n,          (numeric) The number of requests taken from the queue\n"
+                        "      \"rejected\": n,           (numeric) The number of requests rejected because the queue was full\n"
+                        "      \"avg_wait_us\": n,        (numeric) The average time in microseconds requests waited in the queue\n"
+                        "      \"max_wait_us\": n         (numeric) The longest time in microseconds a request waited in the queue\n"
+                        "    }, ...\n"
+                        "  ],\n"
+                        "  \"methods\": {                (json object) The methods which were called\n"
+                        "    \"method\": {\n"
+                        "      \"calls\": n,              (numeric) The number of calls\n"
+                        "      \"total_us\": n,           (numeric) The total execution time in microseconds\n"
+                        "      \"avg_us\": n,             (numeric) The average execution time in microseconds\n"
+                        "      \"max_us\": n              (numeric) The longest execution time in microseconds\n"
+                        "    }, ...\n"
+                        "  },\n"
+                        "  \"result_cache\": {           (json object) The cache of chain dependent results (see -rpccachesize)\n"
+                        "    \"max_usage\": n,            (numeric) The memory budget in bytes\n"
+                        "    \"usage\": n,                (numeric) The approximate memory used in bytes\n"
+                        "    \"entries\": n,              (numeric) The number of cached results\n"
+                        "    \"hits\": n,                 (numeric) The number of calls answered from the cache\n"
+                        "    \"misses\": n                (numeric) The number of cacheable calls which had to be executed\n"
+                        "  }\n"
+                        "}\n"
+                        "\nExamples:\n"
+                + HelpExampleCli("getrpcinfo", "")
+                + HelpExampleRpc("getrpcinfo", "")
+        );
+
+    UniValue workQueues(UniValue::VARR);
+    for (const HTTPWorkQueueStats& stats : GetHTTPWorkQueueStats()) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("name", stats.name);
+        obj.pushKV("threads", stats.nThreads);
+        obj.pushKV("depth", (uint64_t)stats.nDepth);
+        obj.pushKV("max_depth", (uint64_t)stats.nMaxDepth);
+        obj.pushKV("processed", stats.nProcessed);
+        obj.pushKV("rejected", stats.nRejected);
+        obj.pushKV("avg_wait_us", stats.nProcessed ? stats.nTotalWaitMicros / (int64_t)stats.nProcessed : 0);
+        obj.pushKV("max_wait_us", stats.nMaxWaitMicros);
+        workQueues.push_back(obj);
+    }
+
+    UniValue methods(UniValue::VOBJ);
+    {
+        LOCK(cs_rpcMethodStats);
+        for (const auto& p : mapRPCMethodStats) {
+            UniValue obj(UniValue::VOBJ);
+            obj.pushKV("calls", p.second.nCalls);
+            obj.pushKV("total_us", p.second.nTotalMicros);
+            obj.pushKV("avg_us", p.second.nTotalMicros / (int64_t)p.second.nCalls);
+            obj.pushKV("max_us", p.second.nMaxMicros);
+            methods.pushKV(p.first, obj);
+        }
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("work_queues", workQueues);
+    ret.pushKV("methods", methods);
+    ret.pushKV("result_cache", g_rpc_result_cache.GetStats());
+    return ret;
+}
+
 /**
  * Call Table
  */
@@ -343,6 +452,7 @@ static const CRPCCommand vRPCCommands[] =
     { "control",            "help",                   &help,                   {"command","subcommand"}  },
     { "control",            "stop",                   &stop,                   {"wait"}  },
     { "control",            "uptime",                 &uptime,                 {}  },
+    { "control",            "getrpcinfo",             &getrpcinfo,             {}  },
 };
 
 CRPCTable::CRPCTable()
@@ -382,6 +492,7 @@ bool CRPCTable::appendCommand(const std::string& name, const CRPCCommand* pcmd)
 bool StartRPC()
 {
     LogPrint(BCLog::RPC, "Starting RPC\n");
+    g_rpc_result_cache.SetMaxUsage(std::max<int64_t>(gArgs.GetArg("-rpccachesize", DEFAULT_RPC_CACHE_SIZE), 0) << 20);
     fRPCRunning = true;
     g_rpcSignals.Started();
     return true;
@@ -496,8 +607,37 @@ static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
 std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq)
 {
     UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+    const size_t nThreads = std::min<size_t>(std::max<int64_t>(gArgs.GetArg("-rpcbatchthreads", DEFAULT_RPC_BATCH_THREADS), 1), vReq.size());
+    if (nThreads <= 1) {
+        for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
+            ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+
+        return ret.write() + "\n";
+    }
+
+    // Elements are handed out in order but may complete in any order, the
+    // replies are still returned in the order of the requests
+    std::vector<UniValue> vReplies(vReq.size());
+    std::atomic<size_t> nNext{0};
+    auto execute = [&]() {
+        for (size_t i = nNext++; i < vReq.size(); i = nNext++) {
+            vReplies[i] = JSONRPCExecOne(jreq, vReq[i]);
+        }
+    };
+    std::vector<std::thread> vThreads;
+    for (size_t i = 1; i < nThreads; i++) {
+        vThreads.emplace_back([&]() {
+            RenameThread("dash-rpcbatch");
+            execute();
+        });
+    }
+    execute();
+    for (auto& t : vThreads) {
+        t.join();
+    }
+    for (auto& reply : vReplies) {
+        ret.push_back(std::move(reply));
+    }
 
     return ret.write() + "\n";
 }
@@ -617,14 +757,31 @@ UniValue CRPCTable::execute(const JSONRPCRequest &request) const
 
     g_rpcSignals.PreCommand(*pcmd);
 
+    RPCMethodTimer timer(pcmd->name);
+    const bool fUseCache = g_rpc_result_cache.IsEnabled() && CRPCResultCache::IsCacheable(request);
+    std::string strCacheKey;
+    uint256 hashTip;
+    if (fUseCache) {
+        strCacheKey = CRPCResultCache::GetKey(request);
+        hashTip = CRPCResultCache::GetTipHash();
+        UniValue result;
+        if (g_rpc_result_cache.Get(strCacheKey, hashTip, result)) {
+            return result;
+        }
+    }
     try
     {
         // Execute, convert arguments to array if necessary
+        UniValue result;
         if (request.params.isObject()) {
-            return pcmd->actor(transformNamedArguments(request, pcmd->argNames));
+            result = pcmd->actor(transformNamedArguments(request, pcmd->argNames));
         } else {
-            return pcmd->actor(request);
+            result = pcmd->actor(request);
+        }
+        if (fUseCache && CRPCResultCache::GetTipHash() == hashTip) {
+            g_rpc_result_cache.Put(strCacheKey, hashTip, result);
         }
+        return result;
     }
     catch (const std::exception& e)
     {
@@ -203,6 +203,9 @@ extern CAmount AmountFromValue(const UniValue& value);
 extern std::string HelpExampleCli(const std::string& methodname, const std::string& args);
 extern std::string HelpExampleRpc(const std::string& methodname, const std::string& args);
 
+//! Default for -rpcbatchthreads, batch elements are executed one after another
+static const int DEFAULT_RPC_BATCH_THREADS = 1;
+
 bool StartRPC();
 void InterruptRPC();
 void StopRPC();
@@ -30,6 +30,15 @@ struct SaltedHasherImpl<std::pair<N, uint256>>
     }
 };
 
+template<>
+struct SaltedHasherImpl<std::pair<int, uint160>>
+{
+    static std::size_t CalcHash(const std::pair<int, uint160>& v, uint64_t k0, uint64_t k1)
+    {
+        return CSipHasher(k0, k1).Write(v.second.begin(), v.second.size()).Write((uint64_t)v.first).Finalize();
+    }
+};
+
 template<>
 struct SaltedHasherImpl<uint256>
 {
@@ -7,17 +7,46 @@
 #include <random.h>
 #include <reverselock.h>
 
+#include <algorithm>
 #include <assert.h>
 #include <boost/bind.hpp>
+#include <set>
 #include <utility>
 
-CScheduler::CScheduler() : nThreadsServicingQueue(0), stopRequested(false), stopWhenEmpty(false)
+namespace {
+
+struct SchedulerRegistry
+{
+    boost::mutex mutex;
+    std::set<const CScheduler*> schedulers;
+};
+
+// Constructed on first use, so it outlives schedulers with static storage duration
+SchedulerRegistry& GetSchedulerRegistry()
 {
+    static SchedulerRegistry registry;
+    return registry;
+}
+
+} // namespace
+
+CScheduler::CScheduler(const std::string& strNameIn) : strName(strNameIn), nThreadsServicingQueue(0), stopRequested(false), stopWhenEmpty(false)
+{
+    if (!strName.empty()) {
+        SchedulerRegistry& registry = GetSchedulerRegistry();
+        boost::unique_lock<boost::mutex> lock(registry.mutex);
+        registry.schedulers.insert(this);
+    }
 }
 
 CScheduler::~CScheduler()
 {
     assert(nThreadsServicingQueue == 0);
+    if (!strName.empty()) {
+        SchedulerRegistry& registry = GetSchedulerRegistry();
+        boost::unique_lock<boost::mutex> lock(registry.mutex);
+        registry.schedulers.erase(this);
+    }
 }
 
 
@@ -73,14 +102,29 @@ void CScheduler::serviceQueue()
             if (shouldStop() || taskQueue.empty())
                 continue;
 
-            Function f = taskQueue.begin()->second;
+            const boost::chrono::system_clock::time_point due = taskQueue.begin()->first;
+            Function f = std::move(taskQueue.begin()->second.first);
+            const std::string strTaskName = std::move(taskQueue.begin()->second.second);
             taskQueue.erase(taskQueue.begin());
 
+            boost::chrono::system_clock::time_point start, end;
             {
                 // Unlock before calling f, so it can reschedule itself or another task
                 // without deadlocking:
                 reverse_lock<boost::unique_lock<boost::mutex> > rlock(lock);
+                start = boost::chrono::system_clock::now();
                 f();
+                end = boost::chrono::system_clock::now();
+            }
+
+            if (!strTaskName.empty()) {
+                CSchedulerTaskStats& stats = mapTaskStats[strTaskName];
+                const int64_t nMicros = boost::chrono::duration_cast<boost::chrono::microseconds>(end - start).count();
+                const int64_t nDelayMicros = boost::chrono::duration_cast<boost::chrono::microseconds>(start - due).count();
+                stats.nRuns++;
+                stats.nTotalMicros += nMicros;
+                stats.nMaxMicros = std::max(stats.nMaxMicros, nMicros);
+                stats.nMaxDelayMicros = std::max(stats.nMaxDelayMicros, nDelayMicros);
             }
         } catch (...) {
             --nThreadsServicingQueue;
@@ -103,29 +147,29 @@ void CScheduler::stop(bool drain)
     newTaskScheduled.notify_all();
 }
 
-void CScheduler::schedule(CScheduler::Function f, boost::chrono::system_clock::time_point t)
+void CScheduler::schedule(CScheduler::Function f, boost::chrono::system_clock::time_point t, const std::string& strTaskName)
 {
     {
         boost::unique_lock<boost::mutex> lock(newTaskMutex);
-        taskQueue.insert(std::make_pair(t, f));
+        taskQueue.insert(std::make_pair(t, std::make_pair(f, strTaskName)));
     }
     newTaskScheduled.notify_one();
 }
 
-void CScheduler::scheduleFromNow(CScheduler::Function f, int64_t deltaMilliSeconds)
+void CScheduler::scheduleFromNow(CScheduler::Function f, int64_t deltaMilliSeconds, const std::string& strTaskName)
 {
-    schedule(f, boost::chrono::system_clock::now() + boost::chrono::milliseconds(deltaMilliSeconds));
+    schedule(f, boost::chrono::system_clock::now() + boost::chrono::milliseconds(deltaMilliSeconds), strTaskName);
 }
 
-static void Repeat(CScheduler* s, CScheduler::Function f, int64_t deltaMilliSeconds)
+static void Repeat(CScheduler* s, CScheduler::Function f, int64_t deltaMilliSeconds, const std::string& strTaskName)
 {
     f();
-    s->scheduleFromNow(boost::bind(&Repeat, s, f, deltaMilliSeconds), deltaMilliSeconds);
+    s->scheduleFromNow(boost::bind(&Repeat, s, f, deltaMilliSeconds, strTaskName), deltaMilliSeconds, strTaskName);
 }
 
-void CScheduler::scheduleEvery(CScheduler::Function f, int64_t deltaMilliSeconds)
+void CScheduler::scheduleEvery(CScheduler::Function f, int64_t deltaMilliSeconds, const std::string& strTaskName)
 {
-    scheduleFromNow(boost::bind(&Repeat, this, f, deltaMilliSeconds), deltaMilliSeconds);
+    scheduleFromNow(boost::bind(&Repeat, this, f, deltaMilliSeconds, strTaskName), deltaMilliSeconds, strTaskName);
 }
 
 size_t CScheduler::getQueueInfo(boost::chrono::system_clock::time_point &first,
@@ -145,6 +189,19 @@ bool CScheduler::AreThreadsServicingQueue() const {
     return nThreadsServicingQueue;
 }
 
+std::map<std::string, CSchedulerTaskStats> CScheduler::GetTaskStats() const
+{
+    boost::unique_lock<boost::mutex> lock(newTaskMutex);
+    return mapTaskStats;
+}
+
+void ForEachScheduler(std::function<void (const CScheduler&)> fn)
+{
+    SchedulerRegistry& registry = GetSchedulerRegistry();
+    boost::unique_lock<boost::mutex> lock(registry.mutex);
+    for (const CScheduler* scheduler : registry.schedulers) fn(*scheduler);
+}
+
 
 void SingleThreadedSchedulerClient::MaybeScheduleProcessQueue() {
     {
@@ -155,7 +212,7 @@ void SingleThreadedSchedulerClient::MaybeScheduleProcessQueue() {
         if (m_are_callbacks_running) return;
         if (m_callbacks_pending.empty()) return;
     }
-    m_pscheduler->schedule(std::bind(&SingleThreadedSchedulerClient::ProcessQueue, this));
+    m_pscheduler->schedule(std::bind(&SingleThreadedSchedulerClient::ProcessQueue, this), boost::chrono::system_clock::now(), "callbacks");
 }
 
 void SingleThreadedSchedulerClient::ProcessQueue() {
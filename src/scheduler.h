@@ -12,7 +12,9 @@
 //
 #include <boost/chrono/chrono.hpp>
 #include <boost/thread.hpp>
+#include <functional>
 #include <map>
+#include <string>
 
 #include <sync.h>
 
@@ -33,27 +35,42 @@
 // delete t;
 // delete s; // Must be done after thread is interrupted/joined.
 //
+// A scheduler given a name is listed by ForEachScheduler, and every task
+// scheduled with a name keeps runtime statistics, so slow tasks and the
+// delays they cause for the other tasks on the same thread can be found.
+//
+
+/** Runtime statistics of the tasks scheduled under one name */
+struct CSchedulerTaskStats
+{
+    uint64_t nRuns{0};
+    //! Total and longest time spent running the task
+    int64_t nTotalMicros{0};
+    int64_t nMaxMicros{0};
+    //! Longest time the task started after it was due, i.e. waited for other tasks
+    int64_t nMaxDelayMicros{0};
+};
 
 class CScheduler
 {
 public:
-    CScheduler();
+    explicit CScheduler(const std::string& strNameIn = "");
     ~CScheduler();
 
     typedef std::function<void(void)> Function;
 
     // Call func at/after time t
-    void schedule(Function f, boost::chrono::system_clock::time_point t=boost::chrono::system_clock::now());
+    void schedule(Function f, boost::chrono::system_clock::time_point t=boost::chrono::system_clock::now(), const std::string& strTaskName = "");
 
     // Convenience method: call f once deltaSeconds from now
-    void scheduleFromNow(Function f, int64_t deltaMilliSeconds);
+    void scheduleFromNow(Function f, int64_t deltaMilliSeconds, const std::string& strTaskName = "");
 
     // Another convenience method: call f approximately
     // every deltaSeconds forever, starting deltaSeconds from now.
     // To be more precise: every time f is finished, it
     // is rescheduled to run deltaSeconds later. If you
     // need more accurate scheduling, don't use this method.
-    void scheduleEvery(Function f, int64_t deltaMilliSeconds);
+    void scheduleEvery(Function f, int64_t deltaMilliSeconds, const std::string& strTaskName = "");
 
     // To keep things as simple as possible, there is no unschedule.
 
@@ -74,8 +91,15 @@ public:
     // Returns true if there are threads actively running in serviceQueue()
     bool AreThreadsServicingQueue() const;
 
+    const std::string& GetName() const { return strName; }
+
+    // Returns the statistics of all named tasks that ran so far
+    std::map<std::string, CSchedulerTaskStats> GetTaskStats() const;
+
 private:
-    std::multimap<boost::chrono::system_clock::time_point, Function> taskQueue;
+    const std::string strName;
+    std::multimap<boost::chrono::system_clock::time_point, std::pair<Function, std::string>> taskQueue;
+    std::map<std::string, CSchedulerTaskStats> mapTaskStats;
     boost::condition_variable newTaskScheduled;
     mutable boost::mutex newTaskMutex;
     int nThreadsServicingQueue;
@@ -84,6 +108,9 @@ private:
     bool shouldStop() const { return stopRequested || (stopWhenEmpty && taskQueue.empty()); }
 };
 
+/** Iterate over all named schedulers, invoking fn on each. */
+void ForEachScheduler(std::function<void (const CScheduler&)> fn);
+
 /**
  * Class used by CScheduler clients which may schedule multiple jobs
  * which are required to be run serially. Jobs may not be run on the
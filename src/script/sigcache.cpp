@@ -14,6 +14,9 @@
 #include <cuckoocache.h>
 #include <boost/thread.hpp>
 
+#include <array>
+#include <atomic>
+
 namespace {
 /**
  * Valid signature cache, to avoid doing expensive ECDSA signature checking
@@ -26,8 +29,17 @@ private:
      //! Entries are SHA256(nonce || signature hash || public key || signature):
     uint256 nonce;
     typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
-    map_type setValid;
-    boost::shared_mutex cs_sigcache;
+    struct Shard {
+        map_type setValid;
+        boost::shared_mutex cs_sigcache;
+        std::atomic<uint64_t> nHits{0};
+        std::atomic<uint64_t> nMisses{0};
+    };
+    std::array<Shard, SIGNATURE_CACHE_SHARDS> shards;
+    size_t nMaxElements{0};
+
+    // The cuckoo hashes use the high bits of the entry words, pick the shard from the low bits of the first one
+    Shard& GetShard(const uint256& entry) { return shards[*entry.begin() % SIGNATURE_CACHE_SHARDS]; }
 
 public:
     CSignatureCache()
@@ -44,18 +56,36 @@ public:
     bool
     Get(const uint256& entry, const bool erase)
     {
-        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
-        return setValid.contains(entry, erase);
+        Shard& shard = GetShard(entry);
+        boost::shared_lock<boost::shared_mutex> lock(shard.cs_sigcache);
+        const bool found = shard.setValid.contains(entry, erase);
+        (found ? shard.nHits : shard.nMisses).fetch_add(1, std::memory_order_relaxed);
+        return found;
     }
 
     void Set(uint256& entry)
     {
-        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
-        setValid.insert(entry);
+        Shard& shard = GetShard(entry);
+        boost::unique_lock<boost::shared_mutex> lock(shard.cs_sigcache);
+        shard.setValid.insert(entry);
+    }
+    size_t setup_bytes(size_t n)
+    {
+        nMaxElements = 0;
+        for (Shard& shard : shards) {
+            nMaxElements += shard.setValid.setup_bytes(n / SIGNATURE_CACHE_SHARDS);
+        }
+        return nMaxElements;
     }
-    uint32_t setup_bytes(size_t n)
+    CCuckooCacheStats GetStats() const
     {
-        return setValid.setup_bytes(n);
+        CCuckooCacheStats stats;
+        for (const Shard& shard : shards) {
+            stats.nHits += shard.nHits.load(std::memory_order_relaxed);
+            stats.nMisses += shard.nMisses.load(std::memory_order_relaxed);
+        }
+        stats.nMaxElements = nMaxElements;
+        return stats;
     }
 };
 
@@ -76,8 +106,13 @@ void InitSignatureCache()
     // setup_bytes creates the minimum possible cache (2 elements).
     size_t nMaxCacheSize = std::min(std::max((int64_t)0, gArgs.GetArg("-maxsigcachesize", DEFAULT_MAX_SIG_CACHE_SIZE) / 2), MAX_MAX_SIG_CACHE_SIZE) * ((size_t) 1 << 20);
     size_t nElems = signatureCache.setup_bytes(nMaxCacheSize);
-    LogPrintf("Using %zu MiB out of %zu/2 requested for signature cache, able to store %zu elements\n",
-            (nElems*sizeof(uint256)) >>20, (nMaxCacheSize*2)>>20, nElems);
+    LogPrintf("Using %zu MiB out of %zu/2 requested for signature cache, able to store %zu elements in %u shards\n",
+            (nElems*sizeof(uint256)) >>20, (nMaxCacheSize*2)>>20, nElems, SIGNATURE_CACHE_SHARDS);
+}
+
+CCuckooCacheStats GetSignatureCacheStats()
+{
+    return signatureCache.GetStats();
 }
 
 bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
@@ -10,12 +10,14 @@
 
 #include <vector>
 
-// DoS prevention: limit cache size to 32MB (over 1000000 entries on 64-bit
+// DoS prevention: limit cache size to 64MB (over 2000000 entries on 64-bit
 // systems). Due to how we count cache size, actual memory usage is slightly
-// more (~32.25 MB)
-static const unsigned int DEFAULT_MAX_SIG_CACHE_SIZE = 32;
+// more (~64.5 MB)
+static const unsigned int DEFAULT_MAX_SIG_CACHE_SIZE = 64;
 // Maximum sig cache size allowed
 static const int64_t MAX_MAX_SIG_CACHE_SIZE = 16384;
+// Number of independently locked parts of the signature cache, so script check threads rarely wait on each other
+static const unsigned int SIGNATURE_CACHE_SHARDS = 16;
 
 class CPubKey;
 
@@ -40,6 +42,15 @@ public:
     }
 };
 
+/** Lookup counters of a cuckoo cache of validation results */
+struct CCuckooCacheStats
+{
+    uint64_t nHits{0};
+    uint64_t nMisses{0};
+    //! Number of entries the cache can hold
+    size_t nMaxElements{0};
+};
+
 class CachingTransactionSignatureChecker : public TransactionSignatureChecker
 {
 private:
@@ -52,5 +63,6 @@ public:
 };
 
 void InitSignatureCache();
+CCuckooCacheStats GetSignatureCacheStats();
 
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
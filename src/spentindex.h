@@ -8,6 +8,7 @@
 
 #include <uint256.h>
 #include <amount.h>
+#include <saltedhasher.h>
 #include <script/script.h>
 #include <serialize.h>
 
@@ -37,6 +38,17 @@ struct CSpentIndexKey {
         outputIndex = 0;
     }
 
+    friend bool operator==(const CSpentIndexKey& a, const CSpentIndexKey& b) {
+        return a.txid == b.txid && a.outputIndex == b.outputIndex;
+    }
+};
+
+struct CSpentIndexKeyHasher
+{
+    std::size_t operator()(const CSpentIndexKey& key) const
+    {
+        return StaticSaltedHasher()(std::make_pair(key.txid, key.outputIndex));
+    }
 };
 
 struct CSpentIndexValue {
@@ -241,6 +253,38 @@ struct CAddressUnspentValue {
     }
 };
 
+/** Totals of all address index entries of an address, kept up to date by the address index */
+struct CAddressSummary {
+    CAmount balance;
+    CAmount received;
+    uint32_t txCount;
+    int firstHeight;
+    int lastHeight;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(balance);
+        READWRITE(received);
+        READWRITE(txCount);
+        READWRITE(firstHeight);
+        READWRITE(lastHeight);
+    }
+
+    CAddressSummary() {
+        SetNull();
+    }
+
+    void SetNull() {
+        balance = 0;
+        received = 0;
+        txCount = 0;
+        firstHeight = -1;
+        lastHeight = -1;
+    }
+};
+
 struct CAddressIndexKey {
     unsigned int type;
     uint160 hashBytes;
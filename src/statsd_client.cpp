@@ -40,6 +40,11 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdlib.h>
 #include <stdio.h>
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 statsd::StatsdClient statsClient;
 
 namespace statsd {
@@ -52,6 +57,12 @@ inline bool fequal(float a, float b)
 
 thread_local FastRandomContext insecure_rand;
 
+inline bool is_enabled()
+{
+    static bool fEnabled = gArgs.GetBoolArg("-statsenabled", DEFAULT_STATSD_ENABLE);
+    return fEnabled;
+}
+
 inline bool should_send(float sample_rate)
 {
     if ( fequal(sample_rate, 1.0) )
@@ -74,17 +85,35 @@ struct _StatsdClientData {
     bool    init;
 
     char    errmsg[1024];
+
+    // protects everything above and the batch below
+    std::mutex mutex;
+    // metrics waiting to be sent, separated by newlines
+    std::string buffer;
+
+    std::thread flushThread;
+    std::condition_variable condFlush;
+    bool fStop;
 };
 
 StatsdClient::StatsdClient(const std::string& host, int port, const std::string& ns)
 {
     d = new _StatsdClientData;
     d->sock = INVALID_SOCKET;
+    d->fStop = false;
     config(host, port, ns);
 }
 
 StatsdClient::~StatsdClient()
 {
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+        d->fStop = true;
+    }
+    d->condFlush.notify_one();
+    if (d->flushThread.joinable()) d->flushThread.join();
+    flush();
+
     // close socket
     CloseSocket(d->sock);
     delete d;
@@ -93,6 +122,7 @@ StatsdClient::~StatsdClient()
 
 void StatsdClient::config(const std::string& host, int port, const std::string& ns)
 {
+    std::lock_guard<std::mutex> lock(d->mutex);
     d->ns = ns;
     d->host = host;
     d->port = port;
@@ -100,14 +130,17 @@ void StatsdClient::config(const std::string& host, int port, const std::string&
     CloseSocket(d->sock);
 }
 
+/* must hold d->mutex */
 int StatsdClient::init()
 {
-    static bool fEnabled = gArgs.GetBoolArg("-statsenabled", DEFAULT_STATSD_ENABLE);
-    if (!fEnabled) return -3;
+    if (!is_enabled()) return -3;
 
     if ( d->init ) return 0;
 
-    config(gArgs.GetArg("-statshost", DEFAULT_STATSD_HOST), gArgs.GetArg("-statsport", DEFAULT_STATSD_PORT), gArgs.GetArg("-statsns", DEFAULT_STATSD_NAMESPACE));
+    d->ns = gArgs.GetArg("-statsns", DEFAULT_STATSD_NAMESPACE);
+    d->host = gArgs.GetArg("-statshost", DEFAULT_STATSD_HOST);
+    d->port = gArgs.GetArg("-statsport", DEFAULT_STATSD_PORT);
+    CloseSocket(d->sock);
 
     d->sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
     if ( d->sock == INVALID_SOCKET ) {
@@ -130,9 +163,28 @@ int StatsdClient::init()
     }
 
     d->init = true;
+    if (!d->flushThread.joinable() && !d->fStop) {
+        d->flushThread = std::thread(&StatsdClient::flushThread, this);
+    }
     return 0;
 }
 
+void StatsdClient::flushThread()
+{
+    RenameThread("dash-statsd");
+    std::unique_lock<std::mutex> lock(d->mutex);
+    while (!d->fStop) {
+        d->condFlush.wait_for(lock, std::chrono::milliseconds(STATSD_FLUSH_INTERVAL_MS));
+        sendBuffer();
+    }
+}
+
+void StatsdClient::flush()
+{
+    std::lock_guard<std::mutex> lock(d->mutex);
+    sendBuffer();
+}
+
 /* will change the original string */
 void StatsdClient::cleanup(std::string& key)
 {
@@ -176,6 +228,10 @@ int StatsdClient::timing(const std::string& key, size_t ms, float sample_rate)
 
 int StatsdClient::send(std::string key, size_t value, const std::string& type, float sample_rate)
 {
+    if (!is_enabled()) {
+        return -3;
+    }
+
     if (!should_send(sample_rate)) {
         return 0;
     }
@@ -203,6 +259,10 @@ int StatsdClient::send(std::string key, size_t value, const std::string& type, f
 
 int StatsdClient::sendDouble(std::string key, double value, const std::string& type, float sample_rate)
 {
+    if (!is_enabled()) {
+        return -3;
+    }
+
     if (!should_send(sample_rate)) {
         return 0;
     }
@@ -230,12 +290,31 @@ int StatsdClient::sendDouble(std::string key, double value, const std::string& t
 
 int StatsdClient::send(const std::string& message)
 {
+    std::lock_guard<std::mutex> lock(d->mutex);
     int ret = init();
     if ( ret )
     {
         return ret;
     }
-    ret = sendto(d->sock, message.data(), message.size(), 0, (struct sockaddr *) &d->server, sizeof(d->server));
+    // send the batch first if the message doesn't fit into the same datagram anymore
+    if (!d->buffer.empty() && d->buffer.size() + 1 + message.size() > STATSD_MAX_DATAGRAM_SIZE) {
+        ret = sendBuffer();
+    }
+    if (!d->buffer.empty()) {
+        d->buffer += '\n';
+    }
+    d->buffer += message;
+    return ret;
+}
+
+/* must hold d->mutex */
+int StatsdClient::sendBuffer()
+{
+    if (!d->init || d->buffer.empty()) {
+        return 0;
+    }
+    int ret = sendto(d->sock, d->buffer.data(), d->buffer.size(), 0, (struct sockaddr *) &d->server, sizeof(d->server));
+    d->buffer.clear();
     if ( ret == -1) {
         snprintf(d->errmsg, sizeof(d->errmsg),
                 "sendto server fail, host=%s:%d, err=%m", d->host.c_str(), d->port);
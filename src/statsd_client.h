@@ -14,6 +14,11 @@ static const int DEFAULT_STATSD_PERIOD = 60;
 static const int MIN_STATSD_PERIOD = 5;
 static const int MAX_STATSD_PERIOD = 60 * 60;
 
+// metrics are batched into datagrams of at most this size, which fits into the usual MTU
+static const size_t STATSD_MAX_DATAGRAM_SIZE = 1432;
+// batched metrics are sent at least this often, in milliseconds
+static const int STATSD_FLUSH_INTERVAL_MS = 1000;
+
 namespace statsd {
 
 struct _StatsdClientData;
@@ -28,6 +33,9 @@ class StatsdClient {
         void config(const std::string& host, int port, const std::string& ns = DEFAULT_STATSD_NAMESPACE);
         const char* errmsg();
 
+        // send out the batched metrics now
+        void flush();
+
     public:
         int inc(const std::string& key, float sample_rate = 1.0);
         int dec(const std::string& key, float sample_rate = 1.0);
@@ -40,6 +48,7 @@ class StatsdClient {
         /**
          * (Low Level Api) manually send a message
          * which might be composed of several lines.
+         * Messages are batched and sent by a background thread.
          */
         int send(const std::string& message);
 
@@ -54,6 +63,8 @@ class StatsdClient {
     protected:
         int init();
         void cleanup(std::string& key);
+        int sendBuffer();
+        void flushThread();
 
     protected:
         struct _StatsdClientData* d;
@@ -169,6 +169,65 @@ public:
     }
 };
 
+/** Minimal stream for reading from an existing, non-owned buffer. The buffer must outlive the reader and
+ * every Span returned by Peek()
+ */
+class SpanReader
+{
+private:
+    const int m_type;
+    const int m_version;
+    Span<const unsigned char> m_data;
+    size_t m_pos = 0;
+
+public:
+
+    /*
+     * @param[in]  type Serialization Type
+     * @param[in]  version Serialization Version (including any flags)
+     * @param[in]  data Referenced buffer to read from
+     */
+    SpanReader(int type, int version, Span<const unsigned char> data)
+        : m_type(type), m_version(version), m_data(data) {}
+
+    template<typename T>
+    SpanReader& operator>>(T& obj)
+    {
+        // Unserialize from this stream
+        ::Unserialize(*this, obj);
+        return (*this);
+    }
+
+    int GetVersion() const { return m_version; }
+    int GetType() const { return m_type; }
+
+    size_t size() const { return m_data.size() - m_pos; }
+    bool empty() const { return size() == 0; }
+
+    void read(char* dst, size_t n)
+    {
+        memcpy(dst, Peek(n).data(), n);
+        m_pos += n;
+    }
+
+    /** Returns the next n bytes without copying them and without advancing the read position */
+    Span<const unsigned char> Peek(size_t n) const
+    {
+        if (n > size()) {
+            throw std::ios_base::failure("SpanReader::Peek(): end of data");
+        }
+        return Span<const unsigned char>(m_data.data() + m_pos, n);
+    }
+
+    void ignore(size_t n)
+    {
+        if (n > size()) {
+            throw std::ios_base::failure("SpanReader::ignore(): end of data");
+        }
+        m_pos += n;
+    }
+};
+
 /** Double ended buffer combining vector and stream-like interfaces.
  *
  * >> and << read and write unformatted data using the above serialization templates.
@@ -0,0 +1,177 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SUPPORT_ALLOCATORS_POOL_H
+#define BITCOIN_SUPPORT_ALLOCATORS_POOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+//
+// Pool for the nodes of a node based container. Nodes are carved out of chunks which are only freed when the pool
+// is destroyed, freed nodes are kept on a free list for the next allocation. The first single object allocation
+// determines the node size, allocations of other sizes are passed to operator new. This pool is NOT thread safe
+//
+class NodePool
+{
+public:
+    //! nodes in the first chunk, every further chunk is twice as large up to MAX_CHUNK_BYTES
+    static const size_t MIN_CHUNK_NODES = 32;
+    static const size_t MAX_CHUNK_BYTES = 256 * 1024;
+
+private:
+    struct FreeNode {
+        FreeNode* pNext;
+    };
+
+    size_t nNodeSize{0};
+    size_t nNextChunkNodes{MIN_CHUNK_NODES};
+    FreeNode* pFree{nullptr};
+    char* pUnused{nullptr};
+    char* pUnusedEnd{nullptr};
+    std::vector<std::unique_ptr<char[]>> vChunks;
+    size_t nChunksBytes{0};
+
+    // new char[] is aligned for any fundamental type, so all nodes are aligned as their size is a multiple of this
+    static size_t RoundUp(size_t nSize)
+    {
+        return (std::max(nSize, sizeof(FreeNode)) + alignof(FreeNode) - 1) / alignof(FreeNode) * alignof(FreeNode);
+    }
+
+    void AllocateChunk()
+    {
+        const size_t nBytes = nNextChunkNodes * nNodeSize;
+        vChunks.emplace_back(new char[nBytes]);
+        nChunksBytes += nBytes;
+        pUnused = vChunks.back().get();
+        pUnusedEnd = pUnused + nBytes;
+        nNextChunkNodes = std::max(nNextChunkNodes, std::min(nNextChunkNodes * 2, MAX_CHUNK_BYTES / nNodeSize));
+    }
+
+public:
+    NodePool() = default;
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    /** Whether allocations of this size and alignment are taken from the pool */
+    bool IsPooled(size_t nSize, size_t nAlign) const
+    {
+        return nAlign <= alignof(FreeNode) && RoundUp(nSize) == nNodeSize;
+    }
+
+    /** Returns nullptr if nodes of this pool have a different size */
+    void* Allocate(size_t nSize, size_t nAlign)
+    {
+        if (nNodeSize == 0 && nAlign <= alignof(FreeNode)) {
+            nNodeSize = RoundUp(nSize);
+        }
+        if (!IsPooled(nSize, nAlign)) {
+            return nullptr;
+        }
+        if (pFree) {
+            FreeNode* p = pFree;
+            pFree = p->pNext;
+            return p;
+        }
+        if (pUnused == pUnusedEnd) {
+            AllocateChunk();
+        }
+        void* p = pUnused;
+        pUnused += nNodeSize;
+        return p;
+    }
+
+    void Deallocate(void* p)
+    {
+        FreeNode* pNode = static_cast<FreeNode*>(p);
+        pNode->pNext = pFree;
+        pFree = pNode;
+    }
+
+    /** Makes sure that the next chunk has room for at least nNodes, e.g. when the final size of the container is known */
+    void Reserve(size_t nNodes)
+    {
+        nNextChunkNodes = std::max(nNextChunkNodes, nNodes);
+    }
+
+    size_t NodeSize() const { return nNodeSize; }
+    /** Memory allocated for chunks, including nodes which are free at the moment */
+    size_t ChunksBytes() const { return nChunksBytes; }
+};
+
+//
+// Allocator which takes nodes from a NodePool. A default constructed allocator creates a new pool, copies share it,
+// also with containers which are move constructed from each other (use swap() instead if the containers are used by
+// different threads afterwards). A copied container gets a new pool. Swapping or assigning containers moves the
+// pools along with the nodes, so that destroying a container frees all its nodes at once.
+//
+template <typename T>
+struct node_pool_allocator {
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+    typedef std::false_type is_always_equal;
+
+    template <typename U>
+    struct rebind {
+        typedef node_pool_allocator<U> other;
+    };
+
+    std::shared_ptr<NodePool> pool;
+
+    node_pool_allocator() : pool(std::make_shared<NodePool>()) {}
+    node_pool_allocator(const node_pool_allocator& other) noexcept : pool(other.pool) {}
+    // moving would leave the source without pool, but the moved-from container is still usable
+    node_pool_allocator(node_pool_allocator&& other) noexcept : pool(other.pool) {}
+    template <typename U>
+    node_pool_allocator(const node_pool_allocator<U>& other) noexcept : pool(other.pool) {}
+    node_pool_allocator& operator=(const node_pool_allocator& other) noexcept
+    {
+        pool = other.pool;
+        return *this;
+    }
+
+    node_pool_allocator select_on_container_copy_construction() const { return node_pool_allocator(); }
+
+    T* allocate(std::size_t n)
+    {
+        if (n == 1) {
+            void* p = pool->Allocate(sizeof(T), alignof(T));
+            if (p) {
+                return static_cast<T*>(p);
+            }
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        if (n == 1 && pool->IsPooled(sizeof(T), alignof(T))) {
+            pool->Deallocate(p);
+            return;
+        }
+        ::operator delete(p);
+    }
+
+    NodePool& GetPool() const { return *pool; }
+};
+
+template <typename T, typename U>
+bool operator==(const node_pool_allocator<T>& a, const node_pool_allocator<U>& b) noexcept
+{
+    return a.pool == b.pool;
+}
+
+template <typename T, typename U>
+bool operator!=(const node_pool_allocator<T>& a, const node_pool_allocator<U>& b) noexcept
+{
+    return !(a == b);
+}
+
+#endif // BITCOIN_SUPPORT_ALLOCATORS_POOL_H
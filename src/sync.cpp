@@ -9,6 +9,7 @@
 
 #include <stdio.h>
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <set>
@@ -23,6 +24,100 @@ void PrintLockContention(const char* pszName, const char* pszFile, int nLine)
 }
 #endif /* DEBUG_LOCKCONTENTION */
 
+//
+// Lock contention profiling.
+// Sites are identified by the name, file and line string literals of the
+// LOCK macro and live in a fixed size open addressing table, so that looking
+// up a known site on the LOCK path takes no lock. Only the first LOCK of a
+// site takes lockSitesMutex to claim a slot.
+//
+
+std::atomic<bool> g_lock_profiling{false};
+
+struct LockSite {
+    //! Published last (release), a non-null file means the slot is taken
+    std::atomic<const char*> pszFile{nullptr};
+    const char* pszName{nullptr};
+    int nLine{0};
+    std::atomic<uint64_t> nLocks{0};
+    std::atomic<uint64_t> nContended{0};
+    std::atomic<int64_t> nWaitNanos{0};
+    std::atomic<int64_t> nMaxWaitNanos{0};
+    std::atomic<int64_t> nHoldNanos{0};
+};
+
+static const size_t LOCK_SITES = 4096;
+static LockSite lockSites[LOCK_SITES];
+static std::mutex lockSitesMutex;
+
+LockSite* GetLockSite(const char* pszName, const char* pszFile, int nLine)
+{
+    const size_t nHash = (reinterpret_cast<uintptr_t>(pszFile) >> 3) * 31 + (size_t)nLine * 7 + reinterpret_cast<uintptr_t>(pszName);
+    for (bool fLocked : {false, true}) {
+        std::unique_lock<std::mutex> lock(lockSitesMutex, std::defer_lock);
+        if (fLocked) lock.lock();
+        for (size_t i = 0; i < LOCK_SITES; ++i) {
+            LockSite& site = lockSites[(nHash + i) % LOCK_SITES];
+            const char* pszSiteFile = site.pszFile.load(std::memory_order_acquire);
+            if (pszSiteFile == nullptr) {
+                if (!fLocked) break;
+                site.pszName = pszName;
+                site.nLine = nLine;
+                site.pszFile.store(pszFile, std::memory_order_release);
+                return &site;
+            }
+            if (pszSiteFile == pszFile && site.nLine == nLine && site.pszName == pszName) {
+                return &site;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void RecordLockAcquired(LockSite* site, int64_t nWaitNanos, bool fContended)
+{
+    site->nLocks.fetch_add(1, std::memory_order_relaxed);
+    if (!fContended) return;
+    site->nContended.fetch_add(1, std::memory_order_relaxed);
+    site->nWaitNanos.fetch_add(nWaitNanos, std::memory_order_relaxed);
+    int64_t nMax = site->nMaxWaitNanos.load(std::memory_order_relaxed);
+    while (nWaitNanos > nMax && !site->nMaxWaitNanos.compare_exchange_weak(nMax, nWaitNanos, std::memory_order_relaxed)) {}
+}
+
+void RecordLockReleased(LockSite* site, int64_t nHoldNanos)
+{
+    site->nHoldNanos.fetch_add(nHoldNanos, std::memory_order_relaxed);
+}
+
+void EnableLockProfiling(bool fEnable)
+{
+    g_lock_profiling.store(fEnable, std::memory_order_relaxed);
+}
+
+void ResetLockSiteStats()
+{
+    for (LockSite& site : lockSites) {
+        site.nLocks = 0;
+        site.nContended = 0;
+        site.nWaitNanos = 0;
+        site.nMaxWaitNanos = 0;
+        site.nHoldNanos = 0;
+    }
+}
+
+std::vector<LockSiteStats> GetLockSiteStats()
+{
+    std::vector<LockSiteStats> ret;
+    for (const LockSite& site : lockSites) {
+        const char* pszFile = site.pszFile.load(std::memory_order_acquire);
+        if (pszFile == nullptr || site.nLocks == 0) continue;
+        ret.push_back(LockSiteStats{site.pszName, pszFile, site.nLine, site.nLocks, site.nContended,
+                                    site.nWaitNanos / 1000, site.nMaxWaitNanos / 1000, site.nHoldNanos / 1000});
+    }
+    std::sort(ret.begin(), ret.end(), [](const LockSiteStats& a, const LockSiteStats& b) { return a.nWaitMicros > b.nWaitMicros; });
+    return ret;
+}
+
 #ifdef DEBUG_LOCKORDER
 //
 // Early deadlock detection.
@@ -352,6 +352,16 @@ BOOST_AUTO_TEST_CASE(addrman_delete)
     BOOST_CHECK_EQUAL(addrman.size(), 0);
     CAddrInfo* info2 = addrman.Find(addr1);
     BOOST_CHECK(info2 == nullptr);
+
+    // Test: The nId of a deleted entry is reused for the next one.
+    CAddress addr2 = CAddress(ResolveService("250.1.2.2", 8333), NODE_NONE);
+    int nId2;
+    addrman.Create(addr2, source1, &nId2);
+    BOOST_CHECK_EQUAL(nId2, nId);
+    BOOST_CHECK(addrman.Find(addr1) == nullptr);
+    CAddrInfo* info3 = addrman.Find(addr2);
+    BOOST_REQUIRE(info3 != nullptr);
+    BOOST_CHECK_EQUAL(info3->ToString(), "250.1.2.2:8333");
 }
 
 BOOST_AUTO_TEST_CASE(addrman_getaddr)
@@ -7,6 +7,8 @@
 
 #include <blockfilter.h>
 #include <core_io.h>
+#include <evo/providertx.h>
+#include <evo/specialtx.h>
 #include <serialize.h>
 #include <streams.h>
 #include <univalue.h>
@@ -90,6 +92,50 @@ BOOST_AUTO_TEST_CASE(blockfilter_basic_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(blockfilter_specialtx_test)
+{
+    CProRegTx proRegTx;
+    proRegTx.keyIDOwner = CKeyID(uint160(std::vector<unsigned char>(20, 1)));
+    proRegTx.keyIDVoting = CKeyID(uint160(std::vector<unsigned char>(20, 2)));
+    proRegTx.scriptPayout << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 3) << OP_EQUALVERIFY << OP_CHECKSIG;
+
+    CProUpRegTx proUpRegTx;
+    proUpRegTx.proTxHash = uint256S("0x1234");
+    proUpRegTx.keyIDVoting = CKeyID(uint160(std::vector<unsigned char>(20, 4)));
+
+    CMutableTransaction tx_1;
+    tx_1.nVersion = 3;
+    tx_1.nType = TRANSACTION_PROVIDER_REGISTER;
+    SetTxPayload(tx_1, proRegTx);
+
+    CMutableTransaction tx_2;
+    tx_2.nVersion = 3;
+    tx_2.nType = TRANSACTION_PROVIDER_UPDATE_REGISTRAR;
+    SetTxPayload(tx_2, proUpRegTx);
+
+    // Regular outputs only go into the basic filter.
+    CScript output_script;
+    output_script << std::vector<unsigned char>(33, 5) << OP_CHECKSIG;
+    tx_2.vout.emplace_back(100, output_script);
+
+    CBlock block;
+    block.vtx.push_back(MakeTransactionRef(tx_1));
+    block.vtx.push_back(MakeTransactionRef(tx_2));
+
+    BlockFilter block_filter(BlockFilterType::SPECIAL_TX_FILTER, block, CBlockUndo());
+    const GCSFilter& filter = block_filter.GetFilter();
+
+    BOOST_CHECK(filter.Match(GCSFilter::Element(proRegTx.keyIDOwner.begin(), proRegTx.keyIDOwner.end())));
+    BOOST_CHECK(filter.Match(GCSFilter::Element(proRegTx.keyIDVoting.begin(), proRegTx.keyIDVoting.end())));
+    BOOST_CHECK(filter.Match(GCSFilter::Element(proRegTx.scriptPayout.begin(), proRegTx.scriptPayout.end())));
+    BOOST_CHECK(filter.Match(GCSFilter::Element(proUpRegTx.proTxHash.begin(), proUpRegTx.proTxHash.end())));
+    BOOST_CHECK(filter.Match(GCSFilter::Element(proUpRegTx.keyIDVoting.begin(), proUpRegTx.keyIDVoting.end())));
+    BOOST_CHECK(!filter.Match(GCSFilter::Element(output_script.begin(), output_script.end())));
+
+    BlockFilter decoded(BlockFilterType::SPECIAL_TX_FILTER, block.GetHash(), block_filter.GetEncodedFilter());
+    BOOST_CHECK(decoded.GetFilter().Match(GCSFilter::Element(proRegTx.keyIDOwner.begin(), proRegTx.keyIDOwner.end())));
+}
+
 BOOST_AUTO_TEST_CASE(blockfilters_json_test)
 {
     UniValue json;
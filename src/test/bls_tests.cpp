@@ -2,8 +2,10 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <arith_uint256.h>
 #include <bls/bls.h>
 #include <bls/bls_batchverifier.h>
+#include <bls/bls_worker.h>
 #include <test/test_dash.h>
 
 #include <boost/test/unit_test.hpp>
@@ -46,6 +48,46 @@ BOOST_AUTO_TEST_CASE(bls_sig_tests)
     BOOST_CHECK(sig2.VerifyInsecure(sk2.GetPublicKey(), msgHash1));
 }
 
+BOOST_AUTO_TEST_CASE(bls_sanity_check_tests)
+{
+    BOOST_CHECK(BLSSanityCheck());
+}
+
+BOOST_AUTO_TEST_CASE(bls_lazy_wrapper_tests)
+{
+    CBLSSecretKey sk;
+    sk.MakeNewKey();
+    auto sig = sk.Sign(uint256S("0000000000000000000000000000000000000000000000000000000000000001"));
+
+    // default constructed wrappers hold the all-zero buffer which results in an invalid object
+    CBLSLazySignature lazyNull;
+    BOOST_CHECK(lazyNull.IsNull());
+    BOOST_CHECK(!lazyNull.Get().IsValid());
+
+    CBLSLazySignature lazySig;
+    lazySig.Set(sig);
+    BOOST_CHECK(lazySig.Get() == sig);
+    BOOST_CHECK(lazySig != lazyNull);
+
+    // round trip through the buffer, the object must only be deserialized on access
+    CDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
+    ds << lazySig;
+    BOOST_CHECK_EQUAL(ds.size(), (size_t)CBLSSignature::SerSize);
+    CBLSLazySignature lazySig2;
+    ds >> lazySig2;
+    BOOST_CHECK(!lazySig2.IsNull());
+    BOOST_CHECK(lazySig2 == lazySig);
+    BOOST_CHECK(lazySig2.GetHash() == lazySig.GetHash());
+    BOOST_CHECK(lazySig2.Get() == sig);
+
+    // copies keep both representations
+    CBLSLazySignature lazySig3(lazySig2);
+    BOOST_CHECK(lazySig3.GetHash() == lazySig.GetHash());
+    BOOST_CHECK(lazySig3.Get() == sig);
+    lazySig3 = lazyNull;
+    BOOST_CHECK(!lazySig3.Get().IsValid());
+}
+
 struct Message
 {
     uint32_t sourceId;
@@ -77,9 +119,9 @@ static void AddMessage(std::vector<Message>& vec, uint32_t sourceId, uint32_t ms
     vec.emplace_back(m);
 }
 
-static void Verify(std::vector<Message>& vec, bool secureVerification, bool perMessageFallback)
+static void Verify(std::vector<Message>& vec, bool secureVerification, bool perMessageFallback, CBLSWorker* worker = nullptr)
 {
-    CBLSBatchVerifier<uint32_t, uint32_t> batchVerifier(secureVerification, perMessageFallback);
+    CBLSBatchVerifier<uint32_t, uint32_t> batchVerifier(secureVerification, perMessageFallback, 0, worker);
 
     std::set<uint32_t> expectedBadMessages;
     std::set<uint32_t> expectedBadSources;
@@ -109,6 +151,12 @@ static void Verify(std::vector<Message>& vec)
     Verify(vec, true, false);
     Verify(vec, false, true);
     Verify(vec, true, true);
+
+    CBLSWorker worker;
+    worker.Start();
+    Verify(vec, false, true, &worker);
+    Verify(vec, true, true, &worker);
+    worker.Stop();
 }
 
 BOOST_AUTO_TEST_CASE(batch_verifier_tests)
@@ -152,6 +200,89 @@ BOOST_AUTO_TEST_CASE(batch_verifier_tests)
     // last message invalid from one source
     AddMessage(msgs, 1, 7, 1, false);
     Verify(msgs);
+
+    msgs.clear();
+    // many sources with a few bad ones, which must be isolated by bisection
+    for (uint32_t i = 0; i < 50; i++) {
+        AddMessage(msgs, i, i, i % 5, i != 3 && i != 17 && i != 49);
+    }
+    Verify(msgs);
+}
+
+BOOST_AUTO_TEST_CASE(bls_worker_encrypt_contributions_tests)
+{
+    CBLSWorker worker;
+    worker.Start();
+
+    // not a multiple of the internal batch size
+    const size_t count = 21;
+    std::vector<CBLSSecretKey> recipientKeys(count);
+    std::vector<CBLSPublicKey> recipients;
+    BLSSecretKeyVector skShares(count);
+    for (size_t i = 0; i < count; i++) {
+        recipientKeys[i].MakeNewKey();
+        recipients.emplace_back(recipientKeys[i].GetPublicKey());
+        skShares[i].MakeNewKey();
+    }
+
+    CBLSIESMultiRecipientObjects<CBLSSecretKey> encrypted;
+    BOOST_CHECK(worker.EncryptContributions(recipients, skShares, PROTOCOL_VERSION, encrypted));
+    BOOST_CHECK_EQUAL(encrypted.blobs.size(), count);
+    for (size_t i = 0; i < count; i++) {
+        CBLSSecretKey decrypted;
+        BOOST_CHECK(encrypted.Decrypt(i, recipientKeys[i], decrypted, PROTOCOL_VERSION));
+        BOOST_CHECK(decrypted == skShares[i]);
+        // must not be decryptable with the key of another recipient
+        BOOST_CHECK(!encrypted.Decrypt(i, recipientKeys[(i + 1) % count], decrypted, PROTOCOL_VERSION) || decrypted != skShares[i]);
+    }
+
+    // sizes must match
+    skShares.pop_back();
+    BOOST_CHECK(!worker.EncryptContributions(recipients, skShares, PROTOCOL_VERSION, encrypted));
+
+    // contributions of all members for a single recipient, as received through QDATA
+    const size_t recipientIdx = 5;
+    std::vector<CBLSIESEncryptedObject<CBLSSecretKey>> vecEncrypted(skShares.size());
+    for (size_t i = 0; i < skShares.size(); i++) {
+        BOOST_CHECK(vecEncrypted[i].Encrypt(recipientIdx, recipients[recipientIdx], skShares[i], PROTOCOL_VERSION));
+    }
+    BLSSecretKeyVector decryptedShares;
+    BOOST_CHECK(worker.DecryptContributions(vecEncrypted, recipientIdx, recipientKeys[recipientIdx], PROTOCOL_VERSION, decryptedShares));
+    BOOST_CHECK(decryptedShares == skShares);
+    BOOST_CHECK(!worker.DecryptContributions(vecEncrypted, recipientIdx, recipientKeys[0], PROTOCOL_VERSION, decryptedShares));
+
+    worker.Stop();
+}
+
+BOOST_AUTO_TEST_CASE(bls_worker_cache_eviction_tests)
+{
+    CBLSWorker worker;
+    worker.Start();
+
+    BLSVerificationVectorPtr vvec = std::make_shared<BLSVerificationVector>();
+    for (size_t i = 0; i < 10; i++) {
+        CBLSSecretKey sk;
+        sk.MakeNewKey();
+        vvec->emplace_back(sk.GetPublicKey());
+    }
+
+    const size_t nMaxUsage = 2048;
+    CBLSWorkerCache cache(worker, nMaxUsage);
+    std::vector<CBLSPublicKey> pubKeyShares;
+    for (int i = 0; i < 100; i++) {
+        CBLSId id(ArithToUint256(arith_uint256(i + 1)));
+        pubKeyShares.emplace_back(cache.BuildPubKeyShare(id.GetHash(), vvec, id));
+        BOOST_CHECK(cache.DynamicMemoryUsage() <= nMaxUsage);
+    }
+    BOOST_CHECK(cache.DynamicMemoryUsage() > 0);
+
+    // evicted entries are rebuilt with the same result
+    for (int i = 0; i < 100; i++) {
+        CBLSId id(ArithToUint256(arith_uint256(i + 1)));
+        BOOST_CHECK(cache.BuildPubKeyShare(id.GetHash(), vvec, id) == pubKeyShares[i]);
+    }
+
+    worker.Stop();
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,7 @@
 
 #include <coins.h>
 #include <script/standard.h>
+#include <txdb.h>
 #include <uint256.h>
 #include <undo.h>
 #include <utilstrencodings.h>
@@ -855,4 +856,122 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_add_fetched)
+{
+    CCoinsViewTest base;
+    CCoinsViewCacheTest cache(&base);
+    COutPoint outpoint(InsecureRand256(), 0);
+
+    Coin coin;
+    coin.out.nValue = 1;
+    coin.nHeight = 1;
+    cache.AddFetchedCoin(outpoint, Coin(coin));
+    BOOST_CHECK(cache.HaveCoinInCache(outpoint));
+    BOOST_CHECK_EQUAL(cache.map().at(outpoint).flags, 0);
+    cache.SelfTest();
+
+    // entries which are cached already are never replaced
+    Coin coin2;
+    coin2.out.nValue = 2;
+    coin2.nHeight = 2;
+    cache.AddFetchedCoin(outpoint, std::move(coin2));
+    BOOST_CHECK_EQUAL(cache.AccessCoin(outpoint).out.nValue, 1);
+
+    // spent coins are not added
+    COutPoint outpoint2(InsecureRand256(), 0);
+    cache.AddFetchedCoin(outpoint2, Coin());
+    BOOST_CHECK(!cache.HaveCoinInCache(outpoint2));
+    cache.SelfTest();
+
+    // fetched coins are not dirty, so they aren't written back
+    BOOST_CHECK(cache.Flush());
+    Coin coinRet;
+    BOOST_CHECK(!base.GetCoin(outpoint, coinRet));
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_flush_and_trim)
+{
+    CCoinsViewTest base;
+    CCoinsViewCacheTest cache(&base);
+
+    // 10 blocks with 10 new coins each, every block is one access epoch of the cache
+    std::vector<std::vector<COutPoint>> blocks(10);
+    for (auto& block : blocks) {
+        CCoinsViewCacheTest view(&cache);
+        for (int i = 0; i < 10; i++) {
+            block.emplace_back(InsecureRand256(), 0);
+            Coin coin;
+            coin.out.nValue = 1;
+            coin.nHeight = 1;
+            view.AddCoin(block.back(), std::move(coin), false);
+        }
+        BOOST_CHECK(view.Flush());
+    }
+    // the coins of the first block are used again
+    for (const auto& outpoint : blocks[0]) {
+        BOOST_CHECK(cache.HaveCoin(outpoint));
+    }
+
+    // room for 30 coins, which are the ones of the first and the last two blocks
+    const size_t nNodeUsage = memusage::MallocUsage(sizeof(memusage::unordered_node<CCoinsMap::value_type>));
+    const size_t nMaxUsage = memusage::MallocUsage(sizeof(void*) * cache.map().bucket_count()) + 30 * nNodeUsage;
+    BOOST_CHECK(cache.FlushAndTrim(nMaxUsage));
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 30);
+    BOOST_CHECK(cache.DynamicMemoryUsage() <= nMaxUsage);
+    cache.SelfTest();
+    for (size_t i = 0; i < blocks.size(); i++) {
+        for (const auto& outpoint : blocks[i]) {
+            Coin coin;
+            BOOST_CHECK(base.GetCoin(outpoint, coin));
+            const bool fKept = i == 0 || i >= 8;
+            BOOST_CHECK_EQUAL(cache.HaveCoinInCache(outpoint), fKept);
+            if (fKept) {
+                BOOST_CHECK_EQUAL(cache.map().at(outpoint).flags, 0);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_db_background_write)
+{
+    SetDataDir("ccoins_db_background_write");
+    CCoinsViewDB db(1 << 20, true);
+    db.StartBackgroundWrites();
+
+    COutPoint outpoint(InsecureRand256(), 0);
+    Coin coin;
+    coin.out.nValue = 1;
+    coin.nHeight = 1;
+    uint256 hashBlock = InsecureRand256();
+    {
+        CCoinsViewCache cache(&db);
+        cache.AddCoin(outpoint, std::move(coin), false);
+        cache.SetBestBlock(hashBlock);
+        BOOST_CHECK(cache.Flush());
+    }
+
+    // the view is consistent while the write may still be in progress
+    Coin coinRet;
+    BOOST_CHECK(db.GetCoin(outpoint, coinRet));
+    BOOST_CHECK_EQUAL(coinRet.out.nValue, 1);
+    BOOST_CHECK(db.GetBestBlock() == hashBlock);
+
+    BOOST_CHECK(db.WaitForPendingWrite());
+    BOOST_CHECK(!db.IsWritePending());
+    BOOST_CHECK(db.GetHeadBlocks().empty());
+    BOOST_CHECK(db.HaveCoin(outpoint));
+    BOOST_CHECK(db.GetBestBlock() == hashBlock);
+
+    // spending it in a second flush
+    {
+        CCoinsViewCache cache(&db);
+        BOOST_CHECK(cache.SpendCoin(outpoint));
+        cache.SetBestBlock(InsecureRand256());
+        BOOST_CHECK(cache.Flush());
+    }
+    BOOST_CHECK(!db.HaveCoin(outpoint));
+    BOOST_CHECK(db.WaitForPendingWrite());
+    BOOST_CHECK(!db.GetCoin(outpoint, coinRet));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,7 @@
 #include <crypto/aes.h>
 #include <crypto/chacha20.h>
 #include <crypto/chacha_poly_aead.h>
+#include <crypto/muhash.h>
 #include <crypto/poly1305.h>
 #include <crypto/ripemd160.h>
 #include <crypto/sha1.h>
@@ -824,4 +825,84 @@ BOOST_AUTO_TEST_CASE(sha256d64)
     }
 }
 
+static MuHash3072 FromInt(unsigned char i) {
+    unsigned char tmp[32] = {i, 0};
+    return MuHash3072(tmp, 32);
+}
+
+BOOST_AUTO_TEST_CASE(muhash_tests)
+{
+    uint256 out;
+
+    // the empty set, and a set in which an element was added and removed
+    MuHash3072 empty;
+    empty.Finalize(out);
+    uint256 out_empty = out;
+    MuHash3072 acc = FromInt(0);
+    acc /= FromInt(0);
+    acc.Finalize(out);
+    BOOST_CHECK(out == out_empty);
+
+    // the order of the operations doesn't matter
+    for (int iter = 0; iter < 10; ++iter) {
+        uint256 res;
+        int table[4];
+        for (int i = 0; i < 4; ++i) {
+            table[i] = InsecureRandBits(3);
+        }
+        for (int order = 0; order < 4; ++order) {
+            MuHash3072 acc;
+            for (int i = 0; i < 4; ++i) {
+                int t = table[i ^ order];
+                if (t & 4) {
+                    acc /= FromInt(t & 3);
+                } else {
+                    acc *= FromInt(t & 3);
+                }
+            }
+            acc.Finalize(out);
+            if (order == 0) {
+                res = out;
+            } else {
+                BOOST_CHECK(res == out);
+            }
+        }
+
+        MuHash3072 x = FromInt(InsecureRandBits(4)); // x=X
+        MuHash3072 y = FromInt(InsecureRandBits(4)); // x=X, y=Y
+        MuHash3072 z; // x=X, y=Y, z=1
+        z *= x; // x=X, y=Y, z=X
+        z *= y; // x=X, y=Y, z=X*Y
+        y *= x; // x=X, y=X*Y, z=X*Y
+        z /= y; // x=X, y=X*Y, z=1
+        z.Finalize(out);
+        BOOST_CHECK(out == out_empty);
+    }
+
+    // the same test vector as Bitcoin Core, so that the hash of a UTXO set can be compared
+    MuHash3072 acc2 = FromInt(0);
+    acc2 *= FromInt(1);
+    acc2 /= FromInt(2);
+    acc2.Finalize(out);
+    BOOST_CHECK(out == uint256S("10d312b100cbd32ada024a6646e40d3482fcff103668d2625f10002a607d5863"));
+
+    // Insert() and Remove() of the serialized elements are the same as multiplying and dividing
+    std::vector<unsigned char> vch0(32, 0), vch1(32, 0), vch2(32, 0);
+    vch1[0] = 1;
+    vch2[0] = 2;
+    MuHash3072 acc3;
+    acc3.Insert(vch0).Insert(vch1).Remove(vch2);
+    uint256 out3;
+    acc3.Finalize(out3);
+    BOOST_CHECK(out == out3);
+
+    // and serializing keeps the value
+    CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+    ss << acc3;
+    MuHash3072 acc4;
+    ss >> acc4;
+    acc4.Finalize(out3);
+    BOOST_CHECK(out == out3);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
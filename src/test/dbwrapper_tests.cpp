@@ -317,6 +317,65 @@ BOOST_AUTO_TEST_CASE(iterator_string_ordering)
     }
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_nested_transactions)
+{
+    fs::path ph = fs::temp_directory_path() / fs::unique_path();
+    CDBWrapper dbw(ph, (1 << 20), true, false, false);
+    CDBBatch batch(dbw);
+    CDBTransaction<CDBWrapper, CDBBatch> root(dbw, batch);
+    CDBTransaction<CDBTransaction<CDBWrapper, CDBBatch>, CDBTransaction<CDBWrapper, CDBBatch>> cur(root, root);
+
+    const std::vector<uint256> vValue(100, InsecureRand256());
+    cur.Write(std::string("a"), vValue);
+    cur.Write(std::string("b"), vValue);
+    cur.Write(std::string("b"), uint256());
+    cur.Erase(std::string("a"));
+    cur.Write(std::string("a"), vValue);
+    const size_t nMemoryUsage = cur.GetMemoryUsage();
+
+    // committing moves the values into the parent, with their sizes
+    cur.Commit();
+    BOOST_CHECK(cur.IsClean());
+    BOOST_CHECK_EQUAL(root.GetMemoryUsage(), nMemoryUsage);
+    std::vector<uint256> vRead;
+    uint256 hashRead;
+    BOOST_CHECK(root.Read(std::string("a"), vRead));
+    BOOST_CHECK(vRead == vValue);
+    BOOST_CHECK(root.Read(std::string("b"), hashRead));
+    BOOST_CHECK(hashRead.IsNull());
+
+    root.Commit();
+    BOOST_CHECK(dbw.WriteBatch(batch));
+    vRead.clear();
+    BOOST_CHECK(dbw.Read(std::string("a"), vRead));
+    BOOST_CHECK(vRead == vValue);
+}
 
+BOOST_AUTO_TEST_CASE(dbwrapper_tune_args)
+{
+    CDBOptions dbOptions = GetDefaultDBOptions(DBRole::LLMQ, 8 << 20);
+    BOOST_CHECK_EQUAL(dbOptions.nBloomBits, 16);
+
+    BOOST_CHECK(ApplyDBTuneArg("llmq:writebuffer=1024", "llmq", dbOptions));
+    BOOST_CHECK_EQUAL(dbOptions.nWriteBufferSize, 1 << 20);
+    BOOST_CHECK(ApplyDBTuneArg("llmq:compression=1", "llmq", dbOptions));
+    BOOST_CHECK(dbOptions.fCompression);
+    // arguments for other databases are only checked
+    BOOST_CHECK(ApplyDBTuneArg("evodb:bloombits=0", "llmq", dbOptions));
+    BOOST_CHECK_EQUAL(dbOptions.nBloomBits, 16);
+
+    BOOST_CHECK(!ApplyDBTuneArg("llmq:unknown=1", "llmq", dbOptions));
+    BOOST_CHECK(!ApplyDBTuneArg("llmq:blocksize=-1", "llmq", dbOptions));
+    BOOST_CHECK(!ApplyDBTuneArg("blocksize=4", "", dbOptions));
+    BOOST_CHECK(!ApplyDBTuneArg(":blocksize=4", "", dbOptions));
+    BOOST_CHECK(!ApplyDBTuneArg("llmq:blocksize", "", dbOptions));
+
+    fs::path ph = fs::temp_directory_path() / fs::unique_path();
+    CDBWrapper dbw(ph, dbOptions, true, false, false);
+    BOOST_CHECK(dbw.GetDBOptions().fCompression);
+    std::string strStats;
+    BOOST_CHECK(dbw.GetProperty("leveldb.stats", strStats));
+    BOOST_CHECK(!dbw.GetProperty("leveldb.unknown", strStats));
+}
 
 BOOST_AUTO_TEST_SUITE_END()
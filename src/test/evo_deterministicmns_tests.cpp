@@ -648,4 +648,76 @@ BOOST_FIXTURE_TEST_CASE(dip3_verify_db, TestChainDIP3Setup)
     BOOST_ASSERT(CVerifyDB().VerifyDB(Params(), pcoinsTip.get(), 4, 2));
 }
 
+BOOST_FIXTURE_TEST_CASE(dip3_payment_queue, BasicTestingSetup)
+{
+    // the incrementally maintained payment order must always match sorting all valid MNs from scratch
+    auto getHeight = [](const CDeterministicMNCPtr& dmn) {
+        int height = dmn->pdmnState->nLastPaidHeight;
+        if (dmn->pdmnState->nPoSeRevivedHeight != -1 && dmn->pdmnState->nPoSeRevivedHeight > height) {
+            height = dmn->pdmnState->nPoSeRevivedHeight;
+        } else if (height == 0) {
+            height = dmn->pdmnState->nRegisteredHeight;
+        }
+        return height;
+    };
+    auto checkPayees = [&](const CDeterministicMNList& mnList) {
+        std::vector<CDeterministicMNCPtr> expected;
+        mnList.ForEachMN(true, [&](const CDeterministicMNCPtr& dmn) {
+            expected.emplace_back(dmn);
+        });
+        std::sort(expected.begin(), expected.end(), [&](const CDeterministicMNCPtr& a, const CDeterministicMNCPtr& b) {
+            int ah = getHeight(a);
+            int bh = getHeight(b);
+            return ah == bh ? a->proTxHash < b->proTxHash : ah < bh;
+        });
+        auto payees = mnList.GetProjectedMNPayees((int)mnList.GetAllMNsCount());
+        BOOST_CHECK_EQUAL(mnList.GetValidMNsCount(), expected.size());
+        BOOST_REQUIRE_EQUAL(payees.size(), expected.size());
+        for (size_t i = 0; i < payees.size(); i++) {
+            BOOST_CHECK(payees[i]->proTxHash == expected[i]->proTxHash);
+        }
+        BOOST_CHECK(mnList.GetMNPayee() == (expected.empty() ? nullptr : expected.front()));
+    };
+
+    CDeterministicMNList mnList(uint256(), 0, 0);
+    std::vector<uint256> proTxHashes;
+    for (int i = 0; i < 50; i++) {
+        auto dmn = std::make_shared<CDeterministicMN>(i);
+        dmn->proTxHash = InsecureRand256();
+        dmn->collateralOutpoint = COutPoint(InsecureRand256(), 0);
+        auto state = std::make_shared<CDeterministicMNState>();
+        state->nRegisteredHeight = InsecureRandRange(10);
+        uint256 keyId = InsecureRand256();
+        state->keyIDOwner = CKeyID(uint160(std::vector<unsigned char>(keyId.begin(), keyId.begin() + 20)));
+        dmn->pdmnState = state;
+        mnList.AddMN(dmn);
+        proTxHashes.emplace_back(dmn->proTxHash);
+    }
+    checkPayees(mnList);
+
+    for (int i = 0; i < 200; i++) {
+        CDeterministicMNList prevList = mnList;
+        const uint256& proTxHash = proTxHashes[InsecureRandRange(proTxHashes.size())];
+        auto newState = std::make_shared<CDeterministicMNState>(*mnList.GetMN(proTxHash)->pdmnState);
+        switch (InsecureRandRange(3)) {
+        case 0:
+            newState->nLastPaidHeight = 10 + i;
+            break;
+        case 1:
+            newState->BanIfNotBanned(10 + i);
+            break;
+        case 2:
+            newState->Revive(10 + i);
+            break;
+        }
+        mnList.UpdateMN(proTxHash, newState);
+        checkPayees(mnList);
+        // older versions are not affected by updates
+        checkPayees(prevList);
+    }
+
+    mnList.RemoveMN(proTxHashes.front());
+    checkPayees(mnList);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
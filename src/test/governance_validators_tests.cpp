@@ -59,6 +59,14 @@ BOOST_AUTO_TEST_CASE(valid_proposals_test)
         CProposalValidator validator2(strHexData2, false);
         BOOST_CHECK_MESSAGE(validator2.Validate(false), validator2.GetErrorMessages());
         BOOST_CHECK_MESSAGE(!validator2.Validate(), validator2.GetErrorMessages());
+
+        // already parsed data
+        CProposalValidator validator3(objProposal, objProposal.write().size());
+        BOOST_CHECK_MESSAGE(validator3.Validate(false), validator3.GetErrorMessages());
+        CProposalData data;
+        BOOST_CHECK(validator3.GetProposalData(data));
+        BOOST_CHECK_EQUAL(data.nEndEpoch, objProposal["end_epoch"].get_int64());
+        BOOST_CHECK_EQUAL(data.strPaymentAddress, objProposal["payment_address"].get_str());
     }
 }
 
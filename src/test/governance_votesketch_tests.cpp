@@ -0,0 +1,93 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <governance/governance-votesketch.h>
+#include <streams.h>
+#include <version.h>
+
+#include <test/test_dash.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(governance_votesketch_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(votesketch_reconcile)
+{
+    uint256 nParentHash = InsecureRand256();
+    uint64_t nSalt = InsecureRandBits(64);
+
+    std::vector<uint256> vecCommon, vecOnlyOurs, vecOnlyTheirs;
+    for (int i = 0; i < 500; i++) {
+        vecCommon.emplace_back(InsecureRand256());
+    }
+    for (int i = 0; i < 10; i++) {
+        vecOnlyOurs.emplace_back(InsecureRand256());
+    }
+    for (int i = 0; i < 5; i++) {
+        vecOnlyTheirs.emplace_back(InsecureRand256());
+    }
+
+    size_t nCells = CGovernanceVoteSketch::GetCellCountForVotes(vecCommon.size() + vecOnlyTheirs.size());
+    CGovernanceVoteSketch ours(nParentHash, nSalt, nCells);
+    CGovernanceVoteSketch theirs(nParentHash, nSalt, nCells);
+    for (const auto& h : vecCommon) {
+        ours.Add(h);
+        theirs.Add(h);
+    }
+    for (const auto& h : vecOnlyOurs) {
+        ours.Add(h);
+    }
+    for (const auto& h : vecOnlyTheirs) {
+        theirs.Add(h);
+    }
+
+    // the received sketch must survive serialization
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << theirs;
+    CGovernanceVoteSketch received;
+    ss >> received;
+    BOOST_CHECK(received.IsValid());
+
+    BOOST_CHECK(ours.Subtract(received));
+    std::set<uint64_t> setPositive, setNegative;
+    BOOST_CHECK(ours.Decode(setPositive, setNegative));
+
+    std::set<uint64_t> setExpectedPositive, setExpectedNegative;
+    for (const auto& h : vecOnlyOurs) {
+        setExpectedPositive.emplace(ours.GetShortId(h));
+    }
+    for (const auto& h : vecOnlyTheirs) {
+        setExpectedNegative.emplace(ours.GetShortId(h));
+    }
+    BOOST_CHECK(setPositive == setExpectedPositive);
+    BOOST_CHECK(setNegative == setExpectedNegative);
+
+    // sketches with different parameters can't be subtracted
+    CGovernanceVoteSketch other(nParentHash, nSalt + 1, nCells);
+    BOOST_CHECK(!ours.Subtract(other));
+}
+
+BOOST_AUTO_TEST_CASE(votesketch_too_many_differences)
+{
+    uint256 nParentHash = InsecureRand256();
+    CGovernanceVoteSketch ours(nParentHash, InsecureRandBits(64), CGovernanceVoteSketch::MIN_CELLS);
+    CGovernanceVoteSketch theirs(nParentHash, ours.GetSalt(), CGovernanceVoteSketch::MIN_CELLS);
+    for (size_t i = 0; i < CGovernanceVoteSketch::MIN_CELLS * 2; i++) {
+        ours.Add(InsecureRand256());
+    }
+
+    BOOST_CHECK(ours.Subtract(theirs));
+    std::set<uint64_t> setPositive, setNegative;
+    BOOST_CHECK(!ours.Decode(setPositive, setNegative));
+}
+
+BOOST_AUTO_TEST_CASE(votesketch_invalid_size)
+{
+    BOOST_CHECK(!CGovernanceVoteSketch(uint256(), 0, CGovernanceVoteSketch::MIN_CELLS - CGovernanceVoteSketch::NUM_HASHES).IsValid());
+    BOOST_CHECK(!CGovernanceVoteSketch(uint256(), 0, CGovernanceVoteSketch::MIN_CELLS + 1).IsValid());
+    BOOST_CHECK(!CGovernanceVoteSketch(uint256(), 0, CGovernanceVoteSketch::MAX_CELLS + CGovernanceVoteSketch::NUM_HASHES).IsValid());
+    BOOST_CHECK(CGovernanceVoteSketch(uint256(), 0, CGovernanceVoteSketch::MAX_CELLS).IsValid());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
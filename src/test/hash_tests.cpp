@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <hash.h>
+#include <primitives/block.h>
 #include <utilstrencodings.h>
 #include <test/test_dash.h>
 
@@ -149,4 +150,23 @@ BOOST_AUTO_TEST_CASE(siphash)
     BOOST_CHECK_EQUAL(SipHashUint256(1, 2, ss.GetHash()), 0x79751e980c2a0a35ULL);
 }
 
+BOOST_AUTO_TEST_CASE(hashx11multi_tests)
+{
+    // Cover a partial group of lanes and more than one group
+    std::vector<CBlockHeader> headers(2 * X11_MULTI_LANES + 3);
+    for (CBlockHeader& header : headers) {
+        header.nVersion = InsecureRand32();
+        header.hashPrevBlock = InsecureRand256();
+        header.hashMerkleRoot = InsecureRand256();
+        header.nTime = InsecureRand32();
+        header.nBits = InsecureRand32();
+        header.nNonce = InsecureRand32();
+    }
+    std::vector<uint256> hashes(headers.size());
+    HashX11Multi(headers.data(), headers.size(), hashes.data());
+    for (size_t i = 0; i < headers.size(); i++) {
+        BOOST_CHECK(hashes[i] == headers[i].GetHash());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,62 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/test_dash.h>
+
+#include <llmq/quorums_chainlocks.h>
+#include <random.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(llmq_chainlocks_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(tx_first_seen_times)
+{
+    const int64_t nTimeBase = 1000000;
+    llmq::CTxFirstSeenTimes times(nTimeBase);
+
+    // enough entries to force a few resizes, every 10th one mined at height i / 10
+    std::vector<uint256> txids;
+    for (int i = 0; i < 10000; i++) {
+        txids.emplace_back(InsecureRand256());
+        times.Add(txids.back(), nTimeBase + i, i % 10 == 0 ? i / 10 : -1);
+    }
+    BOOST_CHECK_EQUAL(times.size(), txids.size());
+
+    int64_t nTime;
+    for (size_t i = 0; i < txids.size(); i++) {
+        BOOST_CHECK(times.Get(txids[i], nTime));
+        BOOST_CHECK_EQUAL(nTime, nTimeBase + (int64_t)i);
+    }
+    BOOST_CHECK(!times.Get(InsecureRand256(), nTime));
+
+    // existing times are not overwritten, times before the base are clamped
+    times.Add(txids[1], nTimeBase + 12345);
+    BOOST_CHECK(times.Get(txids[1], nTime) && nTime == nTimeBase + 1);
+    uint256 oldTxid = InsecureRand256();
+    times.Add(oldTxid, nTimeBase - 100);
+    BOOST_CHECK(times.Get(oldTxid, nTime) && nTime == nTimeBase);
+    times.Remove(oldTxid);
+    BOOST_CHECK(!times.Get(oldTxid, nTime));
+
+    // prune everything mined at or below height 499, which are the first 500 mined entries
+    BOOST_CHECK_EQUAL(times.PruneMined(499), 500);
+    BOOST_CHECK_EQUAL(times.size(), txids.size() - 500);
+    for (size_t i = 0; i < txids.size(); i++) {
+        bool fPruned = i % 10 == 0 && i / 10 <= 499;
+        BOOST_CHECK_EQUAL(times.Get(txids[i], nTime), !fPruned);
+    }
+
+    // unmined entries are never pruned
+    times.SetMinedHeight(txids[10000 - 10], -1);
+    BOOST_CHECK_EQUAL(times.PruneMined(std::numeric_limits<int>::max()), 499);
+    BOOST_CHECK_EQUAL(times.size(), 9000 + 1);
+
+    for (size_t i = 0; i < txids.size(); i++) {
+        times.Remove(txids[i]);
+    }
+    BOOST_CHECK_EQUAL(times.size(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
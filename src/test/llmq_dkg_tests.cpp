@@ -0,0 +1,98 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/test_dash.h>
+
+#include <llmq/quorums_dkgsessionhandler.h>
+#include <protocol.h>
+
+#include <boost/test/unit_test.hpp>
+
+// pushes a message consisting of a single uint32 payload of the given size
+static void PushMessage(llmq::CDKGPendingMessages& pending, NodeId from, uint32_t id, size_t size = 0)
+{
+    CDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
+    ds << id;
+    ds << std::vector<unsigned char>(size);
+    pending.PushPendingMessage(from, ds);
+}
+
+static std::vector<std::pair<NodeId, uint32_t>> PopMessages(llmq::CDKGPendingMessages& pending, size_t maxCount)
+{
+    std::vector<std::pair<NodeId, uint32_t>> ret;
+    for (auto& bm : pending.PopPendingMessages(maxCount)) {
+        uint32_t id;
+        *bm.second >> id;
+        ret.emplace_back(bm.first, id);
+    }
+    return ret;
+}
+
+BOOST_FIXTURE_TEST_SUITE(llmq_dkg_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(pending_messages_round_robin)
+{
+    llmq::CDKGPendingMessages pending(10, 1024 * 1024, MSG_QUORUM_CONTRIB);
+
+    // node 1 spams, nodes 2 and 3 send a single message each
+    for (uint32_t i = 0; i < 5; i++) {
+        PushMessage(pending, 1, 100 + i);
+    }
+    PushMessage(pending, 2, 200);
+    PushMessage(pending, 3, 300);
+    // duplicates are dropped, no matter who sends them
+    PushMessage(pending, 2, 100);
+    PushMessage(pending, 3, 300);
+
+    auto msgs = PopMessages(pending, 3);
+    BOOST_CHECK(msgs == (std::vector<std::pair<NodeId, uint32_t>>{{1, 100}, {2, 200}, {3, 300}}));
+    msgs = PopMessages(pending, 10);
+    BOOST_CHECK(msgs == (std::vector<std::pair<NodeId, uint32_t>>{{1, 101}, {1, 102}, {1, 103}, {1, 104}}));
+
+    // the per node limit still applies to messages that were already popped
+    for (uint32_t i = 5; i < 15; i++) {
+        PushMessage(pending, 1, 100 + i);
+    }
+    BOOST_CHECK_EQUAL(PopMessages(pending, 100).size(), 5U);
+}
+
+BOOST_AUTO_TEST_CASE(pending_messages_memory_limit)
+{
+    // room for ~4 messages of 1000 bytes
+    llmq::CDKGPendingMessages pending(100, 4200, MSG_QUORUM_CONTRIB);
+
+    for (uint32_t i = 0; i < 4; i++) {
+        PushMessage(pending, 1, 100 + i, 1000);
+    }
+    // node 1 occupies the whole budget, so it can't push more
+    PushMessage(pending, 1, 104, 1000);
+    // but other nodes can, by evicting the newest messages of node 1
+    PushMessage(pending, 2, 200, 1000);
+    PushMessage(pending, 3, 300, 1000);
+
+    auto msgs = PopMessages(pending, 100);
+    BOOST_CHECK(msgs == (std::vector<std::pair<NodeId, uint32_t>>{{1, 100}, {2, 200}, {3, 300}, {1, 101}}));
+
+    // evicted messages can be received again
+    PushMessage(pending, 2, 103, 1000);
+    msgs = PopMessages(pending, 100);
+    BOOST_CHECK(msgs == (std::vector<std::pair<NodeId, uint32_t>>{{2, 103}}));
+}
+
+BOOST_AUTO_TEST_CASE(pending_messages_passed_phase)
+{
+    llmq::CDKGPendingMessages pending(10, 1024 * 1024, MSG_QUORUM_CONTRIB);
+
+    PushMessage(pending, 1, 100);
+    pending.DropPendingForPassedPhase();
+    PushMessage(pending, 1, 101);
+    BOOST_CHECK(PopMessages(pending, 10).empty());
+
+    // a new DKG round accepts messages again
+    pending.Clear();
+    PushMessage(pending, 1, 100);
+    BOOST_CHECK_EQUAL(PopMessages(pending, 10).size(), 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
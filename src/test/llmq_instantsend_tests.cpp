@@ -0,0 +1,103 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/test_dash.h>
+
+#include <llmq/quorums_instantsend.h>
+#include <random.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(llmq_instantsend_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(outpoint_index)
+{
+    llmq::CInstantSendOutpointIndex index;
+    index.Init(1 << 20);
+    BOOST_CHECK(index.IsComplete());
+
+    std::vector<std::pair<COutPoint, uint256>> entries;
+    for (uint32_t i = 0; i < 5000; i++) {
+        entries.emplace_back(COutPoint(InsecureRand256(), i % 3), InsecureRand256());
+        index.Add(entries.back().first, entries.back().second);
+    }
+    BOOST_CHECK_EQUAL(index.size(), entries.size());
+
+    uint256 islockHash;
+    for (const auto& e : entries) {
+        BOOST_CHECK(index.Lookup(e.first, islockHash));
+        BOOST_CHECK(islockHash == e.second);
+    }
+    BOOST_CHECK(index.Lookup(COutPoint(InsecureRand256(), 0), islockHash));
+    BOOST_CHECK(islockHash.IsNull());
+
+    // remove every second entry, the remaining ones must still be found after the backward shifts
+    for (size_t i = 0; i < entries.size(); i += 2) {
+        index.Remove(entries[i].first);
+    }
+    BOOST_CHECK_EQUAL(index.size(), entries.size() / 2);
+    for (size_t i = 0; i < entries.size(); i++) {
+        BOOST_CHECK(index.Lookup(entries[i].first, islockHash));
+        BOOST_CHECK(i % 2 == 0 ? islockHash.IsNull() : islockHash == entries[i].second);
+    }
+
+    // overwriting keeps the count
+    index.Add(entries[1].first, entries[0].second);
+    BOOST_CHECK_EQUAL(index.size(), entries.size() / 2);
+    BOOST_CHECK(index.Lookup(entries[1].first, islockHash));
+    BOOST_CHECK(islockHash == entries[0].second);
+}
+
+BOOST_AUTO_TEST_CASE(outpoint_index_budget)
+{
+    llmq::CInstantSendOutpointIndex index;
+
+    // a budget which doesn't even fit the minimal table disables the index
+    index.Init(0);
+    BOOST_CHECK(!index.IsComplete());
+    uint256 islockHash;
+    BOOST_CHECK(!index.Lookup(COutPoint(InsecureRand256(), 0), islockHash));
+
+    index.Init(64 << 10);
+    BOOST_CHECK(index.IsComplete());
+    size_t i = 0;
+    while (index.IsComplete()) {
+        index.Add(COutPoint(InsecureRand256(), 0), InsecureRand256());
+        BOOST_CHECK(index.GetMemoryUsage() <= (64 << 10));
+        BOOST_REQUIRE(++i < 10000);
+    }
+    BOOST_CHECK_EQUAL(index.size(), 0);
+    BOOST_CHECK(!index.Lookup(COutPoint(InsecureRand256(), 0), islockHash));
+}
+
+BOOST_AUTO_TEST_CASE(known_locks)
+{
+    llmq::CInstantSendKnownLocks knownLocks;
+
+    uint256 txid = InsecureRand256();
+    uint256 islockHash = InsecureRand256();
+    uint256 ret;
+    BOOST_CHECK(!knownLocks.GetHashByTxid(txid, ret));
+    BOOST_CHECK(!knownLocks.IsKnownHash(islockHash));
+
+    knownLocks.Add(islockHash, txid);
+    BOOST_CHECK(knownLocks.GetHashByTxid(txid, ret));
+    BOOST_CHECK(ret == islockHash);
+    BOOST_CHECK(knownLocks.IsKnownHash(islockHash));
+
+    // removed islocks are archived, so only the txid is forgotten
+    knownLocks.RemoveTxid(txid);
+    BOOST_CHECK(!knownLocks.GetHashByTxid(txid, ret));
+    BOOST_CHECK(knownLocks.IsKnownHash(islockHash));
+
+    knownLocks.RemoveKnownHash(islockHash);
+    BOOST_CHECK(!knownLocks.IsKnownHash(islockHash));
+
+    knownLocks.Add(islockHash, txid);
+    knownLocks.Clear();
+    BOOST_CHECK(!knownLocks.GetHashByTxid(txid, ret));
+    BOOST_CHECK(!knownLocks.IsKnownHash(islockHash));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,159 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/test_dash.h>
+
+#include <llmq/quorums_signing.h>
+#include <llmq/quorums_signing_shares.h>
+#include <llmq/quorums_signing_stats.h>
+#include <streams.h>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace llmq;
+
+BOOST_FIXTURE_TEST_SUITE(llmq_signing_shares_tests, BasicTestingSetup)
+
+static uint256 SignHash(int i)
+{
+    return uint256S(strprintf("%064x", i + 1));
+}
+
+BOOST_AUTO_TEST_CASE(sigsharemap_basics)
+{
+    SigShareMap<int64_t> m;
+    BOOST_CHECK(m.Empty());
+    BOOST_CHECK(m.GetFirst() == nullptr);
+
+    BOOST_CHECK(m.Add(std::make_pair(SignHash(0), 0), 10));
+    BOOST_CHECK(m.Add(std::make_pair(SignHash(0), 399), 20));
+    BOOST_CHECK(!m.Add(std::make_pair(SignHash(0), 399), 30));
+    BOOST_CHECK(m.Add(std::make_pair(SignHash(1), 64), 40));
+
+    BOOST_CHECK_EQUAL(m.Size(), 3U);
+    BOOST_CHECK_EQUAL(m.CountForSignHash(SignHash(0)), 2U);
+    BOOST_CHECK_EQUAL(m.CountForSignHash(SignHash(1)), 1U);
+    BOOST_CHECK_EQUAL(m.CountForSignHash(SignHash(2)), 0U);
+    BOOST_CHECK(m.Has(std::make_pair(SignHash(0), 399)));
+    BOOST_CHECK(!m.Has(std::make_pair(SignHash(0), 398)));
+    BOOST_CHECK(!m.Has(std::make_pair(SignHash(1), 0)));
+    BOOST_CHECK_EQUAL(*m.Get(std::make_pair(SignHash(0), 399)), 20);
+    BOOST_CHECK_EQUAL(*m.GetFirst(), 10);
+
+    m.GetOrAdd(std::make_pair(SignHash(2), 5)) = 50;
+    BOOST_CHECK_EQUAL(*m.Get(std::make_pair(SignHash(2), 5)), 50);
+    BOOST_CHECK_EQUAL(m.Size(), 4U);
+
+    m.Erase(std::make_pair(SignHash(0), 0));
+    BOOST_CHECK_EQUAL(*m.GetFirst(), 20);
+    m.Erase(std::make_pair(SignHash(0), 399));
+    BOOST_CHECK_EQUAL(m.CountForSignHash(SignHash(0)), 0U);
+    BOOST_CHECK_EQUAL(m.Size(), 2U);
+
+    // freed slot gets reused and must not leak old entries
+    BOOST_CHECK(m.Add(std::make_pair(SignHash(3), 1), 60));
+    BOOST_CHECK(!m.Has(std::make_pair(SignHash(3), 399)));
+    BOOST_CHECK_EQUAL(m.Size(), 3U);
+
+    m.EraseAllForSignHash(SignHash(1));
+    BOOST_CHECK_EQUAL(m.Size(), 2U);
+
+    m.Clear();
+    BOOST_CHECK(m.Empty());
+    BOOST_CHECK_EQUAL(m.Size(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(sigsharemap_iterate)
+{
+    SigShareMap<bool> m;
+    for (int i = 0; i < 10; i++) {
+        for (uint16_t j = 0; j < 200; j += 3) {
+            m.Add(std::make_pair(SignHash(i), j), true);
+        }
+    }
+    size_t expected = m.Size();
+
+    size_t count = 0;
+    m.ForEach([&](const SigShareKey& k, bool v) {
+        BOOST_CHECK(v);
+        BOOST_CHECK_EQUAL(k.second % 3, 0);
+        count++;
+    });
+    BOOST_CHECK_EQUAL(count, expected);
+
+    count = 0;
+    m.ForEachForSignHash(SignHash(4), [&](const SigShareKey& k, bool v) {
+        BOOST_CHECK(k.first == SignHash(4));
+        count++;
+    });
+    BOOST_CHECK_EQUAL(count, m.CountForSignHash(SignHash(4)));
+
+    // remove all odd members and all of the first session
+    m.EraseIf([&](const SigShareKey& k, bool v) {
+        return k.first == SignHash(0) || (k.second % 2) != 0;
+    });
+    BOOST_CHECK_EQUAL(m.CountForSignHash(SignHash(0)), 0U);
+    m.ForEach([&](const SigShareKey& k, bool v) {
+        BOOST_CHECK_EQUAL(k.second % 2, 0);
+    });
+    BOOST_CHECK_EQUAL(m.Size(), 9U * 34U);
+}
+
+BOOST_AUTO_TEST_CASE(batchedsigshares_view)
+{
+    std::vector<CBatchedSigShares> batches(2);
+    batches[0].sessionId = 1;
+    batches[1].sessionId = 300;
+    for (uint16_t i = 0; i < 5; i++) {
+        std::vector<uint8_t> buf(CBLSSignature::SerSize, (uint8_t)(i + 1));
+        CBLSLazySignature sig;
+        CDataStream(buf, SER_NETWORK, PROTOCOL_VERSION) >> sig;
+        batches[i % 2].sigShares.emplace_back(i * 10, sig);
+    }
+
+    CDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
+    ds << batches;
+
+    std::vector<CBatchedSigSharesView> views;
+    SpanReader(ds.GetType(), ds.GetVersion(), Span<const unsigned char>((const unsigned char*)ds.data(), ds.size())) >> views;
+    BOOST_REQUIRE_EQUAL(views.size(), batches.size());
+    for (size_t i = 0; i < views.size(); i++) {
+        BOOST_CHECK_EQUAL(views[i].sessionId, batches[i].sessionId);
+        BOOST_REQUIRE_EQUAL(views[i].sigShares.size(), batches[i].sigShares.size());
+        for (size_t j = 0; j < views[i].sigShares.size(); j++) {
+            BOOST_CHECK_EQUAL(views[i].sigShares[j].first, batches[i].sigShares[j].first);
+            // signatures point into the message buffer
+            BOOST_CHECK(views[i].sigShares[j].second.data() >= (const unsigned char*)ds.data());
+            BOOST_CHECK(::SerializeHash(views[i].GetSigShare(j)) == ::SerializeHash(batches[i].sigShares[j].second));
+        }
+    }
+
+    // truncated messages must fail to parse
+    std::vector<CBatchedSigSharesView> truncated;
+    BOOST_CHECK_THROW(SpanReader(ds.GetType(), ds.GetVersion(), Span<const unsigned char>((const unsigned char*)ds.data(), ds.size() - 1)) >> truncated, std::ios_base::failure);
+}
+
+BOOST_AUTO_TEST_CASE(latency_histogram)
+{
+    llmq::CLatencyHistogram h;
+    h.Add(-5);
+    h.Add(1);
+    h.Add(2);
+    h.Add(150);
+    h.Add(100000);
+
+    BOOST_CHECK_EQUAL(h.count, 5);
+    BOOST_CHECK_EQUAL(h.sumMs, 1 + 2 + 150 + 100000);
+    BOOST_CHECK_EQUAL(h.maxMs, 100000);
+    BOOST_CHECK_EQUAL(h.buckets[0], 2); // <=1, negative values are clamped to 0
+    BOOST_CHECK_EQUAL(h.buckets[1], 1); // <=2
+    BOOST_CHECK_EQUAL(h.buckets[7], 1); // <=200
+    BOOST_CHECK_EQUAL(h.buckets[llmq::CLatencyHistogram::BUCKET_COUNT - 1], 1);
+
+    UniValue json = h.ToJson();
+    BOOST_CHECK_EQUAL(json["count"].get_int(), 5);
+    BOOST_CHECK_EQUAL(json["buckets"][">10000"].get_int(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -10,6 +10,7 @@
 #include <streams.h>
 #include <net.h>
 #include <netbase.h>
+#include <netmessagemaker.h>
 #include <chainparams.h>
 #include <util.h>
 
@@ -241,4 +242,116 @@ BOOST_AUTO_TEST_CASE(ipv4_peer_with_ipv6_addrMe_test)
     BOOST_CHECK(1);
 }
 
+
+BOOST_AUTO_TEST_CASE(shared_message_push)
+{
+    // nodes must outlive the connman, it keeps pointers to nodes with pending data
+    CAddress addr(CService(CNetAddr(), 7777), NODE_NETWORK);
+    CNode node1(0, NODE_NETWORK, 0, INVALID_SOCKET, addr, 0, 0, CAddress{}, std::string{}, false);
+    CNode node2(1, NODE_NETWORK, 0, INVALID_SOCKET, addr, 1, 1, CAddress{}, std::string{}, false);
+    CConnman connman(0x1337, 0x1337);
+
+    const CNetMsgMaker msgMaker(PROTOCOL_VERSION);
+    std::vector<unsigned char> vSmall(100, 0x42), vLarge(100000, 0x43);
+    auto smallMsg = CConnman::MakeSharedMessage(msgMaker.Make(NetMsgType::PING, vSmall));
+    auto largeMsg = CConnman::MakeSharedMessage(msgMaker.Make(NetMsgType::PING, vLarge));
+
+    connman.PushMessage(&node1, msgMaker.Make(NetMsgType::PING, vSmall));
+    connman.PushMessage(&node1, msgMaker.Make(NetMsgType::PING, vLarge));
+    connman.PushMessage(&node1, msgMaker.Make(NetMsgType::PING, vSmall));
+    connman.PushMessage(&node2, smallMsg);
+    connman.PushMessage(&node2, largeMsg);
+    connman.PushMessage(&node2, smallMsg);
+
+    auto flatten = [](CNode& node) {
+        LOCK(node.cs_vSend);
+        std::vector<unsigned char> vData;
+        for (const auto& buf : node.vSendMsg) {
+            vData.insert(vData.end(), buf.begin(), buf.end());
+        }
+        BOOST_CHECK_EQUAL(vData.size(), node.nSendSize);
+        return vData;
+    };
+    auto vData1 = flatten(node1);
+    BOOST_CHECK(vData1 == flatten(node2));
+    BOOST_CHECK_EQUAL(vData1.size(), 3 * CMessageHeader::HEADER_SIZE + 2 * ::GetSerializeSize(vSmall, SER_NETWORK, PROTOCOL_VERSION) + ::GetSerializeSize(vLarge, SER_NETWORK, PROTOCOL_VERSION));
+}
+
+
+BOOST_AUTO_TEST_CASE(direct_recv_buffer)
+{
+    CAddress addr(CService(CNetAddr(), 7777), NODE_NETWORK);
+    CNode node(0, NODE_NETWORK, 0, INVALID_SOCKET, addr, 0, 0, CAddress{}, std::string{}, false);
+
+    std::vector<unsigned char> vPayload(1000000);
+    for (size_t i = 0; i < vPayload.size(); i++) {
+        vPayload[i] = (unsigned char)i;
+    }
+    CSerializedNetMsg msg;
+    msg.command = NetMsgType::PING;
+    msg.data = vPayload;
+    auto sharedMsg = CConnman::MakeSharedMessage(std::move(msg));
+
+    // header and the start of the payload go through the regular path
+    bool complete = false;
+    std::vector<unsigned char> vStart(sharedMsg->header);
+    vStart.insert(vStart.end(), vPayload.begin(), vPayload.begin() + 1000);
+    BOOST_CHECK(node.ReceiveMsgBytes((const char*)vStart.data(), vStart.size(), complete));
+    BOOST_CHECK(!complete);
+
+    LOCK(node.cs_vRecv);
+    size_t nPos = 1000;
+    while (!complete) {
+        unsigned int nSize = 0;
+        char* pBuf = node.GetDirectRecvBuffer(1, nSize);
+        BOOST_REQUIRE(pBuf != nullptr);
+        nSize = std::min<unsigned int>(nSize, 0x10000);
+        memcpy(pBuf, vPayload.data() + nPos, nSize);
+        node.DirectRecvBufferWritten(nSize, complete);
+        nPos += nSize;
+    }
+    BOOST_CHECK_EQUAL(nPos, vPayload.size());
+    unsigned int nSize = 0;
+    BOOST_CHECK(node.GetDirectRecvBuffer(1, nSize) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(compact_message_header)
+{
+    // short ids must never be confused with the message start of a regular header
+    for (const std::string& chain : {CBaseChainParams::MAIN, CBaseChainParams::TESTNET, CBaseChainParams::DEVNET, CBaseChainParams::REGTEST}) {
+        BOOST_CHECK((uint8_t)CreateChainParams(chain, true)->MessageStart()[0] > MAX_SHORT_NET_MSG_TYPE_ID);
+    }
+    for (uint8_t i = 1; i <= GetShortNetMsgTypeCount(); i++) {
+        BOOST_CHECK_EQUAL(GetShortNetMsgTypeId(GetNetMsgTypeFromShortId(i)), i);
+    }
+    BOOST_CHECK(GetNetMsgTypeFromShortId(0) == nullptr);
+    BOOST_CHECK(GetNetMsgTypeFromShortId(GetShortNetMsgTypeCount() + 1) == nullptr);
+    BOOST_CHECK_EQUAL(GetShortNetMsgTypeId(NetMsgType::VERSION), 0);
+
+    CAddress addr(CService(CNetAddr(), 7777), NODE_NETWORK);
+    CNode node(0, NODE_NETWORK, 0, INVALID_SOCKET, addr, 0, 0, CAddress{}, std::string{}, false);
+    node.fRecvCompactHeaders = true;
+
+    // a compact ping followed by a regular one, fed byte by byte
+    uint64_t nonce = 0x1234;
+    std::vector<unsigned char> vData;
+    CVectorWriter{SER_NETWORK, PROTOCOL_VERSION, vData, 0, GetShortNetMsgTypeId(NetMsgType::PING), (uint32_t)sizeof(nonce), nonce};
+    CSerializedNetMsg msg = CNetMsgMaker(PROTOCOL_VERSION).Make(NetMsgType::PING, nonce);
+    auto sharedMsg = CConnman::MakeSharedMessage(std::move(msg));
+    vData.insert(vData.end(), sharedMsg->header.begin(), sharedMsg->header.end());
+    vData.insert(vData.end(), sharedMsg->data.begin(), sharedMsg->data.end());
+    BOOST_CHECK_EQUAL(vData.size(), CMessageHeader::COMPACT_HEADER_SIZE + CMessageHeader::HEADER_SIZE + 2 * sizeof(nonce));
+
+    bool complete = false;
+    for (unsigned char c : vData) {
+        BOOST_CHECK(node.ReceiveMsgBytes((const char*)&c, 1, complete));
+    }
+    BOOST_CHECK(complete);
+
+    // both were accounted as ping, each with its own header size
+    CNodeStats stats;
+    node.copyStats(stats);
+    BOOST_CHECK_EQUAL(stats.mapRecvBytesPerMsgCmd[NetMsgType::PING], vData.size());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
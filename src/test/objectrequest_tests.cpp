@@ -0,0 +1,97 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <objectrequest.h>
+
+#include <test/test_dash.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(objectrequest_tests, BasicTestingSetup)
+
+static const auto HaveNothing = [](const CInv& inv) { return false; };
+
+BOOST_AUTO_TEST_CASE(objectrequest_priority)
+{
+    CObjectRequestScheduler scheduler;
+    scheduler.AddPeer(1);
+    scheduler.SetPreferred(1, true);
+    std::chrono::microseconds now{std::chrono::seconds{1600000000}};
+
+    for (int i = 0; i < MAX_PEER_OBJECT_IN_FLIGHT; i++) {
+        scheduler.RequestObject(1, CInv(MSG_GOVERNANCE_OBJECT_VOTE, InsecureRand256()), now);
+    }
+    CInv islock(MSG_ISLOCK, InsecureRand256());
+    scheduler.RequestObject(1, islock, now);
+    // announcing twice is ignored
+    scheduler.RequestObject(1, islock, now);
+    BOOST_CHECK_EQUAL(scheduler.GetScheduledCount(1), MAX_PEER_OBJECT_IN_FLIGHT + 1);
+
+    // the ISLOCK is requested first, one vote has to wait for a free slot
+    std::vector<CInv> vRequests;
+    scheduler.GetRequests(1, now, HaveNothing, vRequests);
+    BOOST_CHECK_EQUAL(vRequests.size(), MAX_PEER_OBJECT_IN_FLIGHT);
+    BOOST_CHECK(vRequests.front().type == MSG_ISLOCK && vRequests.front().hash == islock.hash);
+    BOOST_CHECK_EQUAL(scheduler.GetScheduledCount(1), 1);
+
+    scheduler.EraseObjectRequest(1, islock);
+    vRequests.clear();
+    scheduler.GetRequests(1, now, HaveNothing, vRequests);
+    BOOST_CHECK_EQUAL(vRequests.size(), 1);
+    BOOST_CHECK_EQUAL(vRequests.front().type, MSG_GOVERNANCE_OBJECT_VOTE);
+
+    CObjectRequestScheduler::Stats stats = scheduler.GetStats();
+    BOOST_CHECK_EQUAL(stats.nInFlight, MAX_PEER_OBJECT_IN_FLIGHT);
+    BOOST_CHECK_EQUAL(stats.nRequested, MAX_PEER_OBJECT_IN_FLIGHT + 1);
+}
+
+BOOST_AUTO_TEST_CASE(objectrequest_timeout)
+{
+    CObjectRequestScheduler scheduler;
+    scheduler.AddPeer(1);
+    scheduler.AddPeer(2);
+    std::chrono::microseconds now{std::chrono::seconds{1600000000}};
+
+    CInv clsig(MSG_CLSIG, InsecureRand256());
+    scheduler.RequestObject(1, clsig, now);
+    scheduler.RequestObject(2, clsig, now);
+
+    std::vector<CInv> vRequests;
+    scheduler.GetRequests(1, now, HaveNothing, vRequests);
+    BOOST_CHECK_EQUAL(vRequests.size(), 1);
+
+    // requested from peer 1 already, peer 2 has to wait until that request times out
+    vRequests.clear();
+    scheduler.GetRequests(2, now, HaveNothing, vRequests);
+    BOOST_CHECK(vRequests.empty());
+    BOOST_CHECK_EQUAL(scheduler.GetScheduledCount(2), 1);
+
+    now += GetObjectInterval(MSG_CLSIG);
+    scheduler.GetRequests(2, now, HaveNothing, vRequests);
+    BOOST_CHECK_EQUAL(vRequests.size(), 1);
+
+    BOOST_CHECK(scheduler.ReceivedNotFound(2, clsig));
+    BOOST_CHECK(!scheduler.ReceivedNotFound(2, clsig));
+
+    now += GetObjectExpiryInterval(MSG_CLSIG);
+    vRequests.clear();
+    scheduler.GetRequests(1, now, HaveNothing, vRequests);
+    CObjectRequestScheduler::Stats stats = scheduler.GetStats();
+    BOOST_CHECK_EQUAL(stats.nTimedOut, 1);
+    BOOST_CHECK_EQUAL(stats.nNotFound, 1);
+    BOOST_CHECK_EQUAL(stats.nInFlight, 0);
+    BOOST_CHECK_EQUAL(stats.nAnnounced, 0);
+
+    // objects we have already are dropped
+    scheduler.RequestObject(1, clsig, now);
+    scheduler.GetRequests(1, now, [](const CInv& inv) { return true; }, vRequests);
+    BOOST_CHECK(vRequests.empty());
+    BOOST_CHECK_EQUAL(scheduler.GetStats().nAnnounced, 0);
+
+    scheduler.RemovePeer(1);
+    scheduler.RemovePeer(2);
+    BOOST_CHECK_EQUAL(scheduler.GetStats().nPeers, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -336,4 +336,25 @@ BOOST_AUTO_TEST_CASE(rpc_convert_values_generatetoaddress)
 }
 #endif // ENABLE_MINER
 
+BOOST_AUTO_TEST_CASE(rpc_json_stream_writer)
+{
+    UniValue result;
+    BOOST_CHECK(result.read("{\"a\":[1,\"two\",{\"b\\\"\":null,\"c\":[]},{}],\"d\":true,\"e\":-1.5}"));
+    const std::string strExpected = JSONRPCReply(result, NullUniValue, UniValue(7));
+
+    // a tiny chunk size hands every value to the sink separately
+    std::string strStreamed;
+    JSONStreamWriter writer([&](const std::string& strChunk) { strStreamed += strChunk; }, 1);
+    JSONRPCWriteReply(writer, result, NullUniValue, UniValue(7));
+    BOOST_CHECK(writer.HasFlushed());
+    strStreamed += writer.Finish();
+    BOOST_CHECK_EQUAL(strStreamed, strExpected);
+
+    // nothing reaches the sink if the reply fits into one chunk
+    JSONStreamWriter writerSmall([&](const std::string& strChunk) { BOOST_ERROR("unexpected chunk"); });
+    JSONRPCWriteReply(writerSmall, result, JSONRPCError(RPC_MISC_ERROR, "error"), UniValue(7));
+    BOOST_CHECK(!writerSmall.HasFlushed());
+    BOOST_CHECK_EQUAL(writerSmall.Finish(), JSONRPCReply(result, JSONRPCError(RPC_MISC_ERROR, "error"), UniValue(7)));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -154,4 +154,31 @@ BOOST_AUTO_TEST_CASE(singlethreadedscheduler_ordered)
     BOOST_CHECK_EQUAL(counter2, 100);
 }
 
+BOOST_AUTO_TEST_CASE(scheduler_task_stats)
+{
+    CScheduler scheduler("test");
+
+    // Only named tasks are counted, and only once they have run
+    int counter = 0;
+    for (int i = 0; i < 10; ++i) {
+        scheduler.schedule([&counter]() { ++counter; }, boost::chrono::system_clock::now(), "named");
+    }
+    scheduler.schedule([&counter]() { ++counter; });
+    BOOST_CHECK(scheduler.GetTaskStats().empty());
+
+    bool fListed = false;
+    ForEachScheduler([&fListed](const CScheduler& s) { fListed |= s.GetName() == "test"; });
+    BOOST_CHECK(fListed);
+
+    boost::thread thread(boost::bind(&CScheduler::serviceQueue, &scheduler));
+    scheduler.stop(true);
+    thread.join();
+
+    BOOST_CHECK_EQUAL(counter, 11);
+    const std::map<std::string, CSchedulerTaskStats> stats = scheduler.GetTaskStats();
+    BOOST_CHECK_EQUAL(stats.size(), 1U);
+    BOOST_CHECK_EQUAL(stats.at("named").nRuns, 10U);
+    BOOST_CHECK(stats.at("named").nMaxMicros <= stats.at("named").nTotalMicros);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
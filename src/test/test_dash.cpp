@@ -8,6 +8,7 @@
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
 #include <crypto/sha256.h>
+#include <crypto/x11.h>
 #include <validation.h>
 #include <miner.h>
 #include <net_processing.h>
@@ -22,22 +23,27 @@
 #include <evo/specialtx.h>
 #include <evo/deterministicmns.h>
 #include <evo/cbtx.h>
+#include <governance/governance-votedb.h>
 #include <llmq/quorums_init.h>
 
 void CConnmanTest::AddNode(CNode& node)
 {
     LOCK(g_connman->cs_vNodes);
     g_connman->vNodes.push_back(&node);
+    g_connman->UpdateNodesSnapshot();
     g_connman->mapSocketToNode.emplace(node.hSocket, &node);
 }
 
 void CConnmanTest::ClearNodes()
 {
     LOCK(g_connman->cs_vNodes);
-    for (CNode* node : g_connman->vNodes) {
+    std::vector<CNode*> vNodes;
+    vNodes.swap(g_connman->vNodes);
+    // drop the snapshot before the nodes are deleted
+    g_connman->UpdateNodesSnapshot();
+    for (CNode* node : vNodes) {
         delete node;
     }
-    g_connman->vNodes.clear();
     g_connman->mapSocketToNode.clear();
 
     g_connman->mapReceivableNodes.clear();
@@ -56,6 +62,7 @@ BasicTestingSetup::BasicTestingSetup(const std::string& chainName)
     : m_path_root(fs::temp_directory_path() / "test_dash" / strprintf("%lu_%i", (unsigned long)GetTime(), (int)(InsecureRandRange(1 << 30))))
 {
     SHA256AutoDetect();
+    X11AutoDetect();
     RandomInit();
     ECC_Start();
     BLSInit();
@@ -108,6 +115,7 @@ TestingSetup::TestingSetup(const std::string& chainName) : BasicTestingSetup(cha
         pblocktree.reset(new CBlockTreeDB(1 << 20, true));
         pcoinsdbview.reset(new CCoinsViewDB(1 << 23, true));
         llmq::InitLLMQSystem(*evoDb, true);
+        governanceDB = new CGovernanceDB(true, false);
         pcoinsTip.reset(new CCoinsViewCache(pcoinsdbview.get()));
         if (!LoadGenesisBlock(chainparams)) {
             throw std::runtime_error("LoadGenesisBlock failed.");
@@ -137,6 +145,8 @@ TestingSetup::~TestingSetup()
         UnloadBlockIndex();
         pcoinsTip.reset();
         llmq::DestroyLLMQSystem();
+        delete governanceDB;
+        governanceDB = nullptr;
         pcoinsdbview.reset();
         pblocktree.reset();
 }
@@ -0,0 +1,82 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <core_memusage.h>
+#include <txrelaycache.h>
+
+#include <test/test_dash.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(txrelaycache_tests, BasicTestingSetup)
+
+static CTransactionRef MakeTx(uint32_t n)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout.n = n;
+    tx.vout.resize(1);
+    tx.vout[0].nValue = n;
+    return MakeTransactionRef(tx);
+}
+
+BOOST_AUTO_TEST_CASE(txrelaycache_expiry)
+{
+    CTxRelayCache cache;
+    int64_t nNow = 1600000000;
+
+    auto tx1 = MakeTx(1);
+    auto tx2 = MakeTx(2);
+    cache.Add(tx1, nNow);
+    cache.Add(tx2, nNow + 5 * 60);
+    BOOST_CHECK(cache.Get(tx1->GetHash()) == tx1);
+    BOOST_CHECK(cache.Get(tx2->GetHash()) == tx2);
+    BOOST_CHECK(cache.Get(MakeTx(3)->GetHash()) == nullptr);
+    BOOST_CHECK_EQUAL(cache.GetStats().nCount, 2);
+
+    // kept for at least RELAY_TIME, at most one slot longer
+    cache.Expire(nNow + CTxRelayCache::RELAY_TIME - 1);
+    BOOST_CHECK(cache.Get(tx1->GetHash()) != nullptr);
+    cache.Expire(nNow + CTxRelayCache::RELAY_TIME + CTxRelayCache::WHEEL_SLOT_SECONDS);
+    BOOST_CHECK(cache.Get(tx1->GetHash()) == nullptr);
+    BOOST_CHECK(cache.Get(tx2->GetHash()) != nullptr);
+
+    // jumping far ahead clears everything
+    cache.Expire(nNow + 100 * CTxRelayCache::RELAY_TIME);
+    BOOST_CHECK_EQUAL(cache.GetStats().nCount, 0);
+    BOOST_CHECK_EQUAL(cache.GetStats().nBytes, 0);
+
+    // and the wheel is still usable afterwards
+    cache.Add(tx1, nNow + 100 * CTxRelayCache::RELAY_TIME);
+    BOOST_CHECK(cache.Get(tx1->GetHash()) != nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(txrelaycache_budget)
+{
+    auto tx0 = MakeTx(0);
+    size_t nTxBytes = RecursiveDynamicUsage(tx0);
+
+    CTxRelayCache cache(nTxBytes * 3);
+    int64_t nNow = 1600000000;
+    std::vector<CTransactionRef> vecTxs;
+    for (uint32_t i = 0; i < 5; i++) {
+        vecTxs.emplace_back(MakeTx(i));
+        cache.Add(vecTxs.back(), nNow + i * CTxRelayCache::WHEEL_SLOT_SECONDS);
+    }
+
+    // the transactions expiring first were evicted
+    CTxRelayCache::Stats stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.nCount, 3);
+    BOOST_CHECK_EQUAL(stats.nEvicted, 2);
+    BOOST_CHECK(stats.nBytes <= stats.nMaxBytes);
+    BOOST_CHECK(cache.Get(vecTxs[0]->GetHash()) == nullptr);
+    BOOST_CHECK(cache.Get(vecTxs[1]->GetHash()) == nullptr);
+    BOOST_CHECK(cache.Get(vecTxs[4]->GetHash()) != nullptr);
+
+    cache.SetMaxBytes(nTxBytes);
+    BOOST_CHECK_EQUAL(cache.GetStats().nCount, 1);
+    BOOST_CHECK(cache.Get(vecTxs[4]->GetHash()) != nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -8,6 +8,8 @@
 #include <consensus/validation.h>
 #include <primitives/transaction.h>
 #include <script/script.h>
+#include <script/interpreter.h>
+#include <random.h>
 #include <test/test_dash.h>
 
 #include <boost/test/unit_test.hpp>
@@ -57,4 +59,53 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_reject_coinbase, TestChain100Setup)
     BOOST_CHECK_EQUAL(nDoS, 100);
 }
 
+/**
+ * Ensure that a package is accepted in order, so children can spend their parents.
+ */
+BOOST_FIXTURE_TEST_CASE(tx_mempool_accept_package, TestChain100Setup)
+{
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+
+    auto spend = [&](const COutPoint& prevout, const CScript& prevScriptPubKey, CAmount nValue) {
+        CMutableTransaction tx;
+        tx.nVersion = 1;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = prevout;
+        tx.vout.resize(1);
+        tx.vout[0].nValue = nValue;
+        tx.vout[0].scriptPubKey = scriptPubKey;
+
+        std::vector<unsigned char> vchSig;
+        uint256 hash = SignatureHash(prevScriptPubKey, tx, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+        BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+        vchSig.push_back((unsigned char)SIGHASH_ALL);
+        tx.vin[0].scriptSig << vchSig;
+        return MakeTransactionRef(tx);
+    };
+
+    CTransactionRef parent = spend(COutPoint(coinbaseTxns[0].GetHash(), 0), coinbaseTxns[0].vout[0].scriptPubKey, 11 * CENT);
+    CTransactionRef child = spend(COutPoint(parent->GetHash(), 0), scriptPubKey, 10 * CENT);
+    CTransactionRef orphan = spend(COutPoint(InsecureRand256(), 0), scriptPubKey, 10 * CENT);
+
+    LOCK(cs_main);
+
+    unsigned int initialPoolSize = mempool.size();
+
+    std::vector<CValidationState> vStates;
+    std::vector<bool> vAccepted;
+    BOOST_CHECK_EQUAL(AcceptPackageToMemoryPool(mempool, {parent, child, orphan}, vStates, vAccepted,
+                          false /* bypass_limits */, 0 /* nAbsurdFee */), 2);
+    BOOST_CHECK(vAccepted[0] && vAccepted[1] && !vAccepted[2]);
+    BOOST_CHECK(mempool.exists(parent->GetHash()) && mempool.exists(child->GetHash()));
+    BOOST_CHECK_EQUAL(mempool.size(), initialPoolSize + 2);
+
+    // the orphan is only missing inputs
+    BOOST_CHECK(vStates[2].IsValid());
+
+    // a second time, both are rejected as duplicates
+    BOOST_CHECK_EQUAL(AcceptPackageToMemoryPool(mempool, {parent, child}, vStates, vAccepted,
+                          false /* bypass_limits */, 0 /* nAbsurdFee */), 0);
+    BOOST_CHECK_EQUAL(vStates[0].GetRejectReason(), "txn-already-in-mempool");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
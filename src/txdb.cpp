@@ -6,9 +6,12 @@
 #include <txdb.h>
 
 #include <chainparams.h>
+#include <clientversion.h>
 #include <hash.h>
+#include <node/coinstats.h>
 #include <random.h>
 #include <pow.h>
+#include <streams.h>
 #include <uint256.h>
 #include <util.h>
 #include <ui_interface.h>
@@ -22,17 +25,17 @@ static const char DB_COIN = 'C';
 static const char DB_COINS = 'c';
 static const char DB_BLOCK_FILES = 'f';
 static const char DB_TXINDEX = 't';
-static const char DB_ADDRESSINDEX = 'a';
-static const char DB_ADDRESSUNSPENTINDEX = 'u';
-static const char DB_TIMESTAMPINDEX = 's';
-static const char DB_SPENTINDEX = 'p';
 static const char DB_BLOCK_INDEX = 'b';
 
 static const char DB_BEST_BLOCK = 'B';
 static const char DB_HEAD_BLOCKS = 'H';
+static const char DB_COINS_COMMITMENT = 'M';
 static const char DB_FLAG = 'F';
 static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
+static const char DB_BLOCK_INDEX_CACHE = 'I';
+
+static const uint64_t BLOCK_INDEX_CACHE_VERSION = 1;
 
 namespace {
 
@@ -62,15 +65,73 @@ CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(Get
 {
 }
 
+CCoinsViewDB::~CCoinsViewDB()
+{
+    if (writerPool) {
+        // finishes the pending write
+        writerPool->stop(true);
+    }
+}
+
+void CCoinsViewDB::StartBackgroundWrites()
+{
+    if (writerPool) {
+        return;
+    }
+    writerPool = std::make_unique<ctpl::thread_pool>(1);
+    RenameThreadPool(*writerPool, "dash-coinswrite");
+}
+
+bool CCoinsViewDB::WaitForPendingWrite() const
+{
+    WaitableLock lock(csPending);
+    condPendingWritten.wait(lock, [this] { return pendingCoins == nullptr || fPendingWriteFailed; });
+    return !fPendingWriteFailed;
+}
+
+bool CCoinsViewDB::IsWritePending() const
+{
+    WaitableLock lock(csPending);
+    return pendingCoins != nullptr;
+}
+
 bool CCoinsViewDB::GetCoin(const COutPoint &outpoint, Coin &coin) const {
+    {
+        WaitableLock lock(csPending);
+        if (pendingCoins != nullptr) {
+            auto it = pendingCoins->find(outpoint);
+            if (it != pendingCoins->end()) {
+                if (it->second.coin.IsSpent()) {
+                    return false;
+                }
+                coin = it->second.coin;
+                return true;
+            }
+        }
+    }
     return db.Read(CoinEntry(&outpoint), coin);
 }
 
 bool CCoinsViewDB::HaveCoin(const COutPoint &outpoint) const {
+    {
+        WaitableLock lock(csPending);
+        if (pendingCoins != nullptr) {
+            auto it = pendingCoins->find(outpoint);
+            if (it != pendingCoins->end()) {
+                return !it->second.coin.IsSpent();
+            }
+        }
+    }
     return db.Exists(CoinEntry(&outpoint));
 }
 
 uint256 CCoinsViewDB::GetBestBlock() const {
+    {
+        WaitableLock lock(csPending);
+        if (pendingCoins != nullptr) {
+            return hashPendingBlock;
+        }
+    }
     uint256 hashBestChain;
     if (!db.Read(DB_BEST_BLOCK, hashBestChain))
         return uint256();
@@ -86,11 +147,52 @@ std::vector<uint256> CCoinsViewDB::GetHeadBlocks() const {
 }
 
 bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
-    CDBBatch batch(db);
-    size_t count = 0;
-    size_t changed = 0;
-    size_t batch_size = (size_t)gArgs.GetArg("-dbbatchsize", nDefaultDbBatchSize);
-    int crash_simulate = gArgs.GetArg("-dbcrashratio", 0);
+    // The transition marker below needs the database to be consistent
+    if (!WaitForPendingWrite()) {
+        return false;
+    }
+    if (!WriteHeadBlocks(hashBlock)) {
+        return false;
+    }
+    if (!writerPool) {
+        bool ret = WriteCoins(mapCoins, hashBlock);
+        mapCoins.clear();
+        return ret;
+    }
+
+    // The marker is written already, so that a crash before the background write finished is recovered by
+    // ReplayBlocks() like a crash in the middle of a synchronous write. Callers may rely on this, e.g. to commit
+    // other databases which must not get ahead of the coins.
+    // swapped instead of moved, so that mapCoins gets a new pool and the writer thread owns the old one alone
+    auto coins = std::make_shared<CCoinsMap>();
+    coins->swap(mapCoins);
+    {
+        WaitableLock lock(csPending);
+        pendingCoins = coins;
+        hashPendingBlock = hashBlock;
+    }
+    writerPool->push([this, coins, hashBlock](int threadId) {
+        int64_t nStart = GetTimeMillis();
+        bool ret;
+        try {
+            ret = WriteCoins(*coins, hashBlock);
+        } catch (const std::runtime_error& e) {
+            LogPrintf("CCoinsViewDB::%s -- failed to write coins: %s\n", __func__, e.what());
+            ret = false;
+        }
+        LogPrint(BCLog::COINDB, "Background write of %u coins finished in %dms\n", coins->size(), GetTimeMillis() - nStart);
+        WaitableLock lock(csPending);
+        if (ret) {
+            pendingCoins = nullptr;
+        } else {
+            fPendingWriteFailed = true;
+        }
+        condPendingWritten.notify_all();
+    });
+    return true;
+}
+
+bool CCoinsViewDB::WriteHeadBlocks(const uint256 &hashBlock) {
     assert(!hashBlock.IsNull());
 
     uint256 old_tip = GetBestBlock();
@@ -103,14 +205,24 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
         }
     }
 
-    // In the first batch, mark the database as being in the middle of a
+    // Before writing any coins, mark the database as being in the middle of a
     // transition from old_tip to hashBlock.
     // A vector is used for future extensibility, as we may want to support
     // interrupting after partial writes from multiple independent reorgs.
+    CDBBatch batch(db);
     batch.Erase(DB_BEST_BLOCK);
     batch.Write(DB_HEAD_BLOCKS, std::vector<uint256>{hashBlock, old_tip});
+    return db.WriteBatch(batch);
+}
 
-    for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
+bool CCoinsViewDB::WriteCoins(const CCoinsMap &mapCoins, const uint256 &hashBlock) {
+    CDBBatch batch(db);
+    size_t count = 0;
+    size_t changed = 0;
+    size_t batch_size = (size_t)gArgs.GetArg("-dbbatchsize", nDefaultDbBatchSize);
+    int crash_simulate = gArgs.GetArg("-dbcrashratio", 0);
+
+    for (CCoinsMap::const_iterator it = mapCoins.begin(); it != mapCoins.end(); ++it) {
         if (it->second.flags & CCoinsCacheEntry::DIRTY) {
             CoinEntry entry(&it->first);
             if (it->second.coin.IsSpent())
@@ -120,8 +232,6 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
             changed++;
         }
         count++;
-        CCoinsMap::iterator itOld = it++;
-        mapCoins.erase(itOld);
         if (batch.SizeEstimate() > batch_size) {
             LogPrint(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
             db.WriteBatch(batch);
@@ -174,13 +284,29 @@ bool CBlockTreeDB::ReadLastBlockFile(int &nFile) {
     return Read(DB_LAST_BLOCK, nFile);
 }
 
+bool CCoinsViewDB::ReadCommitment(CCoinsCommitment &commitment) const {
+    return db.Read(DB_COINS_COMMITMENT, commitment);
+}
+
+bool CCoinsViewDB::WriteCommitment(const CCoinsCommitment &commitment) {
+    return db.Write(DB_COINS_COMMITMENT, commitment);
+}
+
 CCoinsViewCursor *CCoinsViewDB::Cursor() const
 {
+    return Cursor(uint256());
+}
+
+CCoinsViewCursor *CCoinsViewDB::Cursor(const uint256 &hashStart) const
+{
+    // The cursor only sees what's written already
+    WaitForPendingWrite();
     CCoinsViewDBCursor *i = new CCoinsViewDBCursor(const_cast<CDBWrapper&>(db).NewIterator(), GetBestBlock());
     /* It seems that there are no "const iterators" for LevelDB.  Since we
        only need read operations on it, use a const-cast to get around
        that restriction.  */
-    i->pcursor->Seek(DB_COIN);
+    COutPoint start(hashStart, 0);
+    i->pcursor->Seek(CoinEntry(&start));
     // Cache key of first record
     if (i->pcursor->Valid()) {
         CoinEntry entry(&i->keyTmp.second);
@@ -273,143 +399,113 @@ bool CBlockTreeDB::WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos>
     return ret;
 }
 
-bool CBlockTreeDB::ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value) {
-    return Read(std::make_pair(DB_SPENTINDEX, key), value);
+bool CBlockTreeDB::WriteFlag(const std::string &name, bool fValue) {
+    return Write(std::make_pair(DB_FLAG, name), fValue ? '1' : '0');
 }
 
-bool CBlockTreeDB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect) {
-    CDBBatch batch(*this);
-    for (std::vector<std::pair<CSpentIndexKey,CSpentIndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
-        if (it->second.IsNull()) {
-            batch.Erase(std::make_pair(DB_SPENTINDEX, it->first));
-        } else {
-            batch.Write(std::make_pair(DB_SPENTINDEX, it->first), it->second);
-        }
-    }
-    return WriteBatch(batch);
+bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
+    char ch;
+    if (!Read(std::make_pair(DB_FLAG, name), ch))
+        return false;
+    fValue = ch == '1';
+    return true;
 }
 
-bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect) {
-    CDBBatch batch(*this);
-    for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
-        if (it->second.IsNull()) {
-            batch.Erase(std::make_pair(DB_ADDRESSUNSPENTINDEX, it->first));
-        } else {
-            batch.Write(std::make_pair(DB_ADDRESSUNSPENTINDEX, it->first), it->second);
-        }
-    }
-    return WriteBatch(batch);
+static bool InsertDiskBlockIndex(const CDiskBlockIndex& diskindex, const Consensus::Params& consensusParams, const std::function<CBlockIndex*(const uint256&)>& insertBlockIndex)
+{
+    // Construct block index object
+    CBlockIndex* pindexNew = insertBlockIndex(diskindex.GetBlockHash());
+    pindexNew->pprev          = insertBlockIndex(diskindex.hashPrev);
+    pindexNew->nHeight        = diskindex.nHeight;
+    pindexNew->nFile          = diskindex.nFile;
+    pindexNew->nDataPos       = diskindex.nDataPos;
+    pindexNew->nUndoPos       = diskindex.nUndoPos;
+    pindexNew->nVersion       = diskindex.nVersion;
+    pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
+    pindexNew->nTime          = diskindex.nTime;
+    pindexNew->nBits          = diskindex.nBits;
+    pindexNew->nNonce         = diskindex.nNonce;
+    pindexNew->nStatus        = diskindex.nStatus;
+    pindexNew->nTx            = diskindex.nTx;
+
+    if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams))
+        return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
+    return true;
 }
 
-bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
-                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs) {
-
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
-
-    pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
-
-    while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
-        std::pair<char,CAddressUnspentKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash) {
-            CAddressUnspentValue nValue;
-            if (pcursor->GetValue(nValue)) {
-                unspentOutputs.push_back(std::make_pair(key.second, nValue));
-                pcursor->Next();
-            } else {
-                return error("failed to get address unspent value");
-            }
-        } else {
-            break;
+bool CBlockTreeDB::WriteBlockIndexCache(const std::vector<const CBlockIndex*>& vIndexes)
+{
+    const uint256 id = GetRandHash();
+    try {
+        FILE* filestr = fsbridge::fopen(GetDataDir() / "blockindex.dat.new", "wb");
+        if (!filestr) {
+            return false;
+        }
+        CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+        file << BLOCK_INDEX_CACHE_VERSION;
+        file << id;
+        file << (uint64_t)vIndexes.size();
+        for (const CBlockIndex* pindex : vIndexes) {
+            file << CDiskBlockIndex(pindex);
         }
+        // repeated at the end to detect truncated files
+        file << id;
+        if (!FileCommit(file.Get()))
+            throw std::runtime_error("FileCommit failed");
+        file.fclose();
+        RenameOver(GetDataDir() / "blockindex.dat.new", GetDataDir() / "blockindex.dat");
+    } catch (const std::exception& e) {
+        LogPrintf("%s: failed to write block index cache: %s\n", __func__, e.what());
+        return false;
     }
-
-    return true;
-}
-
-bool CBlockTreeDB::WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
-    CDBBatch batch(*this);
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
-        batch.Write(std::make_pair(DB_ADDRESSINDEX, it->first), it->second);
-    return WriteBatch(batch);
-}
-
-bool CBlockTreeDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
-    CDBBatch batch(*this);
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
-        batch.Erase(std::make_pair(DB_ADDRESSINDEX, it->first));
-    return WriteBatch(batch);
+    // Only now the cache becomes valid
+    return Write(DB_BLOCK_INDEX_CACHE, id, true);
 }
 
-bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
-                                    std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                                    int start, int end) {
-
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
-
-    if (start > 0 && end > 0) {
-        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start)));
-    } else {
-        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
+bool CBlockTreeDB::LoadBlockIndexCache(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, std::function<void(size_t)> reserveBlockIndex)
+{
+    uint256 id;
+    if (!Read(DB_BLOCK_INDEX_CACHE, id)) {
+        return false;
+    }
+    // The block index is written after this without updating the cache, so it can only be used once. Versions which
+    // don't know about the cache can't accidentally validate an outdated one this way either.
+    if (!Erase(DB_BLOCK_INDEX_CACHE, true)) {
+        return false;
     }
 
-    while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
-        std::pair<char,CAddressIndexKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.hashBytes == addressHash) {
-            if (end > 0 && key.second.blockHeight > end) {
-                break;
-            }
-            CAmount nValue;
-            if (pcursor->GetValue(nValue)) {
-                addressIndex.push_back(std::make_pair(key.second, nValue));
-                pcursor->Next();
-            } else {
-                return error("failed to get address index value");
+    FILE* filestr = fsbridge::fopen(GetDataDir() / "blockindex.dat", "rb");
+    if (!filestr) {
+        return false;
+    }
+    try {
+        CBufferedFile file(filestr, 16 << 20, 1, SER_DISK, CLIENT_VERSION);
+        uint64_t nVersion;
+        uint256 idFile;
+        uint64_t nCount;
+        file >> nVersion;
+        file >> idFile;
+        if (nVersion != BLOCK_INDEX_CACHE_VERSION || idFile != id) {
+            LogPrintf("%s: block index cache does not match the block index database\n", __func__);
+            return false;
+        }
+        file >> nCount;
+        reserveBlockIndex(nCount);
+        for (uint64_t i = 0; i < nCount; i++) {
+            boost::this_thread::interruption_point();
+            CDiskBlockIndex diskindex;
+            file >> diskindex;
+            if (!InsertDiskBlockIndex(diskindex, consensusParams, insertBlockIndex)) {
+                return false;
             }
-        } else {
-            break;
         }
-    }
-
-    return true;
-}
-
-bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
-    CDBBatch batch(*this);
-    batch.Write(std::make_pair(DB_TIMESTAMPINDEX, timestampIndex), 0);
-    return WriteBatch(batch);
-}
-
-bool CBlockTreeDB::ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &hashes) {
-
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
-
-    pcursor->Seek(std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexIteratorKey(low)));
-
-    while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
-        std::pair<char, CTimestampIndexKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_TIMESTAMPINDEX && key.second.timestamp <= high) {
-            hashes.push_back(key.second.blockHash);
-            pcursor->Next();
-        } else {
-            break;
+        file >> idFile;
+        if (idFile != id) {
+            return error("%s: block index cache is corrupted", __func__);
         }
+    } catch (const std::exception& e) {
+        return error("%s: failed to read block index cache: %s", __func__, e.what());
     }
-
-    return true;
-}
-
-bool CBlockTreeDB::WriteFlag(const std::string &name, bool fValue) {
-    return Write(std::make_pair(DB_FLAG, name), fValue ? '1' : '0');
-}
-
-bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
-    char ch;
-    if (!Read(std::make_pair(DB_FLAG, name), ch))
-        return false;
-    fValue = ch == '1';
     return true;
 }
 
@@ -426,23 +522,8 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
         if (pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX) {
             CDiskBlockIndex diskindex;
             if (pcursor->GetValue(diskindex)) {
-                // Construct block index object
-                CBlockIndex* pindexNew = insertBlockIndex(diskindex.GetBlockHash());
-                pindexNew->pprev          = insertBlockIndex(diskindex.hashPrev);
-                pindexNew->nHeight        = diskindex.nHeight;
-                pindexNew->nFile          = diskindex.nFile;
-                pindexNew->nDataPos       = diskindex.nDataPos;
-                pindexNew->nUndoPos       = diskindex.nUndoPos;
-                pindexNew->nVersion       = diskindex.nVersion;
-                pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
-                pindexNew->nTime          = diskindex.nTime;
-                pindexNew->nBits          = diskindex.nBits;
-                pindexNew->nNonce         = diskindex.nNonce;
-                pindexNew->nStatus        = diskindex.nStatus;
-                pindexNew->nTx            = diskindex.nTx;
-
-                if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams))
-                    return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
+                if (!InsertDiskBlockIndex(diskindex, consensusParams, insertBlockIndex))
+                    return false;
 
                 pcursor->Next();
             } else {
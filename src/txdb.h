@@ -10,9 +10,10 @@
 #include <dbwrapper.h>
 #include <chain.h>
 #include <limitedmap.h>
-#include <spentindex.h>
 #include <sync.h>
 
+#include <ctpl.h>
+
 #include <map>
 #include <memory>
 #include <string>
@@ -20,6 +21,7 @@
 #include <vector>
 
 class CBlockIndex;
+class CCoinsCommitment;
 class CCoinsViewDBCursor;
 class uint256;
 
@@ -29,6 +31,8 @@ static constexpr int MAX_BLOCK_COINSDB_USAGE = 10;
 static const int64_t nDefaultDbCache = 300;
 //! -dbbatchsize default (bytes)
 static const int64_t nDefaultDbBatchSize = 16 << 20;
+//! -dbbackgroundwrite default
+static const bool DEFAULT_DB_BACKGROUND_WRITE = true;
 //! max. -dbcache (MiB)
 static const int64_t nMaxDbCache = sizeof(void*) > 4 ? 16384 : 1024;
 //! min. -dbcache (MiB)
@@ -41,6 +45,10 @@ static const int64_t nMaxBlockDBCache = 2;
 static const int64_t nMaxBlockDBAndTxIndexCache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
+//! Max memory allocated to the -addressindex, -spentindex and -timestampindex databases together (MiB)
+static const int64_t nMaxExtraIndexCache = 1024;
+//! Max memory allocated to all block filter index caches combined (MiB)
+static const int64_t nMaxFilterIndexCache = 1024;
 
 struct CDiskTxPos : public CDiskBlockPos
 {
@@ -68,13 +76,36 @@ struct CDiskTxPos : public CDiskBlockPos
 };
 
 /** CCoinsView backed by the coin database (chainstate/) */
+/**
+ * CCoinsView backed by the coin database.
+ *
+ * With background writes enabled, BatchWrite() only marks the database as being in transition to the new best block
+ * and hands the coins over to a writer thread, so that flushing pcoinsTip doesn't block validation for the whole
+ * write. Until the write finished, the coins are kept in memory and reads look at them first, so the view stays
+ * consistent. Only one write can be pending, BatchWrite() waits for the previous one to finish first.
+ */
 class CCoinsViewDB final : public CCoinsView
 {
 protected:
     CDBWrapper db;
+
+    mutable CWaitableCriticalSection csPending;
+    mutable CConditionVariable condPendingWritten;
+    //! Coins handed over by BatchWrite() which are not written to db yet
+    std::shared_ptr<const CCoinsMap> pendingCoins GUARDED_BY(csPending);
+    uint256 hashPendingBlock GUARDED_BY(csPending);
+    //! A background write failed, pendingCoins are kept so that reads stay consistent until we shut down
+    bool fPendingWriteFailed GUARDED_BY(csPending){false};
+    std::unique_ptr<ctpl::thread_pool> writerPool;
+
+    //! Marks the database as being in the middle of a transition to hashBlock
+    bool WriteHeadBlocks(const uint256 &hashBlock);
+    //! Writes the dirty coins of mapCoins and marks the database as consistent with hashBlock again
+    bool WriteCoins(const CCoinsMap &mapCoins, const uint256 &hashBlock);
+
 public:
     explicit CCoinsViewDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
-
+    ~CCoinsViewDB();
 
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
@@ -82,6 +113,18 @@ public:
     std::vector<uint256> GetHeadBlocks() const override;
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
     CCoinsViewCursor *Cursor() const override;
+    //! Cursor starting at the first coin of the first txid which isn't lower than hashStart (in the order of the database)
+    CCoinsViewCursor *Cursor(const uint256 &hashStart) const;
+
+    //! The UTXO set commitment of -utxocommitment, see CCoinsCommitment
+    bool ReadCommitment(CCoinsCommitment &commitment) const;
+    bool WriteCommitment(const CCoinsCommitment &commitment);
+
+    //! Lets BatchWrite() return before the coins are written, see class description
+    void StartBackgroundWrites();
+    //! Waits for the pending write to finish, returns false if it failed
+    bool WaitForPendingWrite() const;
+    bool IsWritePending() const;
 
     //! Attempt to update from an older database format. Returns whether an error occurred.
     bool Upgrade();
@@ -131,21 +174,14 @@ public:
     bool HasTxIndex(const uint256 &txid);
     bool ReadTxIndex(const uint256 &txid, CDiskTxPos &pos);
     bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> > &vect);
-    bool ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
-    bool UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect);
-    bool UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect);
-    bool ReadAddressUnspentIndex(uint160 addressHash, int type,
-                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect);
-    bool WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
-    bool EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
-    bool ReadAddressIndex(uint160 addressHash, int type,
-                          std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                          int start = 0, int end = 0);
-    bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
-    bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &vect);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
     bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex);
+
+    //! Writes vIndexes to blockindex.dat, which is then valid for loading the block index once
+    bool WriteBlockIndexCache(const std::vector<const CBlockIndex*>& vIndexes);
+    //! Loads the block index from blockindex.dat if it's valid, entries might be inserted already if this fails
+    bool LoadBlockIndexCache(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, std::function<void(size_t)> reserveBlockIndex);
 };
 
 #endif // BITCOIN_TXDB_H
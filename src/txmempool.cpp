@@ -63,13 +63,14 @@ void CTxMemPoolEntry::UpdateLockPoints(const LockPoints& lp)
 void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap &cachedDescendants, const std::set<uint256> &setExclude)
 {
     setEntries stageEntries, setAllDescendants;
-    stageEntries = GetMemPoolChildren(updateIt);
+    const vecEntries& updateChildren = GetMemPoolChildren(updateIt);
+    stageEntries.insert(updateChildren.begin(), updateChildren.end());
 
     while (!stageEntries.empty()) {
         const txiter cit = *stageEntries.begin();
         setAllDescendants.insert(cit);
         stageEntries.erase(cit);
-        const setEntries &setChildren = GetMemPoolChildren(cit);
+        const vecEntries &setChildren = GetMemPoolChildren(cit);
         for (txiter childEntry : setChildren) {
             cacheMap::iterator cacheIt = cachedDescendants.find(childEntry);
             if (cacheIt != cachedDescendants.end()) {
@@ -173,7 +174,8 @@ bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry, setEntr
         // If we're not searching for parents, we require this to be an
         // entry in the mempool already.
         txiter it = mapTx.iterator_to(entry);
-        parentHashes = GetMemPoolParents(it);
+        const vecEntries& parents = GetMemPoolParents(it);
+        parentHashes.insert(parents.begin(), parents.end());
     }
 
     size_t totalSizeWithAncestors = entry.GetTxSize();
@@ -196,7 +198,7 @@ bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry, setEntr
             return false;
         }
 
-        const setEntries & setMemPoolParents = GetMemPoolParents(stageit);
+        const vecEntries & setMemPoolParents = GetMemPoolParents(stageit);
         for (const txiter &phash : setMemPoolParents) {
             // If this is a new ancestor, add it.
             if (setAncestors.count(phash) == 0) {
@@ -214,7 +216,7 @@ bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry, setEntr
 
 void CTxMemPool::UpdateAncestorsOf(bool add, txiter it, setEntries &setAncestors)
 {
-    setEntries parentIters = GetMemPoolParents(it);
+    const vecEntries parentIters = GetMemPoolParents(it);
     // add or remove this tx as a child of each parent
     for (txiter piter : parentIters) {
         UpdateChild(piter, it, add);
@@ -243,7 +245,7 @@ void CTxMemPool::UpdateEntryForAncestors(txiter it, const setEntries &setAncesto
 
 void CTxMemPool::UpdateChildrenForRemoval(txiter it)
 {
-    const setEntries &setMemPoolChildren = GetMemPoolChildren(it);
+    const vecEntries &setMemPoolChildren = GetMemPoolChildren(it);
     for (txiter updateIt : setMemPoolChildren) {
         UpdateParent(updateIt, it, false);
     }
@@ -258,7 +260,7 @@ void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, b
         // updateDescendants should be true whenever we're not recursively
         // removing a tx and all its descendants, eg when a transaction is
         // confirmed in a block.
-        // Here we only update statistics and not data in mapLinks (which
+        // Here we only update statistics and not data in vTxLinks (which
         // we need to preserve until we're finished with all operations that
         // need to traverse the mempool).
         for (txiter removeIt : entriesToRemove) {
@@ -283,16 +285,16 @@ void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, b
         // should be a bit faster.
         // However, if we happen to be in the middle of processing a reorg, then
         // the mempool can be in an inconsistent state.  In this case, the set
-        // of ancestors reachable via mapLinks will be the same as the set of
+        // of ancestors reachable via vTxLinks will be the same as the set of
         // ancestors whose packages include this transaction, because when we
         // add a new transaction to the mempool in addUnchecked(), we assume it
         // has no children, and in the case of a reorg where that assumption is
         // false, the in-mempool children aren't linked to the in-block tx's
         // until UpdateTransactionsFromBlock() is called.
         // So if we're being called during a reorg, ie before
-        // UpdateTransactionsFromBlock() has been called, then mapLinks[] will
+        // UpdateTransactionsFromBlock() has been called, then vTxLinks will
         // differ from the set of mempool parents we'd calculate by searching,
-        // and it's important that we use the mapLinks[] notion of ancestor
+        // and it's important that we use the vTxLinks notion of ancestor
         // transactions as the set of things to update for removal.
         CalculateMemPoolAncestors(entry, setAncestors, nNoLimit, nNoLimit, nNoLimit, nNoLimit, dummy, false);
         // Note that UpdateAncestorsOf severs the child links that point to
@@ -363,7 +365,9 @@ bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
     // Used by AcceptToMemoryPool(), which DOES do
     // all the appropriate checks.
     indexed_transaction_set::iterator newit = mapTx.insert(entry).first;
-    mapLinks.insert(make_pair(newit, TxLinks()));
+    vTxHashes.emplace_back(hash, newit);
+    vTxLinks.emplace_back();
+    newit->vTxHashesIdx = vTxHashes.size() - 1;
 
     // Update transaction for any feeDelta created by PrioritiseTransaction
     // TODO: refactor so that the fee delta is calculated before inserting
@@ -408,8 +412,25 @@ bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
     totalTxSize += entry.GetTxSize();
     if (minerPolicyEstimator) {minerPolicyEstimator->processTransaction(entry, validFeeEstimate);}
 
-    vTxHashes.emplace_back(hash, newit);
-    newit->vTxHashesIdx = vTxHashes.size() - 1;
+    addProTxIndexes(tx, newit);
+
+    return true;
+}
+
+void CTxMemPool::addProTxIndexes(const CTransaction& tx, const txiter& newit)
+{
+    AssertLockHeld(cs);
+    if (tx.nType != TRANSACTION_PROVIDER_REGISTER && tx.nType != TRANSACTION_PROVIDER_UPDATE_SERVICE &&
+        tx.nType != TRANSACTION_PROVIDER_UPDATE_REGISTRAR && tx.nType != TRANSACTION_PROVIDER_UPDATE_REVOKE) {
+        return;
+    }
+
+    const uint256& txHash = tx.GetHash();
+    ProTxIndexKeys& keys = mapProTxIndexKeys[txHash];
+    auto addRef = [&](const uint256& proTxHash, const uint256& refHash) {
+        mapProTxRefs.emplace(proTxHash, refHash);
+        keys.refs.emplace_back(proTxHash, refHash);
+    };
 
     // Invalid ProTxes should never get this far because transactions should be
     // fully checked by AcceptToMemoryPool() at this point, so we just assume that
@@ -419,28 +440,31 @@ bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
         bool ok = GetTxPayload(tx, proTx);
         assert(ok);
         if (!proTx.collateralOutpoint.hash.IsNull()) {
-            mapProTxRefs.emplace(tx.GetHash(), proTx.collateralOutpoint.hash);
-        }
-        mapProTxAddresses.emplace(proTx.addr, tx.GetHash());
-        mapProTxPubKeyIDs.emplace(proTx.keyIDOwner, tx.GetHash());
-        mapProTxBlsPubKeyHashes.emplace(proTx.pubKeyOperator.GetHash(), tx.GetHash());
-        if (!proTx.collateralOutpoint.hash.IsNull()) {
-            mapProTxCollaterals.emplace(proTx.collateralOutpoint, tx.GetHash());
-        } else {
-            mapProTxCollaterals.emplace(COutPoint(tx.GetHash(), proTx.collateralOutpoint.n), tx.GetHash());
-        }
+            addRef(txHash, proTx.collateralOutpoint.hash);
+        }
+        mapProTxAddresses.emplace(proTx.addr, txHash);
+        keys.addresses.emplace_back(proTx.addr);
+        mapProTxPubKeyIDs.emplace(proTx.keyIDOwner, txHash);
+        keys.keyIDs.emplace_back(proTx.keyIDOwner);
+        mapProTxBlsPubKeyHashes.emplace(proTx.pubKeyOperator.GetHash(), txHash);
+        keys.blsPubKeyHashes.emplace_back(proTx.pubKeyOperator.GetHash());
+        COutPoint collateralOutpoint = !proTx.collateralOutpoint.hash.IsNull() ? proTx.collateralOutpoint : COutPoint(txHash, proTx.collateralOutpoint.n);
+        mapProTxCollaterals.emplace(collateralOutpoint, txHash);
+        keys.collaterals.emplace_back(collateralOutpoint);
     } else if (tx.nType == TRANSACTION_PROVIDER_UPDATE_SERVICE) {
         CProUpServTx proTx;
         bool ok = GetTxPayload(tx, proTx);
         assert(ok);
-        mapProTxRefs.emplace(proTx.proTxHash, tx.GetHash());
-        mapProTxAddresses.emplace(proTx.addr, tx.GetHash());
+        addRef(proTx.proTxHash, txHash);
+        mapProTxAddresses.emplace(proTx.addr, txHash);
+        keys.addresses.emplace_back(proTx.addr);
     } else if (tx.nType == TRANSACTION_PROVIDER_UPDATE_REGISTRAR) {
         CProUpRegTx proTx;
         bool ok = GetTxPayload(tx, proTx);
         assert(ok);
-        mapProTxRefs.emplace(proTx.proTxHash, tx.GetHash());
-        mapProTxBlsPubKeyHashes.emplace(proTx.pubKeyOperator.GetHash(), tx.GetHash());
+        addRef(proTx.proTxHash, txHash);
+        mapProTxBlsPubKeyHashes.emplace(proTx.pubKeyOperator.GetHash(), txHash);
+        keys.blsPubKeyHashes.emplace_back(proTx.pubKeyOperator.GetHash());
         auto dmn = deterministicMNManager->GetListAtChainTip().GetMN(proTx.proTxHash);
         assert(dmn);
         newit->validForProTxKey = ::SerializeHash(dmn->pdmnState->pubKeyOperator);
@@ -451,7 +475,7 @@ bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
         CProUpRevTx proTx;
         bool ok = GetTxPayload(tx, proTx);
         assert(ok);
-        mapProTxRefs.emplace(proTx.proTxHash, tx.GetHash());
+        addRef(proTx.proTxHash, txHash);
         auto dmn = deterministicMNManager->GetListAtChainTip().GetMN(proTx.proTxHash);
         assert(dmn);
         newit->validForProTxKey = ::SerializeHash(dmn->pdmnState->pubKeyOperator);
@@ -459,8 +483,57 @@ bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
             newit->isKeyChangeProTx = true;
         }
     }
+}
 
-    return true;
+void CTxMemPool::removeProTxIndexes(const uint256& txHash)
+{
+    AssertLockHeld(cs);
+    auto it = mapProTxIndexKeys.find(txHash);
+    if (it == mapProTxIndexKeys.end()) {
+        return;
+    }
+    const ProTxIndexKeys& keys = it->second;
+
+    for (const auto& ref : keys.refs) {
+        auto its = mapProTxRefs.equal_range(ref.first);
+        for (auto refIt = its.first; refIt != its.second; ++refIt) {
+            if (refIt->second == ref.second) {
+                mapProTxRefs.erase(refIt);
+                break;
+            }
+        }
+    }
+    // only erase the entries which were inserted by this tx, the others belong to the tx which conflicts with it
+    auto eraseOwned = [&](auto& map, const auto& key) {
+        auto mapIt = map.find(key);
+        if (mapIt != map.end() && mapIt->second == txHash) {
+            map.erase(mapIt);
+        }
+    };
+    for (const auto& addr : keys.addresses) {
+        eraseOwned(mapProTxAddresses, addr);
+    }
+    for (const auto& keyID : keys.keyIDs) {
+        eraseOwned(mapProTxPubKeyIDs, keyID);
+    }
+    for (const auto& pubKeyHash : keys.blsPubKeyHashes) {
+        eraseOwned(mapProTxBlsPubKeyHashes, pubKeyHash);
+    }
+    for (const auto& collateral : keys.collaterals) {
+        eraseOwned(mapProTxCollaterals, collateral);
+    }
+
+    mapProTxIndexKeys.erase(it);
+}
+
+void CTxMemPool::addAddressDelta(const CMempoolAddressDeltaKey& key, const CMempoolAddressDelta& delta, std::vector<CMempoolAddressDeltaKey>& inserted)
+{
+    AssertLockHeld(cs);
+    auto& bucket = mapAddress[std::make_pair(key.type, key.addressBytes)];
+    cachedIndexUsage -= memusage::DynamicUsage(bucket);
+    bucket.emplace_back(key, delta);
+    cachedIndexUsage += memusage::DynamicUsage(bucket);
+    inserted.push_back(key);
 }
 
 void CTxMemPool::addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewCache &view)
@@ -478,20 +551,17 @@ void CTxMemPool::addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewC
             std::vector<unsigned char> hashBytes(prevout.scriptPubKey.begin()+2, prevout.scriptPubKey.begin()+22);
             CMempoolAddressDeltaKey key(2, uint160(hashBytes), txhash, j, 1);
             CMempoolAddressDelta delta(entry.GetTime(), prevout.nValue * -1, input.prevout.hash, input.prevout.n);
-            mapAddress.insert(std::make_pair(key, delta));
-            inserted.push_back(key);
+            addAddressDelta(key, delta, inserted);
         } else if (prevout.scriptPubKey.IsPayToPublicKeyHash()) {
             std::vector<unsigned char> hashBytes(prevout.scriptPubKey.begin()+3, prevout.scriptPubKey.begin()+23);
             CMempoolAddressDeltaKey key(1, uint160(hashBytes), txhash, j, 1);
             CMempoolAddressDelta delta(entry.GetTime(), prevout.nValue * -1, input.prevout.hash, input.prevout.n);
-            mapAddress.insert(std::make_pair(key, delta));
-            inserted.push_back(key);
+            addAddressDelta(key, delta, inserted);
         } else if (prevout.scriptPubKey.IsPayToPublicKey()) {
             uint160 hashBytes(Hash160(prevout.scriptPubKey.begin()+1, prevout.scriptPubKey.end()-1));
             CMempoolAddressDeltaKey key(1, hashBytes, txhash, j, 1);
             CMempoolAddressDelta delta(entry.GetTime(), prevout.nValue * -1, input.prevout.hash, input.prevout.n);
-            mapAddress.insert(std::make_pair(key, delta));
-            inserted.push_back(key);
+            addAddressDelta(key, delta, inserted);
         }
     }
 
@@ -500,36 +570,39 @@ void CTxMemPool::addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewC
         if (out.scriptPubKey.IsPayToScriptHash()) {
             std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+2, out.scriptPubKey.begin()+22);
             CMempoolAddressDeltaKey key(2, uint160(hashBytes), txhash, k, 0);
-            mapAddress.insert(std::make_pair(key, CMempoolAddressDelta(entry.GetTime(), out.nValue)));
-            inserted.push_back(key);
+            addAddressDelta(key, CMempoolAddressDelta(entry.GetTime(), out.nValue), inserted);
         } else if (out.scriptPubKey.IsPayToPublicKeyHash()) {
             std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+3, out.scriptPubKey.begin()+23);
-            std::pair<addressDeltaMap::iterator,bool> ret;
             CMempoolAddressDeltaKey key(1, uint160(hashBytes), txhash, k, 0);
-            mapAddress.insert(std::make_pair(key, CMempoolAddressDelta(entry.GetTime(), out.nValue)));
-            inserted.push_back(key);
+            addAddressDelta(key, CMempoolAddressDelta(entry.GetTime(), out.nValue), inserted);
         } else if (out.scriptPubKey.IsPayToPublicKey()) {
             uint160 hashBytes(Hash160(out.scriptPubKey.begin()+1, out.scriptPubKey.end()-1));
-            std::pair<addressDeltaMap::iterator,bool> ret;
             CMempoolAddressDeltaKey key(1, hashBytes, txhash, k, 0);
-            mapAddress.insert(std::make_pair(key, CMempoolAddressDelta(entry.GetTime(), out.nValue)));
-            inserted.push_back(key);
+            addAddressDelta(key, CMempoolAddressDelta(entry.GetTime(), out.nValue), inserted);
         }
     }
 
-    mapAddressInserted.insert(std::make_pair(txhash, inserted));
+    auto ret = mapAddressInserted.emplace(txhash, std::move(inserted));
+    if (ret.second) {
+        cachedIndexUsage += memusage::DynamicUsage(ret.first->second);
+    }
 }
 
 bool CTxMemPool::getAddressIndex(std::vector<std::pair<uint160, int> > &addresses,
                                  std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> > &results)
 {
     LOCK(cs);
-    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        addressDeltaMap::iterator ait = mapAddress.lower_bound(CMempoolAddressDeltaKey((*it).second, (*it).first));
-        while (ait != mapAddress.end() && (*ait).first.addressBytes == (*it).first && (*ait).first.type == (*it).second) {
-            results.push_back(*ait);
-            ait++;
+    for (const auto& address : addresses) {
+        auto it = mapAddress.find(std::make_pair(address.second, address.first));
+        if (it == mapAddress.end()) {
+            continue;
         }
+        // the entries of an address are returned ordered by tx hash, index and spending, like they were before buckets
+        size_t nStart = results.size();
+        results.insert(results.end(), it->second.begin(), it->second.end());
+        std::sort(results.begin() + nStart, results.end(), [](const std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta>& a, const std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta>& b) {
+            return CMempoolAddressDeltaKeyCompare()(a.first, b.first);
+        });
     }
     return true;
 }
@@ -540,10 +613,28 @@ bool CTxMemPool::removeAddressIndex(const uint256 txhash)
     addressDeltaMapInserted::iterator it = mapAddressInserted.find(txhash);
 
     if (it != mapAddressInserted.end()) {
-        std::vector<CMempoolAddressDeltaKey> keys = (*it).second;
-        for (std::vector<CMempoolAddressDeltaKey>::iterator mit = keys.begin(); mit != keys.end(); mit++) {
-            mapAddress.erase(*mit);
+        for (const auto& key : it->second) {
+            auto bit = mapAddress.find(std::make_pair(key.type, key.addressBytes));
+            if (bit == mapAddress.end()) {
+                continue;
+            }
+            auto& bucket = bit->second;
+            cachedIndexUsage -= memusage::DynamicUsage(bucket);
+            for (size_t i = 0; i < bucket.size(); i++) {
+                const auto& bucketKey = bucket[i].first;
+                if (bucketKey.txhash == key.txhash && bucketKey.index == key.index && bucketKey.spending == key.spending) {
+                    bucket[i] = std::move(bucket.back());
+                    bucket.pop_back();
+                    break;
+                }
+            }
+            if (bucket.empty()) {
+                mapAddress.erase(bit);
+            } else {
+                cachedIndexUsage += memusage::DynamicUsage(bucket);
+            }
         }
+        cachedIndexUsage -= memusage::DynamicUsage(it->second);
         mapAddressInserted.erase(it);
     }
 
@@ -587,7 +678,10 @@ void CTxMemPool::addSpentIndex(const CTxMemPoolEntry &entry, const CCoinsViewCac
 
     }
 
-    mapSpentInserted.insert(make_pair(txhash, inserted));
+    auto ret = mapSpentInserted.emplace(txhash, std::move(inserted));
+    if (ret.second) {
+        cachedIndexUsage += memusage::DynamicUsage(ret.first->second);
+    }
 }
 
 bool CTxMemPool::getSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value)
@@ -609,10 +703,10 @@ bool CTxMemPool::removeSpentIndex(const uint256 txhash)
     mapSpentIndexInserted::iterator it = mapSpentInserted.find(txhash);
 
     if (it != mapSpentInserted.end()) {
-        std::vector<CSpentIndexKey> keys = (*it).second;
-        for (std::vector<CSpentIndexKey>::iterator mit = keys.begin(); mit != keys.end(); mit++) {
-            mapSpent.erase(*mit);
+        for (const auto& key : it->second) {
+            mapSpent.erase(key);
         }
+        cachedIndexUsage -= memusage::DynamicUsage(it->second);
         mapSpentInserted.erase(it);
     }
 
@@ -626,65 +720,27 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     for (const CTxIn& txin : it->GetTx().vin)
         mapNextTx.erase(txin.prevout);
 
+    const TxLinks& links = vTxLinks[it->vTxHashesIdx];
+    cachedLinksUsage -= memusage::DynamicUsage(links.parents) + memusage::DynamicUsage(links.children);
     if (vTxHashes.size() > 1) {
         vTxHashes[it->vTxHashesIdx] = std::move(vTxHashes.back());
+        vTxLinks[it->vTxHashesIdx] = std::move(vTxLinks.back());
         vTxHashes[it->vTxHashesIdx].second->vTxHashesIdx = it->vTxHashesIdx;
         vTxHashes.pop_back();
-        if (vTxHashes.size() * 2 < vTxHashes.capacity())
+        vTxLinks.pop_back();
+        if (vTxHashes.size() * 2 < vTxHashes.capacity()) {
             vTxHashes.shrink_to_fit();
-    } else
-        vTxHashes.clear();
-
-    auto eraseProTxRef = [&](const uint256& proTxHash, const uint256& txHash) {
-        auto its = mapProTxRefs.equal_range(proTxHash);
-        for (auto it = its.first; it != its.second;) {
-            if (it->second == txHash) {
-                it = mapProTxRefs.erase(it);
-            } else {
-                ++it;
-            }
+            vTxLinks.shrink_to_fit();
         }
-    };
-
-    if (it->GetTx().nType == TRANSACTION_PROVIDER_REGISTER) {
-        CProRegTx proTx;
-        if (!GetTxPayload(it->GetTx(), proTx)) {
-            assert(false);
-        }
-        if (!proTx.collateralOutpoint.IsNull()) {
-            eraseProTxRef(it->GetTx().GetHash(), proTx.collateralOutpoint.hash);
-        }
-        mapProTxAddresses.erase(proTx.addr);
-        mapProTxPubKeyIDs.erase(proTx.keyIDOwner);
-        mapProTxBlsPubKeyHashes.erase(proTx.pubKeyOperator.GetHash());
-        mapProTxCollaterals.erase(proTx.collateralOutpoint);
-        mapProTxCollaterals.erase(COutPoint(it->GetTx().GetHash(), proTx.collateralOutpoint.n));
-    } else if (it->GetTx().nType == TRANSACTION_PROVIDER_UPDATE_SERVICE) {
-        CProUpServTx proTx;
-        if (!GetTxPayload(it->GetTx(), proTx)) {
-            assert(false);
-        }
-        eraseProTxRef(proTx.proTxHash, it->GetTx().GetHash());
-        mapProTxAddresses.erase(proTx.addr);
-    } else if (it->GetTx().nType == TRANSACTION_PROVIDER_UPDATE_REGISTRAR) {
-        CProUpRegTx proTx;
-        if (!GetTxPayload(it->GetTx(), proTx)) {
-            assert(false);
-        }
-        eraseProTxRef(proTx.proTxHash, it->GetTx().GetHash());
-        mapProTxBlsPubKeyHashes.erase(proTx.pubKeyOperator.GetHash());
-    } else if (it->GetTx().nType == TRANSACTION_PROVIDER_UPDATE_REVOKE) {
-        CProUpRevTx proTx;
-        if (!GetTxPayload(it->GetTx(), proTx)) {
-            assert(false);
-        }
-        eraseProTxRef(proTx.proTxHash, it->GetTx().GetHash());
+    } else {
+        vTxHashes.clear();
+        vTxLinks.clear();
     }
 
+    removeProTxIndexes(hash);
+
     totalTxSize -= it->GetTxSize();
     cachedInnerUsage -= it->DynamicMemoryUsage();
-    cachedInnerUsage -= memusage::DynamicUsage(mapLinks[it].parents) + memusage::DynamicUsage(mapLinks[it].children);
-    mapLinks.erase(it);
     mapTx.erase(it);
     nTransactionsUpdated++;
     if (minerPolicyEstimator) {minerPolicyEstimator->removeTx(hash, false);}
@@ -712,7 +768,7 @@ void CTxMemPool::CalculateDescendants(txiter entryit, setEntries &setDescendants
         setDescendants.insert(it);
         stage.erase(it);
 
-        const setEntries &setChildren = GetMemPoolChildren(it);
+        const vecEntries &setChildren = GetMemPoolChildren(it);
         for (const txiter &childiter : setChildren) {
             if (!setDescendants.count(childiter)) {
                 stage.insert(childiter);
@@ -982,17 +1038,32 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigne
     }
     // Before the txs in the new block have been removed from the mempool, update policy estimates
     if (minerPolicyEstimator) {minerPolicyEstimator->processBlock(nBlockHeight, entries);}
-    for (const auto& tx : vtx)
-    {
-        txiter it = mapTx.find(tx->GetHash());
+
+    // Remove all block txs which are in the mempool at once, so that the state of their descendants is updated in
+    // one pass. Most block txs were in the mempool (e.g. all IS-locked ones) and as mapNextTx only has one spender
+    // per outpoint, nothing else in the mempool can spend their inputs, so they don't need to be scanned for
+    // conflicts.
+    setEntries stage;
+    std::vector<bool> vInMempool(vtx.size(), false);
+    for (size_t i = 0; i < vtx.size(); i++) {
+        txiter it = mapTx.find(vtx[i]->GetHash());
         if (it != mapTx.end()) {
-            setEntries stage;
             stage.insert(it);
-            RemoveStaged(stage, true, MemPoolRemovalReason::BLOCK);
+            vInMempool[i] = true;
         }
-        removeConflicts(*tx);
-        removeProTxConflicts(*tx);
-        ClearPrioritisation(tx->GetHash());
+    }
+    RemoveStaged(stage, true, MemPoolRemovalReason::BLOCK);
+
+    for (size_t i = 0; i < vtx.size(); i++) {
+        const CTransaction& tx = *vtx[i];
+        if (!vInMempool[i]) {
+            removeConflicts(tx);
+        }
+        // without any ProTx in the mempool there is nothing which could conflict with one
+        if (!mapProTxIndexKeys.empty()) {
+            removeProTxConflicts(tx);
+        }
+        ClearPrioritisation(tx.GetHash());
     }
     lastRollingFeeUpdate = GetTime();
     blockSinceLastRollingFeeBump = true;
@@ -1000,13 +1071,19 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigne
 
 void CTxMemPool::_clear()
 {
-    mapLinks.clear();
+    vTxLinks.clear();
+    vTxHashes.clear();
     mapTx.clear();
     mapNextTx.clear();
+    mapProTxRefs.clear();
     mapProTxAddresses.clear();
     mapProTxPubKeyIDs.clear();
+    mapProTxBlsPubKeyHashes.clear();
+    mapProTxCollaterals.clear();
+    mapProTxIndexKeys.clear();
     totalTxSize = 0;
     cachedInnerUsage = 0;
+    cachedLinksUsage = 0;
     lastRollingFeeUpdate = GetTime();
     blockSinceLastRollingFeeBump = false;
     rollingMinimumFeeRate = 0;
@@ -1041,6 +1118,7 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
 
     uint64_t checkTotal = 0;
     uint64_t innerUsage = 0;
+    uint64_t linksUsage = 0;
 
     CCoinsViewCache mempoolDuplicate(const_cast<CCoinsViewCache*>(pcoins));
     const int64_t spendheight = GetSpendHeight(mempoolDuplicate);
@@ -1051,10 +1129,9 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
         checkTotal += it->GetTxSize();
         innerUsage += it->DynamicMemoryUsage();
         const CTransaction& tx = it->GetTx();
-        txlinksMap::const_iterator linksiter = mapLinks.find(it);
-        assert(linksiter != mapLinks.end());
-        const TxLinks &links = linksiter->second;
-        innerUsage += memusage::DynamicUsage(links.parents) + memusage::DynamicUsage(links.children);
+        assert(it->vTxHashesIdx < vTxLinks.size() && vTxHashes[it->vTxHashesIdx].second == it);
+        const TxLinks &links = vTxLinks[it->vTxHashesIdx];
+        linksUsage += memusage::DynamicUsage(links.parents) + memusage::DynamicUsage(links.children);
         bool fDependsWait = false;
         setEntries setParentCheck;
         int64_t parentSizes = 0;
@@ -1080,7 +1157,7 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
             assert(it3->second == &tx);
             i++;
         }
-        assert(setParentCheck == GetMemPoolParents(it));
+        assert(std::equal(setParentCheck.begin(), setParentCheck.end(), links.parents.begin(), links.parents.end()));
         // Verify ancestor state is correct.
         setEntries setAncestors;
         uint64_t nNoLimit = std::numeric_limits<uint64_t>::max();
@@ -1113,7 +1190,7 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
                 childSizes += childit->GetTxSize();
             }
         }
-        assert(setChildrenCheck == GetMemPoolChildren(it));
+        assert(std::equal(setChildrenCheck.begin(), setChildrenCheck.end(), links.children.begin(), links.children.end()));
         // Also check to make sure size is greater than sum with immediate children.
         // just a sanity check, not definitive that this calc is correct...
         assert(it->GetSizeWithDescendants() >= childSizes + it->GetTxSize());
@@ -1147,6 +1224,7 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
 
     assert(totalTxSize == checkTotal);
     assert(innerUsage == cachedInnerUsage);
+    assert(linksUsage == cachedLinksUsage);
 }
 
 bool CTxMemPool::CompareDepthAndScore(const uint256& hasha, const uint256& hashb)
@@ -1404,9 +1482,24 @@ bool CCoinsViewMemPool::GetCoin(const COutPoint &outpoint, Coin &coin) const {
 }
 
 size_t CTxMemPool::DynamicMemoryUsage() const {
+    return GetMemoryUsage().Total();
+}
+
+CTxMemPool::MemoryUsage CTxMemPool::GetMemoryUsage() const {
     LOCK(cs);
+    MemoryUsage usage;
     // Estimate the overhead of mapTx to be 12 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 12 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(mapLinks) + memusage::DynamicUsage(vTxHashes) + cachedInnerUsage;
+    usage.nEntries = memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 12 * sizeof(void*)) * mapTx.size();
+    usage.nEntriesInner = cachedInnerUsage;
+    usage.nLinks = memusage::DynamicUsage(vTxLinks) + cachedLinksUsage;
+    usage.nNextTx = memusage::DynamicUsage(mapNextTx);
+    usage.nDeltas = memusage::DynamicUsage(mapDeltas);
+    usage.nTxHashes = memusage::DynamicUsage(vTxHashes);
+    usage.nAddressIndex = memusage::DynamicUsage(mapAddress) + memusage::DynamicUsage(mapAddressInserted);
+    usage.nSpentIndex = memusage::DynamicUsage(mapSpent) + memusage::DynamicUsage(mapSpentInserted);
+    // cachedIndexUsage covers the vectors of both indexes, it's accounted to the address index
+    usage.nAddressIndex += cachedIndexUsage;
+    return usage;
 }
 
 void CTxMemPool::RemoveStaged(setEntries &stage, bool updateDescendants, MemPoolRemovalReason reason) {
@@ -1447,40 +1540,47 @@ bool CTxMemPool::addUnchecked(const uint256&hash, const CTxMemPoolEntry &entry,
     return addUnchecked(hash, entry, setAncestors, validFeeEstimate);
 }
 
-void CTxMemPool::UpdateChild(txiter entry, txiter child, bool add)
+void CTxMemPool::UpdateLink(vecEntries& links, txiter other, bool add)
 {
-    setEntries s;
-    if (add && mapLinks[entry].children.insert(child).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && mapLinks[entry].children.erase(child)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
+    auto it = std::lower_bound(links.begin(), links.end(), other, CompareIteratorByHash());
+    bool fFound = it != links.end() && *it == other;
+    if (add == fFound) {
+        return;
+    }
+    cachedLinksUsage -= memusage::DynamicUsage(links);
+    if (add) {
+        links.insert(it, other);
+    } else {
+        links.erase(it);
+        if (links.empty()) {
+            links.shrink_to_fit();
+        }
     }
+    cachedLinksUsage += memusage::DynamicUsage(links);
+}
+
+void CTxMemPool::UpdateChild(txiter entry, txiter child, bool add)
+{
+    UpdateLink(vTxLinks[entry->vTxHashesIdx].children, child, add);
 }
 
 void CTxMemPool::UpdateParent(txiter entry, txiter parent, bool add)
 {
-    setEntries s;
-    if (add && mapLinks[entry].parents.insert(parent).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && mapLinks[entry].parents.erase(parent)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
-    }
+    UpdateLink(vTxLinks[entry->vTxHashesIdx].parents, parent, add);
 }
 
-const CTxMemPool::setEntries & CTxMemPool::GetMemPoolParents(txiter entry) const
+const CTxMemPool::vecEntries & CTxMemPool::GetMemPoolParents(txiter entry) const
 {
     assert (entry != mapTx.end());
-    txlinksMap::const_iterator it = mapLinks.find(entry);
-    assert(it != mapLinks.end());
-    return it->second.parents;
+    assert(entry->vTxHashesIdx < vTxLinks.size());
+    return vTxLinks[entry->vTxHashesIdx].parents;
 }
 
-const CTxMemPool::setEntries & CTxMemPool::GetMemPoolChildren(txiter entry) const
+const CTxMemPool::vecEntries & CTxMemPool::GetMemPoolChildren(txiter entry) const
 {
     assert (entry != mapTx.end());
-    txlinksMap::const_iterator it = mapLinks.find(entry);
-    assert(it != mapLinks.end());
-    return it->second.children;
+    assert(entry->vTxHashesIdx < vTxLinks.size());
+    return vTxLinks[entry->vTxHashesIdx].children;
 }
 
 CFeeRate CTxMemPool::GetMinFee(size_t sizelimit) const {
@@ -1568,7 +1668,7 @@ uint64_t CTxMemPool::CalculateDescendantMaximum(txiter entry) const {
         txiter candidate = candidates.back();
         candidates.pop_back();
         if (!counted.insert(candidate).second) continue;
-        const setEntries& parents = GetMemPoolParents(candidate);
+        const vecEntries& parents = GetMemPoolParents(candidate);
         if (parents.size() == 0) {
             maximum = std::max(maximum, candidate->GetCountWithDescendants());
         } else {
@@ -9,6 +9,7 @@
 #include <memory>
 #include <set>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 #include <string>
@@ -23,6 +24,7 @@
 #include <sync.h>
 #include <random.h>
 #include <netaddress.h>
+#include <saltedhasher.h>
 #include <bls/bls.h>
 #include <pubkey.h>
 
@@ -131,7 +133,7 @@ public:
     CAmount GetModFeesWithAncestors() const { return nModFeesWithAncestors; }
     unsigned int GetSigOpCountWithAncestors() const { return nSigOpCountWithAncestors; }
 
-    mutable size_t vTxHashesIdx; //!< Index in mempool's vTxHashes
+    mutable size_t vTxHashesIdx; //!< Index in mempool's vTxHashes and vTxLinks
 
     // If this is a proTx, this will be the hash of the key for which this ProTx was valid
     mutable uint256 validForProTxKey;
@@ -358,6 +360,35 @@ enum class MemPoolRemovalReason {
     CONFLICT,    //! Removed for conflict with in-block transaction
 };
 
+/** Hashers for the keys of the ProTx conflict indexes, for use with StaticSaltedHasher */
+template<>
+struct SaltedHasherImpl<CService>
+{
+    static std::size_t CalcHash(const CService& v, uint64_t k0, uint64_t k1)
+    {
+        std::vector<unsigned char> vchKey = v.GetKey();
+        return CSipHasher(k0, k1).Write(vchKey.data(), vchKey.size()).Finalize();
+    }
+};
+
+template<>
+struct SaltedHasherImpl<CKeyID>
+{
+    static std::size_t CalcHash(const CKeyID& v, uint64_t k0, uint64_t k1)
+    {
+        return CSipHasher(k0, k1).Write(v.begin(), v.size()).Finalize();
+    }
+};
+
+template<>
+struct SaltedHasherImpl<COutPoint>
+{
+    static std::size_t CalcHash(const COutPoint& v, uint64_t k0, uint64_t k1)
+    {
+        return SipHashUint256Extra(k0, k1, v.hash, v.n);
+    }
+};
+
 class SaltedTxidHasher
 {
 private:
@@ -398,7 +429,7 @@ public:
  *
  * In order for the feerate sort to remain correct, we must update transactions
  * in the mempool when new descendants arrive.  To facilitate this, we track
- * the set of in-mempool direct parents and direct children in mapLinks.  Within
+ * the set of in-mempool direct parents and direct children in vTxLinks.  Within
  * each CTxMemPoolEntry, we track the size and fees of all descendants.
  *
  * Usually when a new transaction is added to the mempool, it has no in-mempool
@@ -431,7 +462,7 @@ public:
  * state, to account for in-mempool, out-of-block descendants for all the
  * in-block transactions by calling UpdateTransactionsFromBlock().  Note that
  * until this is called, the mempool state is not consistent, and in particular
- * mapLinks may not be correct (and therefore functions like
+ * vTxLinks may not be correct (and therefore functions like
  * CalculateMemPoolAncestors() and CalculateDescendants() that rely
  * on them to walk the mempool are not generally safe to use).
  *
@@ -501,39 +532,79 @@ public:
         }
     };
     typedef std::set<txiter, CompareIteratorByHash> setEntries;
+    //! Direct parents or children of an entry, sorted like setEntries. Most entries only have a few, for which a
+    //! vector needs a fraction of the memory of a set.
+    typedef std::vector<txiter> vecEntries;
 
-    const setEntries & GetMemPoolParents(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
-    const setEntries & GetMemPoolChildren(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    const vecEntries & GetMemPoolParents(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    const vecEntries & GetMemPoolChildren(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
     uint64_t CalculateDescendantMaximum(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    /** Memory usage of the mempool, broken down by structure */
+    struct MemoryUsage {
+        size_t nEntries{0};
+        size_t nEntriesInner{0};
+        size_t nLinks{0};
+        size_t nNextTx{0};
+        size_t nDeltas{0};
+        size_t nTxHashes{0};
+        size_t nAddressIndex{0};
+        size_t nSpentIndex{0};
+
+        size_t Total() const { return nEntries + nEntriesInner + nLinks + nNextTx + nDeltas + nTxHashes + nAddressIndex + nSpentIndex; }
+    };
 private:
     typedef std::map<txiter, setEntries, CompareIteratorByHash> cacheMap;
 
     struct TxLinks {
-        setEntries parents;
-        setEntries children;
+        vecEntries parents;
+        vecEntries children;
     };
 
-    typedef std::map<txiter, TxLinks, CompareIteratorByHash> txlinksMap;
-    txlinksMap mapLinks;
+    //! Links of the entries, at the same index as the entry in vTxHashes (see CTxMemPoolEntry::vTxHashesIdx)
+    std::vector<TxLinks> vTxLinks;
+    //! dynamic memory usage of the vectors in vTxLinks
+    uint64_t cachedLinksUsage{0};
 
-    typedef std::map<CMempoolAddressDeltaKey, CMempoolAddressDelta, CMempoolAddressDeltaKeyCompare> addressDeltaMap;
-    addressDeltaMap mapAddress;
+    // Address deltas bucketed by (address type, address hash). A bucket is unordered, getAddressIndex sorts it.
+    typedef std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta>> addressDeltaBucket;
+    typedef std::unordered_map<std::pair<int, uint160>, addressDeltaBucket, StaticSaltedHasher> addressDeltaMap;
+    addressDeltaMap mapAddress GUARDED_BY(cs);
 
-    typedef std::map<uint256, std::vector<CMempoolAddressDeltaKey> > addressDeltaMapInserted;
-    addressDeltaMapInserted mapAddressInserted;
+    typedef std::unordered_map<uint256, std::vector<CMempoolAddressDeltaKey>, StaticSaltedHasher> addressDeltaMapInserted;
+    addressDeltaMapInserted mapAddressInserted GUARDED_BY(cs);
 
-    typedef std::map<CSpentIndexKey, CSpentIndexValue, CSpentIndexKeyCompare> mapSpentIndex;
-    mapSpentIndex mapSpent;
+    typedef std::unordered_map<CSpentIndexKey, CSpentIndexValue, CSpentIndexKeyHasher> mapSpentIndex;
+    mapSpentIndex mapSpent GUARDED_BY(cs);
 
-    typedef std::map<uint256, std::vector<CSpentIndexKey> > mapSpentIndexInserted;
-    mapSpentIndexInserted mapSpentInserted;
+    typedef std::unordered_map<uint256, std::vector<CSpentIndexKey>, StaticSaltedHasher> mapSpentIndexInserted;
+    mapSpentIndexInserted mapSpentInserted GUARDED_BY(cs);
+
+    //! dynamic memory usage of the vectors in mapAddress, mapAddressInserted and mapSpentInserted
+    uint64_t cachedIndexUsage GUARDED_BY(cs){0};
+
+    void addAddressDelta(const CMempoolAddressDeltaKey& key, const CMempoolAddressDelta& delta, std::vector<CMempoolAddressDeltaKey>& inserted) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    std::unordered_multimap<uint256, uint256, StaticSaltedHasher> mapProTxRefs; // proTxHash -> transaction (all TXs that refer to an existing proTx)
+    std::unordered_map<CService, uint256, StaticSaltedHasher> mapProTxAddresses;
+    std::unordered_map<CKeyID, uint256, StaticSaltedHasher> mapProTxPubKeyIDs;
+    std::unordered_map<uint256, uint256, StaticSaltedHasher> mapProTxBlsPubKeyHashes;
+    std::unordered_map<COutPoint, uint256, StaticSaltedHasher> mapProTxCollaterals;
+
+    /** The keys a ProTx was inserted with into the maps above, so that removing it doesn't need to parse its payload */
+    struct ProTxIndexKeys {
+        std::vector<std::pair<uint256, uint256>> refs;
+        std::vector<CService> addresses;
+        std::vector<CKeyID> keyIDs;
+        std::vector<uint256> blsPubKeyHashes;
+        std::vector<COutPoint> collaterals;
+    };
+    std::unordered_map<uint256, ProTxIndexKeys, StaticSaltedHasher> mapProTxIndexKeys;
 
-    std::multimap<uint256, uint256> mapProTxRefs; // proTxHash -> transaction (all TXs that refer to an existing proTx)
-    std::map<CService, uint256> mapProTxAddresses;
-    std::map<CKeyID, uint256> mapProTxPubKeyIDs;
-    std::map<uint256, uint256> mapProTxBlsPubKeyHashes;
-    std::map<COutPoint, uint256> mapProTxCollaterals;
+    void addProTxIndexes(const CTransaction& tx, const txiter& newit);
+    void removeProTxIndexes(const uint256& txHash);
 
+    void UpdateLink(vecEntries& links, txiter other, bool add);
     void UpdateParent(txiter entry, txiter parent, bool add);
     void UpdateChild(txiter entry, txiter child, bool add);
 
@@ -633,7 +704,7 @@ public:
      *  limitDescendantSize = max size of descendants any ancestor can have
      *  errString = populated with error reason if any limits are hit
      *  fSearchForParents = whether to search a tx's vin for in-mempool parents, or
-     *    look up parents from mapLinks. Must be true for entries not in the mempool
+     *    look up parents from vTxLinks. Must be true for entries not in the mempool
      */
     bool CalculateMemPoolAncestors(const CTxMemPoolEntry& entry, setEntries& setAncestors, uint64_t limitAncestorCount, uint64_t limitAncestorSize, uint64_t limitDescendantCount, uint64_t limitDescendantSize, std::string& errString, bool fSearchForParents = true) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
@@ -690,6 +761,7 @@ public:
     bool existsProviderTxConflict(const CTransaction &tx) const;
 
     size_t DynamicMemoryUsage() const;
+    MemoryUsage GetMemoryUsage() const;
 
     boost::signals2::signal<void (CTransactionRef)> NotifyEntryAdded;
     boost::signals2::signal<void (CTransactionRef, MemPoolRemovalReason)> NotifyEntryRemoved;
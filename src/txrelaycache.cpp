@@ -0,0 +1,126 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <txrelaycache.h>
+
+#include <core_memusage.h>
+
+#include <algorithm>
+
+CTxRelayCache txRelayCache;
+
+CTxRelayCache::CTxRelayCache(size_t nMaxBytesIn) :
+    vecWheel(WHEEL_SLOTS),
+    nMaxBytes(nMaxBytesIn)
+{
+}
+
+void CTxRelayCache::Add(const CTransactionRef& tx, int64_t nNow)
+{
+    LOCK(cs);
+
+    int64_t nNowSlot = nNow / WHEEL_SLOT_SECONDS;
+    if (nFirstSlot == -1) {
+        nFirstSlot = nNowSlot;
+    }
+    ExpireSlots(nNowSlot);
+
+    const uint256& hash = tx->GetHash();
+    if (mapTxs.count(hash)) {
+        return;
+    }
+
+    // keep the slot inside the wheel, even if the clock went backwards
+    int64_t nSlot = (nNow + RELAY_TIME) / WHEEL_SLOT_SECONDS;
+    nSlot = std::max(nFirstSlot, std::min(nSlot, nFirstSlot + (int64_t)WHEEL_SLOTS - 1));
+
+    size_t nTxBytes = RecursiveDynamicUsage(tx);
+    mapTxs.emplace(hash, Entry{tx, nSlot, nTxBytes});
+    vecWheel[nSlot % WHEEL_SLOTS].emplace_back(hash);
+    nBytes += nTxBytes;
+
+    EvictToBudget();
+}
+
+CTransactionRef CTxRelayCache::Get(const uint256& hash) const
+{
+    LOCK(cs);
+    auto it = mapTxs.find(hash);
+    if (it == mapTxs.end()) {
+        return nullptr;
+    }
+    return it->second.tx;
+}
+
+void CTxRelayCache::Expire(int64_t nNow)
+{
+    LOCK(cs);
+    if (nFirstSlot != -1) {
+        ExpireSlots(nNow / WHEEL_SLOT_SECONDS);
+    }
+}
+
+void CTxRelayCache::SetMaxBytes(size_t nMaxBytesIn)
+{
+    LOCK(cs);
+    nMaxBytes = nMaxBytesIn;
+    EvictToBudget();
+}
+
+CTxRelayCache::Stats CTxRelayCache::GetStats() const
+{
+    LOCK(cs);
+    Stats stats;
+    stats.nCount = mapTxs.size();
+    stats.nBytes = nBytes;
+    stats.nMaxBytes = nMaxBytes;
+    stats.nEvicted = nEvicted;
+    return stats;
+}
+
+void CTxRelayCache::ExpireSlots(int64_t nSlot)
+{
+    AssertLockHeld(cs);
+
+    // everything in a slot expires once the clock passed it, no need to go around the wheel more than once
+    int64_t nCount = std::min(nSlot - nFirstSlot, (int64_t)WHEEL_SLOTS);
+    for (int64_t i = 0; i < nCount; i++) {
+        ClearSlot(nFirstSlot + i);
+    }
+    nFirstSlot = std::max(nFirstSlot, nSlot);
+}
+
+void CTxRelayCache::ClearSlot(int64_t nSlot)
+{
+    AssertLockHeld(cs);
+
+    auto& slot = vecWheel[nSlot % WHEEL_SLOTS];
+    for (const auto& hash : slot) {
+        auto it = mapTxs.find(hash);
+        if (it != mapTxs.end() && it->second.nSlot == nSlot) {
+            nBytes -= it->second.nBytes;
+            mapTxs.erase(it);
+        }
+    }
+    // release the memory of slots which grew large during spam
+    std::deque<uint256>().swap(slot);
+}
+
+void CTxRelayCache::EvictToBudget()
+{
+    AssertLockHeld(cs);
+
+    for (int64_t nSlot = nFirstSlot; nBytes > nMaxBytes && nSlot < nFirstSlot + (int64_t)WHEEL_SLOTS; nSlot++) {
+        auto& slot = vecWheel[nSlot % WHEEL_SLOTS];
+        while (nBytes > nMaxBytes && !slot.empty()) {
+            auto it = mapTxs.find(slot.front());
+            if (it != mapTxs.end() && it->second.nSlot == nSlot) {
+                nBytes -= it->second.nBytes;
+                mapTxs.erase(it);
+                nEvicted++;
+            }
+            slot.pop_front();
+        }
+    }
+}
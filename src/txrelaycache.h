@@ -0,0 +1,80 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_TXRELAYCACHE_H
+#define BITCOIN_TXRELAYCACHE_H
+
+#include <primitives/transaction.h>
+#include <saltedhasher.h>
+#include <sync.h>
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+class CTxRelayCache;
+
+/** Transactions we announced recently, so that we can still answer GETDATA for them after they left the mempool */
+extern CTxRelayCache txRelayCache;
+
+/** Default for -maxrelaycache, the memory budget of the relay cache in megabytes */
+static const unsigned int DEFAULT_MAX_RELAY_CACHE_SIZE = 32;
+
+/**
+ * Keeps relayed transactions for RELAY_TIME seconds, in a memory budget.
+ *
+ * Expiry is done with a time wheel of WHEEL_SLOT_SECONDS wide slots, so that expiring and evicting is cheap no matter
+ * how many transactions are in the cache. If the budget is exceeded, the transactions which expire first are evicted
+ * first. The cache has its own lock and can be used without holding cs_main.
+ */
+class CTxRelayCache
+{
+public:
+    static const int64_t RELAY_TIME = 15 * 60;
+    static const int64_t WHEEL_SLOT_SECONDS = 60;
+    // one more slot than needed to cover RELAY_TIME, as the current slot is only partially used
+    static const size_t WHEEL_SLOTS = RELAY_TIME / WHEEL_SLOT_SECONDS + 2;
+
+    struct Stats {
+        size_t nCount{0};
+        size_t nBytes{0};
+        size_t nMaxBytes{0};
+        uint64_t nEvicted{0};
+    };
+
+private:
+    struct Entry {
+        CTransactionRef tx;
+        int64_t nSlot;
+        size_t nBytes;
+    };
+
+    mutable CCriticalSection cs;
+    std::unordered_map<uint256, Entry, StaticSaltedHasher> mapTxs GUARDED_BY(cs);
+    std::vector<std::deque<uint256>> vecWheel GUARDED_BY(cs);
+    // All slots before this one were expired already, -1 if nothing was added yet
+    int64_t nFirstSlot GUARDED_BY(cs){-1};
+    size_t nBytes GUARDED_BY(cs){0};
+    size_t nMaxBytes GUARDED_BY(cs);
+    uint64_t nEvicted GUARDED_BY(cs){0};
+
+public:
+    explicit CTxRelayCache(size_t nMaxBytesIn = DEFAULT_MAX_RELAY_CACHE_SIZE * 1000000);
+
+    /** Adds tx (if it's not in the cache yet), nNow is in seconds */
+    void Add(const CTransactionRef& tx, int64_t nNow);
+    CTransactionRef Get(const uint256& hash) const;
+    /** Removes all transactions which expired at nNow */
+    void Expire(int64_t nNow);
+
+    void SetMaxBytes(size_t nMaxBytesIn);
+    Stats GetStats() const;
+
+private:
+    void ExpireSlots(int64_t nSlot) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void ClearSlot(int64_t nSlot) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void EvictToBudget() EXCLUSIVE_LOCKS_REQUIRED(cs);
+};
+
+#endif // BITCOIN_TXRELAYCACHE_H
@@ -11,13 +11,17 @@
 #include <chainparams.h>
 #include <checkpoints.h>
 #include <checkqueue.h>
+#include <coinsprefetch.h>
 #include <consensus/consensus.h>
 #include <consensus/merkle.h>
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
+#include <ctpl.h>
 #include <cuckoocache.h>
 #include <hash.h>
+#include <index/extraindexes.h>
 #include <init.h>
+#include <node/coinstats.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
 #include <pow.h>
@@ -166,14 +170,16 @@ public:
     /**
      * If a block header hasn't already been seen, call CheckBlockHeader on it, ensure
      * that it doesn't descend from an invalid block, and then add it to mapBlockIndex.
+     * pHash may point to the already calculated hash of the header.
      */
-    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
-    bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, bool* fNewBlock) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, const uint256* pHash = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, bool* fNewBlock, const uint256* pHash = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     // Block (dis)connection on a given view:
-    DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view);
+    // When pcommitment is not null, it's updated with the changes to the view.
+    DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view, CCoinsCommitment* pcommitment = nullptr);
     bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex,
-                    CCoinsViewCache& view, const CChainParams& chainparams, bool fJustCheck = false);
+                    CCoinsViewCache& view, const CChainParams& chainparams, bool fJustCheck = false, CCoinsCommitment* pcommitment = nullptr);
 
     // Block disconnection on our pcoinsTip:
     bool DisconnectTip(CValidationState& state, const CChainParams& chainparams, DisconnectedBlockTransactions *disconnectpool);
@@ -196,7 +202,7 @@ private:
     bool ActivateBestChainStep(CValidationState& state, const CChainParams& chainparams, CBlockIndex* pindexMostWork, const std::shared_ptr<const CBlock>& pblock, bool& fInvalidFound, ConnectTrace& connectTrace);
     bool ConnectTip(CValidationState& state, const CChainParams& chainparams, CBlockIndex* pindexNew, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, DisconnectedBlockTransactions &disconnectpool);
 
-    CBlockIndex* AddToBlockIndex(const CBlockHeader& block, enum BlockStatus nStatus = BLOCK_VALID_TREE) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    CBlockIndex* AddToBlockIndex(const CBlockHeader& block, enum BlockStatus nStatus = BLOCK_VALID_TREE, const uint256* pHash = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     /** Create a new block index entry for a given block hash */
     CBlockIndex* InsertBlockIndex(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     /**
@@ -240,6 +246,7 @@ unsigned int nBytesPerSigOp = DEFAULT_BYTES_PER_SIGOP;
 bool fCheckBlockIndex = false;
 bool fCheckpointsEnabled = DEFAULT_CHECKPOINTS_ENABLED;
 size_t nCoinCacheUsage = 5000 * 300;
+size_t nCoinCacheKeepUsage = 0;
 uint64_t nPruneTarget = 0;
 int64_t nMaxTipAge = DEFAULT_MAX_TIP_AGE;
 
@@ -306,6 +313,7 @@ CBlockIndex* FindForkInGlobalIndex(const CChain& chain, const CBlockLocator& loc
 std::unique_ptr<CCoinsViewDB> pcoinsdbview;
 std::unique_ptr<CCoinsViewCache> pcoinsTip;
 std::unique_ptr<CBlockTreeDB> pblocktree;
+std::unique_ptr<CCoinsCommitment> g_coins_commitment;
 
 enum class FlushStateMode {
     NONE,
@@ -917,12 +925,61 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState &state, const CTransa
     return AcceptToMemoryPoolWithTime(chainparams, pool, state, tx, pfMissingInputs, GetTime(), bypass_limits, nAbsurdFee, fDryRun);
 }
 
+static void CachePackageSignatures(CTxMemPool& pool, const std::vector<CTransactionRef>& vtx, std::vector<std::vector<COutPoint>>& vCoinsToUncache);
+
+/** (try to) add a package of transactions to memory pool with specified acceptance times, one for each transaction **/
+static size_t AcceptPackageToMemoryPoolWithTimes(const CChainParams& chainparams, CTxMemPool& pool, const std::vector<CTransactionRef>& vtx,
+                                                 const std::vector<int64_t>& vAcceptTimes, std::vector<CValidationState>& vStates,
+                                                 std::vector<bool>& vAccepted, bool bypass_limits, const CAmount nAbsurdFee)
+{
+    AssertLockHeld(cs_main);
+    assert(vAcceptTimes.size() == vtx.size());
+    vStates.assign(vtx.size(), CValidationState());
+    vAccepted.assign(vtx.size(), false);
+    std::vector<std::vector<COutPoint>> vCoinsToUncache(vtx.size());
+    size_t nAccepted = 0;
+    {
+        LOCK(pool.cs);
+        CachePackageSignatures(pool, vtx, vCoinsToUncache);
+
+        for (size_t i = 0; i < vtx.size(); i++) {
+            vAccepted[i] = AcceptToMemoryPoolWorker(chainparams, pool, vStates[i], vtx[i], nullptr /* pfMissingInputs */, vAcceptTimes[i], bypass_limits, nAbsurdFee, vCoinsToUncache[i], false);
+            if (vAccepted[i]) {
+                nAccepted++;
+            } else {
+                LogPrint(BCLog::MEMPOOL, "%s: %s %s (%s)\n", __func__, vtx[i]->GetHash().ToString(), vStates[i].GetRejectReason(), vStates[i].GetDebugMessage());
+            }
+        }
+    }
+    for (size_t i = 0; i < vtx.size(); i++) {
+        if (!vAccepted[i]) {
+            for (const COutPoint& outpoint : vCoinsToUncache[i]) {
+                pcoinsTip->Uncache(outpoint);
+            }
+        }
+    }
+    // After we've (potentially) uncached entries, ensure our coins cache is still within its size limits
+    CValidationState stateDummy;
+    FlushStateToDisk(chainparams, stateDummy, FlushStateMode::PERIODIC);
+    return nAccepted;
+}
+
+size_t AcceptPackageToMemoryPool(CTxMemPool& pool, const std::vector<CTransactionRef>& vtx, std::vector<CValidationState>& vStates,
+                                 std::vector<bool>& vAccepted, bool bypass_limits, const CAmount nAbsurdFee)
+{
+    const std::vector<int64_t> vAcceptTimes(vtx.size(), GetTime());
+    return AcceptPackageToMemoryPoolWithTimes(Params(), pool, vtx, vAcceptTimes, vStates, vAccepted, bypass_limits, nAbsurdFee);
+}
+
 bool GetTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &hashes)
 {
-    if (!fTimestampIndex)
+    if (!g_timestampindex)
         return error("Timestamp index not enabled");
 
-    if (!pblocktree->ReadTimestampIndex(high, low, hashes))
+    if (!g_timestampindex->IsSynced())
+        return error("Timestamp index is still being built");
+
+    if (!g_timestampindex->ReadTimestampIndex(high, low, hashes))
         return error("Unable to get hashes for timestamps");
 
     return true;
@@ -936,7 +993,10 @@ bool GetSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value)
     if (mempool.getSpentIndex(key, value))
         return true;
 
-    if (!pblocktree->ReadSpentIndex(key, value))
+    if (!g_spentindex || !g_spentindex->IsSynced())
+        return false;
+
+    if (!g_spentindex->ReadSpentIndex(key, value))
         return false;
 
     return true;
@@ -945,10 +1005,13 @@ bool GetSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value)
 bool GetAddressIndex(uint160 addressHash, int type,
                      std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex, int start, int end)
 {
-    if (!fAddressIndex)
+    if (!g_addressindex)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressIndex(addressHash, type, addressIndex, start, end))
+    if (!g_addressindex->IsSynced())
+        return error("address index is still being built");
+
+    if (!g_addressindex->ReadAddressIndex(addressHash, type, addressIndex, start, end))
         return error("unable to get txids for address");
 
     return true;
@@ -957,15 +1020,64 @@ bool GetAddressIndex(uint160 addressHash, int type,
 bool GetAddressUnspent(uint160 addressHash, int type,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs)
 {
-    if (!fAddressIndex)
+    if (!g_addressindex)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, unspentOutputs))
+    if (!g_addressindex->IsSynced())
+        return error("address index is still being built");
+
+    if (!g_addressindex->ReadAddressUnspentIndex(addressHash, type, unspentOutputs))
         return error("unable to get txids for address");
 
     return true;
 }
 
+bool GetAddressIndexPage(const CAddressIndexKey &start, int end, size_t limit,
+                         std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                         CAddressIndexKey &next, bool &fMore)
+{
+    if (!g_addressindex)
+        return error("address index not enabled");
+
+    if (!g_addressindex->IsSynced())
+        return error("address index is still being built");
+
+    if (!g_addressindex->ReadAddressIndexPage(start, end, limit, addressIndex, next, fMore))
+        return error("unable to get txids for address");
+
+    return true;
+}
+
+bool GetAddressUnspentPage(const CAddressUnspentKey &start, size_t limit,
+                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                           CAddressUnspentKey &next, bool &fMore)
+{
+    if (!g_addressindex)
+        return error("address index not enabled");
+
+    if (!g_addressindex->IsSynced())
+        return error("address index is still being built");
+
+    if (!g_addressindex->ReadAddressUnspentPage(start, limit, unspentOutputs, next, fMore))
+        return error("unable to get txids for address");
+
+    return true;
+}
+
+bool GetAddressSummary(uint160 addressHash, int type, CAddressSummary &summary)
+{
+    if (!g_addressindex)
+        return error("address index not enabled");
+
+    if (!g_addressindex->IsSynced())
+        return error("address index is still being built");
+
+    if (!g_addressindex->ReadAddressSummary(addressHash, type, summary))
+        return error("unable to get summary for address");
+
+    return true;
+}
+
 /**
  * Return transaction in txOut, and if it was found inside a block, its hash is placed in hashBlock.
  * If blockIndex is provided, the transaction is fetched from the corresponding block.
@@ -1063,7 +1175,8 @@ static bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMes
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams)
+/** Read a block and check its PoW, the X11 hash computed for that is returned in hashRet */
+static bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams, uint256& hashRet)
 {
     block.SetNull();
 
@@ -1081,12 +1194,19 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus:
     }
 
     // Check the header
-    if (!CheckProofOfWork(block.GetHash(), block.nBits, consensusParams))
+    hashRet = block.GetHash();
+    if (!CheckProofOfWork(hashRet, block.nBits, consensusParams))
         return error("ReadBlockFromDisk: Errors in block header at %s", pos.ToString());
 
     return true;
 }
 
+bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams)
+{
+    uint256 hash;
+    return ReadBlockFromDisk(block, pos, consensusParams, hash);
+}
+
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
 {
     CDiskBlockPos blockPos;
@@ -1095,14 +1215,50 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus
         blockPos = pindex->GetBlockPos();
     }
 
-    if (!ReadBlockFromDisk(block, blockPos, consensusParams))
+    uint256 hash;
+    if (!ReadBlockFromDisk(block, blockPos, consensusParams, hash))
         return false;
-    if (block.GetHash() != pindex->GetBlockHash())
+    if (hash != pindex->GetBlockHash())
         return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): GetHash() doesn't match index for %s at %s",
                 pindex->ToString(), pindex->GetBlockPos().ToString());
     return true;
 }
 
+bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& message_start)
+{
+    CDiskBlockPos hpos = pos;
+    hpos.nPos -= 8; // Seek back 8 bytes for meta header
+    CAutoFile filein(OpenBlockFile(hpos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull()) {
+        return error("%s: OpenBlockFile failed for %s", __func__, pos.ToString());
+    }
+
+    try {
+        CMessageHeader::MessageStartChars blk_start;
+        unsigned int blk_size;
+
+        filein >> blk_start >> blk_size;
+
+        if (memcmp(blk_start, message_start, CMessageHeader::MESSAGE_START_SIZE)) {
+            return error("%s: Block magic mismatch for %s: %s versus expected %s", __func__, pos.ToString(),
+                    HexStr(blk_start, blk_start + CMessageHeader::MESSAGE_START_SIZE),
+                    HexStr(message_start, message_start + CMessageHeader::MESSAGE_START_SIZE));
+        }
+
+        if (blk_size > MAX_SIZE) {
+            return error("%s: Block data is larger than maximum deserialization size for %s: %s versus %s", __func__, pos.ToString(),
+                    blk_size, MAX_SIZE);
+        }
+
+        block.resize(blk_size); // Zeroing of memory is intentional here
+        filein.read((char*)block.data(), blk_size);
+    } catch (const std::exception& e) {
+        return error("%s: Read from block file failed: %s for %s", __func__, e.what(), pos.ToString());
+    }
+
+    return true;
+}
+
 double ConvertBitsToDouble(unsigned int nBits)
 {
     int nShift = (nBits >> 24) & 0xff;
@@ -1446,16 +1602,65 @@ int GetSpendHeight(const CCoinsViewCache& inputs)
 
 static CuckooCache::cache<uint256, SignatureCacheHasher> scriptExecutionCache;
 static uint256 scriptExecutionCacheNonce(GetRandHash());
+static std::atomic<uint64_t> nScriptExecutionCacheHits{0};
+static std::atomic<uint64_t> nScriptExecutionCacheMisses{0};
+static std::atomic<size_t> nScriptExecutionCacheElements{0};
+
+static uint256 ScriptExecutionCacheEntry(const CTransaction& tx, unsigned int flags)
+{
+    uint256 hashCacheEntry;
+    // We only use the first 19 bytes of nonce to avoid a second SHA
+    // round - giving us 19 + 32 + 4 = 55 bytes (+ 8 + 1 = 64)
+    static_assert(55 - sizeof(flags) - 32 >= 128/8, "Want at least 128 bits of nonce for script execution cache");
+    CSHA256().Write(scriptExecutionCacheNonce.begin(), 55 - sizeof(flags) - 32).Write(tx.GetHash().begin(), 32).Write((unsigned char*)&flags, sizeof(flags)).Finalize(hashCacheEntry.begin());
+    return hashCacheEntry;
+}
 
 void InitScriptExecutionCache() {
     // nMaxCacheSize is unsigned. If -maxsigcachesize is set to zero,
     // setup_bytes creates the minimum possible cache (2 elements).
     size_t nMaxCacheSize = std::min(std::max((int64_t)0, gArgs.GetArg("-maxsigcachesize", DEFAULT_MAX_SIG_CACHE_SIZE) / 2), MAX_MAX_SIG_CACHE_SIZE) * ((size_t) 1 << 20);
     size_t nElems = scriptExecutionCache.setup_bytes(nMaxCacheSize);
+    nScriptExecutionCacheElements = nElems;
     LogPrintf("Using %zu MiB out of %zu/2 requested for script execution cache, able to store %zu elements\n",
             (nElems*sizeof(uint256)) >>20, (nMaxCacheSize*2)>>20, nElems);
 }
 
+CCuckooCacheStats GetScriptExecutionCacheStats()
+{
+    CCuckooCacheStats stats;
+    stats.nHits = nScriptExecutionCacheHits;
+    stats.nMisses = nScriptExecutionCacheMisses;
+    stats.nMaxElements = nScriptExecutionCacheElements;
+    return stats;
+}
+
+void WarmScriptExecutionCache(const CTransaction& tx)
+{
+    LOCK2(cs_main, mempool.cs);
+    if (tx.IsCoinBase() || !mempool.exists(tx.GetHash())) {
+        return;
+    }
+    const unsigned int flags = GetBlockScriptFlags(chainActive.Tip(), Params().GetConsensus());
+    if (scriptExecutionCache.contains(ScriptExecutionCacheEntry(tx, flags), false)) {
+        return;
+    }
+
+    // The entry was evicted or never stored with the current block flags, verify the scripts again and cache them
+    CCoinsViewMemPool viewMemPool(pcoinsTip.get(), mempool);
+    CCoinsViewCache view(&viewMemPool);
+    for (const CTxIn& txin : tx.vin) {
+        if (view.AccessCoin(txin.prevout).IsSpent()) {
+            return;
+        }
+    }
+    CValidationState state;
+    PrecomputedTransactionData txdata(tx);
+    if (!CheckInputsFromMempoolAndCache(tx, state, view, mempool, flags, true, txdata)) {
+        LogPrint(BCLog::MEMPOOL, "%s: script checks of %s failed: %s\n", __func__, tx.GetHash().ToString(), FormatStateMessage(state));
+    }
+}
+
 /**
  * Check whether all inputs of this transaction are valid (no double spends, scripts & sigs, amounts)
  * This does not modify the UTXO set.
@@ -1493,15 +1698,13 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsVi
             // correct (ie that the transaction hash which is in tx's prevouts
             // properly commits to the scriptPubKey in the inputs view of that
             // transaction).
-            uint256 hashCacheEntry;
-            // We only use the first 19 bytes of nonce to avoid a second SHA
-            // round - giving us 19 + 32 + 4 = 55 bytes (+ 8 + 1 = 64)
-            static_assert(55 - sizeof(flags) - 32 >= 128/8, "Want at least 128 bits of nonce for script execution cache");
-            CSHA256().Write(scriptExecutionCacheNonce.begin(), 55 - sizeof(flags) - 32).Write(tx.GetHash().begin(), 32).Write((unsigned char*)&flags, sizeof(flags)).Finalize(hashCacheEntry.begin());
+            const uint256 hashCacheEntry = ScriptExecutionCacheEntry(tx, flags);
             AssertLockHeld(cs_main); //TODO: Remove this requirement by making CuckooCache not require external locks
             if (scriptExecutionCache.contains(hashCacheEntry, !cacheFullScriptStore)) {
+                nScriptExecutionCacheHits++;
                 return true;
             }
+            nScriptExecutionCacheMisses++;
 
             for (unsigned int i = 0; i < tx.vin.size(); i++) {
                 const COutPoint &prevout = tx.vin[i].prevout;
@@ -1570,8 +1773,12 @@ bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint
     if (fileout.IsNull())
         return error("%s: OpenUndoFile failed", __func__);
 
+    // Serialize the undo data only once, the size, the file and the checksum all use the same buffer
+    CDataStream ssUndo(SER_DISK, CLIENT_VERSION);
+    ssUndo << blockundo;
+
     // Write index header
-    unsigned int nSize = GetSerializeSize(fileout, blockundo);
+    unsigned int nSize = ssUndo.size();
     fileout << messageStart << nSize;
 
     // Write undo data
@@ -1579,45 +1786,63 @@ bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint
     if (fileOutPos < 0)
         return error("%s: ftell failed", __func__);
     pos.nPos = (unsigned int)fileOutPos;
-    fileout << blockundo;
+    fileout.write(ssUndo.data(), ssUndo.size());
 
     // calculate & write checksum
     CHashWriter hasher(SER_GETHASH, PROTOCOL_VERSION);
     hasher << hashBlock;
-    hasher << blockundo;
+    hasher.write(ssUndo.data(), ssUndo.size());
     fileout << hasher.GetHash();
 
     return true;
 }
 
-static bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
+static bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uint256& hashPrevBlock)
 {
-    CDiskBlockPos pos = pindex->GetUndoPos();
     if (pos.IsNull()) {
         return error("%s: no undo data available", __func__);
     }
+    if (pos.nPos < sizeof(unsigned int)) {
+        return error("%s: invalid undo position %s", __func__, pos.ToString());
+    }
 
-    // Open history file to read
-    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
+    // Open history file to read, at the size field of the index header. The record is read with a single read and
+    // hashed in one go, instead of hashing every field while it's deserialized from the file.
+    CAutoFile filein(OpenUndoFile(CDiskBlockPos(pos.nFile, pos.nPos - sizeof(unsigned int)), true), SER_DISK, CLIENT_VERSION);
     if (filein.IsNull())
         return error("%s: OpenUndoFile failed", __func__);
 
     // Read block
     uint256 hashChecksum;
-    CHashVerifier<CAutoFile> verifier(&filein); // We need a CHashVerifier as reserializing may lose data
+    CDataStream ssUndo(SER_DISK, CLIENT_VERSION);
     try {
-        verifier << pindex->pprev->GetBlockHash();
-        verifier >> blockundo;
+        unsigned int nSize;
+        filein >> nSize;
+        if (nSize > MAX_SIZE) {
+            return error("%s: invalid undo data size %u", __func__, nSize);
+        }
+        ssUndo.resize(nSize);
+        filein.read(ssUndo.data(), nSize);
         filein >> hashChecksum;
     }
     catch (const std::exception& e) {
-        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+        return error("%s: I/O error - %s", __func__, e.what());
     }
 
     // Verify checksum
-    if (hashChecksum != verifier.GetHash())
+    CHashWriter hasher(SER_GETHASH, PROTOCOL_VERSION);
+    hasher << hashPrevBlock;
+    hasher.write(ssUndo.data(), ssUndo.size());
+    if (hashChecksum != hasher.GetHash())
         return error("%s: Checksum mismatch", __func__);
 
+    try {
+        ssUndo >> blockundo;
+    }
+    catch (const std::exception& e) {
+        return error("%s: Deserialize error - %s", __func__, e.what());
+    }
+
     return true;
 }
 
@@ -1641,6 +1866,11 @@ bool AbortNode(CValidationState& state, const std::string& strMessage, const std
 
 } // namespace
 
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
+{
+    return UndoReadFromDisk(blockundo, pindex->GetUndoPos(), pindex->pprev->GetBlockHash());
+}
+
 /**
  * Restore the UTXO in a Coin at a given COutPoint
  * @param undo The Coin to be restored.
@@ -1677,7 +1907,7 @@ int ApplyTxInUndo(Coin&& undo, CCoinsViewCache& view, const COutPoint& out)
 
 /** Undo the effects of this block (with given index) on the UTXO set represented by coins.
  *  When FAILED is returned, view is left in an indeterminate state. */
-DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view)
+DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view, CCoinsCommitment* pcommitment)
 {
     bool fDIP0003Active = pindex->nHeight >= Params().GetConsensus().DIP0003Height;
     if (fDIP0003Active && !evoDb->VerifyBestBlock(pindex->GetBlockHash())) {
@@ -1701,10 +1931,6 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
         return DISCONNECT_FAILED;
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
-    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
-
     if (!UndoSpecialTxsInBlock(block, pindex)) {
         return DISCONNECT_FAILED;
     }
@@ -1715,41 +1941,6 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
         uint256 hash = tx.GetHash();
         bool is_coinbase = tx.IsCoinBase();
 
-        if (fAddressIndex) {
-
-            for (unsigned int k = tx.vout.size(); k-- > 0;) {
-                const CTxOut &out = tx.vout[k];
-
-                if (out.scriptPubKey.IsPayToScriptHash()) {
-                    std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+2, out.scriptPubKey.begin()+22);
-
-                    // undo receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(2, uint160(hashBytes), pindex->nHeight, i, hash, k, false), out.nValue));
-
-                    // undo unspent index
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(2, uint160(hashBytes), hash, k), CAddressUnspentValue()));
-
-                } else if (out.scriptPubKey.IsPayToPublicKeyHash()) {
-                    std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+3, out.scriptPubKey.begin()+23);
-
-                    // undo receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(1, uint160(hashBytes), pindex->nHeight, i, hash, k, false), out.nValue));
-
-                    // undo unspent index
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, uint160(hashBytes), hash, k), CAddressUnspentValue()));
-
-                } else if (out.scriptPubKey.IsPayToPublicKey()) {
-                    uint160 hashBytes(Hash160(out.scriptPubKey.begin()+1, out.scriptPubKey.end()-1));
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(1, hashBytes, pindex->nHeight, i, hash, k, false), out.nValue));
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, hash, k), CAddressUnspentValue()));
-                } else {
-                    continue;
-                }
-
-            }
-
-        }
-
         // Check that all outputs are available and match the outputs in the block itself
         // exactly.
         for (size_t o = 0; o < tx.vout.size(); o++) {
@@ -1760,6 +1951,9 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
                 if (!is_spent || tx.vout[o] != coin.out || pindex->nHeight != coin.nHeight || is_coinbase != coin.fCoinBase) {
                     fClean = false; // transaction output mismatch
                 }
+                if (is_spent && pcommitment) {
+                    pcommitment->RemoveCoin(out, coin);
+                }
             }
         }
 
@@ -1772,73 +1966,18 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
             }
             for (unsigned int j = tx.vin.size(); j-- > 0;) {
                 const COutPoint &out = tx.vin[j].prevout;
-                int undoHeight = txundo.vprevout[j].nHeight;
                 int res = ApplyTxInUndo(std::move(txundo.vprevout[j]), view, out);
                 if (res == DISCONNECT_FAILED) return DISCONNECT_FAILED;
                 fClean = fClean && res != DISCONNECT_UNCLEAN;
-
-                const CTxIn input = tx.vin[j];
-
-                if (fSpentIndex) {
-                    // undo and delete the spent index
-                    spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue()));
+                if (pcommitment) {
+                    // the restored coin, ApplyTxInUndo() might have completed its metadata
+                    pcommitment->AddCoin(out, view.AccessCoin(out));
                 }
-
-                if (fAddressIndex) {
-                    const Coin &coin = view.AccessCoin(tx.vin[j].prevout);
-                    const CTxOut &prevout = coin.out;
-                    if (prevout.scriptPubKey.IsPayToScriptHash()) {
-                        std::vector<unsigned char> hashBytes(prevout.scriptPubKey.begin()+2, prevout.scriptPubKey.begin()+22);
-
-                        // undo spending activity
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(2, uint160(hashBytes), pindex->nHeight, i, hash, j, true), prevout.nValue * -1));
-
-                        // restore unspent index
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(2, uint160(hashBytes), input.prevout.hash, input.prevout.n), CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undoHeight)));
-
-
-                    } else if (prevout.scriptPubKey.IsPayToPublicKeyHash()) {
-                        std::vector<unsigned char> hashBytes(prevout.scriptPubKey.begin()+3, prevout.scriptPubKey.begin()+23);
-
-                        // undo spending activity
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(1, uint160(hashBytes), pindex->nHeight, i, hash, j, true), prevout.nValue * -1));
-
-                        // restore unspent index
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, uint160(hashBytes), input.prevout.hash, input.prevout.n), CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undoHeight)));
-
-                    } else if (prevout.scriptPubKey.IsPayToPublicKey()) {
-                        uint160 hashBytes(Hash160(prevout.scriptPubKey.begin()+1, prevout.scriptPubKey.end()-1));
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(1, hashBytes, pindex->nHeight, i, hash, j, false), prevout.nValue));
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, hash, j), CAddressUnspentValue()));
-                    } else {
-                        continue;
-                    }
-                }
-
             }
             // At this point, all of txundo.vprevout should have been moved out.
         }
     }
 
-
-    if (fSpentIndex) {
-        if (!pblocktree->UpdateSpentIndex(spentIndex)) {
-            AbortNode("Failed to delete spent index");
-            return DISCONNECT_FAILED;
-        }
-    }
-
-    if (fAddressIndex) {
-        if (!pblocktree->EraseAddressIndex(addressIndex)) {
-            AbortNode("Failed to delete address index");
-            return DISCONNECT_FAILED;
-        }
-        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
-            AbortNode("Failed to write address unspent index");
-            return DISCONNECT_FAILED;
-        }
-    }
-
     // move best block pointer to prevout block
     view.SetBestBlock(pindex->pprev->GetBlockHash());
     evoDb->WriteBestBlock(pindex->pprev->GetBlockHash());
@@ -1926,6 +2065,286 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+/**
+ * Runs the script checks of a package on the script check threads with cacheSigStore set, so that
+ * AcceptToMemoryPoolWorker finds most signatures in the signature cache afterwards. The results are not used,
+ * transactions which fail here are rejected with the proper reason by AcceptToMemoryPoolWorker.
+ */
+static void CachePackageSignatures(CTxMemPool& pool, const std::vector<CTransactionRef>& vtx, std::vector<std::vector<COutPoint>>& vCoinsToUncache)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(pool.cs);
+    if (!nScriptCheckThreads || vtx.size() < 2) {
+        return;
+    }
+
+    CCoinsViewMemPool viewMemPool(pcoinsTip.get(), pool);
+    CCoinsViewCache view(&viewMemPool);
+    // the checks point into these, so they must not be reallocated
+    std::vector<PrecomputedTransactionData> vTxData;
+    vTxData.reserve(vtx.size());
+
+    CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+    for (size_t i = 0; i < vtx.size(); i++) {
+        const CTransaction& tx = *vtx[i];
+        if (tx.IsCoinBase()) {
+            continue;
+        }
+        for (const CTxIn& txin : tx.vin) {
+            if (!pcoinsTip->HaveCoinInCache(txin.prevout)) {
+                vCoinsToUncache[i].push_back(txin.prevout);
+            }
+        }
+        if (!view.HaveInputs(tx)) {
+            continue;
+        }
+        vTxData.emplace_back(tx);
+        CValidationState stateDummy;
+        std::vector<CScriptCheck> vChecks;
+        if (CheckInputs(tx, stateDummy, view, true, STANDARD_SCRIPT_VERIFY_FLAGS, true, false, vTxData.back(), &vChecks)) {
+            control.Add(vChecks);
+        }
+        // make the outputs visible to the children in the package
+        AddCoins(view, tx, MEMPOOL_HEIGHT);
+    }
+    control.Wait();
+}
+
+/** Calculates the (X11) hashes of a group of block headers, the results are written to the locations passed on construction */
+class CBlockHeaderHashCheck
+{
+private:
+    const CBlockHeader* pheaders{nullptr};
+    size_t nHeaders{0};
+    uint256* phashesRet{nullptr};
+
+public:
+    CBlockHeaderHashCheck() = default;
+    CBlockHeaderHashCheck(const CBlockHeader* headers, size_t n, uint256* hashesRet) : pheaders(headers), nHeaders(n), phashesRet(hashesRet) {}
+
+    bool operator()()
+    {
+        HashX11Multi(pheaders, nHeaders, phashesRet);
+        return true;
+    }
+
+    void swap(CBlockHeaderHashCheck& check)
+    {
+        std::swap(pheaders, check.pheaders);
+        std::swap(nHeaders, check.nHeaders);
+        std::swap(phashesRet, check.phashesRet);
+    }
+};
+
+// Each check covers X11_MULTI_LANES headers already, keep the batches small to spread them over the workers
+static CCheckQueue<CBlockHeaderHashCheck> headerhashqueue(2);
+
+void ThreadHeaderHashCheck() {
+    RenameThread("dash-hdrhash");
+    headerhashqueue.Thread();
+}
+
+void CalculateBlockHeaderHashes(const std::vector<CBlockHeader>& headers, std::vector<uint256>& hashesRet)
+{
+    hashesRet.resize(headers.size());
+    // Not worth waking up the threads for a few headers, e.g. block announcements
+    if (nScriptCheckThreads == 0 || headers.size() < 16) {
+        HashX11Multi(headers.data(), headers.size(), hashesRet.data());
+        return;
+    }
+
+    // Each check hashes a group of headers, so the workers use the multi-lane X11 steps
+    std::vector<CBlockHeaderHashCheck> vChecks;
+    vChecks.reserve((headers.size() + X11_MULTI_LANES - 1) / X11_MULTI_LANES);
+    for (size_t i = 0; i < headers.size(); i += X11_MULTI_LANES) {
+        vChecks.emplace_back(&headers[i], std::min(X11_MULTI_LANES, headers.size() - i), &hashesRet[i]);
+    }
+    CCheckQueueControl<CBlockHeaderHashCheck> control(&headerhashqueue);
+    control.Add(vChecks);
+    control.Wait();
+}
+
+/** Reads a coin from the coins database, the result is written to the location passed on construction */
+class CCoinPrefetchCheck
+{
+private:
+    const COutPoint* poutpoint{nullptr};
+    Coin* pcoinRet{nullptr};
+
+public:
+    CCoinPrefetchCheck() = default;
+    CCoinPrefetchCheck(const COutPoint& outpoint, Coin& coinRet) : poutpoint(&outpoint), pcoinRet(&coinRet) {}
+
+    bool operator()()
+    {
+        try {
+            if (!pcoinsdbview->GetCoin(*poutpoint, *pcoinRet)) {
+                pcoinRet->Clear();
+            }
+        } catch (const std::runtime_error& e) {
+            // leave it to the regular lookup through pcoinsTip to handle the error
+            pcoinRet->Clear();
+        }
+        return true;
+    }
+
+    void swap(CCoinPrefetchCheck& check)
+    {
+        std::swap(poutpoint, check.poutpoint);
+        std::swap(pcoinRet, check.pcoinRet);
+    }
+};
+
+static CCheckQueue<CCoinPrefetchCheck> coinprefetchqueue(16);
+
+void ThreadCoinPrefetch() {
+    RenameThread("dash-coinpref");
+    coinprefetchqueue.Thread();
+}
+
+/**
+ * Reads the inputs of a block which aren't cached in pcoinsTip from the coins database in parallel, instead of one
+ * by one when ConnectBlock gets to them. Inputs created in the same block are skipped.
+ */
+static void PrefetchBlockInputs(const CBlock& block) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    AssertLockHeld(cs_main);
+
+    std::set<uint256> setBlockTxids;
+    for (const auto& tx : block.vtx) {
+        setBlockTxids.emplace(tx->GetHash());
+    }
+    std::vector<COutPoint> vOutPoints;
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        for (const auto& txin : block.vtx[i]->vin) {
+            if (setBlockTxids.count(txin.prevout.hash) || pcoinsTip->HaveCoinInCache(txin.prevout)) {
+                continue;
+            }
+            // Read already by coinsPrefetcher when the block was received
+            Coin coin;
+            if (coinsPrefetcher.TakeCoin(txin.prevout, coin)) {
+                pcoinsTip->AddFetchedCoin(txin.prevout, std::move(coin));
+                continue;
+            }
+            vOutPoints.emplace_back(txin.prevout);
+        }
+    }
+    // Not worth waking up the threads for a few inputs
+    if (nScriptCheckThreads == 0 || vOutPoints.size() < 16) {
+        return;
+    }
+
+    std::vector<Coin> vCoins(vOutPoints.size());
+    std::vector<CCoinPrefetchCheck> vChecks;
+    vChecks.reserve(vOutPoints.size());
+    for (size_t i = 0; i < vOutPoints.size(); i++) {
+        vChecks.emplace_back(vOutPoints[i], vCoins[i]);
+    }
+    CCheckQueueControl<CCoinPrefetchCheck> control(&coinprefetchqueue);
+    control.Add(vChecks);
+    control.Wait();
+
+    for (size_t i = 0; i < vOutPoints.size(); i++) {
+        pcoinsTip->AddFetchedCoin(vOutPoints[i], std::move(vCoins[i]));
+    }
+}
+
+/**
+ * Runs the context free checks of a transaction for CheckBlock, the result and the legacy sigop count are written to
+ * the locations passed on construction. Always succeeds, so that CheckBlock can report the first invalid transaction
+ * of the block as it does when checking serially.
+ */
+class CTransactionCheck
+{
+private:
+    const CTransaction* ptx{nullptr};
+    CValidationState* pstateRet{nullptr};
+    unsigned int* pnSigOpsRet{nullptr};
+
+public:
+    CTransactionCheck() = default;
+    CTransactionCheck(const CTransaction& tx, CValidationState& stateRet, unsigned int& nSigOpsRet) : ptx(&tx), pstateRet(&stateRet), pnSigOpsRet(&nSigOpsRet) {}
+
+    bool operator()()
+    {
+        if (CheckTransaction(*ptx, *pstateRet)) {
+            *pnSigOpsRet = GetLegacySigOpCount(*ptx);
+        }
+        return true;
+    }
+
+    void swap(CTransactionCheck& check)
+    {
+        std::swap(ptx, check.ptx);
+        std::swap(pstateRet, check.pstateRet);
+        std::swap(pnSigOpsRet, check.pnSigOpsRet);
+    }
+};
+
+static CCheckQueue<CTransactionCheck> txcheckqueue(32);
+
+void ThreadTransactionCheck() {
+    RenameThread("dash-txcheck");
+    txcheckqueue.Thread();
+}
+
+/**
+ * Runs CheckTransaction and counts the legacy sigops of all transactions of a block, on the transaction check threads
+ * if the block is large enough. Like the serial loop it replaces, stops at (and reports) the first invalid transaction.
+ */
+static bool CheckBlockTransactions(const CBlock& block, CValidationState& state, unsigned int& nSigOpsRet)
+{
+    nSigOpsRet = 0;
+
+    // Not worth waking up the threads for small blocks
+    if (nScriptCheckThreads == 0 || block.vtx.size() < MIN_PARALLEL_CHECKBLOCK_TXS) {
+        for (const auto& tx : block.vtx) {
+            if (!CheckTransaction(*tx, state))
+                return state.Invalid(false, state.GetRejectCode(), state.GetRejectReason(),
+                                     strprintf("Transaction check failed (tx hash %s) %s", tx->GetHash().ToString(), state.GetDebugMessage()));
+            nSigOpsRet += GetLegacySigOpCount(*tx);
+        }
+        return true;
+    }
+
+    std::vector<CValidationState> vStates(block.vtx.size());
+    std::vector<unsigned int> vSigOps(block.vtx.size(), 0);
+    std::vector<CTransactionCheck> vChecks;
+    vChecks.reserve(block.vtx.size());
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        vChecks.emplace_back(*block.vtx[i], vStates[i], vSigOps[i]);
+    }
+    CCheckQueueControl<CTransactionCheck> control(&txcheckqueue);
+    control.Add(vChecks);
+    control.Wait();
+
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        if (!vStates[i].IsValid()) {
+            state = vStates[i];
+            return state.Invalid(false, state.GetRejectCode(), state.GetRejectReason(),
+                                 strprintf("Transaction check failed (tx hash %s) %s", block.vtx[i]->GetHash().ToString(), state.GetDebugMessage()));
+        }
+        nSigOpsRet += vSigOps[i];
+    }
+    return true;
+}
+
+bool RunScriptChecks(std::vector<CScriptCheck>& vChecks)
+{
+    if (nScriptCheckThreads == 0) {
+        for (auto& check : vChecks) {
+            if (!check()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+    control.Add(vChecks);
+    return control.Wait();
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -2026,6 +2445,7 @@ static unsigned int GetBlockScriptFlags(const CBlockIndex* pindex, const Consens
 
 static int64_t nTimeCheck = 0;
 static int64_t nTimeForks = 0;
+static int64_t nTimePrefetch = 0;
 static int64_t nTimeVerify = 0;
 static int64_t nTimeISFilter = 0;
 static int64_t nTimeSubsidy = 0;
@@ -2043,13 +2463,14 @@ static int64_t nBlocksTotal = 0;
  *  Validity checks that depend on the UTXO set are also done; ConnectBlock()
  *  can fail if those validity checks fail (among other reasons). */
 bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex,
-                  CCoinsViewCache& view, const CChainParams& chainparams, bool fJustCheck)
+                  CCoinsViewCache& view, const CChainParams& chainparams, bool fJustCheck, CCoinsCommitment* pcommitment)
 {
     boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
 
     AssertLockHeld(cs_main);
     assert(pindex);
-    assert(*pindex->phashBlock == block.GetHash());
+    const uint256 block_hash = block.GetHash();
+    assert(*pindex->phashBlock == block_hash);
     int64_t nTimeStart = GetTimeMicros();
 
     // Check it again in case a previous version let a bad block in
@@ -2065,7 +2486,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     // is enforced in ContextualCheckBlockHeader(); we wouldn't want to
     // re-enforce that rule here (at least until we make it impossible for
     // GetAdjustedTime() to go backward).
-    if (!CheckBlock(block, state, chainparams.GetConsensus(), !fJustCheck, !fJustCheck)) {
+    if (!CheckBlock(block, state, chainparams.GetConsensus(), !fJustCheck, !fJustCheck, &block_hash)) {
         if (state.CorruptionPossible()) {
             // We don't write down blocks to disk if they may have been
             // corrupted, so this should be impossible unless we're having hardware
@@ -2093,7 +2514,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
     // Special case for the genesis block, skipping connection of its transactions
     // (its coinbase is unspendable)
-    if (block.GetHash() == chainparams.GetConsensus().hashGenesisBlock) {
+    if (block_hash == chainparams.GetConsensus().hashGenesisBlock) {
         if (!fJustCheck)
             view.SetBestBlock(pindex->GetBlockHash());
         return true;
@@ -2172,7 +2593,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     // make sure old budget is the real one
     if (pindex->nHeight == chainparams.GetConsensus().nSuperblockStartBlock &&
         chainparams.GetConsensus().nSuperblockStartHash != uint256() &&
-        block.GetHash() != chainparams.GetConsensus().nSuperblockStartHash)
+        block_hash != chainparams.GetConsensus().nSuperblockStartHash)
             return state.DoS(100, error("ConnectBlock(): invalid superblock start"),
                              REJECT_INVALID, "bad-sb-start");
 
@@ -2187,8 +2608,13 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     // Get the script flags for this block
     unsigned int flags = GetBlockScriptFlags(pindex, chainparams.GetConsensus());
 
-    int64_t nTime2 = GetTimeMicros(); nTimeForks += nTime2 - nTime1;
-    LogPrint(BCLog::BENCHMARK, "    - Fork checks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime2 - nTime1), nTimeForks * MICRO, nTimeForks * MILLI / nBlocksTotal);
+    int64_t nTime1_1 = GetTimeMicros(); nTimeForks += nTime1_1 - nTime1;
+    LogPrint(BCLog::BENCHMARK, "    - Fork checks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime1_1 - nTime1), nTimeForks * MICRO, nTimeForks * MILLI / nBlocksTotal);
+
+    PrefetchBlockInputs(block);
+
+    int64_t nTime2 = GetTimeMicros(); nTimePrefetch += nTime2 - nTime1_1;
+    LogPrint(BCLog::BENCHMARK, "    - Prefetch inputs: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime2 - nTime1_1), nTimePrefetch * MICRO, nTimePrefetch * MILLI / nBlocksTotal);
 
     CBlockUndo blockundo;
 
@@ -2199,35 +2625,27 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     int nInputs = 0;
     unsigned int nSigOps = 0;
     blockundo.vtxundo.reserve(block.vtx.size() - 1);
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
-    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
 
     std::vector<PrecomputedTransactionData> txdata;
     txdata.reserve(block.vtx.size()); // Required so that pointers to individual PrecomputedTransactionData don't get invalidated
 
     bool fDIP0001Active_context = pindex->nHeight >= Params().GetConsensus().DIP0001Height;
 
-    // MUST process special txes before updating UTXO to ensure consistency between mempool and block processing
-    if (!ProcessSpecialTxsInBlock(block, pindex, state, view, fJustCheck, fScriptChecks)) {
-        return error("ConnectBlock(DASH): ProcessSpecialTxsInBlock for block %s failed with %s",
-                     pindex->GetBlockHash().ToString(), FormatStateMessage(state));
-    }
-
-    int64_t nTime2_1 = GetTimeMicros(); nTimeProcessSpecial += nTime2_1 - nTime2;
-    LogPrint(BCLog::BENCHMARK, "      - ProcessSpecialTxsInBlock: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime2_1 - nTime2), nTimeProcessSpecial * MICRO, nTimeProcessSpecial * MILLI / nBlocksTotal);
+    // The UTXO changes of this block go to viewBlock first, so that the special txes can be processed on the UTXO set
+    // of before this block while the script checks run (see below).
+    CCoinsViewCache viewBlock(&view);
+    viewBlock.SetBestBlock(hashPrevBlock);
 
     for (unsigned int i = 0; i < block.vtx.size(); i++)
     {
         const CTransaction &tx = *(block.vtx[i]);
-        const uint256 txhash = tx.GetHash();
 
         nInputs += tx.vin.size();
 
         if (!tx.IsCoinBase())
         {
             CAmount txfee = 0;
-            if (!Consensus::CheckTxInputs(tx, state, view, pindex->nHeight, txfee)) {
+            if (!Consensus::CheckTxInputs(tx, state, viewBlock, pindex->nHeight, txfee)) {
                 return error("%s: Consensus::CheckTxInputs: %s, %s", __func__, tx.GetHash().ToString(), FormatStateMessage(state));
             }
             nFees += txfee;
@@ -2241,60 +2659,19 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
             // be in ConnectBlock because they require the UTXO set
             prevheights.resize(tx.vin.size());
             for (size_t j = 0; j < tx.vin.size(); j++) {
-                prevheights[j] = view.AccessCoin(tx.vin[j].prevout).nHeight;
+                prevheights[j] = viewBlock.AccessCoin(tx.vin[j].prevout).nHeight;
             }
 
             if (!SequenceLocks(tx, nLockTimeFlags, &prevheights, *pindex)) {
                 return state.DoS(100, error("%s: contains a non-BIP68-final transaction", __func__),
                                  REJECT_INVALID, "bad-txns-nonfinal");
             }
-
-            if (fAddressIndex || fSpentIndex)
-            {
-                for (size_t j = 0; j < tx.vin.size(); j++) {
-                    const CTxIn input = tx.vin[j];
-                    const Coin& coin = view.AccessCoin(tx.vin[j].prevout);
-                    const CTxOut &prevout = coin.out;
-                    uint160 hashBytes;
-                    int addressType;
-
-                    if (prevout.scriptPubKey.IsPayToScriptHash()) {
-                        hashBytes = uint160(std::vector<unsigned char>(prevout.scriptPubKey.begin()+2, prevout.scriptPubKey.begin()+22));
-                        addressType = 2;
-                    } else if (prevout.scriptPubKey.IsPayToPublicKeyHash()) {
-                        hashBytes = uint160(std::vector<unsigned char>(prevout.scriptPubKey.begin()+3, prevout.scriptPubKey.begin()+23));
-                        addressType = 1;
-                    } else if (prevout.scriptPubKey.IsPayToPublicKey()) {
-                        hashBytes = Hash160(prevout.scriptPubKey.begin()+1, prevout.scriptPubKey.end()-1);
-                        addressType = 1;
-                    } else {
-                        hashBytes.SetNull();
-                        addressType = 0;
-                    }
-
-                    if (fAddressIndex && addressType > 0) {
-                        // record spending activity
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(addressType, hashBytes, pindex->nHeight, i, txhash, j, true), prevout.nValue * -1));
-
-                        // remove address from unspent index
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(addressType, hashBytes, input.prevout.hash, input.prevout.n), CAddressUnspentValue()));
-                    }
-
-                    if (fSpentIndex) {
-                        // add the spent index to determine the txid and input that spent an output
-                        // and to find the amount and address from an input
-                        spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue(txhash, j, pindex->nHeight, prevout.nValue, addressType, hashBytes)));
-                    }
-                }
-
-            }
-
         }
 
         // GetTransactionSigOpCount counts 2 types of sigops:
         // * legacy (always)
         // * p2sh (when P2SH enabled in flags and excludes coinbase)
-        nSigOps += GetTransactionSigOpCount(tx, view, flags);
+        nSigOps += GetTransactionSigOpCount(tx, viewBlock, flags);
         if (nSigOps > MaxBlockSigOps(fDIP0001Active_context))
             return state.DoS(100, error("ConnectBlock(): too many sigops"),
                              REJECT_INVALID, "bad-blk-sigops");
@@ -2305,54 +2682,34 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
             std::vector<CScriptCheck> vChecks;
             bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
-            if (!CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults, fCacheResults, txdata[i], nScriptCheckThreads ? &vChecks : nullptr))
+            if (!CheckInputs(tx, state, viewBlock, fScriptChecks, flags, fCacheResults, fCacheResults, txdata[i], nScriptCheckThreads ? &vChecks : nullptr))
                 return error("ConnectBlock(): CheckInputs on %s failed with %s",
                     tx.GetHash().ToString(), FormatStateMessage(state));
             control.Add(vChecks);
         }
 
-        if (fAddressIndex) {
-            for (unsigned int k = 0; k < tx.vout.size(); k++) {
-                const CTxOut &out = tx.vout[k];
-
-                if (out.scriptPubKey.IsPayToScriptHash()) {
-                    std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+2, out.scriptPubKey.begin()+22);
-
-                    // record receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(2, uint160(hashBytes), pindex->nHeight, i, txhash, k, false), out.nValue));
-
-                    // record unspent output
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(2, uint160(hashBytes), txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
-
-                } else if (out.scriptPubKey.IsPayToPublicKeyHash()) {
-                    std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+3, out.scriptPubKey.begin()+23);
-
-                    // record receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(1, uint160(hashBytes), pindex->nHeight, i, txhash, k, false), out.nValue));
-
-                    // record unspent output
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, uint160(hashBytes), txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
-
-                } else if (out.scriptPubKey.IsPayToPublicKey()) {
-                    uint160 hashBytes(Hash160(out.scriptPubKey.begin()+1, out.scriptPubKey.end()-1));
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(1, hashBytes, pindex->nHeight, i, txhash, k, false), out.nValue));
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
-                } else {
-                    continue;
-                }
-
-            }
-        }
-
         CTxUndo undoDummy;
         if (i > 0) {
             blockundo.vtxundo.push_back(CTxUndo());
         }
-        UpdateCoins(tx, view, i == 0 ? undoDummy : blockundo.vtxundo.back(), pindex->nHeight);
+        UpdateCoins(tx, viewBlock, i == 0 ? undoDummy : blockundo.vtxundo.back(), pindex->nHeight);
     }
     int64_t nTime3 = GetTimeMicros(); nTimeConnect += nTime3 - nTime2;
     LogPrint(BCLog::BENCHMARK, "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs (%.2fms/blk)]\n", (unsigned)block.vtx.size(), MILLI * (nTime3 - nTime2), MILLI * (nTime3 - nTime2) / block.vtx.size(), nInputs <= 1 ? 0 : MILLI * (nTime3 - nTime2) / (nInputs-1), nTimeConnect * MICRO, nTimeConnect * MILLI / nBlocksTotal);
 
+    // Process the special txes while the script check threads verify the queued checks, they don't touch the views.
+    // MUST process special txes before updating UTXO to ensure consistency between mempool and block processing, view
+    // doesn't contain the changes of this block yet.
+    if (!ProcessSpecialTxsInBlock(block, pindex, state, view, fJustCheck, fScriptChecks)) {
+        return error("ConnectBlock(DASH): ProcessSpecialTxsInBlock for block %s failed with %s",
+                     pindex->GetBlockHash().ToString(), FormatStateMessage(state));
+    }
+    bool fFlushed = viewBlock.Flush();
+    assert(fFlushed);
+
+    int64_t nTime3_1 = GetTimeMicros(); nTimeProcessSpecial += nTime3_1 - nTime3;
+    LogPrint(BCLog::BENCHMARK, "      - ProcessSpecialTxsInBlock: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime3_1 - nTime3), nTimeProcessSpecial * MICRO, nTimeProcessSpecial * MILLI / nBlocksTotal);
+
     if (!control.Wait())
         return state.DoS(100, error("%s: CheckQueue failed", __func__), REJECT_INVALID, "block-validation-failed");
     int64_t nTime4 = GetTimeMicros(); nTimeVerify += nTime4 - nTime2;
@@ -2439,24 +2796,11 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     if (!WriteTxIndexDataForBlock(block, state, pindex))
         return false;
 
-    if (fAddressIndex) {
-        if (!pblocktree->WriteAddressIndex(addressIndex)) {
-            return AbortNode(state, "Failed to write address index");
-        }
-
-        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
-            return AbortNode(state, "Failed to write address unspent index");
-        }
+    if (pcommitment) {
+        pcommitment->ConnectBlock(block, blockundo, pindex->nHeight);
+        pcommitment->hashBlock = pindex->GetBlockHash();
     }
 
-    if (fSpentIndex)
-        if (!pblocktree->UpdateSpentIndex(spentIndex))
-            return AbortNode(state, "Failed to write transaction index");
-
-    if (fTimestampIndex)
-        if (!pblocktree->WriteTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())))
-            return AbortNode(state, "Failed to write timestamp index");
-
     assert(pindex->phashBlock);
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
@@ -2541,8 +2885,10 @@ bool static FlushStateToDisk(const CChainParams& chainparams, CValidationState &
         bool fPeriodicWrite = mode == FlushStateMode::PERIODIC && nNow > nLastWrite + (int64_t)DATABASE_WRITE_INTERVAL * 1000000;
         // It's been very long since we flushed the cache. Do this infrequently, to optimize cache usage.
         bool fPeriodicFlush = mode == FlushStateMode::PERIODIC && nNow > nLastFlush + (int64_t)DATABASE_FLUSH_INTERVAL * 1000000;
+        // The previous flush is still being written in the background, don't wait for it unless we have to.
+        bool fWritePending = pcoinsdbview->IsWritePending();
         // Combine all conditions that result in a full cache flush.
-        fDoFullFlush = (mode == FlushStateMode::ALWAYS) || fCacheLarge || fCacheCritical || fPeriodicFlush || fFlushForPrune;
+        fDoFullFlush = (mode == FlushStateMode::ALWAYS) || fCacheCritical || fFlushForPrune || (!fWritePending && (fCacheLarge || fPeriodicFlush));
         // Write blocks and block index to disk.
         if (fDoFullFlush || fPeriodicWrite) {
             // Depend on nMinDiskSpace to ensure we can write block index
@@ -2583,11 +2929,29 @@ bool static FlushStateToDisk(const CChainParams& chainparams, CValidationState &
             if (!CheckDiskSpace(48 * 2 * 2 * pcoinsTip->GetCacheSize()))
                 return state.Error("out of disk space");
             // Flush the chainstate (which may refer to block index entries).
-            if (!pcoinsTip->Flush())
+            // With background writes, this only marks the coin database as being in transition to the new tip and
+            // hands the coins over to the writer thread (see CCoinsViewDB). EvoDB is committed after that, so that
+            // ReplayBlocks() recovers the coins to the same block if we crash before the write finished.
+            // Coins read by coinsPrefetcher before or while pcoinsTip is flushed might be outdated afterwards.
+            // Unless we're shutting down, recently used coins stay in the cache, so that blocks connected after the
+            // flush don't have to read all their inputs from disk.
+            coinsPrefetcher.Invalidate();
+            bool fFlushed = (mode != FlushStateMode::ALWAYS && nCoinCacheKeepUsage > 0) ? pcoinsTip->FlushAndTrim(nCoinCacheKeepUsage) : pcoinsTip->Flush();
+            coinsPrefetcher.Invalidate();
+            if (!fFlushed)
                 return AbortNode(state, "Failed to write to coin database");
             if (!evoDb->CommitRootTransaction()) {
                 return AbortNode(state, "Failed to commit EvoDB");
             }
+            // Not atomic with the coins, the commitment is recalculated on startup if its block doesn't match
+            if (g_coins_commitment && !pcoinsdbview->WriteCommitment(*g_coins_commitment)) {
+                return AbortNode(state, "Failed to write UTXO set commitment");
+            }
+            // Callers asking for a full flush expect the coins to be on disk, and pruned block files can't be
+            // replayed anymore
+            if ((mode == FlushStateMode::ALWAYS || fFlushForPrune) && !pcoinsdbview->WaitForPendingWrite()) {
+                return AbortNode(state, "Failed to write to coin database");
+            }
             nLastFlush = nNow;
         }
     }
@@ -2718,11 +3082,17 @@ bool CChainState::DisconnectTip(CValidationState& state, const CChainParams& cha
 
         CCoinsViewCache view(pcoinsTip.get());
         assert(view.GetBestBlock() == pindexDelete->GetBlockHash());
-        if (DisconnectBlock(block, pindexDelete, view) != DISCONNECT_OK)
+        // only replaced if the block is disconnected
+        std::unique_ptr<CCoinsCommitment> commitment = g_coins_commitment ? MakeUnique<CCoinsCommitment>(*g_coins_commitment) : nullptr;
+        if (DisconnectBlock(block, pindexDelete, view, commitment.get()) != DISCONNECT_OK)
             return error("DisconnectTip(): DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
         bool flushed = view.Flush();
         assert(flushed);
         dbTx->Commit();
+        if (commitment) {
+            commitment->hashBlock = pindexDelete->pprev->GetBlockHash();
+            g_coins_commitment = std::move(commitment);
+        }
     }
     LogPrint(BCLog::BENCHMARK, "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * MILLI);
     // Write the chain state to disk, if necessary.
@@ -2852,7 +3222,8 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
         auto dbTx = evoDb->BeginTransaction();
 
         CCoinsViewCache view(pcoinsTip.get());
-        bool rv = ConnectBlock(blockConnecting, state, pindexNew, view, chainparams);
+        std::unique_ptr<CCoinsCommitment> commitment = g_coins_commitment ? MakeUnique<CCoinsCommitment>(*g_coins_commitment) : nullptr;
+        bool rv = ConnectBlock(blockConnecting, state, pindexNew, view, chainparams, false, commitment.get());
         GetMainSignals().BlockChecked(blockConnecting, state);
         if (!rv) {
             if (state.IsInvalid())
@@ -2864,6 +3235,9 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
         bool flushed = view.Flush();
         assert(flushed);
         dbTx->Commit();
+        if (commitment) {
+            g_coins_commitment = std::move(commitment);
+        }
     }
     int64_t nTime4 = GetTimeMicros(); nTimeFlush += nTime4 - nTime3;
     LogPrint(BCLog::BENCHMARK, "  - Flush: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime4 - nTime3) * MILLI, nTimeFlush * MICRO, nTimeFlush * MILLI / nBlocksTotal);
@@ -2965,6 +3339,70 @@ void CChainState::PruneBlockIndexCandidates() {
     assert(!setBlockIndexCandidates.empty());
 }
 
+/**
+ * Reads the blocks ActivateBestChainStep is about to connect from disk on a separate thread, so that reading and
+ * deserializing them overlaps with connecting the previous ones. This matters during -reindex(-chainstate), where
+ * every block is connected from disk. ActivateBestChainStep usually returns after connecting a single block, so the
+ * reads are kept across calls.
+ */
+class CBlockReadAhead
+{
+private:
+    typedef std::shared_future<std::shared_ptr<const CBlock>> BlockFuture;
+
+    ctpl::thread_pool pool;
+    std::map<uint256, BlockFuture> mapReads GUARDED_BY(cs_main);
+
+public:
+    /** Starts reading the blocks in vpindex which aren't read yet and drops the reads of blocks not in vpindex */
+    void Prefetch(const std::vector<CBlockIndex*>& vpindex, const Consensus::Params& consensusParams) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+    {
+        AssertLockHeld(cs_main);
+        if (pool.size() == 0) {
+            pool.resize(1);
+            RenameThreadPool(pool, "dash-blkread");
+        }
+
+        std::map<uint256, BlockFuture> mapReadsNew;
+        for (const CBlockIndex* pindex : vpindex) {
+            if (!(pindex->nStatus & BLOCK_HAVE_DATA)) {
+                continue;
+            }
+            const uint256 hash = pindex->GetBlockHash();
+            auto it = mapReads.find(hash);
+            if (it != mapReads.end()) {
+                mapReadsNew.emplace(hash, it->second);
+                continue;
+            }
+            const CDiskBlockPos pos = pindex->GetBlockPos();
+            BlockFuture future = pool.push([pos, hash, &consensusParams](int threadId) {
+                auto pblock = std::make_shared<CBlock>();
+                if (!ReadBlockFromDisk(*pblock, pos, consensusParams) || pblock->GetHash() != hash) {
+                    return std::shared_ptr<const CBlock>();
+                }
+                return std::shared_ptr<const CBlock>(pblock);
+            }).share();
+            mapReadsNew.emplace(hash, future);
+        }
+        mapReads = std::move(mapReadsNew);
+    }
+
+    /** Waits for the read of pindex, returns nullptr if it wasn't prefetched or couldn't be read, ConnectTip reads it again then */
+    std::shared_ptr<const CBlock> Take(const CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+    {
+        AssertLockHeld(cs_main);
+        auto it = mapReads.find(pindex->GetBlockHash());
+        if (it == mapReads.end()) {
+            return nullptr;
+        }
+        BlockFuture future = it->second;
+        mapReads.erase(it);
+        return future.get();
+    }
+};
+
+static CBlockReadAhead blockReadAhead;
+
 /**
  * Try to make some progress towards making pindexMostWork the active block.
  * pblock is either nullptr or a pointer to a CBlock corresponding to pindexMostWork.
@@ -3005,13 +3443,25 @@ bool CChainState::ActivateBestChainStep(CValidationState& state, const CChainPar
         }
         nHeight = nTargetHeight;
 
+        std::reverse(vpindexToConnect.begin(), vpindexToConnect.end());
+        if (vpindexToConnect.size() > 1) {
+            blockReadAhead.Prefetch(vpindexToConnect, chainparams.GetConsensus());
+        }
+
         // Connect new blocks.
-        for (CBlockIndex *pindexConnect : reverse_iterate(vpindexToConnect)) {
-            if (!ConnectTip(state, chainparams, pindexConnect, pindexConnect == pindexMostWork ? pblock : std::shared_ptr<const CBlock>(), connectTrace, disconnectpool)) {
+        for (CBlockIndex *pindexConnect : vpindexToConnect) {
+            std::shared_ptr<const CBlock> pblockConnect;
+            if (pindexConnect == pindexMostWork) {
+                pblockConnect = pblock;
+            }
+            if (!pblockConnect) {
+                pblockConnect = blockReadAhead.Take(pindexConnect);
+            }
+            if (!ConnectTip(state, chainparams, pindexConnect, pblockConnect, connectTrace, disconnectpool)) {
                 if (state.IsInvalid()) {
                     // The block violates a consensus rule.
                     if (!state.CorruptionPossible()) {
-                        InvalidChainFound(vpindexToConnect.front());
+                        InvalidChainFound(vpindexToConnect.back());
                     }
                     state = CValidationState();
                     fInvalidFound = true;
@@ -3044,7 +3494,7 @@ bool CChainState::ActivateBestChainStep(CValidationState& state, const CChainPar
 
     // Callbacks/notifications for a new best chain.
     if (fInvalidFound)
-        CheckForkWarningConditionsOnNewFork(vpindexToConnect.back());
+        CheckForkWarningConditionsOnNewFork(vpindexToConnect.front());
     else
         CheckForkWarningConditions();
 
@@ -3099,6 +3549,7 @@ bool CChainState::ActivateBestChain(CValidationState &state, const CChainParams&
     CBlockIndex *pindexMostWork = nullptr;
     CBlockIndex *pindexNewTip = nullptr;
     int nStopAtHeight = gArgs.GetArg("-stopatheight", DEFAULT_STOPATHEIGHT);
+    const uint256 hashBlock = pblock ? pblock->GetHash() : uint256();
     do {
         boost::this_thread::interruption_point();
 
@@ -3130,7 +3581,7 @@ bool CChainState::ActivateBestChain(CValidationState &state, const CChainParams&
 
             bool fInvalidFound = false;
             std::shared_ptr<const CBlock> nullBlockPtr;
-            if (!ActivateBestChainStep(state, chainparams, pindexMostWork, pblock && pblock->GetHash() == pindexMostWork->GetBlockHash() ? pblock : nullBlockPtr, fInvalidFound, connectTrace))
+            if (!ActivateBestChainStep(state, chainparams, pindexMostWork, pblock && hashBlock == pindexMostWork->GetBlockHash() ? pblock : nullBlockPtr, fInvalidFound, connectTrace))
                 return false;
 
             if (fInvalidFound) {
@@ -3427,13 +3878,13 @@ bool ResetBlockFailureFlags(CBlockIndex *pindex) {
     return g_chainstate.ResetBlockFailureFlags(pindex);
 }
 
-CBlockIndex* CChainState::AddToBlockIndex(const CBlockHeader& block, enum BlockStatus nStatus)
+CBlockIndex* CChainState::AddToBlockIndex(const CBlockHeader& block, enum BlockStatus nStatus, const uint256* pHash)
 {
     assert(!(nStatus & BLOCK_FAILED_MASK)); // no failed blocks alowed
     AssertLockHeld(cs_main);
 
     // Check for duplicate
-    uint256 hash = block.GetHash();
+    uint256 hash = pHash ? *pHash : block.GetHash();
     BlockMap::iterator it = mapBlockIndex.find(hash);
     if (it != mapBlockIndex.end())
         return it->second;
@@ -3608,16 +4059,16 @@ static bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos,
     return true;
 }
 
-static bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true)
+static bool CheckBlockHeader(const CBlockHeader& block, const uint256& hash, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true)
 {
     // Check proof of work matches claimed amount
-    if (fCheckPOW && !CheckProofOfWork(block.GetHash(), block.nBits, consensusParams))
+    if (fCheckPOW && !CheckProofOfWork(hash, block.nBits, consensusParams))
         return state.DoS(50, false, REJECT_INVALID, "high-hash", false, "proof of work failed");
 
     // Check DevNet
     if (!consensusParams.hashDevnetGenesisBlock.IsNull() &&
             block.hashPrevBlock == consensusParams.hashGenesisBlock &&
-            block.GetHash() != consensusParams.hashDevnetGenesisBlock) {
+            hash != consensusParams.hashDevnetGenesisBlock) {
         return state.DoS(100, error("CheckBlockHeader(): wrong devnet genesis"),
                          REJECT_INVALID, "devnet-genesis");
     }
@@ -3625,7 +4076,7 @@ static bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state,
     return true;
 }
 
-bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW, bool fCheckMerkleRoot)
+bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW, bool fCheckMerkleRoot, const uint256* pHash)
 {
     // These are checks that are independent of context.
 
@@ -3636,7 +4087,7 @@ bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::P
 
     // Check that the header is valid (particularly PoW).  This is mostly
     // redundant with the call in AcceptBlockHeader.
-    if (!CheckBlockHeader(block, state, consensusParams, fCheckPOW))
+    if (!CheckBlockHeader(block, pHash ? *pHash : block.GetHash(), state, consensusParams, fCheckPOW))
         return false;
 
     // Check the merkle root.
@@ -3669,16 +4120,10 @@ bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::P
             return state.DoS(100, false, REJECT_INVALID, "bad-cb-multiple", false, "more than one coinbase");
 
     // Check transactions
-    for (const auto& tx : block.vtx)
-        if (!CheckTransaction(*tx, state))
-            return state.Invalid(false, state.GetRejectCode(), state.GetRejectReason(),
-                                 strprintf("Transaction check failed (tx hash %s) %s", tx->GetHash().ToString(), state.GetDebugMessage()));
-
     unsigned int nSigOps = 0;
-    for (const auto& tx : block.vtx)
-    {
-        nSigOps += GetLegacySigOpCount(*tx);
-    }
+    if (!CheckBlockTransactions(block, state, nSigOps))
+        return false;
+
     // sigops limits (relaxed)
     if (nSigOps > MaxBlockSigOps())
         return state.DoS(100, false, REJECT_INVALID, "bad-blk-sigops", false, "out-of-bounds SigOpCount");
@@ -3817,11 +4262,11 @@ static bool ContextualCheckBlock(const CBlock& block, CValidationState& state, c
     return true;
 }
 
-bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, const uint256* pHash)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
-    uint256 hash = block.GetHash();
+    uint256 hash = pHash ? *pHash : block.GetHash();
     BlockMap::iterator miSelf = mapBlockIndex.find(hash);
     CBlockIndex *pindex = nullptr;
 
@@ -3839,7 +4284,7 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, chainparams.GetConsensus()))
+        if (!CheckBlockHeader(block, hash, state, chainparams.GetConsensus()))
             return error("%s: Consensus::CheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
 
         // Get prev block index
@@ -3880,13 +4325,13 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
 
         if (llmq::chainLocksHandler->HasConflictingChainLock(pindexPrev->nHeight + 1, hash)) {
             if (pindex == nullptr) {
-                AddToBlockIndex(block, BLOCK_CONFLICT_CHAINLOCK);
+                AddToBlockIndex(block, BLOCK_CONFLICT_CHAINLOCK, &hash);
             }
             return state.DoS(10, error("%s: header %s conflicts with chainlock", __func__, hash.ToString()), REJECT_INVALID, "bad-chainlock");
         }
     }
     if (pindex == nullptr)
-        pindex = AddToBlockIndex(block);
+        pindex = AddToBlockIndex(block, BLOCK_VALID_TREE, &hash);
 
     if (ppindex)
         *ppindex = pindex;
@@ -3900,14 +4345,23 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
 }
 
 // Exposed wrapper for AcceptBlockHeader
-bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, CBlockHeader *first_invalid)
+bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, CBlockHeader *first_invalid, const std::vector<uint256>* pHashes)
 {
     if (first_invalid != nullptr) first_invalid->SetNull();
+
+    // X11 is expensive, hash all headers in parallel and only once before taking cs_main
+    std::vector<uint256> vHashes;
+    if (pHashes == nullptr || pHashes->size() != headers.size()) {
+        CalculateBlockHeaderHashes(headers, vHashes);
+        pHashes = &vHashes;
+    }
+
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        for (size_t i = 0; i < headers.size(); i++) {
+            const CBlockHeader& header = headers[i];
             CBlockIndex *pindex = nullptr; // Use a temp pindex instead of ppindex to avoid a const_cast
-            if (!g_chainstate.AcceptBlockHeader(header, state, chainparams, &pindex)) {
+            if (!g_chainstate.AcceptBlockHeader(header, state, chainparams, &pindex, &(*pHashes)[i])) {
                 if (first_invalid) *first_invalid = header;
                 return false;
             }
@@ -3940,7 +4394,7 @@ static CDiskBlockPos SaveBlockToDisk(const CBlock& block, int nHeight, const CCh
 }
 
 /** Store block on disk. If dbp is non-nullptr, the file is known to already reside on disk */
-bool CChainState::AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, bool* fNewBlock)
+bool CChainState::AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, bool* fNewBlock, const uint256* pHash)
 {
     boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
 
@@ -3952,7 +4406,7 @@ bool CChainState::AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CVali
     CBlockIndex *pindexDummy = nullptr;
     CBlockIndex *&pindex = ppindex ? *ppindex : pindexDummy;
 
-    if (!AcceptBlockHeader(block, state, chainparams, &pindex))
+    if (!AcceptBlockHeader(block, state, chainparams, &pindex, pHash))
         return false;
 
     // Try to process all requested blocks that we don't have, but only
@@ -3987,7 +4441,7 @@ bool CChainState::AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CVali
         if (pindex->nChainWork < nMinimumChainWork) return true;
     }
 
-    if (!CheckBlock(block, state, chainparams.GetConsensus()) ||
+    if (!CheckBlock(block, state, chainparams.GetConsensus(), true, true, pindex->phashBlock) ||
         !ContextualCheckBlock(block, state, chainparams.GetConsensus(), pindex->pprev)) {
         if (state.IsInvalid() && !state.CorruptionPossible()) {
             pindex->nStatus |= BLOCK_FAILED_VALID;
@@ -4035,20 +4489,29 @@ bool ProcessNewBlock(const CChainParams& chainparams, const std::shared_ptr<cons
         CBlockIndex *pindex = nullptr;
         if (fNewBlock) *fNewBlock = false;
         CValidationState state;
+        // X11 is expensive, hash the block only once for all the checks below
+        const uint256 hash = pblock->GetHash();
         // Ensure that CheckBlock() passes before calling AcceptBlock, as
         // belt-and-suspenders.
-        bool ret = CheckBlock(*pblock, state, chainparams.GetConsensus());
+        bool ret = CheckBlock(*pblock, state, chainparams.GetConsensus(), true, true, &hash);
 
         LOCK(cs_main);
 
+        bool fNewBlockStored = false;
         if (ret) {
             // Store to disk
-            ret = g_chainstate.AcceptBlock(pblock, state, chainparams, &pindex, fForceProcessing, nullptr, fNewBlock);
+            ret = g_chainstate.AcceptBlock(pblock, state, chainparams, &pindex, fForceProcessing, nullptr, &fNewBlockStored, &hash);
         }
+        if (fNewBlock) *fNewBlock = fNewBlockStored;
         if (!ret) {
             GetMainSignals().BlockChecked(*pblock, state);
             return error("%s: AcceptBlock FAILED: %s", __func__, FormatStateMessage(state));
         }
+        // During IBD blocks are often received before their parents are connected, start reading their inputs
+        // already. The next block is connected right away and reads its inputs itself (see PrefetchBlockInputs).
+        if (fNewBlockStored && pindex->pprev != chainActive.Tip() && IsInitialBlockDownload()) {
+            coinsPrefetcher.PrefetchBlock(*pblock, *pcoinsTip);
+        }
     }
 
     NotifyHeaderTip();
@@ -4329,7 +4792,24 @@ CBlockIndex * CChainState::InsertBlockIndex(const uint256& hash)
 
 bool CChainState::LoadBlockIndex(const Consensus::Params& consensus_params, CBlockTreeDB& blocktree)
 {
-    if (!blocktree.LoadBlockIndexGuts(consensus_params, [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); }))
+    auto insertBlockIndex = [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); };
+
+    // Reading the flat file written on the last clean shutdown is much faster than iterating the database
+    bool fFromCache = false;
+    if (mapBlockIndex.empty()) {
+        int64_t nStart = GetTimeMillis();
+        fFromCache = blocktree.LoadBlockIndexCache(consensus_params, insertBlockIndex, [this](size_t nCount) { mapBlockIndex.reserve(nCount); });
+        if (fFromCache) {
+            LogPrintf("%s: loaded %u block indexes from cache in %dms\n", __func__, mapBlockIndex.size(), GetTimeMillis() - nStart);
+        } else {
+            // Drop whatever was loaded from a broken cache
+            for (const auto& p : mapBlockIndex) {
+                delete p.second;
+            }
+            mapBlockIndex.clear();
+        }
+    }
+    if (!fFromCache && !blocktree.LoadBlockIndexGuts(consensus_params, insertBlockIndex))
         return false;
 
     boost::this_thread::interruption_point();
@@ -4438,18 +4918,6 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams) EXCLUSIVE_LOCKS_RE
     pblocktree->ReadFlag("txindex", fTxIndex);
     LogPrintf("%s: transaction index %s\n", __func__, fTxIndex ? "enabled" : "disabled");
 
-    // Check whether we have an address index
-    pblocktree->ReadFlag("addressindex", fAddressIndex);
-    LogPrintf("%s: address index %s\n", __func__, fAddressIndex ? "enabled" : "disabled");
-
-    // Check whether we have a timestamp index
-    pblocktree->ReadFlag("timestampindex", fTimestampIndex);
-    LogPrintf("%s: timestamp index %s\n", __func__, fTimestampIndex ? "enabled" : "disabled");
-
-    // Check whether we have a spent index
-    pblocktree->ReadFlag("spentindex", fSpentIndex);
-    LogPrintf("%s: spent index %s\n", __func__, fSpentIndex ? "enabled" : "disabled");
-
     return true;
 }
 
@@ -4486,6 +4954,222 @@ bool LoadChainTip(const CChainParams& chainparams)
     return true;
 }
 
+bool LoadCoinsCommitment()
+{
+    LOCK(cs_main);
+
+    // The commitment on disk is for the coins database, so it can't be compared with unflushed coins
+    g_coins_commitment.reset();
+    FlushStateToDisk();
+
+    const uint256 hashBestBlock = pcoinsdbview->GetBestBlock();
+    std::unique_ptr<CCoinsCommitment> commitment = MakeUnique<CCoinsCommitment>();
+    if (hashBestBlock.IsNull()) {
+        // no coins yet, the commitment of the empty set is updated when the genesis block is connected
+    } else if (pcoinsdbview->ReadCommitment(*commitment) && commitment->hashBlock == hashBestBlock) {
+        LogPrintf("%s: loaded UTXO set commitment of block %s\n", __func__, hashBestBlock.ToString());
+    } else {
+        LogPrintf("%s: calculating UTXO set commitment of block %s...\n", __func__, hashBestBlock.ToString());
+        int64_t nStart = GetTimeMillis();
+        CCoinsStats stats;
+        *commitment = CCoinsCommitment();
+        if (!GetUTXOStatsParallel(pcoinsdbview.get(), stats, commitment.get(), GetNumCores())) {
+            return error("%s: unable to calculate the UTXO set commitment", __func__);
+        }
+        if (!pcoinsdbview->WriteCommitment(*commitment)) {
+            return error("%s: unable to write the UTXO set commitment", __func__);
+        }
+        LogPrintf("%s: calculated UTXO set commitment of %u coins in %dms\n", __func__, commitment->nTransactionOutputs, GetTimeMillis() - nStart);
+    }
+    g_coins_commitment = std::move(commitment);
+    return true;
+}
+
+namespace {
+
+/** A block of the active chain which is checked by CheckBlockFiles, copied so that cs_main is not needed */
+struct BlockFilesCheck {
+    int nHeight;
+    uint256 hash;
+    uint256 hashPrev;
+    CDiskBlockPos pos;
+    CDiskBlockPos undoPos;
+};
+
+CCriticalSection cs_verifydb_status;
+CVerifyDBStatus verifyDBStatus GUARDED_BY(cs_verifydb_status);
+
+} // namespace
+
+/** Collects the last nCheckDepth blocks of the active chain, starting at the tip, and stops at pruned blocks */
+static void CollectBlockFilesChecks(int nCheckDepth, std::vector<BlockFilesCheck>& vChecks) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    AssertLockHeld(cs_main);
+    if (nCheckDepth <= 0 || nCheckDepth > chainActive.Height())
+        nCheckDepth = chainActive.Height();
+    vChecks.reserve(nCheckDepth);
+    for (const CBlockIndex* pindex = chainActive.Tip(); pindex && pindex->pprev; pindex = pindex->pprev) {
+        if (pindex->nHeight <= chainActive.Height() - nCheckDepth)
+            break;
+        if (fPruneMode && !(pindex->nStatus & BLOCK_HAVE_DATA)) {
+            // If pruning, only go back as far as we have data.
+            LogPrintf("VerifyDB(): block verification stopping at height %d (pruning, no data)\n", pindex->nHeight);
+            break;
+        }
+        vChecks.push_back({pindex->nHeight, pindex->GetBlockHash(), pindex->pprev->GetBlockHash(), pindex->GetBlockPos(), pindex->GetUndoPos()});
+    }
+}
+
+/** Check levels 0-2 of CVerifyDB for one block */
+static bool CheckBlockFiles(const BlockFilesCheck& check, int nCheckLevel, const Consensus::Params& consensusParams, std::string& strErrorRet)
+{
+    CBlock block;
+    // check level 0: read from disk
+    if (!ReadBlockFromDisk(block, check.pos, consensusParams) || block.GetHash() != check.hash) {
+        strErrorRet = "ReadBlockFromDisk failed";
+        return false;
+    }
+    // check level 1: verify block validity
+    CValidationState state;
+    if (nCheckLevel >= 1 && !CheckBlock(block, state, consensusParams)) {
+        strErrorRet = strprintf("found bad block (%s)", FormatStateMessage(state));
+        return false;
+    }
+    // check level 2: verify undo validity
+    if (nCheckLevel >= 2 && !check.undoPos.IsNull()) {
+        CBlockUndo undo;
+        if (!UndoReadFromDisk(undo, check.undoPos, check.hashPrev)) {
+            strErrorRet = "found bad undo data";
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Runs CheckBlockFiles for vChecks on nThreads threads (in the calling thread if nThreads <= 1), calling progress with
+ * the number of checked blocks in between. Returns false and sets nFailedRet to the first failing entry if a check
+ * failed. Stops early when a shutdown is requested.
+ */
+static bool CheckBlockFilesParallel(const std::vector<BlockFilesCheck>& vChecks, int nCheckLevel, int nThreads, const Consensus::Params& consensusParams, const std::function<void(size_t)>& progress, size_t& nFailedRet, std::string& strErrorRet)
+{
+    std::atomic<size_t> nNext{0};
+    std::atomic<size_t> nChecked{0};
+    std::atomic<size_t> nFirstFailed{vChecks.size()};
+    CCriticalSection cs_error;
+    std::string strFirstError;
+
+    auto worker = [&]() {
+        while (!ShutdownRequested()) {
+            size_t n = nNext++;
+            // blocks behind a failed one don't matter anymore
+            if (n >= vChecks.size() || n > nFirstFailed) {
+                break;
+            }
+            std::string strError;
+            if (!CheckBlockFiles(vChecks[n], nCheckLevel, consensusParams, strError)) {
+                LOCK(cs_error);
+                if (n < nFirstFailed) {
+                    nFirstFailed = n;
+                    strFirstError = strError;
+                }
+            }
+            nChecked++;
+        }
+    };
+
+    if (nThreads <= 1) {
+        worker();
+    } else {
+        ctpl::thread_pool pool(nThreads);
+        RenameThreadPool(pool, "dash-verifydb");
+        std::vector<std::future<void>> vFutures;
+        for (int i = 0; i < nThreads; i++) {
+            vFutures.emplace_back(pool.push([&](int threadId) { worker(); }));
+        }
+        for (auto& f : vFutures) {
+            while (f.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready) {
+                progress(nChecked);
+            }
+        }
+    }
+    progress(nChecked);
+
+    LOCK(cs_error);
+    if (nFirstFailed < vChecks.size()) {
+        nFailedRet = nFirstFailed;
+        strErrorRet = strFirstError;
+        return false;
+    }
+    return true;
+}
+
+CVerifyDBStatus GetBackgroundVerifyDBStatus()
+{
+    LOCK(cs_verifydb_status);
+    return verifyDBStatus;
+}
+
+void ThreadVerifyDB(int nCheckLevel, int nCheckDepth, bool fShutdownOnFailure)
+{
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+    std::vector<BlockFilesCheck> vChecks;
+    {
+        LOCK(cs_main);
+        CollectBlockFilesChecks(nCheckDepth, vChecks);
+    }
+    {
+        LOCK(cs_verifydb_status);
+        verifyDBStatus.fRunning = true;
+        verifyDBStatus.nCheckLevel = nCheckLevel;
+        verifyDBStatus.nBlocksTotal = vChecks.size();
+    }
+    LogPrintf("%s: verifying last %u blocks at level %i in the background\n", __func__, vChecks.size(), nCheckLevel);
+
+    int64_t nStart = GetTimeMillis();
+    size_t nFailed;
+    std::string strError;
+    bool fOk = CheckBlockFilesParallel(vChecks, nCheckLevel, std::max(1, nScriptCheckThreads), consensusParams, [](size_t nChecked) {
+        LOCK(cs_verifydb_status);
+        verifyDBStatus.nBlocksChecked = nChecked;
+    }, nFailed, strError);
+
+    if (!fOk) {
+        // The block might have been pruned in the meantime
+        LOCK(cs_main);
+        const CBlockIndex* pindex = LookupBlockIndex(vChecks[nFailed].hash);
+        if (pindex == nullptr || !(pindex->nStatus & BLOCK_HAVE_DATA)) {
+            LogPrintf("%s: block verification stopping at height %d (pruning, no data)\n", __func__, vChecks[nFailed].nHeight);
+            fOk = true;
+        }
+    }
+
+    {
+        LOCK(cs_verifydb_status);
+        verifyDBStatus.fRunning = false;
+        verifyDBStatus.fDone = !ShutdownRequested();
+        if (!fOk) {
+            verifyDBStatus.nFailedHeight = vChecks[nFailed].nHeight;
+            verifyDBStatus.strError = strError;
+        }
+    }
+    if (fOk) {
+        LogPrintf("%s: verified %u blocks in %dms\n", __func__, vChecks.size(), GetTimeMillis() - nStart);
+        return;
+    }
+
+    std::string strMessage = strprintf("Background block verification %s at height %d, hash=%s. Please restart with -reindex.",
+                                       strError, vChecks[nFailed].nHeight, vChecks[nFailed].hash.ToString());
+    if (fShutdownOnFailure) {
+        AbortNode(strMessage, _("Corrupted block database detected"));
+    } else {
+        SetMiscWarning(strMessage);
+        LogPrintf("*** %s\n", strMessage);
+        uiInterface.ThreadSafeMessageBox(_("Corrupted block database detected") + "\n" + _("Please restart with -reindex or -reindex-chainstate to recover."),
+                                         "", CClientUIInterface::MSG_WARNING);
+    }
+}
+
 CVerifyDB::CVerifyDB()
 {
     uiInterface.ShowProgress(_("Verifying blocks..."), 0, false);
@@ -4510,6 +5194,32 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
         nCheckDepth = chainActive.Height();
     nCheckLevel = std::max(0, std::min(4, nCheckLevel));
     LogPrintf("Verifying last %i blocks at level %i\n", nCheckDepth, nCheckLevel);
+
+    // Levels 0-2 only look at each block on its own, so they can be checked in parallel
+    if (nCheckLevel <= 2) {
+        std::vector<BlockFilesCheck> vChecks;
+        CollectBlockFilesChecks(nCheckDepth, vChecks);
+        int reportDone = 0;
+        LogPrintf("[0%%]..."); /* Continued */
+        size_t nFailed;
+        std::string strError;
+        bool fOk = CheckBlockFilesParallel(vChecks, nCheckLevel, nScriptCheckThreads, chainparams.GetConsensus(), [&](size_t nChecked) {
+            int percentageDone = std::max(1, std::min(99, (int)((double)nChecked / (double)nCheckDepth * 100)));
+            if (reportDone < percentageDone/10) {
+                // report every 10% step
+                LogPrintf("[%d%%]...", percentageDone); /* Continued */
+                reportDone = percentageDone/10;
+            }
+            uiInterface.ShowProgress(_("Verifying blocks..."), percentageDone, false);
+        }, nFailed, strError);
+        if (!fOk) {
+            return error("VerifyDB(): *** %s at %d, hash=%s", strError, vChecks[nFailed].nHeight, vChecks[nFailed].hash.ToString());
+        }
+        LogPrintf("[DONE].\n");
+        LogPrintf("No coin database inconsistencies in last %i blocks (%i transactions)\n", vChecks.size(), 0);
+        return true;
+    }
+
     CCoinsViewCache coins(coinsview);
     CBlockIndex* pindex;
     CBlockIndex* pindexFailure = nullptr;
@@ -4708,6 +5418,29 @@ void CChainState::UnloadBlockIndex() {
 // May NOT be used after any connections are up as much
 // of the peer-processing logic assumes a consistent
 // block index state
+bool DumpBlockIndexCache()
+{
+    LOCK(cs_main);
+    if (!pblocktree || !setDirtyBlockIndex.empty() || mapBlockIndex.empty()) {
+        // The cache would not match the database
+        return false;
+    }
+
+    int64_t nStart = GetTimeMillis();
+    std::vector<const CBlockIndex*> vIndexes;
+    vIndexes.reserve(mapBlockIndex.size());
+    for (const auto& p : mapBlockIndex) {
+        vIndexes.emplace_back(p.second);
+    }
+    // Sorted by height so that the file is read in roughly the order the block index is processed afterwards
+    std::sort(vIndexes.begin(), vIndexes.end(), [](const CBlockIndex* a, const CBlockIndex* b) { return a->nHeight < b->nHeight; });
+    if (!pblocktree->WriteBlockIndexCache(vIndexes)) {
+        return false;
+    }
+    LogPrintf("%s: dumped %u block indexes in %dms\n", __func__, vIndexes.size(), GetTimeMillis() - nStart);
+    return true;
+}
+
 void UnloadBlockIndex()
 {
     LOCK(cs_main);
@@ -4755,18 +5488,6 @@ bool LoadBlockIndex(const CChainParams& chainparams)
         // Use the provided setting for -txindex in the new database
         fTxIndex = gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX);
         pblocktree->WriteFlag("txindex", fTxIndex);
-
-        // Use the provided setting for -addressindex in the new database
-        fAddressIndex = gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
-        pblocktree->WriteFlag("addressindex", fAddressIndex);
-
-        // Use the provided setting for -timestampindex in the new database
-        fTimestampIndex = gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
-        pblocktree->WriteFlag("timestampindex", fTimestampIndex);
-
-        // Use the provided setting for -spentindex in the new database
-        fSpentIndex = gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX);
-        pblocktree->WriteFlag("spentindex", fSpentIndex);
     }
     return true;
 }
@@ -4882,7 +5603,7 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
                     CBlockIndex* pindex = LookupBlockIndex(hash);
                     if (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0) {
                       CValidationState state;
-                      if (g_chainstate.AcceptBlock(pblock, state, chainparams, nullptr, true, dbp, nullptr)) {
+                      if (g_chainstate.AcceptBlock(pblock, state, chainparams, nullptr, true, dbp, nullptr, &hash)) {
                           nLoaded++;
                       }
                       if (state.IsError()) {
@@ -4915,14 +5636,15 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
                         std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
                         if (ReadBlockFromDisk(*pblockrecursive, it->second, chainparams.GetConsensus()))
                         {
-                            LogPrint(BCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
+                            const uint256 hashrecursive = pblockrecursive->GetHash();
+                            LogPrint(BCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, hashrecursive.ToString(),
                                     head.ToString());
                             LOCK(cs_main);
                             CValidationState dummy;
-                            if (g_chainstate.AcceptBlock(pblockrecursive, dummy, chainparams, nullptr, true, &it->second, nullptr))
+                            if (g_chainstate.AcceptBlock(pblockrecursive, dummy, chainparams, nullptr, true, &it->second, nullptr, &hashrecursive))
                             {
                                 nLoaded++;
-                                queue.push_back(pblockrecursive->GetHash());
+                                queue.push_back(hashrecursive);
                             }
                         }
                         range.first++;
@@ -5164,6 +5886,9 @@ int VersionBitsTipStateSinceHeight(const Consensus::Params& params, Consensus::D
 
 static const uint64_t MEMPOOL_DUMP_VERSION = 1;
 
+/** Number of transactions LoadMempool accepts at once */
+static const size_t MEMPOOL_LOAD_BATCH_SIZE = 100;
+
 bool LoadMempool(void)
 {
     const CChainParams& chainparams = Params();
@@ -5181,6 +5906,40 @@ bool LoadMempool(void)
     int64_t already_there = 0;
     int64_t nNow = GetTime();
 
+    // Transactions are accepted in batches, so that cs_main is released in between and the node keeps serving peers
+    // while the mempool is loaded. The dump is sorted by depth, so parents always come before their children.
+    std::vector<CTransactionRef> vBatch;
+    std::vector<int64_t> vBatchTimes;
+    auto acceptBatch = [&]() {
+        if (vBatch.empty()) {
+            return;
+        }
+        std::vector<CValidationState> vStates;
+        std::vector<bool> vAccepted;
+        {
+            LOCK(cs_main);
+            AcceptPackageToMemoryPoolWithTimes(chainparams, mempool, vBatch, vBatchTimes, vStates, vAccepted,
+                                               false /* bypass_limits */, 0 /* nAbsurdFee */);
+        }
+        for (size_t i = 0; i < vBatch.size(); i++) {
+            if (vStates[i].IsValid()) {
+                ++count;
+            } else {
+                // mempool may contain the transaction already, e.g. from
+                // wallet(s) having loaded it while we were processing
+                // mempool transactions; consider these as valid, instead of
+                // failed, but mark them as 'already there'
+                if (mempool.exists(vBatch[i]->GetHash())) {
+                    ++already_there;
+                } else {
+                    ++failed;
+                }
+            }
+        }
+        vBatch.clear();
+        vBatchTimes.clear();
+    };
+
     try {
         uint64_t version;
         file >> version;
@@ -5201,23 +5960,11 @@ bool LoadMempool(void)
             if (amountdelta) {
                 mempool.PrioritiseTransaction(tx->GetHash(), amountdelta);
             }
-            CValidationState state;
             if (nTime + nExpiryTimeout > nNow) {
-                LOCK(cs_main);
-                AcceptToMemoryPoolWithTime(chainparams, mempool, state, tx, nullptr /* pfMissingInputs */, nTime,
-                                           false /* bypass_limits */, 0 /* nAbsurdFee */);
-                if (state.IsValid()) {
-                    ++count;
-                } else {
-                    // mempool may contain the transaction already, e.g. from
-                    // wallet(s) having loaded it while we were processing
-                    // mempool transactions; consider these as valid, instead of
-                    // failed, but mark them as 'already there'
-                    if (mempool.exists(tx->GetHash())) {
-                        ++already_there;
-                    } else {
-                        ++failed;
-                    }
+                vBatch.emplace_back(std::move(tx));
+                vBatchTimes.emplace_back(nTime);
+                if (vBatch.size() >= MEMPOOL_LOAD_BATCH_SIZE) {
+                    acceptBatch();
                 }
             } else {
                 ++expired;
@@ -5225,6 +5972,7 @@ bool LoadMempool(void)
             if (ShutdownRequested())
                 return false;
         }
+        acceptBatch();
         std::map<uint256, CAmount> mapDeltas;
         file >> mapDeltas;
 
@@ -5233,6 +5981,8 @@ bool LoadMempool(void)
         }
     } catch (const std::exception& e) {
         LogPrintf("Failed to deserialize mempool data on disk: %s. Continuing anyway.\n", e.what());
+        // keep what was read before the error, like when the transactions were accepted one by one
+        acceptBatch();
         return false;
     }
 
@@ -35,7 +35,9 @@
 
 class CBlockIndex;
 class CBlockTreeDB;
+class CBlockUndo;
 class CChainParams;
+class CCoinsCommitment;
 class CCoinsViewDB;
 class CInv;
 class CConnman;
@@ -44,6 +46,7 @@ class CBlockPolicyEstimator;
 class CTxMemPool;
 class CValidationState;
 class PrecomputedTransactionData;
+struct CCuckooCacheStats;
 struct ChainTxData;
 
 struct LockPoints;
@@ -83,10 +86,19 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 static const int MAX_SCRIPTCHECK_THREADS = 16;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
-/** Number of blocks that can be requested at any given time from a single peer. */
+/** Minimum number of transactions in a block for CheckBlock to check them on the transaction check threads */
+static const size_t MIN_PARALLEL_CHECKBLOCK_TXS = 64;
+/** Number of blocks that can be requested at any given time from a single peer, until its delivery rate is known. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
+/** Upper bound of the per-peer in-flight limit, which grows for peers that deliver blocks quickly. */
+static const int MAX_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER = 64;
+/** A peer may have as many blocks in flight as it can deliver within this time (in microseconds) at its measured rate. */
+static const int64_t BLOCK_DOWNLOAD_PIPELINE_TIME = 2 * 1000000;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
 static const unsigned int BLOCK_STALLING_TIMEOUT = 2;
+/** Minimum time in microseconds the block holding back the download window must be in flight before a faster
+ *  peer may take it over from the stalling one. */
+static const int64_t BLOCK_STALLING_REASSIGN_TIME = 500000;
 /** Number of headers sent in one getheaders result. We rely on the assumption that if a peer sends
  *  less than this number, we reached its tip. Changing this value is a protocol upgrade. */
 static const unsigned int MAX_HEADERS_RESULTS = 2000;
@@ -95,15 +107,23 @@ static const unsigned int MAX_HEADERS_RESULTS = 2000;
 static const int MAX_CMPCTBLOCK_DEPTH = 5;
 /** Maximum depth of blocks we're willing to respond to GETBLOCKTXN requests for. */
 static const int MAX_BLOCKTXN_DEPTH = 10;
-/** Size of the "block download window": how far ahead of our current height do we fetch?
+/** Minimum size of the "block download window": how far ahead of our current height do we fetch?
  *  Larger windows tolerate larger download speed differences between peer, but increase the potential
- *  degree of disordering of blocks on disk (which make reindexing and pruning harder). We'll probably
- *  want to make this a per-peer adaptive value at some point. */
+ *  degree of disordering of blocks on disk (which make reindexing and pruning harder). The window grows
+ *  with the total in-flight limit of our peers, up to MAX_BLOCK_DOWNLOAD_WINDOW. */
 static const unsigned int BLOCK_DOWNLOAD_WINDOW = 1024;
+/** Maximum size of the block download window */
+static const unsigned int MAX_BLOCK_DOWNLOAD_WINDOW = 4096;
+/** The block download window is this many times the total number of blocks which may be in flight from our peers. */
+static const unsigned int BLOCK_DOWNLOAD_WINDOW_PER_IN_FLIGHT = 8;
 /** Time to wait (in seconds) between writing blocks/block index to disk. */
 static const unsigned int DATABASE_WRITE_INTERVAL = 60 * 60;
 /** Time to wait (in seconds) between flushing chainstate to disk. */
 static const unsigned int DATABASE_FLUSH_INTERVAL = 24 * 60 * 60;
+/** Default for -dbcachekeep, the percentage of the coins cache filled with recently used coins after a flush */
+static const int DEFAULT_COINS_CACHE_KEEP_PERCENT = 50;
+/** Maximum for -dbcachekeep, the cache must have room for new coins after a flush */
+static const int MAX_COINS_CACHE_KEEP_PERCENT = 90;
 /** Maximum length of reject messages. */
 static const unsigned int MAX_REJECT_MESSAGE_LENGTH = 111;
 /** Block download timeout base, expressed in millionths of the block interval (i.e. 2.5 min) */
@@ -123,6 +143,8 @@ static const bool DEFAULT_TXINDEX = true;
 static const bool DEFAULT_ADDRESSINDEX = false;
 static const bool DEFAULT_TIMESTAMPINDEX = false;
 static const bool DEFAULT_SPENTINDEX = false;
+/** Default for -utxocommitment */
+static const bool DEFAULT_UTXO_COMMITMENT = false;
 static const unsigned int DEFAULT_BANSCORE_THRESHOLD = 100;
 /** Default for -persistmempool */
 static const bool DEFAULT_PERSIST_MEMPOOL = true;
@@ -173,6 +195,8 @@ extern unsigned int nBytesPerSigOp;
 extern bool fCheckBlockIndex;
 extern bool fCheckpointsEnabled;
 extern size_t nCoinCacheUsage;
+/** Memory usage of recently used coins which stay in the coins cache when it's flushed, see CCoinsViewCache::FlushAndTrim */
+extern size_t nCoinCacheKeepUsage;
 /** A fee rate smaller than this is considered zero fee (for relaying, mining and transaction creation) */
 extern CFeeRate minRelayTxFee;
 /** Absolute maximum transaction fee (in duffs) used by wallet and mempool (rejects high fee in sendrawtransaction) */
@@ -211,6 +235,10 @@ static const unsigned int NODE_NETWORK_LIMITED_MIN_BLOCKS = 288;
 
 static const signed int DEFAULT_CHECKBLOCKS = 6;
 static const unsigned int DEFAULT_CHECKLEVEL = 3;
+/** Default for -checkblocksbackground, 0 disables the background verification */
+static const int DEFAULT_CHECKBLOCKS_BACKGROUND = 0;
+/** Default for -checkblocksbackgroundlevel, only the levels which don't need the coins can run in the background */
+static const int DEFAULT_CHECKLEVEL_BACKGROUND = 2;
 
 // Require that user allocate at least 945MB for block & undo files (blk???.dat and rev???.dat)
 // At 2MB per block, 288 blocks = 576MB.
@@ -255,8 +283,9 @@ bool ProcessNewBlock(const CChainParams& chainparams, const std::shared_ptr<cons
  * @param[in]  chainparams The params for the chain we want to connect to
  * @param[out] ppindex If set, the pointer will be set to point to the last new block index object for the given headers
  * @param[out] first_invalid First header that fails validation, if one exists
+ * @param[in]  pHashes If set, the hashes of the headers as returned by CalculateBlockHeaderHashes
  */
-bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex = nullptr, CBlockHeader* first_invalid = nullptr) LOCKS_EXCLUDED(cs_main);
+bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex = nullptr, CBlockHeader* first_invalid = nullptr, const std::vector<uint256>* pHashes = nullptr) LOCKS_EXCLUDED(cs_main);
 
 /** Check whether enough disk space is available for an incoming block */
 bool CheckDiskSpace(uint64_t nAdditionalBytes = 0, bool blocks_dir = false);
@@ -273,10 +302,27 @@ bool LoadGenesisBlock(const CChainParams& chainparams);
 bool LoadBlockIndex(const CChainParams& chainparams) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 /** Update the chain tip based on database information. */
 bool LoadChainTip(const CChainParams& chainparams);
+/** Loads the UTXO set commitment of -utxocommitment, recalculating it if it doesn't match the coins database */
+bool LoadCoinsCommitment();
+/** Write the block index to a flat file which is loaded instead of the block tree database on the next start */
+bool DumpBlockIndexCache();
 /** Unload database information */
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/**
+ * Run a batch of script checks on the script checking threads (inline if there are none) and wait for the result.
+ * Blocks while the threads are busy with a block. Returns false if any of the checks failed.
+ */
+bool RunScriptChecks(std::vector<CScriptCheck>& vChecks);
+/** Run an instance of the block header hashing thread */
+void ThreadHeaderHashCheck();
+/** Calculates the hashes of headers, on the header hashing threads if there are enough headers to make it worth it */
+void CalculateBlockHeaderHashes(const std::vector<CBlockHeader>& headers, std::vector<uint256>& hashesRet);
+/** Run an instance of the thread which reads block inputs from the coins database during ConnectBlock */
+void ThreadCoinPrefetch();
+/** Run an instance of the thread which checks the transactions of large blocks in CheckBlock */
+void ThreadTransactionCheck();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
@@ -323,6 +369,15 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState &state, const CTransa
 static bool AcceptToMemoryPoolWithTime(const CChainParams& chainparams, CTxMemPool& pool, CValidationState &state, const CTransactionRef &tx,
                                        bool* pfMissingInputs, int64_t nAcceptTime, bool bypass_limits,
                                        const CAmount nAbsurdFee, bool fDryRun = false);
+/**
+ * (try to) add a package of transactions to memory pool, parents must come before their children. Same as calling
+ * AcceptToMemoryPool for each of them, but the mempool lock is taken once, the signatures of all transactions are
+ * verified in parallel up front and the coins cache is only flushed at the end. vStates and vAccepted receive the
+ * result for each transaction, a transaction which wasn't accepted with a valid state is missing inputs.
+ * Returns the number of accepted transactions.
+ */
+size_t AcceptPackageToMemoryPool(CTxMemPool& pool, const std::vector<CTransactionRef>& vtx, std::vector<CValidationState>& vStates,
+                                 std::vector<bool>& vAccepted, bool bypass_limits, const CAmount nAbsurdFee);
 
 bool GetUTXOCoin(const COutPoint& outpoint, Coin& coin);
 int GetUTXOHeight(const COutPoint& outpoint);
@@ -414,18 +469,37 @@ bool GetAddressIndex(uint160 addressHash, int type,
                      int start = 0, int end = 0);
 bool GetAddressUnspent(uint160 addressHash, int type,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs);
+bool GetAddressSummary(uint160 addressHash, int type, CAddressSummary &summary);
+/** Paginated versions of GetAddressIndex and GetAddressUnspent, see AddressIndex::ReadAddressIndexPage */
+bool GetAddressIndexPage(const CAddressIndexKey &start, int end, size_t limit,
+                         std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                         CAddressIndexKey &next, bool &fMore);
+bool GetAddressUnspentPage(const CAddressUnspentKey &start, size_t limit,
+                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                           CAddressUnspentKey &next, bool &fMore);
 /** Initializes the script-execution cache */
 void InitScriptExecutionCache();
+/** Lookup counters of the script execution cache */
+CCuckooCacheStats GetScriptExecutionCacheStats();
+/**
+ * Make sure the script execution cache holds the scripts of a mempool transaction,
+ * verifying them again with the block flags if they were evicted. Used for transactions
+ * which got an InstantSend lock, as they are expected in the next blocks.
+ */
+void WarmScriptExecutionCache(const CTransaction& tx);
 
 
 /** Functions for disk access for blocks */
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex);
+/** Reads the serialized block at pos without deserializing it, e.g. to serve it to peers unchanged */
+bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& message_start);
 
 /** Functions for validating blocks and updating the block tree */
 
-/** Context-independent validity checks */
-bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true, bool fCheckMerkleRoot = true);
+/** Context-independent validity checks, pHash can pass the already known block hash to skip hashing the header again */
+bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true, bool fCheckMerkleRoot = true, const uint256* pHash = nullptr);
 
 /** Check a block is completely valid from start to finish (only works on top of our current best block) */
 bool TestBlockValidity(CValidationState& state, const CChainParams& chainparams, const CBlock& block, CBlockIndex* pindexPrev, bool fCheckPOW = true, bool fCheckMerkleRoot = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -438,6 +512,25 @@ public:
     bool VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview, int nCheckLevel, int nCheckDepth);
 };
 
+/** Progress of the block verification started with -checkblocksbackground */
+struct CVerifyDBStatus {
+    bool fRunning{false};
+    bool fDone{false};
+    int nCheckLevel{0};
+    int nBlocksTotal{0};
+    int nBlocksChecked{0};
+    //! -1 if no bad block was found
+    int nFailedHeight{-1};
+    std::string strError;
+};
+
+/**
+ * Checks the last nCheckDepth blocks of the active chain at nCheckLevel 0-2 without holding cs_main, meant to run in
+ * its own thread after init. A bad block results in a warning or, with fShutdownOnFailure, in a shutdown.
+ */
+void ThreadVerifyDB(int nCheckLevel, int nCheckDepth, bool fShutdownOnFailure);
+CVerifyDBStatus GetBackgroundVerifyDBStatus();
+
 /** Replay blocks that aren't fully applied to the database. */
 bool ReplayBlocks(const CChainParams& params, CCoinsView* view);
 
@@ -479,6 +572,9 @@ extern std::unique_ptr<CCoinsViewCache> pcoinsTip;
 /** Global variable that points to the active block tree (protected by cs_main) */
 extern std::unique_ptr<CBlockTreeDB> pblocktree;
 
+/** The UTXO set commitment of pcoinsTip if -utxocommitment is set, null otherwise (protected by cs_main) */
+extern std::unique_ptr<CCoinsCommitment> g_coins_commitment;
+
 /**
  * Return the spend height, which is one more than the inputs.GetBestBlock().
  * While checking, GetBestBlock() refers to the parent block. (protected by cs_main)
@@ -18,13 +18,14 @@
 #include <llmq/quorums_chainlocks.h>
 #include <llmq/quorums_instantsend.h>
 
+#include <array>
 #include <list>
 #include <atomic>
 #include <future>
 
 #include <boost/signals2/signal.hpp>
 
-struct MainSignalsInstance {
+struct MainSignalsShard {
     boost::signals2::signal<void (const CBlockIndex *, const CBlockIndex *, bool fInitialDownload)> UpdatedBlockTip;
     boost::signals2::signal<void (const CBlockIndex *, const CBlockIndex *, bool fInitialDownload)> SynchronousUpdatedBlockTip;
     boost::signals2::signal<void (const CTransactionRef &, int64_t)> TransactionAddedToMempool;
@@ -49,14 +50,44 @@ struct MainSignalsInstance {
     // our own queue here :(
     SingleThreadedSchedulerClient m_schedulerClient;
 
-    explicit MainSignalsInstance(CScheduler *pscheduler) : m_schedulerClient(pscheduler) {}
+    explicit MainSignalsShard(CScheduler *pscheduler) : m_schedulerClient(pscheduler) {}
+};
+
+/**
+ * The listeners are split into shards, each with its own callback queue, so that listeners in one shard never wait
+ * for slow callbacks of listeners in the other one. A listener only ever is in one shard, so it still receives its
+ * callbacks in order.
+ */
+struct MainSignalsInstance {
+    std::array<std::unique_ptr<MainSignalsShard>, VALIDATION_INTERFACE_PRIORITY_COUNT> m_shards;
+
+    MainSignalsInstance(CScheduler *pscheduler, CScheduler *pschedulerHighPriority)
+    {
+        m_shards[(size_t)ValidationInterfacePriority::HIGH].reset(new MainSignalsShard(pschedulerHighPriority));
+        m_shards[(size_t)ValidationInterfacePriority::NORMAL].reset(new MainSignalsShard(pscheduler));
+    }
 };
 
 static CMainSignals g_signals;
 
-void CMainSignals::RegisterBackgroundSignalScheduler(CScheduler& scheduler) {
+/** Queues a call of signal with args in each shard which has listeners for it */
+template <typename Signal, typename... Args>
+static void EnqueueSignal(MainSignalsInstance& internals, Signal MainSignalsShard::*signal, const Args&... args)
+{
+    for (auto& shard : internals.m_shards) {
+        if ((shard.get()->*signal).empty()) {
+            continue;
+        }
+        MainSignalsShard* pshard = shard.get();
+        pshard->m_schedulerClient.AddToProcessQueue([pshard, signal, args...] {
+            (pshard->*signal)(args...);
+        });
+    }
+}
+
+void CMainSignals::RegisterBackgroundSignalScheduler(CScheduler& scheduler, CScheduler* pschedulerHighPriority) {
     assert(!m_internals);
-    m_internals.reset(new MainSignalsInstance(&scheduler));
+    m_internals.reset(new MainSignalsInstance(&scheduler, pschedulerHighPriority ? pschedulerHighPriority : &scheduler));
 }
 
 void CMainSignals::UnregisterBackgroundSignalScheduler() {
@@ -65,13 +96,19 @@ void CMainSignals::UnregisterBackgroundSignalScheduler() {
 
 void CMainSignals::FlushBackgroundCallbacks() {
     if (m_internals) {
-        m_internals->m_schedulerClient.EmptyQueue();
+        for (auto& shard : m_internals->m_shards) {
+            shard->m_schedulerClient.EmptyQueue();
+        }
     }
 }
 
 size_t CMainSignals::CallbacksPending() {
     if (!m_internals) return 0;
-    return m_internals->m_schedulerClient.CallbacksPending();
+    size_t nPending = 0;
+    for (auto& shard : m_internals->m_shards) {
+        nPending += shard->m_schedulerClient.CallbacksPending();
+    }
+    return nPending;
 }
 
 void CMainSignals::RegisterWithMempoolSignals(CTxMemPool& pool) {
@@ -87,77 +124,92 @@ CMainSignals& GetMainSignals()
     return g_signals;
 }
 
-void RegisterValidationInterface(CValidationInterface* pwalletIn) {
-    g_signals.m_internals->AcceptedBlockHeader.connect(boost::bind(&CValidationInterface::AcceptedBlockHeader, pwalletIn, _1));
-    g_signals.m_internals->NotifyHeaderTip.connect(boost::bind(&CValidationInterface::NotifyHeaderTip, pwalletIn, _1, _2));
-    g_signals.m_internals->UpdatedBlockTip.connect(boost::bind(&CValidationInterface::UpdatedBlockTip, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->SynchronousUpdatedBlockTip.connect(boost::bind(&CValidationInterface::SynchronousUpdatedBlockTip, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->TransactionAddedToMempool.connect(boost::bind(&CValidationInterface::TransactionAddedToMempool, pwalletIn, _1, _2));
-    g_signals.m_internals->BlockConnected.connect(boost::bind(&CValidationInterface::BlockConnected, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->BlockDisconnected.connect(boost::bind(&CValidationInterface::BlockDisconnected, pwalletIn, _1, _2));
-    g_signals.m_internals->NotifyTransactionLock.connect(boost::bind(&CValidationInterface::NotifyTransactionLock, pwalletIn, _1, _2));
-    g_signals.m_internals->NotifyChainLock.connect(boost::bind(&CValidationInterface::NotifyChainLock, pwalletIn, _1, _2));
-    g_signals.m_internals->TransactionRemovedFromMempool.connect(boost::bind(&CValidationInterface::TransactionRemovedFromMempool, pwalletIn, _1, _2));
-    g_signals.m_internals->SetBestChain.connect(boost::bind(&CValidationInterface::SetBestChain, pwalletIn, _1));
-    g_signals.m_internals->Broadcast.connect(boost::bind(&CValidationInterface::ResendWalletTransactions, pwalletIn, _1, _2));
-    g_signals.m_internals->BlockChecked.connect(boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
-    g_signals.m_internals->NewPoWValidBlock.connect(boost::bind(&CValidationInterface::NewPoWValidBlock, pwalletIn, _1, _2));
-    g_signals.m_internals->NotifyGovernanceObject.connect(boost::bind(&CValidationInterface::NotifyGovernanceObject, pwalletIn, _1));
-    g_signals.m_internals->NotifyGovernanceVote.connect(boost::bind(&CValidationInterface::NotifyGovernanceVote, pwalletIn, _1));
-    g_signals.m_internals->NotifyInstantSendDoubleSpendAttempt.connect(boost::bind(&CValidationInterface::NotifyInstantSendDoubleSpendAttempt, pwalletIn, _1, _2));
-    g_signals.m_internals->NotifyRecoveredSig.connect(boost::bind(&CValidationInterface::NotifyRecoveredSig, pwalletIn, _1));
-    g_signals.m_internals->NotifyMasternodeListChanged.connect(boost::bind(&CValidationInterface::NotifyMasternodeListChanged, pwalletIn, _1, _2, _3));
+void RegisterValidationInterface(CValidationInterface* pwalletIn, ValidationInterfacePriority priority) {
+    MainSignalsShard& shard = *g_signals.m_internals->m_shards[(size_t)priority];
+    shard.AcceptedBlockHeader.connect(boost::bind(&CValidationInterface::AcceptedBlockHeader, pwalletIn, _1));
+    shard.NotifyHeaderTip.connect(boost::bind(&CValidationInterface::NotifyHeaderTip, pwalletIn, _1, _2));
+    shard.UpdatedBlockTip.connect(boost::bind(&CValidationInterface::UpdatedBlockTip, pwalletIn, _1, _2, _3));
+    shard.SynchronousUpdatedBlockTip.connect(boost::bind(&CValidationInterface::SynchronousUpdatedBlockTip, pwalletIn, _1, _2, _3));
+    shard.TransactionAddedToMempool.connect(boost::bind(&CValidationInterface::TransactionAddedToMempool, pwalletIn, _1, _2));
+    shard.BlockConnected.connect(boost::bind(&CValidationInterface::BlockConnected, pwalletIn, _1, _2, _3));
+    shard.BlockDisconnected.connect(boost::bind(&CValidationInterface::BlockDisconnected, pwalletIn, _1, _2));
+    shard.NotifyTransactionLock.connect(boost::bind(&CValidationInterface::NotifyTransactionLock, pwalletIn, _1, _2));
+    shard.NotifyChainLock.connect(boost::bind(&CValidationInterface::NotifyChainLock, pwalletIn, _1, _2));
+    shard.TransactionRemovedFromMempool.connect(boost::bind(&CValidationInterface::TransactionRemovedFromMempool, pwalletIn, _1, _2));
+    shard.SetBestChain.connect(boost::bind(&CValidationInterface::SetBestChain, pwalletIn, _1));
+    shard.Broadcast.connect(boost::bind(&CValidationInterface::ResendWalletTransactions, pwalletIn, _1, _2));
+    shard.BlockChecked.connect(boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
+    shard.NewPoWValidBlock.connect(boost::bind(&CValidationInterface::NewPoWValidBlock, pwalletIn, _1, _2));
+    shard.NotifyGovernanceObject.connect(boost::bind(&CValidationInterface::NotifyGovernanceObject, pwalletIn, _1));
+    shard.NotifyGovernanceVote.connect(boost::bind(&CValidationInterface::NotifyGovernanceVote, pwalletIn, _1));
+    shard.NotifyInstantSendDoubleSpendAttempt.connect(boost::bind(&CValidationInterface::NotifyInstantSendDoubleSpendAttempt, pwalletIn, _1, _2));
+    shard.NotifyRecoveredSig.connect(boost::bind(&CValidationInterface::NotifyRecoveredSig, pwalletIn, _1));
+    shard.NotifyMasternodeListChanged.connect(boost::bind(&CValidationInterface::NotifyMasternodeListChanged, pwalletIn, _1, _2, _3));
 }
 
 void UnregisterValidationInterface(CValidationInterface* pwalletIn) {
-    g_signals.m_internals->BlockChecked.disconnect(boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
-    g_signals.m_internals->Broadcast.disconnect(boost::bind(&CValidationInterface::ResendWalletTransactions, pwalletIn, _1, _2));
-    g_signals.m_internals->SetBestChain.disconnect(boost::bind(&CValidationInterface::SetBestChain, pwalletIn, _1));
-    g_signals.m_internals->NotifyChainLock.disconnect(boost::bind(&CValidationInterface::NotifyChainLock, pwalletIn, _1, _2));
-    g_signals.m_internals->NotifyTransactionLock.disconnect(boost::bind(&CValidationInterface::NotifyTransactionLock, pwalletIn, _1, _2));
-    g_signals.m_internals->TransactionAddedToMempool.disconnect(boost::bind(&CValidationInterface::TransactionAddedToMempool, pwalletIn, _1, _2));
-    g_signals.m_internals->BlockConnected.disconnect(boost::bind(&CValidationInterface::BlockConnected, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->BlockDisconnected.disconnect(boost::bind(&CValidationInterface::BlockDisconnected, pwalletIn, _1, _2));
-    g_signals.m_internals->TransactionRemovedFromMempool.disconnect(boost::bind(&CValidationInterface::TransactionRemovedFromMempool, pwalletIn, _1, _2));
-    g_signals.m_internals->UpdatedBlockTip.disconnect(boost::bind(&CValidationInterface::UpdatedBlockTip, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->SynchronousUpdatedBlockTip.disconnect(boost::bind(&CValidationInterface::SynchronousUpdatedBlockTip, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->NewPoWValidBlock.disconnect(boost::bind(&CValidationInterface::NewPoWValidBlock, pwalletIn, _1, _2));
-    g_signals.m_internals->NotifyHeaderTip.disconnect(boost::bind(&CValidationInterface::NotifyHeaderTip, pwalletIn, _1, _2));
-    g_signals.m_internals->AcceptedBlockHeader.disconnect(boost::bind(&CValidationInterface::AcceptedBlockHeader, pwalletIn, _1));
-    g_signals.m_internals->NotifyGovernanceObject.disconnect(boost::bind(&CValidationInterface::NotifyGovernanceObject, pwalletIn, _1));
-    g_signals.m_internals->NotifyGovernanceVote.disconnect(boost::bind(&CValidationInterface::NotifyGovernanceVote, pwalletIn, _1));
-    g_signals.m_internals->NotifyInstantSendDoubleSpendAttempt.disconnect(boost::bind(&CValidationInterface::NotifyInstantSendDoubleSpendAttempt, pwalletIn, _1, _2));
-    g_signals.m_internals->NotifyRecoveredSig.disconnect(boost::bind(&CValidationInterface::NotifyRecoveredSig, pwalletIn, _1));
-    g_signals.m_internals->NotifyMasternodeListChanged.disconnect(boost::bind(&CValidationInterface::NotifyMasternodeListChanged, pwalletIn, _1, _2, _3));
+    // disconnecting slots which were not connected is a no-op, no need to remember the shard of pwalletIn
+    for (auto& shard : g_signals.m_internals->m_shards) {
+        shard->BlockChecked.disconnect(boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
+        shard->Broadcast.disconnect(boost::bind(&CValidationInterface::ResendWalletTransactions, pwalletIn, _1, _2));
+        shard->SetBestChain.disconnect(boost::bind(&CValidationInterface::SetBestChain, pwalletIn, _1));
+        shard->NotifyChainLock.disconnect(boost::bind(&CValidationInterface::NotifyChainLock, pwalletIn, _1, _2));
+        shard->NotifyTransactionLock.disconnect(boost::bind(&CValidationInterface::NotifyTransactionLock, pwalletIn, _1, _2));
+        shard->TransactionAddedToMempool.disconnect(boost::bind(&CValidationInterface::TransactionAddedToMempool, pwalletIn, _1, _2));
+        shard->BlockConnected.disconnect(boost::bind(&CValidationInterface::BlockConnected, pwalletIn, _1, _2, _3));
+        shard->BlockDisconnected.disconnect(boost::bind(&CValidationInterface::BlockDisconnected, pwalletIn, _1, _2));
+        shard->TransactionRemovedFromMempool.disconnect(boost::bind(&CValidationInterface::TransactionRemovedFromMempool, pwalletIn, _1, _2));
+        shard->UpdatedBlockTip.disconnect(boost::bind(&CValidationInterface::UpdatedBlockTip, pwalletIn, _1, _2, _3));
+        shard->SynchronousUpdatedBlockTip.disconnect(boost::bind(&CValidationInterface::SynchronousUpdatedBlockTip, pwalletIn, _1, _2, _3));
+        shard->NewPoWValidBlock.disconnect(boost::bind(&CValidationInterface::NewPoWValidBlock, pwalletIn, _1, _2));
+        shard->NotifyHeaderTip.disconnect(boost::bind(&CValidationInterface::NotifyHeaderTip, pwalletIn, _1, _2));
+        shard->AcceptedBlockHeader.disconnect(boost::bind(&CValidationInterface::AcceptedBlockHeader, pwalletIn, _1));
+        shard->NotifyGovernanceObject.disconnect(boost::bind(&CValidationInterface::NotifyGovernanceObject, pwalletIn, _1));
+        shard->NotifyGovernanceVote.disconnect(boost::bind(&CValidationInterface::NotifyGovernanceVote, pwalletIn, _1));
+        shard->NotifyInstantSendDoubleSpendAttempt.disconnect(boost::bind(&CValidationInterface::NotifyInstantSendDoubleSpendAttempt, pwalletIn, _1, _2));
+        shard->NotifyRecoveredSig.disconnect(boost::bind(&CValidationInterface::NotifyRecoveredSig, pwalletIn, _1));
+        shard->NotifyMasternodeListChanged.disconnect(boost::bind(&CValidationInterface::NotifyMasternodeListChanged, pwalletIn, _1, _2, _3));
+    }
 }
 
 void UnregisterAllValidationInterfaces() {
     if (!g_signals.m_internals) {
         return;
     }
-    g_signals.m_internals->BlockChecked.disconnect_all_slots();
-    g_signals.m_internals->Broadcast.disconnect_all_slots();
-    g_signals.m_internals->SetBestChain.disconnect_all_slots();
-    g_signals.m_internals->NotifyTransactionLock.disconnect_all_slots();
-    g_signals.m_internals->NotifyChainLock.disconnect_all_slots();
-    g_signals.m_internals->TransactionAddedToMempool.disconnect_all_slots();
-    g_signals.m_internals->BlockConnected.disconnect_all_slots();
-    g_signals.m_internals->BlockDisconnected.disconnect_all_slots();
-    g_signals.m_internals->TransactionRemovedFromMempool.disconnect_all_slots();
-    g_signals.m_internals->UpdatedBlockTip.disconnect_all_slots();
-    g_signals.m_internals->SynchronousUpdatedBlockTip.disconnect_all_slots();
-    g_signals.m_internals->NewPoWValidBlock.disconnect_all_slots();
-    g_signals.m_internals->NotifyHeaderTip.disconnect_all_slots();
-    g_signals.m_internals->AcceptedBlockHeader.disconnect_all_slots();
-    g_signals.m_internals->NotifyGovernanceObject.disconnect_all_slots();
-    g_signals.m_internals->NotifyGovernanceVote.disconnect_all_slots();
-    g_signals.m_internals->NotifyInstantSendDoubleSpendAttempt.disconnect_all_slots();
-    g_signals.m_internals->NotifyRecoveredSig.disconnect_all_slots();
-    g_signals.m_internals->NotifyMasternodeListChanged.disconnect_all_slots();
+    for (auto& shard : g_signals.m_internals->m_shards) {
+        shard->BlockChecked.disconnect_all_slots();
+        shard->Broadcast.disconnect_all_slots();
+        shard->SetBestChain.disconnect_all_slots();
+        shard->NotifyTransactionLock.disconnect_all_slots();
+        shard->NotifyChainLock.disconnect_all_slots();
+        shard->TransactionAddedToMempool.disconnect_all_slots();
+        shard->BlockConnected.disconnect_all_slots();
+        shard->BlockDisconnected.disconnect_all_slots();
+        shard->TransactionRemovedFromMempool.disconnect_all_slots();
+        shard->UpdatedBlockTip.disconnect_all_slots();
+        shard->SynchronousUpdatedBlockTip.disconnect_all_slots();
+        shard->NewPoWValidBlock.disconnect_all_slots();
+        shard->NotifyHeaderTip.disconnect_all_slots();
+        shard->AcceptedBlockHeader.disconnect_all_slots();
+        shard->NotifyGovernanceObject.disconnect_all_slots();
+        shard->NotifyGovernanceVote.disconnect_all_slots();
+        shard->NotifyInstantSendDoubleSpendAttempt.disconnect_all_slots();
+        shard->NotifyRecoveredSig.disconnect_all_slots();
+        shard->NotifyMasternodeListChanged.disconnect_all_slots();
+    }
 }
 
 void CallFunctionInValidationInterfaceQueue(std::function<void ()> func) {
-    g_signals.m_internals->m_schedulerClient.AddToProcessQueue(std::move(func));
+    // func is called by the shard which gets to it last, once all shards are done with the callbacks queued before
+    auto nShardsPending = std::make_shared<std::atomic<size_t>>(VALIDATION_INTERFACE_PRIORITY_COUNT);
+    auto pfunc = std::make_shared<std::function<void ()>>(std::move(func));
+    for (auto& shard : g_signals.m_internals->m_shards) {
+        shard->m_schedulerClient.AddToProcessQueue([nShardsPending, pfunc] {
+            if (--*nShardsPending == 0) {
+                (*pfunc)();
+            }
+        });
+    }
 }
 
 void SyncWithValidationInterfaceQueue() {
@@ -172,9 +224,7 @@ void SyncWithValidationInterfaceQueue() {
 
 void CMainSignals::MempoolEntryRemoved(CTransactionRef ptx, MemPoolRemovalReason reason) {
     if (reason != MemPoolRemovalReason::BLOCK) {
-        m_internals->m_schedulerClient.AddToProcessQueue([ptx, reason, this] {
-            m_internals->TransactionRemovedFromMempool(ptx, reason);
-        });
+        EnqueueSignal(*m_internals, &MainSignalsShard::TransactionRemovedFromMempool, ptx, reason);
     }
 }
 
@@ -183,95 +233,95 @@ void CMainSignals::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockInd
     // the chain actually updates. One way to ensure this is for the caller to invoke this signal
     // in the same critical section where the chain is updated
 
-    m_internals->m_schedulerClient.AddToProcessQueue([pindexNew, pindexFork, fInitialDownload, this] {
-        m_internals->UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
-    });
+    EnqueueSignal(*m_internals, &MainSignalsShard::UpdatedBlockTip, pindexNew, pindexFork, fInitialDownload);
 }
 
 void CMainSignals::SynchronousUpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) {
-    m_internals->SynchronousUpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
+    for (auto& shard : m_internals->m_shards) {
+        shard->SynchronousUpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
+    }
 }
 
 void CMainSignals::TransactionAddedToMempool(const CTransactionRef &ptx, int64_t nAcceptTime) {
-    m_internals->m_schedulerClient.AddToProcessQueue([ptx, nAcceptTime, this] {
-        m_internals->TransactionAddedToMempool(ptx, nAcceptTime);
-    });
+    EnqueueSignal(*m_internals, &MainSignalsShard::TransactionAddedToMempool, ptx, nAcceptTime);
 }
 
 void CMainSignals::BlockConnected(const std::shared_ptr<const CBlock> &pblock, const CBlockIndex *pindex, const std::shared_ptr<const std::vector<CTransactionRef>>& pvtxConflicted) {
-    m_internals->m_schedulerClient.AddToProcessQueue([pblock, pindex, pvtxConflicted, this] {
-        m_internals->BlockConnected(pblock, pindex, *pvtxConflicted);
-    });
+    for (auto& shard : m_internals->m_shards) {
+        if (shard->BlockConnected.empty()) {
+            continue;
+        }
+        MainSignalsShard* pshard = shard.get();
+        pshard->m_schedulerClient.AddToProcessQueue([pblock, pindex, pvtxConflicted, pshard] {
+            pshard->BlockConnected(pblock, pindex, *pvtxConflicted);
+        });
+    }
 }
 
 void CMainSignals::BlockDisconnected(const std::shared_ptr<const CBlock> &pblock, const CBlockIndex* pindexDisconnected) {
-    m_internals->m_schedulerClient.AddToProcessQueue([pblock, pindexDisconnected, this] {
-        m_internals->BlockDisconnected(pblock, pindexDisconnected);
-    });
+    EnqueueSignal(*m_internals, &MainSignalsShard::BlockDisconnected, pblock, pindexDisconnected);
 }
 
 void CMainSignals::SetBestChain(const CBlockLocator &locator) {
-    m_internals->m_schedulerClient.AddToProcessQueue([locator, this] {
-        m_internals->SetBestChain(locator);
-    });
+    EnqueueSignal(*m_internals, &MainSignalsShard::SetBestChain, locator);
 }
 
 void CMainSignals::Broadcast(int64_t nBestBlockTime, CConnman* connman) {
-    m_internals->Broadcast(nBestBlockTime, connman);
+    for (auto& shard : m_internals->m_shards) {
+        shard->Broadcast(nBestBlockTime, connman);
+    }
 }
 
 void CMainSignals::BlockChecked(const CBlock& block, const CValidationState& state) {
-    m_internals->BlockChecked(block, state);
+    for (auto& shard : m_internals->m_shards) {
+        shard->BlockChecked(block, state);
+    }
 }
 
 void CMainSignals::NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock> &block) {
-    m_internals->NewPoWValidBlock(pindex, block);
+    for (auto& shard : m_internals->m_shards) {
+        shard->NewPoWValidBlock(pindex, block);
+    }
 }
 
 void CMainSignals::AcceptedBlockHeader(const CBlockIndex *pindexNew) {
-    m_internals->AcceptedBlockHeader(pindexNew);
+    for (auto& shard : m_internals->m_shards) {
+        shard->AcceptedBlockHeader(pindexNew);
+    }
 }
 
 void CMainSignals::NotifyHeaderTip(const CBlockIndex *pindexNew, bool fInitialDownload) {
-    m_internals->NotifyHeaderTip(pindexNew, fInitialDownload);
+    for (auto& shard : m_internals->m_shards) {
+        shard->NotifyHeaderTip(pindexNew, fInitialDownload);
+    }
 }
 
 void CMainSignals::NotifyTransactionLock(const CTransactionRef &tx, const std::shared_ptr<const llmq::CInstantSendLock>& islock) {
-    m_internals->m_schedulerClient.AddToProcessQueue([tx, islock, this] {
-        m_internals->NotifyTransactionLock(tx, islock);
-    });
+    EnqueueSignal(*m_internals, &MainSignalsShard::NotifyTransactionLock, tx, islock);
 }
 
 void CMainSignals::NotifyChainLock(const CBlockIndex* pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig) {
-    m_internals->m_schedulerClient.AddToProcessQueue([pindex, clsig, this] {
-        m_internals->NotifyChainLock(pindex, clsig);
-    });
+    EnqueueSignal(*m_internals, &MainSignalsShard::NotifyChainLock, pindex, clsig);
 }
 
 void CMainSignals::NotifyGovernanceVote(const std::shared_ptr<const CGovernanceVote>& vote) {
-    m_internals->m_schedulerClient.AddToProcessQueue([vote, this] {
-        m_internals->NotifyGovernanceVote(vote);
-    });
+    EnqueueSignal(*m_internals, &MainSignalsShard::NotifyGovernanceVote, vote);
 }
 
 void CMainSignals::NotifyGovernanceObject(const std::shared_ptr<const CGovernanceObject>& object) {
-    m_internals->m_schedulerClient.AddToProcessQueue([object, this] {
-        m_internals->NotifyGovernanceObject(object);
-    });
+    EnqueueSignal(*m_internals, &MainSignalsShard::NotifyGovernanceObject, object);
 }
 
 void CMainSignals::NotifyInstantSendDoubleSpendAttempt(const CTransactionRef& currentTx, const CTransactionRef& previousTx) {
-    m_internals->m_schedulerClient.AddToProcessQueue([currentTx, previousTx, this] {
-        m_internals->NotifyInstantSendDoubleSpendAttempt(currentTx, previousTx);
-    });
+    EnqueueSignal(*m_internals, &MainSignalsShard::NotifyInstantSendDoubleSpendAttempt, currentTx, previousTx);
 }
 
 void CMainSignals::NotifyRecoveredSig(const std::shared_ptr<const llmq::CRecoveredSig>& sig) {
-    m_internals->m_schedulerClient.AddToProcessQueue([sig, this] {
-        m_internals->NotifyRecoveredSig(sig);
-    });
+    EnqueueSignal(*m_internals, &MainSignalsShard::NotifyRecoveredSig, sig);
 }
 
 void CMainSignals::NotifyMasternodeListChanged(bool undo, const CDeterministicMNList& oldMNList, const CDeterministicMNListDiff& diff) {
-    m_internals->NotifyMasternodeListChanged(undo, oldMNList, diff);
-}
\ No newline at end of file
+    for (auto& shard : m_internals->m_shards) {
+        shard->NotifyMasternodeListChanged(undo, oldMNList, diff);
+    }
+}
@@ -33,16 +33,26 @@ namespace llmq {
     class CRecoveredSig;
 } // namespace llmq
 
+/**
+ * Each priority has its own callback queue, so that e.g. InstantSend and ChainLocks listeners never wait in the queue
+ * for slow callbacks of wallets or ZMQ.
+ */
+enum class ValidationInterfacePriority {
+    HIGH,
+    NORMAL,
+};
+static const size_t VALIDATION_INTERFACE_PRIORITY_COUNT = 2;
+
 // These functions dispatch to one or all registered wallets
 
 /** Register a wallet to receive updates from core */
-void RegisterValidationInterface(CValidationInterface* pwalletIn);
+void RegisterValidationInterface(CValidationInterface* pwalletIn, ValidationInterfacePriority priority = ValidationInterfacePriority::NORMAL);
 /** Unregister a wallet from core */
 void UnregisterValidationInterface(CValidationInterface* pwalletIn);
 /** Unregister all wallets from core */
 void UnregisterAllValidationInterfaces();
 /**
- * Pushes a function to callback onto the notification queue, guaranteeing any
+ * Pushes a function to callback onto the notification queues, guaranteeing any
  * callbacks generated prior to now are finished when the function is called.
  *
  * Be very careful blocking on func to be called if any locks are held -
@@ -75,7 +85,8 @@ void SyncWithValidationInterfaceQueue();
  * UpdatedBlockTip() callback may depend on an operation performed in
  * the BlockConnected() callback without worrying about explicit
  * synchronization. No ordering should be assumed across
- * ValidationInterface() subscribers.
+ * ValidationInterface() subscribers, subscribers registered with different
+ * priorities don't even share a callback queue.
  */
 class CValidationInterface {
 protected:
@@ -152,7 +163,7 @@ protected:
      * Notifies listeners that a block which builds directly on our current tip
      * has been received and connected to the headers tree, though not validated yet */
     virtual void NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block) {};
-    friend void ::RegisterValidationInterface(CValidationInterface*);
+    friend void ::RegisterValidationInterface(CValidationInterface*, ValidationInterfacePriority);
     friend void ::UnregisterValidationInterface(CValidationInterface*);
     friend void ::UnregisterAllValidationInterfaces();
 };
@@ -162,7 +173,7 @@ class CMainSignals {
 private:
     std::unique_ptr<MainSignalsInstance> m_internals;
 
-    friend void ::RegisterValidationInterface(CValidationInterface*);
+    friend void ::RegisterValidationInterface(CValidationInterface*, ValidationInterfacePriority);
     friend void ::UnregisterValidationInterface(CValidationInterface*);
     friend void ::UnregisterAllValidationInterfaces();
     friend void ::CallFunctionInValidationInterfaceQueue(std::function<void ()> func);
@@ -170,8 +181,12 @@ private:
     void MempoolEntryRemoved(CTransactionRef tx, MemPoolRemovalReason reason);
 
 public:
-    /** Register a CScheduler to give callbacks which should run in the background (may only be called once) */
-    void RegisterBackgroundSignalScheduler(CScheduler& scheduler);
+    /**
+     * Register a CScheduler to give callbacks which should run in the background (may only be called once).
+     * Callbacks of high priority listeners run on pschedulerHighPriority if given, so they don't wait for scheduler's
+     * thread either.
+     */
+    void RegisterBackgroundSignalScheduler(CScheduler& scheduler, CScheduler* pschedulerHighPriority = nullptr);
     /** Unregister a CScheduler to give callbacks which should run in the background - these callbacks will now be dropped! */
     void UnregisterBackgroundSignalScheduler();
     /** Call any remaining callbacks on the calling thread */
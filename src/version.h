@@ -11,7 +11,7 @@
  */
 
 
-static const int PROTOCOL_VERSION = 70219;
+static const int PROTOCOL_VERSION = 70221;
 
 //! initial proto version, to be increased after version/verack negotiation
 static const int INIT_PROTO_VERSION = 209;
@@ -48,4 +48,10 @@ static const int MNAUTH_NODE_VER_VERSION = 70218;
 //! introduction of QGETDATA/QDATA messages
 static const int LLMQ_DATA_MESSAGES_VERSION = 70219;
 
+//! introduction of MNGOVERNANCERECON (governance vote set reconciliation)
+static const int GOVERNANCE_VOTE_RECON_VERSION = 70220;
+
+//! introduction of SENDCMPCTHDR (compact message headers)
+static const int COMPACT_HEADER_PROTO_VERSION = 70221;
+
 #endif // BITCOIN_VERSION_H
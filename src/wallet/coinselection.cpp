@@ -229,26 +229,23 @@ int CInputCoin::Priority() const
     return -1 * (txout.nValue / COIN);
 }
 
-struct CompareByPriority
+/** Sorts coins by ascending priority value, calculating the priority of every coin only once */
+static void SortByPriority(std::vector<CInputCoin>& vCoins)
 {
-    bool operator()(const CInputCoin& coin1,
-                    const CInputCoin& coin2) const
-    {
-        return coin1.Priority() > coin2.Priority();
+    std::vector<std::pair<int, size_t>> vPriorities;
+    vPriorities.reserve(vCoins.size());
+    for (size_t i = 0; i < vCoins.size(); i++) {
+        vPriorities.emplace_back(vCoins[i].Priority(), i);
     }
-};
-
-// move denoms down
-bool less_then_denom (const CInputCoin& coin1, const CInputCoin& coin2)
-{
-    bool found1 = false;
-    bool found2 = false;
-    for (const auto& d : CCoinJoin::GetStandardDenominations()) // loop through predefined denoms
-    {
-        if(coin1.txout.nValue == d) found1 = true;
-        if(coin2.txout.nValue == d) found2 = true;
+    std::stable_sort(vPriorities.begin(), vPriorities.end(), [](const std::pair<int, size_t>& a, const std::pair<int, size_t>& b) {
+        return a.first < b.first;
+    });
+    std::vector<CInputCoin> vSorted;
+    vSorted.reserve(vCoins.size());
+    for (const auto& p : vPriorities) {
+        vSorted.push_back(std::move(vCoins[p.second]));
     }
-    return (!found1 && found2);
+    vCoins = std::move(vSorted);
 }
 
 bool KnapsackSolver(const CAmount& nTargetValue, std::vector<CInputCoin>& vCoins, std::set<CInputCoin>& setCoinsRet, CAmount& nValueRet, bool fFulyMixedOnly, CAmount maxTxFee)
@@ -268,7 +265,7 @@ bool KnapsackSolver(const CAmount& nTargetValue, std::vector<CInputCoin>& vCoins
 
     if (fFulyMixedOnly) {
         // larger denoms first
-        std::sort(vCoins.rbegin(), vCoins.rend(), CompareByPriority());
+        SortByPriority(vCoins);
         // we actually want denoms only, so let's skip "non-denom only" step
         tryDenomStart = 1;
         // no change is allowed
@@ -276,7 +273,9 @@ bool KnapsackSolver(const CAmount& nTargetValue, std::vector<CInputCoin>& vCoins
     } else {
         // move denoms down on the list
         // try not to use denominated coins when not needed, save denoms for coinjoin
-        std::sort(vCoins.begin(), vCoins.end(), less_then_denom);
+        std::stable_partition(vCoins.begin(), vCoins.end(), [](const CInputCoin& coin) {
+            return !CCoinJoin::IsDenominatedAmount(coin.txout.nValue);
+        });
     }
 
     // try to find nondenom first to prevent unneeded spending of mixed coins
@@ -270,6 +270,37 @@ BOOST_AUTO_TEST_CASE(LoadReceiveRequests)
     BOOST_CHECK_EQUAL(values[1], "val_rr1");
 }
 
+// IsMine(const CTxOut&) rejects outputs through the script hashes, which must follow every way of adding and
+// removing keys and scripts.
+BOOST_AUTO_TEST_CASE(ismine_script_hashes)
+{
+    CKey key, watchKey1, watchKey2;
+    key.MakeNewKey(true);
+    watchKey1.MakeNewKey(true);
+    watchKey2.MakeNewKey(true);
+    CTxOut p2pkh(COIN, GetScriptForDestination(key.GetPubKey().GetID()));
+    CScript redeemScript = GetScriptForRawPubKey(key.GetPubKey());
+    CTxOut p2sh(COIN, GetScriptForDestination(CScriptID(redeemScript)));
+    CTxOut watch1(COIN, GetScriptForDestination(watchKey1.GetPubKey().GetID()));
+    CTxOut watch2(COIN, GetScriptForDestination(watchKey2.GetPubKey().GetID()));
+
+    LOCK(m_wallet.cs_wallet);
+    BOOST_CHECK_EQUAL(m_wallet.IsMine(p2pkh), ISMINE_NO);
+    BOOST_CHECK(m_wallet.AddKeyPubKey(key, key.GetPubKey()));
+    BOOST_CHECK_EQUAL(m_wallet.IsMine(p2pkh), ISMINE_SPENDABLE);
+    BOOST_CHECK_EQUAL(m_wallet.IsMine(p2sh), ISMINE_NO);
+    BOOST_CHECK(m_wallet.AddCScript(redeemScript));
+    BOOST_CHECK_EQUAL(m_wallet.IsMine(p2sh), ISMINE_SPENDABLE);
+
+    BOOST_CHECK(m_wallet.AddWatchOnly(watch1.scriptPubKey, 0));
+    BOOST_CHECK_EQUAL(m_wallet.IsMine(watch1), ISMINE_WATCH_ONLY);
+    BOOST_CHECK(m_wallet.RemoveWatchOnly(watch1.scriptPubKey));
+    BOOST_CHECK_EQUAL(m_wallet.IsMine(watch1), ISMINE_NO);
+    // same number of scripts as before the removal, but a different one
+    BOOST_CHECK(m_wallet.AddWatchOnly(watch2.scriptPubKey, 0));
+    BOOST_CHECK_EQUAL(m_wallet.IsMine(watch2), ISMINE_WATCH_ONLY);
+}
+
 class ListCoinsTestingSetup : public TestChain100Setup
 {
 public:
@@ -6,12 +6,14 @@
 
 #include <wallet/wallet.h>
 
+#include <blockfilter.h>
 #include <checkpoints.h>
 #include <chain.h>
 #include <wallet/coinselection.h>
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
 #include <fs.h>
+#include <index/blockfilterindex.h>
 #include <init.h>
 #include <key.h>
 #include <key_io.h>
@@ -41,6 +43,9 @@
 
 #include <assert.h>
 #include <future>
+#include <limits>
+#include <thread>
+#include <unordered_set>
 
 #include <boost/algorithm/string/replace.hpp>
 
@@ -283,6 +288,105 @@ void CWallet::DeriveNewChildKey(WalletBatch &batch, const CKeyMetadata& metadata
         throw std::runtime_error(std::string(__func__) + ": AddHDPubKey failed");
 }
 
+/** Derives the children of parentKey starting at nFirstIndex into vExtPubKeysRet, spreading the indexes over several threads */
+static void DeriveChildExtPubKeys(const CExtKey& parentKey, uint32_t nFirstIndex, std::vector<CExtPubKey>& vExtPubKeysRet)
+{
+    std::atomic<size_t> nNext{0};
+    auto derive = [&]() {
+        for (size_t i = nNext++; i < vExtPubKeysRet.size(); i = nNext++) {
+            CExtKey childKey;
+            parentKey.Derive(childKey, nFirstIndex + i);
+            vExtPubKeysRet[i] = childKey.Neuter();
+            assert(childKey.key.VerifyPubKey(vExtPubKeysRet[i].pubkey));
+        }
+    };
+
+    const size_t nThreads = std::min(std::max(GetNumCores(), 1), MAX_KEYPOOL_DERIVE_THREADS);
+    std::vector<std::thread> vThreads;
+    for (size_t i = 1; i < nThreads && i * KEYPOOL_DERIVE_MIN_KEYS_PER_THREAD < vExtPubKeysRet.size(); i++) {
+        vThreads.emplace_back([&]() {
+            RenameThread("dash-keyderive");
+            derive();
+        });
+    }
+    derive();
+    for (auto& thread : vThreads) {
+        thread.join();
+    }
+}
+
+void CWallet::DeriveNewChildKeys(WalletBatch& batch, uint32_t nAccountIndex, bool fInternal, size_t nCount, std::vector<CPubKey>& vPubKeysRet)
+{
+    AssertLockHeld(cs_wallet); // mapKeyMetadata
+
+    vPubKeysRet.clear();
+    if (nCount == 0) {
+        return;
+    }
+
+    CHDChain hdChainTmp;
+    if (!GetHDChain(hdChainTmp)) {
+        throw std::runtime_error(std::string(__func__) + ": GetHDChain failed");
+    }
+
+    if (!DecryptHDChain(hdChainTmp))
+        throw std::runtime_error(std::string(__func__) + ": DecryptHDChain failed");
+    // make sure seed matches this chain
+    if (hdChainTmp.GetID() != hdChainTmp.GetSeedHash())
+        throw std::runtime_error(std::string(__func__) + ": Wrong HD chain!");
+
+    CHDAccount acc;
+    if (!hdChainTmp.GetAccount(nAccountIndex, acc))
+        throw std::runtime_error(std::string(__func__) + ": Wrong HD account!");
+
+    CExtKey changeKey;
+    hdChainTmp.DeriveChangeExtKey(nAccountIndex, fInternal, changeKey);
+
+    CKeyMetadata metadata(GetTime());
+    UpdateTimeFirstKey(metadata.nCreateTime);
+
+    // derive child keys at the next indexes, skip keys already known to the wallet and derive more instead
+    uint32_t nChildIndex = fInternal ? acc.nInternalChainCounter : acc.nExternalChainCounter;
+    while (vPubKeysRet.size() < nCount) {
+        std::vector<CExtPubKey> vExtPubKeys(nCount - vPubKeysRet.size());
+        DeriveChildExtPubKeys(changeKey, nChildIndex, vExtPubKeys);
+        nChildIndex += vExtPubKeys.size();
+
+        for (const CExtPubKey& extPubKey : vExtPubKeys) {
+            if (HaveKey(extPubKey.pubkey.GetID())) {
+                continue;
+            }
+            mapKeyMetadata[extPubKey.pubkey.GetID()] = metadata;
+            if (!AddHDPubKey(batch, extPubKey, fInternal))
+                throw std::runtime_error(std::string(__func__) + ": AddHDPubKey failed");
+            vPubKeysRet.push_back(extPubKey.pubkey);
+        }
+    }
+
+    // update the chain model in the database
+    CHDChain hdChainCurrent;
+    GetHDChain(hdChainCurrent);
+
+    if (fInternal) {
+        acc.nInternalChainCounter = nChildIndex;
+    }
+    else {
+        acc.nExternalChainCounter = nChildIndex;
+    }
+
+    if (!hdChainCurrent.SetAccount(nAccountIndex, acc))
+        throw std::runtime_error(std::string(__func__) + ": SetAccount failed");
+
+    if (IsCrypted()) {
+        if (!SetCryptedHDChain(batch, hdChainCurrent, false))
+            throw std::runtime_error(std::string(__func__) + ": SetCryptedHDChain failed");
+    }
+    else {
+        if (!SetHDChain(batch, hdChainCurrent, false))
+            throw std::runtime_error(std::string(__func__) + ": SetHDChain failed");
+    }
+}
+
 bool CWallet::GetPubKey(const CKeyID &address, CPubKey& vchPubKeyOut) const
 {
     LOCK(cs_wallet);
@@ -352,7 +456,9 @@ bool CWallet::AddHDPubKey(WalletBatch &batch, const CExtPubKey &extPubKey, bool
     hdPubKey.extPubKey = extPubKey;
     hdPubKey.hdchainID = hdChainCurrent.GetID();
     hdPubKey.nChangeIndex = fInternal ? 1 : 0;
+    size_t nScriptsCount = GetWalletScriptsCount();
     mapHdPubKeys[extPubKey.pubkey.GetID()] = hdPubKey;
+    AddKeyToScriptHashes(extPubKey.pubkey, nScriptsCount);
 
     // check if we need to remove from watch-only
     CScript script;
@@ -377,11 +483,13 @@ bool CWallet::AddKeyPubKeyWithDB(WalletBatch &batch, const CKey& secret, const C
     if (needsDB) {
         encrypted_batch = &batch;
     }
+    size_t nScriptsCount = GetWalletScriptsCount();
     if (!CCryptoKeyStore::AddKeyPubKey(secret, pubkey)) {
         if (needsDB) encrypted_batch = nullptr;
         return false;
     }
     if (needsDB) encrypted_batch = nullptr;
+    AddKeyToScriptHashes(pubkey, nScriptsCount);
     // check if we need to remove from watch-only
     CScript script;
     script = GetScriptForDestination(pubkey.GetID());
@@ -512,8 +620,16 @@ bool CWallet::AddWatchOnly(const CScript& dest, int64_t nCreateTime)
 bool CWallet::RemoveWatchOnly(const CScript &dest)
 {
     AssertLockHeld(cs_wallet);
-    if (!CCryptoKeyStore::RemoveWatchOnly(dest))
-        return false;
+    {
+        LOCK(cs_KeyStore);
+        size_t nScriptsCount = GetWalletScriptsCount();
+        if (!CCryptoKeyStore::RemoveWatchOnly(dest))
+            return false;
+        // a stale hash only lets the script through to ::IsMine, but the count must not match again after the next addition
+        if (m_script_hashes_count == nScriptsCount) {
+            m_script_hashes_count = GetWalletScriptsCount();
+        }
+    }
     if (!HaveWatchOnly())
         NotifyWatchonlyChanged(false);
     if (!WalletBatch(*database).EraseWatchOnly(dest))
@@ -779,10 +895,31 @@ bool CWallet::IsSpent(const uint256& hash, unsigned int n) const
     return false;
 }
 
+CWallet::WalletUTXO::WalletUTXO(const CTxOut& txout, isminetype mineIn) :
+    mine(mineIn),
+    fDenominated(CCoinJoin::IsDenominatedAmount(txout.nValue)),
+    fCoinJoinCollateral(CCoinJoin::IsCollateralAmount(txout.nValue)),
+    fMasternodeCollateral(txout.nValue == 1000 * COIN)
+{
+}
+
+bool CWallet::AddWalletUTXO(const CWalletTx& wtx, unsigned int n)
+{
+    AssertLockHeld(cs_main); // IsSpent
+    AssertLockHeld(cs_wallet);
+
+    const CTxOut& txout = wtx.tx->vout[n];
+    isminetype mine = IsMine(txout);
+    if (mine == ISMINE_NO || IsSpent(wtx.GetHash(), n)) {
+        return false;
+    }
+    return mapWalletUTXO.emplace(COutPoint(wtx.GetHash(), n), WalletUTXO(txout, mine)).second;
+}
+
 void CWallet::AddToSpends(const COutPoint& outpoint, const uint256& wtxid)
 {
     mapTxSpends.insert(std::make_pair(outpoint, wtxid));
-    setWalletUTXO.erase(outpoint);
+    mapWalletUTXO.erase(outpoint);
 
     setLockedCoins.erase(outpoint);
 
@@ -1016,7 +1153,7 @@ int64_t CWallet::IncOrderPosNext(WalletBatch *batch)
     if (batch) {
         batch->WriteOrderPosNext(nOrderPosNext);
     } else {
-        WalletBatch(*database).WriteOrderPosNext(nOrderPosNext);
+        WalletBatch(*database, "r+", false).WriteOrderPosNext(nOrderPosNext);
     }
     return nRet;
 }
@@ -1100,10 +1237,16 @@ void CWallet::MarkDirty()
         LOCK(cs_wallet);
         for (std::pair<const uint256, CWalletTx>& item : mapWallet)
             item.second.MarkDirty();
+        // keys or scripts were imported, outputs might have become spendable
+        for (auto& pair : mapWalletUTXO) {
+            const auto it = mapWallet.find(pair.first.hash);
+            if (it != mapWallet.end()) {
+                pair.second.mine = IsMine(it->second.tx->vout[pair.first.n]);
+            }
+        }
     }
 
-    fAnonymizableTallyCached = false;
-    fAnonymizableTallyCachedNonDenom = false;
+    ResetBalanceCaches();
 }
 
 bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
@@ -1126,11 +1269,12 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
         wtx.m_it_wtxOrdered = wtxOrdered.insert(std::make_pair(wtx.nOrderPos, TxPair(&wtx, nullptr)));
         wtx.nTimeSmart = ComputeTimeSmart(wtx);
         AddToSpends(hash);
+        // rounds of descendants which were seen before this tx are based on an incomplete chain
+        InvalidateCoinJoinRounds(wtx.tx, batch);
 
         auto mnList = deterministicMNManager->GetListAtChainTip();
         for(unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
-            if (IsMine(wtx.tx->vout[i]) && !IsSpent(hash, i)) {
-                setWalletUTXO.insert(COutPoint(hash, i));
+            if (AddWalletUTXO(wtx, i)) {
                 if (deterministicMNManager->IsProTxWithCollateral(wtx.tx, i) || mnList.HasMNByCollateral(COutPoint(hash, i))) {
                     LockCoin(COutPoint(hash, i));
                 }
@@ -1166,12 +1310,11 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
 
         auto mnList = deterministicMNManager->GetListAtChainTip();
         for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
-            if (IsMine(wtx.tx->vout[i]) && !IsSpent(hash, i)) {
-                bool new_utxo = setWalletUTXO.insert(COutPoint(hash, i)).second;
-                if (new_utxo && (deterministicMNManager->IsProTxWithCollateral(wtx.tx, i) || mnList.HasMNByCollateral(COutPoint(hash, i)))) {
+            if (AddWalletUTXO(wtx, i)) {
+                if (deterministicMNManager->IsProTxWithCollateral(wtx.tx, i) || mnList.HasMNByCollateral(COutPoint(hash, i))) {
                     LockCoin(COutPoint(hash, i));
                 }
-                fUpdated |= new_utxo;
+                fUpdated = true;
             }
         }
     }
@@ -1184,6 +1327,20 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
         if (!batch.WriteTx(wtx))
             return false;
 
+    if (fInsertedNew) {
+        // calculate the rounds of new denominations right away, they only depend on already known inputs
+        const int nRoundsMax = MAX_COINJOIN_ROUNDS + CCoinJoinClientOptions::GetRandomRounds();
+        std::vector<COutPoint> vecUpdated;
+        for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
+            if (CCoinJoin::IsDenominatedAmount(wtx.tx->vout[i].nValue) && IsMine(wtx.tx->vout[i])) {
+                GetRealOutpointCoinJoinRounds(COutPoint(hash, i), 0, vecUpdated);
+            }
+        }
+        for (const auto& outpoint : vecUpdated) {
+            batch.WriteCoinJoinRounds(outpoint, mapOutpointRoundsCache.at(outpoint), nRoundsMax);
+        }
+    }
+
     // Break debit/credit balance caches:
     wtx.MarkDirty();
 
@@ -1200,8 +1357,7 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
         t.detach(); // thread runs free
     }
 
-    fAnonymizableTallyCached = false;
-    fAnonymizableTallyCachedNonDenom = false;
+    ResetBalanceCaches();
 
     return true;
 }
@@ -1372,13 +1528,13 @@ bool CWallet::AbandonTransaction(const uint256& hashTx)
                 auto it = mapWallet.find(txin.prevout.hash);
                 if (it != mapWallet.end()) {
                     it->second.MarkDirty();
+                    AddWalletUTXO(it->second, txin.prevout.n);
                 }
             }
         }
     }
 
-    fAnonymizableTallyCached = false;
-    fAnonymizableTallyCachedNonDenom = false;
+    ResetBalanceCaches();
 
     return true;
 }
@@ -1436,13 +1592,13 @@ void CWallet::MarkConflicted(const uint256& hashBlock, const uint256& hashTx)
                 auto it = mapWallet.find(txin.prevout.hash);
                 if (it != mapWallet.end()) {
                     it->second.MarkDirty();
+                    AddWalletUTXO(it->second, txin.prevout.n);
                 }
             }
         }
     }
 
-    fAnonymizableTallyCached = false;
-    fAnonymizableTallyCachedNonDenom = false;
+    ResetBalanceCaches();
 }
 
 void CWallet::SyncTransaction(const CTransactionRef& ptx, const CBlockIndex *pindex, int posInBlock) {
@@ -1461,8 +1617,7 @@ void CWallet::SyncTransaction(const CTransactionRef& ptx, const CBlockIndex *pin
         }
     }
 
-    fAnonymizableTallyCached = false;
-    fAnonymizableTallyCachedNonDenom = false;
+    ResetBalanceCaches();
 }
 
 void CWallet::TransactionAddedToMempool(const CTransactionRef& ptx, int64_t nAcceptTime) {
@@ -1473,6 +1628,7 @@ void CWallet::TransactionAddedToMempool(const CTransactionRef& ptx, int64_t nAcc
     if (it != mapWallet.end()) {
         it->second.fInMempool = true;
     }
+    ResetBalanceCaches();
 }
 
 void CWallet::TransactionRemovedFromMempool(const CTransactionRef &ptx, MemPoolRemovalReason reason) {
@@ -1482,6 +1638,7 @@ void CWallet::TransactionRemovedFromMempool(const CTransactionRef &ptx, MemPoolR
         if (it != mapWallet.end()) {
             it->second.fInMempool = false;
         }
+        ResetBalanceCaches();
     }
 }
 
@@ -1536,8 +1693,7 @@ void CWallet::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const
     hashPrevBestCoinbase = pblock->vtx[0]->GetHash();
 
     // reset cache to make sure no longer immature coins are included
-    fAnonymizableTallyCached = false;
-    fAnonymizableTallyCachedNonDenom = false;
+    ResetBalanceCaches();
 }
 
 void CWallet::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexDisconnected) {
@@ -1549,8 +1705,7 @@ void CWallet::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, con
     }
 
     // reset cache to make sure no longer mature coins are excluded
-    fAnonymizableTallyCached = false;
-    fAnonymizableTallyCachedNonDenom = false;
+    ResetBalanceCaches();
 }
 
 
@@ -1613,11 +1768,30 @@ CAmount CWallet::GetDebit(const CTxIn &txin, const isminefilter& filter) const
     return 0;
 }
 
-// Recursively determine the rounds of a given input (How deep is the CoinJoin chain for a given input)
-int CWallet::GetRealOutpointCoinJoinRounds(const COutPoint& outpoint, int nRounds) const
+int CWallet::GetRealOutpointCoinJoinRounds(const COutPoint& outpoint) const
 {
     LOCK(cs_wallet);
 
+    std::vector<COutPoint> vecUpdated;
+    int nRoundsRet = GetRealOutpointCoinJoinRounds(outpoint, 0, vecUpdated);
+
+    if (!vecUpdated.empty()) {
+        const int nRoundsMax = MAX_COINJOIN_ROUNDS + CCoinJoinClientOptions::GetRandomRounds();
+        WalletBatch batch(*database, "r+", false);
+        for (const auto& outpointUpdated : vecUpdated) {
+            batch.WriteCoinJoinRounds(outpointUpdated, mapOutpointRoundsCache.at(outpointUpdated), nRoundsMax);
+        }
+    }
+
+    return nRoundsRet;
+}
+
+// Recursively determine the rounds of a given input (How deep is the CoinJoin chain for a given input)
+// Outpoints the rounds were calculated for are appended to vecUpdatedRet so that the caller can persist them
+int CWallet::GetRealOutpointCoinJoinRounds(const COutPoint& outpoint, int nRounds, std::vector<COutPoint>& vecUpdatedRet) const
+{
+    AssertLockHeld(cs_wallet);
+
     const int nRoundsMax = MAX_COINJOIN_ROUNDS + CCoinJoinClientOptions::GetRandomRounds();
 
     if (nRounds >= nRoundsMax) {
@@ -1636,7 +1810,7 @@ int CWallet::GetRealOutpointCoinJoinRounds(const COutPoint& outpoint, int nRound
     const CWalletTx* wtx = GetWalletTx(outpoint.hash);
 
     if (wtx == nullptr || wtx->tx == nullptr) {
-        // no such tx in this wallet
+        // no such tx in this wallet, not persisted as it might still be added later
         *nRoundsRef = -1;
         LogPrint(BCLog::COINJOIN, "%s FAILED    %-70s %3d\n", __func__, outpoint.ToStringShort(), -1);
         return *nRoundsRef;
@@ -1654,6 +1828,7 @@ int CWallet::GetRealOutpointCoinJoinRounds(const COutPoint& outpoint, int nRound
 
     if (CCoinJoin::IsCollateralAmount(txOutRef->nValue)) {
         *nRoundsRef = -3;
+        vecUpdatedRet.emplace_back(outpoint);
         LogPrint(BCLog::COINJOIN, "%s UPDATED   %-70s %3d\n", __func__, outpoint.ToStringShort(), *nRoundsRef);
         return *nRoundsRef;
     }
@@ -1661,6 +1836,7 @@ int CWallet::GetRealOutpointCoinJoinRounds(const COutPoint& outpoint, int nRound
     // make sure the final output is non-denominate
     if (!CCoinJoin::IsDenominatedAmount(txOutRef->nValue)) { //NOT DENOM
         *nRoundsRef = -2;
+        vecUpdatedRet.emplace_back(outpoint);
         LogPrint(BCLog::COINJOIN, "%s UPDATED   %-70s %3d\n", __func__, outpoint.ToStringShort(), *nRoundsRef);
         return *nRoundsRef;
     }
@@ -1669,6 +1845,7 @@ int CWallet::GetRealOutpointCoinJoinRounds(const COutPoint& outpoint, int nRound
         if (!CCoinJoin::IsDenominatedAmount(out.nValue)) {
             // this one is denominated but there is another non-denominated output found in the same tx
             *nRoundsRef = 0;
+            vecUpdatedRet.emplace_back(outpoint);
             LogPrint(BCLog::COINJOIN, "%s UPDATED   %-70s %3d\n", __func__, outpoint.ToStringShort(), *nRoundsRef);
             return *nRoundsRef;
         }
@@ -1679,7 +1856,7 @@ int CWallet::GetRealOutpointCoinJoinRounds(const COutPoint& outpoint, int nRound
     // only denoms here so let's look up
     for (const auto& txinNext : wtx->tx->vin) {
         if (IsMine(txinNext)) {
-            int n = GetRealOutpointCoinJoinRounds(txinNext.prevout, nRounds + 1);
+            int n = GetRealOutpointCoinJoinRounds(txinNext.prevout, nRounds + 1, vecUpdatedRet);
             // denom found, find the shortest chain or initially assign nShortest with the first found value
             if(n >= 0 && (n < nShortest || nShortest == -10)) {
                 nShortest = n;
@@ -1690,10 +1867,54 @@ int CWallet::GetRealOutpointCoinJoinRounds(const COutPoint& outpoint, int nRound
     *nRoundsRef = fDenomFound
             ? (nShortest >= nRoundsMax - 1 ? nRoundsMax : nShortest + 1) // good, we a +1 to the shortest one but only nRoundsMax rounds max allowed
             : 0;            // too bad, we are the fist one in that chain
+    vecUpdatedRet.emplace_back(outpoint);
     LogPrint(BCLog::COINJOIN, "%s UPDATED   %-70s %3d\n", __func__, outpoint.ToStringShort(), *nRoundsRef);
     return *nRoundsRef;
 }
 
+void CWallet::LoadCoinJoinRounds(const COutPoint& outpoint, int nRounds, int nRoundsMax)
+{
+    LOCK(cs_wallet);
+
+    // rounds calculated with a different limit are recalculated (and overwritten) on first use
+    if (nRoundsMax == MAX_COINJOIN_ROUNDS + CCoinJoinClientOptions::GetRandomRounds()) {
+        mapOutpointRoundsCache[outpoint] = nRounds;
+    }
+}
+
+// Drop the cached rounds for the outputs of a transaction and of all its in-wallet descendants
+void CWallet::InvalidateCoinJoinRounds(const CTransactionRef& tx, WalletBatch& batch)
+{
+    AssertLockHeld(cs_wallet);
+
+    std::set<uint256> setDone;
+    std::vector<CTransactionRef> vecTodo{tx};
+    while (!vecTodo.empty()) {
+        CTransactionRef txCur = vecTodo.back();
+        vecTodo.pop_back();
+        if (!setDone.emplace(txCur->GetHash()).second) {
+            continue;
+        }
+        for (unsigned int i = 0; i < txCur->vout.size(); ++i) {
+            COutPoint outpoint(txCur->GetHash(), i);
+            auto it = mapOutpointRoundsCache.find(outpoint);
+            if (it != mapOutpointRoundsCache.end()) {
+                if (it->second != -1 && it->second != -4) {
+                    batch.EraseCoinJoinRounds(outpoint);
+                }
+                mapOutpointRoundsCache.erase(it);
+            }
+            auto range = mapTxSpends.equal_range(outpoint);
+            for (auto itSpend = range.first; itSpend != range.second; ++itSpend) {
+                auto itWtx = mapWallet.find(itSpend->second);
+                if (itWtx != mapWallet.end() && !setDone.count(itSpend->second)) {
+                    vecTodo.emplace_back(itWtx->second.tx);
+                }
+            }
+        }
+    }
+}
+
 // respect current settings
 int CWallet::GetCappedOutpointCoinJoinRounds(const COutPoint& outpoint) const
 {
@@ -1743,6 +1964,19 @@ bool CWallet::IsFullyMixed(const COutPoint& outpoint) const
 
 isminetype CWallet::IsMine(const CTxOut& txout) const
 {
+    {
+        LOCK2(cs_wallet, cs_KeyStore);
+        size_t nScriptsCount = GetWalletScriptsCount();
+        if (m_script_hashes_count != nScriptsCount) {
+            // keys or scripts were added without going through AddKeyToScriptHashes, e.g. imported or loaded
+            m_script_hashes.setHashes.clear();
+            ForEachWalletScript([&](const CScript& script) { m_script_hashes.Add(script); });
+            m_script_hashes_count = nScriptsCount;
+        }
+        if (!m_script_hashes.MayBeMine(txout.scriptPubKey)) {
+            return ISMINE_NO;
+        }
+    }
     return ::IsMine(*this, txout.scriptPubKey);
 }
 
@@ -2173,6 +2407,103 @@ int64_t CWallet::RescanFromTime(int64_t startTime, const WalletRescanReserver& r
     return startTime;
 }
 
+void WalletScriptHashes::Add(const CScript& script)
+{
+    uint160 hash;
+    if (script.IsPayToPublicKeyHash()) {
+        memcpy(hash.begin(), &script[3], 20);
+        setHashes.emplace(TX_PUBKEYHASH, hash);
+    } else if (script.IsPayToScriptHash()) {
+        memcpy(hash.begin(), &script[2], 20);
+        setHashes.emplace(TX_SCRIPTHASH, hash);
+    }
+}
+
+bool WalletScriptHashes::MayBeMine(const CScript& script) const
+{
+    uint160 hash;
+    if (script.IsPayToPublicKeyHash()) {
+        memcpy(hash.begin(), &script[3], 20);
+        return setHashes.count(std::make_pair((int)TX_PUBKEYHASH, hash)) != 0;
+    } else if (script.IsPayToScriptHash()) {
+        memcpy(hash.begin(), &script[2], 20);
+        return setHashes.count(std::make_pair((int)TX_SCRIPTHASH, hash)) != 0;
+    }
+    return true;
+}
+
+/**
+ * The scripts of the wallet, precomputed so that the rescan workers can match blocks without taking cs_wallet.
+ * P2PKH and P2SH outputs are looked up by their hash, all other scripts are left to AddToWalletIfInvolvingMe.
+ */
+struct WalletRescanScripts
+{
+    WalletScriptHashes hashes;
+    //! The scripts block filters are queried with
+    GCSFilter::ElementSet filterElements;
+
+    void Add(const CScript& script)
+    {
+        hashes.Add(script);
+        filterElements.emplace(script.begin(), script.end());
+    }
+
+    //! Whether one of the outputs of tx may be ours, false positives are fine
+    bool MayBeMine(const CTransaction& tx) const
+    {
+        for (const CTxOut& txout : tx.vout) {
+            const CScript& script = txout.scriptPubKey;
+            if (script.empty() || script[0] == OP_RETURN) continue;
+            if (hashes.MayBeMine(script)) return true;
+        }
+        return false;
+    }
+};
+
+size_t CWallet::GetWalletScriptsCount() const
+{
+    LOCK2(cs_wallet, cs_KeyStore);
+    return mapKeys.size() + mapCryptedKeys.size() + mapHdPubKeys.size() + mapScripts.size() + setWatchOnly.size();
+}
+
+void CWallet::ForEachWalletScript(const std::function<void(const CScript&)>& fn) const
+{
+    LOCK2(cs_wallet, cs_KeyStore);
+    std::set<CKeyID> setKeyIDs = GetKeys();
+    for (const auto& entry : mapHdPubKeys) {
+        setKeyIDs.insert(entry.first);
+    }
+    for (const CKeyID& keyID : setKeyIDs) {
+        fn(GetScriptForDestination(keyID));
+        CPubKey pubkey;
+        if (GetPubKey(keyID, pubkey)) {
+            fn(GetScriptForRawPubKey(pubkey));
+        }
+    }
+    for (const auto& entry : mapScripts) {
+        fn(GetScriptForDestination(entry.first));
+    }
+    for (const CScript& script : setWatchOnly) {
+        fn(script);
+    }
+}
+
+void CWallet::GetRescanScripts(WalletRescanScripts& scriptsRet) const
+{
+    scriptsRet.hashes.setHashes.clear();
+    scriptsRet.filterElements.clear();
+    ForEachWalletScript([&](const CScript& script) { scriptsRet.Add(script); });
+}
+
+void CWallet::AddKeyToScriptHashes(const CPubKey& pubkey, size_t nCountBefore)
+{
+    LOCK2(cs_wallet, cs_KeyStore);
+    // if the hashes were already behind, IsMine rebuilds them anyway
+    if (m_script_hashes_count != nCountBefore) return;
+    m_script_hashes.Add(GetScriptForDestination(pubkey.GetID()));
+    m_script_hashes_count = GetWalletScriptsCount();
+}
+
 /**
  * Scan the block chain (starting in pindexStart) for transactions
  * from or to us. If fUpdate is true, found transactions that already
@@ -2199,10 +2530,17 @@ CBlockIndex* CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, CBlock
         assert(pindexStop->nHeight >= pindexStart->nHeight);
     }
 
+    int nThreads = gArgs.GetArg("-rescanthreads", DEFAULT_RESCAN_THREADS);
+    if (nThreads <= 0) {
+        nThreads = GetNumCores();
+    }
+    nThreads = std::max(1, std::min(nThreads, MAX_RESCAN_THREADS));
+    const size_t nBatchSize = nThreads * RESCAN_BATCH_BLOCKS_PER_THREAD;
+
     CBlockIndex* pindex = pindexStart;
     CBlockIndex* ret = nullptr;
 
-    if (pindex) LogPrintf("Rescan started from block %d...\n", pindex->nHeight);
+    if (pindex) LogPrintf("Rescan started from block %d with %d threads...\n", pindex->nHeight, nThreads);
 
     {
         fAbortRescan = false;
@@ -2221,39 +2559,142 @@ CBlockIndex* CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, CBlock
             }
         }
         double progress_current = progress_begin;
+
+        // Blocks are read and matched against the scripts of the wallet by nThreads workers, a batch at a time, and
+        // the matches are then added to the wallet in order. This thread may hold cs_main and cs_wallet (e.g. when
+        // called on startup), so the workers must not take any locks.
+        struct RescanBlock {
+            CBlockIndex* pindex;
+            CDiskBlockPos pos;
+            double progress;
+            //! set by the workers
+            bool fSkipped{false};
+            bool fReadFailed{false};
+            CBlock block;
+            std::vector<bool> vMayBeMine;
+        };
+        // Blocks whose basic filter doesn't match any script of the wallet are not read at all. Bare multisig outputs
+        // and conflicts with wallet transactions which only spend coins of others are not found in such blocks.
+        const BlockFilterIndex* filter_index = GetBlockFilterIndex(BlockFilterType::BASIC_FILTER);
+        WalletRescanScripts scripts;
+        GetRescanScripts(scripts);
+        size_t nScriptsCount = GetWalletScriptsCount();
+        auto fSpendsFromWallet = [this](const CTransaction& tx) {
+            AssertLockHeld(cs_wallet);
+            for (const CTxIn& txin : tx.vin) {
+                if (mapWallet.count(txin.prevout.hash) || mapTxSpends.count(txin.prevout)) {
+                    return true;
+                }
+            }
+            return false;
+        };
+
         while (pindex && !fAbortRescan && !ShutdownRequested())
         {
-            m_scanning_progress = (progress_current - progress_begin) / (progress_end - progress_begin);
-            if (pindex->nHeight % 100 == 0 && progress_end - progress_begin > 0.0) {
-                ShowProgress(_("Rescanning..."), std::max(1, std::min(99, (int)(m_scanning_progress * 100))));
+            std::vector<RescanBlock> vBatch;
+            {
+                LOCK(cs_main);
+                for (CBlockIndex* pindexBatch = pindex; pindexBatch && vBatch.size() < nBatchSize; pindexBatch = chainActive.Next(pindexBatch)) {
+                    vBatch.emplace_back();
+                    vBatch.back().pindex = pindexBatch;
+                    vBatch.back().pos = pindexBatch->GetBlockPos();
+                    vBatch.back().progress = GuessVerificationProgress(chainParams.TxData(), pindexBatch);
+                    if (pindexBatch == pindexStop) {
+                        break;
+                    }
+                }
             }
-            if (GetTime() >= nNow + 60) {
-                nNow = GetTime();
-                LogPrintf("Still rescanning. At block %d. Progress=%f\n", pindex->nHeight, progress_current);
+
+            std::atomic<size_t> nNext{0};
+            auto worker = [&] {
+                for (size_t i = nNext++; i < vBatch.size() && !fAbortRescan && !ShutdownRequested(); i = nNext++) {
+                    RescanBlock& entry = vBatch[i];
+                    BlockFilter filter;
+                    if (filter_index && filter_index->LookupFilter(entry.pindex, filter) &&
+                            !filter.GetFilter().MatchAny(scripts.filterElements)) {
+                        entry.fSkipped = true;
+                        continue;
+                    }
+                    if (!ReadBlockFromDisk(entry.block, entry.pos, chainParams.GetConsensus()) ||
+                            entry.block.GetHash() != entry.pindex->GetBlockHash()) {
+                        entry.fReadFailed = true;
+                        continue;
+                    }
+                    entry.vMayBeMine.reserve(entry.block.vtx.size());
+                    for (const CTransactionRef& tx : entry.block.vtx) {
+                        entry.vMayBeMine.push_back(scripts.MayBeMine(*tx));
+                    }
+                }
+            };
+            std::vector<std::thread> vThreads;
+            for (int i = 1; i < nThreads && (size_t)i < vBatch.size(); i++) {
+                vThreads.emplace_back([&, i] {
+                    RenameThread(strprintf("dash-rescan-%d", i).c_str());
+                    worker();
+                });
+            }
+            worker();
+            for (auto& thread : vThreads) {
+                thread.join();
             }
 
-            CBlock block;
-            if (ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
-                LOCK2(cs_main, cs_wallet);
-                if (pindex && !chainActive.Contains(pindex)) {
-                    // Abort scan if current block is no longer active, to prevent
-                    // marking transactions as coming from the wrong block.
-                    ret = pindex;
+            CBlockIndex* pindexLast = nullptr;
+            for (RescanBlock& entry : vBatch) {
+                if (fAbortRescan || ShutdownRequested()) {
+                    pindex = entry.pindex;
+                    pindexLast = nullptr;
                     break;
                 }
-                for (size_t posInBlock = 0; posInBlock < block.vtx.size(); ++posInBlock) {
-                    AddToWalletIfInvolvingMe(block.vtx[posInBlock], pindex, posInBlock, fUpdate);
+                pindexLast = entry.pindex;
+                progress_current = entry.progress;
+                m_scanning_progress = (progress_current - progress_begin) / (progress_end - progress_begin);
+                if (entry.pindex->nHeight % 100 == 0 && progress_end - progress_begin > 0.0) {
+                    ShowProgress(_("Rescanning..."), std::max(1, std::min(99, (int)(m_scanning_progress * 100))));
+                }
+                if (GetTime() >= nNow + 60) {
+                    nNow = GetTime();
+                    LogPrintf("Still rescanning. At block %d. Progress=%f\n", entry.pindex->nHeight, progress_current);
+                }
+
+                if (entry.fReadFailed) {
+                    ret = entry.pindex;
+                } else if (!entry.fSkipped) {
+                    LOCK2(cs_main, cs_wallet);
+                    if (!chainActive.Contains(entry.pindex)) {
+                        // Abort scan if current block is no longer active, to prevent
+                        // marking transactions as coming from the wrong block.
+                        ret = entry.pindex;
+                        pindex = nullptr;
+                        break;
+                    }
+                    for (size_t posInBlock = 0; posInBlock < entry.block.vtx.size(); ++posInBlock) {
+                        const CTransactionRef& tx = entry.block.vtx[posInBlock];
+                        // Spends of wallet transactions and conflicts with them are found by their inputs, which
+                        // depend on the transactions added before.
+                        if (entry.vMayBeMine[posInBlock] || mapWallet.count(tx->GetHash()) || fSpendsFromWallet(*tx)) {
+                            AddToWalletIfInvolvingMe(tx, entry.pindex, posInBlock, fUpdate);
+                        }
+                    }
+                }
+                if (entry.pindex == pindexStop) {
+                    pindex = nullptr;
+                    break;
+                }
+                // New keys (e.g. a keypool top-up after a used key was found) may be used by the rest of the batch,
+                // which was matched without them, so it is matched again.
+                size_t nScriptsCountNew = GetWalletScriptsCount();
+                if (nScriptsCountNew != nScriptsCount) {
+                    nScriptsCount = nScriptsCountNew;
+                    GetRescanScripts(scripts);
+                    break;
                 }
-            } else {
-                ret = pindex;
             }
-            if (pindex == pindexStop) {
+            if (!pindex || !pindexLast) {
                 break;
             }
             {
                 LOCK(cs_main);
-                pindex = chainActive.Next(pindex);
-                progress_current = GuessVerificationProgress(chainParams.TxData(), pindex);
+                pindex = chainActive.Next(pindexLast);
                 if (pindexStop == nullptr && tip != chainActive.Tip()) {
                     tip = chainActive.Tip();
                     // in case the tip has changed, update progress max
@@ -2294,11 +2735,18 @@ void CWallet::ReacceptWalletTransactions()
         }
     }
 
-    // Try to add wallet transactions to memory pool
+    // Try to add wallet transactions to memory pool, all at once as they are often chained
+    std::vector<CTransactionRef> vtx;
+    vtx.reserve(mapSorted.size());
     for (std::pair<const int64_t, CWalletTx*>& item : mapSorted) {
-        CWalletTx& wtx = *(item.second);
-        CValidationState state;
-        wtx.AcceptToMemoryPool(maxTxFee, state);
+        vtx.emplace_back(item.second->tx);
+    }
+    std::vector<CValidationState> vStates;
+    std::vector<bool> vAccepted;
+    AcceptPackageToMemoryPool(mempool, vtx, vStates, vAccepted, false /* bypass_limits */, maxTxFee);
+    size_t i = 0;
+    for (std::pair<const int64_t, CWalletTx*>& item : mapSorted) {
+        item.second->fInMempool |= vAccepted[i++];
     }
 }
 
@@ -2676,27 +3124,60 @@ std::unordered_set<const CWalletTx*, WalletTxHasher> CWallet::GetSpendableTXs()
     AssertLockHeld(cs_wallet);
 
     std::unordered_set<const CWalletTx*, WalletTxHasher> ret;
-    for (auto it = setWalletUTXO.begin(); it != setWalletUTXO.end(); ) {
-        const auto& outpoint = *it;
+    for (auto it = mapWalletUTXO.begin(); it != mapWalletUTXO.end(); ) {
+        const COutPoint& outpoint = it->first;
         const auto jt = mapWallet.find(outpoint.hash);
         if (jt != mapWallet.end()) {
             ret.emplace(&jt->second);
         }
 
-        // setWalletUTXO is sorted by COutPoint, which means that all UTXOs for the same TX are neighbors
+        // mapWalletUTXO is sorted by COutPoint, which means that all UTXOs for the same TX are neighbors
         // skip entries until we encounter a new TX
-        while (it != setWalletUTXO.end() && it->hash == outpoint.hash) {
-            ++it;
-        }
+        it = mapWalletUTXO.upper_bound(COutPoint(outpoint.hash, std::numeric_limits<uint32_t>::max()));
     }
     return ret;
 }
 
+const CWallet::Balances& CWallet::GetCachedBalances() const
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+
+    if (balancesCached.fValid) {
+        return balancesCached;
+    }
+
+    Balances balances;
+    for (auto pcoin : GetSpendableTXs()) {
+        const bool fTrusted = pcoin->IsTrusted();
+        if (fTrusted) {
+            balances.nTrusted += pcoin->GetAvailableCredit(true, ISMINE_SPENDABLE);
+            balances.nTrustedWatchOnly += pcoin->GetAvailableCredit(true, ISMINE_WATCH_ONLY);
+        } else if (pcoin->GetDepthInMainChain() == 0 && !pcoin->IsLockedByInstantSend() && pcoin->InMempool()) {
+            balances.nUntrustedPending += pcoin->GetAvailableCredit();
+            balances.nUntrustedPendingWatchOnly += pcoin->GetAvailableCredit(true, ISMINE_WATCH_ONLY);
+        }
+        balances.nImmature += pcoin->GetImmatureCredit();
+        balances.nImmatureWatchOnly += pcoin->GetImmatureWatchOnlyCredit();
+    }
+    balances.fValid = true;
+    balancesCached = balances;
+
+    return balancesCached;
+}
+
 CAmount CWallet::GetBalance(const isminefilter& filter, const int min_depth, const bool fAddLocked) const
 {
     CAmount nTotal = 0;
     {
         LOCK2(cs_main, cs_wallet);
+        // trusted transactions are never conflicted and IS locked ones are trusted, the depth check is a no-op then
+        if (min_depth <= 0 && (filter == ISMINE_SPENDABLE || filter == ISMINE_WATCH_ONLY || filter == ISMINE_ALL)) {
+            const auto& balances = GetCachedBalances();
+            if (filter & ISMINE_SPENDABLE) nTotal += balances.nTrusted;
+            if (filter & ISMINE_WATCH_ONLY) nTotal += balances.nTrustedWatchOnly;
+            return nTotal;
+        }
         for (auto pcoin : GetSpendableTXs()) {
             if (pcoin->IsTrusted() && ((pcoin->GetDepthInMainChain() >= min_depth) || (fAddLocked && pcoin->IsLockedByInstantSend()))) {
                 nTotal += pcoin->GetAvailableCredit(true, filter);
@@ -2707,10 +3188,8 @@ CAmount CWallet::GetBalance(const isminefilter& filter, const int min_depth, con
     return nTotal;
 }
 
-CAmount CWallet::GetAnonymizableBalance(bool fSkipDenominated, bool fSkipUnconfirmed) const
+CAmount CWallet::CalculateAnonymizableBalance(bool fSkipDenominated, bool fSkipUnconfirmed) const
 {
-    if (!CCoinJoinClientOptions::IsEnabled()) return 0;
-
     std::vector<CompactTallyItem> vecTally;
     if(!SelectCoinsGroupedByAddresses(vecTally, fSkipDenominated, true, fSkipUnconfirmed)) return 0;
 
@@ -2729,14 +3208,13 @@ CAmount CWallet::GetAnonymizableBalance(bool fSkipDenominated, bool fSkipUnconfi
     return nTotal;
 }
 
-CAmount CWallet::GetAnonymizedBalance(const CCoinControl* coinControl) const
+CAmount CWallet::CalculateAnonymizedBalance(const CCoinControl* coinControl) const
 {
-    if (!CCoinJoinClientOptions::IsEnabled()) return 0;
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
 
     CAmount nTotal = 0;
 
-    LOCK2(cs_main, cs_wallet);
-
     for (auto pcoin : GetSpendableTXs()) {
         nTotal += pcoin->GetAnonymizedCredit(coinControl);
     }
@@ -2746,16 +3224,17 @@ CAmount CWallet::GetAnonymizedBalance(const CCoinControl* coinControl) const
 
 // Note: calculated including unconfirmed,
 // that's ok as long as we use it for informational purposes only
-float CWallet::GetAverageAnonymizedRounds() const
+float CWallet::CalculateAverageAnonymizedRounds() const
 {
-    if (!CCoinJoinClientOptions::IsEnabled()) return 0;
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
 
     int nTotal = 0;
     int nCount = 0;
 
-    LOCK2(cs_main, cs_wallet);
-    for (const auto& outpoint : setWalletUTXO) {
-        if(!IsDenominated(outpoint)) continue;
+    for (const auto& pair : mapWalletUTXO) {
+        const COutPoint& outpoint = pair.first;
+        if (!pair.second.fDenominated) continue;
 
         nTotal += GetCappedOutpointCoinJoinRounds(outpoint);
         nCount++;
@@ -2768,19 +3247,20 @@ float CWallet::GetAverageAnonymizedRounds() const
 
 // Note: calculated including unconfirmed,
 // that's ok as long as we use it for informational purposes only
-CAmount CWallet::GetNormalizedAnonymizedBalance() const
+CAmount CWallet::CalculateNormalizedAnonymizedBalance() const
 {
-    if (!CCoinJoinClientOptions::IsEnabled()) return 0;
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
 
     CAmount nTotal = 0;
 
-    LOCK2(cs_main, cs_wallet);
-    for (const auto& outpoint : setWalletUTXO) {
+    for (const auto& pair : mapWalletUTXO) {
+        const COutPoint& outpoint = pair.first;
+        if (!pair.second.fDenominated) continue;
         const auto it = mapWallet.find(outpoint.hash);
         if (it == mapWallet.end()) continue;
 
         CAmount nValue = it->second.tx->vout[outpoint.n].nValue;
-        if (!CCoinJoin::IsDenominatedAmount(nValue)) continue;
         if (it->second.GetDepthInMainChain() < 0) continue;
 
         int nRounds = GetCappedOutpointCoinJoinRounds(outpoint);
@@ -2790,14 +3270,13 @@ CAmount CWallet::GetNormalizedAnonymizedBalance() const
     return nTotal;
 }
 
-CAmount CWallet::GetDenominatedBalance(bool unconfirmed) const
+CAmount CWallet::CalculateDenominatedBalance(bool unconfirmed) const
 {
-    if (!CCoinJoinClientOptions::IsEnabled()) return 0;
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
 
     CAmount nTotal = 0;
 
-    LOCK2(cs_main, cs_wallet);
-
     for (auto pcoin : GetSpendableTXs()) {
         nTotal += pcoin->GetDenominatedCredit(unconfirmed);
     }
@@ -2805,54 +3284,113 @@ CAmount CWallet::GetDenominatedBalance(bool unconfirmed) const
     return nTotal;
 }
 
-CAmount CWallet::GetUnconfirmedBalance() const
+void CWallet::ResetBalanceCaches()
 {
-    CAmount nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
-        for (auto pcoin : GetSpendableTXs()) {
-            if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 && !pcoin->IsLockedByInstantSend() && pcoin->InMempool())
-                nTotal += pcoin->GetAvailableCredit();
-        }
+    balancesCached.fValid = false;
+    fAnonymizableTallyCached = false;
+    fAnonymizableTallyCachedNonDenom = false;
+    coinJoinBalancesCached.nRounds = -1;
+}
+
+const CWallet::CoinJoinBalances& CWallet::GetCoinJoinBalances() const
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+
+    // fully mixed outputs depend on the currently configured rounds
+    if (coinJoinBalancesCached.nRounds == CCoinJoinClientOptions::GetRounds()) {
+        return coinJoinBalancesCached;
     }
-    return nTotal;
+
+    // the tally caches depend on the configured rounds too, recalculate them along with the balances
+    fAnonymizableTallyCached = false;
+    fAnonymizableTallyCachedNonDenom = false;
+
+    CoinJoinBalances balances;
+    balances.nRounds = CCoinJoinClientOptions::GetRounds();
+    balances.nAnonymizable = CalculateAnonymizableBalance(false, true);
+    balances.nAnonymizableNonDenom = CalculateAnonymizableBalance(true, true);
+    balances.nAnonymized = CalculateAnonymizedBalance(nullptr);
+    balances.nDenominatedConf = CalculateDenominatedBalance(false);
+    balances.nDenominatedUnconf = CalculateDenominatedBalance(true);
+    balances.nNormalizedAnonymized = CalculateNormalizedAnonymizedBalance();
+    balances.nAverageAnonymizedRounds = CalculateAverageAnonymizedRounds();
+    coinJoinBalancesCached = balances;
+
+    return coinJoinBalancesCached;
 }
 
-CAmount CWallet::GetImmatureBalance() const
+CAmount CWallet::GetAnonymizableBalance(bool fSkipDenominated, bool fSkipUnconfirmed) const
 {
-    CAmount nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
-        for (auto pcoin : GetSpendableTXs()) {
-            nTotal += pcoin->GetImmatureCredit();
-        }
+    if (!CCoinJoinClientOptions::IsEnabled()) return 0;
+
+    if (!fSkipUnconfirmed) {
+        return CalculateAnonymizableBalance(fSkipDenominated, fSkipUnconfirmed);
     }
-    return nTotal;
+
+    LOCK2(cs_main, cs_wallet);
+    const auto& balances = GetCoinJoinBalances();
+    return fSkipDenominated ? balances.nAnonymizableNonDenom : balances.nAnonymizable;
 }
 
-CAmount CWallet::GetUnconfirmedWatchOnlyBalance() const
+CAmount CWallet::GetAnonymizedBalance(const CCoinControl* coinControl) const
 {
-    CAmount nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
-        for (auto pcoin : GetSpendableTXs()) {
-            if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 && !pcoin->IsLockedByInstantSend() && pcoin->InMempool())
-                nTotal += pcoin->GetAvailableCredit(true, ISMINE_WATCH_ONLY);
-        }
+    if (!CCoinJoinClientOptions::IsEnabled()) return 0;
+
+    LOCK2(cs_main, cs_wallet);
+    if (coinControl != nullptr) {
+        return CalculateAnonymizedBalance(coinControl);
     }
-    return nTotal;
+    return GetCoinJoinBalances().nAnonymized;
+}
+
+float CWallet::GetAverageAnonymizedRounds() const
+{
+    if (!CCoinJoinClientOptions::IsEnabled()) return 0;
+
+    LOCK2(cs_main, cs_wallet);
+    return GetCoinJoinBalances().nAverageAnonymizedRounds;
+}
+
+CAmount CWallet::GetNormalizedAnonymizedBalance() const
+{
+    if (!CCoinJoinClientOptions::IsEnabled()) return 0;
+
+    LOCK2(cs_main, cs_wallet);
+    return GetCoinJoinBalances().nNormalizedAnonymized;
+}
+
+CAmount CWallet::GetDenominatedBalance(bool unconfirmed) const
+{
+    if (!CCoinJoinClientOptions::IsEnabled()) return 0;
+
+    LOCK2(cs_main, cs_wallet);
+    const auto& balances = GetCoinJoinBalances();
+    return unconfirmed ? balances.nDenominatedUnconf : balances.nDenominatedConf;
+}
+
+CAmount CWallet::GetUnconfirmedBalance() const
+{
+    LOCK2(cs_main, cs_wallet);
+    return GetCachedBalances().nUntrustedPending;
+}
+
+CAmount CWallet::GetImmatureBalance() const
+{
+    LOCK2(cs_main, cs_wallet);
+    return GetCachedBalances().nImmature;
+}
+
+CAmount CWallet::GetUnconfirmedWatchOnlyBalance() const
+{
+    LOCK2(cs_main, cs_wallet);
+    return GetCachedBalances().nUntrustedPendingWatchOnly;
 }
 
 CAmount CWallet::GetImmatureWatchOnlyBalance() const
 {
-    CAmount nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
-        for (auto pcoin : GetSpendableTXs()) {
-            nTotal += pcoin->GetImmatureWatchOnlyCredit();
-        }
-    }
-    return nTotal;
+    LOCK2(cs_main, cs_wallet);
+    return GetCachedBalances().nImmatureWatchOnly;
 }
 
 // Calculate total balance in a different way from GetBalance. The biggest
@@ -2923,8 +3461,15 @@ void CWallet::AvailableCoins(std::vector<COutput> &vCoins, bool fOnlySafe, const
 
     CAmount nTotal = 0;
 
-    for (auto pcoin : GetSpendableTXs()) {
-        const uint256& wtxid = pcoin->GetHash();
+    // the UTXOs of a transaction are neighbors in mapWalletUTXO, the checks of the transaction are done once for all of them
+    for (auto it = mapWalletUTXO.begin(), itNextTx = it; it != mapWalletUTXO.end(); it = itNextTx) {
+        const uint256 wtxid = it->first.hash;
+        itNextTx = mapWalletUTXO.upper_bound(COutPoint(wtxid, std::numeric_limits<uint32_t>::max()));
+
+        const auto jt = mapWallet.find(wtxid);
+        if (jt == mapWallet.end())
+            continue;
+        const CWalletTx* pcoin = &jt->second;
 
         if (!CheckFinalTx(*pcoin->tx))
             continue;
@@ -2948,21 +3493,23 @@ void CWallet::AvailableCoins(std::vector<COutput> &vCoins, bool fOnlySafe, const
         if (nDepth < nMinDepth || nDepth > nMaxDepth)
             continue;
 
-        for (unsigned int i = 0; i < pcoin->tx->vout.size(); i++) {
+        for (auto itUTXO = it; itUTXO != itNextTx; ++itUTXO) {
+            const unsigned int i = itUTXO->first.n;
+            const WalletUTXO& utxo = itUTXO->second;
             bool found = false;
             if (nCoinType == CoinType::ONLY_FULLY_MIXED) {
-                if (!CCoinJoin::IsDenominatedAmount(pcoin->tx->vout[i].nValue)) continue;
-                found = IsFullyMixed(COutPoint(wtxid, i));
+                if (!utxo.fDenominated) continue;
+                found = IsFullyMixed(itUTXO->first);
             } else if(nCoinType == CoinType::ONLY_READY_TO_MIX) {
-                if (!CCoinJoin::IsDenominatedAmount(pcoin->tx->vout[i].nValue)) continue;
-                found = !IsFullyMixed(COutPoint(wtxid, i));
+                if (!utxo.fDenominated) continue;
+                found = !IsFullyMixed(itUTXO->first);
             } else if(nCoinType == CoinType::ONLY_NONDENOMINATED) {
-                if (CCoinJoin::IsCollateralAmount(pcoin->tx->vout[i].nValue)) continue; // do not use collateral amounts
-                found = !CCoinJoin::IsDenominatedAmount(pcoin->tx->vout[i].nValue);
+                if (utxo.fCoinJoinCollateral) continue; // do not use collateral amounts
+                found = !utxo.fDenominated;
             } else if(nCoinType == CoinType::ONLY_MASTERNODE_COLLATERAL) {
-                found = pcoin->tx->vout[i].nValue == 1000*COIN;
+                found = utxo.fMasternodeCollateral;
             } else if(nCoinType == CoinType::ONLY_COINJOIN_COLLATERAL) {
-                found = CCoinJoin::IsCollateralAmount(pcoin->tx->vout[i].nValue);
+                found = utxo.fCoinJoinCollateral;
             } else {
                 found = true;
             }
@@ -2980,7 +3527,7 @@ void CWallet::AvailableCoins(std::vector<COutput> &vCoins, bool fOnlySafe, const
             if (IsSpent(wtxid, i))
                 continue;
 
-            isminetype mine = IsMine(pcoin->tx->vout[i]);
+            isminetype mine = utxo.mine;
 
             if (mine == ISMINE_NO) {
                 continue;
@@ -3107,6 +3654,11 @@ bool CWallet::OutputEligibleForSpending(const COutput& output, const CoinEligibi
     if ((output.nDepth < (output.tx->IsFromMe(ISMINE_ALL) ? eligibility_filter.conf_mine : eligibility_filter.conf_theirs)) && !fLockedByIS)
         return false;
 
+    // confirmed transactions are not in the mempool, don't look them up for every output and filter
+    if (output.nDepth > 0) {
+        return true;
+    }
+
     size_t ancestors, descendants;
     mempool.GetTransactionAncestry(output.tx->GetHash(), ancestors, descendants);
     if (ancestors > eligibility_filter.max_ancestors || descendants > eligibility_filter.max_descendants) {
@@ -3116,7 +3668,7 @@ bool CWallet::OutputEligibleForSpending(const COutput& output, const CoinEligibi
     return true;
 }
 
-bool CWallet::SelectCoinsMinConf(const CAmount& nTargetValue, const CoinEligibilityFilter& eligibility_filter, std::vector<COutput> vCoins,
+bool CWallet::SelectCoinsMinConf(const CAmount& nTargetValue, const CoinEligibilityFilter& eligibility_filter, const std::vector<COutput>& vCoins,
                                  std::set<CInputCoin>& setCoinsRet, CAmount& nValueRet, const CoinSelectionParams& coin_selection_params, bool& bnb_used, CoinType nCoinType) const
 {
     setCoinsRet.clear();
@@ -3229,12 +3781,10 @@ bool CWallet::SelectCoins(const std::vector<COutput>& vAvailableCoins, const CAm
     }
 
     // remove preset inputs from vCoins
-    for (std::vector<COutput>::iterator it = vCoins.begin(); it != vCoins.end() && coin_control.HasSelected();)
-    {
-        if (setPresetCoins.count(CInputCoin(it->tx->tx, it->i)))
-            it = vCoins.erase(it);
-        else
-            ++it;
+    if (coin_control.HasSelected()) {
+        vCoins.erase(std::remove_if(vCoins.begin(), vCoins.end(), [&](const COutput& output) {
+            return setPresetCoins.count(CInputCoin(output.tx->tx, output.i)) != 0;
+        }), vCoins.end());
     }
 
     size_t max_ancestors = (size_t)std::max<int64_t>(1, gArgs.GetArg("-limitancestorcount", DEFAULT_ANCESTOR_LIMIT));
@@ -3390,7 +3940,8 @@ bool CWallet::SelectCoinsGroupedByAddresses(std::vector<CompactTallyItem>& vecTa
     // Tally
     std::map<CTxDestination, CompactTallyItem> mapTally;
     std::set<uint256> setWalletTxesCounted;
-    for (const auto& outpoint : setWalletUTXO) {
+    for (const auto& pair : mapWalletUTXO) {
+        const COutPoint& outpoint = pair.first;
 
         if (!setWalletTxesCounted.emplace(outpoint.hash).second) continue;
 
@@ -3499,7 +4050,8 @@ int CWallet::CountInputsWithAmount(CAmount nInputAmount) const
 
     LOCK2(cs_main, cs_wallet);
 
-    for (const auto& outpoint : setWalletUTXO) {
+    for (const auto& pair : mapWalletUTXO) {
+        const COutPoint& outpoint = pair.first;
         const auto it = mapWallet.find(outpoint.hash);
         if (it == mapWallet.end()) continue;
         if (it->second.tx->vout[outpoint.n].nValue != nInputAmount) continue;
@@ -4087,9 +4639,7 @@ DBErrors CWallet::LoadWallet(bool& fFirstRunRet)
         LOCK2(cs_main, cs_wallet);
         for (auto& pair : mapWallet) {
             for(unsigned int i = 0; i < pair.second.tx->vout.size(); ++i) {
-                if (IsMine(pair.second.tx->vout[i]) && !IsSpent(pair.first, i)) {
-                    setWalletUTXO.insert(COutPoint(pair.first, i));
-                }
+                AddWalletUTXO(pair.second, i);
             }
         }
     }
@@ -4124,10 +4674,13 @@ DBErrors CWallet::ZapSelectTx(std::vector<uint256>& vHashIn, std::vector<uint256
 {
     AssertLockHeld(cs_wallet); // mapWallet
     DBErrors nZapSelectTxRet = WalletBatch(*database,"cr+").ZapSelectTx(vHashIn, vHashOut);
+    WalletBatch batch(*database, "r+", false);
     for (uint256 hash : vHashOut) {
         const auto& it = mapWallet.find(hash);
+        InvalidateCoinJoinRounds(it->second.tx, batch);
         wtxOrdered.erase(it->second.m_it_wtxOrdered);
         mapWallet.erase(it);
+        mapWalletUTXO.erase(mapWalletUTXO.lower_bound(COutPoint(hash, 0)), mapWalletUTXO.upper_bound(COutPoint(hash, std::numeric_limits<uint32_t>::max())));
     }
 
     if (nZapSelectTxRet == DBErrors::NEED_REWRITE)
@@ -4190,13 +4743,15 @@ bool CWallet::SetAddressBook(const CTxDestination& address, const std::string& s
     }
     NotifyAddressBookChanged(this, address, strName, ::IsMine(*this, address) != ISMINE_NO,
                              strPurpose, (fUpdated ? CT_UPDATED : CT_NEW) );
-    if (!strPurpose.empty() && !WalletBatch(*database).WritePurpose(EncodeDestination(address), strPurpose))
+    WalletBatch batch(*database, "r+", false);
+    if (!strPurpose.empty() && !batch.WritePurpose(EncodeDestination(address), strPurpose))
         return false;
-    return WalletBatch(*database).WriteName(EncodeDestination(address), strName);
+    return batch.WriteName(EncodeDestination(address), strName);
 }
 
 bool CWallet::DelAddressBook(const CTxDestination& address)
 {
+    WalletBatch batch(*database, "r+", false);
     {
         LOCK(cs_wallet); // mapAddressBook
 
@@ -4204,15 +4759,15 @@ bool CWallet::DelAddressBook(const CTxDestination& address)
         std::string strAddress = EncodeDestination(address);
         for (const std::pair<const std::string, std::string> &item : mapAddressBook[address].destdata)
         {
-            WalletBatch(*database).EraseDestData(strAddress, item.first);
+            batch.EraseDestData(strAddress, item.first);
         }
         mapAddressBook.erase(address);
     }
 
     NotifyAddressBookChanged(this, address, "", ::IsMine(*this, address) != ISMINE_NO, "", CT_DELETED);
 
-    WalletBatch(*database).ErasePurpose(EncodeDestination(address));
-    return WalletBatch(*database).EraseName(EncodeDestination(address));
+    batch.ErasePurpose(EncodeDestination(address));
+    return batch.EraseName(EncodeDestination(address));
 }
 
 const std::string& CWallet::GetLabelName(const CScript& scriptPubKey) const
@@ -4322,6 +4877,14 @@ bool CWallet::TopUpKeyPool(unsigned int kpSize)
         }
         bool fInternal = false;
         WalletBatch batch(*database);
+        // HD keys are derived up front, all external ones first as they are added to the pool in that order
+        std::vector<CPubKey> vHDPubKeys;
+        if (IsHDEnabled()) {
+            std::vector<CPubKey> vInternalPubKeys;
+            DeriveNewChildKeys(batch, 0, false, missingExternal, vHDPubKeys);
+            DeriveNewChildKeys(batch, 0, true, missingInternal, vInternalPubKeys);
+            vHDPubKeys.insert(vHDPubKeys.end(), vInternalPubKeys.begin(), vInternalPubKeys.end());
+        }
         for (int64_t i = missingInternal + missingExternal; i--;)
         {
             if (i < missingInternal) {
@@ -4332,7 +4895,7 @@ bool CWallet::TopUpKeyPool(unsigned int kpSize)
             int64_t index = ++m_max_keypool_index;
 
             // TODO: implement keypools for all accounts?
-            CPubKey pubkey(GenerateNewKey(batch, 0, fInternal));
+            CPubKey pubkey(IsHDEnabled() ? vHDPubKeys[missingInternal + missingExternal - 1 - i] : GenerateNewKey(batch, 0, fInternal));
             if (!batch.WritePool(index, CKeyPool(pubkey, fInternal))) {
                 throw std::runtime_error(std::string(__func__) + ": writing generated key failed");
             }
@@ -4705,8 +5268,7 @@ void CWallet::LockCoin(const COutPoint& output)
     std::map<uint256, CWalletTx>::iterator it = mapWallet.find(output.hash);
     if (it != mapWallet.end()) it->second.MarkDirty(); // recalculate all credits for this tx
 
-    fAnonymizableTallyCached = false;
-    fAnonymizableTallyCachedNonDenom = false;
+    ResetBalanceCaches();
 }
 
 void CWallet::UnlockCoin(const COutPoint& output)
@@ -4716,8 +5278,7 @@ void CWallet::UnlockCoin(const COutPoint& output)
     std::map<uint256, CWalletTx>::iterator it = mapWallet.find(output.hash);
     if (it != mapWallet.end()) it->second.MarkDirty(); // recalculate all credits for this tx
 
-    fAnonymizableTallyCached = false;
-    fAnonymizableTallyCachedNonDenom = false;
+    ResetBalanceCaches();
 }
 
 void CWallet::UnlockAllCoins()
@@ -4749,7 +5310,8 @@ void CWallet::ListProTxCoins(std::vector<COutPoint>& vOutpts) const
     auto mnList = deterministicMNManager->GetListAtChainTip();
 
     AssertLockHeld(cs_wallet);
-    for (const auto &o : setWalletUTXO) {
+    for (const auto& pair : mapWalletUTXO) {
+        const COutPoint& o = pair.first;
         auto it = mapWallet.find(o.hash);
         if (it != mapWallet.end()) {
             const auto &p = it->second;
@@ -4884,14 +5446,14 @@ bool CWallet::AddDestData(const CTxDestination &dest, const std::string &key, co
         return false;
 
     mapAddressBook[dest].destdata.insert(std::make_pair(key, value));
-    return WalletBatch(*database).WriteDestData(EncodeDestination(dest), key, value);
+    return WalletBatch(*database, "r+", false).WriteDestData(EncodeDestination(dest), key, value);
 }
 
 bool CWallet::EraseDestData(const CTxDestination &dest, const std::string &key)
 {
     if (!mapAddressBook[dest].destdata.erase(key))
         return false;
-    return WalletBatch(*database).EraseDestData(EncodeDestination(dest), key);
+    return WalletBatch(*database, "r+", false).EraseDestData(EncodeDestination(dest), key);
 }
 
 bool CWallet::LoadDestData(const CTxDestination &dest, const std::string &key, const std::string &value)
@@ -5396,6 +5958,8 @@ void CWallet::NotifyTransactionLock(const CTransactionRef &tx, const std::shared
     uint256 txHash = tx->GetHash();
     std::map<uint256, CWalletTx>::const_iterator mi = mapWallet.find(txHash);
     if (mi != mapWallet.end()){
+        // the tx is trusted now, which changes the confirmed/unconfirmed CoinJoin balances
+        ResetBalanceCaches();
         NotifyTransactionChanged(this, txHash, CT_UPDATED);
         NotifyISLockReceived();
         // notify an external script
@@ -5410,6 +5974,11 @@ void CWallet::NotifyTransactionLock(const CTransactionRef &tx, const std::shared
 
 void CWallet::NotifyChainLock(const CBlockIndex* pindexChainLock, const std::shared_ptr<const llmq::CChainLockSig>& clsig)
 {
+    {
+        LOCK(cs_wallet);
+        // chainlocked transactions are no longer considered IS locked
+        ResetBalanceCaches();
+    }
     NotifyChainLockReceived(pindexChainLock->nHeight);
 }
 
@@ -29,12 +29,14 @@
 #include <algorithm>
 #include <atomic>
 #include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
 #include <stdexcept>
 #include <stdint.h>
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -75,6 +77,16 @@ static const int64_t TIMESTAMP_MIN = 0;
 
 //! if set, all keys will be derived by using BIP39/BIP44
 static const bool DEFAULT_USE_HD_WALLET = false;
+//! -rescanthreads default, 0 means the number of cores
+static const int DEFAULT_RESCAN_THREADS = 0;
+//! Maximum number of threads which read and match blocks during a rescan
+static const int MAX_RESCAN_THREADS = 16;
+//! Number of blocks per rescan thread which are read before the matches are added to the wallet
+static const size_t RESCAN_BATCH_BLOCKS_PER_THREAD = 8;
+//! Maximum number of threads which derive HD keys for the keypool
+static const int MAX_KEYPOOL_DERIVE_THREADS = 16;
+//! Don't start another key derivation thread for less than this many keys
+static const size_t KEYPOOL_DERIVE_MIN_KEYS_PER_THREAD = 50;
 
 class CBlockIndex;
 class CCoinControl;
@@ -705,7 +717,22 @@ struct CoinEligibilityFilter
     CoinEligibilityFilter(int conf_mine, int conf_theirs, uint64_t max_ancestors, uint64_t max_descendants) : conf_mine(conf_mine), conf_theirs(conf_theirs), max_ancestors(max_ancestors), max_descendants(max_descendants) {}
 };
 
+/**
+ * Salted hashes of the P2PKH and P2SH scripts of a wallet, so that outputs paying to someone else can be rejected
+ * without running Solver and looking up keys. Scripts of any other type are never rejected.
+ */
+struct WalletScriptHashes
+{
+    //! (TX_PUBKEYHASH or TX_SCRIPTHASH, hash) of the outputs which may be ours
+    std::unordered_set<std::pair<int, uint160>, StaticSaltedHasher> setHashes;
+
+    void Add(const CScript& script);
+    //! False if script is certainly not ours, false positives are fine
+    bool MayBeMine(const CScript& script) const;
+};
+
 class WalletRescanReserver; //forward declarations for ScanForWalletTransactions/RescanFromTime
+struct WalletRescanScripts;
 /**
  * A CWallet is an extension of a keystore, which also maintains a set of transactions and balances,
  * and provides the ability to create new transactions.
@@ -720,6 +747,19 @@ private:
     std::mutex mutexScanning;
     friend class WalletRescanReserver;
 
+    //! Changes whenever keys or scripts are added, i.e. when ForEachWalletScript() would return more scripts
+    size_t GetWalletScriptsCount() const;
+    //! Call fn with all scripts the wallet can own or watch, some of them more than once
+    void ForEachWalletScript(const std::function<void(const CScript&)>& fn) const;
+    //! Collect the scripts ScanForWalletTransactions matches blocks against
+    void GetRescanScripts(WalletRescanScripts& scriptsRet) const;
+
+    //! Lets IsMine(const CTxOut&) reject outputs of others, complete as long as m_script_hashes_count is GetWalletScriptsCount()
+    mutable WalletScriptHashes m_script_hashes GUARDED_BY(cs_KeyStore);
+    mutable size_t m_script_hashes_count GUARDED_BY(cs_KeyStore){0};
+    //! Adds a key to m_script_hashes right after it was added to the keystore, which had nCountBefore scripts before
+    void AddKeyToScriptHashes(const CPubKey& pubkey, size_t nCountBefore);
+
 
     /**
      * Select a set of coins such that nValueRet >= nTargetValue and at least
@@ -746,6 +786,43 @@ private:
     mutable bool fAnonymizableTallyCachedNonDenom = false;
     mutable std::vector<CompactTallyItem> vecAnonymizableTallyCachedNonDenom;
 
+    /** CoinJoin balances of the wallet, calculated in a single pass and reset together with the tally caches */
+    struct CoinJoinBalances {
+        //! CCoinJoinClientOptions::GetRounds() the balances were calculated with, -1 if they are not calculated yet
+        int nRounds{-1};
+        CAmount nAnonymizable{0};
+        CAmount nAnonymizableNonDenom{0};
+        CAmount nAnonymized{0};
+        CAmount nDenominatedConf{0};
+        CAmount nDenominatedUnconf{0};
+        CAmount nNormalizedAnonymized{0};
+        float nAverageAnonymizedRounds{0};
+    };
+    mutable CoinJoinBalances coinJoinBalancesCached;
+
+    /** Balances returned by the balance getters with default arguments, calculated in a single pass and reset together with the CoinJoin balances */
+    struct Balances {
+        bool fValid{false};
+        CAmount nTrusted{0};
+        CAmount nTrustedWatchOnly{0};
+        CAmount nUntrustedPending{0};
+        CAmount nUntrustedPendingWatchOnly{0};
+        CAmount nImmature{0};
+        CAmount nImmatureWatchOnly{0};
+    };
+    mutable Balances balancesCached;
+
+    const Balances& GetCachedBalances() const EXCLUSIVE_LOCKS_REQUIRED(cs_main, cs_wallet);
+
+    const CoinJoinBalances& GetCoinJoinBalances() const EXCLUSIVE_LOCKS_REQUIRED(cs_main, cs_wallet);
+    CAmount CalculateAnonymizableBalance(bool fSkipDenominated, bool fSkipUnconfirmed) const;
+    CAmount CalculateAnonymizedBalance(const CCoinControl* coinControl) const EXCLUSIVE_LOCKS_REQUIRED(cs_main, cs_wallet);
+    float CalculateAverageAnonymizedRounds() const EXCLUSIVE_LOCKS_REQUIRED(cs_main, cs_wallet);
+    CAmount CalculateNormalizedAnonymizedBalance() const EXCLUSIVE_LOCKS_REQUIRED(cs_main, cs_wallet);
+    CAmount CalculateDenominatedBalance(bool unconfirmed) const EXCLUSIVE_LOCKS_REQUIRED(cs_main, cs_wallet);
+    /** Must be called whenever the UTXOs of the wallet or their state (depth, locks, mempool, trust) change */
+    void ResetBalanceCaches();
+
     /**
      * Used to keep track of spent outpoints, and
      * detect and report conflicts (double-spends or
@@ -756,9 +833,29 @@ private:
     void AddToSpends(const COutPoint& outpoint, const uint256& wtxid);
     void AddToSpends(const uint256& wtxid);
 
-    std::set<COutPoint> setWalletUTXO;
+    /** An output of the wallet which no wallet transaction spends, with what AvailableCoins filters on precomputed */
+    struct WalletUTXO {
+        isminetype mine;
+        bool fDenominated;
+        bool fCoinJoinCollateral;
+        bool fMasternodeCollateral;
+
+        WalletUTXO(const CTxOut& txout, isminetype mineIn);
+    };
+    /** Sorted by COutPoint, so the UTXOs of a transaction are neighbors */
+    std::map<COutPoint, WalletUTXO> mapWalletUTXO;
+    /** Adds output n of wtx to mapWalletUTXO if it is ours and unspent, returns false if it was not added now */
+    bool AddWalletUTXO(const CWalletTx& wtx, unsigned int n);
+    /**
+     * CoinJoin rounds per outpoint, mirrored in the wallet database ("cj_rounds") so that the input chains don't
+     * have to be walked again after a restart. Entries only depend on the ancestors of an outpoint and are
+     * invalidated via InvalidateCoinJoinRounds when one of them is added to or removed from the wallet.
+     */
     mutable std::map<COutPoint, int> mapOutpointRoundsCache;
 
+    int GetRealOutpointCoinJoinRounds(const COutPoint& outpoint, int nRounds, std::vector<COutPoint>& vecUpdatedRet) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    void InvalidateCoinJoinRounds(const CTransactionRef& tx, WalletBatch& batch) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     /* Mark a transaction (and its in-wallet descendants) as conflicting with a particular block. */
     void MarkConflicted(const uint256& hashBlock, const uint256& hashTx);
 
@@ -770,6 +867,8 @@ private:
 
     /* HD derive new child key (on internal or external chain) */
     void DeriveNewChildKey(WalletBatch &batch, const CKeyMetadata& metadata, CKey& secretRet, uint32_t nAccountIndex, bool fInternal /*= false*/) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    /** Like nCount calls of DeriveNewChildKey, but decrypts and writes the HD chain once and derives the keys in parallel */
+    void DeriveNewChildKeys(WalletBatch& batch, uint32_t nAccountIndex, bool fInternal, size_t nCount, std::vector<CPubKey>& vPubKeysRet) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
     std::set<int64_t> setInternalKeyPool;
     std::set<int64_t> setExternalKeyPool;
@@ -916,7 +1015,7 @@ public:
      * completion the coin set and corresponding actual target value is
      * assembled
      */
-    bool SelectCoinsMinConf(const CAmount& nTargetValue, const CoinEligibilityFilter& eligibility_filter, std::vector<COutput> vCoins, std::set<CInputCoin>& setCoinsRet, CAmount& nValueRet, const CoinSelectionParams& coin_selection_params, bool& bnb_used, CoinType nCoinType = CoinType::ALL_COINS) const;
+    bool SelectCoinsMinConf(const CAmount& nTargetValue, const CoinEligibilityFilter& eligibility_filter, const std::vector<COutput>& vCoins, std::set<CInputCoin>& setCoinsRet, CAmount& nValueRet, const CoinSelectionParams& coin_selection_params, bool& bnb_used, CoinType nCoinType = CoinType::ALL_COINS) const;
 
     // Coin selection
     bool SelectTxDSInsByDenomination(int nDenom, CAmount nValueMax, std::vector<CTxDSIn>& vecTxDSInRet);
@@ -928,7 +1027,8 @@ public:
     int  CountInputsWithAmount(CAmount nInputAmount) const;
 
     // get the CoinJoin chain depth for a given input
-    int GetRealOutpointCoinJoinRounds(const COutPoint& outpoint, int nRounds = 0) const;
+    int GetRealOutpointCoinJoinRounds(const COutPoint& outpoint) const;
+    void LoadCoinJoinRounds(const COutPoint& outpoint, int nRounds, int nRoundsMax);
     // respect current settings
     int GetCappedOutpointCoinJoinRounds(const COutPoint& outpoint) const;
 
@@ -20,6 +20,7 @@
 #include <validation.h>
 
 #include <atomic>
+#include <thread>
 
 #include <boost/thread.hpp>
 
@@ -190,6 +191,16 @@ bool WalletBatch::WriteCoinJoinSalt(const uint256& salt)
     return WriteIC(std::string("cj_salt"), salt);
 }
 
+bool WalletBatch::WriteCoinJoinRounds(const COutPoint& outpoint, int nRounds, int nRoundsMax)
+{
+    return WriteIC(std::make_pair(std::string("cj_rounds"), outpoint), std::make_pair(nRounds, nRoundsMax));
+}
+
+bool WalletBatch::EraseCoinJoinRounds(const COutPoint& outpoint)
+{
+    return EraseIC(std::make_pair(std::string("cj_rounds"), outpoint));
+}
+
 bool WalletBatch::WriteGovernanceObject(const CGovernanceObject& obj)
 {
     return WriteIC(std::make_pair(std::string("gobject"), obj.GetHash()), obj, false);
@@ -271,6 +282,92 @@ public:
     }
 };
 
+/** Decodes the remaining key and the value of a "tx" record, doesn't touch any wallet so it can run in parallel */
+static bool ReadWalletTx(CDataStream& ssKey, CDataStream& ssValue, CWalletTx& wtx, bool& fUpgradedRet, std::string& strErr)
+{
+    fUpgradedRet = false;
+    try {
+        uint256 hash;
+        ssKey >> hash;
+        ssValue >> wtx;
+        CValidationState state;
+        if (!(CheckTransaction(*wtx.tx, state) && (wtx.GetHash() == hash) && state.IsValid()))
+            return false;
+
+        // Undo serialize changes in 31600
+        if (31404 <= wtx.fTimeReceivedIsTxTime && wtx.fTimeReceivedIsTxTime <= 31703)
+        {
+            if (!ssValue.empty())
+            {
+                char fTmp;
+                char fUnused;
+                ssValue >> fTmp >> fUnused >> wtx.strFromAccount;
+                strErr = strprintf("LoadWallet() upgrading tx ver=%d %d '%s' %s",
+                                   wtx.fTimeReceivedIsTxTime, fTmp, wtx.strFromAccount, hash.ToString());
+                wtx.fTimeReceivedIsTxTime = fTmp;
+            }
+            else
+            {
+                strErr = strprintf("LoadWallet() repairing tx ver=%d %s", wtx.fTimeReceivedIsTxTime, hash.ToString());
+                wtx.fTimeReceivedIsTxTime = 0;
+            }
+            fUpgradedRet = true;
+        }
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+static void LoadWalletTx(CWallet* pwallet, const CWalletTx& wtx, bool fUpgraded, CWalletScanState& wss) EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet)
+{
+    if (fUpgraded)
+        wss.vWalletUpgrade.push_back(wtx.GetHash());
+
+    if (wtx.nOrderPos == -1)
+        wss.fAnyUnordered = true;
+
+    pwallet->LoadToWallet(wtx);
+}
+
+/** A "tx" record read by LoadWallet, decoded later together with others by DecodeWalletTxRecords */
+struct WalletTxRecord
+{
+    CDataStream ssKey;
+    CDataStream ssValue;
+    CWalletTx wtx{nullptr /* pwallet */, MakeTransactionRef()};
+    bool fValid{false};
+    bool fUpgraded{false};
+    std::string strErr;
+
+    WalletTxRecord(CDataStream&& ssKeyIn, CDataStream&& ssValueIn) : ssKey(std::move(ssKeyIn)), ssValue(std::move(ssValueIn)) {}
+};
+
+/** Decodes and checks the records on all cores, decoding and CheckTransaction dominate the load time of large wallets */
+static void DecodeWalletTxRecords(std::vector<WalletTxRecord>& vRecords)
+{
+    std::atomic<size_t> nNext{0};
+    auto decode = [&]() {
+        for (size_t i = nNext++; i < vRecords.size(); i = nNext++) {
+            WalletTxRecord& record = vRecords[i];
+            record.fValid = ReadWalletTx(record.ssKey, record.ssValue, record.wtx, record.fUpgraded, record.strErr);
+        }
+    };
+
+    const size_t nThreads = std::min<size_t>(std::max(GetNumCores(), 1), WALLET_LOAD_MAX_THREADS);
+    std::vector<std::thread> vThreads;
+    for (size_t i = 1; i < nThreads && i * WALLET_LOAD_MIN_TXS_PER_THREAD < vRecords.size(); i++) {
+        vThreads.emplace_back([&]() {
+            RenameThread("dash-walletload");
+            decode();
+        });
+    }
+    decode();
+    for (auto& thread : vThreads) {
+        thread.join();
+    }
+}
+
 bool
 ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
              CWalletScanState &wss, std::string& strType, std::string& strErr) EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet)
@@ -294,38 +391,11 @@ ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
         }
         else if (strType == "tx")
         {
-            uint256 hash;
-            ssKey >> hash;
             CWalletTx wtx(nullptr /* pwallet */, MakeTransactionRef());
-            ssValue >> wtx;
-            CValidationState state;
-            if (!(CheckTransaction(*wtx.tx, state) && (wtx.GetHash() == hash) && state.IsValid()))
+            bool fUpgraded;
+            if (!ReadWalletTx(ssKey, ssValue, wtx, fUpgraded, strErr))
                 return false;
-
-            // Undo serialize changes in 31600
-            if (31404 <= wtx.fTimeReceivedIsTxTime && wtx.fTimeReceivedIsTxTime <= 31703)
-            {
-                if (!ssValue.empty())
-                {
-                    char fTmp;
-                    char fUnused;
-                    ssValue >> fTmp >> fUnused >> wtx.strFromAccount;
-                    strErr = strprintf("LoadWallet() upgrading tx ver=%d %d '%s' %s",
-                                       wtx.fTimeReceivedIsTxTime, fTmp, wtx.strFromAccount, hash.ToString());
-                    wtx.fTimeReceivedIsTxTime = fTmp;
-                }
-                else
-                {
-                    strErr = strprintf("LoadWallet() repairing tx ver=%d %s", wtx.fTimeReceivedIsTxTime, hash.ToString());
-                    wtx.fTimeReceivedIsTxTime = 0;
-                }
-                wss.vWalletUpgrade.push_back(hash);
-            }
-
-            if (wtx.nOrderPos == -1)
-                wss.fAnyUnordered = true;
-
-            pwallet->LoadToWallet(wtx);
+            LoadWalletTx(pwallet, wtx, fUpgraded, wss);
         }
         else if (strType == "acentry")
         {
@@ -525,6 +595,15 @@ ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
                 return false;
             }
         }
+        else if (strType == "cj_rounds")
+        {
+            COutPoint outpoint;
+            ssKey >> outpoint;
+            int nRounds, nRoundsMax;
+            ssValue >> nRounds;
+            ssValue >> nRoundsMax;
+            pwallet->LoadCoinJoinRounds(outpoint, nRounds, nRoundsMax);
+        }
         else if (strType == "hdchain")
         {
             CHDChain chain;
@@ -621,6 +700,24 @@ DBErrors WalletBatch::LoadWallet(CWallet* pwallet)
             return DBErrors::CORRUPT;
         }
 
+        // transactions are collected and decoded in parallel, they don't depend on any other record
+        std::vector<WalletTxRecord> vTxRecords;
+        auto loadTxRecords = [&]() {
+            DecodeWalletTxRecords(vTxRecords);
+            for (const WalletTxRecord& record : vTxRecords) {
+                if (record.fValid) {
+                    LoadWalletTx(pwallet, record.wtx, record.fUpgraded, wss);
+                } else {
+                    // Leave bad transactions alone, see below
+                    fNoncriticalErrors = true;
+                    gArgs.SoftSetBoolArg("-rescan", true);
+                }
+                if (!record.strErr.empty())
+                    LogPrintf("%s\n", record.strErr);
+            }
+            vTxRecords.clear();
+        };
+
         while (true)
         {
             // Read next record
@@ -635,8 +732,22 @@ DBErrors WalletBatch::LoadWallet(CWallet* pwallet)
                 return DBErrors::CORRUPT;
             }
 
-            // Try to be tolerant of single corrupt records:
             std::string strType, strErr;
+            try {
+                CDataStream(ssKey) >> strType;
+            } catch (...) {
+                strType.clear();
+            }
+            if (strType == "tx") {
+                ssKey >> strType;
+                vTxRecords.emplace_back(std::move(ssKey), std::move(ssValue));
+                if (vTxRecords.size() >= WALLET_LOAD_TX_BATCH_SIZE) {
+                    loadTxRecords();
+                }
+                continue;
+            }
+
+            // Try to be tolerant of single corrupt records:
             if (!ReadKeyValue(pwallet, ssKey, ssValue, wss, strType, strErr))
             {
                 // losing keys is considered a catastrophic error, anything else
@@ -656,6 +767,7 @@ DBErrors WalletBatch::LoadWallet(CWallet* pwallet)
                 LogPrintf("%s\n", strErr);
         }
         pcursor->close();
+        loadTxRecords();
 
         // Store initial external keypool size since we mostly use external keys in mixing
         pwallet->nKeysLeftSinceAutoBackup = pwallet->KeypoolCountExternalKeys();
@@ -819,6 +931,13 @@ DBErrors WalletBatch::ZapWalletTx(std::vector<CWalletTx>& vWtx)
             return DBErrors::CORRUPT;
     }
 
+    // cached CoinJoin rounds would refer to transactions which are not part of the wallet anymore
+    for (const CWalletTx& wtx : vWtx) {
+        for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
+            EraseCoinJoinRounds(COutPoint(wtx.GetHash(), i));
+        }
+    }
+
     return DBErrors::LOAD_OK;
 }
 
@@ -30,6 +30,12 @@
  */
 
 static const bool DEFAULT_FLUSHWALLET = true;
+//! Transaction records LoadWallet collects before decoding them in parallel
+static const size_t WALLET_LOAD_TX_BATCH_SIZE = 10000;
+//! Maximum number of threads decoding transaction records while loading a wallet
+static const size_t WALLET_LOAD_MAX_THREADS = 16;
+//! Don't start another decoding thread for less than this many transaction records
+static const size_t WALLET_LOAD_MIN_TXS_PER_THREAD = 100;
 
 class CAccount;
 class CAccountingEntry;
@@ -37,6 +43,7 @@ struct CBlockLocator;
 class CGovernanceObject;
 class CKeyPool;
 class CMasterKey;
+class COutPoint;
 class CScript;
 class CWallet;
 class CWalletTx;
@@ -93,6 +100,11 @@ public:
  * This represents a single transaction at the
  * database. It will be committed when the object goes out of scope.
  * Optionally (on by default) it will flush to disk as well.
+ *
+ * Only batches which write key material, encryption keys or transactions created by the wallet itself flush on
+ * close. Records which can be restored by a rescan or are only informational (received transactions, CoinJoin
+ * rounds, the address book and dest data) are left to the periodic flush of -flushwallet, so that mixing and
+ * rescans don't checkpoint the database for every record.
  */
 class WalletBatch
 {
@@ -167,6 +179,10 @@ public:
     bool ReadCoinJoinSalt(uint256& salt, bool fLegacy = false);
     bool WriteCoinJoinSalt(const uint256& salt);
 
+    /// Write the CoinJoin rounds of an outpoint, nRoundsMax is the limit the rounds were calculated with
+    bool WriteCoinJoinRounds(const COutPoint& outpoint, int nRounds, int nRoundsMax);
+    bool EraseCoinJoinRounds(const COutPoint& outpoint);
+
     /** Write a CGovernanceObject to the database */
     bool WriteGovernanceObject(const CGovernanceObject& obj);
 
@@ -5,6 +5,23 @@
 #include <zmq/zmqabstractnotifier.h>
 #include <util.h>
 
+void CZMQNotifierStats::RecordQueued(size_t nSize)
+{
+    nMessages++;
+    nBytes += nSize;
+    nQueued++;
+    nQueuedBytes += nSize;
+}
+
+void CZMQNotifierStats::RecordReleased(size_t nSize, int64_t nLatency)
+{
+    nQueued--;
+    nQueuedBytes -= nSize;
+    nReleased++;
+    nLatencyTotal += nLatency;
+    int64_t nMax = nLatencyMax.load();
+    while (nLatency > nMax && !nLatencyMax.compare_exchange_weak(nMax, nLatency)) {}
+}
 
 CZMQAbstractNotifier::~CZMQAbstractNotifier()
 {
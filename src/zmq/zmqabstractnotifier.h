@@ -7,6 +7,9 @@
 
 #include <zmq/zmqconfig.h>
 
+#include <atomic>
+#include <memory>
+
 class CBlockIndex;
 class CGovernanceObject;
 class CGovernanceVote;
@@ -20,10 +23,35 @@ namespace llmq {
 
 typedef CZMQAbstractNotifier* (*CZMQNotifierFactory)();
 
+//! Default for -zmqsndhwm, the outbound message high water mark of the publish sockets (same as libzmq)
+static const int DEFAULT_ZMQ_SNDHWM = 1000;
+
+/**
+ * Publishing statistics of a notifier. Messages are handed to libzmq without
+ * copying their payload, libzmq releases the payload once it was written to
+ * all subscribers or dropped. Updated from the notifying and the libzmq I/O
+ * threads.
+ */
+struct CZMQNotifierStats
+{
+    std::atomic<uint64_t> nMessages{0};        //!< messages handed to the socket
+    std::atomic<uint64_t> nBytes{0};           //!< payload bytes handed to the socket
+    std::atomic<uint64_t> nDropped{0};         //!< messages the socket refused to queue
+    std::atomic<uint64_t> nQueueDropped{0};    //!< notifications dropped because the publisher queue was full
+    std::atomic<int64_t> nQueued{0};           //!< payloads which libzmq didn't release yet
+    std::atomic<int64_t> nQueuedBytes{0};
+    std::atomic<uint64_t> nReleased{0};        //!< payloads released by libzmq
+    std::atomic<int64_t> nLatencyTotal{0};     //!< sum of the microseconds between queueing and release of payloads
+    std::atomic<int64_t> nLatencyMax{0};
+
+    void RecordQueued(size_t nSize);
+    void RecordReleased(size_t nSize, int64_t nLatency);
+};
+
 class CZMQAbstractNotifier
 {
 public:
-    CZMQAbstractNotifier() : psocket(nullptr) { }
+    CZMQAbstractNotifier() : psocket(nullptr), outbound_message_high_water_mark(DEFAULT_ZMQ_SNDHWM), fBlockOnFullQueue(false), stats(std::make_shared<CZMQNotifierStats>()) { }
     virtual ~CZMQAbstractNotifier();
 
     template <typename T>
@@ -36,6 +64,12 @@ public:
     void SetType(const std::string &t) { type = t; }
     std::string GetAddress() const { return address; }
     void SetAddress(const std::string &a) { address = a; }
+    int GetOutboundMessageHighWaterMark() const { return outbound_message_high_water_mark; }
+    void SetOutboundMessageHighWaterMark(int hwm) { outbound_message_high_water_mark = hwm; }
+    bool IsBlockOnFullQueue() const { return fBlockOnFullQueue; }
+    void SetBlockOnFullQueue(bool f) { fBlockOnFullQueue = f; }
+    const CZMQNotifierStats& GetStats() const { return *stats; }
+    CZMQNotifierStats& GetStats() { return *stats; }
 
     virtual bool Initialize(void *pcontext) = 0;
     virtual void Shutdown() = 0;
@@ -53,6 +87,11 @@ protected:
     void *psocket;
     std::string type;
     std::string address;
+    int outbound_message_high_water_mark;
+    //! wait for room in the publisher queue instead of dropping notifications
+    bool fBlockOnFullQueue;
+    //! shared with the payloads still queued in libzmq, which may be released after the notifier is gone
+    std::shared_ptr<CZMQNotifierStats> stats;
 };
 
 #endif // BITCOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
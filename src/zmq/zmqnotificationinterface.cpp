@@ -4,6 +4,7 @@
 
 #include <zmq/zmqnotificationinterface.h>
 #include <zmq/zmqpublishnotifier.h>
+#include <zmq/zmqwatchset.h>
 
 #include <version.h>
 #include <validation.h>
@@ -15,7 +16,7 @@ void zmqError(const char *str)
     LogPrint(BCLog::ZMQ, "zmq: Error: %s, errno=%s\n", str, zmq_strerror(errno));
 }
 
-CZMQNotificationInterface::CZMQNotificationInterface() : pcontext(nullptr)
+CZMQNotificationInterface::CZMQNotificationInterface() : pcontext(nullptr), nMaxQueueSize(DEFAULT_ZMQ_QUEUE_SIZE), fStopping(false)
 {
 }
 
@@ -23,6 +24,7 @@ CZMQNotificationInterface::~CZMQNotificationInterface()
 {
     Shutdown();
 
+    LOCK(cs_notifiers);
     for (std::list<CZMQAbstractNotifier*>::iterator i=notifiers.begin(); i!=notifiers.end(); ++i)
     {
         delete *i;
@@ -31,6 +33,7 @@ CZMQNotificationInterface::~CZMQNotificationInterface()
 
 std::list<const CZMQAbstractNotifier*> CZMQNotificationInterface::GetActiveNotifiers() const
 {
+    LOCK(cs_notifiers);
     std::list<const CZMQAbstractNotifier*> result;
     for (const auto* n : notifiers) {
         result.push_back(n);
@@ -56,6 +59,7 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubrawchainlock"] = CZMQAbstractNotifier::Create<CZMQPublishRawChainLockNotifier>;
     factories["pubrawchainlocksig"] = CZMQAbstractNotifier::Create<CZMQPublishRawChainLockSigNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
+    factories["pubrawtxwatch"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionWatchNotifier>;
     factories["pubrawtxlock"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionLockNotifier>;
     factories["pubrawtxlocksig"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionLockSigNotifier>;
     factories["pubrawgovernancevote"] = CZMQAbstractNotifier::Create<CZMQPublishRawGovernanceVoteNotifier>;
@@ -63,6 +67,7 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubrawinstantsenddoublespend"] = CZMQAbstractNotifier::Create<CZMQPublishRawInstantSendDoubleSpendNotifier>;
     factories["pubrawrecoveredsig"] = CZMQAbstractNotifier::Create<CZMQPublishRawRecoveredSigNotifier>;
 
+    const std::vector<std::string> vBlockOnFull = gArgs.GetArgs("-zmqblockonfull");
     for (const auto& entry : factories)
     {
         std::string arg("-zmq" + entry.first);
@@ -73,14 +78,29 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
             CZMQAbstractNotifier *notifier = factory();
             notifier->SetType(entry.first);
             notifier->SetAddress(address);
+            notifier->SetOutboundMessageHighWaterMark(std::max<int64_t>(gArgs.GetArg("-zmqsndhwm", DEFAULT_ZMQ_SNDHWM), 0));
+            notifier->SetBlockOnFullQueue(std::find(vBlockOnFull.begin(), vBlockOnFull.end(), entry.first) != vBlockOnFull.end());
             notifiers.push_back(notifier);
         }
     }
 
+    for (const std::string& strWatch : gArgs.GetArgs("-zmqwatch")) {
+        CScript script;
+        if (ParseZMQWatchScript(strWatch, script)) {
+            g_zmq_watch_set.Add(script);
+        } else {
+            LogPrintf("zmq: Ignoring -zmqwatch=%s, it's neither an address nor a hex encoded script\n", strWatch);
+        }
+    }
+
     if (!notifiers.empty())
     {
         notificationInterface = new CZMQNotificationInterface();
-        notificationInterface->notifiers = notifiers;
+        notificationInterface->nMaxQueueSize = std::max<int64_t>(gArgs.GetArg("-zmqqueuesize", DEFAULT_ZMQ_QUEUE_SIZE), 1);
+        {
+            LOCK(notificationInterface->cs_notifiers);
+            notificationInterface->notifiers = notifiers;
+        }
 
         if (!notificationInterface->Initialize())
         {
@@ -106,6 +126,7 @@ bool CZMQNotificationInterface::Initialize()
         return false;
     }
 
+    LOCK(cs_notifiers);
     std::list<CZMQAbstractNotifier*>::iterator i=notifiers.begin();
     for (; i!=notifiers.end(); ++i)
     {
@@ -126,6 +147,10 @@ bool CZMQNotificationInterface::Initialize()
         return false;
     }
 
+    // serialization and sending happen on this thread, so the validation
+    // callbacks and the LLMQ threads only have to queue notifications
+    publisherThread = std::thread(&TraceThread<std::function<void()> >, "zmqpub", std::function<void()>(std::bind(&CZMQNotificationInterface::ThreadPublish, this)));
+
     return true;
 }
 
@@ -135,6 +160,18 @@ void CZMQNotificationInterface::Shutdown()
     LogPrint(BCLog::ZMQ, "zmq: Shutdown notification interface\n");
     if (pcontext)
     {
+        if (publisherThread.joinable()) {
+            // publish what is still queued, but don't wait for room in the queue anymore
+            {
+                std::lock_guard<std::mutex> lock(cs_queue);
+                fStopping = true;
+            }
+            condQueueNotEmpty.notify_all();
+            condQueueNotFull.notify_all();
+            publisherThread.join();
+        }
+
+        LOCK(cs_notifiers);
         for (std::list<CZMQAbstractNotifier*>::iterator i=notifiers.begin(); i!=notifiers.end(); ++i)
         {
             CZMQAbstractNotifier *notifier = *i;
@@ -147,62 +184,86 @@ void CZMQNotificationInterface::Shutdown()
     }
 }
 
-void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
+void CZMQNotificationInterface::Enqueue(const NotifyFunc& func)
 {
-    if (fInitialDownload || pindexNew == pindexFork) // In IBD or blocks were disconnected without any new ones
-        return;
-
-    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
+    std::list<CZMQAbstractNotifier*> activeNotifiers;
     {
-        CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyBlock(pindexNew))
-        {
-            i++;
+        LOCK(cs_notifiers);
+        activeNotifiers = notifiers;
+    }
+
+    std::unique_lock<std::mutex> lock(cs_queue);
+    for (CZMQAbstractNotifier* notifier : activeNotifiers) {
+        if (queue.size() >= nMaxQueueSize && notifier->IsBlockOnFullQueue()) {
+            condQueueNotFull.wait(lock, [this]{ return queue.size() < nMaxQueueSize || fStopping; });
         }
-        else
-        {
-            notifier->Shutdown();
-            i = notifiers.erase(i);
+        if (fStopping) {
+            return;
+        }
+        if (queue.size() >= nMaxQueueSize) {
+            notifier->GetStats().nQueueDropped++;
+            continue;
         }
+        queue.push_back(PendingNotification{notifier, func});
     }
+    lock.unlock();
+    condQueueNotEmpty.notify_one();
 }
 
-void CZMQNotificationInterface::NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig)
+void CZMQNotificationInterface::ThreadPublish()
 {
-    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
-    {
-        CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyChainLock(pindex, clsig))
+    while (true) {
+        PendingNotification pending;
         {
-            i++;
+            std::unique_lock<std::mutex> lock(cs_queue);
+            condQueueNotEmpty.wait(lock, [this]{ return !queue.empty() || fStopping; });
+            if (queue.empty()) {
+                return;
+            }
+            pending = std::move(queue.front());
+            queue.pop_front();
         }
-        else
+        condQueueNotFull.notify_all();
+
         {
-            notifier->Shutdown();
-            i = notifiers.erase(i);
+            LOCK(cs_notifiers);
+            // the notifier failed while this was queued
+            if (std::find(notifiers.begin(), notifiers.end(), pending.notifier) == notifiers.end()) {
+                continue;
+            }
+        }
+        if (!pending.func(pending.notifier)) {
+            LOCK(cs_notifiers);
+            pending.notifier->Shutdown();
+            notifiers.remove(pending.notifier);
         }
     }
 }
 
+void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
+{
+    if (fInitialDownload || pindexNew == pindexFork) // In IBD or blocks were disconnected without any new ones
+        return;
+
+    Enqueue([pindexNew](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyBlock(pindexNew);
+    });
+}
+
+void CZMQNotificationInterface::NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig)
+{
+    Enqueue([pindex, clsig](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyChainLock(pindex, clsig);
+    });
+}
+
 void CZMQNotificationInterface::TransactionAddedToMempool(const CTransactionRef& ptx, int64_t nAcceptTime)
 {
     // Used by BlockConnected and BlockDisconnected as well, because they're
     // all the same external callback.
-    const CTransaction& tx = *ptx;
-
-    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
-    {
-        CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyTransaction(tx))
-        {
-            i++;
-        }
-        else
-        {
-            notifier->Shutdown();
-            i = notifiers.erase(i);
-        }
-    }
+    Enqueue([ptx](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyTransaction(*ptx);
+    });
 }
 
 void CZMQNotificationInterface::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexConnected, const std::vector<CTransactionRef>& vtxConflicted)
@@ -223,79 +284,37 @@ void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const CB
 
 void CZMQNotificationInterface::NotifyTransactionLock(const CTransactionRef& tx, const std::shared_ptr<const llmq::CInstantSendLock>& islock)
 {
-    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
-    {
-        CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyTransactionLock(tx, islock))
-        {
-            i++;
-        }
-        else
-        {
-            notifier->Shutdown();
-            i = notifiers.erase(i);
-        }
-    }
+    Enqueue([tx, islock](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyTransactionLock(tx, islock);
+    });
 }
 
 void CZMQNotificationInterface::NotifyGovernanceVote(const std::shared_ptr<const CGovernanceVote> &vote)
 {
-    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i != notifiers.end(); )
-    {
-        CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyGovernanceVote(vote))
-        {
-            i++;
-        }
-        else
-        {
-            notifier->Shutdown();
-            i = notifiers.erase(i);
-        }
-    }
+    Enqueue([vote](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyGovernanceVote(vote);
+    });
 }
 
 void CZMQNotificationInterface::NotifyGovernanceObject(const std::shared_ptr<const CGovernanceObject> &object)
 {
-    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i != notifiers.end(); )
-    {
-        CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyGovernanceObject(object))
-        {
-            i++;
-        }
-        else
-        {
-            notifier->Shutdown();
-            i = notifiers.erase(i);
-        }
-    }
+    Enqueue([object](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyGovernanceObject(object);
+    });
 }
 
 void CZMQNotificationInterface::NotifyInstantSendDoubleSpendAttempt(const CTransactionRef& currentTx, const CTransactionRef& previousTx)
 {
-    for (auto it = notifiers.begin(); it != notifiers.end();) {
-        CZMQAbstractNotifier *notifier = *it;
-        if (notifier->NotifyInstantSendDoubleSpendAttempt(currentTx, previousTx)) {
-            ++it;
-        } else {
-            notifier->Shutdown();
-            it = notifiers.erase(it);
-        }
-    }
+    Enqueue([currentTx, previousTx](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyInstantSendDoubleSpendAttempt(currentTx, previousTx);
+    });
 }
 
 void CZMQNotificationInterface::NotifyRecoveredSig(const std::shared_ptr<const llmq::CRecoveredSig>& sig)
 {
-    for (auto it = notifiers.begin(); it != notifiers.end();) {
-        CZMQAbstractNotifier *notifier = *it;
-        if (notifier->NotifyRecoveredSig(sig)) {
-            ++it;
-        } else {
-            notifier->Shutdown();
-            it = notifiers.erase(it);
-        }
-    }
+    Enqueue([sig](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyRecoveredSig(sig);
+    });
 }
 
 CZMQNotificationInterface* g_zmq_notification_interface = nullptr;
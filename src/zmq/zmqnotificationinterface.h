@@ -5,14 +5,23 @@
 #ifndef BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 #define BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 
+#include <sync.h>
 #include <validationinterface.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <string>
 #include <map>
 #include <list>
+#include <mutex>
+#include <thread>
 
 class CBlockIndex;
 class CZMQAbstractNotifier;
 
+//! Default for -zmqqueuesize, the number of notifications which may wait for the publisher thread
+static const unsigned int DEFAULT_ZMQ_QUEUE_SIZE = 10000;
+
 class CZMQNotificationInterface final : public CValidationInterface
 {
 public:
@@ -41,8 +50,35 @@ protected:
 private:
     CZMQNotificationInterface();
 
+    typedef std::function<bool(CZMQAbstractNotifier*)> NotifyFunc;
+
+    /** A notification waiting to be published by a single notifier */
+    struct PendingNotification
+    {
+        CZMQAbstractNotifier* notifier;
+        NotifyFunc func;
+    };
+
+    /**
+     * Queue func for all notifiers. If the queue is full, the notification is
+     * dropped for notifiers in -zmqblockonfull unless they wait for room.
+     */
+    void Enqueue(const NotifyFunc& func);
+    /** Publish queued notifications until Shutdown() and the queue is drained */
+    void ThreadPublish();
+
     void *pcontext;
-    std::list<CZMQAbstractNotifier*> notifiers;
+    mutable CCriticalSection cs_notifiers;
+    //! only the publisher thread removes (failed) notifiers
+    std::list<CZMQAbstractNotifier*> notifiers GUARDED_BY(cs_notifiers);
+
+    std::mutex cs_queue;
+    std::condition_variable condQueueNotEmpty;
+    std::condition_variable condQueueNotFull;
+    std::deque<PendingNotification> queue;
+    size_t nMaxQueueSize;
+    bool fStopping;
+    std::thread publisherThread;
 };
 
 extern CZMQNotificationInterface* g_zmq_notification_interface;
@@ -6,6 +6,7 @@
 #include <chainparams.h>
 #include <streams.h>
 #include <zmq/zmqpublishnotifier.h>
+#include <zmq/zmqwatchset.h>
 #include <validation.h>
 #include <util.h>
 
@@ -23,6 +24,7 @@ static const char *MSG_RAWBLOCK      = "rawblock";
 static const char *MSG_RAWCHAINLOCK  = "rawchainlock";
 static const char *MSG_RAWCLSIG      = "rawchainlocksig";
 static const char *MSG_RAWTX         = "rawtx";
+static const char *MSG_RAWTXWATCH    = "rawtxwatch";
 static const char *MSG_RAWTXLOCK     = "rawtxlock";
 static const char *MSG_RAWTXLOCKSIG  = "rawtxlocksig";
 static const char *MSG_RAWGVOTE      = "rawgovernancevote";
@@ -30,49 +32,134 @@ static const char *MSG_RAWGOBJ       = "rawgovernanceobject";
 static const char *MSG_RAWISCON      = "rawinstantsenddoublespend";
 static const char *MSG_RAWRECSIG     = "rawrecoveredsig";
 
-// Internal function to send multipart message
-static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
+namespace {
+
+/** A payload handed to libzmq, which passes it back to zmq_release_payload once it's done with it */
+struct CZMQPendingPayload
 {
-    va_list args;
-    va_start(args, size);
+    CZMQPayloadRef payload;
+    std::shared_ptr<CZMQNotifierStats> stats;
+    int64_t nTimeQueued;
+};
 
-    while (1)
-    {
-        zmq_msg_t msg;
+void zmq_release_payload(void* /*data*/, void* hint)
+{
+    CZMQPendingPayload* pending = static_cast<CZMQPendingPayload*>(hint);
+    pending->stats->RecordReleased(pending->payload->size(), GetTimeMicros() - pending->nTimeQueued);
+    delete pending;
+}
 
-        int rc = zmq_msg_init_size(&msg, size);
-        if (rc != 0)
+/**
+ * Serialized payloads of the objects published last. Several notifiers publish
+ * the same object for one event (rawtx, rawtxlock and rawtxlocksig or rawblock,
+ * rawchainlock and rawchainlocksig), so it's serialized, and blocks are read from
+ * disk, only once per event. Only the most recent object of each kind is kept.
+ */
+class CZMQPayloadCache
+{
+private:
+    CCriticalSection cs;
+    uint256 hashTx GUARDED_BY(cs);
+    CZMQPayloadRef txPayload GUARDED_BY(cs);
+    uint256 hashBlock GUARDED_BY(cs);
+    CZMQPayloadRef blockPayload GUARDED_BY(cs);
+
+public:
+    CZMQPayloadRef GetTransaction(const CTransaction& tx)
+    {
+        const uint256& hash = tx.GetHash();
         {
-            zmqError("Unable to initialize ZMQ msg");
-            va_end(args);
-            return -1;
+            LOCK(cs);
+            if (txPayload && hashTx == hash) {
+                return txPayload;
+            }
         }
+        auto ss = std::make_shared<CDataStream>(SER_NETWORK, PROTOCOL_VERSION);
+        *ss << tx;
+        LOCK(cs);
+        hashTx = hash;
+        txPayload = ss;
+        return txPayload;
+    }
 
-        void *buf = zmq_msg_data(&msg);
-        memcpy(buf, data, size);
-
-        data = va_arg(args, const void*);
-
-        rc = zmq_msg_send(&msg, sock, data ? ZMQ_SNDMORE : 0);
-        if (rc == -1)
+    /** Returns nullptr if the block can't be read from disk */
+    CZMQPayloadRef GetBlock(const CBlockIndex* pindex)
+    {
+        const uint256 hash = pindex->GetBlockHash();
         {
-            zmqError("Unable to send ZMQ msg");
-            zmq_msg_close(&msg);
-            va_end(args);
-            return -1;
+            LOCK(cs);
+            if (blockPayload && hashBlock == hash) {
+                return blockPayload;
+            }
         }
+        // don't hold cs while reading, to not make it part of the cs_main lock order
+        auto ss = std::make_shared<CDataStream>(SER_NETWORK, PROTOCOL_VERSION);
+        {
+            LOCK(cs_main);
+            CBlock block;
+            if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
+                zmqError("Can't read block from disk");
+                return nullptr;
+            }
+            *ss << block;
+        }
+        LOCK(cs);
+        hashBlock = hash;
+        blockPayload = ss;
+        return blockPayload;
+    }
+};
 
-        zmq_msg_close(&msg);
+CZMQPayloadCache payloadCache;
 
-        if (!data)
-            break;
+/** Hashes are published in reversed byte order, like they are displayed */
+CZMQPayloadRef MakeHashPayload(const uint256& hash)
+{
+    auto ss = std::make_shared<CDataStream>(SER_NETWORK, PROTOCOL_VERSION);
+    ss->resize(32);
+    for (unsigned int i = 0; i < 32; i++) {
+        (*ss)[31 - i] = hash.begin()[i];
+    }
+    return ss;
+}
+
+/** A copy of payload with obj appended */
+template <typename T>
+CZMQPayloadRef AppendToPayload(const CZMQPayloadRef& payload, const T& obj)
+{
+    auto ss = std::make_shared<CDataStream>(payload->begin(), payload->end(), SER_NETWORK, PROTOCOL_VERSION);
+    *ss << obj;
+    return ss;
+}
+
+template <typename T>
+CZMQPayloadRef MakePayload(const T& obj)
+{
+    auto ss = std::make_shared<CDataStream>(SER_NETWORK, PROTOCOL_VERSION);
+    *ss << obj;
+    return ss;
+}
 
-        size = va_arg(args, size_t);
+/** Send a small message part, copying it */
+bool zmq_send_copy(void* sock, const void* data, size_t size, int flags)
+{
+    zmq_msg_t msg;
+    if (zmq_msg_init_size(&msg, size) != 0) {
+        zmqError("Unable to initialize ZMQ msg");
+        return false;
+    }
+    memcpy(zmq_msg_data(&msg), data, size);
+    if (zmq_msg_send(&msg, sock, flags) == -1) {
+        zmqError("Unable to send ZMQ msg");
+        zmq_msg_close(&msg);
+        return false;
     }
-    va_end(args);
-    return 0;
+    zmq_msg_close(&msg);
+    return true;
 }
 
+} // namespace
+
 bool CZMQAbstractPublishNotifier::Initialize(void *pcontext)
 {
     assert(!psocket);
@@ -89,7 +176,16 @@ bool CZMQAbstractPublishNotifier::Initialize(void *pcontext)
             return false;
         }
 
-        int rc = zmq_bind(psocket, address.c_str());
+        LogPrint(BCLog::ZMQ, "zmq: Outbound message high water mark for %s at %s is %d\n", type, address, outbound_message_high_water_mark);
+
+        int rc = zmq_setsockopt(psocket, ZMQ_SNDHWM, &outbound_message_high_water_mark, sizeof(outbound_message_high_water_mark));
+        if (rc != 0) {
+            zmqError("Failed to set outbound message high water mark");
+            zmq_close(psocket);
+            return false;
+        }
+
+        rc = zmq_bind(psocket, address.c_str());
         if (rc!=0)
         {
             zmqError("Failed to bind address");
@@ -142,16 +238,40 @@ void CZMQAbstractPublishNotifier::Shutdown()
     psocket = nullptr;
 }
 
-bool CZMQAbstractPublishNotifier::SendMessage(const char *command, const void* data, size_t size)
+bool CZMQAbstractPublishNotifier::SendMessage(const char *command, const CZMQPayloadRef& payload)
 {
     assert(psocket);
 
     /* send three parts, command & data & a LE 4byte sequence number */
+    if (!zmq_send_copy(psocket, command, strlen(command), ZMQ_SNDMORE | ZMQ_DONTWAIT)) {
+        stats->nDropped++;
+        return false;
+    }
+
+    // from here on the message is owned by libzmq, which calls zmq_release_payload when it's done with it
+    CZMQPendingPayload* pending = new CZMQPendingPayload{payload, stats, GetTimeMicros()};
+    zmq_msg_t msg;
+    if (zmq_msg_init_data(&msg, const_cast<char*>(payload->data()), payload->size(), zmq_release_payload, pending) != 0) {
+        zmqError("Unable to initialize ZMQ msg");
+        delete pending;
+        stats->nDropped++;
+        return false;
+    }
+    stats->RecordQueued(payload->size());
+    if (zmq_msg_send(&msg, psocket, ZMQ_SNDMORE | ZMQ_DONTWAIT) == -1) {
+        zmqError("Unable to send ZMQ msg");
+        zmq_msg_close(&msg);
+        stats->nDropped++;
+        return false;
+    }
+    zmq_msg_close(&msg);
+
     unsigned char msgseq[sizeof(uint32_t)];
     WriteLE32(&msgseq[0], nSequence);
-    int rc = zmq_send_multipart(psocket, command, strlen(command), data, size, msgseq, (size_t)sizeof(uint32_t), nullptr);
-    if (rc == -1)
+    if (!zmq_send_copy(psocket, msgseq, sizeof(msgseq), ZMQ_DONTWAIT)) {
+        stats->nDropped++;
         return false;
+    }
 
     /* increment memory only sequence number after sending */
     nSequence++;
@@ -163,211 +283,145 @@ bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
 {
     uint256 hash = pindex->GetBlockHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashblock %s\n", hash.GetHex());
-    char data[32];
-    for (unsigned int i = 0; i < 32; i++)
-        data[31 - i] = hash.begin()[i];
-    return SendMessage(MSG_HASHBLOCK, data, 32);
+    return SendMessage(MSG_HASHBLOCK, MakeHashPayload(hash));
 }
 
 bool CZMQPublishHashChainLockNotifier::NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig)
 {
     uint256 hash = pindex->GetBlockHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashchainlock %s\n", hash.GetHex());
-    char data[32];
-    for (unsigned int i = 0; i < 32; i++)
-        data[31 - i] = hash.begin()[i];
-    return SendMessage(MSG_HASHCHAINLOCK, data, 32);
+    return SendMessage(MSG_HASHCHAINLOCK, MakeHashPayload(hash));
 }
 
 bool CZMQPublishHashTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
 {
     uint256 hash = transaction.GetHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashtx %s\n", hash.GetHex());
-    char data[32];
-    for (unsigned int i = 0; i < 32; i++)
-        data[31 - i] = hash.begin()[i];
-    return SendMessage(MSG_HASHTX, data, 32);
+    return SendMessage(MSG_HASHTX, MakeHashPayload(hash));
 }
 
 bool CZMQPublishHashTransactionLockNotifier::NotifyTransactionLock(const CTransactionRef& transaction, const std::shared_ptr<const llmq::CInstantSendLock>& islock)
 {
     uint256 hash = transaction->GetHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashtxlock %s\n", hash.GetHex());
-    char data[32];
-    for (unsigned int i = 0; i < 32; i++)
-        data[31 - i] = hash.begin()[i];
-    return SendMessage(MSG_HASHTXLOCK, data, 32);
+    return SendMessage(MSG_HASHTXLOCK, MakeHashPayload(hash));
 }
 
 bool CZMQPublishHashGovernanceVoteNotifier::NotifyGovernanceVote(const std::shared_ptr<const CGovernanceVote>& vote)
 {
     uint256 hash = vote->GetHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashgovernancevote %s\n", hash.GetHex());
-    char data[32];
-    for (unsigned int i = 0; i < 32; i++)
-        data[31 - i] = hash.begin()[i];
-    return SendMessage(MSG_HASHGVOTE, data, 32);
+    return SendMessage(MSG_HASHGVOTE, MakeHashPayload(hash));
 }
 
 bool CZMQPublishHashGovernanceObjectNotifier::NotifyGovernanceObject(const std::shared_ptr<const CGovernanceObject>& object)
 {
     uint256 hash = object->GetHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashgovernanceobject %s\n", hash.GetHex());
-    char data[32];
-    for (unsigned int i = 0; i < 32; i++)
-        data[31 - i] = hash.begin()[i];
-    return SendMessage(MSG_HASHGOBJ, data, 32);
+    return SendMessage(MSG_HASHGOBJ, MakeHashPayload(hash));
 }
 
 bool CZMQPublishHashInstantSendDoubleSpendNotifier::NotifyInstantSendDoubleSpendAttempt(const CTransactionRef& currentTx, const CTransactionRef& previousTx)
 {
     uint256 currentHash = currentTx->GetHash(), previousHash = previousTx->GetHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashinstantsenddoublespend %s conflicts against %s\n", currentHash.ToString(), previousHash.ToString());
-    char dataCurrentHash[32], dataPreviousHash[32];
-    for (unsigned int i = 0; i < 32; i++) {
-        dataCurrentHash[31 - i] = currentHash.begin()[i];
-        dataPreviousHash[31 - i] = previousHash.begin()[i];
-    }
-    return SendMessage(MSG_HASHISCON, dataCurrentHash, 32)
-        && SendMessage(MSG_HASHISCON, dataPreviousHash, 32);
+    return SendMessage(MSG_HASHISCON, MakeHashPayload(currentHash))
+        && SendMessage(MSG_HASHISCON, MakeHashPayload(previousHash));
 }
 
 bool CZMQPublishHashRecoveredSigNotifier::NotifyRecoveredSig(const std::shared_ptr<const llmq::CRecoveredSig> &sig)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish hashrecoveredsig %s\n", sig->msgHash.ToString());
-    char data[32];
-    for (unsigned int i = 0; i < 32; i++)
-        data[31 - i] = sig->msgHash.begin()[i];
-    return SendMessage(MSG_HASHRECSIG, data, 32);
+    return SendMessage(MSG_HASHRECSIG, MakeHashPayload(sig->msgHash));
 }
 
 bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawblock %s\n", pindex->GetBlockHash().GetHex());
 
-    const Consensus::Params& consensusParams = Params().GetConsensus();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    {
-        LOCK(cs_main);
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex, consensusParams))
-        {
-            zmqError("Can't read block from disk");
-            return false;
-        }
-
-        ss << block;
+    CZMQPayloadRef payload = payloadCache.GetBlock(pindex);
+    if (!payload) {
+        return false;
     }
-
-    return SendMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWBLOCK, payload);
 }
 
 bool CZMQPublishRawChainLockNotifier::NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawchainlock %s\n", pindex->GetBlockHash().GetHex());
 
-    const Consensus::Params& consensusParams = Params().GetConsensus();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    {
-        LOCK(cs_main);
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex, consensusParams))
-        {
-            zmqError("Can't read block from disk");
-            return false;
-        }
-
-        ss << block;
+    CZMQPayloadRef payload = payloadCache.GetBlock(pindex);
+    if (!payload) {
+        return false;
     }
-
-    return SendMessage(MSG_RAWCHAINLOCK, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWCHAINLOCK, payload);
 }
 
 bool CZMQPublishRawChainLockSigNotifier::NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawchainlocksig %s\n", pindex->GetBlockHash().GetHex());
 
-    const Consensus::Params& consensusParams = Params().GetConsensus();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    {
-        LOCK(cs_main);
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex, consensusParams))
-        {
-            zmqError("Can't read block from disk");
-            return false;
-        }
-
-        ss << block;
-        ss << *clsig;
+    CZMQPayloadRef payload = payloadCache.GetBlock(pindex);
+    if (!payload) {
+        return false;
     }
-
-    return SendMessage(MSG_RAWCLSIG, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWCLSIG, AppendToPayload(payload, *clsig));
 }
 
 bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
 {
     uint256 hash = transaction.GetHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish rawtx %s\n", hash.GetHex());
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << transaction;
-    return SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWTX, payloadCache.GetTransaction(transaction));
+}
+
+bool CZMQPublishRawTransactionWatchNotifier::NotifyTransaction(const CTransaction &transaction)
+{
+    if (!g_zmq_watch_set.Matches(transaction)) {
+        return true;
+    }
+    uint256 hash = transaction.GetHash();
+    LogPrint(BCLog::ZMQ, "zmq: Publish rawtxwatch %s\n", hash.GetHex());
+    return SendMessage(MSG_RAWTXWATCH, payloadCache.GetTransaction(transaction));
 }
 
 bool CZMQPublishRawTransactionLockNotifier::NotifyTransactionLock(const CTransactionRef& transaction, const std::shared_ptr<const llmq::CInstantSendLock>& islock)
 {
     uint256 hash = transaction->GetHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish rawtxlock %s\n", hash.GetHex());
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << *transaction;
-    return SendMessage(MSG_RAWTXLOCK, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWTXLOCK, payloadCache.GetTransaction(*transaction));
 }
 
 bool CZMQPublishRawTransactionLockSigNotifier::NotifyTransactionLock(const CTransactionRef& transaction, const std::shared_ptr<const llmq::CInstantSendLock>& islock)
 {
     uint256 hash = transaction->GetHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish rawtxlocksig %s\n", hash.GetHex());
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << *transaction;
-    ss << *islock;
-    return SendMessage(MSG_RAWTXLOCKSIG, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWTXLOCKSIG, AppendToPayload(payloadCache.GetTransaction(*transaction), *islock));
 }
 
 bool CZMQPublishRawGovernanceVoteNotifier::NotifyGovernanceVote(const std::shared_ptr<const CGovernanceVote>& vote)
 {
     uint256 nHash = vote->GetHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish rawgovernanceobject: hash = %s, vote = %d\n", nHash.ToString(), vote->ToString());
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << *vote;
-    return SendMessage(MSG_RAWGVOTE, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWGVOTE, MakePayload(*vote));
 }
 
 bool CZMQPublishRawGovernanceObjectNotifier::NotifyGovernanceObject(const std::shared_ptr<const CGovernanceObject>& govobj)
 {
     uint256 nHash = govobj->GetHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish rawgovernanceobject: hash = %s, type = %d\n", nHash.ToString(), govobj->GetObjectType());
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << *govobj;
-    return SendMessage(MSG_RAWGOBJ, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWGOBJ, MakePayload(*govobj));
 }
 
 bool CZMQPublishRawInstantSendDoubleSpendNotifier::NotifyInstantSendDoubleSpendAttempt(const CTransactionRef& currentTx, const CTransactionRef& previousTx)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawinstantsenddoublespend %s conflicts with %s\n", currentTx->GetHash().ToString(), previousTx->GetHash().ToString());
-    CDataStream ssCurrent(SER_NETWORK, PROTOCOL_VERSION), ssPrevious(SER_NETWORK, PROTOCOL_VERSION);
-    ssCurrent << *currentTx;
-    ssPrevious << *previousTx;
-    return SendMessage(MSG_RAWISCON, &(*ssCurrent.begin()), ssCurrent.size())
-        && SendMessage(MSG_RAWISCON, &(*ssPrevious.begin()), ssPrevious.size());
+    return SendMessage(MSG_RAWISCON, payloadCache.GetTransaction(*currentTx))
+        && SendMessage(MSG_RAWISCON, MakePayload(*previousTx));
 }
 
 bool CZMQPublishRawRecoveredSigNotifier::NotifyRecoveredSig(const std::shared_ptr<const llmq::CRecoveredSig>& sig)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawrecoveredsig %s\n", sig->msgHash.ToString());
-
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << *sig;
-
-    return SendMessage(MSG_RAWRECSIG, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWRECSIG, MakePayload(*sig));
 }
-
@@ -5,12 +5,16 @@
 #ifndef BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
 #define BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
 
+#include <streams.h>
 #include <zmq/zmqabstractnotifier.h>
 
 class CBlockIndex;
 class CGovernanceVote;
 class CGovernanceObject;
 
+/** Serialized message data, shared by all notifiers publishing it and handed to libzmq without copying */
+typedef std::shared_ptr<const CDataStream> CZMQPayloadRef;
+
 class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier
 {
 private:
@@ -24,7 +28,7 @@ public:
           * data
           * message sequence number
     */
-    bool SendMessage(const char *command, const void* data, size_t size);
+    bool SendMessage(const char *command, const CZMQPayloadRef& payload);
 
     bool Initialize(void *pcontext) override;
     void Shutdown() override;
@@ -102,6 +106,12 @@ public:
     bool NotifyTransaction(const CTransaction &transaction) override;
 };
 
+class CZMQPublishRawTransactionWatchNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyTransaction(const CTransaction &transaction) override;
+};
+
 class CZMQPublishRawTransactionLockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
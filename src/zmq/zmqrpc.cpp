@@ -4,9 +4,14 @@
 
 #include <zmq/zmqrpc.h>
 
+#include <key_io.h>
+#include <rpc/protocol.h>
 #include <rpc/server.h>
+#include <script/standard.h>
+#include <utilstrencodings.h>
 #include <zmq/zmqabstractnotifier.h>
 #include <zmq/zmqnotificationinterface.h>
+#include <zmq/zmqwatchset.h>
 
 #include <univalue.h>
 
@@ -23,6 +28,15 @@ UniValue getzmqnotifications(const JSONRPCRequest& request)
             "  {                        (json object)\n"
             "    \"type\": \"pubhashtx\",   (string) Type of notification\n"
             "    \"address\": \"...\"       (string) Address of the publisher\n"
+            "    \"hwm\": n,              (numeric) Outbound message high water mark\n"
+            "    \"messages\": n,         (numeric) Number of messages published\n"
+            "    \"bytes\": n,            (numeric) Payload bytes published\n"
+            "    \"dropped\": n,          (numeric) Number of messages the socket refused to queue\n"
+            "    \"queue_dropped\": n,    (numeric) Number of notifications dropped because the publisher queue was full\n"
+            "    \"queued\": n,           (numeric) Number of messages still held by ZeroMQ for sending\n"
+            "    \"queued_bytes\": n,     (numeric) Payload bytes still held by ZeroMQ for sending\n"
+            "    \"avg_latency\": n,      (numeric) Average time in microseconds from publishing a message until ZeroMQ was done sending it\n"
+            "    \"max_latency\": n       (numeric) Maximum of these times\n"
             "  },\n"
             "  ...\n"
             "]\n"
@@ -38,6 +52,17 @@ UniValue getzmqnotifications(const JSONRPCRequest& request)
             UniValue obj(UniValue::VOBJ);
             obj.pushKV("type", n->GetType());
             obj.pushKV("address", n->GetAddress());
+            obj.pushKV("hwm", n->GetOutboundMessageHighWaterMark());
+            const CZMQNotifierStats& stats = n->GetStats();
+            const uint64_t nReleased = stats.nReleased;
+            obj.pushKV("messages", stats.nMessages.load());
+            obj.pushKV("bytes", stats.nBytes.load());
+            obj.pushKV("dropped", stats.nDropped.load());
+            obj.pushKV("queue_dropped", stats.nQueueDropped.load());
+            obj.pushKV("queued", stats.nQueued.load());
+            obj.pushKV("queued_bytes", stats.nQueuedBytes.load());
+            obj.pushKV("avg_latency", nReleased ? stats.nLatencyTotal / (int64_t)nReleased : 0);
+            obj.pushKV("max_latency", stats.nLatencyMax.load());
             result.push_back(obj);
         }
     }
@@ -45,10 +70,92 @@ UniValue getzmqnotifications(const JSONRPCRequest& request)
     return result;
 }
 
+UniValue setzmqwatch(const JSONRPCRequest& request)
+{
+    const std::string strCommand = request.params.size() > 0 ? request.params[0].get_str() : "";
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2 ||
+        (strCommand != "add" && strCommand != "remove" && strCommand != "clear") ||
+        (strCommand != "clear" && request.params.size() != 2)) {
+        throw std::runtime_error(
+            "setzmqwatch \"command\" ( [\"address|script\",...] )\n"
+            "\nChanges the addresses and scripts watched by -zmqpubrawtxwatch, which publishes\n"
+            "transactions paying to or spending from them.\n"
+            "\nArguments:\n"
+            "1. \"command\"      (string, required) 'add' or 'remove' the given items, or 'clear' all of them\n"
+            "2. \"items\"        (json array, required for add and remove) Addresses or hex encoded scripts\n"
+            "\nResult:\n"
+            "n                 (numeric) The number of watched scripts\n"
+            "\nExamples:\n"
+            + HelpExampleCli("setzmqwatch", "add \"[\\\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\\\"]\"")
+            + HelpExampleCli("setzmqwatch", "clear")
+            + HelpExampleRpc("setzmqwatch", "\"add\", [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]")
+        );
+    }
+
+    if (strCommand == "clear") {
+        g_zmq_watch_set.Clear();
+        return 0;
+    }
+
+    std::vector<CScript> vScripts;
+    for (const UniValue& item : request.params[1].get_array().getValues()) {
+        CScript script;
+        if (!ParseZMQWatchScript(item.get_str(), script)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("%s is neither an address nor a hex encoded script", item.get_str()));
+        }
+        vScripts.emplace_back(std::move(script));
+    }
+    for (const CScript& script : vScripts) {
+        if (strCommand == "add") {
+            g_zmq_watch_set.Add(script);
+        } else {
+            g_zmq_watch_set.Remove(script);
+        }
+    }
+
+    return (uint64_t)g_zmq_watch_set.Size();
+}
+
+UniValue getzmqwatch(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0) {
+        throw std::runtime_error(
+            "getzmqwatch\n"
+            "\nReturns the scripts watched by -zmqpubrawtxwatch.\n"
+            "\nResult:\n"
+            "[\n"
+            "  {                        (json object)\n"
+            "    \"script\": \"hex\",       (string) The watched script\n"
+            "    \"address\": \"...\"       (string, optional) The address of the script, if it has one\n"
+            "  },\n"
+            "  ...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getzmqwatch", "")
+            + HelpExampleRpc("getzmqwatch", "")
+        );
+    }
+
+    UniValue result(UniValue::VARR);
+    for (const CScript& script : g_zmq_watch_set.GetScripts()) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("script", HexStr(script.begin(), script.end()));
+        CTxDestination dest;
+        if (ExtractDestination(script, dest)) {
+            obj.pushKV("address", EncodeDestination(dest));
+        }
+        result.push_back(obj);
+    }
+
+    return result;
+}
+
 const CRPCCommand commands[] =
 { //  category              name                                actor (function)                argNames
   //  -----------------     ------------------------            -----------------------         ----------
     { "zmq",                "getzmqnotifications",              &getzmqnotifications,           {} },
+    { "zmq",                "getzmqwatch",                      &getzmqwatch,                   {} },
+    { "zmq",                "setzmqwatch",                      &setzmqwatch,                   {"command", "items"} },
 };
 
 } // anonymous namespace
@@ -0,0 +1,139 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <zmq/zmqwatchset.h>
+
+#include <coins.h>
+#include <key_io.h>
+#include <primitives/transaction.h>
+#include <script/standard.h>
+#include <spentindex.h>
+#include <txmempool.h>
+#include <utilstrencodings.h>
+#include <validation.h>
+
+CZMQWatchSet g_zmq_watch_set;
+
+/** Script of the output spent by prevout, from the index if it's provided the address type and hash */
+static bool GetScriptFromSpentIndex(const COutPoint& prevout, CScript& scriptRet)
+{
+    CSpentIndexKey key(prevout.hash, prevout.n);
+    CSpentIndexValue value;
+    if (!GetSpentIndex(key, value)) {
+        return false;
+    }
+    if (value.addressType == 1) {
+        scriptRet = GetScriptForDestination(CKeyID(value.addressHash));
+        return true;
+    }
+    if (value.addressType == 2) {
+        scriptRet = GetScriptForDestination(CScriptID(value.addressHash));
+        return true;
+    }
+    return false;
+}
+
+bool CZMQWatchSet::Contains(const CScript& script) const
+{
+    LOCK(cs);
+    return setScripts.count(script) != 0;
+}
+
+bool CZMQWatchSet::Add(const CScript& script)
+{
+    LOCK(cs);
+    return setScripts.insert(script).second;
+}
+
+bool CZMQWatchSet::Remove(const CScript& script)
+{
+    LOCK(cs);
+    return setScripts.erase(script) != 0;
+}
+
+void CZMQWatchSet::Clear()
+{
+    LOCK(cs);
+    setScripts.clear();
+}
+
+size_t CZMQWatchSet::Size() const
+{
+    LOCK(cs);
+    return setScripts.size();
+}
+
+std::vector<CScript> CZMQWatchSet::GetScripts() const
+{
+    LOCK(cs);
+    return std::vector<CScript>(setScripts.begin(), setScripts.end());
+}
+
+bool CZMQWatchSet::Matches(const CTransaction& tx) const
+{
+    {
+        LOCK(cs);
+        if (setScripts.empty()) {
+            return false;
+        }
+        for (const CTxOut& txout : tx.vout) {
+            if (setScripts.count(txout.scriptPubKey)) {
+                return true;
+            }
+        }
+    }
+    if (tx.IsCoinBase()) {
+        return false;
+    }
+
+    std::vector<COutPoint> vMissing;
+    for (const CTxIn& txin : tx.vin) {
+        CScript script;
+        CTransactionRef ptxPrev = mempool.get(txin.prevout.hash);
+        if (ptxPrev && txin.prevout.n < ptxPrev->vout.size()) {
+            script = ptxPrev->vout[txin.prevout.n].scriptPubKey;
+        } else if (!fSpentIndex || !GetScriptFromSpentIndex(txin.prevout, script)) {
+            vMissing.emplace_back(txin.prevout);
+            continue;
+        }
+        if (Contains(script)) {
+            return true;
+        }
+    }
+    if (vMissing.empty()) {
+        return false;
+    }
+
+    std::vector<CScript> vScripts;
+    {
+        LOCK(cs_main);
+        for (const COutPoint& prevout : vMissing) {
+            const Coin& coin = pcoinsTip->AccessCoin(prevout);
+            if (!coin.IsSpent()) {
+                vScripts.emplace_back(coin.out.scriptPubKey);
+            }
+        }
+    }
+    for (const CScript& script : vScripts) {
+        if (Contains(script)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseZMQWatchScript(const std::string& str, CScript& scriptRet)
+{
+    CTxDestination dest = DecodeDestination(str);
+    if (IsValidDestination(dest)) {
+        scriptRet = GetScriptForDestination(dest);
+        return true;
+    }
+    if (!str.empty() && IsHex(str)) {
+        std::vector<unsigned char> vch(ParseHex(str));
+        scriptRet = CScript(vch.begin(), vch.end());
+        return true;
+    }
+    return false;
+}
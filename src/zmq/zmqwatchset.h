@@ -0,0 +1,53 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_ZMQ_ZMQWATCHSET_H
+#define BITCOIN_ZMQ_ZMQWATCHSET_H
+
+#include <script/script.h>
+#include <sync.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+class CTransaction;
+
+/**
+ * Scripts watched by the pubrawtxwatch notification, set up with -zmqwatch and
+ * managed with the setzmqwatch RPC. A transaction matches if one of its outputs
+ * pays to, or one of its inputs spends from, a watched script.
+ */
+class CZMQWatchSet
+{
+private:
+    mutable CCriticalSection cs;
+    std::set<CScript> setScripts GUARDED_BY(cs);
+
+    bool Contains(const CScript& script) const;
+
+public:
+    /** Returns false if the script was watched already */
+    bool Add(const CScript& script);
+    /** Returns false if the script wasn't watched */
+    bool Remove(const CScript& script);
+    void Clear();
+    size_t Size() const;
+    std::vector<CScript> GetScripts() const;
+
+    /**
+     * The scripts spent by the inputs are looked up in the mempool, in the
+     * spent index if enabled and in the UTXO set otherwise. Without -spentindex,
+     * inputs of confirmed transactions can only be matched while their block
+     * isn't connected yet.
+     */
+    bool Matches(const CTransaction& tx) const;
+};
+
+/** Parse an address or a hex encoded script, returns false if it's neither */
+bool ParseZMQWatchScript(const std::string& str, CScript& scriptRet);
+
+extern CZMQWatchSet g_zmq_watch_set;
+
+#endif // BITCOIN_ZMQ_ZMQWATCHSET_H
@@ -35,15 +35,13 @@ class AddressIndexTest(BitcoinTestFramework):
         self.sync_all()
 
     def run_test(self):
-        self.log.info("Test that settings can't be changed without -reindex...")
+        self.log.info("Test that settings can be changed without -reindex...")
         self.stop_node(1)
-        self.nodes[1].assert_start_raises_init_error(["-addressindex=0"], "You need to rebuild the database using -reindex to change -addressindex", partial_match=True)
-        self.start_node(1, ["-addressindex=0", "-reindex"])
+        self.start_node(1, ["-addressindex=0"])
         connect_nodes(self.nodes[0], 1)
         self.sync_all()
         self.stop_node(1)
-        self.nodes[1].assert_start_raises_init_error(["-addressindex"], "You need to rebuild the database using -reindex to change -addressindex", partial_match=True)
-        self.start_node(1, ["-addressindex", "-reindex"])
+        self.start_node(1, ["-addressindex"])
         connect_nodes(self.nodes[0], 1)
         self.sync_all()
 
@@ -145,6 +143,18 @@ class AddressIndexTest(BitcoinTestFramework):
         assert_equal(len(txidsmany), 4)
         assert_equal(txidsmany[3], sent_txid)
 
+        # Check that txids can be paginated, transactions are never split between pages
+        paged_txids = []
+        query = {"addresses": ["93bVhahvUKmQu8gu9g3QnPPa2cxFK98pMB"], "limit": 1}
+        while True:
+            page = self.nodes[1].getaddresstxids(query)
+            assert_equal(len(page["txids"]), 1)
+            paged_txids += page["txids"]
+            if "cursor" not in page:
+                break
+            query["cursor"] = page["cursor"]
+        assert_equal(paged_txids, txidsmany)
+
         # Check that balances are correct
         self.log.info("Testing balances...")
         balance0 = self.nodes[1].getaddressbalance("93bVhahvUKmQu8gu9g3QnPPa2cxFK98pMB")
@@ -169,7 +169,7 @@ class QuorumDataRecoveryTest(DashTestFramework):
         # Now restart with recovery enabled
         self.restart_mns(mns=recover_members, exclude=exclude_members, reindex=True, qdata_recovery_enabled=True)
         # Validate that all invalid members recover. Note: recover=True leads to mocktime bumps and mining while waiting
-        # which trigger CQuorumManger::TriggerQuorumDataRecoveryThreads()
+        # which trigger CQuorumManager::TriggerQuorumDataRecoveries()
         self.test_mns(llmq_test, quorum_hash_recover, valid_mns=member_mns_recover_test, recover=True)
         self.test_mns(llmq_test_v17, quorum_hash_recover, valid_mns=member_mns_recover_v17, recover=True)
         # Mining a block should result in a chainlock now because the quorum should be healed
@@ -0,0 +1,238 @@
+#!/usr/bin/env python3
+# Copyright (c) 2021 The Dash Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+import json
+import os
+import time
+
+from test_framework.test_framework import DashTestFramework
+from test_framework.util import assert_equal, satoshi_round, wait_until
+
+'''
+feature_node_throughput.py
+
+End-to-end throughput benchmark, not run by default.
+
+Spins up a regtest network with --masternodes masternodes and active LLMQs,
+then runs --rounds rounds of load. Each round broadcasts --txs independent
+transactions from the control node, waits for all of them to be islocked,
+mines a block and waits for its ChainLock. --coinjoin additionally keeps
+CoinJoin mixing running on the control node in the background.
+
+The results are written as JSON to --results: transaction throughput,
+ISLOCK and CLSIG latency percentiles, CPU time and memory of every node,
+and the scheduler task and lock contention stats of the control node and
+the first masternode. Latencies are measured from the test's point of
+view and include the RPC polling interval (POLL_INTERVAL).
+'''
+
+POLL_INTERVAL = 0.05
+FEE = satoshi_round(0.001)
+
+def percentiles(values):
+    """Nearest rank percentiles of a list of latencies"""
+    if len(values) == 0:
+        return {}
+    values = sorted(values)
+    def rank(p):
+        return values[min(len(values) - 1, int(len(values) * p / 100))]
+    return {
+        "count": len(values),
+        "min": values[0],
+        "p50": rank(50),
+        "p90": rank(90),
+        "p99": rank(99),
+        "max": values[-1],
+    }
+
+def process_usage(pid):
+    """CPU seconds and resident memory of a process, read from /proc (Linux only)"""
+    usage = {}
+    try:
+        with open("/proc/%d/stat" % pid, encoding="utf8") as f:
+            # the process name may contain spaces, fields are counted from its closing parenthesis
+            fields = f.read().rsplit(")", 1)[1].split()
+        ticks = os.sysconf("SC_CLK_TCK")
+        usage["cpu_user_s"] = int(fields[11]) / ticks
+        usage["cpu_system_s"] = int(fields[12]) / ticks
+        with open("/proc/%d/status" % pid, encoding="utf8") as f:
+            for line in f:
+                if line.startswith("VmRSS:") or line.startswith("VmHWM:"):
+                    usage[line.split(":")[0].lower() + "_kb"] = int(line.split()[1])
+    except (OSError, IndexError, ValueError):
+        pass
+    return usage
+
+class NodeThroughputBenchmark(DashTestFramework):
+    def set_test_params(self):
+        # Replaced in setup_chain once the options are known
+        self.set_dash_test_params(6, 5, fast_dip3_enforcement=True)
+
+    def add_options(self, parser):
+        parser.add_option("--masternodes", dest="masternodes", default=5, type="int",
+                          help="Number of masternodes (default: %default)")
+        parser.add_option("--txs", dest="txs", default=50, type="int",
+                          help="Transactions broadcast per round (default: %default)")
+        parser.add_option("--rounds", dest="rounds", default=5, type="int",
+                          help="Number of load rounds (default: %default)")
+        parser.add_option("--coinjoin", dest="coinjoin", default=False, action="store_true",
+                          help="Run CoinJoin mixing on the control node during the rounds")
+        parser.add_option("--results", dest="results", default="node_throughput.json",
+                          help="File to write the JSON results to (default: %default)")
+
+    def setup_chain(self):
+        mn_count = self.options.masternodes
+        assert mn_count >= self.llmq_size
+        self.set_dash_test_params(mn_count + 1, mn_count, [["-lockstats=1"]] * (mn_count + 1), fast_dip3_enforcement=True)
+        super().setup_chain()
+
+    def run_test(self):
+        self.activate_dip8()
+
+        self.nodes[0].spork("SPORK_17_QUORUM_DKG_ENABLED", 0)
+        self.wait_for_sporks_same()
+
+        self.mine_quorum()
+        self.mine_quorum()
+        self.wait_for_chainlocked_block_all_nodes(self.nodes[0].getbestblockhash(), timeout=30)
+
+        utxos = self.prepare_utxos(self.options.txs * self.options.rounds)
+
+        if self.options.coinjoin:
+            self.log.info("Starting CoinJoin mixing on the control node")
+            self.nodes[0].coinjoin("start")
+
+        usage_before = [process_usage(node.process.pid) for node in self.nodes]
+        for node in self.nodes:
+            node.getlockstats(0, True)
+
+        islock_latencies = []
+        clsig_latencies = []
+        tx_count = 0
+        load_time = 0.0
+        for r in range(self.options.rounds):
+            txs = [self.create_tx(utxo) for utxo in utxos[r * self.options.txs:(r + 1) * self.options.txs]]
+            round_latencies, round_time = self.run_islock_round(txs)
+            islock_latencies += round_latencies
+            tx_count += len(txs)
+            load_time += round_time
+            clsig_latencies.append(self.run_clsig_round())
+            self.log.info("Round %d: %d txs islocked in %.2fs, islock p50=%.0fms, clsig=%.0fms" % (
+                r, len(txs), round_time, percentiles(round_latencies)["p50"], clsig_latencies[-1]))
+
+        usage_after = [process_usage(node.process.pid) for node in self.nodes]
+
+        results = {
+            "config": {
+                "masternodes": self.options.masternodes,
+                "llmq_size": self.llmq_size,
+                "llmq_threshold": self.llmq_threshold,
+                "txs_per_round": self.options.txs,
+                "rounds": self.options.rounds,
+                "coinjoin": self.options.coinjoin,
+            },
+            "throughput": {
+                "txs": tx_count,
+                "duration_s": load_time,
+                "txs_per_s": tx_count / load_time if load_time > 0 else 0,
+            },
+            "islock_latency_ms": percentiles(islock_latencies),
+            "clsig_latency_ms": percentiles(clsig_latencies),
+            "nodes": [],
+        }
+        for i, node in enumerate(self.nodes):
+            node_results = {
+                "index": i,
+                "masternode": i != 0,
+                "memory": node.getmemoryinfo()["locked"],
+            }
+            before, after = usage_before[i], usage_after[i]
+            for key in ("cpu_user_s", "cpu_system_s"):
+                if key in before and key in after:
+                    node_results[key] = after[key] - before[key]
+            for key in ("vmrss_kb", "vmhwm_kb"):
+                if key in after:
+                    node_results[key] = after[key]
+            # The full per-subsystem stats only for the control node and one masternode, to keep the output readable
+            if i <= 1:
+                node_results["scheduler"] = node.getschedulerinfo()
+                node_results["locks"] = node.getlockstats(20)["sites"]
+            if self.options.coinjoin and i == 0:
+                node_results["coinjoin"] = node.getcoinjoininfo()
+            results["nodes"].append(node_results)
+
+        if self.options.coinjoin:
+            self.nodes[0].coinjoin("stop")
+
+        with open(self.options.results, "w", encoding="utf8") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+        self.log.info("Throughput: %.1f txs/s, islock p50=%sms p99=%sms, clsig p50=%sms" % (
+            results["throughput"]["txs_per_s"], results["islock_latency_ms"]["p50"],
+            results["islock_latency_ms"]["p99"], results["clsig_latency_ms"]["p50"]))
+        self.log.info("Results written to %s" % os.path.abspath(self.options.results))
+
+    def prepare_utxos(self, count):
+        """Split coins into confirmed and chainlocked outputs, so every load tx can be locked independently"""
+        self.log.info("Preparing %d utxos" % count)
+        node = self.nodes[0]
+        addresses = []
+        while len(addresses) < count:
+            batch = {}
+            for _ in range(min(100, count - len(addresses))):
+                address = node.getnewaddress()
+                batch[address] = 1
+                addresses.append(address)
+            node.sendmany("", batch)
+        self.bump_mocktime(1)
+        block = node.generate(1)[0]
+        self.sync_all()
+        self.wait_for_chainlocked_block_all_nodes(block, timeout=30)
+
+        addresses = set(addresses)
+        utxos = [u for u in node.listunspent(1) if u["address"] in addresses and u["amount"] == 1]
+        assert_equal(len(utxos), count)
+        # keep CoinJoin from spending them
+        node.lockunspent(False, [{"txid": u["txid"], "vout": u["vout"]} for u in utxos])
+        return utxos
+
+    def create_tx(self, utxo):
+        node = self.nodes[0]
+        outputs = {node.getnewaddress(): satoshi_round(utxo["amount"]) - FEE}
+        rawtx = node.createrawtransaction([{"txid": utxo["txid"], "vout": utxo["vout"]}], outputs)
+        return node.signrawtransactionwithwallet(rawtx)["hex"]
+
+    def run_islock_round(self, txs):
+        """Broadcast all txs and return the ISLOCK latency of each one in ms and the time until the last one was locked"""
+        node = self.nodes[0]
+        sent = {}
+        start = time.time()
+        for tx in txs:
+            sent[node.sendrawtransaction(tx)] = time.time()
+
+        latencies = []
+        pending = set(sent.keys())
+        def check_islocks():
+            for txid in list(pending):
+                if node.getrawtransaction(txid, True)["instantlock"]:
+                    latencies.append((time.time() - sent[txid]) * 1000)
+                    pending.remove(txid)
+            return len(pending) == 0
+        wait_until(check_islocks, timeout=max(60, len(txs)), sleep=POLL_INTERVAL)
+        return latencies, time.time() - start
+
+    def run_clsig_round(self):
+        """Mine a block with the locked txs and return how long its ChainLock took in ms"""
+        node = self.nodes[0]
+        self.bump_mocktime(1)
+        start = time.time()
+        block = node.generate(1)[0]
+        wait_until(lambda: node.getbestchainlock()["blockhash"] == block, timeout=60, sleep=POLL_INTERVAL)
+        latency = (time.time() - start) * 1000
+        self.sync_all()
+        return latency
+
+
+if __name__ == '__main__':
+    NodeThroughputBenchmark().main()
@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+# Copyright (c) 2021 The Dash Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the UTXO set commitment of -utxocommitment and gettxoutsetinfo hash types."""
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, assert_raises_rpc_error, connect_nodes
+
+
+class UTXOCommitmentTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 2
+        self.extra_args = [['-utxocommitment'], []]
+
+    def check_stats(self):
+        self.sync_all()
+        fast = self.nodes[0].gettxoutsetinfo('muhash')
+        scanned = self.nodes[1].gettxoutsetinfo('muhash')
+        full = self.nodes[1].gettxoutsetinfo()
+        none = self.nodes[1].gettxoutsetinfo('none')
+        for key in ['height', 'bestblock', 'txouts', 'bogosize', 'total_amount', 'muhash']:
+            assert_equal(fast[key], scanned[key])
+        for key in ['height', 'bestblock', 'transactions', 'txouts', 'bogosize', 'total_amount']:
+            assert_equal(scanned[key], full[key])
+            assert_equal(none[key], full[key])
+        assert 'transactions' not in fast
+        assert 'hash_serialized_2' not in scanned
+        assert 'muhash' not in none and 'hash_serialized_2' not in none
+        return fast
+
+    def run_test(self):
+        assert_raises_rpc_error(-8, 'foo is not a valid hash_type', self.nodes[0].gettxoutsetinfo, 'foo')
+        self.check_stats()
+
+        self.log.info("The commitment follows connected blocks")
+        address = self.nodes[1].getnewaddress()
+        self.nodes[0].sendtoaddress(address, 10)
+        self.nodes[0].sendtoaddress(address, 20)
+        self.nodes[0].generate(1)
+        stats = self.check_stats()
+
+        self.log.info("And disconnected ones")
+        self.nodes[0].sendtoaddress(address, 5)
+        self.nodes[0].generate(2)
+        self.sync_all()
+        tip = self.nodes[0].getbestblockhash()
+        for node in self.nodes:
+            node.invalidateblock(self.nodes[0].getblockhash(stats['height'] + 1))
+        assert_equal(self.check_stats()['muhash'], stats['muhash'])
+        for node in self.nodes:
+            node.reconsiderblock(self.nodes[0].getblockhash(stats['height'] + 1))
+        assert_equal(self.check_stats()['bestblock'], tip)
+
+        self.log.info("The commitment is written to disk")
+        stats = self.nodes[0].gettxoutsetinfo('muhash')
+        self.restart_node(0, extra_args=['-utxocommitment'])
+        loaded = self.nodes[0].gettxoutsetinfo('muhash')
+        for key in ['height', 'bestblock', 'txouts', 'bogosize', 'total_amount', 'muhash']:
+            assert_equal(loaded[key], stats[key])
+
+        self.log.info("And recalculated when it's outdated")
+        self.restart_node(0, extra_args=[])
+        self.nodes[0].generate(1)
+        self.restart_node(0, extra_args=['-utxocommitment'])
+        connect_nodes(self.nodes[0], 1)
+        self.check_stats()
+
+if __name__ == '__main__':
+    UTXOCommitmentTest().main()
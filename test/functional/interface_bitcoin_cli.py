@@ -44,6 +44,15 @@ class TestBitcoinCli(BitcoinTestFramework):
         self.log.info("Make sure that -getinfo with arguments fails")
         assert_raises_process_error(1, "-getinfo takes no arguments", self.nodes[0].cli('-getinfo').help)
 
+        self.log.info("Test -batch")
+        batch = self.nodes[0].cli('-batch', input="getblockcount\n\necho foo bar\nnonexistentmethod\n").send_cli()
+        assert_equal(len(batch), 3)
+        assert_equal(batch[0]['result'], self.nodes[0].getblockcount())
+        assert_equal(batch[1]['result'], ["foo", "bar"])
+        assert_equal(batch[2]['error']['code'], -32601)
+        assert_raises_process_error(1, "-batch takes no arguments", self.nodes[0].cli('-batch', input="getblockcount").echo)
+        assert_raises_process_error(1, "-batch can't be combined with -stdin or -getinfo", self.nodes[0].cli('-batch', '-stdin', input="getblockcount").send_cli)
+
         self.log.info("Compare responses from `dash-cli -getinfo` and the RPCs data is retrieved from.")
         cli_get_info = self.nodes[0].cli('-getinfo').send_cli()
         wallet_info = self.nodes[0].getwalletinfo()
@@ -350,5 +350,38 @@ class RESTTest (BitcoinTestFramework):
         json_obj = json.loads(json_string)
         assert_equal(json_obj['bestblockhash'], bb_hash)
 
+        # test the masternode list diff, from the empty list to the tip
+        null_hash = '00' * 32
+        json_string = http_get_call(url.hostname, url.port, '/rest/mnlistdiff/'+null_hash+'/tip'+self.FORMAT_SEPARATOR+'json')
+        json_obj = json.loads(json_string)
+        assert_equal(json_obj['blockHash'], bb_hash)
+        assert_equal(json_obj['mnList'], [])
+
+        response = http_get_call(url.hostname, url.port, '/rest/mnlistdiff/'+null_hash+'/'+bb_hash+self.FORMAT_SEPARATOR+'bin', True)
+        assert_equal(response.status, 200)
+        etag = response.getheader('ETag')
+        assert_equal(etag, '"%s.%s.bin"' % (null_hash, bb_hash))
+        bin_diff = response.read()
+        hex_diff = http_get_call(url.hostname, url.port, '/rest/mnlistdiff/'+null_hash+'/'+bb_hash+self.FORMAT_SEPARATOR+'hex')
+        assert_equal(bin_diff, hex_str_to_bytes(hex_diff.strip()))
+
+        # a client which already has the diff doesn't get it again
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        conn.request('GET', '/rest/mnlistdiff/'+null_hash+'/'+bb_hash+self.FORMAT_SEPARATOR+'bin', headers={'If-None-Match': etag})
+        response = conn.getresponse()
+        assert_equal(response.status, 304)
+        assert_equal(response.read(), b'')
+
+        # no chainlocks or InstantSend locks without quorums
+        response = http_get_call(url.hostname, url.port, '/rest/chainlock'+self.FORMAT_SEPARATOR+'json', True)
+        assert_equal(response.status, 404)
+        response = http_get_call(url.hostname, url.port, '/rest/txlock/'+txs[0]+self.FORMAT_SEPARATOR+'bin', True)
+        assert_equal(response.status, 404)
+        json_string = http_get_call(url.hostname, url.port, '/rest/txlock/'+txs[0]+self.FORMAT_SEPARATOR+'json')
+        json_obj = json.loads(json_string)
+        assert_equal(json_obj['txid'], txs[0])
+        assert_equal(json_obj['instantlock'], False)
+        assert_equal(json_obj['chainlock'], False)
+
 if __name__ == '__main__':
     RESTTest ().main ()
@@ -42,8 +42,12 @@ class MempoolSpendCoinbaseTest(BitcoinTestFramework):
         assert_equal(self.nodes[0].getrawmempool(), [ spend_101_id ])
 
         # mine a block, spend_101 should get confirmed
+        script_cache = self.nodes[0].getmempoolinfo()['scriptcache']
         self.nodes[0].generate(1)
         assert_equal(set(self.nodes[0].getrawmempool()), set())
+        # its scripts were verified when it entered the mempool and are not executed again for the block
+        assert_greater_than(self.nodes[0].getmempoolinfo()['scriptcache']['hits'], script_cache['hits'])
+        assert_greater_than(self.nodes[0].getmempoolinfo()['sigcache']['maxelements'], 0)
 
         # ... and now height 102 can be spent:
         spend_102_id = self.nodes[0].sendrawtransaction(spends_raw[1])
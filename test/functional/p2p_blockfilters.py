@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+# Copyright (c) 2019 The Bitcoin Core developers
+# Copyright (c) 2021 The Dash Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Tests NODE_COMPACT_FILTERS (BIP 157/158).
+
+Tests that a node configured with -blockfilterindex and -peerblockfilters signals
+NODE_COMPACT_FILTERS and can serve cfilters, cfheaders and cfcheckpts.
+"""
+
+from test_framework.messages import (
+    FILTER_TYPE_BASIC,
+    NODE_COMPACT_FILTERS,
+    hash256,
+    msg_getcfcheckpt,
+    msg_getcfheaders,
+    msg_getcfilters,
+    ser_uint256,
+    uint256_from_str,
+)
+from test_framework.mininode import P2PInterface, mininode_lock, network_thread_start
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, wait_until
+
+class CFiltersClient(P2PInterface):
+    def __init__(self):
+        super().__init__()
+        # Store the cfilters received.
+        self.cfilters = []
+
+    def pop_cfilters(self):
+        cfilters = self.cfilters
+        self.cfilters = []
+        return cfilters
+
+    def on_cfilter(self, message):
+        """Store cfilters received in a list."""
+        self.cfilters.append(message)
+
+class CompactFiltersTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+        self.extra_args = [
+            ["-blockfilterindex", "-peerblockfilters"],
+            ["-blockfilterindex"],
+        ]
+
+    def run_test(self):
+        # Node 0 supports COMPACT_FILTERS, node 1 does not.
+        node0 = self.nodes[0].add_p2p_connection(CFiltersClient())
+        node1 = self.nodes[1].add_p2p_connection(CFiltersClient())
+        network_thread_start()
+        node0.wait_for_verack()
+        node1.wait_for_verack()
+
+        self.nodes[0].generate(1005)
+        self.sync_all()
+
+        assert node0.nServices & NODE_COMPACT_FILTERS != 0
+        assert node1.nServices & NODE_COMPACT_FILTERS == 0
+
+        stop_hash = self.nodes[0].getblockhash(1000)
+        wait_until(lambda: self.nodes[0].getblockfilter(self.nodes[0].getbestblockhash()), allow_exception=True)
+
+        self.log.info("Check that peers can fetch cfcheckpt from the node.")
+        node0.send_and_ping(msg_getcfcheckpt(filter_type=FILTER_TYPE_BASIC, stop_hash=int(stop_hash, 16)))
+        response = node0.last_message['cfcheckpt']
+        assert_equal(response.filter_type, FILTER_TYPE_BASIC)
+        assert_equal(response.stop_hash, int(stop_hash, 16))
+        assert_equal(response.headers, [int(self.nodes[0].getblockfilter(stop_hash)['header'], 16)])
+
+        self.log.info("Check that peers can fetch cfheaders and that they chain up.")
+        start_height = 990
+        node0.send_and_ping(msg_getcfheaders(filter_type=FILTER_TYPE_BASIC, start_height=start_height, stop_hash=int(stop_hash, 16)))
+        response = node0.last_message['cfheaders']
+        assert_equal(len(response.hashes), 11)
+        prev_header = self.nodes[0].getblockfilter(self.nodes[0].getblockhash(start_height - 1))['header']
+        assert_equal(response.prev_header, int(prev_header, 16))
+        header = response.prev_header
+        for filter_hash in response.hashes:
+            header = uint256_from_str(hash256(ser_uint256(filter_hash) + ser_uint256(header)))
+        assert_equal(header, int(self.nodes[0].getblockfilter(stop_hash)['header'], 16))
+
+        self.log.info("Check that peers can fetch cfilters.")
+        node0.send_and_ping(msg_getcfilters(filter_type=FILTER_TYPE_BASIC, start_height=start_height, stop_hash=int(stop_hash, 16)))
+        with mininode_lock:
+            cfilters = node0.pop_cfilters()
+        assert_equal(len(cfilters), 11)
+        for height, cfilter in zip(range(start_height, 1001), cfilters):
+            block_hash = self.nodes[0].getblockhash(height)
+            assert_equal(cfilter.filter_type, FILTER_TYPE_BASIC)
+            assert_equal(cfilter.block_hash, int(block_hash, 16))
+            assert_equal(cfilter.filter_data.hex(), self.nodes[0].getblockfilter(block_hash)['filter'])
+
+        self.log.info("Check that a node without -peerblockfilters disconnects peers requesting filters.")
+        node1.send_message(msg_getcfcheckpt(filter_type=FILTER_TYPE_BASIC, stop_hash=int(stop_hash, 16)))
+        node1.wait_for_disconnect()
+
+        self.log.info("Check that too large and unknown requests lead to a disconnect.")
+        requests = [
+            msg_getcfilters(filter_type=FILTER_TYPE_BASIC, start_height=0, stop_hash=int(stop_hash, 16)),
+            msg_getcfheaders(filter_type=FILTER_TYPE_BASIC, start_height=1000, stop_hash=int(self.nodes[0].getblockhash(999), 16)),
+            msg_getcfcheckpt(filter_type=255, stop_hash=int(stop_hash, 16)),
+        ]
+        for request in requests:
+            # node0 stays connected, so the network thread picks up the new connection
+            node = self.nodes[0].add_p2p_connection(P2PInterface())
+            node.wait_for_verack()
+            node.send_message(request)
+            node.wait_for_disconnect()
+
+if __name__ == '__main__':
+    CompactFiltersTest().main()
@@ -65,6 +65,7 @@ class BlockchainTest(BitcoinTestFramework):
         self._test_getchaintxstats()
         self._test_gettxoutsetinfo()
         self._test_getblockheader()
+        self._test_getmerkleblocks()
         self._test_getdifficulty()
         self._test_getnetworkhashps()
         self._test_stopatheight()
@@ -235,6 +236,24 @@ class BlockchainTest(BitcoinTestFramework):
         assert isinstance(int(header['versionHex'], 16), int)
         assert isinstance(header['difficulty'], Decimal)
 
+    def _test_getmerkleblocks(self):
+        self.log.info("Test getmerkleblocks")
+        node = self.nodes[0]
+        # a single byte filter with all bits set matches every transaction
+        filter_full = "01ff" + "01000000" + "00000000" + "00"
+        start = node.getblockhash(100)
+        merkleblocks = node.getmerkleblocks(filter_full, start, 50)
+        assert_equal(len(merkleblocks), 50)
+        # the blocks are returned in chain order, starting with the given one
+        for i, merkleblock in enumerate(merkleblocks):
+            assert_equal(merkleblock[:160], node.getblockheader(node.getblockhash(100 + i), False))
+        # the range ends at the tip
+        assert_equal(len(node.getmerkleblocks(filter_full, node.getblockhash(190))), 11)
+        # an empty filter matches nothing
+        assert_equal(node.getmerkleblocks("0100" + "01000000" + "00000000" + "00", start, 50), [])
+        assert_raises_rpc_error(-5, "Block not found", node.getmerkleblocks, filter_full, "00" * 32)
+        assert_raises_rpc_error(-8, "Count is out of range", node.getmerkleblocks, filter_full, start, 0)
+
     def _test_getdifficulty(self):
         difficulty = self.nodes[0].getdifficulty()
         # 1 hash in 2 should be valid, so difficulty should be 1/2**31
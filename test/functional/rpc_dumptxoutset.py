@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+# Copyright (c) 2021 The Dash Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test dumptxoutset and loadtxoutset."""
+
+import os
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, assert_raises_rpc_error
+
+
+class DumptxoutsetTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+
+    def run_test(self):
+        node = self.nodes[0]
+        res = node.dumptxoutset('utxo.dat')
+        stats = node.gettxoutsetinfo()
+        assert_equal(res['coins_written'], stats['txouts'])
+        assert_equal(res['base_height'], stats['height'])
+        assert_equal(res['base_hash'], stats['bestblock'])
+        assert_equal(res['txoutset_hash'], stats['hash_serialized_2'])
+        expected_path = os.path.join(node.datadir, 'regtest', 'utxo.dat')
+        assert_equal(res['path'], expected_path)
+        assert os.path.exists(expected_path)
+        assert_raises_rpc_error(-8, 'already exists', node.dumptxoutset, 'utxo.dat')
+
+        self.log.info("Snapshots are only accepted with known hashes")
+        assert_raises_rpc_error(-25, 'no snapshot hashes known for height %d' % res['base_height'], node.loadtxoutset, 'utxo.dat')
+
+        self.restart_node(0, extra_args=['-assumeutxo=%d:%s:%s' % (res['base_height'], res['txoutset_hash'], res['evo_state_hash'])])
+        loaded = node.loadtxoutset('utxo.dat')
+        assert_equal(loaded['coins_read'], res['coins_written'])
+        assert_equal(loaded['base_hash'], res['base_hash'])
+        assert_equal(loaded['txoutset_hash'], res['txoutset_hash'])
+        assert_equal(loaded['evo_state_hash'], res['evo_state_hash'])
+        assert_equal(loaded['total_amount'], stats['total_amount'])
+
+        self.log.info("Snapshots with a different UTXO set are rejected")
+        self.restart_node(0, extra_args=['-assumeutxo=%d:%s:%s' % (res['base_height'], '00' * 32, res['evo_state_hash'])])
+        assert_raises_rpc_error(-25, 'UTXO set hash', node.loadtxoutset, 'utxo.dat')
+
+
+if __name__ == '__main__':
+    DumptxoutsetTest().main()
@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+# Copyright (c) 2021 The Dash Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test getrpcinfo and the per method class RPC work queues.
+
+Test corresponds to code in rpc/server.cpp, httprpc.cpp and httpserver.cpp.
+"""
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, assert_greater_than
+
+
+class RPCInfoTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+        self.extra_args = [["-rpcfastthreads=1", "-rpcheavythreads=3", "-rpccachesize=1"]]
+
+    def get_info(self):
+        info = self.nodes[0].getrpcinfo()
+        return {q['name']: q for q in info['work_queues']}, info['methods']
+
+    def run_test(self):
+        node = self.nodes[0]
+        queues_before, methods_before = self.get_info()
+        assert_equal(sorted(queues_before.keys()), ['default', 'fast', 'heavy', 'wallet'])
+        assert_equal(queues_before['fast']['threads'], 1)
+        assert_equal(queues_before['heavy']['threads'], 3)
+
+        node.getblockcount()
+        node.getblockcount()
+        node.gettxoutsetinfo()
+        queues, methods = self.get_info()
+
+        # both getblockcount calls and getrpcinfo itself went to the fast queue
+        assert_equal(queues['fast']['processed'] - queues_before['fast']['processed'], 3)
+        assert_equal(queues['heavy']['processed'] - queues_before['heavy']['processed'], 1)
+        assert_equal(queues['default']['processed'], queues_before['default']['processed'])
+        for q in queues.values():
+            assert_equal(q['rejected'], 0)
+
+        assert_equal(methods['getblockcount']['calls'] - methods_before.get('getblockcount', {'calls': 0})['calls'], 2)
+        assert_equal(methods['gettxoutsetinfo']['calls'], 1)
+        assert_greater_than(methods['gettxoutsetinfo']['total_us'], 0)
+        assert_equal(methods['getrpcinfo']['calls'], 1)
+
+        self.log.info("Test the result cache")
+        cache = node.getrpcinfo()['result_cache']
+        assert_equal(cache['max_usage'], 1 << 20)
+        assert_equal(cache['entries'], 0)
+        blockhash = node.getbestblockhash()
+        block = node.getblock(blockhash)
+        assert_equal(node.getblock(blockhash), block)
+        node.getblock(blockhash, 0)
+        cache = node.getrpcinfo()['result_cache']
+        assert_equal(cache['hits'], 1)
+        assert_equal(cache['misses'], 2)
+        assert_equal(cache['entries'], 2)
+        assert_greater_than(cache['usage'], 0)
+
+        # a new tip drops the cached results, which depend on it (e.g. confirmations)
+        node.generate(1)
+        assert_equal(node.getblock(blockhash)['confirmations'], block['confirmations'] + 1)
+        cache = node.getrpcinfo()['result_cache']
+        assert_equal(cache['hits'], 1)
+        assert_equal(cache['misses'], 3)
+        assert_equal(cache['entries'], 1)
+
+if __name__ == '__main__':
+    RPCInfoTest().main()
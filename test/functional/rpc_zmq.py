@@ -6,7 +6,7 @@
 
 from test_framework.test_framework import (
     BitcoinTestFramework, skip_if_no_py3_zmq, skip_if_no_bitcoind_zmq)
-from test_framework.util import assert_equal
+from test_framework.util import assert_equal, assert_raises_rpc_error, wait_until
 
 
 class RPCZMQTest(BitcoinTestFramework):
@@ -21,15 +21,47 @@ class RPCZMQTest(BitcoinTestFramework):
         skip_if_no_py3_zmq()
         skip_if_no_bitcoind_zmq(self)
         self._test_getzmqnotifications()
+        self._test_zmqwatch()
 
     def _test_getzmqnotifications(self):
         self.restart_node(0, extra_args=[])
         assert_equal(self.nodes[0].getzmqnotifications(), [])
 
-        self.restart_node(0, extra_args=["-zmqpubhashtx=%s" % self.address])
-        assert_equal(self.nodes[0].getzmqnotifications(), [
-            {"type": "pubhashtx", "address": self.address},
-        ])
+        self.restart_node(0, extra_args=["-zmqpubhashtx=%s" % self.address, "-zmqsndhwm=50"])
+        notifications = self.nodes[0].getzmqnotifications()
+        assert_equal(len(notifications), 1)
+        assert_equal(notifications[0]["type"], "pubhashtx")
+        assert_equal(notifications[0]["address"], self.address)
+        assert_equal(notifications[0]["hwm"], 50)
+        assert_equal(notifications[0]["messages"], 0)
+
+        # notifications are published asynchronously
+        self.nodes[0].generate(1)
+        wait_until(lambda: self.nodes[0].getzmqnotifications()[0]["messages"] == 1)
+        notifications = self.nodes[0].getzmqnotifications()
+        assert_equal(notifications[0]["bytes"], 32)
+        assert_equal(notifications[0]["dropped"], 0)
+        assert_equal(notifications[0]["queue_dropped"], 0)
+
+    def _test_zmqwatch(self):
+        address = self.nodes[0].getnewaddress()
+        script = self.nodes[0].getaddressinfo(address)["scriptPubKey"]
+        self.restart_node(0, extra_args=["-zmqpubrawtxwatch=%s" % self.address, "-zmqwatch=%s" % address])
+        assert_equal(self.nodes[0].getzmqwatch(), [{"script": script, "address": address}])
+
+        assert_equal(self.nodes[0].setzmqwatch("add", ["51"]), 2)
+        assert_equal(self.nodes[0].setzmqwatch("remove", [address]), 1)
+        assert_equal(self.nodes[0].getzmqwatch(), [{"script": "51"}])
+        assert_raises_rpc_error(-5, "is neither an address nor a hex encoded script", self.nodes[0].setzmqwatch, "add", ["foo"])
+        assert_equal(self.nodes[0].setzmqwatch("clear"), 0)
+        assert_equal(self.nodes[0].getzmqwatch(), [])
+
+        # only transactions paying to the watched address are published
+        assert_equal(self.nodes[0].setzmqwatch("add", [address]), 1)
+        self.nodes[0].generate(101)
+        self.nodes[0].sendtoaddress(self.nodes[0].getnewaddress(), 1)
+        self.nodes[0].sendtoaddress(address, 1)
+        wait_until(lambda: self.nodes[0].getzmqnotifications()[0]["messages"] == 1)
 
 
 if __name__ == '__main__':
@@ -96,6 +96,7 @@ BASE_SCRIPTS= [
     'feature_csv_activation.py',
     'rpc_rawtransaction.py',
     'feature_reindex.py',
+    'feature_utxocommitment.py',
     # vv Tests less than 30s vv
     'wallet_keypool_topup.py',
     'interface_zmq_dash.py',
@@ -105,6 +106,7 @@ BASE_SCRIPTS= [
     'wallet_txn_doublespend.py --mineblock',
     'wallet_txn_clone.py',
     'rpc_getchaintips.py',
+    'rpc_getblockfilter.py',
     'interface_rest.py',
     'mempool_spend_coinbase.py',
     'mempool_reorg.py',
@@ -144,6 +146,7 @@ BASE_SCRIPTS= [
     'wallet_listsinceblock.py',
     'p2p_leak.py',
     'p2p_compactblocks.py',
+    'p2p_blockfilters.py',
     'p2p_connect_to_devnet.py',
     'feature_sporks.py',
     'rpc_getblockstats.py',
@@ -154,6 +157,8 @@ BASE_SCRIPTS= [
     'feature_new_quorum_type_activation.py',
     'feature_governance_objects.py',
     'rpc_uptime.py',
+    'rpc_getrpcinfo.py',
+    'rpc_dumptxoutset.py',
     'wallet_resendwallettransactions.py',
     'feature_minchainwork.py',
     'p2p_unrequested_blocks.py', # NOTE: needs dash_hash to pass
@@ -183,6 +188,7 @@ EXTENDED_SCRIPTS = [
     'feature_pruning.py', # NOTE: Prune mode is incompatible with -txindex, should work with governance validation disabled though.
     # vv Tests less than 20m vv
     'feature_fee_estimation.py',
+    'feature_node_throughput.py', # NOTE: a benchmark, see its --results option
     # vv Tests less than 5m vv
     'feature_maxuploadtarget.py',
     'mempool_packages.py',
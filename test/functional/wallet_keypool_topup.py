@@ -9,7 +9,8 @@ Two nodes. Node1 is under test. Node0 is providing transactions and generating b
 - Start node1, shutdown and backup wallet.
 - Generate 110 keys (enough to drain the keypool). Store key 90 (in the initial keypool) and key 110 (beyond the initial keypool). Send funds to key 90 and key 110.
 - Stop node1, clear the datadir, move wallet file back into the datadir and restart node1.
-- connect node1 to node0. Verify that they sync and node1 receives its funds."""
+- connect node1 to node0. Verify that they sync and node1 receives its funds.
+- Restore the backup once more, with a block filter index and several rescan threads, and verify the balance again."""
 import os
 import shutil
 import sys
@@ -18,6 +19,7 @@ from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import (
     assert_equal,
     connect_nodes_bi,
+    wait_until,
 )
 
 
@@ -65,6 +67,16 @@ class KeypoolRestoreTest(BitcoinTestFramework):
         # Check that we have marked all keys up to the used keypool key as used
         assert_equal(self.nodes[1].getaddressinfo(self.nodes[1].getnewaddress())['hdkeypath'], "m/44'/1'/0'/0/110")
 
+        self.log.info("Restore the backup with a block filter index and several rescan threads")
+        extra_args = self.extra_args[1] + ['-blockfilterindex']
+        self.restart_node(1, extra_args)
+        wait_until(lambda: self.nodes[1].getblockfilter(self.nodes[1].getbestblockhash()), allow_exception=True)
+        self.stop_node(1)
+        shutil.copyfile(wallet_backup_path, wallet_path)
+        self.start_node(1, extra_args + ['-rescanthreads=4'])
+        assert_equal(self.nodes[1].getbalance(), 15)
+        assert_equal(self.nodes[1].getaddressinfo(self.nodes[1].getnewaddress())['hdkeypath'], "m/44'/1'/0'/0/110")
+
 
 if __name__ == '__main__':
     KeypoolRestoreTest().main()